@@ -0,0 +1,89 @@
+#include "benchmark.h"
+#include "one_bit_branch_predictor.h"
+#include "pentium_m_branch_predictor.h"
+#include "a53branchpredictor.h"
+#include "perceptron_branch_predictor.h"
+#include "nn_branch_predictor.h"
+#include "random.h"
+
+#include <vector>
+
+// BranchPredictor::predict followed by update, as Core::accessBranchPredictor does, per implementation.
+// The branch stream mixes 256 static branches with different behavior: strongly biased,
+// alternating, loop back-edges with a trip count of 8, and data-dependent (random) ones.
+
+struct Branch
+{
+   IntPtr ip;
+   IntPtr target;
+   bool taken;
+};
+
+static std::vector<Branch> makeBranches(UInt32 count)
+{
+   Random rng;
+   std::vector<Branch> branches(count);
+   std::vector<UInt32> executions(256, 0);
+   for(UInt32 i = 0; i < count; ++i)
+   {
+      UInt32 site = rng.next(256);
+      UInt32 n = executions[site]++;
+      bool taken;
+      switch(site % 4)
+      {
+         case 0:  taken = rng.next(100) < 95; break;
+         case 1:  taken = n % 2; break;
+         case 2:  taken = n % 8 != 7; break;
+         default: taken = rng.next(2); break;
+      }
+      branches[i].ip = 0x400000 + 16 * site;
+      branches[i].target = branches[i].ip - 64;
+      branches[i].taken = taken;
+   }
+   return branches;
+}
+
+static void benchBranchPredictor(BenchmarkState &state, BranchPredictor *bp)
+{
+   const UInt32 num_branches = 8192;
+   std::vector<Branch> branches = makeBranches(num_branches);
+   UInt64 predictions = 0;
+
+   while(state.keepRunning())
+   {
+      for(std::vector<Branch>::const_iterator it = branches.begin(); it != branches.end(); ++it)
+      {
+         bool prediction = bp->predict(false, it->ip, it->target);
+         bp->update(prediction, it->taken, false, it->ip, it->target);
+      }
+      predictions += num_branches;
+   }
+
+   state.setItemsProcessed(predictions);
+   // Predictors own registered statistics, don't delete them
+}
+
+static String bpName(const char *type)
+{
+   return String("benchmark-branch-predictor-") + type;
+}
+
+SNIPER_BENCHMARK("branch_predictor/one_bit", [](BenchmarkState &state) {
+   benchBranchPredictor(state, new OneBitBranchPredictor(bpName("one_bit"), BenchmarkRegistry::nextInstance(), 1024));
+});
+SNIPER_BENCHMARK("branch_predictor/pentium_m", [](BenchmarkState &state) {
+   benchBranchPredictor(state, new PentiumMBranchPredictor(bpName("pentium_m"), BenchmarkRegistry::nextInstance()));
+});
+SNIPER_BENCHMARK("branch_predictor/a53", [](BenchmarkState &state) {
+   benchBranchPredictor(state, new A53BranchPredictor(bpName("a53"), BenchmarkRegistry::nextInstance()));
+});
+SNIPER_BENCHMARK("branch_predictor/perceptron", [](BenchmarkState &state) {
+   benchBranchPredictor(state, new PerceptronBranchPredictor(bpName("perceptron"), BenchmarkRegistry::nextInstance(), 1024, 31));
+});
+// Same parameters as test/fft-nn
+SNIPER_BENCHMARK("branch_predictor/nn", [](BenchmarkState &state) {
+   benchBranchPredictor(state, new NNBranchPredictor(bpName("nn"), BenchmarkRegistry::nextInstance(), 32, 0.001, false, false));
+});
+SNIPER_BENCHMARK("branch_predictor/nn_fast_inference", [](BenchmarkState &state) {
+   benchBranchPredictor(state, new NNBranchPredictor(bpName("nn_fast_inference"), BenchmarkRegistry::nextInstance(), 32, 0.001, true, false));
+});
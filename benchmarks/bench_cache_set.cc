@@ -0,0 +1,86 @@
+#include "benchmark.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "cache_set.h"
+#include "shared_cache_block_info.h"
+#include "random.h"
+
+#include <vector>
+
+// CacheSet::find and CacheSet::insert per replacement policy, argument is the associativity.
+// Each access does what Cache::accessSingleLine / Cache::insertSingleLine do: look up the tag,
+// update the replacement state on a hit, insert the line on a miss. The tags are drawn from
+// a working set of twice the associativity, so roughly half of the accesses miss.
+
+static void benchCacheSet(BenchmarkState &state, const char *policy)
+{
+   const String cfgname = "benchmark/cache_set";
+   const UInt32 associativity = state.arg();
+   const UInt32 num_accesses = 4096;
+
+   // Parameters of the policies that have any, the benchmark does not use a cache from the configuration
+   Sim()->getCfg()->set(cfgname + "/srrip/bits", SInt64(3));
+   Sim()->getCfg()->set(cfgname + "/qbs/attempts", SInt64(2));
+   for(const char *predictor : { "ship", "hawkeye", "mockingjay" })
+   {
+      Sim()->getCfg()->set(cfgname + "/" + predictor + "/signature_bits", SInt64(14));
+      Sim()->getCfg()->set(cfgname + "/" + predictor + "/region_size", SInt64(16384));
+      Sim()->getCfg()->set(cfgname + "/" + predictor + "/sampled_sets", SInt64(64));
+   }
+   Sim()->getCfg()->set(cfgname + "/mockingjay/granularity", SInt64(8));
+
+   CacheSetInfo *set_info = CacheSet::createCacheSetInfo(
+      String("benchmark-cache-set-") + policy, cfgname, BenchmarkRegistry::nextInstance(), policy, associativity, 1, 64);
+   CacheSet *set = CacheSet::createCacheSet(cfgname, 0, policy, CacheBase::SHARED_CACHE, associativity, 64, set_info);
+
+   Random rng;
+   std::vector<IntPtr> tags(num_accesses);
+   for(UInt32 i = 0; i < num_accesses; ++i)
+      tags[i] = rng.next(2 * associativity);
+
+   SharedCacheBlockInfo block_info, evict_block_info;
+   UInt64 accesses = 0;
+
+   while(state.keepRunning())
+   {
+      for(UInt32 i = 0; i < num_accesses; ++i)
+      {
+         UInt32 line_index;
+         CacheBlockInfo *block = set->find(tags[i], &line_index);
+         if (block)
+         {
+            set->updateReplacementIndex(line_index);
+         }
+         else
+         {
+            bool eviction;
+            block_info.setTag(tags[i]);
+            block_info.setCState(CacheState::SHARED);
+            set->insert(&block_info, NULL, &eviction, &evict_block_info, NULL);
+         }
+      }
+      accesses += num_accesses;
+   }
+
+   state.setItemsProcessed(accesses);
+
+   delete set;
+   // CacheSetInfo objects own registered statistics and live as long as their cache, don't delete set_info
+}
+
+#define CACHE_SET_BENCHMARK(policy) \
+   SNIPER_BENCHMARK("cache_set/" policy, [](BenchmarkState &state) { benchCacheSet(state, policy); }, { 4, 8, 16 })
+
+CACHE_SET_BENCHMARK("round_robin");
+CACHE_SET_BENCHMARK("lru");
+CACHE_SET_BENCHMARK("lru_qbs");
+CACHE_SET_BENCHMARK("nru");
+CACHE_SET_BENCHMARK("mru");
+CACHE_SET_BENCHMARK("nmru");
+CACHE_SET_BENCHMARK("plru");
+CACHE_SET_BENCHMARK("srrip");
+CACHE_SET_BENCHMARK("srrip_qbs");
+CACHE_SET_BENCHMARK("random");
+CACHE_SET_BENCHMARK("ship");
+CACHE_SET_BENCHMARK("hawkeye");
+CACHE_SET_BENCHMARK("mockingjay");
@@ -0,0 +1,46 @@
+#include "benchmark.h"
+#include "hooks_manager.h"
+#include "config.h"
+
+// HooksManager::callHooks with the given number of registered callbacks, on a private HooksManager
+// so callbacks registered by the simulator itself are not included. The per-core variant also has
+// as many callbacks registered for other cores, which should not be visited.
+
+static SInt64 hookCallback(UInt64 arg, UInt64 val)
+{
+   (*(UInt64*)arg) += val;
+   return 0;
+}
+
+static void benchHooks(BenchmarkState &state, bool per_core)
+{
+   HooksManager hooks_manager;
+   UInt64 sum = 0;
+
+   for(SInt64 i = 0; i < state.arg(); ++i)
+   {
+      if (per_core)
+      {
+         hooks_manager.registerHook(HookType::HOOK_CORE_STATE_CHANGE, hookCallback, (UInt64)&sum, HooksManager::ORDER_NOTIFY_PRE, 0);
+         if (Config::getSingleton()->getTotalCores() > 1)
+            hooks_manager.registerHook(HookType::HOOK_CORE_STATE_CHANGE, hookCallback, (UInt64)&sum, HooksManager::ORDER_NOTIFY_PRE, 1);
+      }
+      else
+      {
+         hooks_manager.registerHook(HookType::HOOK_CORE_STATE_CHANGE, hookCallback, (UInt64)&sum, HooksManager::HookCallbackOrder(i % HooksManager::NUM_HOOK_ORDER));
+      }
+   }
+
+   UInt64 calls = 0;
+   while(state.keepRunning())
+   {
+      hooks_manager.callHooks(HookType::HOOK_CORE_STATE_CHANGE, 1, false, per_core ? 0 : INVALID_CORE_ID);
+      ++calls;
+   }
+
+   benchmarkUse(sum);
+   state.setItemsProcessed(calls);
+}
+
+SNIPER_BENCHMARK("hooks/call", [](BenchmarkState &state) { benchHooks(state, false); }, { 0, 1, 8, 64 });
+SNIPER_BENCHMARK("hooks/call_per_core", [](BenchmarkState &state) { benchHooks(state, true); }, { 1, 8, 64 });
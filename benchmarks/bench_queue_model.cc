@@ -0,0 +1,46 @@
+#include "benchmark.h"
+#include "queue_model.h"
+#include "random.h"
+
+#include <vector>
+
+// QueueModel::computeQueueDelay per implementation, for a stream of requests at 50% utilization
+// arriving mostly in order, with some jitter as requests from concurrently simulated cores do.
+
+static void benchQueueModel(BenchmarkState &state, const char *type)
+{
+   const UInt32 num_requests = 4096;
+   const SubsecondTime processing_time = SubsecondTime::NS(10);
+
+   QueueModel *queue_model = QueueModel::create(String("benchmark-queue-model-") + type, BenchmarkRegistry::nextInstance(), type, processing_time);
+
+   Random rng;
+   std::vector<SubsecondTime> jitter(num_requests);
+   for(UInt32 i = 0; i < num_requests; ++i)
+      jitter[i] = SubsecondTime::NS(rng.next(40));
+
+   SubsecondTime time = SubsecondTime::NS(100);
+   UInt64 requests = 0;
+
+   while(state.keepRunning())
+   {
+      for(UInt32 i = 0; i < num_requests; ++i)
+      {
+         benchmarkUse(queue_model->computeQueueDelay(time + jitter[i], processing_time, i % 8));
+         time += 2 * processing_time;
+      }
+      requests += num_requests;
+   }
+
+   state.setItemsProcessed(requests);
+   // Queue models own registered statistics, don't delete them
+}
+
+#define QUEUE_MODEL_BENCHMARK(type) \
+   SNIPER_BENCHMARK("queue_model/" type, [](BenchmarkState &state) { benchQueueModel(state, type); })
+
+QUEUE_MODEL_BENCHMARK("basic");
+QUEUE_MODEL_BENCHMARK("history_list");
+QUEUE_MODEL_BENCHMARK("contention");
+QUEUE_MODEL_BENCHMARK("windowed_mg1");
+QUEUE_MODEL_BENCHMARK("lockfree");
@@ -0,0 +1,124 @@
+#include "benchmark.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "core_manager.h"
+#include "core.h"
+#include "rob_timer.h"
+#include "core_model.h"
+#include "micro_op.h"
+#include "dynamic_micro_op.h"
+#include "memory_access.h"
+#include "allocator.h"
+#include "hit_where.h"
+#include "random.h"
+
+#include <vector>
+
+// RobTimer::simulate on a synthetic stream of single-uop instructions, one call per instruction as
+// RobPerformanceModel does. The stream has 40% ALU ops, 30% loads, 15% stores and 15% branches,
+// with register dependencies at a short random distance over 16 registers, streaming load and store
+// addresses, some loads that miss in the L1, and 5% of the branches mispredicted.
+// The RobTimer is attached to core 0 and uses its configuration, whatever the core's own performance model is.
+
+static const UInt32 NUM_UOPS = 4096;
+
+struct SyntheticUop
+{
+   MicroOp *uop;
+   IntPtr address;
+   UInt32 latency;
+   bool mispredicted;
+};
+
+static std::vector<SyntheticUop> makeUops()
+{
+   Random rng;
+   std::vector<SyntheticUop> uops(NUM_UOPS);
+   IntPtr load_address = 0x10000000, store_address = 0x20000000;
+
+   for(UInt32 i = 0; i < NUM_UOPS; ++i)
+   {
+      MicroOp *uop = new MicroOp();
+      SyntheticUop &s = uops[i];
+      s.address = 0;
+      s.latency = 1;
+      s.mispredicted = false;
+
+      UInt32 kind = rng.next(100);
+      if (kind < 40)
+      {
+         uop->makeExecute(0, 0, dl::Decoder::DL_OPCODE_INVALID, "alu", false);
+      }
+      else if (kind < 70)
+      {
+         uop->makeLoad(0, dl::Decoder::DL_OPCODE_INVALID, "load", 8);
+         s.address = load_address += 8;
+         s.latency = rng.next(100) < 5 ? 40 : 4;
+      }
+      else if (kind < 85)
+      {
+         uop->makeStore(0, 0, dl::Decoder::DL_OPCODE_INVALID, "store", 8);
+         s.address = store_address += 8;
+      }
+      else
+      {
+         uop->makeExecute(0, 0, dl::Decoder::DL_OPCODE_INVALID, "branch", true);
+         s.mispredicted = rng.next(100) < 5;
+      }
+
+      // Register ids 1..16, 0 is DL_REG_INVALID
+      uop->addSourceRegister(1 + rng.next(16), "src");
+      if (!uop->isStore() && !uop->isBranch())
+         uop->addDestinationRegister(1 + rng.next(16), "dst");
+      uop->setFirst(true);
+      uop->setLast(true);
+
+      s.uop = uop;
+   }
+
+   return uops;
+}
+
+static void benchRobTimer(BenchmarkState &state)
+{
+   // RobTimer registers per-core statistics, so only one can ever be created for a core: reuse it between runs
+   static std::vector<SyntheticUop> uops = makeUops();
+   static Core *core = Sim()->getCoreManager()->getCoreFromID(0);
+   static const CoreModel *core_model = CoreModel::getCoreModel(Sim()->getCfg()->getStringArray("perf_model/core/core_model", core->getId()));
+   static Allocator *allocator = core_model->createDMOAllocator();
+   static RobTimer *rob_timer = new RobTimer(core, core->getPerformanceModel(), core_model,
+      Sim()->getCfg()->getIntArray("perf_model/branch_predictor/mispredict_penalty", core->getId()),
+      Sim()->getCfg()->getIntArray("perf_model/core/interval_timer/dispatch_width", core->getId()),
+      Sim()->getCfg()->getIntArray("perf_model/core/interval_timer/window_size", core->getId()));
+
+   const ComponentPeriod period = *core->getDvfsDomain();
+   std::vector<DynamicMicroOp*> insn(1);
+   UInt64 num_uops = 0;
+
+   while(state.keepRunning())
+   {
+      for(std::vector<SyntheticUop>::const_iterator it = uops.begin(); it != uops.end(); ++it)
+      {
+         DynamicMicroOp *uop = core_model->createDynamicMicroOp(allocator, it->uop, period);
+         if (it->address)
+         {
+            Memory::Access access;
+            access.set(it->address);
+            uop->setAddress(access);
+            uop->setDCacheHitWhere(it->latency > 4 ? HitWhere::L2_OWN : HitWhere::L1_OWN);
+            uop->setExecLatency(it->latency);
+         }
+         if (it->uop->isBranch())
+            uop->setBranchMispredicted(it->mispredicted);
+
+         // RobTimer takes ownership of the DynamicMicroOp
+         insn[0] = uop;
+         benchmarkUse(rob_timer->simulate(insn));
+      }
+      num_uops += uops.size();
+   }
+
+   state.setItemsProcessed(num_uops);
+}
+
+SNIPER_BENCHMARK("rob_timer/simulate", benchRobTimer);
@@ -0,0 +1,75 @@
+#include "benchmark.h"
+#include "sift_writer.h"
+#include "sift_reader.h"
+#include "random.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+// Sift::Reader decode throughput on a synthetic trace, written in advance with Sift::Writer.
+// Argument 0 reads an uncompressed trace, 1 a zlib compressed one.
+// The trace loops over a few basic blocks like a hot loop nest would, with one memory address
+// on a third of the instructions and a branch at the end of each basic block.
+
+static const UInt32 TRACE_LENGTH = 1000000;
+static uint8_t s_code[4096];
+
+static void getCode(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+   memcpy(dst, src, size);
+}
+
+static void writeTrace(const char *filename, bool compressed)
+{
+   memset(s_code, 0x90, sizeof(s_code));
+   Sift::Writer writer(filename, getCode, compressed);
+
+   Random rng;
+   uint64_t address = 0x100000;
+   for(UInt32 i = 0; i < TRACE_LENGTH; )
+   {
+      // Basic block of 8 instructions of 1 to 4 bytes, at one of 64 locations
+      uint64_t eip = (uint64_t)&s_code[64 * rng.next(64)];
+      for(UInt32 j = 0; j < 8; ++j, ++i)
+      {
+         uint8_t size = 1 + rng.next(4);
+         bool is_branch = (j == 7);
+         uint64_t addresses[1] = { address };
+         bool memory = (i % 3) == 0;
+         if (memory)
+            address += 8;
+         writer.Instruction(eip, size, memory ? 1 : 0, addresses, is_branch, is_branch && rng.next(2), false, true);
+         eip += size;
+      }
+   }
+   writer.End();
+}
+
+static void benchSiftReader(BenchmarkState &state)
+{
+   char filename[] = "/tmp/sniper-bench-sift-XXXXXX";
+   int fd = mkstemp(filename);
+   LOG_ASSERT_ERROR(fd >= 0, "Cannot create temporary file");
+   close(fd);
+
+   writeTrace(filename, state.arg() == 1);
+
+   UInt64 instructions = 0;
+   while(state.keepRunning())
+   {
+      Sift::Reader reader(filename);
+      Sift::Instruction inst;
+      while(reader.Read(inst))
+      {
+         benchmarkUse(inst.sinst);
+         ++instructions;
+      }
+   }
+
+   state.setItemsProcessed(instructions);
+   unlink(filename);
+}
+
+SNIPER_BENCHMARK("sift/reader", benchSiftReader, { 0, 1 });
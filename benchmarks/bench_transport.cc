@@ -0,0 +1,81 @@
+#include "benchmark.h"
+#include "smtransport.h"
+#include "config.h"
+#include "log.h"
+
+#include <pthread.h>
+#include <vector>
+
+// SmTransport round trips between two nodes of a private SmTransport, argument is the message size.
+// round_trip sends and receives from the same thread, which measures the queueing and copying overhead;
+// round_trip_threaded echoes messages from a second host thread, which adds the wakeup latency
+// that messages between simulation threads see.
+
+static const Byte STOP = 0xff;
+
+struct Echo
+{
+   Transport *transport;
+   Transport::Node *node;
+   UInt32 size;
+};
+
+static void *echoThread(void *arg)
+{
+   Echo *echo = (Echo*)arg;
+   while(true)
+   {
+      Byte *msg = echo->node->recv();
+      if (msg[0] == STOP)
+      {
+         echo->transport->freeBuffer(msg);
+         return NULL;
+      }
+      echo->node->sendBuffer(0, msg, echo->size);
+   }
+}
+
+static void benchTransport(BenchmarkState &state, bool threaded)
+{
+   LOG_ASSERT_ERROR(Config::getSingleton()->getTotalCores() >= 2, "Transport benchmarks need at least two cores");
+
+   SmTransport *transport = new SmTransport();
+   Transport::Node *node0 = transport->createNode(0);
+   Transport::Node *node1 = transport->createNode(1);
+   std::vector<Byte> msg(state.arg(), 0);
+
+   pthread_t thread;
+   Echo echo = { transport, node1, (UInt32)msg.size() };
+   if (threaded)
+      pthread_create(&thread, NULL, echoThread, &echo);
+
+   UInt64 round_trips = 0;
+   while(state.keepRunning())
+   {
+      node0->send(1, msg.data(), msg.size());
+      if (!threaded)
+      {
+         Byte *request = node1->recv();
+         node1->sendBuffer(0, request, msg.size());
+      }
+      Byte *reply = node0->recv();
+      transport->freeBuffer(reply);
+      ++round_trips;
+   }
+
+   if (threaded)
+   {
+      msg[0] = STOP;
+      node0->send(1, msg.data(), msg.size());
+      pthread_join(thread, NULL);
+   }
+
+   state.setItemsProcessed(round_trips);
+
+   delete node0;
+   delete node1;
+   delete transport;
+}
+
+SNIPER_BENCHMARK("transport/sm/round_trip", [](BenchmarkState &state) { benchTransport(state, false); }, { 64, 4096 });
+SNIPER_BENCHMARK("transport/sm/round_trip_threaded", [](BenchmarkState &state) { benchTransport(state, true); }, { 64, 4096 });
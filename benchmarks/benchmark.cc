@@ -0,0 +1,232 @@
+#include "benchmark.h"
+#include "simulator.h"
+#include "handle_args.h"
+#include "config.hpp"
+#include "itostr.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <regex>
+#include <algorithm>
+
+BenchmarkState::BenchmarkState(UInt64 iterations, SInt64 arg)
+   : m_iterations(iterations)
+   , m_arg(arg)
+   , m_remaining(iterations)
+   , m_items(0)
+   , m_running(false)
+   , m_real_time(0)
+   , m_cpu_time(0)
+{
+}
+
+static double elapsed(const struct timespec &start, clockid_t clock)
+{
+   struct timespec now;
+   clock_gettime(clock, &now);
+   return (now.tv_sec - start.tv_sec) + 1e-9 * (now.tv_nsec - start.tv_nsec);
+}
+
+void BenchmarkState::start()
+{
+   m_running = true;
+   clock_gettime(CLOCK_MONOTONIC, &m_real_start);
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &m_cpu_start);
+}
+
+void BenchmarkState::stop()
+{
+   if (m_running)
+   {
+      m_real_time += elapsed(m_real_start, CLOCK_MONOTONIC);
+      m_cpu_time += elapsed(m_cpu_start, CLOCK_THREAD_CPUTIME_ID);
+      m_running = false;
+   }
+}
+
+void BenchmarkState::pauseTiming()
+{
+   stop();
+}
+
+void BenchmarkState::resumeTiming()
+{
+   start();
+}
+
+UInt32 BenchmarkRegistry::m_instance = 0;
+
+std::vector<BenchmarkRegistry::Benchmark>& BenchmarkRegistry::getList()
+{
+   // Function-local so registration from static initializers in other files is safe
+   static std::vector<Benchmark> list;
+   return list;
+}
+
+int BenchmarkRegistry::add(const char *name, BenchmarkFunc func, std::vector<SInt64> args)
+{
+   Benchmark benchmark = { name, func, args };
+   getList().push_back(benchmark);
+   return getList().size();
+}
+
+BenchmarkState BenchmarkRegistry::run(BenchmarkFunc func, SInt64 arg, double min_time)
+{
+   UInt64 iterations = 1;
+   while(true)
+   {
+      BenchmarkState state(iterations, arg);
+      func(state);
+      state.stop();
+
+      if (state.getRealTime() >= min_time || iterations >= (UInt64(1) << 40))
+         return state;
+
+      // Aim a bit over min_time, but don't grow too fast from a noisy short run
+      double multiplier = state.getRealTime() > 0 ? 1.4 * min_time / state.getRealTime() : 10.;
+      iterations = std::max(iterations + 1, UInt64(iterations * std::min(multiplier, 10.)));
+   }
+}
+
+static void jsonString(FILE *fp, const char *str)
+{
+   fputc('"', fp);
+   for(const char *p = str; *p; ++p)
+   {
+      if (*p == '"' || *p == '\\')
+         fputc('\\', fp);
+      fputc(*p, fp);
+   }
+   fputc('"', fp);
+}
+
+static void usage(const char *prog)
+{
+   fprintf(stderr, "Usage: %s -c <config> [--section/key=value ...] [--benchmark_filter=<regex>] [--benchmark_min_time=<seconds>] [--benchmark_out=<file.json>] [--benchmark_list_tests]\n", prog);
+   exit(-1);
+}
+
+int main(int argc, char* argv[])
+{
+   String filter = ".";
+   double min_time = 0.5;
+   String out_file;
+   bool list_only = false;
+
+   // Strip our own options, the rest are passed to the simulator's configuration handling
+   std::vector<char*> sim_argv;
+   sim_argv.push_back(argv[0]);
+   for(int i = 1; i < argc; ++i)
+   {
+      if (strncmp(argv[i], "--benchmark_filter=", 19) == 0)
+         filter = argv[i] + 19;
+      else if (strncmp(argv[i], "--benchmark_min_time=", 21) == 0)
+         min_time = atof(argv[i] + 21);
+      else if (strncmp(argv[i], "--benchmark_out=", 16) == 0)
+         out_file = argv[i] + 16;
+      else if (strcmp(argv[i], "--benchmark_list_tests") == 0)
+         list_only = true;
+      else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+         usage(argv[0]);
+      else
+         sim_argv.push_back(argv[i]);
+   }
+
+   std::regex filter_re(filter.c_str());
+   std::vector<std::pair<String, std::pair<BenchmarkFunc, SInt64> > > runs;
+   for(std::vector<BenchmarkRegistry::Benchmark>::const_iterator it = BenchmarkRegistry::get().begin(); it != BenchmarkRegistry::get().end(); ++it)
+   {
+      std::vector<SInt64> args = it->args.empty() ? std::vector<SInt64>(1, -1) : it->args;
+      for(std::vector<SInt64>::iterator arg = args.begin(); arg != args.end(); ++arg)
+      {
+         String name = it->args.empty() ? String(it->name) : String(it->name) + "/" + itostr(*arg);
+         if (std::regex_search(name.c_str(), filter_re))
+            runs.push_back(std::make_pair(name, std::make_pair(it->func, *arg)));
+      }
+   }
+
+   if (list_only)
+   {
+      for(auto it = runs.begin(); it != runs.end(); ++it)
+         printf("%s\n", it->first.c_str());
+      return 0;
+   }
+
+   string_vec args;
+   String config_path = "carbon_sim.cfg";
+   parse_args(args, config_path, sim_argv.size(), sim_argv.data());
+
+   config::ConfigFile *cfg = new config::ConfigFile();
+   cfg->load(config_path);
+   handle_args(args, *cfg);
+
+   // Benchmarks create their own instances of the components they measure, run without an application
+   cfg->set("traceinput/enabled", "false");
+
+   Simulator::setConfig(cfg, Config::STANDALONE);
+   Simulator::allocate();
+   Sim()->start();
+
+   FILE *fp = NULL;
+   if (!out_file.empty())
+   {
+      fp = fopen(out_file.c_str(), "w");
+      LOG_ASSERT_ERROR(fp, "Cannot write to %s", out_file.c_str());
+
+      char hostname[256] = "";
+      gethostname(hostname, sizeof(hostname) - 1);
+      time_t now = time(NULL);
+      char date[64];
+      strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+
+      fprintf(fp, "{\n  \"context\": {\n    \"date\": ");
+      jsonString(fp, date);
+      fprintf(fp, ",\n    \"host_name\": ");
+      jsonString(fp, hostname);
+      fprintf(fp, ",\n    \"executable\": ");
+      jsonString(fp, argv[0]);
+      fprintf(fp, ",\n    \"num_cpus\": %ld", sysconf(_SC_NPROCESSORS_ONLN));
+#ifdef NDEBUG
+      fprintf(fp, ",\n    \"library_build_type\": \"release\"");
+#else
+      fprintf(fp, ",\n    \"library_build_type\": \"debug\"");
+#endif
+      fprintf(fp, "\n  },\n  \"benchmarks\": [");
+   }
+
+   printf("%-48s %16s %16s %12s %14s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations", "Items/s");
+   for(auto it = runs.begin(); it != runs.end(); ++it)
+   {
+      BenchmarkState state = BenchmarkRegistry::run(it->second.first, it->second.second, min_time);
+      double real_ns = 1e9 * state.getRealTime() / state.iterations();
+      double cpu_ns = 1e9 * state.getCpuTime() / state.iterations();
+      double items_per_second = state.getCpuTime() > 0 ? state.getItemsProcessed() / state.getCpuTime() : 0;
+
+      printf("%-48s %16.1f %16.1f %12" PRId64 " %14.4g\n", it->first.c_str(), real_ns, cpu_ns, state.iterations(), items_per_second);
+
+      if (fp)
+      {
+         fprintf(fp, "%s\n    {\n      \"name\": ", it == runs.begin() ? "" : ",");
+         jsonString(fp, it->first.c_str());
+         fprintf(fp, ",\n      \"run_name\": ");
+         jsonString(fp, it->first.c_str());
+         fprintf(fp, ",\n      \"run_type\": \"iteration\",\n      \"iterations\": %" PRId64 ",\n      \"real_time\": %.6e,\n      \"cpu_time\": %.6e,\n      \"time_unit\": \"ns\"",
+            state.iterations(), real_ns, cpu_ns);
+         if (state.getItemsProcessed())
+            fprintf(fp, ",\n      \"items_per_second\": %.6e", items_per_second);
+         fprintf(fp, "\n    }");
+      }
+   }
+
+   if (fp)
+   {
+      fprintf(fp, "\n  ]\n}\n");
+      fclose(fp);
+   }
+
+   Simulator::release();
+   delete cfg;
+
+   return 0;
+}
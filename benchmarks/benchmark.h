@@ -0,0 +1,106 @@
+#ifndef __BENCHMARK_H
+#define __BENCHMARK_H
+
+#include "fixed_types.h"
+
+#include <vector>
+#include <time.h>
+
+// Minimal micro-benchmark harness for simulator hot paths (lib/sniper-bench)
+//
+// Modeled after Google Benchmark: a benchmark is a function that repeats the measured operation
+// while state.keepRunning() returns true, and is run with enough iterations to take at least
+// --benchmark_min_time seconds. Results are printed as a table, and written as Google Benchmark
+// compatible JSON with --benchmark_out=<file> so existing comparison tools can be used on them.
+// Benchmarks run after a full Simulator was set up from the configuration given on the command line
+// (-c <config> and --section/key=value, as for lib/sniper), so components can be created as usual.
+
+class BenchmarkState
+{
+   public:
+      BenchmarkState(UInt64 iterations, SInt64 arg);
+
+      bool keepRunning()
+      {
+         if (__builtin_expect(m_remaining > 0, 1))
+         {
+            // Timing starts at the loop, setup before it is not measured
+            if (__builtin_expect(m_remaining == m_iterations, 0))
+               start();
+            --m_remaining;
+            return true;
+         }
+         stop();
+         return false;
+      }
+
+      // Exclude setup or cleanup inside the loop from the measurement
+      void pauseTiming();
+      void resumeTiming();
+
+      SInt64 arg() const { return m_arg; }
+      UInt64 iterations() const { return m_iterations; }
+      // Total number of items (instructions, accesses, messages, ...) processed by all iterations
+      void setItemsProcessed(UInt64 items) { m_items = items; }
+
+      double getRealTime() const { return m_real_time; }
+      double getCpuTime() const { return m_cpu_time; }
+      UInt64 getItemsProcessed() const { return m_items; }
+
+   private:
+      const UInt64 m_iterations;
+      const SInt64 m_arg;
+      UInt64 m_remaining;
+      UInt64 m_items;
+      bool m_running;
+      double m_real_time, m_cpu_time;
+      struct timespec m_real_start, m_cpu_start;
+
+      void start();
+      void stop();
+
+      friend class BenchmarkRegistry;
+};
+
+typedef void (*BenchmarkFunc)(BenchmarkState &state);
+
+class BenchmarkRegistry
+{
+   public:
+      struct Benchmark
+      {
+         const char *name;
+         BenchmarkFunc func;
+         std::vector<SInt64> args;   // Run once for each argument, or once without when empty
+      };
+
+      static int add(const char *name, BenchmarkFunc func, std::vector<SInt64> args = std::vector<SInt64>());
+      static const std::vector<Benchmark>& get() { return getList(); }
+
+      // Run one benchmark, increasing the number of iterations until it runs for at least min_time seconds
+      static BenchmarkState run(BenchmarkFunc func, SInt64 arg, double min_time);
+
+      // Statistics names need to be unique, and a benchmark is called several times while calibrating
+      // its number of iterations: use this as index for components that register statistics
+      static UInt32 nextInstance() { return m_instance++; }
+
+   private:
+      static UInt32 m_instance;
+
+      static std::vector<Benchmark>& getList();
+};
+
+// Prevent the compiler from optimizing away a computed value
+template <typename T> inline void benchmarkUse(T const &value)
+{
+   asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#define BENCHMARK_CONCAT2(a, b) a ## b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT2(a, b)
+
+// SNIPER_BENCHMARK(name, func) or SNIPER_BENCHMARK(name, func, { arg1, arg2, ... })
+#define SNIPER_BENCHMARK(...) \
+   static int BENCHMARK_CONCAT(__benchmark_, __LINE__) __attribute__((unused)) = BenchmarkRegistry::add(__VA_ARGS__)
+
+#endif // __BENCHMARK_H
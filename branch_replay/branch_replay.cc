@@ -0,0 +1,331 @@
+#include "branch_trace.h"
+#include "branch_predictor.h"
+#include "core_state_predictor.h"
+#include "core_state_timeline.h"
+#include "simulator.h"
+#include "handle_args.h"
+#include "config.hpp"
+#include "log.h"
+
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Replays branch traces written with [branch_trace/enabled] through the branch predictor configured by
+// [perf_model/branch_predictor/type], and the core-state predictor configured by [core_state_predictor/type],
+// without running the timing model. Core-state predictors can also be scored against the oracle timeline
+// written with [core_state_timeline/enabled].
+
+static void usage(const char *prog)
+{
+   fprintf(stderr, "Usage: %s -c <config> [--section/key=value ...] [--branch_trace=<branch_trace.N.bin> ...] [--core_state_timeline=<core_state_timeline.bin>]\n", prog);
+   exit(-1);
+}
+
+static double now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+struct ReplayStats
+{
+   UInt64 branches;
+   UInt64 mispredicts;
+   UInt64 csp_predictions;
+   UInt64 csp_correct;
+};
+
+static void replayCoreStates(CoreStatePredictor *csp, const BranchTrace::Record *records, UInt64 count, UInt64 interval_ns, ReplayStats &stats)
+{
+   // Same sampling as CoreStatePredictorManager::sample, on the core's own timeline
+   Core::State state = Core::RUNNING;
+   Core::State predicted = Core::NUM_STATES;
+   UInt64 time_next = count ? records[0].timeNS() + interval_ns : 0;
+   bool needs_branches = csp->needsBranches();
+
+   for(UInt64 i = 0; i < count; ++i)
+   {
+      const BranchTrace::Record &record = records[i];
+
+      while (record.timeNS() >= time_next)
+      {
+         if (predicted != Core::NUM_STATES)
+         {
+            ++stats.csp_predictions;
+            if (predicted == state)
+               ++stats.csp_correct;
+         }
+         csp->update(state);
+         predicted = csp->isConfident() ? csp->predict() : Core::NUM_STATES;
+         time_next += interval_ns;
+      }
+
+      if (record.isStateChange())
+      {
+         Core::State new_state = (Core::State)record.state();
+         if (new_state != state)
+            csp->stateChanged(state, new_state);
+         state = new_state;
+      }
+      else if (needs_branches)
+      {
+         csp->branch(record.ip, record.taken());
+      }
+   }
+}
+
+static void replayBranches(BranchPredictor *bp, const BranchTrace::Record *records, UInt64 count, ReplayStats &stats)
+{
+   for(UInt64 i = 0; i < count; ++i)
+   {
+      const BranchTrace::Record &record = records[i];
+      if (record.isStateChange())
+         continue;
+
+      bool prediction = bp->predict(record.indirect(), record.ip, record.target);
+      bp->update(prediction, record.taken(), record.indirect(), record.ip, record.target);
+      ++stats.branches;
+      if (prediction != record.taken())
+         ++stats.mispredicts;
+   }
+}
+
+struct TimelineStats
+{
+   UInt64 predictions;
+   UInt64 correct;
+   UInt64 idle_time;       // Oracle time spent idle, in fs
+   UInt64 active_time;
+   UInt64 idle_covered;    // Idle time in intervals that were predicted idle
+   UInt64 active_as_idle;  // Non-idle time in intervals that were predicted idle
+};
+
+static void evaluateTimeline(CoreStatePredictor *csp, const std::vector<CoreStateTimeline::Run> &runs, UInt64 interval_fs, TimelineStats &stats)
+{
+   // Same sampling as CoreStatePredictorManager::sample, on the concatenated runs: at the end of each interval,
+   // the prediction made at its start is scored, and the predictor sees the actual state
+   Core::State state = Core::NUM_STATES;
+   Core::State predicted = Core::NUM_STATES;
+   UInt64 elapsed = 0, time_next = interval_fs;
+   UInt64 idle_in_interval = 0, active_in_interval = 0;
+
+   for(auto it = runs.begin(); it != runs.end(); ++it)
+   {
+      Core::State new_state = (Core::State)it->state;
+      if (state != Core::NUM_STATES && new_state != state)
+         csp->stateChanged(state, new_state);
+      state = new_state;
+
+      for(UInt64 remaining = it->length; remaining > 0; )
+      {
+         UInt64 step = std::min(remaining, time_next - elapsed);
+         if (state == Core::IDLE)
+            idle_in_interval += step;
+         else
+            active_in_interval += step;
+         elapsed += step;
+         remaining -= step;
+
+         if (elapsed == time_next)
+         {
+            if (predicted != Core::NUM_STATES)
+            {
+               ++stats.predictions;
+               if (predicted == state)
+                  ++stats.correct;
+               if (predicted == Core::IDLE)
+               {
+                  stats.idle_covered += idle_in_interval;
+                  stats.active_as_idle += active_in_interval;
+               }
+            }
+            stats.idle_time += idle_in_interval;
+            stats.active_time += active_in_interval;
+            idle_in_interval = active_in_interval = 0;
+
+            csp->update(state);
+            predicted = csp->isConfident() ? csp->predict() : Core::NUM_STATES;
+            time_next += interval_fs;
+         }
+      }
+   }
+   stats.idle_time += idle_in_interval;
+   stats.active_time += active_in_interval;
+}
+
+static void replayTimeline(const String &filename, const String &csp_type, UInt64 interval_ns)
+{
+   int fd = open(filename.c_str(), O_RDONLY);
+   LOG_ASSERT_ERROR(fd >= 0, "Cannot open core state timeline %s", filename.c_str());
+   struct stat st;
+   fstat(fd, &st);
+   LOG_ASSERT_ERROR(size_t(st.st_size) >= sizeof(CoreStateTimeline::Header), "Core state timeline %s is truncated", filename.c_str());
+
+   void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+   LOG_ASSERT_ERROR(data != MAP_FAILED, "Cannot map core state timeline %s", filename.c_str());
+   close(fd);
+
+   const CoreStateTimeline::Header *header = (const CoreStateTimeline::Header *)data;
+   LOG_ASSERT_ERROR(header->magic == CoreStateTimeline::MAGIC, "%s is not a core state timeline", filename.c_str());
+   LOG_ASSERT_ERROR(header->version == CoreStateTimeline::VERSION && header->run_size == sizeof(CoreStateTimeline::Run),
+      "Core state timeline %s has version %u, expected %u", filename.c_str(), header->version, CoreStateTimeline::VERSION);
+   UInt32 num_cores = std::min(header->num_cores, Sim()->getConfig()->getApplicationCores());
+
+   // Runs are in order per core, but interleaved between cores. Only use the ROI, unless there was none.
+   const CoreStateTimeline::Run *runs = (const CoreStateTimeline::Run *)(header + 1);
+   UInt64 count = (st.st_size - sizeof(CoreStateTimeline::Header)) / sizeof(CoreStateTimeline::Run);
+   std::vector<std::vector<CoreStateTimeline::Run> > core_runs(num_cores), core_roi_runs(num_cores);
+   for(UInt64 i = 0; i < count; ++i)
+   {
+      if (runs[i].core_id >= num_cores)
+         continue;
+      core_runs[runs[i].core_id].push_back(runs[i]);
+      if (runs[i].in_roi)
+         core_roi_runs[runs[i].core_id].push_back(runs[i]);
+   }
+
+   UInt64 idle_freq_mhz = Sim()->getCfg()->getInt("core_state_predictor/idle_frequency");
+
+   printf("%-32s %5s %8s %12s %10s %10s %10s %10s\n", "Timeline", "Core", "Idle", "Predictions", "Correct", "Idle cov.", "False idle", "Savings");
+   for(UInt32 core_id = 0; core_id < num_cores; ++core_id)
+   {
+      const std::vector<CoreStateTimeline::Run> &timeline = core_roi_runs[core_id].empty() ? core_runs[core_id] : core_roi_runs[core_id];
+      TimelineStats stats = { 0, 0, 0, 0, 0, 0 };
+      CoreStatePredictor *csp = CoreStatePredictor::create(csp_type, core_id);
+      evaluateTimeline(csp, timeline, interval_ns * SubsecondTime::NS().getFS(), stats);
+      delete csp;
+
+      // First-order estimate: power scales with frequency, time correctly spent at the idle frequency saves the difference
+      double nominal_mhz = Sim()->getCfg()->getFloatArray("perf_model/core/frequency", core_id) * 1000;
+      double scale = nominal_mhz > idle_freq_mhz ? 1. - idle_freq_mhz / nominal_mhz : 0.;
+      UInt64 total = stats.idle_time + stats.active_time;
+
+      printf("%-32s %5u %7.2f%% %12" PRIu64 " %9.2f%% %9.2f%% %9.2f%% %9.2f%%\n", filename.c_str(), core_id,
+         total ? 100. * stats.idle_time / total : 0., stats.predictions,
+         stats.predictions ? 100. * stats.correct / stats.predictions : 0.,
+         stats.idle_time ? 100. * stats.idle_covered / stats.idle_time : 0.,
+         stats.active_time ? 100. * stats.active_as_idle / stats.active_time : 0.,
+         total ? 100. * scale * stats.idle_covered / total : 0.);
+   }
+
+   munmap(data, st.st_size);
+}
+
+int main(int argc, char* argv[])
+{
+   std::vector<String> traces;
+   std::vector<String> timelines;
+
+   // Strip our own options, the rest are passed to the simulator's configuration handling
+   std::vector<char*> sim_argv;
+   sim_argv.push_back(argv[0]);
+   for(int i = 1; i < argc; ++i)
+   {
+      if (strncmp(argv[i], "--branch_trace=", 15) == 0)
+         traces.push_back(argv[i] + 15);
+      else if (strncmp(argv[i], "--core_state_timeline=", 22) == 0)
+         timelines.push_back(argv[i] + 22);
+      else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+         usage(argv[0]);
+      else
+         sim_argv.push_back(argv[i]);
+   }
+   if (traces.empty() && timelines.empty())
+      usage(argv[0]);
+
+   string_vec args;
+   String config_path = "carbon_sim.cfg";
+   parse_args(args, config_path, sim_argv.size(), sim_argv.data());
+
+   config::ConfigFile *cfg = new config::ConfigFile();
+   cfg->load(config_path);
+   handle_args(args, *cfg);
+
+   // Predictors are driven from the traces, run without an application
+   cfg->set("traceinput/enabled", "false");
+   cfg->set("branch_trace/enabled", "false");
+
+   Simulator::setConfig(cfg, Config::STANDALONE);
+   Simulator::allocate();
+   Sim()->start();
+
+   String csp_type = Sim()->getCfg()->getString("core_state_predictor/type");
+   UInt64 interval_ns = Sim()->getCfg()->getInt("core_state_predictor/interval");
+   LOG_ASSERT_ERROR(interval_ns > 0, "core_state_predictor/interval must be non-zero");
+
+   if (!timelines.empty())
+   {
+      LOG_ASSERT_ERROR(csp_type != "none", "Scoring a core state timeline needs a core_state_predictor/type");
+      for(auto it = timelines.begin(); it != timelines.end(); ++it)
+         replayTimeline(*it, csp_type, interval_ns);
+   }
+
+   std::vector<bool> replayed(Sim()->getConfig()->getApplicationCores(), false);
+   if (!traces.empty())
+      printf("%-32s %5s %14s %12s %10s %10s %12s\n", "Trace", "Core", "Branches", "Mispredicts", "MPKB", "MIPS", "CSP correct");
+   for(auto it = traces.begin(); it != traces.end(); ++it)
+   {
+      int fd = open(it->c_str(), O_RDONLY);
+      LOG_ASSERT_ERROR(fd >= 0, "Cannot open branch trace %s", it->c_str());
+      struct stat st;
+      fstat(fd, &st);
+      LOG_ASSERT_ERROR(size_t(st.st_size) >= sizeof(BranchTrace::Header), "Branch trace %s is truncated", it->c_str());
+
+      void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+      LOG_ASSERT_ERROR(data != MAP_FAILED, "Cannot map branch trace %s", it->c_str());
+      close(fd);
+
+      const BranchTrace::Header *header = (const BranchTrace::Header *)data;
+      LOG_ASSERT_ERROR(header->magic == BranchTrace::MAGIC, "%s is not a branch trace", it->c_str());
+      LOG_ASSERT_ERROR(header->version == BranchTrace::VERSION && header->record_size == sizeof(BranchTrace::Record),
+         "Branch trace %s has version %u, expected %u", it->c_str(), header->version, BranchTrace::VERSION);
+      LOG_ASSERT_ERROR(header->core_id < Sim()->getConfig()->getApplicationCores(),
+         "Branch trace %s is for core %u, only %u cores are configured", it->c_str(), header->core_id, Sim()->getConfig()->getApplicationCores());
+
+      // Predictors register statistics per core, so each core can only be replayed once
+      LOG_ASSERT_ERROR(!replayed[header->core_id], "More than one branch trace given for core %u", header->core_id);
+      replayed[header->core_id] = true;
+
+      const BranchTrace::Record *records = (const BranchTrace::Record *)(header + 1);
+      UInt64 count = (st.st_size - sizeof(BranchTrace::Header)) / sizeof(BranchTrace::Record);
+
+      ReplayStats stats = { 0, 0, 0, 0 };
+
+      // Predictors own registered statistics, don't delete them
+      BranchPredictor *bp = BranchPredictor::create(header->core_id);
+      double start = now();
+      if (bp)
+         replayBranches(bp, records, count, stats);
+      double elapsed = now() - start;
+
+      if (csp_type != "none")
+      {
+         CoreStatePredictor *csp = CoreStatePredictor::create(csp_type, header->core_id);
+         replayCoreStates(csp, records, count, interval_ns, stats);
+         delete csp;
+      }
+
+      char csp_result[32] = "-";
+      if (stats.csp_predictions)
+         snprintf(csp_result, sizeof(csp_result), "%.2f%%", 100. * stats.csp_correct / stats.csp_predictions);
+
+      printf("%-32s %5u %14" PRIu64 " %12" PRIu64 " %10.2f %10.1f %12s\n", it->c_str(), header->core_id,
+         stats.branches, stats.mispredicts, stats.branches ? 1000. * stats.mispredicts / stats.branches : 0.,
+         elapsed > 0 ? stats.branches / elapsed / 1e6 : 0., csp_result);
+
+      munmap(data, st.st_size);
+   }
+
+   Simulator::release();
+   delete cfg;
+
+   return 0;
+}
@@ -71,57 +71,83 @@ namespace config
     {
         m_path = path;
         loadConfig();
+        invalidateIndex();
     }
 
     void Config::clear()
     {
         m_root.clear();
+        invalidateIndex();
     }
 
-    bool Config::hasKey(const String & path, UInt64 index)
+    void Config::invalidateIndex()
     {
-        //Handle the base case
-        if(isLeaf(path))
-        {
-            if(m_root.hasKey(path, index))
-                return true;
-            else
-                return false;
-        }
+        std::lock_guard<std::mutex> guard(m_index_lock);
+        m_index_valid.store(false, std::memory_order_relaxed);
+        m_generation.fetch_add(1, std::memory_order_relaxed);
+    }
 
-        //Disect the path
-        PathPair path_pair = Config::splitPath(path);
-        Section & section = getSection_unsafe(path_pair.first);
+    //Add all keys below section to the lookup table, prefix is the path of section (including a trailing /)
+    void Config::buildIndex(const Section & section, const String & prefix)
+    {
+        for(KeyList::const_iterator i = section.getKeys().begin(); i != section.getKeys().end(); i++)
+            if (i->second)
+                m_index[prefix + i->first].value = i->second;
 
-        if(section.hasKey(path_pair.second, index))
-            return true;
-        else
-            return false;
+        for(KeyArrayList::const_iterator i = section.getArrayKeys().begin(); i != section.getArrayKeys().end(); i++)
+            m_index[prefix + i->first].overrides = &i->second;
+
+        for(SectionList::const_iterator i = section.getSubsections().begin(); i != section.getSubsections().end(); i++)
+            buildIndex(*i->second, prefix + i->first + "/");
     }
 
-    const Key & Config::getKey(const String & path, UInt64 index)
+    const ResolvedKey * Config::resolveKey(const String & path)
     {
-        //Handle the base case
-        if(isLeaf(path))
+        if (!m_index_valid.load(std::memory_order_acquire))
         {
-            if(!m_root.hasKey(path, index))
+            std::lock_guard<std::mutex> guard(m_index_lock);
+            if (!m_index_valid.load(std::memory_order_relaxed))
             {
-                if (index == UINT64_MAX)
-                    config::Error("Configuration value %s not found.", path.c_str());
-                else
-                    config::Error("Configuration value %s[%i] not found.", path.c_str(), index);
-            }
-            else
-            {
-                return m_root.getKey(path, index);
+                m_index.clear();
+                buildIndex(m_root, "");
+                m_index_valid.store(true, std::memory_order_release);
             }
         }
 
-        //Disect the path
-        PathPair path_pair = Config::splitPath(path);
-        Section & section = getSection_unsafe(path_pair.first);
+        KeyIndex::const_iterator found;
+        if (m_case_sensitive)
+            found = m_index.find(path);
+        else
+            found = m_index.find(boost::to_lower_copy(path));
+
+        return found == m_index.end() ? NULL : &found->second;
+    }
+
+    const Key * Config::selectKey(const ResolvedKey & resolved, UInt64 index)
+    {
+        if (index != UINT64_MAX && resolved.overrides && index < resolved.overrides->size() && (*resolved.overrides)[index])
+            return (*resolved.overrides)[index];
+        else
+            return resolved.value;
+    }
+
+    bool Config::hasKey(const String & path, UInt64 index)
+    {
+        const ResolvedKey * resolved = resolveKey(path);
+        if (!resolved)
+            return false;
+        else if (index == UINT64_MAX)
+            return true;
+        else
+            return selectKey(*resolved, index) != NULL;
+    }
 
-        if(!section.hasKey(path_pair.second, index))
+    const Key & Config::getKey(const String & path, UInt64 index)
+    {
+        const ResolvedKey * resolved = resolveKey(path);
+        const Key * key = resolved ? selectKey(*resolved, index) : NULL;
+
+        if(!key)
         {
             if (index == UINT64_MAX)
                 config::Error("Configuration value %s not found.", path.c_str());
@@ -129,7 +155,7 @@ namespace config
                 config::Error("Configuration value %s[%i] not found.", path.c_str(), index);
         }
 
-        return section.getKey(path_pair.second, index);
+        return *key;
     }
 
     const Section & Config::addSection(const String & path)
@@ -168,11 +194,17 @@ namespace config
     {
         //Handle the base case
         if(isLeaf(path))
-            return m_root.addKey(path, value, index);
+        {
+            const Key & key = m_root.addKey(path, value, index);
+            invalidateIndex();
+            return key;
+        }
 
         PathPair path_pair = Config::splitPath(path);
         Section &parent = getSection_unsafe(path_pair.first);
-        return parent.addKey(path_pair.second, value, index);
+        const Key & key = parent.addKey(path_pair.second, value, index);
+        invalidateIndex();
+        return key;
     }
 
     //Convert the in-memory representation into a string
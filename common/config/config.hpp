@@ -19,6 +19,10 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <type_traits>
 #include <iostream>
 
 namespace config
@@ -30,6 +34,14 @@ namespace config
     typedef std::vector < String > PathElementList;
     typedef std::pair<String,String> PathPair;
 
+    /*! \brief ResolvedKey: all values of a key, found through the lookup table of Config::resolveKey()
+     */
+    struct ResolvedKey
+    {
+        const Key * value;                   //!< The default value, NULL if the key only has per-index overrides
+        const std::vector<Key*> * overrides; //!< The per-index overrides, NULL if there are none
+    };
+
     /*! \brief Config: A class for managing the interface to persistent configuration entries defined at runtime.
      * This class is used to manage a configuration interface.
      * It is the base class for which different back ends will derive from.
@@ -37,8 +49,8 @@ namespace config
     class Config
     {
         public:
-            Config(bool case_sensitive = false): m_case_sensitive(case_sensitive), m_root("", case_sensitive){}
-            Config(const Section & root, bool case_sensitive = false): m_case_sensitive(case_sensitive), m_root(root, "", case_sensitive){}
+            Config(bool case_sensitive = false): m_case_sensitive(case_sensitive), m_root("", case_sensitive), m_index_valid(false), m_generation(0){}
+            Config(const Section & root, bool case_sensitive = false): m_case_sensitive(case_sensitive), m_root(root, "", case_sensitive), m_index_valid(false), m_generation(0){}
             virtual ~Config(){}
 
             /*! \brief A function for saving the entire configuration
@@ -160,12 +172,28 @@ namespace config
              */
             const Key & addKey(const String & path, const double new_key, UInt64 index = UINT64_MAX) { return addKeyInternal(path, new_key, index); }
 
+            /*! \brief Look up all values of the key at the given path, returns NULL if the key doesn't exist.
+             * On the first lookup after the tree has changed, all keys are resolved at once into a hash table
+             * indexed by their full path, so lookups don't need to split the path and walk the section tree.
+             * The result stays valid until the tree is changed, which increments getGeneration().
+             */
+            const ResolvedKey * resolveKey(const String & path);
+
+            //! Returns the override for the given index if there is one, else the default value (NULL if neither exists)
+            static const Key * selectKey(const ResolvedKey & resolved, UInt64 index);
+
+            //! Incremented every time the tree changes
+            UInt64 getGeneration() const { return m_generation.load(std::memory_order_relaxed); }
+
         protected:
             bool m_case_sensitive;
             Section m_root;
             String m_path;
             virtual void loadConfig() = 0;
 
+            //! Must be called after changing the tree
+            void invalidateIndex();
+
             Section & getSection_unsafe(String const& path);
             Section & getRoot_unsafe() { return m_root; };
             Key & getKey_unsafe(String const& path);
@@ -188,6 +216,67 @@ namespace config
 
             //Utility function to determine if a given path is a leaf (i.e. it has no '/'s in it)
             static bool isLeaf(const String & path);
+
+            //Lookup table used by resolveKey(), from full key path (lower case unless case sensitive) to its values
+            typedef std::unordered_map<String, ResolvedKey> KeyIndex;
+            KeyIndex m_index;
+            std::atomic<bool> m_index_valid;
+            std::atomic<UInt64> m_generation;
+            std::mutex m_index_lock;
+
+            void buildIndex(const Section & section, const String & prefix);
+    };
+
+    /*! \brief ConfigKey: a typed handle to a configuration key
+     * The path is resolved once (and again only if the configuration changes), subsequent get() calls
+     * just pick the value for the requested index, so handles can be used on runtime paths.
+     * T can be bool, any integer or floating point type, or String.
+     */
+    template <class T>
+    class ConfigKey
+    {
+        public:
+            ConfigKey(Config & config, const String & path)
+                : m_config(config), m_path(path), m_resolved(NULL), m_generation(UINT64_MAX)
+            {}
+
+            //! Returns the value for the given index (e.g. a core id), or the default value
+            T get(UInt64 index = UINT64_MAX)
+            {
+                if (m_generation != m_config.getGeneration())
+                {
+                    m_generation = m_config.getGeneration();
+                    m_resolved = m_config.resolveKey(m_path);
+                }
+
+                const Key * key = m_resolved ? Config::selectKey(*m_resolved, index) : NULL;
+                if (!key)
+                {
+                    if (index == UINT64_MAX)
+                        config::Error("Configuration value %s not found.", m_path.c_str());
+                    else
+                        config::Error("Configuration value %s[%i] not found.", m_path.c_str(), index);
+                }
+
+                if constexpr (std::is_same<T, bool>::value)
+                    return key->getBool();
+                else if constexpr (std::is_integral<T>::value)
+                    return key->getInt();
+                else if constexpr (std::is_floating_point<T>::value)
+                    return key->getFloat();
+                else
+                    return key->getString();
+            }
+
+            T operator[](UInt64 index) { return get(index); }
+
+            const String & getPath() const { return m_path; }
+
+        private:
+            Config & m_config;
+            const String m_path;
+            const ResolvedKey * m_resolved;
+            UInt64 m_generation;
     };
 
 }//end of namespace config
@@ -69,6 +69,7 @@ namespace config
     void ConfigFile::loadConfigFromString(const String & cfg)
     {
         parse(cfg, m_root);
+        invalidateIndex();
     }
 
 
@@ -41,6 +41,9 @@ class BbvCount
       UInt64 getDiff();
       UInt64 getDimension(int dim) { return m_bbv_counts_abs.at(dim) - m_bbv_reset.at(dim); }
       UInt64 getInstructionCount(void) const { return m_instrs_abs - m_instrs_reset; }
+      // Running counts, unaffected by reset()
+      UInt64 getAbsoluteDimension(int dim) const { return m_bbv_counts_abs.at(dim); }
+      UInt64 getAbsoluteInstructionCount(void) const { return m_instrs_abs; }
 };
 
 #endif // BBV_COUNT_H
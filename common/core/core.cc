@@ -7,6 +7,8 @@
 #include "instruction.h"
 #include "clock_skew_minimization_object.h"
 #include "core_manager.h"
+#include "thread_manager.h"
+#include "thread.h"
 #include "dvfs_manager.h"
 #include "hooks_manager.h"
 #include "trace_manager.h"
@@ -16,6 +18,10 @@
 #include "stats.h"
 #include "topology_info.h"
 #include "cheetah_manager.h"
+#include "instruction_aggregator.h"
+#include "branch_trace.h"
+#include "deterministic_order.h"
+#include "memory_sampler.h"
 
 #include <cstring>
 
@@ -61,8 +67,6 @@ const char * Core::CoreStateString(Core::State state)
 
 
 Lock Core::m_global_core_lock;
-UInt64 Core::g_instructions_hpi_global = 0;
-UInt64 Core::g_instructions_hpi_global_callback = 0;
 
 Core::Core(SInt32 id)
    : m_core_id(id)
@@ -71,11 +75,21 @@ Core::Core(SInt32 id)
    , m_bbv(id)
    , m_topology_info(new TopologyInfo(id))
    , m_cheetah_manager(Sim()->getCfg()->getBool("core/cheetah/enabled") ? new CheetahManager(id) : NULL)
+   , m_branch_trace(NULL)
    , m_core_state(Core::IDLE)
-   , m_icache_last_block(-1)
+   , m_state_history(NULL)
+   , m_state_since(SubsecondTime::Zero())
+   , m_models_requested(false)
+   , m_models_enabled(false)
+   , m_fetch_buffer(Sim()->getCfg()->getIntArray("perf_model/l1_icache/fetch_buffer_lines", id), -1)
+   , m_fetch_buffer_next(0)
+   , m_icache_blockmask(0)
    , m_spin_loops(0)
    , m_spin_instructions(0)
    , m_spin_elapsed_time(SubsecondTime::Zero())
+   , m_spin_skips(0)
+   , m_spin_skipped_instructions(0)
+   , m_spin_skipped_time(SubsecondTime::Zero())
    , m_instructions(0)
    , m_instructions_callback(UINT64_MAX)
    , m_instructions_hpi_callback(0)
@@ -87,6 +101,9 @@ Core::Core(SInt32 id)
    registerStatsMetric("core", id, "spin_loops", &m_spin_loops);
    registerStatsMetric("core", id, "spin_instructions", &m_spin_instructions);
    registerStatsMetric("core", id, "spin_elapsed_time", &m_spin_elapsed_time);
+   registerStatsMetric("core", id, "spin_skips", &m_spin_skips);
+   registerStatsMetric("core", id, "spin_skipped_instructions", &m_spin_skipped_instructions);
+   registerStatsMetric("core", id, "spin_skipped_time", &m_spin_skipped_time);
 
    Sim()->getStatsManager()->logTopology("hwcontext", id, id);
 
@@ -100,14 +117,27 @@ Core::Core(SInt32 id)
    m_memory_manager = MemoryManagerBase::createMMU(
          Sim()->getCfg()->getString("caching_protocol/type"),
          this, m_network, m_shmem_perf_model);
+   m_icache_blockmask = ~(IntPtr(getMemoryManager()->getCacheBlockSize()) - 1);
+   LOG_ASSERT_ERROR(m_fetch_buffer.size() > 0, "perf_model/l1_icache/fetch_buffer_lines must be at least 1");
 
    m_performance_model = PerformanceModel::create(this);
+
+   if (Sim()->getCfg()->getBool("branch_trace/enabled") && id < (SInt32)Sim()->getConfig()->getApplicationCores())
+      m_branch_trace = new BranchTrace::Writer(Sim()->getConfig()->formatOutputFileName("branch_trace." + itostr(id) + ".bin"), id);
+
+   UInt32 history_size = Sim()->getCfg()->getIntArray("core/state_history/size", id);
+   if (history_size)
+      m_state_history = new CoreStateHistory(history_size);
 }
 
 Core::~Core()
 {
    if (m_cheetah_manager)
       delete m_cheetah_manager;
+   if (m_branch_trace)
+      delete m_branch_trace;
+   if (m_state_history)
+      delete m_state_history;
    delete m_topology_info;
    delete m_memory_manager;
    delete m_shmem_perf_model;
@@ -117,6 +147,62 @@ Core::~Core()
    delete m_network;
 }
 
+void Core::setState(State core_state)
+{
+   if (core_state == m_core_state)
+      return;
+
+   State old_state = m_core_state;
+   m_core_state = core_state;
+
+   if (m_state_history)
+   {
+      SubsecondTime now = m_performance_model ? m_performance_model->getElapsedTime() : SubsecondTime::Zero();
+      // Don't let a rewound elapsed time underflow the duration
+      m_state_history->push(old_state, now > m_state_since ? now - m_state_since : SubsecondTime::Zero());
+      m_state_since = now;
+   }
+
+   if (m_branch_trace)
+      m_branch_trace->stateChange(m_performance_model ? m_performance_model->getElapsedTime().getNS() : 0, core_state);
+
+   if (Sim()->getHooksManager()->hasHooks(HookType::HOOK_CORE_STATE_CHANGE, m_core_id))
+   {
+      HooksManager::CoreStateChange args = { core_id: m_core_id, old_state: old_state, new_state: core_state,
+                                             time: m_performance_model ? m_performance_model->getElapsedTime() : SubsecondTime::Zero() };
+      Sim()->getHooksManager()->callHooks(HookType::HOOK_CORE_STATE_CHANGE, (UInt64)&args, false, m_core_id);
+   }
+}
+
+void Core::setPerformanceModelsEnabled(bool enabled)
+{
+   m_models_requested = enabled;
+   if (m_models_enabled == enabled)
+      return;
+
+   // Our own thread is not in the middle of an instruction, and a core that is not running
+   // a thread won't reach an instruction boundary any time soon: switch these right away
+   Core *current = Sim()->getCoreManager()->getCurrentCore();
+   if (current == this || !m_thread || !Sim()->getThreadManager()->isThreadRunning(m_thread->getId()))
+      updatePerformanceModels();
+}
+
+void Core::updatePerformanceModels()
+{
+   ScopedLock sl(m_models_lock);
+
+   // Repeated toggles may cancel each other out before we get here, all models then keep their state
+   bool enabled = m_models_requested;
+   if (m_models_enabled == enabled)
+      return;
+   m_models_enabled = enabled;
+
+   if (enabled)
+      enablePerformanceModels();
+   else
+      disablePerformanceModels();
+}
+
 void Core::enablePerformanceModels()
 {
    getShmemPerfModel()->enable();
@@ -138,6 +224,8 @@ Core::countInstructions(IntPtr address, UInt32 count)
 {
    bool check_rescheduled = false;
 
+   checkPerformanceModels();
+
    m_instructions += count;
    if (m_bbv.sample())
       m_bbv.count(address, count);
@@ -165,12 +253,13 @@ Core::hookPeriodicInsCheck()
 {
    if (m_instructions > m_instructions_hpi_callback)
    {
-      __sync_fetch_and_add(&g_instructions_hpi_global, m_instructions - m_instructions_hpi_last);
+      InstructionAggregator *aggregator = Sim()->getCoreManager()->getInstructionAggregator();
+      bool crossed = aggregator->add(m_core_id, m_instructions - m_instructions_hpi_last);
       m_instructions_hpi_callback += Sim()->getConfig()->getHPIInstructionsPerCore();
       m_instructions_hpi_last = m_instructions;
 
       // Quick, unlocked check if we should do the HOOK_PERIODIC_INS callback
-      if (g_instructions_hpi_global > g_instructions_hpi_global_callback)
+      if (crossed)
          hookPeriodicInsCall();
    }
 }
@@ -180,13 +269,15 @@ Core::hookPeriodicInsCall()
 {
    // Take the Thread lock, to make sure no other core calls us at the same time
    // and that the hook callback is also serialized w.r.t. other global events
+   DeterministicOrder::Scope order(m_core_id, m_performance_model->getElapsedTime());
    ScopedLock sl(Sim()->getThreadManager()->getLock());
 
    // Definitive, locked checked if we should do the HOOK_PERIODIC_INS callback
-   if (g_instructions_hpi_global > g_instructions_hpi_global_callback)
+   InstructionAggregator *aggregator = Sim()->getCoreManager()->getInstructionAggregator();
+   if (aggregator->getRoot() > aggregator->getRootCallback())
    {
-      Sim()->getHooksManager()->callHooks(HookType::HOOK_PERIODIC_INS, g_instructions_hpi_global);
-      g_instructions_hpi_global_callback += Sim()->getConfig()->getHPIInstructionsGlobal();
+      Sim()->getHooksManager()->callHooks(HookType::HOOK_PERIODIC_INS, aggregator->getRoot());
+      aggregator->advanceRootCallback(Sim()->getConfig()->getHPIInstructionsGlobal());
    }
 }
 
@@ -196,6 +287,9 @@ Core::accessBranchPredictor(IntPtr eip, bool taken, bool indirect, IntPtr target
    PerformanceModel *prfmdl = getPerformanceModel();
    BranchPredictor *bp = prfmdl->getBranchPredictor();
 
+   if (m_branch_trace)
+      m_branch_trace->branch(prfmdl->getElapsedTime().getNS(), m_core_state, eip, target, taken, indirect);
+
    if (bp)
    {
       bool prediction = bp->predict(indirect, eip, target);
@@ -230,16 +324,15 @@ Core::readInstructionMemory(IntPtr address, UInt32 instruction_size)
    LOG_PRINT("Instruction: Address(0x%x), Size(%u), Start READ",
            address, instruction_size);
 
-   UInt64 blockmask = ~(getMemoryManager()->getCacheBlockSize() - 1);
-   bool single_cache_line = ((address & blockmask) == ((address + instruction_size - 1) & blockmask));
+   bool single_cache_line = ((address & m_icache_blockmask) == ((address + instruction_size - 1) & m_icache_blockmask));
 
    // Assume the core reads full instruction cache lines and caches them internally for subsequent instructions.
    // This reduces L1-I accesses and power to more realistic levels.
    // For Nehalem, it's in fact only 16 bytes, other architectures (Sandy Bridge) have a micro-op cache,
    // so this is just an approximation.
 
-   // When accessing the same cache line as last time, don't access the L1-I
-   if ((address & blockmask) == m_icache_last_block)
+   // When accessing a recently fetched cache line, don't access the L1-I
+   if (fetchBufferHit(address & m_icache_blockmask))
    {
       if (single_cache_line)
       {
@@ -248,16 +341,47 @@ Core::readInstructionMemory(IntPtr address, UInt32 instruction_size)
       else
       {
          // Instruction spanning cache lines: drop the first line, do access the second one
-         address = (address & blockmask) + getMemoryManager()->getCacheBlockSize();
+         address = (address & m_icache_blockmask) + getMemoryManager()->getCacheBlockSize();
       }
    }
 
-   // Update the most recent cache line accessed
-   m_icache_last_block = address & blockmask;
-
    // Cases with multiple cache lines or when we are not sure that it will be a hit call into the caches
-   return initiateMemoryAccess(MemComponent::L1_ICACHE,
-             Core::NONE, Core::READ, address & blockmask, NULL, getMemoryManager()->getCacheBlockSize(), MEM_MODELED_COUNT_TLBTIME, 0, SubsecondTime::MaxTime());
+   return fetchInstructionLine(address & m_icache_blockmask);
+}
+
+void
+Core::readInstructionBlock(IntPtr address, UInt32 size)
+{
+   IntPtr last = (address + (size ? size : 1) - 1) & m_icache_blockmask;
+   for(IntPtr block = address & m_icache_blockmask; block <= last; block += getMemoryManager()->getCacheBlockSize())
+   {
+      if (!fetchBufferHit(block))
+         fetchInstructionLine(block);
+   }
+}
+
+MemoryResult
+Core::fetchInstructionLine(IntPtr block)
+{
+   MemoryResult res = initiateMemoryAccess(MemComponent::L1_ICACHE,
+             Core::NONE, Core::READ, block, NULL, getMemoryManager()->getCacheBlockSize(), MEM_MODELED_COUNT_TLBTIME, 0, SubsecondTime::MaxTime());
+   fetchBufferInsert(block);
+   return res;
+}
+
+void
+Core::fetchBufferInsert(IntPtr block)
+{
+   m_fetch_buffer[m_fetch_buffer_next] = block;
+   m_fetch_buffer_next = (m_fetch_buffer_next + 1) % m_fetch_buffer.size();
+}
+
+void
+Core::invalidateFetchBuffer(IntPtr block)
+{
+   for(std::vector<IntPtr>::iterator it = m_fetch_buffer.begin(); it != m_fetch_buffer.end(); ++it)
+      if (*it == block)
+         *it = -1;
 }
 
 void Core::accessMemoryFast(bool icache, mem_op_t mem_op_type, IntPtr address)
@@ -265,12 +389,35 @@ void Core::accessMemoryFast(bool icache, mem_op_t mem_op_type, IntPtr address)
    if (m_cheetah_manager && icache == false)
       m_cheetah_manager->access(mem_op_type, address);
 
+   DeterministicOrder::Scope order(m_core_id, m_performance_model->getElapsedTime());
    SubsecondTime latency = getMemoryManager()->coreInitiateMemoryAccessFast(icache, mem_op_type, address);
 
    if (latency > SubsecondTime::Zero())
       m_performance_model->handleMemoryLatency(latency, HitWhere::MISS);
 }
 
+void
+Core::warmMemoryBatch(const CacheOnlyAccess* accesses, UInt32 count)
+{
+   if (count == 0)
+      return;
+
+   SubsecondTime initial_time = getPerformanceModel()->getElapsedTime();
+
+   DeterministicOrder::Scope order(m_core_id, initial_time);
+   ScopedLock sl(m_mem_lock);
+
+   if (m_cheetah_manager)
+      for(UInt32 i = 0; i < count; ++i)
+         m_cheetah_manager->access(accesses[i].mem_op_type, accesses[i].address & ~IntPtr(getMemoryManager()->getCacheBlockSize() - 1));
+
+   SubsecondTime latency = getMemoryManager()->coreWarmMemoryBatch(accesses, count, initial_time);
+
+   if (latency > SubsecondTime::Zero())
+      m_performance_model->handleMemoryLatency(latency, HitWhere::MISS);
+   getShmemPerfModel()->incrTotalMemoryAccessLatency(latency);
+}
+
 MemoryResult
 Core::initiateMemoryAccess(MemComponent::component_t mem_component,
       lock_signal_t lock_signal,
@@ -291,6 +438,12 @@ Core::initiateMemoryAccess(MemComponent::component_t mem_component,
    // Setting the initial time
    SubsecondTime initial_time = (now == SubsecondTime::MaxTime()) ? getPerformanceModel()->getElapsedTime() : now;
 
+   // In deterministic mode, wait for our turn before touching the memory hierarchy.
+   // An atomic operation (LOCK ... UNLOCK) keeps its turn until the second half
+   DeterministicOrder *order = Sim()->getDeterministicOrder();
+   if (order && lock_signal != Core::UNLOCK)
+      order->acquire(m_core_id, initial_time);
+
    // Protect from concurrent access by user thread (doing rewritten memops) and core thread (doing icache lookups)
    if (lock_signal != Core::UNLOCK)
       m_mem_lock.acquire();
@@ -368,7 +521,8 @@ Core::initiateMemoryAccess(MemComponent::component_t mem_component,
                mem_op_type,
                curr_addr_aligned, curr_offset,
                data_buf ? curr_data_buffer_head : NULL, curr_size,
-               modeled);
+               modeled,
+               eip);
 
       if (hit_where != (HitWhere::where_t)mem_component)
       {
@@ -403,6 +557,8 @@ Core::initiateMemoryAccess(MemComponent::component_t mem_component,
 
    if (lock_signal != Core::LOCK)
       m_mem_lock.release();
+   if (order && lock_signal != Core::LOCK)
+      order->release(m_core_id);
 
    // Calculate the round-trip time
    SubsecondTime shmem_time = final_time - initial_time;
@@ -442,6 +598,10 @@ Core::initiateMemoryAccess(MemComponent::component_t mem_component,
 
    LOG_ASSERT_ERROR(hit_where != HitWhere::UNKNOWN, "HitWhere == UNKNOWN");
 
+   MemorySampler *sampler = Sim()->getMemorySampler();
+   if (sampler && mem_component == MemComponent::L1_DCACHE && modeled != MEM_MODELED_NONE)
+      sampler->access(m_core_id, address, eip, hit_where, shmem_time, mem_op_type == WRITE);
+
    return makeMemoryResult(hit_where, shmem_time);
 }
 
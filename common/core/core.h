@@ -11,6 +11,7 @@ class ClockSkewMinimizationClient;
 class ShmemPerfModel;
 class TopologyInfo;
 class CheetahManager;
+namespace BranchTrace { class Writer; }
 
 #include "mem_component.h"
 #include "fixed_types.h"
@@ -20,6 +21,10 @@ class CheetahManager;
 #include "bbv_count.h"
 #include "cpuid.h"
 #include "hit_where.h"
+#include "core_state_history.h"
+
+#include <atomic>
+#include <vector>
 
 struct MemoryResult {
    HitWhere::where_t hit_where;
@@ -78,6 +83,14 @@ class Core
          MEM_MODELED_RETURN,    /* Count + time + return data to construct DynamicInstruction */
       };
 
+      /* A data access of cache-only warmup, see warmMemoryBatch */
+      struct CacheOnlyAccess
+      {
+         mem_op_t mem_op_type;
+         IntPtr address;
+         IntPtr eip;
+      };
+
       static const char * CoreStateString(State state);
 
       Core(SInt32 id);
@@ -88,11 +101,18 @@ class Core
 
       MemoryResult readInstructionMemory(IntPtr address,
             UInt32 instruction_size);
+      // Fetch all cache lines of a basic block (cache-only warmup)
+      void readInstructionBlock(IntPtr address, UInt32 size);
+      // Called by the L1-I when a line leaves it (eviction, invalidation)
+      void invalidateFetchBuffer(IntPtr block);
 
       MemoryResult accessMemory(lock_signal_t lock_signal, mem_op_t mem_op_type, IntPtr d_addr, char* data_buffer, UInt32 data_size, MemModeled modeled = MEM_MODELED_NONE, IntPtr eip = 0, SubsecondTime now = SubsecondTime::MaxTime(), bool is_fault_mask = false);
       MemoryResult nativeMemOp(lock_signal_t lock_signal, mem_op_t mem_op_type, IntPtr d_addr, char* data_buffer, UInt32 data_size);
 
       void accessMemoryFast(bool icache, mem_op_t mem_op_type, IntPtr address);
+      // Cache-only warmup: a run of data accesses (MEM_MODELED_COUNT, no data), under a single acquisition of the memory lock.
+      // Each access touches only the cache line containing its address.
+      void warmMemoryBatch(const CacheOnlyAccess* accesses, UInt32 count);
 
       void logMemoryHit(bool icache, mem_op_t mem_op_type, IntPtr address, MemModeled modeled = MEM_MODELED_NONE, IntPtr eip = 0);
       bool countInstructions(IntPtr address, UInt32 count);
@@ -115,16 +135,22 @@ class Core
       const CheetahManager* getCheetahManager() const { return m_cheetah_manager; }
 
       State getState() const { return m_core_state; }
-      void setState(State core_state) { m_core_state = core_state; }
+      void setState(State core_state);
+      // Recent states and their durations, NULL unless [core/state_history] size is set
+      const CoreStateHistory* getStateHistory() const { return m_state_history; }
       UInt64 getInstructionCount() { return m_instructions; }
+      // Instructions not yet added to the global InstructionAggregator
+      UInt64 getInstructionCountUnaggregated() { return m_instructions - m_instructions_hpi_last; }
       BbvCount *getBbvCount() { return &m_bbv; }
       UInt64 getInstructionsCallback() { return m_instructions_callback; }
       bool isEnabledInstructionsCallback() { return m_instructions_callback != UINT64_MAX; }
       void setInstructionsCallback(UInt64 instructions) { m_instructions_callback = m_instructions + instructions; }
       void disableInstructionsCallback() { m_instructions_callback = UINT64_MAX; }
 
-      void enablePerformanceModels();
-      void disablePerformanceModels();
+      // Request the performance models to be switched on or off. The change is applied by the core's own
+      // thread at its next instruction boundary, or right away if no thread is running on this core.
+      void setPerformanceModelsEnabled(bool enabled);
+      bool isPerformanceModelsEnabled() const { return m_models_enabled; }
 
       void updateSpinCount(UInt64 instructions, SubsecondTime elapsed_time)
       {
@@ -132,6 +158,12 @@ class Core
          m_spin_instructions += instructions;
          m_spin_elapsed_time += elapsed_time;
       }
+      void updateSpinSkip(UInt64 instructions, SubsecondTime elapsed_time)
+      {
+         m_spin_skips++;
+         m_spin_skipped_instructions += instructions;
+         m_spin_skipped_time += elapsed_time;
+      }
 
    private:
       core_id_t m_core_id;
@@ -146,8 +178,15 @@ class Core
       BbvCount m_bbv;
       TopologyInfo *m_topology_info;
       CheetahManager *m_cheetah_manager;
+      BranchTrace::Writer *m_branch_trace;
 
       State m_core_state;
+      CoreStateHistory *m_state_history;
+      SubsecondTime m_state_since;
+
+      std::atomic<bool> m_models_requested;
+      std::atomic<bool> m_models_enabled;
+      Lock m_models_lock;
 
       static Lock m_global_core_lock;
 
@@ -161,14 +200,39 @@ class Core
             IntPtr eip,
             SubsecondTime now);
 
+      void enablePerformanceModels();
+      void disablePerformanceModels();
+      void updatePerformanceModels();
+      void checkPerformanceModels()
+      {
+         if (m_models_requested.load(std::memory_order_relaxed) != m_models_enabled.load(std::memory_order_relaxed))
+            updatePerformanceModels();
+      }
+
       void hookPeriodicInsCheck();
       void hookPeriodicInsCall();
 
-      IntPtr m_icache_last_block;
+      // Recently fetched L1-I lines ([perf_model/l1_icache/fetch_buffer_lines]), fetches from these don't access the L1-I
+      std::vector<IntPtr> m_fetch_buffer;
+      UInt32 m_fetch_buffer_next;
+      IntPtr m_icache_blockmask;
+
+      bool fetchBufferHit(IntPtr block) const
+      {
+         for(std::vector<IntPtr>::const_iterator it = m_fetch_buffer.begin(); it != m_fetch_buffer.end(); ++it)
+            if (*it == block)
+               return true;
+         return false;
+      }
+      void fetchBufferInsert(IntPtr block);
+      MemoryResult fetchInstructionLine(IntPtr block);
 
       UInt64 m_spin_loops;
       UInt64 m_spin_instructions;
       SubsecondTime m_spin_elapsed_time;
+      UInt64 m_spin_skips;
+      UInt64 m_spin_skipped_instructions;
+      SubsecondTime m_spin_skipped_time;
 
    protected:
       // Optimized version of countInstruction has direct access to m_instructions and m_instructions_callback
@@ -181,8 +245,6 @@ class Core
       // HOOK_PERIODIC_INS implementation
       UInt64 m_instructions_hpi_callback;
       UInt64 m_instructions_hpi_last;
-      static UInt64 g_instructions_hpi_global;
-      static UInt64 g_instructions_hpi_global_callback;
 };
 
 #endif
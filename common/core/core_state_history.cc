@@ -0,0 +1,21 @@
+#include "core_state_history.h"
+#include "log.h"
+
+#include <cstdlib>
+
+CoreStateHistory::CoreStateHistory(UInt32 size)
+{
+   LOG_ASSERT_ERROR(size > 0, "Core state history needs at least one entry");
+
+   static_assert(sizeof(Header) == 16 && sizeof(Entry) == 16, "CoreStateHistory layout changed, update sim.util.CoreStateHistory");
+   void *block = calloc(1, sizeof(Header) + size * sizeof(Entry));
+   LOG_ASSERT_ERROR(block, "Cannot allocate core state history of %u entries", size);
+   m_header = (Header*)block;
+   m_header->size = size;
+   m_entries = (Entry*)(m_header + 1);
+}
+
+CoreStateHistory::~CoreStateHistory()
+{
+   free(m_header);
+}
@@ -0,0 +1,55 @@
+#ifndef CORE_STATE_HISTORY_H
+#define CORE_STATE_HISTORY_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+
+// Fixed-size ring of the most recent states a core has left, with the exact time it spent in each
+// ([core/state_history] size). Core::setState() appends to it, predictors read it through get().
+// Header and entries are a single block, so scripts can map it without copying (sim.control.get_core_state_history).
+class CoreStateHistory
+{
+   public:
+      // Layout is shared with sim.util.CoreStateHistory
+      struct Header
+      {
+         UInt64 count;        // Number of entries ever pushed, the newest one is at (count - 1) % size
+         UInt32 size;
+         UInt32 reserved;
+      };
+      struct Entry
+      {
+         UInt32 state;        // Core::State
+         UInt32 reserved;
+         UInt64 duration;     // in fs
+      };
+
+      CoreStateHistory(UInt32 size);
+      ~CoreStateHistory();
+
+      void push(UInt32 state, SubsecondTime duration)
+      {
+         UInt64 count = m_header->count;
+         Entry &entry = m_entries[count % m_header->size];
+         entry.state = state;
+         entry.duration = duration.getFS();
+         // Publish the entry before the count, readers on other threads then never see a half-written newest entry
+         __atomic_store_n(&m_header->count, count + 1, __ATOMIC_RELEASE);
+      }
+
+      UInt32 size() const { return m_header->size; }
+      UInt64 count() const { return __atomic_load_n(&m_header->count, __ATOMIC_ACQUIRE); }
+      // Number of valid entries
+      UInt32 length() const { UInt64 count = this->count(); return count < m_header->size ? count : m_header->size; }
+      // Entry age steps back from the newest one (age 0), age must be below length()
+      const Entry& get(UInt32 age) const { return m_entries[(count() - 1 - age) % m_header->size]; }
+
+      const void* data() const { return m_header; }
+      size_t dataSize() const { return sizeof(Header) + m_header->size * sizeof(Entry); }
+
+   private:
+      Header *m_header;
+      Entry *m_entries;
+};
+
+#endif // CORE_STATE_HISTORY_H
@@ -0,0 +1,42 @@
+#include "instruction_aggregator.h"
+#include "simulator.h"
+#include "config.h"
+#include "config.hpp"
+#include "log.h"
+
+#include <algorithm>
+
+InstructionAggregator::InstructionAggregator(UInt32 num_cores)
+   : m_cores_per_shard(Sim()->getCfg()->getInt("core/hook_periodic_ins/cores_per_shard"))
+   , m_root(0)
+   , m_root_callback(0)
+{
+   // Default to one shard per socket, as used for DVFS
+   if (m_cores_per_shard == 0)
+      m_cores_per_shard = Sim()->getCfg()->getInt("dvfs/simple/cores_per_socket");
+   LOG_ASSERT_ERROR(m_cores_per_shard > 0, "Invalid number of cores per instruction count shard");
+
+   m_num_shards = (num_cores + m_cores_per_shard - 1) / m_cores_per_shard;
+   m_forward_chunk = std::max(UInt64(1), Sim()->getConfig()->getHPIInstructionsGlobal() / (4 * m_num_shards));
+
+   m_shards = new Shard[m_num_shards];
+   for (UInt32 i = 0; i < m_num_shards; ++i)
+   {
+      m_shards[i].count = 0;
+      m_shards[i].forwarded = 0;
+   }
+}
+
+InstructionAggregator::~InstructionAggregator()
+{
+   delete [] m_shards;
+}
+
+UInt64
+InstructionAggregator::getCount() const
+{
+   UInt64 count = 0;
+   for (UInt32 i = 0; i < m_num_shards; ++i)
+      count += __atomic_load_n(&m_shards[i].count, __ATOMIC_RELAXED);
+   return count;
+}
@@ -0,0 +1,55 @@
+#ifndef __INSTRUCTION_AGGREGATOR_H
+#define __INSTRUCTION_AGGREGATOR_H
+
+#include "fixed_types.h"
+
+// Global instruction count behind HOOK_PERIODIC_INS and MagicServer::getGlobalInstructionCount.
+// Cores add their progress into a per-socket shard ([core/hook_periodic_ins/cores_per_shard] cores each), every shard
+// lives on its own cache line. A shard only forwards to the root counter once it has gathered a quarter of its share
+// of a period, so the root trails the true count by less than a quarter of [core/hook_periodic_ins/ins_global].
+class InstructionAggregator
+{
+   public:
+      InstructionAggregator(UInt32 num_cores);
+      ~InstructionAggregator();
+
+      // Returns true when the root has crossed the next HOOK_PERIODIC_INS boundary
+      bool add(core_id_t core_id, UInt64 count)
+      {
+         Shard &shard = m_shards[core_id / m_cores_per_shard];
+         UInt64 total = __atomic_add_fetch(&shard.count, count, __ATOMIC_RELAXED);
+         UInt64 forwarded = __atomic_load_n(&shard.forwarded, __ATOMIC_RELAXED);
+         if (total - forwarded < m_forward_chunk)
+            return false;
+         // Only one core of the socket forwards a given range, a loser's instructions go with the next forward
+         if (!__atomic_compare_exchange_n(&shard.forwarded, &forwarded, total, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            return false;
+         UInt64 root = __atomic_add_fetch(&m_root, total - forwarded, __ATOMIC_RELAXED);
+         return root > __atomic_load_n(&m_root_callback, __ATOMIC_RELAXED);
+      }
+
+      // Root value and next boundary, only stable while holding the ThreadManager lock
+      UInt64 getRoot() const { return __atomic_load_n(&m_root, __ATOMIC_RELAXED); }
+      UInt64 getRootCallback() const { return m_root_callback; }
+      void advanceRootCallback(UInt64 interval) { __atomic_store_n(&m_root_callback, m_root_callback + interval, __ATOMIC_RELAXED); }
+
+      // All instructions added so far, including those not yet forwarded to the root
+      UInt64 getCount() const;
+
+   private:
+      struct Shard
+      {
+         UInt64 count;
+         UInt64 forwarded;
+      } __attribute__((aligned(64)));
+
+      UInt32 m_cores_per_shard;
+      UInt32 m_num_shards;
+      UInt64 m_forward_chunk;
+      Shard *m_shards;
+
+      UInt64 m_root __attribute__((aligned(64)));
+      UInt64 m_root_callback;
+};
+
+#endif // __INSTRUCTION_AGGREGATOR_H
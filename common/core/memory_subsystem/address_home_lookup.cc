@@ -1,13 +1,23 @@
 #include "address_home_lookup.h"
+#include "numa_topology.h"
+#include "utils.h"
 #include "log.h"
 
+static const UInt32 AHL_PAGE_SHIFT = 12;
+
 AddressHomeLookup::AddressHomeLookup(UInt32 ahl_param,
       std::vector<core_id_t>& core_list,
-      UInt32 cache_block_size):
+      UInt32 cache_block_size,
+      interleaving_t interleaving,
+      const NumaTopology *numa):
    m_ahl_param(ahl_param),
    m_ahl_mask((UInt64(1) << ahl_param) - 1),
    m_core_list(core_list),
-   m_cache_block_size(cache_block_size)
+   m_cache_block_size(cache_block_size),
+   m_interleaving(interleaving),
+   m_log_granularity(interleaving == INTERLEAVE_PAGE && ahl_param < AHL_PAGE_SHIFT ? AHL_PAGE_SHIFT : ahl_param),
+   m_log_modules(0),
+   m_numa(numa)
 {
 
    // Each Block Address is as follows:
@@ -19,17 +29,65 @@ AddressHomeLookup::AddressHomeLookup(UInt32 ahl_param,
          "2^AHL param(%u) must be >= Cache Block Size(%u)",
          m_ahl_param, m_cache_block_size);
    m_total_modules = core_list.size();
+   LOG_ASSERT_ERROR(m_total_modules > 0, "AddressHomeLookup needs at least one home");
+   LOG_ASSERT_ERROR(interleaving != INTERLEAVE_XOR || isPower2(m_total_modules),
+         "XOR home interleaving needs a power-of-two number of homes, got %u", m_total_modules);
+
+   m_modules = FastDivider(m_total_modules);
+   m_log_modules = floorLog2(m_total_modules);
+
+   if (m_numa)
+   {
+      std::vector<std::vector<core_id_t> > socket_homes(m_numa->getNumSockets());
+      for(std::vector<core_id_t>::const_iterator it = core_list.begin(); it != core_list.end(); ++it)
+         socket_homes[m_numa->getCoreSocket(*it)].push_back(*it);
+      for(UInt32 socket = 0; socket < m_numa->getNumSockets(); ++socket)
+      {
+         LOG_ASSERT_ERROR(socket_homes[socket].size() > 0, "NUMA socket %u has no home, check perf_model/dram/controller_positions", socket);
+         m_socket_lookups.push_back(new AddressHomeLookup(ahl_param, socket_homes[socket], cache_block_size, interleaving));
+      }
+   }
 }
 
 AddressHomeLookup::~AddressHomeLookup()
 {
-   // There is no memory to deallocate, so destructor has no function
+   for(std::vector<AddressHomeLookup*>::iterator it = m_socket_lookups.begin(); it != m_socket_lookups.end(); ++it)
+      delete *it;
+}
+
+AddressHomeLookup::interleaving_t
+AddressHomeLookup::parseInterleaving(String interleaving)
+{
+   if (interleaving == "line")
+      return INTERLEAVE_LINE;
+   else if (interleaving == "page")
+      return INTERLEAVE_PAGE;
+   else if (interleaving == "xor")
+      return INTERLEAVE_XOR;
+   else
+      LOG_PRINT_ERROR("Invalid address interleaving %s", interleaving.c_str());
+}
+
+UInt32 AddressHomeLookup::getModule(IntPtr address) const
+{
+   IntPtr block = address >> m_log_granularity;
+   if (m_interleaving == INTERLEAVE_XOR && m_total_modules > 1)
+   {
+      UInt32 module_num = 0;
+      for(; block; block >>= m_log_modules)
+         module_num ^= block & (m_total_modules - 1);
+      return module_num;
+   }
+   else
+      return m_modules.modulo(block);
 }
 
 core_id_t AddressHomeLookup::getHome(IntPtr address) const
 {
-   SInt32 module_num = (address >> m_ahl_param) % m_total_modules;
-   LOG_ASSERT_ERROR(0 <= module_num && module_num < (SInt32) m_total_modules, "module_num(%i), total_modules(%u)", module_num, m_total_modules);
+   if (m_numa)
+      return m_socket_lookups[m_numa->getAddressSocket(address)]->getHome(m_numa->getSocketAddress(address));
+
+   UInt32 module_num = getModule(address);
 
    LOG_PRINT("address(0x%x), module_num(%i)", address, module_num);
    return (m_core_list[module_num]);
@@ -37,10 +95,16 @@ core_id_t AddressHomeLookup::getHome(IntPtr address) const
 
 IntPtr AddressHomeLookup::getLinearBlock(IntPtr address) const
 {
-   return (address >> m_ahl_param) / m_total_modules;
+   return getLinearAddress(address) >> m_ahl_param;
 }
 
 IntPtr AddressHomeLookup::getLinearAddress(IntPtr address) const
 {
-   return (getLinearBlock(address) << m_ahl_param) | (address & m_ahl_mask);
+   if (m_numa)
+      return m_socket_lookups[m_numa->getAddressSocket(address)]->getLinearAddress(m_numa->getSocketAddress(address));
+
+   // Remove the home selection bits. For XOR interleaving, the lower bits identify the unit within the home
+   // together with the home index.
+   return (m_modules.divide(address >> m_log_granularity) << m_log_granularity)
+      | (address & ((IntPtr(1) << m_log_granularity) - 1));
 }
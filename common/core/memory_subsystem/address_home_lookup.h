@@ -4,6 +4,9 @@
 #include <vector>
 
 #include "fixed_types.h"
+#include "fast_divider.h"
+
+class NumaTopology;
 
 /*
  * TODO abstract MMU stuff to a configure file to allow
@@ -18,19 +21,41 @@
  * Maybe allow the ability to have public and private memory space?
  */
 
+// Addresses are spread over the homes in units of 2^ahl_param bytes, according to the interleaving policy:
+//   line: consecutive units go to consecutive homes
+//   page: consecutive 4KB pages go to consecutive homes (units of 2^ahl_param if that is larger)
+//   xor:  line interleaving, with the home index XOR-folded with the higher unit address bits (power-of-two homes only)
+// Division by the number of homes is precomputed (FastDivider), as getHome() is called on every miss.
+// With a NumaTopology, an address first selects its socket, and is then interleaved over the homes on that socket.
 class AddressHomeLookup
 {
    public:
+      enum interleaving_t
+      {
+         INTERLEAVE_LINE,
+         INTERLEAVE_PAGE,
+         INTERLEAVE_XOR,
+      };
+
       AddressHomeLookup(UInt32 ahl_param,
             std::vector<core_id_t>& core_list,
-            UInt32 cache_block_size);
-      ~AddressHomeLookup();
+            UInt32 cache_block_size,
+            interleaving_t interleaving = INTERLEAVE_LINE,
+            const NumaTopology *numa = NULL);
+
+      static interleaving_t parseInterleaving(String interleaving);
+
+      virtual ~AddressHomeLookup();
       // Return home node for a given address
       core_id_t getHome(IntPtr address) const;
       // Within home node, return unique, incrementing block number
       IntPtr getLinearBlock(IntPtr address) const;
       // Within home node, return unique, incrementing address to be used in cache set selection
-      IntPtr getLinearAddress(IntPtr address) const;
+      virtual IntPtr getLinearAddress(IntPtr address) const;
+
+   protected:
+      // For lookups that further split a home node (e.g. NucaBankLookup) and only override getLinearAddress
+      AddressHomeLookup() : m_ahl_param(0), m_ahl_mask(0), m_total_modules(0), m_cache_block_size(0), m_interleaving(INTERLEAVE_LINE), m_log_granularity(0), m_log_modules(0), m_numa(NULL) {}
 
    private:
       UInt32 m_ahl_param;
@@ -38,6 +63,15 @@ class AddressHomeLookup
       std::vector<core_id_t> m_core_list;
       UInt32 m_total_modules;
       UInt32 m_cache_block_size;
+      interleaving_t m_interleaving;
+      UInt32 m_log_granularity; // Interleaving granularity: 2^ahl_param bytes or a page
+      UInt32 m_log_modules;
+      FastDivider m_modules;
+
+      const NumaTopology *m_numa;
+      std::vector<AddressHomeLookup*> m_socket_lookups; // Homes on each socket, when m_numa is set
+
+      UInt32 getModule(IntPtr address) const;
 };
 
 #endif /* __ADDRESS_HOME_LOOKUP_H__ */
@@ -1,6 +1,14 @@
 #include "simulator.h"
 #include "cache.h"
 #include "log.h"
+#include "checkpoint.h"
+#include "stats.h"
+#include "config.hpp"
+#include "host_topology.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
 
 // Cache class
 // constructors/destructors
@@ -19,17 +27,30 @@ Cache::Cache(
 :
    CacheBase(name, num_sets, associativity, cache_block_size, hash, ahl),
    m_enabled(false),
-   m_num_accesses(0),
-   m_num_hits(0),
+   m_num_accesses(*allocStatsCounters<UInt64>(core_id)),
+   m_num_hits(*allocStatsCounters<UInt64>(core_id)),
    m_cache_type(cache_type),
-   m_fault_injector(fault_injector)
+   m_block_info_storage(NULL),
+   m_block_info_size(0),
+   m_fault_injector(fault_injector),
+   m_data(NULL),
+   m_data_size(0)
 {
-   m_set_info = CacheSet::createCacheSetInfo(name, cfgname, core_id, replacement_policy, m_associativity);
+   m_set_info = CacheSet::createCacheSetInfo(name, cfgname, core_id, replacement_policy, m_associativity, m_num_sets, m_blocksize);
    m_sets = new CacheSet*[m_num_sets];
    for (UInt32 i = 0; i < m_num_sets; i++)
    {
       m_sets[i] = CacheSet::createCacheSet(cfgname, core_id, replacement_policy, m_cache_type, m_associativity, m_blocksize, m_set_info);
    }
+   if (Sim()->getHostTopology()->useHugePages() && m_num_sets > 0)
+   {
+      size_t set_size = m_sets[0]->getBlockInfoStorageSize();
+      m_block_info_size = set_size * m_num_sets;
+      m_block_info_storage = (char*)Sim()->getHostTopology()->allocLarge(m_block_info_size);
+      for (UInt32 i = 0; i < m_num_sets; i++)
+         m_sets[i]->relocateBlockInfoStorage(m_block_info_storage + i * set_size);
+   }
+   allocateData();
 
    #ifdef ENABLE_SET_USAGE_HIST
    m_set_usage_hist = new UInt64[m_num_sets];
@@ -54,6 +75,56 @@ Cache::~Cache()
    for (SInt32 i = 0; i < (SInt32) m_num_sets; i++)
       delete m_sets[i];
    delete [] m_sets;
+   if (m_block_info_storage)
+      Sim()->getHostTopology()->freeLarge(m_block_info_storage, m_block_info_size);
+
+   if (m_data_storage == DATA_LAZY)
+      munmap(m_data, m_data_size);
+   else if (m_data_storage == DATA_FULL)
+      Sim()->getHostTopology()->freeLarge(m_data, m_data_size);
+}
+
+void
+Cache::allocateData()
+{
+   // Data values are only needed by fault injection, trace-driven timing runs never look at them
+   String data_storage = Sim()->getCfg()->getString("perf_model/cache/data_storage");
+   if (data_storage == "auto")
+      m_data_storage = Sim()->getFaultinjectionManager() ? DATA_FULL : DATA_NONE;
+   else if (data_storage == "none")
+      m_data_storage = DATA_NONE;
+   else if (data_storage == "full")
+      m_data_storage = DATA_FULL;
+   else if (data_storage == "lazy")
+      m_data_storage = DATA_LAZY;
+   else
+      LOG_PRINT_ERROR("Invalid perf_model/cache/data_storage %s", data_storage.c_str());
+
+   LOG_ASSERT_ERROR(m_data_storage != DATA_NONE || !Sim()->getFaultinjectionManager(),
+                    "Fault injection requires cache data storage, set perf_model/cache/data_storage to auto, full or lazy");
+
+   m_data_size = size_t(m_num_sets) * m_associativity * m_blocksize;
+   if (m_data_storage == DATA_NONE || m_data_size == 0)
+   {
+      m_data_storage = DATA_NONE;
+      return;
+   }
+
+   if (m_data_storage == DATA_LAZY)
+   {
+      // Anonymous memory reads as zero and is only backed by host pages when first written to
+      void *data = mmap(NULL, m_data_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      LOG_ASSERT_ERROR(data != MAP_FAILED, "%s: cannot reserve %ld bytes for cache data", m_name.c_str(), m_data_size);
+      m_data = (char*)data;
+   }
+   else
+   {
+      // Zero-filled
+      m_data = (char*)Sim()->getHostTopology()->allocLarge(m_data_size);
+   }
+
+   for (UInt32 i = 0; i < m_num_sets; i++)
+      m_sets[i]->setDataArray(m_data + size_t(i) * m_associativity * m_blocksize);
 }
 
 Lock&
@@ -123,17 +194,16 @@ void
 Cache::insertSingleLine(IntPtr addr, Byte* fill_buff,
       bool* eviction, IntPtr* evict_addr,
       CacheBlockInfo* evict_block_info, Byte* evict_buff,
-      SubsecondTime now, CacheCntlr *cntlr)
+      SubsecondTime now, CacheCntlr *cntlr, UInt64 way_mask)
 {
    IntPtr tag;
    UInt32 set_index;
    splitAddress(addr, tag, set_index);
 
-   CacheBlockInfo* cache_block_info = CacheBlockInfo::create(m_cache_type);
-   cache_block_info->setTag(tag);
+   CacheBlockInfo cache_block_info(tag);
 
-   m_sets[set_index]->insert(cache_block_info, fill_buff,
-         eviction, evict_block_info, evict_buff, cntlr);
+   m_sets[set_index]->insert(&cache_block_info, fill_buff,
+         eviction, evict_block_info, evict_buff, cntlr, way_mask);
    *evict_addr = tagToAddress(evict_block_info->getTag());
 
    if (m_fault_injector) {
@@ -148,8 +218,6 @@ Cache::insertSingleLine(IntPtr addr, Byte* fill_buff,
    #ifdef ENABLE_SET_USAGE_HIST
    ++m_set_usage_hist[set_index];
    #endif
-
-   delete cache_block_info;
 }
 
 
@@ -184,3 +252,121 @@ Cache::updateHits(Core::mem_op_t mem_op_type, UInt64 hits)
       m_num_hits += hits;
    }
 }
+
+void
+Cache::saveState(CheckpointWriter &ckpt) const
+{
+   ckpt.put(m_num_sets);
+   ckpt.put(m_associativity);
+   for (UInt32 set_index = 0; set_index < m_num_sets; ++set_index)
+   {
+      UInt32 num_valid = 0;
+      for (UInt32 way = 0; way < m_associativity; ++way)
+         if (m_sets[set_index]->peekBlock(way)->isValid())
+            ++num_valid;
+
+      ckpt.put(num_valid);
+      for (UInt32 way = 0; way < m_associativity; ++way)
+      {
+         CacheBlockInfo *block_info = m_sets[set_index]->peekBlock(way);
+         if (block_info->isValid())
+         {
+            ckpt.put(way);
+            ckpt.put(block_info->getTag());
+            ckpt.put(UInt8(block_info->getCState()));
+            ckpt.put(m_sets[set_index]->getRecency(way));
+         }
+      }
+   }
+}
+
+void
+Cache::loadState(CheckpointReader &ckpt)
+{
+   UInt32 num_sets, associativity;
+   ckpt.get(num_sets);
+   ckpt.get(associativity);
+   LOG_ASSERT_ERROR(num_sets == m_num_sets && associativity == m_associativity,
+      "Checkpoint for %s has %d sets of %d ways, expected %d sets of %d ways", m_name.c_str(), num_sets, associativity, m_num_sets, m_associativity);
+
+   for (UInt32 set_index = 0; set_index < m_num_sets; ++set_index)
+   {
+      UInt32 num_valid;
+      ckpt.get(num_valid);
+      for (UInt32 i = 0; i < num_valid; ++i)
+      {
+         UInt32 way, recency;
+         IntPtr tag;
+         UInt8 cstate;
+         ckpt.get(way);
+         ckpt.get(tag);
+         ckpt.get(cstate);
+         ckpt.get(recency);
+
+         CacheBlockInfo *block_info = m_sets[set_index]->peekBlock(way);
+         block_info->setTag(tag);
+         block_info->setCState(CacheState::cstate_t(cstate));
+         m_sets[set_index]->setRecency(way, recency);
+      }
+   }
+}
+
+void
+Cache::loadLines(CheckpointReader &ckpt, std::vector<CheckpointLine> &lines)
+{
+   UInt32 num_sets, associativity;
+   ckpt.get(num_sets);
+   ckpt.get(associativity);
+   LOG_ASSERT_ERROR(num_sets == m_num_sets && associativity == m_associativity,
+      "Checkpoint for %s has %d sets of %d ways, expected %d sets of %d ways", m_name.c_str(), num_sets, associativity, m_num_sets, m_associativity);
+
+   // Sort all lines by recency, so that re-accessing them in order leaves the most recently used ones
+   // at the MRU position of their set
+   std::vector<std::pair<UInt32, CheckpointLine> > saved;
+   for (UInt32 set_index = 0; set_index < m_num_sets; ++set_index)
+   {
+      UInt32 num_valid;
+      ckpt.get(num_valid);
+      for (UInt32 i = 0; i < num_valid; ++i)
+      {
+         UInt32 way, recency;
+         IntPtr tag;
+         UInt8 cstate;
+         ckpt.get(way);
+         ckpt.get(tag);
+         ckpt.get(cstate);
+         ckpt.get(recency);
+
+         CheckpointLine line = { tagToAddress(tag), CacheState::cstate_t(cstate) };
+         saved.push_back(std::make_pair(recency, line));
+      }
+   }
+   std::stable_sort(saved.begin(), saved.end(),
+      [](const std::pair<UInt32, CheckpointLine> &a, const std::pair<UInt32, CheckpointLine> &b) { return a.first > b.first; });
+
+   for (std::vector<std::pair<UInt32, CheckpointLine> >::iterator it = saved.begin(); it != saved.end(); ++it)
+      lines.push_back(it->second);
+}
+
+void
+Cache::getLines(std::vector<CheckpointLine> &lines)
+{
+   std::vector<std::pair<UInt32, CheckpointLine> > valid;
+   for (UInt32 set_index = 0; set_index < m_num_sets; ++set_index)
+   {
+      for (UInt32 way = 0; way < m_associativity; ++way)
+      {
+         CacheBlockInfo *block_info = m_sets[set_index]->peekBlock(way);
+         if (block_info->isValid())
+         {
+            CheckpointLine line = { tagToAddress(block_info->getTag()), block_info->getCState() };
+            valid.push_back(std::make_pair(m_sets[set_index]->getRecency(way), line));
+         }
+      }
+   }
+   std::stable_sort(valid.begin(), valid.end(),
+      [](const std::pair<UInt32, CheckpointLine> &a, const std::pair<UInt32, CheckpointLine> &b) { return a.first > b.first; });
+
+   for (std::vector<std::pair<UInt32, CheckpointLine> >::iterator it = valid.begin(); it != valid.end(); ++it)
+      lines.push_back(it->second);
+}
@@ -12,6 +12,12 @@
 #include "core.h"
 #include "fault_injection.h"
 
+#include <vector>
+
+class CheckpointWriter;
+class CheckpointReader;
+struct CheckpointLine;
+
 // Define to enable the set usage histogram
 //#define ENABLE_SET_USAGE_HIST
 
@@ -20,17 +26,33 @@ class Cache : public CacheBase
    private:
       bool m_enabled;
 
-      // Cache counters
-      UInt64 m_num_accesses;
-      UInt64 m_num_hits;
+      // Cache counters, in per-core storage (see allocStatsCounters)
+      UInt64 &m_num_accesses;
+      UInt64 &m_num_hits;
 
       // Generic Cache Info
       cache_t m_cache_type;
       CacheSet** m_sets;
       CacheSetInfo* m_set_info;
+      // Tags and block infos of all sets in one array, when backed by huge pages (general/host_hugepages)
+      char* m_block_info_storage;
+      size_t m_block_info_size;
 
       FaultInjector *m_fault_injector;
 
+      // Data values of all blocks (perf_model/cache/data_storage), NULL when only tags are modeled
+      enum data_storage_t
+      {
+         DATA_NONE,     // Tags only, reads and writes of line data are no-ops
+         DATA_FULL,     // Allocated and cleared up front
+         DATA_LAZY,     // Reserved address space, host pages are only allocated once a block in them is written
+      };
+      data_storage_t m_data_storage;
+      char* m_data;
+      size_t m_data_size;
+
+      void allocateData();
+
       #ifdef ENABLE_SET_USAGE_HIST
       UInt64* m_set_usage_hist;
       #endif
@@ -57,7 +79,7 @@ class Cache : public CacheBase
             access_t access_type, Byte* buff, UInt32 bytes, SubsecondTime now, bool update_replacement);
       void insertSingleLine(IntPtr addr, Byte* fill_buff,
             bool* eviction, IntPtr* evict_addr,
-            CacheBlockInfo* evict_block_info, Byte* evict_buff, SubsecondTime now, CacheCntlr *cntlr = NULL);
+            CacheBlockInfo* evict_block_info, Byte* evict_buff, SubsecondTime now, CacheCntlr *cntlr = NULL, UInt64 way_mask = 0);
       CacheBlockInfo* peekSingleLine(IntPtr addr);
 
       CacheBlockInfo* peekBlock(UInt32 set_index, UInt32 way) const { return m_sets[set_index]->peekBlock(way); }
@@ -68,6 +90,15 @@ class Cache : public CacheBase
 
       void enable() { m_enabled = true; }
       void disable() { m_enabled = false; }
+
+      // Checkpointing: save all valid lines with their state and recency
+      void saveState(CheckpointWriter &ckpt) const;
+      // Restore the saved lines in place (for structures without coherence, such as TLBs)
+      void loadState(CheckpointReader &ckpt);
+      // Read the saved lines, in the order (least recently used first) in which to re-access them
+      void loadLines(CheckpointReader &ckpt, std::vector<CheckpointLine> &lines);
+      // Get the current valid lines, in the same order, for replaying them elsewhere (see WarmupSampler)
+      void getLines(std::vector<CheckpointLine> &lines);
 };
 
 template <class T>
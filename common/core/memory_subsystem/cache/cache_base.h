@@ -60,6 +60,9 @@ class CacheBase
          SRRIP,
          SRRIP_QBS,
          RANDOM,
+         SHIP,
+         HAWKEYE,
+         MOCKINGJAY,
          NUM_REPLACEMENT_POLICIES
       };
 
@@ -4,6 +4,8 @@
 #include "shared_cache_block_info.h"
 #include "log.h"
 
+#include <new>
+
 const char* CacheBlockInfo::option_names[] =
 {
    "prefetch",
@@ -21,52 +23,73 @@ const char* CacheBlockInfo::getOptionName(option_t option)
 }
 
 
+static_assert(CacheState::NUM_CSTATE_STATES <= 16, "CacheBlockInfo::m_cstate is too small");
+static_assert(CacheBlockInfo::NUM_OPTIONS <= 4, "CacheBlockInfo::m_options is too small");
+static_assert(sizeof(PrL1CacheBlockInfo) == sizeof(CacheBlockInfo)
+              && sizeof(PrL2CacheBlockInfo) == sizeof(CacheBlockInfo)
+              && sizeof(SharedCacheBlockInfo) == sizeof(CacheBlockInfo), "CacheBlockInfo facades cannot add members");
+
 CacheBlockInfo::CacheBlockInfo(IntPtr tag, CacheState::cstate_t cstate, UInt64 options):
    m_tag(tag),
-   m_cstate(cstate),
    m_owner(0),
+   m_tag_offset(0),
+   m_cstate(cstate),
+   m_options(options),
    m_used(0),
-   m_options(options)
-{}
-
-CacheBlockInfo::~CacheBlockInfo()
+   m_cached_locs(0)
 {}
 
-CacheBlockInfo*
-CacheBlockInfo::create(CacheBase::cache_t cache_type)
+void
+CacheBlockInfo::createArray(CacheBase::cache_t cache_type, CacheBlockInfo* storage, UInt32 count)
 {
-   switch (cache_type)
+   for (UInt32 i = 0; i < count; ++i)
    {
-      case CacheBase::PR_L1_CACHE:
-         return new PrL1CacheBlockInfo();
+      switch (cache_type)
+      {
+         case CacheBase::PR_L1_CACHE:
+            new (&storage[i]) PrL1CacheBlockInfo();
+            break;
 
-      case CacheBase::PR_L2_CACHE:
-         return new PrL2CacheBlockInfo();
+         case CacheBase::PR_L2_CACHE:
+            new (&storage[i]) PrL2CacheBlockInfo();
+            break;
 
-      case CacheBase::SHARED_CACHE:
-         return new SharedCacheBlockInfo();
+         case CacheBase::SHARED_CACHE:
+            new (&storage[i]) SharedCacheBlockInfo();
+            break;
 
-      default:
-         LOG_PRINT_ERROR("Unrecognized cache type (%u)", cache_type);
-         return NULL;
+         default:
+            LOG_PRINT_ERROR("Unrecognized cache type (%u)", cache_type);
+      }
    }
 }
 
+void
+CacheBlockInfo::bindTagStore(IntPtr* tag_store)
+{
+   ptrdiff_t offset = (char*)tag_store - (char*)this;
+   LOG_ASSERT_ERROR(offset != 0 && offset == SInt32(offset), "Tag store too far away from its block");
+   m_tag_offset = offset;
+   *tag_store = m_tag;
+}
+
 void
 CacheBlockInfo::invalidate()
 {
-   m_tag = ~0;
+   updateTag(~0);
    m_cstate = CacheState::INVALID;
+   m_cached_locs = 0;
 }
 
 void
 CacheBlockInfo::clone(CacheBlockInfo* cache_block_info)
 {
-   m_tag = cache_block_info->getTag();
-   m_cstate = cache_block_info->getCState();
+   updateTag(cache_block_info->getTag());
+   m_cstate = cache_block_info->m_cstate;
    m_owner = cache_block_info->m_owner;
    m_used = cache_block_info->m_used;
    m_options = cache_block_info->m_options;
+   m_cached_locs = cache_block_info->m_cached_locs;
 }
 
 bool
@@ -18,34 +18,44 @@ class CacheBlockInfo
       static const UInt8 BitsUsedOffset = 3;  // Track usage on 1<<BitsUsedOffset granularity (per 64-bit / 8-byte)
       typedef UInt8 BitsUsedType;      // Enough to store one bit per 1<<BitsUsedOffset byte element per cache line (8 8-byte elements for 64-byte cache lines)
 
-   // This can be extended later to include other information
-   // for different cache coherence protocols
+   // Packed line metadata: no vtable, one fixed 24-byte layout shared by all cache types, so CacheSet can keep
+   // all ways of a set in one array next to its tags. The per-type classes below are facades over this layout.
    private:
       IntPtr m_tag;
-      CacheState::cstate_t m_cstate;
       UInt64 m_owner;
+      SInt32 m_tag_offset;  // Byte offset from this object to its slot in the owning CacheSet's tag array, 0 if none
+      UInt8 m_cstate : 4;
+      UInt8 m_options : 4; // large enough to hold a bitfield for all available option_t's
       BitsUsedType m_used;
-      UInt8 m_options;  // large enough to hold a bitfield for all available option_t's
+      UInt16 m_cached_locs; // Previous-level caches holding this line (PrL2CacheBlockInfo, SharedCacheBlockInfo)
 
       static const char* option_names[];
 
+      void updateTag(IntPtr tag) { m_tag = tag; if (m_tag_offset) *(IntPtr*)((char*)this + m_tag_offset) = tag; }
+
+   protected:
+      UInt16 getCachedLocBits() const { return m_cached_locs; }
+      void setCachedLocBits(UInt16 cached_locs) { m_cached_locs = cached_locs; }
+
    public:
       CacheBlockInfo(IntPtr tag = ~0,
             CacheState::cstate_t cstate = CacheState::INVALID,
             UInt64 options = 0);
-      virtual ~CacheBlockInfo();
 
-      static CacheBlockInfo* create(CacheBase::cache_t cache_type);
+      // Construct count blocks of the class matching cache_type in place, storage must hold count CacheBlockInfo's
+      static void createArray(CacheBase::cache_t cache_type, CacheBlockInfo* storage, UInt32 count);
 
-      virtual void invalidate(void);
-      virtual void clone(CacheBlockInfo* cache_block_info);
+      void invalidate(void);
+      void clone(CacheBlockInfo* cache_block_info);
 
       bool isValid() const { return (m_tag != ((IntPtr) ~0)); }
 
       IntPtr getTag() const { return m_tag; }
-      CacheState::cstate_t getCState() const { return m_cstate; }
+      CacheState::cstate_t getCState() const { return CacheState::cstate_t(m_cstate); }
 
-      void setTag(IntPtr tag) { m_tag = tag; }
+      void setTag(IntPtr tag) { updateTag(tag); }
+      // Used by CacheSet to keep all of its tags in one contiguous array, allocated together with the blocks
+      void bindTagStore(IntPtr* tag_store);
       void setCState(CacheState::cstate_t cstate) { m_cstate = cstate; }
 
       UInt64 getOwner() const { return m_owner; }
@@ -53,7 +63,7 @@ class CacheBlockInfo
 
       bool hasOption(option_t option) { return m_options & (1 << option); }
       void setOption(option_t option) { m_options |= (1 << option); }
-      void clearOption(option_t option) { m_options &= ~(UInt64(1) << option); }
+      void clearOption(option_t option) { m_options &= ~(1 << option); }
 
       BitsUsedType getUsage() const { return m_used; };
       bool updateUsage(UInt32 offset, UInt32 size);
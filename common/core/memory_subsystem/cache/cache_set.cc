@@ -7,37 +7,82 @@
 #include "cache_set_random.h"
 #include "cache_set_round_robin.h"
 #include "cache_set_srrip.h"
+#include "cache_set_ship.h"
+#include "cache_set_hawkeye.h"
+#include "cache_set_mockingjay.h"
 #include "cache_base.h"
 #include "log.h"
 #include "simulator.h"
 #include "config.h"
 #include "config.hpp"
 
+#include <algorithm>
+
+#if defined(__SSE2__) && defined(TARGET_INTEL64)
+#include <emmintrin.h>
+
+// Lanes of age vector vec that belong to actual ways
+static inline __m128i ageLanes(UInt32 vec, UInt32 associativity)
+{
+   static const UInt8 lanes[32] = {
+      0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+   };
+   UInt32 num_lanes = std::min(associativity - 16 * vec, 16u);
+   return _mm_loadu_si128((const __m128i*)&lanes[16 - num_lanes]);
+}
+#endif
+
 CacheSet::CacheSet(CacheBase::cache_t cache_type,
       UInt32 associativity, UInt32 blocksize):
-      m_associativity(associativity), m_blocksize(blocksize)
+      m_owns_block_info_storage(true), m_blocks(NULL), m_associativity(associativity), m_blocksize(blocksize)
 {
    m_cache_block_info_array = new CacheBlockInfo*[m_associativity];
+   // Tags and blocks share one allocation, so blocks can address their tag slot with a small offset.
+   // Round up to a multiple of two ways so findIndex() can always load full vectors
+   UInt32 num_tags = (m_associativity + 1) & ~1;
+   m_block_info_storage = new char[getBlockInfoStorageSize()];
+   m_tags = (IntPtr*)m_block_info_storage;
+   if (m_associativity & 1)
+      m_tags[m_associativity] = INVALID_ADDRESS;
+   CacheBlockInfo* blocks = (CacheBlockInfo*)(m_tags + num_tags);
+   CacheBlockInfo::createArray(cache_type, blocks, m_associativity);
    for (UInt32 i = 0; i < m_associativity; i++)
    {
-      m_cache_block_info_array[i] = CacheBlockInfo::create(cache_type);
-   }
-
-   if (Sim()->getFaultinjectionManager())
-   {
-      m_blocks = new char[m_associativity * m_blocksize];
-      memset(m_blocks, 0x00, m_associativity * m_blocksize);
-   } else {
-      m_blocks = NULL;
+      m_cache_block_info_array[i] = &blocks[i];
+      m_cache_block_info_array[i]->bindTagStore(&m_tags[i]);
    }
+   m_ways_mask = m_associativity >= 64 ? ~UInt64(0) : (UInt64(1) << m_associativity) - 1;
+   m_allowed_ways = m_ways_mask;
+   m_num_age_vectors = (m_associativity + 15) / 16;
 }
 
 CacheSet::~CacheSet()
 {
-   for (UInt32 i = 0; i < m_associativity; i++)
-      delete m_cache_block_info_array[i];
+   // CacheBlockInfo has no destructor to run
    delete [] m_cache_block_info_array;
-   delete [] m_blocks;
+   if (m_owns_block_info_storage)
+      delete [] m_block_info_storage;
+}
+
+size_t
+CacheSet::getBlockInfoStorageSize() const
+{
+   UInt32 num_tags = (m_associativity + 1) & ~1;
+   return num_tags * sizeof(IntPtr) + m_associativity * sizeof(CacheBlockInfo);
+}
+
+void
+CacheSet::relocateBlockInfoStorage(char* storage)
+{
+   // Blocks find their tag slot by a relative offset, so the whole area can be copied as is
+   memcpy(storage, m_block_info_storage, getBlockInfoStorageSize());
+   for (UInt32 i = 0; i < m_associativity; i++)
+      m_cache_block_info_array[i] = (CacheBlockInfo*)(storage + ((char*)m_cache_block_info_array[i] - m_block_info_storage));
+   if (m_owns_block_info_storage)
+      delete [] m_block_info_storage;
+   m_block_info_storage = storage;
+   m_tags = (IntPtr*)storage;
+   m_owns_block_info_storage = false;
 }
 
 void
@@ -66,42 +111,214 @@ CacheSet::write_line(UInt32 line_index, UInt32 offset, Byte *in_buff, UInt32 byt
       updateReplacementIndex(line_index);
 }
 
-CacheBlockInfo*
-CacheSet::find(IntPtr tag, UInt32* line_index)
+UInt64
+CacheSet::matchTags(IntPtr tag) const
 {
-   for (SInt32 index = m_associativity-1; index >= 0; index--)
+#if defined(__SSE2__) && defined(TARGET_INTEL64)
+   if (m_associativity <= 64)
    {
-      if (m_cache_block_info_array[index]->getTag() == tag)
+      // SSE2 has no 64-bit compare: compare 32-bit halves, then require both halves of a way to match
+      const __m128i key = _mm_set1_epi64x(tag);
+      UInt64 matches = 0;
+      for (UInt32 way = 0; way < m_associativity; way += 2)
       {
-         if (line_index != NULL)
-            *line_index = index;
-         return (m_cache_block_info_array[index]);
+         __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&m_tags[way]), key);
+         eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+         matches |= UInt64(_mm_movemask_pd(_mm_castsi128_pd(eq))) << way;
       }
+      return matches & m_ways_mask;
+   }
+#endif
+
+   UInt64 matches = 0;
+   for (UInt32 way = 0; way < m_associativity && way < 64; ++way)
+   {
+      if (m_tags[way] == tag)
+         matches |= UInt64(1) << way;
    }
-   return NULL;
+   return matches;
 }
 
-bool
-CacheSet::invalidate(IntPtr& tag)
+// Returns the highest way holding <tag>, or -1
+SInt32
+CacheSet::findIndex(IntPtr tag) const
 {
+   if (m_associativity <= 64)
+   {
+      UInt64 matches = matchTags(tag);
+      return matches ? 63 - __builtin_clzll(matches) : -1;
+   }
+
    for (SInt32 index = m_associativity-1; index >= 0; index--)
    {
-      if (m_cache_block_info_array[index]->getTag() == tag)
-      {
-         m_cache_block_info_array[index]->invalidate();
-         return true;
-      }
+      if (m_tags[index] == tag)
+         return index;
+   }
+   return -1;
+}
+
+SInt32
+CacheSet::findInvalidWay() const
+{
+   if (m_associativity <= 64)
+   {
+      UInt64 invalid = matchTags(INVALID_ADDRESS) & m_allowed_ways;
+      return invalid ? __builtin_ctzll(invalid) : -1;
+   }
+
+   for (UInt32 index = 0; index < m_associativity; index++)
+   {
+      if (m_tags[index] == INVALID_ADDRESS)
+         return index;
+   }
+   return -1;
+}
+
+UInt8*
+CacheSet::newAges() const
+{
+   UInt8* ages = new UInt8[16 * m_num_age_vectors];
+   memset(ages, 0, 16 * m_num_age_vectors);
+   return ages;
+}
+
+UInt64
+CacheSet::agesAtLeast(const UInt8* ages, UInt8 value) const
+{
+   LOG_ASSERT_ERROR(m_associativity <= 64, "Age bitmasks support up to 64 ways");
+#if defined(__SSE2__) && defined(TARGET_INTEL64)
+   // max(age, value) == age <=> age >= value
+   const __m128i key = _mm_set1_epi8(value);
+   UInt64 matches = 0;
+   for (UInt32 vec = 0; vec < m_num_age_vectors; ++vec)
+   {
+      __m128i v = _mm_loadu_si128((const __m128i*)&ages[16 * vec]);
+      __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(v, key), v);
+      matches |= UInt64(UInt16(_mm_movemask_epi8(ge))) << (16 * vec);
+   }
+   return matches & m_ways_mask;
+#else
+   UInt64 matches = 0;
+   for (UInt32 way = 0; way < m_associativity; ++way)
+   {
+      if (ages[way] >= value)
+         matches |= UInt64(1) << way;
+   }
+   return matches;
+#endif
+}
+
+UInt8
+CacheSet::maxAge(const UInt8* ages) const
+{
+#if defined(__SSE2__) && defined(TARGET_INTEL64)
+   __m128i max = _mm_setzero_si128();
+   for (UInt32 vec = 0; vec < m_num_age_vectors; ++vec)
+      max = _mm_max_epu8(max, _mm_loadu_si128((const __m128i*)&ages[16 * vec]));
+   max = _mm_max_epu8(max, _mm_srli_si128(max, 8));
+   max = _mm_max_epu8(max, _mm_srli_si128(max, 4));
+   max = _mm_max_epu8(max, _mm_srli_si128(max, 2));
+   max = _mm_max_epu8(max, _mm_srli_si128(max, 1));
+   return _mm_cvtsi128_si32(max) & 0xff;
+#else
+   UInt8 max = 0;
+   for (UInt32 way = 0; way < m_associativity; ++way)
+      max = std::max(max, ages[way]);
+   return max;
+#endif
+}
+
+UInt8
+CacheSet::maxAllowedAge(const UInt8* ages) const
+{
+   if (m_allowed_ways == m_ways_mask)
+      return maxAge(ages);
+
+   UInt8 max = 0;
+   for (UInt64 ways = m_allowed_ways; ways; ways &= ways - 1)
+      max = std::max(max, ages[__builtin_ctzll(ways)]);
+   return max;
+}
+
+void
+CacheSet::promoteAges(UInt8* ages, UInt8 threshold) const
+{
+#if defined(__SSE2__) && defined(TARGET_INTEL64)
+   // threshold -sat age != 0 <=> age < threshold, the compare result is -1 so subtracting it increments
+   const __m128i key = _mm_set1_epi8(threshold);
+   const __m128i zero = _mm_setzero_si128();
+   for (UInt32 vec = 0; vec < m_num_age_vectors; ++vec)
+   {
+      __m128i v = _mm_loadu_si128((const __m128i*)&ages[16 * vec]);
+      __m128i below = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_subs_epu8(key, v), zero), ageLanes(vec, m_associativity));
+      _mm_storeu_si128((__m128i*)&ages[16 * vec], _mm_sub_epi8(v, below));
+   }
+#else
+   for (UInt32 way = 0; way < m_associativity; ++way)
+   {
+      if (ages[way] < threshold)
+         ages[way]++;
    }
-   return false;
+#endif
 }
 
 void
-CacheSet::insert(CacheBlockInfo* cache_block_info, Byte* fill_buff, bool* eviction, CacheBlockInfo* evict_block_info, Byte* evict_buff, CacheCntlr *cntlr)
+CacheSet::ageAll(UInt8* ages, UInt8 delta, UInt8 max) const
 {
+#if defined(__SSE2__) && defined(TARGET_INTEL64)
+   const __m128i add = _mm_set1_epi8(delta);
+   const __m128i limit = _mm_set1_epi8(max);
+   for (UInt32 vec = 0; vec < m_num_age_vectors; ++vec)
+   {
+      __m128i v = _mm_loadu_si128((const __m128i*)&ages[16 * vec]);
+      v = _mm_and_si128(_mm_min_epu8(_mm_adds_epu8(v, add), limit), ageLanes(vec, m_associativity));
+      _mm_storeu_si128((__m128i*)&ages[16 * vec], v);
+   }
+#else
+   for (UInt32 way = 0; way < m_associativity; ++way)
+      ages[way] = std::min(UInt32(ages[way]) + delta, UInt32(max));
+#endif
+}
+
+CacheBlockInfo*
+CacheSet::find(IntPtr tag, UInt32* line_index)
+{
+   SInt32 index = findIndex(tag);
+   if (index < 0)
+      return NULL;
+
+   if (line_index != NULL)
+      *line_index = index;
+   return (m_cache_block_info_array[index]);
+}
+
+bool
+CacheSet::invalidate(IntPtr& tag)
+{
+   SInt32 index = findIndex(tag);
+   if (index < 0)
+      return false;
+
+   m_cache_block_info_array[index]->invalidate();
+   return true;
+}
+
+void
+CacheSet::insert(CacheBlockInfo* cache_block_info, Byte* fill_buff, bool* eviction, CacheBlockInfo* evict_block_info, Byte* evict_buff, CacheCntlr *cntlr, UInt64 way_mask)
+{
+   // The replacement policies only consider ways for which isValidReplacement() holds, which includes the way mask
+   if (way_mask)
+   {
+      LOG_ASSERT_ERROR(m_associativity <= 64 && (way_mask & m_ways_mask), "Way mask %#lx selects none of the %u ways", way_mask, m_associativity);
+      m_allowed_ways = way_mask & m_ways_mask;
+   }
+
    // This replacement strategy does not take into account the fact that
    // cache blocks can be voluntarily flushed or invalidated due to another write request
    const UInt32 index = getReplacementIndex(cntlr);
    assert(index < m_associativity);
+   assert(m_allowed_ways & (UInt64(1) << index));
+   m_allowed_ways = m_ways_mask;
 
    assert(eviction != NULL);
 
@@ -123,6 +340,8 @@ CacheSet::insert(CacheBlockInfo* cache_block_info, Byte* fill_buff, bool* evicti
 
    if (fill_buff != NULL && m_blocks != NULL)
       memcpy(&m_blocks[index * m_blocksize], (void*) fill_buff, m_blocksize);
+
+   notifyInsert(index);
 }
 
 char*
@@ -166,6 +385,15 @@ CacheSet::createCacheSet(String cfgname, core_id_t core_id,
       case CacheBase::RANDOM:
          return new CacheSetRandom(cache_type, associativity, blocksize);
 
+      case CacheBase::SHIP:
+         return new CacheSetSHiP(cache_type, associativity, blocksize, dynamic_cast<CacheSetInfoSHiP*>(set_info));
+
+      case CacheBase::HAWKEYE:
+         return new CacheSetHawkeye(cache_type, associativity, blocksize, dynamic_cast<CacheSetInfoHawkeye*>(set_info));
+
+      case CacheBase::MOCKINGJAY:
+         return new CacheSetMockingjay(cache_type, associativity, blocksize, dynamic_cast<CacheSetInfoMockingjay*>(set_info));
+
       default:
          LOG_PRINT_ERROR("Unrecognized Cache Replacement Policy: %i",
                policy);
@@ -176,7 +404,7 @@ CacheSet::createCacheSet(String cfgname, core_id_t core_id,
 }
 
 CacheSetInfo*
-CacheSet::createCacheSetInfo(String name, String cfgname, core_id_t core_id, String replacement_policy, UInt32 associativity)
+CacheSet::createCacheSetInfo(String name, String cfgname, core_id_t core_id, String replacement_policy, UInt32 associativity, UInt32 num_sets, UInt32 blocksize)
 {
    CacheBase::ReplacementPolicy policy = parsePolicyType(replacement_policy);
    switch(policy)
@@ -186,6 +414,12 @@ CacheSet::createCacheSetInfo(String name, String cfgname, core_id_t core_id, Str
       case CacheBase::SRRIP:
       case CacheBase::SRRIP_QBS:
          return new CacheSetInfoLRU(name, cfgname, core_id, associativity, getNumQBSAttempts(policy, cfgname, core_id));
+      case CacheBase::SHIP:
+         return new CacheSetInfoSHiP(name, cfgname, core_id, associativity, num_sets, blocksize);
+      case CacheBase::HAWKEYE:
+         return new CacheSetInfoHawkeye(name, cfgname, core_id, associativity, num_sets, blocksize);
+      case CacheBase::MOCKINGJAY:
+         return new CacheSetInfoMockingjay(name, cfgname, core_id, associativity, num_sets, blocksize);
       default:
          return NULL;
    }
@@ -227,13 +461,23 @@ CacheSet::parsePolicyType(String policy)
       return CacheBase::SRRIP_QBS;
    if (policy == "random")
       return CacheBase::RANDOM;
+   if (policy == "ship")
+      return CacheBase::SHIP;
+   if (policy == "hawkeye")
+      return CacheBase::HAWKEYE;
+   if (policy == "mockingjay")
+      return CacheBase::MOCKINGJAY;
 
    LOG_PRINT_ERROR("Unknown replacement policy %s", policy.c_str());
 }
 
-bool CacheSet::isValidReplacement(UInt32 index)
+bool CacheSet::isValidReplacement(UInt32 index) const
 {
-   if (m_cache_block_info_array[index]->getCState() == CacheState::SHARED_UPGRADING)
+   if (index < 64 && !(m_allowed_ways & (UInt64(1) << index)))
+   {
+      return false;
+   }
+   else if (m_cache_block_info_array[index]->getCState() == CacheState::SHARED_UPGRADING)
    {
       return false;
    }
@@ -24,12 +24,20 @@ class CacheSet
    public:
 
       static CacheSet* createCacheSet(String cfgname, core_id_t core_id, String replacement_policy, CacheBase::cache_t cache_type, UInt32 associativity, UInt32 blocksize, CacheSetInfo* set_info = NULL);
-      static CacheSetInfo* createCacheSetInfo(String name, String cfgname, core_id_t core_id, String replacement_policy, UInt32 associativity);
+      static CacheSetInfo* createCacheSetInfo(String name, String cfgname, core_id_t core_id, String replacement_policy, UInt32 associativity, UInt32 num_sets, UInt32 blocksize);
       static CacheBase::ReplacementPolicy parsePolicyType(String policy);
       static UInt8 getNumQBSAttempts(CacheBase::ReplacementPolicy, String cfgname, core_id_t core_id);
 
    protected:
       CacheBlockInfo** m_cache_block_info_array;
+      // Tags of all ways, kept up to date by the CacheBlockInfo objects themselves,
+      // so lookups can compare them in bulk instead of chasing a pointer per way
+      IntPtr* m_tags;
+      char* m_block_info_storage;
+      bool m_owns_block_info_storage;
+      UInt64 m_ways_mask;
+      // Ways the line being inserted may replace (cache partitioning), m_ways_mask outside of insert()
+      UInt64 m_allowed_ways;
       char* m_blocks;
       UInt32 m_associativity;
       UInt32 m_blocksize;
@@ -49,17 +57,54 @@ class CacheSet
       void write_line(UInt32 line_index, UInt32 offset, Byte *in_buff, UInt32 bytes, bool update_replacement);
       CacheBlockInfo* find(IntPtr tag, UInt32* line_index = NULL);
       bool invalidate(IntPtr& tag);
-      void insert(CacheBlockInfo* cache_block_info, Byte* fill_buff, bool* eviction, CacheBlockInfo* evict_block_info, Byte* evict_buff, CacheCntlr *cntlr = NULL);
+      // way_mask limits the victim to a subset of the ways (up to 64 ways), 0 allows all ways
+      void insert(CacheBlockInfo* cache_block_info, Byte* fill_buff, bool* eviction, CacheBlockInfo* evict_block_info, Byte* evict_buff, CacheCntlr *cntlr = NULL, UInt64 way_mask = 0);
 
       CacheBlockInfo* peekBlock(UInt32 way) const { return m_cache_block_info_array[way]; }
 
       char* getDataPtr(UInt32 line_index, UInt32 offset = 0);
+      // Data storage for this set's blocks is owned by the Cache, NULL when only tags are modeled
+      void setDataArray(char* blocks) { m_blocks = blocks; }
+      // Tags and block infos can be moved into an array owned by the Cache, which holds those of all sets
+      size_t getBlockInfoStorageSize() const;
+      void relocateBlockInfoStorage(char* storage);
       UInt32 getBlockSize(void) const { return m_blocksize; }
 
       virtual UInt32 getReplacementIndex(CacheCntlr *cntlr) = 0;
       virtual void updateReplacementIndex(UInt32) = 0;
+      // A new line was just placed in way index by insert(), its tag is already in m_tags
+      virtual void notifyInsert(UInt32 index) {}
 
-      bool isValidReplacement(UInt32 index);
+      // Ways holding a line that is being upgraded, or outside of the way mask of the current insert, cannot be replaced
+      bool isValidReplacement(UInt32 index) const;
+      // Lowest way without a valid line that may be replaced, or -1
+      SInt32 findInvalidWay() const;
+
+      // Position of a way in the replacement order (0 = most recently used), for checkpointing.
+      // Policies without a recency order report all ways as equal and ignore restores.
+      virtual UInt32 getRecency(UInt32 way) const { return 0; }
+      virtual void setRecency(UInt32 way, UInt32 recency) {}
+
+   protected:
+      // Per-way 8-bit age arrays for the replacement policies, padded to whole SSE vectors. Padding ages stay zero.
+      UInt8* newAges() const;
+      static void deleteAges(UInt8* ages) { delete [] ages; }
+      // Bitmasks over the ways, for associativities up to 64
+      UInt64 agesAtLeast(const UInt8* ages, UInt8 value) const;
+      UInt8 maxAge(const UInt8* ages) const;
+      // Maximum age over the ways that may be replaced
+      UInt8 maxAllowedAge(const UInt8* ages) const;
+      // Increment all ages below threshold (LRU/MRU promotion)
+      void promoteAges(UInt8* ages, UInt8 threshold) const;
+      // Add delta to all ages, saturating at max (RRIP aging)
+      void ageAll(UInt8* ages, UInt8 delta, UInt8 max) const;
+
+   private:
+      UInt32 m_num_age_vectors;
+
+      // Bitmask of the ways holding tag, up to 64 ways
+      UInt64 matchTags(IntPtr tag) const;
+      SInt32 findIndex(IntPtr tag) const;
 };
 
 #endif /* CACHE_SET_H */
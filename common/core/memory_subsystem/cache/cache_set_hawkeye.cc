@@ -0,0 +1,134 @@
+#include "cache_set_hawkeye.h"
+#include "log.h"
+
+// Hawkeye [Jain and Lin, ISCA'16]: OPTgen reconstructs Belady's optimal decisions for past accesses to a few
+// sampled sets, a predictor learns from them which signatures are cache-friendly. Friendly lines are inserted
+// at RRPV 0, averse lines at RRPV_MAX so they are evicted first.
+
+CacheSetInfoHawkeye::CacheSetInfoHawkeye(String name, String cfgname, core_id_t core_id, UInt32 associativity, UInt32 num_sets, UInt32 blocksize)
+   : CacheSetInfoPredictor(name, cfgname, core_id, "hawkeye", associativity, num_sets, blocksize, HISTORY_PER_WAY)
+   , m_vector_size(HISTORY_PER_WAY * associativity)
+{
+   m_occupancy = newTable(UInt64(getNumSamplers()) * m_vector_size, UInt8(0));
+   // Start out weakly friendly
+   m_predictor = newTable(UInt64(1) << getSignatureBits(), UInt8(COUNTER_MAX / 2 + 1));
+}
+
+CacheSetInfoHawkeye::~CacheSetInfoHawkeye()
+{
+   deleteTable(m_occupancy);
+   deleteTable(m_predictor);
+}
+
+void
+CacheSetInfoHawkeye::access(UInt32 sampler, IntPtr tag, UInt16 signature, UInt32 time)
+{
+   UInt8* occupancy = &m_occupancy[UInt64(sampler) * m_vector_size];
+   occupancy[time % m_vector_size] = 0;
+
+   HistoryEntry* entry;
+   if (lookupHistory(sampler, tag, entry))
+   {
+      // OPT would have kept the line since its previous access if the set had room at every point in between
+      bool opt_hit = time - entry->last_access < m_vector_size;
+      for (UInt32 t = entry->last_access; opt_hit && t != time; ++t)
+         opt_hit = occupancy[t % m_vector_size] < m_associativity;
+      if (opt_hit)
+      {
+         for (UInt32 t = entry->last_access; t != time; ++t)
+            ++occupancy[t % m_vector_size];
+      }
+      train(entry->signature, opt_hit);
+   }
+   else if (entry->valid)
+   {
+      // Dropped from the history without being reused within the OPTgen window
+      train(entry->signature, false);
+   }
+
+   entry->tag = tag;
+   entry->last_access = time;
+   entry->signature = signature;
+   entry->valid = true;
+}
+
+CacheSetHawkeye::CacheSetHawkeye(
+      CacheBase::cache_t cache_type,
+      UInt32 associativity, UInt32 blocksize, CacheSetInfoHawkeye* set_info)
+   : CacheSet(cache_type, associativity, blocksize)
+   , m_set_info(set_info)
+   , m_sampler(set_info->registerSet())
+   , m_time(0)
+{
+   m_rrpv = newAges();
+   for (UInt32 i = 0; i < m_associativity; i++)
+      m_rrpv[i] = RRPV_MAX;
+}
+
+CacheSetHawkeye::~CacheSetHawkeye()
+{
+   deleteAges(m_rrpv);
+}
+
+UInt32
+CacheSetHawkeye::getReplacementIndex(CacheCntlr *cntlr)
+{
+   SInt32 invalid = findInvalidWay();
+   if (invalid >= 0)
+      return invalid;
+
+   // Prefer cache-averse lines
+   for (UInt64 candidates = agesAtLeast(m_rrpv, RRPV_MAX); candidates; candidates &= candidates - 1)
+   {
+      UInt32 index = __builtin_ctzll(candidates);
+      if (isValidReplacement(index))
+         return index;
+   }
+
+   // All lines are predicted friendly: evict the oldest one, and tell the predictor it was wrong
+   UInt32 index = 0;
+   for (UInt64 candidates = agesAtLeast(m_rrpv, maxAllowedAge(m_rrpv)); candidates; candidates &= candidates - 1)
+   {
+      index = __builtin_ctzll(candidates);
+      if (isValidReplacement(index))
+         break;
+   }
+   if (!isValidReplacement(index))
+   {
+      for (index = 0; index < m_associativity && !isValidReplacement(index); ++index) {}
+   }
+   LOG_ASSERT_ERROR(index < m_associativity, "Hawkeye found no valid replacement candidate");
+
+   m_set_info->train(m_set_info->getSignature(m_tags[index]), false);
+   return index;
+}
+
+void
+CacheSetHawkeye::access(UInt32 index, bool miss)
+{
+   UInt16 signature = m_set_info->getSignature(m_tags[index]);
+   if (m_sampler >= 0)
+      m_set_info->access(m_sampler, m_tags[index], signature, m_time++);
+
+   if (m_set_info->isFriendly(signature))
+   {
+      // A new friendly line ages the other friendly lines, saturating below RRPV_MAX
+      if (miss)
+         promoteAges(m_rrpv, RRPV_MAX - 1);
+      m_rrpv[index] = 0;
+   }
+   else
+      m_rrpv[index] = RRPV_MAX;
+}
+
+void
+CacheSetHawkeye::notifyInsert(UInt32 index)
+{
+   access(index, true);
+}
+
+void
+CacheSetHawkeye::updateReplacementIndex(UInt32 accessed_index)
+{
+   access(accessed_index, false);
+}
@@ -0,0 +1,57 @@
+#ifndef CACHE_SET_HAWKEYE_H
+#define CACHE_SET_HAWKEYE_H
+
+#include "cache_set_predictor.h"
+
+// OPTgen occupancy vectors of the sampled sets and the cache-friendliness predictor shared by all sets of a cache
+class CacheSetInfoHawkeye : public CacheSetInfoPredictor
+{
+   public:
+      static const UInt32 HISTORY_PER_WAY = 8;  // OPTgen looks back 8x the associativity in set accesses
+      static const UInt8 COUNTER_MAX = 7;
+
+      CacheSetInfoHawkeye(String name, String cfgname, core_id_t core_id, UInt32 associativity, UInt32 num_sets, UInt32 blocksize);
+      virtual ~CacheSetInfoHawkeye();
+
+      // Would Belady's OPT have cached the previous access to tag? Trains the predictor with the answer.
+      void access(UInt32 sampler, IntPtr tag, UInt16 signature, UInt32 time);
+
+      bool isFriendly(UInt16 signature) const { return m_predictor[signature] > COUNTER_MAX / 2; }
+      void train(UInt16 signature, bool friendly)
+      {
+         countTraining(friendly);
+         if (friendly && m_predictor[signature] < COUNTER_MAX)
+            ++m_predictor[signature];
+         else if (!friendly && m_predictor[signature] > 0)
+            --m_predictor[signature];
+      }
+
+   private:
+      const UInt32 m_vector_size;
+      UInt8* m_occupancy;  // Per sampled set, number of lines OPT keeps cached at each point in time
+      UInt8* m_predictor;
+};
+
+class CacheSetHawkeye final : public CacheSet
+{
+   public:
+      CacheSetHawkeye(CacheBase::cache_t cache_type,
+            UInt32 associativity, UInt32 blocksize, CacheSetInfoHawkeye* set_info);
+      ~CacheSetHawkeye();
+
+      UInt32 getReplacementIndex(CacheCntlr *cntlr);
+      void updateReplacementIndex(UInt32 accessed_index);
+      void notifyInsert(UInt32 index);
+
+   private:
+      static const UInt8 RRPV_MAX = 7;
+
+      CacheSetInfoHawkeye* m_set_info;
+      const SInt32 m_sampler;
+      UInt32 m_time;
+      UInt8* m_rrpv;
+
+      void access(UInt32 index, bool miss);
+};
+
+#endif /* CACHE_SET_HAWKEYE_H */
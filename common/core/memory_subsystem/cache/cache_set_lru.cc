@@ -11,43 +11,32 @@ CacheSetLRU::CacheSetLRU(
    , m_num_attempts(num_attempts)
    , m_set_info(set_info)
 {
-   m_lru_bits = new UInt8[m_associativity];
+   m_lru_bits = newAges();
    for (UInt32 i = 0; i < m_associativity; i++)
       m_lru_bits[i] = i;
 }
 
 CacheSetLRU::~CacheSetLRU()
 {
-   delete [] m_lru_bits;
+   deleteAges(m_lru_bits);
 }
 
 UInt32
 CacheSetLRU::getReplacementIndex(CacheCntlr *cntlr)
 {
    // First try to find an invalid block
-   for (UInt32 i = 0; i < m_associativity; i++)
+   SInt32 invalid = findInvalidWay();
+   if (invalid >= 0)
    {
-      if (!m_cache_block_info_array[i]->isValid())
-      {
-         // Mark our newly-inserted line as most-recently used
-         moveToMRU(i);
-         return i;
-      }
+      // Mark our newly-inserted line as most-recently used
+      moveToMRU(invalid);
+      return invalid;
    }
 
    // Make m_num_attemps attempts at evicting the block at LRU position
    for(UInt8 attempt = 0; attempt < m_num_attempts; ++attempt)
    {
-      UInt32 index = 0;
-      UInt8 max_bits = 0;
-      for (UInt32 i = 0; i < m_associativity; i++)
-      {
-         if (m_lru_bits[i] > max_bits && isValidReplacement(i))
-         {
-            index = i;
-            max_bits = m_lru_bits[i];
-         }
-      }
+      UInt32 index = findLRU();
       LOG_ASSERT_ERROR(index < m_associativity, "Error Finding LRU bits");
 
       bool qbs_reject = false;
@@ -84,14 +73,32 @@ CacheSetLRU::updateReplacementIndex(UInt32 accessed_index)
    moveToMRU(accessed_index);
 }
 
-void
-CacheSetLRU::moveToMRU(UInt32 accessed_index)
+UInt32
+CacheSetLRU::findLRU() const
 {
+   // Usually the oldest way (the lowest one if ages were restored with ties) is a valid candidate
+   if (m_associativity <= 64)
+   {
+      UInt32 index = __builtin_ctzll(agesAtLeast(m_lru_bits, maxAge(m_lru_bits)));
+      if (m_lru_bits[index] == 0 && isValidReplacement(0))
+         return 0;
+      if (isValidReplacement(index))
+         return index;
+   }
+
+   UInt32 index = m_associativity;
    for (UInt32 i = 0; i < m_associativity; i++)
    {
-      if (m_lru_bits[i] < m_lru_bits[accessed_index])
-         m_lru_bits[i] ++;
+      if (isValidReplacement(i) && (index == m_associativity || m_lru_bits[i] > m_lru_bits[index]))
+         index = i;
    }
+   return index == m_associativity ? 0 : index;
+}
+
+void
+CacheSetLRU::moveToMRU(UInt32 accessed_index)
+{
+   promoteAges(m_lru_bits, m_lru_bits[accessed_index]);
    m_lru_bits[accessed_index] = 0;
 }
 
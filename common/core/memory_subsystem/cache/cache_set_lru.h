@@ -26,7 +26,7 @@ class CacheSetInfoLRU : public CacheSetInfo
       UInt64* m_attempts;
 };
 
-class CacheSetLRU : public CacheSet
+class CacheSetLRU final : public CacheSet
 {
    public:
       CacheSetLRU(CacheBase::cache_t cache_type,
@@ -36,10 +36,14 @@ class CacheSetLRU : public CacheSet
       virtual UInt32 getReplacementIndex(CacheCntlr *cntlr);
       void updateReplacementIndex(UInt32 accessed_index);
 
+      virtual UInt32 getRecency(UInt32 way) const { return m_lru_bits[way]; }
+      virtual void setRecency(UInt32 way, UInt32 recency) { m_lru_bits[way] = recency; }
+
    protected:
       const UInt8 m_num_attempts;
       UInt8* m_lru_bits;
       CacheSetInfoLRU* m_set_info;
+      UInt32 findLRU() const;
       void moveToMRU(UInt32 accessed_index);
 };
 
@@ -0,0 +1,133 @@
+#include "cache_set_mockingjay.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "log.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Mockingjay [Shah, Jain and Lin, HPCA'22]: sampled sets measure the reuse distance of each signature, every line
+// is given an estimated time of arrival (ETA) from its signature's predicted reuse distance, and the line whose
+// ETA is furthest away (in the future or overdue) is evicted, mimicking Belady's OPT.
+
+CacheSetInfoMockingjay::CacheSetInfoMockingjay(String name, String cfgname, core_id_t core_id, UInt32 associativity, UInt32 num_sets, UInt32 blocksize)
+   : CacheSetInfoPredictor(name, cfgname, core_id, "mockingjay", associativity, num_sets, blocksize, HISTORY_PER_WAY)
+   , m_granularity(Sim()->getCfg()->getIntArray(cfgname + "/mockingjay/granularity", core_id))
+   , m_infinite(HISTORY_PER_WAY * associativity)
+{
+   LOG_ASSERT_ERROR(m_granularity > 0, "%s/mockingjay/granularity must be positive", cfgname.c_str());
+   m_rdp = newTable(UInt64(1) << getSignatureBits(), UNKNOWN);
+}
+
+CacheSetInfoMockingjay::~CacheSetInfoMockingjay()
+{
+   deleteTable(m_rdp);
+}
+
+void
+CacheSetInfoMockingjay::train(UInt16 signature, UInt32 distance)
+{
+   countTraining(distance < m_infinite);
+   if (m_rdp[signature] == UNKNOWN)
+   {
+      m_rdp[signature] = distance;
+      return;
+   }
+   // Move the prediction towards the observation, at least one step at a time
+   SInt32 diff = SInt32(distance) - SInt32(m_rdp[signature]);
+   SInt32 step = diff / 8;
+   if (step == 0 && diff != 0)
+      step = diff > 0 ? 1 : -1;
+   m_rdp[signature] = std::min(SInt32(m_infinite), SInt32(m_rdp[signature]) + step);
+}
+
+void
+CacheSetInfoMockingjay::access(UInt32 sampler, IntPtr tag, UInt16 signature, UInt32 time)
+{
+   HistoryEntry* entry;
+   if (lookupHistory(sampler, tag, entry))
+      train(entry->signature, std::min(time - entry->last_access, m_infinite));
+   else if (entry->valid)
+      // Pushed out of the history without being seen again: the reuse distance is too long to cache
+      train(entry->signature, m_infinite);
+
+   entry->tag = tag;
+   entry->last_access = time;
+   entry->signature = signature;
+   entry->valid = true;
+}
+
+CacheSetMockingjay::CacheSetMockingjay(
+      CacheBase::cache_t cache_type,
+      UInt32 associativity, UInt32 blocksize, CacheSetInfoMockingjay* set_info)
+   : CacheSet(cache_type, associativity, blocksize)
+   , m_set_info(set_info)
+   , m_sampler(set_info->registerSet())
+   , m_time(0)
+{
+   m_eta = new SInt8[m_associativity];
+   for (UInt32 i = 0; i < m_associativity; i++)
+      m_eta[i] = 0;
+}
+
+CacheSetMockingjay::~CacheSetMockingjay()
+{
+   delete [] m_eta;
+}
+
+UInt32
+CacheSetMockingjay::getReplacementIndex(CacheCntlr *cntlr)
+{
+   SInt32 invalid = findInvalidWay();
+   if (invalid >= 0)
+      return invalid;
+
+   UInt32 index = m_associativity;
+   int furthest = -1;
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      if (std::abs(int(m_eta[i])) > furthest && isValidReplacement(i))
+      {
+         index = i;
+         furthest = std::abs(int(m_eta[i]));
+      }
+   }
+   LOG_ASSERT_ERROR(index < m_associativity, "Mockingjay found no valid replacement candidate");
+   return index;
+}
+
+void
+CacheSetMockingjay::access(UInt32 index)
+{
+   UInt16 signature = m_set_info->getSignature(m_tags[index]);
+   if (m_sampler >= 0)
+      m_set_info->access(m_sampler, m_tags[index], signature, m_time);
+
+   // Advance the ETA clock of the whole set
+   if (++m_time % m_set_info->getGranularity() == 0)
+   {
+      for (UInt32 i = 0; i < m_associativity; i++)
+         if (m_eta[i] > -ETA_MAX)
+            --m_eta[i];
+   }
+
+   UInt16 distance = m_set_info->getReuseDistance(signature);
+   if (distance == CacheSetInfoMockingjay::UNKNOWN)
+      m_eta[index] = 0;
+   else if (distance >= m_set_info->getInfinite())
+      m_eta[index] = ETA_MAX;
+   else
+      m_eta[index] = std::min(UInt32(distance) / m_set_info->getGranularity(), UInt32(ETA_MAX));
+}
+
+void
+CacheSetMockingjay::notifyInsert(UInt32 index)
+{
+   access(index);
+}
+
+void
+CacheSetMockingjay::updateReplacementIndex(UInt32 accessed_index)
+{
+   access(accessed_index);
+}
@@ -0,0 +1,53 @@
+#ifndef CACHE_SET_MOCKINGJAY_H
+#define CACHE_SET_MOCKINGJAY_H
+
+#include "cache_set_predictor.h"
+
+// Reuse distance predictor (RDP) shared by all sets of a cache
+class CacheSetInfoMockingjay : public CacheSetInfoPredictor
+{
+   public:
+      static const UInt32 HISTORY_PER_WAY = 8;
+      static const UInt16 UNKNOWN = 0xffff;
+
+      CacheSetInfoMockingjay(String name, String cfgname, core_id_t core_id, UInt32 associativity, UInt32 num_sets, UInt32 blocksize);
+      virtual ~CacheSetInfoMockingjay();
+
+      // Observe an access to a sampled set, train the RDP with the reuse distance of tag's previous access
+      void access(UInt32 sampler, IntPtr tag, UInt16 signature, UInt32 time);
+
+      UInt32 getGranularity() const { return m_granularity; }
+      UInt32 getInfinite() const { return m_infinite; }
+      UInt16 getReuseDistance(UInt16 signature) const { return m_rdp[signature]; }
+
+   private:
+      UInt32 m_granularity;   // Set accesses per ETA clock tick
+      const UInt32 m_infinite;   // Reuse distances from here on are not cache-friendly
+      UInt16* m_rdp;
+
+      void train(UInt16 signature, UInt32 distance);
+};
+
+class CacheSetMockingjay final : public CacheSet
+{
+   public:
+      CacheSetMockingjay(CacheBase::cache_t cache_type,
+            UInt32 associativity, UInt32 blocksize, CacheSetInfoMockingjay* set_info);
+      ~CacheSetMockingjay();
+
+      UInt32 getReplacementIndex(CacheCntlr *cntlr);
+      void updateReplacementIndex(UInt32 accessed_index);
+      void notifyInsert(UInt32 index);
+
+   private:
+      static const SInt8 ETA_MAX = 127;
+
+      CacheSetInfoMockingjay* m_set_info;
+      const SInt32 m_sampler;
+      UInt32 m_time;
+      SInt8* m_eta;  // Estimated time until the next access, in ETA clock ticks. Negative when overdue.
+
+      void access(UInt32 index);
+};
+
+#endif /* CACHE_SET_MOCKINGJAY_H */
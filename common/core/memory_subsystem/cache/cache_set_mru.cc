@@ -8,14 +8,14 @@ CacheSetMRU::CacheSetMRU(
       UInt32 associativity, UInt32 blocksize) :
    CacheSet(cache_type, associativity, blocksize)
 {
-   m_lru_bits = new UInt8[m_associativity];
+   m_lru_bits = newAges();
    for (UInt32 i = 0; i < m_associativity; i++)
       m_lru_bits[i] = i;
 }
 
 CacheSetMRU::~CacheSetMRU()
 {
-   delete [] m_lru_bits;
+   deleteAges(m_lru_bits);
 }
 
 UInt32
@@ -23,12 +23,22 @@ CacheSetMRU::getReplacementIndex(CacheCntlr *cntlr)
 {
    // Invalidations may mess up the LRU bits
 
-   for (UInt32 i = 0; i < m_associativity; i++)
+   SInt32 invalid = findInvalidWay();
+   if (invalid >= 0)
+   {
+      updateReplacementIndex(invalid);
+      return invalid;
+   }
+
+   // Usually the most recently used way is a valid candidate
+   if (m_associativity <= 64)
    {
-      if (!m_cache_block_info_array[i]->isValid())
+      UInt64 mru = ~agesAtLeast(m_lru_bits, 1) & m_ways_mask;
+      if (mru && isValidReplacement(__builtin_ctzll(mru)))
       {
-         updateReplacementIndex(i);
-         return i;
+         UInt32 index = __builtin_ctzll(mru);
+         updateReplacementIndex(index);
+         return index;
       }
    }
 
@@ -52,10 +62,6 @@ CacheSetMRU::getReplacementIndex(CacheCntlr *cntlr)
 void
 CacheSetMRU::updateReplacementIndex(UInt32 accessed_index)
 {
-   for (UInt32 i = 0; i < m_associativity; i++)
-   {
-      if (m_lru_bits[i] < m_lru_bits[accessed_index])
-         m_lru_bits[i] ++;
-   }
+   promoteAges(m_lru_bits, m_lru_bits[accessed_index]);
    m_lru_bits[accessed_index] = 0;
 }
@@ -25,13 +25,11 @@ CacheSetNMRU::getReplacementIndex(CacheCntlr *cntlr)
 {
    // Invalidations may mess up the LRU bits
 
-   for (UInt32 i = 0; i < m_associativity; i++)
+   SInt32 invalid = findInvalidWay();
+   if (invalid >= 0)
    {
-      if (!m_cache_block_info_array[i]->isValid())
-      {
-         updateReplacementIndex(i);
-         return i;
-      }
+      updateReplacementIndex(invalid);
+      return invalid;
    }
 
    for (UInt32 i = 0; i < m_associativity; i++)
@@ -48,6 +46,16 @@ CacheSetNMRU::getReplacementIndex(CacheCntlr *cntlr)
       m_replacement_pointer = (m_replacement_pointer + 1) % m_associativity;
    }
 
+   // Only the MRU line may be replaced (way mask of a single way)
+   for (UInt32 i = 0; i < m_associativity; i++)
+   {
+      if (isValidReplacement(i))
+      {
+         updateReplacementIndex(i);
+         return i;
+      }
+   }
+
    LOG_PRINT_ERROR("Error Finding LRU bits");
 }
 
@@ -1,6 +1,8 @@
 #include "cache_set_nru.h"
 #include "log.h"
 
+#include <cstring>
+
 // NRU: Not Recently Used. Some sort of Pseudo LRU policy.
 
 CacheSetNRU::CacheSetNRU(
@@ -8,9 +10,7 @@ CacheSetNRU::CacheSetNRU(
       UInt32 associativity, UInt32 blocksize) :
    CacheSet(cache_type, associativity, blocksize)
 {
-   m_lru_bits = new UInt8[m_associativity];
-   for (UInt32 i = 0; i < m_associativity; i++)
-      m_lru_bits[i] = 0;  // initially, lru bits of each set are set to zero, they are not touched yet
+   m_lru_bits = newAges();  // initially, lru bits of each set are set to zero, they are not touched yet
 
    m_num_bits_set = 0;
    m_replacement_pointer = 0;
@@ -18,7 +18,7 @@ CacheSetNRU::CacheSetNRU(
 
 CacheSetNRU::~CacheSetNRU()
 {
-   delete [] m_lru_bits;
+   deleteAges(m_lru_bits);
 }
 
 UInt32
@@ -26,6 +26,9 @@ CacheSetNRU::getReplacementIndex(CacheCntlr *cntlr)
 {
    // Invalidations may mess up the LRU bits
 
+   if (m_associativity <= 64)
+      return getReplacementIndexMask();
+
    bool have_zero_bit = false;
 
    for (UInt32 i = 0; i < m_associativity; i++)
@@ -65,6 +68,45 @@ CacheSetNRU::getReplacementIndex(CacheCntlr *cntlr)
    LOG_PRINT_ERROR("Error Finding LRU bits");
 }
 
+UInt32
+CacheSetNRU::getReplacementIndexMask()
+{
+   // Same selection as the loops in getReplacementIndex, on bitmasks of the ways
+   SInt32 invalid = findInvalidWay();
+   if (invalid >= 0)
+   {
+      updateReplacementIndex(invalid);
+      return invalid;
+   }
+
+   UInt64 zero_bits = ~agesAtLeast(m_lru_bits, 1) & m_ways_mask;
+   bool have_zero_bit = false;
+   for (UInt64 ways = zero_bits; ways && !have_zero_bit; ways &= ways - 1)
+      have_zero_bit = isValidReplacement(__builtin_ctzll(ways));
+
+   // Visit the candidates starting from the replacement pointer, wrapping around
+   UInt64 candidates = have_zero_bit ? zero_bits : m_ways_mask;
+   UInt64 from_pointer = candidates & ~((UInt64(1) << m_replacement_pointer) - 1);
+   UInt64 ordered[2] = { from_pointer, candidates & ~from_pointer };
+   for (UInt32 pass = 0; pass < 2; ++pass)
+   {
+      for (UInt64 ways = ordered[pass]; ways; ways &= ways - 1)
+      {
+         UInt32 index = __builtin_ctzll(ways);
+         if (isValidReplacement(index))
+         {
+            m_replacement_pointer = (index + 1) % m_associativity;
+
+            // Mark our newly-inserted line as recently used
+            updateReplacementIndex(index);
+            return index;
+         }
+      }
+   }
+
+   LOG_PRINT_ERROR("Error Finding LRU bits");
+}
+
 void
 CacheSetNRU::updateReplacementIndex(UInt32 accessed_index)
 {
@@ -77,9 +119,6 @@ CacheSetNRU::updateReplacementIndex(UInt32 accessed_index)
    {
       m_num_bits_set = 0;
 
-      for (UInt32 i = 0; i < m_associativity; i++)
-      {
-         m_lru_bits[i] = 0;
-      }
+      memset(m_lru_bits, 0, m_associativity);
    }
 }
@@ -3,7 +3,7 @@
 
 #include "cache_set.h"
 
-class CacheSetNRU : public CacheSet
+class CacheSetNRU final : public CacheSet
 {
    public:
       CacheSetNRU(CacheBase::cache_t cache_type,
@@ -15,6 +15,7 @@ class CacheSetNRU : public CacheSet
 
    private:
       UInt8* m_lru_bits;
+      UInt32 getReplacementIndexMask();
       UInt8  m_num_bits_set;
       UInt8  m_replacement_pointer;
 };
@@ -1,17 +1,18 @@
 #include "cache_set_plru.h"
+#include "utils.h"
 #include "log.h"
 
-// Tree LRU for 4 and 8 way caches
+// Tree LRU for power-of-two associativities up to 64 ways
 
 CacheSetPLRU::CacheSetPLRU(
       CacheBase::cache_t cache_type,
       UInt32 associativity, UInt32 blocksize) :
-   CacheSet(cache_type, associativity, blocksize)
+   CacheSet(cache_type, associativity, blocksize),
+   m_tree(0),
+   m_levels(floorLog2(associativity))
 {
-   LOG_ASSERT_ERROR(associativity == 4 || associativity == 8,
-      "PLRU not implemted for associativity %d (only 4, 8)", associativity);
-   for(int i = 0; i < 8; ++i)
-      b[i] = 0;
+   LOG_ASSERT_ERROR(isPower2(associativity) && associativity >= 2 && associativity <= 64,
+      "PLRU not implemted for associativity %d (only powers of two from 2 to 64)", associativity);
 }
 
 CacheSetPLRU::~CacheSetPLRU()
@@ -23,63 +24,25 @@ CacheSetPLRU::getReplacementIndex(CacheCntlr *cntlr)
 {
    // Invalidations may mess up the LRU bits
 
-   for (UInt32 i = 0; i < m_associativity; i++)
+   SInt32 invalid = findInvalidWay();
+   if (invalid >= 0)
    {
-      if (!m_cache_block_info_array[i]->isValid())
-      {
-         updateReplacementIndex(i);
-         return i;
-      }
+      updateReplacementIndex(invalid);
+      return invalid;
    }
 
-   UInt32 retValue = -1;
-   if (m_associativity == 4)
+   UInt32 node = 0, first = 0;
+   for (UInt32 level = 0; level < m_levels; ++level)
    {
-      if (b[0] == 0)
-      {
-         if (b[1] == 0) retValue = 0;
-         else           retValue = 1;   // b1==1
-      }
-      else
-      {
-         if (b[2] == 0) retValue = 2;
-         else           retValue = 3;   // b2==1
-      }
+      // Follow the tree, unless the way mask excludes all ways on that side
+      UInt32 half = m_associativity >> (level + 1);
+      UInt32 side = (m_tree >> node) & 1;
+      if (!(m_allowed_ways & (((UInt64(1) << half) - 1) << (first + side * half))))
+         side ^= 1;
+      node = 2 * node + 1 + side;
+      first += side * half;
    }
-   else if (m_associativity == 8)
-   {
-      if (b[0] == 0)
-      {
-         if (b[1] == 0)
-         {
-            if (b[2] == 0) retValue= 0;
-            else           retValue= 1;  // b2==1
-         }
-         else
-         {                            // b1==1
-            if (b[3] == 0) retValue = 2;
-            else           retValue = 3;  // b3==1
-         }
-      }
-      else
-      {                               // b0==1
-         if (b[4] == 0)
-         {
-            if (b[5] == 0) retValue = 4;
-            else           retValue = 5;  // b5==1
-         }
-         else
-         {                            // b4==1
-            if (b[6] == 0) retValue = 6;
-            else           retValue = 7;  // b6==1
-         }
-      }
-   }
-   else
-   {
-      LOG_PRINT_ERROR("PLRU doesn't support associativity %d", m_associativity);
-   }
-
+   UInt32 retValue = first;
 
    LOG_ASSERT_ERROR(isValidReplacement(retValue), "PLRU selected an invalid replacement candidate" );
    updateReplacementIndex(retValue);
@@ -90,26 +53,13 @@ CacheSetPLRU::getReplacementIndex(CacheCntlr *cntlr)
 void
 CacheSetPLRU::updateReplacementIndex(UInt32 accessed_index)
 {
-   if (m_associativity == 4)
-   {
-      if      (accessed_index==0) { b[0]=1;b[1]=1;     }
-      else if (accessed_index==1) { b[0]=1;b[1]=0;     }
-      else if (accessed_index==2) { b[0]=0;       b[2]=1;}
-      else if (accessed_index==3) { b[0]=0;       b[2]=0;}
-   }
-   else if (m_associativity == 8)
-   {
-      if      (accessed_index==0) { b[0]=1;b[1]=1;b[2]=1;                            }
-      else if (accessed_index==1) { b[0]=1;b[1]=1;b[2]=0;                            }
-      else if (accessed_index==2) { b[0]=1;b[1]=0;       b[3]=1;                     }
-      else if (accessed_index==3) { b[0]=1;b[1]=0;       b[3]=0;                     }
-      else if (accessed_index==4) { b[0]=0;                     b[4]=1;b[5]=1;       }
-      else if (accessed_index==5) { b[0]=0;                     b[4]=1;b[5]=0;       }
-      else if (accessed_index==6) { b[0]=0;                     b[4]=0;       b[6]=1;}
-      else if (accessed_index==7) { b[0]=0;                     b[4]=0;       b[6]=0;}
-   }
-   else
+   // Walk from the root to the accessed way, pointing each node away from it. Bits of the way index, from the
+   // most significant one down, tell whether the path goes right at each level.
+   UInt32 node = 0;
+   for (UInt32 level = m_levels; level > 0; --level)
    {
-      LOG_PRINT_ERROR("PLRU doesn't support associativity %d", m_associativity);
+      UInt64 right = (accessed_index >> (level - 1)) & 1;
+      m_tree = (m_tree & ~(UInt64(1) << node)) | ((right ^ 1) << node);
+      node = 2 * node + 1 + right;
    }
 }
@@ -3,7 +3,7 @@
 
 #include "cache_set.h"
 
-class CacheSetPLRU : public CacheSet
+class CacheSetPLRU final : public CacheSet
 {
    public:
       CacheSetPLRU(CacheBase::cache_t cache_type,
@@ -14,7 +14,9 @@ class CacheSetPLRU : public CacheSet
       void updateReplacementIndex(UInt32 accessed_index);
 
    private:
-      UInt8 b[8];
+      // Tree nodes in heap order (children of node n are 2n+1 and 2n+2), a set bit points the victim search right
+      UInt64 m_tree;
+      UInt32 m_levels;
 };
 
 #endif /* CACHE_SET_PLRU_H */
@@ -0,0 +1,72 @@
+#include "cache_set_predictor.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "stats.h"
+#include "utils.h"
+#include "log.h"
+
+#include <algorithm>
+
+CacheSetInfoPredictor::CacheSetInfoPredictor(String name, String cfgname, core_id_t core_id, String policy,
+      UInt32 associativity, UInt32 num_sets, UInt32 blocksize, UInt32 history_per_way)
+   : m_associativity(associativity)
+   , m_signature_bits(Sim()->getCfg()->getIntArray(cfgname + "/" + policy + "/signature_bits", core_id))
+   , m_region_shift(0)
+   , m_num_registered(0)
+   , m_history_size(history_per_way * associativity)
+   , m_train_reuse(0)
+   , m_train_no_reuse(0)
+{
+   LOG_ASSERT_ERROR(associativity <= 64, "%s replacement supports up to 64 ways, got %u", policy.c_str(), associativity);
+   LOG_ASSERT_ERROR(m_signature_bits > 0 && m_signature_bits <= 16, "%s/%s/signature_bits must be between 1 and 16", cfgname.c_str(), policy.c_str());
+
+   UInt32 region_size = Sim()->getCfg()->getIntArray(cfgname + "/" + policy + "/region_size", core_id);
+   LOG_ASSERT_ERROR(isPower2(region_size) && region_size >= blocksize, "%s/%s/region_size must be a power of two of at least one cache line", cfgname.c_str(), policy.c_str());
+   m_region_shift = floorLog2(region_size / blocksize);
+
+   UInt32 sampled_sets = Sim()->getCfg()->getIntArray(cfgname + "/" + policy + "/sampled_sets", core_id);
+   sampled_sets = std::max(1u, std::min(sampled_sets, num_sets));
+   m_sample_interval = num_sets / sampled_sets;
+   m_num_samplers = (num_sets + m_sample_interval - 1) / m_sample_interval;
+
+   m_history = newTable(UInt64(m_num_samplers) * m_history_size, HistoryEntry());
+
+   registerStatsMetric(name, core_id, policy + "-train-reuse", &m_train_reuse);
+   registerStatsMetric(name, core_id, policy + "-train-noreuse", &m_train_no_reuse);
+}
+
+CacheSetInfoPredictor::~CacheSetInfoPredictor()
+{
+   deleteTable(m_history);
+}
+
+SInt32
+CacheSetInfoPredictor::registerSet()
+{
+   UInt32 set_index = m_num_registered++;
+   if (set_index % m_sample_interval == 0 && set_index / m_sample_interval < m_num_samplers)
+      return set_index / m_sample_interval;
+   else
+      return -1;
+}
+
+bool
+CacheSetInfoPredictor::lookupHistory(UInt32 sampler, IntPtr tag, HistoryEntry*& entry)
+{
+   HistoryEntry* history = &m_history[UInt64(sampler) * m_history_size];
+   HistoryEntry* victim = &history[0];
+   for (UInt32 i = 0; i < m_history_size; ++i)
+   {
+      if (!history[i].valid)
+         victim = &history[i];
+      else if (history[i].tag == tag)
+      {
+         entry = &history[i];
+         return true;
+      }
+      else if (victim->valid && history[i].last_access < victim->last_access)
+         victim = &history[i];
+   }
+   entry = victim;
+   return false;
+}
@@ -0,0 +1,70 @@
+#ifndef CACHE_SET_PREDICTOR_H
+#define CACHE_SET_PREDICTOR_H
+
+#include "cache_set.h"
+
+#include <new>
+
+// Shared state of the learning replacement policies (SHiP++, Hawkeye, Mockingjay), one instance per cache.
+// Predictor tables are flat, cache-line aligned arrays indexed by a signature. Training only looks at a few
+// sampled sets, each of which keeps a short history of the lines it has seen (tag, last access time, signature).
+// Caches below the L1 are not told the instruction pointer of a request, so signatures hash the line's memory
+// region instead of the PC (the SHiP-Mem signature).
+class CacheSetInfoPredictor : public CacheSetInfo
+{
+   public:
+      struct HistoryEntry
+      {
+         IntPtr tag;
+         UInt32 last_access;     // Set-local time of the last access
+         UInt16 signature;
+         bool valid;
+         bool reused;            // Seen again since it entered the history
+      };
+
+      CacheSetInfoPredictor(String name, String cfgname, core_id_t core_id, String policy,
+            UInt32 associativity, UInt32 num_sets, UInt32 blocksize, UInt32 history_per_way);
+      virtual ~CacheSetInfoPredictor();
+
+      // Called by each set when it is constructed, returns the set's sampler index or -1 if it is not sampled
+      SInt32 registerSet();
+
+      UInt32 getSignatureBits() const { return m_signature_bits; }
+      UInt16 getSignature(IntPtr tag) const
+         { return ((tag >> m_region_shift) * 0x9e3779b97f4a7c15ull) >> (64 - m_signature_bits); }
+
+      // Find tag in a sampler's history. On a miss, entry is the slot to reuse (invalid or least recently accessed).
+      bool lookupHistory(UInt32 sampler, IntPtr tag, HistoryEntry*& entry);
+      UInt32 getHistorySize() const { return m_history_size; }
+      UInt32 getNumSamplers() const { return m_num_samplers; }
+
+      void countTraining(bool reuse) { if (reuse) ++m_train_reuse; else ++m_train_no_reuse; }
+
+   protected:
+      const UInt32 m_associativity;
+
+      template <class T> static T* newTable(UInt64 entries, T value)
+      {
+         T* table = new (std::align_val_t(ALIGNMENT)) T[entries];
+         for (UInt64 i = 0; i < entries; ++i)
+            table[i] = value;
+         return table;
+      }
+      template <class T> static void deleteTable(T* table) { ::operator delete[](table, std::align_val_t(ALIGNMENT)); }
+
+   private:
+      static const size_t ALIGNMENT = 64;
+
+      UInt32 m_signature_bits;
+      UInt32 m_region_shift;     // log2 of the number of cache lines per signature region
+      UInt32 m_sample_interval;  // Every m_sample_interval'th set is sampled
+      UInt32 m_num_registered;
+      UInt32 m_num_samplers;
+      UInt32 m_history_size;     // History entries per sampled set
+      HistoryEntry* m_history;
+
+      UInt64 m_train_reuse;
+      UInt64 m_train_no_reuse;
+};
+
+#endif /* CACHE_SET_PREDICTOR_H */
@@ -17,7 +17,7 @@ CacheSetRoundRobin::getReplacementIndex(CacheCntlr *cntlr)
    UInt32 curr_replacement_index = m_replacement_index;
    m_replacement_index = (m_replacement_index == 0) ? (m_associativity-1) : (m_replacement_index-1);
 
-   if (!isValidReplacement(m_replacement_index))
+   if (!isValidReplacement(curr_replacement_index))
       return getReplacementIndex(cntlr);
    else
       return curr_replacement_index;
@@ -0,0 +1,88 @@
+#include "cache_set_ship.h"
+#include "log.h"
+
+// SHiP++: Signature-based Hit Predictor [Wu et al., MICRO'11] with the SHiP++ enhancements [Young et al., CRC2 2017]:
+// counters only train on sampled sets and on the first re-reference of a line, and lines whose signature
+// is confidently reused are inserted at RRPV 0.
+
+CacheSetInfoSHiP::CacheSetInfoSHiP(String name, String cfgname, core_id_t core_id, UInt32 associativity, UInt32 num_sets, UInt32 blocksize)
+   : CacheSetInfoPredictor(name, cfgname, core_id, "ship", associativity, num_sets, blocksize, 0)
+{
+   m_shct = newTable(UInt64(1) << getSignatureBits(), UInt8(1));
+}
+
+CacheSetInfoSHiP::~CacheSetInfoSHiP()
+{
+   deleteTable(m_shct);
+}
+
+CacheSetSHiP::CacheSetSHiP(
+      CacheBase::cache_t cache_type,
+      UInt32 associativity, UInt32 blocksize, CacheSetInfoSHiP* set_info)
+   : CacheSet(cache_type, associativity, blocksize)
+   , m_set_info(set_info)
+   , m_sampled(set_info->registerSet() >= 0)
+   , m_reused(0)
+{
+   m_rrpv = newAges();
+   for (UInt32 i = 0; i < m_associativity; i++)
+      m_rrpv[i] = RRPV_MAX;
+}
+
+CacheSetSHiP::~CacheSetSHiP()
+{
+   deleteAges(m_rrpv);
+}
+
+UInt32
+CacheSetSHiP::getReplacementIndex(CacheCntlr *cntlr)
+{
+   SInt32 invalid = findInvalidWay();
+   if (invalid >= 0)
+      return invalid;
+
+   // SRRIP victim selection: age all lines until one reaches RRPV_MAX, take the first one
+   UInt8 oldest = maxAllowedAge(m_rrpv);
+   if (oldest < RRPV_MAX)
+      ageAll(m_rrpv, RRPV_MAX - oldest, RRPV_MAX);
+
+   UInt32 index = 0;
+   for (UInt64 candidates = agesAtLeast(m_rrpv, RRPV_MAX); candidates; candidates &= candidates - 1)
+   {
+      index = __builtin_ctzll(candidates);
+      if (isValidReplacement(index))
+         break;
+   }
+   LOG_ASSERT_ERROR(isValidReplacement(index), "SHiP selected an invalid replacement candidate");
+
+   // Evicted without being reused: its signature predicts no reuse
+   if (m_sampled && !(m_reused & (UInt64(1) << index)))
+      m_set_info->train(m_set_info->getSignature(m_tags[index]), false);
+
+   return index;
+}
+
+void
+CacheSetSHiP::notifyInsert(UInt32 index)
+{
+   UInt8 counter = m_set_info->getCounter(m_set_info->getSignature(m_tags[index]));
+   m_reused &= ~(UInt64(1) << index);
+   if (counter == 0)
+      m_rrpv[index] = RRPV_MAX;
+   else if (counter == CacheSetInfoSHiP::SHCT_MAX)
+      m_rrpv[index] = 0;
+   else
+      m_rrpv[index] = RRPV_MAX - 1;
+}
+
+void
+CacheSetSHiP::updateReplacementIndex(UInt32 accessed_index)
+{
+   if (!(m_reused & (UInt64(1) << accessed_index)))
+   {
+      m_reused |= UInt64(1) << accessed_index;
+      if (m_sampled)
+         m_set_info->train(m_set_info->getSignature(m_tags[accessed_index]), true);
+   }
+   m_rrpv[accessed_index] = 0;
+}
@@ -0,0 +1,49 @@
+#ifndef CACHE_SET_SHIP_H
+#define CACHE_SET_SHIP_H
+
+#include "cache_set_predictor.h"
+
+// Signature history counter table (SHCT) shared by all sets of a cache
+class CacheSetInfoSHiP : public CacheSetInfoPredictor
+{
+   public:
+      static const UInt8 SHCT_MAX = 7;
+
+      CacheSetInfoSHiP(String name, String cfgname, core_id_t core_id, UInt32 associativity, UInt32 num_sets, UInt32 blocksize);
+      virtual ~CacheSetInfoSHiP();
+
+      UInt8 getCounter(UInt16 signature) const { return m_shct[signature]; }
+      void train(UInt16 signature, bool reuse)
+      {
+         countTraining(reuse);
+         if (reuse && m_shct[signature] < SHCT_MAX)
+            ++m_shct[signature];
+         else if (!reuse && m_shct[signature] > 0)
+            --m_shct[signature];
+      }
+
+   private:
+      UInt8* m_shct;
+};
+
+class CacheSetSHiP final : public CacheSet
+{
+   public:
+      CacheSetSHiP(CacheBase::cache_t cache_type,
+            UInt32 associativity, UInt32 blocksize, CacheSetInfoSHiP* set_info);
+      ~CacheSetSHiP();
+
+      UInt32 getReplacementIndex(CacheCntlr *cntlr);
+      void updateReplacementIndex(UInt32 accessed_index);
+      void notifyInsert(UInt32 index);
+
+   private:
+      static const UInt8 RRPV_MAX = 3;
+
+      CacheSetInfoSHiP* m_set_info;
+      const bool m_sampled;
+      UInt8* m_rrpv;
+      UInt64 m_reused;  // Bitmask of the ways that were hit since they were inserted
+};
+
+#endif /* CACHE_SET_SHIP_H */
@@ -17,37 +17,38 @@ CacheSetSRRIP::CacheSetSRRIP(
    , m_replacement_pointer(0)
    , m_set_info(set_info)
 {
-   m_rrip_bits = new UInt8[m_associativity];
+   m_rrip_bits = newAges();
    for (UInt32 i = 0; i < m_associativity; i++)
       m_rrip_bits[i] = m_rrip_insert;
 }
 
 CacheSetSRRIP::~CacheSetSRRIP()
 {
-   delete [] m_rrip_bits;
+   deleteAges(m_rrip_bits);
 }
 
 UInt32
 CacheSetSRRIP::getReplacementIndex(CacheCntlr *cntlr)
 {
-   for (UInt32 i = 0; i < m_associativity; i++)
+   SInt32 invalid = findInvalidWay();
+   if (invalid >= 0)
    {
-      if (!m_cache_block_info_array[i]->isValid())
-      {
-         // If there is an invalid line(s) in the set, regardless of the LRU bits of other lines, we choose the first invalid line to replace
-         // Prepare way for a new line: set prediction to 'long'
-         m_rrip_bits[i] = m_rrip_insert;
-         return i;
-      }
+      // If there is an invalid line(s) in the set, regardless of the LRU bits of other lines, we choose the first invalid line to replace
+      // Prepare way for a new line: set prediction to 'long'
+      m_rrip_bits[invalid] = m_rrip_insert;
+      return invalid;
    }
 
+   if (m_num_attempts == 1 && m_associativity <= 64)
+      return getReplacementIndexMask();
+
    UInt8 attempt = 0;
 
    for(UInt32 j = 0; j <= m_rrip_max; ++j)
    {
       for (UInt32 i = 0; i < m_associativity; i++)
       {
-         if (m_rrip_bits[m_replacement_pointer] >= m_rrip_max)
+         if (m_rrip_bits[m_replacement_pointer] >= m_rrip_max && isValidReplacement(m_replacement_pointer))
          {
             // We choose the first non-touched line as the victim (note that we start searching from the replacement pointer position)
             UInt8 index = m_replacement_pointer;
@@ -95,6 +96,29 @@ CacheSetSRRIP::getReplacementIndex(CacheCntlr *cntlr)
    LOG_PRINT_ERROR("Error finding replacement index");
 }
 
+UInt32
+CacheSetSRRIP::getReplacementIndexMask()
+{
+   // Without QBS, the loops in getReplacementIndex age all lines just enough for the oldest to reach RRIP_MAX,
+   // then take the first such line from the replacement pointer on. Do the aging in one step.
+   UInt8 oldest = maxAllowedAge(m_rrip_bits);
+   if (oldest < m_rrip_max)
+      ageAll(m_rrip_bits, m_rrip_max - oldest, m_rrip_max);
+
+   UInt64 candidates = agesAtLeast(m_rrip_bits, m_rrip_max) & m_allowed_ways;
+   UInt64 from_pointer = candidates & ~((UInt64(1) << m_replacement_pointer) - 1);
+   UInt32 index = __builtin_ctzll(from_pointer ? from_pointer : candidates);
+
+   m_replacement_pointer = (index + 1) % m_associativity;
+   // Prepare way for a new line: set prediction to 'long'
+   m_rrip_bits[index] = m_rrip_insert;
+
+   m_set_info->incrementAttempt(0);
+
+   LOG_ASSERT_ERROR(isValidReplacement(index), "SRRIP selected an invalid replacement candidate" );
+   return index;
+}
+
 void
 CacheSetSRRIP::updateReplacementIndex(UInt32 accessed_index)
 {
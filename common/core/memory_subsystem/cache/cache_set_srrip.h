@@ -4,7 +4,7 @@
 #include "cache_set.h"
 #include "cache_set_lru.h"
 
-class CacheSetSRRIP : public CacheSet
+class CacheSetSRRIP final : public CacheSet
 {
    public:
       CacheSetSRRIP(String cfgname, core_id_t core_id,
@@ -23,6 +23,8 @@ class CacheSetSRRIP : public CacheSet
       UInt8* m_rrip_bits;
       UInt8  m_replacement_pointer;
       CacheSetInfoLRU* m_set_info;
+
+      UInt32 getReplacementIndexMask();
 };
 
 #endif /* CACHE_SET_H */
@@ -5,16 +5,13 @@
 #include "cache_block_info.h"
 #include "mem_component.h"
 
+// Facade over CacheBlockInfo, its cached-location bits record which L1 caches hold the line
 class PrL2CacheBlockInfo : public CacheBlockInfo
 {
-   private:
-      UInt32 m_cached_loc_bitvec;
-
    public:
       PrL2CacheBlockInfo(IntPtr tag = ~0,
             CacheState::cstate_t cstate = CacheState::INVALID):
-         CacheBlockInfo(tag, cstate),
-         m_cached_loc_bitvec(0)
+         CacheBlockInfo(tag, cstate)
       {}
 
       ~PrL2CacheBlockInfo() {}
@@ -23,9 +20,6 @@ class PrL2CacheBlockInfo : public CacheBlockInfo
       void setCachedLoc(MemComponent::component_t cached_loc);
       void clearCachedLoc(MemComponent::component_t cached_loc);
 
-      UInt32 getCachedLocBitVec() { return m_cached_loc_bitvec; }
-
-      void invalidate();
-      void clone(CacheBlockInfo* cache_block_info);
+      UInt32 getCachedLocBitVec() { return getCachedLocBits(); }
 };
 #endif /* __PR_L2_CACHE_BLOCK_INFO_H__ */
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <map>
-#include <queue>
 
 #include "log.h"
 
@@ -12,14 +11,45 @@
 
 #ifndef ENABLE_CIRCULAR_QUEUE
 
+
+#include "flat_address_map.h"
+
+#include <vector>
+
+// Per-address FIFOs of pending requests. Addresses are looked up in a flat hash table, and the queues are
+// singly-linked lists of nodes recycled through a free list, so no memory is allocated once the
+// number of outstanding requests has reached its steady state.
+
 template <class T_Req> class ReqQueueListTemplate
 {
    private:
-      std::map<IntPtr, std::queue<T_Req*>* > m_req_queue_list;
+      struct Node
+      {
+         T_Req* req;
+         Node* next;
+      };
+      struct Queue
+      {
+         Node* head;
+         Node* tail;
+         UInt32 size;
+         Queue() : head(NULL), tail(NULL), size(0) {}
+      };
+      static const UInt32 NODES_PER_BLOCK = 64;
+
+      FlatAddressMap<Queue> m_req_queue_list;
+      Node* m_free_nodes;
+      std::vector<Node*> m_node_blocks;
+
+      Node* allocNode();
+      void freeNode(Node* node) { node->next = m_free_nodes; m_free_nodes = node; }
 
    public:
-      ReqQueueListTemplate() {};
-      ~ReqQueueListTemplate() {};
+      ReqQueueListTemplate(UInt32 expected_addresses = 16)
+         : m_req_queue_list(expected_addresses)
+         , m_free_nodes(NULL)
+      {}
+      ~ReqQueueListTemplate();
 
       void enqueue(IntPtr address, T_Req* shmem_req);
       T_Req* dequeue(IntPtr address);
@@ -30,28 +60,60 @@ template <class T_Req> class ReqQueueListTemplate
 };
 
 template <class T_Req>
-void
-ReqQueueListTemplate<T_Req>::enqueue(IntPtr address, T_Req* shmem_req)
+ReqQueueListTemplate<T_Req>::~ReqQueueListTemplate()
 {
-   if (m_req_queue_list.count(address) == 0)
+   for(typename std::vector<Node*>::iterator it = m_node_blocks.begin(); it != m_node_blocks.end(); ++it)
+      delete [] *it;
+}
+
+template <class T_Req>
+typename ReqQueueListTemplate<T_Req>::Node*
+ReqQueueListTemplate<T_Req>::allocNode()
+{
+   if (m_free_nodes == NULL)
    {
-      m_req_queue_list[address] = new std::queue<T_Req*>();
+      Node* block = new Node[NODES_PER_BLOCK];
+      m_node_blocks.push_back(block);
+      for(UInt32 i = 0; i < NODES_PER_BLOCK; ++i)
+         freeNode(&block[i]);
    }
-   m_req_queue_list[address]->push(shmem_req);
+   Node* node = m_free_nodes;
+   m_free_nodes = node->next;
+   return node;
+}
+
+template <class T_Req>
+void
+ReqQueueListTemplate<T_Req>::enqueue(IntPtr address, T_Req* shmem_req)
+{
+   Node* node = allocNode();
+   node->req = shmem_req;
+   node->next = NULL;
+
+   Queue &queue = m_req_queue_list[address];
+   if (queue.tail)
+      queue.tail->next = node;
+   else
+      queue.head = node;
+   queue.tail = node;
+   ++queue.size;
 }
 
 template <class T_Req>
 T_Req*
 ReqQueueListTemplate<T_Req>::dequeue(IntPtr address)
 {
-   LOG_ASSERT_ERROR(m_req_queue_list.count(address) != 0,
+   Queue* queue = m_req_queue_list.find(address);
+   LOG_ASSERT_ERROR(queue != NULL,
          "Could not find a request with address(0x%x)", address);
 
-   T_Req* shmem_req = m_req_queue_list[address]->front();
-   m_req_queue_list[address]->pop();
-   if (m_req_queue_list[address]->empty())
+   Node* node = queue->head;
+   T_Req* shmem_req = node->req;
+   queue->head = node->next;
+   --queue->size;
+   freeNode(node);
+   if (queue->head == NULL)
    {
-      delete m_req_queue_list[address];
       m_req_queue_list.erase(address);
    }
    return shmem_req;
@@ -61,40 +123,37 @@ template <class T_Req>
 T_Req*
 ReqQueueListTemplate<T_Req>::front(IntPtr address)
 {
-   LOG_ASSERT_ERROR(m_req_queue_list.count(address) != 0,
+   Queue* queue = m_req_queue_list.find(address);
+   LOG_ASSERT_ERROR(queue != NULL,
          "Could not find a request with address(0x%x)", address);
 
-   return m_req_queue_list[address]->front();
+   return queue->head->req;
 }
 
 template <class T_Req>
 T_Req*
 ReqQueueListTemplate<T_Req>::back(IntPtr address)
 {
-   LOG_ASSERT_ERROR(m_req_queue_list.count(address) != 0,
+   Queue* queue = m_req_queue_list.find(address);
+   LOG_ASSERT_ERROR(queue != NULL,
          "Could not find a request with address(0x%x)", address);
 
-   return m_req_queue_list[address]->back();
+   return queue->tail->req;
 }
 
 template <class T_Req>
 UInt32
 ReqQueueListTemplate<T_Req>::size(IntPtr address)
 {
-   if (m_req_queue_list.count(address) == 0)
-      return 0;
-   else
-      return m_req_queue_list[address]->size();
+   Queue* queue = m_req_queue_list.find(address);
+   return queue ? queue->size : 0;
 }
 
 template <class T_Req>
 bool
 ReqQueueListTemplate<T_Req>::empty(IntPtr address)
 {
-   if (m_req_queue_list.count(address) == 0)
-      return true;
-   else
-      return false;
+   return m_req_queue_list.find(address) == NULL;
 }
 
 
@@ -6,10 +6,11 @@
 PrevCacheIndex
 SharedCacheBlockInfo::getCachedLoc()
 {
-   LOG_ASSERT_ERROR(m_cached_locs.count() == 1, "m_cached_locs.count() == %u", m_cached_locs.count());
+   CacheSharersType cached_locs = getCachedLocs();
+   LOG_ASSERT_ERROR(cached_locs.count() == 1, "cached_locs.count() == %u", cached_locs.count());
 
-   for(PrevCacheIndex idx = 0; idx < m_cached_locs.size(); ++idx)
-      if (m_cached_locs.test(idx))
+   for(PrevCacheIndex idx = 0; idx < cached_locs.size(); ++idx)
+      if (cached_locs.test(idx))
          return idx;
    assert(false);
 }
@@ -17,36 +18,17 @@ SharedCacheBlockInfo::getCachedLoc()
 void
 SharedCacheBlockInfo::setCachedLoc(PrevCacheIndex idx)
 {
-   LOG_ASSERT_ERROR(m_cached_locs.test(idx) == false, "location %u already in set", idx);
+   LOG_ASSERT_ERROR(getCachedLocs().test(idx) == false, "location %u already in set", idx);
 
-   m_cached_locs.set(idx);
+   setCachedLocBits(getCachedLocBits() | (1 << idx));
 }
 
 void
 SharedCacheBlockInfo::clearCachedLoc(PrevCacheIndex idx)
 {
-   LOG_ASSERT_ERROR(m_cached_locs.test(idx) == true, "location %u not set", idx);
+   LOG_ASSERT_ERROR(getCachedLocs().test(idx) == true, "location %u not set", idx);
 
-   m_cached_locs.reset(idx);
+   setCachedLocBits(getCachedLocBits() & ~(1 << idx));
 }
 
 #endif
-
-void
-SharedCacheBlockInfo::invalidate()
-{
-   #ifdef ENABLE_TRACK_SHARING_PREVCACHES
-   for(PrevCacheIndex idx = 0; idx < m_cached_locs.size(); ++idx)
-      m_cached_locs.reset(idx);
-   #endif
-   CacheBlockInfo::invalidate();
-}
-
-void
-SharedCacheBlockInfo::clone(CacheBlockInfo* cache_block_info)
-{
-   #ifdef ENABLE_TRACK_SHARING_PREVCACHES
-   m_cached_locs = ((SharedCacheBlockInfo*) cache_block_info)->getCachedLocs();
-   #endif
-   CacheBlockInfo::clone(cache_block_info);
-}
@@ -8,13 +8,16 @@
 
 CheetahManager::CheetahStats *CheetahManager::s_cheetah_stats = NULL;
 std::vector<std::vector<CheetahModel*> > CheetahManager::s_cheetah_models(NUM_CHEETAH_TYPES);
+std::vector<std::vector<CheetahManager::CheetahWorker*> > CheetahManager::s_cheetah_model_workers(NUM_CHEETAH_TYPES);
+std::vector<CheetahManager::CheetahWorker*> CheetahManager::s_cheetah_workers;
+UInt32 CheetahManager::s_num_managers = 0;
 const char* CheetahManager::cheetah_names[] = { "local", "by-2", "by-4", "by-8", "global" };
 
 CheetahManager::CheetahManager(core_id_t core_id)
    : m_min_bits(Sim()->getCfg()->getInt("core/cheetah/min_size_bits"))
    , m_max_bits_local(Sim()->getCfg()->getInt("core/cheetah/max_size_bits_local"))
    , m_max_bits_global(Sim()->getCfg()->getInt("core/cheetah/max_size_bits_global"))
-   , m_address_buffer_size(0)
+   , m_address_buffer(new AddressBatch())
 {
    LOG_ASSERT_ERROR(m_min_bits >= CheetahModel::getMinSize(),
       "cheetah/min_size_bits (%d) must be >= %d",
@@ -27,34 +30,129 @@ CheetahManager::CheetahManager(core_id_t core_id)
       m_max_bits_global, CheetahModel::getMinSize());
 
    if (!s_cheetah_stats)
+   {
       s_cheetah_stats = new CheetahStats(m_min_bits, m_max_bits_local, m_max_bits_global);
 
-   s_cheetah_models[CHEETAH_LOCAL].push_back(new CheetahModel(false, m_min_bits, m_max_bits_local));
-   if ((core_id & 1) == 0) s_cheetah_models[CHEETAH_BY2].push_back(new CheetahModel(true, m_min_bits, m_max_bits_local));
-   if ((core_id & 3) == 0) s_cheetah_models[CHEETAH_BY4].push_back(new CheetahModel(true, m_min_bits, m_max_bits_local));
-   if ((core_id & 7) == 0) s_cheetah_models[CHEETAH_BY8].push_back(new CheetahModel(true, m_min_bits, m_max_bits_local));
-   if (core_id == 0)       s_cheetah_models[CHEETAH_GLOBAL].push_back(new CheetahModel(true, m_min_bits, m_max_bits_global));
-
-   m_cheetah[CHEETAH_LOCAL] = s_cheetah_models[CHEETAH_LOCAL].back();
-   m_cheetah[CHEETAH_BY2] = s_cheetah_models[CHEETAH_BY2].back();
-   m_cheetah[CHEETAH_BY4] = s_cheetah_models[CHEETAH_BY4].back();
-   m_cheetah[CHEETAH_BY8] = s_cheetah_models[CHEETAH_BY8].back();
-   m_cheetah[CHEETAH_GLOBAL] = s_cheetah_models[CHEETAH_GLOBAL].back();
+      UInt32 num_threads = Sim()->getCfg()->getInt("core/cheetah/threads");
+      for(UInt32 i = 0; i < num_threads; ++i)
+         s_cheetah_workers.push_back(new CheetahWorker());
+   }
+   ++s_num_managers;
+
+   addModel(CHEETAH_LOCAL, false, m_max_bits_local);
+   if ((core_id & 1) == 0) addModel(CHEETAH_BY2, true, m_max_bits_local);
+   if ((core_id & 3) == 0) addModel(CHEETAH_BY4, true, m_max_bits_local);
+   if ((core_id & 7) == 0) addModel(CHEETAH_BY8, true, m_max_bits_local);
+   if (core_id == 0)       addModel(CHEETAH_GLOBAL, true, m_max_bits_global);
+
+   for(unsigned int idx = 0; idx < NUM_CHEETAH_TYPES; ++idx)
+   {
+      m_cheetah[idx] = s_cheetah_models[idx].back();
+      m_worker[idx] = s_cheetah_model_workers[idx].back();
+   }
 }
 
 CheetahManager::~CheetahManager()
 {
+   delete m_address_buffer;
+
+   if (--s_num_managers == 0)
+   {
+      for(auto it = s_cheetah_workers.begin(); it != s_cheetah_workers.end(); ++it)
+         delete *it;
+      s_cheetah_workers.clear();
+   }
+}
+
+void CheetahManager::addModel(cheetah_types_t type, bool locked, UInt32 max_bits)
+{
+   s_cheetah_models[type].push_back(new CheetahModel(locked, m_min_bits, max_bits));
+
+   // Spread the models over the workers in creation order
+   UInt32 num_models = 0;
+   for(unsigned int idx = 0; idx < NUM_CHEETAH_TYPES; ++idx)
+      num_models += s_cheetah_models[idx].size();
+   s_cheetah_model_workers[type].push_back(s_cheetah_workers.empty() ? NULL : s_cheetah_workers[(num_models - 1) % s_cheetah_workers.size()]);
 }
 
 void CheetahManager::access(Core::mem_op_t mem_op_type, IntPtr address)
 {
-   m_address_buffer[m_address_buffer_size++] = address;
+   m_address_buffer->addresses[m_address_buffer->size++] = address;
+
+   if (m_address_buffer->size >= ADDRESS_BUFFER_SIZE)
+   {
+      if (s_cheetah_workers.empty())
+      {
+         for(unsigned int idx = 0; idx < NUM_CHEETAH_TYPES; ++idx)
+            m_cheetah[idx]->accesses(m_address_buffer->addresses, m_address_buffer->size);
+         m_address_buffer->size = 0;
+      }
+      else
+      {
+         m_address_buffer->refcount = NUM_CHEETAH_TYPES;
+         for(unsigned int idx = 0; idx < NUM_CHEETAH_TYPES; ++idx)
+            m_worker[idx]->push(m_cheetah[idx], m_address_buffer);
+         m_address_buffer = new AddressBatch();
+      }
+   }
+}
+
+void CheetahManager::flushWorkers()
+{
+   for(auto it = s_cheetah_workers.begin(); it != s_cheetah_workers.end(); ++it)
+      (*it)->flush();
+}
+
+CheetahManager::CheetahWorker::CheetahWorker()
+   : m_queue(QUEUE_SIZE)
+{
+   m_thread = _Thread::create(this);
+   m_thread->run();
+}
 
-   if (m_address_buffer_size >= ADDRESS_BUFFER_SIZE)
+CheetahManager::CheetahWorker::~CheetahWorker()
+{
+   Job job;
+   job.signal = true;
+   job.stop = true;
+   m_queue.push_wait(job);
+   m_done.wait();
+   delete m_thread;
+}
+
+void CheetahManager::CheetahWorker::push(CheetahModel *model, AddressBatch *batch)
+{
+   Job job;
+   job.model = model;
+   job.batch = batch;
+   m_queue.push_wait(job);
+}
+
+void CheetahManager::CheetahWorker::flush()
+{
+   Job job;
+   job.signal = true;
+   m_queue.push_wait(job);
+   m_done.wait();
+}
+
+void CheetahManager::CheetahWorker::run()
+{
+   while(true)
    {
-      for(unsigned int idx = 0; idx < NUM_CHEETAH_TYPES; ++idx)
-         m_cheetah[idx]->accesses(m_address_buffer, m_address_buffer_size);
-      m_address_buffer_size = 0;
+      Job job = m_queue.pop_wait();
+
+      if (job.batch)
+      {
+         job.model->accesses(job.batch->addresses, job.batch->size);
+         if (__sync_sub_and_fetch(&job.batch->refcount, 1) == 0)
+            delete job.batch;
+      }
+
+      if (job.signal)
+         m_done.signal();
+      if (job.stop)
+         break;
    }
 }
 
@@ -76,6 +174,9 @@ CheetahManager::CheetahStats::CheetahStats(UInt32 min_bits, UInt32 max_bits_loca
 
 void CheetahManager::CheetahStats::update()
 {
+   // Make sure all batches handed to the workers are included
+   flushWorkers();
+
    for(unsigned int idx = 0; idx < NUM_CHEETAH_TYPES; ++idx)
    {
       for(UInt32 size_bits = 0; size_bits < m_stats.size(); ++size_bits)
@@ -3,6 +3,9 @@
 
 #include "fixed_types.h"
 #include "core.h"
+#include "_thread.h"
+#include "sem.h"
+#include "mt_circular_queue.h"
 
 class CheetahModel;
 
@@ -34,17 +37,63 @@ class CheetahManager
          public:
             CheetahStats(UInt32 min_bits, UInt32 max_bits_local, UInt32 max_bits_global);
       };
+      static const UInt32 ADDRESS_BUFFER_SIZE = 256;
+
+      // A full buffer of addresses, freed by the last model that processes it
+      struct AddressBatch
+      {
+         AddressBatch() : size(0), refcount(0) {}
+         IntPtr addresses[ADDRESS_BUFFER_SIZE];
+         UInt32 size;
+         UInt32 refcount;
+      };
+
+      // With core/cheetah/threads > 0, each model is owned by one worker thread that processes its batches in order,
+      // so the simulation thread only hands over full buffers
+      class CheetahWorker : public Runnable
+      {
+         private:
+            struct Job
+            {
+               Job() : model(NULL), batch(NULL), signal(false), stop(false) {}
+               CheetahModel *model;
+               AddressBatch *batch;
+               bool signal;   // Signal m_done once all earlier jobs are processed
+               bool stop;
+            };
+            static const UInt32 QUEUE_SIZE = 1024;
+
+            MTCircularQueue<Job> m_queue;
+            Semaphore m_done;
+            _Thread *m_thread;
+
+            void run();
+
+         public:
+            CheetahWorker();
+            ~CheetahWorker();
+
+            void push(CheetahModel *model, AddressBatch *batch);
+            // Wait until all batches pushed so far have been processed
+            void flush();
+      };
+
       static CheetahStats *s_cheetah_stats;
       static std::vector<std::vector<CheetahModel*> > s_cheetah_models;
+      static std::vector<std::vector<CheetahWorker*> > s_cheetah_model_workers;
+      static std::vector<CheetahWorker*> s_cheetah_workers;
+      static UInt32 s_num_managers;
 
       const UInt32 m_min_bits;
       const UInt32 m_max_bits_local;
       const UInt32 m_max_bits_global;
       CheetahModel *m_cheetah[NUM_CHEETAH_TYPES];
+      CheetahWorker *m_worker[NUM_CHEETAH_TYPES];
 
-      static const UInt32 ADDRESS_BUFFER_SIZE = 256;
-      IntPtr m_address_buffer[ADDRESS_BUFFER_SIZE];
-      UInt32 m_address_buffer_size;
+      AddressBatch *m_address_buffer;
+
+      void addModel(cheetah_types_t type, bool locked, UInt32 max_bits);
+      static void flushWorkers();
 
    public:
       CheetahManager(core_id_t core_id);
@@ -1,6 +1,9 @@
 #ifndef COHERENCYPROTOCOL_H_
 #define COHERENCYPROTOCOL_H_
 
+#include "fixed_types.h"
+#include "log.h"
+
 class CoherencyProtocol
 {
    public:
@@ -8,8 +11,23 @@ class CoherencyProtocol
       {
          MSI,
          MESI,
-         MESIF
+         MESIF,
+         MOESI
       };
+
+      // Parse caching_protocol/variant
+      static type_t parse(String protocol)
+      {
+         if (protocol == "msi")
+            return MSI;
+         else if (protocol == "mesi")
+            return MESI;
+         else if (protocol == "mesif")
+            return MESIF;
+         else if (protocol == "moesi")
+            return MOESI;
+         LOG_PRINT_ERROR("Invalid coherency protocol %s, must be msi, mesi, mesif or moesi", protocol.c_str());
+      }
 };
 
 #endif /* COHERENCYPROTOCOL_H_ */
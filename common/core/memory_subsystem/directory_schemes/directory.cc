@@ -6,6 +6,7 @@
 #include "stats.h"
 #include "log.h"
 #include "config.hpp"
+#include "host_topology.h"
 
 Directory::Directory(core_id_t core_id, String directory_type_str, UInt32 num_entries, UInt32 max_hw_sharers, UInt32 max_num_sharers):
    m_num_entries(num_entries),
@@ -15,14 +16,10 @@ Directory::Directory(core_id_t core_id, String directory_type_str, UInt32 num_en
    m_max_num_sharers(max_num_sharers),
    m_limitless_software_trap_penalty(SubsecondTime::Zero())
 {
-   // Look at the type of directory and create
-   m_directory_entry_list = new DirectoryEntry*[m_num_entries];
+   // Look at the type of directory and create (zero-filled, so all entries start out NULL)
+   m_directory_entry_list = (DirectoryEntry**)Sim()->getHostTopology()->allocLarge(m_num_entries * sizeof(DirectoryEntry*));
 
    m_directory_type = parseDirectoryType(directory_type_str);
-   for (UInt32 i = 0; i < m_num_entries; i++)
-   {
-      m_directory_entry_list[i] = NULL;
-   }
 
    if (m_directory_type == LIMITLESS)
    {
@@ -37,6 +34,13 @@ Directory::Directory(core_id_t core_id, String directory_type_str, UInt32 num_en
    }
 
    registerStatsMetric("directory", core_id, "entries-allocated", &m_num_entries_allocated);
+   if (m_directory_type == SPARSE)
+   {
+      registerStatsMetric("directory", core_id, "sharers-overflows", &m_sparse_stats.overflows);
+      registerStatsMetric("directory", core_id, "entries-overflowed", &m_sparse_stats.overflowed_entries);
+      Sim()->getStatsManager()->registerMetric(new StatsMetricCallback("directory", core_id, "sharers-bytes", getSharerStorage, (UInt64)this));
+      Sim()->getStatsManager()->registerMetric(new StatsMetricCallback("directory", core_id, "sharers-bytes-full-map", getSharerStorage, (UInt64)this));
+   }
 }
 
 Directory::~Directory()
@@ -46,7 +50,7 @@ Directory::~Directory()
       if (m_directory_entry_list[i])
          delete m_directory_entry_list[i];
    }
-   delete [] m_directory_entry_list;
+   Sim()->getHostTopology()->freeLarge(m_directory_entry_list, m_num_entries * sizeof(DirectoryEntry*));
 }
 
 DirectoryEntry*
@@ -68,6 +72,23 @@ Directory::setDirectoryEntry(UInt32 entry_num, DirectoryEntry* directory_entry)
    m_directory_entry_list[entry_num] = directory_entry;
 }
 
+UInt64
+Directory::getSharerStorage(String objectName, UInt32 index, String metricName, UInt64 arg)
+{
+   // Bytes used to store sharers in all allocated entries, versus what the full_map bit vectors would use
+   Directory *directory = (Directory*)arg;
+   if (metricName == "sharers-bytes")
+      return directory->m_num_entries_allocated * DirectoryEntrySparse::NUM_POINTERS * sizeof(UInt16) + directory->m_sparse_stats.overflow_bytes;
+   else
+   {
+      // Sizes of the DirectorySharers classes chosen by createDirectoryEntry
+      UInt32 max_num_sharers = directory->m_max_num_sharers;
+      UInt64 bytes = max_num_sharers <= 64 ? 8 : max_num_sharers <= 128 ? 16 : max_num_sharers <= 256 ? 32 : max_num_sharers <= 1024 ? 128
+                   : (max_num_sharers + 63) / 64 * 8;
+      return directory->m_num_entries_allocated * bytes;
+   }
+}
+
 Directory::DirectoryType
 Directory::parseDirectoryType(String directory_type_str)
 {
@@ -77,6 +98,8 @@ Directory::parseDirectoryType(String directory_type_str)
       return LIMITED_NO_BROADCAST;
    else if (directory_type_str == "limitless")
       return LIMITLESS;
+   else if (directory_type_str == "sparse")
+      return SPARSE;
    else
    {
       LOG_PRINT_ERROR("Unsupported Directory Type: %s", directory_type_str.c_str());
@@ -87,6 +110,12 @@ Directory::parseDirectoryType(String directory_type_str)
 DirectoryEntry*
 Directory::createDirectoryEntry()
 {
+   if (m_directory_type == SPARSE)
+   {
+      m_use_max_hw_sharers = m_max_num_sharers;
+      return new DirectoryEntrySparse(m_max_num_sharers, &m_sparse_stats);
+   }
+
    // Specify the storage class to use for counting the directory sharers.
    // Due to alignment issues, the minimum size can already hold up to 64 nodes.
    if (m_max_num_sharers <= 64)
@@ -2,6 +2,7 @@
 #define __DIRECTORY_H__
 
 #include "directory_entry.h"
+#include "directory_entry_sparse.h"
 #include "fixed_types.h"
 #include "subsecond_time.h"
 
@@ -13,6 +14,7 @@ class Directory
          FULL_MAP = 0,
          LIMITED_NO_BROADCAST,
          LIMITLESS,
+         SPARSE,
          NUM_DIRECTORY_TYPES
       };
 
@@ -29,6 +31,10 @@ class Directory
 
       DirectoryEntry** m_directory_entry_list;
 
+      DirectoryEntrySparse::Stats m_sparse_stats;
+
+      static UInt64 getSharerStorage(String objectName, UInt32 index, String metricName, UInt64 arg);
+
    public:
       Directory(core_id_t core_id, String directory_type_str, UInt32 num_entries, UInt32 max_hw_sharers, UInt32 max_num_sharers);
       ~Directory();
@@ -0,0 +1,164 @@
+#include "directory_entry_sparse.h"
+#include "log.h"
+
+#include <algorithm>
+#include <string.h>
+
+DirectoryEntrySparse::DirectoryEntrySparse(UInt32 max_num_sharers, Stats *stats)
+   : DirectoryEntry()
+   , m_stats(stats)
+   , m_num_words(0)
+   , m_max_words((max_num_sharers + 63) / 64)
+   , m_num_sharers(0)
+{
+   LOG_ASSERT_ERROR(max_num_sharers <= 65536, "Sparse directory supports at most 65536 sharers, got %u", max_num_sharers);
+}
+
+DirectoryEntrySparse::~DirectoryEntrySparse()
+{
+   if (overflowed())
+   {
+      m_stats->overflowed_entries --;
+      m_stats->overflow_bytes -= m_num_words * sizeof(UInt64);
+      delete [] m_words;
+   }
+}
+
+void
+DirectoryEntrySparse::toBitVector()
+{
+   UInt64 *words = new UInt64[m_max_words];
+   memset(words, 0, m_max_words * sizeof(UInt64));
+   for(UInt32 i = 0; i < m_num_sharers; ++i)
+      words[m_pointers[i] / 64] |= 1ULL << (m_pointers[i] % 64);
+   m_words = words;
+   m_num_words = m_max_words;
+
+   m_stats->overflows ++;
+   m_stats->overflowed_entries ++;
+   m_stats->overflow_bytes += m_num_words * sizeof(UInt64);
+}
+
+void
+DirectoryEntrySparse::toPointers()
+{
+   UInt64 *words = m_words;
+   UInt32 n = 0;
+   for(UInt32 w = 0; w < m_num_words; ++w)
+      for(UInt64 bits = words[w]; bits; bits &= bits - 1)
+         m_pointers[n++] = w * 64 + __builtin_ctzll(bits);
+   assert(n == m_num_sharers);
+
+   m_stats->overflowed_entries --;
+   m_stats->overflow_bytes -= m_num_words * sizeof(UInt64);
+
+   m_num_words = 0;
+   delete [] words;
+}
+
+bool
+DirectoryEntrySparse::hasSharer(core_id_t sharer_id)
+{
+   if (overflowed())
+      return (m_words[sharer_id / 64] >> (sharer_id % 64)) & 1;
+
+   for(UInt32 i = 0; i < m_num_sharers; ++i)
+      if ((core_id_t) m_pointers[i] == sharer_id)
+         return true;
+   return false;
+}
+
+// Sharers are tracked exactly, so (like full_map) adding a sharer always succeeds
+bool
+DirectoryEntrySparse::addSharer(core_id_t sharer_id, UInt32 max_hw_sharers)
+{
+   assert(!hasSharer(sharer_id));
+
+   if (!overflowed() && m_num_sharers == NUM_POINTERS)
+      toBitVector();
+
+   if (overflowed())
+      m_words[sharer_id / 64] |= 1ULL << (sharer_id % 64);
+   else
+      m_pointers[m_num_sharers] = sharer_id;
+   m_num_sharers ++;
+   return true;
+}
+
+void
+DirectoryEntrySparse::removeSharer(core_id_t sharer_id, bool reply_expected)
+{
+   assert(!reply_expected);
+   assert(hasSharer(sharer_id));
+
+   m_num_sharers --;
+   if (overflowed())
+   {
+      m_words[sharer_id / 64] &= ~(1ULL << (sharer_id % 64));
+      // Some hysteresis to avoid reallocating when the number of sharers oscillates around NUM_POINTERS
+      if (m_num_sharers <= NUM_POINTERS / 2)
+         toPointers();
+   }
+   else
+   {
+      for(UInt32 i = 0; i < m_num_sharers; ++i)
+      {
+         if ((core_id_t) m_pointers[i] == sharer_id)
+         {
+            m_pointers[i] = m_pointers[m_num_sharers];
+            break;
+         }
+      }
+   }
+}
+
+core_id_t
+DirectoryEntrySparse::getOwner()
+{
+   return m_owner_id;
+}
+
+void
+DirectoryEntrySparse::setOwner(core_id_t owner_id)
+{
+   if (owner_id != INVALID_CORE_ID)
+      assert(hasSharer(owner_id));
+   m_owner_id = owner_id;
+}
+
+core_id_t
+DirectoryEntrySparse::getOneSharer()
+{
+   assert(m_num_sharers > 0);
+   if (!overflowed())
+      return m_pointers[0];
+
+   for(UInt32 w = 0; w < m_num_words; ++w)
+      if (m_words[w])
+         return w * 64 + __builtin_ctzll(m_words[w]);
+   assert(false);
+   return INVALID_CORE_ID;
+}
+
+std::pair<bool, std::vector<core_id_t> >
+DirectoryEntrySparse::getSharersList()
+{
+   std::pair<bool, std::vector<core_id_t> > sharers_list;
+   sharers_list.first = false;
+   sharers_list.second.reserve(m_num_sharers);
+
+   if (overflowed())
+   {
+      for(UInt32 w = 0; w < m_num_words; ++w)
+         for(UInt64 bits = m_words[w]; bits; bits &= bits - 1)
+            sharers_list.second.push_back(w * 64 + __builtin_ctzll(bits));
+   }
+   else
+   {
+      // Keep the ascending order of the bit vector encodings
+      sharers_list.second.assign(m_pointers, m_pointers + m_num_sharers);
+      std::sort(sharers_list.second.begin(), sharers_list.second.end());
+   }
+
+   return sharers_list;
+}
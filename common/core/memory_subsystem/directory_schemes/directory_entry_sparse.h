@@ -0,0 +1,59 @@
+#ifndef __DIRECTORY_ENTRY_SPARSE_H__
+#define __DIRECTORY_ENTRY_SPARSE_H__
+
+#include "directory_entry.h"
+
+// Directory entry with a compact, exact sharer encoding for large core counts.
+// Up to NUM_POINTERS sharers are stored as 16-bit core ids inside the entry itself, in the space also
+// used by the overflow pointer. A fifth sharer switches the entry to a bit vector of (max_num_sharers + 63) / 64
+// words, which is scanned with ctz, and the entry switches back to pointers once it is down to
+// NUM_POINTERS / 2 sharers. Most lines have only a few sharers, so most entries never allocate.
+// Sharer tracking stays exact (like full_map): the protocol counts invalidation replies per sharer.
+
+class DirectoryEntrySparse : public DirectoryEntry
+{
+   public:
+      static const UInt32 NUM_POINTERS = 4;
+
+      // Shared by all entries of a Directory, for its storage statistics
+      struct Stats
+      {
+         UInt64 overflows;          // Number of times an entry switched to a bit vector
+         UInt64 overflowed_entries; // Entries currently using a bit vector
+         UInt64 overflow_bytes;     // Bytes of bit vector storage currently allocated
+         Stats() : overflows(0), overflowed_entries(0), overflow_bytes(0) {}
+      };
+
+      DirectoryEntrySparse(UInt32 max_num_sharers, Stats *stats);
+      ~DirectoryEntrySparse();
+
+      bool hasSharer(core_id_t sharer_id);
+      bool addSharer(core_id_t sharer_id, UInt32 max_hw_sharers);
+      void removeSharer(core_id_t sharer_id, bool reply_expected);
+      UInt32 getNumSharers() { return m_num_sharers; }
+
+      core_id_t getOwner();
+      void setOwner(core_id_t owner_id);
+
+      core_id_t getOneSharer();
+      std::pair<bool, std::vector<core_id_t> > getSharersList();
+
+      SubsecondTime getLatency() { return SubsecondTime::Zero(); }
+
+   private:
+      Stats *m_stats;
+      UInt16 m_num_words;   // Bit vector size in words, 0 when using pointers
+      UInt16 m_max_words;
+      UInt32 m_num_sharers;
+      union
+      {
+         UInt16 m_pointers[NUM_POINTERS];
+         UInt64 *m_words;
+      };
+
+      bool overflowed() const { return m_num_words != 0; }
+      void toBitVector();
+      void toPointers();
+};
+
+#endif /* __DIRECTORY_ENTRY_SPARSE_H__ */
@@ -8,6 +8,12 @@
 #include "queue_model.h"
 #include "shmem_perf.h"
 #include "prefetcher.h"
+#include "dram_cache_tags.h"
+
+// Saturating set-dueling selector: above the midpoint, followers start DRAM accesses in parallel with the tag probe
+static const UInt32 PSEL_MAX = 1023;
+// One in every LEADER_SPACING sets is a serial leader, the next one a parallel leader
+static const UInt64 LEADER_SPACING = 32;
 
 DramCache::DramCache(MemoryManagerBase* memory_manager, ShmemPerfModel* shmem_perf_model, AddressHomeLookup* home_lookup, UInt32 cache_block_size, DramCntlrInterface *dram_cntlr)
    : DramCntlrInterface(memory_manager, shmem_perf_model, cache_block_size)
@@ -18,6 +24,14 @@ DramCache::DramCache(MemoryManagerBase* memory_manager, ShmemPerfModel* shmem_pe
    , m_data_array_bandwidth(8 * Sim()->getCfg()->getFloat("perf_model/dram/cache/bandwidth"))
    , m_home_lookup(home_lookup)
    , m_dram_cntlr(dram_cntlr)
+   , m_cache(NULL)
+   , m_tags(NULL)
+   , m_tag_cache(NULL)
+   , m_missmap(NULL)
+   , m_row_hit_time(SubsecondTime::Zero())
+   , m_tag_bytes(0)
+   , m_dueling(false)
+   , m_psel(PSEL_MAX / 2)
    , m_queue_model(NULL)
    , m_prefetcher(NULL)
    , m_prefetch_mshr("dram-cache.prefetch-mshr", m_core_id, 16)
@@ -27,25 +41,70 @@ DramCache::DramCache(MemoryManagerBase* memory_manager, ShmemPerfModel* shmem_pe
    , m_write_misses(0)
    , m_hits_prefetch(0)
    , m_prefetches(0)
+   , m_tag_cache_hits(0)
+   , m_tag_cache_misses(0)
+   , m_missmap_misses(0)
+   , m_missmap_evictions(0)
+   , m_parallel_accesses(0)
+   , m_wasted_dram_reads(0)
    , m_prefetch_mshr_delay(SubsecondTime::Zero())
 {
-   UInt32 cache_size = Sim()->getCfg()->getIntArray("perf_model/dram/cache/cache_size", m_core_id);
+   UInt64 cache_size = Sim()->getCfg()->getIntArray("perf_model/dram/cache/cache_size", m_core_id);
    UInt32 associativity = Sim()->getCfg()->getIntArray("perf_model/dram/cache/associativity", m_core_id);
-   UInt32 num_sets = k_KILO * cache_size / (associativity * m_cache_block_size);
-   LOG_ASSERT_ERROR(k_KILO * cache_size == num_sets * associativity * m_cache_block_size, "Invalid cache configuration: size(%d Kb) != sets(%d) * associativity(%d) * block_size(%d)", cache_size, num_sets, associativity, m_cache_block_size);
-
-   m_cache = new Cache("dram-cache",
-      "perf_model/dram/cache",
-      m_core_id,
-      num_sets,
-      associativity,
-      m_cache_block_size,
-      Sim()->getCfg()->getStringArray("perf_model/dram/cache/replacement_policy", m_core_id),
-      CacheBase::PR_L1_CACHE,
-      CacheBase::parseAddressHash(Sim()->getCfg()->getStringArray("perf_model/dram/cache/address_hash", m_core_id)),
-      NULL, /* FaultinjectionManager */
-      home_lookup
-   );
+   UInt64 num_sets = k_KILO * cache_size / (associativity * m_cache_block_size);
+   LOG_ASSERT_ERROR(k_KILO * cache_size == num_sets * associativity * m_cache_block_size, "Invalid cache configuration: size(%ld Kb) != sets(%ld) * associativity(%d) * block_size(%d)", cache_size, num_sets, associativity, m_cache_block_size);
+
+   String organization = Sim()->getCfg()->getStringArray("perf_model/dram/cache/organization", m_core_id);
+   if (organization == "sram")
+      m_organization = SRAM_TAGS;
+   else if (organization == "alloy")
+      m_organization = ALLOY;
+   else if (organization == "loh_hill")
+      m_organization = LOH_HILL;
+   else
+      LOG_PRINT_ERROR("Unknown DRAM cache organization %s", organization.c_str());
+
+   if (m_organization != SRAM_TAGS)
+   {
+      // Tags live in the DRAM cache itself, only the sets that are used get allocated in the simulator
+      LOG_ASSERT_ERROR(m_organization != ALLOY || associativity == 1, "The alloy DRAM cache organization is direct-mapped (associativity = 1)");
+      m_tags = new DramCacheTags(num_sets, associativity, m_cache_block_size);
+      // Alloy streams an 8-byte tag with each line, Loh-Hill reads the tags of all ways in whole blocks
+      m_tag_bytes = m_organization == ALLOY ? 8 : (8 * associativity + m_cache_block_size - 1) / m_cache_block_size * m_cache_block_size;
+      m_row_hit_time = SubsecondTime::NS(Sim()->getCfg()->getIntArray("perf_model/dram/cache/row_hit_time", m_core_id));
+      m_dueling = Sim()->getCfg()->getBoolArray("perf_model/dram/cache/dueling", m_core_id);
+
+      UInt32 tag_cache_entries = Sim()->getCfg()->getIntArray("perf_model/dram/cache/tag_cache/entries", m_core_id);
+      if (tag_cache_entries)
+         m_tag_cache = new DramCacheTagCache(tag_cache_entries, Sim()->getCfg()->getIntArray("perf_model/dram/cache/tag_cache/associativity", m_core_id));
+      if (Sim()->getCfg()->getBoolArray("perf_model/dram/cache/missmap/enabled", m_core_id))
+         m_missmap = new DramCacheMissMap(Sim()->getCfg()->getIntArray("perf_model/dram/cache/missmap/entries", m_core_id),
+                                          Sim()->getCfg()->getIntArray("perf_model/dram/cache/missmap/associativity", m_core_id),
+                                          Sim()->getCfg()->getIntArray("perf_model/dram/cache/missmap/segment_size", m_core_id),
+                                          m_cache_block_size);
+
+      registerStatsMetric("dram-cache", m_core_id, "tag-cache-hits", &m_tag_cache_hits);
+      registerStatsMetric("dram-cache", m_core_id, "tag-cache-misses", &m_tag_cache_misses);
+      registerStatsMetric("dram-cache", m_core_id, "missmap-misses", &m_missmap_misses);
+      registerStatsMetric("dram-cache", m_core_id, "missmap-evictions", &m_missmap_evictions);
+      registerStatsMetric("dram-cache", m_core_id, "parallel-accesses", &m_parallel_accesses);
+      registerStatsMetric("dram-cache", m_core_id, "wasted-dram-reads", &m_wasted_dram_reads);
+   }
+   else
+   {
+      m_cache = new Cache("dram-cache",
+         "perf_model/dram/cache",
+         m_core_id,
+         num_sets,
+         associativity,
+         m_cache_block_size,
+         Sim()->getCfg()->getStringArray("perf_model/dram/cache/replacement_policy", m_core_id),
+         CacheBase::PR_L1_CACHE,
+         CacheBase::parseAddressHash(Sim()->getCfg()->getStringArray("perf_model/dram/cache/address_hash", m_core_id)),
+         NULL, /* FaultinjectionManager */
+         home_lookup
+      );
+   }
 
    if (Sim()->getCfg()->getBool("perf_model/dram/cache/queue_model/enabled"))
    {
@@ -67,7 +126,14 @@ DramCache::DramCache(MemoryManagerBase* memory_manager, ShmemPerfModel* shmem_pe
 
 DramCache::~DramCache()
 {
-   delete m_cache;
+   if (m_cache)
+      delete m_cache;
+   if (m_tags)
+      delete m_tags;
+   if (m_tag_cache)
+      delete m_tag_cache;
+   if (m_missmap)
+      delete m_missmap;
    if (m_queue_model)
       delete m_queue_model;
 }
@@ -99,6 +165,9 @@ DramCache::putDataToDram(IntPtr address, core_id_t requester, Byte* data_buf, Su
 std::pair<bool, SubsecondTime>
 DramCache::doAccess(Cache::access_t access, IntPtr address, core_id_t requester, Byte* data_buf, SubsecondTime now, ShmemPerf *perf)
 {
+   if (m_tags)
+      return doAccessTagsInDram(access, address, requester, data_buf, now, perf);
+
    PrL1CacheBlockInfo* block_info = (PrL1CacheBlockInfo*)m_cache->peekSingleLine(address);
    SubsecondTime latency = m_tags_access_time;
    perf->updateTime(now);
@@ -152,9 +221,174 @@ DramCache::doAccess(Cache::access_t access, IntPtr address, core_id_t requester,
    return std::pair<bool, SubsecondTime>(block_info ? true : false, latency);
 }
 
+std::pair<bool, SubsecondTime>
+DramCache::doAccessTagsInDram(Cache::access_t access, IntPtr address, core_id_t requester, Byte* data_buf, SubsecondTime now, ShmemPerf *perf)
+{
+   UInt64 set_index = m_tags->getSetIndex(address);
+   DramCacheTags::Line *line = m_tags->find(address, true);
+   bool cache_hit = line != NULL, prefetch_hit = false;
+   SubsecondTime latency = SubsecondTime::Zero();
+   if (perf)
+      perf->updateTime(now);
+
+   // Can on-chip structures tell hit from miss, without reading the tags from the DRAM cache?
+   bool known = false;
+   if (m_missmap)
+   {
+      // Precise, a predicted miss goes to DRAM straight away
+      latency += m_tags_access_time;
+      known = true;
+      if (!m_missmap->isPresent(address))
+         ++m_missmap_misses;
+   }
+   else if (m_tag_cache)
+   {
+      latency += m_tags_access_time;
+      known = m_tag_cache->access(set_index);
+      if (known)
+         ++m_tag_cache_hits;
+      else
+         ++m_tag_cache_misses;
+   }
+   if (perf)
+      perf->updateTime(now + latency, ShmemPerf::DRAM_CACHE_TAGS);
+
+   // Reading the tags from the DRAM cache: Alloy gets the data with them, Loh-Hill reads the set's tag blocks
+   UInt32 probe_bytes = m_organization == ALLOY ? m_cache_block_size + m_tag_bytes : m_tag_bytes;
+   bool parallel = false;
+
+   if (cache_hit)
+   {
+      if (line->prefetch)
+      {
+         // This line was fetched by the prefetcher and has proven useful
+         m_hits_prefetch++;
+         prefetch_hit = true;
+         line->prefetch = false;
+
+         // If prefetch is still in progress: delay
+         SubsecondTime t_completed = m_prefetch_mshr.getTagCompletionTime(address);
+         if (t_completed != SubsecondTime::MaxTime() && t_completed > now + latency)
+         {
+            m_prefetch_mshr_delay += t_completed - (now + latency);
+            latency = t_completed - now;
+         }
+      }
+
+      if (known || m_organization == ALLOY)
+      {
+         latency += accessDataArray(access, requester, now + latency, perf, m_organization == ALLOY ? probe_bytes : m_cache_block_size, m_data_access_time);
+      }
+      else
+      {
+         latency += accessDataArray(Cache::LOAD, requester, now + latency, perf, probe_bytes, m_data_access_time);
+         // The data is in the row that was just opened for the tags
+         latency += accessDataArray(access, requester, now + latency, perf, m_cache_block_size, m_row_hit_time);
+      }
+
+      if (!known && access == Cache::LOAD && useParallelAccess(set_index, true))
+      {
+         // The DRAM access started next to the probe turned out to be useless, it still takes bandwidth
+         Byte dram_buf[m_cache_block_size];
+         m_dram_cntlr->getDataFromDram(address, requester, dram_buf, now, NULL);
+         ++m_wasted_dram_reads;
+      }
+
+      if (access == Cache::STORE)
+         line->dirty = true;
+   }
+   else
+   {
+      if (access == Cache::LOAD)
+      {
+         SubsecondTime probe_latency = SubsecondTime::Zero();
+         if (!known)
+         {
+            parallel = useParallelAccess(set_index, false);
+            probe_latency = accessDataArray(Cache::LOAD, requester, now + latency, parallel ? NULL : perf, probe_bytes, m_data_access_time);
+         }
+
+         SubsecondTime dram_latency;
+         HitWhere::where_t hit_where;
+         if (parallel)
+         {
+            ++m_parallel_accesses;
+            boost::tie(dram_latency, hit_where) = m_dram_cntlr->getDataFromDram(address, requester, data_buf, now + latency, perf);
+            latency += std::max(probe_latency, dram_latency);
+         }
+         else
+         {
+            boost::tie(dram_latency, hit_where) = m_dram_cntlr->getDataFromDram(address, requester, data_buf, now + latency + probe_latency, perf);
+            latency += probe_latency + dram_latency;
+         }
+      }
+         // For STOREs, we only do complete cache lines so we don't need to read from DRAM
+
+      insertLine(access, address, requester, data_buf, now + latency);
+   }
+
+   if (m_prefetcher)
+      callPrefetcher(address, cache_hit, prefetch_hit, now + latency);
+
+   return std::pair<bool, SubsecondTime>(cache_hit, latency);
+}
+
+bool
+DramCache::useParallelAccess(UInt64 set_index, bool hit)
+{
+   if (!m_dueling)
+      return false;
+
+   switch(set_index % LEADER_SPACING)
+   {
+      case 0:
+         // Serial leader: a miss paid for the tag probe before the DRAM access
+         if (!hit && m_psel < PSEL_MAX)
+            ++m_psel;
+         return false;
+      case 1:
+         // Parallel leader: a hit made the DRAM access useless
+         if (hit && m_psel > 0)
+            --m_psel;
+         return true;
+      default:
+         return m_psel > PSEL_MAX / 2;
+   }
+}
+
 void
 DramCache::insertLine(Cache::access_t access, IntPtr address, core_id_t requester, Byte* data_buf, SubsecondTime now)
 {
+   if (m_tags)
+   {
+      IntPtr evict_address;
+      bool evict_dirty;
+      if (m_tags->insert(address, access == Cache::STORE, &evict_address, &evict_dirty))
+      {
+         if (m_missmap)
+            m_missmap->remove(evict_address);
+         if (evict_dirty)
+            m_dram_cntlr->putDataToDram(evict_address, requester, data_buf, now);
+      }
+
+      if (m_missmap)
+      {
+         // Lines of a segment that lost its MissMap entry can no longer be found, so they have to go
+         std::vector<IntPtr> victims;
+         m_missmap->insert(address, victims);
+         for(std::vector<IntPtr>::iterator it = victims.begin(); it != victims.end(); ++it)
+         {
+            bool dirty;
+            if (m_tags->invalidate(*it, &dirty))
+               evictLine(*it, dirty, requester, now);
+         }
+      }
+
+      // Write to data array off-line, so don't affect return latency
+      accessDataArray(Cache::STORE, requester, now, NULL, m_organization == ALLOY ? m_cache_block_size + m_tag_bytes : m_cache_block_size, m_data_access_time);
+      return;
+   }
+
    bool eviction;
    IntPtr evict_address;
    PrL1CacheBlockInfo evict_block_info;
@@ -175,10 +409,22 @@ DramCache::insertLine(Cache::access_t access, IntPtr address, core_id_t requeste
    }
 }
 
+void
+DramCache::evictLine(IntPtr address, bool dirty, core_id_t requester, SubsecondTime now)
+{
+   ++m_missmap_evictions;
+   // Writeback to DRAM done off-line, so don't affect return latency
+   if (dirty)
+   {
+      Byte data_buf[m_cache_block_size];
+      m_dram_cntlr->putDataToDram(address, requester, data_buf, now);
+   }
+}
+
 SubsecondTime
-DramCache::accessDataArray(Cache::access_t access, core_id_t requester, SubsecondTime t_start, ShmemPerf *perf)
+DramCache::accessDataArray(Cache::access_t access, core_id_t requester, SubsecondTime t_start, ShmemPerf *perf, UInt32 bytes, SubsecondTime access_time)
 {
-   SubsecondTime processing_time = m_data_array_bandwidth.getRoundedLatency(8 * m_cache_block_size); // bytes to bits
+   SubsecondTime processing_time = m_data_array_bandwidth.getRoundedLatency(8 * bytes); // bytes to bits
 
    // Compute Queue Delay
    SubsecondTime queue_delay;
@@ -191,27 +437,32 @@ DramCache::accessDataArray(Cache::access_t access, core_id_t requester, Subsecon
       queue_delay = SubsecondTime::Zero();
    }
 
-   perf->updateTime(t_start);
-   perf->updateTime(t_start + queue_delay, ShmemPerf::DRAM_CACHE_QUEUE);
-   perf->updateTime(t_start + queue_delay + processing_time, ShmemPerf::DRAM_CACHE_BUS);
-   perf->updateTime(t_start + queue_delay + processing_time + m_data_access_time, ShmemPerf::DRAM_CACHE_DATA);
+   if (perf)
+   {
+      perf->updateTime(t_start);
+      perf->updateTime(t_start + queue_delay, ShmemPerf::DRAM_CACHE_QUEUE);
+      perf->updateTime(t_start + queue_delay + processing_time, ShmemPerf::DRAM_CACHE_BUS);
+      perf->updateTime(t_start + queue_delay + processing_time + access_time, ShmemPerf::DRAM_CACHE_DATA);
+   }
 
-   return queue_delay + processing_time + m_data_access_time;
+   return queue_delay + processing_time + access_time;
 }
 
 void
 DramCache::callPrefetcher(IntPtr train_address, bool cache_hit, bool prefetch_hit, SubsecondTime t_issue)
 {
    // Always train the prefetcher
-   std::vector<IntPtr> prefetchList = m_prefetcher->getNextAddress(train_address, INVALID_CORE_ID);
+   IntPtr prefetchList[Prefetcher::MAX_PREFETCHES];
+   Prefetcher::Access access = { train_address, 0, INVALID_CORE_ID };
+   UInt32 numPrefetches = m_prefetcher->getNextAddresses(access, prefetchList, Prefetcher::MAX_PREFETCHES);
 
    // Only do prefetches on misses, or on hits to lines previously brought in by the prefetcher (if enabled)
    if (!cache_hit || (m_prefetch_on_prefetch_hit && prefetch_hit))
    {
-      for(std::vector<IntPtr>::iterator it = prefetchList.begin(); it != prefetchList.end(); ++it)
+      for(UInt32 i = 0; i < numPrefetches; ++i)
       {
-         IntPtr prefetch_address = *it;
-         if (!m_cache->peekSingleLine(prefetch_address))
+         IntPtr prefetch_address = prefetchList[i];
+         if (!isCached(prefetch_address))
          {
             // Get data from DRAM
             SubsecondTime dram_latency;
@@ -221,8 +472,7 @@ DramCache::callPrefetcher(IntPtr train_address, bool cache_hit, bool prefetch_hi
             // Insert into data array
             insertLine(Cache::LOAD, prefetch_address, m_core_id, data_buf, t_issue + dram_latency);
             // Set prefetched bit
-            PrL1CacheBlockInfo* block_info = (PrL1CacheBlockInfo*)m_cache->peekSingleLine(prefetch_address);
-            block_info->setOption(CacheBlockInfo::PREFETCH);
+            setPrefetched(prefetch_address);
             // Update completion time
             m_prefetch_mshr.getCompletionTime(t_issue, dram_latency, prefetch_address);
 
@@ -231,3 +481,27 @@ DramCache::callPrefetcher(IntPtr train_address, bool cache_hit, bool prefetch_hi
       }
    }
 }
+
+bool
+DramCache::isCached(IntPtr address)
+{
+   if (m_tags)
+      return m_tags->find(address, false) != NULL;
+   else
+      return m_cache->peekSingleLine(address) != NULL;
+}
+
+void
+DramCache::setPrefetched(IntPtr address)
+{
+   if (m_tags)
+   {
+      DramCacheTags::Line *line = m_tags->find(address, false);
+      if (line)
+         line->prefetch = true;
+   }
+   else
+   {
+      m_cache->peekSingleLine(address)->setOption(CacheBlockInfo::PREFETCH);
+   }
+}
@@ -8,6 +8,9 @@
 
 class QueueModel;
 class Prefetcher;
+class DramCacheTags;
+class DramCacheTagCache;
+class DramCacheMissMap;
 
 class DramCache : public DramCntlrInterface
 {
@@ -19,7 +22,15 @@ class DramCache : public DramCntlrInterface
       virtual boost::tuple<SubsecondTime, HitWhere::where_t> putDataToDram(IntPtr address, core_id_t requester, Byte* data_buf, SubsecondTime now);
 
    private:
+      enum organization_t
+      {
+         SRAM_TAGS,     // Full Cache, tags looked up on-chip in tags_access_time
+         ALLOY,         // Direct-mapped, tag and data read together from the DRAM cache in one burst
+         LOH_HILL,      // Set-associative, tags read from the DRAM cache row before the data (an open-row hit)
+      };
+
       core_id_t m_core_id;
+      organization_t m_organization;
       UInt32 m_cache_block_size;
       SubsecondTime m_data_access_time;
       SubsecondTime m_tags_access_time;
@@ -28,6 +39,16 @@ class DramCache : public DramCntlrInterface
       AddressHomeLookup* m_home_lookup;
       DramCntlrInterface* m_dram_cntlr;
       Cache* m_cache;
+      // Tags-in-DRAM organizations
+      DramCacheTags* m_tags;
+      DramCacheTagCache* m_tag_cache;
+      DramCacheMissMap* m_missmap;
+      SubsecondTime m_row_hit_time;
+      UInt32 m_tag_bytes;
+      // Set dueling between probing the DRAM cache tags before going to DRAM (serial leaders) and starting the DRAM
+      // access in parallel (parallel leaders), for accesses the tag cache or MissMap can't decide
+      bool m_dueling;
+      UInt32 m_psel;
       QueueModel* m_queue_model;
       Prefetcher* m_prefetcher;
       bool m_prefetch_on_prefetch_hit;
@@ -36,11 +57,20 @@ class DramCache : public DramCntlrInterface
       UInt64 m_reads, m_writes;
       UInt64 m_read_misses, m_write_misses;
       UInt64 m_hits_prefetch, m_prefetches;
+      UInt64 m_tag_cache_hits, m_tag_cache_misses, m_missmap_misses, m_missmap_evictions;
+      UInt64 m_parallel_accesses, m_wasted_dram_reads;
       SubsecondTime m_prefetch_mshr_delay;
 
       std::pair<bool, SubsecondTime> doAccess(Cache::access_t access, IntPtr address, core_id_t requester, Byte* data_buf, SubsecondTime now, ShmemPerf *perf);
+      std::pair<bool, SubsecondTime> doAccessTagsInDram(Cache::access_t access, IntPtr address, core_id_t requester, Byte* data_buf, SubsecondTime now, ShmemPerf *perf);
       void insertLine(Cache::access_t access, IntPtr address, core_id_t requester, Byte* data_buf, SubsecondTime now);
-      SubsecondTime accessDataArray(Cache::access_t access, core_id_t requester, SubsecondTime t_start, ShmemPerf *perf);
+      void evictLine(IntPtr address, bool dirty, core_id_t requester, SubsecondTime now);
+      SubsecondTime accessDataArray(Cache::access_t access, core_id_t requester, SubsecondTime t_start, ShmemPerf *perf)
+         { return accessDataArray(access, requester, t_start, perf, m_cache_block_size, m_data_access_time); }
+      SubsecondTime accessDataArray(Cache::access_t access, core_id_t requester, SubsecondTime t_start, ShmemPerf *perf, UInt32 bytes, SubsecondTime access_time);
+      bool isCached(IntPtr address);
+      void setPrefetched(IntPtr address);
+      bool useParallelAccess(UInt64 set_index, bool hit);
       void callPrefetcher(IntPtr address, bool cache_hit, bool prefetch_hit, SubsecondTime t_issue);
 };
 
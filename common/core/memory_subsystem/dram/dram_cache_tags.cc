@@ -0,0 +1,182 @@
+#include "dram_cache_tags.h"
+#include "log.h"
+
+static const IntPtr INVALID_SEGMENT = ~IntPtr(0);
+
+DramCacheTags::DramCacheTags(UInt64 num_sets, UInt32 associativity, UInt32 cache_block_size)
+   : m_num_sets(num_sets)
+   , m_associativity(associativity)
+   , m_cache_block_size(cache_block_size)
+   , m_lru_max(0)
+{
+   LOG_ASSERT_ERROR(num_sets > 0 && associativity > 0, "Invalid DRAM cache configuration");
+}
+
+DramCacheTags::Line*
+DramCacheTags::find(IntPtr address, bool update_replacement)
+{
+   auto it = m_sets.find(getSetIndex(address));
+   if (it == m_sets.end())
+      return NULL;
+
+   IntPtr line = address / m_cache_block_size;
+   for(auto way = it->second.begin(); way != it->second.end(); ++way)
+   {
+      if (way->line == line)
+      {
+         if (update_replacement)
+            way->lru = ++m_lru_max;
+         return &*way;
+      }
+   }
+   return NULL;
+}
+
+bool
+DramCacheTags::insert(IntPtr address, bool dirty, IntPtr *evict_address, bool *evict_dirty)
+{
+   std::vector<Line> &set = m_sets[getSetIndex(address)];
+   Line fill = { address / m_cache_block_size, ++m_lru_max, dirty, false };
+
+   if (set.size() < m_associativity)
+   {
+      if (set.empty())
+         set.reserve(m_associativity);
+      set.push_back(fill);
+      return false;
+   }
+
+   Line *victim = &set[0];
+   for(auto way = set.begin(); way != set.end(); ++way)
+      if (way->lru < victim->lru)
+         victim = &*way;
+
+   *evict_address = victim->line * m_cache_block_size;
+   *evict_dirty = victim->dirty;
+   *victim = fill;
+   return true;
+}
+
+bool
+DramCacheTags::invalidate(IntPtr address, bool *dirty)
+{
+   auto it = m_sets.find(getSetIndex(address));
+   if (it == m_sets.end())
+      return false;
+
+   IntPtr line = address / m_cache_block_size;
+   for(auto way = it->second.begin(); way != it->second.end(); ++way)
+   {
+      if (way->line == line)
+      {
+         *dirty = way->dirty;
+         *way = it->second.back();
+         it->second.pop_back();
+         return true;
+      }
+   }
+   return false;
+}
+
+DramCacheTagCache::DramCacheTagCache(UInt32 num_entries, UInt32 associativity)
+   : m_num_sets(num_entries / associativity)
+   , m_associativity(associativity)
+   , m_tags(num_entries, ~UInt64(0))
+   , m_lru(num_entries, 0)
+   , m_lru_max(0)
+{
+   LOG_ASSERT_ERROR(m_num_sets > 0 && m_num_sets * associativity == num_entries,
+                    "DRAM cache tag cache entries (%d) must be a multiple of its associativity (%d)", num_entries, associativity);
+}
+
+bool
+DramCacheTagCache::access(UInt64 set_index)
+{
+   UInt32 base = (set_index % m_num_sets) * m_associativity;
+   UInt32 victim = base;
+   for(UInt32 idx = base; idx < base + m_associativity; ++idx)
+   {
+      if (m_tags[idx] == set_index)
+      {
+         m_lru[idx] = ++m_lru_max;
+         return true;
+      }
+      if (m_lru[idx] < m_lru[victim])
+         victim = idx;
+   }
+   m_tags[victim] = set_index;
+   m_lru[victim] = ++m_lru_max;
+   return false;
+}
+
+DramCacheMissMap::DramCacheMissMap(UInt32 num_entries, UInt32 associativity, UInt32 segment_size, UInt32 cache_block_size)
+   : m_num_sets(num_entries / associativity)
+   , m_associativity(associativity)
+   , m_segment_size(segment_size)
+   , m_cache_block_size(cache_block_size)
+   , m_entries(num_entries)
+   , m_lru_max(0)
+{
+   LOG_ASSERT_ERROR(m_num_sets > 0 && m_num_sets * associativity == num_entries,
+                    "MissMap entries (%d) must be a multiple of its associativity (%d)", num_entries, associativity);
+   LOG_ASSERT_ERROR(segment_size % cache_block_size == 0 && segment_size / cache_block_size <= 64,
+                    "MissMap segments must hold a whole number of lines, at most 64");
+   for(auto it = m_entries.begin(); it != m_entries.end(); ++it)
+   {
+      it->segment = INVALID_SEGMENT;
+      it->present = 0;
+      it->lru = 0;
+   }
+}
+
+DramCacheMissMap::Entry*
+DramCacheMissMap::find(IntPtr segment)
+{
+   Entry *set = &m_entries[(segment % m_num_sets) * m_associativity];
+   for(UInt32 way = 0; way < m_associativity; ++way)
+      if (set[way].segment == segment)
+         return &set[way];
+   return NULL;
+}
+
+bool
+DramCacheMissMap::isPresent(IntPtr address)
+{
+   Entry *entry = find(address / m_segment_size);
+   if (!entry)
+      return false;
+   entry->lru = ++m_lru_max;
+   return entry->present & (UInt64(1) << ((address % m_segment_size) / m_cache_block_size));
+}
+
+void
+DramCacheMissMap::insert(IntPtr address, std::vector<IntPtr> &victims)
+{
+   IntPtr segment = address / m_segment_size;
+   Entry *entry = find(segment);
+   if (!entry)
+   {
+      Entry *set = &m_entries[(segment % m_num_sets) * m_associativity];
+      entry = &set[0];
+      for(UInt32 way = 1; way < m_associativity; ++way)
+         if (set[way].lru < entry->lru)
+            entry = &set[way];
+
+      for(UInt32 idx = 0; entry->present; ++idx, entry->present >>= 1)
+         if (entry->present & 1)
+            victims.push_back(entry->segment * m_segment_size + idx * m_cache_block_size);
+
+      entry->segment = segment;
+      entry->present = 0;
+   }
+   entry->present |= UInt64(1) << ((address % m_segment_size) / m_cache_block_size);
+   entry->lru = ++m_lru_max;
+}
+
+void
+DramCacheMissMap::remove(IntPtr address)
+{
+   Entry *entry = find(address / m_segment_size);
+   if (entry)
+      entry->present &= ~(UInt64(1) << ((address % m_segment_size) / m_cache_block_size));
+}
@@ -0,0 +1,92 @@
+#ifndef __DRAM_CACHE_TAGS
+#define __DRAM_CACHE_TAGS
+
+#include "fixed_types.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Tag store for large DRAM caches: sets are only allocated once they are touched, so a multi-GB cache costs host
+// memory in proportion to its footprint rather than to its capacity. Full line addresses are kept as tags.
+class DramCacheTags
+{
+   public:
+      struct Line
+      {
+         IntPtr line;      // Line address (address / block size)
+         UInt64 lru;
+         bool dirty;
+         bool prefetch;
+      };
+
+      DramCacheTags(UInt64 num_sets, UInt32 associativity, UInt32 cache_block_size);
+
+      UInt64 getSetIndex(IntPtr address) const { return (address / m_cache_block_size) % m_num_sets; }
+      UInt64 getNumAllocatedSets() const { return m_sets.size(); }
+
+      // Returns NULL when not present, update_replacement marks the line as most recently used
+      Line* find(IntPtr address, bool update_replacement);
+      // Returns true if a line had to be evicted, which is described by evict_address and evict_dirty
+      bool insert(IntPtr address, bool dirty, IntPtr *evict_address, bool *evict_dirty);
+      // Returns true if the line was present, dirty tells whether it has to be written back
+      bool invalidate(IntPtr address, bool *dirty);
+
+   private:
+      const UInt64 m_num_sets;
+      const UInt32 m_associativity;
+      const UInt32 m_cache_block_size;
+      UInt64 m_lru_max;
+      // Lines of a set, in no particular order, only as many as have ever been filled
+      std::unordered_map<UInt64, std::vector<Line> > m_sets;
+};
+
+// On-chip SRAM cache of recently used tag sets: when the tags of a set are here, hit or miss is known without reading
+// the tags from the DRAM cache
+class DramCacheTagCache
+{
+   public:
+      DramCacheTagCache(UInt32 num_entries, UInt32 associativity);
+
+      // Returns whether set_index was cached, and caches it
+      bool access(UInt64 set_index);
+
+   private:
+      const UInt32 m_num_sets;
+      const UInt32 m_associativity;
+      std::vector<UInt64> m_tags;
+      std::vector<UInt64> m_lru;
+      UInt64 m_lru_max;
+};
+
+// MissMap (Loh and Hill, MICRO 2011): precise on-chip record of the lines present in the DRAM cache, one bit vector
+// per memory segment. A line can only be cached while its segment is tracked, evicting a segment's entry evicts its
+// lines from the DRAM cache.
+class DramCacheMissMap
+{
+   public:
+      DramCacheMissMap(UInt32 num_entries, UInt32 associativity, UInt32 segment_size, UInt32 cache_block_size);
+
+      bool isPresent(IntPtr address);
+      // Marks the line as present, addresses of lines that lost their entry are appended to victims
+      void insert(IntPtr address, std::vector<IntPtr> &victims);
+      void remove(IntPtr address);
+
+   private:
+      struct Entry
+      {
+         IntPtr segment;
+         UInt64 present;
+         UInt64 lru;
+      };
+
+      const UInt32 m_num_sets;
+      const UInt32 m_associativity;
+      const UInt32 m_segment_size;
+      const UInt32 m_cache_block_size;
+      std::vector<Entry> m_entries;
+      UInt64 m_lru_max;
+
+      Entry* find(IntPtr segment);
+};
+
+#endif // __DRAM_CACHE_TAGS
@@ -0,0 +1,279 @@
+#ifndef __FAST_HIERARCHY_CACHE_H
+#define __FAST_HIERARCHY_CACHE_H
+
+#include "memory_manager.h"
+#include "stats.h"
+#include "lock.h"
+#include "log.h"
+#include "utils.h"
+
+namespace FastHierarchy
+{
+   class Dram : public CacheBase
+   {
+      private:
+         const SubsecondTime m_latency;
+         UInt64 m_reads, m_writes;
+      public:
+         Dram(Core *core, String name, SubsecondTime latency)
+            : m_latency(latency)
+         {
+            m_reads = m_writes = 0;
+            registerStatsMetric(name, core->getId(), "reads", &m_reads);
+            registerStatsMetric(name, core->getId(), "writes", &m_writes);
+         }
+         SubsecondTime access(Core::mem_op_t mem_op_type, IntPtr tag)
+         {
+            // Shared by all cores without a lock, the counters are approximate
+            if (mem_op_type == Core::WRITE)
+               ++m_writes;
+            else
+               ++m_reads;
+            return m_latency;
+         }
+   };
+
+   template <UInt32 assoc>
+   class CacheSet
+   {
+      private:
+         IntPtr m_tags[assoc];
+         UInt64 m_lru[assoc];
+         UInt64 m_lru_max;
+      public:
+         CacheSet()
+            : m_lru_max(0)
+         {
+            for(unsigned int idx = 0; idx < assoc; ++idx)
+            {
+               m_tags[idx] = INVALID_TAG;
+               m_lru[idx] = 0;
+            }
+         }
+         bool find(IntPtr tag)
+         {
+            for(unsigned int idx = 0; idx < assoc; ++idx)
+            {
+               if (m_tags[idx] == tag)
+               {
+                  m_lru[idx] = ++m_lru_max;
+                  return true;
+               }
+            }
+            // Find replacement
+            UInt64 lru_min = UINT64_MAX; unsigned int idx_min = 0;
+            for(unsigned int idx = 0; idx < assoc; ++idx)
+            {
+               if (m_lru[idx] < lru_min)
+               {
+                  lru_min = m_lru[idx];
+                  idx_min = idx;
+               }
+            }
+            m_tags[idx_min] = tag;
+            m_lru[idx_min] = ++m_lru_max;
+            return false;
+         }
+         bool invalidate(IntPtr tag)
+         {
+            for(unsigned int idx = 0; idx < assoc; ++idx)
+            {
+               if (m_tags[idx] == tag)
+               {
+                  m_tags[idx] = INVALID_TAG;
+                  m_lru[idx] = 0;
+                  return true;
+               }
+            }
+            return false;
+         }
+   };
+
+   // Same as FastNehalem::Cache, but only the associativity is a template parameter: it is what determines the
+   // (unrolled) lookup loop, the number of sets is just a mask
+   template <UInt32 assoc>
+   class Cache : public CacheBase
+   {
+      private:
+         const ComponentLatency m_latency;
+         CacheBase* const m_next_level;
+         const UInt64 m_num_sets;
+         const IntPtr m_sets_mask;
+         std::vector<CacheSet<assoc> > m_sets;
+         UInt64 m_loads, m_stores, m_load_misses, m_store_misses, m_invalidations;
+
+      public:
+         Cache(Core *core, String name, UInt64 size_kb, UInt64 latency, CacheBase* next_level)
+            : m_latency(core->getDvfsDomain(), latency)
+            , m_next_level(next_level)
+            , m_num_sets(size_kb * 1024 / CACHE_LINE_SIZE / assoc)
+            , m_sets_mask(m_num_sets - 1)
+            , m_sets(m_num_sets)
+         {
+            LOG_ASSERT_ERROR(m_num_sets > 0 && UInt64(1) << floorLog2(m_num_sets) == m_num_sets,
+                             "%s: number of sets must be power of 2", name.c_str());
+            m_loads = m_stores = m_load_misses = m_store_misses = m_invalidations = 0;
+            registerStatsMetric(name, core->getId(), "loads", &m_loads);
+            registerStatsMetric(name, core->getId(), "stores", &m_stores);
+            registerStatsMetric(name, core->getId(), "load-misses", &m_load_misses);
+            registerStatsMetric(name, core->getId(), "store-misses", &m_store_misses);
+            registerStatsMetric(name, core->getId(), "coherency-invalidates", &m_invalidations);
+         }
+         virtual ~Cache() {}
+
+         SubsecondTime access(Core::mem_op_t mem_op_type, IntPtr tag)
+         {
+            if (mem_op_type == Core::WRITE) ++m_stores; else ++m_loads;
+            if (m_sets[tag & m_sets_mask].find(tag))
+               return m_latency.getLatency();
+            else
+            {
+               if (mem_op_type == Core::WRITE) ++m_store_misses; else ++m_load_misses;
+               return m_next_level->access(mem_op_type, tag);
+            }
+         }
+         void invalidate(IntPtr tag)
+         {
+            if (m_sets[tag & m_sets_mask].invalidate(tag))
+               ++m_invalidations;
+         }
+   };
+
+   template <UInt32 assoc>
+   class CacheLocked : public Cache<assoc>
+   {
+      private:
+         Lock lock;
+      public:
+         CacheLocked(Core *core, String name, UInt64 size_kb, UInt64 latency, CacheBase* next_level)
+            : Cache<assoc>(core, name, size_kb, latency, next_level)
+         {}
+         SubsecondTime access(Core::mem_op_t mem_op_type, IntPtr tag)
+         {
+            ScopedLock sl(lock);
+            return Cache<assoc>::access(mem_op_type, tag);
+         }
+   };
+
+   // Simplified coherence at the first shared level (or DRAM): a direct-mapped table of the cores that may hold a
+   // line in their private caches. Fills add the requester, writes invalidate all other holders. With silent private
+   // evictions a sharer bit may be stale, which only costs a useless invalidation. Filter conflicts back-invalidate
+   // the holders of the old line, so no invalidation is ever missed.
+   // Invalidations are applied to the private caches of other cores without synchronizing with them, like a snoop
+   // arriving between two of their accesses; this is an approximate model aimed at throughput.
+   class CoherenceFilter
+   {
+      private:
+         struct Entry
+         {
+            IntPtr tag;
+            UInt64 sharers;
+         };
+
+         const SubsecondTime m_latency;
+         std::vector<Entry> m_entries;
+         const IntPtr m_mask;
+         std::vector<std::vector<CacheBase*> > m_private_caches;
+         Lock m_lock;
+         UInt64 m_upgrades, m_invalidations, m_back_invalidations;
+
+         void invalidateSharers(IntPtr tag, UInt64 sharers)
+         {
+            for(UInt32 idx = 0; sharers; ++idx, sharers >>= 1)
+               if (sharers & 1)
+                  for(auto it = m_private_caches[idx].begin(); it != m_private_caches[idx].end(); ++it)
+                     (*it)->invalidate(tag);
+         }
+
+         Entry& lookup(IntPtr tag)
+         {
+            Entry &entry = m_entries[tag & m_mask];
+            if (entry.tag != tag)
+            {
+               if (entry.sharers)
+               {
+                  invalidateSharers(entry.tag, entry.sharers);
+                  ++m_back_invalidations;
+               }
+               entry.tag = tag;
+               entry.sharers = 0;
+            }
+            return entry;
+         }
+
+      public:
+         CoherenceFilter(Core *core, UInt32 num_sharers, UInt64 num_entries, SubsecondTime latency)
+            : m_latency(latency)
+            , m_entries(num_entries)
+            , m_mask(num_entries - 1)
+            , m_private_caches(num_sharers)
+         {
+            LOG_ASSERT_ERROR(num_sharers <= 64, "The fast coherence filter supports up to 64 cores per shared cache, not %d", num_sharers);
+            LOG_ASSERT_ERROR(UInt64(1) << floorLog2(num_entries) == num_entries, "Number of coherence filter entries must be power of 2");
+            for(auto it = m_entries.begin(); it != m_entries.end(); ++it)
+            {
+               it->tag = INVALID_TAG;
+               it->sharers = 0;
+            }
+            m_upgrades = m_invalidations = m_back_invalidations = 0;
+            registerStatsMetric("fast-coherence", core->getId(), "upgrades", &m_upgrades);
+            registerStatsMetric("fast-coherence", core->getId(), "invalidations", &m_invalidations);
+            registerStatsMetric("fast-coherence", core->getId(), "back-invalidations", &m_back_invalidations);
+         }
+
+         void addSharer(UInt32 sharer, const std::vector<CacheBase*> &private_caches)
+         {
+            m_private_caches[sharer] = private_caches;
+         }
+
+         void fill(UInt32 sharer, IntPtr tag)
+         {
+            ScopedLock sl(m_lock);
+            lookup(tag).sharers |= UInt64(1) << sharer;
+         }
+
+         // Returns the upgrade latency when copies in other private caches had to be invalidated
+         SubsecondTime write(UInt32 sharer, IntPtr tag)
+         {
+            const UInt64 self = UInt64(1) << sharer;
+            // Common case: we're the only holder already, which doesn't need the lock
+            const Entry &entry = m_entries[tag & m_mask];
+            if (entry.tag == tag && entry.sharers == self)
+               return SubsecondTime::Zero();
+
+            ScopedLock sl(m_lock);
+            Entry &current = lookup(tag);
+            UInt64 others = current.sharers & ~self;
+            current.sharers = self;
+            if (!others)
+               return SubsecondTime::Zero();
+
+            invalidateSharers(tag, others);
+            ++m_upgrades;
+            m_invalidations += __builtin_popcountll(others);
+            return m_latency;
+         }
+   };
+
+   // Per-core entry into the coherence point: registers private misses with the filter
+   class FilterPort : public CacheBase
+   {
+      private:
+         CoherenceFilter* const m_filter;
+         const UInt32 m_sharer;
+         CacheBase* const m_next_level;
+      public:
+         FilterPort(CoherenceFilter *filter, UInt32 sharer, CacheBase *next_level)
+            : m_filter(filter)
+            , m_sharer(sharer)
+            , m_next_level(next_level)
+         {}
+         SubsecondTime access(Core::mem_op_t mem_op_type, IntPtr tag)
+         {
+            m_filter->fill(m_sharer, tag);
+            return m_next_level->access(mem_op_type, tag);
+         }
+   };
+}
+
+#endif // __FAST_HIERARCHY_CACHE_H
@@ -0,0 +1,184 @@
+#include "memory_manager.h"
+#include "fast_hierarchy_cache.h"
+#include "simulator.h"
+#include "config.h"
+#include "config.hpp"
+#include "itostr.h"
+
+namespace FastHierarchy
+{
+
+std::map<std::pair<UInt32, UInt32>, CacheBase*> MemoryManager::s_shared;
+std::map<UInt32, CoherenceFilter*> MemoryManager::s_filters;
+
+typedef CacheBase* (*CacheFactory)(Core *core, String name, UInt64 size_kb, UInt64 latency, CacheBase *next_level, bool shared);
+
+template <UInt32 assoc>
+static CacheBase* newCache(Core *core, String name, UInt64 size_kb, UInt64 latency, CacheBase *next_level, bool shared)
+{
+   if (shared)
+      return new CacheLocked<assoc>(core, name, size_kb, latency, next_level);
+   else
+      return new Cache<assoc>(core, name, size_kb, latency, next_level);
+}
+
+// Precompiled instantiations, add an entry here to support another associativity
+static const struct
+{
+   UInt32 assoc;
+   CacheFactory factory;
+} cache_factories[] = {
+   {  1, newCache<1> },
+   {  2, newCache<2> },
+   {  4, newCache<4> },
+   {  8, newCache<8> },
+   { 12, newCache<12> },
+   { 16, newCache<16> },
+   { 20, newCache<20> },
+   { 24, newCache<24> },
+   { 32, newCache<32> },
+};
+
+MemoryManager::MemoryManager(Core* core, Network* network, ShmemPerfModel* shmem_perf_model)
+   : MemoryManagerFast(core, network, shmem_perf_model)
+   , icache(NULL)
+   , dcache(NULL)
+   , m_port(NULL)
+   , m_filter(NULL)
+   , m_sharer(0)
+{
+   const core_id_t core_id = core->getId();
+   const UInt32 levels = Sim()->getCfg()->getInt("perf_model/cache/levels");
+   const UInt32 smt_cores = Sim()->getCfg()->getInt("perf_model/core/logical_cpus");
+
+   // Number of cores sharing each level, which may only grow (by integer factors) towards DRAM
+   std::vector<UInt32> shared_cores(levels + 1, 1);
+   UInt32 first_shared = levels + 1;
+   for(UInt32 level = 1; level <= levels; ++level)
+   {
+      String config_name = level == 1 ? "l1_dcache" : "l" + itostr(level) + "_cache";
+      shared_cores[level] = Sim()->getCfg()->getIntArray("perf_model/" + config_name + "/shared_cores", core_id) * smt_cores;
+      LOG_ASSERT_ERROR(shared_cores[level] % shared_cores[level - 1] == 0,
+                       "%s must be shared by a multiple of the number of cores sharing the previous level", config_name.c_str());
+      if (shared_cores[level] > 1 && first_shared > levels)
+         first_shared = level;
+   }
+
+   SubsecondTime dram_latency = SubsecondTime::FS() * static_cast<uint64_t>(TimeConverter<float>::NStoFS(Sim()->getCfg()->getFloat("perf_model/dram/latency")));
+   CacheBase *&dram = s_shared[std::make_pair(UInt32(MemComponent::DRAM), UInt32(0))];
+   if (!dram)
+      dram = new Dram(core, "dram", dram_latency);
+
+   // Private caches in front of the first shared level (or DRAM) are kept coherent by a filter at that level
+   if (first_shared > 1 && Sim()->getCfg()->getBool("caching_protocol/fast/coherence"))
+   {
+      UInt32 domain = first_shared <= levels ? shared_cores[first_shared] : Config::getSingleton()->getTotalCores();
+      if (domain > 1)
+      {
+         SubsecondTime latency = first_shared <= levels
+            ? ComponentLatency(core->getDvfsDomain(),
+                               Sim()->getCfg()->getIntArray("perf_model/l" + itostr(first_shared) + "_cache/data_access_time", core_id)).getLatency()
+            : dram_latency;
+         CoherenceFilter *&filter = s_filters[core_id / domain];
+         if (!filter)
+            filter = new CoherenceFilter(core, domain, Sim()->getCfg()->getInt("caching_protocol/fast/filter_entries"), latency);
+         m_filter = filter;
+         m_sharer = core_id % domain;
+      }
+   }
+
+   // Build from DRAM towards the core, so every level knows its next level
+   CacheBase *next_level = dram;
+   for(UInt32 level = levels; level >= 2; --level)
+   {
+      if (level + 1 == first_shared && m_filter)
+         next_level = m_port = new FilterPort(m_filter, m_sharer, next_level);
+      next_level = getCache(MemComponent::component_t(MemComponent::L2_CACHE + level - 2), level >= first_shared, shared_cores[level], next_level);
+   }
+   if (first_shared == 2 && m_filter)
+      next_level = m_port = new FilterPort(m_filter, m_sharer, next_level);
+   icache = getCache(MemComponent::L1_ICACHE, first_shared == 1, shared_cores[1], next_level);
+   dcache = getCache(MemComponent::L1_DCACHE, first_shared == 1, shared_cores[1], next_level);
+
+   if (m_filter)
+      m_filter->addSharer(m_sharer, m_private);
+}
+
+MemoryManager::~MemoryManager()
+{
+   for(auto it = m_private.begin(); it != m_private.end(); ++it)
+      delete *it;
+   if (m_port)
+      delete m_port;
+}
+
+CacheBase* MemoryManager::getCache(MemComponent::component_t component, bool shared, UInt32 shared_cores, CacheBase *next_level)
+{
+   const core_id_t core_id = getCore()->getId();
+   String config_name, name;
+   switch(component)
+   {
+      case MemComponent::L1_ICACHE:
+         config_name = "l1_icache";
+         name = "L1-I";
+         break;
+      case MemComponent::L1_DCACHE:
+         config_name = "l1_dcache";
+         name = "L1-D";
+         break;
+      default:
+         String level = itostr(component - MemComponent::L2_CACHE + 2);
+         config_name = "l" + level + "_cache";
+         name = "L" + level;
+         break;
+   }
+
+   if (shared)
+   {
+      CacheBase *&cache = s_shared[std::make_pair(UInt32(component), UInt32(core_id / shared_cores))];
+      if (!cache)
+         cache = createCache(config_name, name, true, next_level);
+      return cache;
+   }
+   else
+   {
+      CacheBase *cache = createCache(config_name, name, false, next_level);
+      m_private.push_back(cache);
+      return cache;
+   }
+}
+
+CacheBase* MemoryManager::createCache(String config_name, String name, bool shared, CacheBase *next_level)
+{
+   const core_id_t core_id = getCore()->getId();
+   UInt32 assoc = Sim()->getCfg()->getIntArray("perf_model/" + config_name + "/associativity", core_id);
+   UInt64 size_kb = Sim()->getCfg()->getIntArray("perf_model/" + config_name + "/cache_size", core_id);
+   // As in fast_nehalem, L1 hits are free: their latency is part of the core model
+   UInt64 latency = config_name.compare(0, 2, "l1") == 0
+      ? 0 : Sim()->getCfg()->getIntArray("perf_model/" + config_name + "/data_access_time", core_id);
+   LOG_ASSERT_ERROR(Sim()->getCfg()->getIntArray("perf_model/" + config_name + "/cache_block_size", core_id) == SInt64(CACHE_LINE_SIZE),
+                    "The fast memory hierarchy only supports %d-byte cache blocks", CACHE_LINE_SIZE);
+
+   String supported;
+   for(size_t idx = 0; idx < sizeof(cache_factories) / sizeof(cache_factories[0]); ++idx)
+   {
+      if (cache_factories[idx].assoc == assoc)
+         return cache_factories[idx].factory(getCore(), name, size_kb, latency, next_level, shared);
+      supported += (idx ? ", " : "") + itostr(cache_factories[idx].assoc);
+   }
+   LOG_PRINT_ERROR("%s: associativity %d is not supported by the fast memory hierarchy (supported: %s)", name.c_str(), assoc, supported.c_str());
+}
+
+SubsecondTime MemoryManager::coreInitiateMemoryAccessFast(
+      bool use_icache,
+      Core::mem_op_t mem_op_type,
+      IntPtr address)
+{
+   IntPtr tag = address >> CACHE_LINE_BITS;
+   SubsecondTime latency = (use_icache ? icache : dcache)->access(mem_op_type, tag);
+   if (m_filter && mem_op_type == Core::WRITE)
+      latency += m_filter->write(m_sharer, tag);
+   return latency;
+}
+
+}
@@ -0,0 +1,55 @@
+#ifndef __FAST_HIERARCHY_H
+#define __FAST_HIERARCHY_H
+
+#include "memory_manager_fast.h"
+
+#include <map>
+#include <vector>
+
+// Configurable version of fast_nehalem: cache levels, sizes, associativities, latencies and sharing are taken from
+// the regular perf_model/l*_cache sections. Levels are built from precompiled per-associativity templates, selected
+// through a dispatch table at startup, so lookups still run a fixed-size loop.
+namespace FastHierarchy
+{
+   static const UInt64 CACHE_LINE_SIZE = 64;
+   static const IntPtr INVALID_TAG = ~IntPtr(0);
+
+   class CacheBase
+   {
+      public:
+         virtual ~CacheBase() {}
+         virtual SubsecondTime access(Core::mem_op_t mem_op_type, IntPtr tag) = 0;
+         virtual void invalidate(IntPtr tag) {}
+   };
+
+   class CoherenceFilter;
+
+   class MemoryManager : public MemoryManagerFast
+   {
+      private:
+         CacheBase *icache, *dcache;
+         // Caches owned by this core, deleted with it
+         std::vector<CacheBase*> m_private;
+         CacheBase *m_port;
+         CoherenceFilter *m_filter;
+         UInt32 m_sharer;
+
+         // Shared objects, by level and index of the group of cores sharing them (level 0 is DRAM)
+         static std::map<std::pair<UInt32, UInt32>, CacheBase*> s_shared;
+         static std::map<UInt32, CoherenceFilter*> s_filters;
+
+         CacheBase* getCache(MemComponent::component_t component, bool shared, UInt32 shared_cores, CacheBase *next_level);
+         CacheBase* createCache(String config_name, String name, bool shared, CacheBase *next_level);
+
+      public:
+         MemoryManager(Core* core, Network* network, ShmemPerfModel* shmem_perf_model);
+         ~MemoryManager();
+
+         SubsecondTime coreInitiateMemoryAccessFast(
+               bool use_icache,
+               Core::mem_op_t mem_op_type,
+               IntPtr address);
+   };
+}
+
+#endif // __FAST_HIERARCHY_H
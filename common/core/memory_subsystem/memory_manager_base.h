@@ -8,6 +8,10 @@
 #include "shmem_perf_model.h"
 #include "pr_l1_pr_l2_dram_directory_msi/shmem_msg.h"
 
+class CheckpointWriter;
+class CheckpointReader;
+struct CheckpointLine;
+
 void MemoryManagerNetworkCallback(void* obj, NetPacket packet);
 
 class MemoryManagerBase
@@ -17,6 +21,7 @@ class MemoryManagerBase
       {
          PARAMETRIC_DRAM_DIRECTORY_MSI,
          FAST_NEHALEM,
+         FAST_HIERARCHY,
          NUM_CACHING_PROTOCOL_TYPES
       };
 
@@ -48,7 +53,8 @@ class MemoryManagerBase
             Core::mem_op_t mem_op_type,
             IntPtr address, UInt32 offset,
             Byte* data_buf, UInt32 data_length,
-            Core::MemModeled modeled) = 0;
+            Core::MemModeled modeled,
+            IntPtr eip = 0) = 0;
       virtual SubsecondTime coreInitiateMemoryAccessFast(
             bool icache,
             Core::mem_op_t mem_op_type,
@@ -72,6 +78,30 @@ class MemoryManagerBase
          return latency;
       }
 
+      // Cache-only warmup of a run of L1-D accesses (see Core::warmMemoryBatch), each one starting at <now>.
+      // Returns the sum of their latencies. The default issues them one by one through coreInitiateMemoryAccess.
+      virtual SubsecondTime coreWarmMemoryBatch(
+            const Core::CacheOnlyAccess* accesses, UInt32 count,
+            SubsecondTime now)
+      {
+         SubsecondTime latency = SubsecondTime::Zero();
+         IntPtr block_mask = ~IntPtr(getCacheBlockSize() - 1);
+         for(UInt32 i = 0; i < count; ++i)
+         {
+            getShmemPerfModel()->setElapsedTime(ShmemPerfModel::_USER_THREAD, now);
+            coreInitiateMemoryAccess(
+                  MemComponent::L1_DCACHE,
+                  Core::NONE,
+                  accesses[i].mem_op_type,
+                  accesses[i].address & block_mask, accesses[i].address & ~block_mask,
+                  NULL, 1,
+                  Core::MEM_MODELED_COUNT,
+                  accesses[i].eip);
+            latency += getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD) - now;
+         }
+         return latency;
+      }
+
       virtual void handleMsgFromNetwork(NetPacket& packet) = 0;
 
       // FIXME: Take this out of here
@@ -90,6 +120,16 @@ class MemoryManagerBase
 
       Core* getCore() { return m_core; }
 
+      // Checkpointing (see CheckpointManager). Cache contents are saved per level, and on restore are only read back
+      // as a list of lines so they can be re-installed through the normal access path, keeping coherence state consistent.
+      // All other (non-coherent) state such as TLBs and prefetchers is saved and restored as-is.
+      virtual void saveCheckpointCache(MemComponent::component_t mem_component, CheckpointWriter &ckpt) {}
+      virtual void loadCheckpointCache(MemComponent::component_t mem_component, CheckpointReader &ckpt, std::vector<CheckpointLine> &lines) {}
+      virtual void saveCheckpoint(CheckpointWriter &ckpt) {}
+      virtual void loadCheckpoint(CheckpointReader &ckpt) {}
+      // Current lines of a cache level (only for the core that owns it), least recently used first
+      virtual void getCacheLines(MemComponent::component_t mem_component, std::vector<CheckpointLine> &lines) {}
+
       virtual void sendMsg(PrL1PrL2DramDirectoryMSI::ShmemMsg::msg_t msg_type, MemComponent::component_t sender_mem_component, MemComponent::component_t receiver_mem_component, core_id_t requester, core_id_t receiver, IntPtr address, Byte* data_buf = NULL, UInt32 data_length = 0, HitWhere::where_t where = HitWhere::UNKNOWN, ShmemPerf *perf = NULL, ShmemPerfModel::Thread_t thread_num = ShmemPerfModel::NUM_CORE_THREADS) = 0;
       virtual void broadcastMsg(PrL1PrL2DramDirectoryMSI::ShmemMsg::msg_t msg_type, MemComponent::component_t sender_mem_component, MemComponent::component_t receiver_mem_component, core_id_t requester, IntPtr address, Byte* data_buf = NULL, UInt32 data_length = 0, ShmemPerf *perf = NULL, ShmemPerfModel::Thread_t thread_num = ShmemPerfModel::NUM_CORE_THREADS) = 0;
 
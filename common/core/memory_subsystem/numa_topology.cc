@@ -0,0 +1,104 @@
+#include "numa_topology.h"
+#include "simulator.h"
+#include "config.h"
+#include "config.hpp"
+#include "queue_model.h"
+#include "stats.h"
+#include "log.h"
+
+NumaTopology* NumaTopology::create()
+{
+   UInt32 num_sockets = Sim()->getCfg()->getInt("perf_model/numa/sockets");
+   if (num_sockets > 1)
+      return new NumaTopology(num_sockets);
+   else
+      return NULL;
+}
+
+NumaTopology::NumaTopology(UInt32 num_sockets)
+   : m_num_sockets(num_sockets)
+   , m_num_cores(Sim()->getConfig()->getApplicationCores())
+   , m_sockets(num_sockets)
+   , m_node_pages(0)
+   , m_link_latency(SubsecondTime::FS() * static_cast<uint64_t>(TimeConverter<float>::NStoFS(Sim()->getCfg()->getFloat("perf_model/numa/link_latency"))))
+   , m_link_bandwidth(8 * Sim()->getCfg()->getFloat("perf_model/numa/link_bandwidth")) // Convert bytes to bits
+{
+   LOG_ASSERT_ERROR(m_num_sockets <= m_num_cores, "perf_model/numa/sockets(%u) cannot be larger than the number of cores(%u)", m_num_sockets, m_num_cores);
+
+   if (Sim()->getCfg()->getBool("traceinput/enabled") && Sim()->getCfg()->getBool("traceinput/page_allocator/enabled"))
+   {
+      // Page allocator nodes are contiguous ranges of physical memory, cores are assigned to nodes the same way as to sockets
+      UInt32 num_nodes = Sim()->getCfg()->getInt("traceinput/page_allocator/numa_nodes");
+      LOG_ASSERT_ERROR(num_nodes == m_num_sockets, "traceinput/page_allocator/numa_nodes(%u) must equal perf_model/numa/sockets(%u)", num_nodes, m_num_sockets);
+      m_node_pages = (UInt64(Sim()->getCfg()->getInt("traceinput/page_allocator/memory_size")) << (20 - PAGE_SHIFT)) / num_nodes;
+   }
+
+   String queue_model_type = Sim()->getCfg()->getString("perf_model/numa/queue_model/type");
+   bool queue_model_enabled = Sim()->getCfg()->getBool("perf_model/numa/queue_model/enabled");
+   UInt32 cache_block_size = Sim()->getCfg()->getInt("perf_model/l1_dcache/cache_block_size");
+
+   for(UInt32 from = 0; from < m_num_sockets; ++from)
+   {
+      for(UInt32 to = 0; to < m_num_sockets; ++to)
+      {
+         UInt32 link_id = from * m_num_sockets + to;
+         Link *link = new Link();
+         link->queue_model = from != to && queue_model_enabled
+            ? QueueModel::create("numa-link-queue", link_id, queue_model_type, m_link_bandwidth.getRoundedLatency(8 * cache_block_size))
+            : NULL;
+         link->transfers = 0;
+         link->bytes = 0;
+         link->total_queueing_delay = SubsecondTime::Zero();
+         m_links.push_back(link);
+
+         if (from != to)
+         {
+            registerStatsMetric("numa-link", link_id, "transfers", &link->transfers);
+            registerStatsMetric("numa-link", link_id, "bytes", &link->bytes);
+            registerStatsMetric("numa-link", link_id, "total-queueing-delay", &link->total_queueing_delay);
+         }
+      }
+   }
+}
+
+NumaTopology::~NumaTopology()
+{
+   for(std::vector<Link*>::iterator it = m_links.begin(); it != m_links.end(); ++it)
+   {
+      if ((*it)->queue_model)
+         delete (*it)->queue_model;
+      delete *it;
+   }
+}
+
+SubsecondTime
+NumaTopology::crossLink(UInt32 from, UInt32 to, SubsecondTime now, UInt32 size, ShmemPerf *perf)
+{
+   Link *link = m_links[from * m_num_sockets + to];
+
+   SubsecondTime processing_time = m_link_bandwidth.getRoundedLatency(8 * size); // bytes to bits
+   SubsecondTime queue_delay = SubsecondTime::Zero();
+   if (link->queue_model && size)
+   {
+      if (link->queue_model->isThreadSafe())
+         queue_delay = link->queue_model->computeQueueDelay(now, processing_time);
+      else
+      {
+         ScopedLock sl(link->lock);
+         queue_delay = link->queue_model->computeQueueDelay(now, processing_time);
+      }
+   }
+
+   __sync_fetch_and_add(&link->transfers, 1);
+   __sync_fetch_and_add(&link->bytes, size);
+   if (queue_delay > SubsecondTime::Zero())
+   {
+      ScopedLock sl(link->lock);
+      link->total_queueing_delay += queue_delay;
+   }
+
+   SubsecondTime latency = queue_delay + processing_time + m_link_latency;
+   perf->updateTime(now);
+   perf->updateTime(now + latency, ShmemPerf::NUMA_LINK);
+   return latency;
+}
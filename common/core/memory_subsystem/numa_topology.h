@@ -0,0 +1,79 @@
+#ifndef __NUMA_TOPOLOGY_H
+#define __NUMA_TOPOLOGY_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "fast_divider.h"
+#include "lock.h"
+#include "shmem_perf.h"
+
+#include <vector>
+#include <algorithm>
+
+class QueueModel;
+
+// Multi-socket NUMA memory ([perf_model/numa], enabled with sockets > 1).
+// Cores are split into contiguous groups of sockets, and each socket owns the DRAM controllers that sit on its cores
+// (see AddressHomeLookup). Physical memory is split over the sockets: with the trace-driven page allocator
+// ([traceinput/page_allocator]) the sockets are its NUMA nodes, so its first_touch or interleave policy decides
+// where pages live; otherwise consecutive 4 KB pages go to consecutive sockets.
+// Sockets are fully connected by point-to-point links (QPI/UPI), with a queue model per direction. DRAM requests from
+// a core on another socket than the controller cross a link on top of the on-chip network hops.
+class NumaTopology
+{
+   public:
+      static const UInt32 PAGE_SHIFT = 12;
+
+      static NumaTopology* create();
+
+      NumaTopology(UInt32 num_sockets);
+      ~NumaTopology();
+
+      UInt32 getNumSockets() const { return m_num_sockets; }
+      UInt32 getCoreSocket(core_id_t core_id) const
+      {
+         // Non-application cores (e.g. MCP) are not placed on a socket, consider them local
+         return core_id < 0 || UInt32(core_id) >= m_num_cores ? 0 : UInt64(core_id) * m_num_sockets / m_num_cores;
+      }
+      UInt32 getAddressSocket(IntPtr address) const
+      {
+         UInt64 page = address >> PAGE_SHIFT;
+         if (m_node_pages)
+            return std::min(page / m_node_pages, UInt64(m_num_sockets - 1));
+         else
+            return m_sockets.modulo(page);
+      }
+      // Address within its socket, dense so the socket's controllers can interleave on it
+      IntPtr getSocketAddress(IntPtr address) const
+      {
+         UInt64 page = address >> PAGE_SHIFT;
+         if (m_node_pages)
+            return address - ((getAddressSocket(address) * m_node_pages) << PAGE_SHIFT);
+         else
+            return (m_sockets.divide(page) << PAGE_SHIFT) | (address & ((IntPtr(1) << PAGE_SHIFT) - 1));
+      }
+
+      // Cross the link from one socket to another at <now>, returns the latency.
+      // Messages without data (size 0) only see the link latency.
+      SubsecondTime crossLink(UInt32 from, UInt32 to, SubsecondTime now, UInt32 size, ShmemPerf *perf);
+
+   private:
+      struct Link
+      {
+         Lock lock; // Only used when the queue model is not thread-safe
+         QueueModel *queue_model;
+         UInt64 transfers;
+         UInt64 bytes;
+         SubsecondTime total_queueing_delay;
+      };
+
+      const UInt32 m_num_sockets;
+      const UInt32 m_num_cores;
+      const FastDivider m_sockets;
+      UInt64 m_node_pages; // Pages per socket when memory is split into contiguous ranges, 0 for page interleaving
+      const SubsecondTime m_link_latency;
+      const ComponentBandwidth m_link_bandwidth;
+      std::vector<Link*> m_links; // Indexed by from * sockets + to
+};
+
+#endif // __NUMA_TOPOLOGY_H
@@ -1,6 +1,7 @@
 #include "a53prefetcher.h"
 #include "simulator.h"
 #include "config.hpp"
+#include "checkpoint.h"
 
 inline intptr_t myAbs(intptr_t a) {
    return a < 0 ? -a:a;
@@ -18,8 +19,9 @@ A53Prefetcher::A53Prefetcher(String configName, core_id_t core_id)
 {
 }
 
-std::vector<IntPtr> A53Prefetcher::getNextAddress(IntPtr currentAddress, core_id_t core_id) {
-   std::vector<IntPtr> prefetchAddress;
+UInt32 A53Prefetcher::getNextAddresses(const Access &access, IntPtr *prefetches, UInt32 max_prefetches) {
+   const IntPtr currentAddress = access.address;
+   UInt32 count = 0;
 
    if (firstAddress) {
       firstAddress = false;
@@ -38,8 +40,8 @@ std::vector<IntPtr> A53Prefetcher::getNextAddress(IntPtr currentAddress, core_id
          }
 
          if (currentConsecutivePatternLength >= m_consecutivePatternLength) {
-            for (unsigned int i = 1; i <= m_numPrefetches; ++i) {
-               prefetchAddress.push_back(currentAddress + m_cacheLineSize*i);
+            for (unsigned int i = 1; i <= m_numPrefetches && count < max_prefetches; ++i) {
+               prefetches[count++] = currentAddress + m_cacheLineSize*i;
             }
          }
       }
@@ -53,13 +55,29 @@ std::vector<IntPtr> A53Prefetcher::getNextAddress(IntPtr currentAddress, core_id
          }
 
          if (currentPatternLength >= m_patternLength) {
-            for (unsigned int i = 1; i <= m_numPrefetches; ++i) {
-               prefetchAddress.push_back(currentAddress + stride*i);
+            for (unsigned int i = 1; i <= m_numPrefetches && count < max_prefetches; ++i) {
+               prefetches[count++] = currentAddress + stride*i;
             }
          }
       }
    }
 
    prevAddress = currentAddress;
-   return prefetchAddress;
+   return count;
+}
+
+void A53Prefetcher::saveState(CheckpointWriter &ckpt) const {
+   ckpt.put(firstAddress);
+   ckpt.put(stride);
+   ckpt.put(prevAddress);
+   ckpt.put(currentPatternLength);
+   ckpt.put(currentConsecutivePatternLength);
+}
+
+void A53Prefetcher::loadState(CheckpointReader &ckpt) {
+   ckpt.get(firstAddress);
+   ckpt.get(stride);
+   ckpt.get(prevAddress);
+   ckpt.get(currentPatternLength);
+   ckpt.get(currentConsecutivePatternLength);
 }
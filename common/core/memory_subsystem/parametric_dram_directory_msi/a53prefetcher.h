@@ -15,7 +15,9 @@ class A53Prefetcher : public Prefetcher
 
 public:
    A53Prefetcher(String configName, core_id_t core_id);
-   std::vector<IntPtr> getNextAddress(IntPtr currentAddress, core_id_t core_id) override;
+   UInt32 getNextAddresses(const Access &access, IntPtr *prefetches, UInt32 max_prefetches) override;
+   void saveState(CheckpointWriter &ckpt) const override;
+   void loadState(CheckpointReader &ckpt) override;
 };
 
 #endif // A53PREFETCHER_H
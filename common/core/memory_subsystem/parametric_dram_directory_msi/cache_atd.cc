@@ -5,36 +5,22 @@
 #include "config.hpp"
 #include "rng.h"
 
+#include <boost/algorithm/string.hpp>
+
 ATD::ATD(String name, String configName, core_id_t core_id, UInt32 num_sets, UInt32 associativity,
          UInt32 cache_block_size, String replacement_policy, CacheBase::hash_t hash_function)
    : m_cache_base(name, num_sets, associativity, cache_block_size, hash_function)
-   , m_sets()
-   , loads(0)
-   , stores(0)
-   , load_misses(0)
-   , store_misses(0)
-   , loads_constructive(0)
-   , stores_constructive(0)
-   , loads_destructive(0)
-   , stores_destructive(0)
+   , m_shadows()
+   , m_sampled((num_sets + 63) / 64, 0)
+   , m_slot_base((num_sets + 63) / 64, 0)
+   , m_num_slots(0)
 {
-   m_set_info = CacheSet::createCacheSetInfo(name, configName, core_id, replacement_policy, associativity);
-
-   registerStatsMetric(name, core_id, "loads", &loads);
-   registerStatsMetric(name, core_id, "stores", &stores);
-   registerStatsMetric(name, core_id, "load-misses", &load_misses);
-   registerStatsMetric(name, core_id, "store-misses", &store_misses);
-   registerStatsMetric(name, core_id, "loads-constructive", &loads_constructive);
-   registerStatsMetric(name, core_id, "loads-destructive", &loads_destructive);
-   registerStatsMetric(name, core_id, "stores-constructive", &stores_constructive);
-   registerStatsMetric(name, core_id, "stores-destructive", &stores_destructive);
-
    String sampling = Sim()->getCfg()->getStringArray(configName + "/atd/sampling", core_id);
    if (sampling == "full")
    {
       for(UInt64 set_index = 0; set_index < num_sets; ++set_index)
       {
-         m_sets[set_index] = CacheSet::createCacheSet(name, core_id, replacement_policy, CacheBase::PR_L1_CACHE, associativity, 0, m_set_info);
+         m_sampled[set_index / 64] |= UInt64(1) << (set_index % 64);
       }
    }
    else if (sampling == "2^n+1")
@@ -42,7 +28,7 @@ ATD::ATD(String name, String configName, core_id_t core_id, UInt32 num_sets, UIn
       // Sample sets at indexes 2^N+1
       for(UInt64 set_index = 1; set_index < num_sets - 1; set_index <<= 1)
       {
-         m_sets[set_index+1] = CacheSet::createCacheSet(name, core_id, replacement_policy, CacheBase::PR_L1_CACHE, associativity, 0, m_set_info);
+         m_sampled[(set_index+1) / 64] |= UInt64(1) << ((set_index+1) % 64);
       }
    }
    else if (sampling == "random")
@@ -57,9 +43,9 @@ ATD::ATD(String name, String configName, core_id_t core_id, UInt32 num_sets, UIn
       while(num_atds)
       {
          UInt64 set_index = rng_next(state) % num_sets;
-         if (m_sets.count(set_index) == 0)
+         if (!isSampledSet(set_index))
          {
-            m_sets[set_index] = CacheSet::createCacheSet(name, core_id, replacement_policy, CacheBase::PR_L1_CACHE, associativity, 0, m_set_info);
+            m_sampled[set_index / 64] |= UInt64(1) << (set_index % 64);
             --num_atds;
          }
          LOG_ASSERT_ERROR(++num_attempts < 10 * num_sets, "Cound not find unique ATD sets even after many attempts");
@@ -69,17 +55,62 @@ ATD::ATD(String name, String configName, core_id_t core_id, UInt32 num_sets, UIn
    {
       LOG_PRINT_ERROR("Invalid ATD sampling method %s", sampling.c_str());
    }
+
+   for(UInt32 word = 0; word < m_sampled.size(); ++word)
+   {
+      m_slot_base[word] = m_num_slots;
+      m_num_slots += __builtin_popcountll(m_sampled[word]);
+   }
+
+   // The cache's own policy keeps the original statistics names, additional policies to compare against
+   // are reported as <name>-<policy>, all from the same simulation
+   addShadow(name, configName, core_id, replacement_policy, associativity, cache_block_size);
+   if (Sim()->getCfg()->hasKey(configName + "/atd/policies", core_id))
+   {
+      String policies = Sim()->getCfg()->getStringArray(configName + "/atd/policies", core_id);
+      std::vector<String> selected;
+      boost::split(selected, policies, boost::is_any_of(" ,"), boost::token_compress_on);
+      for(std::vector<String>::iterator it = selected.begin(); it != selected.end(); ++it)
+      {
+         if (!it->empty())
+            addShadow(name + "-" + *it, configName, core_id, *it, associativity, cache_block_size);
+      }
+   }
 }
 
 ATD::~ATD()
 {
-   if (m_set_info)
-      delete m_set_info;
+   for(std::vector<Shadow*>::iterator it = m_shadows.begin(); it != m_shadows.end(); ++it)
+   {
+      for(std::vector<CacheSet*>::iterator set = (*it)->sets.begin(); set != (*it)->sets.end(); ++set)
+         delete *set;
+      if ((*it)->set_info)
+         delete (*it)->set_info;
+      delete *it;
+   }
 }
 
-bool ATD::isSampledSet(UInt32 set_index)
+void ATD::addShadow(String name, String configName, core_id_t core_id, String policy, UInt32 associativity, UInt32 cache_block_size)
 {
-   return m_sets.count(set_index);
+   Shadow *shadow = new Shadow();
+   shadow->policy = policy;
+   shadow->set_info = CacheSet::createCacheSetInfo(name, configName, core_id, policy, associativity, m_num_slots, cache_block_size);
+   shadow->sets.resize(m_num_slots);
+   for(UInt32 slot = 0; slot < m_num_slots; ++slot)
+   {
+      shadow->sets[slot] = CacheSet::createCacheSet(configName, core_id, policy, CacheBase::PR_L1_CACHE, associativity, 0, shadow->set_info);
+   }
+
+   registerStatsMetric(name, core_id, "loads", &shadow->loads);
+   registerStatsMetric(name, core_id, "stores", &shadow->stores);
+   registerStatsMetric(name, core_id, "load-misses", &shadow->load_misses);
+   registerStatsMetric(name, core_id, "store-misses", &shadow->store_misses);
+   registerStatsMetric(name, core_id, "loads-constructive", &shadow->loads_constructive);
+   registerStatsMetric(name, core_id, "loads-destructive", &shadow->loads_destructive);
+   registerStatsMetric(name, core_id, "stores-constructive", &shadow->stores_constructive);
+   registerStatsMetric(name, core_id, "stores-destructive", &shadow->stores_destructive);
+
+   m_shadows.push_back(shadow);
 }
 
 void ATD::access(Core::mem_op_t mem_op_type, bool cache_hit, IntPtr address)
@@ -89,47 +120,54 @@ void ATD::access(Core::mem_op_t mem_op_type, bool cache_hit, IntPtr address)
 
    if (isSampledSet(set_index))
    {
-      UInt32 line_index = -1;
-      bool atd_hit = m_sets[set_index]->find(tag, &line_index);
+      UInt32 slot = getSlot(set_index);
+      for(std::vector<Shadow*>::iterator it = m_shadows.begin(); it != m_shadows.end(); ++it)
+         access(*it, slot, tag, mem_op_type, cache_hit);
+   }
+}
 
-      if (atd_hit)
-      {
-         m_sets[set_index]->updateReplacementIndex(line_index);
-      }
-      else
-      {
-         PrL1CacheBlockInfo* cache_block_info = new PrL1CacheBlockInfo(tag, CacheState::MODIFIED);
-         bool eviction; PrL1CacheBlockInfo evict_block_info;
-         m_sets[set_index]->insert(cache_block_info, NULL, &eviction, &evict_block_info, NULL);
-         delete cache_block_info;
-      }
+void ATD::access(Shadow *shadow, UInt32 slot, IntPtr tag, Core::mem_op_t mem_op_type, bool cache_hit)
+{
+   CacheSet *set = shadow->sets[slot];
+   UInt32 line_index = -1;
+   bool atd_hit = set->find(tag, &line_index);
 
+   if (atd_hit)
+   {
+      set->updateReplacementIndex(line_index);
+   }
+   else
+   {
+      PrL1CacheBlockInfo cache_block_info(tag, CacheState::MODIFIED);
+      bool eviction; PrL1CacheBlockInfo evict_block_info;
+      set->insert(&cache_block_info, NULL, &eviction, &evict_block_info, NULL);
+   }
+
+   if (mem_op_type == Core::WRITE)
+   {
+      ++shadow->stores;
+      if (!atd_hit)
+         ++shadow->store_misses;
+   }
+   else
+   {
+      ++shadow->loads;
+      if (!atd_hit)
+         ++shadow->load_misses;
+   }
+
+   if (cache_hit && !atd_hit)
+   {
       if (mem_op_type == Core::WRITE)
-      {
-         ++stores;
-         if (!atd_hit)
-            ++store_misses;
-      }
+         ++shadow->stores_constructive;
       else
-      {
-         ++loads;
-         if (!atd_hit)
-            ++load_misses;
-      }
-
-      if (cache_hit && !atd_hit)
-      {
-         if (mem_op_type == Core::WRITE)
-            ++stores_constructive;
-         else
-            ++loads_constructive;
-      }
-      else if (!cache_hit && atd_hit)
-      {
-         if (mem_op_type == Core::WRITE)
-            ++stores_destructive;
-         else
-            ++loads_destructive;
-      }
+         ++shadow->loads_constructive;
+   }
+   else if (!cache_hit && atd_hit)
+   {
+      if (mem_op_type == Core::WRITE)
+         ++shadow->stores_destructive;
+      else
+         ++shadow->loads_destructive;
    }
 }
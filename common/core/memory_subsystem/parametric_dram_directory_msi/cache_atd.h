@@ -6,23 +6,42 @@
 #include "cache_set.h"
 #include "core.h"
 
-#include <unordered_map>
+#include <vector>
 
 class CacheSet;
 
 class ATD
 {
    private:
+      // One replacement policy simulated on the sampled sets, with its own statistics
+      struct Shadow
+      {
+         String policy;
+         CacheSetInfo *set_info;
+         std::vector<CacheSet*> sets;  // Indexed by sample slot, see getSlot()
+
+         UInt64 loads, stores;
+         UInt64 load_misses, store_misses;
+         UInt64 loads_constructive, stores_constructive;
+         UInt64 loads_destructive, stores_destructive;
+      };
+
       CacheBase m_cache_base;
-      std::unordered_map<UInt32, CacheSet*> m_sets;
-      CacheSetInfo *m_set_info;
+      std::vector<Shadow*> m_shadows;
+
+      // Bitmap of the sampled sets, and the number of sampled sets before each bitmap word,
+      // so a set's slot in the contiguous set arrays is a popcount away
+      std::vector<UInt64> m_sampled;
+      std::vector<UInt32> m_slot_base;
+      UInt32 m_num_slots;
 
-      UInt64 loads, stores;
-      UInt64 load_misses, store_misses;
-      UInt64 loads_constructive, stores_constructive;
-      UInt64 loads_destructive, stores_destructive;
+      void addShadow(String name, String configName, core_id_t core_id, String policy, UInt32 associativity, UInt32 cache_block_size);
+      void access(Shadow *shadow, UInt32 slot, IntPtr tag, Core::mem_op_t mem_op_type, bool cache_hit);
 
-      bool isSampledSet(UInt32 set_index);
+      bool isSampledSet(UInt32 set_index) const
+         { return m_sampled[set_index / 64] & (UInt64(1) << (set_index % 64)); }
+      UInt32 getSlot(UInt32 set_index) const
+         { return m_slot_base[set_index / 64] + __builtin_popcountll(m_sampled[set_index / 64] & ((UInt64(1) << (set_index % 64)) - 1)); }
 
    public:
       ATD(String name, String configName, core_id_t core_id, UInt32 num_sets, UInt32 associativity,
@@ -7,7 +7,11 @@
 #include "fault_injection.h"
 #include "hooks_manager.h"
 #include "cache_atd.h"
+#include "cache_reuse_profiler.h"
+#include "prefetch_throttle.h"
 #include "shmem_perf.h"
+#include "self_profiler.h"
+#include "qos_manager.h"
 
 #include <cstring>
 
@@ -84,7 +88,22 @@ void CacheMasterCntlr::createSetLocks(UInt32 cache_block_size, UInt32 num_sets,
 {
    m_log_blocksize = floorLog2(cache_block_size);
    m_num_sets = num_sets;
-   m_setlocks.resize(m_num_sets, SetLock(core_offset, num_cores));
+   std::vector<SetLock>(m_num_sets, SetLock(core_offset, num_cores)).swap(m_setlocks);
+
+   // Number of lock acquisitions that had to wait, summed over all sets
+   Sim()->getStatsManager()->registerMetric(new StatsMetricCallback(m_cache->getName(), core_offset, "setlock-shared-contended", getSetLockContention, (UInt64)this));
+   Sim()->getStatsManager()->registerMetric(new StatsMetricCallback(m_cache->getName(), core_offset, "setlock-exclusive-contended", getSetLockContention, (UInt64)this));
+}
+
+UInt64
+CacheMasterCntlr::getSetLockContention(String objectName, UInt32 index, String metricName, UInt64 arg)
+{
+   CacheMasterCntlr *master = (CacheMasterCntlr *)arg;
+   bool shared = metricName == "setlock-shared-contended";
+   UInt64 count = 0;
+   for(std::vector<SetLock>::const_iterator it = master->m_setlocks.begin(); it != master->m_setlocks.end(); ++it)
+      count += shared ? it->getSharedContended() : it->getExclusiveContended();
+   return count;
 }
 
 SetLock*
@@ -111,13 +130,36 @@ CacheMasterCntlr::accessATDs(Core::mem_op_t mem_op_type, bool hit, IntPtr addres
       m_atds[core_num]->access(mem_op_type, hit, address);
 }
 
+void
+CacheMasterCntlr::createReuseProfilers(String name, String configName, core_id_t master_core_id, UInt32 shared_cores, UInt32 block_size)
+{
+   // Instantiate a reuse profiler for each sharing core
+   for(UInt32 core_id = master_core_id; core_id < master_core_id + shared_cores; ++core_id)
+   {
+      m_reuse_profilers.push_back(new ReuseProfiler(name + ".reuse", configName, core_id, block_size));
+   }
+}
+
+void
+CacheMasterCntlr::accessReuseProfilers(IntPtr address, UInt32 core_num)
+{
+   if (m_reuse_profilers.size())
+      m_reuse_profilers[core_num]->access(address);
+}
+
 CacheMasterCntlr::~CacheMasterCntlr()
 {
    delete m_cache;
+   if (m_prefetch_throttle)
+      delete m_prefetch_throttle;
    for(std::vector<ATD*>::iterator it = m_atds.begin(); it != m_atds.end(); ++it)
    {
       delete *it;
    }
+   for(std::vector<ReuseProfiler*>::iterator it = m_reuse_profilers.begin(); it != m_reuse_profilers.end(); ++it)
+   {
+      delete *it;
+   }
 }
 
 CacheCntlr::CacheCntlr(MemComponent::component_t mem_component,
@@ -139,8 +181,13 @@ CacheCntlr::CacheCntlr(MemComponent::component_t mem_component,
    m_perfect(cache_params.perfect),
    m_passthrough(Sim()->getCfg()->getBoolArray("perf_model/" + cache_params.configName + "/passthrough", core_id)),
    m_coherent(cache_params.coherent),
+   m_protocol(CoherencyProtocol::parse(Sim()->getCfg()->getString("caching_protocol/variant"))),
    m_prefetch_on_prefetch_hit(false),
    m_l1_mshr(cache_params.outstanding_misses > 0),
+   m_fast_hit_path(Sim()->getCfg()->getBool("perf_model/cache/fast_hit_path")
+      && !m_perfect && !m_passthrough && !m_l1_mshr && !cache_params.writethrough),
+   m_fast_hit_path_checked(false),
+   stats(*allocStatsCounters<stats_t>(core_id)),
    m_core_id(core_id),
    m_cache_block_size(cache_block_size),
    m_cache_writethrough(cache_params.writethrough),
@@ -150,7 +197,7 @@ CacheCntlr::CacheCntlr(MemComponent::component_t mem_component,
    m_user_thread_sem(user_thread_sem),
    m_network_thread_sem(network_thread_sem),
    m_last_remote_hit_where(HitWhere::UNKNOWN),
-   m_shmem_perf(new ShmemPerf()),
+   m_shmem_perf(new ShmemPerf(Sim()->getCfg()->getBool("perf_model/cache/shmem_perf"))),
    m_shmem_perf_global(NULL),
    m_shmem_perf_model(shmem_perf_model)
 {
@@ -179,6 +226,8 @@ CacheCntlr::CacheCntlr(MemComponent::component_t mem_component,
                ? Sim()->getFaultinjectionManager()->getFaultInjector(m_core_id_master, mem_component)
                : NULL);
       m_master->m_prefetcher = Prefetcher::createPrefetcher(cache_params.prefetcher, cache_params.configName, m_core_id, m_shared_cores);
+      if (m_master->m_prefetcher)
+         m_master->m_prefetch_throttle = PrefetchThrottle::create(name, "perf_model/" + cache_params.configName, m_core_id, m_cache_block_size);
 
       if (Sim()->getCfg()->getBoolDefault("perf_model/" + cache_params.configName + "/atd/enabled", false))
       {
@@ -193,6 +242,15 @@ CacheCntlr::CacheCntlr(MemComponent::component_t mem_component,
                CacheBase::parseAddressHash(cache_params.hash_function));
       }
 
+      if (Sim()->getCfg()->getBoolDefault("perf_model/" + cache_params.configName + "/reuse_profiler/enabled", false))
+      {
+         m_master->createReuseProfilers(name,
+               "perf_model/" + cache_params.configName,
+               m_core_id,
+               m_shared_cores,
+               m_cache_block_size);
+      }
+
       Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_END, __walkUsageBits, (UInt64)this, HooksManager::ORDER_NOTIFY_PRE);
    }
    else
@@ -258,6 +316,7 @@ CacheCntlr::CacheCntlr(MemComponent::component_t mem_component,
    registerStatsMetric(name, core_id, "coherency-writebacks", &stats.coherency_writebacks);
    registerStatsMetric(name, core_id, "coherency-invalidates", &stats.coherency_invalidates);
 #ifdef ENABLE_TRANSITIONS
+   m_transition_seen.resize(1 << ceilLog2(std::max(4 * cache_params.num_sets * cache_params.associativity, 1024U)), 0);
    for(CacheState::cstate_t old_state = CacheState::CSTATE_FIRST; old_state < CacheState::NUM_CSTATE_STATES; old_state = CacheState::cstate_t(int(old_state)+1))
       for(CacheState::cstate_t new_state = CacheState::CSTATE_FIRST; new_state < CacheState::NUM_CSTATE_STATES; new_state = CacheState::cstate_t(int(new_state)+1))
          registerStatsMetric(name, core_id, String("transitions-")+CStateString(old_state)+"-"+CStateString(new_state), &stats.transitions[old_state][new_state]);
@@ -266,7 +325,7 @@ CacheCntlr::CacheCntlr(MemComponent::component_t mem_component,
          for(CacheState::cstate_t new_state = CacheState::CSTATE_FIRST; new_state < CacheState::NUM_CSTATE_SPECIAL_STATES; new_state = CacheState::cstate_t(int(new_state)+1))
             registerStatsMetric(name, core_id, String("transitions-")+ReasonString(reason)+"-"+CStateString(old_state)+"-"+CStateString(new_state), &stats.transition_reasons[reason][old_state][new_state]);
 #endif
-   if (is_last_level_cache)
+   if (is_last_level_cache && Sim()->getCfg()->getBool("perf_model/cache/shmem_perf"))
    {
       m_shmem_perf_global = new ShmemPerf();
       m_shmem_perf_totaltime = SubsecondTime::Zero();
@@ -292,9 +351,11 @@ CacheCntlr::~CacheCntlr()
    if (m_shmem_perf_global)
       delete m_shmem_perf_global;
    #ifdef TRACK_LATENCY_BY_HITWHERE
-   for(std::unordered_map<HitWhere::where_t, StatHist>::iterator it = lat_by_where.begin(); it != lat_by_where.end(); ++it) {
-      printf("%2u-%s: ", m_core_id, HitWhereString(it->first));
-      it->second.print();
+   for(int i = 0; i < HitWhere::NUM_HITWHERES; ++i) {
+      if (lat_by_where[i].count() == 0)
+         continue;
+      printf("%2u-%s: ", m_core_id, HitWhereString(HitWhere::where_t(i)));
+      lat_by_where[i].print();
    }
    #endif
 }
@@ -330,10 +391,19 @@ CacheCntlr::processMemOpFromCore(
       IntPtr ca_address, UInt32 offset,
       Byte* data_buf, UInt32 data_length,
       bool modeled,
-      bool count)
+      bool count,
+      IntPtr eip)
 {
+   SELF_PROFILE(MEMORY);
+
    HitWhere::where_t hit_where = HitWhere::MISS;
 
+   if (lock_signal == Core::NONE && useFastHitPath()
+      && processMemOpFromCoreHit(mem_op_type, ca_address, offset, data_buf, data_length, modeled, count, hit_where))
+   {
+      return hit_where;
+   }
+
    // Protect against concurrent access from sibling SMT threads
    ScopedLock sl_smt(m_master->m_smt_lock);
 
@@ -437,13 +507,18 @@ MYLOG("L1 hit");
          ScopedLock sl(getLock());
          // This is a hit, but maybe the prefetcher filled it at a future time stamp. If so, delay.
          SubsecondTime t_now = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
-         if (m_master->mshr.count(ca_address)
-            && (m_master->mshr[ca_address].t_issue < t_now && m_master->mshr[ca_address].t_complete > t_now))
+         const MshrEntry *mshr_entry = m_master->mshr.find(ca_address);
+         bool late = false;
+         if (mshr_entry
+            && (mshr_entry->t_issue < t_now && mshr_entry->t_complete > t_now))
          {
-            SubsecondTime latency = m_master->mshr[ca_address].t_complete - t_now;
+            SubsecondTime latency = mshr_entry->t_complete - t_now;
             stats.mshr_latency += latency;
             getMemoryManager()->incrElapsedTime(latency, ShmemPerfModel::_USER_THREAD);
+            late = true;
          }
+         if (prefetch_hit && m_master->m_prefetch_throttle)
+            m_master->m_prefetch_throttle->prefetchUsed(late);
       }
 
    } else {
@@ -594,7 +669,7 @@ MYLOG("access done");
 
    if (modeled && m_master->m_prefetcher)
    {
-       trainPrefetcher(ca_address, cache_hit, prefetch_hit, false, t_start);
+       trainPrefetcher(ca_address, eip, cache_hit, prefetch_hit, false, t_start);
    }
 
    // Call Prefetch on next-level caches (but not for atomic instructions as that causes a locking mess)
@@ -604,13 +679,101 @@ MYLOG("access done");
    }
 
    if (Sim()->getConfig()->getCacheEfficiencyCallbacks().notify_access_func)
-      Sim()->getConfig()->getCacheEfficiencyCallbacks().call_notify_access(cache_block_info->getOwner(), mem_op_type, hit_where);
+      Sim()->getConfig()->getCacheEfficiencyCallbacks().notify_access(m_core_id, cache_block_info->getOwner(), mem_op_type, hit_where);
 
    MYLOG("returning %s, latency %lu ns", HitWhereString(hit_where), total_latency.getNS());
    return hit_where;
 }
 
 
+bool
+CacheCntlr::useFastHitPath()
+{
+   if (!m_fast_hit_path_checked)
+   {
+      // Prefetchers are trained on, and issue their queued prefetches from, every L1 access, so they need the full path.
+      // Checked on first use, as next-level caches are only connected after construction
+      for(CacheCntlr *cntlr = this; cntlr; cntlr = cntlr->m_next_cache_cntlr)
+         if (cntlr->m_master->m_prefetcher)
+            m_fast_hit_path = false;
+      m_fast_hit_path_checked = true;
+   }
+   // Cache efficiency callbacks need usage bits propagated to the next level
+   return m_fast_hit_path && !Sim()->getConfig()->hasCacheEfficiencyCallbacks();
+}
+
+/* Fast path for L1 hits that would not do anything beyond what processMemOpFromCore does for a plain hit:
+   no atomic (lock_signal), no MSHR, perfect or pass-through cache, no prefetchers, and no per-line WARMUP/PREFETCH bookkeeping.
+   Takes only the per-cache set lock in shared mode, and a single pass through the controller lock for all statistics.
+   Returns false without doing anything when the access is not such a hit, the caller then takes the full path. */
+bool
+CacheCntlr::processMemOpFromCoreHit(
+      Core::mem_op_t mem_op_type,
+      IntPtr ca_address, UInt32 offset,
+      Byte* data_buf, UInt32 data_length,
+      bool modeled,
+      bool count,
+      HitWhere::where_t &hit_where)
+{
+   // Protect against concurrent access from sibling SMT threads
+   ScopedLock sl_smt(m_master->m_smt_lock);
+
+   acquireLock(ca_address);
+
+   CacheBlockInfo *cache_block_info;
+   if (!operationPermissibleinCache(ca_address, mem_op_type, &cache_block_info)
+      || cache_block_info->hasOption(CacheBlockInfo::WARMUP)
+      || cache_block_info->hasOption(CacheBlockInfo::PREFETCH))
+   {
+      releaseLock(ca_address);
+      return false;
+   }
+
+MYLOG("L1 hit (fast path)");
+   hit_where = (HitWhere::where_t)m_mem_component;
+
+   {
+      ScopedLock sl(getLock());
+
+      if (count)
+      {
+         getCache()->updateCounters(true);
+         updateCounters(mem_op_type, ca_address, true, getCacheState(cache_block_info), Prefetch::NONE);
+      }
+
+      getMemoryManager()->incrElapsedTime(m_mem_component, CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS, ShmemPerfModel::_USER_THREAD);
+
+      if (modeled)
+      {
+         // This is a hit, but maybe the line was filled at a future time stamp. If so, delay.
+         SubsecondTime t_now = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
+         const MshrEntry *mshr_entry = m_master->mshr.find(ca_address);
+         if (mshr_entry
+            && (mshr_entry->t_issue < t_now && mshr_entry->t_complete > t_now))
+         {
+            SubsecondTime latency = mshr_entry->t_complete - t_now;
+            stats.mshr_latency += latency;
+            getMemoryManager()->incrElapsedTime(latency, ShmemPerfModel::_USER_THREAD);
+         }
+      }
+
+      if (mem_op_type == Core::WRITE)
+         stats.stores_where[hit_where]++;
+      else
+         stats.loads_where[hit_where]++;
+   }
+
+   accessCache(mem_op_type, ca_address, offset, data_buf, data_length, count);
+
+   releaseLock(ca_address);
+
+   if (Sim()->getConfig()->getCacheEfficiencyCallbacks().notify_access_func)
+      Sim()->getConfig()->getCacheEfficiencyCallbacks().notify_access(m_core_id, cache_block_info->getOwner(), mem_op_type, hit_where);
+
+   return true;
+}
+
+
 void
 CacheCntlr::updateHits(Core::mem_op_t mem_op_type, UInt64 hits)
 {
@@ -666,17 +829,19 @@ MYLOG("copyDataFromNextLevel l%d", m_mem_component);
 }
 
 void
-CacheCntlr::trainPrefetcher(IntPtr address, bool cache_hit, bool prefetch_hit, bool prefetch_own, SubsecondTime t_issue)
+CacheCntlr::trainPrefetcher(IntPtr address, IntPtr eip, bool cache_hit, bool prefetch_hit, bool prefetch_own, SubsecondTime t_issue)
 {
    ScopedLock sl(getLock());
 
-   std::vector<IntPtr> prefetchList;
+   IntPtr prefetchList[Prefetcher::MAX_PREFETCHES];
+   UInt32 numPrefetches = 0;
 
    bool prefetcherTrained;
 
    // Train the prefetcher always or only on misses on lines that are not being brought by the prefetcher (load or store miss)
    if (m_train_prefetcher_on_hit || (!prefetch_own && !cache_hit)) {
-      prefetchList = m_master->m_prefetcher->getNextAddress(address, m_core_id);
+      Prefetcher::Access access = { address, eip, m_core_id };
+      numPrefetches = m_master->m_prefetcher->getNextAddresses(access, prefetchList, Prefetcher::MAX_PREFETCHES);
       prefetcherTrained = true;
    }
    else prefetcherTrained = false;
@@ -689,13 +854,22 @@ CacheCntlr::trainPrefetcher(IntPtr address, bool cache_hit, bool prefetch_hit, b
       // Just talked to the next-level cache, wait a bit before we start to prefetch if enabled
       m_master->m_prefetch_next = m_prefetch_delay ? t_issue + PREFETCH_INTERVAL:t_issue;
 
-      for(std::vector<IntPtr>::iterator it = prefetchList.begin(); it != prefetchList.end(); ++it)
+      // With throttling, only look at the first <distance> candidates and queue at most <degree> of them
+      UInt32 degree = numPrefetches;
+      if (m_master->m_prefetch_throttle)
+      {
+         numPrefetches = std::min(numPrefetches, m_master->m_prefetch_throttle->getDistance());
+         degree = m_master->m_prefetch_throttle->getDegree();
+      }
+
+      for(UInt32 i = 0; i < numPrefetches && degree > 0; ++i)
       {
          // Keep at most PREFETCH_MAX_QUEUE_LENGTH entries in the prefetch queue
          if (m_master->m_prefetch_list.size() > PREFETCH_MAX_QUEUE_LENGTH)
             break;
-         if (!operationPermissibleinCache(*it, Core::READ)) {
-            m_master->m_prefetch_list.push_back(*it);
+         if (!operationPermissibleinCache(prefetchList[i], Core::READ)) {
+            m_master->m_prefetch_list.push(prefetchList[i]);
+            --degree;
          }
       }
    }
@@ -714,7 +888,7 @@ CacheCntlr::Prefetch(SubsecondTime t_now)
          while(!m_master->m_prefetch_list.empty())
          {
             IntPtr address = m_master->m_prefetch_list.front();
-            m_master->m_prefetch_list.pop_front();
+            m_master->m_prefetch_list.pop();
 
             // Check address again, maybe some other core already brought it into the cache
             if (!operationPermissibleinCache(address, Core::READ))
@@ -746,6 +920,11 @@ void
 CacheCntlr::doPrefetch(IntPtr prefetch_address, SubsecondTime t_start)
 {
    ++stats.prefetches;
+   if (m_master->m_prefetch_throttle)
+   {
+      ScopedLock sl(getLock());
+      m_master->m_prefetch_throttle->prefetchIssued();
+   }
    acquireStackLock(prefetch_address);
    MYLOG("prefetching %lx", prefetch_address);
    SubsecondTime t_before = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
@@ -844,17 +1023,22 @@ CacheCntlr::processShmemReqFromPrevCache(CacheCntlr* requester, Core::mem_op_t m
          ScopedLock sl(getLock());
          // This is a hit, but maybe the prefetcher filled it at a future time stamp. If so, delay.
          SubsecondTime t_now = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
-         if (m_master->mshr.count(address)
-            && (m_master->mshr[address].t_issue < t_now && m_master->mshr[address].t_complete > t_now))
+         const MshrEntry *mshr_entry = m_master->mshr.find(address);
+         bool late = false;
+         if (mshr_entry
+            && (mshr_entry->t_issue < t_now && mshr_entry->t_complete > t_now))
          {
-            SubsecondTime latency = m_master->mshr[address].t_complete - t_now;
+            SubsecondTime latency = mshr_entry->t_complete - t_now;
             stats.mshr_latency += latency;
             getMemoryManager()->incrElapsedTime(latency, ShmemPerfModel::_USER_THREAD);
+            late = true;
          }
          else
          {
             getMemoryManager()->incrElapsedTime(m_mem_component, CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS, ShmemPerfModel::_USER_THREAD);
          }
+         if (prefetch_hit && m_master->m_prefetch_throttle)
+            m_master->m_prefetch_throttle->prefetchUsed(late);
       }
 
       if (mem_op_type != Core::READ) // write that hits
@@ -927,9 +1111,9 @@ CacheCntlr::processShmemReqFromPrevCache(CacheCntlr* requester, Core::mem_op_t m
       if (modeled)
          getMemoryManager()->incrElapsedTime(m_mem_component, CachePerfModel::ACCESS_CACHE_TAGS, ShmemPerfModel::_USER_THREAD);
 
-      if (cache_block_info && (cache_block_info->getCState() == CacheState::SHARED))
+      if (cache_block_info && (cache_block_info->getCState() == CacheState::SHARED || cache_block_info->getCState() == CacheState::OWNED))
       {
-         // Data is present, but still no cache_hit => this is a write on a SHARED block. Do Upgrade
+         // Data is present, but still no cache_hit => this is a write on a SHARED (or OWNED) block. Do Upgrade
          SubsecondTime latency = SubsecondTime::Zero();
          for(CacheCntlrList::iterator it = m_master->m_prev_cache_cntlrs.begin(); it != m_master->m_prev_cache_cntlrs.end(); it++)
             if (*it != requester)
@@ -1031,7 +1215,7 @@ CacheCntlr::processShmemReqFromPrevCache(CacheCntlr* requester, Core::mem_op_t m
 
    if (modeled && m_master->m_prefetcher)
    {
-      trainPrefetcher(address, cache_hit, prefetch_hit, isPrefetch == Prefetch::prefetch_type_t::OWN, t_issue);
+      trainPrefetcher(address, 0, cache_hit, prefetch_hit, isPrefetch == Prefetch::prefetch_type_t::OWN, t_issue);
    }
 
    #ifdef PRIVATE_L2_OPTIMIZATION
@@ -1172,7 +1356,7 @@ CacheCntlr::initiateDirectoryAccess(Core::mem_op_t mem_op_type, IntPtr address,
       if (exclusive)
       {
          SharedCacheBlockInfo* cache_block_info = getCacheBlockInfo(address);
-         if (cache_block_info && (cache_block_info->getCState() == CacheState::SHARED))
+         if (cache_block_info && (cache_block_info->getCState() == CacheState::SHARED || cache_block_info->getCState() == CacheState::OWNED))
          {
             processUpgradeReqToDirectory(address, m_shmem_perf, ShmemPerfModel::_USER_THREAD);
          }
@@ -1219,8 +1403,9 @@ CacheCntlr::processUpgradeReqToDirectory(IntPtr address, ShmemPerf *perf, ShmemP
    // We need to send a request to the Dram Directory Cache
    MYLOG("UPGR REQ @ %lx", address);
 
+   // An OWNED line keeps its data while upgrading, the directory flushes it if another request wins the race
    CacheState::cstate_t cstate = getCacheState(address);
-   assert(cstate == CacheState::SHARED);
+   assert(cstate == CacheState::SHARED || cstate == CacheState::OWNED);
    setCacheState(address, CacheState::SHARED_UPGRADING);
 
    getMemoryManager()->sendMsg(PrL1PrL2DramDirectoryMSI::ShmemMsg::UPGRADE_REQ,
@@ -1351,6 +1536,15 @@ CacheCntlr::setCacheState(IntPtr address, CacheState::cstate_t cstate)
    return cache_block_info;
 }
 
+void
+CacheCntlr::notifyFetchBuffers(IntPtr address)
+{
+   // Cores keep recently fetched L1-I lines, which are only valid as long as the L1-I has them
+   if (m_mem_component == MemComponent::L1_ICACHE)
+      for(core_id_t core_id = m_core_id_master; core_id < m_core_id_master + (core_id_t)m_shared_cores; ++core_id)
+         Sim()->getCoreManager()->getCoreFromID(core_id)->invalidateFetchBuffer(address);
+}
+
 void
 CacheCntlr::invalidateCacheBlock(IntPtr address)
 {
@@ -1358,7 +1552,11 @@ CacheCntlr::invalidateCacheBlock(IntPtr address)
    assert(old_cstate != CacheState::MODIFIED);
    assert(old_cstate != CacheState::INVALID);
 
+   if (!m_next_cache_cntlr && Sim()->getQosManager() && !Sim()->getConfig()->hasCacheEfficiencyCallbacks())
+      Sim()->getQosManager()->removeLine(m_master->m_cache->peekSingleLine(address)->getOwner());
+
    m_master->m_cache->invalidateSingleLine(address);
+   notifyFetchBuffers(address);
 
    if (m_next_cache_cntlr)
       m_next_cache_cntlr->notifyPrevLevelEvict(m_core_id_master, m_mem_component, address);
@@ -1390,11 +1588,25 @@ MYLOG("insertCacheBlock l%d @ %lx as %c (now %c)", m_mem_component, address, CSt
 
    LOG_ASSERT_ERROR(getCacheState(address) == CacheState::INVALID, "we already have this line, can't add it again");
 
+   // Cache allocation and occupancy monitoring of the last-level cache. Occupancy uses the line's owner field,
+   // so it is not tracked when the cache efficiency callbacks use it.
+   QosManager *qos = m_next_cache_cntlr ? NULL : Sim()->getQosManager();
+   bool qos_monitor = qos && !Sim()->getConfig()->hasCacheEfficiencyCallbacks();
+
    m_master->m_cache->insertSingleLine(address, data_buf,
          &eviction, &evict_address, &evict_block_info, evict_buf,
-         getShmemPerfModel()->getElapsedTime(thread_num), this);
+         getShmemPerfModel()->getElapsedTime(thread_num), this,
+         qos ? qos->getCoreWayMask(requester) : 0);
    SharedCacheBlockInfo* cache_block_info = setCacheState(address, cstate);
 
+   if (qos_monitor)
+   {
+      cache_block_info->setOwner(requester);
+      qos->insertLine(requester);
+      if (eviction)
+         qos->removeLine(evict_block_info.getOwner());
+   }
+
    if (Sim()->getInstrumentationMode() == InstMode::CACHE_ONLY)
       cache_block_info->setOption(CacheBlockInfo::WARMUP);
 
@@ -1409,6 +1621,7 @@ MYLOG("insertCacheBlock l%d local done", m_mem_component);
    if (eviction)
    {
 MYLOG("evicting @%lx", evict_address);
+      notifyFetchBuffers(evict_address);
 
       if (
          !m_next_cache_cntlr // Track at LLC
@@ -1416,7 +1629,7 @@ MYLOG("evicting @%lx", evict_address);
          && Sim()->getConfig()->hasCacheEfficiencyCallbacks()
       )
       {
-         Sim()->getConfig()->getCacheEfficiencyCallbacks().call_notify_evict(false, evict_block_info.getOwner(), cache_block_info->getOwner(), evict_block_info.getUsage(), getCacheBlockSize() >> CacheBlockInfo::BitsUsedOffset);
+         Sim()->getConfig()->getCacheEfficiencyCallbacks().notify_evict(requester, evict_block_info.getOwner(), cache_block_info->getOwner(), evict_block_info.getUsage(), getCacheBlockSize() >> CacheBlockInfo::BitsUsedOffset);
       }
 
       CacheState::cstate_t old_state = evict_block_info.getCState();
@@ -1434,6 +1647,8 @@ MYLOG("evicting @%lx", evict_address);
          // Line was prefetched, but is evicted without ever being used
          if (evict_block_info.hasOption(CacheBlockInfo::PREFETCH))
             ++stats.evict_prefetch;
+         if (m_master->m_prefetch_throttle)
+            m_master->m_prefetch_throttle->evicted(evict_address, address);
          if (evict_block_info.hasOption(CacheBlockInfo::WARMUP))
             ++stats.evict_warmup;
       }
@@ -1513,7 +1728,7 @@ MYLOG("evicting @%lx", evict_address);
       {
          /* Send dirty block to directory */
          UInt32 home_node_id = getHome(evict_address);
-         if (evict_block_info.getCState() == CacheState::MODIFIED)
+         if (evict_block_info.getCState() == CacheState::MODIFIED || evict_block_info.getCState() == CacheState::OWNED)
          {
             // Send back the data also
 MYLOG("evict FLUSH %lx", evict_address);
@@ -1565,8 +1780,10 @@ CacheCntlr::updateCacheBlock(IntPtr address, CacheState::cstate_t new_cstate, Tr
    if (! m_master->m_prev_cache_cntlrs.empty())
    {
       for(CacheCntlrList::iterator it = m_master->m_prev_cache_cntlrs.begin(); it != m_master->m_prev_cache_cntlrs.end(); it++) {
+         // Only the last-level cache can own a line, previous levels keep a SHARED copy
          std::pair<SubsecondTime, bool> res = (*it)->updateCacheBlock(
-            address, new_cstate, reason == Transition::EVICT ? Transition::BACK_INVAL : reason, NULL, thread_num);
+            address, new_cstate == CacheState::OWNED ? CacheState::SHARED : new_cstate,
+            reason == Transition::EVICT ? Transition::BACK_INVAL : reason, NULL, thread_num);
          // writeback_time is for the complete stack, so only model it at the last level, ignore latencies returned by previous ones
          //latency = getMax<SubsecondTime>(latency, res.first);
          sibling_hit |= res.second;
@@ -1604,7 +1821,7 @@ CacheCntlr::updateCacheBlock(IntPtr address, CacheState::cstate_t new_cstate, Tr
          );
          if (reason == Transition::COHERENCY)
          {
-            if (new_cstate == CacheState::SHARED)
+            if (new_cstate == CacheState::SHARED || new_cstate == CacheState::OWNED)
                ++stats.coherency_downgrades;
             else if (cache_block_info->getCState() == CacheState::MODIFIED)
                ++stats.coherency_writebacks;
@@ -1625,7 +1842,10 @@ CacheCntlr::updateCacheBlock(IntPtr address, CacheState::cstate_t new_cstate, Tr
          }
       }
 
-      if (cache_block_info->getCState() == CacheState::MODIFIED) {
+      if (new_cstate == CacheState::INVALID)
+         notifyFetchBuffers(address);
+
+      if (cache_block_info->getCState() == CacheState::MODIFIED && new_cstate != CacheState::OWNED) {
          /* data is modified, write it back */
 
          if (m_cache_writethrough) {
@@ -1678,6 +1898,19 @@ CacheCntlr::updateCacheBlock(IntPtr address, CacheState::cstate_t new_cstate, Tr
 
          cache_block_info->setCState(new_cstate);
       }
+      else if (new_cstate == CacheState::OWNED)
+      {
+         /* MOESI downgrade: hand out the data but keep it, dirty */
+         if (out_buf)
+         {
+            retrieveCacheBlock(address, out_buf, thread_num, false);
+            buf_written = true;
+            is_writeback = true;
+            sibling_hit = true;
+         }
+
+         cache_block_info->setCState(new_cstate);
+      }
       else if (new_cstate == CacheState::MODIFIED)
       {
          cache_block_info->setCState(new_cstate);
@@ -1950,7 +2183,12 @@ CacheCntlr::processInvReqFromDramDirectory(core_id_t sender, PrL1PrL2DramDirecto
 MYLOG("processInvReqFromDramDirectory l%d", m_mem_component);
 
    CacheState::cstate_t cstate = getCacheState(address);
-   if (cstate != CacheState::INVALID)
+   if (cstate == CacheState::OWNED)
+   {
+      // We have the only up-to-date copy (broadcast invalidations don't know who owns the line): flush it
+      processFlushReqFromDramDirectory(sender, shmem_msg);
+   }
+   else if (cstate != CacheState::INVALID)
    {
       if (cstate != CacheState::SHARED)
       {
@@ -2034,11 +2272,13 @@ MYLOG("processWbReqFromDramDirectory l%d", m_mem_component);
       // Update Shared Mem perf counters for access to L2 Cache
       getMemoryManager()->incrElapsedTime(m_mem_component, CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS, ShmemPerfModel::_SIM_THREAD);
 
-      // Write-Back the line
+      // Write-Back the line. With MOESI, the owner keeps the data without writing it back to memory.
+      // Exclusive lines also become OWNED, the directory cannot tell whether they were silently upgraded.
       Byte data_buf[getCacheBlockSize()];
       if (cstate != CacheState::SHARED_UPGRADING)
       {
-         updateCacheBlock(address, CacheState::SHARED, Transition::COHERENCY, data_buf, ShmemPerfModel::_SIM_THREAD);
+         bool keep_owned = m_protocol == CoherencyProtocol::MOESI && cstate != CacheState::SHARED;
+         updateCacheBlock(address, keep_owned ? CacheState::OWNED : CacheState::SHARED, Transition::COHERENCY, data_buf, ShmemPerfModel::_SIM_THREAD);
       }
 
       shmem_msg->getPerf()->updateTime(getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_SIM_THREAD), ShmemPerf::REMOTE_CACHE_FWD);
@@ -2073,11 +2313,27 @@ CacheCntlr::updateCounters(Core::mem_op_t mem_op_type, IntPtr address, bool cach
       operationPermissibleinCache() will think it's a hit (so cache_hit == true) since the processing
       of the previous miss was done instantaneously. But mshr[address] contains its completion time */
    SubsecondTime t_now = getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD);
-   bool overlapping = m_master->mshr.count(address) && m_master->mshr[address].t_issue < t_now && m_master->mshr[address].t_complete > t_now;
+   const MshrEntry *mshr_entry = m_master->mshr.find(address);
+   bool overlapping = mshr_entry && mshr_entry->t_issue < t_now && mshr_entry->t_complete > t_now;
 
    // ATD doesn't track state, so when reporting hit/miss to it we shouldn't either (i.e. write hit to shared line becomes hit, not miss)
    bool cache_data_hit = (state != CacheState::INVALID);
    m_master->accessATDs(mem_op_type, cache_data_hit, address, m_core_id - m_core_id_master);
+   // Batched hits from updateHits() don't carry their (unknown) line address
+   if (isPrefetch != Prefetch::OWN && address != 0)
+      m_master->accessReuseProfilers(address, m_core_id - m_core_id_master);
+
+   // A demand miss to a line that was pushed out by a prefetched line which is still unused means prefetching polluted the cache
+   if (m_master->m_prefetch_throttle && isPrefetch == Prefetch::NONE && !cache_data_hit && address != 0)
+   {
+      IntPtr displacer = m_master->m_prefetch_throttle->demandMiss(address);
+      if (displacer != INVALID_ADDRESS)
+      {
+         SharedCacheBlockInfo* displacer_info = getCacheBlockInfo(displacer);
+         if (displacer_info && displacer_info->hasOption(CacheBlockInfo::PREFETCH))
+            m_master->m_prefetch_throttle->polluted();
+      }
+   }
 
    if (mem_op_type == Core::WRITE)
    {
@@ -2125,14 +2381,14 @@ CacheCntlr::updateCounters(Core::mem_op_t mem_op_type, IntPtr address, bool cach
 void
 CacheCntlr::cleanupMshr()
 {
-   /* Keep only last 8 MSHR entries */
-   while(m_master->mshr.size() > 8) {
+   /* Keep only last MSHR_HISTORY_LENGTH MSHR entries */
+   while(m_master->mshr.size() > MSHR_HISTORY_LENGTH) {
       IntPtr address_min = 0;
       SubsecondTime time_min = SubsecondTime::MaxTime();
       for(Mshr::iterator it = m_master->mshr.begin(); it != m_master->mshr.end(); ++it) {
-         if (it->second.t_complete < time_min) {
-            address_min = it->first;
-            time_min = it->second.t_complete;
+         if (it->value.t_complete < time_min) {
+            address_min = it->key;
+            time_min = it->value.t_complete;
          }
       }
       m_master->mshr.erase(address_min);
@@ -2144,16 +2400,19 @@ CacheCntlr::transition(IntPtr address, Transition::reason_t reason, CacheState::
 {
 #ifdef ENABLE_TRANSITIONS
    stats.transitions[old_state][new_state]++;
+   UInt64 line = address / m_cache_block_size;
+   UInt64 &seen = m_transition_seen[(line * 0x9e3779b97f4a7c15ULL >> 32) & (m_transition_seen.size() - 1)];
    if (old_state == CacheState::INVALID) {
-      if (stats.seen.count(address) == 0)
+      Transition::reason_t last = Transition::reason_t((seen & 7) - 1);
+      if ((seen >> 3) != line || seen == 0)
          old_state = CacheState::INVALID_COLD;
-      else if (stats.seen[address] == Transition::EVICT || stats.seen[address] == Transition::BACK_INVAL)
+      else if (last == Transition::EVICT || last == Transition::BACK_INVAL)
          old_state = CacheState::INVALID_EVICT;
-      else if (stats.seen[address] == Transition::COHERENCY)
+      else if (last == Transition::COHERENCY)
          old_state = CacheState::INVALID_COHERENCY;
    }
    stats.transition_reasons[reason][old_state][new_state]++;
-   stats.seen[address] = reason;
+   seen = (line << 3) | (reason + 1);
 #endif
 }
 
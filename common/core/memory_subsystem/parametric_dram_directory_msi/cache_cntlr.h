@@ -14,14 +14,19 @@
 #include "shmem_perf_model.h"
 #include "contention_model.h"
 #include "req_queue_list_template.h"
+#include "flat_address_map.h"
+#include "flat_ring.h"
 #include "stats.h"
 #include "subsecond_time.h"
 #include "shmem_perf.h"
+#include "coherency_protocol.h"
 
 #include "boost/tuple/tuple.hpp"
 
 class DramCntlrInterface;
 class ATD;
+class ReuseProfiler;
+class PrefetchThrottle;
 
 /* Enable to get a detailed count of state transitions */
 //#define ENABLE_TRANSITIONS
@@ -42,6 +47,8 @@ class ShmemPerf;
 #define PREFETCH_MAX_QUEUE_LENGTH 32
 // Time between prefetches
 #define PREFETCH_INTERVAL SubsecondTime::NS(1)
+// Number of completed misses kept to detect overlapping accesses
+#define MSHR_HISTORY_LENGTH 8
 
 namespace ParametricDramDirectoryMSI
 {
@@ -144,7 +151,7 @@ namespace ParametricDramDirectoryMSI
    struct MshrEntry {
       SubsecondTime t_issue, t_complete;
    };
-   typedef std::unordered_map<IntPtr, MshrEntry> Mshr;
+   typedef FlatAddressMap<MshrEntry> Mshr;
 
    class CacheMasterCntlr
    {
@@ -154,6 +161,7 @@ namespace ParametricDramDirectoryMSI
          Lock m_smt_lock; //< Only used in L1 cache, to protect against concurrent access from sibling SMT threads
          CacheCntlrList m_prev_cache_cntlrs;
          Prefetcher* m_prefetcher;
+         PrefetchThrottle* m_prefetch_throttle;
          DramCntlrInterface* m_dram_cntlr;
          ContentionModel* m_dram_outstanding_writebacks;
 
@@ -165,32 +173,40 @@ namespace ParametricDramDirectoryMSI
          Byte* m_evicting_buf;
 
          std::vector<ATD*> m_atds;
+         std::vector<ReuseProfiler*> m_reuse_profilers;
 
          std::vector<SetLock> m_setlocks;
          UInt32 m_log_blocksize;
          UInt32 m_num_sets;
 
-         std::deque<IntPtr> m_prefetch_list;
+         FlatRing<IntPtr> m_prefetch_list;
          SubsecondTime m_prefetch_next;
 
          void createSetLocks(UInt32 cache_block_size, UInt32 num_sets, UInt32 core_offset, UInt32 num_cores);
          SetLock* getSetLock(IntPtr addr);
+         static UInt64 getSetLockContention(String objectName, UInt32 index, String metricName, UInt64 arg);
 
          void createATDs(String name, String configName, core_id_t core_id, UInt32 shared_cores, UInt32 size, UInt32 associativity, UInt32 block_size,
             String replacement_policy, CacheBase::hash_t hash_function);
          void accessATDs(Core::mem_op_t mem_op_type, bool hit, IntPtr address, UInt32 core_num);
+         void createReuseProfilers(String name, String configName, core_id_t core_id, UInt32 shared_cores, UInt32 block_size);
+         void accessReuseProfilers(IntPtr address, UInt32 core_num);
 
          CacheMasterCntlr(String name, core_id_t core_id, UInt32 outstanding_misses)
             : m_cache(NULL)
             , m_prefetcher(NULL)
+            , m_prefetch_throttle(NULL)
             , m_dram_cntlr(NULL)
             , m_dram_outstanding_writebacks(NULL)
+            , mshr(MSHR_HISTORY_LENGTH + 1)
             , m_l1_mshr(name + ".mshr", core_id, outstanding_misses)
             , m_next_level_read_bandwidth(name + ".next_read", core_id)
+            , m_directory_waiters(std::max(outstanding_misses, (UInt32)MSHR_HISTORY_LENGTH))
             , m_evicting_address(0)
             , m_evicting_buf(NULL)
             , m_atds()
-            , m_prefetch_list()
+            , m_reuse_profilers()
+            , m_prefetch_list(PREFETCH_MAX_QUEUE_LENGTH + 1)
             , m_prefetch_next(SubsecondTime::Zero())
          {}
          ~CacheMasterCntlr();
@@ -208,16 +224,19 @@ namespace ParametricDramDirectoryMSI
          CacheCntlr* m_next_cache_cntlr;
          CacheCntlr* m_last_level;
          AddressHomeLookup* m_tag_directory_home_lookup;
-         std::unordered_map<IntPtr, MemComponent::component_t> m_shmem_req_source_map;
          bool m_perfect;
          bool m_passthrough;
          bool m_coherent;
+         CoherencyProtocol::type_t m_protocol;  // MOESI: the last-level cache keeps written-back lines as OWNED
          bool m_prefetch_on_prefetch_hit;
          bool m_train_prefetcher_on_hit;
          bool m_prefetch_delay;
          bool m_l1_mshr;
+         bool m_fast_hit_path;         // perf_model/cache/fast_hit_path, and no feature of this cache prevents it
+         bool m_fast_hit_path_checked; // Whether next-level caches have been checked for prefetchers
 
-         struct {
+         // Counters in per-core storage (see allocStatsCounters)
+         struct stats_t {
            UInt64 loads, stores;
            UInt64 load_misses, store_misses;
            UInt64 load_overlapping_misses, store_overlapping_misses;
@@ -244,11 +263,16 @@ namespace ParametricDramDirectoryMSI
            #ifdef ENABLE_TRANSITIONS
            UInt64 transitions[CacheState::NUM_CSTATE_SPECIAL_STATES][CacheState::NUM_CSTATE_SPECIAL_STATES];
            UInt64 transition_reasons[Transition::NUM_REASONS][CacheState::NUM_CSTATE_SPECIAL_STATES][CacheState::NUM_CSTATE_SPECIAL_STATES];
-           std::unordered_map<IntPtr, Transition::reason_t> seen;
            #endif
-         } stats;
+         } &stats;
+         #ifdef ENABLE_TRANSITIONS
+         // Reason of the last transition per line, (line << 3) | (reason + 1), to tell cold misses from misses after an eviction
+         // or invalidation. Direct-mapped and a few times the size of the cache: lines that have been out of the cache for long,
+         // or that lost their entry to a collision, count as cold.
+         std::vector<UInt64> m_transition_seen;
+         #endif
          #ifdef TRACK_LATENCY_BY_HITWHERE
-         std::unordered_map<HitWhere::where_t, StatHist> lat_by_where;
+         StatHist lat_by_where[HitWhere::NUM_HITWHERES];
          #endif
 
          void updateCounters(Core::mem_op_t mem_op_type, IntPtr address, bool cache_hit, CacheState::cstate_t state, Prefetch::prefetch_type_t isPrefetch);
@@ -286,7 +310,7 @@ namespace ParametricDramDirectoryMSI
                IntPtr address, Core::mem_op_t mem_op_type, CacheBlockInfo **cache_block_info = NULL);
 
          void copyDataFromNextLevel(Core::mem_op_t mem_op_type, IntPtr address, bool modeled, SubsecondTime t_start);
-         void trainPrefetcher(IntPtr address, bool cache_hit, bool prefetch_hit, bool prefetch_own, SubsecondTime t_issue);
+         void trainPrefetcher(IntPtr address, IntPtr eip, bool cache_hit, bool prefetch_hit, bool prefetch_own, SubsecondTime t_issue);
          void Prefetch(SubsecondTime t_start);
          void doPrefetch(IntPtr prefetch_address, SubsecondTime t_start);
 
@@ -298,6 +322,7 @@ namespace ParametricDramDirectoryMSI
 
          // Cache data operations
          void invalidateCacheBlock(IntPtr address);
+         void notifyFetchBuffers(IntPtr address);
          void retrieveCacheBlock(IntPtr address, Byte* data_buf, ShmemPerfModel::Thread_t thread_num, bool update_replacement);
 
 
@@ -350,6 +375,16 @@ namespace ParametricDramDirectoryMSI
 
          CacheCntlr* lastLevelCache(void);
 
+         // L1 hits that need nothing beyond a state check, replacement update and latency charge
+         bool useFastHitPath(void);
+         bool processMemOpFromCoreHit(
+               Core::mem_op_t mem_op_type,
+               IntPtr ca_address, UInt32 offset,
+               Byte* data_buf, UInt32 data_length,
+               bool modeled,
+               bool count,
+               HitWhere::where_t &hit_where);
+
       public:
 
          CacheCntlr(MemComponent::component_t mem_component,
@@ -367,6 +402,7 @@ namespace ParametricDramDirectoryMSI
          virtual ~CacheCntlr();
 
          Cache* getCache() { return m_master->m_cache; }
+         Prefetcher* getPrefetcher() { return m_master->m_prefetcher; }
          Lock& getLock() { return m_master->m_cache_lock; }
 
          void setPrevCacheCntlrs(CacheCntlrList& prev_cache_cntlrs);
@@ -380,7 +416,8 @@ namespace ParametricDramDirectoryMSI
                IntPtr ca_address, UInt32 offset,
                Byte* data_buf, UInt32 data_length,
                bool modeled,
-               bool count);
+               bool count,
+               IntPtr eip = 0);
          void updateHits(Core::mem_op_t mem_op_type, UInt64 hits);
 
          // Notify next level cache of so it can update its sharing set
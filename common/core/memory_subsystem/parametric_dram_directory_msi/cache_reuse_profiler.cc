@@ -0,0 +1,95 @@
+#include "cache_reuse_profiler.h"
+#include "simulator.h"
+#include "stats.h"
+#include "config.hpp"
+#include "utils.h"
+
+#include <algorithm>
+
+ReuseProfiler::ReuseProfiler(String name, String configName, core_id_t core_id, UInt32 cache_block_size)
+   : m_log_blocksize(floorLog2(cache_block_size))
+   , m_sampling(Sim()->getCfg()->getIntArray(configName + "/reuse_profiler/sampling", core_id))
+   , m_tree(MIN_TREE_SIZE + 1, 0)
+   , m_time(0)
+   , m_accesses(0)
+   , m_cold_misses(0)
+{
+   LOG_ASSERT_ERROR(m_sampling > 0, "%s/reuse_profiler/sampling must be at least 1", configName.c_str());
+
+   for(UInt32 bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+      m_histogram[bucket] = 0;
+
+   registerStatsMetric(name, core_id, "accesses", &m_accesses);
+   registerStatsMetric(name, core_id, "cold-misses", &m_cold_misses);
+   for(UInt32 bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+      registerStatsMetric(name, core_id, "distance-" + itostr(bucket), &m_histogram[bucket]);
+}
+
+bool ReuseProfiler::isSampled(IntPtr line) const
+{
+   // Use the high bits of a multiplicative hash, so that strided addresses are sampled uniformly
+   return m_sampling == 1 || ((line * 0x9e3779b97f4a7c15ULL) >> 32) % m_sampling == 0;
+}
+
+void ReuseProfiler::access(IntPtr address)
+{
+   IntPtr line = address >> m_log_blocksize;
+   if (!isSampled(line))
+      return;
+
+   ++m_accesses;
+   if (m_time + 1 >= m_tree.size())
+      compact();
+   ++m_time;
+
+   auto it = m_last_access.find(line);
+   if (it == m_last_access.end())
+   {
+      ++m_cold_misses;
+      m_last_access[line] = m_time;
+   }
+   else
+   {
+      // Every sampled line has a single one in the tree, so the lines touched after the previous access
+      // to this line are all lines minus the ones whose most recent access came before it
+      UInt64 distance = (m_last_access.size() - treeSum(it->second)) * m_sampling;
+      UInt32 bucket = distance == 0 ? 0 : 64 - __builtin_clzll(distance);
+      ++m_histogram[std::min(bucket, NUM_BUCKETS - 1)];
+
+      treeAdd(it->second, -1);
+      it->second = m_time;
+   }
+   treeAdd(m_time, 1);
+}
+
+void ReuseProfiler::treeAdd(UInt64 time, SInt32 delta)
+{
+   for( ; time < m_tree.size(); time += time & -time)
+      m_tree[time] += delta;
+}
+
+UInt64 ReuseProfiler::treeSum(UInt64 time) const
+{
+   UInt64 sum = 0;
+   for( ; time > 0; time -= time & -time)
+      sum += m_tree[time];
+   return sum;
+}
+
+void ReuseProfiler::compact()
+{
+   // Out of timestamps: renumber the most recent accesses to 1..N, preserving their order, and rebuild the tree
+   std::vector<std::pair<UInt64, IntPtr> > lines;
+   lines.reserve(m_last_access.size());
+   for(auto it = m_last_access.begin(); it != m_last_access.end(); ++it)
+      lines.push_back(std::make_pair(it->second, it->first));
+   std::sort(lines.begin(), lines.end());
+
+   m_tree.assign(std::max(MIN_TREE_SIZE, 2 * (UInt64)lines.size()) + 1, 0);
+   m_time = 0;
+   for(auto it = lines.begin(); it != lines.end(); ++it)
+   {
+      m_last_access[it->second] = ++m_time;
+      treeAdd(m_time, 1);
+   }
+}
@@ -0,0 +1,45 @@
+#ifndef __CACHE_REUSE_PROFILER_H
+#define __CACHE_REUSE_PROFILER_H
+
+#include "fixed_types.h"
+#include "core.h"
+
+#include <unordered_map>
+#include <vector>
+
+// One-pass stack (reuse) distance profiler, attached to a cache level like an ATD.
+// Stack distances are computed exactly for a spatially sampled subset of the cache lines (SHARDS: a line is sampled when
+// a hash of its address falls in 1/sampling of the hash space) and scaled back up by the sampling factor.
+// The distance of an access is the number of distinct lines touched since the previous access to the same line,
+// found with a Fenwick tree holding a one at the time of each line's most recent access.
+// The resulting histogram has bucket b = ceil(log2(distance + 1)), so a fully-associative LRU cache of 2^k lines
+// would miss on all cold accesses plus all accesses in buckets k+1 and up: one simulation yields the miss-ratio curve.
+
+class ReuseProfiler
+{
+   private:
+      static const UInt32 NUM_BUCKETS = 40;
+      static const UInt64 MIN_TREE_SIZE = 1 << 16;
+
+      const UInt32 m_log_blocksize;
+      const UInt32 m_sampling;
+
+      std::unordered_map<IntPtr, UInt64> m_last_access; // Sampled line -> time of its most recent access
+      std::vector<UInt32> m_tree;                       // Fenwick tree over access times (1-based)
+      UInt64 m_time;
+
+      UInt64 m_accesses, m_cold_misses;
+      UInt64 m_histogram[NUM_BUCKETS];
+
+      bool isSampled(IntPtr line) const;
+      void treeAdd(UInt64 time, SInt32 delta);
+      UInt64 treeSum(UInt64 time) const;
+      void compact();
+
+   public:
+      ReuseProfiler(String name, String configName, core_id_t core_id, UInt32 cache_block_size);
+
+      void access(IntPtr address);
+};
+
+#endif // __CACHE_REUSE_PROFILER_H
@@ -1,6 +1,7 @@
 #include "ghb_prefetcher.h"
 #include "simulator.h"
 #include "config.hpp"
+#include "checkpoint.h"
 
 #include <algorithm>
 
@@ -11,10 +12,13 @@ GhbPrefetcher::GhbPrefetcher(String configName, core_id_t core_id)
    , m_ghbSize(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/ghb/ghb_size", core_id))
    , m_ghbHead(0)
    , m_generation(0)
-   , m_ghb(m_ghbSize)
+   , m_ghbDelta(m_ghbSize, INVALID_DELTA)
+   , m_ghbLink(m_ghbSize)
    , m_tableSize(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/ghb/ghb_table_size", core_id))
    , m_tableHead(0)
-   , m_ghbTable(m_tableSize)
+   , m_tableUsed(0)
+   , m_tableDelta(m_tableSize, INVALID_DELTA)
+   , m_tableLink(m_tableSize)
 {
 }
 
@@ -22,16 +26,28 @@ GhbPrefetcher::~GhbPrefetcher()
 {
 }
 
-std::vector<IntPtr>
-GhbPrefetcher::getNextAddress(IntPtr currentAddress, core_id_t core_id)
+//index of the table entry for delta, or m_tableSize if there is none
+UInt32
+GhbPrefetcher::findDelta(SInt64 delta) const
 {
-   std::vector<IntPtr> prefetchList;
+   const SInt64 *deltas = m_tableDelta.data();
+   for(UInt32 i = 0; i < m_tableUsed; ++i)
+      if (deltas[i] == delta)
+         return i;
+   return m_tableSize;
+}
+
+UInt32
+GhbPrefetcher::getNextAddresses(const Access &access, IntPtr *prefetches, UInt32 max_prefetches)
+{
+   const IntPtr currentAddress = access.address;
+   UInt32 count = 0;
 
    //deal with prefether initialization
    if (m_lastAddress == INVALID_ADDRESS)
    {
       m_lastAddress = currentAddress;
-      return prefetchList;
+      return count;
    }
 
    //determine the delta with the last address
@@ -39,40 +55,38 @@ GhbPrefetcher::getNextAddress(IntPtr currentAddress, core_id_t core_id)
    m_lastAddress = currentAddress;
 
    //look for the current delta in the table
-   UInt32 i = 0;
-   while (i < m_tableSize &&
-          m_ghbTable[i].delta != INVALID_DELTA &&
-          m_ghbTable[i].delta != delta)
-      ++i;
+   UInt32 i = findDelta(delta);
 
    if (i != m_tableSize &&
-       m_ghbTable[i].delta == delta &&
-       m_ghbTable[i].generation == m_ghb[m_ghbTable[i].ghbIndex].generation) //check if the table still points to the current GHB 'generation'
+       m_tableLink[i].generation == m_ghbLink[m_tableLink[i].index].generation) //check if the table still points to the current GHB 'generation'
    {
       UInt32 width = 0;
-      UInt32 ghbIndex = m_ghbTable[i].ghbIndex;
+      UInt32 ghbIndex = m_tableLink[i].index;
 
       while(width < m_prefetchWidth && ghbIndex != INVALID_INDEX)
       {
          UInt32 depth = 0;
+         UInt32 index = ghbIndex;
 
          IntPtr newAddress = currentAddress;
 
          while (depth < m_prefetchDepth &&
-                m_ghb[(ghbIndex + depth)%m_ghbSize].delta != INVALID_DELTA)
+                m_ghbDelta[index] != INVALID_DELTA)
          {
-            newAddress += m_ghb[(ghbIndex + depth)%m_ghbSize].delta;
+            newAddress += m_ghbDelta[index];
 
             //add address to the list if it wasn't in there already
-            if (find(prefetchList.begin(), prefetchList.end(), newAddress) == prefetchList.end())
-               prefetchList.push_back(newAddress);
+            if (count < max_prefetches && std::find(prefetches, prefetches + count, newAddress) == prefetches + count)
+               prefetches[count++] = newAddress;
 
             ++depth;
+            if (++index == m_ghbSize)
+               index = 0;
          }
 
          ++width;
 
-         UInt32 nextIndex = m_ghb[ghbIndex].nextIndex;
+         UInt32 nextIndex = m_ghbLink[ghbIndex].index;
          if ((nextIndex > ghbIndex ||   //if we circle the GHB
               ghbIndex > m_ghbHead) &&  //OR we were already larger than the head pointer
               nextIndex < m_ghbHead)    //AND the nextIndex has been overwritten by new entries
@@ -84,44 +98,41 @@ GhbPrefetcher::getNextAddress(IntPtr currentAddress, core_id_t core_id)
 
    //add new delta to the ghb and table
 
-   m_ghb[m_ghbHead].delta = delta;
-   m_ghb[m_ghbHead].nextIndex = INVALID_INDEX;
-   m_ghb[m_ghbHead].generation = m_generation;
+   m_ghbDelta[m_ghbHead] = delta;
+   m_ghbLink[m_ghbHead].index = INVALID_INDEX;
+   m_ghbLink[m_ghbHead].generation = m_generation;
 
    UInt32 prevHead = m_ghbHead > 0 ? m_ghbHead - 1 : m_ghbSize - 1;
-   SInt64 prevDelta = m_ghb[prevHead].delta;
+   SInt64 prevDelta = m_ghbDelta[prevHead];
 
    if (prevDelta != INVALID_DELTA)
    {
-      i = 0;
-      while (i < m_tableSize &&
-             m_ghbTable[i].delta != INVALID_DELTA &&
-             m_ghbTable[i].delta != prevDelta)
-         ++i;
-
-      if (i != m_tableSize &&
-          m_ghbTable[i].delta == prevDelta)
+      i = findDelta(prevDelta);
+
+      if (i != m_tableSize)
       { //update existing entry
 
          //if the current table entry refers to a live ghb entry,
          //have the new entry link to the live entry
          //
          //otherwise, refer to INVALID_INDEX
-         if (m_ghbTable[i].generation == m_ghb[m_ghbTable[i].ghbIndex].generation)
-            m_ghb[m_ghbHead].nextIndex = m_ghbTable[i].ghbIndex;
+         if (m_tableLink[i].generation == m_ghbLink[m_tableLink[i].index].generation)
+            m_ghbLink[m_ghbHead].index = m_tableLink[i].index;
          else
-            m_ghb[m_ghbHead].nextIndex = INVALID_INDEX;
+            m_ghbLink[m_ghbHead].index = INVALID_INDEX;
 
-         m_ghbTable[i].ghbIndex = m_ghbHead;
-         m_ghbTable[i].generation = m_generation;
+         m_tableLink[i].index = m_ghbHead;
+         m_tableLink[i].generation = m_generation;
       }
       else
       { //prevDelta not found ==> add entry to table
-         m_ghbTable[m_tableHead].delta = prevDelta;
-         m_ghbTable[m_tableHead].ghbIndex = m_ghbHead;
-         m_ghbTable[m_tableHead].generation = m_generation;
+         m_tableDelta[m_tableHead] = prevDelta;
+         m_tableLink[m_tableHead].index = m_ghbHead;
+         m_tableLink[m_tableHead].generation = m_generation;
 
-         m_tableHead = (m_tableHead + 1) % m_tableSize;
+         if (++m_tableHead == m_tableSize)
+            m_tableHead = 0;
+         m_tableUsed = std::max(m_tableUsed, m_tableHead == 0 ? m_tableSize : m_tableHead);
       }
 
    }
@@ -133,5 +144,33 @@ GhbPrefetcher::getNextAddress(IntPtr currentAddress, core_id_t core_id)
       m_generation = (m_generation + 1) % 4;
    }
 
-   return prefetchList;
+   return count;
+}
+
+void
+GhbPrefetcher::saveState(CheckpointWriter &ckpt) const
+{
+   ckpt.put(m_lastAddress);
+   ckpt.put(m_ghbHead);
+   ckpt.put(m_generation);
+   ckpt.put(m_ghbDelta);
+   ckpt.put(m_ghbLink);
+   ckpt.put(m_tableHead);
+   ckpt.put(m_tableUsed);
+   ckpt.put(m_tableDelta);
+   ckpt.put(m_tableLink);
+}
+
+void
+GhbPrefetcher::loadState(CheckpointReader &ckpt)
+{
+   ckpt.get(m_lastAddress);
+   ckpt.get(m_ghbHead);
+   ckpt.get(m_generation);
+   ckpt.get(m_ghbDelta);
+   ckpt.get(m_ghbLink);
+   ckpt.get(m_tableHead);
+   ckpt.get(m_tableUsed);
+   ckpt.get(m_tableDelta);
+   ckpt.get(m_tableLink);
 }
@@ -7,7 +7,9 @@ class GhbPrefetcher : public Prefetcher
 {
    public:
       GhbPrefetcher(String configName, core_id_t core_id);
-      std::vector<IntPtr> getNextAddress(IntPtr currentAddress, core_id_t core_id);
+      UInt32 getNextAddresses(const Access &access, IntPtr *prefetches, UInt32 max_prefetches);
+      void saveState(CheckpointWriter &ckpt) const;
+      void loadState(CheckpointReader &ckpt);
 
       ~GhbPrefetcher();
 
@@ -15,20 +17,13 @@ class GhbPrefetcher : public Prefetcher
       static const SInt64 INVALID_DELTA = INT64_MAX;
       static const UInt32 INVALID_INDEX = UINT32_MAX;
 
-      struct GHBEntry
+      // Links are kept apart from the deltas: the table lookup only scans deltas,
+      // and prefetch generation walks consecutive deltas without touching the links
+      struct Link
       {
-         UInt32 nextIndex; //index of the next entry belonging to the same list
-         SInt64 delta; //delta between last address and current address
+         UInt32 index; //GHB: index of the next entry belonging to the same list, table: most recent GHB entry with this delta
          UInt32 generation;
-         GHBEntry() : nextIndex(INVALID_INDEX), delta(INVALID_DELTA), generation(0) {}
-      };
-
-      struct TableEntry
-      {
-         UInt32 ghbIndex;
-         SInt64 delta;
-         UInt32 generation;
-         TableEntry() : ghbIndex(INVALID_INDEX), delta(INVALID_DELTA), generation(0) {}
+         Link() : index(INVALID_INDEX), generation(0) {}
       };
 
       UInt32 m_prefetchWidth;
@@ -40,11 +35,16 @@ class GhbPrefetcher : public Prefetcher
       UInt32 m_ghbSize;
       UInt32 m_ghbHead;
       UInt32 m_generation;
-      std::vector<GHBEntry> m_ghb;
+      std::vector<SInt64> m_ghbDelta; //delta between last address and current address
+      std::vector<Link> m_ghbLink;
 
       UInt32 m_tableSize;
       UInt32 m_tableHead; //next table position to be overwritten (in lack of a better replacement policy at the moment)
-      std::vector<TableEntry> m_ghbTable;
+      UInt32 m_tableUsed; //entries are filled in order, so only [0, m_tableUsed) are valid
+      std::vector<SInt64> m_tableDelta;
+      std::vector<Link> m_tableLink;
+
+      UInt32 findDelta(SInt64 delta) const;
 };
 
 #endif // __GHB_PREFETCHER_H
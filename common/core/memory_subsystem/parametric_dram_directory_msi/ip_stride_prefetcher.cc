@@ -0,0 +1,152 @@
+#include "ip_stride_prefetcher.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "checkpoint.h"
+#include "utils.h"
+#include "log.h"
+
+#include <algorithm>
+
+static const IntPtr PAGE_SIZE = 4096;
+static const IntPtr PAGE_MASK = ~(PAGE_SIZE-1);
+
+IpStridePrefetcher::IpStridePrefetcher(String configName, core_id_t core_id)
+   : m_cache_block_size(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/cache_block_size", core_id))
+   , m_degree(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/ip_stride/degree", core_id))
+   , m_confidence_threshold(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/ip_stride/confidence_threshold", core_id))
+   , m_region_size(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/ip_stride/region_size", core_id))
+   , m_region_threshold(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/ip_stride/region_threshold", core_id))
+   , m_region_degree(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/ip_stride/region_degree", core_id))
+   , m_stop_at_page(Sim()->getCfg()->getBoolArray("perf_model/" + configName + "/prefetcher/ip_stride/stop_at_page_boundary", core_id))
+   , m_log_region_size(floorLog2(m_region_size))
+   , m_lines_per_region(m_region_size / m_cache_block_size)
+   , m_stride_table(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/ip_stride/table_size", core_id))
+   , m_region_table(Sim()->getCfg()->getIntArray("perf_model/" + configName + "/prefetcher/ip_stride/region_table_size", core_id))
+   , m_region_time(0)
+{
+   LOG_ASSERT_ERROR(isPower2(m_stride_table.size()), "ip_stride/table_size must be a power of two, got %u", m_stride_table.size());
+   LOG_ASSERT_ERROR(isPower2(m_region_size) && m_region_size >= m_cache_block_size && m_lines_per_region <= 64,
+      "ip_stride/region_size must be a power of two of between 1 and 64 cache lines, got %u", m_region_size);
+   LOG_ASSERT_ERROR(m_confidence_threshold <= MAX_CONFIDENCE, "ip_stride/confidence_threshold can be at most %u", MAX_CONFIDENCE);
+}
+
+UInt32
+IpStridePrefetcher::getNextAddresses(const Access &access, IntPtr *prefetches, UInt32 max_prefetches)
+{
+   UInt32 count = 0;
+   if (access.eip)
+      count = trainStride(access, prefetches, count, max_prefetches);
+   if (m_region_table.size())
+      count = trainRegion(access, prefetches, count, max_prefetches);
+   return count;
+}
+
+UInt32
+IpStridePrefetcher::trainStride(const Access &access, IntPtr *prefetches, UInt32 count, UInt32 max_prefetches)
+{
+   StrideEntry &entry = m_stride_table[(access.eip ^ (access.eip >> 12)) & (m_stride_table.size() - 1)];
+
+   if (entry.eip != access.eip)
+   {
+      entry.eip = access.eip;
+      entry.last_address = access.address;
+      entry.stride = 0;
+      entry.confidence = 0;
+      return count;
+   }
+
+   SInt64 stride = access.address - entry.last_address;
+   entry.last_address = access.address;
+   if (stride == 0)
+      return count;
+
+   // Two-bit saturating confidence, the stride is only replaced once confidence has dropped to zero
+   if (stride == entry.stride)
+      entry.confidence = std::min(entry.confidence + 1, MAX_CONFIDENCE);
+   else if (entry.confidence > 0)
+      entry.confidence--;
+   else
+      entry.stride = stride;
+
+   if (entry.confidence < m_confidence_threshold || entry.stride != stride)
+      return count;
+
+   const IntPtr block_mask = ~IntPtr(m_cache_block_size - 1);
+   IntPtr last_block = access.address & block_mask;
+   for(UInt32 i = 1; i <= m_degree && count < max_prefetches; ++i)
+   {
+      IntPtr prefetch_address = (access.address + i * stride) & block_mask;
+      if (m_stop_at_page && (prefetch_address & PAGE_MASK) != (access.address & PAGE_MASK))
+         break;
+      // Strides smaller than a cache line map several prefetches to the same line
+      if (prefetch_address != last_block)
+         prefetches[count++] = prefetch_address;
+      last_block = prefetch_address;
+   }
+   return count;
+}
+
+UInt32
+IpStridePrefetcher::trainRegion(const Access &access, IntPtr *prefetches, UInt32 count, UInt32 max_prefetches)
+{
+   IntPtr region = access.address >> m_log_region_size;
+   UInt32 line = (access.address & (m_region_size - 1)) / m_cache_block_size;
+
+   RegionEntry *entry = NULL, *victim = &m_region_table[0];
+   for(std::vector<RegionEntry>::iterator it = m_region_table.begin(); it != m_region_table.end(); ++it)
+   {
+      if (it->region == region)
+      {
+         entry = &*it;
+         break;
+      }
+      if (it->last_use < victim->last_use)
+         victim = &*it;
+   }
+   if (!entry)
+   {
+      entry = victim;
+      entry->region = region;
+      entry->accessed = 0;
+      entry->prefetched = 0;
+   }
+   entry->last_use = ++m_region_time;
+   entry->accessed |= 1ULL << line;
+
+   if ((UInt32)__builtin_popcountll(entry->accessed) < m_region_threshold)
+      return count;
+
+   // Walk outwards from the current line, alternating forwards and backwards
+   UInt64 done = entry->accessed | entry->prefetched;
+   UInt32 issued = 0;
+   for(UInt32 distance = 1; distance < m_lines_per_region && issued < m_region_degree && count < max_prefetches; ++distance)
+   {
+      UInt32 candidates[2] = { line + distance, line - distance };
+      for(UInt32 c = 0; c < 2 && issued < m_region_degree && count < max_prefetches; ++c)
+      {
+         // Underflow of line - distance also ends up >= m_lines_per_region
+         if (candidates[c] >= m_lines_per_region || (done & (1ULL << candidates[c])))
+            continue;
+         entry->prefetched |= 1ULL << candidates[c];
+         prefetches[count++] = (region << m_log_region_size) + candidates[c] * m_cache_block_size;
+         ++issued;
+      }
+   }
+   return count;
+}
+
+void
+IpStridePrefetcher::saveState(CheckpointWriter &ckpt) const
+{
+   ckpt.put(m_stride_table);
+   ckpt.put(m_region_table);
+   ckpt.put(m_region_time);
+}
+
+void
+IpStridePrefetcher::loadState(CheckpointReader &ckpt)
+{
+   ckpt.get(m_stride_table);
+   ckpt.get(m_region_table);
+   ckpt.get(m_region_time);
+}
@@ -0,0 +1,61 @@
+#ifndef __IP_STRIDE_PREFETCHER_H
+#define __IP_STRIDE_PREFETCHER_H
+
+#include "prefetcher.h"
+
+// Combined instruction-pointer stride and spatial region prefetcher.
+// A direct-mapped table indexed by the access' eip tracks the stride of each load/store instruction,
+// once the same stride has been seen confidence_threshold times, the next <degree> strides are prefetched.
+// Independently, a small fully-associative table of aligned regions records which cache lines of each
+// region have been touched; after region_threshold distinct lines, the untouched lines of the region are
+// prefetched, nearest to the current access first and at most region_degree per access.
+// Accesses without an eip (e.g., training at the L2) only use the region table.
+
+class IpStridePrefetcher : public Prefetcher
+{
+   public:
+      IpStridePrefetcher(String configName, core_id_t core_id);
+      UInt32 getNextAddresses(const Access &access, IntPtr *prefetches, UInt32 max_prefetches);
+      void saveState(CheckpointWriter &ckpt) const;
+      void loadState(CheckpointReader &ckpt);
+
+   private:
+      struct StrideEntry
+      {
+         IntPtr eip;
+         IntPtr last_address;
+         SInt64 stride;
+         UInt32 confidence;
+         StrideEntry() : eip(0), last_address(0), stride(0), confidence(0) {}
+      };
+
+      struct RegionEntry
+      {
+         IntPtr region;      // Region number, INVALID_ADDRESS when unused
+         UInt64 accessed;    // Bitmap of lines touched by demand accesses
+         UInt64 prefetched;  // Bitmap of lines already handed out as prefetches
+         UInt64 last_use;
+         RegionEntry() : region(INVALID_ADDRESS), accessed(0), prefetched(0), last_use(0) {}
+      };
+
+      static const UInt32 MAX_CONFIDENCE = 3;
+
+      const UInt32 m_cache_block_size;
+      const UInt32 m_degree;
+      const UInt32 m_confidence_threshold;
+      const UInt32 m_region_size;
+      const UInt32 m_region_threshold;
+      const UInt32 m_region_degree;
+      const bool m_stop_at_page;
+      const UInt32 m_log_region_size;
+      const UInt32 m_lines_per_region;
+
+      std::vector<StrideEntry> m_stride_table;
+      std::vector<RegionEntry> m_region_table;
+      UInt64 m_region_time;
+
+      UInt32 trainStride(const Access &access, IntPtr *prefetches, UInt32 count, UInt32 max_prefetches);
+      UInt32 trainRegion(const Access &access, IntPtr *prefetches, UInt32 count, UInt32 max_prefetches);
+};
+
+#endif // __IP_STRIDE_PREFETCHER_H
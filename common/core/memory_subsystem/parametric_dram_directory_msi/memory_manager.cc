@@ -4,6 +4,7 @@
 #include "nuca_cache.h"
 #include "dram_cache.h"
 #include "tlb.h"
+#include "page_walker.h"
 #include "simulator.h"
 #include "log.h"
 #include "dvfs_manager.h"
@@ -12,6 +13,7 @@
 #include "config.hpp"
 #include "distribution.h"
 #include "topology_info.h"
+#include "checkpoint.h"
 
 #include <algorithm>
 
@@ -29,6 +31,7 @@ namespace ParametricDramDirectoryMSI
 {
 
 std::map<CoreComponentType, CacheCntlr*> MemoryManager::m_all_cache_cntlrs;
+Lock MemoryManager::m_all_cache_cntlrs_lock;
 
 MemoryManager::MemoryManager(Core* core,
       Network* network, ShmemPerfModel* shmem_perf_model):
@@ -38,6 +41,7 @@ MemoryManager::MemoryManager(Core* core,
    m_dram_directory_cntlr(NULL),
    m_dram_cntlr(NULL),
    m_itlb(NULL), m_dtlb(NULL), m_stlb(NULL),
+   m_page_walker(NULL),
    m_tlb_miss_penalty(NULL,0),
    m_tlb_miss_parallel(false),
    m_tag_directory_present(false),
@@ -61,6 +65,7 @@ MemoryManager::MemoryManager(Core* core,
    UInt32 dram_directory_max_hw_sharers = 0;
    String dram_directory_type_str;
    UInt32 dram_directory_home_lookup_param = 0;
+   AddressHomeLookup::interleaving_t dram_directory_home_interleaving = AddressHomeLookup::INTERLEAVE_LINE;
    ComponentLatency dram_directory_cache_access_time(global_domain, 0);
 
    try
@@ -69,15 +74,20 @@ MemoryManager::MemoryManager(Core* core,
 
       m_last_level_cache = (MemComponent::component_t)(Sim()->getCfg()->getInt("perf_model/cache/levels") - 2 + MemComponent::L2_CACHE);
 
+      UInt32 page_size = Sim()->getCfg()->getInt("perf_model/tlb/page_size");
+      LOG_ASSERT_ERROR(page_size == (1 << 12) || page_size == (1 << 21) || page_size == (1 << 30),
+         "perf_model/tlb/page_size must be 4096, 2097152 or 1073741824, got %u", page_size);
+      m_tlb_page_shift = floorLog2(page_size);
+
       UInt32 stlb_size = Sim()->getCfg()->getInt("perf_model/stlb/size");
       if (stlb_size)
-         m_stlb = new TLB("stlb", "perf_model/stlb", getCore()->getId(), stlb_size, Sim()->getCfg()->getInt("perf_model/stlb/associativity"), NULL);
+         m_stlb = new TLB("stlb", getCore()->getId(), m_tlb_page_shift, stlb_size, Sim()->getCfg()->getInt("perf_model/stlb/associativity"), NULL);
       UInt32 itlb_size = Sim()->getCfg()->getInt("perf_model/itlb/size");
       if (itlb_size)
-         m_itlb = new TLB("itlb", "perf_model/itlb", getCore()->getId(), itlb_size, Sim()->getCfg()->getInt("perf_model/itlb/associativity"), m_stlb);
+         m_itlb = new TLB("itlb", getCore()->getId(), m_tlb_page_shift, itlb_size, Sim()->getCfg()->getInt("perf_model/itlb/associativity"), m_stlb);
       UInt32 dtlb_size = Sim()->getCfg()->getInt("perf_model/dtlb/size");
       if (dtlb_size)
-         m_dtlb = new TLB("dtlb", "perf_model/dtlb", getCore()->getId(), dtlb_size, Sim()->getCfg()->getInt("perf_model/dtlb/associativity"), m_stlb);
+         m_dtlb = new TLB("dtlb", getCore()->getId(), m_tlb_page_shift, dtlb_size, Sim()->getCfg()->getInt("perf_model/dtlb/associativity"), m_stlb);
       m_tlb_miss_penalty = ComponentLatency(core->getDvfsDomain(), Sim()->getCfg()->getInt("perf_model/tlb/penalty"));
       m_tlb_miss_parallel = Sim()->getCfg()->getBool("perf_model/tlb/penalty_parallel");
 
@@ -173,6 +183,7 @@ MemoryManager::MemoryManager(Core* core,
       dram_directory_max_hw_sharers = Sim()->getCfg()->getInt("perf_model/dram_directory/max_hw_sharers");
       dram_directory_type_str = Sim()->getCfg()->getString("perf_model/dram_directory/directory_type");
       dram_directory_home_lookup_param = Sim()->getCfg()->getInt("perf_model/dram_directory/home_lookup_param");
+      dram_directory_home_interleaving = AddressHomeLookup::parseInterleaving(Sim()->getCfg()->getString("perf_model/dram_directory/home_interleaving"));
       dram_directory_cache_access_time = ComponentLatency(global_domain, Sim()->getCfg()->getInt("perf_model/dram_directory/directory_cache_access_time"));
 
       // Dram Cntlr
@@ -219,8 +230,8 @@ MemoryManager::MemoryManager(Core* core,
       }
    }
 
-   m_tag_directory_home_lookup = new AddressHomeLookup(dram_directory_home_lookup_param, core_list_with_tag_directories, getCacheBlockSize());
-   m_dram_controller_home_lookup = new AddressHomeLookup(dram_directory_home_lookup_param, core_list_with_dram_controllers, getCacheBlockSize());
+   m_tag_directory_home_lookup = new AddressHomeLookup(dram_directory_home_lookup_param, core_list_with_tag_directories, getCacheBlockSize(), dram_directory_home_interleaving);
+   m_dram_controller_home_lookup = new AddressHomeLookup(dram_directory_home_lookup_param, core_list_with_dram_controllers, getCacheBlockSize(), dram_directory_home_interleaving, Sim()->getNumaTopology());
 
    // if (m_core->getId() == 0)
    //   printCoreListWithMemoryControllers(core_list_with_dram_controllers);
@@ -308,6 +319,11 @@ MemoryManager::MemoryManager(Core* core,
       m_cache_cntlrs[(MemComponent::component_t)(i + 1)]->setPrevCacheCntlrs(prev_cache_cntlrs);
    }
 
+   // Page walks load their page table entries through the L1-D cache
+   if ((m_itlb || m_dtlb) && Sim()->getCfg()->getBool("perf_model/tlb/walk_through_caches"))
+      m_page_walker = new PageWalker(getCore()->getId(), m_tlb_page_shift, Sim()->getCfg()->getInt("perf_model/tlb/walk_cache_size"),
+                                     m_cache_cntlrs[MemComponent::L1_DCACHE], getCacheBlockSize(), getShmemPerfModel());
+
    // Create Performance Models
    for(UInt32 i = MemComponent::FIRST_LEVEL_CACHE; i <= (UInt32)m_last_level_cache; ++i)
       m_cache_perf_models[(MemComponent::component_t)i] = CachePerfModel::create(
@@ -386,6 +402,7 @@ MemoryManager::~MemoryManager()
    if (m_itlb) delete m_itlb;
    if (m_dtlb) delete m_dtlb;
    if (m_stlb) delete m_stlb;
+   if (m_page_walker) delete m_page_walker;
 
    for(i = MemComponent::FIRST_LEVEL_CACHE; i <= (UInt32)m_last_level_cache; ++i)
    {
@@ -421,7 +438,8 @@ MemoryManager::coreInitiateMemoryAccess(
       Core::mem_op_t mem_op_type,
       IntPtr address, UInt32 offset,
       Byte* data_buf, UInt32 data_length,
-      Core::MemModeled modeled)
+      Core::MemModeled modeled,
+      IntPtr eip)
 {
    LOG_ASSERT_ERROR(mem_component <= m_last_level_cache,
       "Error: invalid mem_component (%d) for coreInitiateMemoryAccess", mem_component);
@@ -437,7 +455,8 @@ MemoryManager::coreInitiateMemoryAccess(
          address, offset,
          data_buf, data_length,
          modeled == Core::MEM_MODELED_NONE || modeled == Core::MEM_MODELED_COUNT ? false : true,
-         modeled == Core::MEM_MODELED_NONE ? false : true);
+         modeled == Core::MEM_MODELED_NONE ? false : true,
+         eip);
 }
 
 void
@@ -445,7 +464,11 @@ MemoryManager::handleMsgFromNetwork(NetPacket& packet)
 {
 MYLOG("begin");
    core_id_t sender = packet.sender;
-   PrL1PrL2DramDirectoryMSI::ShmemMsg* shmem_msg = PrL1PrL2DramDirectoryMSI::ShmemMsg::getShmemMsg((Byte*) packet.data, &m_dummy_shmem_perf);
+   bool zero_copy = getNetwork()->isZeroCopy();
+   // In zero-copy mode, the network owns the packet (and releases it once we return)
+   PrL1PrL2DramDirectoryMSI::ShmemMsg* shmem_msg = zero_copy
+      ? PrL1PrL2DramDirectoryMSI::ShmemMsg::getShmemMsgInPlace((Byte*) packet.data)
+      : PrL1PrL2DramDirectoryMSI::ShmemMsg::getShmemMsg((Byte*) packet.data, &m_dummy_shmem_perf);
    SubsecondTime msg_time = packet.time;
 
    getShmemPerfModel()->setElapsedTime(ShmemPerfModel::_SIM_THREAD, msg_time);
@@ -526,12 +549,15 @@ MYLOG("begin");
    // First delete 'data_buf' if it is present
    // LOG_PRINT("Finished handling Shmem Msg");
 
-   if (shmem_msg->getDataLength() > 0)
+   if (!zero_copy)
    {
-      assert(shmem_msg->getDataBuf());
-      delete [] shmem_msg->getDataBuf();
+      if (shmem_msg->getDataLength() > 0)
+      {
+         assert(shmem_msg->getDataBuf());
+         delete [] shmem_msg->getDataBuf();
+      }
+      delete shmem_msg;
    }
-   delete shmem_msg;
 MYLOG("end");
 }
 
@@ -543,7 +569,8 @@ MYLOG("send msg %u %ul%u > %ul%u", msg_type, requester, sender_mem_component, re
    PrL1PrL2DramDirectoryMSI::ShmemMsg shmem_msg(msg_type, sender_mem_component, receiver_mem_component, requester, address, data_buf, data_length, perf);
    shmem_msg.setWhere(where);
 
-   Byte* msg_buf = shmem_msg.makeMsgBuf();
+   Byte* msg_buf = getNetwork()->allocPayload(shmem_msg.getMsgLen());
+   shmem_msg.writeMsgBuf(msg_buf);
    SubsecondTime msg_time = getShmemPerfModel()->getElapsedTime(thread_num);
    perf->updateTime(msg_time);
 
@@ -555,10 +582,8 @@ MYLOG("send msg %u %ul%u > %ul%u", msg_type, requester, sender_mem_component, re
    NetPacket packet(msg_time, SHARED_MEM_1,
          m_core_id_master, receiver,
          shmem_msg.getMsgLen(), (const void*) msg_buf);
-   getNetwork()->netSend(packet);
-
-   // Delete the Msg Buf
-   delete [] msg_buf;
+   // The network takes over the Msg Buf
+   getNetwork()->netSendPayload(packet);
 }
 
 void
@@ -568,7 +593,8 @@ MYLOG("bcast msg");
    assert((data_buf == NULL) == (data_length == 0));
    PrL1PrL2DramDirectoryMSI::ShmemMsg shmem_msg(msg_type, sender_mem_component, receiver_mem_component, requester, address, data_buf, data_length, perf);
 
-   Byte* msg_buf = shmem_msg.makeMsgBuf();
+   Byte* msg_buf = getNetwork()->allocPayload(shmem_msg.getMsgLen());
+   shmem_msg.writeMsgBuf(msg_buf);
    SubsecondTime msg_time = getShmemPerfModel()->getElapsedTime(thread_num);
    perf->updateTime(msg_time);
 
@@ -580,28 +606,35 @@ MYLOG("bcast msg");
    NetPacket packet(msg_time, SHARED_MEM_1,
          m_core_id_master, NetPacket::BROADCAST,
          shmem_msg.getMsgLen(), (const void*) msg_buf);
-   getNetwork()->netSend(packet);
-
-   // Delete the Msg Buf
-   delete [] msg_buf;
+   // The network takes over the Msg Buf
+   getNetwork()->netSendPayload(packet);
 }
 
 void
 MemoryManager::accessTLB(TLB * tlb, IntPtr address, bool isIfetch, Core::MemModeled modeled)
 {
    bool hit = tlb->lookup(address, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_USER_THREAD));
-   if (hit == false
-       && !(modeled == Core::MEM_MODELED_NONE || modeled == Core::MEM_MODELED_COUNT)
-       && m_tlb_miss_penalty.getLatency() != SubsecondTime::Zero()
+   if (hit)
+      return;
+
+   SubsecondTime latency = m_tlb_miss_penalty.getLatency();
+   // Walk the page table also for unmodeled accesses, so it warms the page-walk cache and the data caches
+   if (m_page_walker)
+      latency += m_page_walker->walk(address,
+         modeled == Core::MEM_MODELED_NONE || modeled == Core::MEM_MODELED_COUNT ? false : true,
+         modeled == Core::MEM_MODELED_NONE ? false : true);
+
+   if (!(modeled == Core::MEM_MODELED_NONE || modeled == Core::MEM_MODELED_COUNT)
+       && latency != SubsecondTime::Zero()
    )
    {
       if (m_tlb_miss_parallel)
       {
-         incrElapsedTime(m_tlb_miss_penalty.getLatency(), ShmemPerfModel::_USER_THREAD);
+         incrElapsedTime(latency, ShmemPerfModel::_USER_THREAD);
       }
       else
       {
-         PseudoInstruction *i = new TLBMissInstruction(m_tlb_miss_penalty.getLatency(), isIfetch);
+         PseudoInstruction *i = new TLBMissInstruction(latency, isIfetch);
          getCore()->getPerformanceModel()->queuePseudoInstruction(i);
       }
    }
@@ -659,4 +692,65 @@ MemoryManager::disableModels()
       m_dram_cntlr->getDramPerfModel()->disable();
 }
 
+void
+MemoryManager::saveCheckpointCache(MemComponent::component_t mem_component, CheckpointWriter &ckpt)
+{
+   // Shared caches are only saved once, by the core that owns them
+   if (mem_component <= m_last_level_cache && m_cache_cntlrs[mem_component]->isMasterCache())
+      m_cache_cntlrs[mem_component]->getCache()->saveState(ckpt);
+}
+
+void
+MemoryManager::loadCheckpointCache(MemComponent::component_t mem_component, CheckpointReader &ckpt, std::vector<CheckpointLine> &lines)
+{
+   if (mem_component <= m_last_level_cache && m_cache_cntlrs[mem_component]->isMasterCache())
+   {
+      LOG_ASSERT_ERROR(ckpt.more(), "Checkpoint has no contents for cache level %d of core %d", mem_component, getCore()->getId());
+      m_cache_cntlrs[mem_component]->getCache()->loadLines(ckpt, lines);
+   }
+}
+
+void
+MemoryManager::getCacheLines(MemComponent::component_t mem_component, std::vector<CheckpointLine> &lines)
+{
+   if (mem_component <= m_last_level_cache && m_cache_cntlrs[mem_component]->isMasterCache())
+      m_cache_cntlrs[mem_component]->getCache()->getLines(lines);
+}
+
+void
+MemoryManager::saveCheckpoint(CheckpointWriter &ckpt)
+{
+   TLB *tlbs[] = { m_itlb, m_dtlb, m_stlb };
+   for(UInt32 i = 0; i < sizeof(tlbs) / sizeof(tlbs[0]); ++i)
+      if (tlbs[i])
+         tlbs[i]->saveState(ckpt);
+   if (m_page_walker)
+      m_page_walker->saveState(ckpt);
+
+   for(UInt32 i = MemComponent::FIRST_LEVEL_CACHE; i <= (UInt32)m_last_level_cache; ++i)
+   {
+      CacheCntlr *cache_cntlr = m_cache_cntlrs[(MemComponent::component_t)i];
+      if (cache_cntlr->isMasterCache() && cache_cntlr->getPrefetcher())
+         cache_cntlr->getPrefetcher()->saveState(ckpt);
+   }
+}
+
+void
+MemoryManager::loadCheckpoint(CheckpointReader &ckpt)
+{
+   TLB *tlbs[] = { m_itlb, m_dtlb, m_stlb };
+   for(UInt32 i = 0; i < sizeof(tlbs) / sizeof(tlbs[0]); ++i)
+      if (tlbs[i])
+         tlbs[i]->loadState(ckpt);
+   if (m_page_walker)
+      m_page_walker->loadState(ckpt);
+
+   for(UInt32 i = MemComponent::FIRST_LEVEL_CACHE; i <= (UInt32)m_last_level_cache; ++i)
+   {
+      CacheCntlr *cache_cntlr = m_cache_cntlrs[(MemComponent::component_t)i];
+      if (cache_cntlr->isMasterCache() && cache_cntlr->getPrefetcher())
+         cache_cntlr->getPrefetcher()->loadState(ckpt);
+   }
+}
+
 }
@@ -22,6 +22,7 @@ class ShmemPerf;
 namespace ParametricDramDirectoryMSI
 {
    class TLB;
+   class PageWalker;
 
    typedef std::pair<core_id_t, MemComponent::component_t> CoreComponentType;
    typedef std::map<CoreComponentType, CacheCntlr*> CacheCntlrMap;
@@ -37,6 +38,8 @@ namespace ParametricDramDirectoryMSI
          AddressHomeLookup* m_tag_directory_home_lookup;
          AddressHomeLookup* m_dram_controller_home_lookup;
          TLB *m_itlb, *m_dtlb, *m_stlb;
+         PageWalker *m_page_walker;
+         UInt32 m_tlb_page_shift;
          ComponentLatency m_tlb_miss_penalty;
          bool m_tlb_miss_parallel;
 
@@ -59,6 +62,7 @@ namespace ParametricDramDirectoryMSI
 
          // Global map of all caches on all cores (within this process!)
          static CacheCntlrMap m_all_cache_cntlrs;
+         static Lock m_all_cache_cntlrs_lock; // Cores can be constructed in parallel (general/startup_threads)
 
          void accessTLB(TLB * tlb, IntPtr address, bool isIfetch, Core::MemModeled modeled);
 
@@ -79,8 +83,8 @@ namespace ParametricDramDirectoryMSI
          AddressHomeLookup* getTagDirectoryHomeLookup() { return m_tag_directory_home_lookup; }
          AddressHomeLookup* getDramControllerHomeLookup() { return m_dram_controller_home_lookup; }
 
-         CacheCntlr* getCacheCntlrAt(core_id_t core_id, MemComponent::component_t mem_component) { return m_all_cache_cntlrs[CoreComponentType(core_id, mem_component)]; }
-         void setCacheCntlrAt(core_id_t core_id, MemComponent::component_t mem_component, CacheCntlr* cache_cntlr) { m_all_cache_cntlrs[CoreComponentType(core_id, mem_component)] = cache_cntlr; }
+         CacheCntlr* getCacheCntlrAt(core_id_t core_id, MemComponent::component_t mem_component) { ScopedLock sl(m_all_cache_cntlrs_lock); return m_all_cache_cntlrs[CoreComponentType(core_id, mem_component)]; }
+         void setCacheCntlrAt(core_id_t core_id, MemComponent::component_t mem_component, CacheCntlr* cache_cntlr) { ScopedLock sl(m_all_cache_cntlrs_lock); m_all_cache_cntlrs[CoreComponentType(core_id, mem_component)] = cache_cntlr; }
 
          HitWhere::where_t coreInitiateMemoryAccess(
                MemComponent::component_t mem_component,
@@ -88,7 +92,8 @@ namespace ParametricDramDirectoryMSI
                Core::mem_op_t mem_op_type,
                IntPtr address, UInt32 offset,
                Byte* data_buf, UInt32 data_length,
-               Core::MemModeled modeled);
+               Core::MemModeled modeled,
+               IntPtr eip = 0);
 
          void handleMsgFromNetwork(NetPacket& packet);
 
@@ -104,6 +109,12 @@ namespace ParametricDramDirectoryMSI
          void enableModels();
          void disableModels();
 
+         void saveCheckpointCache(MemComponent::component_t mem_component, CheckpointWriter &ckpt);
+         void loadCheckpointCache(MemComponent::component_t mem_component, CheckpointReader &ckpt, std::vector<CheckpointLine> &lines);
+         void saveCheckpoint(CheckpointWriter &ckpt);
+         void loadCheckpoint(CheckpointReader &ckpt);
+         void getCacheLines(MemComponent::component_t mem_component, std::vector<CheckpointLine> &lines);
+
          core_id_t getShmemRequester(const void* pkt_data)
          { return ((PrL1PrL2DramDirectoryMSI::ShmemMsg*) pkt_data)->getRequester(); }
 
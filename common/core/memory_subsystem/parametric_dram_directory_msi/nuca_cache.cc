@@ -5,6 +5,53 @@
 #include "stats.h"
 #include "queue_model.h"
 #include "shmem_perf.h"
+#include "utils.h"
+#include "itostr.h"
+#include "log.h"
+
+static const UInt32 NUCA_PAGE_SHIFT = 12;
+
+NucaBankLookup::NucaBankLookup(AddressHomeLookup *home_lookup, UInt32 num_banks, interleaving_t interleaving, UInt32 cache_block_size)
+   : m_home_lookup(home_lookup)
+   , m_num_banks(num_banks)
+   , m_interleaving(interleaving)
+   , m_log_granularity(interleaving == INTERLEAVE_PAGE ? NUCA_PAGE_SHIFT : floorLog2(cache_block_size))
+   , m_log_num_banks(floorLog2(num_banks))
+   , m_banks(num_banks)
+{
+   LOG_ASSERT_ERROR(num_banks > 0, "NUCA cache needs at least one bank");
+   LOG_ASSERT_ERROR(interleaving != INTERLEAVE_XOR || isPower2(num_banks), "XOR bank interleaving needs a power-of-two number of banks, got %u", num_banks);
+}
+
+UInt32
+NucaBankLookup::getBank(IntPtr address) const
+{
+   if (m_num_banks == 1)
+      return 0;
+
+   IntPtr block = getSliceAddress(address) >> m_log_granularity;
+   if (m_interleaving == INTERLEAVE_XOR)
+   {
+      UInt32 bank = 0;
+      for(; block; block >>= m_log_num_banks)
+         bank ^= block & (m_num_banks - 1);
+      return bank;
+   }
+   else
+      return m_banks.modulo(block);
+}
+
+IntPtr
+NucaBankLookup::getLinearAddress(IntPtr address) const
+{
+   IntPtr slice_address = getSliceAddress(address);
+   if (m_num_banks == 1)
+      return slice_address;
+
+   // For XOR interleaving, the lower bits identify the line within the bank together with the bank index
+   IntPtr block = m_banks.divide(slice_address >> m_log_granularity);
+   return (block << m_log_granularity) | (slice_address & ((IntPtr(1) << m_log_granularity) - 1));
+}
 
 NucaCache::NucaCache(MemoryManagerBase* memory_manager, ShmemPerfModel* shmem_perf_model, AddressHomeLookup* home_lookup, UInt32 cache_block_size, ParametricDramDirectoryMSI::CacheParameters& parameters)
    : m_core_id(memory_manager->getCore()->getId())
@@ -15,91 +62,149 @@ NucaCache::NucaCache(MemoryManagerBase* memory_manager, ShmemPerfModel* shmem_pe
    , m_data_access_time(parameters.data_access_time)
    , m_tags_access_time(parameters.tags_access_time)
    , m_data_array_bandwidth(8 * Sim()->getCfg()->getFloat("perf_model/nuca/bandwidth"))
-   , m_queue_model(NULL)
-   , m_reads(0)
-   , m_writes(0)
-   , m_read_misses(0)
-   , m_write_misses(0)
+   , m_bank_lookup(home_lookup,
+                   Sim()->getCfg()->getInt("perf_model/nuca/banks"),
+                   NucaBankLookup::parseInterleaving(Sim()->getCfg()->getString("perf_model/nuca/bank_interleaving")),
+                   cache_block_size)
+   , m_banks(Sim()->getCfg()->getInt("perf_model/nuca/banks"))
 {
-   m_cache = new Cache("nuca-cache",
-      "perf_model/nuca/cache",
-      m_core_id,
-      parameters.num_sets,
-      parameters.associativity,
-      m_cache_block_size,
-      parameters.replacement_policy,
-      CacheBase::PR_L1_CACHE,
-      CacheBase::parseAddressHash(parameters.hash_function),
-      NULL, /* FaultinjectionManager */
-      home_lookup
-   );
-
-   if (Sim()->getCfg()->getBool("perf_model/nuca/queue_model/enabled"))
+   UInt32 num_banks = m_banks.size();
+   LOG_ASSERT_ERROR(parameters.num_sets % num_banks == 0, "NUCA cache sets (%u) must be a multiple of the number of banks (%u)", parameters.num_sets, num_banks);
+
+   bool queue_model_enabled = Sim()->getCfg()->getBool("perf_model/nuca/queue_model/enabled");
+   String queue_model_type = queue_model_enabled ? Sim()->getCfg()->getString("perf_model/nuca/queue_model/type") : "";
+
+   for(UInt32 b = 0; b < num_banks; ++b)
    {
-      String queue_model_type = Sim()->getCfg()->getString("perf_model/nuca/queue_model/type");
-      m_queue_model = QueueModel::create("nuca-cache-queue", m_core_id, queue_model_type, m_data_array_bandwidth.getRoundedLatency(8 * m_cache_block_size)); // bytes to bits
+      // With a single bank, keep the names of the unbanked model
+      String bank_name = num_banks == 1 ? "nuca-cache" : "nuca-bank" + itostr(b);
+      Bank *bank = new Bank();
+
+      bank->cache = new Cache(bank_name,
+         "perf_model/nuca/cache",
+         m_core_id,
+         parameters.num_sets / num_banks,
+         parameters.associativity,
+         m_cache_block_size,
+         parameters.replacement_policy,
+         CacheBase::PR_L1_CACHE,
+         CacheBase::parseAddressHash(parameters.hash_function),
+         NULL, /* FaultinjectionManager */
+         &m_bank_lookup
+      );
+
+      // Bandwidth is per bank
+      if (queue_model_enabled)
+         bank->queue_model = QueueModel::create(num_banks == 1 ? "nuca-cache-queue" : bank_name + "-queue", m_core_id, queue_model_type, m_data_array_bandwidth.getRoundedLatency(8 * m_cache_block_size)); // bytes to bits
+
+      if (num_banks > 1)
+      {
+         registerStatsMetric(bank_name, m_core_id, "reads", &bank->reads);
+         registerStatsMetric(bank_name, m_core_id, "writes", &bank->writes);
+         registerStatsMetric(bank_name, m_core_id, "read-misses", &bank->read_misses);
+         registerStatsMetric(bank_name, m_core_id, "write-misses", &bank->write_misses);
+      }
+
+      m_banks[b] = bank;
    }
 
-   registerStatsMetric("nuca-cache", m_core_id, "reads", &m_reads);
-   registerStatsMetric("nuca-cache", m_core_id, "writes", &m_writes);
-   registerStatsMetric("nuca-cache", m_core_id, "read-misses", &m_read_misses);
-   registerStatsMetric("nuca-cache", m_core_id, "write-misses", &m_write_misses);
+   const char *metrics[] = { "reads", "writes", "read-misses", "write-misses" };
+   for(UInt32 i = 0; i < sizeof(metrics) / sizeof(metrics[0]); ++i)
+      Sim()->getStatsManager()->registerMetric(new StatsMetricCallback("nuca-cache", m_core_id, metrics[i], getBankStat, (UInt64)this));
 }
 
 NucaCache::~NucaCache()
 {
-   delete m_cache;
-   if (m_queue_model)
-      delete m_queue_model;
+   for(std::vector<Bank*>::iterator it = m_banks.begin(); it != m_banks.end(); ++it)
+   {
+      delete (*it)->cache;
+      if ((*it)->queue_model)
+         delete (*it)->queue_model;
+      delete *it;
+   }
+}
+
+UInt64
+NucaCache::getBankStat(String objectName, UInt32 index, String metricName, UInt64 arg)
+{
+   NucaCache *nuca = (NucaCache *)arg;
+   UInt64 value = 0;
+   for(std::vector<Bank*>::const_iterator it = nuca->m_banks.begin(); it != nuca->m_banks.end(); ++it)
+   {
+      if (metricName == "reads")
+         value += (*it)->reads;
+      else if (metricName == "writes")
+         value += (*it)->writes;
+      else if (metricName == "read-misses")
+         value += (*it)->read_misses;
+      else if (metricName == "write-misses")
+         value += (*it)->write_misses;
+   }
+   return value;
 }
 
 boost::tuple<SubsecondTime, HitWhere::where_t>
-NucaCache::read(IntPtr address, Byte* data_buf, SubsecondTime now, ShmemPerf *perf, bool count)
+NucaCache::read(IntPtr address, Byte* data_buf, SubsecondTime now, ShmemPerf *perf, bool count, bool tags_done)
 {
    HitWhere::where_t hit_where = HitWhere::MISS;
    perf->updateTime(now);
 
-   PrL1CacheBlockInfo* block_info = (PrL1CacheBlockInfo*)m_cache->peekSingleLine(address);
-   SubsecondTime latency = m_tags_access_time.getLatency();
+   Bank &bank = *m_banks[m_bank_lookup.getBank(address)];
+   ScopedLock sl(bank.lock);
+
+   PrL1CacheBlockInfo* block_info = (PrL1CacheBlockInfo*)bank.cache->peekSingleLine(address);
+   SubsecondTime latency = tags_done ? SubsecondTime::Zero() : m_tags_access_time.getLatency();
    perf->updateTime(now + latency, ShmemPerf::NUCA_TAGS);
 
    if (block_info)
    {
-      m_cache->accessSingleLine(address, Cache::LOAD, data_buf, m_cache_block_size, now + latency, true);
+      bank.cache->accessSingleLine(address, Cache::LOAD, data_buf, m_cache_block_size, now + latency, true);
 
-      latency += accessDataArray(Cache::LOAD, now + latency, perf);
+      latency += accessDataArray(bank, Cache::LOAD, now + latency, perf);
       hit_where = HitWhere::NUCA_CACHE;
    }
    else
    {
-      if (count) ++m_read_misses;
+      if (count) ++bank.read_misses;
    }
-   if (count) ++m_reads;
+   if (count) ++bank.reads;
 
    return boost::tuple<SubsecondTime, HitWhere::where_t>(latency, hit_where);
 }
 
+bool
+NucaCache::isCached(IntPtr address)
+{
+   Bank &bank = *m_banks[m_bank_lookup.getBank(address)];
+   ScopedLock sl(bank.lock);
+
+   return bank.cache->peekSingleLine(address) != NULL;
+}
+
 boost::tuple<SubsecondTime, HitWhere::where_t>
 NucaCache::write(IntPtr address, Byte* data_buf, bool& eviction, IntPtr& evict_address, Byte* evict_buf, SubsecondTime now, bool count)
 {
    HitWhere::where_t hit_where = HitWhere::MISS;
 
-   PrL1CacheBlockInfo* block_info = (PrL1CacheBlockInfo*)m_cache->peekSingleLine(address);
+   Bank &bank = *m_banks[m_bank_lookup.getBank(address)];
+   ScopedLock sl(bank.lock);
+
+   PrL1CacheBlockInfo* block_info = (PrL1CacheBlockInfo*)bank.cache->peekSingleLine(address);
    SubsecondTime latency = m_tags_access_time.getLatency();
 
    if (block_info)
    {
       block_info->setCState(CacheState::MODIFIED);
-      m_cache->accessSingleLine(address, Cache::STORE, data_buf, m_cache_block_size, now + latency, true);
+      bank.cache->accessSingleLine(address, Cache::STORE, data_buf, m_cache_block_size, now + latency, true);
 
-      latency += accessDataArray(Cache::STORE, now + latency, &m_dummy_shmem_perf);
+      latency += accessDataArray(bank, Cache::STORE, now + latency, &m_dummy_shmem_perf);
       hit_where = HitWhere::NUCA_CACHE;
    }
    else
    {
       PrL1CacheBlockInfo evict_block_info;
 
-      m_cache->insertSingleLine(address, data_buf,
+      bank.cache->insertSingleLine(address, data_buf,
          &eviction, &evict_address, &evict_block_info, evict_buf,
          now + latency);
 
@@ -112,25 +217,25 @@ NucaCache::write(IntPtr address, Byte* data_buf, bool& eviction, IntPtr& evict_a
          }
       }
 
-      if (count) ++m_write_misses;
+      if (count) ++bank.write_misses;
    }
-   if (count) ++m_writes;
+   if (count) ++bank.writes;
 
    return boost::tuple<SubsecondTime, HitWhere::where_t>(latency, hit_where);
 }
 
 SubsecondTime
-NucaCache::accessDataArray(Cache::access_t access, SubsecondTime t_start, ShmemPerf *perf)
+NucaCache::accessDataArray(Bank &bank, Cache::access_t access, SubsecondTime t_start, ShmemPerf *perf)
 {
    perf->updateTime(t_start);
 
    // Compute Queue Delay
    SubsecondTime queue_delay;
-   if (m_queue_model)
+   if (bank.queue_model)
    {
       SubsecondTime processing_time = m_data_array_bandwidth.getRoundedLatency(8 * m_cache_block_size); // bytes to bits
 
-      queue_delay = processing_time + m_queue_model->computeQueueDelay(t_start, processing_time, m_core_id);
+      queue_delay = processing_time + bank.queue_model->computeQueueDelay(t_start, processing_time, m_core_id);
 
       perf->updateTime(t_start + processing_time, ShmemPerf::NUCA_BUS);
       perf->updateTime(t_start + queue_delay, ShmemPerf::NUCA_QUEUE);
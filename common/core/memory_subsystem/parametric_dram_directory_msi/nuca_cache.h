@@ -5,18 +5,54 @@
 #include "subsecond_time.h"
 #include "hit_where.h"
 #include "cache_cntlr.h"
+#include "address_home_lookup.h"
+#include "lock.h"
 
 #include "boost/tuple/tuple.hpp"
 
 class MemoryManagerBase;
 class ShmemPerfModel;
-class AddressHomeLookup;
 class QueueModel;
 class ShmemPerf;
 
+// Splits the addresses of one NUCA slice over its banks.
+// Interleaving is done on the slice's linear address, so it does not alias with the slice selection bits:
+//   line: consecutive cache lines go to consecutive banks
+//   page: consecutive 4KB pages go to consecutive banks
+//   xor:  line interleaving, with the bank index XOR-folded with the higher line address bits (power-of-two banks only)
+// getLinearAddress() removes the bank bits again, so each bank's Cache uses all of its sets.
+class NucaBankLookup : public AddressHomeLookup
+{
+   public:
+      NucaBankLookup(AddressHomeLookup *home_lookup, UInt32 num_banks, interleaving_t interleaving, UInt32 cache_block_size);
+
+      UInt32 getBank(IntPtr address) const;
+      IntPtr getLinearAddress(IntPtr address) const;
+
+   private:
+      AddressHomeLookup *m_home_lookup;
+      const UInt32 m_num_banks;
+      const interleaving_t m_interleaving;
+      const UInt32 m_log_granularity; // Interleaving granularity: cache line or page
+      UInt32 m_log_num_banks;
+      const FastDivider m_banks;
+
+      IntPtr getSliceAddress(IntPtr address) const { return m_home_lookup ? m_home_lookup->getLinearAddress(address) : address; }
+};
+
 class NucaCache
 {
    private:
+      // Each bank has its own tags and data, queue and lock, so accesses to different banks proceed independently
+      struct Bank
+      {
+         Cache* cache;
+         QueueModel *queue_model;
+         Lock lock;
+         UInt64 reads, writes, read_misses, write_misses;
+         Bank() : cache(NULL), queue_model(NULL), reads(0), writes(0), read_misses(0), write_misses(0) {}
+      };
+
       core_id_t m_core_id;
       MemoryManagerBase *m_memory_manager;
       ShmemPerfModel *m_shmem_perf_model;
@@ -26,20 +62,25 @@ class NucaCache
       ComponentLatency m_tags_access_time;
       ComponentBandwidth m_data_array_bandwidth;
 
-      Cache* m_cache;
-      QueueModel *m_queue_model;
-
-      UInt64 m_reads, m_writes, m_read_misses, m_write_misses;
+      NucaBankLookup m_bank_lookup;
+      std::vector<Bank*> m_banks;
 
       ShmemPerf m_dummy_shmem_perf;
 
-      SubsecondTime accessDataArray(Cache::access_t access, SubsecondTime t_start, ShmemPerf *perf);
+      SubsecondTime accessDataArray(Bank &bank, Cache::access_t access, SubsecondTime t_start, ShmemPerf *perf);
+
+      static UInt64 getBankStat(String objectName, UInt32 index, String metricName, UInt64 arg);
 
    public:
       NucaCache(MemoryManagerBase* memory_manager, ShmemPerfModel* shmem_perf_model, AddressHomeLookup* home_lookup, UInt32 cache_block_size, ParametricDramDirectoryMSI::CacheParameters& parameters);
       ~NucaCache();
 
-      boost::tuple<SubsecondTime, HitWhere::where_t> read(IntPtr address, Byte* data_buf, SubsecondTime now, ShmemPerf *perf, bool count);
+      // tags_done: the tags were already looked up together with the directory (perf_model/dram_directory/llc_colocated)
+      boost::tuple<SubsecondTime, HitWhere::where_t> read(IntPtr address, Byte* data_buf, SubsecondTime now, ShmemPerf *perf, bool count, bool tags_done = false);
+      // Tag-only lookup, does not touch replacement state or statistics
+      bool isCached(IntPtr address);
+      SubsecondTime getTagsAccessTime() const { return m_tags_access_time.getLatency(); }
+
       boost::tuple<SubsecondTime, HitWhere::where_t> write(IntPtr address, Byte* data_buf, bool& eviction, IntPtr& evict_address, Byte* evict_buf, SubsecondTime now, bool count);
 };
 
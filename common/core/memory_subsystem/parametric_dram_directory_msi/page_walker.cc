@@ -0,0 +1,92 @@
+#include "page_walker.h"
+#include "cache_cntlr.h"
+#include "stats.h"
+#include "log.h"
+
+namespace ParametricDramDirectoryMSI
+{
+
+PageWalker::PageWalker(core_id_t core_id, UInt32 page_shift, UInt32 walk_cache_size, CacheCntlr *cache_cntlr, UInt32 cache_block_size, ShmemPerfModel *shmem_perf_model)
+   : m_leaf_level(NUM_LEVELS - 1 - (page_shift - BASE_SHIFT) / LEVEL_BITS)
+   , m_cache_cntlr(cache_cntlr)
+   , m_cache_block_size(cache_block_size)
+   , m_shmem_perf_model(shmem_perf_model)
+   , m_walks(0)
+   , m_memory_accesses(0)
+   , m_walk_cache_hits(0)
+   , m_latency(SubsecondTime::Zero())
+{
+   LOG_ASSERT_ERROR(page_shift >= BASE_SHIFT && (page_shift - BASE_SHIFT) % LEVEL_BITS == 0 && page_shift < BASE_SHIFT + LEVEL_BITS * NUM_LEVELS,
+      "Page walks are only supported for 4KB, 2MB and 1GB pages");
+
+   if (walk_cache_size)
+      m_walk_caches.resize(m_leaf_level, TLBTagArray(1, walk_cache_size));
+
+   registerStatsMetric("page_walker", core_id, "walks", &m_walks);
+   registerStatsMetric("page_walker", core_id, "memory-accesses", &m_memory_accesses);
+   registerStatsMetric("page_walker", core_id, "walk-cache-hits", &m_walk_cache_hits);
+   registerStatsMetric("page_walker", core_id, "total-latency", &m_latency);
+}
+
+// Each distinct prefix above a level gets its own 4KB table, tables of a level are laid out by prefix
+IntPtr
+PageWalker::entryAddress(IntPtr address, UInt32 level) const
+{
+   address &= (IntPtr(1) << (BASE_SHIFT + LEVEL_BITS * NUM_LEVELS)) - 1;
+   IntPtr table = PAGE_TABLE_BASE + (IntPtr(level) << 40) + ((address >> (levelShift(level) + LEVEL_BITS)) << BASE_SHIFT);
+   IntPtr index = (address >> levelShift(level)) & ((1 << LEVEL_BITS) - 1);
+   return table + index * sizeof(UInt64);
+}
+
+SubsecondTime
+PageWalker::walk(IntPtr address, bool modeled, bool count)
+{
+   // Find the deepest level whose entry is in the page-walk cache, the walk continues below it
+   UInt32 start = 0;
+   for(UInt32 level = m_walk_caches.size(); level > 0; --level)
+   {
+      if (m_walk_caches[level - 1].lookup(address >> levelShift(level - 1)))
+      {
+         start = level;
+         ++m_walk_cache_hits;
+         break;
+      }
+   }
+
+   SubsecondTime t_start = m_shmem_perf_model->getElapsedTime(ShmemPerfModel::_USER_THREAD);
+   for(UInt32 level = start; level <= m_leaf_level; ++level)
+   {
+      // Each level depends on the entry loaded by the previous one
+      IntPtr entry = entryAddress(address, level);
+      m_cache_cntlr->processMemOpFromCore(Core::NONE, Core::READ, entry & ~IntPtr(m_cache_block_size - 1), entry & (m_cache_block_size - 1),
+                                          NULL, sizeof(UInt64), modeled, count);
+      ++m_memory_accesses;
+
+      IntPtr evicted;
+      if (level < m_walk_caches.size())
+         m_walk_caches[level].insert(address >> levelShift(level), evicted);
+   }
+
+   SubsecondTime latency = m_shmem_perf_model->getElapsedTime(ShmemPerfModel::_USER_THREAD) - t_start;
+   m_shmem_perf_model->setElapsedTime(ShmemPerfModel::_USER_THREAD, t_start);
+
+   ++m_walks;
+   m_latency += latency;
+   return latency;
+}
+
+void
+PageWalker::saveState(CheckpointWriter &ckpt) const
+{
+   for(std::vector<TLBTagArray>::const_iterator it = m_walk_caches.begin(); it != m_walk_caches.end(); ++it)
+      it->saveState(ckpt);
+}
+
+void
+PageWalker::loadState(CheckpointReader &ckpt)
+{
+   for(std::vector<TLBTagArray>::iterator it = m_walk_caches.begin(); it != m_walk_caches.end(); ++it)
+      it->loadState(ckpt, "page walk cache");
+}
+
+}
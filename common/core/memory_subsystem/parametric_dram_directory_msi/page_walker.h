@@ -0,0 +1,49 @@
+#ifndef PAGE_WALKER_H
+#define PAGE_WALKER_H
+
+#include "tlb.h"
+#include "shmem_perf_model.h"
+
+namespace ParametricDramDirectoryMSI
+{
+   class CacheCntlr;
+
+   // Hardware page walker for an x86-64 style four-level radix page table.
+   // Page table entries are loaded through the given (L1-D) cache controller, so walks compete with
+   // and benefit from the data caches. The page table itself is not tracked: entry addresses are
+   // synthesized in a region outside the user address space, with neighbouring pages sharing
+   // page table lines like they would in a real process.
+   // A page-walk cache per upper level (PML4, PDPT and, for 4KB pages, PD entries) lets walks skip the
+   // levels whose entry for the walked address is cached.
+   class PageWalker
+   {
+      private:
+         static const UInt32 NUM_LEVELS = 4;
+         static const UInt32 LEVEL_BITS = 9;
+         static const UInt32 BASE_SHIFT = 12;
+         static const IntPtr PAGE_TABLE_BASE = 0xffff800000000000ULL;
+
+         const UInt32 m_leaf_level; // Level of the leaf entry: 3 for 4KB pages, 2 for 2MB, 1 for 1GB
+         std::vector<TLBTagArray> m_walk_caches; // One per level above the leaf
+         CacheCntlr *m_cache_cntlr;
+         const UInt32 m_cache_block_size;
+         ShmemPerfModel *m_shmem_perf_model;
+
+         UInt64 m_walks, m_memory_accesses, m_walk_cache_hits;
+         SubsecondTime m_latency;
+
+         UInt32 levelShift(UInt32 level) const { return BASE_SHIFT + LEVEL_BITS * (NUM_LEVELS - 1 - level); }
+         IntPtr entryAddress(IntPtr address, UInt32 level) const;
+
+      public:
+         PageWalker(core_id_t core_id, UInt32 page_shift, UInt32 walk_cache_size, CacheCntlr *cache_cntlr, UInt32 cache_block_size, ShmemPerfModel *shmem_perf_model);
+
+         // Walk the page table for address, returns the walk latency but leaves the thread's time unchanged
+         SubsecondTime walk(IntPtr address, bool modeled, bool count);
+
+         void saveState(CheckpointWriter &ckpt) const;
+         void loadState(CheckpointReader &ckpt);
+   };
+}
+
+#endif // PAGE_WALKER_H
@@ -0,0 +1,145 @@
+#include "prefetch_throttle.h"
+#include "simulator.h"
+#include "stats.h"
+#include "config.hpp"
+#include "utils.h"
+#include "log.h"
+
+#include <boost/algorithm/string.hpp>
+
+static std::vector<UInt32> parseLevels(String configName, String key, core_id_t core_id)
+{
+   String value = Sim()->getCfg()->getStringArray(configName + "/prefetcher/throttle/" + key, core_id);
+   std::vector<String> tokens;
+   boost::split(tokens, value, boost::is_any_of(" ,"), boost::token_compress_on);
+
+   std::vector<UInt32> levels;
+   for(std::vector<String>::iterator it = tokens.begin(); it != tokens.end(); ++it)
+   {
+      if (!it->empty())
+         levels.push_back(atoi(it->c_str()));
+   }
+   return levels;
+}
+
+PrefetchThrottle* PrefetchThrottle::create(String name, String configName, core_id_t core_id, UInt32 cache_block_size)
+{
+   if (Sim()->getCfg()->getBoolDefault(configName + "/prefetcher/throttle/enabled", false))
+      return new PrefetchThrottle(name, configName, core_id, cache_block_size);
+   else
+      return NULL;
+}
+
+PrefetchThrottle::PrefetchThrottle(String name, String configName, core_id_t core_id, UInt32 cache_block_size)
+   : m_log_blocksize(floorLog2(cache_block_size))
+   , m_interval(Sim()->getCfg()->getIntArray(configName + "/prefetcher/throttle/interval", core_id))
+   , m_accuracy_high(Sim()->getCfg()->getFloatArray(configName + "/prefetcher/throttle/accuracy_high", core_id))
+   , m_accuracy_low(Sim()->getCfg()->getFloatArray(configName + "/prefetcher/throttle/accuracy_low", core_id))
+   , m_lateness_threshold(Sim()->getCfg()->getFloatArray(configName + "/prefetcher/throttle/lateness_threshold", core_id))
+   , m_pollution_threshold(Sim()->getCfg()->getFloatArray(configName + "/prefetcher/throttle/pollution_threshold", core_id))
+   , m_distance(parseLevels(configName, "distance", core_id))
+   , m_degree(parseLevels(configName, "degree", core_id))
+   , m_filter(FILTER_SIZE)
+   , m_evictions(0), m_issued(0), m_useful(0), m_late(0), m_demand_misses(0), m_polluting(0)
+   , m_avg_issued(0), m_avg_useful(0), m_avg_late(0), m_avg_demand_misses(0), m_avg_polluting(0)
+   , m_total_useful(0), m_total_late(0), m_total_polluting(0), m_increments(0), m_decrements(0)
+{
+   LOG_ASSERT_ERROR(m_interval > 0, "%s/prefetcher/throttle/interval must be at least 1", configName.c_str());
+   LOG_ASSERT_ERROR(m_distance.size() > 0 && m_distance.size() == m_degree.size(),
+      "%s/prefetcher/throttle/distance and degree must list the same, non-zero number of levels", configName.c_str());
+   LOG_ASSERT_ERROR(m_accuracy_low <= m_accuracy_high,
+      "%s/prefetcher/throttle/accuracy_low must not be larger than accuracy_high", configName.c_str());
+
+   m_level = Sim()->getCfg()->getIntArray(configName + "/prefetcher/throttle/start_level", core_id);
+   LOG_ASSERT_ERROR(m_level < m_distance.size(), "%s/prefetcher/throttle/start_level(%u) must be below the number of levels(%u)",
+      configName.c_str(), m_level, m_distance.size());
+
+   for(std::vector<Eviction>::iterator it = m_filter.begin(); it != m_filter.end(); ++it)
+      it->evicted = it->inserted = INVALID_ADDRESS;
+
+   registerStatsMetric(name, core_id, "prefetch-useful", &m_total_useful);
+   registerStatsMetric(name, core_id, "prefetch-late", &m_total_late);
+   registerStatsMetric(name, core_id, "prefetch-polluting", &m_total_polluting);
+   registerStatsMetric(name, core_id, "prefetch-throttle-increments", &m_increments);
+   registerStatsMetric(name, core_id, "prefetch-throttle-decrements", &m_decrements);
+}
+
+void
+PrefetchThrottle::prefetchUsed(bool late)
+{
+   ++m_useful;
+   ++m_total_useful;
+   if (late)
+   {
+      ++m_late;
+      ++m_total_late;
+   }
+}
+
+IntPtr
+PrefetchThrottle::demandMiss(IntPtr address)
+{
+   ++m_demand_misses;
+
+   IntPtr line = address >> m_log_blocksize;
+   Eviction &entry = m_filter[hash(line)];
+   if (entry.evicted != line)
+      return INVALID_ADDRESS;
+
+   // Only count each eviction once
+   entry.evicted = INVALID_ADDRESS;
+   return entry.inserted << m_log_blocksize;
+}
+
+void
+PrefetchThrottle::evicted(IntPtr evict_address, IntPtr insert_address)
+{
+   IntPtr line = evict_address >> m_log_blocksize;
+   Eviction &entry = m_filter[hash(line)];
+   entry.evicted = line;
+   entry.inserted = insert_address >> m_log_blocksize;
+
+   if (++m_evictions >= m_interval)
+      adjust();
+}
+
+void
+PrefetchThrottle::adjust()
+{
+   // Give the current interval and all earlier ones (themselves averaged) equal weight
+   m_avg_issued = (m_avg_issued + m_issued) / 2;
+   m_avg_useful = (m_avg_useful + m_useful) / 2;
+   m_avg_late = (m_avg_late + m_late) / 2;
+   m_avg_demand_misses = (m_avg_demand_misses + m_demand_misses) / 2;
+   m_avg_polluting = (m_avg_polluting + m_polluting) / 2;
+   m_evictions = m_issued = m_useful = m_late = m_demand_misses = m_polluting = 0;
+
+   // Nothing to learn from an interval without prefetches
+   if (m_avg_issued == 0)
+      return;
+
+   double accuracy = m_avg_useful / m_avg_issued;
+   bool late = m_avg_useful > 0 && m_avg_late / m_avg_useful > m_lateness_threshold;
+   bool polluting = m_avg_demand_misses > 0 && m_avg_polluting / m_avg_demand_misses > m_pollution_threshold;
+
+   SInt32 update;
+   if (accuracy >= m_accuracy_high)
+      // Accurate: prefetch further ahead when prefetches are late, even at the cost of some pollution
+      update = late ? 1 : 0;
+   else if (accuracy >= m_accuracy_low)
+      update = polluting ? -1 : (late ? 1 : 0);
+   else
+      // Inaccurate: being late or polluting is a reason to back off, prefetching earlier would not help
+      update = polluting || late ? -1 : 0;
+
+   if (update > 0 && m_level + 1 < m_distance.size())
+   {
+      ++m_level;
+      ++m_increments;
+   }
+   else if (update < 0 && m_level > 0)
+   {
+      --m_level;
+      ++m_decrements;
+   }
+}
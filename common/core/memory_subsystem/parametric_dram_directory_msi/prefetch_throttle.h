@@ -0,0 +1,66 @@
+#ifndef __PREFETCH_THROTTLE_H
+#define __PREFETCH_THROTTLE_H
+
+#include "fixed_types.h"
+#include "core.h"
+
+#include <vector>
+
+// Feedback-directed prefetch throttling (FDP, Srinath et al., HPCA 2007), attached to a cache level's prefetcher.
+// Per interval of <interval> evictions from the cache, three metrics are measured:
+//   - accuracy: prefetched lines that were used by a demand access, over prefetches issued
+//   - lateness: useful prefetches whose line was still on its way when the demand access arrived
+//   - pollution: demand misses to lines that were evicted by a prefetched line that did not get used, over demand misses
+// Each metric is averaged with its value of the previous interval, and the outcome moves the aggressiveness level
+// up or down one step. A level limits how far down the prefetcher's candidate list we look (distance) and
+// how many of the candidates not yet in the cache get queued (degree).
+// All calls are made with the cache controller's lock held.
+
+class PrefetchThrottle
+{
+   private:
+      static const UInt32 FILTER_SIZE = 4096;
+
+      struct Eviction
+      {
+         IntPtr evicted;  // Line that was evicted
+         IntPtr inserted; // Line that replaced it
+      };
+
+      const UInt32 m_log_blocksize;
+      const UInt64 m_interval;
+      const double m_accuracy_high, m_accuracy_low, m_lateness_threshold, m_pollution_threshold;
+      std::vector<UInt32> m_distance, m_degree;
+      UInt32 m_level;
+
+      std::vector<Eviction> m_filter; // Most recent eviction per hash bucket, to detect pollution
+
+      // Current interval
+      UInt64 m_evictions, m_issued, m_useful, m_late, m_demand_misses, m_polluting;
+      // Averaged over previous intervals
+      double m_avg_issued, m_avg_useful, m_avg_late, m_avg_demand_misses, m_avg_polluting;
+
+      // Totals, for statistics
+      UInt64 m_total_useful, m_total_late, m_total_polluting, m_increments, m_decrements;
+
+      UInt32 hash(IntPtr line) const { return ((line * 0x9e3779b97f4a7c15ULL) >> 32) % FILTER_SIZE; }
+      void adjust();
+
+   public:
+      static PrefetchThrottle* create(String name, String configName, core_id_t core_id, UInt32 cache_block_size);
+
+      PrefetchThrottle(String name, String configName, core_id_t core_id, UInt32 cache_block_size);
+
+      UInt32 getDistance() const { return m_distance[m_level]; }
+      UInt32 getDegree() const { return m_degree[m_level]; }
+
+      void prefetchIssued() { ++m_issued; }
+      void prefetchUsed(bool late);
+      // Demand miss, returns the line that evicted <address> if that happened recently, else INVALID_ADDRESS
+      IntPtr demandMiss(IntPtr address);
+      // The line returned by demandMiss was a prefetched line that had not been used yet
+      void polluted() { ++m_polluting; ++m_total_polluting; }
+      void evicted(IntPtr evict_address, IntPtr insert_address);
+};
+
+#endif // __PREFETCH_THROTTLE_H
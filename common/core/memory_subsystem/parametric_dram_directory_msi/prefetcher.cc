@@ -5,6 +5,7 @@
 #include "simple_prefetcher.h"
 #include "ghb_prefetcher.h"
 #include "a53prefetcher.h"
+#include "ip_stride_prefetcher.h"
 
 Prefetcher* Prefetcher::createPrefetcher(String type, String configName, core_id_t core_id, UInt32 shared_cores)
 {
@@ -16,6 +17,26 @@ Prefetcher* Prefetcher::createPrefetcher(String type, String configName, core_id
       return new GhbPrefetcher(configName, core_id);
    else if (type == "a53prefetcher")
        return new A53Prefetcher(configName, core_id);
+   else if (type == "ip_stride")
+      return new IpStridePrefetcher(configName, core_id);
 
    LOG_PRINT_ERROR("Invalid prefetcher type %s", type.c_str());
 }
+
+UInt32
+Prefetcher::train(const Access *accesses, UInt32 num_accesses, IntPtr *prefetches, UInt32 max_prefetches)
+{
+   UInt32 num_prefetches = 0;
+   for(UInt32 i = 0; i < num_accesses; ++i)
+      num_prefetches += getNextAddresses(accesses[i], prefetches + num_prefetches, max_prefetches - num_prefetches);
+   return num_prefetches;
+}
+
+std::vector<IntPtr>
+Prefetcher::getNextAddress(IntPtr current_address, core_id_t core_id)
+{
+   IntPtr prefetches[MAX_PREFETCHES];
+   Access access = { current_address, 0, core_id };
+   UInt32 num_prefetches = getNextAddresses(access, prefetches, MAX_PREFETCHES);
+   return std::vector<IntPtr>(prefetches, prefetches + num_prefetches);
+}
@@ -5,12 +5,41 @@
 
 #include <vector>
 
+class CheckpointWriter;
+class CheckpointReader;
+
 class Prefetcher
 {
    public:
+      // Upper bound on the candidates a caller needs to make room for per access,
+      // prefetchers stop writing once the caller's buffer is full but keep training
+      static const UInt32 MAX_PREFETCHES = 64;
+
+      struct Access
+      {
+         IntPtr address;
+         IntPtr eip;          // Instruction address of the access, or zero when it is not known (e.g., below the L1)
+         core_id_t core_id;
+      };
+
       static Prefetcher* createPrefetcher(String type, String configName, core_id_t core_id, UInt32 shared_cores);
 
-      virtual std::vector<IntPtr> getNextAddress(IntPtr current_address, core_id_t core_id) = 0;
+      virtual ~Prefetcher() {}
+
+      // Train on a single access, and write up to max_prefetches addresses to prefetch into prefetches.
+      // Returns the number of addresses written.
+      virtual UInt32 getNextAddresses(const Access &access, IntPtr *prefetches, UInt32 max_prefetches) = 0;
+
+      // Train on num_accesses accesses in order, appending the candidates of all of them to prefetches.
+      // Returns the total number of addresses written, at most max_prefetches.
+      UInt32 train(const Access *accesses, UInt32 num_accesses, IntPtr *prefetches, UInt32 max_prefetches);
+
+      // Convenience wrapper around getNextAddresses for a single access without instruction address
+      std::vector<IntPtr> getNextAddress(IntPtr current_address, core_id_t core_id);
+
+      // Checkpointing of the prefetcher's training state, prefetchers without state save nothing
+      virtual void saveState(CheckpointWriter &ckpt) const {}
+      virtual void loadState(CheckpointReader &ckpt) {}
 };
 
 #endif // PREFETCHER_H
@@ -1,6 +1,7 @@
 #include "simple_prefetcher.h"
 #include "simulator.h"
 #include "config.hpp"
+#include "checkpoint.h"
 
 #include <cstdlib>
 
@@ -21,10 +22,11 @@ SimplePrefetcher::SimplePrefetcher(String configName, core_id_t _core_id, UInt32
       m_prev_address.at(idx).resize(n_flows);
 }
 
-std::vector<IntPtr>
-SimplePrefetcher::getNextAddress(IntPtr current_address, core_id_t _core_id)
+UInt32
+SimplePrefetcher::getNextAddresses(const Access &access, IntPtr *prefetches, UInt32 max_prefetches)
 {
-   std::vector<IntPtr> &prev_address = m_prev_address.at(flows_per_core ? _core_id - core_id : 0);
+   const IntPtr current_address = access.address;
+   std::vector<IntPtr> &prev_address = m_prev_address.at(flows_per_core ? access.core_id - core_id : 0);
 
    UInt32 n_flow = n_flow_next;
    IntPtr min_dist = PAGE_SIZE;
@@ -48,17 +50,33 @@ SimplePrefetcher::getNextAddress(IntPtr current_address, core_id_t _core_id)
    IntPtr stride = current_address - prev_address[n_flow];
    prev_address[n_flow] = current_address;
 
-   std::vector<IntPtr> addresses;
+   UInt32 count = 0;
    if (stride != 0)
    {
-      for(unsigned int i = 0; i < num_prefetches; ++i)
+      for(unsigned int i = 0; i < num_prefetches && count < max_prefetches; ++i)
       {
          IntPtr prefetch_address = current_address + i * stride;
          // But stay within the page if requested
          if (!stop_at_page || ((prefetch_address & PAGE_MASK) == (current_address & PAGE_MASK)))
-            addresses.push_back(prefetch_address);
+            prefetches[count++] = prefetch_address;
       }
    }
 
-   return addresses;
+   return count;
+}
+
+void
+SimplePrefetcher::saveState(CheckpointWriter &ckpt) const
+{
+   ckpt.put(n_flow_next);
+   for(std::vector<std::vector<IntPtr> >::const_iterator it = m_prev_address.begin(); it != m_prev_address.end(); ++it)
+      ckpt.put(*it);
+}
+
+void
+SimplePrefetcher::loadState(CheckpointReader &ckpt)
+{
+   ckpt.get(n_flow_next);
+   for(std::vector<std::vector<IntPtr> >::iterator it = m_prev_address.begin(); it != m_prev_address.end(); ++it)
+      ckpt.get(*it);
 }
@@ -7,7 +7,9 @@ class SimplePrefetcher : public Prefetcher
 {
    public:
       SimplePrefetcher(String configName, core_id_t core_id, UInt32 shared_cores);
-      virtual std::vector<IntPtr> getNextAddress(IntPtr current_address, core_id_t core_id);
+      virtual UInt32 getNextAddresses(const Access &access, IntPtr *prefetches, UInt32 max_prefetches);
+      virtual void saveState(CheckpointWriter &ckpt) const;
+      virtual void loadState(CheckpointReader &ckpt);
 
    private:
       const core_id_t core_id;
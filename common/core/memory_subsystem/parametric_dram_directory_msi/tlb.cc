@@ -1,27 +1,60 @@
 #include "tlb.h"
 #include "stats.h"
+#include "checkpoint.h"
+#include "utils.h"
+#include "log.h"
 
 namespace ParametricDramDirectoryMSI
 {
 
-TLB::TLB(String name, String cfgname, core_id_t core_id, UInt32 num_entries, UInt32 associativity, TLB *next_level)
-   : m_size(num_entries)
+TLBTagArray::TLBTagArray(UInt32 num_sets, UInt32 associativity)
+   : m_num_sets(num_sets)
    , m_associativity(associativity)
-   , m_cache(name + "_cache", cfgname, core_id, num_entries / associativity, associativity, SIM_PAGE_SIZE, "lru", CacheBase::PR_L1_CACHE)
+   , m_mask(isPower2(num_sets))
+   , m_tags(num_sets * associativity, INVALID_TAG)
+{
+}
+
+void
+TLBTagArray::saveState(CheckpointWriter &ckpt) const
+{
+   ckpt.put(m_num_sets);
+   ckpt.put(m_associativity);
+   ckpt.put(m_tags);
+}
+
+void
+TLBTagArray::loadState(CheckpointReader &ckpt, const String &name)
+{
+   UInt32 num_sets, associativity;
+   ckpt.get(num_sets);
+   ckpt.get(associativity);
+   LOG_ASSERT_ERROR(num_sets == m_num_sets && associativity == m_associativity,
+      "Checkpoint for %s has %d sets of %d ways, expected %d sets of %d ways", name.c_str(), num_sets, associativity, m_num_sets, m_associativity);
+   ckpt.get(m_tags);
+}
+
+TLB::TLB(String name, core_id_t core_id, UInt32 page_shift, UInt32 num_entries, UInt32 associativity, TLB *next_level)
+   : m_page_shift(page_shift)
+   , m_size(num_entries)
+   , m_associativity(associativity)
+   , m_tags(num_entries / associativity, associativity)
    , m_next_level(next_level)
    , m_access(0)
    , m_miss(0)
+   , m_name(name)
 {
    LOG_ASSERT_ERROR((num_entries / associativity) * associativity == num_entries, "Invalid TLB configuration: num_entries(%d) must be a multiple of the associativity(%d)", num_entries, associativity);
+   LOG_ASSERT_ERROR(next_level == NULL || next_level->m_page_shift == page_shift, "TLB levels must use the same page size");
 
    registerStatsMetric(name, core_id, "access", &m_access);
    registerStatsMetric(name, core_id, "miss", &m_miss);
 }
 
 bool
-TLB::lookup(IntPtr address, SubsecondTime now, bool allocate_on_miss)
+TLB::lookupPage(IntPtr page, bool allocate_on_miss)
 {
-   bool hit = m_cache.accessSingleLine(address, Cache::LOAD, NULL, 0, now, true);
+   bool hit = m_tags.lookup(page);
 
    m_access++;
 
@@ -32,28 +65,26 @@ TLB::lookup(IntPtr address, SubsecondTime now, bool allocate_on_miss)
 
    if (m_next_level)
    {
-      hit = m_next_level->lookup(address, now, false /* no allocation */);
+      hit = m_next_level->lookupPage(page, false /* no allocation */);
    }
 
    if (allocate_on_miss)
    {
-      allocate(address, now);
+      allocatePage(page);
    }
 
    return hit;
 }
 
 void
-TLB::allocate(IntPtr address, SubsecondTime now)
+TLB::allocatePage(IntPtr page)
 {
-   bool eviction;
-   IntPtr evict_addr;
-   CacheBlockInfo evict_block_info;
-   m_cache.insertSingleLine(address, NULL, &eviction, &evict_addr, &evict_block_info, NULL, now);
+   IntPtr evicted;
+   bool eviction = m_tags.insert(page, evicted);
 
    // Use next level as a victim cache
    if (eviction && m_next_level)
-      m_next_level->allocate(evict_addr, now);
+      m_next_level->allocatePage(evicted);
 }
 
 }
@@ -2,28 +2,94 @@
 #define TLB_H
 
 #include "fixed_types.h"
-#include "cache.h"
+#include "subsecond_time.h"
+
+#include <vector>
+
+class CheckpointWriter;
+class CheckpointReader;
 
 namespace ParametricDramDirectoryMSI
 {
+   // Set-associative array of page numbers with LRU replacement.
+   // Each set is a contiguous run of tags kept in most-recently-used order,
+   // so a lookup is a short linear scan and the LRU victim is always the last way.
+   class TLBTagArray
+   {
+      private:
+         static const IntPtr INVALID_TAG = ~IntPtr(0);
+
+         UInt32 m_num_sets;
+         UInt32 m_associativity;
+         bool m_mask; // num_sets is a power of two
+         std::vector<IntPtr> m_tags;
+
+         IntPtr* getSet(IntPtr tag) { return &m_tags[(m_mask ? tag & (m_num_sets - 1) : tag % m_num_sets) * m_associativity]; }
+
+      public:
+         TLBTagArray(UInt32 num_sets, UInt32 associativity);
+
+         // Look up tag, and make it the most recently used entry of its set on a hit
+         bool lookup(IntPtr tag)
+         {
+            IntPtr *set = getSet(tag);
+            for(UInt32 way = 0; way < m_associativity; ++way)
+            {
+               if (set[way] == tag)
+               {
+                  for(; way > 0; --way)
+                     set[way] = set[way - 1];
+                  set[0] = tag;
+                  return true;
+               }
+            }
+            return false;
+         }
+
+         // Insert tag as the most recently used entry of its set, returns true if a valid tag was evicted.
+         // A tag that is already present is only moved up, which keeps victim insertions from duplicating entries.
+         bool insert(IntPtr tag, IntPtr &evicted)
+         {
+            IntPtr *set = getSet(tag);
+            UInt32 way = 0;
+            while (way < m_associativity - 1 && set[way] != tag)
+               ++way;
+            evicted = set[way] == tag ? INVALID_TAG : set[way];
+            for(; way > 0; --way)
+               set[way] = set[way - 1];
+            set[0] = tag;
+            return evicted != INVALID_TAG;
+         }
+
+         void saveState(CheckpointWriter &ckpt) const;
+         void loadState(CheckpointReader &ckpt, const String &name);
+   };
+
    class TLB
    {
       private:
-         static const UInt32 SIM_PAGE_SHIFT = 12; // 4KB
-         static const IntPtr SIM_PAGE_SIZE = (1L << SIM_PAGE_SHIFT);
-         static const IntPtr SIM_PAGE_MASK = ~(SIM_PAGE_SIZE - 1);
+         const UInt32 m_page_shift;
 
          UInt32 m_size;
          UInt32 m_associativity;
-         Cache m_cache;
+         TLBTagArray m_tags;
 
          TLB *m_next_level;
 
          UInt64 m_access, m_miss;
+
+         String m_name;
+
+         bool lookupPage(IntPtr page, bool allocate_on_miss);
+         void allocatePage(IntPtr page);
+
       public:
-         TLB(String name, String cfgname, core_id_t core_id, UInt32 num_entries, UInt32 associativity, TLB *next_level);
-         bool lookup(IntPtr address, SubsecondTime now, bool allocate_on_miss = true);
-         void allocate(IntPtr address, SubsecondTime now);
+         TLB(String name, core_id_t core_id, UInt32 page_shift, UInt32 num_entries, UInt32 associativity, TLB *next_level);
+         bool lookup(IntPtr address, SubsecondTime now, bool allocate_on_miss = true) { return lookupPage(address >> m_page_shift, allocate_on_miss); }
+         void allocate(IntPtr address, SubsecondTime now) { allocatePage(address >> m_page_shift); }
+
+         void saveState(CheckpointWriter &ckpt) const { m_tags.saveState(ckpt); }
+         void loadState(CheckpointReader &ckpt) { m_tags.loadState(ckpt, m_name); }
    };
 }
 
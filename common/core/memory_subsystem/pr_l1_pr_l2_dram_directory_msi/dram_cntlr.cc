@@ -6,6 +6,8 @@
 #include "stats.h"
 #include "fault_injection.h"
 #include "shmem_perf.h"
+#include "numa_topology.h"
+#include "qos_manager.h"
 
 #if 0
    extern Lock iolock;
@@ -27,6 +29,11 @@ DramCntlr::DramCntlr(MemoryManagerBase* memory_manager,
    : DramCntlrInterface(memory_manager, shmem_perf_model, cache_block_size)
    , m_reads(0)
    , m_writes(0)
+   , m_qos(Sim()->getQosManager())
+   , m_numa(Sim()->getNumaTopology())
+   , m_socket(m_numa ? m_numa->getCoreSocket(memory_manager->getCore()->getId()) : 0)
+   , m_remote_reads(0)
+   , m_remote_writes(0)
 {
    m_dram_perf_model = DramPerfModel::createDramPerfModel(
          memory_manager->getCore()->getId(),
@@ -39,6 +46,11 @@ DramCntlr::DramCntlr(MemoryManagerBase* memory_manager,
    m_dram_access_count = new AccessCountMap[DramCntlrInterface::NUM_ACCESS_TYPES];
    registerStatsMetric("dram", memory_manager->getCore()->getId(), "reads", &m_reads);
    registerStatsMetric("dram", memory_manager->getCore()->getId(), "writes", &m_writes);
+   if (m_numa)
+   {
+      registerStatsMetric("dram", memory_manager->getCore()->getId(), "remote-reads", &m_remote_reads);
+      registerStatsMetric("dram", memory_manager->getCore()->getId(), "remote-writes", &m_remote_writes);
+   }
 }
 
 DramCntlr::~DramCntlr()
@@ -109,8 +121,41 @@ SubsecondTime
 DramCntlr::runDramPerfModel(core_id_t requester, SubsecondTime time, IntPtr address, DramCntlrInterface::access_t access_type, ShmemPerf *perf)
 {
    UInt64 pkt_size = getCacheBlockSize();
-   SubsecondTime dram_access_latency = m_dram_perf_model->getAccessLatency(time, pkt_size, requester, address, access_type, perf);
-   return dram_access_latency;
+
+   // Memory bandwidth allocation: requests are held back until the requester's bandwidth limit allows them
+   SubsecondTime throttle_delay = SubsecondTime::Zero();
+   if (m_qos)
+   {
+      throttle_delay = m_qos->throttle(requester, time, pkt_size);
+      if (throttle_delay > SubsecondTime::Zero())
+      {
+         perf->updateTime(time);
+         perf->updateTime(time + throttle_delay, ShmemPerf::DRAM_QUEUE);
+         time += throttle_delay;
+      }
+   }
+
+   UInt32 requester_socket = m_numa ? m_numa->getCoreSocket(requester) : m_socket;
+   if (requester_socket == m_socket)
+      return throttle_delay + m_dram_perf_model->getAccessLatency(time, pkt_size, requester, address, access_type, perf);
+
+   // Memory on another socket: reads send a request over the inter-socket link and get the data back,
+   // writes send the data
+   SubsecondTime latency;
+   if (access_type == READ)
+   {
+      ++m_remote_reads;
+      latency = m_numa->crossLink(requester_socket, m_socket, time, 0, perf);
+      latency += m_dram_perf_model->getAccessLatency(time + latency, pkt_size, requester, address, access_type, perf);
+      latency += m_numa->crossLink(m_socket, requester_socket, time + latency, pkt_size, perf);
+   }
+   else
+   {
+      ++m_remote_writes;
+      latency = m_numa->crossLink(requester_socket, m_socket, time, pkt_size, perf);
+      latency += m_dram_perf_model->getAccessLatency(time + latency, pkt_size, requester, address, access_type, perf);
+   }
+   return throttle_delay + latency;
 }
 
 void
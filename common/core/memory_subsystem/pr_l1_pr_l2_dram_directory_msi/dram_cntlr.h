@@ -14,6 +14,8 @@
 #include "subsecond_time.h"
 
 class FaultInjector;
+class NumaTopology;
+class QosManager;
 
 namespace PrL1PrL2DramDirectoryMSI
 {
@@ -28,6 +30,11 @@ namespace PrL1PrL2DramDirectoryMSI
          AccessCountMap* m_dram_access_count;
          UInt64 m_reads, m_writes;
 
+         QosManager* m_qos;
+         NumaTopology* m_numa;
+         UInt32 m_socket;
+         UInt64 m_remote_reads, m_remote_writes;
+
          ShmemPerf m_dummy_shmem_perf;
 
          SubsecondTime runDramPerfModel(core_id_t requester, SubsecondTime time, IntPtr address, DramCntlrInterface::access_t access_type, ShmemPerf *perf);
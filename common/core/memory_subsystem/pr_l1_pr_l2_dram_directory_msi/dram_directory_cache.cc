@@ -1,4 +1,6 @@
 #include "dram_directory_cache.h"
+#include "simulator.h"
+#include "host_topology.h"
 #include "log.h"
 #include "utils.h"
 
@@ -15,6 +17,8 @@ DramDirectoryCache::DramDirectoryCache(
       UInt32 max_num_sharers,
       ComponentLatency dram_directory_cache_access_time,
       ShmemPerfModel* shmem_perf_model):
+   m_replacement_set(0),
+   m_replacement_start(0),
    m_total_entries(total_entries),
    m_associativity(associativity),
    m_cache_block_size(cache_block_size),
@@ -25,7 +29,10 @@ DramDirectoryCache::DramDirectoryCache(
 
    // Instantiate the directory
    m_directory = new Directory(core_id, directory_type_str, total_entries, max_hw_sharers, max_num_sharers);
-   m_replacement_ptrs = new UInt32[m_num_sets];
+   m_tags = (IntPtr*)Sim()->getHostTopology()->allocLarge(m_total_entries * sizeof(IntPtr));
+   for (UInt32 i = 0; i < m_total_entries; i++)
+      m_tags[i] = INVALID_ADDRESS;
+   m_replacement_ptrs = new UInt32[m_num_sets]();
 
    // Logs
    m_log_num_sets = floorLog2(m_num_sets);
@@ -34,7 +41,12 @@ DramDirectoryCache::DramDirectoryCache(
 
 DramDirectoryCache::~DramDirectoryCache()
 {
+   for (std::vector<DirectoryEntry*>::iterator it = m_replaced_directory_entry_list.begin(); it != m_replaced_directory_entry_list.end(); it++)
+      delete (*it);
+   for (std::vector<DirectoryEntry*>::iterator it = m_free_directory_entry_list.begin(); it != m_free_directory_entry_list.end(); it++)
+      delete (*it);
    delete[] m_replacement_ptrs;
+   Sim()->getHostTopology()->freeLarge(m_tags, m_total_entries * sizeof(IntPtr));
    delete m_directory;
 }
 
@@ -50,30 +62,30 @@ DramDirectoryCache::getDirectoryEntry(IntPtr address, bool modeled)
    // Assume that it always hit in the Dram Directory Cache for now
    splitAddress(address, tag, set_index);
 
-   // Find the relevant directory entry
+   // Find the relevant directory entry, remembering the first free one in case it does not exist
+   const IntPtr* tags = &m_tags[set_index * m_associativity];
+   UInt32 free_way = m_associativity;
    for (UInt32 i = 0; i < m_associativity; i++)
    {
-      DirectoryEntry* directory_entry = m_directory->getDirectoryEntry(set_index * m_associativity + i);
-
-      if (directory_entry->getAddress() == address)
+      if (tags[i] == address)
       {
+         DirectoryEntry* directory_entry = m_directory->getDirectoryEntry(set_index * m_associativity + i);
          if (m_shmem_perf_model && modeled)
             getShmemPerfModel()->incrElapsedTime(directory_entry->getLatency(), ShmemPerfModel::_SIM_THREAD);
          // Simple check for now. Make sophisticated later
          return directory_entry;
       }
+      if (tags[i] == INVALID_ADDRESS && free_way == m_associativity)
+         free_way = i;
    }
 
-   // Find a free directory entry if one does not currently exist
-   for (UInt32 i = 0; i < m_associativity; i++)
+   // Use a free directory entry if one does not currently exist
+   if (free_way < m_associativity)
    {
-      DirectoryEntry* directory_entry = m_directory->getDirectoryEntry(set_index * m_associativity + i);
-      if (directory_entry->getAddress() == INVALID_ADDRESS)
-      {
-         // Simple check for now. Make sophisticated later
-         directory_entry->setAddress(address);
-         return directory_entry;
-      }
+      DirectoryEntry* directory_entry = m_directory->getDirectoryEntry(set_index * m_associativity + free_way);
+      directory_entry->setAddress(address);
+      m_tags[set_index * m_associativity + free_way] = address;
+      return directory_entry;
    }
 
    // Check in the m_replaced_directory_entry_list
@@ -89,20 +101,23 @@ DramDirectoryCache::getDirectoryEntry(IntPtr address, bool modeled)
    return (DirectoryEntry*) NULL;
 }
 
-void
-DramDirectoryCache::getReplacementCandidates(IntPtr address, std::vector<DirectoryEntry*>& replacement_candidate_list)
+UInt32
+DramDirectoryCache::getReplacementCandidates(IntPtr address)
 {
    assert(getDirectoryEntry(address) == NULL);
 
    IntPtr tag;
-   UInt32 set_index;
-   splitAddress(address, tag, set_index);
+   splitAddress(address, tag, m_replacement_set);
 
-   for (UInt32 i = 0; i < m_associativity; i++)
-   {
-      replacement_candidate_list.push_back(m_directory->getDirectoryEntry(set_index * m_associativity + ((i + m_replacement_ptrs[set_index]) % m_associativity)));
-   }
-   ++m_replacement_ptrs[set_index];
+   m_replacement_start = m_replacement_ptrs[m_replacement_set]++;
+   return m_associativity;
+}
+
+DirectoryEntry*
+DramDirectoryCache::getReplacementCandidate(UInt32 idx)
+{
+   assert(idx < m_associativity);
+   return m_directory->getDirectoryEntry(m_replacement_set * m_associativity + ((idx + m_replacement_start) % m_associativity));
 }
 
 DirectoryEntry*
@@ -117,14 +132,24 @@ DramDirectoryCache::replaceDirectoryEntry(IntPtr replaced_address, IntPtr addres
 
    for (UInt32 i = 0; i < m_associativity; i++)
    {
-      DirectoryEntry* replaced_directory_entry = m_directory->getDirectoryEntry(set_index * m_associativity + i);
-      if (replaced_directory_entry->getAddress() == replaced_address)
+      if (m_tags[set_index * m_associativity + i] == replaced_address)
       {
+         DirectoryEntry* replaced_directory_entry = m_directory->getDirectoryEntry(set_index * m_associativity + i);
          m_replaced_directory_entry_list.push_back(replaced_directory_entry);
 
-         DirectoryEntry* directory_entry = m_directory->createDirectoryEntry();
+         DirectoryEntry* directory_entry;
+         if (m_free_directory_entry_list.empty())
+         {
+            directory_entry = m_directory->createDirectoryEntry();
+         }
+         else
+         {
+            directory_entry = m_free_directory_entry_list.back();
+            m_free_directory_entry_list.pop_back();
+         }
          directory_entry->setAddress(address);
          m_directory->setDirectoryEntry(set_index * m_associativity + i, directory_entry);
+         m_tags[set_index * m_associativity + i] = address;
 
          return directory_entry;
       }
@@ -142,7 +167,10 @@ DramDirectoryCache::invalidateDirectoryEntry(IntPtr address)
    {
       if ((*it)->getAddress() == address)
       {
-         delete (*it);
+         // The entry has been nullified (it is UNCACHED, without sharers): keep it for the next replacement
+         LOG_ASSERT_ERROR((*it)->getNumSharers() == 0, "Invalidating directory entry %lx with %u sharers", address, (*it)->getNumSharers());
+         (*it)->setAddress(INVALID_ADDRESS);
+         m_free_directory_entry_list.push_back(*it);
          m_replaced_directory_entry_list.erase(it);
 
          return;
@@ -152,7 +180,6 @@ DramDirectoryCache::invalidateDirectoryEntry(IntPtr address)
    // Should not reach here
    LOG_PRINT_ERROR("");
 }
-
 void
 DramDirectoryCache::splitAddress(IntPtr address, IntPtr& tag, UInt32& set_index)
 {
@@ -12,8 +12,17 @@ namespace PrL1PrL2DramDirectoryMSI
    {
       private:
          Directory* m_directory;
+         // Address held by each way, set-major (entry set_index * associativity + way), INVALID_ADDRESS when free.
+         // Lookups scan one contiguous row of this instead of dereferencing every entry of the set.
+         IntPtr* m_tags;
          UInt32* m_replacement_ptrs;
+         // Set and first way of the replacement started by the last getReplacementCandidates()
+         UInt32 m_replacement_set;
+         UInt32 m_replacement_start;
+         // Entries replaced in the cache that are still being nullified, until invalidateDirectoryEntry()
          std::vector<DirectoryEntry*> m_replaced_directory_entry_list;
+         // Invalidated entries, reused by replaceDirectoryEntry() instead of allocating new ones
+         std::vector<DirectoryEntry*> m_free_directory_entry_list;
 
          UInt32 m_total_entries;
          UInt32 m_associativity;
@@ -50,8 +59,12 @@ namespace PrL1PrL2DramDirectoryMSI
          DirectoryEntry* getDirectoryEntry(IntPtr address, bool modeled = false);
          DirectoryEntry* replaceDirectoryEntry(IntPtr replaced_address, IntPtr address, bool modeled);
          void invalidateDirectoryEntry(IntPtr address);
-         void getReplacementCandidates(IntPtr address, std::vector<DirectoryEntry*>& replacement_candidate_list);
+         // Start a replacement for address, returns the number of candidates (the ways of its set)
+         UInt32 getReplacementCandidates(IntPtr address);
+         // Candidate idx of the replacement started last, in round-robin order from the set's replacement pointer
+         DirectoryEntry* getReplacementCandidate(UInt32 idx);
 
          UInt32 getMaxHwSharers() const { return m_directory->getMaxHwSharers(); }
+         SubsecondTime getAccessTime() const { return m_dram_directory_cache_access_time.getLatency(); }
    };
 }
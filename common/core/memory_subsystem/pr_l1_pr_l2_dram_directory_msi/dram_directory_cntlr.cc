@@ -6,6 +6,10 @@
 #include "shmem_perf.h"
 #include "coherency_protocol.h"
 #include "config.hpp"
+#include "simulator.h"
+#include "clock_skew_minimization_object.h"
+
+#include <algorithm>
 
 #if 0
    extern Lock iolock;
@@ -50,7 +54,9 @@ DramDirectoryCntlr::DramDirectoryCntlr(core_id_t core_id,
    m_cache_block_size(cache_block_size),
    m_shmem_perf_model(shmem_perf_model),
    forward(0),
-   forward_failed(0)
+   forward_failed(0),
+   colocated_llc_lookups(0),
+   snoop_filter_lookups(0)
 {
    m_dram_directory_cache = new DramDirectoryCache(
          core_id,
@@ -74,22 +80,13 @@ DramDirectoryCntlr::DramDirectoryCntlr(core_id_t core_id,
    registerStatsMetric("directory", core_id, "forward", &forward);
    registerStatsMetric("directory", core_id, "forward-failed", &forward_failed);
 
-   String protocol = Sim()->getCfg()->getString("caching_protocol/variant");
-   if (protocol == "msi")
-   {
-      m_protocol = CoherencyProtocol::MSI;
-   }
-   else if (protocol == "mesi")
-   {
-      m_protocol = CoherencyProtocol::MESI;
-   }
-   else if (protocol == "mesif")
-   {
-      m_protocol = CoherencyProtocol::MESIF;
-   }
-   else
+   m_protocol = CoherencyProtocol::parse(Sim()->getCfg()->getString("caching_protocol/variant"));
+
+   m_llc_colocated = Sim()->getCfg()->getBool("perf_model/dram_directory/llc_colocated") && m_nuca_cache;
+   if (m_llc_colocated)
    {
-      LOG_PRINT_ERROR("Invalid coherency protocol %s, must be msi, mesi or mesif", protocol.c_str());
+      registerStatsMetric("directory", core_id, "colocated-llc-lookups", &colocated_llc_lookups);
+      registerStatsMetric("directory", core_id, "snoop-filter-lookups", &snoop_filter_lookups);
    }
 }
 
@@ -109,9 +106,9 @@ DramDirectoryCntlr::handleMsgFromL2Cache(core_id_t sender, ShmemMsg* shmem_msg)
    MYLOG("begin for address %lx, %d in queue", address, m_dram_directory_req_queue_list->size(address));
 
    // Look up line state in the tag directory
-   // This is just for modeling the TD lookup time (this is the only place where we call getDirectoryEntry with modeled==true),
+   // This is just for modeling the TD lookup time (this is the only place where the lookup is modeled),
    // elsewhere we assume outstanding requests are stored in a fast MSHR-like structure
-   m_dram_directory_cache->getDirectoryEntry(address, true);
+   accessTagDirectory(address);
    updateShmemPerf(shmem_msg, ShmemPerf::TD_ACCESS);
 
    switch (shmem_msg_type)
@@ -197,6 +194,36 @@ DramDirectoryCntlr::handleMsgFromL2Cache(core_id_t sender, ShmemMsg* shmem_msg)
 MYLOG("done for %lx", address);
 }
 
+void
+DramDirectoryCntlr::accessTagDirectory(IntPtr address)
+{
+   if (m_llc_colocated)
+   {
+      // Like an inclusive LLC, the sharers of lines in the NUCA cache are kept in its tags, and a snoop filter
+      // looked up in parallel covers the lines that are not. One lookup yields both the directory state and
+      // whether the LLC has the data, retrieveDataAndSendToL2Cache does not access the NUCA tags again.
+      SubsecondTime latency = m_nuca_cache->getTagsAccessTime();
+      if (m_nuca_cache->isCached(address))
+      {
+         ++colocated_llc_lookups;
+      }
+      else
+      {
+         ++snoop_filter_lookups;
+         latency = std::max(latency, m_dram_directory_cache->getAccessTime());
+      }
+
+      DirectoryEntry* directory_entry = m_dram_directory_cache->getDirectoryEntry(address);
+      if (directory_entry)
+         latency += directory_entry->getLatency();
+      getShmemPerfModel()->incrElapsedTime(latency, ShmemPerfModel::_SIM_THREAD);
+   }
+   else
+   {
+      m_dram_directory_cache->getDirectoryEntry(address, true);
+   }
+}
+
 void
 DramDirectoryCntlr::handleMsgFromDRAM(core_id_t sender, ShmemMsg* shmem_msg)
 {
@@ -265,31 +292,30 @@ DramDirectoryCntlr::processDirectoryEntryAllocationReq(ShmemReq* shmem_req)
 
    MYLOG("Start @ %lx", address);
 
-   std::vector<DirectoryEntry*> replacement_candidate_list;
-   m_dram_directory_cache->getReplacementCandidates(address, replacement_candidate_list);
+   UInt32 num_candidates = m_dram_directory_cache->getReplacementCandidates(address);
 
-   std::vector<DirectoryEntry*>::iterator it;
-   std::vector<DirectoryEntry*>::iterator replacement_candidate = replacement_candidate_list.end();
-   for (it = replacement_candidate_list.begin(); it != replacement_candidate_list.end(); it++)
+   DirectoryEntry* replacement_candidate = NULL;
+   for (UInt32 i = 0; i < num_candidates; i++)
    {
-      if ( ( (replacement_candidate == replacement_candidate_list.end()) ||
-             ((*replacement_candidate)->getNumSharers() > (*it)->getNumSharers())
+      DirectoryEntry* candidate = m_dram_directory_cache->getReplacementCandidate(i);
+      if ( ( (replacement_candidate == NULL) ||
+             (replacement_candidate->getNumSharers() > candidate->getNumSharers())
            )
            &&
-           (m_dram_directory_req_queue_list->size((*it)->getAddress()) == 0)
+           (m_dram_directory_req_queue_list->size(candidate->getAddress()) == 0)
          )
       {
-         replacement_candidate = it;
+         replacement_candidate = candidate;
       }
    }
 
-   LOG_ASSERT_ERROR(replacement_candidate != replacement_candidate_list.end(),
+   LOG_ASSERT_ERROR(replacement_candidate != NULL,
          "Cannot find a directory entry to be replaced with a non-zero request list (see Redmine #175)");
 
-   DirectoryState::dstate_t curr_dstate = (*replacement_candidate)->getDirectoryBlockInfo()->getDState();
+   DirectoryState::dstate_t curr_dstate = replacement_candidate->getDirectoryBlockInfo()->getDState();
    evict[curr_dstate]++;
 
-   IntPtr replaced_address = (*replacement_candidate)->getAddress();
+   IntPtr replaced_address = replacement_candidate->getAddress();
 
    // We get the entry with the lowest number of sharers
    DirectoryEntry* directory_entry = m_dram_directory_cache->replaceDirectoryEntry(replaced_address, address, true);
@@ -340,6 +366,7 @@ DramDirectoryCntlr::processNullifyReq(ShmemReq* shmem_req)
                ShmemPerfModel::_SIM_THREAD);
          break;
 
+      case DirectoryState::OWNED:
       case DirectoryState::SHARED:
 
          {
@@ -348,6 +375,7 @@ DramDirectoryCntlr::processNullifyReq(ShmemReq* shmem_req)
             {
                // Broadcast Invalidation Request to all cores
                // (irrespective of whether they are sharers or not)
+               // An OWNED line's owner answers with a FLUSH_REP
                getMemoryManager()->broadcastMsg(ShmemMsg::INV_REQ,
                      MemComponent::TAG_DIR, MemComponent::L2_CACHE,
                      requester /* requester */,
@@ -358,10 +386,12 @@ DramDirectoryCntlr::processNullifyReq(ShmemReq* shmem_req)
             }
             else
             {
-               // Send Invalidation Request to only a specific set of sharers
+               // Send Invalidation Request to only a specific set of sharers,
+               // the owner of an OWNED line has the only up-to-date copy so it is flushed instead
                for (UInt32 i = 0; i < sharers_list_pair.second.size(); i++)
                {
-                  getMemoryManager()->sendMsg(ShmemMsg::INV_REQ,
+                  bool is_owner = curr_dstate == DirectoryState::OWNED && sharers_list_pair.second[i] == directory_entry->getOwner();
+                  getMemoryManager()->sendMsg(is_owner ? ShmemMsg::FLUSH_REQ : ShmemMsg::INV_REQ,
                         MemComponent::TAG_DIR, MemComponent::L2_CACHE,
                         requester /* requester */,
                         sharers_list_pair.second[i] /* receiver */,
@@ -413,6 +443,9 @@ DramDirectoryCntlr::processExReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_da
 
    updateShmemPerf(shmem_req, ShmemPerf::TD_ACCESS);
 
+   if (curr_dstate != DirectoryState::UNCACHED)
+      Sim()->getClockSkewMinimizationServer()->notifySharing();
+
    switch (curr_dstate)
    {
       case DirectoryState::EXCLUSIVE: // Cache may have done a silent upgrade to MODIFIED, so send a FLUSH (dirty data) rather than an INV (data clean)
@@ -466,6 +499,58 @@ DramDirectoryCntlr::processExReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_da
          break;
       }
 
+      case DirectoryState::OWNED:
+      {
+         assert(cached_data_buf == NULL);
+         std::pair<bool, std::vector<SInt32> > sharers_list_pair = directory_entry->getSharersList();
+         if (directory_entry->getNumSharers() == 1)
+         {
+            // Only the owner is left: have it flush its dirty copy, which is forwarded to the requester
+            MYLOG("Send FLUSH_REQ>%d for %lx (OWNED)", directory_entry->getOwner(), address )
+            getMemoryManager()->sendMsg(ShmemMsg::FLUSH_REQ,
+                  MemComponent::TAG_DIR, MemComponent::L2_CACHE,
+                  requester /* requester */,
+                  directory_entry->getOwner() /* receiver */,
+                  address,
+                  NULL, 0,
+                  HitWhere::UNKNOWN, shmem_req->getShmemMsg()->getPerf(), ShmemPerfModel::_SIM_THREAD);
+         }
+         else if (sharers_list_pair.first == true)
+         {
+            // Broadcast Invalidation Request to all cores, the owner answers with a FLUSH_REP
+            getMemoryManager()->broadcastMsg(ShmemMsg::INV_REQ,
+                  MemComponent::TAG_DIR, MemComponent::L2_CACHE,
+                  requester /* requester */,
+                  address,
+                  NULL, 0,
+                  NULL, // No ShmemPerf on broadcast
+                  ShmemPerfModel::_SIM_THREAD);
+         }
+         else
+         {
+            // Invalidate the clean copies first, processInvRepFromL2Cache flushes the owner once they are gone
+            bool shmem_perf_sent = false;
+            for (UInt32 i = 0; i < sharers_list_pair.second.size(); i++)
+            {
+               if (sharers_list_pair.second[i] != directory_entry->getOwner())
+               {
+                  MYLOG("Send INV_REQ>%d for %lx (OWNED)", sharers_list_pair.second[i], address )
+                  getMemoryManager()->sendMsg(ShmemMsg::INV_REQ,
+                        MemComponent::TAG_DIR, MemComponent::L2_CACHE,
+                        requester /* requester */,
+                        sharers_list_pair.second[i] /* receiver */,
+                        address,
+                        NULL, 0,
+                        HitWhere::UNKNOWN,
+                        shmem_perf_sent == false ? shmem_req->getShmemMsg()->getPerf() : &m_dummy_shmem_perf,
+                        ShmemPerfModel::_SIM_THREAD);
+                  shmem_perf_sent = true;
+               }
+            }
+         }
+         break;
+      }
+
       case DirectoryState::UNCACHED:
       {
          // Modifiy the directory entry contents
@@ -505,6 +590,10 @@ DramDirectoryCntlr::processShReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_da
 
    updateShmemPerf(shmem_req, ShmemPerf::TD_ACCESS);
 
+   // Reading a line that another core may have written
+   if (curr_dstate != DirectoryState::UNCACHED && curr_dstate != DirectoryState::SHARED)
+      Sim()->getClockSkewMinimizationServer()->notifySharing();
+
    switch (curr_dstate)
    {
       case DirectoryState::EXCLUSIVE:
@@ -574,6 +663,46 @@ DramDirectoryCntlr::processShReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_da
          break;
       }
 
+      case DirectoryState::OWNED:
+      {
+         if (cached_data_buf == NULL)
+         {
+            // Owner forwarding: the owner sends us its dirty data and keeps it, memory is not updated
+            MYLOG("WB_REQ>%d for %lx (OWNED)", directory_entry->getOwner(), address  )
+            shmem_req->setForwardingFrom(directory_entry->getOwner());
+            getMemoryManager()->sendMsg(ShmemMsg::WB_REQ,
+                  MemComponent::TAG_DIR, MemComponent::L2_CACHE,
+                  requester /* requester */,
+                  directory_entry->getOwner() /* receiver */,
+                  address,
+                  NULL, 0,
+                  HitWhere::UNKNOWN, shmem_req->getShmemMsg()->getPerf(), ShmemPerfModel::_SIM_THREAD);
+         }
+         else
+         {
+            ++forward;
+            bool add_result = directory_entry->addSharer(requester, m_dram_directory_cache->getMaxHwSharers());
+            if (add_result)
+            {
+               retrieveDataAndSendToL2Cache(ShmemMsg::SH_REP, requester, address, cached_data_buf, shmem_req->getShmemMsg());
+            }
+            else
+            {
+               // No room for another sharer: have the owner write back and give up its slot,
+               // processFlushRepFromL2Cache then handles this request in the SHARED state
+               MYLOG("FLUSH_REQ>%d for %lx because I could not add sharer", directory_entry->getOwner(), address  )
+               getMemoryManager()->sendMsg(ShmemMsg::FLUSH_REQ,
+                     MemComponent::TAG_DIR, MemComponent::L2_CACHE,
+                     requester /* requester */,
+                     directory_entry->getOwner() /* receiver */,
+                     address,
+                     NULL, 0,
+                     HitWhere::UNKNOWN, shmem_req->getShmemMsg()->getPerf(), ShmemPerfModel::_SIM_THREAD);
+            }
+         }
+         break;
+      }
+
       case DirectoryState::UNCACHED:
       {
          MYLOG("was UNCACHED, is now EXCLUSIVE")
@@ -640,7 +769,7 @@ DramDirectoryCntlr::retrieveDataAndSendToL2Cache(ShmemMsg::msg_t reply_msg_type,
          SubsecondTime nuca_latency;
          HitWhere::where_t hit_where;
          Byte nuca_data_buf[getCacheBlockSize()];
-         boost::tie(nuca_latency, hit_where) = m_nuca_cache->read(address, nuca_data_buf, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_SIM_THREAD), orig_shmem_msg->getPerf(), true);
+         boost::tie(nuca_latency, hit_where) = m_nuca_cache->read(address, nuca_data_buf, getShmemPerfModel()->getElapsedTime(ShmemPerfModel::_SIM_THREAD), orig_shmem_msg->getPerf(), true, m_llc_colocated);
 
          getShmemPerfModel()->incrElapsedTime(nuca_latency, ShmemPerfModel::_SIM_THREAD);
 
@@ -804,14 +933,19 @@ DramDirectoryCntlr::processInvRepFromL2Cache(core_id_t sender, ShmemMsg* shmem_m
    assert(directory_entry);
 
    DirectoryBlockInfo* directory_block_info = directory_entry->getDirectoryBlockInfo();
-   LOG_ASSERT_ERROR(directory_block_info->getDState() == DirectoryState::SHARED || directory_block_info->getDState() == DirectoryState::EXCLUSIVE, "Ooops (%lx)", address);
-   assert(directory_block_info->getDState() == DirectoryState::SHARED || directory_block_info->getDState() == DirectoryState::EXCLUSIVE);
+   LOG_ASSERT_ERROR(directory_block_info->getDState() == DirectoryState::SHARED || directory_block_info->getDState() == DirectoryState::EXCLUSIVE
+      || directory_block_info->getDState() == DirectoryState::OWNED, "Ooops (%lx)", address);
 
    directory_entry->removeSharer(sender);
    if (directory_entry->getForwarder() == sender)
    {
       directory_entry->setForwarder(INVALID_CORE_ID);
    }
+   if (directory_block_info->getDState() == DirectoryState::OWNED && directory_entry->getOwner() == sender)
+   {
+      directory_entry->setOwner(INVALID_CORE_ID);
+      directory_block_info->setDState(DirectoryState::SHARED);
+   }
    if (directory_entry->getNumSharers() == 0)
    {
       directory_block_info->setDState(DirectoryState::UNCACHED);
@@ -834,6 +968,12 @@ DramDirectoryCntlr::processInvRepFromL2Cache(core_id_t sender, ShmemMsg* shmem_m
             updateShmemPerf(shmem_req, ShmemPerf::INV_IMBALANCE);
             processExReqFromL2Cache(shmem_req);
          }
+         else if (directory_block_info->getDState() == DirectoryState::OWNED && directory_entry->getNumSharers() == 1)
+         {
+            // All clean copies are gone, only the owner remains: get the data from it
+            updateShmemPerf(shmem_req, ShmemPerf::INV_IMBALANCE);
+            processExReqFromL2Cache(shmem_req);
+         }
       }
       else if (shmem_req->getShmemMsg()->getMsgType() == ShmemMsg::UPGRADE_REQ)
       {
@@ -932,6 +1072,9 @@ DramDirectoryCntlr::processUpgradeReqFromL2Cache(ShmemReq* shmem_req, Byte* cach
 
    updateShmemPerf(shmem_msg, ShmemPerf::TD_ACCESS);
 
+   if (directory_entry->getNumSharers() > 1)
+      Sim()->getClockSkewMinimizationServer()->notifySharing();
+
    switch (curr_dstate)
    {
       case DirectoryState::EXCLUSIVE:
@@ -969,6 +1112,7 @@ DramDirectoryCntlr::processUpgradeReqFromL2Cache(ShmemReq* shmem_req, Byte* cach
 
          break;
       }
+      case DirectoryState::OWNED:
       case DirectoryState::SHARED:
       {
          if ((sharers_list_pair.second.size() == 1) && (sharers_list_pair.second[0] == requester))
@@ -1019,7 +1163,9 @@ DramDirectoryCntlr::processUpgradeReqFromL2Cache(ShmemReq* shmem_req, Byte* cach
                   {
                      MYLOG("INV REQ (UPGR)>%u @ %lx",sharers_list_pair.second[i] , shmem_msg->getAddress());
                      // avoid having to fetch the data from DRAM, so ask at least one core to FLUSH instead of INV
-                     ShmemMsg::msg_t msg_type = (!requesterHasCopy && i==0) ? ShmemMsg::FLUSH_REQ : ShmemMsg::INV_REQ;
+                     // the owner of an OWNED line always flushes, it has the only up-to-date copy
+                     bool is_owner = curr_dstate == DirectoryState::OWNED && sharers_list_pair.second[i] == directory_entry->getOwner();
+                     ShmemMsg::msg_t msg_type = ((!requesterHasCopy && i==0) || is_owner) ? ShmemMsg::FLUSH_REQ : ShmemMsg::INV_REQ;
                      //ShmemMsg::msg_t msg_type = ShmemMsg::INV_REQ;
                      getMemoryManager()->sendMsg( msg_type, //ShmemMsg::INV_REQ,
                            MemComponent::TAG_DIR, MemComponent::L2_CACHE,
@@ -1080,9 +1226,12 @@ DramDirectoryCntlr::processFlushRepFromL2Cache(core_id_t sender, ShmemMsg* shmem
    DirectoryBlockInfo* directory_block_info = directory_entry->getDirectoryBlockInfo();
 
    assert(directory_entry->hasSharer(sender));
+   // Sharers of an OWNED line can be flushed too (upgrades), only the owner flushing ends the OWNED state
+   bool owner_flushed = directory_block_info->getDState() != DirectoryState::OWNED || directory_entry->getOwner() == sender;
    directory_entry->removeSharer(sender);
    directory_entry->setForwarder(INVALID_CORE_ID);
-   directory_entry->setOwner(INVALID_CORE_ID);
+   if (owner_flushed)
+      directory_entry->setOwner(INVALID_CORE_ID);
 
    // could be that this is a FLUSH to force a core with S-state to to write back clean data
    // to avoid a memory access
@@ -1090,6 +1239,11 @@ DramDirectoryCntlr::processFlushRepFromL2Cache(core_id_t sender, ShmemMsg* shmem
    {
       directory_block_info->setDState(DirectoryState::UNCACHED);
    }
+   else if (directory_block_info->getDState() == DirectoryState::OWNED)
+   {
+      if (owner_flushed)
+         directory_block_info->setDState(DirectoryState::SHARED);
+   }
    else
    {
       assert(directory_block_info->getDState() == DirectoryState::SHARED);
@@ -1109,7 +1263,16 @@ DramDirectoryCntlr::processFlushRepFromL2Cache(core_id_t sender, ShmemMsg* shmem
       // An involuntary/voluntary Flush
       if (shmem_req->getShmemMsg()->getMsgType() == ShmemMsg::EX_REQ)
       {
-         processExReqFromL2Cache(shmem_req, shmem_msg->getDataBuf());
+         if (directory_block_info->getDState() == DirectoryState::UNCACHED)
+         {
+            processExReqFromL2Cache(shmem_req, shmem_msg->getDataBuf());
+         }
+         else
+         {
+            // The owner of an OWNED line evicted it while clean copies are still being invalidated,
+            // processInvRepFromL2Cache completes the request
+            sendDataToDram(address, shmem_msg->getRequester(), shmem_msg->getDataBuf(), now);
+         }
       }
       else if (shmem_req->getShmemMsg()->getMsgType() == ShmemMsg::SH_REQ)
       {
@@ -1141,7 +1304,9 @@ DramDirectoryCntlr::processFlushRepFromL2Cache(core_id_t sender, ShmemMsg* shmem
       {
          // Write Data To Dram
          sendDataToDram(address, shmem_msg->getRequester(), shmem_msg->getDataBuf(), now);
-         processNullifyReq(shmem_req);
+         // When nullifying an OWNED line, clean copies may still be outstanding
+         if (directory_block_info->getDState() == DirectoryState::UNCACHED)
+            processNullifyReq(shmem_req);
       }
    }
    else
@@ -1170,8 +1335,17 @@ DramDirectoryCntlr::processWbRepFromL2Cache(core_id_t sender, ShmemMsg* shmem_ms
    //assert(directory_block_info->getDState() == DirectoryState::MODIFIED);
    assert(directory_entry->hasSharer(sender));
 
-   directory_entry->setOwner(INVALID_CORE_ID);
-   directory_block_info->setDState(DirectoryState::SHARED);
+   if (m_protocol == CoherencyProtocol::MOESI)
+   {
+      // The sender keeps its (possibly dirty) copy in the OWNED state and supplies it to later readers
+      directory_entry->setOwner(sender);
+      directory_block_info->setDState(DirectoryState::OWNED);
+   }
+   else
+   {
+      directory_entry->setOwner(INVALID_CORE_ID);
+      directory_block_info->setDState(DirectoryState::SHARED);
+   }
 
    if (m_dram_directory_req_queue_list->size(address) != 0)
    {
@@ -33,15 +33,18 @@ namespace PrL1PrL2DramDirectoryMSI
          ShmemPerf m_dummy_shmem_perf;
 
          CoherencyProtocol::type_t m_protocol;
+         bool m_llc_colocated;   // Sharer information lives in the NUCA tags, with a snoop filter for the other lines
 
          UInt64 evict[DirectoryState::NUM_DIRECTORY_STATES];
          UInt64 forward, forward_failed;
+         UInt64 colocated_llc_lookups, snoop_filter_lookups;
 
          UInt32 getCacheBlockSize() { return m_cache_block_size; }
          MemoryManagerBase* getMemoryManager() { return m_memory_manager; }
          ShmemPerfModel* getShmemPerfModel() { return m_shmem_perf_model; }
 
          // Private Functions
+         void accessTagDirectory(IntPtr address);
          DirectoryEntry* processDirectoryEntryAllocationReq(ShmemReq* shmem_req);
          void processNullifyReq(ShmemReq* shmem_req);
 
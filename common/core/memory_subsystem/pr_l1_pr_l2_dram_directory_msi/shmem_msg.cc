@@ -63,18 +63,32 @@ namespace PrL1PrL2DramDirectoryMSI
       return shmem_msg;
    }
 
+   ShmemMsg*
+   ShmemMsg::getShmemMsgInPlace(Byte* msg_buf)
+   {
+      ShmemMsg* shmem_msg = (ShmemMsg*) msg_buf;
+      if (shmem_msg->getDataLength() > 0)
+         shmem_msg->setDataBuf(msg_buf + sizeof(*shmem_msg));
+      return shmem_msg;
+   }
+
    Byte*
    ShmemMsg::makeMsgBuf()
    {
       Byte* msg_buf = new Byte[getMsgLen()];
+      writeMsgBuf(msg_buf);
+      return msg_buf;
+   }
+
+   void
+   ShmemMsg::writeMsgBuf(Byte* msg_buf)
+   {
       memcpy(msg_buf, (void*) this, sizeof(*this));
       if (m_data_length > 0)
       {
          LOG_ASSERT_ERROR(m_data_buf != NULL, "m_data_buf(%p)", m_data_buf);
          memcpy(msg_buf + sizeof(*this), (void*) m_data_buf, m_data_length);
       }
-
-      return msg_buf;
    }
 
    UInt32
@@ -67,7 +67,10 @@ namespace PrL1PrL2DramDirectoryMSI
          ~ShmemMsg();
 
          static ShmemMsg* getShmemMsg(Byte* msg_buf, ShmemPerf* perf);
+         // Use a message buffer in place, it must stay alive (and not be freed through the ShmemMsg) while in use
+         static ShmemMsg* getShmemMsgInPlace(Byte* msg_buf);
          Byte* makeMsgBuf();
+         void writeMsgBuf(Byte* msg_buf);
          UInt32 getMsgLen();
 
          // Modeling
@@ -24,6 +24,7 @@ const char* shmem_reason_names[] = {
    "dram-queue",
    "dram-bus",
    "dram-device",
+   "numa-link",
    "unknown",
 };
 
@@ -37,12 +38,14 @@ const char* ShmemReasonString(ShmemPerf::shmem_times_type_t reason)
 }
 
 
-ShmemPerf::ShmemPerf()
-   : m_core_id(INVALID_CORE_ID)
+ShmemPerf::ShmemPerf(bool enabled)
+   : m_enabled(enabled)
+   , m_core_id(INVALID_CORE_ID)
    , m_time_begin(SubsecondTime::Zero())
-   , m_time_last(SubsecondTime::Zero())
-   , m_times(NUM_SHMEM_TIMES)
+   , m_time_last(enabled ? SubsecondTime::Zero() : SubsecondTime::MaxTime())
 {
+   for(int i = 0; i < ShmemPerf::NUM_SHMEM_TIMES; ++i)
+      m_times[i] = SubsecondTime::Zero();
 }
 
 void ShmemPerf::disable()
@@ -53,6 +56,9 @@ void ShmemPerf::disable()
 
 void ShmemPerf::reset(SubsecondTime time, core_id_t core_id)
 {
+   if (!m_enabled)
+      return;
+
    m_core_id = core_id;
    m_time_begin = time;
    m_time_last = time;
@@ -60,18 +66,6 @@ void ShmemPerf::reset(SubsecondTime time, core_id_t core_id)
       m_times[i] = SubsecondTime::Zero();
 }
 
-void ShmemPerf::updateTime(SubsecondTime time, shmem_times_type_t reason)
-{
-   LOG_ASSERT_ERROR(reason < NUM_SHMEM_TIMES, "Invalid ShmemPerf reason %d", reason);
-
-   // Ignore duplicate paths or updates using stale pointers
-   if (time > m_time_last)
-   {
-      m_times[reason] += time - m_time_last;
-      m_time_last = time;
-   }
-}
-
 void ShmemPerf::updatePacket(NetPacket& packet)
 {
    if (packet.time > m_time_last)
@@ -2,8 +2,7 @@
 #define __SHMEM_PERF_H
 
 #include "subsecond_time.h"
-
-#include <vector>
+#include "fixed_types.h"
 
 class NetPacket;
 
@@ -32,14 +31,24 @@ class ShmemPerf
          DRAM_QUEUE,
          DRAM_BUS,
          DRAM_DEVICE,
+         NUMA_LINK,
          UNKNOWN,
          NUM_SHMEM_TIMES
       } shmem_times_type_t;
 
-      ShmemPerf();
+      // A record created with enabled = false stays disabled, so every update on it is a single compare
+      ShmemPerf(bool enabled = true);
       void disable();
       void reset(SubsecondTime time, core_id_t core_id);
-      void updateTime(SubsecondTime time, shmem_times_type_t reason = UNKNOWN);
+      void updateTime(SubsecondTime time, shmem_times_type_t reason = UNKNOWN)
+      {
+         // Ignore duplicate paths, updates using stale pointers and disabled records
+         if (time > m_time_last)
+         {
+            m_times[reason] += time - m_time_last;
+            m_time_last = time;
+         }
+      }
       void updatePacket(NetPacket& packet);
       void add(ShmemPerf *perf);
 
@@ -48,10 +57,11 @@ class ShmemPerf
       SubsecondTime &getComponent(shmem_times_type_t reason) { return m_times[reason]; }
 
    private:
+      bool m_enabled;
       core_id_t m_core_id;
       SubsecondTime m_time_begin;
       SubsecondTime m_time_last;
-      std::vector<SubsecondTime> m_times;
+      SubsecondTime m_times[NUM_SHMEM_TIMES];
 };
 
 const char* ShmemReasonString(ShmemPerf::shmem_times_type_t reason);
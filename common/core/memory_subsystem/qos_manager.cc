@@ -0,0 +1,110 @@
+#include "qos_manager.h"
+#include "simulator.h"
+#include "config.h"
+#include "config.hpp"
+#include "stats.h"
+#include "log.h"
+
+#include <cstdlib>
+
+QosManager* QosManager::create()
+{
+   if (Sim()->getCfg()->getBool("perf_model/qos/enabled"))
+      return new QosManager();
+   else
+      return NULL;
+}
+
+QosManager::QosManager()
+   : m_classes(Sim()->getCfg()->getInt("perf_model/qos/classes"))
+   , m_cores(Sim()->getConfig()->getApplicationCores())
+   , m_burst(Sim()->getCfg()->getInt("perf_model/qos/burst"))
+{
+   LOG_ASSERT_ERROR(m_classes.size() > 0, "perf_model/qos/classes must be at least 1");
+
+   for(UInt32 clos = 0; clos < m_classes.size(); ++clos)
+   {
+      m_classes[clos].way_mask = 0;
+      m_classes[clos].bandwidth = 0;
+      // Way masks are given in hexadecimal, like the CAT capacity bitmasks in resctrl
+      setWayMask(clos, strtoull(Sim()->getCfg()->getStringArray("perf_model/qos/way_mask", clos).c_str(), NULL, 0));
+      setBandwidth(clos, Sim()->getCfg()->getFloatArray("perf_model/qos/bandwidth", clos));
+   }
+
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_cores.size(); ++core_id)
+   {
+      CoreState &core = m_cores[core_id];
+      core.clos = 0;
+      setClass(core_id, Sim()->getCfg()->getIntArray("perf_model/qos/core_class", core_id));
+      core.occupancy = 0;
+      core.bytes = 0;
+      core.refilled = SubsecondTime::Zero();
+      core.throttled = 0;
+      core.throttle_delay = SubsecondTime::Zero();
+
+      registerStatsMetric("qos", core_id, "llc-occupancy", &core.occupancy);
+      registerStatsMetric("qos", core_id, "memory-bytes", &core.bytes);
+      registerStatsMetric("qos", core_id, "throttled", &core.throttled);
+      registerStatsMetric("qos", core_id, "throttle-delay", &core.throttle_delay);
+   }
+}
+
+QosManager::~QosManager()
+{
+}
+
+void
+QosManager::setClass(core_id_t core_id, UInt32 clos)
+{
+   LOG_ASSERT_ERROR(clos < m_classes.size(), "Invalid class of service %u for core %d, there are %u classes", clos, core_id, m_classes.size());
+   m_cores[core_id].clos = clos;
+}
+
+void
+QosManager::setWayMask(UInt32 clos, UInt64 way_mask)
+{
+   // Like CAT, only allow contiguous masks
+   UInt64 shifted = way_mask ? way_mask >> __builtin_ctzll(way_mask) : 0;
+   LOG_ASSERT_ERROR((shifted & (shifted + 1)) == 0, "Way mask %#lx of class of service %u is not contiguous", way_mask, clos);
+   m_classes[clos].way_mask = way_mask;
+}
+
+void
+QosManager::setBandwidth(UInt32 clos, double bandwidth)
+{
+   LOG_ASSERT_ERROR(bandwidth >= 0, "Bandwidth limit of class of service %u cannot be negative", clos);
+   m_classes[clos].bandwidth = bandwidth;
+}
+
+SubsecondTime
+QosManager::throttle(core_id_t core_id, SubsecondTime now, UInt32 size)
+{
+   if (!isCore(core_id))
+      return SubsecondTime::Zero();
+
+   CoreState &core = m_cores[core_id];
+   __sync_fetch_and_add(&core.bytes, size);
+
+   double bandwidth = m_classes[core.clos].bandwidth;
+   if (bandwidth == 0)
+      return SubsecondTime::Zero();
+
+   // GB/s equals bytes/ns
+   SubsecondTime cost = SubsecondTime::FS() * UInt64(size * 1e6 / bandwidth);
+   SubsecondTime window = SubsecondTime::FS() * UInt64(m_burst * 1e6 / bandwidth);
+
+   ScopedLock sl(core.lock);
+
+   // The bucket holds tokens for at most <window> worth of requests. Once the time at which it will have refilled
+   // is further ahead than that, the request has to wait.
+   SubsecondTime start = std::max(core.refilled, now);
+   SubsecondTime delay = start > now + window ? start - now - window : SubsecondTime::Zero();
+   core.refilled = start + cost;
+
+   if (delay > SubsecondTime::Zero())
+   {
+      ++core.throttled;
+      core.throttle_delay += delay;
+   }
+   return delay;
+}
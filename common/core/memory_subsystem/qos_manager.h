@@ -0,0 +1,80 @@
+#ifndef __QOS_MANAGER_H
+#define __QOS_MANAGER_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "lock.h"
+
+#include <vector>
+
+// Shared-resource QoS in the style of Intel RDT ([perf_model/qos]).
+// Each core belongs to a class of service (CLOS). Allocation:
+//   - way masks (CAT): lines filled into the last-level cache on behalf of a core can only replace ways in its class'
+//     mask, hits are allowed in all ways
+//   - bandwidth limits (MBA): DRAM requests from each core go through a token bucket with the rate of its class,
+//     requests that find the bucket empty are delayed until enough tokens have accumulated
+// Monitoring is per core (RMIDs equal to core IDs):
+//   - occupancy (CMT): number of last-level cache lines inserted by the core that are still there
+//   - bandwidth (MBM): bytes read from and written to DRAM on behalf of the core
+// Allocation can be changed at run time, from Python (sim.qos), to implement dynamic partitioning policies.
+class QosManager
+{
+   public:
+      static QosManager* create();
+
+      QosManager();
+      ~QosManager();
+
+      UInt32 getNumClasses() const { return m_classes.size(); }
+      UInt32 getClass(core_id_t core_id) const { return m_cores[core_id].clos; }
+      void setClass(core_id_t core_id, UInt32 clos);
+
+      // Ways filled lines can be placed in, 0 for all ways
+      UInt64 getWayMask(UInt32 clos) const { return m_classes[clos].way_mask; }
+      UInt64 getCoreWayMask(core_id_t core_id) const
+      {
+         return core_id >= 0 && UInt32(core_id) < m_cores.size() ? m_classes[m_cores[core_id].clos].way_mask : 0;
+      }
+      void setWayMask(UInt32 clos, UInt64 way_mask);
+
+      // Bandwidth limit of each core in a class, in GB/s, 0 for unlimited
+      double getBandwidth(UInt32 clos) const { return m_classes[clos].bandwidth; }
+      void setBandwidth(UInt32 clos, double bandwidth);
+
+      // Delay of a DRAM request of <size> bytes issued at <now> due to the requester's bandwidth limit, and count
+      // its bytes for bandwidth monitoring
+      SubsecondTime throttle(core_id_t core_id, SubsecondTime now, UInt32 size);
+
+      void insertLine(core_id_t core_id) { if (isCore(core_id)) __sync_fetch_and_add(&m_cores[core_id].occupancy, 1); }
+      void removeLine(core_id_t core_id) { if (isCore(core_id)) __sync_fetch_and_sub(&m_cores[core_id].occupancy, 1); }
+
+      UInt64 getOccupancy(core_id_t core_id) const { return m_cores[core_id].occupancy; } // In cache lines
+      UInt64 getMemoryBytes(core_id_t core_id) const { return m_cores[core_id].bytes; }
+
+   private:
+      struct Class
+      {
+         UInt64 way_mask;
+         double bandwidth;
+      };
+
+      struct CoreState
+      {
+         UInt32 clos;
+         UInt64 occupancy;
+         UInt64 bytes;
+         // Token bucket, kept as the time at which the bucket will have refilled after all requests so far
+         Lock lock;
+         SubsecondTime refilled;
+         UInt64 throttled;
+         SubsecondTime throttle_delay;
+      };
+
+      std::vector<Class> m_classes;
+      std::vector<CoreState> m_cores;
+      const UInt32 m_burst; // Bucket size, in bytes
+
+      bool isCore(core_id_t core_id) const { return core_id >= 0 && UInt32(core_id) < m_cores.size(); }
+};
+
+#endif // __QOS_MANAGER_H
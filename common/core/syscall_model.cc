@@ -72,13 +72,17 @@ bool SyscallMdl::runEnter(IntPtr syscall_number, syscall_args_t &args)
    m_in_syscall = true;
    m_syscall_args = args;
 
-   HookSyscallEnter hook_args;
-   hook_args.thread_id = m_thread->getId();
-   hook_args.core_id = core->getId();
-   hook_args.time = core->getPerformanceModel()->getElapsedTime();
-   hook_args.syscall_number = syscall_number;
-   hook_args.args = args;
+   // Most system calls (getpid, gettid, clock_gettime, non-suppressed write, ...) never touch the thread manager,
+   // so only take its lock when someone is actually listening
+   if (Sim()->getHooksManager()->hasHooks(HookType::HOOK_SYSCALL_ENTER))
    {
+      HookSyscallEnter hook_args;
+      hook_args.thread_id = m_thread->getId();
+      hook_args.core_id = core->getId();
+      hook_args.time = core->getPerformanceModel()->getElapsedTime();
+      hook_args.syscall_number = syscall_number;
+      hook_args.args = args;
+
       ScopedLock sl(Sim()->getThreadManager()->getLock());
       Sim()->getHooksManager()->callHooks(HookType::HOOK_SYSCALL_ENTER, (UInt64)&hook_args);
    }
@@ -330,14 +334,16 @@ IntPtr SyscallMdl::runExit(IntPtr old_return)
       m_ret_val = old_return;
    }
 
-   Core *core = m_thread->getCore();
-   HookSyscallExit hook_args;
-   hook_args.thread_id = m_thread->getId();
-   hook_args.core_id = core->getId();
-   hook_args.time = core->getPerformanceModel()->getElapsedTime();
-   hook_args.ret_val = m_ret_val;
-   hook_args.emulated = m_emulated;
+   if (Sim()->getHooksManager()->hasHooks(HookType::HOOK_SYSCALL_EXIT))
    {
+      Core *core = m_thread->getCore();
+      HookSyscallExit hook_args;
+      hook_args.thread_id = m_thread->getId();
+      hook_args.core_id = core->getId();
+      hook_args.time = core->getPerformanceModel()->getElapsedTime();
+      hook_args.ret_val = m_ret_val;
+      hook_args.emulated = m_emulated;
+
       ScopedLock sl(Sim()->getThreadManager()->getLock());
       Sim()->getHooksManager()->callHooks(HookType::HOOK_SYSCALL_EXIT, (UInt64)&hook_args);
    }
@@ -1,5 +1,6 @@
 #include "fault_injection.h"
 #include "fault_injector_random.h"
+#include "fault_injector_geometric.h"
 #include "simulator.h"
 #include "config.hpp"
 #include "log.h"
@@ -27,6 +28,8 @@ FaultinjectionManager::create()
       injector = FAULT_INJECTOR_NONE;
    else if (s_injector == "random")
       injector = FAULT_INJECTOR_RANDOM;
+   else if (s_injector == "geometric")
+      injector = FAULT_INJECTOR_GEOMETRIC;
    else
       LOG_PRINT_ERROR("Unknown fault injector %s", s_injector.c_str());
 
@@ -48,6 +51,8 @@ FaultinjectionManager::getFaultInjector(UInt32 core_id, MemComponent::component_
          return new FaultInjector(core_id, mem_component);
       case FAULT_INJECTOR_RANDOM:
          return new FaultInjectorRandom(core_id, mem_component);
+      case FAULT_INJECTOR_GEOMETRIC:
+         return new FaultInjectorGeometric(core_id, mem_component);
    }
 
    return NULL;
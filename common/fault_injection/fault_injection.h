@@ -19,6 +19,7 @@ class FaultinjectionManager
       enum fault_injector_t {
          FAULT_INJECTOR_NONE,
          FAULT_INJECTOR_RANDOM,
+         FAULT_INJECTOR_GEOMETRIC,
       };
       fault_injector_t m_injector;
 
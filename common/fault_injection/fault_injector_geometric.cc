@@ -0,0 +1,70 @@
+#include "fault_injector_geometric.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "stats.h"
+#include "rng.h"
+
+#include <cmath>
+
+FaultInjectorGeometric::FaultInjectorGeometric(UInt32 core_id, MemComponent::component_t mem_component)
+   : FaultInjector(core_id, mem_component)
+   // Independent streams for each core and component
+   , m_rng(rng_seed(Sim()->getCfg()->getInt("fault_injection/geometric/seed") + core_id * MemComponent::NUM_MEM_COMPONENTS + mem_component))
+   , m_num_faults(0)
+{
+   String component_key = String("fault_injection/geometric/") + MemComponentString(mem_component) + "/rate";
+   double rate = Sim()->getCfg()->hasKey(component_key)
+      ? Sim()->getCfg()->getFloat(component_key)
+      : Sim()->getCfg()->getFloat("fault_injection/geometric/rate");
+   LOG_ASSERT_ERROR(rate >= 0 && rate < 1, "Invalid fault rate %f for %s", rate, MemComponentString(mem_component));
+
+   m_log_inverse_rate = log1p(-rate);
+   m_bits_to_fault = nextGap();
+
+   registerStatsMetric("fault-injection", core_id, String(MemComponentString(mem_component)) + "-faults", &m_num_faults);
+}
+
+void
+FaultInjectorGeometric::preRead(IntPtr addr, IntPtr location, UInt32 data_size, Byte *fault, SubsecondTime time)
+{
+   access(data_size, fault);
+}
+
+void
+FaultInjectorGeometric::postWrite(IntPtr addr, IntPtr location, UInt32 data_size, Byte *fault, SubsecondTime time)
+{
+   access(data_size, fault);
+}
+
+void
+FaultInjectorGeometric::injectFaults(UInt64 bits, Byte *fault)
+{
+   // There is a fault at bit m_bits_to_fault of this access: flip it and any further ones that fall inside the access,
+   // then carry the remainder of the last gap over to the next accesses
+   UInt64 bit_location = m_bits_to_fault;
+   while(true)
+   {
+      fault[bit_location / 8] ^= 1 << (bit_location % 8);
+      ++m_num_faults;
+
+      UInt64 gap = nextGap();
+      UInt64 remaining = bits - bit_location - 1;
+      if (gap >= remaining)
+      {
+         m_bits_to_fault = gap - remaining;
+         break;
+      }
+      bit_location += gap + 1;
+   }
+}
+
+UInt64
+FaultInjectorGeometric::nextGap()
+{
+   // Number of fault-free bits before the next fault: floor(log(U) / log(1 - rate)) with U uniform in (0, 1)
+   if (m_log_inverse_rate == 0)
+      return UINT64_MAX;
+   double u = (rng_next(m_rng) + 0.5) / 4294967296.;
+   double gap = floor(log(u) / m_log_inverse_rate);
+   return gap >= 1.8e19 ? UINT64_MAX : UInt64(gap);
+}
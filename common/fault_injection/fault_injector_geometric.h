@@ -0,0 +1,37 @@
+#ifndef __FAULT_INJECTOR_GEOMETRIC_H
+#define __FAULT_INJECTOR_GEOMETRIC_H
+
+#include "fault_injection.h"
+
+// Flips each accessed bit independently with probability fault_injection/geometric/rate (overridable per component
+// through fault_injection/geometric/<component>/rate). Rather than drawing a random number per access, the number
+// of bits until the next fault is drawn from the matching geometric distribution, so an access without faults only
+// decrements a counter, and an access covering several fault positions (e.g. a line fill) flips all of them at once.
+
+class FaultInjectorGeometric : public FaultInjector
+{
+   public:
+      FaultInjectorGeometric(UInt32 core_id, MemComponent::component_t mem_component);
+
+      virtual void preRead(IntPtr addr, IntPtr location, UInt32 data_size, Byte *fault, SubsecondTime time);
+      virtual void postWrite(IntPtr addr, IntPtr location, UInt32 data_size, Byte *fault, SubsecondTime time);
+
+   private:
+      double m_log_inverse_rate; // log(1 - rate)
+      UInt64 m_bits_to_fault;    // Bits that can still be accessed before the next fault
+      UInt64 m_rng;
+      UInt64 m_num_faults;
+
+      void access(UInt32 data_size, Byte *fault)
+      {
+         UInt64 bits = 8 * UInt64(data_size);
+         if (m_bits_to_fault >= bits)
+            m_bits_to_fault -= bits;
+         else
+            injectFaults(bits, fault);
+      }
+      void injectFaults(UInt64 bits, Byte *fault);
+      UInt64 nextGap();
+};
+
+#endif // __FAULT_INJECTOR_GEOMETRIC_H
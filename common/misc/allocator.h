@@ -22,6 +22,8 @@ class Allocator
 
       virtual void *alloc(size_t bytes) = 0;
       virtual void _dealloc(void *ptr) = 0;
+      // Number of times this allocator went to the heap for more memory, if it keeps track
+      virtual UInt64 getHeapAllocations() const { return 0; }
 
       static void dealloc(void* ptr)
       {
@@ -0,0 +1,154 @@
+#ifndef __ARENA_ALLOCATOR_H
+#define __ARENA_ALLOCATOR_H
+
+#include "allocator.h"
+#include "lock.h"
+#include "log.h"
+
+#include <vector>
+#include <stdlib.h>
+#include <stdint.h>
+
+// Bump allocator for objects that are freed in roughly the order they were allocated
+// (dynamic instructions and micro-ops going through the ROB, and their dependency lists).
+// Memory is carved out of ChunkSize-aligned chunks; each chunk counts its live objects
+// and is recycled as a whole once the last of them is freed, so there is no per-object free list.
+// Objects that stay alive keep their entire chunk alive, so this is not a general-purpose allocator.
+
+template <size_t ChunkSize = 64 * 1024> class ArenaAllocator : public Allocator
+{
+   private:
+      struct Chunk
+      {
+         UInt64 live;
+         Chunk *next;
+      };
+      static const size_t HEADER_SIZE = (sizeof(Chunk) + 15) & ~15;
+
+      UInt64 m_items;
+      Chunk *m_current;
+      size_t m_offset;
+      Chunk *m_free;
+      std::vector<Chunk*> m_chunks;
+
+      // In ROB-SMT, DynamicMicroOps are allocated by their own thread but free'd in simulate() which can be called by anyone
+      const bool m_thread_safe;
+      Lock m_lock;
+
+      static Chunk* getChunk(void *ptr)
+      {
+         return (Chunk*)((uintptr_t)ptr & ~(uintptr_t)(ChunkSize - 1));
+      }
+
+      void nextChunk()
+      {
+         if (m_free)
+         {
+            m_current = m_free;
+            m_free = m_free->next;
+         }
+         else
+         {
+            void *ptr;
+            int res = posix_memalign(&ptr, ChunkSize, ChunkSize);
+            LOG_ASSERT_ERROR(res == 0, "Cannot allocate arena chunk of %ld bytes", ChunkSize);
+            m_current = (Chunk*)ptr;
+            m_chunks.push_back(m_current);
+         }
+         m_current->live = 0;
+         m_current->next = NULL;
+         m_offset = HEADER_SIZE;
+      }
+
+   public:
+      ArenaAllocator(bool thread_safe = true)
+         : m_items(0)
+         , m_current(NULL)
+         , m_offset(ChunkSize)
+         , m_free(NULL)
+         , m_thread_safe(thread_safe)
+      {
+         static_assert((ChunkSize & (ChunkSize - 1)) == 0, "ChunkSize must be a power of two");
+      }
+
+      virtual ~ArenaAllocator()
+      {
+         if (m_items)
+            printf("[ALLOC] %" PRIu64 " items not freed from arena\n", m_items);
+         for(typename std::vector<Chunk*>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+            ::free(*it);
+      }
+
+      virtual UInt64 getHeapAllocations() const { return m_chunks.size(); }
+
+      virtual void* alloc(size_t bytes)
+      {
+         size_t size = (sizeof(DataElement) + bytes + 15) & ~15;
+         LOG_ASSERT_ERROR(size <= ChunkSize - HEADER_SIZE, "Allocation of %ld bytes does not fit in an arena chunk", bytes);
+
+         if (m_thread_safe) m_lock.acquire();
+
+         if (m_offset + size > ChunkSize)
+         {
+            // Current chunk is full. It is recycled when its last object is freed, or right now if that already happened
+            if (m_current && m_current->live == 0)
+            {
+               m_current->next = m_free;
+               m_free = m_current;
+            }
+            nextChunk();
+         }
+
+         DataElement *elem = (DataElement *)((char*)m_current + m_offset);
+         m_offset += size;
+         ++m_current->live;
+         ++m_items;
+
+         if (m_thread_safe) m_lock.release();
+
+         elem->allocator = this;
+         return elem->data;
+      }
+
+      virtual void _dealloc(void* ptr)
+      {
+         if (m_thread_safe) m_lock.acquire();
+
+         --m_items;
+         Chunk *chunk = getChunk(ptr);
+         if (--chunk->live == 0)
+         {
+            if (chunk == m_current)
+               // Everything in the current chunk is dead, start again from its beginning
+               m_offset = HEADER_SIZE;
+            else
+            {
+               chunk->next = m_free;
+               m_free = chunk;
+            }
+         }
+
+         if (m_thread_safe) m_lock.release();
+      }
+};
+
+// STL allocator that allocates from an Allocator, to put container storage into an arena
+
+template <typename T> class ArenaStlAllocator
+{
+   public:
+      typedef T value_type;
+
+      Allocator *m_alloc;
+
+      ArenaStlAllocator(Allocator *alloc) : m_alloc(alloc) {}
+      template <typename U> ArenaStlAllocator(const ArenaStlAllocator<U> &other) : m_alloc(other.m_alloc) {}
+
+      T* allocate(size_t n) { return (T*)m_alloc->alloc(n * sizeof(T)); }
+      void deallocate(T* ptr, size_t n) { Allocator::dealloc(ptr); }
+
+      template <typename U> bool operator==(const ArenaStlAllocator<U> &other) const { return m_alloc == other.m_alloc; }
+      template <typename U> bool operator!=(const ArenaStlAllocator<U> &other) const { return m_alloc != other.m_alloc; }
+};
+
+#endif // __ARENA_ALLOCATOR_H
@@ -5,41 +5,67 @@
 // Implement data needed to plot bottle graphs [Du Bois, OOSPLA 2013]
 
 BottleGraphManager::BottleGraphManager(int max_threads)
-   : m_running(max_threads, false)
-   , m_contrib(max_threads, SubsecondTime::Zero())
-   , m_runtime(max_threads, SubsecondTime::Zero())
+   : m_time_last(SubsecondTime::Zero())
+   , m_share(SubsecondTime::Zero())
+   , m_n_running(0)
+   , m_threads(max_threads)
 {
+   for(std::vector<ThreadSlot>::iterator it = m_threads.begin(); it != m_threads.end(); ++it)
+   {
+      it->running = false;
+      it->time_start = it->share_start = it->contrib = it->runtime = SubsecondTime::Zero();
+   }
 }
 
 void BottleGraphManager::threadStart(thread_id_t thread_id)
 {
-   m_contrib[thread_id] = SubsecondTime::Zero();
-   m_runtime[thread_id] = SubsecondTime::Zero();
-   registerStatsMetric("thread", thread_id, "bottle_contrib_time", &m_contrib[thread_id]);
-   registerStatsMetric("thread", thread_id, "bottle_runtime_time", &m_runtime[thread_id]);
+   m_threads[thread_id].contrib = SubsecondTime::Zero();
+   m_threads[thread_id].runtime = SubsecondTime::Zero();
+   registerStatsMetric("thread", thread_id, "bottle_contrib_time", &m_threads[thread_id].contrib);
+   registerStatsMetric("thread", thread_id, "bottle_runtime_time", &m_threads[thread_id].runtime);
+}
+
+void BottleGraphManager::charge(ThreadSlot &slot)
+{
+   slot.contrib += m_share - slot.share_start;
+   slot.runtime += m_time_last - slot.time_start;
+   slot.share_start = m_share;
+   slot.time_start = m_time_last;
 }
 
 void BottleGraphManager::update(SubsecondTime time, thread_id_t thread_id, bool running)
 {
    if (time > m_time_last)
    {
-      UInt64 n_running = 0;
-      for(thread_id_t _thread_id = 0; _thread_id < (thread_id_t)Sim()->getThreadManager()->getNumThreads(); ++_thread_id)
-         if (m_running[_thread_id])
-            ++n_running;
-
-      SubsecondTime time_delta = time - m_time_last;
-      if (n_running)
-         for(thread_id_t _thread_id = 0; _thread_id < (thread_id_t)Sim()->getThreadManager()->getNumThreads(); ++_thread_id)
-            if (m_running[_thread_id])
-            {
-               m_contrib[_thread_id] += time_delta / n_running;
-               m_runtime[_thread_id] += time_delta;
-            }
-
+      if (m_n_running)
+         m_share += (time - m_time_last) / m_n_running;
       m_time_last = time;
    }
 
-   if (thread_id != INVALID_THREAD_ID)
-      m_running[thread_id] = running;
+   if (thread_id == INVALID_THREAD_ID)
+   {
+      // Statistics are about to be written
+      for(std::vector<ThreadSlot>::iterator it = m_threads.begin(); it != m_threads.end(); ++it)
+         if (it->running)
+            charge(*it);
+   }
+   else
+   {
+      ThreadSlot &slot = m_threads[thread_id];
+      if (slot.running == running)
+         return;
+
+      if (running)
+      {
+         slot.time_start = m_time_last;
+         slot.share_start = m_share;
+         ++m_n_running;
+      }
+      else
+      {
+         charge(slot);
+         --m_n_running;
+      }
+      slot.running = running;
+   }
 }
@@ -12,13 +12,27 @@ class BottleGraphManager
       BottleGraphManager(int max_threads);
 
       void threadStart(thread_id_t thread_id);
+      // Advance to time and set thread_id's running state; thread_id == INVALID_THREAD_ID brings all statistics up to date
       void update(SubsecondTime time, thread_id_t thread_id, bool running);
 
    private:
+      // Each thread's running periods are charged lazily, when they end or when statistics are written:
+      // contrib gets the growth of m_share (the integral of 1/number of running threads) over the period.
+      struct ThreadSlot
+      {
+         bool running;
+         SubsecondTime time_start;     // Start of the period not yet charged
+         SubsecondTime share_start;    // m_share at time_start
+         SubsecondTime contrib;
+         SubsecondTime runtime;
+      } __attribute__((aligned(64)));
+
       SubsecondTime m_time_last;
-      std::vector<bool> m_running;
-      std::vector<SubsecondTime> m_contrib;
-      std::vector<SubsecondTime> m_runtime;
+      SubsecondTime m_share;
+      UInt64 m_n_running;
+      std::vector<ThreadSlot> m_threads;
+
+      void charge(ThreadSlot &slot);
 };
 
 #endif // __BOTTLEGRAPH_H
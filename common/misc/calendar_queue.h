@@ -0,0 +1,165 @@
+#ifndef CALENDAR_QUEUE_H
+#define CALENDAR_QUEUE_H
+
+#include "fixed_types.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <utility>
+#include <vector>
+
+// Calendar queue of (time, value) items, used for the sliding window of QueueModelWindowedMG1.
+// Items are hashed into a power-of-two ring of buckets, each covering bucket_width units of time.
+// Every bucket is a vector kept sorted by time: items mostly arrive in increasing time order,
+// so insertion only rarely has to move an item back, and vectors keep their capacity after being emptied,
+// so a queue in steady state no longer allocates.
+// popBefore() drops whole buckets below the cut-off time in one go and pops the partial bucket from its front,
+// a bitmap of non-empty buckets lets it skip over empty ones 64 at a time.
+// The ring grows when the items in the queue span more buckets than it has.
+
+template <typename V> class CalendarQueue
+{
+   private:
+      typedef std::pair<UInt64, V> Item;
+      struct Bucket
+      {
+         std::vector<Item> items;
+         UInt32 head; // items before head have been popped
+         Bucket() : head(0) {}
+      };
+
+      const UInt64 m_bucket_width;
+      std::vector<Bucket> m_buckets;
+      std::vector<UInt64> m_occupied; // Bitmap of non-empty buckets
+      UInt64 m_mask;
+      UInt64 m_first; // Bucket index of the oldest item
+      UInt64 m_last;  // Bucket index of the newest item
+      UInt64 m_size;
+
+      Bucket& bucket(UInt64 index) { return m_buckets[index & m_mask]; }
+      void setOccupied(UInt64 index) { m_occupied[(index & m_mask) / 64] |= 1ULL << (index % 64); }
+      void clearOccupied(UInt64 index) { m_occupied[(index & m_mask) / 64] &= ~(1ULL << (index % 64)); }
+
+      // First non-empty bucket in [index, last], or last + 1 if there is none
+      UInt64 nextOccupied(UInt64 index, UInt64 last) const
+      {
+         while (index <= last)
+         {
+            UInt64 word = m_occupied[(index & m_mask) / 64] >> (index % 64);
+            if (word)
+               return std::min(index + __builtin_ctzll(word), last + 1);
+            index += 64 - index % 64;
+         }
+         return last + 1;
+      }
+
+      void grow(UInt64 span)
+      {
+         UInt64 num_buckets = m_buckets.size();
+         while (num_buckets < 2 * span)
+            num_buckets <<= 1;
+         std::vector<Bucket> buckets(num_buckets);
+         for(UInt64 index = m_first; index <= m_last; ++index)
+         {
+            Bucket &b = buckets[index & (num_buckets - 1)];
+            b.items.swap(bucket(index).items);
+            b.head = bucket(index).head;
+         }
+         m_buckets.swap(buckets);
+         m_mask = num_buckets - 1;
+         m_occupied.assign(num_buckets / 64, 0);
+         for(UInt64 index = m_first; index <= m_last; ++index)
+            if (!bucket(index).items.empty())
+               setOccupied(index);
+      }
+
+      template <typename F> void clearBucket(Bucket &b, F &func)
+      {
+         for(UInt32 i = b.head; i < b.items.size(); ++i)
+            func(b.items[i].first, b.items[i].second);
+         m_size -= b.items.size() - b.head;
+         b.items.clear();
+         b.head = 0;
+      }
+
+   public:
+      CalendarQueue(UInt64 bucket_width, UInt32 num_buckets = 64)
+         : m_bucket_width(bucket_width ? bucket_width : 1)
+         , m_buckets(num_buckets)
+         , m_occupied(num_buckets / 64)
+         , m_mask(num_buckets - 1)
+         , m_first(0)
+         , m_last(0)
+         , m_size(0)
+      {
+         assert(num_buckets >= 64 && (num_buckets & (num_buckets - 1)) == 0);
+      }
+
+      UInt64 size() const { return m_size; }
+      bool empty() const { return m_size == 0; }
+
+      void push(UInt64 time, const V &value)
+      {
+         UInt64 index = time / m_bucket_width;
+         if (m_size == 0)
+         {
+            m_first = m_last = index;
+         }
+         else if (index < m_first)
+         {
+            if (m_last - index >= m_buckets.size())
+               grow(m_last - index + 1);
+            m_first = index;
+         }
+         else if (index > m_last)
+         {
+            if (index - m_first >= m_buckets.size())
+               grow(index - m_first + 1);
+            m_last = index;
+         }
+
+         Bucket &b = bucket(index);
+         b.items.push_back(Item(time, value));
+         setOccupied(index);
+         for(UInt32 i = b.items.size() - 1; i > b.head && b.items[i - 1].first > time; --i)
+            std::swap(b.items[i - 1], b.items[i]);
+         ++m_size;
+      }
+
+      // Remove all items with a time before the given time, calling func(time, value) for each of them
+      template <typename F> void popBefore(UInt64 time, F func)
+      {
+         UInt64 index = time / m_bucket_width;
+         while (m_size && m_first < index)
+         {
+            m_first = nextOccupied(m_first, m_last);
+            if (m_first >= index)
+               break;
+            clearBucket(bucket(m_first), func);
+            clearOccupied(m_first);
+            if (m_first == m_last)
+               break;
+            ++m_first;
+         }
+         if (m_size && m_first == index)
+         {
+            Bucket &b = bucket(index);
+            while (b.head < b.items.size() && b.items[b.head].first < time)
+            {
+               func(b.items[b.head].first, b.items[b.head].second);
+               ++b.head;
+               --m_size;
+            }
+            if (b.head == b.items.size())
+            {
+               b.items.clear();
+               b.head = 0;
+               clearOccupied(index);
+               if (m_size && m_first < m_last)
+                  ++m_first;
+            }
+         }
+      }
+};
+
+#endif // CALENDAR_QUEUE_H
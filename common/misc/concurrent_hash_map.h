@@ -0,0 +1,370 @@
+#ifndef CONCURRENT_HASH_MAP_H
+#define CONCURRENT_HASH_MAP_H
+
+#include "fixed_types.h"
+#include "lock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+// Concurrent hash map from 64-bit keys (addresses, IDs) to small trivially copyable values.
+// - Buckets are one cache line each: a version word, an overflow pointer, and as many key/value slots as fit.
+//   Buckets that fill up get more cache-line nodes chained to them.
+// - Reads take no locks: every bucket is a sequence lock, a writer makes its version odd while it changes the bucket
+//   (or any of its overflow nodes), and readers retry when the version changed under them.
+// - Writers lock one of a fixed number of stripes, selected by the top bits of the hash. Buckets are also selected
+//   by the top bits, so a bucket and the two buckets it splits into when the table doubles share a stripe.
+// - Resizing is incremental: once the table is 3/4 full, a table twice the size is linked to it, and each write moves
+//   a few buckets over (and always the bucket it touches). Moved buckets are marked, so readers and writers that find a
+//   marked bucket continue in the next table. When all buckets have moved, the new table becomes the current one.
+// Nodes and old tables are only freed when the map is destroyed, so a reader can never touch freed memory;
+// old tables add up to less than the current one.
+
+template <class V = UInt64> class ConcurrentHashMap
+{
+   static_assert(std::is_trivially_copyable<V>::value, "ConcurrentHashMap values are copied by racing readers");
+
+   private:
+      static const UInt32 LINE_SIZE = 64;
+      static const UInt32 HEADER_SIZE = 16;
+      static const UInt32 SLOTS = (LINE_SIZE - HEADER_SIZE) / (sizeof(UInt64) + sizeof(V));
+      static_assert(SLOTS > 0, "ConcurrentHashMap values must leave room for at least one slot per cache line");
+      static const UInt32 MIGRATE_PER_WRITE = 4;
+
+      struct alignas(LINE_SIZE) Bucket
+      {
+         UInt32 version;   // Odd while a writer is changing this bucket or its overflow nodes
+         UInt16 count;     // Used slots in this node
+         UInt16 migrated;  // Entries have moved to the next table (home buckets only)
+         Bucket *overflow;
+         UInt64 keys[SLOTS];
+         V values[SLOTS];
+      };
+      static_assert(sizeof(Bucket) == LINE_SIZE, "ConcurrentHashMap buckets should be one cache line");
+
+      struct Table
+      {
+         Table(UInt32 _bits, Table *_prev)
+            : bits(_bits)
+            , num_buckets(1ULL << _bits)
+            , buckets(new Bucket[1ULL << _bits])
+            , next(NULL)
+            , prev(_prev)
+            , migrate_cursor(0)
+            , migrated(0)
+         {
+            memset((void*)buckets, 0, num_buckets * sizeof(Bucket));
+         }
+         ~Table()
+         {
+            for(UInt64 idx = 0; idx < num_buckets; ++idx)
+            {
+               for(Bucket *node = buckets[idx].overflow; node; )
+               {
+                  Bucket *overflow = node->overflow;
+                  delete node;
+                  node = overflow;
+               }
+            }
+            delete [] buckets;
+         }
+
+         const UInt32 bits;
+         const UInt64 num_buckets;
+         Bucket * const buckets;
+         std::atomic<Table*> next;     // Table being resized into
+         Table * const prev;           // Table resized from, kept until destruction
+         std::atomic<UInt64> migrate_cursor;
+         std::atomic<UInt64> migrated;
+
+         Bucket *bucket(UInt64 hash) const { return &buckets[hash >> (64 - bits)]; }
+      };
+
+      const UInt32 m_stripe_bits;
+      Lock *m_locks;
+      std::atomic<Table*> m_table;
+      std::atomic<UInt64> m_size;
+
+      static UInt64 hash(UInt64 key) { return key * 0x9E3779B97F4A7C15ull; }
+      Lock &stripe(UInt64 hash) const { return m_locks[hash >> (64 - m_stripe_bits)]; }
+
+      static void writeBegin(Bucket *bucket)
+      {
+         __atomic_store_n(&bucket->version, bucket->version + 1, __ATOMIC_RELAXED);
+         std::atomic_thread_fence(std::memory_order_release);
+      }
+      static void writeEnd(Bucket *bucket)
+      {
+         __atomic_store_n(&bucket->version, bucket->version + 1, __ATOMIC_RELEASE);
+      }
+
+      // Find <key> in the chain of <bucket>, returns the node and sets <slot>, or NULL
+      static Bucket *findSlot(Bucket *bucket, UInt64 key, UInt32 &slot)
+      {
+         for(Bucket *node = bucket; node; node = node->overflow)
+         {
+            for(slot = 0; slot < node->count; ++slot)
+               if (node->keys[slot] == key)
+                  return node;
+         }
+         return NULL;
+      }
+
+      // Add an entry that is known not to be there yet, with <bucket>'s version held odd by the caller
+      static void addSlot(Bucket *bucket, UInt64 key, const V &value)
+      {
+         Bucket *node = bucket;
+         while (node->count == SLOTS)
+         {
+            if (!node->overflow)
+            {
+               Bucket *overflow = new Bucket();
+               memset((void*)overflow, 0, sizeof(Bucket));
+               __atomic_store_n(&node->overflow, overflow, __ATOMIC_RELEASE);
+            }
+            node = node->overflow;
+         }
+         node->keys[node->count] = key;
+         node->values[node->count] = value;
+         __atomic_store_n(&node->count, node->count + 1, __ATOMIC_RELEASE);
+      }
+
+      // Move a bucket's entries into the next table, with its stripe lock held
+      void migrate(Table *table, Bucket *bucket)
+      {
+         if (bucket->migrated)
+            return;
+         Table *next = table->next.load(std::memory_order_acquire);
+         for(Bucket *node = bucket; node; node = node->overflow)
+         {
+            for(UInt32 slot = 0; slot < node->count; ++slot)
+            {
+               Bucket *target = next->bucket(hash(node->keys[slot]));
+               writeBegin(target);
+               addSlot(target, node->keys[slot], node->values[slot]);
+               writeEnd(target);
+            }
+         }
+         writeBegin(bucket);
+         bucket->migrated = 1;
+         writeEnd(bucket);
+
+         if (table->migrated.fetch_add(1) + 1 == table->num_buckets)
+         {
+            Table *expected = table;
+            m_table.compare_exchange_strong(expected, next);
+         }
+      }
+
+      // Table and home bucket a write to <hash> should go to, with the stripe lock held
+      Bucket *writableBucket(UInt64 hash)
+      {
+         Table *table = m_table.load(std::memory_order_acquire);
+         while (true)
+         {
+            Bucket *bucket = table->bucket(hash);
+            if (!bucket->migrated && !table->next.load(std::memory_order_acquire))
+               return bucket;
+            migrate(table, bucket);
+            table = table->next.load(std::memory_order_acquire);
+         }
+      }
+
+      // After a write, outside of any lock: start a resize when needed, and help moving buckets
+      void afterWrite()
+      {
+         Table *table = m_table.load(std::memory_order_acquire);
+         Table *next = table->next.load(std::memory_order_acquire);
+         if (!next)
+         {
+            if (m_size.load(std::memory_order_relaxed) * 4 <= table->num_buckets * SLOTS * 3)
+               return;
+            Table *resized = new Table(table->bits + 1, table);
+            if (!table->next.compare_exchange_strong(next, resized))
+            {
+               delete resized;
+               return;
+            }
+         }
+
+         for(UInt32 i = 0; i < MIGRATE_PER_WRITE; ++i)
+         {
+            UInt64 idx = table->migrate_cursor.fetch_add(1);
+            if (idx >= table->num_buckets)
+               break;
+            ScopedLock sl(m_locks[idx >> (table->bits - m_stripe_bits)]);
+            migrate(table, &table->buckets[idx]);
+         }
+      }
+
+   public:
+      ConcurrentHashMap(UInt64 expected_size = 1024, UInt32 stripe_bits = 6)
+         : m_stripe_bits(stripe_bits)
+         , m_locks(new Lock[1ULL << stripe_bits])
+         , m_size(0)
+      {
+         UInt32 bits = stripe_bits;
+         while ((1ULL << bits) * SLOTS * 3 < expected_size * 4)
+            ++bits;
+         m_table.store(new Table(bits, NULL));
+      }
+
+      ~ConcurrentHashMap()
+      {
+         Table *table = m_table.load();
+         while (table->next.load())
+            table = table->next.load();
+         while (table)
+         {
+            Table *prev = table->prev;
+            delete table;
+            table = prev;
+         }
+         delete [] m_locks;
+      }
+
+      UInt64 size() const { return m_size.load(std::memory_order_relaxed); }
+
+      // Lock-free lookup
+      bool lookup(UInt64 key, V &value) const
+      {
+         UInt64 h = hash(key);
+         Table *table = m_table.load(std::memory_order_acquire);
+         while (true)
+         {
+            Bucket *bucket = table->bucket(h);
+            bool found, migrated;
+            UInt32 version;
+            do
+            {
+               while ((version = __atomic_load_n(&bucket->version, __ATOMIC_ACQUIRE)) & 1)
+                  ;
+               migrated = bucket->migrated;
+               found = false;
+               for(Bucket *node = bucket; node && !found; node = __atomic_load_n(&node->overflow, __ATOMIC_ACQUIRE))
+               {
+                  UInt32 count = std::min<UInt32>(__atomic_load_n(&node->count, __ATOMIC_ACQUIRE), SLOTS);
+                  for(UInt32 slot = 0; slot < count; ++slot)
+                  {
+                     if (node->keys[slot] == key)
+                     {
+                        memcpy((void*)&value, (const void*)&node->values[slot], sizeof(V));
+                        found = true;
+                        break;
+                     }
+                  }
+               }
+               std::atomic_thread_fence(std::memory_order_acquire);
+            }
+            while (__atomic_load_n(&bucket->version, __ATOMIC_RELAXED) != version);
+
+            if (!migrated)
+               return found;
+            table = table->next.load(std::memory_order_acquire);
+         }
+      }
+
+      std::pair<bool, V> find(UInt64 key) const
+      {
+         std::pair<bool, V> res(false, V());
+         res.first = lookup(key, res.second);
+         return res;
+      }
+
+      // Add <key> if it is not there yet, returns whether it was added (like std::unordered_map::insert)
+      bool insert(UInt64 key, const V &value)
+      {
+         UInt64 h = hash(key);
+         {
+            ScopedLock sl(stripe(h));
+            Bucket *bucket = writableBucket(h);
+            UInt32 slot;
+            if (findSlot(bucket, key, slot))
+               return false;
+            writeBegin(bucket);
+            addSlot(bucket, key, value);
+            writeEnd(bucket);
+            m_size.fetch_add(1, std::memory_order_relaxed);
+         }
+         afterWrite();
+         return true;
+      }
+
+      // Add or overwrite <key>
+      void set(UInt64 key, const V &value)
+      {
+         update(key, [&value](V &v, bool) { v = value; });
+      }
+
+      // Call func(value, existed) on the value of <key> under its stripe lock, adding it (value-initialized) if needed
+      template <typename F> void update(UInt64 key, F func)
+      {
+         UInt64 h = hash(key);
+         {
+            ScopedLock sl(stripe(h));
+            Bucket *bucket = writableBucket(h);
+            UInt32 slot;
+            Bucket *node = findSlot(bucket, key, slot);
+            V value = node ? node->values[slot] : V();
+            func(value, node != NULL);
+            writeBegin(bucket);
+            if (node)
+               node->values[slot] = value;
+            else
+               addSlot(bucket, key, value);
+            writeEnd(bucket);
+            if (!node)
+               m_size.fetch_add(1, std::memory_order_relaxed);
+         }
+         afterWrite();
+      }
+
+      // Remove <key>, returns whether it was there
+      bool remove(UInt64 key)
+      {
+         UInt64 h = hash(key);
+         ScopedLock sl(stripe(h));
+         Bucket *bucket = writableBucket(h);
+         UInt32 slot;
+         Bucket *node = findSlot(bucket, key, slot);
+         if (!node)
+            return false;
+         // Fill the hole with the node's last entry, empty nodes stay linked to be reused
+         writeBegin(bucket);
+         UInt16 last = node->count - 1;
+         node->keys[slot] = node->keys[last];
+         node->values[slot] = node->values[last];
+         node->count = last;
+         writeEnd(bucket);
+         m_size.fetch_sub(1, std::memory_order_relaxed);
+         return true;
+      }
+
+      // Call func(key, value) for all entries, with all writers locked out
+      template <typename F> void forEach(F func)
+      {
+         for(UInt64 idx = 0; idx < (1ULL << m_stripe_bits); ++idx)
+            m_locks[idx].acquire();
+
+         // Finish a pending resize first, so everything is in one table
+         Table *table = m_table.load(std::memory_order_acquire);
+         if (table->next.load(std::memory_order_acquire))
+         {
+            for(UInt64 idx = 0; idx < table->num_buckets; ++idx)
+               migrate(table, &table->buckets[idx]);
+            table = m_table.load(std::memory_order_acquire);
+         }
+         for(UInt64 idx = 0; idx < table->num_buckets; ++idx)
+            for(Bucket *node = &table->buckets[idx]; node; node = node->overflow)
+               for(UInt32 slot = 0; slot < node->count; ++slot)
+                  func(node->keys[slot], node->values[slot]);
+
+         for(UInt64 idx = 0; idx < (1ULL << m_stripe_bits); ++idx)
+            m_locks[idx].release();
+      }
+};
+
+#endif // CONCURRENT_HASH_MAP_H
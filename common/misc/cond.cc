@@ -1,5 +1,6 @@
 #include "cond.h"
 #include "os_compat.h"
+#include "fiber_pool.h"
 
 #include <unistd.h>
 #include <sys/syscall.h>
@@ -24,6 +25,20 @@ ConditionVariable::~ConditionVariable()
 
 void ConditionVariable::wait(Lock& lock, UInt64 timeout_ns)
 {
+   Fiber *fiber = Fiber::current();
+   if (fiber && timeout_ns == 0)
+   {
+      m_lock.acquire();
+      fiber->prepareWait();
+      m_fibers.push_back(fiber);
+      m_lock.release();
+
+      lock.release();
+      fiber->park();
+      lock.acquire();
+      return;
+   }
+
    m_lock.acquire();
 
    // Wait
@@ -53,6 +68,16 @@ void ConditionVariable::signal()
 {
    m_lock.acquire();
 
+   if (!m_fibers.empty())
+   {
+      // Wake up a single waiter, like a futex wake would
+      Fiber *fiber = m_fibers.front();
+      m_fibers.pop_front();
+      m_lock.release();
+      fiber->wake();
+      return;
+   }
+
    m_futx = 1;
 
    syscall(SYS_futex, (void*) &m_futx, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, 1, NULL, NULL, 0);
@@ -64,9 +89,15 @@ void ConditionVariable::broadcast()
 {
    m_lock.acquire();
 
+   std::deque<Fiber*> fibers;
+   fibers.swap(m_fibers);
+
    m_futx = 1;
 
    syscall(SYS_futex, (void*) &m_futx, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, INT_MAX, NULL, NULL, 0);
 
    m_lock.release();
+
+   for(std::deque<Fiber*>::iterator it = fibers.begin(); it != fibers.end(); ++it)
+      (*it)->wake();
 }
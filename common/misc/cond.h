@@ -4,9 +4,14 @@
 #include "fixed_types.h"
 #include "lock.h"
 
+#include <deque>
+
+class Fiber;
+
 // Our condition variable interface is slightly different from
 // pthreads in that the mutex associated with the condition variable
 // is built into the condition variable itself.
+// Waiting from a FiberPool fiber parks the fiber rather than blocking its host thread.
 
 class ConditionVariable
 {
@@ -22,6 +27,7 @@ class ConditionVariable
    private:
       int m_futx;
       Lock m_lock;
+      std::deque<Fiber*> m_fibers;
       #ifdef TIME_LOCKS
       TotalTimer* _timer;
       #endif
@@ -16,6 +16,7 @@ UInt32 Config::m_knob_total_cores;
 UInt32 Config::m_knob_num_host_cores;
 bool Config::m_knob_enable_smc_support;
 bool Config::m_knob_issue_memops_at_functional;
+bool Config::m_knob_batch_memops_warmup;
 bool Config::m_knob_enable_icache_modeling;
 Config::SimulationROI Config::m_knob_roi;
 bool Config::m_knob_enable_progress_trace;
@@ -76,6 +77,7 @@ Config::Config(SimulationMode mode)
    m_knob_enable_smc_support = Sim()->getCfg()->getBool("general/enable_smc_support");
    m_knob_enable_icache_modeling = Sim()->getCfg()->getBool("general/enable_icache_modeling");
    m_knob_issue_memops_at_functional = Sim()->getCfg()->getBool("general/issue_memops_at_functional");
+   m_knob_batch_memops_warmup = Sim()->getCfg()->getBool("general/batch_memops_warmup");
 
    if (Sim()->getCfg()->getBool("general/roi_script"))
       m_knob_roi = ROI_SCRIPT;
@@ -249,4 +251,8 @@ void Config::setCacheEfficiencyCallbacks(CacheEfficiencyTracker::CallbackGetOwne
    m_cache_efficiency_callbacks.notify_access_func = notify_access_func;
    m_cache_efficiency_callbacks.notify_evict_func = notify_evict_func;
    m_cache_efficiency_callbacks.user_arg = user_arg;
+
+   UInt32 batch_size = Sim()->getCfg()->getInt("routine_tracer/cache_efficiency_batch");
+   if (batch_size)
+      m_cache_efficiency_callbacks.batch = new CacheEfficiencyTracker::Batch(m_cache_efficiency_callbacks, batch_size);
 }
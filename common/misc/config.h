@@ -72,6 +72,7 @@ public:
    bool getEnableSMCSupport() const { return m_knob_enable_smc_support; }
    void forceEnableSMCSupport() { m_knob_enable_smc_support = true; }
    bool getIssueMemopsAtFunctional() const { return m_knob_issue_memops_at_functional; }
+   bool getBatchMemopsWarmup() const { return m_knob_batch_memops_warmup; }
    bool getEnableICacheModeling() const { return m_knob_enable_icache_modeling; }
    SimulationROI getSimulationROI() const { return m_knob_roi; }
    bool getEnableProgressTrace() const { return m_knob_enable_progress_trace; }
@@ -121,6 +122,7 @@ private:
    static UInt32 m_knob_num_host_cores;
    static bool m_knob_enable_smc_support;
    static bool m_knob_issue_memops_at_functional;
+   static bool m_knob_batch_memops_warmup;
    static bool m_knob_enable_icache_modeling;
    static SimulationROI m_knob_roi;
    static bool m_knob_enable_progress_trace;
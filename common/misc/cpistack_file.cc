@@ -0,0 +1,102 @@
+#include "cpistack_file.h"
+#include "stats.h"
+#include "log.h"
+
+CpiStackFile::CpiStackFile(String filename)
+{
+   m_fp = fopen(filename.c_str(), "w");
+   LOG_ASSERT_ERROR(m_fp, "Cannot create %s", filename.c_str());
+   fprintf(m_fp, "# Sniper CPI stack file, version 1\n");
+}
+
+CpiStackFile::~CpiStackFile()
+{
+   fclose(m_fp);
+}
+
+bool
+CpiStackFile::isCpiComponent(const String &objectName, const String &metricName)
+{
+   // Per-thread CPI components are not part of the per-core stacks, fast-forward time is not a component
+   return metricName.compare(0, 3, "cpi") == 0 && objectName != "thread" && metricName != "cpiFastforwardTime";
+}
+
+bool
+CpiStackFile::isNeeded(const String &objectName, const String &metricName)
+{
+   if (metricName.compare(0, 8, "cpContr_") == 0 || metricName.compare(0, 12, "detailed-cpi") == 0)
+      return true;
+   if (objectName == "performance_model")
+      return metricName == "instruction_count" || metricName == "elapsed_time" || metricName == "idle_elapsed_time";
+   if (objectName == "core")
+      return metricName == "instructions";
+   if (objectName == "barrier")
+      return metricName == "global_time";
+   if (objectName == "thread")
+      return metricName == "bottle_runtime_time" || metricName == "bottle_contrib_time";
+   return false;
+}
+
+void
+CpiStackFile::addMetric(StatsMetricBase *metric)
+{
+   std::string objectName, metricName;
+   if (isCpiComponent(metric->objectName, metric->metricName))
+      objectName = "cpistack";
+   else if (isNeeded(metric->objectName, metric->metricName))
+      objectName = metric->objectName.c_str();
+   else
+      return;
+   metricName = metric->metricName.c_str();
+
+   std::string key = objectName + '.' + metricName;
+   std::unordered_map<std::string, UInt64>::iterator it = m_name_ids.find(key);
+   if (it == m_name_ids.end())
+   {
+      it = m_name_ids.insert(std::make_pair(key, m_names.size())).first;
+      m_names.push_back((Name){ objectName, metricName, false, std::vector<StatsMetricBase*>() });
+   }
+   m_names[it->second].metrics.push_back(metric);
+}
+
+void
+CpiStackFile::recordSnapshot(String prefix)
+{
+   std::vector<bool> present(m_names.size());
+   for(UInt64 nameid = 0; nameid < m_names.size(); ++nameid)
+   {
+      // Gather values first, names of metrics that are still all zero are not written yet
+      std::vector<StatsMetricBase*> &metrics = m_names[nameid].metrics;
+      for(std::vector<StatsMetricBase*>::iterator it = metrics.begin(); it != metrics.end(); ++it)
+         if (!(*it)->isDefault())
+            present[nameid] = true;
+
+      if (present[nameid] && !m_names[nameid].written)
+      {
+         fprintf(m_fp, "name %" PRIu64 " %s %s\n", nameid, m_names[nameid].objectName.c_str(), m_names[nameid].metricName.c_str());
+         m_names[nameid].written = true;
+      }
+   }
+
+   fprintf(m_fp, "snapshot %s\n", prefix.c_str());
+   for(UInt64 nameid = 0; nameid < m_names.size(); ++nameid)
+   {
+      if (!present[nameid])
+         continue;
+
+      m_values.clear();
+      std::vector<StatsMetricBase*> &metrics = m_names[nameid].metrics;
+      for(std::vector<StatsMetricBase*>::iterator it = metrics.begin(); it != metrics.end(); ++it)
+      {
+         if (m_values.size() <= (*it)->index)
+            m_values.resize((*it)->index + 1, 0);
+         m_values[(*it)->index] += (*it)->recordMetric();
+      }
+
+      fprintf(m_fp, "%" PRIu64, nameid);
+      for(std::vector<UInt64>::iterator it = m_values.begin(); it != m_values.end(); ++it)
+         fprintf(m_fp, " %" PRIu64, *it);
+      fprintf(m_fp, "\n");
+   }
+   fflush(m_fp);
+}
@@ -0,0 +1,55 @@
+#ifndef __CPISTACK_FILE_H
+#define __CPISTACK_FILE_H
+
+#include "fixed_types.h"
+
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <stdio.h>
+
+class StatsMetricBase;
+
+// Pre-aggregated CPI stack and bottle graph data (sim.cpistack, see general/cpistack_file)
+//
+// Written next to every statistics snapshot, so tools/cpistack.py and tools/bottlegraph.py can skip reading
+// all statistics back from sim.stats.sqlite3 or sim.stats.bin. Per-core cpi* components of all core models
+// (performance_model, interval_timer, rob_timer, ...) are summed into one cpistack.cpi<component> metric,
+// as tools/cpistack_data.py would do. Only the other statistics these tools need are copied as they are:
+// instruction counts, elapsed and idle time, critical path contributions (cpContr_*, detailed-cpi*),
+// the barrier's global time and the per-thread bottle graph times.
+//
+// Text format, one record per line:
+//   name <nameid> <objectname> <metricname>     before the first snapshot that contains the metric
+//   snapshot <prefix>
+//   <nameid> <value at index 0> <value at index 1> ...     for all metrics with a non-zero value
+
+class CpiStackFile
+{
+   public:
+      CpiStackFile(String filename);
+      ~CpiStackFile();
+
+      // Called for every registered statistic, keeps the ones that belong in the file
+      void addMetric(StatsMetricBase *metric);
+      void recordSnapshot(String prefix);
+
+   private:
+      struct Name
+      {
+         std::string objectName;
+         std::string metricName;
+         bool written;
+         std::vector<StatsMetricBase*> metrics; // Summed per index
+      };
+
+      FILE *m_fp;
+      std::vector<Name> m_names;
+      std::unordered_map<std::string, UInt64> m_name_ids;
+      std::vector<UInt64> m_values;
+
+      static bool isCpiComponent(const String &objectName, const String &metricName);
+      static bool isNeeded(const String &objectName, const String &metricName);
+};
+
+#endif // __CPISTACK_FILE_H
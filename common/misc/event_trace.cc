@@ -0,0 +1,131 @@
+#include "event_trace.h"
+#include "log.h"
+
+#include <string.h>
+#include <sched.h>
+
+thread_local EventTrace::Ring *EventTrace::t_ring = NULL;
+
+EventTrace::EventTrace(String filename)
+   : m_fp(NULL)
+   , m_seqnum(0)
+   , m_thread(NULL)
+   , m_stop(false)
+{
+   m_fp = fopen(filename.c_str(), "w");
+   LOG_ASSERT_ERROR(m_fp, "Cannot create %s", filename.c_str());
+
+   UInt64 header[2] = { 0, 1 };
+   memcpy(&header[0], "SNIPEVNT", 8);
+   fwrite(header, sizeof(header), 1, m_fp);
+
+   m_thread = _Thread::create(this);
+   m_thread->run();
+}
+
+EventTrace::~EventTrace()
+{
+   {
+      ScopedLock sl(m_lock);
+      m_stop = true;
+      m_cond.signal();
+   }
+   m_done.wait();
+   delete m_thread;
+
+   // The writer thread has drained all rings after the last events were recorded
+   for(std::vector<Ring*>::iterator it = m_rings.begin(); it != m_rings.end(); ++it)
+      delete *it;
+   fclose(m_fp);
+}
+
+EventTrace::Ring *
+EventTrace::getRing()
+{
+   if (!t_ring)
+   {
+      t_ring = new Ring();
+      ScopedLock sl(m_rings_lock);
+      m_rings.push_back(t_ring);
+   }
+   return t_ring;
+}
+
+void
+EventTrace::copyIn(Ring *ring, UInt64 position, const void *data, UInt64 length)
+{
+   UInt64 start = position % RING_SIZE;
+   UInt64 first = std::min(length, RING_SIZE - start);
+   memcpy(&ring->data[start], data, first);
+   memcpy(&ring->data[0], (const char*)data + first, length - first);
+}
+
+void
+EventTrace::record(UInt32 event, UInt64 time, core_id_t core_id, thread_id_t thread_id, UInt64 value0, UInt64 value1, const char *description)
+{
+   Ring *ring = getRing();
+
+   size_t desc_length = std::min(strlen(description), (size_t)(RING_SIZE / 4));
+   UInt64 length = (sizeof(event_header_t) + desc_length + 1 + 7) & ~7ULL;
+
+   // Wait for the writer thread if the ring is full
+   UInt64 head = ring->head.load(std::memory_order_relaxed);
+   while (head + length - ring->tail.load(std::memory_order_acquire) > RING_SIZE)
+   {
+      m_cond.signal();
+      sched_yield();
+   }
+
+   event_header_t header = { (UInt32)length, event, __sync_fetch_and_add(&m_seqnum, 1), time, core_id, thread_id, value0, value1 };
+
+   static const char zeros[8] = { 0 };
+   copyIn(ring, head, &header, sizeof(header));
+   copyIn(ring, head + sizeof(header), description, desc_length);
+   copyIn(ring, head + sizeof(header) + desc_length, zeros, length - sizeof(header) - desc_length);
+
+   ring->head.store(head + length, std::memory_order_release);
+}
+
+void
+EventTrace::drain(Ring *ring)
+{
+   UInt64 tail = ring->tail.load(std::memory_order_relaxed);
+   UInt64 head = ring->head.load(std::memory_order_acquire);
+   if (head == tail)
+      return;
+
+   UInt64 start = tail % RING_SIZE, end = head % RING_SIZE;
+   if (start < end)
+   {
+      fwrite(&ring->data[start], end - start, 1, m_fp);
+   }
+   else
+   {
+      fwrite(&ring->data[start], RING_SIZE - start, 1, m_fp);
+      fwrite(&ring->data[0], end, 1, m_fp);
+   }
+
+   ring->tail.store(head, std::memory_order_release);
+}
+
+void
+EventTrace::run()
+{
+   bool stop = false;
+   while (!stop)
+   {
+      {
+         ScopedLock sl(m_lock);
+         if (!m_stop)
+            m_cond.wait(m_lock, FLUSH_INTERVAL_NS);
+         stop = m_stop;
+      }
+
+      ScopedLock sl(m_rings_lock);
+      for(std::vector<Ring*>::iterator it = m_rings.begin(); it != m_rings.end(); ++it)
+         drain(*it);
+   }
+
+   fflush(m_fp);
+   m_done.signal();
+}
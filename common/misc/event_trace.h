@@ -0,0 +1,76 @@
+#ifndef __EVENT_TRACE_H
+#define __EVENT_TRACE_H
+
+#include "fixed_types.h"
+#include "lock.h"
+#include "cond.h"
+#include "sem.h"
+#include "_thread.h"
+
+#include <atomic>
+#include <vector>
+#include <stdio.h>
+
+// Binary event trace for StatsManager::logEvent (sim.events.bin, see general/events_binary)
+//
+// Each host thread appends its events to its own single-producer, single-consumer ring buffer,
+// without locking. A background thread drains all rings in bulk every FLUSH_INTERVAL_NS, or sooner
+// when a ring fills up. Events carry a global sequence number so readers can restore the order
+// in which they were logged (tools/sniper_events.py).
+//
+// File format: "SNIPEVNT", UInt64 version, then event records of length bytes each (a multiple of 8):
+//   UInt32 length, UInt32 event, UInt64 sequence number, UInt64 time (fs), SInt32 core, SInt32 thread,
+//   UInt64 value0, UInt64 value1, description\0 (zero padded)
+
+class EventTrace : public Runnable
+{
+   public:
+      EventTrace(String filename);
+      ~EventTrace();
+
+      void record(UInt32 event, UInt64 time, core_id_t core_id, thread_id_t thread_id, UInt64 value0, UInt64 value1, const char *description);
+
+   private:
+      typedef struct {
+         UInt32 length;
+         UInt32 event;
+         UInt64 seqnum;
+         UInt64 time;
+         SInt32 core_id;
+         SInt32 thread_id;
+         UInt64 value0;
+         UInt64 value1;
+      } event_header_t;
+
+      static const UInt64 RING_SIZE = 64*1024; // Power of two
+      static const UInt64 FLUSH_INTERVAL_NS = 10000000;
+
+      struct Ring
+      {
+         std::atomic<UInt64> head; // Bytes written by the producer
+         char padding[64 - sizeof(std::atomic<UInt64>)];
+         std::atomic<UInt64> tail; // Bytes consumed by the writer thread
+         char data[RING_SIZE];
+         Ring() : head(0), tail(0) {}
+      };
+
+      static thread_local Ring *t_ring;
+
+      FILE *m_fp;
+      UInt64 m_seqnum;
+      std::vector<Ring*> m_rings;
+      Lock m_rings_lock;
+
+      _Thread *m_thread;
+      Lock m_lock;
+      ConditionVariable m_cond;
+      bool m_stop;
+      Semaphore m_done;
+
+      Ring *getRing();
+      static void copyIn(Ring *ring, UInt64 position, const void *data, UInt64 length);
+      void drain(Ring *ring);
+      void run();
+};
+
+#endif // __EVENT_TRACE_H
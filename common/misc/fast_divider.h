@@ -0,0 +1,59 @@
+#ifndef FAST_DIVIDER_H
+#define FAST_DIVIDER_H
+
+#include "fixed_types.h"
+
+#include <cassert>
+
+// Division and modulo of 64-bit values by a divisor fixed at construction time, for hot paths that would
+// otherwise do a hardware division on every call (address interleaving, home lookup).
+// Powers of two use a shift and a mask. Other divisors use Lemire's direct remainder computation
+// (D. Lemire, O. Kaser, N. Kurz, "Faster Remainder by Direct Computation", 2019) with a 128-bit reciprocal,
+// which is exact for all 64-bit dividends and divisors below 2^32.
+
+class FastDivider
+{
+   private:
+      UInt64 m_divisor;
+      bool m_power2;
+      UInt32 m_shift;
+      UInt64 m_mask;
+      __uint128_t m_reciprocal;
+
+      // High 64 bits of the 192-bit product of a 128-bit and a 64-bit value
+      static UInt64 mulHigh(__uint128_t a, UInt64 b)
+      {
+         __uint128_t bottom = ((__uint128_t)UInt64(a) * b) >> 64;
+         __uint128_t top = (__uint128_t)UInt64(a >> 64) * b;
+         return (bottom + top) >> 64;
+      }
+
+   public:
+      FastDivider(UInt32 divisor = 1)
+         : m_divisor(divisor)
+         , m_power2((divisor & (divisor - 1)) == 0)
+         , m_shift(0)
+         , m_mask(UInt64(divisor) - 1)
+         , m_reciprocal(0)
+      {
+         assert(divisor > 0);
+         while ((UInt64(1) << m_shift) < m_divisor)
+            ++m_shift;
+         if (!m_power2)
+            m_reciprocal = ~__uint128_t(0) / divisor + 1;
+      }
+
+      UInt64 getDivisor() const { return m_divisor; }
+      bool isPower2() const { return m_power2; }
+
+      UInt64 divide(UInt64 value) const
+      {
+         return m_power2 ? value >> m_shift : mulHigh(m_reciprocal, value);
+      }
+      UInt64 modulo(UInt64 value) const
+      {
+         return m_power2 ? value & m_mask : mulHigh(m_reciprocal * value, m_divisor);
+      }
+};
+
+#endif // FAST_DIVIDER_H
@@ -0,0 +1,253 @@
+#include "fiber_pool.h"
+#include "simulator.h"
+#include "config.h"
+#include "config.hpp"
+#include "stats.h"
+#include "log.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+
+thread_local Fiber *Fiber::t_current = NULL;
+thread_local FiberPool::Worker *FiberPool::t_worker = NULL;
+
+Fiber::Fiber(FiberPool *pool, _Thread::ThreadFunc func, void *arg, size_t stack_size)
+   : m_pool(pool)
+   , m_func(func)
+   , m_arg(arg)
+   , m_stack_size(stack_size)
+   , m_state(RUNNABLE)
+{
+   m_profile.depth = 0;
+
+   // Reserve address space only, with a guard page at the bottom to catch overflows
+   m_stack = mmap(NULL, m_stack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+   LOG_ASSERT_ERROR(m_stack != MAP_FAILED, "Cannot allocate fiber stack of %ld bytes", m_stack_size);
+   mprotect(m_stack, getpagesize(), PROT_NONE);
+
+   getcontext(&m_context);
+   m_context.uc_stack.ss_sp = m_stack;
+   m_context.uc_stack.ss_size = m_stack_size;
+   m_context.uc_link = NULL;
+   // makecontext only passes int arguments
+   makecontext(&m_context, (void (*)())Fiber::entry, 2, UInt32((UInt64)this), UInt32((UInt64)this >> 32));
+}
+
+Fiber::~Fiber()
+{
+   munmap(m_stack, m_stack_size);
+}
+
+void Fiber::entry(UInt32 lo, UInt32 hi)
+{
+   Fiber *fiber = (Fiber*)((UInt64(hi) << 32) | lo);
+   fiber->m_func(fiber->m_arg);
+
+   fiber->m_state = DONE;
+   // We may have moved since we started, return to the worker we're on now
+   setcontext(&FiberPool::t_worker->context);
+}
+
+void Fiber::prepareWait()
+{
+   m_state = PARKING;
+}
+
+void Fiber::park()
+{
+   swapcontext(&m_context, &FiberPool::t_worker->context);
+}
+
+void Fiber::wake()
+{
+   while(true)
+   {
+      int state = m_state;
+      if (state == PARKING)
+      {
+         // Still switching out, FiberPool::runFiber will reschedule us
+         if (__sync_bool_compare_and_swap(&m_state, PARKING, WOKEN))
+            return;
+      }
+      else if (state == PARKED)
+      {
+         if (__sync_bool_compare_and_swap(&m_state, PARKED, RUNNABLE))
+         {
+            m_pool->schedule(this);
+            return;
+         }
+      }
+      else
+      {
+         LOG_PRINT_ERROR("Waking up fiber %p which is not waiting (state %d)", this, state);
+      }
+   }
+}
+
+void Fiber::setLocal(UInt32 key, void *value)
+{
+   if (key >= m_locals.size())
+      m_locals.resize(key + 1, NULL);
+   m_locals[key] = value;
+}
+
+FiberPool* FiberPool::create()
+{
+   if (!Sim()->getCfg()->getBool("traceinput/thread_pool"))
+      return NULL;
+
+   // num_host_cores = -1 (no limit) is a very large number, there's no use in having more workers than cores
+   UInt32 num_workers = std::min(Sim()->getConfig()->getNumHostCores(), Sim()->getConfig()->getApplicationCores());
+   size_t stack_size = Sim()->getCfg()->getInt("traceinput/thread_pool_stack_size") * 1024;
+
+   return new FiberPool(std::max(num_workers, 1u), stack_size);
+}
+
+FiberPool::FiberPool(UInt32 num_workers, size_t stack_size)
+   : m_stack_size(stack_size)
+   , m_queued(0)
+   , m_next_worker(0)
+   , m_num_idle(0)
+{
+   for(UInt32 i = 0; i < num_workers; ++i)
+   {
+      Worker *worker = new Worker();
+      worker->pool = this;
+      worker->index = i;
+      worker->num_tasks = 0;
+      worker->num_steals = 0;
+      m_workers.push_back(worker);
+
+      registerStatsMetric("fiber_pool", i, "tasks", &worker->num_tasks);
+      registerStatsMetric("fiber_pool", i, "steals", &worker->num_steals);
+   }
+
+   // Start workers only now, they steal from each other
+   for(std::vector<Worker*>::iterator it = m_workers.begin(); it != m_workers.end(); ++it)
+   {
+      pthread_attr_t attr;
+      pthread_attr_init(&attr);
+      pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+      int res = pthread_create(&(*it)->thread, &attr, FiberPool::workerFunc, *it);
+      LOG_ASSERT_ERROR(res == 0, "Cannot create fiber pool worker");
+   }
+}
+
+_Thread *FiberPool::createThread(Runnable *runnable)
+{
+   return new FiberThread(this, Runnable::threadFunc, runnable);
+}
+
+void FiberPool::spawn(_Thread::ThreadFunc func, void *arg)
+{
+   schedule(new Fiber(this, func, arg, m_stack_size));
+}
+
+void FiberPool::schedule(Fiber *fiber)
+{
+   // Queue locally when called from a fiber (or worker), so the waking worker's cache is warm
+   // and idle workers steal the rest. Other threads spread new work round-robin.
+   Worker *worker = t_worker;
+   if (!worker)
+      worker = m_workers[__sync_fetch_and_add(&m_next_worker, 1) % m_workers.size()];
+
+   {
+      ScopedLock sl(worker->lock);
+      worker->deque.push_back(fiber);
+   }
+   __sync_fetch_and_add(&m_queued, 1);
+
+   ScopedLock sl(m_idle_lock);
+   if (m_num_idle)
+      m_idle_cond.signal();
+}
+
+void *FiberPool::workerFunc(void *arg)
+{
+   Worker *worker = (Worker*)arg;
+   worker->pool->workerLoop(worker);
+   return NULL;
+}
+
+void FiberPool::workerLoop(Worker *worker)
+{
+   t_worker = worker;
+
+   while(true)
+   {
+      Fiber *fiber = take(worker);
+      if (fiber)
+         runFiber(worker, fiber);
+      else
+         waitForWork();
+   }
+}
+
+Fiber *FiberPool::take(Worker *worker)
+{
+   Fiber *fiber = NULL;
+
+   {
+      ScopedLock sl(worker->lock);
+      if (!worker->deque.empty())
+      {
+         fiber = worker->deque.back();
+         worker->deque.pop_back();
+      }
+   }
+
+   for(UInt32 i = 1; !fiber && i < m_workers.size(); ++i)
+   {
+      Worker *victim = m_workers[(worker->index + i) % m_workers.size()];
+      ScopedLock sl(victim->lock);
+      if (!victim->deque.empty())
+      {
+         fiber = victim->deque.front();
+         victim->deque.pop_front();
+         ++worker->num_steals;
+      }
+   }
+
+   if (fiber)
+      __sync_fetch_and_sub(&m_queued, 1);
+
+   return fiber;
+}
+
+void FiberPool::waitForWork()
+{
+   ScopedLock sl(m_idle_lock);
+   while(m_queued == 0)
+   {
+      ++m_num_idle;
+      m_idle_cond.wait(m_idle_lock);
+      --m_num_idle;
+   }
+}
+
+void FiberPool::runFiber(Worker *worker, Fiber *fiber)
+{
+   fiber->m_state = Fiber::RUNNING;
+   Fiber::t_current = fiber;
+   SelfProfiler::resume(fiber->m_profile);
+   ++worker->num_tasks;
+
+   swapcontext(&worker->context, &fiber->m_context);
+
+   // Back on the worker: the fiber has finished or is parking
+   SelfProfiler::suspend(fiber->m_profile);
+   Fiber::t_current = NULL;
+
+   if (fiber->m_state == Fiber::DONE)
+   {
+      delete fiber;
+   }
+   else if (!__sync_bool_compare_and_swap(&fiber->m_state, Fiber::PARKING, Fiber::PARKED))
+   {
+      // Woken up while switching out
+      LOG_ASSERT_ERROR(fiber->m_state == Fiber::WOKEN, "Fiber %p switched out in state %d", fiber, fiber->m_state);
+      fiber->m_state = Fiber::RUNNABLE;
+      schedule(fiber);
+   }
+}
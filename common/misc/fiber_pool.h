@@ -0,0 +1,131 @@
+#ifndef __FIBER_POOL_H
+#define __FIBER_POOL_H
+
+#include "fixed_types.h"
+#include "lock.h"
+#include "cond.h"
+#include "_thread.h"
+#include "self_profiler.h"
+
+#include <vector>
+#include <deque>
+#include <ucontext.h>
+#include <pthread.h>
+
+// Work-stealing pool of host threads that run simulator threads as user-level fibers (traceinput/thread_pool)
+//
+// Instead of one host thread per simulated thread, each thread runs on its own stack but is multiplexed onto
+// a fixed number of workers. A fiber runs until it blocks: ConditionVariable::wait and GenerationCounter::wait
+// called from a fiber park it, and waking it up puts it on the deque of the waking worker. Workers run their own
+// deque LIFO and steal FIFO from others when it is empty. With the barrier, every fiber then advances
+// one quantum per task, and all released fibers are queued at once rather than being woken a few at a time.
+// Host calls that block in the OS (SIFT pipe reads, futex waits with a timeout) still block the worker.
+// PthreadTLS is kept per fiber, so TLS objects (current core, thread) follow the fiber between workers.
+
+class FiberPool;
+
+class Fiber
+{
+   public:
+      static Fiber *current() { return t_current; }
+
+      // Called by the fiber, with the lock that protects the waiter list held, before publishing itself as waiter
+      void prepareWait();
+      // Called by the fiber after prepareWait and releasing the lock: switch out until wake() is called
+      void park();
+      // Make a waiting fiber runnable again (from any thread)
+      void wake();
+
+      void *getLocal(UInt32 key) const { return key < m_locals.size() ? m_locals[key] : NULL; }
+      void setLocal(UInt32 key, void *value);
+
+   private:
+      enum state_t
+      {
+         RUNNABLE,
+         RUNNING,
+         PARKING,  // Between prepareWait() and having switched out to the worker
+         PARKED,
+         WOKEN,    // wake() was called while still PARKING
+         DONE,
+      };
+
+      friend class FiberPool;
+
+      Fiber(FiberPool *pool, _Thread::ThreadFunc func, void *arg, size_t stack_size);
+      ~Fiber();
+
+      FiberPool *m_pool;
+      _Thread::ThreadFunc m_func;
+      void *m_arg;
+      void *m_stack;
+      size_t m_stack_size;
+      ucontext_t m_context;
+      volatile int m_state;
+      std::vector<void*> m_locals;
+      SelfProfiler::Context m_profile;
+
+      static thread_local Fiber *t_current;
+
+      static void entry(UInt32 lo, UInt32 hi);
+};
+
+class FiberPool
+{
+   public:
+      static FiberPool* create();
+
+      // Workers (and fibers that are still blocked when the simulation ends) live until the process exits,
+      // just like trace threads running on their own host thread are never joined
+      FiberPool(UInt32 num_workers, size_t stack_size);
+
+      // Thread object whose run() starts func(param) as a fiber, like _Thread::create does for a host thread
+      _Thread *createThread(Runnable *runnable);
+
+      void spawn(_Thread::ThreadFunc func, void *arg);
+      void schedule(Fiber *fiber);
+
+   private:
+      struct Worker
+      {
+         FiberPool *pool;
+         UInt32 index;
+         pthread_t thread;
+         Lock lock;
+         std::deque<Fiber*> deque;
+         ucontext_t context;
+         UInt64 num_tasks;
+         UInt64 num_steals;
+      };
+
+      class FiberThread : public _Thread
+      {
+         public:
+            FiberThread(FiberPool *pool, ThreadFunc func, void *arg) : m_pool(pool), m_func(func), m_arg(arg) {}
+            void run() { m_pool->spawn(m_func, m_arg); }
+         private:
+            FiberPool *m_pool;
+            ThreadFunc m_func;
+            void *m_arg;
+      };
+
+      const size_t m_stack_size;
+      std::vector<Worker*> m_workers;
+      volatile UInt64 m_queued;
+      UInt32 m_next_worker;
+      Lock m_idle_lock;
+      ConditionVariable m_idle_cond;
+      UInt32 m_num_idle;
+
+      static thread_local Worker *t_worker;
+
+      static void *workerFunc(void *arg);
+      void workerLoop(Worker *worker);
+      Fiber *take(Worker *worker);
+      void waitForWork();
+      void runFiber(Worker *worker, Fiber *fiber);
+
+      friend class Fiber;
+};
+
+#endif // __FIBER_POOL_H
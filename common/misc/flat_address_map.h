@@ -0,0 +1,163 @@
+#ifndef FLAT_ADDRESS_MAP_H
+#define FLAT_ADDRESS_MAP_H
+
+#include "fixed_types.h"
+
+#include <new>
+
+// Open-addressing (linear probing) hash table keyed by address, for small tables that are probed on every
+// cache miss or directory request (MSHRs, per-address request queues).
+// Slots live in a single cache-line aligned array sized up front from the expected number of entries,
+// erase() uses backward-shift deletion so there are no tombstones, and clear() empties the table
+// without reallocating. Should the table become more than half full, it doubles in size.
+
+template <class V> class FlatAddressMap
+{
+   public:
+      struct Slot
+      {
+         IntPtr key;
+         bool used;
+         V value;
+      };
+
+      class iterator
+      {
+         private:
+            const FlatAddressMap *_map;
+            UInt64 _idx;
+            void skip() { while (_idx < _map->m_capacity && !_map->m_slots[_idx].used) ++_idx; }
+         public:
+            iterator(const FlatAddressMap *map, UInt64 idx) : _map(map), _idx(idx) { skip(); }
+            Slot& operator*() const { return _map->m_slots[_idx]; }
+            Slot* operator->() const { return &_map->m_slots[_idx]; }
+            iterator& operator++() { ++_idx; skip(); return *this; }
+            bool operator==(iterator const& rhs) const { return _idx == rhs._idx; }
+            bool operator!=(iterator const& rhs) const { return _idx != rhs._idx; }
+      };
+
+   private:
+      static const size_t ALIGNMENT = 64;
+
+      UInt64 m_capacity;
+      UInt64 m_mask;
+      UInt32 m_shift;
+      UInt64 m_size;
+      Slot *m_slots;
+
+      UInt64 home(IntPtr key) const
+      {
+         // Fibonacci hashing: multiply, and take the top bits so all address bits contribute
+         return (UInt64(key) * 0x9E3779B97F4A7C15ull) >> m_shift;
+      }
+
+      void allocate(UInt64 capacity)
+      {
+         m_capacity = capacity;
+         m_mask = capacity - 1;
+         m_shift = 64;
+         for(UInt64 c = capacity; c > 1; c >>= 1)
+            --m_shift;
+         m_size = 0;
+         m_slots = new (std::align_val_t(ALIGNMENT)) Slot[m_capacity];
+         for(UInt64 i = 0; i < m_capacity; ++i)
+            m_slots[i].used = false;
+      }
+
+      void grow()
+      {
+         Slot *old_slots = m_slots;
+         UInt64 old_capacity = m_capacity;
+         allocate(2 * old_capacity);
+         for(UInt64 i = 0; i < old_capacity; ++i)
+            if (old_slots[i].used)
+               (*this)[old_slots[i].key] = old_slots[i].value;
+         ::operator delete[](old_slots, std::align_val_t(ALIGNMENT));
+      }
+
+   public:
+      // Size the table for expected_entries without growing (load factor at most one half)
+      FlatAddressMap(UInt64 expected_entries = 8)
+      {
+         UInt64 capacity = 16;
+         while (capacity < 2 * expected_entries)
+            capacity <<= 1;
+         allocate(capacity);
+      }
+      ~FlatAddressMap() { ::operator delete[](m_slots, std::align_val_t(ALIGNMENT)); }
+      FlatAddressMap(const FlatAddressMap &) = delete;
+      FlatAddressMap& operator=(const FlatAddressMap &) = delete;
+
+      V* find(IntPtr key) const
+      {
+         for(UInt64 idx = home(key); ; idx = (idx + 1) & m_mask)
+         {
+            if (!m_slots[idx].used)
+               return NULL;
+            if (m_slots[idx].key == key)
+               return &m_slots[idx].value;
+         }
+      }
+      bool count(IntPtr key) const { return find(key) != NULL; }
+
+      // Find or insert (value-initialized) the entry for key
+      V& operator[](IntPtr key)
+      {
+         UInt64 idx = home(key);
+         for( ; m_slots[idx].used; idx = (idx + 1) & m_mask)
+         {
+            if (m_slots[idx].key == key)
+               return m_slots[idx].value;
+         }
+         if (2 * (m_size + 1) > m_capacity)
+         {
+            grow();
+            return (*this)[key];
+         }
+         m_slots[idx].key = key;
+         m_slots[idx].used = true;
+         m_slots[idx].value = V();
+         ++m_size;
+         return m_slots[idx].value;
+      }
+
+      bool erase(IntPtr key)
+      {
+         UInt64 idx = home(key);
+         for( ; m_slots[idx].used; idx = (idx + 1) & m_mask)
+            if (m_slots[idx].key == key)
+               break;
+         if (!m_slots[idx].used)
+            return false;
+
+         // Backward-shift: move later entries of the probe sequence into the hole, if that is closer to their home slot
+         for(UInt64 next = (idx + 1) & m_mask; m_slots[next].used; next = (next + 1) & m_mask)
+         {
+            UInt64 h = home(m_slots[next].key);
+            if (((next - h) & m_mask) >= ((next - idx) & m_mask))
+            {
+               m_slots[idx] = m_slots[next];
+               idx = next;
+            }
+         }
+         m_slots[idx].used = false;
+         m_slots[idx].value = V();
+         --m_size;
+         return true;
+      }
+
+      void clear()
+      {
+         for(UInt64 i = 0; i < m_capacity; ++i)
+            m_slots[i].used = false;
+         m_size = 0;
+      }
+
+      UInt64 size() const { return m_size; }
+      bool empty() const { return m_size == 0; }
+
+      iterator begin() const { return iterator(this, 0); }
+      iterator end() const { return iterator(this, m_capacity); }
+};
+
+#endif // FLAT_ADDRESS_MAP_H
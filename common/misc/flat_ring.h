@@ -0,0 +1,88 @@
+#ifndef FLAT_RING_H
+#define FLAT_RING_H
+
+#include "fixed_types.h"
+
+#include <assert.h>
+#include <iterator>
+#include <new>
+
+// Fixed-capacity, single-threaded ring buffer of in-place elements, used for the ROB and other hot-path queues.
+// Unlike CircularQueue, the capacity is rounded up to a power of two so indexing is a mask instead of a modulo,
+// head and tail are not volatile, pop() does not copy the element out, and storage is cache-line aligned.
+// Elements are constructed once and reused: next() hands out the next slot as-is, to be (re)initialized by the caller.
+
+template <class T> class FlatRing
+{
+   private:
+      static const size_t ALIGNMENT = 64;
+
+      const UInt64 m_capacity;
+      const UInt64 m_mask;
+      UInt64 m_head; // next element to be inserted here
+      UInt64 m_tail; // oldest element is here
+      T* const m_ring;
+
+      static UInt64 roundUp(UInt64 size)
+      {
+         UInt64 capacity = 1;
+         while (capacity < size)
+            capacity <<= 1;
+         return capacity;
+      }
+
+   public:
+      typedef T value_type;
+      class iterator
+      {
+         private:
+            FlatRing &_ring;
+            UInt64 _idx;
+         public:
+            using iterator_category = std::forward_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = T;
+            using pointer = T*;
+            using reference = T&;
+
+            iterator(FlatRing &ring, UInt64 idx) : _ring(ring), _idx(idx) {}
+            T& operator*() const { return _ring[_idx]; }
+            T* operator->() const { return &_ring[_idx]; }
+            iterator& operator++() { _idx++; return *this; }
+            bool operator==(iterator const& rhs) const { return &_ring == &rhs._ring && _idx == rhs._idx; }
+            bool operator!=(iterator const& rhs) const { return ! (*this == rhs); }
+      };
+
+      FlatRing(UInt64 size)
+         : m_capacity(roundUp(size))
+         , m_mask(m_capacity - 1)
+         , m_head(0)
+         , m_tail(0)
+         , m_ring(new (std::align_val_t(ALIGNMENT)) T[m_capacity])
+      {}
+      ~FlatRing() { ::operator delete[](m_ring, std::align_val_t(ALIGNMENT)); }
+
+      // Reserve the next free slot at the back, and return it for initialization
+      T& next() { assert(!full()); return m_ring[m_head++ & m_mask]; }
+      void push(const T& t) { next() = t; }
+      // Drop the oldest element, its slot will be reused by a later next()
+      void pop() { assert(!empty()); ++m_tail; }
+      void clear() { m_tail = m_head; }
+      T& front() { assert(!empty()); return m_ring[m_tail & m_mask]; }
+      const T& front() const { assert(!empty()); return m_ring[m_tail & m_mask]; }
+      T& back() { assert(!empty()); return m_ring[(m_head - 1) & m_mask]; }
+      const T& back() const { assert(!empty()); return m_ring[(m_head - 1) & m_mask]; }
+
+      bool full() const { return m_head - m_tail == m_capacity; }
+      bool empty() const { return m_head == m_tail; }
+      UInt64 size() const { return m_head - m_tail; }
+      UInt64 capacity() const { return m_capacity; }
+
+      T& operator[](UInt64 idx) const { return m_ring[(m_tail + idx) & m_mask]; }
+      T& at(UInt64 idx) const { assert(idx < size()); return (*this)[idx]; }
+
+      iterator begin() { return iterator(*this, 0); }
+      iterator end() { return iterator(*this, size()); }
+};
+
+#endif // FLAT_RING_H
@@ -0,0 +1,132 @@
+#ifndef FREE_INTERVAL_RING_H
+#define FREE_INTERVAL_RING_H
+
+#include "fixed_types.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <utility>
+#include <vector>
+
+// Sorted list of disjoint [start, end) free intervals for QueueModelHistoryList, stored contiguously
+// in a fixed-size buffer rather than as one heap node per interval.
+// The live intervals occupy [m_head, m_tail) of a buffer of twice the maximum list size:
+// expiring the oldest interval just advances m_head, and once m_tail hits the end of the buffer the
+// live part is moved back to the start, which happens at most once every max_size insertions.
+// Replacing an interval by zero, one or two new ones shifts the shorter side of the list,
+// for the usual case of requests at the tail end of the list this is constant time.
+// Lookups are a binary search, as both the start and end times increase along the list.
+
+template <typename T> class FreeIntervalRing
+{
+   public:
+      typedef std::pair<T, T> Interval;
+
+   private:
+      std::vector<Interval> m_buffer;
+      UInt32 m_head; // oldest interval
+      UInt32 m_tail; // one past the newest interval
+
+      void compact()
+      {
+         std::copy(m_buffer.begin() + m_head, m_buffer.begin() + m_tail, m_buffer.begin());
+         m_tail -= m_head;
+         m_head = 0;
+      }
+
+   public:
+      FreeIntervalRing(UInt32 max_size)
+         : m_buffer(2 * (max_size + 2))
+         , m_head(0)
+         , m_tail(0)
+      {}
+
+      UInt32 size() const { return m_tail - m_head; }
+      bool empty() const { return m_tail == m_head; }
+      const Interval& operator[](UInt32 index) const { return m_buffer[m_head + index]; }
+      const Interval& front() const { return m_buffer[m_head]; }
+      const Interval& back() const { return m_buffer[m_tail - 1]; }
+
+      void push_back(const Interval &interval)
+      {
+         if (m_tail == m_buffer.size())
+            compact();
+         m_buffer[m_tail++] = interval;
+      }
+
+      void pop_front()
+      {
+         assert(!empty());
+         ++m_head;
+      }
+
+      // Index of the first interval, in list order, that either contains [pkt_time, end_time),
+      // or starts after pkt_time. Returns size() if there is no such interval.
+      // Sets fits when the interval contains [pkt_time, end_time).
+      UInt32 find(T pkt_time, T end_time, bool &fits) const
+      {
+         // First interval that ends at or after end_time
+         UInt32 lo = 0, hi = size();
+         while (lo < hi)
+         {
+            UInt32 mid = lo + (hi - lo) / 2;
+            if ((*this)[mid].second >= end_time) hi = mid; else lo = mid + 1;
+         }
+         UInt32 first_ends_after = lo;
+         // First interval that starts after pkt_time
+         lo = 0; hi = size();
+         while (lo < hi)
+         {
+            UInt32 mid = lo + (hi - lo) / 2;
+            if ((*this)[mid].first > pkt_time) hi = mid; else lo = mid + 1;
+         }
+         UInt32 first_starts_after = lo;
+
+         fits = first_ends_after < first_starts_after;
+         return fits ? first_ends_after : first_starts_after;
+      }
+
+      // Replace the interval at index by count (0, 1 or 2) new intervals
+      void replace(UInt32 index, const Interval *intervals, UInt32 count)
+      {
+         assert(index < size() && count <= 2);
+         UInt32 pos = m_head + index;
+         if (count == 0)
+         {
+            if (index < size() / 2)
+            {
+               std::copy_backward(m_buffer.begin() + m_head, m_buffer.begin() + pos, m_buffer.begin() + pos + 1);
+               ++m_head;
+            }
+            else
+            {
+               std::copy(m_buffer.begin() + pos + 1, m_buffer.begin() + m_tail, m_buffer.begin() + pos);
+               --m_tail;
+            }
+            return;
+         }
+         if (count == 2)
+         {
+            if (m_head > 0 && index < size() / 2)
+            {
+               std::copy(m_buffer.begin() + m_head, m_buffer.begin() + pos, m_buffer.begin() + m_head - 1);
+               --m_head;
+               --pos;
+            }
+            else
+            {
+               if (m_tail == m_buffer.size())
+               {
+                  pos -= m_head;
+                  compact();
+               }
+               std::copy_backward(m_buffer.begin() + pos, m_buffer.begin() + m_tail, m_buffer.begin() + m_tail + 1);
+               ++m_tail;
+            }
+            m_buffer[pos + 1] = intervals[1];
+         }
+         m_buffer[pos] = intervals[0];
+      }
+};
+
+#endif // FREE_INTERVAL_RING_H
@@ -0,0 +1,48 @@
+#include "generation_counter.h"
+#include "os_compat.h"
+#include "fiber_pool.h"
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <limits.h>
+
+GenerationCounter::GenerationCounter()
+   : m_futx(0)
+{
+}
+
+void GenerationCounter::wait(Lock& lock)
+{
+   if (Fiber *fiber = Fiber::current())
+   {
+      fiber->prepareWait();
+      m_fibers.push_back(fiber);
+      lock.release();
+      fiber->park();
+      lock.acquire();
+      return;
+   }
+
+   int generation = m_futx;
+
+   lock.release();
+
+   // Returns immediately (EAGAIN) if advance() was called in between
+   while (m_futx == generation)
+      syscall(SYS_futex, (void*) &m_futx, FUTEX_WAIT | FUTEX_PRIVATE_FLAG, generation, NULL, NULL, 0);
+
+   lock.acquire();
+}
+
+void GenerationCounter::advance()
+{
+   __sync_fetch_and_add(&m_futx, 1);
+
+   syscall(SYS_futex, (void*) &m_futx, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, INT_MAX, NULL, NULL, 0);
+
+   std::vector<Fiber*> fibers;
+   fibers.swap(m_fibers);
+   for(std::vector<Fiber*>::iterator it = fibers.begin(); it != fibers.end(); ++it)
+      (*it)->wake();
+}
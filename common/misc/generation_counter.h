@@ -0,0 +1,31 @@
+#ifndef __GENERATION_COUNTER_H__
+#define __GENERATION_COUNTER_H__
+
+#include "fixed_types.h"
+#include "lock.h"
+
+#include <vector>
+
+class Fiber;
+
+// A single futex word that is incremented on every release. Any number of threads
+// can wait for the next generation, advance() wakes them all with one system call.
+// Waiters are expected to re-check their own release condition after waking up.
+// Waiting from a FiberPool fiber parks the fiber rather than blocking its host thread.
+
+class GenerationCounter
+{
+   public:
+      GenerationCounter();
+
+      // must acquire lock before entering wait (the same lock must be held while calling advance).
+      // will own lock upon exit.
+      void wait(Lock& _lock);
+      void advance();
+
+   private:
+      volatile int m_futx;
+      std::vector<Fiber*> m_fibers;  // Protected by the lock passed to wait()
+};
+
+#endif // __GENERATION_COUNTER_H__
@@ -0,0 +1,51 @@
+#ifndef INLINE_SET_H
+#define INLINE_SET_H
+
+#include "fixed_types.h"
+#include "log.h"
+
+#include <algorithm>
+
+// Fixed-capacity sorted set stored inline, for the handful of register ids an instruction decoder collects per operand.
+// Iterates in the same (ascending) order as std::set but never allocates, so it can be built on the stack and copied freely.
+
+template <class T, UInt32 N> class InlineSet
+{
+   private:
+      UInt32 m_size;
+      T m_elements[N];
+
+   public:
+      typedef const T* const_iterator;
+
+      InlineSet() : m_size(0) {}
+
+      UInt32 size() const { return m_size; }
+      bool empty() const { return m_size == 0; }
+      const_iterator begin() const { return m_elements; }
+      const_iterator end() const { return m_elements + m_size; }
+
+      UInt32 count(const T &value) const
+      {
+         return std::binary_search(begin(), end(), value) ? 1 : 0;
+      }
+
+      void insert(const T &value)
+      {
+         T *it = std::lower_bound(m_elements, m_elements + m_size, value);
+         if (it != m_elements + m_size && *it == value)
+            return;
+         LOG_ASSERT_ERROR(m_size < N, "InlineSet capacity of %u exceeded", N);
+         std::copy_backward(it, m_elements + m_size, m_elements + m_size + 1);
+         *it = value;
+         ++m_size;
+      }
+
+      void insert(const_iterator first, const_iterator last)
+      {
+         for( ; first != last; ++first)
+            insert(*first);
+      }
+};
+
+#endif // INLINE_SET_H
@@ -2,18 +2,15 @@
 #define LOCKED_HASH_H
 
 #include "fixed_types.h"
-#include "lock.h"
-
-#include <unordered_map>
+#include "concurrent_hash_map.h"
 
+// Former interface of a vector of mutex-guarded std::unordered_map buckets, now a ConcurrentHashMap:
+// lookups no longer take a lock, and the table grows instead of chaining within <size> buckets.
+// New code should use ConcurrentHashMap directly.
 class LockedHash
 {
    protected:
-      typedef std::unordered_map<UInt64, UInt64> Bucket;
-
-      UInt64 _size;
-      Bucket *_bins;
-      Lock *_locks;
+      ConcurrentHashMap<UInt64> _map;
    public:
       LockedHash(UInt64 size);
       ~LockedHash();
@@ -2,20 +2,19 @@
 #define LOCKFREE_HASH_H
 
 #include "fixed_types.h"
-#include "basic_hash.h"
+#include "concurrent_hash_map.h"
 
-#include <map>
 #include <utility>
-#include <iostream>
-#include <assert.h>
 
 //#define DEBUG_LOCKFREE_HASH
 
 
-class LockFreeHash : private BasicHash
+// Former fixed-size, collision-free table interface, now a ConcurrentHashMap: collisions are allowed
+// and the table grows as needed. New code should use ConcurrentHashMap directly.
+class LockFreeHash
 {
    private:
-      UInt64 bucket_size(UInt64 key);
+      ConcurrentHashMap<UInt64> m_map;
 
    public:
       LockFreeHash(UInt64 size);
@@ -11,6 +11,7 @@
 #include "core_manager.h"
 #include "config.hpp"
 #include "circular_log.h"
+#include "trace_log.h"
 
 // When debugging, it helps to be able to attach to the thread you would like to investigate directly,
 // instead of running the program from the beginning in GDB.
@@ -41,6 +42,9 @@ Log::Log(Config &config)
 
    if (Sim()->getConfig()->getCircularLogEnabled())
       CircularLog::init(formatFileName("sim.clog"));
+
+   if (Sim()->getCfg()->getBool("log/trace/enabled"))
+      TraceLog::init(formatFileName("sim.trace"), Sim()->getCfg()->getString("log/trace/modules"), Sim()->getCfg()->getInt("log/trace/level"));
 }
 
 Log::~Log()
@@ -64,6 +68,7 @@ Log::~Log()
       fclose(_systemFile);
 
    CircularLog::fini();
+   TraceLog::fini();
 }
 
 Log* Log::getSingleton()
@@ -347,6 +352,7 @@ void Log::log(ErrorState err, const char* source_file, SInt32 source_line, const
    {
    case Error:
       CircularLog::fini();
+      TraceLog::dump();
       fflush(NULL);
       fputs(message, stderr);
 #ifndef LOG_SIGSTOP_ON_ERROR
@@ -1,4 +1,5 @@
 #include "tls.h"
+#include "fiber_pool.h"
 #include <pthread.h>
 
 // Pthread
@@ -16,19 +17,28 @@ public:
         pthread_key_delete(m_key);
     }
 
+    // Fibers move between host threads, they keep their own values
+
     void* get(int thread_id = -1)
     {
+        if (Fiber *fiber = Fiber::current())
+            return fiber->getLocal(m_key);
         return pthread_getspecific(m_key);
     }
 
     const void* get(int thread_id = -1) const
     {
+        if (Fiber *fiber = Fiber::current())
+            return fiber->getLocal(m_key);
         return pthread_getspecific(m_key);
     }
 
     void set(void *vp)
     {
-        pthread_setspecific(m_key, vp);
+        if (Fiber *fiber = Fiber::current())
+            fiber->setLocal(m_key, vp);
+        else
+            pthread_setspecific(m_key, vp);
     }
 
 private:
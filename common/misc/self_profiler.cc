@@ -0,0 +1,106 @@
+#include "self_profiler.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "hooks_manager.h"
+#include "stats.h"
+#include "timer.h"
+
+#include <unistd.h>
+#include <cassert>
+#include <sys/syscall.h>
+
+static const char *subsystem_names[] = {
+   "frontend", "core-model", "memory", "network", "barrier", "hooks",
+};
+static_assert(sizeof(subsystem_names) / sizeof(subsystem_names[0]) == (size_t)SelfProfiler::NUM_SUBSYSTEMS,
+              "subsystem_names must have an entry for each subsystem");
+
+bool SelfProfiler::g_enabled = false;
+thread_local SelfProfiler::ThreadProfile *SelfProfiler::t_profile = NULL;
+std::vector<SelfProfiler::ThreadProfile*> SelfProfiler::g_profiles;
+Lock SelfProfiler::g_lock;
+
+void SelfProfiler::init()
+{
+   if (!Sim()->getCfg()->getBool("general/self_profile"))
+      return;
+
+   // Calibrate rdtsc() for Timer::ticksToNs
+   Timer timer;
+
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_PRE_STAT_WRITE, SelfProfiler::hook_pre_stat_write, 0);
+   g_enabled = true;
+}
+
+const char *SelfProfiler::getSubsystemName(subsystem_t subsystem)
+{
+   return subsystem_names[subsystem];
+}
+
+SelfProfiler::ThreadProfile *SelfProfiler::newThreadProfile()
+{
+   ThreadProfile *profile = new ThreadProfile();
+   profile->tid = syscall(__NR_gettid);
+
+   ScopedLock sl(g_lock);
+   g_profiles.push_back(profile);
+   t_profile = profile;
+   return profile;
+}
+
+void SelfProfiler::suspend(Context &context)
+{
+   ThreadProfile *profile = t_profile;
+   if (!profile || !profile->depth)
+   {
+      context.depth = 0;
+      return;
+   }
+
+   UInt64 now = rdtsc();
+   profile->ticks[profile->stack[std::min(profile->depth, MAX_DEPTH) - 1]] += now - profile->last;
+   context.depth = profile->depth;
+   std::copy(profile->stack, profile->stack + std::min(profile->depth, MAX_DEPTH), context.stack);
+   profile->depth = 0;
+   profile->last = now;
+}
+
+void SelfProfiler::resume(const Context &context)
+{
+   if (!context.depth)
+      return;
+
+   ThreadProfile *profile = t_profile ? t_profile : newThreadProfile();
+   // (LOG_ASSERT_ERROR can't be used here, SelfProfiler::exit() hides ::exit())
+   assert(profile->depth == 0);
+   profile->depth = context.depth;
+   std::copy(context.stack, context.stack + std::min(context.depth, MAX_DEPTH), profile->stack);
+   profile->last = rdtsc();
+}
+
+// Host threads appear throughout the simulation, register the statistics of new ones
+// from the thread writing statistics, right before they are recorded
+SInt64 SelfProfiler::hook_pre_stat_write(UInt64, UInt64)
+{
+   ScopedLock sl(g_lock);
+   for(UInt32 index = 0; index < g_profiles.size(); ++index)
+   {
+      ThreadProfile *profile = g_profiles[index];
+      if (profile->registered)
+         continue;
+      registerStatsMetric("self_profile", index, "host-tid", &profile->tid);
+      for(UInt32 subsystem = 0; subsystem < NUM_SUBSYSTEMS; ++subsystem)
+      {
+         Sim()->getStatsManager()->registerMetric(new StatsMetricCallback("self_profile", index, String(subsystem_names[subsystem]) + "-time",
+                                                                          SelfProfiler::getTime, (UInt64)&profile->ticks[subsystem]));
+         registerStatsMetric("self_profile", index, String(subsystem_names[subsystem]) + "-calls", &profile->calls[subsystem]);
+      }
+      profile->registered = true;
+   }
+   return 0;
+}
+
+UInt64 SelfProfiler::getTime(String objectName, UInt32 index, String metricName, UInt64 arg)
+{
+   return Timer::ticksToNs(*(UInt64*)arg);
+}
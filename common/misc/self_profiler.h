@@ -0,0 +1,121 @@
+#ifndef __SELF_PROFILER_H
+#define __SELF_PROFILER_H
+
+#include "fixed_types.h"
+#include "lock.h"
+
+#include <vector>
+#include <algorithm>
+
+// Host-side self-profiler (general/self_profile)
+//
+// SELF_PROFILE(subsystem) attributes the host time spent in the enclosing scope to a simulator subsystem.
+// Scopes nest: time is exclusive, so while a memory access made from the core model is in progress,
+// the core model is not charged. Each host thread accumulates rdtsc() ticks in its own counters without locking.
+// The totals per host thread are exported as self_profile.<subsystem>-time (ns) and <subsystem>-calls statistics,
+// indexed by host thread in the order threads first entered a profiled scope (self_profile.host-tid has their tid).
+// When profiling is off, a scope costs one test of a global flag.
+
+class SelfProfiler
+{
+   public:
+      static constexpr UInt32 MAX_DEPTH = 16;
+
+      enum subsystem_t
+      {
+         FRONTEND,   // TraceThread::run
+         CORE_MODEL, // PerformanceModel::iterate
+         MEMORY,     // CacheCntlr::processMemOpFromCore
+         NETWORK,    // Network::netSend
+         BARRIER,    // BarrierSyncServer::synchronize
+         HOOKS,      // HooksManager::callHooks
+         NUM_SUBSYSTEMS
+      };
+
+      static void init();
+      static const char *getSubsystemName(subsystem_t subsystem);
+
+      static bool isEnabled() { return g_enabled; }
+
+      static void enter(subsystem_t subsystem)
+      {
+         UInt64 now = rdtsc();
+         ThreadProfile *profile = t_profile ? t_profile : newThreadProfile();
+         if (profile->depth)
+            profile->ticks[profile->stack[std::min(profile->depth, MAX_DEPTH) - 1]] += now - profile->last;
+         if (profile->depth < MAX_DEPTH)
+            profile->stack[profile->depth] = subsystem;
+         ++profile->depth;
+         ++profile->calls[subsystem];
+         profile->last = now;
+      }
+
+      static void exit()
+      {
+         UInt64 now = rdtsc();
+         ThreadProfile *profile = t_profile;
+         // Scopes deeper than MAX_DEPTH are charged to the innermost recorded one
+         profile->ticks[profile->stack[std::min(profile->depth, MAX_DEPTH) - 1]] += now - profile->last;
+         --profile->depth;
+         profile->last = now;
+      }
+
+      // Open scopes of a user-level context (a FiberPool fiber) that can move between host threads
+      struct Context
+      {
+         UInt32 depth;
+         subsystem_t stack[MAX_DEPTH];
+      };
+      // Detach the calling host thread's open scopes into context, charging the time so far
+      static void suspend(Context &context);
+      // Reopen the scopes of context on the calling host thread, which must not have any open scopes
+      static void resume(const Context &context);
+
+   private:
+      struct ThreadProfile
+      {
+         UInt64 ticks[NUM_SUBSYSTEMS];
+         UInt64 calls[NUM_SUBSYSTEMS];
+         UInt64 last;
+         UInt32 depth;
+         subsystem_t stack[MAX_DEPTH];
+         UInt64 tid;
+         bool registered;
+      };
+
+      static bool g_enabled;
+      static thread_local ThreadProfile *t_profile;
+      static std::vector<ThreadProfile*> g_profiles;
+      static Lock g_lock;
+
+      static ThreadProfile *newThreadProfile();
+      static SInt64 hook_pre_stat_write(UInt64, UInt64);
+      static UInt64 getTime(String objectName, UInt32 index, String metricName, UInt64 arg);
+
+      // Inlined, unlike ::rdtsc() from timer.h
+      static UInt64 rdtsc() { UInt32 lo, hi; __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi)); return (UInt64(hi) << 32) | lo; }
+};
+
+class SelfProfileScope
+{
+   public:
+      SelfProfileScope(SelfProfiler::subsystem_t subsystem)
+         : m_active(SelfProfiler::isEnabled())
+      {
+         if (__builtin_expect(m_active, 0))
+            SelfProfiler::enter(subsystem);
+      }
+      ~SelfProfileScope()
+      {
+         if (__builtin_expect(m_active, 0))
+            SelfProfiler::exit();
+      }
+
+   private:
+      // Profiling can be enabled while a scope is open, only close scopes that were entered
+      const bool m_active;
+};
+
+#define SELF_PROFILE(subsystem) SelfProfileScope __self_profile_scope(SelfProfiler::subsystem)
+
+#endif // __SELF_PROFILER_H
@@ -1,5 +1,6 @@
 #include "setlock.h"
 #include <assert.h>
+#include <sched.h>
 
 _SetLock::_SetLock(UInt32 core_offset, UInt32 num_sharers)
    : m_locks(num_sharers)
@@ -64,3 +65,108 @@ _SetLock::downgrade(UInt32 core_id)
       if (i != (core_id - m_core_offset))
          m_locks.at(i).release();
 }
+
+
+#define WAIT_WHILE(condition)                      \
+   /* First busy wait a little */                  \
+   for(int i = 0; i < 10000 && (condition); ++i) ; \
+   while(condition) {                              \
+      /* Then reschedule */                        \
+      sched_yield();                               \
+   }
+
+_RWSetLock::_RWSetLock(UInt32 core_offset, UInt32 num_sharers)
+   : m_state(0)
+   , m_shared_contended(0)
+   , m_exclusive_contended(0)
+{
+   #ifdef TIME_LOCKS
+   _timer = TotalTimer::getTimerByStacktrace("rwsetlock@" + itostr(this));
+   #endif
+}
+
+// Acquire exclusive access
+void
+_RWSetLock::acquire_exclusive(void)
+{
+   UInt32 state = 0;
+   if (m_state.compare_exchange_strong(state, WRITER, std::memory_order_acquire))
+      return;
+
+   #ifdef TIME_LOCKS
+   ScopedTimer tt(*_timer);
+   #endif
+
+   __sync_add_and_fetch(&m_exclusive_contended, 1);
+   // Tell everyone we want to write, this keeps out new readers
+   m_state.fetch_add(WAITING_ONE, std::memory_order_relaxed);
+
+   while(true) {
+      // Wait until the current writer and all readers have left
+      WAIT_WHILE(m_state.load(std::memory_order_relaxed) & (WRITER | READER_MASK));
+
+      // Become the writer and remove ourselves from the waiting writers, unless another writer beat us to it
+      state = m_state.load(std::memory_order_relaxed);
+      if ((state & (WRITER | READER_MASK)) == 0
+         && m_state.compare_exchange_weak(state, (state - WAITING_ONE) | WRITER, std::memory_order_acquire))
+         break;
+   }
+}
+
+// Release exclusive access
+void
+_RWSetLock::release_exclusive(void)
+{
+   assert(m_state.load() & WRITER);
+   m_state.fetch_and(~WRITER, std::memory_order_release);
+}
+
+// Acquire shared access
+void
+_RWSetLock::acquire_shared(UInt32 core_id)
+{
+   UInt32 state = m_state.load(std::memory_order_relaxed);
+   if ((state & (WRITER | WAITING_MASK)) == 0
+      && m_state.compare_exchange_weak(state, state + 1, std::memory_order_acquire))
+      return;
+
+   #ifdef TIME_LOCKS
+   ScopedTimer tt(*_timer);
+   #endif
+
+   __sync_add_and_fetch(&m_shared_contended, 1);
+
+   while(true) {
+      // Wait until the current writer, and writers that were waiting before us, have left
+      WAIT_WHILE(m_state.load(std::memory_order_relaxed) & (WRITER | WAITING_MASK));
+
+      state = m_state.load(std::memory_order_relaxed);
+      if ((state & (WRITER | WAITING_MASK)) == 0
+         && m_state.compare_exchange_weak(state, state + 1, std::memory_order_acquire))
+         break;
+   }
+}
+
+// Release shared access
+void
+_RWSetLock::release_shared(UInt32 core_id)
+{
+   assert(m_state.load() & READER_MASK);
+   m_state.fetch_sub(1, std::memory_order_release);
+}
+
+void
+_RWSetLock::upgrade(UInt32 core_id)
+{
+   // As with _SetLock, upgrading releases the shared lock first: two readers upgrading at the same time would deadlock otherwise
+   release_shared(core_id);
+   acquire_exclusive();
+}
+
+void
+_RWSetLock::downgrade(UInt32 core_id)
+{
+   assert(m_state.load() & WRITER);
+   // Atomically turn the writer into a reader, so no waiting writer can come in until we fully release
+   m_state.fetch_sub(WRITER - 1, std::memory_order_acq_rel);
+}
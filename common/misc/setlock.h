@@ -5,6 +5,7 @@
 #include "selock.h"
 
 #include <vector>
+#include <atomic>
 #include <pthread.h>
 
 /* Cache set lock */
@@ -48,10 +49,46 @@ class _SELock : SELock
       void upgrade(UInt32 core_id)        { SELock::upgrade(); }
 };
 
+/* Reader/writer set lock. One word per set with the reader count, waiting writers and the writer bit,
+   so shared acquires are a single compare-and-swap and exclusive acquires no longer take one mutex per sharing core.
+   Waiting writers block new readers. Acquires that have to wait are counted, so lock contention can be reported. */
+
+class _RWSetLock
+{
+   public:
+      _RWSetLock(UInt32 core_offset = 0, UInt32 num_sharers = 0);
+      // Copying creates a new, unlocked lock (needed to put locks in a vector)
+      _RWSetLock(const _RWSetLock &lock) : _RWSetLock() {}
+      void acquire_exclusive(void);
+      void release_exclusive(void);
+      void acquire_shared(UInt32 core_id);
+      void release_shared(UInt32 core_id);
+      void upgrade(UInt32 core_id);
+      void downgrade(UInt32 core_id);
+
+      UInt64 getSharedContended() const { return m_shared_contended; }
+      UInt64 getExclusiveContended() const { return m_exclusive_contended; }
+
+   private:
+      static const UInt32 READER_MASK = 0x0000ffff;
+      static const UInt32 WAITING_ONE = 0x00010000;
+      static const UInt32 WAITING_MASK = 0x7fff0000;
+      static const UInt32 WRITER = 0x80000000;
+
+      std::atomic<UInt32> m_state;
+      UInt64 m_shared_contended;
+      UInt64 m_exclusive_contended;
+      #ifdef TIME_LOCKS
+      TotalTimer* _timer;
+      #endif
+} __attribute__ ((aligned (64)));
+
 #if 0
   typedef SELock SetLock;
-#else
+#elif 0
   typedef _SetLock SetLock;
+#else
+  typedef _RWSetLock SetLock;
 #endif
 
 #endif // SETLOCK_H
@@ -6,6 +6,24 @@
 #include "spin_loop_detector.h"
 #include "core.h"
 #include "performance_model.h"
+#include "simulator.h"
+#include "config.hpp"
+
+SpinLoopDetector::SpinLoopDetector(Thread *thread)
+   : m_thread(thread)
+   , m_rub()
+   , m_sdt()
+   , m_sdt_bitmask(0)
+   , m_sdt_nextid(0)
+   , m_fastforward(Sim()->getCfg()->getBool("core/spin_loop_fastforward"))
+   , m_fastforward_threshold(Sim()->getCfg()->getInt("core/spin_loop_fastforward_threshold"))
+   , m_candidate_eip(0)
+   , m_candidate_iterations(0)
+   , m_skip_eip(0)
+   , m_skip_icount(0)
+   , m_skip_tcount(SubsecondTime::Zero())
+{
+}
 
 void SpinLoopDetector::commitBCT(uint64_t eip)
 {
@@ -57,7 +75,11 @@ void SpinLoopDetector::commitBCT(uint64_t eip)
          }
       }
 
-      if (spinning)
+      if (spinning && isSkipping())
+      {
+         // Skipped iterations are accounted for in aggregate by endSkip()
+      }
+      else if (spinning)
       {
          // Spin loop detected !!
          core->updateSpinCount(
@@ -67,6 +89,26 @@ void SpinLoopDetector::commitBCT(uint64_t eip)
             // so if spin count is large (which is when we care) it should be reasonably accurate.
             core->getPerformanceModel()->getElapsedTime() - entry->tcount
          );
+
+         if (m_fastforward)
+         {
+            if (eip == m_candidate_eip)
+               ++m_candidate_iterations;
+            else
+            {
+               m_candidate_eip = eip;
+               m_candidate_iterations = 1;
+            }
+            if (m_candidate_iterations >= m_fastforward_threshold)
+               startSkip(eip);
+         }
+      }
+      else
+      {
+         if (eip == m_skip_eip)
+            endSkip();
+         if (eip == m_candidate_eip)
+            m_candidate_iterations = 0;
       }
 
       entry->icount = core->getInstructionCount();
@@ -74,11 +116,48 @@ void SpinLoopDetector::commitBCT(uint64_t eip)
    }
 }
 
+void SpinLoopDetector::commitFallThrough(uint64_t eip)
+{
+   // The loop branch was not taken: we left the loop
+   if (eip == m_skip_eip)
+      endSkip();
+}
+
 void SpinLoopDetector::commitNonSilentStore()
 {
    // ``Whenever the processor commits a non-silent store, it clears the SDT.''
    m_sdt.clear();
    m_rub.clear();
+
+   if (isSkipping())
+      endSkip();
+   m_candidate_eip = 0;
+   m_candidate_iterations = 0;
+}
+
+void SpinLoopDetector::startSkip(uint64_t eip)
+{
+   Core *core = m_thread->getCore();
+
+   m_skip_eip = eip;
+   m_skip_icount = core->getInstructionCount();
+   m_skip_tcount = core->getPerformanceModel()->getElapsedTime();
+}
+
+void SpinLoopDetector::endSkip()
+{
+   // The thread may have been rescheduled while it was spinning, the counts are those of the core it is on now
+   Core *core = m_thread->getCore();
+   UInt64 icount = core->getInstructionCount();
+   SubsecondTime tcount = core->getPerformanceModel()->getElapsedTime();
+
+   core->updateSpinSkip(
+      icount > m_skip_icount ? icount - m_skip_icount : 0,
+      tcount > m_skip_tcount ? tcount - m_skip_tcount : SubsecondTime::Zero()
+   );
+
+   m_skip_eip = 0;
+   m_candidate_iterations = 0;
 }
 
 void SpinLoopDetector::commitRegisterWrite(reg_t reg, uint64_t old_value, uint64_t value)
@@ -31,14 +31,30 @@ class SpinLoopDetector
       uint16_t m_sdt_bitmask; // Bitmask of all valid SDT entries
       uint8_t m_sdt_nextid;
 
+      // Fast-forwarding of confirmed spin loops (core/spin_loop_fastforward)
+      const bool m_fastforward;
+      const uint64_t m_fastforward_threshold; // Consecutive spinning iterations before a loop is confirmed
+      uint64_t m_candidate_eip;
+      uint64_t m_candidate_iterations;
+      uint64_t m_skip_eip; // BCT of the loop being skipped, 0 if none
+      uint64_t m_skip_icount;
+      SubsecondTime m_skip_tcount;
+
+      void startSkip(uint64_t eip);
+      void endSkip();
+
    public:
-      SpinLoopDetector(Thread *thread) : m_thread(thread), m_rub(), m_sdt(), m_sdt_bitmask(0), m_sdt_nextid(0) {}
+      SpinLoopDetector(Thread *thread);
 
       void commitBCT(uint64_t eip);
+      void commitFallThrough(uint64_t eip);
       void commitNonSilentStore();
       void commitRegisterWrite(reg_t reg, uint64_t old_value, uint64_t value);
 
       bool inCandidateSpin() { return !m_sdt.empty(); }
+      // While true, the front-end does not send instructions to the timing model but lets the core idle
+      // until the next barrier: the loop can only exit once another core writes the spun-on data
+      bool isSkipping() const { return m_skip_eip != 0; }
 };
 
 #endif // __SPIN_LOOP_DETECTOR_H
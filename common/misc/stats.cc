@@ -1,8 +1,15 @@
 #include "stats.h"
+#include "stats_binary_file.h"
+#include "cpistack_file.h"
+#include "event_trace.h"
+#include "checkpoint.h"
 #include "simulator.h"
 #include "hooks_manager.h"
+#include "config.hpp"
 #include "utils.h"
 #include "itostr.h"
+#include "sem.h"
+#include "_thread.h"
 
 #include <math.h>
 #include <stdio.h>
@@ -12,10 +19,14 @@
 #include <cstring>
 #include <zlib.h>
 #include <sys/time.h>
+#include <atomic>
 
 template <> UInt64 makeStatsValue<UInt64>(UInt64 t) { return t; }
 template <> UInt64 makeStatsValue<SubsecondTime>(SubsecondTime t) { return t.getFS(); }
 template <> UInt64 makeStatsValue<ComponentTime>(ComponentTime t) { return t.getElapsedTime().getFS(); }
+template <> void restoreStatsValue<UInt64>(UInt64 *t, UInt64 value) { *t = value; }
+template <> void restoreStatsValue<SubsecondTime>(SubsecondTime *t, UInt64 value) { *t = SubsecondTime::FS(value); }
+template <> void restoreStatsValue<ComponentTime>(ComponentTime *t, UInt64 value) { t->setElapsedTime(SubsecondTime::FS(value)); }
 
 const char* db_create_stmts[] = {
    // Statistics
@@ -40,10 +51,123 @@ UInt64 getWallclockTimeCallback(String objectName, UInt32 index, String metricNa
    return usec;
 }
 
+// Writes one SIGUSR1 snapshot at a time: the simulation fills the buffer while the writer is idle,
+// the writer inserts it in a single transaction on its own connection to sim.stats.sqlite3
+class StatsManager::SnapshotWriter : public Runnable
+{
+   public:
+      struct Value
+      {
+         UInt64 nameid;
+         UInt32 index;
+         UInt64 value;
+      };
+
+      SnapshotWriter(String filename)
+         : m_filename(filename)
+         , m_prefixid(0)
+         , m_busy(false)
+         , m_full(0)
+         , m_exited(0)
+      {
+         m_thread = _Thread::create(this);
+         m_thread->run();
+      }
+
+      ~SnapshotWriter()
+      {
+         // Wakes up the writer without a snapshot, after it finished the one in progress (if any)
+         m_full.signal();
+         m_exited.wait();
+         delete m_thread;
+      }
+
+      bool isBusy() const { return m_busy; }
+      // Only to be filled when the writer is not busy
+      std::vector<Value> &getValues() { return m_values; }
+
+      void submit(UInt64 prefixid, String prefix)
+      {
+         m_prefixid = prefixid;
+         m_prefix = prefix;
+         m_busy = true;
+         m_full.signal();
+      }
+
+   private:
+      const String m_filename;
+      UInt64 m_prefixid;
+      String m_prefix;
+      std::vector<Value> m_values;
+      std::atomic<bool> m_busy;
+      Semaphore m_full, m_exited;
+      _Thread *m_thread;
+
+      void run()
+      {
+         sqlite3 *db;
+         int res = sqlite3_open(m_filename.c_str(), &db);
+         LOG_ASSERT_ERROR(res == SQLITE_OK, "Cannot open %s", m_filename.c_str());
+         sqlite3_exec(db, "PRAGMA synchronous = OFF", NULL, NULL, NULL);
+         sqlite3_exec(db, "PRAGMA journal_mode = MEMORY", NULL, NULL, NULL);
+         // The simulation's own connection may hold the database for the duration of a snapshot
+         sqlite3_busy_timeout(db, 3600 * 1000);
+
+         sqlite3_stmt *stmt_prefix, *stmt_value;
+         sqlite3_prepare(db, db_insert_stmt_prefix, -1, &stmt_prefix, NULL);
+         sqlite3_prepare(db, db_insert_stmt_value, -1, &stmt_value, NULL);
+
+         while (true)
+         {
+            m_full.wait();
+            if (!m_busy)
+               break;
+
+            // Take the write lock up front, a deferred transaction could deadlock with the simulation's connection
+            res = sqlite3_exec(db, "BEGIN IMMEDIATE TRANSACTION", NULL, NULL, NULL);
+            LOG_ASSERT_ERROR(res == SQLITE_OK, "Error executing SQL statement: %s", sqlite3_errmsg(db));
+
+            sqlite3_reset(stmt_prefix);
+            sqlite3_bind_int(stmt_prefix, 1, m_prefixid);
+            sqlite3_bind_text(stmt_prefix, 2, m_prefix.c_str(), -1, SQLITE_TRANSIENT);
+            res = sqlite3_step(stmt_prefix);
+            LOG_ASSERT_ERROR(res == SQLITE_DONE, "Error executing SQL statement: %s", sqlite3_errmsg(db));
+
+            for(std::vector<Value>::iterator it = m_values.begin(); it != m_values.end(); ++it)
+            {
+               sqlite3_reset(stmt_value);
+               sqlite3_bind_int(stmt_value, 1, m_prefixid);
+               sqlite3_bind_int(stmt_value, 2, it->nameid);
+               sqlite3_bind_int(stmt_value, 3, it->index);
+               sqlite3_bind_int64(stmt_value, 4, it->value);
+               res = sqlite3_step(stmt_value);
+               LOG_ASSERT_ERROR(res == SQLITE_DONE, "Error executing SQL statement: %s", sqlite3_errmsg(db));
+            }
+
+            res = sqlite3_exec(db, "END TRANSACTION", NULL, NULL, NULL);
+            LOG_ASSERT_ERROR(res == SQLITE_OK, "Error executing SQL statement: %s", sqlite3_errmsg(db));
+
+            m_busy = false;
+         }
+
+         sqlite3_finalize(stmt_prefix);
+         sqlite3_finalize(stmt_value);
+         sqlite3_close(db);
+         m_exited.signal();
+      }
+};
+
 StatsManager::StatsManager()
    : m_keyid(0)
    , m_prefixnum(0)
    , m_db(NULL)
+   , m_binary(NULL)
+   , m_columns_written(0)
+   , m_cpistack(NULL)
+   , m_event_trace(NULL)
+   , m_snapshot_writer(NULL)
+   , m_snapshot_requested(false)
+   , m_snapshot_count(0)
 {
    init();
 
@@ -52,6 +176,9 @@ StatsManager::StatsManager()
 
 StatsManager::~StatsManager()
 {
+   if (m_snapshot_writer)
+      delete m_snapshot_writer;
+
    for(StatsObjectList::iterator it1 = m_objects.begin(); it1 != m_objects.end(); ++it1)
       for (StatsMetricList::iterator it2 = it1->second.begin(); it2 != it1->second.end(); ++it2)
          for(StatsIndexList::iterator it3 = it2->second.second.begin(); it3 != it2->second.second.end(); ++it3)
@@ -64,6 +191,18 @@ StatsManager::~StatsManager()
       sqlite3_finalize(m_stmt_insert_value);
       sqlite3_close(m_db);
    }
+
+   if (m_binary)
+      delete m_binary;
+
+   if (m_cpistack)
+      delete m_cpistack;
+
+   if (m_event_trace)
+      delete m_event_trace;
+
+   for(std::vector<void*>::iterator it = m_counter_chunks.begin(); it != m_counter_chunks.end(); ++it)
+      free(*it);
 }
 
 void
@@ -90,6 +229,21 @@ StatsManager::init()
    sqlite3_prepare(m_db, db_insert_stmt_prefix, -1, &m_stmt_insert_prefix, NULL);
    sqlite3_prepare(m_db, db_insert_stmt_value, -1, &m_stmt_insert_value, NULL);
 
+   String binary_filename = Sim()->getConfig()->formatOutputFileName("sim.stats.bin");
+   unlink(binary_filename.c_str());
+   if (Sim()->getCfg()->getBool("general/stats_binary"))
+      m_binary = new StatsBinaryFile(binary_filename, Sim()->getCfg()->getBool("general/stats_binary_async"));
+
+   String cpistack_filename = Sim()->getConfig()->formatOutputFileName("sim.cpistack");
+   unlink(cpistack_filename.c_str());
+   if (Sim()->getCfg()->getBool("general/cpistack_file"))
+      m_cpistack = new CpiStackFile(cpistack_filename);
+
+   String events_filename = Sim()->getConfig()->formatOutputFileName("sim.events.bin");
+   unlink(events_filename.c_str());
+   if (Sim()->getCfg()->getBool("general/events_binary"))
+      m_event_trace = new EventTrace(events_filename);
+
    sqlite3_exec(m_db, "BEGIN TRANSACTION", NULL, NULL, NULL);
    for(StatsObjectList::iterator it1 = m_objects.begin(); it1 != m_objects.end(); ++it1)
    {
@@ -101,6 +255,18 @@ StatsManager::init()
    sqlite3_exec(m_db, "END TRANSACTION", NULL, NULL, NULL);
 }
 
+void
+StatsManager::enableCallbacks()
+{
+   if (Sim()->getCfg()->getBool("general/stats_sigusr1"))
+   {
+      if (!m_binary)
+         m_snapshot_writer = new SnapshotWriter(Sim()->getConfig()->formatOutputFileName("sim.stats.sqlite3"));
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_SIGUSR1, __hook_sigusr1, (UInt64)this);
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, __hook_periodic, (UInt64)this);
+   }
+}
+
 int
 StatsManager::busy_handler(int count)
 {
@@ -123,6 +289,13 @@ StatsManager::recordMetricName(UInt64 keyId, std::string objectName, std::string
    sqlite3_bind_text(m_stmt_insert_name, 3, metricName.c_str(), -1, SQLITE_TRANSIENT);
    res = sqlite3_step(m_stmt_insert_name);
    LOG_ASSERT_ERROR(res == SQLITE_DONE, "Error executing SQL statement");
+
+   if (m_binary)
+   {
+      std::string record((char*)&keyId, sizeof(UInt64));
+      record += objectName + '\0' + metricName + '\0';
+      m_binary->writeRecord(StatsBinaryFile::RECORD_NAME, record.data(), record.size());
+   }
 }
 
 void
@@ -133,6 +306,15 @@ StatsManager::recordStats(String prefix)
    // Allow lazily-maintained statistics to be updated
    Sim()->getHooksManager()->callHooks(HookType::HOOK_PRE_STAT_WRITE, (UInt64)prefix.c_str());
 
+   if (m_cpistack)
+      m_cpistack->recordSnapshot(prefix);
+
+   if (m_binary)
+   {
+      recordStatsBinary(prefix);
+      return;
+   }
+
    int res;
    int prefixid = ++m_prefixnum;
 
@@ -168,10 +350,87 @@ StatsManager::recordStats(String prefix)
    LOG_ASSERT_ERROR(res == SQLITE_OK, "Error executing SQL statement: %s", sqlite3_errmsg(m_db));
 }
 
+void
+StatsManager::recordStatsBinary(String prefix)
+{
+   // Describe metrics registered since the previous snapshot
+   if (m_columns_written < m_columns.size())
+   {
+      UInt64 count = m_columns.size() - m_columns_written;
+      std::vector<UInt64> record(2 + count);
+      record[0] = m_columns_written;
+      record[1] = count;
+      UInt32 *entries = (UInt32*)&record[2];
+      for(UInt64 i = 0; i < count; ++i)
+      {
+         entries[2*i] = m_columns[m_columns_written + i].nameid;
+         entries[2*i+1] = m_columns[m_columns_written + i].metric->index;
+      }
+      m_binary->writeRecord(StatsBinaryFile::RECORD_COLUMNS, record.data(), record.size() * sizeof(UInt64));
+      m_columns_written = m_columns.size();
+   }
+
+   std::string _prefix(prefix.c_str());
+   UInt64 &prefixid = m_binary_prefixes[_prefix];
+   if (prefixid == 0)
+   {
+      prefixid = ++m_prefixnum;
+      std::string record((char*)&prefixid, sizeof(UInt64));
+      record += _prefix + '\0';
+      m_binary->writeRecord(StatsBinaryFile::RECORD_PREFIX, record.data(), record.size());
+   }
+
+   // Only copy out the values here, in asynchronous mode they are encoded and written by a background thread
+   UInt64 count = m_columns_written;
+   UInt64 *values = m_binary->beginSnapshot(prefixid, count);
+   for(UInt64 i = 0; i < count; ++i)
+      values[i] = m_columns[i].metric->recordMetric();
+   m_binary->endSnapshot();
+}
+
+void
+StatsManager::recordSnapshot()
+{
+   if (!m_snapshot_requested)
+      return;
+   m_snapshot_requested = false;
+
+   String prefix = "sigusr1-" + itostr(++m_snapshot_count);
+
+   // Binary snapshots already only copy out the values (and with general/stats_binary_async, encode and write them in the background)
+   if (m_binary)
+   {
+      recordStats(prefix);
+      return;
+   }
+
+   // Keep the pause at the barrier bounded: rather than waiting for a slow write to finish, drop the request
+   if (m_snapshot_writer->isBusy())
+   {
+      LOG_PRINT_WARNING("Statistics snapshot %s dropped, the previous one is still being written", prefix.c_str());
+      return;
+   }
+
+   Sim()->getHooksManager()->callHooks(HookType::HOOK_PRE_STAT_WRITE, (UInt64)prefix.c_str());
+
+   std::vector<SnapshotWriter::Value> &values = m_snapshot_writer->getValues();
+   values.clear();
+   for(std::vector<Column>::iterator it = m_columns.begin(); it != m_columns.end(); ++it)
+   {
+      if (!it->metric->isDefault())
+      {
+         SnapshotWriter::Value value = { it->nameid, it->metric->index, it->metric->recordMetric() };
+         values.push_back(value);
+      }
+   }
+   m_snapshot_writer->submit(++m_prefixnum, prefix);
+}
+
 void
 StatsManager::registerMetric(StatsMetricBase *metric)
 {
    std::string _objectName(metric->objectName.c_str()), _metricName(metric->metricName.c_str());
+   ScopedLock sl(m_register_lock);
 
    LOG_ASSERT_ERROR(m_objects[_objectName][_metricName].second.count(metric->index) == 0,
       "Duplicate statistic %s.%s[%d]", _objectName.c_str(), _metricName.c_str(), metric->index);
@@ -186,6 +445,45 @@ StatsManager::registerMetric(StatsMetricBase *metric)
          recordMetricName(m_keyid, _objectName, _metricName);
       }
    }
+
+   Column column = { m_objects[_objectName][_metricName].first, metric };
+   m_columns.push_back(column);
+
+   if (m_cpistack)
+      m_cpistack->addMetric(metric);
+}
+
+void *
+StatsManager::allocCounters(core_id_t core_id, size_t size, size_t align)
+{
+   ScopedLock sl(m_counter_lock);
+
+   LOG_ASSERT_ERROR(align <= 64, "Cannot allocate counters with an alignment of %lu bytes", align);
+
+   if (size > COUNTER_CHUNK_SIZE / 4)
+   {
+      // Large counter blocks get their own chunk
+      void *ptr = aligned_alloc(64, (size + 63) & ~63UL);
+      memset(ptr, 0, size);
+      m_counter_chunks.push_back(ptr);
+      return ptr;
+   }
+
+   CounterBlock &block = m_counter_blocks[core_id];
+   size_t padding = block.left ? (align - (uintptr_t)block.next % align) % align : 0;
+   if (block.left < padding + size)
+   {
+      block.next = (char*)aligned_alloc(64, COUNTER_CHUNK_SIZE);
+      block.left = COUNTER_CHUNK_SIZE;
+      padding = 0;
+      memset(block.next, 0, COUNTER_CHUNK_SIZE);
+      m_counter_chunks.push_back(block.next);
+   }
+
+   void *ptr = block.next + padding;
+   block.next += padding + size;
+   block.left -= padding + size;
+   return ptr;
 }
 
 StatsMetricBase *
@@ -204,6 +502,7 @@ StatsManager::getMetricObject(String objectName, UInt32 index, String metricName
 void
 StatsManager::logTopology(String component, core_id_t core_id, core_id_t master_id)
 {
+   ScopedLock sl(m_register_lock);
    sqlite3_stmt *stmt;
    sqlite3_prepare(m_db, "INSERT INTO topology (componentname, coreid, masterid) VALUES (?, ?, ?);", -1, &stmt, NULL);
    sqlite3_bind_text(stmt, 1, component.c_str(), -1, SQLITE_TRANSIENT);
@@ -220,6 +519,12 @@ StatsManager::logEvent(event_type_t event, SubsecondTime time, core_id_t core_id
    if (time == SubsecondTime::MaxTime())
       time = Sim()->getClockSkewMinimizationServer()->getGlobalTime();
 
+   if (m_event_trace)
+   {
+      m_event_trace->record(event, time.getFS(), core_id, thread_id, value0, value1, description ? description : "");
+      return;
+   }
+
    sqlite3_stmt *stmt;
    sqlite3_prepare(m_db, "INSERT INTO event (event, time, core, thread, value0, value1, description) VALUES (?, ?, ?, ?, ?, ?, ?);", -1, &stmt, NULL);
    sqlite3_bind_int(stmt, 1, event);
@@ -234,6 +539,107 @@ StatsManager::logEvent(event_type_t event, SubsecondTime time, core_id_t core_id
    sqlite3_finalize(stmt);
 }
 
+void
+StatsManager::saveCheckpoint(CheckpointWriter &ckpt)
+{
+   // Let lazily-maintained statistics catch up, so their current value is what gets saved
+   Sim()->getHooksManager()->callHooks(HookType::HOOK_PRE_STAT_WRITE, (UInt64)"checkpoint");
+
+   // Metrics are identified by name, registration order can differ between runs
+   UInt64 count = 0;
+   for(std::vector<Column>::iterator it = m_columns.begin(); it != m_columns.end(); ++it)
+      if (it->metric->isRestorable())
+         ++count;
+
+   ckpt.put(count);
+   for(std::vector<Column>::iterator it = m_columns.begin(); it != m_columns.end(); ++it)
+   {
+      if (!it->metric->isRestorable())
+         continue;
+      ckpt.put(it->metric->objectName);
+      ckpt.put<UInt32>(it->metric->index);
+      ckpt.put(it->metric->metricName);
+      ckpt.put<UInt64>(it->metric->recordMetric());
+   }
+}
+
+void
+StatsManager::loadCheckpoint(CheckpointReader &ckpt)
+{
+   UInt64 count, missing = 0;
+   ckpt.get(count);
+   for(UInt64 i = 0; i < count; ++i)
+   {
+      String objectName, metricName;
+      UInt32 index;
+      UInt64 value;
+      ckpt.get(objectName);
+      ckpt.get(index);
+      ckpt.get(metricName);
+      ckpt.get(value);
+
+      StatsMetricBase *metric = getMetricObject(objectName, index, metricName);
+      if (metric && metric->isRestorable())
+         metric->restoreMetric(value);
+      else
+         ++missing;
+   }
+   if (missing)
+      LOG_PRINT_WARNING("%ld of %ld statistics in the checkpoint do not exist in this simulation and were not restored", missing, count);
+}
+
+void
+StatsManager::saveDatabase(String filename)
+{
+   // Only the sqlite3 database is copied, sim.stats.bin, sim.cpistack and sim.events.bin restart on resume
+   sqlite3 *db;
+   unlink(filename.c_str());
+   int res = sqlite3_open(filename.c_str(), &db);
+   LOG_ASSERT_ERROR(res == SQLITE_OK, "Cannot create %s", filename.c_str());
+
+   sqlite3_backup *backup = sqlite3_backup_init(db, "main", m_db, "main");
+   LOG_ASSERT_ERROR(backup, "Cannot copy sim.stats.sqlite3: %s", sqlite3_errmsg(db));
+   sqlite3_backup_step(backup, -1);
+   res = sqlite3_backup_finish(backup);
+   LOG_ASSERT_ERROR(res == SQLITE_OK, "Cannot copy sim.stats.sqlite3: %s", sqlite3_errmsg(db));
+   sqlite3_close(db);
+}
+
+void
+StatsManager::mergeDatabase(String filename)
+{
+   // Copy snapshots and events of the checkpointed run, mapping metrics by name onto this run's name ids,
+   // and number the snapshots of this run after them
+   int res;
+   char *err;
+   char *attach = sqlite3_mprintf("ATTACH DATABASE %Q AS ckpt;", filename.c_str());
+   res = sqlite3_exec(m_db, attach, NULL, NULL, &err);
+   sqlite3_free(attach);
+   LOG_ASSERT_ERROR(res == SQLITE_OK, "Cannot open %s: %s", filename.c_str(), err);
+
+   sqlite3_stmt *stmt;
+   sqlite3_prepare(m_db, "SELECT IFNULL(MAX(prefixid), 0) FROM ckpt.prefixes;", -1, &stmt, NULL);
+   res = sqlite3_step(stmt);
+   LOG_ASSERT_ERROR(res == SQLITE_ROW, "Error executing SQL statement: %s", sqlite3_errmsg(m_db));
+   UInt64 prefixes = sqlite3_column_int64(stmt, 0);
+   sqlite3_finalize(stmt);
+
+   const char *merge_fmt =
+      "BEGIN TRANSACTION;"
+      "INSERT INTO `prefixes` (prefixid, prefixname) SELECT prefixid + %llu, prefixname FROM ckpt.`prefixes`;"
+      "INSERT INTO `values` (prefixid, nameid, core, value) SELECT v.prefixid + %llu, n.nameid, v.core, v.value FROM ckpt.`values` v"
+      " JOIN ckpt.`names` o ON v.nameid = o.nameid JOIN `names` n ON n.objectname = o.objectname AND n.metricname = o.metricname;"
+      "INSERT INTO `event` SELECT * FROM ckpt.`event`;"
+      "END TRANSACTION;";
+   char *merge = sqlite3_mprintf(merge_fmt, (unsigned long long)m_prefixnum, (unsigned long long)m_prefixnum);
+   res = sqlite3_exec(m_db, merge, NULL, NULL, &err);
+   sqlite3_free(merge);
+   LOG_ASSERT_ERROR(res == SQLITE_OK, "Error merging %s: %s", filename.c_str(), err);
+
+   sqlite3_exec(m_db, "DETACH DATABASE ckpt;", NULL, NULL, NULL);
+   m_prefixnum += prefixes;
+}
+
 StatHist &
 StatHist::operator += (StatHist & stat)
 {
@@ -4,8 +4,15 @@
 #include "itostr.h"
 
 #include <cstring>
+#include <vector>
 #include <sqlite3.h>
 
+class StatsBinaryFile;
+class CpiStackFile;
+class EventTrace;
+class CheckpointWriter;
+class CheckpointReader;
+
 class StatsMetricBase
 {
    public:
@@ -18,9 +25,13 @@ class StatsMetricBase
       virtual ~StatsMetricBase() {}
       virtual UInt64 recordMetric() = 0;
       virtual bool isDefault() { return false; } // Return true when value hasn't changed from its initialization value
+      // Overwrite the value with one saved in a checkpoint, computed metrics (callbacks) are not restorable
+      virtual bool isRestorable() const { return false; }
+      virtual void restoreMetric(UInt64 value) {}
 };
 
 template <class T> UInt64 makeStatsValue(T t);
+template <class T> void restoreStatsValue(T *t, UInt64 value);
 
 template <class T> class StatsMetric : public StatsMetricBase
 {
@@ -37,6 +48,11 @@ template <class T> class StatsMetric : public StatsMetricBase
       {
          return recordMetric() == 0;
       }
+      virtual bool isRestorable() const { return true; }
+      virtual void restoreMetric(UInt64 value)
+      {
+         restoreStatsValue<T>(metric, value);
+      }
 };
 
 typedef UInt64 (*StatsCallback)(String objectName, UInt32 index, String metricName, UInt64 arg);
@@ -71,14 +87,23 @@ class StatsManager
       StatsManager();
       ~StatsManager();
       void init();
+      void enableCallbacks();
       void recordStats(String prefix);
       void registerMetric(StatsMetricBase *metric);
+      void *allocCounters(core_id_t core_id, size_t size, size_t align);
       StatsMetricBase *getMetricObject(String objectName, UInt32 index, String metricName);
       void logTopology(String component, core_id_t core_id, core_id_t master_id);
       void logMarker(SubsecondTime time, core_id_t core_id, thread_id_t thread_id, UInt64 value0, UInt64 value1, const char * description)
       { logEvent(EVENT_MARKER, time, core_id, thread_id, value0, value1, description); }
       void logEvent(event_type_t event, SubsecondTime time, core_id_t core_id, thread_id_t thread_id, UInt64 value0, UInt64 value1, const char * description);
 
+      // Resume checkpoints (see CheckpointManager): the values of all non-computed metrics, by name,
+      // and a copy of sim.stats.sqlite3 whose snapshots and events are merged into the resumed run's database
+      void saveCheckpoint(CheckpointWriter &ckpt);
+      void loadCheckpoint(CheckpointReader &ckpt);
+      void saveDatabase(String filename);
+      void mergeDatabase(String filename);
+
    private:
       UInt64 m_keyid;
       UInt64 m_prefixnum;
@@ -88,6 +113,20 @@ class StatsManager
       sqlite3_stmt *m_stmt_insert_prefix;
       sqlite3_stmt *m_stmt_insert_value;
 
+      // When general/stats_binary is set, snapshots go to sim.stats.bin instead of the values table
+      StatsBinaryFile *m_binary;
+      struct Column
+      {
+         UInt64 nameid;
+         StatsMetricBase *metric;
+      };
+      std::vector<Column> m_columns;   // All metrics in registration order, the layout of a binary snapshot
+      UInt64 m_columns_written;        // Number of columns already described in sim.stats.bin
+      std::unordered_map<std::string, UInt64> m_binary_prefixes;
+
+      // When general/cpistack_file is set, CPI stack components are also aggregated into sim.cpistack
+      CpiStackFile *m_cpistack;
+
       // Use std::string here because String (__versa_string) does not provide a hash function for STL containers with gcc < 4.6
       typedef std::unordered_map<UInt64, StatsMetricBase *> StatsIndexList;
       typedef std::pair<UInt64, StatsIndexList> StatsMetricWithKey;
@@ -95,10 +134,37 @@ class StatsManager
       typedef std::unordered_map<std::string, StatsMetricList> StatsObjectList;
       StatsObjectList m_objects;
 
+      // When general/events_binary is set, events go to sim.events.bin instead of the event table
+      EventTrace *m_event_trace;
+
+      // Per-core storage for hot counters, see allocStatsCounters()
+      struct CounterBlock
+      {
+         char *next;
+         size_t left;
+      };
+      static const size_t COUNTER_CHUNK_SIZE = 4096;
+      std::unordered_map<core_id_t, CounterBlock> m_counter_blocks;
+      std::vector<void*> m_counter_chunks;
+      Lock m_counter_lock;
+      Lock m_register_lock;            // Metrics and topology can be registered by cores constructed in parallel
+
+      // When general/stats_sigusr1 is set, SIGUSR1 only sets a flag. Values are copied out at the next barrier,
+      // and written to sim.stats.sqlite3 by a background thread with its own database connection.
+      class SnapshotWriter;
+      SnapshotWriter *m_snapshot_writer;
+      volatile bool m_snapshot_requested;
+      UInt64 m_snapshot_count;
+
       static int __busy_handler(void* self, int count) { return ((StatsManager*)self)->busy_handler(count); }
       int busy_handler(int count);
 
       void recordMetricName(UInt64 keyId, std::string objectName, std::string metricName);
+      void recordStatsBinary(String prefix);
+
+      static SInt64 __hook_sigusr1(UInt64 arg, UInt64 val) { ((StatsManager*)arg)->m_snapshot_requested = true; return 0; }
+      static SInt64 __hook_periodic(UInt64 arg, UInt64 val) { ((StatsManager*)arg)->recordSnapshot(); return 0; }
+      void recordSnapshot();
 };
 
 template <class T> void registerStatsMetric(String objectName, UInt32 index, String metricName, T *metric)
@@ -107,6 +173,17 @@ template <class T> void registerStatsMetric(String objectName, UInt32 index, Str
 }
 
 
+// Storage for counters that are updated by a core's simulation thread on hot paths.
+// Counters of the same core are packed together into cache-line-aligned chunks that are never shared
+// with another core, so counters of neighbouring objects written by different host threads
+// don't cause false sharing. Storage is zero-initialized and lives until the end of the simulation
+// (destructors are not run), and can be registered with registerStatsMetric() as usual.
+template <class T> T *allocStatsCounters(core_id_t core_id)
+{
+   return new (Sim()->getStatsManager()->allocCounters(core_id, sizeof(T), alignof(T))) T();
+}
+
+
 class StatHist {
   private:
     static const int HIST_MAX = 20;
@@ -117,5 +194,6 @@ class StatHist {
     StatHist() : n(0), s(0), s2(0), min(0), max(0) { bzero(hist, sizeof(hist)); }
     StatHist & operator += (StatHist & stat);
     void update(unsigned long v);
+    unsigned long count() const { return n; }
     void print();
 };
@@ -0,0 +1,196 @@
+#include "stats_binary_file.h"
+#include "log.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <zlib.h>
+
+const char StatsBinaryFile::MAGIC[8] = { 'S', 'N', 'I', 'P', 'S', 'T', 'A', 'T' };
+
+StatsBinaryFile::StatsBinaryFile(String filename, bool async)
+   : m_fd(-1)
+   , m_base(NULL)
+   , m_mapped(0)
+   , m_size(0)
+   , m_last_keyframe(0)
+   , m_async(async)
+   , m_fill(0)
+   , m_drain(0)
+   , m_free(2)
+   , m_stop(false)
+   , m_thread(NULL)
+   , m_num_deltas(0)
+{
+   m_fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+   LOG_ASSERT_ERROR(m_fd >= 0, "Cannot create %s", filename.c_str());
+
+   reserve(sizeof(MAGIC) + sizeof(UInt64));
+   memcpy(m_base, MAGIC, sizeof(MAGIC));
+   *(UInt64*)(m_base + sizeof(MAGIC)) = VERSION;
+   m_size = sizeof(MAGIC) + sizeof(UInt64);
+
+   if (m_async)
+   {
+      m_thread = _Thread::create(this);
+      m_thread->run();
+   }
+}
+
+StatsBinaryFile::~StatsBinaryFile()
+{
+   if (m_thread)
+   {
+      // Wait until both buffers are written out, then stop the writer
+      m_free.wait();
+      m_free.wait();
+      m_stop = true;
+      m_full.signal();
+      m_done.wait();
+      delete m_thread;
+   }
+
+   writeIndex();
+
+   munmap(m_base, m_mapped);
+   if (ftruncate(m_fd, m_size) != 0)
+      LOG_PRINT_WARNING("Cannot truncate statistics file");
+   close(m_fd);
+}
+
+void
+StatsBinaryFile::reserve(UInt64 length)
+{
+   if (m_size + length <= m_mapped)
+      return;
+
+   UInt64 mapped = std::max(2 * m_mapped, (m_size + length + CHUNK_SIZE - 1) / CHUNK_SIZE * CHUNK_SIZE);
+   int res = ftruncate(m_fd, mapped);
+   LOG_ASSERT_ERROR(res == 0, "Cannot grow statistics file to %lu bytes", mapped);
+
+   void *base;
+   if (m_base)
+      base = mremap(m_base, m_mapped, mapped, MREMAP_MAYMOVE);
+   else
+      base = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+   LOG_ASSERT_ERROR(base != MAP_FAILED, "Cannot map statistics file");
+
+   m_base = (char*)base;
+   m_mapped = mapped;
+}
+
+void
+StatsBinaryFile::writeRecord(record_type_t type, const void *data, UInt64 length)
+{
+   UInt64 padded = (length + 7) & ~7ULL;
+   LOG_ASSERT_ERROR(padded <= UINT32_MAX, "Statistics record too large (%lu bytes)", length);
+
+   ScopedLock sl(m_lock);
+
+   reserve(sizeof(RecordHeader) + padded);
+
+   UInt64 offset = m_size;
+   if (type == RECORD_NAME || type == RECORD_COLUMNS || type == RECORD_PREFIX)
+   {
+      m_index_meta.push_back(offset);
+   }
+   else if (type == RECORD_SNAPSHOT || type == RECORD_SNAPSHOT_DELTA)
+   {
+      const UInt64 *snapshot = (const UInt64*)data;
+      if (type == RECORD_SNAPSHOT || !(snapshot[2] & FLAG_DELTA))
+         m_last_keyframe = offset;
+      m_index_snapshots.push_back(snapshot[0]);
+      m_index_snapshots.push_back(offset);
+      m_index_snapshots.push_back(m_last_keyframe);
+   }
+
+   RecordHeader *header = (RecordHeader*)(m_base + m_size);
+   header->type = type;
+   header->length = padded;
+   // The file was extended with zeros, so the padding is already in place
+   memcpy(header + 1, data, length);
+   m_size += sizeof(RecordHeader) + padded;
+}
+
+void
+StatsBinaryFile::writeIndex()
+{
+   std::vector<UInt64> index;
+   index.push_back(m_index_meta.size());
+   index.push_back(m_index_snapshots.size() / 3);
+   index.insert(index.end(), m_index_meta.begin(), m_index_meta.end());
+   index.insert(index.end(), m_index_snapshots.begin(), m_index_snapshots.end());
+
+   UInt64 offset = m_size;
+   writeRecord(RECORD_INDEX, index.data(), index.size() * sizeof(UInt64));
+   writeRecord(RECORD_INDEX_END, &offset, sizeof(offset));
+}
+
+UInt64 *
+StatsBinaryFile::beginSnapshot(UInt64 prefixid, UInt64 count)
+{
+   if (m_async)
+      m_free.wait();
+
+   std::vector<UInt64> &buffer = m_buffers[m_fill];
+   buffer.resize(2 + count);
+   buffer[0] = prefixid;
+   buffer[1] = count;
+   return &buffer[2];
+}
+
+void
+StatsBinaryFile::endSnapshot()
+{
+   if (m_async)
+   {
+      m_fill = (m_fill + 1) % 2;
+      m_full.signal();
+   }
+   else
+   {
+      writeRecord(RECORD_SNAPSHOT, m_buffers[0].data(), m_buffers[0].size() * sizeof(UInt64));
+   }
+}
+
+void
+StatsBinaryFile::writeSnapshotDelta(const std::vector<UInt64> &snapshot)
+{
+   UInt64 count = snapshot[1];
+   const UInt64 *values = &snapshot[2];
+
+   bool delta = m_num_deltas++ % KEYFRAME_INTERVAL != 0;
+   m_delta.resize(count);
+   for(UInt64 i = 0; i < count; ++i)
+      m_delta[i] = values[i] - (delta && i < m_previous.size() ? m_previous[i] : 0);
+   m_previous.assign(values, values + count);
+
+   uLongf compressed_length = compressBound(count * sizeof(UInt64));
+   m_compressed.resize(4 * sizeof(UInt64) + compressed_length);
+   int res = compress2(&m_compressed[4 * sizeof(UInt64)], &compressed_length, (const Bytef*)m_delta.data(), count * sizeof(UInt64), Z_BEST_SPEED);
+   LOG_ASSERT_ERROR(res == Z_OK, "Cannot compress statistics snapshot (%d)", res);
+
+   UInt64 *header = (UInt64*)&m_compressed[0];
+   header[0] = snapshot[0];
+   header[1] = count;
+   header[2] = delta ? FLAG_DELTA : 0;
+   header[3] = compressed_length;
+   writeRecord(RECORD_SNAPSHOT_DELTA, &m_compressed[0], 4 * sizeof(UInt64) + compressed_length);
+}
+
+void
+StatsBinaryFile::run()
+{
+   while(true)
+   {
+      m_full.wait();
+      if (m_stop)
+         break;
+
+      writeSnapshotDelta(m_buffers[m_drain]);
+      m_drain = (m_drain + 1) % 2;
+      m_free.signal();
+   }
+   m_done.signal();
+}
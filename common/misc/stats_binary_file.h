@@ -0,0 +1,111 @@
+#ifndef __STATS_BINARY_FILE_H
+#define __STATS_BINARY_FILE_H
+
+#include "fixed_types.h"
+#include "lock.h"
+#include "sem.h"
+#include "_thread.h"
+
+#include <vector>
+
+// Append-only, memory-mapped statistics file (sim.stats.bin, see general/stats_binary)
+//
+// The file starts with an 8-byte magic and a UInt64 version, followed by records.
+// Each record has a UInt32 type and the UInt32 length of its payload, which is zero-padded
+// to a multiple of 8 bytes. All values are in host (little-endian) byte order:
+//
+//   RECORD_NAME:     UInt64 nameid, objectname\0metricname\0
+//   RECORD_COLUMNS:  UInt64 first column, UInt64 count, count x (UInt32 nameid, SInt32 index)
+//   RECORD_PREFIX:   UInt64 prefixid, prefixname\0
+//   RECORD_SNAPSHOT: UInt64 prefixid, UInt64 count, count x UInt64 value
+//   RECORD_SNAPSHOT_DELTA: UInt64 prefixid, UInt64 count, UInt64 flags, UInt64 compressed length,
+//                    zlib-compressed count x UInt64 value; with FLAG_DELTA set, each value is
+//                    the difference (modulo 2^64) with the previous snapshot record
+//   RECORD_INDEX:    UInt64 meta count, UInt64 snapshot count, meta count x UInt64 offset of a name, column
+//                    or prefix record, snapshot count x (UInt64 prefixid, UInt64 offset, UInt64 offset of the
+//                    keyframe it is decoded from)
+//   RECORD_INDEX_END: UInt64 offset of the RECORD_INDEX, always the last 16 bytes of the file
+//
+// Columns are metrics in registration order; a snapshot holds the value of columns 0 .. count-1.
+// Name, column and prefix records are only written when something new was registered or used.
+// The file is grown in chunks and truncated to its used size on close. After a crash the tail
+// is zero-filled, which readers see as a record of type 0 (end of file).
+// On close, an index of all records is appended so readers can find a snapshot, or a single metric's values
+// over time, without scanning the file. Record offsets point at the record header. Files without an index
+// (after a crash) can still be read by scanning.
+//
+// In asynchronous mode (general/stats_binary_async), snapshots are written as RECORD_SNAPSHOT_DELTA
+// by a background thread: the simulation thread only fills one of two snapshot buffers, and only
+// waits when the writer is still busy with both.
+
+class StatsBinaryFile : public Runnable
+{
+   public:
+      enum record_type_t {
+         RECORD_END = 0,
+         RECORD_NAME,
+         RECORD_COLUMNS,
+         RECORD_PREFIX,
+         RECORD_SNAPSHOT,
+         RECORD_SNAPSHOT_DELTA,
+         RECORD_INDEX,
+         RECORD_INDEX_END,
+      };
+
+      enum {
+         FLAG_DELTA = 1,
+      };
+
+      static const char MAGIC[8];
+      static const UInt64 VERSION = 1;
+
+      StatsBinaryFile(String filename, bool async);
+      ~StatsBinaryFile();
+
+      void writeRecord(record_type_t type, const void *data, UInt64 length);
+
+      // Returns a buffer for count values, to be filled in before calling endSnapshot()
+      UInt64 *beginSnapshot(UInt64 prefixid, UInt64 count);
+      void endSnapshot();
+
+   private:
+      struct RecordHeader
+      {
+         UInt32 type;
+         UInt32 length;
+      };
+
+      static const UInt64 CHUNK_SIZE = 16 << 20;
+      static const UInt64 KEYFRAME_INTERVAL = 64; // Maximum number of deltas to apply to find a snapshot's values
+
+      int m_fd;
+      char *m_base;
+      UInt64 m_mapped;
+      UInt64 m_size;
+      Lock m_lock; // Protects the mapping, when records are written by both the simulation and writer thread
+
+      // RECORD_INDEX contents, collected as records are written
+      std::vector<UInt64> m_index_meta;
+      std::vector<UInt64> m_index_snapshots;
+      UInt64 m_last_keyframe;
+
+      const bool m_async;
+      std::vector<UInt64> m_buffers[2]; // prefixid, count, values
+      UInt32 m_fill, m_drain;
+      Semaphore m_free, m_full, m_done;
+      bool m_stop;
+      _Thread *m_thread;
+
+      // Writer thread state
+      std::vector<UInt64> m_previous;
+      std::vector<UInt64> m_delta;
+      std::vector<UInt8> m_compressed;
+      UInt64 m_num_deltas;
+
+      void reserve(UInt64 length);
+      void writeIndex();
+      void writeSnapshotDelta(const std::vector<UInt64> &snapshot);
+      void run();
+};
+
+#endif // __STATS_BINARY_FILE_H
@@ -202,6 +202,8 @@ public:
    {
       return (lhs.m_time + ((rhs.m_time/2) + 1)) / rhs.m_time;
    }
+   // Same as above for a clock period, using its precomputed reciprocal instead of a division
+   static inline uint64_t divideRounded(const SubsecondTime& lhs, const ComponentPeriod& rhs);
 
 private:
    friend class ComponentPeriod;
@@ -298,6 +300,7 @@ public:
    // Public constructors
    ComponentPeriod(const ComponentPeriod &_p)
       : m_period(_p.m_period)
+      , m_reciprocal(_p.m_reciprocal)
    {}
    // Only construct ComponentPeriods from this function
    static ComponentPeriod fromFreqHz(uint64_t freq_in_hz)
@@ -310,6 +313,7 @@ public:
    void setPeriodFromFreqHz(uint64_t freq_in_hz)
    {
       m_period = SubsecondTime::SEC() / freq_in_hz;
+      updateReciprocal();
    }
 
    SubsecondTime getPeriod(void) const { return m_period; }
@@ -319,9 +323,20 @@ public:
       return SubsecondTime::US_1 / m_period.m_time;
    }
 
+   // Number of whole periods in time, equal to time / period but without a hardware division:
+   //  the estimate from the reciprocal is at most one too small, which a single correction step fixes
+   uint64_t divide(const SubsecondTime &time) const
+   {
+      uint64_t cycles = (unsigned __int128)time.m_time * m_reciprocal >> 64;
+      if (time.m_time - cycles * m_period.m_time >= m_period.m_time)
+         ++cycles;
+      return cycles;
+   }
+
    ComponentPeriod& operator=(const ComponentPeriod &rhs)
    {
       m_period = rhs.m_period;
+      m_reciprocal = rhs.m_reciprocal;
       return *this;
    }
 
@@ -329,6 +344,7 @@ public:
    ComponentPeriod& operator*=(uint64_t rhs)
    {
       m_period *= rhs;
+      updateReciprocal();
       return *this;
    }
 
@@ -344,17 +360,34 @@ private:
    friend inline std::ostream &operator<<(std::ostream &os, const ComponentPeriod &period);
 
    ComponentPeriod()
+      : m_reciprocal(0)
    {}
    ComponentPeriod(uint64_t _time)
       : m_period(_time)
-   {}
+   {
+      updateReciprocal();
+   }
    ComponentPeriod(SubsecondTime &_time)
       : m_period(_time)
-   {}
+   {
+      updateReciprocal();
+   }
+
+   // floor((2^64 - 1) / period), recomputed only when the period changes (i.e., on DVFS transitions)
+   void updateReciprocal()
+   {
+      m_reciprocal = m_period.m_time ? 0xffffffffffffffffULL / m_period.m_time : 0;
+   }
 
    SubsecondTime m_period;
+   uint64_t m_reciprocal;
 };
 
+inline uint64_t SubsecondTime::divideRounded(const SubsecondTime& lhs, const ComponentPeriod& rhs)
+{
+   return rhs.divide(SubsecondTime(lhs.m_time + ((rhs.getPeriod().m_time/2) + 1)));
+}
+
 inline ComponentPeriod operator*(ComponentPeriod lhs, uint64_t rhs)
 {
    return (lhs *= rhs);
@@ -383,7 +416,7 @@ public:
    UInt64 subsecondTimeToCycles(SubsecondTime time) const
    {
       // Get the number of native cycles for this component
-      return (time / static_cast<const SubsecondTime>(*m_period)).getInternalDataForced();
+      return m_period->divide(time);
    }
 private:
    SubsecondTimeCycleConverter()
@@ -21,6 +21,8 @@ class Timer
       /** Return elapsed time in nanoseconds */
       UInt64 getTime(void);
       static UInt64 now(void);
+      /** Convert a number of rdtsc() ticks into nanoseconds (a Timer must have been constructed before) */
+      static UInt64 ticksToNs(UInt64 ticks) { return RdtscSpeed::floor(SInt64(ticks) / rdtsc_speed); }
 
    private:
       UInt64 t_start;
@@ -0,0 +1,151 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "fixed_types.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Hierarchical timer wheel of (tick, value) items, used for the native timers in HooksManager.
+// Level l has 64 slots of 64^l ticks each, relative to the current tick: an item is kept at the highest level
+// in which its tick differs from the current one, items further out than all levels go into an overflow list.
+// advance() only looks at the slots of the levels whose window it moves out of, so its cost depends on the
+// number of levels crossed and items fired, not on the number of ticks skipped.
+
+template <typename V> class TimerWheel
+{
+   private:
+      static const UInt32 LEVELS = 4;
+      static const UInt32 SLOT_BITS = 6;
+      static const UInt32 SLOTS = 1 << SLOT_BITS;
+      typedef std::pair<UInt64, V> Item;
+
+      std::vector<Item> m_slots[LEVELS][SLOTS];
+      UInt64 m_occupied[LEVELS]; // Bitmap of non-empty slots per level
+      std::vector<Item> m_overflow;
+      std::vector<Item> m_due;   // Items inserted at or before the current tick, fired by the next advance()
+      std::vector<Item> m_collected;
+      UInt64 m_now;
+      UInt64 m_size;
+
+      void place(const Item &item)
+      {
+         if (item.first <= m_now)
+         {
+            m_due.push_back(item);
+            return;
+         }
+         UInt32 level = (63 - __builtin_clzll(item.first ^ m_now)) / SLOT_BITS;
+         if (level >= LEVELS)
+         {
+            m_overflow.push_back(item);
+         }
+         else
+         {
+            UInt32 slot = (item.first >> (level * SLOT_BITS)) & (SLOTS - 1);
+            m_slots[level][slot].push_back(item);
+            m_occupied[level] |= 1ULL << slot;
+         }
+      }
+
+      void collect(std::vector<Item> &items)
+      {
+         m_collected.insert(m_collected.end(), items.begin(), items.end());
+         items.clear();
+      }
+
+      void collectLevel(UInt32 level, UInt64 mask)
+      {
+         for(UInt64 occupied = m_occupied[level] & mask; occupied; occupied &= occupied - 1)
+            collect(m_slots[level][__builtin_ctzll(occupied)]);
+         m_occupied[level] &= ~mask;
+      }
+
+      static bool earlier(const Item &a, const Item &b) { return a.first < b.first; }
+
+   public:
+      TimerWheel(UInt64 now = 0)
+         : m_now(now)
+         , m_size(0)
+      {
+         std::fill(m_occupied, m_occupied + LEVELS, 0);
+      }
+
+      UInt64 now() const { return m_now; }
+      UInt64 size() const { return m_size; }
+      bool empty() const { return m_size == 0; }
+
+      // Tick of the earliest item, or UINT64_MAX when empty. Items at a level are all later than those at lower
+      // levels, and within a level the slot tells the order, so only one slot (or the overflow list) is scanned.
+      UInt64 next() const
+      {
+         if (!m_due.empty())
+            return m_now;
+         const std::vector<Item> *items = &m_overflow;
+         for(UInt32 level = 0; level < LEVELS; ++level)
+         {
+            if (m_occupied[level])
+            {
+               items = &m_slots[level][__builtin_ctzll(m_occupied[level])];
+               break;
+            }
+         }
+         UInt64 tick = UINT64_MAX;
+         for(typename std::vector<Item>::const_iterator it = items->begin(); it != items->end(); ++it)
+            tick = std::min(tick, it->first);
+         return tick;
+      }
+
+      void insert(UInt64 tick, const V &value)
+      {
+         place(Item(tick, value));
+         ++m_size;
+      }
+
+      // Move the current tick forward to <now>, calling func(tick, value) for all items due by then, in order of their tick.
+      // func may insert new items.
+      template <typename F> void advance(UInt64 now, F func)
+      {
+         m_collected.clear();
+         collect(m_due);
+
+         if (now > m_now)
+         {
+            UInt32 level = (63 - __builtin_clzll(now ^ m_now)) / SLOT_BITS;
+            if (level == 0)
+            {
+               // Still in the same window of level 0: only the slots we pass over are due
+               UInt64 from = (m_now & (SLOTS - 1)) + 1, to = now & (SLOTS - 1);
+               collectLevel(0, (to == SLOTS - 1 ? ~0ULL : (1ULL << (to + 1)) - 1) & ~((1ULL << from) - 1));
+            }
+            else
+            {
+               // Moving into a new window of <level>: everything below it, and the part of <level> we pass over,
+               // has to be redistributed relative to the new tick. Collect the whole level, the rest goes back in below.
+               for(UInt32 l = 0; l <= std::min(level, LEVELS - 1); ++l)
+                  collectLevel(l, ~0ULL);
+               if (level >= LEVELS)
+                  collect(m_overflow);
+            }
+            m_now = now;
+         }
+
+         std::vector<Item> fired;
+         for(typename std::vector<Item>::iterator it = m_collected.begin(); it != m_collected.end(); ++it)
+         {
+            if (it->first <= m_now)
+               fired.push_back(*it);
+            else
+               place(*it);
+         }
+         m_collected.clear();
+
+         std::stable_sort(fired.begin(), fired.end(), earlier);
+         m_size -= fired.size();
+         for(typename std::vector<Item>::iterator it = fired.begin(); it != fired.end(); ++it)
+            func(it->first, it->second);
+      }
+};
+
+#endif // TIMER_WHEEL_H
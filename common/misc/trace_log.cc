@@ -0,0 +1,204 @@
+#include "trace_log.h"
+#include "log.h"
+#include "simulator.h"
+#include "hooks_manager.h"
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <boost/algorithm/string.hpp>
+
+static const char *module_names[] = {
+   "general", "system", "core", "cache", "directory", "dram", "network", "sync", "scheduler",
+};
+static_assert(sizeof(module_names) / sizeof(module_names[0]) == (size_t)TraceModule::NUM_MODULES,
+              "module_names must have an entry for each TraceModule");
+
+thread_local TraceLog::Buffer *TraceLog::t_buffer = NULL;
+TraceLog *TraceLog::g_singleton = NULL;
+
+TraceSite::TraceSite(TraceModule _module, TraceLevel _level, const char *_file, UInt32 _line, const char *_format, UInt32 _num_args)
+   : enabled(false)
+   , module(_module)
+   , level(_level)
+   , file(_file)
+   , line(_line)
+   , format(_format)
+   , num_args(_num_args)
+   , id(0)
+{
+   TraceLog::registerSite(this);
+}
+
+std::vector<TraceSite*> &TraceLog::getSites()
+{
+   // Sites can be constructed before the trace log is initialized (or after it is gone)
+   static std::vector<TraceSite*> sites;
+   return sites;
+}
+
+Lock &TraceLog::getSitesLock()
+{
+   static Lock lock;
+   return lock;
+}
+
+void TraceLog::registerSite(TraceSite *site)
+{
+   ScopedLock sl(getSitesLock());
+   site->id = getSites().size();
+   getSites().push_back(site);
+   if (g_singleton && g_singleton->isSelected(site))
+      site->enabled.store(true, std::memory_order_relaxed);
+}
+
+const char *TraceLog::getModuleName(TraceModule module)
+{
+   return module_names[(UInt32)module];
+}
+
+void TraceLog::init(String filename, String modules, UInt32 level)
+{
+   ScopedLock sl(getSitesLock());
+   g_singleton = new TraceLog(filename, modules, level);
+
+   for(std::vector<TraceSite*>::iterator it = getSites().begin(); it != getSites().end(); ++it)
+      (*it)->enabled.store(g_singleton->isSelected(*it), std::memory_order_relaxed);
+}
+
+void TraceLog::enableCallbacks()
+{
+   if (g_singleton)
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_SIGUSR1, TraceLog::hook_sigusr1, 0);
+}
+
+void TraceLog::fini()
+{
+   TraceLog *trace_log;
+   {
+      ScopedLock sl(getSitesLock());
+      for(std::vector<TraceSite*>::iterator it = getSites().begin(); it != getSites().end(); ++it)
+         (*it)->enabled.store(false, std::memory_order_relaxed);
+      trace_log = g_singleton;
+      g_singleton = NULL;
+   }
+
+   // Writes out the trace, which needs the sites lock
+   if (trace_log)
+      delete trace_log;
+}
+
+void TraceLog::dump()
+{
+   if (g_singleton)
+   {
+      ScopedLock sl(g_singleton->m_lock);
+      g_singleton->writeTrace();
+   }
+}
+
+void TraceLog::setEnabled(TraceModule module, TraceLevel level, bool enabled)
+{
+   ScopedLock sl(getSitesLock());
+   if (!g_singleton)
+      return;
+
+   for(std::vector<TraceSite*>::iterator it = getSites().begin(); it != getSites().end(); ++it)
+      if ((*it)->module == module && (*it)->level <= level)
+         (*it)->enabled.store(enabled, std::memory_order_relaxed);
+}
+
+TraceLog::TraceLog(String filename, String modules, UInt32 level)
+   : m_filename(filename)
+   , m_level(level)
+{
+   std::vector<String> selected;
+   boost::split(selected, modules, boost::is_any_of(" ,"), boost::token_compress_on);
+   for(UInt32 i = 0; i < (UInt32)TraceModule::NUM_MODULES; ++i)
+      m_modules[i] = modules.empty();
+   for(std::vector<String>::iterator it = selected.begin(); it != selected.end(); ++it)
+   {
+      if (it->empty())
+         continue;
+      UInt32 i;
+      for(i = 0; i < (UInt32)TraceModule::NUM_MODULES; ++i)
+         if (*it == module_names[i])
+            break;
+      LOG_ASSERT_ERROR(i < (UInt32)TraceModule::NUM_MODULES, "Invalid trace module %s in log/trace/modules", it->c_str());
+      m_modules[i] = true;
+   }
+}
+
+TraceLog::~TraceLog()
+{
+   writeTrace();
+   for(std::vector<Buffer*>::iterator it = m_buffers.begin(); it != m_buffers.end(); ++it)
+   {
+      delete [] (*it)->events;
+      delete *it;
+   }
+}
+
+bool TraceLog::isSelected(const TraceSite *site) const
+{
+   return m_modules[(UInt32)site->module] && (UInt32)site->level <= m_level;
+}
+
+TraceLog::Buffer *TraceLog::newBuffer()
+{
+   Buffer *buffer = new Buffer();
+   buffer->thread_id = syscall(__NR_gettid);
+   buffer->count = 0;
+   buffer->events = new event_t[BUFFER_SIZE];
+
+   ScopedLock sl(g_singleton->m_lock);
+   g_singleton->m_buffers.push_back(buffer);
+   t_buffer = buffer;
+   return buffer;
+}
+
+// sim.trace: "SNIPTRCE", UInt64 version, UInt64 rdtsc at writing time, UInt64 number of modules, module names\0,
+// UInt64 number of sites, for each site: UInt32 module, level, line, number of arguments, file\0, format\0,
+// UInt64 number of buffers, for each buffer: UInt64 host thread id, number of events,
+// and its last events in order (UInt64 time, UInt32 site, UInt32 reserved, UInt64 args[4])
+void TraceLog::writeTrace()
+{
+   FILE *fp = fopen(m_filename.c_str(), "w");
+   if (!fp)
+   {
+      // Can be called when handling an error, so don't raise another one
+      LOG_PRINT_WARNING("Cannot write %s", m_filename.c_str());
+      return;
+   }
+
+   UInt64 header[4] = { 0, 1, rdtsc(), (UInt64)TraceModule::NUM_MODULES };
+   memcpy(&header[0], "SNIPTRCE", 8);
+   fwrite(header, sizeof(header), 1, fp);
+   for(UInt32 i = 0; i < (UInt32)TraceModule::NUM_MODULES; ++i)
+      fwrite(module_names[i], strlen(module_names[i]) + 1, 1, fp);
+
+   {
+      ScopedLock sl(getSitesLock());
+      UInt64 num_sites = getSites().size();
+      fwrite(&num_sites, sizeof(num_sites), 1, fp);
+      for(std::vector<TraceSite*>::iterator it = getSites().begin(); it != getSites().end(); ++it)
+      {
+         UInt32 site[4] = { (UInt32)(*it)->module, (UInt32)(*it)->level, (*it)->line, (*it)->num_args };
+         fwrite(site, sizeof(site), 1, fp);
+         fwrite((*it)->file, strlen((*it)->file) + 1, 1, fp);
+         fwrite((*it)->format, strlen((*it)->format) + 1, 1, fp);
+      }
+   }
+
+   UInt64 num_buffers = m_buffers.size();
+   fwrite(&num_buffers, sizeof(num_buffers), 1, fp);
+   for(std::vector<Buffer*>::iterator it = m_buffers.begin(); it != m_buffers.end(); ++it)
+   {
+      UInt64 count = (*it)->count, first = count > BUFFER_SIZE ? count - BUFFER_SIZE : 0;
+      UInt64 info[2] = { (*it)->thread_id, count - first };
+      fwrite(info, sizeof(info), 1, fp);
+      for(UInt64 i = first; i < count; ++i)
+         fwrite(&(*it)->events[i % BUFFER_SIZE], sizeof(event_t), 1, fp);
+   }
+
+   fclose(fp);
+}
@@ -0,0 +1,205 @@
+#ifndef __TRACE_LOG_H
+#define __TRACE_LOG_H
+
+#include "fixed_types.h"
+#include "lock.h"
+
+#include <atomic>
+#include <vector>
+#include <type_traits>
+#include <tuple>
+#include <string.h>
+
+// Low-overhead binary event tracing
+//
+// TRACE(module, level, format, args...) records an event with up to 4 integer, floating point or pointer arguments.
+// Sites above the module's compile-time level (TRACE_LEVEL, or TRACE_LEVEL_<module> for one module) are removed
+// by the compiler. When tracing is off, the remaining sites only test their static-initialization guard
+// and do a relaxed load of their own enable flag.
+// Enabled sites (log/trace/enabled, filtered by log/trace/modules and log/trace/level) append the raw arguments
+// to a per-thread circular buffer, without formatting and without locking. At the end of the simulation
+// (or on SIGUSR1), all buffers are written to sim.trace, which tools/decode_trace.py turns into text.
+// Like for CircularLog, strings can't be traced: only the value of a pointer argument is recorded.
+
+enum class TraceModule : UInt32
+{
+   GENERAL,
+   SYSTEM,
+   CORE,
+   CACHE,
+   DIRECTORY,
+   DRAM,
+   NETWORK,
+   SYNC,
+   SCHEDULER,
+   NUM_MODULES
+};
+
+enum class TraceLevel : UInt32
+{
+   NONE,
+   INFO,
+   DEBUG,
+   VERBOSE,
+};
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL 1 // INFO
+#endif
+
+#ifndef TRACE_LEVEL_GENERAL
+#define TRACE_LEVEL_GENERAL TRACE_LEVEL
+#endif
+#ifndef TRACE_LEVEL_SYSTEM
+#define TRACE_LEVEL_SYSTEM TRACE_LEVEL
+#endif
+#ifndef TRACE_LEVEL_CORE
+#define TRACE_LEVEL_CORE TRACE_LEVEL
+#endif
+#ifndef TRACE_LEVEL_CACHE
+#define TRACE_LEVEL_CACHE TRACE_LEVEL
+#endif
+#ifndef TRACE_LEVEL_DIRECTORY
+#define TRACE_LEVEL_DIRECTORY TRACE_LEVEL
+#endif
+#ifndef TRACE_LEVEL_DRAM
+#define TRACE_LEVEL_DRAM TRACE_LEVEL
+#endif
+#ifndef TRACE_LEVEL_NETWORK
+#define TRACE_LEVEL_NETWORK TRACE_LEVEL
+#endif
+#ifndef TRACE_LEVEL_SYNC
+#define TRACE_LEVEL_SYNC TRACE_LEVEL
+#endif
+#ifndef TRACE_LEVEL_SCHEDULER
+#define TRACE_LEVEL_SCHEDULER TRACE_LEVEL
+#endif
+
+constexpr UInt32 trace_compiled_levels[] = {
+   TRACE_LEVEL_GENERAL, TRACE_LEVEL_SYSTEM, TRACE_LEVEL_CORE, TRACE_LEVEL_CACHE, TRACE_LEVEL_DIRECTORY,
+   TRACE_LEVEL_DRAM, TRACE_LEVEL_NETWORK, TRACE_LEVEL_SYNC, TRACE_LEVEL_SCHEDULER,
+};
+static_assert(sizeof(trace_compiled_levels) / sizeof(trace_compiled_levels[0]) == (size_t)TraceModule::NUM_MODULES,
+              "trace_compiled_levels must have an entry for each TraceModule");
+
+constexpr bool traceCompiled(TraceModule module, TraceLevel level)
+{
+   return (UInt32)level <= trace_compiled_levels[(UInt32)module];
+}
+
+class TraceSite
+{
+   public:
+      TraceSite(TraceModule module, TraceLevel level, const char *file, UInt32 line, const char *format, UInt32 num_args);
+
+      std::atomic<bool> enabled;
+      const TraceModule module;
+      const TraceLevel level;
+      const char * const file;
+      const UInt32 line;
+      const char * const format;
+      const UInt32 num_args;
+      UInt32 id;
+};
+
+class TraceLog
+{
+   public:
+      static const UInt32 MAX_ARGS = 4;
+
+      static void init(String filename, String modules, UInt32 level);
+      static void enableCallbacks();
+      static void fini();
+      static void dump();
+
+      // Enable or disable all compiled-in sites of a module up to the given level
+      static void setEnabled(TraceModule module, TraceLevel level, bool enabled);
+
+      static const char *getModuleName(TraceModule module);
+
+      static void registerSite(TraceSite *site);
+
+      template <typename... Args> static void record(TraceSite &site, Args... args)
+      {
+         static_assert(sizeof...(args) <= MAX_ARGS, "TRACE supports at most 4 arguments");
+         Buffer *buffer = t_buffer ? t_buffer : newBuffer();
+         event_t &event = buffer->events[buffer->count++ % BUFFER_SIZE];
+         event.time = rdtsc();
+         event.site = site.id;
+         UInt32 i = 0;
+         ((event.args[i++] = traceArg(args)), ...);
+         (void)i;
+      }
+
+   private:
+      typedef struct {
+         UInt64 time;
+         UInt32 site;
+         UInt32 reserved;
+         UInt64 args[MAX_ARGS];
+      } event_t;
+
+      struct Buffer
+      {
+         UInt64 thread_id;
+         UInt64 count;
+         event_t *events;
+      };
+
+      static const UInt64 BUFFER_SIZE = 64*1024;
+
+      static thread_local Buffer *t_buffer;
+      static TraceLog *g_singleton;
+
+      TraceLog(String filename, String modules, UInt32 level);
+      ~TraceLog();
+
+      static Buffer *newBuffer();
+      static SInt64 hook_sigusr1(UInt64, UInt64) { dump(); return 0; }
+
+      static std::vector<TraceSite*> &getSites();
+      static Lock &getSitesLock();
+      bool isSelected(const TraceSite *site) const;
+      void writeTrace();
+
+      template <typename T> static UInt64 traceArg(T value)
+      {
+         static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                       "TRACE arguments must be integers, floating point values or pointers");
+         if constexpr (std::is_floating_point<T>::value)
+         {
+            double d = value;
+            UInt64 bits;
+            memcpy(&bits, &d, sizeof(bits));
+            return bits;
+         }
+         else if constexpr (std::is_pointer<T>::value)
+            return (UInt64)(uintptr_t)value;
+         else
+            return (UInt64)value;
+      }
+
+      // Inlined, unlike ::rdtsc() from timer.h
+      static UInt64 rdtsc() { UInt32 lo, hi; __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi)); return (UInt64(hi) << 32) | lo; }
+
+      const String m_filename;
+      bool m_modules[(UInt32)TraceModule::NUM_MODULES];
+      const UInt32 m_level;
+      std::vector<Buffer*> m_buffers;
+      Lock m_lock;
+};
+
+#define __TRACE_NUM_ARGS(...) std::tuple_size<decltype(std::make_tuple(__VA_ARGS__))>::value
+
+#define TRACE(module, level, format, ...)                                                          \
+   do {                                                                                            \
+      if (traceCompiled(TraceModule::module, TraceLevel::level))                                   \
+      {                                                                                            \
+         static TraceSite __trace_site(TraceModule::module, TraceLevel::level, __FILE__, __LINE__, \
+                                       format, __TRACE_NUM_ARGS(__VA_ARGS__));                     \
+         if (__builtin_expect(__trace_site.enabled.load(std::memory_order_relaxed), 0))            \
+            TraceLog::record(__trace_site __VA_OPT__(,) __VA_ARGS__);                              \
+      }                                                                                            \
+   } while(0)
+
+#endif // __TRACE_LOG_H
@@ -1,4 +1,5 @@
 #include <string.h>
+#include <algorithm>
 
 #include "transport.h"
 #include "core.h"
@@ -10,6 +11,8 @@
 #include "subsecond_time.h"
 #include "performance_model.h"
 #include "instruction.h"
+#include "config.hpp"
+#include "self_profiler.h"
 
 // FIXME: Rework netCreateBuf and netExPacket. We don't need to
 // duplicate the sender/receiver info the packet. This should be known
@@ -19,6 +22,8 @@
 
 Network::Network(Core *core)
       : _core(core)
+      , _netQueueSeq(0)
+      , _zero_copy(Sim()->getCfg()->getBool("network/zero_copy"))
 {
    LOG_ASSERT_ERROR(sizeof(g_type_to_static_network_map) / sizeof(EStaticNetwork) == NUM_PACKET_TYPES,
                     "Static network type map has incorrect number of entries.");
@@ -78,7 +83,8 @@ void Network::netPullFromTransport()
    {
       LOG_PRINT("Entering netPullFromTransport");
 
-      NetPacket packet(_transport->recv());
+      Byte *buffer = _transport->recv();
+      NetPacket packet = _zero_copy ? NetPacket::fromBuffer(buffer) : NetPacket(buffer);
 
       LOG_PRINT("Pull packet : type %i, from %i, time %s", (SInt32)packet.type, packet.sender, itostr(packet.time).c_str());
       assert(0 <= packet.sender && packet.sender < _numMod);
@@ -95,8 +101,7 @@ void Network::netPullFromTransport()
          // if this isn't a broadcast message, then we shouldn't process it further
          if (packet.receiver != NetPacket::BROADCAST)
          {
-            if (packet.length > 0)
-               delete [] (Byte*) packet.data;
+            releasePacket(packet, buffer);
             continue;
          }
       }
@@ -117,8 +122,7 @@ void Network::netPullFromTransport()
 
          callback(_callbackObjs[packet.type], packet);
 
-         if (packet.length > 0)
-            delete [] (Byte*) packet.data;
+         releasePacket(packet, buffer);
       }
 
       // synchronous I/O support
@@ -126,10 +130,26 @@ void Network::netPullFromTransport()
       {
          LOG_PRINT("Enqueuing packet : type %i, from %i, to %i, core_id %i, time %s.",
                (SInt32)packet.type, packet.sender, packet.receiver, _core->getId(), itostr(packet.time).c_str());
+         if (_zero_copy)
+         {
+            // netRecv() hands out packets that own their payload, detach it from the transport buffer
+            if (packet.length > 0)
+            {
+               Byte *data = new Byte[packet.length];
+               memcpy(data, packet.data, packet.length);
+               packet.data = data;
+            }
+            Transport::getSingleton()->freeBuffer(buffer);
+         }
          _netQueueLock.acquire();
-         _netQueue.push_back(packet);
+         QueuedPacket queued = { packet, _netQueueSeq++ };
+         _netQueue[packet.type][packet.sender].insert(std::make_pair(SubsecondTime(packet.time), queued));
+         // Wake up only the receivers that are waiting for this packet.
+         // Do this while holding the queue lock, a waiter that timed out may otherwise have gone already
+         for (std::list<Waiter*>::iterator it = _netQueueWaiters.begin(); it != _netQueueWaiters.end(); ++it)
+            if ((*it)->matches(packet))
+               (*it)->cond.signal();
          _netQueueLock.release();
-         _netQueueCond.broadcast();
       }
    }
    while (_transport->query());
@@ -147,8 +167,42 @@ NetworkModel* Network::getNetworkModelFromPacketType(PacketType packet_type)
    return _models[g_type_to_static_network_map[packet_type]];
 }
 
+void Network::releasePacket(NetPacket& packet, Byte *buffer)
+{
+   if (_zero_copy)
+      Transport::getSingleton()->freeBuffer(buffer);
+   else if (packet.length > 0)
+      delete [] (Byte*) packet.data;
+}
+
+Byte* Network::allocPayload(UInt32 length)
+{
+   if (_zero_copy)
+      // Leave room for the NetPacket header so the whole message can be handed to the transport as-is
+      return Transport::getSingleton()->allocBuffer(sizeof(NetPacket) + length) + sizeof(NetPacket);
+   else
+      return new Byte[length];
+}
+
+SInt32 Network::netSendPayload(NetPacket& packet)
+{
+   if (_zero_copy)
+      return sendPacket(packet, true);
+
+   SInt32 length = sendPacket(packet, false);
+   delete [] (Byte*) packet.data;
+   return length;
+}
+
 SInt32 Network::netSend(NetPacket& packet)
 {
+   return sendPacket(packet, false);
+}
+
+SInt32 Network::sendPacket(NetPacket& packet, bool zero_copy)
+{
+   SELF_PROFILE(NETWORK);
+
    assert(packet.type >= 0 && packet.type < NUM_PACKET_TYPES);
 
    NetworkModel *model = _models[g_type_to_static_network_map[packet.type]];
@@ -158,7 +212,14 @@ SInt32 Network::netSend(NetPacket& packet)
    std::vector<NetworkModel::Hop> hopVec;
    model->routePacket(packet, hopVec);
 
-   Byte *buffer = packet.makeBuffer();
+   Byte *buffer;
+   if (zero_copy)
+   {
+      buffer = (Byte*) packet.data - sizeof(NetPacket);
+      memcpy(buffer, &packet, sizeof(NetPacket));
+   }
+   else
+      buffer = packet.makeBuffer();
    SubsecondTime start_time = packet.time;
 
    for (UInt32 i = 0; i < hopVec.size(); i++)
@@ -196,182 +257,134 @@ SInt32 Network::netSend(NetPacket& packet)
       buff_pkt->time = hopVec[i].time;
       buff_pkt->receiver = hopVec[i].final_dest;
 
-      _transport->send(hopVec[i].next_dest, buffer, packet.bufferSize());
+      if (zero_copy && i == hopVec.size() - 1)
+      {
+         // Last hop gets our buffer, earlier ones (broadcasts) need their own copy
+         _transport->sendBuffer(hopVec[i].next_dest, buffer, packet.bufferSize());
+         buffer = NULL;
+      }
+      else
+         _transport->send(hopVec[i].next_dest, buffer, packet.bufferSize());
 
       LOG_PRINT("Sent packet");
    }
 
-   delete [] buffer;
+   if (buffer)
+      Transport::getSingleton()->freeBuffer(buffer);
 
    return packet.length;
 }
 
-// Stupid helper class to eliminate special cases for empty
-// sender/type vectors in a NetMatch
-class NetRecvIterator
+bool Network::Waiter::matches(const NetPacket &packet) const
 {
-   public:
-      NetRecvIterator(UInt32 i)
-            : _mode(INT)
-            , _max(i)
-            , _i(0)
-      {
-      }
-      NetRecvIterator(const std::vector<SInt32> &v)
-            : _mode(SENDER_VECTOR)
-            , _senders(&v)
-            , _i(0)
-      {
-      }
-      NetRecvIterator(const std::vector<PacketType> &v)
-            : _mode(TYPE_VECTOR)
-            , _types(&v)
-            , _i(0)
-      {
-      }
+   return (match.senders.empty() || std::find(match.senders.begin(), match.senders.end(), packet.sender) != match.senders.end())
+       && (match.types.empty() || std::find(match.types.begin(), match.types.end(), packet.type) != match.types.end());
+}
 
-      inline UInt32 get()
-      {
-         switch (_mode)
-         {
-         case INT:
-            return _i;
-         case SENDER_VECTOR:
-            return (UInt32)_senders->at(_i);
-         case TYPE_VECTOR:
-            return (UInt32)_types->at(_i);
-         default:
-            assert(false);
-            return (UInt32)-1;
-         };
-      }
+// Find the earliest pending packet that matches, only looking at the buckets of the matching types and senders.
+// Must be called with _netQueueLock held.
+bool Network::findPacket(const NetMatch &match, PacketType &type, SenderQueues::iterator &bucket)
+{
+   const QueuedPacket *best = NULL;
 
-      inline Boolean done()
+   auto consider = [&](PacketType t, SenderQueues::iterator it)
+   {
+      const QueuedPacket &candidate = it->second.begin()->second;
+      if (!best || candidate.packet.time < best->packet.time
+          || (candidate.packet.time == best->packet.time && candidate.seq < best->seq))
       {
-         switch (_mode)
-         {
-         case INT:
-            return _i >= _max;
-         case SENDER_VECTOR:
-            return _i >= _senders->size();
-         case TYPE_VECTOR:
-            return _i >= _types->size();
-         default:
-            assert(false);
-            return true;
-         };
+         best = &candidate;
+         type = t;
+         bucket = it;
       }
+   };
 
-      inline void next()
+   auto searchType = [&](PacketType t)
+   {
+      SenderQueues &queues = _netQueue[t];
+      if (queues.empty())
+         return;
+      if (match.senders.empty())
       {
-         ++_i;
+         for (SenderQueues::iterator it = queues.begin(); it != queues.end(); ++it)
+            consider(t, it);
       }
-
-      inline void reset()
+      else
       {
-         _i = 0;
+         for (std::vector<SInt32>::const_iterator sender = match.senders.begin(); sender != match.senders.end(); ++sender)
+         {
+            SenderQueues::iterator it = queues.find(*sender);
+            if (it != queues.end())
+               consider(t, it);
+         }
       }
+   };
 
-   private:
-      enum
-      {
-         INT, SENDER_VECTOR, TYPE_VECTOR
-      } _mode;
-
-      union
-      {
-         UInt32 _max;
-         const std::vector<SInt32> *_senders;
-         const std::vector<PacketType> *_types;
-      };
+   if (match.types.empty())
+      for (SInt32 t = 0; t < NUM_PACKET_TYPES; t++)
+         searchType((PacketType)t);
+   else
+      for (std::vector<PacketType>::const_iterator t = match.types.begin(); t != match.types.end(); ++t)
+         searchType(*t);
 
-      UInt32 _i;
-};
+   return best != NULL;
+}
 
 NetPacket Network::netRecv(const NetMatch &match, UInt64 timeout_ns)
 {
    LOG_PRINT("Entering netRecv.");
 
-   // Track via iterator to minimize copying
-   NetQueue::iterator itr;
-   Boolean found = false, retry = true;
-
-   NetRecvIterator sender = match.senders.empty()
-                            ? NetRecvIterator(_numMod)
-                            : NetRecvIterator(match.senders);
-
-   NetRecvIterator type = match.types.empty()
-                          ? NetRecvIterator((UInt32)NUM_PACKET_TYPES)
-                          : NetRecvIterator(match.types);
-
    LOG_ASSERT_ERROR(_core && _core->getPerformanceModel(),
                     "Core and/or performance model not initialized.");
    SubsecondTime start_time = _core->getPerformanceModel()->getElapsedTime();
 
    _netQueueLock.acquire();
 
-   while (!found)
+   PacketType type;
+   SenderQueues::iterator bucket;
+   bool found = findPacket(match, type, bucket);
+
+   if (!found)
    {
-      itr = _netQueue.end();
+      // go to sleep until a matching packet arrives
+      Waiter waiter(match);
+      _netQueueWaiters.push_back(&waiter);
 
-      // check every entry in the queue
-      for (NetQueue::iterator i = _netQueue.begin();
-            i != _netQueue.end();
-            i++)
+      bool retry = true;
+      while (!found && retry)
       {
-         // only find packets that match
-         for (sender.reset(); !sender.done(); sender.next())
-         {
-            if (i->sender != (SInt32)sender.get())
-               continue;
-
-            for (type.reset(); !type.done(); type.next())
-            {
-               if (i->type != (PacketType)type.get())
-                  continue;
+         waiter.cond.wait(_netQueueLock, timeout_ns);
 
-               found = true;
+         // After waking from either timeout or cond.signal, retry once but then no more
+         if (timeout_ns)
+            retry = false;
 
-               // find the earliest packet
-               if (itr == _netQueue.end() ||
-                   itr->time > i->time)
-               {
-                  itr = i;
-               }
-            }
-         }
+         found = findPacket(match, type, bucket);
       }
 
+      _netQueueWaiters.remove(&waiter);
+
       if (!found)
       {
-         if (retry)
-         {
-            // go to sleep until a packet arrives if none have been found
-            _netQueueCond.wait(_netQueueLock, timeout_ns);
-
-            // After waking from either timeout or cond.signal, retry once but then no more
-            if (timeout_ns)
-               retry = false;
-         } else {
-            // non-blocking: return a special packet with length == -1 to denote no match
-            _netQueueLock.release();
-            NetPacket packet;
-            packet.length = UINT32_MAX;
-            return packet;
-         }
+         // non-blocking: return a special packet with length == -1 to denote no match
+         _netQueueLock.release();
+         NetPacket packet;
+         packet.length = UINT32_MAX;
+         return packet;
       }
    }
 
-   assert(found == true && itr != _netQueue.end());
-   assert(0 <= itr->sender && itr->sender < _numMod);
-   assert(0 <= itr->type && itr->type < NUM_PACKET_TYPES);
-   assert((itr->receiver == _core->getId()) || (itr->receiver == NetPacket::BROADCAST));
-
    // Copy result
-   NetPacket packet = *itr;
-   _netQueue.erase(itr);
+   NetPacket packet = bucket->second.begin()->second.packet;
+   bucket->second.erase(bucket->second.begin());
+   if (bucket->second.empty())
+      _netQueue[type].erase(bucket);
    _netQueueLock.release();
 
+   assert(0 <= packet.sender && packet.sender < _numMod);
+   assert(0 <= packet.type && packet.type < NUM_PACKET_TYPES);
+   assert((packet.receiver == _core->getId()) || (packet.receiver == NetPacket::BROADCAST));
+
    LOG_PRINT("packet.time(%s), start_time(%s)", itostr(packet.time).c_str(), itostr(start_time).c_str());
 
    if (packet.time > start_time)
@@ -517,7 +530,15 @@ NetPacket::NetPacket(Byte *buffer)
       data = data_buffer;
    }
 
-   delete [] buffer;
+   Transport::getSingleton()->freeBuffer(buffer);
+}
+
+NetPacket NetPacket::fromBuffer(Byte *buffer)
+{
+   NetPacket packet;
+   memcpy(&packet, buffer, sizeof(packet));
+   packet.data = packet.length > 0 ? buffer + sizeof(packet) : NULL;
+   return packet;
 }
 
 // This implementation is slightly wasteful because there is no need
@@ -533,7 +554,7 @@ Byte* NetPacket::makeBuffer() const
    UInt32 size = bufferSize();
    assert(size >= sizeof(NetPacket));
 
-   Byte *buffer = new Byte[size];
+   Byte *buffer = Transport::getSingleton()->allocBuffer(size);
 
    memcpy(buffer, this, sizeof(*this));
    memcpy(buffer + sizeof(*this), data, length);
@@ -11,6 +11,7 @@
 #include <iostream>
 #include <vector>
 #include <list>
+#include <map>
 
 // TODO: Do we need to support multicast to some (but not all)
 // destinations?
@@ -34,6 +35,8 @@ public:
 
    NetPacket();
    explicit NetPacket(Byte*);
+   // Zero-copy: header and payload stay in <buffer>, which must be released with Transport::freeBuffer()
+   static NetPacket fromBuffer(Byte *buffer);
    NetPacket(SubsecondTime time, PacketType type, SInt32 sender,
              SInt32 receiver, UInt32 length, const void *data);
 
@@ -43,8 +46,6 @@ public:
    static const SInt32 BROADCAST = 0xDEADBABE;
 };
 
-typedef std::list<NetPacket> NetQueue;
-
 // -- Network Matches -- //
 
 class NetMatch
@@ -85,6 +86,13 @@ class Network
       SInt32 netSend(NetPacket& packet);
       NetPacket netRecv(const NetMatch &match, UInt64 timeout_ns = 0);
 
+      // -- Zero-copy interface -- //
+      // Payloads from allocPayload() are handed to netSendPayload(), which takes ownership.
+      // With network/zero_copy enabled, they are passed to the receiver by pointer.
+      Byte* allocPayload(UInt32 length);
+      SInt32 netSendPayload(NetPacket& packet);
+      bool isZeroCopy() const { return _zero_copy; }
+
       // -- Wrappers -- //
 
       SInt32 netSend(SInt32 dest, PacketType type, const void *buf, UInt32 len);
@@ -114,11 +122,36 @@ class Network
       SInt32 _tid;
       SInt32 _numMod;
 
-      NetQueue _netQueue;
+      // Received packets waiting for netRecv, indexed by type and sender.
+      // Each bucket is ordered by time, and by arrival (seq) for packets with the same time.
+      struct QueuedPacket
+      {
+         NetPacket packet;
+         UInt64 seq;
+      };
+      typedef std::multimap<SubsecondTime, QueuedPacket> PacketBucket;
+      typedef std::map<SInt32, PacketBucket> SenderQueues; // Only senders with pending packets have a bucket
+
+      // A receiver blocked in netRecv, it is only woken up by packets that it matches
+      struct Waiter
+      {
+         const NetMatch &match;
+         ConditionVariable cond;
+         Waiter(const NetMatch &_match) : match(_match) {}
+         bool matches(const NetPacket &packet) const;
+      };
+
+      SenderQueues _netQueue[NUM_PACKET_TYPES];
+      UInt64 _netQueueSeq;
+      std::list<Waiter*> _netQueueWaiters;
       Lock _netQueueLock;
-      ConditionVariable _netQueueCond;
+
+      bool _zero_copy;
 
       void forwardPacket(NetPacket& packet);
+      SInt32 sendPacket(NetPacket& packet, bool zero_copy);
+      void releasePacket(NetPacket& packet, Byte *buffer);
+      bool findPacket(const NetMatch &match, PacketType &type, SenderQueues::iterator &bucket);
 };
 
 #endif // NETWORK_H
@@ -6,6 +6,7 @@
 #include "network_model_magic.h"
 #include "network_model_emesh_hop_counter.h"
 #include "network_model_emesh_hop_by_hop.h"
+#include "network_model_emesh_hybrid.h"
 #include "network_model_bus.h"
 #include "stats.h"
 #include "log.h"
@@ -55,6 +56,9 @@ NetworkModel::createModel(Network *net, UInt32 model_type, EStaticNetwork net_ty
    case NETWORK_EMESH_HOP_BY_HOP:
       return new NetworkModelEMeshHopByHop(net, net_type);
 
+   case NETWORK_EMESH_HYBRID:
+      return new NetworkModelEMeshHybrid(net, net_type);
+
    case NETWORK_BUS:
       return new NetworkModelBus(net, net_type);
 
@@ -73,6 +77,8 @@ NetworkModel::parseNetworkType(String str)
       return NETWORK_EMESH_HOP_COUNTER;
    else if (str == "emesh_hop_by_hop")
       return NETWORK_EMESH_HOP_BY_HOP;
+   else if (str == "emesh_hybrid")
+      return NETWORK_EMESH_HYBRID;
    else if (str == "bus")
       return NETWORK_BUS;
    else
@@ -90,6 +96,7 @@ NetworkModel::computeCoreCountConstraints(UInt32 network_type, SInt32 core_count
          return std::make_pair(false,core_count);
 
       case NETWORK_EMESH_HOP_BY_HOP:
+      case NETWORK_EMESH_HYBRID:
          return NetworkModelEMeshHopByHop::computeCoreCountConstraints(core_count);
 
       default:
@@ -119,6 +126,7 @@ NetworkModel::computeMemoryControllerPositions(UInt32 network_type, SInt32 num_m
          }
 
       case NETWORK_EMESH_HOP_BY_HOP:
+      case NETWORK_EMESH_HYBRID:
          return NetworkModelEMeshHopByHop::computeMemoryControllerPositions(num_memory_controllers, core_count);
 
       default:
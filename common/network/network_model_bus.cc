@@ -15,8 +15,8 @@ NetworkModelBusGlobal::NetworkModelBusGlobal(String name)
    , _num_packets(0)
    , _num_packets_delayed(0)
    , _num_bytes(0)
-   , _time_used(SubsecondTime::Zero())
-   , _total_delay(SubsecondTime::Zero())
+   , _time_used(0)
+   , _total_delay(0)
 {
    String model_type = Sim()->getCfg()->getString("network/bus/queue_model/type");
    // Emulate the original code, with 10 cycles of latency for the history_list, and 0 outstanding transactions for the contention model
@@ -37,16 +37,28 @@ NetworkModelBusGlobal::~NetworkModelBusGlobal()
 
 /* Model bus utilization. In: packet start time and size. Out: packet out time */
 SubsecondTime
-NetworkModelBusGlobal::useBus(SubsecondTime t_start, UInt32 length, subsecond_time_t *queue_delay_stats)
+NetworkModelBusGlobal::useBus(SubsecondTime t_start, UInt32 length, UInt32 modeled_length, subsecond_time_t *queue_delay_stats)
 {
    SubsecondTime t_delay = _bandwidth.getLatency(length * 8);
-   SubsecondTime t_queue = _queue_model->computeQueueDelay(t_start, t_delay);
-   _time_used += t_delay;
-   _total_delay += t_queue;
+   SubsecondTime t_queue;
+   if (_queue_model->isThreadSafe())
+      t_queue = _queue_model->computeQueueDelay(t_start, t_delay);
+   else
+   {
+      ScopedLock sl(_lock);
+      t_queue = _queue_model->computeQueueDelay(t_start, t_delay);
+   }
+
+   __sync_fetch_and_add(&_num_packets, 1);
+   __sync_fetch_and_add(&_num_bytes, modeled_length);
+   __sync_fetch_and_add(&_time_used, t_delay.getFS());
+   if (t_queue > SubsecondTime::Zero())
+   {
+      __sync_fetch_and_add(&_total_delay, t_queue.getFS());
+      __sync_fetch_and_add(&_num_packets_delayed, 1);
+   }
    if (queue_delay_stats)
       *queue_delay_stats += t_queue;
-   if (t_queue > SubsecondTime::Zero())
-      _num_packets_delayed ++;
    return t_start + t_queue + t_delay;
 }
 
@@ -66,12 +78,9 @@ void
 NetworkModelBus::routePacket(const NetPacket &pkt, std::vector<Hop> &nextHops)
 {
    SubsecondTime t_recv;
-   if (accountPacket(pkt)) {
-      ScopedLock sl(_bus->_lock);
-      _bus->_num_packets ++;
-      _bus->_num_bytes += getNetwork()->getModeledLength(pkt);
-      t_recv = _bus->useBus(pkt.time, pkt.length, (subsecond_time_t*)&pkt.queue_delay);
-   } else
+   if (accountPacket(pkt))
+      t_recv = _bus->useBus(pkt.time, pkt.length, getNetwork()->getModeledLength(pkt), (subsecond_time_t*)&pkt.queue_delay);
+   else
       t_recv = pkt.time;
 
    if (pkt.receiver == NetPacket::BROADCAST)
@@ -11,19 +11,20 @@
 class NetworkModelBusGlobal
 {
    public:
-      Lock _lock;
+      Lock _lock; //< Only used when the queue model is not thread-safe
       const ComponentBandwidth _bandwidth; //< Bits per cycle
       QueueModel* _queue_model;
 
+      // Updated atomically, times are in fs
       UInt64 _num_packets;
       UInt64 _num_packets_delayed;
       UInt64 _num_bytes;
-      SubsecondTime _time_used;
-      SubsecondTime _total_delay;
+      UInt64 _time_used;
+      UInt64 _total_delay;
 
       NetworkModelBusGlobal(String name);
       ~NetworkModelBusGlobal();
-      SubsecondTime useBus(SubsecondTime t_start, UInt32 length, subsecond_time_t *queue_delay_stats = NULL);
+      SubsecondTime useBus(SubsecondTime t_start, UInt32 length, UInt32 modeled_length, subsecond_time_t *queue_delay_stats = NULL);
 };
 
 class NetworkModelBus : public NetworkModel
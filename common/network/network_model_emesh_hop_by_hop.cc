@@ -27,13 +27,14 @@ const char* OutputDirectionString(NetworkModelEMeshHopByHop::OutputDirection dir
 
 NetworkModelEMeshHopByHop::NetworkModelEMeshHopByHop(Network* net, EStaticNetwork net_type):
    NetworkModel(net, net_type),
-   m_enabled(false),
    m_total_bytes_sent(0),
    m_total_packets_sent(0),
    m_total_bytes_received(0),
    m_total_packets_received(0),
    m_total_contention_delay(SubsecondTime::Zero()),
    m_total_packet_latency(SubsecondTime::Zero()),
+   m_enabled(false),
+   m_route_lock_free(true),
    m_fake_node(false),
    m_core_id(getNetwork()->getCore()->getId()),
    // Placeholders.  These values will be overwritten in a derived class.
@@ -111,13 +112,30 @@ NetworkModelEMeshHopByHop::createQueueModels(String name)
 
    m_injection_port_queue_model = QueueModel::create(name+".link-in", m_core_id, m_queue_model_type, min_processing_time);
    m_ejection_port_queue_model = QueueModel::create(name+".link-out", m_core_id, m_queue_model_type, min_processing_time);
+
+   // Routing only needs the per-node lock when it updates queue models that are not thread-safe
+   m_route_lock_free = !m_queue_model_enabled || m_injection_port_queue_model->isThreadSafe();
+   for (UInt32 i = 0; i < NUM_OUTPUT_DIRECTIONS; i++)
+      m_route_lock_free &= !m_queue_model_enabled || m_queue_models[i]->isThreadSafe();
 }
 
 void
 NetworkModelEMeshHopByHop::routePacket(const NetPacket &pkt, std::vector<Hop> &nextHops)
 {
-   ScopedLock sl(m_lock);
+   if (m_route_lock_free)
+   {
+      computeRoute(pkt, nextHops);
+   }
+   else
+   {
+      ScopedLock sl(m_lock);
+      computeRoute(pkt, nextHops);
+   }
+}
 
+void
+NetworkModelEMeshHopByHop::computeRoute(const NetPacket &pkt, std::vector<Hop> &nextHops)
+{
    core_id_t requester = INVALID_CORE_ID;
 
    if (pkt.type == SHARED_MEM_1)
@@ -134,8 +152,8 @@ NetworkModelEMeshHopByHop::routePacket(const NetPacket &pkt, std::vector<Hop> &n
 
    if (pkt.sender == m_core_id)
    {
-      m_total_packets_sent ++;
-      m_total_bytes_sent += pkt_length;
+      __sync_fetch_and_add(&m_total_packets_sent, 1);
+      __sync_fetch_and_add(&m_total_bytes_sent, pkt_length);
    }
 
    if (pkt.receiver == NetPacket::BROADCAST)
@@ -27,19 +27,26 @@ class NetworkModelEMeshHopByHop : public NetworkModel
 
    private:
       // Fields
-      SInt32 m_mesh_width;
-      SInt32 m_mesh_height;
-
       QueueModel* m_queue_models[NUM_OUTPUT_DIRECTIONS];
       QueueModel* m_injection_port_queue_model;
       QueueModel* m_ejection_port_queue_model;
 
-      bool m_enabled;
+      // Functions
+      void computeRoute(const NetPacket &pkt, std::vector<Hop> &nextHops);
+      SInt32 computeDistance(core_id_t sender, core_id_t receiver);
+
+      void addHop(OutputDirection direction, core_id_t final_dest, core_id_t next_dest, SubsecondTime pkt_time, UInt32 pkt_length, std::vector<Hop>& nextHops, core_id_t requester, subsecond_time_t *queue_delay_stats = NULL);
+      SubsecondTime computeLatency(OutputDirection direction, SubsecondTime pkt_time, UInt32 pkt_length, core_id_t requester, subsecond_time_t *queue_delay_stats);
+      core_id_t getNextDest(core_id_t final_dest, OutputDirection& direction);
+
+      // Injection Port Queue Model
+      SubsecondTime computeInjectionPortQueueDelay(core_id_t pkt_receiver, SubsecondTime pkt_time, UInt32 pkt_length);
 
+   protected:
       // Lock
       Lock m_lock;
 
-      // Counters
+      // Counters, the sent counters are updated atomically
       UInt64 m_total_bytes_sent;
       UInt64 m_total_packets_sent;
       UInt64 m_total_bytes_received;
@@ -47,21 +54,11 @@ class NetworkModelEMeshHopByHop : public NetworkModel
       SubsecondTime m_total_contention_delay;
       SubsecondTime m_total_packet_latency;
 
-      // Functions
-      void computePosition(core_id_t core, SInt32 &x, SInt32 &y);
-      core_id_t computeCoreId(SInt32 x, SInt32 y);
-      SInt32 computeDistance(core_id_t sender, core_id_t receiver);
-
-      void addHop(OutputDirection direction, core_id_t final_dest, core_id_t next_dest, SubsecondTime pkt_time, UInt32 pkt_length, std::vector<Hop>& nextHops, core_id_t requester, subsecond_time_t *queue_delay_stats = NULL);
-      SubsecondTime computeLatency(OutputDirection direction, SubsecondTime pkt_time, UInt32 pkt_length, core_id_t requester, subsecond_time_t *queue_delay_stats);
-      SubsecondTime computeProcessingTime(UInt32 pkt_length);
-      core_id_t getNextDest(core_id_t final_dest, OutputDirection& direction);
-
-      // Injection & Ejection Port Queue Models
-      SubsecondTime computeInjectionPortQueueDelay(core_id_t pkt_receiver, SubsecondTime pkt_time, UInt32 pkt_length);
-      SubsecondTime computeEjectionPortQueueDelay(SubsecondTime pkt_time, UInt32 pkt_length);
+      SInt32 m_mesh_width;
+      SInt32 m_mesh_height;
+      bool m_enabled;
+      bool m_route_lock_free; //< Route packets without taking m_lock, true when all link queue models are thread-safe
 
-   protected:
       bool m_fake_node; //< True for nodes that are not the master of their concentrated node, these do not count in the topology
       core_id_t m_core_id;
       SInt32 m_concentration; //< Number of cores per network node
@@ -77,6 +74,11 @@ class NetworkModelEMeshHopByHop : public NetworkModel
 
       void createQueueModels(String name);
 
+      void computePosition(core_id_t core, SInt32 &x, SInt32 &y);
+      core_id_t computeCoreId(SInt32 x, SInt32 y);
+      SubsecondTime computeProcessingTime(UInt32 pkt_length);
+      virtual SubsecondTime computeEjectionPortQueueDelay(SubsecondTime pkt_time, UInt32 pkt_length);
+
    public:
       NetworkModelEMeshHopByHop(Network* net, EStaticNetwork net_type);
       ~NetworkModelEMeshHopByHop();
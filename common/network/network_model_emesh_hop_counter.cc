@@ -8,11 +8,21 @@
 #include "core.h"
 #include "memory_manager_base.h"
 #include "dvfs_manager.h"
+#include "hooks_manager.h"
+#include "stats.h"
 #include "config.hpp"
 
+std::vector<UInt16> NetworkModelEMeshHopCounter::_hopTable;
+Lock NetworkModelEMeshHopCounter::_hopTableLock;
+std::vector<NetworkModelEMeshHopCounter*> NetworkModelEMeshHopCounter::_nodes[NUM_STATIC_NETWORKS];
+
 NetworkModelEMeshHopCounter::NetworkModelEMeshHopCounter(Network *net, EStaticNetwork net_type)
    : NetworkModel(net, net_type)
    , _hopLatency(NULL,0)
+   , _coreId(net->getCore()->getId())
+   , _netType(net_type)
+   , _latencyHopLatency(SubsecondTime::MaxTime())
+   , _linkCounters(Sim()->getCfg()->getBool("network/emesh_hop_counter/link_counters"))
    , _enabled(false)
    , _num_packets(0)
    , _num_bytes(0)
@@ -22,6 +32,7 @@ NetworkModelEMeshHopCounter::NetworkModelEMeshHopCounter(Network *net, EStaticNe
 
    _meshWidth = (SInt32) floor (sqrt(total_cores));
    _meshHeight = (SInt32) ceil (1.0 * total_cores / _meshWidth);
+   _numCores = total_cores;
 
    try
    {
@@ -36,6 +47,37 @@ NetworkModelEMeshHopCounter::NetworkModelEMeshHopCounter(Network *net, EStaticNe
    assert(total_cores <= _meshWidth * _meshHeight);
    assert(total_cores > (_meshWidth - 1) * _meshHeight);
    assert(total_cores > _meshWidth * (_meshHeight - 1));
+
+   {
+      ScopedLock sl(_hopTableLock);
+      if (_hopTable.empty())
+         buildHopTable();
+      if (_nodes[_netType].empty())
+         _nodes[_netType].resize(total_cores, NULL);
+      _nodes[_netType][_coreId] = this;
+   }
+   _zeroLoadLatency.resize(total_cores);
+
+   for (UInt32 i = 0; i < NUM_DIRECTIONS; i++)
+   {
+      _linkPackets[i] = 0;
+      _linkBytes[i] = 0;
+   }
+
+   if (_linkCounters)
+   {
+      _destPackets.resize(total_cores, 0);
+      _destBytes.resize(total_cores, 0);
+
+      static const char *direction_names[NUM_DIRECTIONS] = { "east", "west", "north", "south" };
+      String name = String("network.")+EStaticNetworkStrings[net_type]+".mesh";
+      for (UInt32 i = 0; i < NUM_DIRECTIONS; i++)
+      {
+         registerStatsMetric(name, _coreId, String("link-packets-") + direction_names[i], &_linkPackets[i]);
+         registerStatsMetric(name, _coreId, String("link-bytes-") + direction_names[i], &_linkBytes[i]);
+      }
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_PRE_STAT_WRITE, NetworkModelEMeshHopCounter::hook_pre_stat_write, (UInt64)this);
+   }
 }
 
 NetworkModelEMeshHopCounter::~NetworkModelEMeshHopCounter()
@@ -54,17 +96,52 @@ SInt32 NetworkModelEMeshHopCounter::computeDistance(SInt32 x1, SInt32 y1, SInt32
    return abs(x1 - x2) + abs(y1 - y2);
 }
 
+void NetworkModelEMeshHopCounter::buildHopTable()
+{
+   _hopTable.resize(_numCores * _numCores);
+   for (SInt32 src = 0; src < _numCores; src++)
+   {
+      SInt32 sx, sy;
+      computePosition(src, sx, sy);
+      for (SInt32 dst = 0; dst < _numCores; dst++)
+      {
+         SInt32 dx, dy;
+         computePosition(dst, dx, dy);
+         _hopTable[src * _numCores + dst] = computeDistance(sx, sy, dx, dy);
+      }
+   }
+}
+
+void NetworkModelEMeshHopCounter::updateLatencies()
+{
+   // Only this node's row depends on its clock, all hop latencies of the other nodes are unaffected
+   _latencyHopLatency = _hopLatency.getLatency();
+   for (SInt32 dst = 0; dst < _numCores; dst++)
+      _zeroLoadLatency[dst] = getHops(_coreId, dst) * _latencyHopLatency;
+   for (UInt32 length = 0; length < SERIALIZATION_CACHE_SIZE; length++)
+      _serializationLatency[length] = _linkBandwidth.getRoundedLatency(length * 8);
+}
+
+SubsecondTime NetworkModelEMeshHopCounter::getZeroLoadLatency(core_id_t src, core_id_t dst)
+{
+   if (src == _coreId)
+      return _zeroLoadLatency[dst];
+   else
+      // Routing on behalf of another sender: same hop latency, but not our row of the table
+      return getHops(src, dst) * _latencyHopLatency;
+}
+
 void NetworkModelEMeshHopCounter::routePacket(const NetPacket &pkt,
                                          std::vector<Hop> &nextHops)
 {
+   // A changed clock period (DVFS) invalidates the cached latencies
+   if (_hopLatency.getLatency() != _latencyHopLatency)
+      updateLatencies();
+
    UInt32 pkt_length = getNetwork()->getModeledLength(pkt);
 
    SubsecondTime serialization_latency = computeSerializationLatency(pkt_length);
 
-   SInt32 sx, sy, dx, dy;
-
-   computePosition(pkt.sender, sx, sy);
-
    if (pkt.receiver == NetPacket::BROADCAST)
    {
       UInt32 total_cores = Config::getSingleton()->getTotalCores();
@@ -74,11 +151,13 @@ void NetworkModelEMeshHopCounter::routePacket(const NetPacket &pkt,
       // bottleneck at all since there's no contention
       for (SInt32 i = 0; i < (SInt32) total_cores; i++)
       {
-         computePosition(i, dx, dy);
-
-         SubsecondTime latency = computeDistance(sx, sy, dx, dy) * _hopLatency.getLatency();
+         SubsecondTime latency = getZeroLoadLatency(pkt.sender, i);
          if (i != pkt.sender)
+         {
             latency += serialization_latency;
+            if (_linkCounters && pkt.sender == _coreId)
+               chargeLinks(i, pkt_length);
+         }
 
          Hop h;
          h.final_dest = i;
@@ -93,11 +172,13 @@ void NetworkModelEMeshHopCounter::routePacket(const NetPacket &pkt,
    }
    else
    {
-      computePosition(pkt.receiver, dx, dy);
-
-      SubsecondTime latency = computeDistance(sx, sy, dx, dy) * _hopLatency.getLatency();
+      SubsecondTime latency = getZeroLoadLatency(pkt.sender, pkt.receiver);
       if (pkt.receiver != pkt.sender)
+      {
          latency += serialization_latency;
+         if (_linkCounters && pkt.sender == _coreId)
+            chargeLinks(pkt.receiver, pkt_length);
+      }
 
       Hop h;
       h.final_dest = pkt.receiver;
@@ -140,8 +221,65 @@ NetworkModelEMeshHopCounter::processReceivedPacket(NetPacket &pkt)
 SubsecondTime
 NetworkModelEMeshHopCounter::computeSerializationLatency(UInt32 pkt_length)
 {
+   if (pkt_length < SERIALIZATION_CACHE_SIZE)
+      return _serializationLatency[pkt_length];
+
    // Send: (pkt_length * 8) bits
    // Bandwidth: (m_link_bandwidth) bits/cycle
    UInt32 num_bits = pkt_length * 8;
    return _linkBandwidth.getRoundedLatency(num_bits);
 }
+
+void
+NetworkModelEMeshHopCounter::chargeLinks(core_id_t dst, UInt32 pkt_length)
+{
+   // Only the sender's own counters are touched, the route is walked in flushLinkCounters()
+   __sync_fetch_and_add(&_destPackets[dst], 1);
+   __sync_fetch_and_add(&_destBytes[dst], pkt_length);
+}
+
+void
+NetworkModelEMeshHopCounter::flushLinkCounters()
+{
+   SInt32 sx, sy;
+   computePosition(_coreId, sx, sy);
+
+   for (SInt32 dst = 0; dst < _numCores; dst++)
+   {
+      UInt64 packets = __sync_lock_test_and_set(&_destPackets[dst], 0);
+      if (packets == 0)
+         continue;
+      UInt64 bytes = __sync_lock_test_and_set(&_destBytes[dst], 0);
+
+      // Dimension-order route: along the X dimension in the sender's row, then along Y in the receiver's column
+      SInt32 dx, dy;
+      computePosition(dst, dx, dy);
+      SInt32 x = sx, y = sy;
+      while (x != dx || y != dy)
+      {
+         Direction direction;
+         if (x != dx)
+            direction = dx > x ? EAST : WEST;
+         else
+            direction = dy > y ? NORTH : SOUTH;
+
+         // Routes through the unpopulated part of the last row have no router to charge
+         SInt32 node_id = y * _meshWidth + x;
+         if (node_id < _numCores && _nodes[_netType][node_id])
+         {
+            NetworkModelEMeshHopCounter *node = _nodes[_netType][node_id];
+            __sync_fetch_and_add(&node->_linkPackets[direction], packets);
+            __sync_fetch_and_add(&node->_linkBytes[direction], bytes);
+         }
+
+         switch (direction)
+         {
+            case EAST: x++; break;
+            case WEST: x--; break;
+            case NORTH: y++; break;
+            case SOUTH: y--; break;
+            default: break;
+         }
+      }
+   }
+}
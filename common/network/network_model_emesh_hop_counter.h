@@ -5,6 +5,12 @@
 #include "network_model.h"
 #include "lock.h"
 
+#include <vector>
+
+// Contention-free mesh: a packet arrives after (hops * hop_latency) plus its serialization latency.
+// Hop counts come from an all-pairs table shared by all nodes, and each node keeps its row of zero-load latencies,
+// rebuilt when its clock period changes. With network/emesh_hop_counter/link_counters, senders only count traffic
+// per destination, which is charged to the links of each dimension-order route in bulk before statistics are written.
 class NetworkModelEMeshHopCounter : public NetworkModel
 {
 public:
@@ -20,16 +26,60 @@ public:
 
 private:
 
+   enum Direction
+   {
+      EAST,
+      WEST,
+      NORTH,
+      SOUTH,
+      NUM_DIRECTIONS
+   };
+
+   // Packet lengths whose serialization latency is cached
+   static const UInt32 SERIALIZATION_CACHE_SIZE = 256;
+
    void computePosition(core_id_t core, SInt32 &x, SInt32 &y);
    SInt32 computeDistance(SInt32 x1, SInt32 y1, SInt32 x2, SInt32 y2);
+   void buildHopTable();
+   UInt32 getHops(core_id_t src, core_id_t dst) const { return _hopTable[src * _numCores + dst]; }
+   SubsecondTime getZeroLoadLatency(core_id_t src, core_id_t dst);
+   void updateLatencies();
 
    SubsecondTime computeSerializationLatency(UInt32 pkt_length);
 
+   void chargeLinks(core_id_t dst, UInt32 pkt_length);
+   void flushLinkCounters();
+
+   static SInt64 hook_pre_stat_write(UInt64 self, UInt64)
+   { ((NetworkModelEMeshHopCounter*)self)->flushLinkCounters(); return 0; }
+
    ComponentLatency _hopLatency;
    ComponentBandwidthPerCycle _linkBandwidth;
 
    SInt32 _meshWidth;
    SInt32 _meshHeight;
+   SInt32 _numCores;
+   core_id_t _coreId;
+   EStaticNetwork _netType;
+
+   // Shared by all nodes (the mesh is the same for every network), built by the first one
+   static std::vector<UInt16> _hopTable;
+   static Lock _hopTableLock;
+   // All nodes of each network, indexed by core, to charge the links on a route
+   static std::vector<NetworkModelEMeshHopCounter*> _nodes[NUM_STATIC_NETWORKS];
+
+   // Zero-load latency from this node to each destination, and the hop latency it was computed with
+   std::vector<SubsecondTime> _zeroLoadLatency;
+   SubsecondTime _latencyHopLatency;
+   SubsecondTime _serializationLatency[SERIALIZATION_CACHE_SIZE];
+
+   // Traffic from this node per destination, not yet charged to the links
+   const bool _linkCounters;
+   std::vector<UInt64> _destPackets;
+   std::vector<UInt64> _destBytes;
+   // Traffic over this node's outgoing links
+   UInt64 _linkPackets[NUM_DIRECTIONS];
+   UInt64 _linkBytes[NUM_DIRECTIONS];
 
    bool _enabled;
 
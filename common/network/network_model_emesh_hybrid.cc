@@ -0,0 +1,185 @@
+#include "network_model_emesh_hybrid.h"
+#include "core.h"
+#include "core_manager.h"
+#include "simulator.h"
+#include "config.h"
+#include "memory_manager_base.h"
+#include "hooks_manager.h"
+#include "stats.h"
+#include "config.hpp"
+
+#include <stdlib.h>
+
+NetworkModelEMeshHybrid::NetworkModelEMeshHybrid(Network* net, EStaticNetwork net_type)
+   : NetworkModelEMeshHopByHop(net, net_type)
+   , m_sample_period(Sim()->getCfg()->getInt("network/emesh_hybrid/sample_period"))
+   , m_max_utilization(Sim()->getCfg()->getFloat("network/emesh_hybrid/max_utilization"))
+   , m_last_update(SubsecondTime::Zero())
+   , m_packets_routed(0)
+   , m_analytical_packets(0)
+   , m_sampled_packets(0)
+{
+   LOG_ASSERT_ERROR(m_max_utilization > 0 && m_max_utilization < 1,
+         "Invalid value %f for network/emesh_hybrid/max_utilization, should be between 0 and 1", m_max_utilization);
+
+   String name = String("network.")+EStaticNetworkStrings[net_type]+".mesh";
+   registerStatsMetric(name, m_core_id, "analytical-packets", &m_analytical_packets);
+   registerStatsMetric(name, m_core_id, "sampled-packets", &m_sampled_packets);
+
+   if (!m_fake_node)
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, NetworkModelEMeshHybrid::hook_periodic, (UInt64)this);
+}
+
+void
+NetworkModelEMeshHybrid::routePacket(const NetPacket &pkt, std::vector<Hop> &nextHops)
+{
+   // Broadcasts, packets from non-master nodes, and sampled packets being forwarded by the hop-by-hop model
+   if (pkt.receiver == NetPacket::BROADCAST || m_fake_node || pkt.sender != m_core_id)
+   {
+      NetworkModelEMeshHopByHop::routePacket(pkt, nextHops);
+      return;
+   }
+
+   core_id_t requester = INVALID_CORE_ID;
+
+   if (pkt.type == SHARED_MEM_1)
+      requester = getNetwork()->getCore()->getMemoryManager()->getShmemRequester(pkt.data);
+   else // Other Packet types
+      requester = pkt.sender;
+
+   LOG_ASSERT_ERROR((requester >= 0) && (requester < (core_id_t) Config::getSingleton()->getTotalCores()),
+         "requester(%i)", requester);
+
+   UInt32 pkt_length = getNetwork()->getModeledLength(pkt);
+
+   bool sampled;
+   {
+      ScopedLock sl(m_lock);
+
+      if (m_nodes.empty())
+         findNodes(pkt.type);
+
+      sampled = m_sample_period && ++m_packets_routed % m_sample_period == 0;
+      if (sampled)
+      {
+         m_sampled_packets ++;
+      }
+      else
+      {
+         m_analytical_packets ++;
+         __sync_fetch_and_add(&m_total_packets_sent, 1);
+         __sync_fetch_and_add(&m_total_bytes_sent, pkt_length);
+      }
+   }
+
+   SubsecondTime latency = SubsecondTime::Zero(), contention = SubsecondTime::Zero();
+   if (m_enabled && requester < (core_id_t) Config::getSingleton()->getApplicationCores())
+      // Sampled packets also count towards the link utilization, only their latency comes from the hop-by-hop model
+      latency = computeAnalyticalLatency(pkt.receiver, computeProcessingTime(pkt_length), contention);
+
+   if (sampled)
+   {
+      NetworkModelEMeshHopByHop::routePacket(pkt, nextHops);
+      return;
+   }
+
+   *(subsecond_time_t*)&pkt.queue_delay += contention;
+
+   Hop h;
+   h.final_dest = pkt.receiver;
+   h.next_dest = pkt.receiver;
+   h.time = pkt.time + latency;
+   nextHops.push_back(h);
+}
+
+void
+NetworkModelEMeshHybrid::findNodes(PacketType type)
+{
+   for (SInt32 y = 0; y < m_mesh_height; y++)
+   {
+      for (SInt32 x = 0; x < m_mesh_width; x++)
+      {
+         Core *core = Sim()->getCoreManager()->getCoreFromID(computeCoreId(x, y));
+         m_nodes.push_back(static_cast<NetworkModelEMeshHybrid*>(core->getNetwork()->getNetworkModelFromPacketType(type)));
+      }
+   }
+}
+
+SubsecondTime
+NetworkModelEMeshHybrid::useLink(UInt32 link, SubsecondTime processing_time)
+{
+   __sync_fetch_and_add(&m_links[link].busy_time, processing_time.getFS());
+   __sync_fetch_and_add(&m_links[link].packets, 1);
+   return SubsecondTime::FS(m_links[link].wait);
+}
+
+SubsecondTime
+NetworkModelEMeshHybrid::computeAnalyticalLatency(core_id_t receiver, SubsecondTime processing_time, SubsecondTime &contention)
+{
+   // Follows the injection port and dimension-order route of NetworkModelEMeshHopByHop
+   if (m_queue_model_enabled && receiver != m_core_id)
+      contention += useLink(INJECTION, processing_time);
+
+   if (receiver >= (core_id_t) Config::getSingleton()->getApplicationCores()
+       || m_core_id / m_concentration == receiver / m_concentration)
+      return contention;
+
+   SInt32 x, y, dx, dy;
+   computePosition(m_core_id, x, y);
+   computePosition(receiver, dx, dy);
+
+   UInt32 hops = 0;
+   while (x != dx)
+   {
+      OutputDirection direction = ((x > dx) ^ (m_wrap_around && abs(x - dx) > (m_mesh_width+1) / 2)) ? LEFT : RIGHT;
+      if (m_queue_model_enabled)
+         contention += getNode(x, y)->useLink(direction, processing_time);
+      x = (x + (direction == LEFT ? m_mesh_width - 1 : 1)) % m_mesh_width;
+      hops ++;
+   }
+   while (y != dy)
+   {
+      OutputDirection direction = ((y > dy) ^ (m_wrap_around && abs(y - dy) > (m_mesh_height+1) / 2)) ? DOWN : UP;
+      if (m_queue_model_enabled)
+         contention += getNode(x, y)->useLink(direction, processing_time);
+      y = (y + (direction == DOWN ? m_mesh_height - 1 : 1)) % m_mesh_height;
+      hops ++;
+   }
+
+   return hops * m_hop_latency.getLatency() + contention;
+}
+
+SubsecondTime
+NetworkModelEMeshHybrid::computeEjectionPortQueueDelay(SubsecondTime pkt_time, UInt32 pkt_length)
+{
+   if (!m_queue_model_enabled)
+      return SubsecondTime::Zero();
+
+   return useLink(EJECTION, computeProcessingTime(pkt_length));
+}
+
+void
+NetworkModelEMeshHybrid::updateUtilization(SubsecondTime time)
+{
+   if (time <= m_last_update)
+      return;
+
+   UInt64 elapsed = (time - m_last_update).getFS();
+   m_last_update = time;
+
+   for (UInt32 i = 0; i < NUM_LINKS; i++)
+   {
+      UInt64 busy_time = __sync_lock_test_and_set(&m_links[i].busy_time, 0);
+      UInt64 packets = __sync_lock_test_and_set(&m_links[i].packets, 0);
+
+      if (packets == 0)
+      {
+         m_links[i].wait = 0;
+         continue;
+      }
+
+      // M/D/1 waiting time: rho * S / (2 * (1 - rho)), with S the mean processing time
+      double utilization = std::min(double(busy_time) / elapsed, m_max_utilization);
+      m_links[i].wait = UInt64(utilization / (2 * (1 - utilization)) * busy_time / packets);
+   }
+}
@@ -0,0 +1,67 @@
+#ifndef __NETWORK_MODEL_EMESH_HYBRID_H__
+#define __NETWORK_MODEL_EMESH_HYBRID_H__
+
+#include "network_model_emesh_hop_by_hop.h"
+
+// Mesh network model that only simulates a sample of the packets hop-by-hop.
+// Unicast packets are routed in one step from sender to receiver: the zero-load latency follows from the
+// dimension-order route, and each link on the route (including the injection and ejection ports) adds an M/D/1
+// waiting time computed from its utilization during the previous barrier quantum.
+// Senders only add their processing time to the links' counters, the waiting times are recomputed in bulk
+// at every barrier, so no queue model or remote lock is touched for these packets.
+// One in network/emesh_hybrid/sample_period packets, and all broadcasts, go through the emesh_hop_by_hop
+// model instead (the ejection port is always modeled analytically). Their link queues only see the sampled
+// packets, which do count towards the link utilization of the analytical model.
+// Topology and link parameters are read from network/emesh_hop_by_hop.
+
+class NetworkModelEMeshHybrid : public NetworkModelEMeshHopByHop
+{
+   public:
+      NetworkModelEMeshHybrid(Network* net, EStaticNetwork net_type);
+
+      void routePacket(const NetPacket &pkt, std::vector<Hop> &nextHops);
+
+   protected:
+      SubsecondTime computeEjectionPortQueueDelay(SubsecondTime pkt_time, UInt32 pkt_length);
+
+   private:
+      enum
+      {
+         INJECTION = NUM_OUTPUT_DIRECTIONS,
+         EJECTION,
+         NUM_LINKS
+      };
+
+      struct Link
+      {
+         UInt64 busy_time; // Processing time (fs) offered during the current quantum, updated atomically by the senders
+         UInt64 packets;
+         UInt64 wait;      // M/D/1 waiting time (fs) based on the previous quantum
+         Link() : busy_time(0), packets(0), wait(0) {}
+      };
+
+      const UInt64 m_sample_period;
+      const double m_max_utilization;
+
+      Link m_links[NUM_LINKS];
+      std::vector<NetworkModelEMeshHybrid*> m_nodes; // Master node models, indexed by mesh position
+      SubsecondTime m_last_update;
+
+      UInt64 m_packets_routed;
+      UInt64 m_analytical_packets;
+      UInt64 m_sampled_packets;
+
+      NetworkModelEMeshHybrid* getNode(SInt32 x, SInt32 y) { return m_nodes[y * m_mesh_width + x]; }
+      void findNodes(PacketType type);
+      SubsecondTime useLink(UInt32 link, SubsecondTime processing_time);
+      SubsecondTime computeAnalyticalLatency(core_id_t receiver, SubsecondTime processing_time, SubsecondTime &contention);
+      void updateUtilization(SubsecondTime time);
+
+      static SInt64 hook_periodic(UInt64 self, UInt64 time)
+      {
+         ((NetworkModelEMeshHybrid*)self)->updateUtilization(*(subsecond_time_t*)(&time));
+         return 0;
+      }
+};
+
+#endif /* __NETWORK_MODEL_EMESH_HYBRID_H__ */
@@ -6,6 +6,7 @@ enum NetworkType
    NETWORK_MAGIC,
    NETWORK_EMESH_HOP_COUNTER,
    NETWORK_EMESH_HOP_BY_HOP,
+   NETWORK_EMESH_HYBRID,
    NETWORK_BUS,
    NUM_NETWORK_TYPES
 };
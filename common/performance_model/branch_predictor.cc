@@ -4,24 +4,40 @@
 #include "pentium_m_branch_predictor.h"
 #include "a53branchpredictor.h"
 #include "nn_branch_predictor.h"
+#include "nn_shared_branch_predictor.h"
+#include "perceptron_branch_predictor.h"
 #include "config.hpp"
 #include "stats.h"
 #include "hooks_manager.h" // PaulRosu@ULBS
+#include "core_state_predictor_manager.h"
 
 BranchPredictor::BranchPredictor()
    : m_core_id(0) // PaulRosu@ULBS
-   , m_correct_predictions(0)
-   , m_incorrect_predictions(0)
+   , m_batch_count(0)
+   , m_correct_predictions(*allocStatsCounters<UInt64>(0))
+   , m_incorrect_predictions(*allocStatsCounters<UInt64>(0))
 {
 }
 
 BranchPredictor::BranchPredictor(String name, core_id_t core_id)
    : m_core_id(core_id) // PaulRosu@ULBS
-   , m_correct_predictions(0)
-   , m_incorrect_predictions(0)
+   , m_batch_count(0)
+   , m_correct_predictions(*allocStatsCounters<UInt64>(core_id))
+   , m_incorrect_predictions(*allocStatsCounters<UInt64>(core_id))
 {
    registerStatsMetric(name, core_id, "num-correct", &m_correct_predictions);
    registerStatsMetric(name, core_id, "num-incorrect", &m_incorrect_predictions);
+
+   UInt64 batch_size = Sim()->getCfg()->getInt("hooks/branch_batch_size");
+   if (batch_size)
+   {
+      m_batch.resize(batch_size);
+      // Deliver partially filled batches at every barrier so scripts see up-to-date branch behavior
+      // from their own periodic callbacks (which are registered later, and hence run after us)
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, BranchPredictor::__flushBranchBatch, (UInt64)this);
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_END, BranchPredictor::__flushBranchBatch, (UInt64)this);
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_SIM_END, BranchPredictor::__flushBranchBatch, (UInt64)this);
+   }
 }
 
 BranchPredictor::~BranchPredictor()
@@ -55,10 +71,22 @@ BranchPredictor* BranchPredictor::create(core_id_t core_id)
       else if (type == "a53") {
           return new A53BranchPredictor("branch_predictor", core_id);
       }
+      else if (type == "perceptron")
+      {
+         UInt32 size = cfg->getIntArray("perf_model/branch_predictor/perceptron/size", core_id);
+         UInt32 history_length = cfg->getIntArray("perf_model/branch_predictor/perceptron/history_length", core_id);
+         return new PerceptronBranchPredictor("branch_predictor", core_id, size, history_length);
+      }
       else if (type == "nn") {
           UInt32 batch_length = cfg->getIntArray("perf_model/branch_predictor/batch_length", core_id);
           double learning_rate = cfg->getFloatArray("perf_model/branch_predictor/learning_rate", core_id);
-          return new NNBranchPredictor("branch_predictor", core_id, batch_length, learning_rate);
+          bool fast_inference = cfg->getBoolArray("perf_model/branch_predictor/nn_fast_inference", core_id);
+          bool async_training = cfg->getBoolArray("perf_model/branch_predictor/nn_async_training", core_id);
+          return new NNBranchPredictor("branch_predictor", core_id, batch_length, learning_rate, fast_inference, async_training);
+      }
+      else if (type == "nn_shared") {
+          UInt32 delay = cfg->getIntArray("perf_model/branch_predictor/nn_shared/delay", core_id);
+          return new NNSharedBranchPredictor("branch_predictor", core_id, delay);
       }
       else
       {
@@ -96,7 +124,17 @@ void BranchPredictor::updateCounters(bool predicted, bool actual)
 void BranchPredictor::update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target)
 {
    updateCounters(predicted, actual);
-   
+
+   // Native core-state predictors are trained directly, without going through HOOK_BRANCH_PREDICT
+   CoreStatePredictorManager *csp = Sim()->getCoreStatePredictorManager();
+   if (csp)
+      csp->branch(m_core_id, ip, actual);
+
+   HooksManager *hooks_manager = Sim()->getHooksManager();
+   bool batch = m_batch.size() && hooks_manager->hasHooks(HookType::HOOK_BRANCH_PREDICT_BATCH, m_core_id);
+   if (!batch && !hooks_manager->hasHooks(HookType::HOOK_BRANCH_PREDICT, m_core_id))
+      return;
+
    // Create and populate branch prediction info
    HooksManager::BranchPrediction info = {
       ip,         // instruction pointer
@@ -107,8 +145,33 @@ void BranchPredictor::update(bool predicted, bool actual, bool indirect, IntPtr
    };
 
    // Call Python hooks with branch prediction info
-   Sim()->getHooksManager()->callHooks(
-      HookType::HOOK_BRANCH_PREDICT, 
-      (UInt64)&info
-   );
-}
\ No newline at end of file
+   hooks_manager->callHooks(HookType::HOOK_BRANCH_PREDICT, (UInt64)&info, false, m_core_id);
+
+   if (batch)
+   {
+      m_batch[m_batch_count++] = info;
+      if (m_batch_count == m_batch.size())
+         flushBranchBatch();
+   }
+}
+
+void BranchPredictor::predictAndUpdate(Branch *branches, UInt32 count)
+{
+   for (UInt32 i = 0; i < count; ++i)
+   {
+      Branch &branch = branches[i];
+      bool prediction = predict(branch.indirect, branch.ip, branch.target);
+      update(prediction, branch.taken, branch.indirect, branch.ip, branch.target);
+      branch.mispredict = (prediction != branch.taken);
+   }
+}
+
+void BranchPredictor::flushBranchBatch()
+{
+   if (m_batch_count == 0)
+      return;
+
+   HooksManager::BranchPredictionBatch batch = { m_core_id, m_batch_count, m_batch.data() };
+   m_batch_count = 0;
+   Sim()->getHooksManager()->callHooks(HookType::HOOK_BRANCH_PREDICT_BATCH, (UInt64)&batch, false, m_core_id);
+}
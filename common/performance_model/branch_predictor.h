@@ -4,6 +4,12 @@
 #include <iostream>
 
 #include "fixed_types.h"
+#include "hooks_manager.h"
+
+#include <vector>
+
+class CheckpointWriter;
+class CheckpointReader;
 
 class BranchPredictor
 {
@@ -12,8 +18,20 @@ public:
    BranchPredictor(String name, core_id_t core_id);
    virtual ~BranchPredictor();
 
+   // One branch of a batch for predictAndUpdate, mispredict is filled in by the predictor
+   struct Branch
+   {
+      IntPtr ip;
+      IntPtr target;
+      bool taken;
+      bool indirect;
+      bool mispredict;
+   };
+
    virtual bool predict(bool indirect, IntPtr ip, IntPtr target) = 0;
    virtual void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target);
+   // Predict and train a sequence of branches in program order, as if predict() and update() were called for each
+   virtual void predictAndUpdate(Branch *branches, UInt32 count);
 
    UInt64 getMispredictPenalty();
    static BranchPredictor* create(core_id_t core_id);
@@ -23,13 +41,29 @@ public:
 
    void resetCounters();
 
+   // Checkpointing of the predictor tables (see CheckpointManager)
+   virtual void saveState(CheckpointWriter &ckpt) const {}
+   virtual void loadState(CheckpointReader &ckpt) {}
+
+   // Hand all buffered branch records to HOOK_BRANCH_PREDICT_BATCH subscribers
+   void flushBranchBatch();
+
 protected:
    void updateCounters(bool predicted, bool actual);
 
 private:
    core_id_t m_core_id; //PaulRosu@ULBS
-   UInt64 m_correct_predictions;
-   UInt64 m_incorrect_predictions;
+
+   // Per-core buffer of branch records for HOOK_BRANCH_PREDICT_BATCH. Only written by this core's
+   // simulation thread, and drained either by that same thread (when full) or at the barrier
+   // (HOOK_PERIODIC / HOOK_ROI_END / HOOK_SIM_END) while all cores are stopped, so no locking is needed.
+   std::vector<HooksManager::BranchPrediction> m_batch;
+   UInt64 m_batch_count;
+
+   static SInt64 __flushBranchBatch(UInt64 arg, UInt64 val) { ((BranchPredictor*)arg)->flushBranchBatch(); return 0; }
+   // In per-core storage (see allocStatsCounters)
+   UInt64 &m_correct_predictions;
+   UInt64 &m_incorrect_predictions;
 
    static UInt64 m_mispredict_penalty;
 };
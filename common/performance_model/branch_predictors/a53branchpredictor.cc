@@ -30,13 +30,14 @@ A53BranchPredictor::A53BranchPredictor(String name, core_id_t core_id)
    : BranchPredictor(name, core_id)
    , m_num_registers(Sim()->getCfg()->getIntArray("perf_model/branch_predictor/num_history_registers", core_id))
    , size(Sim()->getCfg()->getIntArray("perf_model/branch_predictor/size", core_id))
-   , m_pattern_history_table(std::vector<A53BranchPredictor::State>(m_num_registers*size, A53BranchPredictor::StronglyNotTaken))
+   , m_pattern_history_table(Fields::bytes(m_num_registers*size), 0) // StronglyNotTaken
    , m_branch_history_register(std::vector<int>(m_num_registers, 0))
 {
+   static_assert(A53BranchPredictor::StronglyNotTaken == 0, "Initial table contents assume StronglyNotTaken is zero");
 }
 
 void A53BranchPredictor::update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target) {
-   updateCounters(predicted, actual);
+   BranchPredictor::update(predicted, actual, indirect, ip, target);
 
    if (indirect) {
       ibtb.update(predicted, actual, indirect, ip, target);
@@ -47,7 +48,8 @@ void A53BranchPredictor::update(bool predicted, bool actual, bool indirect, IntP
    int registerValue = m_branch_history_register[registerIndex] & (size - 1);
    int historyIndex = registerValue + registerIndex*size;
 
-   m_pattern_history_table[historyIndex] = nextState(m_pattern_history_table[historyIndex], actual);
+   State state = State(Fields::get(m_pattern_history_table.data(), historyIndex));
+   Fields::set(m_pattern_history_table.data(), historyIndex, nextState(state, actual));
    m_branch_history_register[registerIndex] = (registerValue << 1) | actual;
 }
 
@@ -61,5 +63,5 @@ bool A53BranchPredictor::predict(bool indirect, IntPtr ip, IntPtr target) {
    int registerValue = m_branch_history_register[registerIndex] & (size - 1);
    int historyIndex = registerValue + registerIndex*size;
 
-   return statePrediction(m_pattern_history_table[historyIndex]);
+   return statePrediction(State(Fields::get(m_pattern_history_table.data(), historyIndex)));
 }
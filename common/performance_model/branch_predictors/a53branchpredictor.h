@@ -3,6 +3,7 @@
 
 #include "branch_predictor.h"
 #include "pentium_m_indirect_branch_target_buffer.h"
+#include "saturating_predictor.h"
 #include <vector>
 
 class A53BranchPredictor : public BranchPredictor {
@@ -20,11 +21,13 @@ public:
     bool predict(bool indirect, IntPtr ip, IntPtr target);
     void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target);
 private:
+    typedef PackedSaturatingCounters<2> Fields;
+
     const int m_num_registers;
     const int size;
 
     PentiumMIndirectBranchTargetBuffer ibtb;
-    std::vector<State> m_pattern_history_table;
+    std::vector<uint8_t> m_pattern_history_table;  // State, packed into 2-bit fields
     std::vector<int> m_branch_history_register;
 };
 
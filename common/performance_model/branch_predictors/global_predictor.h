@@ -1,90 +1,80 @@
 #ifndef GLOBAL_PREDICTOR_H
 #define GLOBAL_PREDICTOR_H
 
-#include <vector>
 #include <stdint.h>
+#include <cstring>
 
 #include "simulator.h"
-#include "branch_predictor.h"
 #include "branch_predictor_return_value.h"
 #include "saturating_predictor.h"
+#include "checkpoint.h"
 
-class GlobalPredictor : BranchPredictor
+// Tagged, set-associative table of 2-bit counters indexed by instruction pointer and path history.
+// All ways of a set share one cache line: LRU stamps, tags, a valid mask and the packed counters.
+template <UInt32 NUM_SETS, UInt32 NUM_WAYS>
+class GlobalPredictor
 {
+   static_assert(NUM_WAYS <= 4, "The counters of a set are packed into a single byte");
+   typedef PackedSaturatingCounters<2> Counters;
 
 public:
 
-   GlobalPredictor(UInt32 entries, UInt32 tag_bitwidth, UInt32 ways)
+   // Set and tag of a lookup, computed once and shared by lookup(), update() and evict()
+   struct Index
+   {
+      UInt32 set;
+      uint8_t tag;
+   };
+
+   GlobalPredictor()
       : m_lru_use_count(0)
-      , m_num_ways(ways)
-      , m_ways(ways, Way(entries/ways, 6))
    {
+      memset(m_sets, 0, sizeof(m_sets));
+      for (UInt32 s = 0 ; s < NUM_SETS ; ++s)
+         m_sets[s].counters = Counters::fill(0);
    }
 
-   bool predict(bool indirect, IntPtr ip, IntPtr target) { LOG_PRINT_ERROR("Need pir"); }
-   BranchPredictorReturnValue lookup(IntPtr ip, IntPtr target) { LOG_PRINT_ERROR("Need pir"); }
-   void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target) { LOG_PRINT_ERROR("Need pir"); }
-
-   bool predict(bool indirect, IntPtr ip, IntPtr target, IntPtr pir)
+   // Pentium M-specific indexing and tag values
+   static Index getIndex(IntPtr ip, IntPtr pir)
    {
-      UInt32 index, tag;
-
-      gen_index_tag(ip, pir, index, tag);
-
-      for (unsigned int w = 0 ; w < m_num_ways ; ++w )
-      {
-         if (m_ways[w].m_valid[index] && m_ways[w].m_tags[index] == tag)
-         {
-            return true;
-         }
-      }
-      return false;
+      Index index = { UInt32(((ip >> 4) ^ (pir >> 6)) & (NUM_SETS - 1)), uint8_t(((ip >> 13) ^ pir) & 0x3F) };
+      return index;
    }
 
-   BranchPredictorReturnValue lookup(IntPtr ip, IntPtr target, IntPtr pir)
+   BranchPredictorReturnValue lookup(const Index &index) const
    {
-
-      UInt32 index, tag;
       BranchPredictorReturnValue ret = { 0, 0, 0, BranchPredictorReturnValue::InvalidBranch };
 
-      gen_index_tag(ip, pir, index, tag);
-
-      for (unsigned int w = 0 ; w < m_num_ways ; ++w )
+      SInt32 w = find(m_sets[index.set], index.tag);
+      if (w >= 0)
       {
-         if (m_ways[w].m_valid[index] && m_ways[w].m_tags[index] == tag)
-         {
-            ret.hit = 1;
-            ret.prediction = m_ways[w].m_predictors[index].predict();
-            break;
-         }
+         ret.hit = 1;
+         ret.prediction = Counters::predict(&m_sets[index.set].counters, w);
       }
 
       return ret;
    }
 
-   void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target, IntPtr pir)
+   void update(bool actual, const Index &index)
    {
-
-      UInt32 index, tag, lru_way;
-
-      gen_index_tag(ip, pir, index, tag);
+      Set &set = m_sets[index.set];
 
       // Start with way 0 as the least recently used
-      lru_way = 0;
+      UInt32 lru_way = 0;
 
-      for (unsigned int w = 0 ; w < m_num_ways ; ++w )
+      for (UInt32 w = 0 ; w < NUM_WAYS ; ++w )
       {
-         if (m_ways[w].m_valid[index] && m_ways[w].m_tags[index] == tag)
+         if ((set.valid & (1 << w)) && set.tags[w] == index.tag)
          {
-            m_ways[w].m_predictors[index].update(actual);
-            m_ways[w].m_lru[index] = m_lru_use_count++;
+            Counters::update(&set.counters, w, actual);
+            set.lru[w] = m_lru_use_count++;
             // Once we have a tag match and have updated the LRU information,
             // we can return
             return;
          }
 
          // Keep track of the LRU in case we do not have a tag match
-         if (m_ways[w].m_lru[index] < m_ways[lru_way].m_lru[index])
+         if (set.lru[w] < set.lru[lru_way])
          {
             lru_way = w;
          }
@@ -93,66 +83,53 @@ public:
       // We will get here only if we have not matched the tag
       // If that is the case, select the LRU entry, and update the tag
       // appropriately
-      m_ways[lru_way].m_valid[index] = true;
-      m_ways[lru_way].m_tags[index] = tag;
+      set.valid |= 1 << lru_way;
+      set.tags[lru_way] = index.tag;
       // Here, we miss with the tag, so reset instead of updating
-      m_ways[lru_way].m_predictors[index].reset(actual);
-      m_ways[lru_way].m_lru[index] = m_lru_use_count++;
+      Counters::reset(&set.counters, lru_way, actual);
+      set.lru[lru_way] = m_lru_use_count++;
    }
 
-   void evict(IntPtr ip, IntPtr pir)
+   void evict(const Index &index)
    {
-      UInt32 index, tag;
+      Set &set = m_sets[index.set];
+      SInt32 w = find(set, index.tag);
+      if (w >= 0)
+         set.valid &= ~(1 << w);
+   }
 
-      gen_index_tag(ip, pir, index, tag);
+   void saveState(CheckpointWriter &ckpt) const
+   {
+      ckpt.put(m_lru_use_count);
+      ckpt.write(m_sets, sizeof(m_sets));
+   }
 
-      for (unsigned int w = 0 ; w < m_num_ways ; ++w )
-      {
-         if (m_ways[w].m_valid[index] && m_ways[w].m_tags[index] == tag)
-         {
-            m_ways[w].m_valid[index] = false;
-            return;
-         }
-      }
-      return;
+   void loadState(CheckpointReader &ckpt)
+   {
+      ckpt.get(m_lru_use_count);
+      ckpt.read(m_sets, sizeof(m_sets));
    }
 
 private:
 
-   class Way
+   struct Set
    {
-   public:
-
-      Way(UInt32 entries, UInt32 tag_bitwidth)
-         : m_valid(entries, false)
-         , m_tags(entries, 0)
-         , m_predictors(entries, SaturatingPredictor<2>(0))
-         , m_lru(entries, 0)
-         , m_num_entries(entries)
-         , m_tag_bitwidth(tag_bitwidth)
-      {
-         assert(tag_bitwidth <= 8);
-      }
+      UInt64 lru[NUM_WAYS];
+      uint8_t tags[NUM_WAYS];
+      uint8_t valid;       // Bit per way
+      uint8_t counters;    // 2-bit counter per way
+   } __attribute__((aligned(64)));
 
-      std::vector<bool> m_valid;
-      std::vector<uint8_t> m_tags;
-      std::vector<SaturatingPredictor<2> > m_predictors;
-      std::vector<UInt64> m_lru;
-      UInt32 m_num_entries;
-      UInt32 m_tag_bitwidth;
-
-   };
-
-   // Pentium M-specific indexing and tag values
-   void gen_index_tag(IntPtr ip, IntPtr pir, UInt32& index, UInt32 &tag)
+   static SInt32 find(const Set &set, uint8_t tag)
    {
-      index = ((ip >> 4) ^ (pir >> 6)) & 0x1FF;
-      tag = ((ip >> 13) ^ pir) & 0x3F;
+      for (UInt32 w = 0 ; w < NUM_WAYS ; ++w )
+         if ((set.valid & (1 << w)) && set.tags[w] == tag)
+            return w;
+      return -1;
    }
 
    UInt64 m_lru_use_count;
-   UInt32 m_num_ways;
-   std::vector<Way> m_ways;
+   Set m_sets[NUM_SETS];
 
 };
 
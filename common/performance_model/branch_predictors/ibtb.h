@@ -4,10 +4,11 @@
 //#include <boost/scoped_array.hpp>
 
 #include "simulator.h"
-#include "branch_predictor.h"
+#include "fixed_types.h"
+#include "checkpoint.h"
 #include <vector>
 
-class IndirectBranchTargetBuffer : BranchPredictor
+class IndirectBranchTargetBuffer
 {
 
   public:
@@ -71,6 +72,26 @@ class IndirectBranchTargetBuffer : BranchPredictor
     }
   }
 
+  void saveState(CheckpointWriter &ckpt) const
+  {
+    ckpt.put(history);
+    ckpt.put(lru);
+    for (UInt32 i = 0; i < m_num_entries; i++) {
+      ckpt.put(std::get<0>(m_table[i]));
+      ckpt.put(std::get<1>(m_table[i]));
+    }
+  }
+
+  void loadState(CheckpointReader &ckpt)
+  {
+    ckpt.get(history);
+    ckpt.get(lru);
+    for (UInt32 i = 0; i < m_num_entries; i++) {
+      ckpt.get(std::get<0>(m_table[i]));
+      ckpt.get(std::get<1>(m_table[i]));
+    }
+  }
+
   private:
   UInt32 m_num_entries;
   UInt32 history;
@@ -1,13 +1,13 @@
 #ifndef LOOP_BRANCH_PREDICTOR_H
 #define LOOP_BRANCH_PREDICTOR_H
 
-#include <vector>
 #include <stdint.h>
+#include <cstring>
 
 #include "simulator.h"
-#include "branch_predictor.h"
 #include "branch_predictor_return_value.h"
 #include "saturating_predictor.h"
+#include "checkpoint.h"
 
 #define DEBUG 0
 
@@ -17,16 +17,35 @@
 # define debug_cout std::cout
 #endif
 
+// All ways of a set share one cache line: LRU stamps, loop counts and limits, tags, state bits and the packed 1-bit predictors
+template <UInt32 NUM_SETS, UInt32 NUM_WAYS>
 class LoopBranchPredictor
 {
+   static_assert(NUM_WAYS <= 8, "The predictors of a set are packed into a single byte");
+   typedef PackedSaturatingCounters<1> Counters;
 
 public:
 
-   LoopBranchPredictor(UInt32 entries, UInt32 tag_bitwidth, UInt32 ways)
+   // Set and tag of a lookup, computed once and shared by lookup() and update()
+   struct Index
+   {
+      UInt32 set;
+      uint8_t tag;
+   };
+
+   LoopBranchPredictor()
       : m_lru_use_count(0)
-      , m_num_ways(ways)
-      , m_ways(ways, Way(entries/ways, tag_bitwidth))
    {
+      memset(m_sets, 0, sizeof(m_sets));
+      for (UInt32 s = 0 ; s < NUM_SETS ; ++s)
+         m_sets[s].predictors = Counters::fill(0);
+   }
+
+   // Pentium M-specific indexing and tag values
+   static Index getIndex(IntPtr ip)
+   {
+      Index index = { UInt32((ip >> 4) & (NUM_SETS - 1)), uint8_t((ip >> 10) & 0x3F) };
+      return index;
    }
 
    // Not sure if predicted can be used
@@ -38,35 +57,33 @@ public:
       // (prediction is only valid when there is a hit)
       return false;
    }
-   BranchPredictorReturnValue lookup(IntPtr ip, IntPtr target)
+   BranchPredictorReturnValue lookup(const Index &index)
    {
 
-      UInt32 index, tag;
+      Set &set = m_sets[index.set];
       BranchPredictorReturnValue ret = { 0, 0, 0, BranchPredictorReturnValue::InvalidBranch };
 
-      gen_index_tag(ip, index, tag);
-
-      for (unsigned int w = 0 ; w < m_num_ways ; ++w )
+      for (unsigned int w = 0 ; w < NUM_WAYS ; ++w )
       {
          // When we are enabled, and we hit, we can use the value even if the count isn't set to the limit
-         if ( m_ways[w].m_enabled[index]
-           && m_ways[w].m_tags[index] == tag )
+         if ( set.enabled[w]
+           && set.tags[w] == index.tag )
          {
-            UInt32 count = m_ways[w].m_count[index];
-            UInt32 limit = m_ways[w].m_limit[index];
+            UInt32 count = set.count[w];
+            UInt32 limit = set.limit[w];
 
             ret.hit = 1;
             // 000001 -> predict() == 0; 111110 -> predict() == 1
             if (count == limit)
             {
-               ret.prediction = ! m_ways[w].m_predictors[index].predict();
+               ret.prediction = ! Counters::predict(&set.predictors, w);
             }
             else
             {
-               ret.prediction = m_ways[w].m_predictors[index].predict();
+               ret.prediction = Counters::predict(&set.predictors, w);
             }
             // Save the lru data
-            m_ways[w].m_lru[index] = m_lru_use_count++;
+            set.lru[w] = m_lru_use_count++;
             break;
          }
       }
@@ -75,27 +92,25 @@ public:
    }
 
    // 000001 -> predict() == 0; 111110 -> predict() == 1
-   void update(bool predicted, bool actual, IntPtr ip, IntPtr target)
+   void update(bool predicted, bool actual, const Index &index)
    {
 
-      UInt32 index, tag, lru_way;
-
-      gen_index_tag(ip, index, tag);
+      Set &set = m_sets[index.set];
 
       // Start with way 0 as the least recently used
-      lru_way = 0;
+      UInt32 lru_way = 0;
 
-      for (UInt32 w = 0 ; w < m_num_ways ; ++w )
+      for (UInt32 w = 0 ; w < NUM_WAYS ; ++w )
       {
-         if (m_ways[w].m_tags[index] == tag)
+         if (set.tags[w] == index.tag)
          {
 
-            bool current_prediction = m_ways[w].m_predictors[index].predict();
-            bool match = prediction_match(w, index, actual);
-            bool previous_actual = m_ways[w].m_previous_actual[index];
-            UInt32 &next_counter = m_ways[w].m_count[index];
-            UInt32 &next_limit = m_ways[w].m_limit[index];
-            uint8_t &next_enabled = m_ways[w].m_enabled[index];
+            bool current_prediction = Counters::predict(&set.predictors, w);
+            bool match = prediction_match(set, w, actual);
+            bool previous_actual = set.previous_actual[w];
+            UInt32 &next_counter = set.count[w];
+            UInt32 &next_limit = set.limit[w];
+            uint8_t &next_enabled = set.enabled[w];
             UInt32 current_counter = next_counter;
             UInt32 current_limit = next_limit;
             uint8_t current_enabled = next_enabled;
@@ -173,7 +188,7 @@ public:
 
                // Update the predictor
                //  For the 000001 (0) case, and we've seen two 1's, set the predictor to (1), ie. 111110
-               m_ways[w].m_predictors[index].update(actual);
+               Counters::update(&set.predictors, w, actual);
 
                // Disable the entry since we have just started to look in another direction
                next_enabled = false;
@@ -232,15 +247,15 @@ public:
 
 
             // Update state and LRU for our next branch
-            m_ways[w].m_previous_actual[index] = actual;
-            m_ways[w].m_lru[index] = m_lru_use_count++;
+            set.previous_actual[w] = actual;
+            set.lru[w] = m_lru_use_count++;
             // Once we have a tag match and have updated the LRU information,
             // we can return
             return;
          }
 
          // Keep track of the LRU in case we do not have a tag match
-         if (m_ways[w].m_lru[index] < m_ways[lru_way].m_lru[index])
+         if (set.lru[w] < set.lru[lru_way])
          {
             lru_way = w;
          }
@@ -249,62 +264,48 @@ public:
       // We will get here only if we have not matched the tag
       // If that is the case, select the LRU entry, and update the tag
       // appropriately
-      m_ways[lru_way].m_tags[index] = tag;
+      set.tags[lru_way] = index.tag;
       // Here, we miss with the tag, so reset instead of updating
-      m_ways[lru_way].m_predictors[index].reset(actual);
-      m_ways[lru_way].m_previous_actual[index] = actual;
-      m_ways[lru_way].m_lru[index] = m_lru_use_count++;
-      m_ways[lru_way].m_count[index] = 1;
-      m_ways[lru_way].m_limit[index] = 1;
+      Counters::reset(&set.predictors, lru_way, actual);
+      set.previous_actual[lru_way] = actual;
+      set.lru[lru_way] = m_lru_use_count++;
+      set.count[lru_way] = 1;
+      set.limit[lru_way] = 1;
 
    }
 
-private:
-
-   class Way
+   void saveState(CheckpointWriter &ckpt) const
    {
-   public:
-
-      Way(UInt32 entries, UInt32 tag_bitwidth)
-         : m_tags(entries, 0)
-         , m_previous_actual(entries, 0)
-         , m_enabled(entries, 0)
-         , m_predictors(entries, SaturatingPredictor<1>(0))
-         , m_lru(entries, 0)
-         , m_count(entries, 0)
-         , m_limit(entries, 0)
-         , m_num_entries(entries)
-         , m_tag_bitwidth(tag_bitwidth)
-      {
-         assert(tag_bitwidth <= 8);
-      }
+      ckpt.put(m_lru_use_count);
+      ckpt.write(m_sets, sizeof(m_sets));
+   }
 
-      std::vector<uint8_t> m_tags;
-      std::vector<uint8_t> m_previous_actual;
-      std::vector<uint8_t> m_enabled;
-      std::vector<SaturatingPredictor<1> > m_predictors;
-      std::vector<UInt64> m_lru;
-      std::vector<UInt32> m_count;
-      std::vector<UInt32> m_limit;
-      UInt32 m_num_entries;
-      UInt32 m_tag_bitwidth;
+   void loadState(CheckpointReader &ckpt)
+   {
+      ckpt.get(m_lru_use_count);
+      ckpt.read(m_sets, sizeof(m_sets));
+   }
 
-   };
+private:
 
-   // Pentium M-specific indexing and tag values
-   void gen_index_tag(IntPtr ip, UInt32& index, UInt32 &tag)
+   struct Set
    {
-      index = (ip >> 4) & 0x3F;
-      tag = (ip >> 10) & 0x3F;
-   }
+      UInt64 lru[NUM_WAYS];
+      UInt32 count[NUM_WAYS];
+      UInt32 limit[NUM_WAYS];
+      uint8_t tags[NUM_WAYS];
+      uint8_t previous_actual[NUM_WAYS];
+      uint8_t enabled[NUM_WAYS];
+      uint8_t predictors;  // 1-bit predictor per way
+   } __attribute__((aligned(64)));
 
    // 000001 -> predict() == 0; 111110 -> predict() == 1
-   inline bool prediction_match(UInt32 way, UInt32 index, bool actual)
+   static inline bool prediction_match(const Set &set, UInt32 way, bool actual)
    {
 
-      bool prediction = m_ways[way].m_predictors[index].predict();
-      UInt32 count = m_ways[way].m_count[index];
-      UInt32 limit = m_ways[way].m_limit[index];
+      bool prediction = Counters::predict(&set.predictors, way);
+      UInt32 count = set.count[way];
+      UInt32 limit = set.limit[way];
 
       // At our count limit
       if (count == limit)
@@ -330,8 +331,7 @@ private:
    }
 
    UInt64 m_lru_use_count;
-   UInt32 m_num_ways;
-   std::vector<Way> m_ways;
+   Set m_sets[NUM_SETS];
 
 };
 
@@ -1,58 +1,92 @@
 #include "nn_branch_predictor.h"
+#include "log.h"
 
 #include <torch/nn/cloneable.h>
 #include <torch/nn/pimpl.h>
 #include <torch/types.h>
 #include <ATen/ATen.h>
 
-torch::Tensor process_x(const std::vector<std::tuple<IntPtr, IntPtr>>& vector_x) {
-    const long N = vector_x.size();
-    torch::Tensor result = torch::zeros({N, 128}, torch::kFloat);
-    auto accessor = result.accessor<float, 2>();
-    for (long i = 0; i < N; i++) {
-        IntPtr ip = std::get<0>(vector_x[i]);
-        IntPtr target = std::get<1>(vector_x[i]);
-        for (size_t bit = 0; bit < 64; bit++) {
-            if (ip & (1ll << bit)) {
-                accessor[i][bit] = 1;
-            } else {
-                accessor[i][bit] = 0;
-            }
-        }
-        for (size_t bit = 0; bit < 64; bit++) {
-            if (target & (1ll << bit)) {
-                accessor[i][bit + 64] = 1;
-            } else {
-                accessor[i][bit + 64] = 0;
-            }
-        }
+#include <algorithm>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Expansion of every byte value into 8 floats (one per bit, LSB first)
+struct BitExpansionTable {
+    alignas(16) float lut[256][8];
+    BitExpansionTable() {
+        for (int byte = 0; byte < 256; byte++)
+            for (int bit = 0; bit < 8; bit++)
+                lut[byte][bit] = (byte & (1 << bit)) ? 1.f : 0.f;
     }
-    return result;
-}
+};
+static const BitExpansionTable bit_expansion;
 
-torch::Tensor process_y(const std::vector<bool>& vector_y) {
-    const long N = vector_y.size();
-    torch::Tensor result = torch::zeros({N}, torch::kFloat);
-    auto accessor = result.accessor<float, 1>();
-    for (long i = 0; i < N; i++) {
-        if (vector_y[i]) {
-            accessor[i] = 1;
-        } else {
-            accessor[i] = 0;
+void NNBranchPredictor::encodeFeatures(float *row, IntPtr ip, IntPtr target) {
+    const UInt64 values[2] = { (UInt64)ip, (UInt64)target };
+    for (int v = 0; v < 2; v++) {
+        for (int byte = 0; byte < 8; byte++) {
+            const float *src = bit_expansion.lut[(values[v] >> (8 * byte)) & 0xff];
+            float *dst = row + 64 * v + 8 * byte;
+#ifdef __SSE2__
+            _mm_storeu_ps(dst, _mm_load_ps(src));
+            _mm_storeu_ps(dst + 4, _mm_load_ps(src + 4));
+#else
+            memcpy(dst, src, 8 * sizeof(float));
+#endif
         }
     }
-    return result;
 }
 
-NNBranchPredictor::NNBranchPredictor(String name, core_id_t core_id, size_t batch_length, double learning_rate) : 
+NNBranchPredictor::NNBranchPredictor(String name, core_id_t core_id, size_t batch_length, double learning_rate, bool fast_inference, bool async_training) :
     BranchPredictor(name, core_id), 
     batch_length(batch_length), 
-    optimizer{model.parameters(), learning_rate} {}
+    m_fast_inference(fast_inference),
+    m_async_training(async_training),
+    optimizer{model.parameters(), learning_rate},
+    m_predict_x(torch::zeros({1, 128}, torch::kFloat)),
+    m_batch_x(torch::zeros({(long)batch_length, 128}, torch::kFloat)),
+    m_batch_y(torch::zeros({(long)batch_length}, torch::kFloat)),
+    m_batch_count(0),
+    m_weights_ready(false),
+    m_train_request(0),
+    m_train_idle(1),
+    m_quit(false),
+    m_thread(NULL)
+{
+    LOG_ASSERT_ERROR(!m_async_training || m_fast_inference, "perf_model/branch_predictor/nn_async_training requires nn_fast_inference");
+
+    snapshotWeights(m_weights);
+
+    if (m_async_training) {
+        m_train_x = torch::zeros({(long)batch_length, 128}, torch::kFloat);
+        m_train_y = torch::zeros({(long)batch_length}, torch::kFloat);
+        m_thread = _Thread::create(this);
+        m_thread->run();
+    }
+}
+
+NNBranchPredictor::~NNBranchPredictor() {
+    if (m_thread) {
+        // Wait for any in-flight training step, then tell the trainer to exit and wait until it has
+        m_train_idle.wait();
+        m_quit = true;
+        m_train_request.signal();
+        m_train_idle.wait();
+        delete m_thread;
+    }
+}
 
 bool NNBranchPredictor::predict(bool indirect, IntPtr ip, IntPtr target) {
-    std::vector<std::tuple<IntPtr, IntPtr>> vector_x = {{ip, target}};
-    torch::Tensor x = process_x(vector_x);
-    torch::Tensor y_pred= model.forward(x);
+    if (m_fast_inference) {
+        consumeWeights();
+        return forwardFast(ip, target);
+    }
+
+    torch::NoGradGuard no_grad;
+    encodeFeatures(m_predict_x.data_ptr<float>(), ip, target);
+    torch::Tensor y_pred = model.forward(m_predict_x);
     auto accessor = y_pred.accessor<float, 1>();
     if (accessor[0] > 0.5) {
         return true;
@@ -62,24 +96,118 @@ bool NNBranchPredictor::predict(bool indirect, IntPtr ip, IntPtr target) {
 }
 
 void NNBranchPredictor::update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target) {
-    updateCounters(predicted, actual);
-    batch.push_back({predicted, actual, indirect, ip, target});
-    if (batch.size() == batch_length) {
-        std::vector<std::tuple<IntPtr, IntPtr>> vector_x;
-        std::vector<bool> vector_y;
-        for (auto row : batch) {
-            vector_x.push_back({std::get<3>(row), std::get<4>(row)});
-            vector_y.push_back(std::get<1>(row));
+    BranchPredictor::update(predicted, actual, indirect, ip, target);
+
+    encodeFeatures(m_batch_x.data_ptr<float>() + 128 * m_batch_count, ip, target);
+    m_batch_y.data_ptr<float>()[m_batch_count] = actual ? 1.f : 0.f;
+
+    if (++m_batch_count == batch_length) {
+        m_batch_count = 0;
+        if (m_async_training) {
+            // At most one batch in flight: wait for the previous step, then hand over this batch
+            m_train_idle.wait();
+            consumeWeights();
+            std::swap(m_batch_x, m_train_x);
+            std::swap(m_batch_y, m_train_y);
+            m_train_request.signal();
+        } else {
+            train(m_batch_x, m_batch_y);
+            if (m_fast_inference)
+                snapshotWeights(m_weights);
         }
-        torch::Tensor x = process_x(vector_x);
-        torch::Tensor y = process_y(vector_y);
+    }
+}
 
-        optimizer.zero_grad();
-        torch::Tensor y_pred = model.forward(x);
+void NNBranchPredictor::train(torch::Tensor x, torch::Tensor y) {
+    optimizer.zero_grad();
+    torch::Tensor y_pred = model.forward(x);
+
+    torch::Tensor loss = torch::binary_cross_entropy(y_pred, y);
+    loss.backward();
+    optimizer.step();
+}
+
+void NNBranchPredictor::run() {
+    while (true) {
+        m_train_request.wait();
+        if (m_quit)
+            break;
+
+        train(m_train_x, m_train_y);
+        snapshotWeights(m_trained_weights);
+        m_weights_ready.store(true, std::memory_order_release);
+
+        m_train_idle.signal();
+    }
+    m_train_idle.signal();
+}
+
+void NNBranchPredictor::snapshotWeights(Weights &weights) {
+    torch::NoGradGuard no_grad;
+    auto w1 = model.fc1->weight.accessor<float, 2>();
+    auto b1 = model.fc1->bias.accessor<float, 1>();
+    auto w2 = model.fc2->weight.accessor<float, 2>();
+    auto b2 = model.fc2->bias.accessor<float, 1>();
+    auto w3 = model.fc3->weight.accessor<float, 2>();
+    auto b3 = model.fc3->bias.accessor<float, 1>();
+    for (int i = 0; i < 128; i++)
+        for (int j = 0; j < 8; j++)
+            weights.w1[i][j] = w1[j][i];
+    for (int j = 0; j < 8; j++)
+        weights.b1[j] = b1[j];
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 8; j++)
+            weights.w2[i][j] = w2[i][j];
+        weights.b2[i] = b2[i];
+        weights.w3[i] = w3[0][i];
+    }
+    weights.b3 = b3[0];
+}
+
+void NNBranchPredictor::consumeWeights() {
+    if (m_weights_ready.load(std::memory_order_acquire)) {
+        m_weights = m_trained_weights;
+        m_weights_ready.store(false, std::memory_order_relaxed);
+    }
+}
+
+// Fused 128-8-4-1 forward pass. The input only consists of 0/1 bits, so the first layer reduces to
+// summing the fc1 columns of all set bits. sigmoid(x) > 0.5 is equivalent to x > 0, so skip the sigmoid.
+bool NNBranchPredictor::forwardFast(IntPtr ip, IntPtr target) const {
+    const UInt64 values[2] = { (UInt64)ip, (UInt64)target };
+    float h1[8];
+#ifdef __SSE2__
+    __m128 acc0 = _mm_loadu_ps(m_weights.b1), acc1 = _mm_loadu_ps(m_weights.b1 + 4);
+    for (int v = 0; v < 2; v++) {
+        for (UInt64 bits = values[v]; bits; bits &= bits - 1) {
+            const float *col = m_weights.w1[64 * v + __builtin_ctzll(bits)];
+            acc0 = _mm_add_ps(acc0, _mm_loadu_ps(col));
+            acc1 = _mm_add_ps(acc1, _mm_loadu_ps(col + 4));
+        }
+    }
+    const __m128 zero = _mm_setzero_ps();
+    _mm_storeu_ps(h1, _mm_max_ps(acc0, zero));
+    _mm_storeu_ps(h1 + 4, _mm_max_ps(acc1, zero));
+#else
+    for (int j = 0; j < 8; j++)
+        h1[j] = m_weights.b1[j];
+    for (int v = 0; v < 2; v++) {
+        for (UInt64 bits = values[v]; bits; bits &= bits - 1) {
+            const float *col = m_weights.w1[64 * v + __builtin_ctzll(bits)];
+            for (int j = 0; j < 8; j++)
+                h1[j] += col[j];
+        }
+    }
+    for (int j = 0; j < 8; j++)
+        h1[j] = std::max(h1[j], 0.f);
+#endif
 
-        torch::Tensor loss = torch::binary_cross_entropy(y_pred, y);
-        loss.backward();
-        optimizer.step();
-        batch.clear();
+    float out = m_weights.b3;
+    for (int i = 0; i < 4; i++) {
+        float h2 = m_weights.b2[i];
+        for (int j = 0; j < 8; j++)
+            h2 += m_weights.w2[i][j] * h1[j];
+        out += m_weights.w3[i] * std::max(h2, 0.f);
     }
+    return out > 0.f;
 }
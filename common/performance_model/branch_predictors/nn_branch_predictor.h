@@ -2,8 +2,12 @@
 #define NNBRANCHPREDICTOR_H
 
 #include "branch_predictor.h"
+#include "_thread.h"
+#include "sem.h"
 #include <torch/torch.h>
 
+#include <atomic>
+
 struct BranchPredictorModel : torch::nn::Module {
   BranchPredictorModel() {
     fc1 = register_module("fc1", torch::nn::Linear(128, 8));
@@ -21,17 +25,56 @@ struct BranchPredictorModel : torch::nn::Module {
   torch::nn::Linear fc1{nullptr}, fc2{nullptr}, fc3{nullptr};
 };
 
-class NNBranchPredictor : public BranchPredictor {
+class NNBranchPredictor : public BranchPredictor, public Runnable {
 public:
-    NNBranchPredictor(String name, core_id_t core_id, size_t batch_length, double learning_rate);
+    NNBranchPredictor(String name, core_id_t core_id, size_t batch_length, double learning_rate, bool fast_inference, bool async_training);
+    ~NNBranchPredictor();
 
     bool predict(bool indirect, IntPtr ip, IntPtr target) override;
     void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target) override;
+
+    // Write the 128-float feature vector (64 ip bits followed by 64 target bits) to row
+    static void encodeFeatures(float *row, IntPtr ip, IntPtr target);
 private:
+    // Flat copy of the model parameters used by the native forward pass
+    struct Weights {
+        float w1[128][8]; // fc1, transposed: the 8 weights fed by each input bit are contiguous
+        float b1[8];
+        float w2[4][8];
+        float b2[4];
+        float w3[4];
+        float b3;
+    };
+
     const size_t batch_length;
+    const bool m_fast_inference;  // Run predict() through forwardFast() instead of libtorch
+    const bool m_async_training;  // Train on a background thread while simulation continues
     BranchPredictorModel model;
     torch::optim::Adam optimizer;
-    std::vector<std::tuple<bool, bool, bool, IntPtr, IntPtr>> batch;
+
+    // Preallocated input for predict() (libtorch path) and training batches, encoded in place
+    torch::Tensor m_predict_x;
+    torch::Tensor m_batch_x, m_batch_y;
+    size_t m_batch_count;
+
+    Weights m_weights;
+
+    // Asynchronous training: m_train_{x,y} are owned by the trainer thread between
+    // m_train_request and m_train_idle, which then publishes m_trained_weights through m_weights_ready
+    torch::Tensor m_train_x, m_train_y;
+    Weights m_trained_weights;
+    std::atomic<bool> m_weights_ready;
+    Semaphore m_train_request;
+    Semaphore m_train_idle;
+    bool m_quit;
+    _Thread *m_thread;
+
+    void train(torch::Tensor x, torch::Tensor y);
+    void snapshotWeights(Weights &weights);
+    void consumeWeights();
+    bool forwardFast(IntPtr ip, IntPtr target) const;
+
+    void run() override; // Trainer thread
 };
   
-#endif // NNBRANCHPREDICTOR_H
\ No newline at end of file
+#endif // NNBRANCHPREDICTOR_H
@@ -0,0 +1,185 @@
+#include "nn_prediction_service.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "log.h"
+
+#include <sched.h>
+
+NNPredictionService *NNPredictionService::s_instance = NULL;
+UInt32 NNPredictionService::s_references = 0;
+Lock NNPredictionService::s_lock;
+
+NNPredictionService* NNPredictionService::acquire() {
+    ScopedLock sl(s_lock);
+    if (s_references++ == 0)
+        s_instance = new NNPredictionService();
+    return s_instance;
+}
+
+void NNPredictionService::release() {
+    ScopedLock sl(s_lock);
+    if (--s_references == 0) {
+        delete s_instance;
+        s_instance = NULL;
+    }
+}
+
+// The model has to be on its device before the optimizer takes its parameters
+static std::vector<torch::Tensor> parametersOn(BranchPredictorModel &model, const torch::Device &device) {
+    model.to(device);
+    return model.parameters();
+}
+
+NNPredictionService::NNPredictionService() :
+    m_batch_length(Sim()->getCfg()->getIntArray("perf_model/branch_predictor/batch_length", 0)),
+    m_max_batch(Sim()->getCfg()->getInt("perf_model/branch_predictor/nn_shared/max_batch")),
+    m_device(Sim()->getCfg()->getString("perf_model/branch_predictor/nn_shared/device").c_str()),
+    m_optimizer{parametersOn(m_model, m_device), Sim()->getCfg()->getFloatArray("perf_model/branch_predictor/learning_rate", 0)},
+    m_infer_x(torch::zeros({(long)m_max_batch, 128}, torch::kFloat)),
+    m_rings(Sim()->getConfig()->getApplicationCores()),
+    m_sleeping(false),
+    m_wakeup(0),
+    m_quit(false),
+    m_exited(0),
+    m_thread(NULL)
+{
+    LOG_ASSERT_ERROR(m_max_batch > 0, "perf_model/branch_predictor/nn_shared/max_batch must be at least 1");
+    LOG_ASSERT_ERROR(!m_device.is_cuda() || torch::cuda::is_available(), "perf_model/branch_predictor/nn_shared/device is %s, but CUDA is not available",
+                     m_device.str().c_str());
+
+    m_thread = _Thread::create(this);
+    m_thread->run();
+}
+
+NNPredictionService::~NNPredictionService() {
+    m_quit = true;
+    m_wakeup.signal();
+    m_exited.wait();
+    delete m_thread;
+}
+
+UInt64 NNPredictionService::submit(core_id_t core_id, IntPtr ip, IntPtr target) {
+    Ring &ring = m_rings[core_id];
+    UInt64 seq = ring.head.load(std::memory_order_relaxed);
+    // Only a core with RING_SIZE unresolved requests has to wait for a slot
+    while (seq - ring.done.load(std::memory_order_acquire) >= RING_SIZE)
+        sched_yield();
+
+    Request &request = ring.requests[seq % RING_SIZE];
+    request.ip = ip;
+    request.target = target;
+    ring.head.store(seq + 1, std::memory_order_release);
+
+    wake();
+    return seq;
+}
+
+bool NNPredictionService::resolve(core_id_t core_id, UInt64 seq) {
+    Ring &ring = m_rings[core_id];
+    while (ring.done.load(std::memory_order_acquire) <= seq)
+        sched_yield();
+    return ring.requests[seq % RING_SIZE].taken;
+}
+
+void NNPredictionService::train(const float *x, const float *y, size_t count) {
+    {
+        ScopedLock sl(m_train_lock);
+        m_train_x.insert(m_train_x.end(), x, x + 128 * count);
+        m_train_y.insert(m_train_y.end(), y, y + count);
+    }
+    wake();
+}
+
+void NNPredictionService::wake() {
+    if (m_sleeping.load(std::memory_order_seq_cst) && m_sleeping.exchange(false))
+        m_wakeup.signal();
+}
+
+// Run one forward pass over the pending requests of all cores, returns false if there were none
+bool NNPredictionService::inferBatch() {
+    std::vector<std::pair<Ring*, UInt64> > rings; // Rings with requests in this batch, and where the batch ends for them
+    float *x = m_infer_x.data_ptr<float>();
+    size_t count = 0;
+
+    for (auto it = m_rings.begin(); it != m_rings.end() && count < m_max_batch; ++it) {
+        UInt64 seq = it->done.load(std::memory_order_relaxed);
+        UInt64 head = it->head.load(std::memory_order_acquire);
+        if (seq == head)
+            continue;
+        for ( ; seq < head && count < m_max_batch; ++seq, ++count) {
+            const Request &request = it->requests[seq % RING_SIZE];
+            NNBranchPredictor::encodeFeatures(x + 128 * count, request.ip, request.target);
+        }
+        rings.push_back(std::make_pair(&*it, seq));
+    }
+    if (count == 0)
+        return false;
+
+    torch::NoGradGuard no_grad;
+    torch::Tensor y_pred = m_model.forward(m_infer_x.narrow(0, 0, count).to(m_device)).to(torch::kCPU);
+    auto accessor = y_pred.accessor<float, 1>();
+
+    size_t idx = 0;
+    for (auto it = rings.begin(); it != rings.end(); ++it) {
+        Ring &ring = *it->first;
+        for (UInt64 seq = ring.done.load(std::memory_order_relaxed); seq < it->second; ++seq)
+            ring.requests[seq % RING_SIZE].taken = accessor[idx++] > 0.5;
+        ring.done.store(it->second, std::memory_order_release);
+    }
+    return true;
+}
+
+// Train on the batches handed in so far, returns false if there were none
+bool NNPredictionService::trainPending() {
+    std::vector<float> x, y;
+    {
+        ScopedLock sl(m_train_lock);
+        if (m_train_y.size() < m_batch_length)
+            return false;
+        size_t count = m_train_y.size() - m_train_y.size() % m_batch_length;
+        x.assign(m_train_x.begin(), m_train_x.begin() + 128 * count);
+        y.assign(m_train_y.begin(), m_train_y.begin() + count);
+        m_train_x.erase(m_train_x.begin(), m_train_x.begin() + 128 * count);
+        m_train_y.erase(m_train_y.begin(), m_train_y.begin() + count);
+    }
+
+    for (size_t start = 0; start < y.size(); start += m_batch_length) {
+        torch::Tensor batch_x = torch::from_blob(&x[128 * start], {(long)m_batch_length, 128}, torch::kFloat).to(m_device);
+        torch::Tensor batch_y = torch::from_blob(&y[start], {(long)m_batch_length}, torch::kFloat).to(m_device);
+
+        m_optimizer.zero_grad();
+        torch::Tensor loss = torch::binary_cross_entropy(m_model.forward(batch_x), batch_y);
+        loss.backward();
+        m_optimizer.step();
+
+        // Cores may be waiting on a prediction, don't keep them behind a long list of training steps
+        inferBatch();
+    }
+    return true;
+}
+
+void NNPredictionService::run() {
+    while (!m_quit) {
+        bool worked = inferBatch();
+        if (!worked)
+            worked = trainPending();
+        if (worked)
+            continue;
+
+        // Announce that we're going to sleep, then check once more for work submitted before the announcement
+        m_sleeping.store(true, std::memory_order_seq_cst);
+        bool pending = false;
+        for (auto it = m_rings.begin(); it != m_rings.end() && !pending; ++it)
+            pending = it->done.load(std::memory_order_relaxed) != it->head.load(std::memory_order_acquire);
+        if (!pending) {
+            ScopedLock sl(m_train_lock);
+            pending = m_train_y.size() >= m_batch_length;
+        }
+        // A wake() that raced with us leaves the semaphore signalled, which only causes an extra iteration
+        if (pending)
+            m_sleeping.store(false);
+        else if (!m_quit)
+            m_wakeup.wait();
+    }
+    m_exited.signal();
+}
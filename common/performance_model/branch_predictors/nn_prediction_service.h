@@ -0,0 +1,81 @@
+#ifndef NNPREDICTIONSERVICE_H
+#define NNPREDICTIONSERVICE_H
+
+#include "nn_branch_predictor.h"
+#include "_thread.h"
+#include "sem.h"
+#include "lock.h"
+
+#include <atomic>
+#include <vector>
+
+// One model shared by the NNSharedBranchPredictors of all cores. Cores submit prediction requests into their own
+// single-producer ring; a worker thread collects the pending requests of all cores into a single forward pass
+// (optionally on a GPU), and runs the training steps for the batches cores hand in between inference batches.
+class NNPredictionService : public Runnable {
+public:
+    // Reference-counted instance, created by the first core and destroyed with the last
+    static NNPredictionService* acquire();
+    static void release();
+
+    // Ring capacity, the largest number of outstanding requests per core
+    static const UInt64 RING_SIZE = 64;
+
+    // Queue a prediction for (ip, target), returns its sequence number on this core
+    UInt64 submit(core_id_t core_id, IntPtr ip, IntPtr target);
+    // Wait for the outcome of a request submitted by this core
+    bool resolve(core_id_t core_id, UInt64 seq);
+    // Hand in count training samples (encoded features and outcomes), copied before returning
+    void train(const float *x, const float *y, size_t count);
+
+    size_t getBatchLength() const { return m_batch_length; }
+
+private:
+    struct Request {
+        IntPtr ip;
+        IntPtr target;
+        bool taken;
+    };
+    struct Ring {
+        Request requests[RING_SIZE];
+        std::atomic<UInt64> head;  // Next sequence number to submit, written by the core
+        std::atomic<UInt64> done;  // All sequence numbers below this are resolved, written by the worker
+        char padding[64];
+        Ring() : head(0), done(0) {}
+    };
+
+    static NNPredictionService *s_instance;
+    static UInt32 s_references;
+    static Lock s_lock;
+
+    const size_t m_batch_length;
+    const size_t m_max_batch;
+    torch::Device m_device;
+    BranchPredictorModel m_model;
+    torch::optim::Adam m_optimizer;
+    torch::Tensor m_infer_x;  // Inference batch, encoded in place on the host
+
+    std::vector<Ring> m_rings;
+
+    // Training batches handed in by the cores, not yet trained on
+    Lock m_train_lock;
+    std::vector<float> m_train_x, m_train_y;
+
+    // The worker sleeps on m_wakeup when it finds no work, submitters only signal it if it does
+    std::atomic<bool> m_sleeping;
+    Semaphore m_wakeup;
+    std::atomic<bool> m_quit;
+    Semaphore m_exited;
+    _Thread *m_thread;
+
+    NNPredictionService();
+    ~NNPredictionService();
+
+    void wake();
+    bool inferBatch();
+    bool trainPending();
+
+    void run() override; // Worker thread
+};
+
+#endif // NNPREDICTIONSERVICE_H
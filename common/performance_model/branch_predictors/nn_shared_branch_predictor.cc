@@ -0,0 +1,50 @@
+#include "nn_shared_branch_predictor.h"
+#include "nn_prediction_service.h"
+#include "log.h"
+
+NNSharedBranchPredictor::NNSharedBranchPredictor(String name, core_id_t core_id, UInt32 delay) :
+    BranchPredictor(name, core_id),
+    m_core(core_id),
+    m_delay(delay),
+    m_service(NNPredictionService::acquire()),
+    m_outcomes(TABLE_SIZE, Entry()),
+    m_batch_x(128 * m_service->getBatchLength()),
+    m_batch_y(m_service->getBatchLength()),
+    m_batch_count(0)
+{
+    LOG_ASSERT_ERROR(m_delay < NNPredictionService::RING_SIZE, "perf_model/branch_predictor/nn_shared/delay must be less than %ld",
+                     NNPredictionService::RING_SIZE);
+}
+
+NNSharedBranchPredictor::~NNSharedBranchPredictor() {
+    NNPredictionService::release();
+}
+
+bool NNSharedBranchPredictor::predict(bool indirect, IntPtr ip, IntPtr target) {
+    UInt64 seq = m_service->submit(m_core, ip, target);
+    if (m_delay == 0)
+        return m_service->resolve(m_core, seq);
+
+    m_outstanding.push_back(std::make_pair(ip, seq));
+    if (m_outstanding.size() > m_delay) {
+        Entry &entry = m_outcomes[m_outstanding.front().first % TABLE_SIZE];
+        entry.ip = m_outstanding.front().first;
+        entry.taken = m_service->resolve(m_core, m_outstanding.front().second);
+        m_outstanding.pop_front();
+    }
+
+    const Entry &entry = m_outcomes[ip % TABLE_SIZE];
+    return entry.ip == ip && entry.taken;
+}
+
+void NNSharedBranchPredictor::update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target) {
+    BranchPredictor::update(predicted, actual, indirect, ip, target);
+
+    NNBranchPredictor::encodeFeatures(&m_batch_x[128 * m_batch_count], ip, target);
+    m_batch_y[m_batch_count] = actual ? 1.f : 0.f;
+
+    if (++m_batch_count == m_batch_y.size()) {
+        m_batch_count = 0;
+        m_service->train(m_batch_x.data(), m_batch_y.data(), m_batch_y.size());
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef NNSHAREDBRANCHPREDICTOR_H
+#define NNSHAREDBRANCHPREDICTOR_H
+
+#include "branch_predictor.h"
+
+#include <deque>
+#include <vector>
+
+class NNPredictionService;
+
+// NN branch predictor backed by the model of the NNPredictionService, shared by all cores.
+// With a delay of N branches, the outcome of a prediction request is only used N branches after it was made:
+// meanwhile the branch is predicted with the most recent outcome the service returned for its ip.
+class NNSharedBranchPredictor : public BranchPredictor {
+public:
+    NNSharedBranchPredictor(String name, core_id_t core_id, UInt32 delay);
+    ~NNSharedBranchPredictor();
+
+    bool predict(bool indirect, IntPtr ip, IntPtr target) override;
+    void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target) override;
+
+private:
+    static const UInt32 TABLE_SIZE = 4096;
+    struct Entry {
+        IntPtr ip;
+        bool taken;
+    };
+
+    const core_id_t m_core;
+    const UInt32 m_delay;
+    NNPredictionService *m_service;
+
+    std::deque<std::pair<IntPtr, UInt64> > m_outstanding; // (ip, sequence number) of unresolved requests, oldest first
+    std::vector<Entry> m_outcomes;                        // Resolved outcomes, direct-mapped on ip
+
+    // Training samples, handed to the service once a batch is complete
+    std::vector<float> m_batch_x, m_batch_y;
+    size_t m_batch_count;
+};
+
+#endif // NNSHAREDBRANCHPREDICTOR_H
@@ -1,5 +1,6 @@
 #include "simulator.h"
 #include "one_bit_branch_predictor.h"
+#include "checkpoint.h"
 
 OneBitBranchPredictor::OneBitBranchPredictor(String name, core_id_t core_id, UInt32 size)
    : BranchPredictor(name, core_id)
@@ -19,7 +20,17 @@ bool OneBitBranchPredictor::predict(bool indirect, IntPtr ip, IntPtr target)
 
 void OneBitBranchPredictor::update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target)
 {
-   updateCounters(predicted, actual);
+   BranchPredictor::update(predicted, actual, indirect, ip, target);
    UInt32 index = ip % m_bits.size();
    m_bits[index] = actual;
 }
+
+void OneBitBranchPredictor::saveState(CheckpointWriter &ckpt) const
+{
+   ckpt.put(m_bits);
+}
+
+void OneBitBranchPredictor::loadState(CheckpointReader &ckpt)
+{
+   ckpt.get(m_bits);
+}
@@ -14,6 +14,9 @@ public:
    bool predict(bool indirect, IntPtr ip, IntPtr target);
    void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target);
 
+   void saveState(CheckpointWriter &ckpt) const;
+   void loadState(CheckpointReader &ckpt);
+
 private:
    std::vector<bool> m_bits;
 };
@@ -3,20 +3,8 @@
 
 #include "simple_bimodal_table.h"
 
-class PentiumMBimodalTable
-   : public SimpleBimodalTable
-{
-
-public:
-
-   // The Pentium M Global Branch Predictor
-   // 512-entries
-   // 6 tag bits per entry
-   // 4-way set associative
-   PentiumMBimodalTable()
-      : SimpleBimodalTable(4096)
-   {}
-
-};
+// The Pentium M Bimodal Table
+// 4096 2-bit counters
+typedef SimpleBimodalTable<4096> PentiumMBimodalTable;
 
 #endif /* PENTIUM_M_BIMODAL_TABLE */
@@ -1,6 +1,7 @@
 
 #include "simulator.h"
 #include "pentium_m_branch_predictor.h"
+#include "checkpoint.h"
 
 PentiumMBranchPredictor::PentiumMBranchPredictor(String name, core_id_t core_id)
    : BranchPredictor(name, core_id)
@@ -8,19 +9,37 @@ PentiumMBranchPredictor::PentiumMBranchPredictor(String name, core_id_t core_id)
    , m_last_gp_hit(false)
    , m_last_lpb_hit(false)
 {
+   // Force computing the indexes on the first lookup
+   m_lookup.ip = ~IntPtr(0);
+   m_lookup.pir = ~IntPtr(0);
 }
 
 PentiumMBranchPredictor::~PentiumMBranchPredictor()
 {
 }
 
+const PentiumMBranchPredictor::Lookup &PentiumMBranchPredictor::getLookup(IntPtr ip)
+{
+   if (ip != m_lookup.ip || m_pir != m_lookup.pir)
+   {
+      m_lookup.ip = ip;
+      m_lookup.pir = m_pir;
+      m_lookup.global = PentiumMGlobalPredictor::getIndex(ip, m_pir);
+      m_lookup.btb = PentiumMBranchTargetBuffer::getIndex(ip);
+      m_lookup.lpb = PentiumMLoopBranchPredictor::getIndex(ip);
+      m_lookup.bimodal = PentiumMBimodalTable::getIndex(ip);
+   }
+   return m_lookup;
+}
+
 bool PentiumMBranchPredictor::predict(bool indirect, IntPtr ip, IntPtr target)
 {
-   BranchPredictorReturnValue global_pred_out = m_global_predictor.lookup(ip, target, m_pir);
-   BranchPredictorReturnValue btb_out = m_btb.lookup(ip, target);
-   BranchPredictorReturnValue lpb_out = m_lpb.lookup(ip, target);
-   
-   bool bimodal_out = m_bimodal_table.predict(indirect, ip, target);
+   const Lookup &lookup = getLookup(ip);
+   BranchPredictorReturnValue global_pred_out = m_global_predictor.lookup(lookup.global);
+   BranchPredictorReturnValue btb_out = m_btb.lookup(lookup.btb);
+   BranchPredictorReturnValue lpb_out = m_lpb.lookup(lookup.lpb);
+
+   bool bimodal_out = m_bimodal_table.predict(lookup.bimodal);
 
    m_last_gp_hit = global_pred_out.hit;
    m_last_bm_pred = bimodal_out;
@@ -55,25 +74,52 @@ void PentiumMBranchPredictor::update(bool predicted, bool actual, bool indirect,
    
    // PaulRosu@ULBS: counters already updated in BranchPredictor::update()
    // updateCounters(predicted, actual);
+   const Lookup &lookup = getLookup(ip);
    ibtb.update(predicted,actual,indirect,ip,target);
-   m_btb.update(predicted, actual, indirect, ip, target);
-   m_lpb.update(predicted, actual, ip, target);
+   m_btb.update(lookup.btb);
+   m_lpb.update(predicted, actual, lookup.lpb);
    if (!m_last_gp_hit && !m_last_lpb_hit) // Update bimodal predictor only when global and loop predictors missed
-      m_bimodal_table.update(predicted, actual, indirect, ip, target);
+      m_bimodal_table.update(actual, lookup.bimodal);
    bool lpb_or_bm_hit = m_last_lpb_hit || m_last_bm_pred == actual; // Global should only allocate when no loop predictor hit and bimodal was wrong
    if (m_last_gp_hit)
    {
       if (predicted != actual && lpb_or_bm_hit) // Evict from global when mispredict and loop or bimodal hit
-         m_global_predictor.evict(ip, m_pir);
+         m_global_predictor.evict(lookup.global);
       else
-         m_global_predictor.update(predicted, actual, indirect, ip, target, m_pir);
+         m_global_predictor.update(actual, lookup.global);
    }
    else if (predicted != actual && (m_last_gp_hit || !lpb_or_bm_hit)) // Update on mispredict, but don't allocate when loop or bimodal hit
-      m_global_predictor.update(predicted, actual, indirect, ip, target, m_pir);
+      m_global_predictor.update(actual, lookup.global);
    // TODO FIXME: Properly propagate the branch type information from the decoder (IndirectBranch information)
    update_pir(actual, ip, target, BranchPredictorReturnValue::ConditionalBranch);
 }
 
+void PentiumMBranchPredictor::saveState(CheckpointWriter &ckpt) const
+{
+   m_global_predictor.saveState(ckpt);
+   m_btb.saveState(ckpt);
+   m_bimodal_table.saveState(ckpt);
+   m_lpb.saveState(ckpt);
+   ibtb.saveState(ckpt);
+   ckpt.put(m_pir);
+   ckpt.put(m_last_gp_hit);
+   ckpt.put(m_last_bm_pred);
+   ckpt.put(m_last_lpb_hit);
+}
+
+void PentiumMBranchPredictor::loadState(CheckpointReader &ckpt)
+{
+   m_global_predictor.loadState(ckpt);
+   m_btb.loadState(ckpt);
+   m_bimodal_table.loadState(ckpt);
+   m_lpb.loadState(ckpt);
+   ibtb.loadState(ckpt);
+   ckpt.get(m_pir);
+   ckpt.get(m_last_gp_hit);
+   ckpt.get(m_last_bm_pred);
+   ckpt.get(m_last_lpb_hit);
+}
+
 void PentiumMBranchPredictor::update_pir(bool actual, IntPtr ip, IntPtr target, BranchPredictorReturnValue::BranchType branch_type)
 {
    IntPtr rhs;
@@ -21,11 +21,28 @@ public:
 
    void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target);
 
+   void saveState(CheckpointWriter &ckpt) const;
+   void loadState(CheckpointReader &ckpt);
+
 private:
 
    void update_pir(bool actual, IntPtr ip, IntPtr target, BranchPredictorReturnValue::BranchType branch_type);
    IntPtr hash_function(IntPtr ip, IntPtr pir);
 
+   // Table indexes of the last prediction, reused by the update of the same branch
+   struct Lookup
+   {
+      IntPtr ip;
+      IntPtr pir;
+      PentiumMGlobalPredictor::Index global;
+      PentiumMBranchTargetBuffer::Index btb;
+      PentiumMLoopBranchPredictor::Index lpb;
+      UInt32 bimodal;
+   };
+   const Lookup &getLookup(IntPtr ip);
+
+   // All tables live inside this object, each set on its own cache line
+   Lookup m_lookup;
    PentiumMGlobalPredictor m_global_predictor;
    PentiumMBranchTargetBuffer m_btb;
    PentiumMBimodalTable m_bimodal_table;
@@ -1,15 +1,16 @@
 #ifndef PENTIUM_M_BRANCH_TARGET_BUFFER_H
 #define PENTIUM_M_BRANCH_TARGET_BUFFER_H
 
-#include <vector>
+#include <cstring>
 
-#include "branch_predictor.h"
+#include "branch_predictor_return_value.h"
+#include "checkpoint.h"
 
-#define NUM_WAYS 4
-#define NUM_ENTRIES 512
-
-class PentiumMBranchTargetBuffer : BranchPredictor
+class PentiumMBranchTargetBuffer
 {
+   static const UInt32 NUM_WAYS = 4;
+   static const UInt32 NUM_ENTRIES = 512;
+
    #define IP_TO_INDEX(_ip) ((_ip >> 4) & 0x1ff)
 
    #define TAG_OFFSET_MASK 0x3fe00f
@@ -17,37 +18,40 @@ class PentiumMBranchTargetBuffer : BranchPredictor
    // offset = ip[3:0] (4 bits)
    // index = ip[12:4] (9 bits), 512 entries
    // tag = ip[21:13] (9 bits)
-   class Way
+   // All ways of a set share one cache line
+   struct Set
    {
-   public:
-      Way()
-         : m_tag_offset(NUM_ENTRIES, 0)
-         , m_plru(NUM_ENTRIES, 0)
-      {}
-
-      std::vector<UInt32> m_tag_offset; // tag and offset data
-      std::vector<UInt64> m_plru; // Should be pseudo-LRU, using LRU instead
-   };
+      UInt32 tag_offset[NUM_WAYS]; // tag and offset data
+      UInt64 plru[NUM_WAYS]; // Should be pseudo-LRU, using LRU instead
+   } __attribute__((aligned(64)));
 
 public:
+   // Set and tag of a lookup, computed once and shared by lookup() and update()
+   struct Index
+   {
+      UInt32 set;
+      UInt32 tag_offset;
+   };
+
    PentiumMBranchTargetBuffer()
-      : m_ways(NUM_WAYS)
-      , m_lru_use_count(0)
-   {}
+      : m_lru_use_count(0)
+   {
+      memset(m_sets, 0, sizeof(m_sets));
+   }
 
-   bool predict(bool indirect, IntPtr ip, IntPtr target)
+   static Index getIndex(IntPtr ip)
    {
-      return false;
+      Index index = { UInt32(IP_TO_INDEX(ip)), UInt32(IP_TO_TAGOFF(ip)) };
+      return index;
    }
 
-   BranchPredictorReturnValue lookup(IntPtr ip, IntPtr target)
+   BranchPredictorReturnValue lookup(const Index &index) const
    {
       bool hit = false;
-      UInt32 tag_offset = IP_TO_TAGOFF(ip);
-      UInt32 index = IP_TO_INDEX(ip);
+      const Set &set = m_sets[index.set];
       for (UInt32 i = 0 ; i < NUM_WAYS ; i++)
       {
-         if (m_ways[i].m_tag_offset[index] == tag_offset)
+         if (set.tag_offset[i] == index.tag_offset)
          {
             hit = true;
             break;
@@ -59,25 +63,25 @@ public:
       return ret;
    }
 
-   void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target)
+   void update(const Index &index)
    {
+      Set &set = m_sets[index.set];
+
       // Start with way 0 as the least recently used
       UInt32 lru_way = 0;
 
-      UInt32 tag_offset = IP_TO_TAGOFF(ip);
-      UInt32 index = IP_TO_INDEX(ip);
       for (unsigned int w = 0 ; w < NUM_WAYS ; ++w )
       {
-         if (m_ways[w].m_tag_offset[index] == tag_offset)
+         if (set.tag_offset[w] == index.tag_offset)
          {
-            m_ways[w].m_plru[index] = m_lru_use_count++;
+            set.plru[w] = m_lru_use_count++;
             // Once we have a tag match and have updated the LRU information,
             // we can return
             return;
          }
 
          // Keep track of the LRU in case we do not have a tag match
-         if (m_ways[w].m_plru[index] < m_ways[lru_way].m_plru[index])
+         if (set.plru[w] < set.plru[lru_way])
          {
             lru_way = w;
          }
@@ -86,15 +90,26 @@ public:
       // We will get here only if we have not matched the tag
       // If that is the case, select the LRU entry, and update the tag
       // appropriately
-      m_ways[lru_way].m_tag_offset[index] = tag_offset;
-      m_ways[lru_way].m_plru[index] = m_lru_use_count++;
+      set.tag_offset[lru_way] = index.tag_offset;
+      set.plru[lru_way] = m_lru_use_count++;
+   }
+
+   void saveState(CheckpointWriter &ckpt) const
+   {
+      ckpt.put(m_lru_use_count);
+      ckpt.write(m_sets, sizeof(m_sets));
+   }
+
+   void loadState(CheckpointReader &ckpt)
+   {
+      ckpt.get(m_lru_use_count);
+      ckpt.read(m_sets, sizeof(m_sets));
    }
 
 private:
-   std::vector<Way> m_ways;
    UInt64 m_lru_use_count;
+   Set m_sets[NUM_ENTRIES];
 
 };
 
 #endif /* PENTIUM_M_BRANCH_TARGET_BUFFER_H */
-
@@ -3,20 +3,10 @@
 
 #include "global_predictor.h"
 
-class PentiumMGlobalPredictor
-   : public GlobalPredictor
-{
-
-public:
-
-   // The Pentium M Global Branch Predictor
-   // 512-entries
-   // 6 tag bits per entry
-   // 4-way set associative
-   PentiumMGlobalPredictor()
-      : GlobalPredictor(2048, 6, 4)
-   {}
-
-};
+// The Pentium M Global Branch Predictor
+// 2048 entries
+// 6 tag bits per entry
+// 4-way set associative
+typedef GlobalPredictor<512, 4> PentiumMGlobalPredictor;
 
 #endif /* PENTIUM_M_GLOBAL_PREDICTOR */
@@ -1,20 +1,12 @@
+
 #ifndef PENTIUM_M_LOOP_BRANCH_PREDICTOR
 #define PENTIUM_M_LOOP_BRANCH_PREDICTOR
 
 #include "lpb.h"
 
-class PentiumMLoopBranchPredictor : public LoopBranchPredictor
-{
-
-public:
-
-   // 128 entries
-   // 6 bit tag
-   // 2 ways
-   PentiumMLoopBranchPredictor()
-      : LoopBranchPredictor(128, 6, 2)
-   {}
-
-};
+// 128 entries
+// 6 bit tag
+// 2 ways
+typedef LoopBranchPredictor<64, 2> PentiumMLoopBranchPredictor;
 
 #endif /* PENTIUM_M_LOOP_BRANCH_PREDICTOR */
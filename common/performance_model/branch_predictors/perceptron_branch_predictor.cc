@@ -0,0 +1,116 @@
+#include "simulator.h"
+#include "perceptron_branch_predictor.h"
+#include "log.h"
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+PerceptronBranchPredictor::PerceptronBranchPredictor(String name, core_id_t core_id, UInt32 size, UInt32 history_length)
+   : BranchPredictor(name, core_id)
+   , m_size(size)
+   , m_history_length(history_length)
+   , m_stride((history_length + 1 + 15) & ~15)
+   // Optimal training threshold as found by Jimenez & Lin
+   , m_threshold(SInt32(1.93 * history_length + 14))
+   , m_weights(size * m_stride, 0)
+   , m_history(m_stride, 0)
+   , m_last_ip(0)
+   , m_last_output(0)
+{
+   LOG_ASSERT_ERROR(size > 0, "Perceptron branch predictor needs at least one entry");
+   LOG_ASSERT_ERROR(history_length > 0, "Perceptron branch predictor needs a non-zero history length");
+
+   m_history[0] = 1;
+   for(UInt32 i = 1; i <= m_history_length; ++i)
+      m_history[i] = -1;
+}
+
+PerceptronBranchPredictor::~PerceptronBranchPredictor()
+{
+}
+
+SInt32 PerceptronBranchPredictor::computeOutput(IntPtr ip) const
+{
+   const SInt8 *w = &m_weights[getIndex(ip) * m_stride];
+   const SInt8 *h = &m_history[0];
+#ifdef __SSE2__
+   // Sign-extend to 16 bits and multiply-accumulate into 32-bit lanes
+   __m128i acc = _mm_setzero_si128();
+   for(UInt32 i = 0; i < m_stride; i += 16)
+   {
+      __m128i vw = _mm_loadu_si128((const __m128i*)(w + i));
+      __m128i vh = _mm_loadu_si128((const __m128i*)(h + i));
+      __m128i w_lo = _mm_srai_epi16(_mm_unpacklo_epi8(vw, vw), 8), w_hi = _mm_srai_epi16(_mm_unpackhi_epi8(vw, vw), 8);
+      __m128i h_lo = _mm_srai_epi16(_mm_unpacklo_epi8(vh, vh), 8), h_hi = _mm_srai_epi16(_mm_unpackhi_epi8(vh, vh), 8);
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(w_lo, h_lo));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(w_hi, h_hi));
+   }
+   acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+   acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+   return _mm_cvtsi128_si32(acc);
+#else
+   SInt32 output = 0;
+   for(UInt32 i = 0; i < m_stride; ++i)
+      output += SInt32(w[i]) * SInt32(h[i]);
+   return output;
+#endif
+}
+
+bool PerceptronBranchPredictor::predict(bool indirect, IntPtr ip, IntPtr target)
+{
+   m_last_ip = ip;
+   m_last_output = computeOutput(ip);
+   return m_last_output >= 0;
+}
+
+void PerceptronBranchPredictor::update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target)
+{
+   BranchPredictor::update(predicted, actual, indirect, ip, target);
+
+   SInt32 output = ip == m_last_ip ? m_last_output : computeOutput(ip);
+
+   if ((output >= 0) != actual || std::abs(output) <= m_threshold)
+   {
+      // Move every weight towards agreeing with the outcome: +h[i] when taken, -h[i] when not taken, saturating at int8 range
+      SInt8 *w = &m_weights[getIndex(ip) * m_stride];
+      const SInt8 *h = &m_history[0];
+#ifdef __SSE2__
+      for(UInt32 i = 0; i < m_stride; i += 16)
+      {
+         __m128i vw = _mm_loadu_si128((const __m128i*)(w + i));
+         __m128i vh = _mm_loadu_si128((const __m128i*)(h + i));
+         vw = actual ? _mm_adds_epi8(vw, vh) : _mm_subs_epi8(vw, vh);
+         _mm_storeu_si128((__m128i*)(w + i), vw);
+      }
+#else
+      for(UInt32 i = 0; i < m_stride; ++i)
+      {
+         SInt32 v = SInt32(w[i]) + (actual ? h[i] : -h[i]);
+         w[i] = std::max(-128, std::min(127, v));
+      }
+#endif
+   }
+
+   // Shift the new outcome into the most recent history position
+   memmove(&m_history[2], &m_history[1], m_history_length - 1);
+   m_history[1] = actual ? 1 : -1;
+   m_last_ip = 0;
+}
+
+void PerceptronBranchPredictor::saveState(CheckpointWriter &ckpt) const
+{
+   ckpt.put(m_weights);
+   ckpt.put(m_history);
+}
+
+void PerceptronBranchPredictor::loadState(CheckpointReader &ckpt)
+{
+   ckpt.get(m_weights);
+   ckpt.get(m_history);
+   m_last_ip = 0;
+}
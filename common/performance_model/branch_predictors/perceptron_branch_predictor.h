@@ -0,0 +1,40 @@
+#ifndef PERCEPTRON_BRANCH_PREDICTOR_H
+#define PERCEPTRON_BRANCH_PREDICTOR_H
+
+#include "branch_predictor.h"
+
+#include <vector>
+
+// Global-history perceptron predictor (Jimenez & Lin, HPCA 2001) with hashed PC indexing.
+// Each table row holds a bias weight plus one weight per history bit, stored as saturating int8
+// values in one contiguous array. Rows are padded to a multiple of 16 weights so prediction
+// (the dot product with the +1/-1 history) and training can be done 16 weights at a time.
+
+class PerceptronBranchPredictor : public BranchPredictor
+{
+public:
+   PerceptronBranchPredictor(String name, core_id_t core_id, UInt32 size, UInt32 history_length);
+   ~PerceptronBranchPredictor();
+
+   bool predict(bool indirect, IntPtr ip, IntPtr target);
+   void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target);
+
+   void saveState(CheckpointWriter &ckpt) const;
+   void loadState(CheckpointReader &ckpt);
+
+private:
+   const UInt32 m_size;
+   const UInt32 m_history_length;
+   const UInt32 m_stride;      // Weights per row, including bias and padding
+   const SInt32 m_threshold;   // Keep training while |output| <= threshold
+   std::vector<SInt8> m_weights;
+   std::vector<SInt8> m_history; // [0] = +1 (bias input), [1..history_length] = +1 taken / -1 not-taken, padding = 0
+
+   IntPtr m_last_ip;
+   SInt32 m_last_output;
+
+   UInt32 getIndex(IntPtr ip) const { return (ip ^ (ip >> 16)) % m_size; }
+   SInt32 computeOutput(IntPtr ip) const;
+};
+
+#endif
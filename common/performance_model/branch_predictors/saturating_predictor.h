@@ -103,4 +103,52 @@ private:
 
 };
 
+// Saturating counters of n bits packed 8/n to a byte, for predictor tables that should stay small in the host cache.
+// Behaves like SaturatingPredictor<n>, the signed counter value v is stored as v + 2^(n-1).
+template <unsigned n>
+class PackedSaturatingCounters
+{
+   static_assert(n == 1 || n == 2 || n == 4, "Packed counters must evenly divide a byte");
+
+public:
+
+   static const UInt32 PER_BYTE = 8 / n;
+   static const uint8_t MAX = (1 << n) - 1;
+   static const uint8_t BIAS = 1 << (n - 1);
+
+   static UInt32 bytes(UInt32 entries) { return (entries + PER_BYTE - 1) / PER_BYTE; }
+   // Byte with all counters set to signed value v
+   static uint8_t fill(int8_t v)
+   {
+      uint8_t byte = 0;
+      for (UInt32 i = 0; i < PER_BYTE; ++i)
+         byte |= uint8_t(v + BIAS) << (i * n);
+      return byte;
+   }
+
+   static uint8_t get(const uint8_t *counters, UInt32 i)
+   {
+      return (counters[i / PER_BYTE] >> ((i % PER_BYTE) * n)) & MAX;
+   }
+   static void set(uint8_t *counters, UInt32 i, uint8_t biased)
+   {
+      UInt32 shift = (i % PER_BYTE) * n;
+      counters[i / PER_BYTE] = (counters[i / PER_BYTE] & ~(MAX << shift)) | (biased << shift);
+   }
+
+   static bool predict(const uint8_t *counters, UInt32 i) { return get(counters, i) >= BIAS; }
+
+   // Make this counter strongly favor the given direction
+   static void reset(uint8_t *counters, UInt32 i, bool prediction) { set(counters, i, prediction ? MAX : 0); }
+
+   static void update(uint8_t *counters, UInt32 i, bool actual)
+   {
+      uint8_t value = get(counters, i);
+      if (actual && value != MAX)
+         set(counters, i, value + 1);
+      else if (!actual && value != 0)
+         set(counters, i, value - 1);
+   }
+};
+
 #endif /* SATURATING_PREDICTOR_H */
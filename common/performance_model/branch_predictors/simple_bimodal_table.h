@@ -1,69 +1,57 @@
 #ifndef BIMODAL_TABLE_H
 #define BIMODAL_TABLE_H
 
-#include <boost/scoped_array.hpp>
 #include "simulator.h"
-#include "branch_predictor.h"
 #include "saturating_predictor.h"
+#include "checkpoint.h"
 
-class SimpleBimodalTable : BranchPredictor
+#include <cstring>
+
+// Table of 2-bit counters indexed by the low instruction pointer bits, packed four to a byte
+template <UInt32 ENTRIES>
+class SimpleBimodalTable
 {
+   static_assert((ENTRIES & (ENTRIES - 1)) == 0, "Bimodal table size must be a power of two");
+   typedef PackedSaturatingCounters<2> Counters;
 
 public:
 
-   SimpleBimodalTable(UInt32 entries)
-      : m_num_entries(entries)
-      , m_table(entries, 0)
+   SimpleBimodalTable()
    {
       reset();
-      m_mask = 0;
-      for (unsigned int i = 0 ; i < ilog2(m_num_entries) ; i++)
-      {
-         m_mask |= (1L<<i);
-      }
    }
 
-   bool predict(bool indirect, IntPtr ip, IntPtr target)
+   static UInt32 getIndex(IntPtr ip) { return ip & (ENTRIES - 1); }
+
+   bool predict(UInt32 index) const
    {
-      UInt32 index = ip & m_mask;
-      return (m_table[index].predict());
+      return Counters::predict(m_table, index);
    }
 
-   void update(bool predicted, bool actual, bool indirect, IntPtr ip, IntPtr target)
+   void update(bool actual, UInt32 index)
    {
-      UInt32 index = ip & m_mask;
-      if (actual)
-      {
-         ++m_table[index];
-      }
-      else
-      {
-         --m_table[index];
-      }
+      Counters::update(m_table, index, actual);
    }
 
    void reset()
    {
-      for (unsigned int i = 0 ; i < m_num_entries ; i++) {
-         m_table[i].reset();
-      }
+      // All counters favor not-taken
+      memset(m_table, Counters::fill(-2), sizeof(m_table));
    }
 
-private:
+   void saveState(CheckpointWriter &ckpt) const
+   {
+      ckpt.write(m_table, sizeof(m_table));
+   }
 
-   template<typename Addr>
-   Addr ilog2(Addr n)
+   void loadState(CheckpointReader &ckpt)
    {
-      Addr i;
-      for(i=0;n>0;n>>=1,i++) {}
-      return i-1;
+      ckpt.read(m_table, sizeof(m_table));
    }
 
 private:
 
-   UInt32 m_num_entries;
-   IntPtr m_mask;
-   std::vector<SaturatingPredictor<2> > m_table;
+   uint8_t m_table[ENTRIES / Counters::PER_BYTE] __attribute__((aligned(64)));
 
 };
 
@@ -0,0 +1,27 @@
+#include "branch_trace.h"
+#include "log.h"
+
+BranchTrace::Writer::Writer(String filename, core_id_t core_id)
+   : m_fp(fopen(filename.c_str(), "wb"))
+   , m_buffer(new Record[BUFFER_RECORDS])
+   , m_count(0)
+{
+   LOG_ASSERT_ERROR(m_fp, "Cannot write branch trace %s", filename.c_str());
+
+   Header header = { MAGIC, VERSION, UInt32(core_id), sizeof(Record) };
+   fwrite(&header, sizeof(header), 1, m_fp);
+}
+
+BranchTrace::Writer::~Writer()
+{
+   flush();
+   fclose(m_fp);
+   delete [] m_buffer;
+}
+
+void BranchTrace::Writer::flush()
+{
+   if (m_count)
+      fwrite(m_buffer, sizeof(Record), m_count, m_fp);
+   m_count = 0;
+}
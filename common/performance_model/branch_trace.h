@@ -0,0 +1,79 @@
+#ifndef BRANCH_TRACE_H
+#define BRANCH_TRACE_H
+
+#include "fixed_types.h"
+
+#include <cstdio>
+
+// Binary branch traces ([branch_trace/enabled]), one file per core, for replaying branch predictors and core-state
+// predictors offline (lib/sniper-branch-replay) instead of re-running the timing model.
+// A file is a Header followed by fixed-size Records: one for every branch the core resolved, and one for every
+// change of the core's state, in the order they happened.
+namespace BranchTrace
+{
+   const UInt32 MAGIC = 0x52544253; // "SBTR"
+   const UInt32 VERSION = 1;
+
+   struct Header
+   {
+      UInt32 magic;
+      UInt32 version;
+      UInt32 core_id;
+      UInt32 record_size;
+   };
+
+   struct Record
+   {
+      UInt64 ip;        // Branch address, zero for state changes
+      UInt64 target;
+      UInt64 info;      // bit 0 taken, bit 1 indirect, bit 2 state change, bits 3-7 core state, bits 8-63 time in ns
+
+      bool isStateChange() const { return info & 4; }
+      bool taken() const { return info & 1; }
+      bool indirect() const { return info & 2; }
+      UInt32 state() const { return (info >> 3) & 0x1f; }
+      UInt64 timeNS() const { return info >> 8; }
+
+      static UInt64 makeInfo(UInt64 time_ns, UInt32 state, bool state_change, bool indirect, bool taken)
+         { return (time_ns << 8) | (UInt64(state) << 3) | (state_change << 2) | (indirect << 1) | UInt64(taken); }
+   };
+
+   class Writer
+   {
+      public:
+         Writer(String filename, core_id_t core_id);
+         ~Writer();
+
+         void branch(UInt64 time_ns, UInt32 state, IntPtr ip, IntPtr target, bool taken, bool indirect)
+         {
+            Record &record = next();
+            record.ip = ip;
+            record.target = target;
+            record.info = Record::makeInfo(time_ns, state, false, indirect, taken);
+         }
+         void stateChange(UInt64 time_ns, UInt32 state)
+         {
+            Record &record = next();
+            record.ip = 0;
+            record.target = 0;
+            record.info = Record::makeInfo(time_ns, state, true, false, false);
+         }
+
+      private:
+         static const UInt32 BUFFER_RECORDS = 16384;
+
+         FILE *m_fp;
+         Record *m_buffer;
+         UInt32 m_count;
+
+         Record& next()
+         {
+            if (m_count == BUFFER_RECORDS)
+               flush();
+            return m_buffer[m_count++];
+         }
+         void flush();
+   };
+}
+
+#endif // BRANCH_TRACE_H
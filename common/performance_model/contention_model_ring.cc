@@ -0,0 +1,101 @@
+#include "contention_model_ring.h"
+#include "stats.h"
+#include "log.h"
+
+#include <algorithm>
+
+RingContentionModel::RingContentionModel(String name, UInt32 id, SubsecondTime slot_size, UInt64 window_slots)
+   : m_slot_shift(63 - __builtin_clzll(std::max(slot_size.getFS(), UInt64(1))))
+   , m_slot_size(1ULL << m_slot_shift)
+   , m_num_slots(window_slots <= 64 ? 64 : 1ULL << (64 - __builtin_clzll(window_slots - 1)))
+   , m_used(m_num_slots, 0)
+   , m_full(m_num_slots / 64, 0)
+   , m_base(0)
+   , m_n_requests(0)
+   , m_n_outoforder(0)
+   , m_n_window_moves(0)
+   , m_total_delay(SubsecondTime::Zero())
+{
+   registerStatsMetric(name, id, "num-requests", &m_n_requests);
+   registerStatsMetric(name, id, "requests-out-of-order", &m_n_outoforder);
+   registerStatsMetric(name, id, "window-moves", &m_n_window_moves);
+   registerStatsMetric(name, id, "total-delay", &m_total_delay);
+}
+
+void
+RingContentionModel::moveWindow(UInt64 last_slot)
+{
+   // Make sure <last_slot> is inside the window, dropping the oldest slots
+   if (last_slot < m_base + m_num_slots)
+      return;
+
+   UInt64 base = last_slot - m_num_slots + 1;
+   if (base - m_base >= m_num_slots)
+   {
+      std::fill(m_used.begin(), m_used.end(), 0);
+      std::fill(m_full.begin(), m_full.end(), 0);
+   }
+   else
+   {
+      for(UInt64 slot = m_base; slot < base; ++slot)
+      {
+         m_used[index(slot)] = 0;
+         m_full[index(slot) >> 6] &= ~(1ULL << (index(slot) & 63));
+      }
+   }
+   m_base = base;
+   ++m_n_window_moves;
+}
+
+UInt64
+RingContentionModel::nextFree(UInt64 slot)
+{
+   // The window is a multiple of 64 slots, so bitmap words cover the same slots in the ring as in time
+   while (true)
+   {
+      moveWindow(slot);
+      UInt64 bit = index(slot) & 63;
+      UInt64 free = ~m_full[index(slot) >> 6] & (~0ULL << bit);
+      if (free)
+         return slot + __builtin_ctzll(free) - bit;
+      slot += 64 - bit;
+   }
+}
+
+SubsecondTime
+RingContentionModel::getCompletionTime(SubsecondTime t_start, SubsecondTime t_delay)
+{
+   ++m_n_requests;
+
+   UInt64 start = t_start.getFS(), remaining = t_delay.getFS();
+   UInt64 first = start >> m_slot_shift;
+   if (first < m_base)
+   {
+      /* Older than the window. Assume no congestion, only transfer latency. */
+      ++m_n_outoforder;
+      return t_start + t_delay;
+   }
+   if (remaining == 0)
+      return t_start;
+
+   // In the first slot, the part before the request arrived cannot be used by it
+   UInt64 offset = start & (m_slot_size - 1);
+   UInt64 end = start;
+   for(UInt64 slot = first; remaining; ++slot)
+   {
+      slot = nextFree(slot);
+      UInt64 &used = m_used[index(slot)];
+      UInt64 begin = slot == first ? std::max(used, offset) : used;
+      UInt64 take = std::min(remaining, m_slot_size - begin);
+
+      used += take;
+      if (used >= m_slot_size)
+         setFull(slot);
+      remaining -= take;
+      end = (slot << m_slot_shift) + begin + take;
+   }
+
+   SubsecondTime t_end = SubsecondTime::FS(end);
+   m_total_delay += t_end - t_start - t_delay;
+   return t_end;
+}
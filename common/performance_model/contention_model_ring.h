@@ -0,0 +1,47 @@
+#ifndef CONTENTION_MODEL_RING_H
+#define CONTENTION_MODEL_RING_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+
+#include <vector>
+
+// Time-windowed contention model for bandwidth-limited resources (DRAM channels, links).
+// Time is cut into slots of a power-of-two number of femtoseconds, and a ring buffer covers the most recent
+// <window_slots> (also a power of two) of them. Each slot records how much of it is in use, a bitmap marks the
+// slots that are full. A request takes the free capacity of the slots from its start time on, skipping full slots
+// with a ctz on the bitmap, and completes when it has collected its processing time.
+// Unlike ContentionModel, a request that arrives out of order still sees the load already booked around it,
+// as long as it falls within the window; older requests only see their processing time.
+// Moving the window just advances the base slot, clearing the slots that fall off.
+
+class RingContentionModel
+{
+   private:
+      const UInt32 m_slot_shift;
+      const UInt64 m_slot_size; // In fs
+      const UInt64 m_num_slots;
+      std::vector<UInt64> m_used; // fs in use per slot, indexed by slot modulo the window
+      std::vector<UInt64> m_full; // Bitmap of full slots
+      UInt64 m_base;              // First slot in the window
+
+      UInt64 m_n_requests;
+      UInt64 m_n_outoforder;
+      UInt64 m_n_window_moves;
+      SubsecondTime m_total_delay;
+
+      UInt64 index(UInt64 slot) const { return slot & (m_num_slots - 1); }
+      bool isFull(UInt64 slot) const { return m_full[index(slot) >> 6] & (1ULL << (index(slot) & 63)); }
+      void setFull(UInt64 slot) { m_full[index(slot) >> 6] |= 1ULL << (index(slot) & 63); }
+      void moveWindow(UInt64 last_slot);
+      UInt64 nextFree(UInt64 slot);
+
+   public:
+      // <slot_size> is rounded down to a power of two fs, <window_slots> up to a power of two
+      RingContentionModel(String name, UInt32 id, SubsecondTime slot_size, UInt64 window_slots);
+
+      SubsecondTime getCompletionTime(SubsecondTime t_start, SubsecondTime t_delay);
+      SubsecondTime getSlotSize() const { return SubsecondTime::FS(m_slot_size); }
+};
+
+#endif // CONTENTION_MODEL_RING_H
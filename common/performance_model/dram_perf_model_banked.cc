@@ -0,0 +1,274 @@
+#include "dram_perf_model_banked.h"
+#include "simulator.h"
+#include "config.h"
+#include "config.hpp"
+#include "stats.h"
+#include "shmem_perf.h"
+
+#include <algorithm>
+#include <iterator>
+
+SubsecondTime
+DramPerfModelBanked::nsToTime(String key)
+{
+   return SubsecondTime::FS() * static_cast<uint64_t>(TimeConverter<float>::NStoFS(Sim()->getCfg()->getFloat(key))); // Operate in fs for higher precision before converting to uint64_t/SubsecondTime
+}
+
+DramPerfModelBanked::DramPerfModelBanked(core_id_t core_id,
+      UInt32 cache_block_size):
+   DramPerfModel(core_id, cache_block_size),
+   m_cache_block_size(cache_block_size),
+   m_num_ranks(Sim()->getCfg()->getInt("perf_model/dram/banked/ranks")),
+   m_num_banks(Sim()->getCfg()->getInt("perf_model/dram/banked/banks_per_rank")),
+   m_lines_per_row(Sim()->getCfg()->getInt("perf_model/dram/banked/row_size") / cache_block_size),
+   m_page_policy(Sim()->getCfg()->getString("perf_model/dram/banked/page_policy") == "closed" ? PAGE_CLOSED : PAGE_OPEN),
+   m_max_intervals(Sim()->getCfg()->getInt("perf_model/dram/banked/max_intervals_per_bank")),
+   m_tCAS(nsToTime("perf_model/dram/banked/tCAS")),
+   m_tRCD(nsToTime("perf_model/dram/banked/tRCD")),
+   m_tRP(nsToTime("perf_model/dram/banked/tRP")),
+   m_tRAS(nsToTime("perf_model/dram/banked/tRAS")),
+   m_tREFI(nsToTime("perf_model/dram/banked/tREFI")),
+   m_tRFC(nsToTime("perf_model/dram/banked/tRFC")),
+   m_controller_delay(nsToTime("perf_model/dram/banked/controller_latency")),
+   m_dram_bandwidth(8 * Sim()->getCfg()->getFloat("perf_model/dram/per_controller_bandwidth")), // Convert bytes to bits
+   m_bus_queue_model(NULL),
+   m_banks(m_num_ranks * m_num_banks),
+   m_refresh_stalls(0),
+   m_total_bank_queueing_delay(SubsecondTime::Zero()),
+   m_total_bus_queueing_delay(SubsecondTime::Zero()),
+   m_total_refresh_delay(SubsecondTime::Zero()),
+   m_total_read_queueing_delay(SubsecondTime::Zero()),
+   m_total_write_queueing_delay(SubsecondTime::Zero()),
+   m_total_access_latency(SubsecondTime::Zero())
+{
+   String page_policy = Sim()->getCfg()->getString("perf_model/dram/banked/page_policy");
+   LOG_ASSERT_ERROR(page_policy == "open" || page_policy == "closed", "Invalid DRAM page policy %s, expected open or closed", page_policy.c_str());
+   LOG_ASSERT_ERROR(m_num_ranks > 0 && m_num_banks > 0, "DRAM needs at least one rank and one bank");
+   LOG_ASSERT_ERROR(m_lines_per_row > 0, "DRAM row size must be at least one cache block");
+   LOG_ASSERT_ERROR(m_max_intervals > 1, "perf_model/dram/banked/max_intervals_per_bank must be at least 2");
+   LOG_ASSERT_ERROR(m_tREFI == SubsecondTime::Zero() || m_tRFC < m_tREFI, "DRAM tRFC must be smaller than tREFI");
+
+   SubsecondTime burst_time = m_dram_bandwidth.getRoundedLatency(8 * cache_block_size); // bytes to bits
+   // Shortest time a bank can be busy for (a row hit), gaps smaller than this can never be used
+   m_min_access_time = burst_time;
+
+   if (Sim()->getCfg()->getBool("perf_model/dram/queue_model/enabled"))
+   {
+      m_bus_queue_model = QueueModel::create("dram-queue-bus", core_id, Sim()->getCfg()->getString("perf_model/dram/queue_model/type"),
+                                             burst_time);
+   }
+
+   for(UInt32 i = 0; i < NUM_ROW_STATES; ++i)
+      m_row_accesses[i] = 0;
+
+   registerStatsMetric("dram", core_id, "total-access-latency", &m_total_access_latency);
+   registerStatsMetric("dram", core_id, "total-read-queueing-delay", &m_total_read_queueing_delay);
+   registerStatsMetric("dram", core_id, "total-write-queueing-delay", &m_total_write_queueing_delay);
+   registerStatsMetric("dram", core_id, "total-bank-queueing-delay", &m_total_bank_queueing_delay);
+   registerStatsMetric("dram", core_id, "total-bus-queueing-delay", &m_total_bus_queueing_delay);
+   registerStatsMetric("dram", core_id, "total-refresh-delay", &m_total_refresh_delay);
+   registerStatsMetric("dram", core_id, "refresh-stalls", &m_refresh_stalls);
+   registerStatsMetric("dram", core_id, "row-hits", &m_row_accesses[ROW_HIT]);
+   registerStatsMetric("dram", core_id, "row-misses", &m_row_accesses[ROW_CLOSED]);
+   registerStatsMetric("dram", core_id, "row-conflicts", &m_row_accesses[ROW_CONFLICT]);
+}
+
+DramPerfModelBanked::~DramPerfModelBanked()
+{
+   if (m_bus_queue_model)
+   {
+      delete m_bus_queue_model;
+      m_bus_queue_model = NULL;
+   }
+}
+
+void
+DramPerfModelBanked::decodeAddress(IntPtr address, UInt32 &rank, UInt32 &bank, UInt64 &row) const
+{
+   // Consecutive cache lines map to the same row, then interleave over banks, then over ranks
+   UInt64 line = address / m_cache_block_size;
+   UInt64 rest = line / m_lines_per_row;
+   bank = rest % m_num_banks;
+   rest /= m_num_banks;
+   rank = rest % m_num_ranks;
+   row = rest / m_num_ranks;
+}
+
+SubsecondTime
+DramPerfModelBanked::refreshOffset(UInt32 rank) const
+{
+   // Stagger refreshes of the different ranks over the refresh interval
+   return m_tREFI * rank / m_num_ranks;
+}
+
+SubsecondTime
+DramPerfModelBanked::refreshEnd(UInt32 rank, SubsecondTime t) const
+{
+   // If t falls inside a refresh of this rank, return the time the refresh completes, else t
+   SubsecondTime offset = refreshOffset(rank);
+   if (m_tREFI == SubsecondTime::Zero() || t < offset)
+      return t;
+   SubsecondTime period_start = t - (t - offset) % m_tREFI;
+   if (t < period_start + m_tRFC)
+      return period_start + m_tRFC;
+   else
+      return t;
+}
+
+SubsecondTime
+DramPerfModelBanked::nextRefresh(UInt32 rank, SubsecondTime t) const
+{
+   // Start of the first refresh of this rank strictly after t
+   SubsecondTime offset = refreshOffset(rank);
+   if (m_tREFI == SubsecondTime::Zero())
+      return SubsecondTime::MaxTime();
+   if (t < offset)
+      return offset;
+   return t - (t - offset) % m_tREFI + m_tREFI;
+}
+
+SubsecondTime
+DramPerfModelBanked::getAccessLatency(SubsecondTime pkt_time, UInt64 pkt_size, core_id_t requester, IntPtr address, DramCntlrInterface::access_t access_type, ShmemPerf *perf)
+{
+   // pkt_size is in 'Bytes'
+   // m_dram_bandwidth is in 'Bits per clock cycle'
+   if ((!m_enabled) ||
+         (requester >= (core_id_t) Config::getSingleton()->getApplicationCores()))
+   {
+      return SubsecondTime::Zero();
+   }
+
+   SubsecondTime processing_time = m_dram_bandwidth.getRoundedLatency(8 * pkt_size); // bytes to bits
+
+   UInt32 rank, bank;
+   UInt64 row;
+   decodeAddress(address, rank, bank, row);
+   BankTimeline &timeline = m_banks[rank * m_num_banks + bank];
+
+   // Forget the oldest intervals, requests that arrive this far out of order just see an idle bank
+   while (timeline.size() >= m_max_intervals)
+      timeline.erase(timeline.begin());
+
+   // Find the first gap in the bank's timeline, at or after pkt_time, that fits this access
+   SubsecondTime start = pkt_time;
+   BankTimeline::iterator next = timeline.upper_bound(start);
+   BankTimeline::iterator prev = next == timeline.begin() ? timeline.end() : std::prev(next);
+   if (prev != timeline.end() && prev->second.end > start)
+      start = prev->second.end;
+
+   SubsecondTime refresh_delay = SubsecondTime::Zero();
+   row_state_t row_state;
+   SubsecondTime activate, data_time, busy_end;
+   while(true)
+   {
+      SubsecondTime refresh_end = refreshEnd(rank, start);
+      if (refresh_end > start)
+      {
+         refresh_delay += refresh_end - start;
+         start = refresh_end;
+      }
+
+      // A refresh precharges all banks, so the row left open by the previous access is gone
+      if (prev == timeline.end() || !prev->second.open || nextRefresh(rank, prev->second.end) <= start)
+         row_state = ROW_CLOSED;
+      else if (prev->second.row == row)
+         row_state = ROW_HIT;
+      else
+         row_state = ROW_CONFLICT;
+
+      switch(row_state)
+      {
+         case ROW_HIT:
+            activate = prev->second.activate;
+            data_time = start + m_tCAS;
+            break;
+         case ROW_CLOSED:
+            activate = start;
+            data_time = activate + m_tRCD + m_tCAS;
+            break;
+         case ROW_CONFLICT:
+         default:
+            // Precharge the open row, which must have been open for at least tRAS
+            activate = std::max(start, prev->second.activate + m_tRAS) + m_tRP;
+            data_time = activate + m_tRCD + m_tCAS;
+            break;
+      }
+
+      if (m_page_policy == PAGE_CLOSED)
+         busy_end = std::max(data_time + processing_time, activate + m_tRAS) + m_tRP; // Auto-precharge
+      else
+         // Column accesses to an open row are pipelined, the next one can be issued once this burst is underway
+         busy_end = data_time - m_tCAS + processing_time;
+
+      if (nextRefresh(rank, start) < busy_end)
+      {
+         // Would be interrupted by a refresh, retry once it completes
+         SubsecondTime refresh_start = nextRefresh(rank, start);
+         refresh_delay += refresh_start + m_tRFC - start;
+         start = refresh_start + m_tRFC;
+         while(next != timeline.end() && next->first < start)
+         {
+            prev = next++;
+            start = std::max(start, prev->second.end);
+         }
+         continue;
+      }
+
+      if (next != timeline.end() && busy_end > next->first)
+      {
+         // Does not fit before the next scheduled access to this bank
+         prev = next++;
+         start = std::max(start, prev->second.end);
+         continue;
+      }
+
+      break;
+   }
+
+   if (refresh_delay > SubsecondTime::Zero())
+      ++m_refresh_stalls;
+
+   BusyInterval interval = { busy_end, activate, row, m_page_policy == PAGE_OPEN };
+   SubsecondTime interval_start = start;
+   // Merge with neighbours when the gap in between is too small to ever be used,
+   // this keeps the number of intervals that a saturated bank needs to skip over small
+   if (prev != timeline.end() && start - prev->second.end < m_min_access_time)
+   {
+      interval_start = prev->first;
+      timeline.erase(prev);
+   }
+   if (next != timeline.end() && next->first - busy_end < m_min_access_time)
+   {
+      interval = next->second;
+      timeline.erase(next);
+   }
+   timeline[interval_start] = interval;
+
+   SubsecondTime bank_delay = start - pkt_time;
+   SubsecondTime device_time = data_time - start;
+
+   // Shared data bus for all banks and ranks of this controller
+   SubsecondTime bus_delay = m_bus_queue_model ? m_bus_queue_model->computeQueueDelay(data_time, processing_time, requester) : SubsecondTime::Zero();
+
+   SubsecondTime queue_delay = bank_delay + bus_delay;
+   SubsecondTime access_latency = queue_delay + device_time + processing_time + m_controller_delay;
+
+   perf->updateTime(pkt_time);
+   perf->updateTime(pkt_time + queue_delay, ShmemPerf::DRAM_QUEUE);
+   perf->updateTime(pkt_time + queue_delay + processing_time, ShmemPerf::DRAM_BUS);
+   perf->updateTime(pkt_time + access_latency, ShmemPerf::DRAM_DEVICE);
+
+   // Update Memory Counters
+   m_num_accesses ++;
+   m_row_accesses[row_state] ++;
+   m_total_access_latency += access_latency;
+   m_total_bank_queueing_delay += bank_delay;
+   m_total_bus_queueing_delay += bus_delay;
+   m_total_refresh_delay += refresh_delay;
+   if (access_type == DramCntlrInterface::READ)
+      m_total_read_queueing_delay += queue_delay;
+   else
+      m_total_write_queueing_delay += queue_delay;
+
+   return access_latency;
+}
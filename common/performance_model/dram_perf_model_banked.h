@@ -0,0 +1,97 @@
+#ifndef __DRAM_PERF_MODEL_BANKED_H__
+#define __DRAM_PERF_MODEL_BANKED_H__
+
+#include "dram_perf_model.h"
+#include "queue_model.h"
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "dram_cntlr_interface.h"
+
+#include <map>
+#include <vector>
+
+// DRAM model with per-rank/bank row buffer state, DRAM command timing (tRCD, tCAS, tRP, tRAS),
+// periodic refresh, and a shared data bus per controller.
+//
+// With fluffy time, requests are not seen in simulated-time order, and their latency must be known
+// as soon as they arrive. Each bank therefore keeps a timeline of the intervals during which it is busy,
+// sorted by start time. A request is placed into the first gap (at or after its arrival) that is long
+// enough for it, and sees the row buffer state left behind by the interval just before it. This
+// approximates FR-FCFS scheduling: a short row hit can use a gap that an earlier-queued row conflict
+// could not, and the row left open by an access is reused by every later access to it.
+// Lookups are O(log n) in the number of intervals; adjacent intervals with a gap too small to hold
+// any access are merged, so the scan over intervals that do not fit stays short when a bank is saturated.
+
+class DramPerfModelBanked : public DramPerfModel
+{
+   private:
+      enum page_policy_t
+      {
+         PAGE_OPEN,
+         PAGE_CLOSED,
+      };
+
+      enum row_state_t
+      {
+         ROW_HIT,
+         ROW_CLOSED,
+         ROW_CONFLICT,
+         NUM_ROW_STATES
+      };
+
+      struct BusyInterval
+      {
+         SubsecondTime end;
+         SubsecondTime activate; // Time the open row was activated, for tRAS
+         UInt64 row;
+         bool open;              // Row is left open at the end of this interval
+      };
+      typedef std::map<SubsecondTime, BusyInterval> BankTimeline;
+
+      const UInt32 m_cache_block_size;
+      const UInt32 m_num_ranks;
+      const UInt32 m_num_banks;
+      const UInt32 m_lines_per_row;
+      const page_policy_t m_page_policy;
+      const UInt32 m_max_intervals;
+
+      const SubsecondTime m_tCAS;
+      const SubsecondTime m_tRCD;
+      const SubsecondTime m_tRP;
+      const SubsecondTime m_tRAS;
+      const SubsecondTime m_tREFI;
+      const SubsecondTime m_tRFC;
+      const SubsecondTime m_controller_delay;
+      SubsecondTime m_min_access_time;
+
+      ComponentBandwidth m_dram_bandwidth;
+      QueueModel* m_bus_queue_model;
+
+      std::vector<BankTimeline> m_banks;
+
+      UInt64 m_row_accesses[NUM_ROW_STATES];
+      UInt64 m_refresh_stalls;
+      SubsecondTime m_total_bank_queueing_delay;
+      SubsecondTime m_total_bus_queueing_delay;
+      SubsecondTime m_total_refresh_delay;
+      SubsecondTime m_total_read_queueing_delay;
+      SubsecondTime m_total_write_queueing_delay;
+      SubsecondTime m_total_access_latency;
+
+      static SubsecondTime nsToTime(String key);
+
+      void decodeAddress(IntPtr address, UInt32 &rank, UInt32 &bank, UInt64 &row) const;
+      SubsecondTime refreshOffset(UInt32 rank) const;
+      SubsecondTime refreshEnd(UInt32 rank, SubsecondTime t) const;
+      SubsecondTime nextRefresh(UInt32 rank, SubsecondTime t) const;
+
+   public:
+      DramPerfModelBanked(core_id_t core_id,
+            UInt32 cache_block_size);
+
+      ~DramPerfModelBanked();
+
+      SubsecondTime getAccessLatency(SubsecondTime pkt_time, UInt64 pkt_size, core_id_t requester, IntPtr address, DramCntlrInterface::access_t access_type, ShmemPerf *perf);
+};
+
+#endif /* __DRAM_PERF_MODEL_BANKED_H__ */
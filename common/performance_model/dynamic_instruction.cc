@@ -1,13 +1,14 @@
 #include "dynamic_instruction.h"
 #include "instruction.h"
-#include "allocator.h"
+#include "arena_allocator.h"
 #include "core.h"
 #include "branch_predictor.h"
 #include "performance_model.h"
 
 Allocator* DynamicInstruction::createAllocator()
 {
-   return new TypedAllocator<DynamicInstruction, 1024>();
+   // Dynamic instructions are freed in program order once they have been simulated
+   return new ArenaAllocator<>();
 }
 
 DynamicInstruction::~DynamicInstruction()
@@ -39,7 +40,7 @@ SubsecondTime DynamicInstruction::getBranchCost(Core *core, bool *p_is_mispredic
    return static_cast<SubsecondTime>(*period) * cost;
 }
 
-void DynamicInstruction::accessMemory(Core *core)
+void DynamicInstruction::accessMemory(Core *core, Instruction *instruction, MemoryInfo *memory_info, UInt8 num_memory)
 {
    for(UInt8 idx = 0; idx < num_memory; ++idx)
    {
@@ -13,12 +13,14 @@ class DynamicInstruction
 {
    private:
       // Private constructor: alloc() should be used
-      DynamicInstruction(Instruction *ins, IntPtr _eip)
+      DynamicInstruction(Instruction *ins, IntPtr _eip, UInt8 _max_memory)
       {
          instruction = ins;
          eip = _eip;
          branch_info.is_branch = false;
          num_memory = 0;
+         max_memory = _max_memory;
+         memory_info = _max_memory ? (MemoryInfo*)(this + 1) : NULL;
       }
    public:
       struct BranchInfo
@@ -37,22 +39,24 @@ class DynamicInstruction
          SubsecondTime latency;
          HitWhere::where_t hit_where;
       };
-      static const UInt8 MAX_MEMORY = 2;
 
       Instruction* instruction;
       IntPtr eip; // Can be physical address, so different from instruction->getAddress() which is always virtual
       BranchInfo branch_info;
       UInt8 num_memory;
-      MemoryInfo memory_info[MAX_MEMORY];
+      UInt8 max_memory;
+      // Records are variable length: the max_memory memory operands follow the record in the same allocation,
+      // so instructions without memory operands carry none, and vector gathers/scatters can have one per element
+      MemoryInfo *memory_info;
 
       static Allocator* createAllocator();
 
       ~DynamicInstruction();
 
-      static DynamicInstruction* alloc(Allocator *alloc, Instruction *ins, IntPtr eip)
+      static DynamicInstruction* alloc(Allocator *alloc, Instruction *ins, IntPtr eip, UInt8 max_memory)
       {
-         void *ptr = alloc->alloc(sizeof(DynamicInstruction));
-         DynamicInstruction *i = new(ptr) DynamicInstruction(ins, eip);
+         void *ptr = alloc->alloc(sizeof(DynamicInstruction) + max_memory * sizeof(MemoryInfo));
+         DynamicInstruction *i = new(ptr) DynamicInstruction(ins, eip, max_memory);
          return i;
       }
       static void operator delete(void* ptr) { Allocator::dealloc(ptr); }
@@ -64,7 +68,7 @@ class DynamicInstruction
 
       void addMemory(bool e, SubsecondTime l, IntPtr a, UInt32 s, Operand::Direction dir, UInt32 num_misses, HitWhere::where_t hit_where)
       {
-         LOG_ASSERT_ERROR(num_memory < MAX_MEMORY, "Got more than MAX_MEMORY(%d) memory operands", MAX_MEMORY);
+         LOG_ASSERT_ERROR(num_memory < max_memory, "Got more than the %d memory operands allocated", max_memory);
          memory_info[num_memory].dir = dir;
          memory_info[num_memory].executed = e;
          memory_info[num_memory].latency = l;
@@ -84,7 +88,9 @@ class DynamicInstruction
       }
 
       SubsecondTime getBranchCost(Core *core, bool *p_is_mispredict = NULL);
-      void accessMemory(Core *core);
+      void accessMemory(Core *core) { accessMemory(core, instruction, memory_info, num_memory); }
+      // Perform the accesses of <num_memory> operands of <instruction>, filling in their latency and hit_where
+      static void accessMemory(Core *core, Instruction *instruction, MemoryInfo *memory_info, UInt8 num_memory);
 };
 
 #endif // __DYNAMIC_INSTRUCTION_H
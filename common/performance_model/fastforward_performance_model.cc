@@ -13,9 +13,25 @@ FastforwardPerformanceModel::FastforwardPerformanceModel(Core *core, Performance
    , m_include_memory_latency(Sim()->getCfg()->getBool("perf_model/fast_forward/oneipc/include_memory_latency"))
    , m_include_branch_mispredict(Sim()->getCfg()->getBool("perf_model/fast_forward/oneipc/include_branch_misprediction"))
    , m_branch_misprediction_penalty(core->getDvfsDomain(), Sim()->getCfg()->getIntArray("perf_model/branch_predictor/mispredict_penalty", core->getId()))
+   , m_interval(Sim()->getCfg()->getString("perf_model/fast_forward/model") == "interval")
+   , m_dispatch_width(1)
+   , m_window_size(0)
+   , m_hidden_latency(SubsecondTime::Zero())
+   , m_instructions(0)
+   , m_overlap_end(0)
    , m_cpi(SubsecondTime::Zero())
    , m_fastforwarded_time(SubsecondTime::Zero())
 {
+   if (m_interval)
+   {
+      m_dispatch_width = Sim()->getCfg()->getIntArray("perf_model/fast_forward/interval/dispatch_width", core->getId());
+      m_window_size = Sim()->getCfg()->getIntArray("perf_model/fast_forward/interval/window_size", core->getId());
+      LOG_ASSERT_ERROR(m_dispatch_width > 0, "perf_model/fast_forward/interval/dispatch_width must be non-zero");
+      // Dispatch continues until the window fills up behind a miss, so latencies up to the time it takes
+      // to dispatch a full window are hidden. This is an approximation: the core's frequency may change later.
+      m_hidden_latency = (m_window_size / m_dispatch_width) * core->getDvfsDomain()->getPeriod();
+   }
+
    registerStatsMetric("fastforward_performance_model", core->getId(), "fastforwarded_time", &m_fastforwarded_time);
    registerStatsMetric("performance_model", core->getId(), "cpiFastforwardTime", &m_fastforwarded_time);
 
@@ -59,20 +75,41 @@ FastforwardPerformanceModel::notifyElapsedTimeUpdate()
 void
 FastforwardPerformanceModel::countInstructions(IntPtr address, UInt32 count)
 {
-   incrementElapsedTime(count * m_cpi, m_cpiBase);
+   if (m_interval)
+   {
+      m_instructions += count;
+      incrementElapsedTime((count * m_core->getDvfsDomain()->getPeriod()) / m_dispatch_width, m_cpiBase);
+   }
+   else
+      incrementElapsedTime(count * m_cpi, m_cpiBase);
 }
 
 void
 FastforwardPerformanceModel::handleMemoryLatency(SubsecondTime latency, HitWhere::where_t hit_where)
 {
-   if (m_include_memory_latency)
+   if (m_interval)
+   {
+      if (latency <= m_hidden_latency || m_instructions < m_overlap_end)
+         return;
+      // An isolated long-latency miss blocks the window for its full latency,
+      // the misses that follow it within one window are serviced in its shadow
+      m_overlap_end = m_instructions + m_window_size;
+      incrementElapsedTime(latency, m_cpiDataCache[hit_where]);
+   }
+   else if (m_include_memory_latency)
       incrementElapsedTime(latency, m_cpiDataCache[hit_where]);
 }
 
 void
 FastforwardPerformanceModel::handleBranchMispredict()
 {
-   if (m_include_branch_mispredict)
+   if (m_interval)
+   {
+      // Front-end refill, plus the time to resolve the branch which on average sits halfway a full window
+      SubsecondTime resolution = (m_window_size / (2 * m_dispatch_width)) * m_core->getDvfsDomain()->getPeriod();
+      incrementElapsedTime(m_branch_misprediction_penalty.getLatency() + resolution, m_cpiBranchPredictor);
+   }
+   else if (m_include_branch_mispredict)
       incrementElapsedTime(m_branch_misprediction_penalty.getLatency(), m_cpiBranchPredictor);
 }
 
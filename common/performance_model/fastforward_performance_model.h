@@ -12,6 +12,16 @@ class FastforwardPerformanceModel
       const bool m_include_branch_mispredict;
       ComponentLatency m_branch_misprediction_penalty;
 
+      // Mechanistic interval model ([perf_model/fast_forward/model] = interval): time advances at the dispatch width,
+      // plus a penalty for every miss event seen while fast-forwarding (branch mispredictions, and cache misses in
+      // cache-only mode). Long-latency misses that fall in the same reorder-buffer window overlap with the first one.
+      const bool m_interval;
+      UInt32 m_dispatch_width;
+      UInt32 m_window_size;
+      SubsecondTime m_hidden_latency;   // Latency an out-of-order window hides without stalling dispatch
+      UInt64 m_instructions;
+      UInt64 m_overlap_end;             // Misses before this instruction overlap with an outstanding long-latency miss
+
       SubsecondTime m_cpi;
       SubsecondTime m_fastforwarded_time;
 
@@ -23,6 +33,7 @@ class FastforwardPerformanceModel
       FastforwardPerformanceModel(Core *core, PerformanceModel *perf);
       ~FastforwardPerformanceModel() {}
 
+      // With the interval model, the CPI set here is only used to aim instruction callbacks
       SubsecondTime getCurrentCPI() const { return m_cpi; }
       void setCurrentCPI(SubsecondTime cpi) { m_cpi = cpi; }
 
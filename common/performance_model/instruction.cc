@@ -14,14 +14,19 @@ Instruction::Instruction(InstructionType type, OperandList &operands)
    : m_type(type)
    , m_uops(NULL)
    , m_addr(0)
+   , m_num_memory_operands(0)
    , m_operands(operands)
 {
+   for(OperandList::const_iterator it = m_operands.begin(); it != m_operands.end(); ++it)
+      if (it->m_type == Operand::MEMORY)
+         ++m_num_memory_operands;
 }
 
 Instruction::Instruction(InstructionType type)
    : m_type(type)
    , m_uops(NULL)
    , m_addr(0)
+   , m_num_memory_operands(0)
 {
 }
 
@@ -59,6 +59,9 @@ public:
 
    const OperandList& getOperands() const
    { return m_operands; }
+   // Number of Operand::MEMORY operands, each gets a DynamicInstruction::MemoryInfo
+   UInt8 getMemoryOperandCount() const
+   { return m_num_memory_operands; }
 
    void setAddress(IntPtr addr) { m_addr = addr; }
    IntPtr getAddress() const { return m_addr; }
@@ -89,6 +92,7 @@ private:
    IntPtr m_addr;
    UInt32 m_size;
    bool m_atomic;
+   UInt8 m_num_memory_operands;
 
 protected:
    OperandList m_operands;
@@ -155,6 +159,7 @@ public:
       SLEEP,
       SYSCALL,
       UNSCHEDULED,
+      SPIN,
       NUM_TYPES
    };
 
@@ -3,6 +3,7 @@
 #include "config.hpp"
 #include "instruction_tracer_fpstats.h"
 #include "instruction_tracer_print.h"
+#include "instruction_tracer_insmix.h"
 #include "loop_tracer.h"
 #include "loop_profiler.h"
 
@@ -26,6 +27,8 @@ InstructionTracer::create(const Core *core)
       return new InstructionTracerPrint(core);
    else if (type == "fpstats")
       return new InstructionTracerFPStats(core);
+   else if (type == "insmix")
+      return new InstructionTracerInsMix(core);
    else if (type == "loop_tracer")
       return new LoopTracer(core);
    else if (type == "loop_profiler")
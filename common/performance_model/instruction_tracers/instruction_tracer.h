@@ -6,6 +6,7 @@
 
 class Core;
 class DynamicMicroOp;
+class Instruction;
 
 class InstructionTracer
 {
@@ -20,6 +21,15 @@ class InstructionTracer
       } uop_times_t;
 
       virtual void traceInstruction(const DynamicMicroOp *uop, uop_times_t *times) = 0;
+
+      // Tracers that only need the static instructions that were committed can instead be called once per basic block
+      // (a run of sequential instructions), rather than through traceInstruction for every micro-op
+      virtual bool traceBasicBlocks() const { return false; }
+      // Instructions start .. last (count instructions, at most MAX_BASIC_BLOCK) executed sequentially, after which
+      // execution continued at next. Longer runs are split. instructions[] holds the decode cache's Instruction objects.
+      virtual void traceBasicBlock(IntPtr start, IntPtr last, UInt32 count, IntPtr next, const Instruction * const *instructions) {}
+
+      static const UInt32 MAX_BASIC_BLOCK = 64;
 };
 
 #endif // __INSTRUCTION_TRACER_H
@@ -0,0 +1,77 @@
+#include "instruction_tracer_insmix.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "core.h"
+#include "instruction.h"
+#include "stats.h"
+#include "log.h"
+
+InstructionTracerInsMix::InstructionTracerInsMix(const Core *core)
+   : m_core(core)
+   , m_sample_interval(Sim()->getCfg()->getInt("instruction_tracer/insmix/sample_interval"))
+   , m_sample_countdown(1)
+{
+   LOG_ASSERT_ERROR(m_sample_interval > 0, "instruction_tracer/insmix/sample_interval must be at least 1");
+
+   for(int i = 0; i < NUM_METRICS; ++i)
+   {
+      m_metrics[i].tracer = this;
+      m_metrics[i].metric = (metric_t)i;
+
+      String name;
+      if (i < METRIC_UOPS)
+         name = "uops-" + MicroOp::getSubtypeString((MicroOp::uop_subtype_t)i);
+      else if (i == METRIC_UOPS)
+         name = "uops";
+      else if (i == METRIC_FP_LDST)
+         name = "uops-fp_ldst";
+      else
+         name = "instructions";
+      Sim()->getStatsManager()->registerMetric(new StatsMetricCallback("insmix", core->getId(), name, getMetric, (UInt64)&m_metrics[i]));
+   }
+}
+
+void
+InstructionTracerInsMix::traceBasicBlock(IntPtr start, IntPtr last, UInt32 count, IntPtr next, const Instruction * const *instructions)
+{
+   if (--m_sample_countdown)
+      return;
+   m_sample_countdown = m_sample_interval;
+
+   // Addresses fit in 58 bits, count is at most MAX_BASIC_BLOCK
+   Block &block = m_blocks[(UInt64(start) << 6) | (count - 1)];
+   if (block.executions == 0)
+      classify(block, count, instructions);
+   ++block.executions;
+}
+
+void
+InstructionTracerInsMix::classify(Block &block, UInt32 count, const Instruction * const *instructions)
+{
+   for(int i = 0; i < NUM_METRICS; ++i)
+      block.counts[i] = 0;
+
+   for(UInt32 i = 0; i < count; ++i)
+   {
+      ++block.counts[METRIC_INSTRUCTIONS];
+      const std::vector<const MicroOp*> *uops = instructions[i]->getMicroOps();
+      if (!uops)
+         continue;
+      for(std::vector<const MicroOp*>::const_iterator it = uops->begin(); it != uops->end(); ++it)
+      {
+         ++block.counts[(*it)->getSubtype()];
+         ++block.counts[METRIC_UOPS];
+         if ((*it)->isFpLoadStore())
+            ++block.counts[METRIC_FP_LDST];
+      }
+   }
+}
+
+UInt64
+InstructionTracerInsMix::getCount(metric_t metric) const
+{
+   UInt64 total = 0;
+   for(std::unordered_map<UInt64, Block>::const_iterator it = m_blocks.begin(); it != m_blocks.end(); ++it)
+      total += it->second.executions * it->second.counts[metric];
+   return total * m_sample_interval;
+}
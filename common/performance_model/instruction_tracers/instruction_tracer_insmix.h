@@ -0,0 +1,57 @@
+#ifndef __INSTRUCTION_TRACER_INSMIX_H
+#define __INSTRUCTION_TRACER_INSMIX_H
+
+#include "instruction_tracer.h"
+#include "micro_op.h"
+
+#include <unordered_map>
+
+// Instruction mix (micro-op subtypes: FP add/sub and mul/div, loads, stores, branches, FP/vector loads and stores)
+// at basic block granularity. Each block is classified once, from the micro-ops of its static instructions, and
+// afterwards costs a single increment per execution. With [instruction_tracer/insmix] sample_interval = N, only one
+// in N executed blocks is counted and the results are scaled by N.
+class InstructionTracerInsMix : public InstructionTracer
+{
+   public:
+      InstructionTracerInsMix(const Core *core);
+
+      virtual void traceInstruction(const DynamicMicroOp *uop, uop_times_t *times) {}
+      virtual bool traceBasicBlocks() const { return true; }
+      virtual void traceBasicBlock(IntPtr start, IntPtr last, UInt32 count, IntPtr next, const Instruction * const *instructions);
+
+   private:
+      enum metric_t {
+         METRIC_UOPS = MicroOp::UOP_SUBTYPE_SIZE,   // Indices below are the uop subtypes
+         METRIC_FP_LDST,
+         METRIC_INSTRUCTIONS,
+         NUM_METRICS
+      };
+      struct Block
+      {
+         UInt64 executions;
+         UInt32 counts[NUM_METRICS];
+      };
+      struct Metric
+      {
+         const InstructionTracerInsMix *tracer;
+         metric_t metric;
+      };
+
+      const Core *m_core;
+      const UInt64 m_sample_interval;
+      UInt64 m_sample_countdown;
+      // Indexed by start address and instruction count, which identify a run of sequential instructions
+      std::unordered_map<UInt64, Block> m_blocks;
+      Metric m_metrics[NUM_METRICS];
+
+      void classify(Block &block, UInt32 count, const Instruction * const *instructions);
+      UInt64 getCount(metric_t metric) const;
+
+      static UInt64 getMetric(String objectName, UInt32 index, String metricName, UInt64 arg)
+      {
+         const Metric *metric = (const Metric *)arg;
+         return metric->tracer->getCount(metric->metric);
+      }
+};
+
+#endif /* __INSTRUCTION_TRACER_INSMIX_H */
@@ -1,84 +1,65 @@
 #include "loop_profiler.h"
-#include "dynamic_micro_op.h"
-#include "instruction.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "utils.h"
+#include "log.h"
 
-#include <list>
+#include <algorithm>
 
 LoopProfiler::LoopProfiler(const Core *core)
    : m_core(core)
+   , m_max_size(Sim()->getCfg()->getInt("instruction_tracer/loop_profiler/max_size"))
    , m_total_instructions(0)
-   , m_eip_last(0)
+   , m_conflicts(0)
 {
+   UInt64 table_size = Sim()->getCfg()->getInt("instruction_tracer/loop_profiler/table_size");
+   LOG_ASSERT_ERROR(isPower2(table_size), "instruction_tracer/loop_profiler/table_size must be a power of two");
+   m_loops.resize(table_size, Loop{0, 0, 0});
+   m_mask = table_size - 1;
 }
 
 LoopProfiler::~LoopProfiler()
 {
-   std::list<Loop*> loops;
+   std::vector<Loop> loops;
    UInt64 limit = m_total_instructions / 100000;
 
    for(auto it = m_loops.begin(); it != m_loops.end(); ++it)
    {
-      for(auto jt = it->second.begin(); jt != it->second.end(); ++jt)
-      {
-         if ((*jt)->weight() > limit)
-            loops.push_back(*jt);
-      }
+      if (it->count && it->weight() > limit)
+         loops.push_back(*it);
    }
 
-   loops.sort(Loop::cmp);
+   std::sort(loops.begin(), loops.end(), Loop::cmp);
 
    int count = 100;
    for(auto it = loops.begin(); it != loops.end(); ++it)
    {
-      printf("%5" PRId64 "x %12" PRIxPTR " .. %12" PRIx64 ": %9" PRId64" (%5.1f%%)\n", (*it)->count, (*it)->eip, (*it)->eip + (*it)->size, (*it)->weight(), 100. * (*it)->weight() / m_total_instructions);
+      printf("%5" PRId64 "x %12" PRIxPTR " .. %12" PRIx64 ": %9" PRId64" (%5.1f%%)\n", it->count, it->eip, it->eip + it->size, it->weight(), 100. * it->weight() / m_total_instructions);
       if (--count == 0)
          break;
    }
-}
-
-LoopProfiler::Loop*
-LoopProfiler::findLoop(IntPtr eip, UInt64 size)
-{
-   if (m_loops.count(eip))
-      for(auto it = m_loops[eip].begin(); it != m_loops[eip].end(); ++it)
-         if ((*it)->size == size)
-            return *it;
-
-   return NULL;
-}
-
-LoopProfiler::Loop*
-LoopProfiler::insertLoop(IntPtr eip, UInt64 size)
-{
-   Loop *loop = new Loop(eip, size);
-   m_loops[eip].push_back(loop);
-   return loop;
+   if (m_conflicts)
+      printf("%" PRId64 " loop table conflicts, counts are lower bounds (increase instruction_tracer/loop_profiler/table_size)\n", m_conflicts);
 }
 
 void
-LoopProfiler::traceInstruction(const DynamicMicroOp *uop, uop_times_t *times)
+LoopProfiler::traceBasicBlock(IntPtr start, IntPtr last, UInt32 count, IntPtr next, const Instruction * const *instructions)
 {
-   // Only consider instructions
-   if (!uop->getMicroOp()->isFirst())
-      return;
-   // Ignore dynamic instructions
-   if (!uop->getMicroOp()->getInstruction())
-      return;
-
-   IntPtr eip = uop->getMicroOp()->getInstruction()->getAddress();
-   ++m_total_instructions;
+   m_total_instructions += count;
 
    // Backwards jump?
-   UInt64 size = m_eip_last - eip;
-   if (eip < m_eip_last && size < 1000)
-   {
-      Loop *loop = findLoop(eip, size);
-
-      if (!loop)
-         loop = insertLoop(eip, size);
+   UInt64 size = last - next;
+   if (next > last || size >= m_max_size)
+      return;
 
-      ++loop->count;
+   Loop &loop = m_loops[((next ^ (size << 16)) * 0x9e3779b97f4a7c15ull >> 32) & m_mask];
+   if (loop.eip == next && loop.size == size)
+      ++loop.count;
+   else if (loop.count == 0)
+      loop = Loop{next, size, 1};
+   else
+   {
+      --loop.count;
+      ++m_conflicts;
    }
-
-   m_eip_last = eip;
 }
@@ -4,15 +4,17 @@
 #include "instruction_tracer.h"
 
 #include <vector>
-#include <unordered_map>
 
+// Finds the hottest loops from taken backward branches. Loops are identified by their header address and size,
+// and counted in a direct-mapped table ([instruction_tracer/loop_profiler/table_size] entries). When two loops
+// share an entry, the resident loop's count is decremented and the newcomer takes over once it reaches zero,
+// so hot loops stay put. Committed instructions are delivered a basic block at a time.
 class LoopProfiler : public InstructionTracer
 {
    private:
       struct Loop
       {
-         Loop(IntPtr _eip, UInt64 _size) : eip(_eip), size(_size), count(0) {}
-         static bool cmp(const Loop* a, const Loop* b) { return a->weight() > b->weight(); }
+         static bool cmp(const Loop &a, const Loop &b) { return a.weight() > b.weight(); }
          UInt64 weight() const { return size * count; }
 
          IntPtr eip;
@@ -21,21 +23,19 @@ class LoopProfiler : public InstructionTracer
       };
       const Core *m_core;
 
-      typedef std::vector<Loop*> LoopList;
-      typedef std::unordered_map<IntPtr, LoopList> LoopMap;
-      LoopMap m_loops;
+      const UInt64 m_max_size;
+      std::vector<Loop> m_loops;
+      UInt64 m_mask;
       UInt64 m_total_instructions;
-
-      IntPtr m_eip_last;
-
-      Loop* findLoop(IntPtr eip, UInt64 size);
-      Loop* insertLoop(IntPtr eip, UInt64 size);
+      UInt64 m_conflicts;
 
    public:
       LoopProfiler(const Core *core);
       virtual ~LoopProfiler();
 
-      virtual void traceInstruction(const DynamicMicroOp *uop, uop_times_t *times);
+      virtual void traceInstruction(const DynamicMicroOp *uop, uop_times_t *times) {}
+      virtual bool traceBasicBlocks() const { return true; }
+      virtual void traceBasicBlock(IntPtr start, IntPtr last, UInt32 count, IntPtr next, const Instruction * const *instructions);
 };
 
 #endif // __LOOP_PROFILER_H
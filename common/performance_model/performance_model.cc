@@ -7,12 +7,17 @@
 #include "interval_performance_model.h"
 #include "rob_performance_model.h"
 #include "rob_smt_performance_model.h"
+#include "inorder_performance_model.h"
 #include "core_manager.h"
 #include "config.hpp"
 #include "stats.h"
 #include "dvfs_manager.h"
 #include "instruction_tracer.h"
 #include "dynamic_instruction.h"
+#include "dynamic_micro_op.h"
+#include "micro_op.h"
+#include "instruction.h"
+#include "self_profiler.h"
 
 PerformanceModel* PerformanceModel::create(Core* core)
 {
@@ -40,6 +45,8 @@ PerformanceModel* PerformanceModel::create(Core* core)
       else
          return new RobSmtPerformanceModel(core);
    }
+   else if (type == "inorder")
+      return new InOrderPerformanceModel(core);
    else
    {
       LOG_PRINT_ERROR("Invalid perf model type: %s", type.c_str());
@@ -56,6 +63,7 @@ PerformanceModel::PerformanceModel(Core *core)
    , m_fastforward_model(new FastforwardPerformanceModel(core, this))
    , m_detailed_sync(true)
    , m_hold(false)
+   , m_direct_path(false)
    , m_instruction_count(0)
    , m_elapsed_time(Sim()->getDvfsManager()->getCoreDomain(core->getId()))
    , m_idle_elapsed_time(Sim()->getDvfsManager()->getCoreDomain(core->getId()))
@@ -69,6 +77,9 @@ PerformanceModel::PerformanceModel(Core *core)
    m_bp = BranchPredictor::create(core->getId());
 
    m_instruction_tracer = InstructionTracer::create(core);
+   m_trace_basic_blocks = m_instruction_tracer && m_instruction_tracer->traceBasicBlocks();
+   m_bb_start = m_bb_last = m_bb_next = 0;
+   m_bb_count = 0;
 
    registerStatsMetric("performance_model", core->getId(), "instruction_count", &m_instruction_count);
 
@@ -86,6 +97,7 @@ PerformanceModel::PerformanceModel(Core *core)
    registerStatsMetric("performance_model", core->getId(), "cpiSyncSleep", &m_cpiSyncSleep);
    registerStatsMetric("performance_model", core->getId(), "cpiSyncSyscall", &m_cpiSyncSyscall);
    registerStatsMetric("performance_model", core->getId(), "cpiSyncUnscheduled", &m_cpiSyncUnscheduled);
+   registerStatsMetric("performance_model", core->getId(), "cpiSyncSpin", &m_cpiSyncSpin);
    registerStatsMetric("performance_model", core->getId(), "cpiSyncDvfsTransition", &m_cpiSyncDvfsTransition);
 
    registerStatsMetric("performance_model", core->getId(), "cpiRecv", &m_cpiRecv);
@@ -96,7 +108,33 @@ PerformanceModel::~PerformanceModel()
    delete m_bp;
    delete m_fastforward_model;
    if (m_instruction_tracer)
+   {
+      if (m_trace_basic_blocks && m_bb_count)
+         m_instruction_tracer->traceBasicBlock(m_bb_start, m_bb_last, m_bb_count, 0, m_bb_instructions);
       delete m_instruction_tracer;
+   }
+}
+
+void PerformanceModel::traceBasicBlockInstruction(const DynamicMicroOp *uop)
+{
+   // Only consider the first micro-op of static instructions
+   const MicroOp *micro_op = uop->getMicroOp();
+   if (!micro_op->isFirst() || !micro_op->getInstruction())
+      return;
+
+   const Instruction *instruction = micro_op->getInstruction();
+   IntPtr eip = instruction->getAddress();
+
+   if (m_bb_count && (eip != m_bb_next || m_bb_count == InstructionTracer::MAX_BASIC_BLOCK))
+   {
+      m_instruction_tracer->traceBasicBlock(m_bb_start, m_bb_last, m_bb_count, eip, m_bb_instructions);
+      m_bb_count = 0;
+   }
+   if (m_bb_count == 0)
+      m_bb_start = eip;
+   m_bb_last = eip;
+   m_bb_next = eip + instruction->getSize();
+   m_bb_instructions[m_bb_count++] = instruction;
 }
 
 void PerformanceModel::enable()
@@ -137,9 +175,9 @@ void PerformanceModel::handleBranchMispredict()
    }
 }
 
-DynamicInstruction* PerformanceModel::createDynamicInstruction(Instruction *ins, IntPtr eip)
+DynamicInstruction* PerformanceModel::createDynamicInstruction(Instruction *ins, IntPtr eip, UInt8 max_memory)
 {
-   return DynamicInstruction::alloc(m_dynins_alloc, ins, eip);
+   return DynamicInstruction::alloc(m_dynins_alloc, ins, eip, max_memory);
 }
 
 void PerformanceModel::queuePseudoInstruction(PseudoInstruction *i)
@@ -175,9 +213,9 @@ void PerformanceModel::queuePseudoInstruction(PseudoInstruction *i)
       else
       {
          #ifdef ENABLE_PERF_MODEL_OWN_THREAD
-            m_instruction_queue.push_wait(createDynamicInstruction(i, 0));
+            m_instruction_queue.push_wait(createDynamicInstruction(i, 0, 0));
          #else
-            m_instruction_queue.push(createDynamicInstruction(i, 0));
+            m_instruction_queue.push(createDynamicInstruction(i, 0, 0));
          #endif
       }
    }
@@ -254,6 +292,9 @@ void PerformanceModel::handleIdleInstruction(PseudoInstruction *instruction)
       case(SyncInstruction::UNSCHEDULED):
          m_cpiSyncUnscheduled += insn_cost;
          break;
+      case(SyncInstruction::SPIN):
+         m_cpiSyncSpin += insn_cost;
+         break;
       default:
          LOG_ASSERT_ERROR(false, "Unexpected SyncInstruction::type_t enum type. (%d)", sync_insn->getSyncType());
       }
@@ -292,6 +333,34 @@ void PerformanceModel::handleIdleInstruction(PseudoInstruction *instruction)
 }
 
 void PerformanceModel::iterate()
+{
+   SELF_PROFILE(CORE_MODEL);
+
+   simulateQueue();
+
+   synchronize();
+}
+
+void PerformanceModel::iterateDirect(Instruction *ins, IntPtr eip, const DynamicInstruction::BranchInfo &branch_info, DynamicInstruction::MemoryInfo *memory_info, UInt8 num_memory)
+{
+   SELF_PROFILE(CORE_MODEL);
+
+   // Pseudo-instructions queued since the previous instruction go first
+   simulateQueue();
+
+   // Like queueInstruction, drop instructions while not in detailed mode
+   if (!m_fastforward && m_enabled)
+      handleInstructionDirect(ins, eip, branch_info, memory_info, num_memory);
+
+   synchronize();
+}
+
+void PerformanceModel::handleInstructionDirect(Instruction *ins, IntPtr eip, const DynamicInstruction::BranchInfo &branch_info, DynamicInstruction::MemoryInfo *memory_info, UInt8 num_memory)
+{
+   LOG_PRINT_ERROR("This performance model does not implement handleInstructionDirect");
+}
+
+void PerformanceModel::simulateQueue()
 {
    while (m_instruction_queue.size() > 0)
    {
@@ -312,17 +381,25 @@ void PerformanceModel::iterate()
 
       m_instruction_queue.pop();
    }
-
-   synchronize();
 }
 
 void PerformanceModel::synchronize()
 {
+   // Frequency changes posted for this core ([dvfs/async]) take effect once its time has reached theirs
+   Sim()->getDvfsManager()->applyPending(m_core->getId(), getElapsedTime());
+
    ClockSkewMinimizationClient *client = m_core->getClockSkewMinimizationClient();
    if (client)
       client->synchronize(SubsecondTime::Zero(), false);
 }
 
+void PerformanceModel::notifyTimeRestored()
+{
+   notifyElapsedTimeUpdate();
+   if (m_fastforward)
+      m_fastforward_model->notifyElapsedTimeUpdate();
+}
+
 void PerformanceModel::incrementIdleElapsedTime(SubsecondTime time)
 {
    // Advance the idle time
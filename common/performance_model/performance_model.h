@@ -8,6 +8,7 @@
 #include "subsecond_time.h"
 #include "instruction_tracer.h"
 #include "hit_where.h"
+#include "dynamic_instruction.h"
 
 #include <queue>
 #include <iostream>
@@ -31,6 +32,9 @@ public:
    void queuePseudoInstruction(PseudoInstruction *i);
    void handleIdleInstruction(PseudoInstruction *i);
    void iterate();
+   // Simulate a traced instruction without creating a DynamicInstruction, only valid when hasDirectPath()
+   void iterateDirect(Instruction *ins, IntPtr eip, const DynamicInstruction::BranchInfo &branch_info, DynamicInstruction::MemoryInfo *memory_info, UInt8 num_memory);
+   bool hasDirectPath() const { return m_direct_path; }
    virtual void synchronize();
 
    UInt64 getInstructionCount() const { return m_instruction_count; }
@@ -50,11 +54,14 @@ public:
    FastforwardPerformanceModel *getFastforwardPerformanceModel() { return m_fastforward_model; }
    FastforwardPerformanceModel const* getFastforwardPerformanceModel() const { return m_fastforward_model; }
 
-   DynamicInstruction* createDynamicInstruction(Instruction *ins, IntPtr eip);
+   // Room is made for max_memory memory operands, to be filled in with DynamicInstruction::addMemory or through memory_info
+   DynamicInstruction* createDynamicInstruction(Instruction *ins, IntPtr eip, UInt8 max_memory);
 
    void traceInstruction(const DynamicMicroOp *uop, InstructionTracer::uop_times_t *times)
    {
-      if (m_instruction_tracer)
+      if (m_trace_basic_blocks)
+         traceBasicBlockInstruction(uop);
+      else if (m_instruction_tracer)
          m_instruction_tracer->traceInstruction(uop, times);
    }
 
@@ -66,6 +73,9 @@ public:
    bool isEnabled() { return m_enabled; }
    void setHold(bool hold) { m_hold = hold; }
 
+   // Elapsed time was overwritten when resuming from a checkpoint: bring the models' own notion of time up to date
+   void notifyTimeRestored();
+
    bool isFastForward() { return m_fastforward; }
    void setFastForward(bool fastforward, bool detailed_sync = true)
    {
@@ -103,6 +113,10 @@ private:
 
    // Simulate a single instruction
    virtual void handleInstruction(DynamicInstruction *instruction) = 0;
+   // Same, for an instruction that comes straight from the frontend (see iterateDirect)
+   virtual void handleInstructionDirect(Instruction *instruction, IntPtr eip, const DynamicInstruction::BranchInfo &branch_info, DynamicInstruction::MemoryInfo *memory_info, UInt8 num_memory);
+   // Simulate all instructions in the queue
+   void simulateQueue();
 
    // When time is jumped ahead outside of control of the performance model (synchronization instructions, etc.)
    // notify it here. This may be used to synchronize internal time or to flush various instruction queues
@@ -123,6 +137,9 @@ private:
    bool m_hold;
 
 protected:
+   // Set by models that implement handleInstructionDirect
+   bool m_direct_path;
+
    UInt64 m_instruction_count;
 
    ComponentTime m_elapsed_time;
@@ -140,6 +157,7 @@ private:
    SubsecondTime m_cpiSyncSleep;
    SubsecondTime m_cpiSyncSyscall;
    SubsecondTime m_cpiSyncUnscheduled;
+   SubsecondTime m_cpiSyncSpin;
    SubsecondTime m_cpiSyncDvfsTransition;
    SubsecondTime m_cpiRecv;
 
@@ -150,6 +168,14 @@ private:
    BranchPredictor *m_bp;
 
    InstructionTracer *m_instruction_tracer;
+   bool m_trace_basic_blocks;
+
+   // Basic block being collected for an InstructionTracer with traceBasicBlocks()
+   IntPtr m_bb_start, m_bb_last, m_bb_next;
+   UInt32 m_bb_count;
+   const Instruction *m_bb_instructions[InstructionTracer::MAX_BASIC_BLOCK];
+
+   void traceBasicBlockInstruction(const DynamicMicroOp *uop);
 };
 
 #endif
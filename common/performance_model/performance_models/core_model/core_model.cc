@@ -10,9 +10,11 @@
 #include "log.h"
 
 std::map<String, const CoreModel*> CoreModel::s_core_models;
+Lock CoreModel::s_core_models_lock;
 
 const CoreModel* CoreModel::getCoreModel(String type)
 {
+   ScopedLock sl(s_core_models_lock);
    if (!s_core_models.count(type))
    {
       if (type == "nehalem")
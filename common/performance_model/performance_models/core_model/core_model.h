@@ -3,8 +3,9 @@
 
 #include "fixed_types.h"
 #include "subsecond_time.h"
-#include "allocator.h"
+#include "arena_allocator.h"
 #include "dynamic_micro_op.h"
+#include "lock.h"
 
 #include <map>
 
@@ -18,6 +19,7 @@ class CoreModel
 {
    private:
       static std::map<String, const CoreModel*> s_core_models;
+      static Lock s_core_models_lock;
 
    public:
       static const CoreModel* getCoreModel(String type);
@@ -44,8 +46,10 @@ template <typename T> class BaseCoreModel : public CoreModel
    public:
       virtual Allocator* createDMOAllocator() const
       {
-         // We need to be able to hold one (Pin) trace worth of MicroOps, as we can only stop functional simulation at the skew barrier
-         return new TypedAllocator<T, 8192>();
+         // MicroOps are freed in order when they leave the ROB, so whole arena chunks are recycled at once.
+         // There is no upper bound, as we need to be able to hold one (Pin) trace worth of MicroOps
+         // because we can only stop functional simulation at the skew barrier
+         return new ArenaAllocator<>();
       }
 
       DynamicMicroOp* createDynamicMicroOp(Allocator *alloc, const MicroOp *uop, ComponentPeriod period) const
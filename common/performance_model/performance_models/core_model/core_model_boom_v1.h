@@ -4,7 +4,7 @@
 #include "core_model.h"
 #include "dynamic_micro_op_boom_v1.h"
 
-class CoreModelBoomV1 : public BaseCoreModel<DynamicMicroOpBoomV1>
+class CoreModelBoomV1 final : public BaseCoreModel<DynamicMicroOpBoomV1>
 {
    private:
       unsigned int m_lll_cutoff;
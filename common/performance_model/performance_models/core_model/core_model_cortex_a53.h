@@ -4,7 +4,7 @@
 #include "core_model.h"
 #include "dynamic_micro_op_cortex_a72.h"
 
-class CoreModelCortexA53 : public BaseCoreModel<DynamicMicroOpCortexA72>
+class CoreModelCortexA53 final : public BaseCoreModel<DynamicMicroOpCortexA72>
 {
    private:
       unsigned int m_lll_cutoff;
@@ -4,7 +4,7 @@
 #include "core_model.h"
 #include "dynamic_micro_op_nehalem.h"
 
-class CoreModelNehalem : public BaseCoreModel<DynamicMicroOpNehalem>
+class CoreModelNehalem final : public BaseCoreModel<DynamicMicroOpNehalem>
 {
    private:
       unsigned int m_lll_cutoff;
@@ -86,4 +86,5 @@ DynamicMicroOpBoomV1::DynamicMicroOpBoomV1(const MicroOp *uop, const CoreModel *
    , uop_alu(DynamicMicroOpBoomV1::getAlu(uop))
    , uop_bypass(DynamicMicroOpBoomV1::getBypassType(uop))
 {
+   setPortIndex(uop_port);
 }
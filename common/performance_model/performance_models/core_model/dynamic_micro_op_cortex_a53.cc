@@ -130,6 +130,7 @@ DynamicMicroOpCortexA53::DynamicMicroOpCortexA53(const MicroOp *uop, const CoreM
     , uop_bypass(DynamicMicroOpCortexA53::getBypassType(uop))
     , uop_issue_slot(getIssueSlot(uop))
 {
+    setPortIndex(uop_port);
 }
 
 #endif /* SNIPER_ARM */
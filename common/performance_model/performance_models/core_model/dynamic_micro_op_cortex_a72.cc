@@ -153,6 +153,7 @@ DynamicMicroOpCortexA72::DynamicMicroOpCortexA72(const MicroOp *uop, const CoreM
    , uop_alu(DynamicMicroOpCortexA72::getAlu(uop))
    , uop_bypass(DynamicMicroOpCortexA72::getBypassType(uop))
 {
+   setPortIndex(uop_port);
 }
 
 #endif /* SNIPER_ARM */
@@ -207,4 +207,5 @@ DynamicMicroOpNehalem::DynamicMicroOpNehalem(const MicroOp *uop, const CoreModel
    , uop_alu(DynamicMicroOpNehalem::getAlu(uop))
    , uop_bypass(DynamicMicroOpNehalem::getBypassType(uop))
 {
+   setPortIndex(uop_port);
 }
@@ -0,0 +1,29 @@
+#include "inorder_performance_model.h"
+#include "config.hpp"
+
+// Memory operations are issued at fetch: their latency is known before the micro-ops reach the timer
+InOrderPerformanceModel::InOrderPerformanceModel(Core *core)
+    : MicroOpPerformanceModel(core, true)
+    , inorder_timer(core,
+       m_core_model,
+       Sim()->getCfg()->getIntArray("perf_model/branch_predictor/mispredict_penalty", core->getId())
+    )
+{
+}
+
+InOrderPerformanceModel::~InOrderPerformanceModel()
+{
+}
+
+boost::tuple<uint64_t,uint64_t> InOrderPerformanceModel::simulate(const std::vector<DynamicMicroOp*>& insts)
+{
+   uint64_t ins; SubsecondTime latency;
+   boost::tie(ins, latency) = inorder_timer.simulate(insts);
+
+   return boost::tuple<uint64_t,uint64_t>(ins, SubsecondTime::divideRounded(latency, m_elapsed_time.getPeriod()));
+}
+
+void InOrderPerformanceModel::notifyElapsedTimeUpdate()
+{
+   inorder_timer.synchronize(m_elapsed_time.getElapsedTime());
+}
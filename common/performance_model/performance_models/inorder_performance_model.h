@@ -0,0 +1,19 @@
+#ifndef INORDER_PERFORMANCE_MODEL_H
+#define INORDER_PERFORMANCE_MODEL_H
+
+#include "micro_op_performance_model.h"
+#include "inorder_timer.h"
+
+class InOrderPerformanceModel : public MicroOpPerformanceModel
+{
+public:
+   InOrderPerformanceModel(Core *core);
+   ~InOrderPerformanceModel();
+protected:
+   virtual boost::tuple<uint64_t,uint64_t> simulate(const std::vector<DynamicMicroOp*>& insts);
+   virtual void notifyElapsedTimeUpdate();
+private:
+   InOrderTimer inorder_timer;
+};
+
+#endif
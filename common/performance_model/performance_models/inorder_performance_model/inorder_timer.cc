@@ -0,0 +1,178 @@
+#include "inorder_timer.h"
+#include "core.h"
+#include "core_model.h"
+#include "rob_contention.h"
+#include "register_dependencies.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "stats.h"
+
+#include <algorithm>
+
+InOrderTimer::InOrderTimer(Core *core, const CoreModel *core_model, int misprediction_penalty)
+   : m_issue_width(Sim()->getCfg()->getIntArray("perf_model/core/inorder_timer/issue_width", core->getId()))
+   , m_misprediction_penalty(misprediction_penalty)
+   , m_blocking_loads(Sim()->getCfg()->getBoolArray("perf_model/core/inorder_timer/blocking_loads", core->getId()))
+   , m_contention(
+      Sim()->getCfg()->getBoolArray("perf_model/core/inorder_timer/issue_contention", core->getId())
+      ? core_model->createRobContentionModel(core)
+      : NULL)
+   , m_register_dependencies(new RegisterDependencies())
+   , m_now(core->getDvfsDomain())
+   , m_issued(0)
+   , m_stall_until(SubsecondTime::Zero())
+   , m_stall_component(NULL)
+   , m_last_done(SubsecondTime::Zero())
+   , m_next_sequence_number(0)
+   , m_uops_total(0)
+   , m_blocking_loads_count(0)
+   , m_cpiBase(SubsecondTime::Zero())
+   , m_cpiBranchPredictor(SubsecondTime::Zero())
+   , m_cpiSerialization(SubsecondTime::Zero())
+   , m_cpiInstructionCache(HitWhere::NUM_HITWHERES, SubsecondTime::Zero())
+   , m_cpiDataCache(HitWhere::NUM_HITWHERES, SubsecondTime::Zero())
+{
+   LOG_ASSERT_ERROR(m_issue_width > 0, "perf_model/core/inorder_timer/issue_width must be at least 1");
+
+   for(uint64_t i = 0; i < SCOREBOARD_SIZE; ++i)
+   {
+      m_scoreboard[i].done = SubsecondTime::Zero();
+      m_scoreboard[i].cpi_component = &m_cpiBase;
+   }
+
+   registerStatsMetric("inorder_timer", core->getId(), "uops_total", &m_uops_total);
+   registerStatsMetric("inorder_timer", core->getId(), "blocking_loads", &m_blocking_loads_count);
+   registerStatsMetric("inorder_timer", core->getId(), "cpiBase", &m_cpiBase);
+   registerStatsMetric("inorder_timer", core->getId(), "cpiBranchPredictor", &m_cpiBranchPredictor);
+   registerStatsMetric("inorder_timer", core->getId(), "cpiSerialization", &m_cpiSerialization);
+   for (int h = HitWhere::WHERE_FIRST ; h < HitWhere::NUM_HITWHERES ; h++)
+   {
+      if (HitWhereIsValid((HitWhere::where_t)h))
+      {
+         registerStatsMetric("inorder_timer", core->getId(), "cpiInstructionCache" + String(HitWhereString((HitWhere::where_t)h)), &(m_cpiInstructionCache[h]));
+         registerStatsMetric("inorder_timer", core->getId(), "cpiDataCache" + String(HitWhereString((HitWhere::where_t)h)), &(m_cpiDataCache[h]));
+      }
+   }
+
+   newCycle();
+}
+
+InOrderTimer::~InOrderTimer()
+{
+   delete m_register_dependencies;
+   if (m_contention)
+      delete m_contention;
+}
+
+void InOrderTimer::newCycle()
+{
+   m_issued = 0;
+   if (m_contention)
+      m_contention->initCycle(m_now);
+}
+
+// Move issue forward to until, accounting the time spent waiting to cpi_component
+void InOrderTimer::advance(SubsecondTime until, SubsecondTime *cpi_component)
+{
+   if (until <= m_now)
+      return;
+   *cpi_component += until - m_now;
+   m_now.setElapsedTime(until);
+   newCycle();
+}
+
+void InOrderTimer::issue(DynamicMicroOp *uop)
+{
+   const MicroOp *microop = uop->getMicroOp();
+   uint64_t sequence_number = m_next_sequence_number++;
+   uop->setSequenceNumber(sequence_number);
+   uint64_t lowest_valid = sequence_number > SCOREBOARD_SIZE ? sequence_number - SCOREBOARD_SIZE : 0;
+   m_register_dependencies->setDependencies(*uop, lowest_valid);
+   ++m_uops_total;
+
+   // Front-end bubble on an instruction cache miss
+   if (uop->isFirst() && uop->getICacheHitWhere() != HitWhere::L1I)
+      advance(m_now + uop->getICacheLatency(), &m_cpiInstructionCache[uop->getICacheHitWhere()]);
+
+   // A preceding load miss or mispredicted branch holds up issue
+   if (m_stall_until > m_now)
+      advance(m_stall_until, m_stall_component);
+
+   // Serializing instructions wait for everything before them to complete
+   if (microop->isSerializing() || microop->isMemBarrier())
+      advance(m_last_done, &m_cpiSerialization);
+
+   // Scoreboard: wait for the source operands
+   for(uint32_t i = 0; i < uop->getDependenciesLength(); ++i)
+   {
+      uint64_t producer = uop->getDependency(i);
+      if (producer < lowest_valid || producer >= sequence_number)
+         continue;
+      const Producer &entry = m_scoreboard[producer % SCOREBOARD_SIZE];
+      advance(entry.done, entry.cpi_component);
+   }
+
+   // Issue width, pairing and port rules
+   while (m_issued >= m_issue_width || (m_contention && !m_contention->tryIssue(*uop)))
+      advance(m_now + 1, &m_cpiBase);
+   if (m_contention)
+      m_contention->doIssue(*uop);
+   ++m_issued;
+
+   Producer &entry = m_scoreboard[sequence_number % SCOREBOARD_SIZE];
+   entry.cpi_component = &m_cpiBase;
+   if (microop->isStore())
+   {
+      // Stores retire into the store buffer, only fences wait for them
+      entry.done = m_now + 1;
+      m_last_done = std::max(m_last_done, SubsecondTime(m_now + uop->getExecLatency()));
+      return;
+   }
+
+   entry.done = m_now + uop->getExecLatency();
+   m_last_done = std::max(m_last_done, entry.done);
+
+   if (microop->isLoad())
+   {
+      HitWhere::where_t hit_where = uop->getDCacheHitWhere();
+      if (hit_where != HitWhere::UNKNOWN)
+         entry.cpi_component = &m_cpiDataCache[hit_where];
+      if (m_blocking_loads && hit_where != HitWhere::L1_OWN && hit_where != HitWhere::UNKNOWN)
+      {
+         ++m_blocking_loads_count;
+         m_stall_until = entry.done;
+         m_stall_component = entry.cpi_component;
+      }
+   }
+   else if (microop->isBranch() && uop->isBranchMispredicted())
+   {
+      m_stall_until = entry.done + m_misprediction_penalty * m_now.getPeriod();
+      m_stall_component = &m_cpiBranchPredictor;
+   }
+}
+
+boost::tuple<uint64_t,SubsecondTime> InOrderTimer::simulate(const std::vector<DynamicMicroOp*>& insts)
+{
+   SubsecondTime start = m_now;
+   uint64_t instructions = 0;
+
+   for (std::vector<DynamicMicroOp*>::const_iterator it = insts.begin(); it != insts.end(); it++)
+   {
+      if (!(*it)->isSquashed())
+      {
+         issue(*it);
+         if ((*it)->isLast())
+            ++instructions;
+      }
+      delete *it;
+   }
+
+   return boost::tuple<uint64_t,SubsecondTime>(instructions, m_now - start);
+}
+
+void InOrderTimer::synchronize(SubsecondTime time)
+{
+   // Time jumped ahead (synchronization, idle periods): everything in flight has completed by then
+   m_now.setElapsedTime(time);
+   newCycle();
+}
@@ -0,0 +1,70 @@
+#ifndef INORDER_TIMER_H
+#define INORDER_TIMER_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "dynamic_micro_op.h"
+
+#include <boost/tuple/tuple.hpp>
+#include <vector>
+
+class Core;
+class CoreModel;
+class RobContention;
+class RegisterDependencies;
+
+// Timing model for small in-order cores (e.g. Cortex-A53): micro-ops issue strictly in program order, up to
+// issue_width per cycle and subject to the core model's pairing and port rules (its RobContention model).
+// Instead of a ROB, a register scoreboard keeps the time each recent micro-op's result becomes available, so
+// the cost per micro-op is a handful of lookups. Loads that miss the L1 data cache stall issue until their data
+// returns, mispredicted branches stall it for the misprediction penalty after they execute.
+class InOrderTimer
+{
+   public:
+      InOrderTimer(Core *core, const CoreModel *core_model, int misprediction_penalty);
+      ~InOrderTimer();
+
+      // Returns the number of instructions completed, and how far issue advanced
+      boost::tuple<uint64_t,SubsecondTime> simulate(const std::vector<DynamicMicroOp*>& insts);
+      void synchronize(SubsecondTime time);
+
+   private:
+      // Scoreboard entry of an in-flight micro-op, indexed by sequence number
+      struct Producer
+      {
+         SubsecondTime done;
+         SubsecondTime *cpi_component;  // Where waiting on this result is accounted
+      };
+      // Micro-ops further back than this are complete by the time a consumer issues
+      static const uint64_t SCOREBOARD_SIZE = 256;
+
+      const uint64_t m_issue_width;
+      const uint64_t m_misprediction_penalty;
+      const bool m_blocking_loads;
+
+      RobContention *m_contention;
+      RegisterDependencies *m_register_dependencies;
+
+      ComponentTime m_now;           // Issue cycle
+      uint64_t m_issued;             // Micro-ops issued in the current cycle
+      SubsecondTime m_stall_until;   // Issue blocked by a load miss or branch misprediction
+      SubsecondTime *m_stall_component;
+      SubsecondTime m_last_done;     // Completion of all micro-ops issued so far, for serializing instructions
+
+      uint64_t m_next_sequence_number;
+      Producer m_scoreboard[SCOREBOARD_SIZE];
+
+      UInt64 m_uops_total;
+      UInt64 m_blocking_loads_count;
+      SubsecondTime m_cpiBase;
+      SubsecondTime m_cpiBranchPredictor;
+      SubsecondTime m_cpiSerialization;
+      std::vector<SubsecondTime> m_cpiInstructionCache;
+      std::vector<SubsecondTime> m_cpiDataCache;
+
+      void advance(SubsecondTime until, SubsecondTime *cpi_component);
+      void newCycle();
+      void issue(DynamicMicroOp *uop);
+};
+
+#endif // INORDER_TIMER_H
@@ -6,19 +6,31 @@
 #define __INTERVAL_CONTENTION_H
 
 #include "fixed_types.h"
+#include "dynamic_micro_op.h"
+
+#include <cstring>
 
 class Core;
 class CoreModel;
-class DynamicMicroOp;
 
 class IntervalContention {
    public:
       static IntervalContention* createIntervalContentionModel(Core *core, const CoreModel *core_model);
 
-      virtual void clearFunctionalUnitStats() = 0;
-      virtual void addFunctionalUnitStats(const DynamicMicroOp *uop) = 0;
-      virtual void removeFunctionalUnitStats(const DynamicMicroOp *uop) = 0;
+      IntervalContention() { clearFunctionalUnitStats(); }
+      virtual ~IntervalContention() {}
+
+      // Micro-ops entering and leaving the old window only update a per-port counter, indexed by the port their core
+      // model assigned (DynamicMicroOp::getPortIndex), so there is no virtual call or dynamic_cast per micro-op.
+      // Turning the port pressure into a dispatch limit is left to the core model.
+      void clearFunctionalUnitStats() { memset(m_count_byport, 0, sizeof(m_count_byport)); }
+      void addFunctionalUnitStats(const DynamicMicroOp *uop) { ++m_count_byport[uop->getPortIndex()]; }
+      void removeFunctionalUnitStats(const DynamicMicroOp *uop) { --m_count_byport[uop->getPortIndex()]; }
       virtual uint64_t getEffectiveCriticalPathLength(uint64_t critical_path_length, bool update_reason) = 0;
+
+   protected:
+      static const unsigned int MAX_PORTS = 16;
+      uint32_t m_count_byport[MAX_PORTS];
 };
 
 #endif // __INTERVAL_CONTENTION_H
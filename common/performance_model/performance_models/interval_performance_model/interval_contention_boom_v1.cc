@@ -9,6 +9,8 @@
 IntervalContentionBoomV1::IntervalContentionBoomV1(const Core *core, const CoreModel *core_model)
    : m_core_model(core_model)
 {
+   static_assert(DynamicMicroOpBoomV1::UOP_PORT_SIZE <= MAX_PORTS, "Too many ports for IntervalContention");
+
    for(unsigned int i = 0; i < DynamicMicroOpBoomV1::UOP_PORT_SIZE; ++i)
    {
       m_cpContrByPort[i] = 0;
@@ -17,24 +19,6 @@ IntervalContentionBoomV1::IntervalContentionBoomV1(const Core *core, const CoreM
    }
 }
 
-void IntervalContentionBoomV1::clearFunctionalUnitStats()
-{
-   for(unsigned int i = 0; i < (unsigned int)DynamicMicroOpBoomV1::UOP_PORT_SIZE; ++i)
-   {
-      m_count_byport[i] = 0;
-   }
-}
-
-void IntervalContentionBoomV1::addFunctionalUnitStats(const DynamicMicroOp *uop)
-{
-   m_count_byport[uop->getCoreSpecificInfo<DynamicMicroOpBoomV1>()->getPort()]++;
-}
-
-void IntervalContentionBoomV1::removeFunctionalUnitStats(const DynamicMicroOp *uop)
-{
-   m_count_byport[uop->getCoreSpecificInfo<DynamicMicroOpBoomV1>()->getPort()]--;
-}
-
 uint64_t IntervalContentionBoomV1::getEffectiveCriticalPathLength(uint64_t critical_path_length, bool update_reason)
 {
    DynamicMicroOpBoomV1::uop_port_t reason = DynamicMicroOpBoomV1::UOP_PORT_SIZE;
@@ -9,6 +9,8 @@
 IntervalContentionCortexA53::IntervalContentionCortexA53(const Core *core, const CoreModel *core_model)
    : m_core_model(core_model)
 {
+   static_assert(DynamicMicroOpCortexA53::UOP_PORT_SIZE <= MAX_PORTS, "Too many ports for IntervalContention");
+
    for(unsigned int i = 0; i < DynamicMicroOpCortexA53::UOP_PORT_SIZE; ++i)
    {
       m_cpContrByPort[i] = 0;
@@ -17,24 +19,6 @@ IntervalContentionCortexA53::IntervalContentionCortexA53(const Core *core, const
    }
 }
 
-void IntervalContentionCortexA53::clearFunctionalUnitStats()
-{
-   for(unsigned int i = 0; i < (unsigned int)DynamicMicroOpCortexA53::UOP_PORT_SIZE; ++i)
-   {
-      m_count_byport[i] = 0;
-   }
-}
-
-void IntervalContentionCortexA53::addFunctionalUnitStats(const DynamicMicroOp *uop)
-{
-   m_count_byport[uop->getCoreSpecificInfo<DynamicMicroOpCortexA53>()->getPort()]++;
-}
-
-void IntervalContentionCortexA53::removeFunctionalUnitStats(const DynamicMicroOp *uop)
-{
-   m_count_byport[uop->getCoreSpecificInfo<DynamicMicroOpCortexA53>()->getPort()]--;
-}
-
 uint64_t IntervalContentionCortexA53::getEffectiveCriticalPathLength(uint64_t critical_path_length, bool update_reason)
 {
    //DynamicMicroOpCortexA53::uop_port_t reason = DynamicMicroOpCortexA53::UOP_PORT_SIZE;
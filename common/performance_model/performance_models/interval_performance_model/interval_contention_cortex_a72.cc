@@ -9,6 +9,8 @@
 IntervalContentionCortexA72::IntervalContentionCortexA72(const Core *core, const CoreModel *core_model)
    : m_core_model(core_model)
 {
+   static_assert(DynamicMicroOpCortexA72::UOP_PORT_SIZE <= MAX_PORTS, "Too many ports for IntervalContention");
+
    for(unsigned int i = 0; i < DynamicMicroOpCortexA72::UOP_PORT_SIZE; ++i)
    {
       m_cpContrByPort[i] = 0;
@@ -17,24 +19,6 @@ IntervalContentionCortexA72::IntervalContentionCortexA72(const Core *core, const
    }
 }
 
-void IntervalContentionCortexA72::clearFunctionalUnitStats()
-{
-   for(unsigned int i = 0; i < (unsigned int)DynamicMicroOpCortexA72::UOP_PORT_SIZE; ++i)
-   {
-      m_count_byport[i] = 0;
-   }
-}
-
-void IntervalContentionCortexA72::addFunctionalUnitStats(const DynamicMicroOp *uop)
-{
-   m_count_byport[uop->getCoreSpecificInfo<DynamicMicroOpCortexA72>()->getPort()]++;
-}
-
-void IntervalContentionCortexA72::removeFunctionalUnitStats(const DynamicMicroOp *uop)
-{
-   m_count_byport[uop->getCoreSpecificInfo<DynamicMicroOpCortexA72>()->getPort()]--;
-}
-
 uint64_t IntervalContentionCortexA72::getEffectiveCriticalPathLength(uint64_t critical_path_length, bool update_reason)
 {
    //DynamicMicroOpCortexA72::uop_port_t reason = DynamicMicroOpCortexA72::UOP_PORT_SIZE;
@@ -9,6 +9,8 @@
 IntervalContentionNehalem::IntervalContentionNehalem(const Core *core, const CoreModel *core_model)
    : m_core_model(core_model)
 {
+   static_assert(DynamicMicroOpNehalem::UOP_PORT_SIZE <= MAX_PORTS, "Too many ports for IntervalContention");
+
    for(unsigned int i = 0; i < DynamicMicroOpNehalem::UOP_PORT_SIZE; ++i)
    {
       m_cpContrByPort[i] = 0;
@@ -17,24 +19,6 @@ IntervalContentionNehalem::IntervalContentionNehalem(const Core *core, const Cor
    }
 }
 
-void IntervalContentionNehalem::clearFunctionalUnitStats()
-{
-   for(unsigned int i = 0; i < (unsigned int)DynamicMicroOpNehalem::UOP_PORT_SIZE; ++i)
-   {
-      m_count_byport[i] = 0;
-   }
-}
-
-void IntervalContentionNehalem::addFunctionalUnitStats(const DynamicMicroOp *uop)
-{
-   m_count_byport[uop->getCoreSpecificInfo<DynamicMicroOpNehalem>()->getPort()]++;
-}
-
-void IntervalContentionNehalem::removeFunctionalUnitStats(const DynamicMicroOp *uop)
-{
-   m_count_byport[uop->getCoreSpecificInfo<DynamicMicroOpNehalem>()->getPort()]--;
-}
-
 uint64_t IntervalContentionNehalem::getEffectiveCriticalPathLength(uint64_t critical_path_length, bool update_reason)
 {
    DynamicMicroOpNehalem::uop_port_t reason = DynamicMicroOpNehalem::UOP_PORT_SIZE;
@@ -347,7 +347,7 @@ void IntervalTimer::issueMemOp(Windows::WindowEntry& micro_op)
          Core::MEM_MODELED_RETURN,
          micro_op.getMicroOp()->getInstruction() ? micro_op.getMicroOp()->getInstruction()->getAddress() : static_cast<uint64_t>(NULL)
       );
-      uint64_t latency = SubsecondTime::divideRounded(res.latency, m_core->getDvfsDomain()->getPeriod());
+      uint64_t latency = SubsecondTime::divideRounded(res.latency, *m_core->getDvfsDomain());
       micro_op.getDynMicroOp()->setExecLatency(micro_op.getDynMicroOp()->getExecLatency() + latency); // execlatency already contains bypass latency
       micro_op.getDynMicroOp()->setDCacheHitWhere(res.hit_where);
    }
@@ -355,6 +355,11 @@ int Windows::calculateBranchResolutionLatency()
 
    // The m_exec_time_map is empty when the algorithm starts !
 
+   // Sequence number of the oldest marked producer: the backward walk below can stop once it has passed it,
+   // rather than visiting the whole old window. Dependency chains leading to a branch are usually short
+   // compared to the old window, so this makes the walk proportional to the chain's extent.
+   uint64_t oldest_marked = UINT64_MAX;
+
    // Mark direct producers of this instruction
    for(uint32_t i = 0; i < micro_op.getDynMicroOp()->getDependenciesLength(); i++)
    {
@@ -362,22 +367,28 @@ int Windows::calculateBranchResolutionLatency()
       {
          Windows::WindowEntry& producer = getInstruction(micro_op.getDynMicroOp()->getDependency(i));
          m_exec_time_map[producer.getWindowIndex()] = producer.getDynMicroOp()->getExecLatency();
+         oldest_marked = std::min(oldest_marked, producer.getSequenceNumber());
       }
    }
 
    // Find/mark producers of producers
    for (int i = windowIndex(m_window_head__old_window_tail - 1), j = 0; j < m_old_window_length; i = windowIndex(i - 1), j++)
    {
+      Windows::WindowEntry& op = getInstructionByIndex(i);
+      if (op.getSequenceNumber() < oldest_marked)
+         // Everything older is unmarked
+         break;
+
       if (m_exec_time_map[i])
       {
          // There is a path to the committed branch: check the dependencies
-         Windows::WindowEntry& op = getInstructionByIndex(i);
          for (uint32_t k = 0; k < op.getDynMicroOp()->getDependenciesLength(); k++)
          {
             if (oldWindowContains(op.getDynMicroOp()->getDependency(k)))
             {
                Windows::WindowEntry& producer = getInstruction(op.getDynMicroOp()->getDependency(k));
                m_exec_time_map[producer.getWindowIndex()] = std::max((producer.getDynMicroOp()->getExecLatency() + m_exec_time_map[i]), m_exec_time_map[producer.getWindowIndex()]);
+               oldest_marked = std::min(oldest_marked, producer.getSequenceNumber());
             }
          }
 
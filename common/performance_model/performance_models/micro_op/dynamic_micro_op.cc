@@ -28,6 +28,7 @@ DynamicMicroOp::DynamicMicroOp(const MicroOp *uop, const CoreModel *core_model,
    this->iCacheLatency = 0;
 
    this->m_forceLongLatencyLoad = false;
+   this->portIndex = 0;
 
    for(uint32_t i = 0 ; i < MAXIMUM_NUMBER_OF_DEPENDENCIES; i++)
       this->dependencies[i] = -1;
@@ -56,6 +56,9 @@ class DynamicMicroOp
 
       bool m_forceLongLatencyLoad;
 
+      /** Issue port, as the core model's port enumeration value. Used by IntervalContention without knowing the model. */
+      uint8_t portIndex;
+
       /** These first/last flags are needed in case of squashing, as long as squashed uop doesn't go to rob
           and we can't use first/last flags of m_uop in such a cases.*/
       /** This microOp is the first microOp of the instruction. */
@@ -143,11 +146,16 @@ class DynamicMicroOp
 
       void setForceLongLatencyLoad(bool forceLLL) { m_forceLongLatencyLoad = forceLLL; }
 
+      uint32_t getPortIndex() const { return portIndex; }
+
       SubsecondTime getPeriod() const { LOG_ASSERT_ERROR(m_period != SubsecondTime::Zero(), "MicroOp Period is == SubsecondTime::Zero()"); return m_period; }
 
 
       // More dynamic, architecture-dependent information to be defined by derived classes
       virtual const char* getType() const = 0; // Make this class pure virtual
+
+   protected:
+      void setPortIndex(uint32_t port) { portIndex = port; }
 };
 
 #endif // __DYNAMIC_MICRO_OP_INFO_H
@@ -11,10 +11,10 @@
 //#endif
 //}
 
-void InstructionDecoder::addSrcs(std::set<dl::Decoder::decoder_reg> regs, MicroOp * currentMicroOp) {
+template <class Set> void InstructionDecoder::addSrcs(const Set &regs, MicroOp * currentMicroOp) {
    dl::Decoder *dec = Sim()->getDecoder();
 
-   for(std::set<dl::Decoder::decoder_reg>::iterator it = regs.begin(); it != regs.end(); ++it)
+   for(typename Set::const_iterator it = regs.begin(); it != regs.end(); ++it)
       if (!(Sim()->getDecoder()->invalid_register(*it))) {
          dl::Decoder::decoder_reg reg = dec->largest_enclosing_register(*it);
          if (dec->reg_is_program_counter(reg)) continue; // eip/rip is known at decode time, shouldn't be a dependency
@@ -22,10 +22,10 @@ void InstructionDecoder::addSrcs(std::set<dl::Decoder::decoder_reg> regs, MicroO
       }
 }
 
-void InstructionDecoder::addAddrs(std::set<dl::Decoder::decoder_reg> regs, MicroOp * currentMicroOp) {
+template <class Set> void InstructionDecoder::addAddrs(const Set &regs, MicroOp * currentMicroOp) {
    dl::Decoder *dec = Sim()->getDecoder();
 
-   for(std::set<dl::Decoder::decoder_reg>::iterator it = regs.begin(); it != regs.end(); ++it)
+   for(typename Set::const_iterator it = regs.begin(); it != regs.end(); ++it)
       if (!(dec->invalid_register(*it))) {
          dl::Decoder::decoder_reg reg = dec->largest_enclosing_register(*it);
          if (dec->reg_is_program_counter(reg)) continue; // eip/rip is known at decode time, shouldn't be a dependency
@@ -33,10 +33,10 @@ void InstructionDecoder::addAddrs(std::set<dl::Decoder::decoder_reg> regs, Micro
       }
 }
 
-void InstructionDecoder::addDsts(std::set<dl::Decoder::decoder_reg> regs, MicroOp * currentMicroOp) {
+template <class Set> void InstructionDecoder::addDsts(const Set &regs, MicroOp * currentMicroOp) {
    dl::Decoder *dec = Sim()->getDecoder();
 
-   for(std::set<dl::Decoder::decoder_reg>::iterator it = regs.begin(); it != regs.end(); ++it)
+   for(typename Set::const_iterator it = regs.begin(); it != regs.end(); ++it)
       if (!(dec->invalid_register(*it))) {
          dl::Decoder::decoder_reg reg = dec->largest_enclosing_register(*it);
          if (dec->reg_is_program_counter(reg)) continue; // eip/rip is known at decode time, shouldn't be a dependency
@@ -59,8 +59,8 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address,  c
    dl::Decoder *dec = Sim()->getDecoder();
    // Determine register dependencies and number of microops per type
 
-   std::vector<std::set<dl::Decoder::decoder_reg> > regs_loads, regs_stores;
-   std::set<dl::Decoder::decoder_reg> regs_mem, regs_src, regs_dst;
+   std::vector<MemRegSet> regs_loads, regs_stores;
+   RegSet regs_mem, regs_src, regs_dst;
    std::vector<uint16_t> memop_load_size, memop_store_size;
 
    int numLoads = 0;
@@ -72,7 +72,7 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address,  c
    {
       for(uint32_t mem_idx = 0; mem_idx < dec->num_memory_operands(ins); ++mem_idx)
       {
-         std::set<dl::Decoder::decoder_reg> regs;
+         MemRegSet regs;
          regs.insert(dec->mem_base_reg(ins, mem_idx));
          regs.insert(dec->mem_index_reg(ins, mem_idx));
 
@@ -146,9 +146,14 @@ const std::vector<const MicroOp*>* InstructionDecoder::decode(IntPtr address,  c
      numExecs = totalMicroOps = 1;
    }
    
+   // The microops of an instruction are immutable once decoded and live as long as the Instruction,
+   // allocate them as one contiguous block so the dynamic microops that reference them stay close in memory
+   MicroOp *microOps = new MicroOp[totalMicroOps];
+   uops->reserve(totalMicroOps);
+
    for(int index = 0; index < totalMicroOps; ++index)
    {
-      MicroOp *currentMicroOp = new MicroOp();
+      MicroOp *currentMicroOp = &microOps[index];
       // pass the decoder object to allow access to the library 
       currentMicroOp->setInstructionPointer(Memory::make_access(address));
       
@@ -2,6 +2,7 @@
 #define INSTRUCTION_INFOWLIB_HPP_
 
 #include "fixed_types.h"
+#include "inline_set.h"
 
 #include <decoder.h>
 
@@ -10,16 +11,19 @@
 //}
 
 #include <vector>
-#include <set>
 
 class Instruction;
 class MicroOp;
 
 class InstructionDecoder {
 private:
-   static void addSrcs(std::set<dl::Decoder::decoder_reg> regs, MicroOp *uop);
-   static void addAddrs(std::set<dl::Decoder::decoder_reg> regs, MicroOp *uop);
-   static void addDsts(std::set<dl::Decoder::decoder_reg> regs, MicroOp *uop);
+   // Registers of one memory operand (base and index), and of all operands of an instruction
+   typedef InlineSet<dl::Decoder::decoder_reg, 2> MemRegSet;
+   typedef InlineSet<dl::Decoder::decoder_reg, 48> RegSet;
+
+   template <class Set> static void addSrcs(const Set &regs, MicroOp *uop);
+   template <class Set> static void addAddrs(const Set &regs, MicroOp *uop);
+   template <class Set> static void addDsts(const Set &regs, MicroOp *uop);
    static unsigned int getNumExecs(const dl::DecodedInst *ins, int numLoads, int numStores);
 public:
    static const std::vector<const MicroOp*>* decode(IntPtr address, const dl::DecodedInst *ins, Instruction *ins_ptr);
@@ -1,8 +1,22 @@
 #include "memory_dependencies.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "utils.h"
+#include "log.h"
+
+#include <algorithm>
 
 MemoryDependencies::MemoryDependencies()
-   : producers(1024) // Maximum size should be one ROB worth of instructions
+   : m_num_sets(Sim()->getCfg()->getInt("perf_model/core/memory_dependencies/sets"))
+   , m_associativity(Sim()->getCfg()->getInt("perf_model/core/memory_dependencies/associativity"))
+   , m_producers(m_num_sets * m_associativity)
+   , m_store_sets(Sim()->getCfg()->getInt("perf_model/core/memory_dependencies/store_sets"))
+   , m_ssit(m_store_sets)
+   , m_lfst(m_store_sets)
 {
+   LOG_ASSERT_ERROR(m_num_sets > 0 && isPower2(m_num_sets), "perf_model/core/memory_dependencies/sets must be a power of two");
+   LOG_ASSERT_ERROR(m_associativity > 0, "perf_model/core/memory_dependencies/associativity must be at least 1");
+   LOG_ASSERT_ERROR(m_store_sets == 0 || isPower2(m_store_sets), "perf_model/core/memory_dependencies/store_sets must be zero or a power of two");
    clear();
 }
 
@@ -12,16 +26,29 @@ MemoryDependencies::~MemoryDependencies()
 
 void MemoryDependencies::setDependencies(DynamicMicroOp &microOp, uint64_t lowestValidSequenceNumber)
 {
-   // Remove all entries that are now below lowestValidSequenceNumber
+   // Entries below lowestValidSequenceNumber are no longer valid
    clean(lowestValidSequenceNumber);
 
    if (microOp.getMicroOp()->isLoad())
    {
       uint64_t physicalAddress = microOp.getLoadAccess().phys;
-      uint64_t producerSequenceNumber = find(physicalAddress);
-      if (producerSequenceNumber != INVALID_SEQNR) /* producer found */
+      const Producer *producer = find(physicalAddress);
+      if (producer) /* producer found */
       {
-         microOp.addDependency(producerSequenceNumber);
+         microOp.addDependency(producer->seqnr);
+      }
+
+      if (m_store_sets)
+      {
+         uint64_t eip = microOp.getMicroOp()->getInstructionPointer().address;
+         if (producer)
+            storeSetTrain(eip, producer->eip);
+
+         uint64_t predictedSequenceNumber = storeSetFind(eip);
+         if (predictedSequenceNumber != INVALID_SEQNR && (!producer || predictedSequenceNumber != producer->seqnr))
+         {
+            microOp.addDependency(predictedSequenceNumber);
+         }
       }
 
       if ((membar != INVALID_SEQNR) && (membar > lowestValidSequenceNumber))
@@ -32,7 +59,11 @@ void MemoryDependencies::setDependencies(DynamicMicroOp &microOp, uint64_t lowes
    else if (microOp.getMicroOp()->isStore())
    {
       uint64_t physicalAddress = microOp.getStoreAccess().phys;
-      add(microOp.getSequenceNumber(), physicalAddress);
+      uint64_t eip = microOp.getMicroOp()->getInstructionPointer().address;
+      add(microOp.getSequenceNumber(), physicalAddress, eip);
+
+      if (m_store_sets)
+         storeSetAdd(microOp.getSequenceNumber(), eip);
 
       // Stores are also dependent on membars
       if ((membar != INVALID_SEQNR) && (membar > lowestValidSequenceNumber))
@@ -56,30 +87,94 @@ void MemoryDependencies::setDependencies(DynamicMicroOp &microOp, uint64_t lowes
    }
 }
 
-void MemoryDependencies::add(uint64_t sequenceNumber, uint64_t address)
+void MemoryDependencies::add(uint64_t sequenceNumber, uint64_t address, uint64_t eip)
 {
-   Producer producer = {sequenceNumber, address};
-   producers.push(producer);
+   // A later store to the same address replaces the earlier one, otherwise replace a free
+   // (no longer valid) entry, or if there is none, the oldest store of the set
+   Producer *set = getSet(address);
+   Producer *victim = NULL;
+   for(UInt32 way = 0; way < m_associativity; ++way)
+   {
+      Producer &entry = set[way];
+      if (entry.address == address && entry.seqnr != INVALID_SEQNR)
+      {
+         victim = &entry;
+         break;
+      }
+      if (!isLive(entry))
+      {
+         if (!victim || isLive(*victim))
+            victim = &entry;
+      }
+      else if (!victim || (isLive(*victim) && entry.seqnr < victim->seqnr))
+         victim = &entry;
+   }
+   victim->seqnr = sequenceNumber;
+   victim->address = address;
+   victim->eip = eip;
 }
 
-uint64_t MemoryDependencies::find(uint64_t address)
+const MemoryDependencies::Producer* MemoryDependencies::find(uint64_t address)
 {
-   // There may be multiple entries with the same address, we want the latest one so traverse list in reverse order
-   for(int i = producers.size() - 1; i >= 0; --i)
-      if (producers.at(i).address == address)
-         return producers.at(i).seqnr;
-   return INVALID_SEQNR;
+   // There is at most one entry per address, holding the latest store
+   Producer *set = getSet(address);
+   for(UInt32 way = 0; way < m_associativity; ++way)
+      if (set[way].address == address && isLive(set[way]))
+         return &set[way];
+   return NULL;
 }
 
 void MemoryDependencies::clean(uint64_t lowestValidSequenceNumber)
 {
-   while(!producers.empty() && producers.front().seqnr < lowestValidSequenceNumber)
-      producers.pop();
+   m_lowest_valid = lowestValidSequenceNumber;
+}
+
+void MemoryDependencies::storeSetAdd(uint64_t sequenceNumber, uint64_t eip)
+{
+   UInt32 store_set = getStoreSet(eip);
+   if (store_set != INVALID_STORE_SET)
+      m_lfst[store_set] = sequenceNumber;
+}
+
+uint64_t MemoryDependencies::storeSetFind(uint64_t eip)
+{
+   UInt32 store_set = getStoreSet(eip);
+   if (store_set == INVALID_STORE_SET)
+      return INVALID_SEQNR;
+
+   uint64_t sequenceNumber = m_lfst[store_set];
+   if (sequenceNumber == INVALID_SEQNR || sequenceNumber < m_lowest_valid)
+      return INVALID_SEQNR;
+   return sequenceNumber;
+}
+
+void MemoryDependencies::storeSetTrain(uint64_t load_eip, uint64_t store_eip)
+{
+   UInt32 &load_set = getStoreSet(load_eip);
+   UInt32 &store_set = getStoreSet(store_eip);
+
+   if (load_set == INVALID_STORE_SET && store_set == INVALID_STORE_SET)
+      // New store set, named after its SSIT index
+      load_set = store_set = UInt32(&store_set - m_ssit.data());
+   else if (load_set == INVALID_STORE_SET)
+      load_set = store_set;
+   else if (store_set == INVALID_STORE_SET)
+      store_set = load_set;
+   else
+   {
+      // Merge: both move to the set with the smaller identifier
+      UInt32 merged = std::min(load_set, store_set);
+      load_set = store_set = merged;
+   }
 }
 
 void MemoryDependencies::clear()
 {
-   while(!producers.empty())
-      producers.pop();
+   for(std::vector<Producer>::iterator it = m_producers.begin(); it != m_producers.end(); ++it)
+      it->seqnr = INVALID_SEQNR;
+   m_lowest_valid = 0;
    membar = INVALID_SEQNR;
+
+   std::fill(m_ssit.begin(), m_ssit.end(), INVALID_STORE_SET);
+   std::fill(m_lfst.begin(), m_lfst.end(), INVALID_SEQNR);
 }
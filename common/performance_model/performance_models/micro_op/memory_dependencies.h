@@ -2,9 +2,10 @@
 #define __MEMORY_DEPENDENCIES_H
 
 #include "fixed_types.h"
-#include "circular_queue.h"
 #include "dynamic_micro_op.h"
 
+#include <vector>
+
 class MemoryDependencies
 {
    private:
@@ -12,22 +13,45 @@ class MemoryDependencies
       {
          uint64_t seqnr;
          uint64_t address;
+         uint64_t eip;
       };
-      // List of all active writers, ordered by sequence number
-      // This makes it easy to remove old entries, just compare the front of the queue with lowestValidSequenceNumber
-      // Finding the latest producer is a linear search, starting from the tail (there may be multiple entries
-      // with the same address, we want the latest one).
-      // Maximum number of entries is the number of instructions in the ROB, actual number of entries equals
-      // the number of writes in the ROB which is usually not larger than around 20.
-      // More fancy data structures, such as an underdered_map keyed on address, have a much higher overhead on insertion
-      // and put significant pressure on malloc()/free(), and are therefore not recommended.
-      CircularQueue<Producer> producers;
+      // Store-address table, modeled after the store queue: a fixed-size, set-associative table of the latest
+      // store to each address, tagged with its sequence number (perf_model/core/memory_dependencies).
+      // Entries older than lowestValidSequenceNumber have left the ROB and are simply ignored (and reused first),
+      // so there is no cleanup pass. A store evicted by a conflict while still in flight is no longer seen
+      // by younger loads, as in a real store queue that lost the entry; make the table large enough for the ROB.
+      // Lookups and insertions only touch one set, and memory use is fixed per core.
+      const UInt32 m_num_sets;
+      const UInt32 m_associativity;
+      std::vector<Producer> m_producers;
+      uint64_t m_lowest_valid;
       uint64_t membar;
 
-      void add(uint64_t sequenceNumber, uint64_t address);
-      uint64_t find(uint64_t address);
+      // Optional memory-dependence prediction, after store sets (Chrysos and Emer, ISCA 1998):
+      // the store set identifier table (SSIT) maps load and store instruction addresses to a store set,
+      // the last fetched store table (LFST) keeps the latest in-flight store of each set.
+      // A load also depends on the last store of its set, even if it accesses a different address.
+      // Loads and stores are put into a common set after the load was found to read from that store.
+      static const UInt32 INVALID_STORE_SET = UINT32_MAX;
+      const UInt32 m_store_sets;
+      std::vector<UInt32> m_ssit;
+      std::vector<uint64_t> m_lfst;
+
+      bool isLive(const Producer &producer) const
+      { return producer.seqnr != INVALID_SEQNR && producer.seqnr >= m_lowest_valid; }
+      Producer* getSet(uint64_t address)
+      { return &m_producers[(((address >> 3) ^ (address >> 13)) & (m_num_sets - 1)) * m_associativity]; }
+      UInt32& getStoreSet(uint64_t eip)
+      { return m_ssit[(eip ^ (eip >> 10)) & (m_store_sets - 1)]; }
+
+      void add(uint64_t sequenceNumber, uint64_t address, uint64_t eip);
+      const Producer* find(uint64_t address);
       void clean(uint64_t lowestValidSequenceNumber);
 
+      void storeSetAdd(uint64_t sequenceNumber, uint64_t eip);
+      uint64_t storeSetFind(uint64_t eip);
+      void storeSetTrain(uint64_t load_eip, uint64_t store_eip);
+
    public:
       MemoryDependencies();
       ~MemoryDependencies();
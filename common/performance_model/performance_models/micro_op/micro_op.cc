@@ -48,6 +48,7 @@ MicroOp::MicroOp()
 
    this->m_membar = false;
    this->is_x87 = false;
+   this->fp_ldst = false;
    this->operand_size = 0;
 
    for(uint32_t i = 0 ; i < MAXIMUM_NUMBER_OF_SOURCE_REGISTERS; i++)
@@ -178,11 +179,12 @@ String MicroOp::getSubtypeString(uop_subtype_t uop_subtype)
    }
 }
 
-bool MicroOp::isFpLoadStore() const
+bool MicroOp::getFpLoadStore(const MicroOp& uop)
 {
-   if (isLoad() || isStore())
+   // Only depends on the static instruction, evaluated once when the microop is made rather than per dynamic instance
+   if (uop.isLoad() || uop.isStore())
    {
-      switch(getSubtype_Exec(*this))
+      switch(getSubtype_Exec(uop))
       {
          case UOP_SUBTYPE_FP_ADDSUB:
          case UOP_SUBTYPE_FP_MULDIV:
@@ -190,7 +192,7 @@ bool MicroOp::isFpLoadStore() const
          default:
             ; // fall through
       }
-      if(Sim()->getDecoder()->is_fpvector_ldst_opcode(getInstructionOpcode(), getDecodedInstruction()))
+      if(Sim()->getDecoder()->is_fpvector_ldst_opcode(uop.getInstructionOpcode(), uop.getDecodedInstruction()))
       {
          return true;
       }
@@ -125,6 +125,8 @@ struct MicroOp
 
    bool m_membar;
    bool is_x87;
+   /** Load or store of FP/vector data, fixed at decode time (see getFpLoadStore). */
+   bool fp_ldst;
    uint16_t operand_size;
    uint16_t memoryAccessSize;
 
@@ -135,12 +137,13 @@ struct MicroOp
 
    static uop_subtype_t getSubtype_Exec(const MicroOp& uop);
    static uop_subtype_t getSubtype(const MicroOp& uop);
+   static bool getFpLoadStore(const MicroOp& uop);
    static String getSubtypeString(uop_subtype_t uop_subtype);
 
-   void setTypes() { uop_subtype = getSubtype(*this); }
+   void setTypes() { uop_subtype = getSubtype(*this); fp_ldst = getFpLoadStore(*this); }
    uop_subtype_t getSubtype(void) const { return uop_subtype; }
 
-   bool isFpLoadStore() const;
+   bool isFpLoadStore() const { return fp_ldst; }
    void setIsX87(bool _is_x87) { is_x87 = _is_x87; }
    bool isX87(void) const { return is_x87; }
    void setOperandSize(int size) { operand_size = size; }
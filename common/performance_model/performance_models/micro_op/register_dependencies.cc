@@ -2,50 +2,64 @@
 #include "dynamic_micro_op.h"
 
 RegisterDependencies::RegisterDependencies():
-	producers(Sim()->getDecoder()->last_reg())
+	producers(Sim()->getDecoder()->last_reg()),
+	mapping(Sim()->getDecoder()->last_reg())
 {
+   dl::Decoder *dec = Sim()->getDecoder();
+   for(uint32_t reg = 0; reg < mapping.size(); ++reg)
+   {
+      uint32_t mapped = dec->map_register(reg);
+      // The ARM mapping is defined for AArch64 registers only, keep other registers that fall outside the table as-is
+      mapping[reg] = mapped < producers.size() ? mapped : reg;
+   }
+
    clear();
 }
 
-void RegisterDependencies::setDependencies(DynamicMicroOp& microOp, uint64_t lowestValidSequenceNumber)
+uint32_t RegisterDependencies::mapRegister(dl::Decoder::decoder_reg reg) const
 {
-   // Create the dependencies for the microOp
-   for(uint32_t i = 0; i < microOp.getMicroOp()->getSourceRegistersLength(); i++)
-   {
-      dl::Decoder::decoder_reg sourceRegister = microOp.getMicroOp()->getSourceRegister(i);
-      uint32_t mappedRegister = Sim()->getDecoder()->map_register(sourceRegister);
-
-      uint64_t producerSequenceNumber;
-      LOG_ASSERT_ERROR(sourceRegister < Sim()->getDecoder()->last_reg(), "Source register src[%u]=%u is invalid", i, sourceRegister);
-      if ((producerSequenceNumber = producers[sourceRegister]) != INVALID_SEQNR)
-      {
-         if (producerSequenceNumber >= lowestValidSequenceNumber)
-         {
-            microOp.addDependency(producerSequenceNumber);
-         }
-         else
-         {
-            producers[mappedRegister] = INVALID_SEQNR;
-         }
-      }
-   }
+   LOG_ASSERT_ERROR(reg < mapping.size(), "Register %u is invalid", reg);
+   return mapping[reg];
+}
 
-   // Update the producers
-   for(uint32_t i = 0; i < microOp.getMicroOp()->getDestinationRegistersLength(); i++)
+uint32_t RegisterDependencies::getProducers(const MicroOp& microOp, uint64_t lowestValidSequenceNumber, uint64_t *result) const
+{
+   uint32_t numProducers = 0;
+   const uint32_t numSources = microOp.getSourceRegistersLength();
+
+   for(uint32_t i = 0; i < numSources; i++)
    {
-      uint32_t destinationRegister = microOp.getMicroOp()->getDestinationRegister(i);
-      LOG_ASSERT_ERROR(destinationRegister < Sim()->getDecoder()->last_reg(), "Destination register dst[%u] = %u is invalid", i, destinationRegister);
-      producers[destinationRegister] = microOp.getSequenceNumber();
+      // Stale producers (older than lowestValidSequenceNumber) are left in place: they will fail this check again,
+      // and are overwritten by the next producer of the register, so lookups never have to write.
+      uint64_t producerSequenceNumber = producers[mapRegister(microOp.getSourceRegister(i))];
+      if (producerSequenceNumber != INVALID_SEQNR && producerSequenceNumber >= lowestValidSequenceNumber)
+         result[numProducers++] = producerSequenceNumber;
    }
 
+   return numProducers;
+}
+
+void RegisterDependencies::setDependencies(DynamicMicroOp& microOp, uint64_t lowestValidSequenceNumber)
+{
+   const MicroOp *uop = microOp.getMicroOp();
+
+   // Create the dependencies for the microOp
+   uint64_t producerSequenceNumbers[MAXIMUM_NUMBER_OF_SOURCE_REGISTERS];
+   uint32_t numProducers = getProducers(*uop, lowestValidSequenceNumber, producerSequenceNumbers);
+   for(uint32_t i = 0; i < numProducers; i++)
+      microOp.addDependency(producerSequenceNumbers[i]);
+
+   // Update the producers
+   for(uint32_t i = 0; i < uop->getDestinationRegistersLength(); i++)
+      producers[mapRegister(uop->getDestinationRegister(i))] = microOp.getSequenceNumber();
 }
 
-uint64_t RegisterDependencies::peekProducer(dl::Decoder::decoder_reg reg, uint64_t lowestValidSequenceNumber)
+uint64_t RegisterDependencies::peekProducer(dl::Decoder::decoder_reg reg, uint64_t lowestValidSequenceNumber) const
 {
    if (reg == dl::Decoder::DL_REG_INVALID)
       return INVALID_SEQNR;
 
-   uint64_t producerSequenceNumber = producers[reg];
+   uint64_t producerSequenceNumber = producers[mapRegister(reg)];
    if (producerSequenceNumber == INVALID_SEQNR || producerSequenceNumber < lowestValidSequenceNumber)
       return INVALID_SEQNR;
 
@@ -10,16 +10,27 @@
 //}
 
 class DynamicMicroOp;
+struct MicroOp;
 
 class RegisterDependencies {
 private:
   // Array containing the sequence number of the producers for each of the registers.
+  // Registers that alias (see Decoder::map_register) share one entry.
   std::vector<uint64_t> producers;
+  // Register id to index into producers, so the decoder's (virtual) mapping isn't called for every operand
+  std::vector<uint32_t> mapping;
+
+  uint32_t mapRegister(dl::Decoder::decoder_reg reg) const;
 public:
   RegisterDependencies();
 
+  // Look up the producers of all source registers of microOp at once. Writes the sequence numbers of the producers
+  // that are still in flight (no older than lowestValidSequenceNumber) to result, and returns how many there are.
+  // result must have room for MAXIMUM_NUMBER_OF_SOURCE_REGISTERS entries.
+  uint32_t getProducers(const MicroOp& microOp, uint64_t lowestValidSequenceNumber, uint64_t *result) const;
+
   void setDependencies(DynamicMicroOp& microOp, uint64_t lowestValidSequenceNumber);
-  uint64_t peekProducer(dl::Decoder::decoder_reg reg, uint64_t lowestValidSequenceNumber);
+  uint64_t peekProducer(dl::Decoder::decoder_reg reg, uint64_t lowestValidSequenceNumber) const;
 
   void clear();
 };
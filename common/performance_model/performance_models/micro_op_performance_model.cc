@@ -27,10 +27,20 @@ MicroOpPerformanceModel::MicroOpPerformanceModel(Core *core, bool issue_memops)
     , m_dyninsn_count(0)
     , m_dyninsn_cost(0)
     , m_dyninsn_zero_count(0)
+    , m_heap_allocations(0)
+    , m_uop_vector_allocations(0)
 {
+   // Room for the uops of all but the rarest (vector, string) instructions, so these vectors normally never grow
+   m_current_uops.reserve(32);
+   m_pseudo_uops.reserve(4);
+   m_current_uops_capacity = m_current_uops.capacity();
+   m_pseudo_uops_capacity = m_pseudo_uops.capacity();
+
    registerStatsMetric("performance_model", core->getId(), "dyninsn_count", &m_dyninsn_count);
    registerStatsMetric("performance_model", core->getId(), "dyninsn_cost", &m_dyninsn_cost);
    registerStatsMetric("performance_model", core->getId(), "dyninsn_zero_count", &m_dyninsn_zero_count);
+   // Divide by instruction_count for allocations per instruction, should go to zero in steady state
+   registerStatsMetric("performance_model", core->getId(), "uop_heap_allocations", &m_heap_allocations);
 #if DEBUG_DYN_INSN_LOG
    String filename;
    filename = "sim.dyninsn_log." + itostr(core->getId());
@@ -153,11 +163,11 @@ void MicroOpPerformanceModel::doSquashing(std::vector<DynamicMicroOp*> &current_
 void MicroOpPerformanceModel::handleInstruction(DynamicInstruction *dynins)
 {
    ComponentPeriod insn_period = *(const_cast<ComponentPeriod*>(static_cast<const ComponentPeriod*>(m_elapsed_time)));
-   std::vector<DynamicMicroOp*> current_uops;
 
    // These vectors are local to handleInstruction, but keeping them around as member variables
    // saves a lot on allocation/deallocation time.
    m_current_uops.clear();
+   m_pseudo_uops.clear();
    m_cache_lines_read.clear();
    m_cache_lines_written.clear();
 
@@ -418,11 +428,10 @@ void MicroOpPerformanceModel::handleInstruction(DynamicInstruction *dynins)
       //  Nevertheless, do not add the instruction cost into the interval model because the latency
       //  has already been taken into account here.  The interval model will serialize, flushing the old window
 
-      std::vector<DynamicMicroOp*> uops;
-      uops.push_back(m_core_model->createDynamicMicroOp(m_allocator, m_serialize_uop, insn_period));
+      m_pseudo_uops.push_back(m_core_model->createDynamicMicroOp(m_allocator, m_serialize_uop, insn_period));
 
       uint64_t new_latency_cycles;
-      boost::tie(new_num_insns, new_latency_cycles) = simulate(uops);
+      boost::tie(new_num_insns, new_latency_cycles) = simulate(m_pseudo_uops);
       new_latency.addCycleLatency(new_latency_cycles);
 
       // Add the instruction cost immediately to prevent synchronization issues
@@ -474,7 +483,6 @@ void MicroOpPerformanceModel::handleInstruction(DynamicInstruction *dynins)
       LOG_ASSERT_ERROR(mem_dyn_insn != NULL, "Expected a MemAccessInstruction, but did not get one.");
 
       // Update uop with the necessary information for the MemAccess DynamicInstruction
-      std::vector<DynamicMicroOp*> uops;
       DynamicMicroOp* uop = m_core_model->createDynamicMicroOp(m_allocator, m_memaccess_uop, insn_period);
 
       // Long latency load setup
@@ -513,10 +521,10 @@ void MicroOpPerformanceModel::handleInstruction(DynamicInstruction *dynins)
       {
          // Add memory fencing support to better simulate actual conditions
          // CMPXCHG instructions are called in mutex handlers, and their performance is about the same as MFENCEs
-         uops.push_back(m_core_model->createDynamicMicroOp(m_allocator, m_mfence_uop, insn_period));
-         //uops.push_back(serialize_uop);
-         uops.push_back(uop);
-         uops.push_back(m_core_model->createDynamicMicroOp(m_allocator, m_mfence_uop, insn_period));
+         m_pseudo_uops.push_back(m_core_model->createDynamicMicroOp(m_allocator, m_mfence_uop, insn_period));
+         //m_pseudo_uops.push_back(serialize_uop);
+         m_pseudo_uops.push_back(uop);
+         m_pseudo_uops.push_back(m_core_model->createDynamicMicroOp(m_allocator, m_mfence_uop, insn_period));
          // Additionally, we need to think about serialization, and it's effect
          // In the case of a system call, the system will be serialized
          // This would matter only for the case when we initially don't have a lock
@@ -526,14 +534,14 @@ void MicroOpPerformanceModel::handleInstruction(DynamicInstruction *dynins)
       }
       else
       {
-         uops.push_back(uop);
+         m_pseudo_uops.push_back(uop);
       }
 
       // TODO Before simulating, iterate over the uops to mark them as first/last
 
       // Send this into the interval simulator
       uint64_t new_latency_cycles;
-      boost::tie(new_num_insns, new_latency_cycles) = simulate(uops);
+      boost::tie(new_num_insns, new_latency_cycles) = simulate(m_pseudo_uops);
       new_latency.addCycleLatency(new_latency_cycles);
 
       // Add a potential LLL cost that needs to be registered right away
@@ -561,6 +569,16 @@ void MicroOpPerformanceModel::handleInstruction(DynamicInstruction *dynins)
    if (latency_out_of_band)
       notifyElapsedTimeUpdate();
 
+   // Growing the uop vectors, or the DynamicMicroOp arena taking a new chunk from the heap, are the only heap allocations.
+   // Once they have reached their working-set size this stops increasing
+   if (m_current_uops.capacity() != m_current_uops_capacity || m_pseudo_uops.capacity() != m_pseudo_uops_capacity)
+   {
+      m_current_uops_capacity = m_current_uops.capacity();
+      m_pseudo_uops_capacity = m_pseudo_uops.capacity();
+      ++m_uop_vector_allocations;
+   }
+   m_heap_allocations = m_uop_vector_allocations + m_allocator->getHeapAllocations();
+
 #if DEBUG_CYCLE_COUNT_LOG
    fprintf(m_cycle_log, "[%s] latency=%d\n", itostr(m_elapsed_time).c_str(), itostr(new_latency.getElapsedTime()).c_str());
 #endif
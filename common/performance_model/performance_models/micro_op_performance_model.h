@@ -39,6 +39,7 @@ private:
    const bool m_issue_memops;
 
    std::vector<DynamicMicroOp*> m_current_uops;
+   std::vector<DynamicMicroOp*> m_pseudo_uops; // Uops standing in for a pseudo-instruction (serialize, MemAccess)
    // An std::set would sound like a better choice for these, but since the number of elements
    // is usually small (one or two, except for some rare vector instructions) a linear search
    // is fast enough; while std::vector does *much* fewer memory allocations/deallocations
@@ -49,6 +50,11 @@ private:
    UInt64 m_dyninsn_cost;
    UInt64 m_dyninsn_zero_count;
 
+   UInt64 m_heap_allocations;
+   UInt64 m_uop_vector_allocations;
+   size_t m_current_uops_capacity;
+   size_t m_pseudo_uops_capacity;
+
 #if DEBUG_DYN_INSN_LOG
    FILE *m_dyninsn_log;
 #endif
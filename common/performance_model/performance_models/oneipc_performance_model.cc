@@ -17,6 +17,8 @@ OneIPCPerformanceModel::OneIPCPerformanceModel(Core *core)
 {
    /* Maximum latency which is assumed to be completely overlapped. L1-D hit latency should be a good value. */
    m_latency_cutoff = Sim()->getCfg()->getIntArray("perf_model/core/oneipc/latency_cutoff", core->getId());
+   /* Only instruction types and memory latencies are needed, so the frontend can skip building DynamicInstructions */
+   m_direct_path = Sim()->getCfg()->getBoolArray("perf_model/core/oneipc/direct", core->getId());
 
    registerStatsMetric("oneipc_timer", core->getId(), "cpiBase", &m_cpiBase);
    registerStatsMetric("oneipc_timer", core->getId(), "cpiBranchPredictor", &m_cpiBranchPredictor);
@@ -37,14 +39,26 @@ OneIPCPerformanceModel::~OneIPCPerformanceModel()
 }
 
 void OneIPCPerformanceModel::handleInstruction(DynamicInstruction *dynins)
+{
+   dynins->accessMemory(getCore());
+
+   simulate(dynins->instruction, dynins->memory_info, dynins->num_memory);
+}
+
+void OneIPCPerformanceModel::handleInstructionDirect(Instruction *instruction, IntPtr eip, const DynamicInstruction::BranchInfo &branch_info, DynamicInstruction::MemoryInfo *memory_info, UInt8 num_memory)
+{
+   DynamicInstruction::accessMemory(getCore(), instruction, memory_info, num_memory);
+
+   simulate(instruction, memory_info, num_memory);
+}
+
+void OneIPCPerformanceModel::simulate(Instruction *instruction, DynamicInstruction::MemoryInfo *memory_info, UInt8 num_memory)
 {
    // compute cost
    ComponentTime cost = m_elapsed_time.getLatencyGenerator();
    SubsecondTime *cpiComponent = NULL;
 
-   dynins->accessMemory(getCore());
-
-   const OperandList &ops = dynins->instruction->getOperands();
+   const OperandList &ops = instruction->getOperands();
    unsigned int memidx = 0;
    for (unsigned int i = 0; i < ops.size(); i++)
    {
@@ -52,8 +66,8 @@ void OneIPCPerformanceModel::handleInstruction(DynamicInstruction *dynins)
 
       if (o.m_type == Operand::MEMORY)
       {
-         LOG_ASSERT_ERROR(dynins->num_memory > memidx, "Did not get enough memory_info objects");
-         DynamicInstruction::MemoryInfo &info = dynins->memory_info[memidx++];
+         LOG_ASSERT_ERROR(num_memory > memidx, "Did not get enough memory_info objects");
+         DynamicInstruction::MemoryInfo &info = memory_info[memidx++];
          LOG_ASSERT_ERROR(info.dir == o.m_direction,
                           "Expected memory %d info, got: %d.", o.m_direction, info.dir);
 
@@ -75,18 +89,18 @@ void OneIPCPerformanceModel::handleInstruction(DynamicInstruction *dynins)
       }
    }
 
-   SubsecondTime instruction_cost = dynins->instruction->getCost(getCore());
+   SubsecondTime instruction_cost = instruction->getCost(getCore());
 
-   if (isModeled(dynins->instruction))
+   if (isModeled(instruction))
       cost.addLatency(instruction_cost);
    else
       cost.addLatency(ComponentLatency(getCore()->getDvfsDomain(), 1).getLatency());
 
-   LOG_ASSERT_ERROR((dynins->instruction->getType() != INST_SYNC && dynins->instruction->getType() != INST_RECV), "Unexpected non-idle instruction");
+   LOG_ASSERT_ERROR((instruction->getType() != INST_SYNC && instruction->getType() != INST_RECV), "Unexpected non-idle instruction");
 
    if (cpiComponent == NULL)
    {
-      if (dynins->instruction->getType() == INST_BRANCH)
+      if (instruction->getType() == INST_BRANCH)
          cpiComponent = &m_cpiBranchPredictor;
       else
          cpiComponent = &m_cpiBase;
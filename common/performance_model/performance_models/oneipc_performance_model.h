@@ -11,6 +11,8 @@ public:
 
 private:
    void handleInstruction(DynamicInstruction *instruction);
+   void handleInstructionDirect(Instruction *instruction, IntPtr eip, const DynamicInstruction::BranchInfo &branch_info, DynamicInstruction::MemoryInfo *memory_info, UInt8 num_memory);
+   void simulate(Instruction *instruction, DynamicInstruction::MemoryInfo *memory_info, UInt8 num_memory);
 
    bool isModeled(Instruction const* instruction) const;
 
@@ -0,0 +1,67 @@
+/*
+ * This file is covered under the Interval Academic License, see LICENCE.academic
+ */
+
+#ifndef __PORT_CONTENTION_H
+#define __PORT_CONTENTION_H
+
+#include "fixed_types.h"
+#include "log.h"
+
+// Issue port state of one cycle, for RobContention models. Single ports are bits of a mask, port groups with a shared
+// limit ("at most three uops to ports 0, 1 and 5") are 8-bit counters packed into one word. Each counter is biased so
+// that going over its limit sets the field's top bit, which lets all counters be incremented and checked at once.
+// A uop port class is described by a Use: the single ports it needs and the counters it increments, so trying to claim
+// the resources of a uop is a table lookup and a few mask operations instead of a chain of per-port branches.
+
+class PortContention
+{
+   public:
+      static const UInt32 MAX_COUNTERS = 8;
+
+      struct Use
+      {
+         UInt32 ports;     // Bit mask of single ports
+         UInt64 counters;  // One 8-bit increment per counter
+      };
+
+      static UInt32 port(UInt32 index) { return 1u << index; }
+      static UInt64 counter(UInt32 index) { return UInt64(1) << (8 * index); }
+
+      PortContention() : m_ports(0), m_counters(0), m_counters_init(0) {}
+
+      void setLimit(UInt32 index, UInt32 limit)
+      {
+         LOG_ASSERT_ERROR(index < MAX_COUNTERS && limit < 0x80, "Invalid port counter %u or limit %u", index, limit);
+         m_counters_init = (m_counters_init & ~(UInt64(0xff) << (8 * index))) | (UInt64(0x7f - limit) << (8 * index));
+      }
+
+      void initCycle()
+      {
+         m_ports = 0;
+         m_counters = m_counters_init;
+      }
+
+      // Claim the ports and counters of use, returns false (and claims nothing) if any of them is not available
+      bool tryClaim(const Use &use)
+      {
+         UInt64 counters = m_counters + use.counters;
+         if ((m_ports & use.ports) || (counters & COUNTER_OVERFLOW))
+            return false;
+         m_ports |= use.ports;
+         m_counters = counters;
+         return true;
+      }
+
+      bool isBusy(UInt32 ports) const { return (m_ports & ports) == ports; }
+      bool isFull(UInt32 index) const { return ((m_counters + counter(index)) & COUNTER_OVERFLOW) != 0; }
+
+   private:
+      static const UInt64 COUNTER_OVERFLOW = 0x8080808080808080ull;
+
+      UInt32 m_ports;
+      UInt64 m_counters;
+      UInt64 m_counters_init;
+};
+
+#endif // __PORT_CONTENTION_H
@@ -13,7 +13,11 @@ class DynamicMicroOp;
 
 class RobContention {
    public:
+      // Contention is modeled (used by RobTimer's issue stage, which is instantiated per implementation)
+      static const bool ENABLED = true;
+
       static RobContention* createRobContentionModel(Core *core, const CoreModel *core_model);
+      virtual ~RobContention() {}
 
       virtual void initCycle(SubsecondTime now) = 0;
       virtual bool tryIssue(const DynamicMicroOp &uop) = 0;
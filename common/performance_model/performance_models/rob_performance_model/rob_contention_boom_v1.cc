@@ -10,19 +10,31 @@
 #include "simulator.h"
 #include "memory_manager_base.h"
 
-RobContentionBoomV1::RobContentionBoomV1(const Core *core, const CoreModel *core_model)
+namespace {
+   // Single ports are indexed by their uop_port_t, ports 0, 1 and 2 together take at most 3 uops
+   enum { GENERIC012 = 0 };
+
+   const PortContention::Use port_use[DynamicMicroOpBoomV1::UOP_PORT_SIZE] = {
+      /* UOP_PORT0   */ { PortContention::port(DynamicMicroOpBoomV1::UOP_PORT0), PortContention::counter(GENERIC012) },
+      /* UOP_PORT1   */ { PortContention::port(DynamicMicroOpBoomV1::UOP_PORT1), PortContention::counter(GENERIC012) },
+      /* UOP_PORT2   */ { PortContention::port(DynamicMicroOpBoomV1::UOP_PORT2), PortContention::counter(GENERIC012) },
+      /* UOP_PORT012 */ { 0, PortContention::counter(GENERIC012) },
+   };
+}
+
+RobContentionBoomV1::RobContentionBoomV1(const Core *core, const CoreModelBoomV1 *core_model)
    : m_core_model(core_model)
    , m_cache_block_mask(~(core->getMemoryManager()->getCacheBlockSize() - 1))
    , m_now(core->getDvfsDomain())
    , alu_used_until(DynamicMicroOpBoomV1::UOP_ALU_SIZE, SubsecondTime::Zero())
 {
+   m_ports.setLimit(GENERIC012, 3);
 }
 
 void RobContentionBoomV1::initCycle(SubsecondTime now)
 {
    m_now.setElapsedTime(now);
-   memset(ports, 0, sizeof(bool) * DynamicMicroOpBoomV1::UOP_PORT_SIZE);
-   ports_generic012 = 0;
+   m_ports.initCycle();
 }
 
 bool RobContentionBoomV1::tryIssue(const DynamicMicroOp &uop)
@@ -34,27 +46,8 @@ bool RobContentionBoomV1::tryIssue(const DynamicMicroOp &uop)
    //       This works as long as, if we return true, this microop is indeed issued
 
    const DynamicMicroOpBoomV1 *core_uop_info = uop.getCoreSpecificInfo<DynamicMicroOpBoomV1>();
-   DynamicMicroOpBoomV1::uop_port_t uop_port = core_uop_info->getPort();
-
-   if (uop_port == DynamicMicroOpBoomV1::UOP_PORT012)
-   {
-      if (ports_generic012 >= 3)
-         return false;
-      else
-         ports_generic012++;
-   }
-   else
-   { // PORT0, PORT1 or PORT2
-      if (ports[uop_port])
-         return false;
-      else if (ports_generic012 >= 3)
-         return false;
-      else
-      {
-         ports[uop_port] = true;
-         ports_generic012++;
-      }
-   }
+   if (!m_ports.tryClaim(port_use[core_uop_info->getPort()]))
+      return false;
 
    // ALU contention
    if (DynamicMicroOpBoomV1::uop_alu_t alu = core_uop_info->getAlu())
@@ -77,7 +70,7 @@ void RobContentionBoomV1::doIssue(DynamicMicroOp &uop)
 bool RobContentionBoomV1::noMore()
 {
    // When we issued something to all ports in this cycle, stop walking the rest of the ROB
-   if (ports[DynamicMicroOpBoomV1::UOP_PORT2] && ports_generic012 >= 3)
+   if (m_ports.isBusy(PortContention::port(DynamicMicroOpBoomV1::UOP_PORT2)) && m_ports.isFull(GENERIC012))
       return true;
    else
       return false;
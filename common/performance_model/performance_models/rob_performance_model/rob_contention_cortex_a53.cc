@@ -10,7 +10,7 @@
 #include "simulator.h"
 #include "memory_manager_base.h"
 
-RobContentionCortexA53::RobContentionCortexA53(const Core *core, const CoreModel *core_model)
+RobContentionCortexA53::RobContentionCortexA53(const Core *core, const CoreModelCortexA53 *core_model)
     : m_core_model(core_model)
     , m_cache_block_mask(~(core->getMemoryManager()->getCacheBlockSize() - 1))
     , m_now(core->getDvfsDomain())
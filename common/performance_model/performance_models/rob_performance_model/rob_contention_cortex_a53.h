@@ -12,9 +12,9 @@
 
 #include <vector>
 
-class RobContentionCortexA53 : public RobContention {
+class RobContentionCortexA53 final : public RobContention {
    private:
-      const CoreModel *m_core_model;
+      const CoreModelCortexA53 *m_core_model;
       uint64_t m_cache_block_mask;
       ComponentTime m_now;
 
@@ -37,7 +37,7 @@ class RobContentionCortexA53 : public RobContention {
       DynamicMicroOpCortexA53::uop_alu_t issueNEONPorts();
 
    public:
-      RobContentionCortexA53(const Core *core, const CoreModel *core_model);
+      RobContentionCortexA53(const Core *core, const CoreModelCortexA53 *core_model);
 
       void initCycle(SubsecondTime now);
       bool tryIssue(const DynamicMicroOp &uop);
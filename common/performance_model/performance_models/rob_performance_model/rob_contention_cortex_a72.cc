@@ -10,24 +10,42 @@
 #include "simulator.h"
 #include "memory_manager_base.h"
 
-RobContentionCortexA72::RobContentionCortexA72(const Core *core, const CoreModel *core_model)
+namespace {
+   // Ports that take at most 1 uop per cycle
+   enum { BRANCH = 0, INT_MULTI = 1, LD = 2, ST = 3 };
+   // Port groups: integer 0/1 and FP/ASIMD 0/1 take at most 2 uops per cycle. A uop for either ASIMD port goes to
+   // the other one when its own port is busy, so only the number of ASIMD uops matters.
+   enum { INTEGER = 0, SIMD = 1 };
+
+   const PortContention::Use port_use[DynamicMicroOpCortexA72::UOP_PORT_SIZE] = {
+      /* UOP_PORT0    */ { PortContention::port(BRANCH), 0 },
+      /* UOP_PORT0_12 */ { PortContention::port(BRANCH), PortContention::counter(INTEGER) },
+      /* UOP_PORT12   */ { 0, PortContention::counter(INTEGER) },
+      /* UOP_PORT3    */ { PortContention::port(INT_MULTI), 0 },
+      /* UOP_PORT12_3 */ { PortContention::port(INT_MULTI), PortContention::counter(INTEGER) },
+      /* UOP_PORT4    */ { 0, PortContention::counter(SIMD) },
+      /* UOP_PORT5    */ { 0, PortContention::counter(SIMD) },
+      /* UOP_PORT6    */ { PortContention::port(LD), 0 },
+      /* UOP_PORT7    */ { PortContention::port(ST), 0 },
+      /* UOP_PORT6_12 */ { PortContention::port(LD), PortContention::counter(INTEGER) },
+      /* UOP_PORT7_12 */ { PortContention::port(ST), PortContention::counter(INTEGER) },
+   };
+}
+
+RobContentionCortexA72::RobContentionCortexA72(const Core *core, const CoreModelCortexA72 *core_model)
    : m_core_model(core_model)
    , m_cache_block_mask(~(core->getMemoryManager()->getCacheBlockSize() - 1))
    , m_now(core->getDvfsDomain())
    , alu_used_until(DynamicMicroOpCortexA72::UOP_ALU_SIZE, SubsecondTime::Zero())
 {
+   m_ports.setLimit(INTEGER, 2);
+   m_ports.setLimit(SIMD, 2);
 }
 
 void RobContentionCortexA72::initCycle(SubsecondTime now)
 {
    m_now.setElapsedTime(now);
-   port_branch = false;
-   port_simd0 = false;
-   port_simd1 = false;
-   port_int_multi = false;
-   port_ld = false; 
-   port_st = false; 
-   ports_integer = 0;
+   m_ports.initCycle();
 }
 
 bool RobContentionCortexA72::tryIssue(const DynamicMicroOp &uop)
@@ -39,101 +57,8 @@ bool RobContentionCortexA72::tryIssue(const DynamicMicroOp &uop)
    //       This works as long as, if we return true, this microop is indeed issued
 
    const DynamicMicroOpCortexA72 *core_uop_info = uop.getCoreSpecificInfo<DynamicMicroOpCortexA72>();
-   DynamicMicroOpCortexA72::uop_port_t uop_port = core_uop_info->getPort();
-   
-   if (uop_port == DynamicMicroOpCortexA72::UOP_PORT0)
-   {
-      if (port_branch)
-         return false;
-      else
-         port_branch = true;
-   }
-   else if (uop_port == DynamicMicroOpCortexA72::UOP_PORT0_12)
-   {
-      if (port_branch || ports_integer >= 2)
-         return false;
-      else
-      {
-         port_branch = true;
-         ports_integer++;
-      }
-   }
-   else if (uop_port == DynamicMicroOpCortexA72::UOP_PORT12)
-   {
-      if (ports_integer >= 2)
-         return false;
-      else
-         ports_integer++;
-   }
-   else if (uop_port == DynamicMicroOpCortexA72::UOP_PORT3)
-   {
-      if (port_int_multi)
-         return false;
-      else
-         port_int_multi = true;
-   }
-   else if (uop_port == DynamicMicroOpCortexA72::UOP_PORT12_3)
-   {
-      if (port_int_multi || ports_integer >= 2)
-         return false;
-      else
-      {
-         port_int_multi = true;
-         ports_integer++;
-      }
-   }
-   else if (uop_port == DynamicMicroOpCortexA72::UOP_PORT4)
-   {
-      if (port_simd0 && port_simd1)
-         return false;
-      else if (port_simd0)
-         port_simd1 = true;
-      else
-         port_simd0 = true;
-   }
-   else if (uop_port == DynamicMicroOpCortexA72::UOP_PORT5)
-   {
-      if (port_simd1 && port_simd0)
-         return false;
-      else if (port_simd1)
-         port_simd0 = true;      
-      else
-         port_simd1 = true;
-   }
-   else if (uop_port == DynamicMicroOpCortexA72::UOP_PORT6)
-   {
-      if (port_ld)
-         return false;
-      else
-         port_ld = true;
-   }
-   else if (uop_port == DynamicMicroOpCortexA72::UOP_PORT6_12)
-   {
-      if (port_ld || ports_integer >= 2)
-         return false;
-      else
-      {
-         port_ld = true;
-         ports_integer++;
-      }
-   }     
-   else if (uop_port == DynamicMicroOpCortexA72::UOP_PORT7)
-   {
-      if (port_st)
-         return false;
-      else
-         port_st = true;
-   }   
-   else if (uop_port == DynamicMicroOpCortexA72::UOP_PORT7_12)
-   {
-      if (port_st || ports_integer >= 2)
-         return false;
-      else
-      {
-         port_st = true;
-         ports_integer++;
-      }
-   } 
+   if (!m_ports.tryClaim(port_use[core_uop_info->getPort()]))
+      return false;
 
    // ALU contention
    if (DynamicMicroOpCortexA72::uop_alu_t alu = core_uop_info->getAlu())
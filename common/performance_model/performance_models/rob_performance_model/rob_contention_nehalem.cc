@@ -10,20 +10,35 @@
 #include "simulator.h"
 #include "memory_manager_base.h"
 
-RobContentionNehalem::RobContentionNehalem(const Core *core, const CoreModel *core_model)
+namespace {
+   // Single ports are indexed by their uop_port_t, port groups with a shared limit are counters
+   enum { GENERIC = 0, GENERIC05 = 1 };  // Ports 0, 1 and 5 (at most 3 uops); ports 0 and 5 (at most 2 uops)
+
+   const PortContention::Use port_use[DynamicMicroOpNehalem::UOP_PORT_SIZE] = {
+      /* UOP_PORT0   */ { PortContention::port(DynamicMicroOpNehalem::UOP_PORT0), PortContention::counter(GENERIC) | PortContention::counter(GENERIC05) },
+      /* UOP_PORT1   */ { PortContention::port(DynamicMicroOpNehalem::UOP_PORT1), PortContention::counter(GENERIC) },
+      /* UOP_PORT2   */ { PortContention::port(DynamicMicroOpNehalem::UOP_PORT2), 0 },
+      /* UOP_PORT34  */ { PortContention::port(DynamicMicroOpNehalem::UOP_PORT34), 0 },
+      /* UOP_PORT5   */ { PortContention::port(DynamicMicroOpNehalem::UOP_PORT5), PortContention::counter(GENERIC) | PortContention::counter(GENERIC05) },
+      /* UOP_PORT05  */ { 0, PortContention::counter(GENERIC05) },
+      /* UOP_PORT015 */ { 0, PortContention::counter(GENERIC) },
+   };
+}
+
+RobContentionNehalem::RobContentionNehalem(const Core *core, const CoreModelNehalem *core_model)
    : m_core_model(core_model)
    , m_cache_block_mask(~(core->getMemoryManager()->getCacheBlockSize() - 1))
    , m_now(core->getDvfsDomain())
    , alu_used_until(DynamicMicroOpNehalem::UOP_ALU_SIZE, SubsecondTime::Zero())
 {
+   m_ports.setLimit(GENERIC, 3);
+   m_ports.setLimit(GENERIC05, 2);
 }
 
 void RobContentionNehalem::initCycle(SubsecondTime now)
 {
    m_now.setElapsedTime(now);
-   memset(ports, 0, sizeof(bool) * DynamicMicroOpNehalem::UOP_PORT_SIZE);
-   ports_generic = 0;
-   ports_generic05 = 0;
+   m_ports.initCycle();
 }
 
 bool RobContentionNehalem::tryIssue(const DynamicMicroOp &uop)
@@ -35,44 +50,8 @@ bool RobContentionNehalem::tryIssue(const DynamicMicroOp &uop)
    //       This works as long as, if we return true, this microop is indeed issued
 
    const DynamicMicroOpNehalem *core_uop_info = uop.getCoreSpecificInfo<DynamicMicroOpNehalem>();
-   DynamicMicroOpNehalem::uop_port_t uop_port = core_uop_info->getPort();
-   if (uop_port == DynamicMicroOpNehalem::UOP_PORT015)
-   {
-      if (ports_generic >= 3)
-         return false;
-      else
-         ports_generic++;
-   }
-   else if (uop_port == DynamicMicroOpNehalem::UOP_PORT05)
-   {
-      if (ports_generic05 >= 2)
-         return false;
-      else
-         ports_generic05++;
-   }
-   else if (uop_port == DynamicMicroOpNehalem::UOP_PORT2 || uop_port == DynamicMicroOpNehalem::UOP_PORT34)
-   {
-      if (ports[uop_port])
-         return false;
-      else
-         ports[uop_port] = true;
-   }
-   else
-   { // PORT0, PORT1 or PORT5
-      if (ports[uop_port])
-         return false;
-      else if (ports_generic >= 3)
-         return false;
-      else if (uop_port != DynamicMicroOpNehalem::UOP_PORT1 && ports_generic05 >= 2)
-         return false;
-      else
-      {
-         ports[uop_port] = true;
-         ports_generic++;
-         if (uop_port != DynamicMicroOpNehalem::UOP_PORT1)
-            ports_generic05++;
-      }
-   }
+   if (!m_ports.tryClaim(port_use[core_uop_info->getPort()]))
+      return false;
 
    // ALU contention
    if (DynamicMicroOpNehalem::uop_alu_t alu = core_uop_info->getAlu())
@@ -95,7 +74,8 @@ void RobContentionNehalem::doIssue(DynamicMicroOp &uop)
 bool RobContentionNehalem::noMore()
 {
    // When we issued something to all ports in this cycle, stop walking the rest of the ROB
-   if (ports[DynamicMicroOpNehalem::UOP_PORT2] && ports[DynamicMicroOpNehalem::UOP_PORT34] && ports_generic >= 3)
+   if (m_ports.isBusy(PortContention::port(DynamicMicroOpNehalem::UOP_PORT2) | PortContention::port(DynamicMicroOpNehalem::UOP_PORT34))
+       && m_ports.isFull(GENERIC))
       return true;
    else
       return false;
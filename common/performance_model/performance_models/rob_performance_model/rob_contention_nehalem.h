@@ -6,26 +6,26 @@
 #define __ROB_CONTENTION_NEHALEM_H
 
 #include "rob_contention.h"
+#include "port_contention.h"
 #include "contention_model.h"
 #include "core_model_nehalem.h"
 #include "dynamic_micro_op_nehalem.h"
 
 #include <vector>
 
-class RobContentionNehalem : public RobContention {
+class RobContentionNehalem final : public RobContention {
    private:
-      const CoreModel *m_core_model;
+      const CoreModelNehalem *m_core_model;
       uint64_t m_cache_block_mask;
       ComponentTime m_now;
 
       // port contention
-      bool ports[DynamicMicroOpNehalem::UOP_PORT_SIZE];
-      int ports_generic, ports_generic05;
+      PortContention m_ports;
 
       std::vector<SubsecondTime> alu_used_until;
 
    public:
-      RobContentionNehalem(const Core *core, const CoreModel *core_model);
+      RobContentionNehalem(const Core *core, const CoreModelNehalem *core_model);
 
       void initCycle(SubsecondTime now);
       bool tryIssue(const DynamicMicroOp &uop);
@@ -31,6 +31,7 @@ RobSmtTimer::RobThread::RobThread(Core *_core, int window_size)
       , now(SubsecondTime::Zero())
       , instrs(0)
       , instrs_returned(0)
+      , dependency_alloc(false)
       , rob(window_size + 255)
       , m_num_in_rob(0)
       , nextSequenceNumber(0)
@@ -208,16 +209,15 @@ void RobSmtTimer::initializeThread(smtthread_id_t thread_num)
 
    if (m_mlp_histogram)
    {
-      thread->m_outstandingLoads.resize(HitWhere::NUM_HITWHERES);
+      thread->m_outstandingLoads.resize(HitWhere::NUM_HITWHERES * MAX_OUTSTANDING, SubsecondTime::Zero());
       for (unsigned int h = HitWhere::WHERE_FIRST ; h < HitWhere::NUM_HITWHERES ; h++)
       {
          if (HitWhereIsValid((HitWhere::where_t)h))
          {
-            thread->m_outstandingLoads[h].resize(MAX_OUTSTANDING, SubsecondTime::Zero());
             for(unsigned int i = 0; i < MAX_OUTSTANDING; ++i)
             {
                String name = String("outstandingLoads.") + HitWhereString((HitWhere::where_t)h) + "[" + itostr(i) + "]";
-               registerStatsMetric("rob_timer", core->getId(), name, &(thread->m_outstandingLoads[h][i]));
+               registerStatsMetric("rob_timer", core->getId(), name, &(thread->m_outstandingLoads[h * MAX_OUTSTANDING + i]));
             }
          }
       }
@@ -231,7 +231,7 @@ void RobSmtTimer::initializeThread(smtthread_id_t thread_num)
    }
 }
 
-void RobSmtTimer::RobEntry::init(DynamicMicroOp *_uop, UInt64 sequenceNumber)
+void RobSmtTimer::RobEntry::init(DynamicMicroOp *_uop, UInt64 sequenceNumber, Allocator *_alloc)
 {
    dispatched = SubsecondTime::MaxTime();
    ready = SubsecondTime::MaxTime();
@@ -244,6 +244,7 @@ void RobSmtTimer::RobEntry::init(DynamicMicroOp *_uop, UInt64 sequenceNumber)
    uop = _uop;
    uop->setSequenceNumber(sequenceNumber);
 
+   alloc = _alloc;
    numInlineDependants = 0;
    vectorDependants = NULL;
 
@@ -254,7 +255,10 @@ void RobSmtTimer::RobEntry::free()
 {
    delete uop;
    if (vectorDependants)
-      delete vectorDependants;
+   {
+      vectorDependants->~DependantVector();
+      Allocator::dealloc(vectorDependants);
+   }
 }
 
 void RobSmtTimer::RobEntry::addDependant(RobSmtTimer::RobEntry* dep)
@@ -267,7 +271,7 @@ void RobSmtTimer::RobEntry::addDependant(RobSmtTimer::RobEntry* dep)
    {
       if (vectorDependants == NULL)
       {
-         vectorDependants = new std::vector<RobEntry*>();
+         vectorDependants = new(alloc->alloc(sizeof(DependantVector))) DependantVector(ArenaStlAllocator<RobEntry*>(alloc));
       }
       vectorDependants->push_back(dep);
    }
@@ -466,7 +470,7 @@ void RobSmtTimer::pushInstructions(smtthread_id_t thread_id, const std::vector<D
       }
 
       RobEntry *entry = &thread->rob.next();
-      entry->init(*it, thread->nextSequenceNumber++);
+      entry->init(*it, thread->nextSequenceNumber++, &thread->dependency_alloc);
 
       #ifdef DEBUG_PERCYCLE
          std::cout<<"** ["<<int(thread_id)<<"] simulate: "<<entry->uop->getMicroOp()->toShortString(true)<<std::endl;
@@ -639,7 +643,7 @@ bool RobSmtTimer::tryDispatch(smtthread_id_t thread_num, SubsecondTime &next_eve
    return uops_dispatched > 0;
 }
 
-SubsecondTime* RobSmtTimer::findCpiComponent(smtthread_id_t thread_num)
+SubsecondTime* RobSmtTimer::findCpiComponent(smtthread_id_t thread_num, SubsecondTime time)
 {
    RobThread *thread = m_rob_threads[thread_num];
 
@@ -649,10 +653,10 @@ SubsecondTime* RobSmtTimer::findCpiComponent(smtthread_id_t thread_num)
       RobEntry *entry = &thread->rob.at(i);
       DynamicMicroOp *uop = entry->uop;
       // Skip over completed instructions
-      if (entry->done < now)
+      if (entry->done < time)
          continue;
       // Nothing currently executing, CPI component will be Base or Branch/Icache as determined by front-end
-      if (entry->issued >= now)
+      if (entry->issued >= time)
          return NULL;
       // This is the first instruction in the ROB which is still executing
       // Assume everyone is blocked on this one
@@ -668,6 +672,67 @@ SubsecondTime* RobSmtTimer::findCpiComponent(smtthread_id_t thread_num)
    return NULL;
 }
 
+SubsecondTime* RobSmtTimer::findIdleCpiComponent(smtthread_id_t thread_num, SubsecondTime time)
+{
+   SmtThread *smt_thread = m_threads[thread_num];
+   RobThread *thread = m_rob_threads[thread_num];
+   SubsecondTime *cpiRobHead = findCpiComponent(thread_num, time);
+
+   // Same classification as doDispatch, for a cycle in which this thread cannot dispatch
+   if (thread->frontend_stalled_until > time)
+      return cpiRobHead ? cpiRobHead : thread->m_cpiCurrentFrontEndStall;
+   else if (!smt_thread->running || thread->now > time)
+      return &thread->m_cpiIdle;
+   else if (thread->m_num_in_rob >= currentWindowSize)
+      return cpiRobHead ? cpiRobHead : &thread->m_cpiBase;
+   else
+      return NULL;
+}
+
+SubsecondTime RobSmtTimer::getNextThreadEvent()
+{
+   // Earliest time at which any thread can dispatch, issue or commit again. Unlike the return values of
+   // doDispatch/doIssue/doCommit this includes threads that were not considered in the current cycle.
+   SubsecondTime next_event = SubsecondTime::MaxTime();
+
+   for(smtthread_id_t thread_num = 0; thread_num < m_threads.size(); ++thread_num)
+   {
+      SmtThread *smt_thread = m_threads[thread_num];
+      RobThread *thread = m_rob_threads[thread_num];
+
+      if (thread->m_num_in_rob > 0)
+         next_event = std::min(next_event, std::min(thread->next_event, thread->rob.front().done));
+
+      if (!smt_thread->running)
+         continue;
+      else if (thread->frontend_stalled_until > now)
+         next_event = std::min(next_event, thread->frontend_stalled_until);
+      else if (thread->now > now)
+         next_event = std::min(next_event, thread->now);
+      else if (thread->m_num_in_rob < currentWindowSize)
+         next_event = std::min(next_event, now.getElapsedTime()); // Can dispatch, don't skip
+   }
+
+   return next_event;
+}
+
+void RobSmtTimer::skipCycles(SubsecondTime skipped)
+{
+   // doDispatch only accounted for the current cycle: charge the skipped ones to the CPI component
+   // each thread is stalled on, and rotate the dispatch and issue priority as if they were simulated
+   SubsecondTime time = (now + 1ul).getElapsedTime();
+   for(smtthread_id_t thread_num = 0; thread_num < m_threads.size(); ++thread_num)
+   {
+      SubsecondTime *cpiComponent = findIdleCpiComponent(thread_num, time);
+      LOG_ASSERT_ERROR(cpiComponent != NULL, "Skipping cycles while thread %d can dispatch", thread_num);
+      *cpiComponent += skipped;
+   }
+
+   UInt64 cycles = SubsecondTime::divideRounded(skipped, *static_cast<const ComponentPeriod*>(now));
+   dispatch_thread = (dispatch_thread + cycles) % m_threads.size();
+   issue_thread = (issue_thread + cycles) % m_threads.size();
+}
+
 SubsecondTime RobSmtTimer::doDispatch()
 {
    SubsecondTime next_event = SubsecondTime::MaxTime();
@@ -682,7 +747,7 @@ SubsecondTime RobSmtTimer::doDispatch()
       SmtThread *smt_thread = m_threads[thread_num];
       RobThread *thread = m_rob_threads[thread_num];
       SubsecondTime *cpiComponent = NULL;
-      SubsecondTime *cpiRobHead = findCpiComponent(thread_num);
+      SubsecondTime *cpiRobHead = findCpiComponent(thread_num, now);
 
       if (thread->frontend_stalled_until > now)
       {
@@ -764,7 +829,7 @@ void RobSmtTimer::issueInstruction(smtthread_id_t thread_num, uint64_t idx, Subs
          uop.getMicroOp()->getInstruction() ? uop.getMicroOp()->getInstruction()->getAddress() : static_cast<uint64_t>(NULL),
          now.getElapsedTime()
       );
-      uint64_t latency = SubsecondTime::divideRounded(res.latency, now.getPeriod());
+      uint64_t latency = SubsecondTime::divideRounded(res.latency, *static_cast<const ComponentPeriod*>(now));
 
       uop.setExecLatency(uop.getExecLatency() + latency); // execlatency already contains bypass latency
       uop.setDCacheHitWhere(res.hit_where);
@@ -1087,10 +1152,8 @@ SubsecondTime RobSmtTimer::doCommit()
       }
    }
 
-   if (m_rob_threads[0]->rob.size()) // NOTE: for SMT, skip is ignored anyway
-      return m_rob_threads[0]->rob.front().done;
-   else
-      return SubsecondTime::MaxTime();
+   // Commit events of all threads are included by getNextThreadEvent()
+   return SubsecondTime::MaxTime();
 }
 
 bool RobSmtTimer::canExecute(smtthread_id_t thread_num)
@@ -1166,16 +1229,9 @@ SubsecondTime RobSmtTimer::executeCycle()
    #ifdef DEBUG_PERCYCLE
       std::cout<<"Next event: D("<<next_dispatch<<") I("<<next_issue<<") C("<<next_commit<<")"<<std::endl;
    #endif
-   SubsecondTime next_event = std::min(next_dispatch, std::min(next_issue, next_commit));
+   SubsecondTime next_event = std::min(std::min(next_dispatch, std::min(next_issue, next_commit)), getNextThreadEvent());
    SubsecondTime skip;
-   if (m_threads.size() > 1)
-   {
-      // SMT: we would need to check all ROBs at all cycles. For now, don't bother skipping
-      will_skip = false;
-      skip = now.getPeriod();
-      // Also, CPI stack code is concentrated at dispatch and wouldn't know about skipping
-   }
-   else if (next_event != SubsecondTime::MaxTime() && next_event > now + 1ul)
+   if (next_event != SubsecondTime::MaxTime() && next_event > now + 1ul)
    {
       #ifdef DEBUG_PERCYCLE
          std::cout<<"++ Skip "<<(next_event - now)<<std::endl;
@@ -1195,10 +1251,13 @@ SubsecondTime RobSmtTimer::executeCycle()
       if (will_skip)
          time_skipped += now.getPeriod();
    #else
-      now += skip;
-      latency += skip;
       if (skip > now.getPeriod())
+      {
+         skipCycles(skip - now.getPeriod());
          time_skipped += (skip - now.getPeriod());
+      }
+      now += skip;
+      latency += skip;
    #endif
 
    if (m_mlp_histogram)
@@ -1227,7 +1286,7 @@ void RobSmtTimer::countOutstandingMemop(smtthread_id_t thread_num, SubsecondTime
 
    for(unsigned int h = 0; h < HitWhere::NUM_HITWHERES; ++h)
       if (counts[h] > 0)
-         thread->m_outstandingLoads[h][counts[h] >= MAX_OUTSTANDING ? MAX_OUTSTANDING-1 : counts[h]] += time;
+         thread->m_outstandingLoads[h * MAX_OUTSTANDING + (counts[h] >= MAX_OUTSTANDING ? MAX_OUTSTANDING-1 : counts[h])] += time;
    if (total > 0)
       thread->m_outstandingLoadsAll[total >= MAX_OUTSTANDING ? MAX_OUTSTANDING-1 : total] += time;
 }
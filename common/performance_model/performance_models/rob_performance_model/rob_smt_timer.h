@@ -8,24 +8,40 @@
 #include "interval_timer.h"
 #include "smt_timer.h"
 #include "rob_contention.h"
+#include "arena_allocator.h"
+#include "flat_ring.h"
 
 #include <deque>
 
 class RobSmtTimer : public SmtTimer {
 private:
    class RobEntry {
+      public:
+         // Fields used while scanning the ROB each cycle come first, so they share the entry's first cache line
+         DynamicMicroOp *uop;
+         SubsecondTime dispatched;
+         SubsecondTime ready;    // Once all dependencies are resolved, cycle number that this uop becomes ready for issue
+         SubsecondTime readyMax; // While some but not all dependencies are resolved, keep the time of the latest known resolving dependency
+         SubsecondTime addressReady;
+         SubsecondTime addressReadyMax;
+         SubsecondTime issued;
+         SubsecondTime done;
+
       private:
          static const size_t MAX_INLINE_DEPENDANTS = 8;
-         size_t numInlineDependants;
-         RobEntry* inlineDependants[MAX_INLINE_DEPENDANTS];
-         std::vector<RobEntry*> *vectorDependants;
-
          static const size_t MAX_ADDRESS_PRODUCERS = 4;
-         size_t numAddressProducers;
+         // Overflow dependants live in the per-thread dependency arena
+         typedef std::vector<RobEntry*, ArenaStlAllocator<RobEntry*> > DependantVector;
+
+         UInt32 numInlineDependants;
+         UInt32 numAddressProducers;
+         RobEntry* inlineDependants[MAX_INLINE_DEPENDANTS];
          uint64_t addressProducers[MAX_ADDRESS_PRODUCERS];
+         Allocator *alloc;
+         DependantVector *vectorDependants;
 
       public:
-         void init(DynamicMicroOp *uop, UInt64 sequenceNumber);
+         void init(DynamicMicroOp *uop, UInt64 sequenceNumber, Allocator *alloc);
          void free();
 
          void addDependant(RobEntry* dep);
@@ -39,17 +55,8 @@ private:
          }
          size_t getNumAddressProducers() const { return numAddressProducers; }
          uint64_t getAddressProducer(size_t idx) const { return addressProducers[idx]; }
-
-         DynamicMicroOp *uop;
-         SubsecondTime dispatched;
-         SubsecondTime ready;    // Once all dependencies are resolved, cycle number that this uop becomes ready for issue
-         SubsecondTime readyMax; // While some but not all dependencies are resolved, keep the time of the latest known resolving dependency
-         SubsecondTime addressReady;
-         SubsecondTime addressReadyMax;
-         SubsecondTime issued;
-         SubsecondTime done;
    };
-   typedef CircularQueue<RobEntry> Rob;
+   typedef FlatRing<RobEntry> Rob;
 
    class RobThread {
       public:
@@ -59,6 +66,7 @@ private:
          uint64_t instrs;
          uint64_t instrs_returned;
 
+         ArenaAllocator<> dependency_alloc;
          Rob rob;
          uint64_t m_num_in_rob;
          uint64_t nextSequenceNumber;
@@ -73,7 +81,7 @@ private:
 
          SubsecondTime *m_cpiCurrentFrontEndStall;
 
-         std::vector<std::vector<SubsecondTime> > m_outstandingLoads;
+         std::vector<SubsecondTime> m_outstandingLoads; // [hit_where * MAX_OUTSTANDING + count]
          std::vector<SubsecondTime> m_outstandingLoadsAll;
 
          UInt64 m_uop_type_count[MicroOp::UOP_SUBTYPE_SIZE];
@@ -179,7 +187,10 @@ private:
    bool canExecute(smtthread_id_t thread_num);
    bool canExecute();
    bool tryDispatch(smtthread_id_t thread_num, SubsecondTime &next_event);
-   SubsecondTime* findCpiComponent(smtthread_id_t thread_num);
+   SubsecondTime* findCpiComponent(smtthread_id_t thread_num, SubsecondTime time);
+   SubsecondTime* findIdleCpiComponent(smtthread_id_t thread_num, SubsecondTime time);
+   SubsecondTime getNextThreadEvent();
+   void skipCycles(SubsecondTime skipped);
    bool tryIssue(smtthread_id_t thread_num, SubsecondTime &next_event, bool would_have_skipped = false);
    void issueInstruction(smtthread_id_t thread_num, uint64_t idx, SubsecondTime &next_event);
 
@@ -12,6 +12,10 @@
 #include "performance_model.h"
 #include "core_model.h"
 #include "rob_contention.h"
+#include "rob_contention_nehalem.h"
+#include "rob_contention_boom_v1.h"
+#include "rob_contention_cortex_a53.h"
+#include "rob_contention_cortex_a72.h"
 #include "instruction.h"
 
 #include <iostream>
@@ -25,6 +29,27 @@
 // Define to not skip any cycles, but assert that the skip logic is working fine
 //#define ASSERT_SKIP
 
+// Contention policy for when issue contention is not modeled: issue is limited by the dispatch width only
+struct NoRobContention
+{
+   static const bool ENABLED = false;
+   void initCycle(SubsecondTime now) {}
+   bool tryIssue(const DynamicMicroOp &uop) { return true; }
+   bool noMore() { return false; }
+   void doIssue(DynamicMicroOp &uop) {}
+};
+
+template <class Contention> SubsecondTime RobTimer::doIssue()
+{
+   return doIssue(static_cast<Contention*>(m_rob_contention));
+}
+
+template <> SubsecondTime RobTimer::doIssue<NoRobContention>()
+{
+   NoRobContention no_contention;
+   return doIssue(&no_contention);
+}
+
 RobTimer::RobTimer(
          Core *core, PerformanceModel *_perf, const CoreModel *core_model,
          int misprediction_penalty,
@@ -39,6 +64,7 @@ RobTimer::RobTimer(
       , m_no_address_disambiguation(!Sim()->getCfg()->getBoolArray("perf_model/core/rob_timer/address_disambiguation", core->getId()))
       , inorder(Sim()->getCfg()->getBoolArray("perf_model/core/rob_timer/in_order", core->getId()))
       , m_core(core)
+      , m_dependency_alloc(false)
       , rob(window_size + 255)
       , m_num_in_rob(0)
       , m_rs_entries_used(0)
@@ -61,6 +87,20 @@ RobTimer::RobTimer(
       , m_cpiCurrentFrontEndStall(NULL)
       , m_mlp_histogram(Sim()->getCfg()->getBoolArray("perf_model/core/rob_timer/mlp_histogram", core->getId()))
 {
+   // Use a specialized issue stage for the core models that come with Sniper,
+   // other RobContention implementations go through the (virtual) base class
+   if (!m_rob_contention)
+      m_do_issue = &RobTimer::doIssue<NoRobContention>;
+   else if (dynamic_cast<RobContentionNehalem*>(m_rob_contention))
+      m_do_issue = &RobTimer::doIssue<RobContentionNehalem>;
+   else if (dynamic_cast<RobContentionBoomV1*>(m_rob_contention))
+      m_do_issue = &RobTimer::doIssue<RobContentionBoomV1>;
+   else if (dynamic_cast<RobContentionCortexA53*>(m_rob_contention))
+      m_do_issue = &RobTimer::doIssue<RobContentionCortexA53>;
+   else if (dynamic_cast<RobContentionCortexA72*>(m_rob_contention))
+      m_do_issue = &RobTimer::doIssue<RobContentionCortexA72>;
+   else
+      m_do_issue = &RobTimer::doIssue<RobContention>;
 
    registerStatsMetric("rob_timer", core->getId(), "time_skipped", &time_skipped);
 
@@ -150,16 +190,15 @@ RobTimer::RobTimer(
 
    if (m_mlp_histogram)
    {
-      m_outstandingLoads.resize(HitWhere::NUM_HITWHERES);
+      m_outstandingLoads.resize(HitWhere::NUM_HITWHERES * MAX_OUTSTANDING, SubsecondTime::Zero());
       for (unsigned int h = HitWhere::WHERE_FIRST ; h < HitWhere::NUM_HITWHERES ; h++)
       {
          if (HitWhereIsValid((HitWhere::where_t)h))
          {
-            m_outstandingLoads[h].resize(MAX_OUTSTANDING, SubsecondTime::Zero());
             for(unsigned int i = 0; i < MAX_OUTSTANDING; ++i)
             {
                String name = String("outstandingLoads.") + HitWhereString((HitWhere::where_t)h) + "[" + itostr(i) + "]";
-               registerStatsMetric("rob_timer", core->getId(), name, &(m_outstandingLoads[h][i]));
+               registerStatsMetric("rob_timer", core->getId(), name, &(m_outstandingLoads[h * MAX_OUTSTANDING + i]));
             }
          }
       }
@@ -180,7 +219,7 @@ RobTimer::~RobTimer()
       it->free();
 }
 
-void RobTimer::RobEntry::init(DynamicMicroOp *_uop, UInt64 sequenceNumber)
+void RobTimer::RobEntry::init(DynamicMicroOp *_uop, UInt64 sequenceNumber, Allocator *_alloc)
 {
    ready = SubsecondTime::MaxTime();
    readyMax = SubsecondTime::Zero();
@@ -192,17 +231,61 @@ void RobTimer::RobEntry::init(DynamicMicroOp *_uop, UInt64 sequenceNumber)
    uop = _uop;
    uop->setSequenceNumber(sequenceNumber);
 
-   addressProducers.clear();
-
+   alloc = _alloc;
    numInlineDependants = 0;
    vectorDependants = NULL;
+   numInlineAddressProducers = 0;
+   vectorAddressProducers = NULL;
 }
 
 void RobTimer::RobEntry::free()
 {
    delete uop;
    if (vectorDependants)
-      delete vectorDependants;
+   {
+      vectorDependants->~DependantVector();
+      Allocator::dealloc(vectorDependants);
+   }
+   if (vectorAddressProducers)
+   {
+      vectorAddressProducers->~ProducerVector();
+      Allocator::dealloc(vectorAddressProducers);
+   }
+}
+
+void RobTimer::RobEntry::addAddressProducer(UInt64 sequenceNumber)
+{
+   if (numInlineAddressProducers < MAX_INLINE_ADDRESS_PRODUCERS)
+   {
+      inlineAddressProducers[numInlineAddressProducers++] = sequenceNumber;
+   }
+   else
+   {
+      if (vectorAddressProducers == NULL)
+      {
+         vectorAddressProducers = new(alloc->alloc(sizeof(ProducerVector))) ProducerVector(ArenaStlAllocator<uint64_t>(alloc));
+      }
+      vectorAddressProducers->push_back(sequenceNumber);
+   }
+}
+
+UInt64 RobTimer::RobEntry::getNumAddressProducers() const
+{
+   return numInlineAddressProducers + (vectorAddressProducers ? vectorAddressProducers->size() : 0);
+}
+
+UInt64 RobTimer::RobEntry::getAddressProducer(size_t idx) const
+{
+   if (idx < MAX_INLINE_ADDRESS_PRODUCERS)
+   {
+      LOG_ASSERT_ERROR(idx < numInlineAddressProducers, "Invalid idx %d", idx);
+      return inlineAddressProducers[idx];
+   }
+   else
+   {
+      LOG_ASSERT_ERROR(idx - MAX_INLINE_ADDRESS_PRODUCERS < vectorAddressProducers->size(), "Invalid idx %d", idx);
+      return (*vectorAddressProducers)[idx - MAX_INLINE_ADDRESS_PRODUCERS];
+   }
 }
 
 void RobTimer::RobEntry::addDependant(RobTimer::RobEntry* dep)
@@ -215,7 +298,7 @@ void RobTimer::RobEntry::addDependant(RobTimer::RobEntry* dep)
    {
       if (vectorDependants == NULL)
       {
-         vectorDependants = new std::vector<RobEntry*>();
+         vectorDependants = new(alloc->alloc(sizeof(DependantVector))) DependantVector(ArenaStlAllocator<RobEntry*>(alloc));
       }
       vectorDependants->push_back(dep);
    }
@@ -265,7 +348,7 @@ boost::tuple<uint64_t,SubsecondTime> RobTimer::simulate(const std::vector<Dynami
       }
 
       RobEntry *entry = &this->rob.next();
-      entry->init(*it, nextSequenceNumber++);
+      entry->init(*it, nextSequenceNumber++, &m_dependency_alloc);
 
       // Add = calculate dependencies, add yourself to list of depenants
       // If no dependants in window: set ready = now()
@@ -451,6 +534,7 @@ SubsecondTime RobTimer::doDispatch(SubsecondTime **cpiComponent)
 {
    SubsecondTime next_event = SubsecondTime::MaxTime();
    SubsecondTime *cpiFrontEnd = NULL;
+   bool rs_full = false;
 
    if (frontend_stalled_until <= now)
    {
@@ -500,6 +584,7 @@ SubsecondTime RobTimer::doDispatch(SubsecondTime **cpiComponent)
          if (m_rs_entries_used == rsEntries)
          {
             cpiFrontEnd = &m_cpiRSFull;
+            rs_full = true;
             break;
          }
 
@@ -570,8 +655,8 @@ SubsecondTime RobTimer::doDispatch(SubsecondTime **cpiComponent)
    }
 
 
-   if (m_num_in_rob == windowSize)
-      return next_event; // front-end is effectively stalled so wait for another event
+   if (m_num_in_rob == windowSize || rs_full)
+      return next_event; // front-end is effectively stalled so wait for another event (issue frees RS entries)
    else
       return std::min(frontend_stalled_until, next_event);
 }
@@ -594,7 +679,7 @@ void RobTimer::issueInstruction(uint64_t idx, SubsecondTime &next_event)
          uop.getMicroOp()->getInstruction() ? uop.getMicroOp()->getInstruction()->getAddress() : static_cast<uint64_t>(NULL),
          now.getElapsedTime()
       );
-      uint64_t latency = SubsecondTime::divideRounded(res.latency, now.getPeriod());
+      uint64_t latency = SubsecondTime::divideRounded(res.latency, *static_cast<const ComponentPeriod*>(now));
 
       uop.setExecLatency(uop.getExecLatency() + latency); // execlatency already contains bypass latency
       uop.setDCacheHitWhere(res.hit_where);
@@ -635,9 +720,6 @@ void RobTimer::issueInstruction(uint64_t idx, SubsecondTime &next_event)
                        entry->uop->getSequenceNumber(), entry->addressReady.getPS(), entry->ready.getPS());
    }
 
-   if (m_rob_contention)
-      m_rob_contention->doIssue(uop);
-
    entry->issued = now;
    entry->done = cycle_done;
 
@@ -707,14 +789,13 @@ void RobTimer::issueInstruction(uint64_t idx, SubsecondTime &next_event)
    }
 }
 
-SubsecondTime RobTimer::doIssue()
+template <class Contention> SubsecondTime RobTimer::doIssue(Contention *contention)
 {
    uint64_t num_issued = 0;
    SubsecondTime next_event = SubsecondTime::MaxTime();
    bool head_of_queue = true, no_more_load = false, no_more_store = false, have_unresolved_store = false;
 
-   if (m_rob_contention)
-      m_rob_contention->initCycle(now);
+   contention->initCycle(now);
 
    for(uint64_t i = 0; i < m_num_in_rob; ++i)
    {
@@ -728,12 +809,10 @@ SubsecondTime RobTimer::doIssue()
          continue;                     // already done
       }
 
-      next_event = std::min(next_event, entry->ready);
-
-
-      // See if we can issue this instruction
+      // See if we can issue this instruction, and if not, the earliest time at which it could be
 
       bool canIssue = false;
+      SubsecondTime wakeup = entry->ready;
 
       if (entry->ready > now)
          canIssue = false;          // blocked by dependency
@@ -746,7 +825,10 @@ SubsecondTime RobTimer::doIssue()
          if (head_of_queue && last_store_done <= now)
             canIssue = true;
          else
+         {
+            next_event = std::min(next_event, wakeup);
             break;
+         }
       }
 
       else if (uop->getMicroOp()->isMemBarrier())
@@ -759,30 +841,42 @@ SubsecondTime RobTimer::doIssue()
             // FIXME: L/SFENCE
       }
 
-      else if (!m_rob_contention && num_issued == dispatchWidth)
+      else if (!Contention::ENABLED && num_issued == dispatchWidth)
          canIssue = false;          // no issue contention: issue width == dispatch width
 
       else if (uop->getMicroOp()->isLoad() && !load_queue.hasFreeSlot(now))
+      {
          canIssue = false;          // load queue full
+         wakeup = load_queue.getStartTime(now);
+      }
 
       else if (uop->getMicroOp()->isLoad() && m_no_address_disambiguation && have_unresolved_store)
          canIssue = false;          // preceding store with unknown address
 
       else if (uop->getMicroOp()->isStore() && (!head_of_queue || !store_queue.hasFreeSlot(now)))
+      {
          canIssue = false;          // store queue full
+         // Not at the head of the ROB: wait for the older instructions, which provide their own events
+         wakeup = head_of_queue ? store_queue.getStartTime(now) : SubsecondTime::MaxTime();
+      }
 
       else
          canIssue = true;           // issue!
 
 
       // canIssue already marks issue ports as in use, so do this one last
-      if (canIssue && m_rob_contention && ! m_rob_contention->tryIssue(*uop))
+      if (canIssue && ! contention->tryIssue(*uop))
          canIssue = false;          // blocked by structural hazard
 
+      // Blocked loads and stores are not retried every cycle while their queue stays full,
+      // so long memory stalls can be skipped in one go
+      next_event = std::min(next_event, wakeup);
+
 
       if (canIssue)
       {
          num_issued++;
+         contention->doIssue(*uop);
          issueInstruction(i, next_event);
 
          // Calculate memory-level parallelism (MLP) for long-latency loads (but ignore overlapped misses)
@@ -826,9 +920,9 @@ SubsecondTime RobTimer::doIssue()
       }
 
 
-      if (m_rob_contention)
+      if (Contention::ENABLED)
       {
-         if (m_rob_contention->noMore())
+         if (contention->noMore())
             break;
       }
       else
@@ -911,7 +1005,7 @@ void RobTimer::execute(uint64_t& instructionsExecuted, SubsecondTime& latency)
    // Decode stage is not modeled, assumes the decoders can keep up with (up to) dispatchWidth uops per cycle
 
    SubsecondTime next_dispatch = doDispatch(&cpiComponent);
-   SubsecondTime next_issue    = doIssue();
+   SubsecondTime next_issue    = (this->*m_do_issue)();
    SubsecondTime next_commit   = doCommit(instructionsExecuted);
 
 
@@ -981,7 +1075,7 @@ void RobTimer::countOutstandingMemop(SubsecondTime time)
 
    for(unsigned int h = 0; h < HitWhere::NUM_HITWHERES; ++h)
       if (counts[h] > 0)
-         m_outstandingLoads[h][counts[h] >= MAX_OUTSTANDING ? MAX_OUTSTANDING-1 : counts[h]] += time;
+         m_outstandingLoads[h * MAX_OUTSTANDING + (counts[h] >= MAX_OUTSTANDING ? MAX_OUTSTANDING-1 : counts[h])] += time;
    if (total > 0)
       m_outstandingLoadsAll[total >= MAX_OUTSTANDING ? MAX_OUTSTANDING-1 : total] += time;
 }
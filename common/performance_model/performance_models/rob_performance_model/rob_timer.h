@@ -8,6 +8,8 @@
 #include "interval_timer.h"
 #include "rob_contention.h"
 #include "stats.h"
+#include "arena_allocator.h"
+#include "flat_ring.h"
 
 #include <deque>
 
@@ -16,33 +18,44 @@ class RobTimer
 private:
    class RobEntry
    {
+      public:
+         // Fields used while scanning the ROB each cycle come first, so they share the entry's first cache line
+         DynamicMicroOp *uop;
+         SubsecondTime dispatched;
+         SubsecondTime ready;    // Once all dependencies are resolved, cycle number that this uop becomes ready for issue
+         SubsecondTime readyMax; // While some but not all dependencies are resolved, keep the time of the latest known resolving dependency
+         SubsecondTime addressReady;
+         SubsecondTime addressReadyMax;
+         SubsecondTime issued;
+         SubsecondTime done;
+
       private:
+         // Dependants and address producers are stored inline, and only spill into a vector
+         // in the per-core dependency arena when there are more than fit here
          static const size_t MAX_INLINE_DEPENDANTS = 8;
-         size_t numInlineDependants;
+         static const size_t MAX_INLINE_ADDRESS_PRODUCERS = 4;
+         typedef std::vector<RobEntry*, ArenaStlAllocator<RobEntry*> > DependantVector;
+         typedef std::vector<uint64_t, ArenaStlAllocator<uint64_t> > ProducerVector;
+
+         UInt32 numInlineDependants;
+         UInt32 numInlineAddressProducers;
          RobEntry* inlineDependants[MAX_INLINE_DEPENDANTS];
-         std::vector<RobEntry*> *vectorDependants;
-         std::vector<uint64_t> addressProducers;
+         uint64_t inlineAddressProducers[MAX_INLINE_ADDRESS_PRODUCERS];
+         Allocator *alloc;
+         DependantVector *vectorDependants;
+         ProducerVector *vectorAddressProducers;
 
       public:
-         void init(DynamicMicroOp *uop, UInt64 sequenceNumber);
+         void init(DynamicMicroOp *uop, UInt64 sequenceNumber, Allocator *alloc);
          void free();
 
          void addDependant(RobEntry* dep);
          uint64_t getNumDependants() const;
          RobEntry* getDependant(size_t idx) const;
 
-         void addAddressProducer(UInt64 sequenceNumber) { addressProducers.push_back(sequenceNumber); }
-         UInt64 getNumAddressProducers() const { return addressProducers.size(); }
-         UInt64 getAddressProducer(size_t idx) const { return addressProducers.at(idx); }
-
-         DynamicMicroOp *uop;
-         SubsecondTime dispatched;
-         SubsecondTime ready;    // Once all dependencies are resolved, cycle number that this uop becomes ready for issue
-         SubsecondTime readyMax; // While some but not all dependencies are resolved, keep the time of the latest known resolving dependency
-         SubsecondTime addressReady;
-         SubsecondTime addressReadyMax;
-         SubsecondTime issued;
-         SubsecondTime done;
+         void addAddressProducer(UInt64 sequenceNumber);
+         UInt64 getNumAddressProducers() const;
+         UInt64 getAddressProducer(size_t idx) const;
    };
 
    const uint64_t dispatchWidth;
@@ -56,7 +69,8 @@ private:
 
    Core *m_core;
 
-   typedef CircularQueue<RobEntry> Rob;
+   ArenaAllocator<> m_dependency_alloc;
+   typedef FlatRing<RobEntry> Rob;
    Rob rob;
    uint64_t m_num_in_rob;
    uint64_t m_rs_entries_used;
@@ -132,7 +146,7 @@ private:
 
    const bool m_mlp_histogram;
    static const unsigned int MAX_OUTSTANDING = 32;
-   std::vector<std::vector<SubsecondTime> > m_outstandingLoads;
+   std::vector<SubsecondTime> m_outstandingLoads; // [hit_where * MAX_OUTSTANDING + count]
    std::vector<SubsecondTime> m_outstandingLoadsAll;
 
    RobEntry *findEntryBySequenceNumber(UInt64 sequenceNumber);
@@ -142,9 +156,15 @@ private:
 
    void execute(uint64_t& instructionsExecuted, SubsecondTime& latency);
    SubsecondTime doDispatch(SubsecondTime **cpiComponent);
-   SubsecondTime doIssue();
    SubsecondTime doCommit(uint64_t& instructionsExecuted);
 
+   // The issue stage is instantiated per RobContention implementation, so the per-uop contention calls
+   // are resolved at compile time. m_do_issue points to the instance matching m_rob_contention.
+   typedef SubsecondTime (RobTimer::*IssueFunction)();
+   IssueFunction m_do_issue;
+   template <class Contention> SubsecondTime doIssue();
+   template <class Contention> SubsecondTime doIssue(Contention *contention);
+
    void issueInstruction(uint64_t idx, SubsecondTime &next_event);
 
 public:
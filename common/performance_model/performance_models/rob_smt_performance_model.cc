@@ -2,6 +2,7 @@
 #include "config.hpp"
 
 std::unordered_map<core_id_t, RobSmtTimer*> RobSmtPerformanceModel::s_rob_timers;
+Lock RobSmtPerformanceModel::s_rob_timers_lock;
 
 RobSmtTimer* RobSmtPerformanceModel::getRobTimer(Core *core, RobSmtPerformanceModel *perf, const CoreModel *core_model)
 {
@@ -13,6 +14,7 @@ RobSmtTimer* RobSmtPerformanceModel::getRobTimer(Core *core, RobSmtPerformanceMo
    if (core->getId() >= (core_id_t) Sim()->getConfig()->getApplicationCores())
       smt_threads = 1;
 
+   ScopedLock sl(s_rob_timers_lock);
    if (s_rob_timers.count(core_id_master) == 0)
    {
       s_rob_timers[core_id_master] = new RobSmtTimer(
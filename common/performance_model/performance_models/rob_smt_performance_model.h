@@ -3,6 +3,7 @@
 
 #include "micro_op_performance_model.h"
 #include "rob_smt_timer.h"
+#include "lock.h"
 
 #include <unordered_map>
 
@@ -24,6 +25,7 @@ private:
    bool m_enabled;
 
    static std::unordered_map<core_id_t, RobSmtTimer*> s_rob_timers;
+   static Lock s_rob_timers_lock;
    static RobSmtTimer* getRobTimer(Core *core, RobSmtPerformanceModel *perf, const CoreModel *core_model);
 };
 
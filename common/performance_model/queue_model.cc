@@ -5,6 +5,8 @@
 #include "queue_model_history_list.h"
 #include "queue_model_contention.h"
 #include "queue_model_windowed_mg1.h"
+#include "queue_model_lockfree.h"
+#include "queue_model_ring.h"
 #include "log.h"
 #include "config.hpp"
 
@@ -30,6 +32,14 @@ QueueModel::create(String name, UInt32 id, String model_type, SubsecondTime min_
    {
       return new QueueModelWindowedMG1(name, id);
    }
+   else if (model_type == "lockfree")
+   {
+      return new QueueModelLockFree(name, id);
+   }
+   else if (model_type == "ring")
+   {
+      return new QueueModelRing(name, id, min_processing_time);
+   }
    else
    {
       LOG_PRINT_ERROR("Unrecognized Queue Model Type(%s)", model_type.c_str());
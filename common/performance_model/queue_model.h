@@ -13,6 +13,8 @@ public:
    virtual ~QueueModel() {}
 
    virtual SubsecondTime computeQueueDelay(SubsecondTime pkt_time, SubsecondTime processing_time, core_id_t requester = INVALID_CORE_ID) = 0;
+   // True if computeQueueDelay can be called concurrently, so callers do not need to serialize on a lock
+   virtual bool isThreadSafe() const { return false; }
 
    static QueueModel* create(String name, UInt32 id, String model_type, SubsecondTime min_processing_time);
 };
@@ -9,6 +9,8 @@
 
 QueueModelHistoryList::QueueModelHistoryList(String name, UInt32 id, SubsecondTime min_processing_time):
    m_min_processing_time(min_processing_time),
+   m_max_free_interval_list_size(Sim()->getCfg()->getInt("queue_model/history_list/max_list_size")),
+   m_free_interval_list(m_max_free_interval_list_size),
    m_utilized_time(SubsecondTime::Zero()),
    m_total_queue_delay(SubsecondTime::Zero()),
    m_total_requests(0),
@@ -26,20 +28,17 @@ QueueModelHistoryList::QueueModelHistoryList(String name, UInt32 id, SubsecondTi
    // Some Hard-Coded values here
    // Assumptions
    // 1) Simulation Time will not exceed 2^63.
-   UInt32 max_list_size = 0;
    try
    {
       m_analytical_model_enabled = Sim()->getCfg()->getBool("queue_model/history_list/analytical_model_enabled");
-      max_list_size = Sim()->getCfg()->getInt("queue_model/history_list/max_list_size");
    }
    catch(...)
    {
       LOG_PRINT_ERROR("Could not read parameters from cfg");
    }
-   m_max_free_interval_list_size = max_list_size;
-   m_average_delay = MovingAverage<SubsecondTime>::createAvgType(MovingAverage<SubsecondTime>::ARITHMETIC_MEAN, max_list_size);
+   m_average_delay = MovingAverage<SubsecondTime>::createAvgType(MovingAverage<SubsecondTime>::ARITHMETIC_MEAN, m_max_free_interval_list_size);
    SubsecondTime max_simulation_time = SubsecondTime::FS() << 63;
-   m_free_interval_list.push_back(std::pair<const SubsecondTime,SubsecondTime>(SubsecondTime::Zero(), max_simulation_time));
+   m_free_interval_list.push_back(FreeIntervalList::Interval(SubsecondTime::Zero(), max_simulation_time));
 
    registerStatsMetric(name, id, "num-requests", &m_total_requests);
    registerStatsMetric(name, id, "num-requests-analytical", &m_total_requests_using_analytical_model);
@@ -63,7 +62,7 @@ QueueModelHistoryList::computeQueueDelay(SubsecondTime pkt_time, SubsecondTime p
    // Check if it is an old packet
    // If yes, use analytical model
    // If not, use the history list based queue model
-   std::pair<SubsecondTime,SubsecondTime> oldest_interval = m_free_interval_list.front();
+   const FreeIntervalList::Interval &oldest_interval = m_free_interval_list.front();
    if (m_analytical_model_enabled && ((pkt_time + processing_time) <= oldest_interval.first))
    {
       // Increment the number of requests that use the analytical model
@@ -88,7 +87,7 @@ QueueModelHistoryList::computeQueueDelay(SubsecondTime pkt_time, SubsecondTime p
 float
 QueueModelHistoryList::getQueueUtilization()
 {
-   std::pair<SubsecondTime,SubsecondTime> newest_interval = m_free_interval_list.back();
+   const FreeIntervalList::Interval &newest_interval = m_free_interval_list.back();
    SubsecondTime total_time = newest_interval.first;
 
    if (total_time == SubsecondTime::Zero())
@@ -144,25 +143,27 @@ QueueModelHistoryList::computeUsingHistoryList(SubsecondTime pkt_time, Subsecond
          "Free Interval list size(%u) > %u", m_free_interval_list.size(), m_max_free_interval_list_size);
    SubsecondTime queue_delay = SubsecondTime::MaxTime();
 
-   FreeIntervalList::iterator curr_it;
-   for (curr_it = m_free_interval_list.begin(); curr_it != m_free_interval_list.end(); curr_it ++)
+   // Find the first free interval that either contains [pkt_time, pkt_time + processing_time), or starts after pkt_time
+   bool fits;
+   UInt32 index = m_free_interval_list.find(pkt_time, pkt_time + processing_time, fits);
+   if (index < m_free_interval_list.size())
    {
-      std::pair<SubsecondTime,SubsecondTime> interval = (*curr_it);
+      FreeIntervalList::Interval interval = m_free_interval_list[index];
+      FreeIntervalList::Interval remaining[2];
+      UInt32 num_remaining = 0;
 
-      if ((pkt_time >= interval.first) && ((pkt_time + processing_time) <= interval.second))
+      if (fits)
       {
          queue_delay = SubsecondTime::Zero();
          // Adjust the data structure accordingly
-         curr_it = m_free_interval_list.erase(curr_it);
          if ((pkt_time - interval.first) >= m_min_processing_time)
          {
-            m_free_interval_list.insert(curr_it, std::pair<SubsecondTime,SubsecondTime>(interval.first, pkt_time));
+            remaining[num_remaining++] = FreeIntervalList::Interval(interval.first, pkt_time);
          }
          if ((interval.second - (pkt_time + processing_time)) >= m_min_processing_time)
          {
-            m_free_interval_list.insert(curr_it, std::pair<SubsecondTime,SubsecondTime>(pkt_time + processing_time, interval.second));
+            remaining[num_remaining++] = FreeIntervalList::Interval(pkt_time + processing_time, interval.second);
          }
-         break;
       }
       // WH: The request comes before this free part, but doesn't fit. It doesn't make sense to me to
       //     demand a fit and move this request down even further. In reality, this request would have most
@@ -171,24 +172,25 @@ QueueModelHistoryList::computeUsingHistoryList(SubsecondTime pkt_time, Subsecond
       //     (If we assume all wait times are additive then the average works out by shifting it down,
       //      but since this is an interactive simulation all delays propagate through the system
       //      so this won't be accurate.)
-      else if ((pkt_time < interval.first) /*&& ((interval.first + processing_time) <= interval.second)*/)
+      else
       {
          queue_delay = interval.first - pkt_time;
          // Adjust the data structure accordingly
-         curr_it = m_free_interval_list.erase(curr_it);
-         if ((interval.second - (interval.first + processing_time)) >= m_min_processing_time)
+         // (the request may not fit in this interval either, don't let the remainder underflow into an inverted interval)
+         if ((interval.first + processing_time < interval.second) && (interval.second - (interval.first + processing_time)) >= m_min_processing_time)
          {
-            m_free_interval_list.insert(curr_it, std::pair<SubsecondTime,SubsecondTime>(interval.first + processing_time, interval.second));
+            remaining[num_remaining++] = FreeIntervalList::Interval(interval.first + processing_time, interval.second);
          }
-         break;
       }
+
+      m_free_interval_list.replace(index, remaining, num_remaining);
    }
 
    LOG_ASSERT_ERROR(queue_delay != SubsecondTime::MaxTime(), "queue delay(%s), free interval not found", itostr(queue_delay).c_str());
 
    if (m_free_interval_list.size() > m_max_free_interval_list_size)
    {
-      m_free_interval_list.erase(m_free_interval_list.begin());
+      m_free_interval_list.pop_front();
    }
 
    LOG_PRINT("HistoryList: pkt_time(%s), processing_time(%s), queue_delay(%s)", itostr(pkt_time).c_str(), itostr(processing_time).c_str(), itostr(queue_delay).c_str());
@@ -0,0 +1,49 @@
+#include "queue_model_lockfree.h"
+#include "stats.h"
+
+#include <algorithm>
+
+QueueModelLockFree::QueueModelLockFree(String name, UInt32 id)
+   : m_next_free(0)
+   , m_t_last(0)
+   , m_n_requests(0)
+   , m_n_outoforder(0)
+   , m_total_delay(0)
+{
+   registerStatsMetric(name, id, "num-requests", &m_n_requests);
+   registerStatsMetric(name, id, "requests-out-of-order", &m_n_outoforder);
+   registerStatsMetric(name, id, "total-delay", &m_total_delay);
+}
+
+QueueModelLockFree::~QueueModelLockFree()
+{}
+
+SubsecondTime
+QueueModelLockFree::computeQueueDelay(SubsecondTime pkt_time, SubsecondTime processing_time, core_id_t requester)
+{
+   UInt64 t_start = pkt_time.getFS();
+
+   __sync_fetch_and_add(&m_n_requests, 1);
+
+   UInt64 t_last = m_t_last.load(std::memory_order_relaxed);
+   do
+   {
+      if (t_start < t_last)
+      {
+         /* Out of order packet. Assume no congestion, only transfer latency. */
+         __sync_fetch_and_add(&m_n_outoforder, 1);
+         return SubsecondTime::Zero();
+      }
+   }
+   while (t_start != t_last && !m_t_last.compare_exchange_weak(t_last, t_start, std::memory_order_relaxed));
+
+   UInt64 next_free = m_next_free.load(std::memory_order_relaxed), t_begin;
+   do
+      t_begin = std::max(t_start, next_free);
+   while (!m_next_free.compare_exchange_weak(next_free, t_begin + processing_time.getFS(), std::memory_order_relaxed));
+
+   if (t_begin > t_start)
+      __sync_fetch_and_add(&m_total_delay, t_begin - t_start);
+
+   return SubsecondTime::FS(t_begin - t_start);
+}
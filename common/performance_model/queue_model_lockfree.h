@@ -0,0 +1,33 @@
+#ifndef __QUEUE_MODEL_LOCKFREE_H__
+#define __QUEUE_MODEL_LOCKFREE_H__
+
+#include "queue_model.h"
+#include "fixed_types.h"
+
+#include <atomic>
+
+// Single-server contention model (like contention with one outstanding request) that can be used
+// by several host threads at once: requests reserve the server by a compare-and-swap on its next-free time.
+// Requests that arrive before the latest request seen so far are out-of-order and, as in ContentionModel,
+// only see their processing time.
+
+class QueueModelLockFree : public QueueModel
+{
+public:
+   QueueModelLockFree(String name, UInt32 id);
+   ~QueueModelLockFree();
+
+   SubsecondTime computeQueueDelay(SubsecondTime pkt_time, SubsecondTime processing_time, core_id_t requester = INVALID_CORE_ID);
+   bool isThreadSafe() const { return true; }
+
+private:
+   std::atomic<UInt64> m_next_free; // In fs
+   std::atomic<UInt64> m_t_last;    // In fs
+
+   // Updated atomically, total-delay is in fs
+   UInt64 m_n_requests;
+   UInt64 m_n_outoforder;
+   UInt64 m_total_delay;
+};
+
+#endif /* __QUEUE_MODEL_LOCKFREE_H__ */
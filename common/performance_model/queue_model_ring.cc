@@ -0,0 +1,30 @@
+#include "queue_model_ring.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "log.h"
+
+QueueModelRing::QueueModelRing(String name, UInt32 id, SubsecondTime min_processing_time)
+   : m_contention(name, id, getSlotSize(min_processing_time), Sim()->getCfg()->getInt("queue_model/ring/window_slots"))
+{}
+
+QueueModelRing::~QueueModelRing()
+{}
+
+SubsecondTime
+QueueModelRing::getSlotSize(SubsecondTime min_processing_time)
+{
+   SInt64 slot_size = Sim()->getCfg()->getInt("queue_model/ring/slot_size");
+   if (slot_size > 0)
+      return SubsecondTime::PS() * slot_size;
+
+   // A slot of about one request keeps per-slot rounding small while a request touches only one or two slots
+   LOG_ASSERT_ERROR(min_processing_time > SubsecondTime::Zero(), "queue_model/ring/slot_size must be set for resources without a minimum processing time");
+   return min_processing_time;
+}
+
+SubsecondTime
+QueueModelRing::computeQueueDelay(SubsecondTime pkt_time, SubsecondTime processing_time, core_id_t requester)
+{
+   SubsecondTime t_complete = m_contention.getCompletionTime(pkt_time, processing_time);
+   return t_complete - pkt_time - processing_time;
+}
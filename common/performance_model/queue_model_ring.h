@@ -0,0 +1,22 @@
+#ifndef __QUEUE_MODEL_RING_H__
+#define __QUEUE_MODEL_RING_H__
+
+#include "queue_model.h"
+#include "fixed_types.h"
+#include "contention_model_ring.h"
+
+class QueueModelRing : public QueueModel
+{
+public:
+   QueueModelRing(String name, UInt32 id, SubsecondTime min_processing_time);
+   ~QueueModelRing();
+
+   SubsecondTime computeQueueDelay(SubsecondTime pkt_time, SubsecondTime processing_time, core_id_t requester = INVALID_CORE_ID);
+
+private:
+   RingContentionModel m_contention;
+
+   static SubsecondTime getSlotSize(SubsecondTime min_processing_time);
+};
+
+#endif /* __QUEUE_MODEL_RING_H__ */
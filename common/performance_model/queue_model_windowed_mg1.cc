@@ -9,6 +9,7 @@ QueueModelWindowedMG1::QueueModelWindowedMG1(String name, UInt32 id)
    , m_total_requests(0)
    , m_total_utilized_time(SubsecondTime::Zero())
    , m_total_queue_delay(SubsecondTime::Zero())
+   , m_window(m_window_size.getFS() / WINDOW_BUCKETS, 2 * WINDOW_BUCKETS)
    , m_num_arrivals(0)
    , m_service_time_sum(0)
    , m_service_time_sum2(0)
@@ -60,7 +61,7 @@ QueueModelWindowedMG1::computeQueueDelay(SubsecondTime pkt_time, SubsecondTime p
 void
 QueueModelWindowedMG1::addItem(SubsecondTime pkt_time, SubsecondTime service_time)
 {
-   m_window.insert(std::pair<SubsecondTime, SubsecondTime>(pkt_time, service_time));
+   m_window.push(pkt_time.getFS(), service_time);
    m_num_arrivals ++;
    m_service_time_sum += service_time.getPS();
    m_service_time_sum2 += service_time.getPS() * service_time.getPS();
@@ -69,12 +70,10 @@ QueueModelWindowedMG1::addItem(SubsecondTime pkt_time, SubsecondTime service_tim
 void
 QueueModelWindowedMG1::removeItems(SubsecondTime earliest_time)
 {
-   while(!m_window.empty() && m_window.begin()->first < earliest_time)
+   m_window.popBefore(earliest_time.getFS(), [this](UInt64 pkt_time, const SubsecondTime &service_time)
    {
-      std::multimap<SubsecondTime, SubsecondTime>::iterator entry = m_window.begin();
       m_num_arrivals --;
-      m_service_time_sum -= entry->second.getPS();
-      m_service_time_sum2 -= entry->second.getPS() * entry->second.getPS();
-      m_window.erase(entry);
-   }
+      m_service_time_sum -= service_time.getPS();
+      m_service_time_sum2 -= service_time.getPS() * service_time.getPS();
+   });
 }
@@ -4,8 +4,7 @@
 #include "queue_model.h"
 #include "fixed_types.h"
 #include "contention_model.h"
-
-#include <map>
+#include "calendar_queue.h"
 
 class QueueModelWindowedMG1 : public QueueModel
 {
@@ -16,13 +15,15 @@ public:
    SubsecondTime computeQueueDelay(SubsecondTime pkt_time, SubsecondTime processing_time, core_id_t requester = INVALID_CORE_ID);
 
 private:
+   static const UInt32 WINDOW_BUCKETS = 32; // Calendar queue buckets per window
+
    const SubsecondTime m_window_size;
 
    UInt64 m_total_requests;
    SubsecondTime m_total_utilized_time;
    SubsecondTime m_total_queue_delay;
 
-   std::multimap<SubsecondTime, SubsecondTime> m_window;
+   CalendarQueue<SubsecondTime> m_window; // Arrival time (in fs) and service time of requests in the window
    UInt64 m_num_arrivals;
    UInt64 m_service_time_sum; // In ps
    UInt64 m_service_time_sum2; // In ps^2
@@ -0,0 +1,214 @@
+#include "adaptive_sampling.h"
+#include "sampling_manager.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "performance_model.h"
+#include "fastforward_performance_model.h"
+#include "config.hpp"
+#include "stats.h"
+
+#include <cmath>
+
+AdaptiveSampling::AdaptiveSampling(SamplingManager *sampling_manager)
+   : SamplingAlgorithm(sampling_manager)
+   , m_min_detailed_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/adaptive/min_detailed_interval")))
+   , m_max_detailed_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/adaptive/max_detailed_interval")))
+   , m_min_fastforward_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/adaptive/min_fastforward_interval")))
+   , m_max_fastforward_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/adaptive/max_fastforward_interval")))
+   , m_fastforward_sync_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/adaptive/fastforward_sync_interval")))
+   , m_warmup_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/adaptive/warmup_interval")))
+   , m_target_error(Sim()->getCfg()->getFloat("sampling/adaptive/target_error"))
+   , m_confidence_z(Sim()->getCfg()->getFloat("sampling/adaptive/confidence_z"))
+   , m_detailed_sync(Sim()->getCfg()->getBool("sampling/adaptive/detailed_sync"))
+   , m_dispatch_width(Sim()->getCfg()->getInt("perf_model/core/interval_timer/dispatch_width"))
+   , m_num_cores(Sim()->getConfig()->getApplicationCores())
+   // Start with the longest detailed and shortest fast-forward intervals, until we know the program is stable
+   , m_detailed_interval(m_max_detailed_interval)
+   , m_fastforward_interval(m_min_fastforward_interval)
+   , m_periodic_last(SubsecondTime::Zero())
+   , m_fastforward_time_remaining(SubsecondTime::Zero())
+   , m_warmup_time_remaining(SubsecondTime::Zero())
+   , m_instructions_start(m_num_cores, 0)
+   , m_misses_start(0)
+   , m_ipc_samples(Sim()->getCfg()->getInt("sampling/adaptive/num_samples"))
+   , m_mpki_samples(Sim()->getCfg()->getInt("sampling/adaptive/num_samples"))
+   , m_num_detailed(0)
+   , m_detailed_ns(m_detailed_interval.getNS())
+   , m_fastforward_ns(m_fastforward_interval.getNS())
+{
+   LOG_ASSERT_ERROR(m_min_detailed_interval > SubsecondTime::Zero() && m_min_detailed_interval <= m_max_detailed_interval, "Expected 0 < min_detailed_interval <= max_detailed_interval");
+   LOG_ASSERT_ERROR(m_min_fastforward_interval <= m_max_fastforward_interval, "Expected min_fastforward_interval <= max_fastforward_interval");
+   LOG_ASSERT_ERROR(m_fastforward_sync_interval > SubsecondTime::Zero() && m_fastforward_sync_interval <= std::max(m_min_fastforward_interval, m_warmup_interval), "fastforward_sync_interval must be between 0 and max(min_fastforward_interval, warmup_interval)");
+   LOG_ASSERT_ERROR(m_target_error > 0, "sampling/adaptive/target_error must be positive");
+
+   String miss_rate_cache = Sim()->getCfg()->getString("sampling/adaptive/miss_rate_cache");
+   if (miss_rate_cache != "")
+   {
+      for(UInt32 core_id = 0; core_id < m_num_cores; ++core_id)
+      {
+         const char *metrics[] = { "load-misses", "store-misses" };
+         for(UInt32 i = 0; i < sizeof(metrics) / sizeof(metrics[0]); ++i)
+         {
+            // Shared caches only register counters on their master core
+            StatsMetricBase *metric = Sim()->getStatsManager()->getMetricObject(miss_rate_cache, core_id, metrics[i]);
+            if (metric)
+               m_miss_metrics.push_back(metric);
+         }
+      }
+      LOG_ASSERT_ERROR(!m_miss_metrics.empty(), "No miss counters found for sampling/adaptive/miss_rate_cache = %s", miss_rate_cache.c_str());
+   }
+
+   registerStatsMetric("sampling", 0, "detailed-intervals", &m_num_detailed);
+   registerStatsMetric("sampling", 0, "detailed-interval-ns", &m_detailed_ns);
+   registerStatsMetric("sampling", 0, "fastforward-interval-ns", &m_fastforward_ns);
+}
+
+UInt64
+AdaptiveSampling::getMisses()
+{
+   UInt64 misses = 0;
+   for(std::vector<StatsMetricBase*>::iterator it = m_miss_metrics.begin(); it != m_miss_metrics.end(); ++it)
+      misses += (*it)->recordMetric();
+   return misses;
+}
+
+void
+AdaptiveSampling::startDetailed()
+{
+   m_sampling_manager->resetCoreHistoricCPIs();
+   for(UInt32 core_id = 0; core_id < m_num_cores; ++core_id)
+      m_instructions_start[core_id] = Sim()->getCoreManager()->getCoreFromID(core_id)->getPerformanceModel()->getInstructionCount();
+   m_misses_start = getMisses();
+}
+
+void
+AdaptiveSampling::endDetailed()
+{
+   ++m_num_detailed;
+
+   double ipc = 0;
+   UInt32 ipc_cores = 0;
+   UInt64 instructions = 0;
+   for(UInt32 core_id = 0; core_id < m_num_cores; ++core_id)
+   {
+      Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+      SubsecondTime period = core->getDvfsDomain()->getPeriod();
+      instructions += core->getPerformanceModel()->getInstructionCount() - m_instructions_start[core_id];
+
+      SubsecondTime cpi = m_sampling_manager->getCoreHistoricCPI(core, m_detailed_sync, m_detailed_interval / 5);
+      if (cpi == SubsecondTime::Zero() || cpi == SubsecondTime::MaxTime())
+         // Mostly idle during this interval, keep the previous fast-forward CPI
+         continue;
+      else if (cpi < period / m_dispatch_width)
+         cpi = period / m_dispatch_width; // max. m_dispatch_width IPC
+      else if (cpi > period * 100)
+         cpi = period * 100; // min. .01 IPC
+
+      core->getPerformanceModel()->getFastforwardPerformanceModel()->setCurrentCPI(cpi);
+      ipc += double(period.getInternalDataForced()) / double(cpi.getInternalDataForced());
+      ++ipc_cores;
+   }
+
+   if (ipc_cores)
+      m_ipc_samples.pushCircular(ipc / ipc_cores);
+   if (!m_miss_metrics.empty() && instructions)
+      m_mpki_samples.pushCircular(1000. * (getMisses() - m_misses_start) / instructions);
+
+   adapt();
+}
+
+double
+AdaptiveSampling::relativeError(CircularQueue<double> &samples)
+{
+   UInt32 n = samples.size();
+   if (n < 2)
+      return INFINITY;
+
+   double sum = 0, sum_sq = 0;
+   for(UInt32 i = 0; i < n; ++i)
+   {
+      sum += samples[i];
+      sum_sq += samples[i] * samples[i];
+   }
+   double mean = sum / n;
+   double variance = std::max(0., (sum_sq - n * mean * mean) / (n - 1));
+   if (mean == 0)
+      return variance == 0 ? 0 : INFINITY;
+
+   // Half-width of the confidence interval of the mean, relative to the mean
+   return m_confidence_z * sqrt(variance / n) / mean;
+}
+
+void
+AdaptiveSampling::adapt()
+{
+   double error = relativeError(m_ipc_samples);
+   if (!m_miss_metrics.empty())
+      error = std::max(error, relativeError(m_mpki_samples));
+
+   if (error > m_target_error)
+   {
+      // Noisy: sample more, and more often
+      m_detailed_interval = std::min(m_detailed_interval * 2, m_max_detailed_interval);
+      m_fastforward_interval = std::max(m_fastforward_interval / 2, m_min_fastforward_interval);
+   }
+   else if (error < m_target_error / 2)
+   {
+      // Stable: shorter samples, further apart
+      m_detailed_interval = std::max(m_detailed_interval / 2, m_min_detailed_interval);
+      m_fastforward_interval = std::min(m_fastforward_interval * 2, m_max_fastforward_interval);
+   }
+
+   m_detailed_ns = m_detailed_interval.getNS();
+   m_fastforward_ns = m_fastforward_interval.getNS();
+}
+
+bool
+AdaptiveSampling::stepFastForward(SubsecondTime time)
+{
+   if (m_fastforward_time_remaining > SubsecondTime::Zero())
+   {
+      SubsecondTime time_to_fastforward = std::min(m_fastforward_time_remaining, m_fastforward_sync_interval);
+      m_fastforward_time_remaining -= time_to_fastforward;
+      m_sampling_manager->enableFastForward(time + time_to_fastforward, false, m_detailed_sync);
+      return false;
+   }
+   else if (m_warmup_time_remaining > SubsecondTime::Zero())
+   {
+      SubsecondTime time_to_warmup = std::min(m_warmup_time_remaining, m_fastforward_sync_interval);
+      m_warmup_time_remaining -= time_to_warmup;
+      m_sampling_manager->enableFastForward(time + time_to_warmup, true, m_detailed_sync);
+      return false;
+   }
+   else
+   {
+      return true;
+   }
+}
+
+void
+AdaptiveSampling::callbackDetailed(SubsecondTime time)
+{
+   if (time > m_periodic_last + m_detailed_interval)
+   {
+      endDetailed();
+
+      m_fastforward_time_remaining = m_fastforward_interval;
+      m_warmup_time_remaining = m_warmup_interval;
+      m_periodic_last = time;
+      if (stepFastForward(time))
+         // Nothing to fast-forward: start the next detailed interval right away
+         startDetailed();
+   }
+}
+
+void
+AdaptiveSampling::callbackFastForward(SubsecondTime time, bool in_warmup)
+{
+   if (stepFastForward(time))
+   {
+      startDetailed();
+      m_sampling_manager->disableFastForward();
+      m_periodic_last = time;
+   }
+}
@@ -0,0 +1,65 @@
+#ifndef __ADAPTIVE_SAMPLING
+#define __ADAPTIVE_SAMPLING
+
+#include "fixed_types.h"
+#include "sampling_algorithm.h"
+#include "circular_queue.h"
+
+#include <vector>
+
+class StatsMetricBase;
+
+// Periodic sampling (detailed, fast-forward, warmup) with interval lengths adapted at runtime.
+// After each detailed interval, its IPC and miss rate (misses per kilo-instruction in [sampling/adaptive/miss_rate_cache])
+// are added to a window of the last [sampling/adaptive/num_samples] samples. When the relative half-width of the
+// confidence interval of either metric exceeds [sampling/adaptive/target_error], the program is in a noisy phase:
+// detailed intervals are made longer and fast-forward intervals shorter. When it is below half the target,
+// the phase is stable and detailed intervals are shortened while fast-forward intervals are lengthened.
+
+class AdaptiveSampling : public SamplingAlgorithm
+{
+   protected:
+      const SubsecondTime m_min_detailed_interval, m_max_detailed_interval;
+      const SubsecondTime m_min_fastforward_interval, m_max_fastforward_interval;
+      const SubsecondTime m_fastforward_sync_interval;
+      const SubsecondTime m_warmup_interval;
+      const double m_target_error;
+      const double m_confidence_z;
+      const bool m_detailed_sync;
+      const int m_dispatch_width;
+      const UInt32 m_num_cores;
+
+      SubsecondTime m_detailed_interval;
+      SubsecondTime m_fastforward_interval;
+
+      SubsecondTime m_periodic_last;
+      SubsecondTime m_fastforward_time_remaining;
+      SubsecondTime m_warmup_time_remaining;
+
+      // Miss counters, and instruction and miss counts at the start of the current detailed interval
+      std::vector<StatsMetricBase*> m_miss_metrics;
+      std::vector<UInt64> m_instructions_start;
+      UInt64 m_misses_start;
+
+      CircularQueue<double> m_ipc_samples;
+      CircularQueue<double> m_mpki_samples;
+
+      UInt64 m_num_detailed;
+      UInt64 m_detailed_ns;
+      UInt64 m_fastforward_ns;
+
+      UInt64 getMisses();
+      void startDetailed();
+      void endDetailed();
+      void adapt();
+      double relativeError(CircularQueue<double> &samples);
+      bool stepFastForward(SubsecondTime time);
+
+   public:
+      AdaptiveSampling(SamplingManager *sampling_manager);
+
+      virtual void callbackDetailed(SubsecondTime now);
+      virtual void callbackFastForward(SubsecondTime now, bool in_warmup);
+};
+
+#endif /* __ADAPTIVE_SAMPLING */
@@ -0,0 +1,18 @@
+#ifndef __BBV_SAMPLING
+#define __BBV_SAMPLING
+
+#include "sampling_provider.h"
+
+// Like instr_count, but asks the frontend for basic-block vectors, for sampling algorithms that classify intervals by BBV
+class BbvSampling : public SamplingProvider
+{
+public:
+   virtual void startSampling(SubsecondTime until)
+   {}
+   virtual InstrumentLevel::Level requestedInstrumentation()
+   {
+      return InstrumentLevel::INSTR_WITH_BBVS;
+   }
+};
+
+#endif /* __BBV_SAMPLING */
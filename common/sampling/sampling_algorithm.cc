@@ -3,6 +3,8 @@
 #include "config.hpp"
 #include "log.h"
 #include "periodic_sampling.h"
+#include "simpoint_sampling.h"
+#include "adaptive_sampling.h"
 
 SamplingAlgorithm*
 SamplingAlgorithm::create(SamplingManager *sampling_manager)
@@ -12,6 +14,14 @@ SamplingAlgorithm::create(SamplingManager *sampling_manager)
    {
       return new PeriodicSampling(sampling_manager);
    }
+   else if (sampling_algorithm == "simpoint")
+   {
+      return new SimpointSampling(sampling_manager);
+   }
+   else if (sampling_algorithm == "adaptive")
+   {
+      return new AdaptiveSampling(sampling_manager);
+   }
    else
    {
       LOG_PRINT_ERROR("Unexpected sampling algorithm '%s'", sampling_algorithm.c_str());
@@ -3,6 +3,7 @@
 #include "config.hpp"
 #include "log.h"
 #include "instr_count_sampling.h"
+#include "bbv_sampling.h"
 
 SamplingProvider*
 SamplingProvider::create()
@@ -12,6 +13,10 @@ SamplingProvider::create()
    {
       return new InstrCountSampling();
    }
+   else if (sampling_type == "bbv")
+   {
+      return new BbvSampling();
+   }
    else
    {
       LOG_PRINT_ERROR("Unexpected sampling type '%s'", sampling_type.c_str());
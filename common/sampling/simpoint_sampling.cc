@@ -0,0 +1,183 @@
+#include "simpoint_sampling.h"
+#include "sampling_manager.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "performance_model.h"
+#include "fastforward_performance_model.h"
+#include "config.hpp"
+#include "stats.h"
+
+#include <cmath>
+
+SimpointSampling::SimpointSampling(SamplingManager *sampling_manager)
+   : SamplingAlgorithm(sampling_manager)
+   , m_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/simpoint/interval")))
+   , m_fastforward_sync_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("sampling/simpoint/fastforward_sync_interval")))
+   , m_max_clusters(Sim()->getCfg()->getInt("sampling/simpoint/max_clusters"))
+   , m_threshold(Sim()->getCfg()->getFloat("sampling/simpoint/threshold"))
+   , m_warmup(Sim()->getCfg()->getBool("sampling/simpoint/warmup"))
+   , m_detailed_sync(Sim()->getCfg()->getBool("sampling/simpoint/detailed_sync"))
+   , m_dispatch_width(Sim()->getCfg()->getInt("perf_model/core/interval_timer/dispatch_width"))
+   , m_num_cores(Sim()->getConfig()->getApplicationCores())
+   , m_interval_start(SubsecondTime::Zero())
+   , m_interval_end(m_interval)
+   , m_bbv_start(BbvCount::NUM_BBV, 0)
+   , m_instrs_start(0)
+   , m_num_clusters(0)
+   , m_num_detailed(0)
+   , m_num_fastforward(0)
+{
+   LOG_ASSERT_ERROR(m_interval > SubsecondTime::Zero(), "sampling/simpoint/interval must be non-zero");
+   LOG_ASSERT_ERROR(m_fastforward_sync_interval > SubsecondTime::Zero() && m_fastforward_sync_interval <= m_interval, "sampling/simpoint/fastforward_sync_interval must be between 0 and interval");
+   LOG_ASSERT_ERROR(m_max_clusters > 0, "sampling/simpoint/max_clusters must be non-zero");
+
+   registerStatsMetric("sampling", 0, "clusters", &m_num_clusters);
+   registerStatsMetric("sampling", 0, "detailed-intervals", &m_num_detailed);
+   registerStatsMetric("sampling", 0, "fastforward-intervals", &m_num_fastforward);
+}
+
+void
+SimpointSampling::getIntervalBbv(std::vector<double> &bbv)
+{
+   std::vector<UInt64> bbv_now(BbvCount::NUM_BBV, 0);
+   UInt64 instrs_now = 0;
+   for(UInt32 core_id = 0; core_id < m_num_cores; ++core_id)
+   {
+      BbvCount *bbv_count = Sim()->getCoreManager()->getCoreFromID(core_id)->getBbvCount();
+      for(int i = 0; i < BbvCount::NUM_BBV; ++i)
+         bbv_now[i] += bbv_count->getAbsoluteDimension(i);
+      instrs_now += bbv_count->getAbsoluteInstructionCount();
+   }
+
+   // BbvCount projects each basic block with weights uniform in [0, 0xffff]. Normalize by instruction count and center
+   // the weights on zero, which gives the SimPoint projection of the normalized BBV (with weights uniform in [-1, 1]).
+   UInt64 icount = instrs_now - m_instrs_start;
+   bbv.resize(BbvCount::NUM_BBV);
+   for(int i = 0; i < BbvCount::NUM_BBV; ++i)
+      bbv[i] = icount ? (double(bbv_now[i] - m_bbv_start[i]) / icount - 32767.5) / 32768. : 0.;
+
+   m_bbv_start = bbv_now;
+   m_instrs_start = instrs_now;
+}
+
+UInt32
+SimpointSampling::classify(const std::vector<double> &bbv)
+{
+   UInt32 nearest = 0;
+   double nearest_distance = INFINITY;
+   for(UInt32 c = 0; c < m_clusters.size(); ++c)
+   {
+      double distance = 0;
+      for(int i = 0; i < BbvCount::NUM_BBV; ++i)
+         distance += (bbv[i] - m_clusters[c].centroid[i]) * (bbv[i] - m_clusters[c].centroid[i]);
+      if (distance < nearest_distance)
+      {
+         nearest = c;
+         nearest_distance = distance;
+      }
+   }
+
+   if (sqrt(nearest_distance) > m_threshold && m_clusters.size() < m_max_clusters)
+   {
+      Cluster cluster = { bbv, 1, std::vector<SubsecondTime>(m_num_cores, SubsecondTime::Zero()), false };
+      m_clusters.push_back(cluster);
+      m_num_clusters = m_clusters.size();
+      return m_clusters.size() - 1;
+   }
+   else
+   {
+      // Online k-means: move the centroid towards the new point by 1/n
+      Cluster &cluster = m_clusters[nearest];
+      ++cluster.num_intervals;
+      for(int i = 0; i < BbvCount::NUM_BBV; ++i)
+         cluster.centroid[i] += (bbv[i] - cluster.centroid[i]) / cluster.num_intervals;
+      return nearest;
+   }
+}
+
+void
+SimpointSampling::setFastForwardCPI(const Cluster &cluster)
+{
+   for(UInt32 core_id = 0; core_id < m_num_cores; ++core_id)
+   {
+      Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+      SubsecondTime period = core->getDvfsDomain()->getPeriod();
+      // Cores that did not execute during the measured interval: assume one IPC
+      SubsecondTime cpi = cluster.cpi[core_id] == SubsecondTime::Zero() ? period : cluster.cpi[core_id];
+      core->getPerformanceModel()->getFastforwardPerformanceModel()->setCurrentCPI(cpi);
+   }
+}
+
+void
+SimpointSampling::endInterval(SubsecondTime time, bool detailed)
+{
+   std::vector<double> bbv;
+   getIntervalBbv(bbv);
+   UInt32 c = classify(bbv);
+   Cluster &cluster = m_clusters[c];
+
+   if (detailed)
+   {
+      ++m_num_detailed;
+      if (!cluster.measured)
+      {
+         // This interval becomes the representative of its cluster
+         for(UInt32 core_id = 0; core_id < m_num_cores; ++core_id)
+         {
+            Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+            SubsecondTime period = core->getDvfsDomain()->getPeriod();
+            SubsecondTime cpi = m_sampling_manager->getCoreHistoricCPI(core, m_detailed_sync, m_interval / 5);
+            if (cpi == SubsecondTime::Zero() || cpi == SubsecondTime::MaxTime())
+               continue;
+            else if (cpi < period / m_dispatch_width)
+               cpi = period / m_dispatch_width; // max. m_dispatch_width IPC
+            else if (cpi > period * 100)
+               cpi = period * 100; // min. .01 IPC
+            cluster.cpi[core_id] = cpi;
+         }
+         cluster.measured = true;
+      }
+   }
+   else
+      ++m_num_fastforward;
+
+   m_interval_start = time;
+   m_interval_end = time + m_interval;
+
+   if (cluster.measured)
+   {
+      // Known phase: fast-forward through the next interval at this phase's CPI
+      setFastForwardCPI(cluster);
+      stepFastForward(time);
+   }
+   else
+   {
+      // New phase: simulate the next interval in detail and use it as the phase's representative
+      m_sampling_manager->resetCoreHistoricCPIs();
+      if (!detailed)
+         m_sampling_manager->disableFastForward();
+   }
+}
+
+void
+SimpointSampling::stepFastForward(SubsecondTime time)
+{
+   SubsecondTime until = std::min(time + m_fastforward_sync_interval, m_interval_end);
+   m_sampling_manager->enableFastForward(until, m_warmup, m_detailed_sync);
+}
+
+void
+SimpointSampling::callbackDetailed(SubsecondTime time)
+{
+   if (time >= m_interval_end)
+      endInterval(time, true);
+}
+
+void
+SimpointSampling::callbackFastForward(SubsecondTime time, bool in_warmup)
+{
+   if (time >= m_interval_end)
+      endInterval(time, false);
+   else
+      stepFastForward(time);
+}
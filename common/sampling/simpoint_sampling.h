@@ -0,0 +1,63 @@
+#ifndef __SIMPOINT_SAMPLING
+#define __SIMPOINT_SAMPLING
+
+#include "fixed_types.h"
+#include "sampling_algorithm.h"
+#include "bbv_count.h"
+
+#include <vector>
+
+// Online, SimPoint-style phase sampling.
+// Execution is divided into intervals of [sampling/simpoint/interval] ns. At the end of each interval, its basic-block vector
+// (the random projection kept by BbvCount, summed over all cores) is assigned to the nearest cluster using online k-means,
+// or starts a new cluster if none is within [sampling/simpoint/threshold] (up to [sampling/simpoint/max_clusters]).
+// Assuming phases persist, the next interval is simulated in detail when the current cluster has not been measured yet,
+// and fast-forwarded at the cluster's measured per-core CPI otherwise. Only one representative interval per phase
+// is simulated in detail, without requiring an offline SimPoint pass.
+
+class SimpointSampling : public SamplingAlgorithm
+{
+   protected:
+      struct Cluster
+      {
+         std::vector<double> centroid;
+         UInt64 num_intervals;
+         std::vector<SubsecondTime> cpi; // Per core, SubsecondTime::Zero() if not measured
+         bool measured;
+      };
+
+      const SubsecondTime m_interval;
+      const SubsecondTime m_fastforward_sync_interval;
+      const UInt32 m_max_clusters;
+      const double m_threshold;
+      const bool m_warmup;
+      const bool m_detailed_sync;
+      const int m_dispatch_width;
+      const UInt32 m_num_cores;
+
+      SubsecondTime m_interval_start;
+      SubsecondTime m_interval_end;
+      std::vector<Cluster> m_clusters;
+
+      // BBV and instruction count totals at the start of the current interval
+      std::vector<UInt64> m_bbv_start;
+      UInt64 m_instrs_start;
+
+      UInt64 m_num_clusters;
+      UInt64 m_num_detailed;
+      UInt64 m_num_fastforward;
+
+      void getIntervalBbv(std::vector<double> &bbv);
+      UInt32 classify(const std::vector<double> &bbv);
+      void endInterval(SubsecondTime time, bool detailed);
+      void setFastForwardCPI(const Cluster &cluster);
+      void stepFastForward(SubsecondTime time);
+
+   public:
+      SimpointSampling(SamplingManager *sampling_manager);
+
+      virtual void callbackDetailed(SubsecondTime now);
+      virtual void callbackFastForward(SubsecondTime now, bool in_warmup);
+};
+
+#endif /* __SIMPOINT_SAMPLING */
@@ -4,6 +4,7 @@
 #include "scheduler_roaming.h"
 #include "scheduler_big_small.h"
 #include "scheduler_sequential.h"
+#include "scheduler_locality.h"
 #include "simulator.h"
 #include "config.hpp"
 #include "core_manager.h"
@@ -24,6 +25,8 @@ Scheduler* Scheduler::create(ThreadManager *thread_manager)
       return new SchedulerBigSmall(thread_manager);
    else if (type == "sequential")
        return new SchedulerSequential(thread_manager);
+   else if (type == "locality")
+      return new SchedulerLocality(thread_manager);
    else
       LOG_PRINT_ERROR("Unknown scheduler type %s", type.c_str());
 }
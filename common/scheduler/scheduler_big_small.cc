@@ -6,6 +6,10 @@
 #include "core_manager.h"
 #include "misc/tags.h"
 #include "rng.h"
+#include "stats.h"
+#include "core_state_predictor_manager.h"
+
+#include <algorithm>
 
 // Example random big-small scheduler using thread affinity
 //
@@ -18,13 +22,32 @@
 // This scheduler uses only setThreadAffinity(), and leaves all messy
 // low-level details that govern thread stalls etc. to the implementation
 // of SchedulerPinnedBase
+//
+// With policy = predicted, threads are promoted only when they are expected to make good use of a big core:
+// at every reshuffle, each running thread is scored by its throughput (instructions per ns of non-idle time)
+// on the core it ran on, or zero when the core state predictor expects its core to go idle (the thread is
+// stalling on synchronization or I/O). Free big cores go to the best threads with a non-zero score. A thread
+// on a small core then replaces the weakest thread on a big core only if its extra throughput pays for
+// refilling the caches of both: migration cost is the number of lines warmed by each thread in its current
+// core's cache (capped at the cache size) times refill_time.
 
 SchedulerBigSmall::SchedulerBigSmall(ThreadManager *thread_manager)
    : SchedulerPinnedBase(thread_manager, SubsecondTime::NS(Sim()->getCfg()->getInt("scheduler/big_small/quantum")))
    , m_debug_output(Sim()->getCfg()->getBool("scheduler/big_small/debug"))
+   , m_refill_time(SubsecondTime::NSfromFloat(Sim()->getCfg()->getFloat("scheduler/big_small/refill_time")))
+   , m_cache_lines(0)
    , m_last_reshuffle(SubsecondTime::Zero())
    , m_rng(rng_seed(42))
+   , m_num_migrations(0)
 {
+   String policy = Sim()->getCfg()->getString("scheduler/big_small/policy");
+   if (policy == "random")
+      m_policy = POLICY_RANDOM;
+   else if (policy == "predicted")
+      m_policy = POLICY_PREDICTED;
+   else
+      LOG_PRINT_ERROR("Invalid scheduler/big_small/policy %s", policy.c_str());
+
    // Figure out big and small cores, and create affinity masks for the set of big cores and the set of small cores, respectively
 
    m_num_big_cores = 0;
@@ -44,6 +67,29 @@ SchedulerBigSmall::SchedulerBigSmall(ThreadManager *thread_manager)
          CPU_SET(coreId, &m_mask_small);
       }
    }
+
+   if (m_policy == POLICY_PREDICTED)
+   {
+      UInt32 num_cores = Sim()->getConfig()->getApplicationCores();
+      m_core_samples.resize(num_cores, (CoreSample){ 0, SubsecondTime::Zero() });
+
+      UInt32 cache_level = Sim()->getCfg()->getInt("scheduler/big_small/cache_level");
+      LOG_ASSERT_ERROR(cache_level >= 1, "Invalid scheduler/big_small/cache_level %d", cache_level);
+      String cache_name = cache_level == 1 ? "L1-D" : "L" + itostr(cache_level);
+      String cache_config = cache_level == 1 ? "perf_model/l1_dcache" : "perf_model/l" + itostr(cache_level) + "_cache";
+
+      // Shared caches only have statistics on their first core, threads on the other cores are considered cold
+      for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+      {
+         m_fills.push_back(Sim()->getStatsManager()->getMetricObject(cache_name, core_id, "load-misses"));
+         m_fills.push_back(Sim()->getStatsManager()->getMetricObject(cache_name, core_id, "store-misses"));
+      }
+      if (cache_level <= (UInt32)Sim()->getCfg()->getInt("perf_model/cache/levels"))
+         m_cache_lines = Sim()->getCfg()->getIntArray(cache_config + "/cache_size", 0) * 1024
+                       / Sim()->getCfg()->getIntArray(cache_config + "/cache_block_size", 0);
+   }
+
+   registerStatsMetric("scheduler", 0, "migrations", &m_num_migrations);
 }
 
 void SchedulerBigSmall::threadSetInitialAffinity(thread_id_t thread_id)
@@ -98,7 +144,14 @@ void SchedulerBigSmall::periodic(SubsecondTime time)
 {
    bool print_state = false;
 
-   if (time > m_last_reshuffle + m_quantum)
+   if (time > m_last_reshuffle + m_quantum && m_policy == POLICY_PREDICTED)
+   {
+      reshufflePredicted();
+
+      m_last_reshuffle = time;
+      print_state = true;
+   }
+   else if (time > m_last_reshuffle + m_quantum)
    {
       // First move all threads back to the small cores
       for(thread_id_t thread_id = 0; thread_id < (thread_id_t)Sim()->getThreadManager()->getNumThreads(); ++thread_id)
@@ -126,17 +179,44 @@ void SchedulerBigSmall::periodic(SubsecondTime time)
 void SchedulerBigSmall::moveToSmall(thread_id_t thread_id)
 {
    threadSetAffinity(INVALID_THREAD_ID, thread_id, sizeof(m_mask_small), &m_mask_small);
+   if (m_thread_isbig[thread_id])
+      ++m_num_migrations;
    m_thread_isbig[thread_id] = false;
 }
 
 void SchedulerBigSmall::moveToBig(thread_id_t thread_id)
 {
    threadSetAffinity(INVALID_THREAD_ID, thread_id, sizeof(m_mask_big), &m_mask_big);
+   if (!m_thread_isbig[thread_id])
+      ++m_num_migrations;
    m_thread_isbig[thread_id] = true;
 }
 
 void SchedulerBigSmall::pickBigThread()
 {
+   if (m_policy == POLICY_PREDICTED)
+   {
+      // Promote the best-scoring thread, if any is expected to be compute-bound
+      thread_id_t best = INVALID_THREAD_ID;
+      double best_score = 0;
+      for(thread_id_t thread_id = 0; thread_id < (thread_id_t)Sim()->getThreadManager()->getNumThreads(); ++thread_id)
+      {
+         if (m_thread_isbig[thread_id] == false && m_threads_runnable[thread_id] && getScore(thread_id) > best_score)
+         {
+            best = thread_id;
+            best_score = getScore(thread_id);
+         }
+      }
+      if (best != INVALID_THREAD_ID)
+      {
+         moveToBig(best);
+
+         if (m_debug_output)
+            std::cout << "[SchedulerBigSmall] thread " << best << " promoted to big core" << std::endl;
+      }
+      return;
+   }
+
    // Randomly select one thread to promote from the small to the big core pool
 
    // First build a list of all eligible cores
@@ -159,3 +239,112 @@ void SchedulerBigSmall::pickBigThread()
          std::cout << "[SchedulerBigSmall] thread " << thread_id << " promoted to big core" << std::endl;
    }
 }
+
+void SchedulerBigSmall::reshufflePredicted()
+{
+   sampleCores();
+
+   std::vector<std::pair<double, thread_id_t> > candidates, incumbents;
+   for(thread_id_t thread_id = 0; thread_id < (thread_id_t)Sim()->getThreadManager()->getNumThreads(); ++thread_id)
+   {
+      if (!m_threads_runnable[thread_id])
+         continue;
+      if (m_thread_isbig[thread_id])
+         incumbents.push_back(std::make_pair(getScore(thread_id), thread_id));
+      else
+         candidates.push_back(std::make_pair(getScore(thread_id), thread_id));
+   }
+   // Best candidates first, weakest incumbents first
+   std::sort(candidates.begin(), candidates.end(), std::greater<std::pair<double, thread_id_t> >());
+   std::sort(incumbents.begin(), incumbents.end());
+
+   const double quantum = m_quantum.getFS();
+   std::vector<std::pair<double, thread_id_t> >::iterator candidate = candidates.begin(), incumbent = incumbents.begin();
+
+   // Fill free big cores, as long as the new thread can make up for its migration within a quantum
+   for(UInt64 free = m_num_big_cores - std::min(m_num_big_cores, (UInt64)incumbents.size());
+       free > 0 && candidate != candidates.end() && candidate->first > 0; ++candidate)
+   {
+      if (getRefillTime(candidate->second).getFS() < quantum)
+      {
+         moveToBig(candidate->second);
+         --free;
+      }
+   }
+
+   // Swap while the candidate, after both threads refilled their caches, still does more work on the big core
+   // than the incumbent would in a full quantum
+   for( ; candidate != candidates.end() && incumbent != incumbents.end() && candidate->first > 0; ++candidate)
+   {
+      double cost = getRefillTime(candidate->second).getFS() + getRefillTime(incumbent->second).getFS();
+      if (candidate->first * (quantum - cost) <= incumbent->first * quantum)
+         continue;
+
+      if (m_debug_output)
+         std::cout << "[SchedulerBigSmall] thread " << candidate->second << " (" << candidate->first << " ins/ns) replaces thread "
+                   << incumbent->second << " (" << incumbent->first << " ins/ns) on big core" << std::endl;
+
+      moveToSmall(incumbent->second);
+      moveToBig(candidate->second);
+      ++incumbent;
+   }
+}
+
+void SchedulerBigSmall::sampleCores()
+{
+   CoreStatePredictorManager *csp = Sim()->getCoreStatePredictorManager();
+
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_core_samples.size(); ++core_id)
+   {
+      const PerformanceModel *perf = Sim()->getCoreManager()->getCoreFromID(core_id)->getPerformanceModel();
+      CoreSample sample = { perf->getInstructionCount(), perf->getNonIdleElapsedTime() };
+      CoreSample &last = m_core_samples[core_id];
+
+      thread_id_t thread_id = m_core_thread_running[core_id];
+      if (thread_id != INVALID_THREAD_ID)
+      {
+         // Threads that ran on a core only part of the quantum are charged for all of it
+         std::unordered_map<thread_id_t, ThreadLoad>::iterator it = m_thread_load.find(thread_id);
+         if (it == m_thread_load.end())
+            it = m_thread_load.insert(std::make_pair(thread_id, (ThreadLoad){ 0, true, INVALID_CORE_ID, 0 })).first;
+         ThreadLoad &load = it->second;
+
+         if (load.core != core_id)
+         {
+            load.core = core_id;
+            load.fills_in = getFills(core_id);
+         }
+         if (sample.time > last.time)
+            load.rate = double(sample.instructions - last.instructions) / (sample.time - last.time).getNS();
+         // Keep the last forecast when the predictor is not sure
+         if (csp && csp->getPredictor(core_id)->isConfident())
+            load.compute_bound = csp->getPredictor(core_id)->predict() == Core::RUNNING;
+      }
+
+      last = sample;
+   }
+}
+
+UInt64 SchedulerBigSmall::getFills(core_id_t core_id)
+{
+   StatsMetricBase *loads = m_fills[2 * core_id], *stores = m_fills[2 * core_id + 1];
+   if (!loads || !stores)
+      return 0;
+   return loads->recordMetric() + stores->recordMetric();
+}
+
+SubsecondTime SchedulerBigSmall::getRefillTime(thread_id_t thread_id)
+{
+   std::unordered_map<thread_id_t, ThreadLoad>::const_iterator it = m_thread_load.find(thread_id);
+   if (it == m_thread_load.end() || it->second.core == INVALID_CORE_ID)
+      return SubsecondTime::Zero();
+   return m_refill_time * std::min(m_cache_lines, getFills(it->second.core) - it->second.fills_in);
+}
+
+double SchedulerBigSmall::getScore(thread_id_t thread_id)
+{
+   std::unordered_map<thread_id_t, ThreadLoad>::const_iterator it = m_thread_load.find(thread_id);
+   if (it == m_thread_load.end() || !it->second.compute_bound)
+      return 0;
+   return it->second.rate;
+}
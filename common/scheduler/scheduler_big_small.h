@@ -4,6 +4,9 @@
 #include "scheduler_pinned_base.h"
 
 #include <unordered_map>
+#include <vector>
+
+class StatsMetricBase;
 
 class SchedulerBigSmall : public SchedulerPinnedBase
 {
@@ -16,20 +19,53 @@ class SchedulerBigSmall : public SchedulerPinnedBase
       virtual void periodic(SubsecondTime time);
 
    private:
+      enum policy_t
+      {
+         POLICY_RANDOM,    // Promote random threads
+         POLICY_PREDICTED, // Promote threads predicted to be compute-bound, with the highest throughput
+      };
+
+      // Per-thread load, as seen at the last reshuffle (predicted policy)
+      struct ThreadLoad
+      {
+         double rate;            // Instructions per ns of non-idle time on its last core
+         bool compute_bound;     // Core state predictor expects its core to keep running
+         core_id_t core;         // Core it was last seen on
+         UInt64 fills_in;        // Fills of that core's cache when it got there
+      };
+      struct CoreSample
+      {
+         UInt64 instructions;
+         SubsecondTime time;
+      };
+
       const bool m_debug_output;
 
       // Configuration
+      policy_t m_policy;
       UInt64 m_num_big_cores;
       cpu_set_t m_mask_big;
       cpu_set_t m_mask_small;
+      SubsecondTime m_refill_time;     // Per cache line
+      UInt64 m_cache_lines;
 
       SubsecondTime m_last_reshuffle;
       UInt64 m_rng;
       std::unordered_map<thread_id_t, bool> m_thread_isbig;
+      std::unordered_map<thread_id_t, ThreadLoad> m_thread_load;
+      std::vector<CoreSample> m_core_samples;
+      std::vector<StatsMetricBase*> m_fills; // Load and store misses of each core's cache (two per core), NULL if not available
+      UInt64 m_num_migrations;
 
       void moveToBig(thread_id_t thread_id);
       void moveToSmall(thread_id_t thread_id);
       void pickBigThread();
+
+      void reshufflePredicted();
+      void sampleCores();
+      UInt64 getFills(core_id_t core_id);
+      SubsecondTime getRefillTime(thread_id_t thread_id);
+      double getScore(thread_id_t thread_id);
 };
 
 #endif // __SCHEDULER_BIG_SMALL_H
@@ -0,0 +1,511 @@
+#include "scheduler_locality.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "performance_model.h"
+#include "thread_manager.h"
+#include "config.hpp"
+#include "stats.h"
+#include "os_compat.h"
+
+#include <algorithm>
+
+SchedulerLocality::SchedulerLocality(ThreadManager *thread_manager)
+   : SchedulerDynamic(thread_manager)
+   , m_quantum(SubsecondTime::NS(Sim()->getCfg()->getInt("scheduler/locality/quantum")))
+   , m_num_cores(Sim()->getConfig()->getApplicationCores())
+   , m_num_words((m_num_cores + 63) / 64)
+   , m_core_mask(m_num_cores)
+   , m_cache_lines(0)
+   , m_warm_lines(0)
+   , m_steal_scan(Sim()->getCfg()->getInt("scheduler/locality/steal_scan"))
+   , m_last_periodic(SubsecondTime::Zero())
+   , m_core_info(m_num_cores)
+   , m_idle(m_num_words, 0)
+   , m_num_queued(0)
+   , m_next_core(0)
+   , m_num_migrations(0)
+   , m_num_steals(0)
+   , m_num_warm_wakeups(0)
+{
+   UInt32 cache_level = Sim()->getCfg()->getInt("scheduler/locality/cache_level");
+   LOG_ASSERT_ERROR(cache_level >= 1, "Invalid scheduler/locality/cache_level %d", cache_level);
+   String cache_name = cache_level == 1 ? "L1-D" : "L" + itostr(cache_level);
+   String cache_config = cache_level == 1 ? "perf_model/l1_dcache" : "perf_model/l" + itostr(cache_level) + "_cache";
+
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+   {
+      m_core_mask[core_id] = Sim()->getCfg()->getBoolArray("scheduler/locality/core_mask", core_id);
+
+      CoreInfo &core = m_core_info[core_id];
+      core.running = INVALID_THREAD_ID;
+      core.head = core.tail = INVALID_THREAD_ID;
+      core.length = 0;
+      core.quantum_left = SubsecondTime::Zero();
+      // Shared caches only have statistics on their first core, others don't get locality information
+      core.fills[0] = Sim()->getStatsManager()->getMetricObject(cache_name, core_id, "load-misses");
+      core.fills[1] = Sim()->getStatsManager()->getMetricObject(cache_name, core_id, "store-misses");
+      setIdle(core_id, true);
+   }
+
+   if (cache_level <= Sim()->getCfg()->getInt("perf_model/cache/levels"))
+   {
+      m_cache_lines = Sim()->getCfg()->getIntArray(cache_config + "/cache_size", 0) * 1024
+                    / Sim()->getCfg()->getIntArray(cache_config + "/cache_block_size", 0);
+      m_warm_lines = m_cache_lines * Sim()->getCfg()->getFloat("scheduler/locality/migration_threshold");
+   }
+
+   registerStatsMetric("scheduler", 0, "migrations", &m_num_migrations);
+   registerStatsMetric("scheduler", 0, "steals", &m_num_steals);
+   registerStatsMetric("scheduler", 0, "warm-wakeups", &m_num_warm_wakeups);
+}
+
+SchedulerLocality::ThreadInfo &SchedulerLocality::getThreadInfo(thread_id_t thread_id)
+{
+   if (m_thread_info.size() <= (size_t)thread_id)
+   {
+      ThreadInfo info;
+      info.affinity.resize(m_num_words, 0);
+      info.has_affinity = false;
+      info.explicit_affinity = false;
+      info.core_running = INVALID_CORE_ID;
+      info.core_queued = INVALID_CORE_ID;
+      info.prev = info.next = INVALID_THREAD_ID;
+      info.home = INVALID_CORE_ID;
+      info.footprint = 0;
+      info.fills_in = info.fills_out = 0;
+      m_thread_info.resize(thread_id + 16, info);
+   }
+   return m_thread_info[thread_id];
+}
+
+void SchedulerLocality::addAffinity(thread_id_t thread_id, core_id_t core_id)
+{
+   m_thread_info[thread_id].affinity[core_id / 64] |= 1ull << (core_id % 64);
+   m_thread_info[thread_id].has_affinity = true;
+}
+
+void SchedulerLocality::setIdle(core_id_t core_id, bool idle)
+{
+   if (idle)
+      m_idle[core_id / 64] |= 1ull << (core_id % 64);
+   else
+      m_idle[core_id / 64] &= ~(1ull << (core_id % 64));
+}
+
+core_id_t SchedulerLocality::findIdleCore(thread_id_t thread_id, core_id_t core_first)
+{
+   // First idle core at or after core_first (wrapping around) that the thread may run on
+   const std::vector<UInt64> &affinity = m_thread_info[thread_id].affinity;
+   UInt32 word_first = core_first / 64;
+   for(UInt32 i = 0; i <= m_num_words; ++i)
+   {
+      UInt32 word = (word_first + i) % m_num_words;
+      UInt64 bits = m_idle[word] & affinity[word];
+      if (i == 0)
+         bits &= ~0ull << (core_first % 64);
+      else if (i == m_num_words)
+         bits &= ~(~0ull << (core_first % 64));
+      if (bits)
+         return word * 64 + __builtin_ctzll(bits);
+   }
+   return INVALID_CORE_ID;
+}
+
+void SchedulerLocality::enqueue(thread_id_t thread_id, core_id_t core_id)
+{
+   ThreadInfo &info = m_thread_info[thread_id];
+   CoreInfo &core = m_core_info[core_id];
+   LOG_ASSERT_ERROR(info.core_queued == INVALID_CORE_ID, "Thread %d is already queued on core %d", thread_id, info.core_queued);
+
+   info.core_queued = core_id;
+   info.prev = core.tail;
+   info.next = INVALID_THREAD_ID;
+   if (core.tail != INVALID_THREAD_ID)
+      m_thread_info[core.tail].next = thread_id;
+   else
+      core.head = thread_id;
+   core.tail = thread_id;
+   ++core.length;
+   ++m_num_queued;
+}
+
+void SchedulerLocality::dequeue(thread_id_t thread_id)
+{
+   ThreadInfo &info = m_thread_info[thread_id];
+   CoreInfo &core = m_core_info[info.core_queued];
+
+   if (info.prev != INVALID_THREAD_ID)
+      m_thread_info[info.prev].next = info.next;
+   else
+      core.head = info.next;
+   if (info.next != INVALID_THREAD_ID)
+      m_thread_info[info.next].prev = info.prev;
+   else
+      core.tail = info.prev;
+   --core.length;
+   --m_num_queued;
+
+   info.core_queued = INVALID_CORE_ID;
+   info.prev = info.next = INVALID_THREAD_ID;
+}
+
+thread_id_t SchedulerLocality::steal(core_id_t core_id)
+{
+   if (m_num_queued == 0)
+      return INVALID_THREAD_ID;
+
+   core_id_t victim = INVALID_CORE_ID;
+   for(core_id_t other = 0; other < (core_id_t)m_num_cores; ++other)
+      if (other != core_id && m_core_info[other].length && (victim == INVALID_CORE_ID || m_core_info[other].length > m_core_info[victim].length))
+         victim = other;
+   if (victim == INVALID_CORE_ID)
+      return INVALID_THREAD_ID;
+
+   // Of the last few threads in the queue (which would wait longest), take the one that lost most of its cache
+   thread_id_t stolen = INVALID_THREAD_ID;
+   UInt64 min_warmth = UINT64_MAX;
+   thread_id_t thread_id = m_core_info[victim].tail;
+   for(UInt32 i = 0; i < m_steal_scan && thread_id != INVALID_THREAD_ID; ++i, thread_id = m_thread_info[thread_id].prev)
+   {
+      if (hasAffinity(thread_id, core_id))
+      {
+         UInt64 warmth = getWarmth(thread_id);
+         if (warmth < min_warmth)
+         {
+            stolen = thread_id;
+            min_warmth = warmth;
+         }
+      }
+   }
+
+   if (stolen != INVALID_THREAD_ID)
+   {
+      dequeue(stolen);
+      ++m_num_steals;
+   }
+   return stolen;
+}
+
+UInt64 SchedulerLocality::getFills(core_id_t core_id)
+{
+   const CoreInfo &core = m_core_info[core_id];
+   if (!core.fills[0] || !core.fills[1])
+      return 0;
+   return core.fills[0]->recordMetric() + core.fills[1]->recordMetric();
+}
+
+UInt64 SchedulerLocality::getWarmth(thread_id_t thread_id)
+{
+   const ThreadInfo &info = m_thread_info[thread_id];
+   if (info.home == INVALID_CORE_ID || m_cache_lines == 0)
+      return 0;
+
+   UInt64 fills = getFills(info.home);
+   if (info.core_running == info.home)
+      return std::min(m_cache_lines, info.footprint + (fills > info.fills_in ? fills - info.fills_in : 0));
+
+   // Every line brought in by others since we left evicted one of ours, as in a fully-associative LRU cache.
+   // Statistics may have been reset in the mean time, in which case the estimate is cleared.
+   UInt64 evicted = fills >= info.fills_out ? fills - info.fills_out : info.footprint;
+   return info.footprint > evicted ? info.footprint - evicted : 0;
+}
+
+void SchedulerLocality::accountIn(thread_id_t thread_id, core_id_t core_id)
+{
+   ThreadInfo &info = m_thread_info[thread_id];
+   if (info.home != core_id)
+   {
+      if (info.home != INVALID_CORE_ID)
+         ++m_num_migrations;
+      info.footprint = 0;
+   }
+   else
+      info.footprint = getWarmth(thread_id);
+   info.home = core_id;
+   info.fills_in = getFills(core_id);
+}
+
+void SchedulerLocality::accountOut(thread_id_t thread_id, core_id_t core_id)
+{
+   ThreadInfo &info = m_thread_info[thread_id];
+   info.footprint = getWarmth(thread_id);
+   info.fills_out = getFills(core_id);
+}
+
+core_id_t SchedulerLocality::chooseCore(thread_id_t thread_id)
+{
+   ThreadInfo &info = m_thread_info[thread_id];
+   core_id_t home = info.home;
+
+   if (home != INVALID_CORE_ID && hasAffinity(thread_id, home))
+   {
+      if (isIdle(home))
+         return home;
+      // Waiting for our old core is cheaper than warming up a new one
+      if (m_warm_lines && getWarmth(thread_id) >= m_warm_lines)
+      {
+         ++m_num_warm_wakeups;
+         return home;
+      }
+   }
+
+   // The nearest idle core, so threads that shared a cache are likely to stay close
+   core_id_t core_id = findIdleCore(thread_id, home != INVALID_CORE_ID ? home : m_next_core);
+   if (core_id != INVALID_CORE_ID)
+      return core_id;
+
+   // No idle core: queue where the wait is shortest, staying home on a tie
+   core_id_t best = INVALID_CORE_ID;
+   if (home != INVALID_CORE_ID && hasAffinity(thread_id, home))
+      best = home;
+   for(core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+      if (hasAffinity(thread_id, core_id) && (best == INVALID_CORE_ID || m_core_info[core_id].length < m_core_info[best].length))
+         best = core_id;
+   LOG_ASSERT_ERROR(best != INVALID_CORE_ID, "Thread %d has no core to run on", thread_id);
+   return best;
+}
+
+void SchedulerLocality::place(thread_id_t thread_id, SubsecondTime time)
+{
+   core_id_t core_id = chooseCore(thread_id);
+   if (isIdle(core_id))
+      runOn(core_id, thread_id, time);
+   else
+      enqueue(thread_id, core_id);
+}
+
+void SchedulerLocality::runOn(core_id_t core_id, thread_id_t thread_id, SubsecondTime time)
+{
+   CoreInfo &core = m_core_info[core_id];
+   ThreadInfo &info = m_thread_info[thread_id];
+
+   // Set core as running this thread *before* we call moveThread(), otherwise the HOOK_THREAD_RESUME callback for this
+   // thread might see an empty core, causing a recursive loop of reschedulings
+   core.running = thread_id;
+   core.quantum_left = m_quantum;
+   setIdle(core_id, false);
+   info.core_running = core_id;
+   accountIn(thread_id, core_id);
+
+   moveThread(thread_id, core_id, time);
+}
+
+void SchedulerLocality::unschedule(core_id_t core_id, SubsecondTime time)
+{
+   CoreInfo &core = m_core_info[core_id];
+   thread_id_t thread_id = core.running;
+
+   accountOut(thread_id, core_id);
+   m_thread_info[thread_id].core_running = INVALID_CORE_ID;
+   // The core is not marked idle until dispatch() finds nothing else to run
+   core.running = INVALID_THREAD_ID;
+
+   moveThread(thread_id, INVALID_CORE_ID, time);
+}
+
+void SchedulerLocality::dispatch(core_id_t core_id, SubsecondTime time)
+{
+   CoreInfo &core = m_core_info[core_id];
+   if (core.running != INVALID_THREAD_ID)
+      return;
+
+   thread_id_t thread_id = core.head;
+   if (thread_id != INVALID_THREAD_ID)
+      dequeue(thread_id);
+   else
+      thread_id = steal(core_id);
+
+   if (thread_id != INVALID_THREAD_ID)
+      runOn(core_id, thread_id, time);
+   else
+      setIdle(core_id, true);
+}
+
+void SchedulerLocality::rotate(core_id_t core_id, SubsecondTime time)
+{
+   CoreInfo &core = m_core_info[core_id];
+   thread_id_t thread_id = core.running;
+
+   if (core.head == INVALID_THREAD_ID
+       // Thread on this core is starting up, don't reschedule it for now
+       || Sim()->getThreadManager()->getThreadState(thread_id) == Core::INITIALIZING)
+   {
+      core.quantum_left = m_quantum;
+      return;
+   }
+
+   thread_id_t next_thread_id = core.head;
+   dequeue(next_thread_id);
+   unschedule(core_id, time);
+   enqueue(thread_id, core_id);
+   runOn(core_id, next_thread_id, time);
+}
+
+core_id_t SchedulerLocality::threadCreate(thread_id_t thread_id)
+{
+   ThreadInfo &info = getThreadInfo(thread_id);
+
+   if (!info.has_affinity)
+   {
+      for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+         if (m_core_mask[core_id])
+            addAffinity(thread_id, core_id);
+   }
+
+   // Spread new threads over the idle cores. Threads that don't get one now are placed once they start.
+   core_id_t core_id = findIdleCore(thread_id, m_next_core);
+   if (core_id == INVALID_CORE_ID)
+      return INVALID_CORE_ID;
+   m_next_core = (core_id + 1) % m_num_cores;
+
+   CoreInfo &core = m_core_info[core_id];
+   core.running = thread_id;
+   core.quantum_left = m_quantum;
+   setIdle(core_id, false);
+   info.core_running = core_id;
+   accountIn(thread_id, core_id);
+   return core_id;
+}
+
+void SchedulerLocality::threadStart(thread_id_t thread_id, SubsecondTime time)
+{
+   ThreadInfo &info = m_thread_info[thread_id];
+   if (info.core_running == INVALID_CORE_ID && info.core_queued == INVALID_CORE_ID)
+      place(thread_id, time);
+}
+
+void SchedulerLocality::threadResume(thread_id_t thread_id, thread_id_t thread_by, SubsecondTime time)
+{
+   ThreadInfo &info = m_thread_info[thread_id];
+   if (info.core_running == INVALID_CORE_ID && info.core_queued == INVALID_CORE_ID)
+      place(thread_id, time);
+}
+
+void SchedulerLocality::threadStall(thread_id_t thread_id, ThreadManager::stall_type_t reason, SubsecondTime time)
+{
+   ThreadInfo &info = m_thread_info[thread_id];
+   if (info.core_queued != INVALID_CORE_ID)
+      dequeue(thread_id);
+
+   // If the running thread becomes unrunnable, schedule someone else
+   if (info.core_running != INVALID_CORE_ID)
+   {
+      core_id_t core_id = info.core_running;
+      unschedule(core_id, time);
+      dispatch(core_id, time);
+   }
+}
+
+void SchedulerLocality::threadExit(thread_id_t thread_id, SubsecondTime time)
+{
+   threadStall(thread_id, ThreadManager::STALL_BROKEN, time);
+}
+
+void SchedulerLocality::threadYield(thread_id_t thread_id)
+{
+   core_id_t core_id = m_thread_info[thread_id].core_running;
+   if (core_id != INVALID_CORE_ID)
+   {
+      SubsecondTime time = Sim()->getCoreManager()->getCoreFromID(core_id)->getPerformanceModel()->getElapsedTime();
+      rotate(core_id, time);
+   }
+}
+
+bool SchedulerLocality::threadSetAffinity(thread_id_t calling_thread_id, thread_id_t thread_id, size_t cpusetsize, const cpu_set_t *mask)
+{
+   ThreadInfo &info = getThreadInfo(thread_id);
+   info.explicit_affinity = true;
+   std::fill(info.affinity.begin(), info.affinity.end(), 0);
+
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+   {
+      // No mask given: free to schedule anywhere
+      if (!mask || ((size_t)core_id < 8 * cpusetsize && CPU_ISSET_S(core_id, cpusetsize, mask)))
+         addAffinity(thread_id, core_id);
+   }
+   if (mask)
+      for(size_t cpu = m_num_cores; cpu < 8 * cpusetsize; ++cpu)
+         LOG_ASSERT_ERROR(!CPU_ISSET_S(cpu, cpusetsize, mask), "Invalid core %ld found in sched_setaffinity() mask", cpu);
+
+   // We're setting the affinity of a thread that isn't yet created. Do nothing else for now.
+   if (thread_id >= (thread_id_t)Sim()->getThreadManager()->getNumThreads())
+      return true;
+
+   if (info.core_running != INVALID_CORE_ID && !hasAffinity(thread_id, info.core_running))
+   {
+      // Can't preempt another thread outside of the barrier, move at the next periodic() unless it's ourselves
+      if (thread_id == calling_thread_id)
+      {
+         core_id_t core_id = info.core_running;
+         SubsecondTime time = Sim()->getCoreManager()->getCoreFromID(core_id)->getPerformanceModel()->getElapsedTime();
+         unschedule(core_id, time);
+         place(thread_id, time);
+         dispatch(core_id, time);
+      }
+      else
+         m_core_info[info.core_running].quantum_left = SubsecondTime::Zero();
+   }
+   else if (info.core_queued != INVALID_CORE_ID && !hasAffinity(thread_id, info.core_queued))
+   {
+      dequeue(thread_id);
+      place(thread_id, Sim()->getClockSkewMinimizationServer()->getGlobalTime());
+   }
+
+   return true;
+}
+
+bool SchedulerLocality::threadGetAffinity(thread_id_t thread_id, size_t cpusetsize, cpu_set_t *mask)
+{
+   if (cpusetsize*8 < m_num_cores)
+   {
+      // Not enough space to return result
+      return false;
+   }
+
+   ThreadInfo &info = getThreadInfo(thread_id);
+   CPU_ZERO_S(cpusetsize, mask);
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+   {
+      // When application has not yet done any sched_setaffinity calls, lie and return a fully populated affinity bitset.
+      // This makes libiomp5 use all available cores.
+      if (hasAffinity(thread_id, core_id) || !info.explicit_affinity)
+         CPU_SET_S(core_id, cpusetsize, mask);
+   }
+
+   return true;
+}
+
+void SchedulerLocality::periodic(SubsecondTime time)
+{
+   SubsecondTime delta = time - m_last_periodic;
+
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+   {
+      CoreInfo &core = m_core_info[core_id];
+      thread_id_t thread_id = core.running;
+
+      if (thread_id == INVALID_THREAD_ID)
+      {
+         // Idle core: run whatever is waiting here, or steal from the longest queue
+         dispatch(core_id, time);
+      }
+      else if (!hasAffinity(thread_id, core_id)
+               && Sim()->getThreadManager()->getThreadState(thread_id) != Core::INITIALIZING)
+      {
+         // Affinity changed while running
+         unschedule(core_id, time);
+         place(thread_id, time);
+         dispatch(core_id, time);
+      }
+      else if (delta >= core.quantum_left)
+      {
+         rotate(core_id, time);
+      }
+      else
+      {
+         core.quantum_left -= delta;
+      }
+   }
+
+   m_last_periodic = time;
+}
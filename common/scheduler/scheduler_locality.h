@@ -0,0 +1,106 @@
+#ifndef __SCHEDULER_LOCALITY_H
+#define __SCHEDULER_LOCALITY_H
+
+#include "scheduler_dynamic.h"
+
+#include <vector>
+
+class StatsMetricBase;
+
+// Locality- and load-aware scheduler (scheduler/type = locality)
+//
+// Each core has a FIFO run queue of runnable threads waiting for it, kept as an intrusive list so enqueue,
+// dequeue and removal are O(1), and idle cores are found through a bitmap intersected with the thread's affinity.
+// No operation scans the thread list: periodic() only visits cores, rotating the run queue of cores whose quantum
+// expired, and letting idle cores steal the coldest of a few threads from the longest queue.
+// A thread that wakes up goes back to the core it last ran on when that core is idle, or when it probably still has
+// a large part of that core's cache (scheduler/locality/cache_level). That occupancy is estimated from the cache's
+// miss statistics: the lines it brought in while it ran there, minus the lines other threads brought in since.
+// Otherwise it moves to the nearest idle core, or queues on the core with the shortest run queue.
+
+class SchedulerLocality : public SchedulerDynamic
+{
+   public:
+      SchedulerLocality(ThreadManager *thread_manager);
+
+      virtual core_id_t threadCreate(thread_id_t thread_id);
+      virtual void threadYield(thread_id_t thread_id);
+      virtual bool threadSetAffinity(thread_id_t calling_thread_id, thread_id_t thread_id, size_t cpusetsize, const cpu_set_t *mask);
+      virtual bool threadGetAffinity(thread_id_t thread_id, size_t cpusetsize, cpu_set_t *mask);
+
+      virtual void periodic(SubsecondTime time);
+      virtual void threadStart(thread_id_t thread_id, SubsecondTime time);
+      virtual void threadStall(thread_id_t thread_id, ThreadManager::stall_type_t reason, SubsecondTime time);
+      virtual void threadResume(thread_id_t thread_id, thread_id_t thread_by, SubsecondTime time);
+      virtual void threadExit(thread_id_t thread_id, SubsecondTime time);
+
+   private:
+      struct ThreadInfo
+      {
+         std::vector<UInt64> affinity;   // Bitmap of allowed cores
+         bool has_affinity;
+         bool explicit_affinity;
+         core_id_t core_running;
+         core_id_t core_queued;          // Run queue this thread is waiting in
+         thread_id_t prev, next;         // Run queue links
+         core_id_t home;                 // Core this thread last ran on
+         UInt64 footprint;               // Estimated lines in home's cache when it was last scheduled out
+         UInt64 fills_in, fills_out;     // Home cache fills when it was last scheduled in/out
+      };
+
+      struct CoreInfo
+      {
+         thread_id_t running;
+         thread_id_t head, tail;
+         UInt32 length;
+         SubsecondTime quantum_left;
+         StatsMetricBase *fills[2];      // Load and store misses of this core's cache, NULL if not available
+      };
+
+      // Configuration
+      const SubsecondTime m_quantum;
+      const UInt32 m_num_cores;
+      const UInt32 m_num_words;
+      std::vector<bool> m_core_mask;
+      UInt64 m_cache_lines;
+      UInt64 m_warm_lines;
+      const UInt32 m_steal_scan;
+
+      // State
+      SubsecondTime m_last_periodic;
+      std::vector<ThreadInfo> m_thread_info;
+      std::vector<CoreInfo> m_core_info;
+      std::vector<UInt64> m_idle;         // Bitmap of cores not running a thread
+      UInt32 m_num_queued;                // Threads in all run queues
+      core_id_t m_next_core;
+
+      // Statistics
+      UInt64 m_num_migrations;
+      UInt64 m_num_steals;
+      UInt64 m_num_warm_wakeups;
+
+      ThreadInfo &getThreadInfo(thread_id_t thread_id);
+      bool hasAffinity(thread_id_t thread_id, core_id_t core_id) { return (m_thread_info[thread_id].affinity[core_id / 64] >> (core_id % 64)) & 1; }
+      void addAffinity(thread_id_t thread_id, core_id_t core_id);
+      void setIdle(core_id_t core_id, bool idle);
+      bool isIdle(core_id_t core_id) const { return (m_idle[core_id / 64] >> (core_id % 64)) & 1; }
+      core_id_t findIdleCore(thread_id_t thread_id, core_id_t core_first);
+
+      void enqueue(thread_id_t thread_id, core_id_t core_id);
+      void dequeue(thread_id_t thread_id);
+      thread_id_t steal(core_id_t core_id);
+
+      UInt64 getFills(core_id_t core_id);
+      UInt64 getWarmth(thread_id_t thread_id);
+      void accountIn(thread_id_t thread_id, core_id_t core_id);
+      void accountOut(thread_id_t thread_id, core_id_t core_id);
+
+      core_id_t chooseCore(thread_id_t thread_id);
+      void place(thread_id_t thread_id, SubsecondTime time);
+      void runOn(core_id_t core_id, thread_id_t thread_id, SubsecondTime time);
+      void unschedule(core_id_t core_id, SubsecondTime time);
+      void dispatch(core_id_t core_id, SubsecondTime time);
+      void rotate(core_id_t core_id, SubsecondTime time);
+};
+
+#endif // __SCHEDULER_LOCALITY_H
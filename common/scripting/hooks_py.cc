@@ -1,17 +1,45 @@
 #include "hooks_py.h"
+#include "hooks_py_async.h"
 #include "simulator.h"
 #include "config.hpp"
+#include "log.h"
+#include "telemetry.h"
+#include "timer.h"
+
+#include <vector>
 
 bool HooksPy::pyInit = false;
 bool HooksPy::abort = false;
 PyThreadState* HooksPy::_save = NULL;
+PyInterpreterState* HooksPy::s_main_interp = NULL;
+pthread_t HooksPy::s_init_thread;
 
-void HooksPy::init()
+#if PY_VERSION_HEX >= 0x030C0000
+// Thread states this (simulator) thread uses for each sub-interpreter, created on first use
+static thread_local std::vector<std::pair<PyInterpreterState*, PyThreadState*> > t_thread_states;
+
+static PyThreadState *threadState(PyInterpreterState *interp)
 {
-   //NOTE this modification to python3 is only tested with numscripts=1
-   UInt64 numscripts = Sim()->getCfg()->getInt("hooks/numscripts");
-   if (numscripts == 0) return;
+   for(auto it = t_thread_states.begin(); it != t_thread_states.end(); ++it)
+      if (it->first == interp)
+         return it->second;
+   PyThreadState *tstate = PyThreadState_New(interp);
+   t_thread_states.push_back(std::make_pair(interp, tstate));
+   return tstate;
+}
 
+static PyThreadState *currentThreadState()
+{
+#if PY_VERSION_HEX >= 0x030D0000
+   return PyThreadState_GetUnchecked();
+#else
+   return _PyThreadState_UncheckedGet();
+#endif
+}
+#endif
+
+void HooksPy::initInterpreter()
+{
    //Init the Python Interpreter
    std::string sim_root = get_root();
    set_env();
@@ -45,8 +73,53 @@ void HooksPy::init()
            exit(-1);
    }
    PyConfig_Clear(&config);
+}
+
+void HooksPy::preinit()
+{
+   if (getenv("SNIPER_ROOT") || getenv("GRAPHITE_ROOT"))
+      initInterpreter();
+}
+
+pid_t HooksPy::forkProcess()
+{
+   // The calling thread holds the GIL: it's the one that started the interpreter, and no scripts have run yet
+   if (!Py_IsInitialized())
+      return fork();
+
+   PyOS_BeforeFork();
+   pid_t pid = fork();
+   if (pid == 0)
+      PyOS_AfterFork_Child();
+   else
+      PyOS_AfterFork_Parent();
+   return pid;
+}
+
+void HooksPy::init()
+{
+   //NOTE this modification to python3 is only tested with numscripts=1
+   UInt64 numscripts = Sim()->getCfg()->getInt("hooks/numscripts");
+   if (numscripts == 0) return;
+
+   // In server mode, the interpreter was already started before forking off this simulation
+   if (!Py_IsInitialized())
+      initInterpreter();
+
+   s_main_interp = PyInterpreterState_Main();
+   s_init_thread = pthread_self();
+
+   // Run each script in its own sub-interpreter, with its own GIL, so that their callbacks can run in parallel
+   bool subinterpreters = Sim()->getCfg()->getBool("hooks/subinterpreters");
+#if PY_VERSION_HEX < 0x030C0000
+   if (subinterpreters) {
+      LOG_PRINT_WARNING("hooks/subinterpreters requires Python 3.12 or newer, running all scripts in the main interpreter");
+      subinterpreters = false;
+   }
+#else
+   PyThreadState *main_tstate = PyThreadState_Get();
+#endif
 
-   
    //Run the different scripts
    for(UInt64 i = 0; i < numscripts; ++i) {
       String scriptname_versa = Sim()->getCfg()->getString(String("hooks/script") + itostr(i) + "name");
@@ -54,7 +127,30 @@ void HooksPy::init()
       if (scriptname.substr(scriptname.length()-3) == ".py") {
 	      String args_versa = Sim()->getCfg()->getString(String("hooks/script") + itostr(i) + "args");
 	      std::string args(args_versa.c_str(), args_versa.size());
+#if PY_VERSION_HEX >= 0x030C0000
+	      PyThreadState *tstate = NULL;
+	      if (subinterpreters) {
+	         PyInterpreterConfig interp_config = {
+	            .use_main_obmalloc = 0,
+	            .allow_fork = 0,
+	            .allow_exec = 0,
+	            .allow_threads = 1,
+	            .allow_daemon_threads = 0,
+	            .check_multi_interp_extensions = 1,
+	            .gil = PyInterpreterConfig_OWN_GIL,
+	         };
+	         PyStatus status = Py_NewInterpreterFromConfig(&tstate, &interp_config);
+	         LOG_ASSERT_ERROR(!PyStatus_Exception(status), "Cannot create a sub-interpreter for script %s", scriptname.c_str());
+	         t_thread_states.push_back(std::make_pair(PyThreadState_GetInterpreter(tstate), tstate));
+	      }
+#endif
 	      run_python_file_with_argv(scriptname, args);
+#if PY_VERSION_HEX >= 0x030C0000
+	      if (tstate) {
+	         PyEval_SaveThread();
+	         PyEval_RestoreThread(main_tstate);
+	      }
+#endif
       }
    }
    
@@ -120,9 +216,12 @@ std::string HooksPy::get_root(){
 	const char env_roots[2][16] = {"SNIPER_ROOT", "GRAPHITE_ROOT"};
 	for (unsigned int i = 0 ; i < 2 ; i++)
 	{
-	   sim_root = getenv(env_roots[i]);
-	   if (!sim_root.empty())
+	   const char *root = getenv(env_roots[i]);
+	   if (root && *root)
+	   {
+	      sim_root = root;
 	      break;
+	   }
 	}
 	LOG_ASSERT_ERROR(!sim_root.empty(), "Please make sure SNIPER_ROOT or GRAPHITE_ROOT is set");
 
@@ -140,23 +239,82 @@ void HooksPy::set_env(){
 	PyImport_AppendInittab("sim_bbv", PyInit_sim_bbv);
 	PyImport_AppendInittab("sim_mem", PyInit_sim_mem);
 	PyImport_AppendInittab("sim_thread", PyInit_sim_thread);
+	PyImport_AppendInittab("sim_power", PyInit_sim_power);
+	PyImport_AppendInittab("sim_qos", PyInit_sim_qos);
 	pyInit = true;
 }
 
 void HooksPy::fini()
 {
-   if (pyInit){
+   // In server mode, Python can be initialized without any scripts having run (and released the GIL)
+   if (pyInit && _save){
+      HooksPyAsync::fini();
       PyEval_RestoreThread(HooksPy::_save);
-//BUG? Python 3.12 hangs on this function, while we have the GIL
-#if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION < 12
+      // Since 3.12, finalization hangs when done from another thread than the one that initialized Python
+      // (e.g. the application thread that ends the simulation in Pin mode). In that case only run what
+      // scripts expect to happen at exit, the process ends right after this anyway.
+#if PY_VERSION_HEX >= 0x030C0000
+      if (!pthread_equal(pthread_self(), s_init_thread)) {
+         PyRun_SimpleString("import atexit, sys; atexit._run_exitfuncs(); sys.stdout.flush(); sys.stderr.flush()");
+         return;
+      }
+#endif
       Py_FinalizeEx();
+   }
+}
+
+HooksPy::Callable * HooksPy::makeCallable(PyObject *pFunc)
+{
+   Callable *callable = new Callable();
+   callable->func = pFunc;
+#if PY_VERSION_HEX >= 0x03090000
+   callable->interp = PyInterpreterState_Get();
+#else
+   callable->interp = PyThreadState_Get()->interp;
 #endif
+   Py_INCREF(pFunc);
+   return callable;
+}
+
+HooksPy::GILState HooksPy::ensureGIL(PyInterpreterState *interp)
+{
+   GILState state = { PyGILState_UNLOCKED, NULL, true, false };
+#if PY_VERSION_HEX >= 0x030C0000
+   // PyGILState_* only know about the main interpreter. For a sub-interpreter, switch to this thread's
+   // thread state for it, after detaching from a different interpreter that may be running on this thread
+   // (e.g. a script in one interpreter calling sim.stats.write, which calls HOOK_PRE_STAT_WRITE callbacks in another).
+   PyThreadState *current = currentThreadState();
+   if (current && PyThreadState_GetInterpreter(current) != interp)
+      state.prev = PyEval_SaveThread();
+   if (interp != s_main_interp) {
+      state.main = false;
+      if (!current || state.prev) {
+         PyEval_RestoreThread(threadState(interp));
+         state.attached = true;
+      }
+      return state;
    }
+#endif
+   state.gilstate = PyGILState_Ensure();
+   return state;
+}
+
+void HooksPy::releaseGIL(const GILState &state)
+{
+   if (state.main)
+      PyGILState_Release(state.gilstate);
+   else if (state.attached)
+      PyEval_SaveThread();
+   if (state.prev)
+      PyEval_RestoreThread(state.prev);
 }
 
 PyObject * HooksPy::callPythonFunction(PyObject *pFunc, PyObject *pArgs)
 {
+   UInt64 t_start = Telemetry::isEnabled() ? Timer::now() : 0;
    PyObject *pResult = PyObject_CallObject(pFunc, pArgs);
+   if (t_start)
+      Telemetry::addPythonTime(Timer::now() - t_start);
    Py_XDECREF(pArgs);
    if (pResult == NULL) {
       PyErr_Print();
@@ -164,6 +322,28 @@ PyObject * HooksPy::callPythonFunction(PyObject *pFunc, PyObject *pArgs)
    return pResult;
 }
 
+PyObject * HooksPy::makeArray(const UInt64 *values, size_t count)
+{
+   // Not cached, objects cannot be shared between (sub-)interpreters. The import is a lookup in sys.modules.
+   PyObject *pModule = PyImport_ImportModule("array");
+   if (!pModule)
+      return NULL;
+   PyObject *pArrayType = PyObject_GetAttrString(pModule, "array");
+   Py_DECREF(pModule);
+   if (!pArrayType)
+      return NULL;
+
+   PyObject *pBytes = PyBytes_FromStringAndSize((const char *)values, count * sizeof(UInt64));
+   if (!pBytes) {
+      Py_DECREF(pArrayType);
+      return NULL;
+   }
+   PyObject *pArray = PyObject_CallFunction(pArrayType, "sO", "Q", pBytes);
+   Py_DECREF(pBytes);
+   Py_DECREF(pArrayType);
+   return pArray;
+}
+
 void HooksPy::prepare_abort(){
 	HooksPy::abort = true;
 }
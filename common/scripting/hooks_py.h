@@ -6,28 +6,69 @@
 #undef _XOPEN_SOURCE
 #include <Python.h>
 #include <string>
+#include <pthread.h>
+
+#include "fixed_types.h"
 
 #if PY_MAJOR_VERSION < 3 || PY_MINOR_VERSION < 8
 #error "Python version does not support some features used. Please upgrade to Pyhton 3.8 or higher."
 #endif
 
+// Module slots shared by all sim_* modules. They keep no per-interpreter state, so they can be imported into
+// sub-interpreters with their own GIL (Python 3.12+), and do not need the GIL on free-threaded builds (Python 3.13+).
+#if PY_VERSION_HEX >= 0x030D0000
+#define HOOKS_PY_MODULE_SLOTS {Py_mod_multiple_interpreters, Py_MOD_PER_INTERPRETER_GIL_SUPPORTED}, {Py_mod_gil, Py_MOD_GIL_NOT_USED},
+#elif PY_VERSION_HEX >= 0x030C0000
+#define HOOKS_PY_MODULE_SLOTS {Py_mod_multiple_interpreters, Py_MOD_PER_INTERPRETER_GIL_SUPPORTED},
+#else
+#define HOOKS_PY_MODULE_SLOTS
+#endif
+
 class HooksPy {
    public:
+      // A Python function registered as a callback, with the interpreter of the script that registered it
+      struct Callable {
+         PyObject *func;
+         PyInterpreterState *interp;
+      };
+      // Take the GIL (of the interpreter a callback belongs to) from a simulator thread, replaces PyGILState_Ensure/Release
+      struct GILState {
+         PyGILState_STATE gilstate;
+         PyThreadState *prev;     // Thread state of another interpreter that was active on this thread
+         bool main;
+         bool attached;
+      };
+
       static void init(void);
       static void set_env();
       static void fini(void);
 
+      // Server mode (see standalone/server.cc): start the interpreter before any simulation is set up,
+      // and fork simulations off a process that has it running
+      static void preinit(void);
+      static pid_t forkProcess(void);
+
+      // Must be called with the GIL held, takes a reference to pFunc
+      static Callable * makeCallable(PyObject *pFunc);
+      static GILState ensureGIL(PyInterpreterState *interp);
+      static void releaseGIL(const GILState &state);
+
       static PyObject * callPythonFunction(PyObject *pFunc, PyObject *pArgs);
+      // Return values as an array.array('Q'), which supports the buffer protocol (e.g., numpy.frombuffer)
+      static PyObject * makeArray(const UInt64 *values, size_t count);
 
       static void prepare_abort();
       static bool need_to_abort();
    private:
       static std::string get_root();
+      static void initInterpreter();
       static void run_python_file_with_argv(const std::string &filename, const std::string &argv_str);
       static bool pyInit;
       static bool abort;
 
       static PyThreadState *_save;
+      static PyInterpreterState *s_main_interp;
+      static pthread_t s_init_thread;
 };
 
 PyMODINIT_FUNC PyInit_sim_config(void);
@@ -38,5 +79,7 @@ PyMODINIT_FUNC PyInit_sim_control(void);
 PyMODINIT_FUNC PyInit_sim_bbv(void);
 PyMODINIT_FUNC PyInit_sim_mem(void);
 PyMODINIT_FUNC PyInit_sim_thread(void);
+PyMODINIT_FUNC PyInit_sim_power(void);
+PyMODINIT_FUNC PyInit_sim_qos(void);
 
 #endif // HOOKS_PY_H
@@ -0,0 +1,314 @@
+#include "hooks_py_async.h"
+#include "simulator.h"
+#include "thread_manager.h"
+#include "subsecond_time.h"
+#include "log.h"
+
+#include <sched.h>
+
+HooksPyAsync *HooksPyAsync::s_instance = NULL;
+
+HooksPyAsync::HooksPyAsync()
+   : m_head(NULL)
+   , m_tail(NULL)
+   , m_pushed(0)
+   , m_handled(0)
+   , m_running(false)
+   , m_sleeping(false)
+   , m_stop(false)
+   , m_wakeup(0)
+   , m_done(0)
+   , m_thread(NULL)
+{
+   Event *stub = new Event();
+   stub->next = NULL;
+   m_head = stub;
+   m_tail = stub;
+
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_END, hookFlush, 0);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_PRE_STAT_WRITE, hookFlush, 0);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_SIM_END, hookFlush, 0);
+
+   // In Pin mode, the thread only starts once the application does. Events queue up until then.
+   m_thread = _Thread::create(this);
+   m_thread->run();
+}
+
+HooksPyAsync::~HooksPyAsync()
+{
+   if (m_running)
+   {
+      m_stop = true;
+      m_wakeup.signal();
+      m_done.wait();
+   }
+   delete m_thread;
+
+   while(pop())
+      ;
+   delete m_tail;
+}
+
+bool
+HooksPyAsync::isSupported(HookType::hook_type_t type)
+{
+   switch(type)
+   {
+      case HookType::HOOK_PERIODIC:
+      case HookType::HOOK_THREAD_CREATE:
+      case HookType::HOOK_THREAD_START:
+      case HookType::HOOK_THREAD_EXIT:
+      case HookType::HOOK_THREAD_STALL:
+      case HookType::HOOK_THREAD_RESUME:
+      case HookType::HOOK_THREAD_MIGRATE:
+      case HookType::HOOK_BRANCH_PREDICT:
+      case HookType::HOOK_CORE_STATE_CHANGE:
+         return true;
+      default:
+         return false;
+   }
+}
+
+void
+HooksPyAsync::registerHook(HookType::hook_type_t type, HooksPy::Callable *callable)
+{
+   LOG_ASSERT_ERROR(isSupported(type), "Hook %s cannot be called asynchronously", HookType::hook_type_names[type]);
+
+   if (!s_instance)
+      s_instance = new HooksPyAsync();
+
+   Registration *registration = new Registration();
+   registration->queue = s_instance;
+   registration->type = type;
+   registration->callable = callable;
+   Sim()->getHooksManager()->registerHook(type, hookCallback, (UInt64)registration);
+}
+
+void
+HooksPyAsync::flush()
+{
+   if (!s_instance)
+      return;
+
+   // Called from a Python callback (e.g. sim.stats.write), let the consumer thread have the GIL while we wait
+   if (PyGILState_Check())
+   {
+      Py_BEGIN_ALLOW_THREADS
+      s_instance->wait();
+      Py_END_ALLOW_THREADS
+   }
+   else
+      s_instance->wait();
+}
+
+void
+HooksPyAsync::fini()
+{
+   if (s_instance)
+   {
+      flush();
+      delete s_instance;
+      s_instance = NULL;
+   }
+}
+
+void
+HooksPyAsync::push(Event *event)
+{
+   event->next.store(NULL, std::memory_order_relaxed);
+   Event *prev = m_head.exchange(event, std::memory_order_acq_rel);
+   prev->next.store(event, std::memory_order_release);
+   m_pushed.fetch_add(1, std::memory_order_release);
+
+   if (m_sleeping.exchange(false))
+      m_wakeup.signal();
+}
+
+HooksPyAsync::Event *
+HooksPyAsync::pop()
+{
+   Event *next = m_tail->next.load(std::memory_order_acquire);
+   if (!next)
+      return NULL;
+   delete m_tail;
+   m_tail = next;
+   return next;
+}
+
+void
+HooksPyAsync::wait()
+{
+   // Before the consumer thread is running (Pin mode, before the application starts) there's no one to wait for
+   UInt64 target = m_pushed.load(std::memory_order_acquire);
+   while (m_running && m_handled.load(std::memory_order_acquire) < target)
+   {
+      if (m_sleeping.exchange(false))
+         m_wakeup.signal();
+      sched_yield();
+   }
+}
+
+void
+HooksPyAsync::run()
+{
+   m_running = true;
+
+   while(true)
+   {
+      Event *event = pop();
+      if (!event)
+      {
+         if (m_stop)
+            break;
+         // Announce that we're going to sleep, then check again to not miss an event pushed in between
+         m_sleeping = true;
+         event = pop();
+         if (!event)
+         {
+            m_wakeup.wait();
+            continue;
+         }
+         m_sleeping = false;
+      }
+
+      // Handle everything that is queued under a single GIL acquisition, unless callbacks live in different interpreters
+      PyInterpreterState *interp = event->registration->callable->interp;
+      HooksPy::GILState state = HooksPy::ensureGIL(interp);
+      UInt64 handled = 0;
+      for( ; event; event = pop())
+      {
+         if (event->registration->callable->interp != interp)
+         {
+            HooksPy::releaseGIL(state);
+            interp = event->registration->callable->interp;
+            state = HooksPy::ensureGIL(interp);
+         }
+         handle(event);
+         ++handled;
+      }
+      HooksPy::releaseGIL(state);
+      m_handled.fetch_add(handled, std::memory_order_release);
+   }
+
+   m_running = false;
+   m_done.signal();
+}
+
+SInt64
+HooksPyAsync::hookCallback(UInt64 _registration, UInt64 argument)
+{
+   const Registration *registration = (const Registration *)_registration;
+   Event *event = new Event();
+   event->registration = registration;
+
+   // Copy out everything the callback needs, the hook's argument structure is gone by the time it runs
+   switch(registration->type)
+   {
+      case HookType::HOOK_PERIODIC:
+         event->args[0] = SubsecondTime(*(subsecond_time_t*)&argument).getFS();
+         break;
+      case HookType::HOOK_THREAD_CREATE:
+      {
+         HooksManager::ThreadCreate *args = (HooksManager::ThreadCreate*)argument;
+         event->args[0] = args->thread_id;
+         event->args[1] = args->creator_thread_id;
+         break;
+      }
+      case HookType::HOOK_THREAD_START:
+      case HookType::HOOK_THREAD_EXIT:
+      {
+         HooksManager::ThreadTime *args = (HooksManager::ThreadTime*)argument;
+         event->args[0] = args->thread_id;
+         event->args[1] = SubsecondTime(args->time).getFS();
+         break;
+      }
+      case HookType::HOOK_THREAD_STALL:
+      {
+         HooksManager::ThreadStall *args = (HooksManager::ThreadStall*)argument;
+         event->args[0] = args->thread_id;
+         event->args[1] = args->reason;
+         event->args[2] = SubsecondTime(args->time).getFS();
+         break;
+      }
+      case HookType::HOOK_THREAD_RESUME:
+      {
+         HooksManager::ThreadResume *args = (HooksManager::ThreadResume*)argument;
+         event->args[0] = args->thread_id;
+         event->args[1] = args->thread_by;
+         event->args[2] = SubsecondTime(args->time).getFS();
+         break;
+      }
+      case HookType::HOOK_THREAD_MIGRATE:
+      {
+         HooksManager::ThreadMigrate *args = (HooksManager::ThreadMigrate*)argument;
+         event->args[0] = args->thread_id;
+         event->args[1] = args->core_id;
+         event->args[2] = SubsecondTime(args->time).getFS();
+         break;
+      }
+      case HookType::HOOK_BRANCH_PREDICT:
+      {
+         HooksManager::BranchPrediction *args = (HooksManager::BranchPrediction*)argument;
+         event->args[0] = args->ip;
+         event->args[1] = args->predicted;
+         event->args[2] = args->actual;
+         event->args[3] = args->indirect;
+         event->args[4] = args->core_id;
+         break;
+      }
+      case HookType::HOOK_CORE_STATE_CHANGE:
+      {
+         HooksManager::CoreStateChange *args = (HooksManager::CoreStateChange*)argument;
+         event->args[0] = args->core_id;
+         event->args[1] = args->old_state;
+         event->args[2] = args->new_state;
+         event->args[3] = SubsecondTime(args->time).getFS();
+         break;
+      }
+      default:
+         LOG_PRINT_ERROR("Unexpected asynchronous hook %s", HookType::hook_type_names[registration->type]);
+   }
+
+   registration->queue->push(event);
+   return -1;
+}
+
+void
+HooksPyAsync::handle(const Event *event)
+{
+   const UInt64 *a = event->args;
+   PyObject *pArgs = NULL;
+
+   // Same arguments as the synchronous callbacks in py_hooks.cc
+   switch(event->registration->type)
+   {
+      case HookType::HOOK_PERIODIC:
+         pArgs = Py_BuildValue("(L)", a[0]);
+         break;
+      case HookType::HOOK_THREAD_CREATE:
+         pArgs = Py_BuildValue("(ii)", int(a[0]), int(a[1]));
+         break;
+      case HookType::HOOK_THREAD_START:
+      case HookType::HOOK_THREAD_EXIT:
+         pArgs = Py_BuildValue("(iL)", int(a[0]), a[1]);
+         break;
+      case HookType::HOOK_THREAD_STALL:
+         pArgs = Py_BuildValue("(isL)", int(a[0]), ThreadManager::stall_type_names[a[1]], a[2]);
+         break;
+      case HookType::HOOK_THREAD_RESUME:
+      case HookType::HOOK_THREAD_MIGRATE:
+         pArgs = Py_BuildValue("(iiL)", int(a[0]), int(a[1]), a[2]);
+         break;
+      case HookType::HOOK_BRANCH_PREDICT:
+         pArgs = Py_BuildValue("(liiii)", long(a[0]), int(a[1]), int(a[2]), int(a[3]), int(a[4]));
+         break;
+      case HookType::HOOK_CORE_STATE_CHANGE:
+         pArgs = Py_BuildValue("(iiiL)", int(a[0]), int(a[1]), int(a[2]), a[3]);
+         break;
+      default:
+         LOG_PRINT_ERROR("Unexpected asynchronous hook %s", HookType::hook_type_names[event->registration->type]);
+   }
+
+   PyObject *pResult = HooksPy::callPythonFunction(event->registration->callable->func, pArgs);
+   Py_XDECREF(pResult);
+}
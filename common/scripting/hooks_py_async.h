@@ -0,0 +1,68 @@
+#ifndef HOOKS_PY_ASYNC_H
+#define HOOKS_PY_ASYNC_H
+
+#include "hooks_py.h"
+#include "hooks_manager.h"
+#include "_thread.h"
+#include "sem.h"
+
+#include <atomic>
+
+// Runs notification-only Python hooks, registered with sim.hooks.register_async, on a dedicated thread.
+// Simulation threads copy the hook's arguments into an event and push it onto a lock-free multi-producer queue,
+// they never wait for the GIL. Events are drained at ROI end, before statistics are written and at simulation end,
+// so a script sees all events up to that point. Callbacks run in order, but later than the event itself:
+// their return value is ignored, and the simulator state they can query has moved on.
+class HooksPyAsync : public Runnable
+{
+   public:
+      static bool isSupported(HookType::hook_type_t type);
+      static void registerHook(HookType::hook_type_t type, HooksPy::Callable *callable);
+      // Wait until all events queued so far have been handled
+      static void flush();
+      static void fini();
+
+   private:
+      struct Registration
+      {
+         HooksPyAsync *queue;
+         HookType::hook_type_t type;
+         HooksPy::Callable *callable;
+      };
+      struct Event
+      {
+         std::atomic<Event*> next;
+         const Registration *registration;
+         UInt64 args[5];
+      };
+
+      static HooksPyAsync *s_instance;
+
+      // Intrusive MPSC queue: producers swap themselves in at m_head, the consumer follows next pointers from m_tail.
+      // m_tail always points to an already handled event (initially a stub), which is freed when moving past it.
+      std::atomic<Event*> m_head;
+      Event *m_tail;
+      std::atomic<UInt64> m_pushed;
+      std::atomic<UInt64> m_handled;
+
+      std::atomic<bool> m_running;
+      std::atomic<bool> m_sleeping;
+      bool m_stop;
+      Semaphore m_wakeup;
+      Semaphore m_done;
+      _Thread *m_thread;
+
+      HooksPyAsync();
+      ~HooksPyAsync();
+
+      void push(Event *event);
+      Event *pop();
+      void wait();
+      void handle(const Event *event);
+      void run();
+
+      static SInt64 hookCallback(UInt64 _registration, UInt64 argument);
+      static SInt64 hookFlush(UInt64, UInt64) { flush(); return 0; }
+};
+
+#endif // HOOKS_PY_ASYNC_H
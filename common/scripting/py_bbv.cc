@@ -60,21 +60,30 @@ static PyMethodDef PyBbvMethods[] = {
    {NULL, NULL, 0, NULL} /* Sentinel */
 };
 
+static int PyBbvExec(PyObject *pModule)
+{
+   PyObject *pGlobalConst = PyLong_FromLong(BbvCount::NUM_BBV);
+   PyObject_SetAttrString(pModule, "BBV_SIZE", pGlobalConst);
+   Py_DECREF(pGlobalConst);
+   return 0;
+}
+
+static PyModuleDef_Slot PyBbvSlots[] = {
+   {Py_mod_exec, (void *)PyBbvExec},
+   HOOKS_PY_MODULE_SLOTS
+   {0, NULL}
+};
+
 static PyModuleDef PyBbvModule = {
 	PyModuleDef_HEAD_INIT,
 	"sim_bbv",
 	"",
-	-1,
+	0,
 	PyBbvMethods,
-	NULL, NULL, NULL, NULL
+	PyBbvSlots, NULL, NULL, NULL
 };
 
 PyMODINIT_FUNC PyInit_sim_bbv(void)
 {
-   PyObject *pModule = PyModule_Create(&PyBbvModule);
-
-   PyObject *pGlobalConst = PyLong_FromLong(BbvCount::NUM_BBV);
-   PyObject_SetAttrString(pModule, "BBV_SIZE", pGlobalConst);
-   Py_DECREF(pGlobalConst);
-   return pModule;
+   return PyModuleDef_Init(&PyBbvModule);
 }
@@ -83,19 +83,8 @@ static PyMethodDef PySniperConfigMethods[] = {
    {NULL, NULL, 0, NULL} /* Sentinel */
 };
 
-static PyModuleDef PySniperConfigModule = {
-	PyModuleDef_HEAD_INIT,
-	"sim_config",
-	"",
-	-1,
-	PySniperConfigMethods,
-	NULL, NULL, NULL, NULL
-};
-
-PyMODINIT_FUNC PyInit_sim_config(void)
+static int PySniperConfigExec(PyObject *pModule)
 {
-   PyObject *pModule = PyModule_Create(&PySniperConfigModule);
-
    PyObject *pOutputdir = PyUnicode_FromString(Sim()->getConfig()->formatOutputFileName("").c_str());
    PyObject_SetAttrString(pModule, "output_dir", pOutputdir);
    Py_DECREF(pOutputdir);
@@ -104,5 +93,25 @@ PyMODINIT_FUNC PyInit_sim_config(void)
    PyObject_SetAttrString(pModule, "ncores", pNcores);
    Py_DECREF(pNcores);
 
-   return pModule;
+   return 0;
+}
+
+static PyModuleDef_Slot PySniperConfigSlots[] = {
+   {Py_mod_exec, (void *)PySniperConfigExec},
+   HOOKS_PY_MODULE_SLOTS
+   {0, NULL}
+};
+
+static PyModuleDef PySniperConfigModule = {
+	PyModuleDef_HEAD_INIT,
+	"sim_config",
+	"",
+	0,
+	PySniperConfigMethods,
+	PySniperConfigSlots, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_sim_config(void)
+{
+   return PyModuleDef_Init(&PySniperConfigModule);
 }
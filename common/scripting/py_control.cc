@@ -61,27 +61,40 @@ simulatorAbort(PyObject *self, PyObject *args)
    Py_RETURN_NONE;
 }
 
+#include "core_manager.h"
+#include "core.h"
+static PyObject *
+getCoreStateHistory(PyObject *self, PyObject *args)
+{
+   long int core_id = -1;
+
+   if (!PyArg_ParseTuple(args, "l", &core_id))
+      return NULL;
+
+   if (core_id < 0 || core_id >= (long int)Sim()->getConfig()->getApplicationCores()) {
+      PyErr_SetString(PyExc_ValueError, "Core does not exist");
+      return NULL;
+   }
+
+   const CoreStateHistory *history = Sim()->getCoreManager()->getCoreFromID(core_id)->getStateHistory();
+   if (!history)
+      Py_RETURN_NONE;
+
+   // Read-only view on the live ring, it stays valid for as long as the simulation runs
+   return PyMemoryView_FromMemory((char*)history->data(), history->dataSize(), PyBUF_READ);
+}
+
 static PyMethodDef PyControlMethods[] = {
    { "set_roi", setROI, METH_VARARGS, "Set whether or not we are in the ROI" },
    { "set_instrumentation_mode", setInstrumentationMode, METH_VARARGS, "Set instrumentation mode" },
    { "set_progress", setProgress, METH_VARARGS, "Set simulation progress indicator (0..1)" },
    { "abort", simulatorAbort, METH_VARARGS, "Stop simulation now" },
+   { "get_core_state_history", getCoreStateHistory, METH_VARARGS, "Get a read-only view on a core's state history ring (None if disabled)" },
    { NULL, NULL, 0, NULL } /* Sentinel */
 };
 
-static PyModuleDef PyControlModule = {
-	PyModuleDef_HEAD_INIT,
-	"sim_control",
-	"",
-	-1,
-	PyControlMethods,
-	NULL, NULL, NULL, NULL
-};
-
-PyMODINIT_FUNC PyInit_sim_control(void)
+static int PyControlExec(PyObject *pModule)
 {
-   PyObject *pModule = PyModule_Create(&PyControlModule);
-
    {
       PyObject *pGlobalConst = PyLong_FromLong(SIM_OPT_INSTRUMENT_DETAILED);
       PyObject_SetAttrString(pModule, "DETAILED", pGlobalConst);
@@ -97,5 +110,25 @@ PyMODINIT_FUNC PyInit_sim_control(void)
       PyObject_SetAttrString(pModule, "FASTFORWARD", pGlobalConst);
       Py_DECREF(pGlobalConst);
    }
-   return pModule;
+   return 0;
+}
+
+static PyModuleDef_Slot PyControlSlots[] = {
+   {Py_mod_exec, (void *)PyControlExec},
+   HOOKS_PY_MODULE_SLOTS
+   {0, NULL}
+};
+
+static PyModuleDef PyControlModule = {
+	PyModuleDef_HEAD_INIT,
+	"sim_control",
+	"",
+	0,
+	PyControlMethods,
+	PyControlSlots, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_sim_control(void)
+{
+   return PyModuleDef_Init(&PyControlModule);
 }
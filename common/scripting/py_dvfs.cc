@@ -46,6 +46,17 @@ getFrequency(PyObject *self, PyObject *args)
    return PyLong_FromLong(freq);
 }
 
+static PyObject *
+getFrequencies(PyObject *self, PyObject *args)
+{
+   UInt32 num_cores = Sim()->getConfig()->getApplicationCores();
+   std::vector<UInt64> freqs(num_cores);
+   for(UInt32 core_id = 0; core_id < num_cores; ++core_id)
+      freqs[core_id] = 1000000000 / Sim()->getDvfsManager()->getCoreDomain(core_id)->getPeriod().getFS();
+
+   return HooksPy::makeArray(freqs.data(), freqs.size());
+}
+
 static PyObject *
 setFrequency(PyObject *self, PyObject *args)
 {
@@ -65,6 +76,72 @@ setFrequency(PyObject *self, PyObject *args)
    Py_RETURN_NONE;
 }
 
+static PyObject *
+postFrequency(PyObject *self, PyObject *args)
+{
+   long int core_id = -999;
+   long int freq_mhz = -1;
+   unsigned long long time_fs = 0;
+
+   if (!PyArg_ParseTuple(args, "llK", &core_id, &freq_mhz, &time_fs))
+      return NULL;
+
+   const ComponentPeriod *domain = getDomain(core_id, false);
+   if (!domain)
+      return NULL;
+
+   if (!Sim()->getDvfsManager()->isAsync()) {
+      PyErr_SetString(PyExc_RuntimeError, "Asynchronous frequency changes are not enabled (dvfs/async)");
+      return NULL;
+   }
+   if (freq_mhz <= 0) {
+      PyErr_SetString(PyExc_ValueError, "Frequency must be positive");
+      return NULL;
+   }
+
+   Sim()->getDvfsManager()->postCoreDomain(core_id, ComponentPeriod::fromFreqHz(1000000 * UInt64(freq_mhz)), SubsecondTime::FS(time_fs));
+
+   Py_RETURN_NONE;
+}
+
+static PyObject *
+setFrequencies(PyObject *self, PyObject *args)
+{
+   PyObject *pFreqs = NULL;
+
+   if (!PyArg_ParseTuple(args, "O", &pFreqs))
+      return NULL;
+
+   PyObject *pSeq = PySequence_Fast(pFreqs, "Expected a sequence of frequencies");
+   if (!pSeq)
+      return NULL;
+
+   Py_ssize_t size = PySequence_Fast_GET_SIZE(pSeq);
+   if (size != Sim()->getConfig()->getApplicationCores()) {
+      Py_DECREF(pSeq);
+      PyErr_SetString(PyExc_ValueError, "Need a frequency for every core");
+      return NULL;
+   }
+
+   std::vector<UInt64> freqs_mhz(size);
+   for(Py_ssize_t i = 0; i < size; ++i) {
+      long int freq_mhz = PyLong_AsLong(PySequence_Fast_GET_ITEM(pSeq, i));
+      if (freq_mhz < 0) {
+         Py_DECREF(pSeq);
+         if (!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "Frequencies must be positive, or 0 to leave a core unchanged");
+         return NULL;
+      }
+      freqs_mhz[i] = freq_mhz;
+   }
+   Py_DECREF(pSeq);
+
+   // We're running in a hook so we already have the thread lock, call MagicServer directly
+   Sim()->getMagicServer()->setFrequencies(freqs_mhz);
+
+   Py_RETURN_NONE;
+}
+
 // ClBu @ULBS
 static PyObject *
 getCoreState(PyObject *self, PyObject *args)
@@ -76,28 +153,52 @@ getCoreState(PyObject *self, PyObject *args)
    return PyLong_FromLong(core_state);
 }
 
+static PyObject *
+getCoreStates(PyObject *self, PyObject *args)
+{
+   UInt32 num_cores = Sim()->getConfig()->getApplicationCores();
+   std::vector<UInt64> states(num_cores);
+   for(UInt32 core_id = 0; core_id < num_cores; ++core_id)
+      states[core_id] = Sim()->getMagicServer()->getCoreState(core_id);
+
+   return HooksPy::makeArray(states.data(), states.size());
+}
+
 static PyMethodDef PyDvfsMethods[] = {
    {"get_frequency",  getFrequency, METH_VARARGS, "Get core or global frequency, in MHz."},
    {"set_frequency",  setFrequency, METH_VARARGS, "Set core frequency, in MHz."},
+   {"post_frequency",  postFrequency, METH_VARARGS, "Set core frequency, in MHz, once the core reaches a time (in fs). Requires dvfs/async."},
+   {"set_frequencies",  setFrequencies, METH_VARARGS, "Set the frequency of all cores at once, in MHz (0 leaves a core unchanged)."},
    {"get_core_state", getCoreState, METH_VARARGS, "Get core state, in Core::State enum."},
+   {"get_frequencies", getFrequencies, METH_NOARGS, "Get the frequency of all cores as an array, in MHz."},
+   {"get_core_states", getCoreStates, METH_NOARGS, "Get the state of all cores as an array, in Core::State enum."},
    {NULL, NULL, 0, NULL} /* Sentinel */
 };
 
+static int PyDvfsExec(PyObject *pModule)
+{
+   PyObject *pGlobalConst = PyLong_FromLong(-1);
+   PyObject_SetAttrString(pModule, "GLOBAL", pGlobalConst);
+   Py_DECREF(pGlobalConst);
+   return 0;
+}
+
+static PyModuleDef_Slot PyDvfsSlots[] = {
+   {Py_mod_exec, (void *)PyDvfsExec},
+   HOOKS_PY_MODULE_SLOTS
+   {0, NULL}
+};
+
 static PyModuleDef PyDvfsModule = {
 	PyModuleDef_HEAD_INIT,
 	"sim_dvfs",
 	"",
-	-1,
+	0,
 	PyDvfsMethods,
-	NULL, NULL, NULL, NULL
+	PyDvfsSlots, NULL, NULL, NULL
 };
 
 PyMODINIT_FUNC PyInit_sim_dvfs(void)
 {
-   PyObject *pModule = PyModule_Create(&PyDvfsModule);
-
-   PyObject *pGlobalConst = PyLong_FromLong(-1);
-   PyObject_SetAttrString(pModule, "GLOBAL", pGlobalConst);
-   Py_DECREF(pGlobalConst);
-   return pModule;
+   return PyModuleDef_Init(&PyDvfsModule);
 }
@@ -1,4 +1,5 @@
 #include "hooks_py.h"
+#include "hooks_py_async.h"
 #include "subsecond_time.h"
 #include "simulator.h"
 #include "hooks_manager.h"
@@ -6,6 +7,7 @@
 #include "syscall_model.h"
 #include "sim_api.h"
 #include <ios>
+#include <vector>
 #include "trace_manager.h"
 
 static SInt64 hookCallbackResult(PyObject *pResult)
@@ -39,141 +41,154 @@ static void check_and_abort(){
 }
 
 /* Notes on the PyGILState, we only need to take a lock on the Global Interpreter lock, when executing the function from a c-thread. All the other callback functions, called by the python scripts, which are assumed to have the GIL already, so we don't need to explictly take it anymore.
+ * Callbacks take the GIL through HooksPy::ensureGIL, which also handles scripts running in their own sub-interpreter (hooks/subinterpreters).
  */
-static SInt64 hookCallbackNone(UInt64 pFunc, UInt64)
+static SInt64 hookCallbackNone(UInt64 _callable, UInt64)
 {
-   PyGILState_STATE state = PyGILState_Ensure();
-   PyObject *pResult = HooksPy::callPythonFunction((PyObject *)pFunc, NULL);
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, NULL);
    SInt64 result = hookCallbackResult(pResult);
-   PyGILState_Release(state);
+   HooksPy::releaseGIL(state);
    check_and_abort();
    return result;
 }
 
-static SInt64 hookCallbackInt(UInt64 pFunc, UInt64 argument)
+static SInt64 hookCallbackInt(UInt64 _callable, UInt64 argument)
 {
-   PyGILState_STATE state = PyGILState_Ensure();
-   PyObject *pResult = HooksPy::callPythonFunction((PyObject *)pFunc, Py_BuildValue("(L)", argument));
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(L)", argument));
    SInt64 result = hookCallbackResult(pResult);
-   PyGILState_Release(state);
+   HooksPy::releaseGIL(state);
    check_and_abort();
    return result;
 }
 
-static SInt64 hookCallbackSubsecondTime(UInt64 pFunc, UInt64 argument)
+static SInt64 hookCallbackSubsecondTime(UInt64 _callable, UInt64 argument)
 {
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
    SubsecondTime time(*(subsecond_time_t*)&argument);
-   PyGILState_STATE state = PyGILState_Ensure();
-   PyObject *pResult = HooksPy::callPythonFunction((PyObject *)pFunc, Py_BuildValue("(L)", time.getFS()));
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(L)", time.getFS()));
    SInt64 result = hookCallbackResult(pResult);
-   PyGILState_Release(state);
+   HooksPy::releaseGIL(state);
    check_and_abort();
    return result;
 }
 
-static SInt64 hookCallbackString(UInt64 pFunc, UInt64 _argument)
+static SInt64 hookCallbackString(UInt64 _callable, UInt64 _argument)
 {
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
    const char* argument = (const char*)_argument;
-   PyGILState_STATE state = PyGILState_Ensure();
-   PyObject *pResult = HooksPy::callPythonFunction((PyObject *)pFunc, Py_BuildValue("(s)", argument));
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(s)", argument));
    SInt64 result = hookCallbackResult(pResult);
-   PyGILState_Release(state);
+   HooksPy::releaseGIL(state);
    check_and_abort();
    return result;
 }
 
-static SInt64 hookCallbackMagicMarkerType(UInt64 pFunc, UInt64 _argument)
+static SInt64 hookCallbackMagicMarkerType(UInt64 _callable, UInt64 _argument)
 {
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
    MagicServer::MagicMarkerType* argument = (MagicServer::MagicMarkerType*)_argument;
-   PyGILState_STATE state = PyGILState_Ensure();
-   PyObject *pResult = HooksPy::callPythonFunction((PyObject *)pFunc, Py_BuildValue("(iiKKs)", argument->thread_id, argument->core_id, argument->arg0, argument->arg1, argument->str));
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(iiKKs)", argument->thread_id, argument->core_id, argument->arg0, argument->arg1, argument->str));
    SInt64 result = hookCallbackResult(pResult);
-   PyGILState_Release(state);
+   HooksPy::releaseGIL(state);
    check_and_abort();
    return result;
 }
 
-static SInt64 hookCallbackThreadCreateType(UInt64 pFunc, UInt64 _argument)
+static SInt64 hookCallbackThreadCreateType(UInt64 _callable, UInt64 _argument)
 {
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
    HooksManager::ThreadCreate* argument = (HooksManager::ThreadCreate*)_argument;
-   PyGILState_STATE state = PyGILState_Ensure();
-   PyObject *pResult = HooksPy::callPythonFunction((PyObject *)pFunc, Py_BuildValue("(ii)", argument->thread_id, argument->creator_thread_id));
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(ii)", argument->thread_id, argument->creator_thread_id));
    SInt64 result = hookCallbackResult(pResult);
-   PyGILState_Release(state);
+   HooksPy::releaseGIL(state);
    check_and_abort();
    return result;
 }
 
-static SInt64 hookCallbackThreadTimeType(UInt64 pFunc, UInt64 _argument)
+static SInt64 hookCallbackThreadTimeType(UInt64 _callable, UInt64 _argument)
 {
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
    HooksManager::ThreadTime* argument = (HooksManager::ThreadTime*)_argument;
    SubsecondTime time(argument->time);
-   PyGILState_STATE state = PyGILState_Ensure();
-   PyObject *pResult = HooksPy::callPythonFunction((PyObject *)pFunc, Py_BuildValue("(iL)", argument->thread_id, time.getFS()));
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(iL)", argument->thread_id, time.getFS()));
    SInt64 result = hookCallbackResult(pResult);
-   PyGILState_Release(state);
+   HooksPy::releaseGIL(state);
    check_and_abort();
    return result;
 }
 
-static SInt64 hookCallbackThreadStallType(UInt64 pFunc, UInt64 _argument)
+static SInt64 hookCallbackThreadStallType(UInt64 _callable, UInt64 _argument)
 {
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
    HooksManager::ThreadStall* argument = (HooksManager::ThreadStall*)_argument;
    SubsecondTime time(argument->time);
-   PyGILState_STATE state = PyGILState_Ensure();
-   PyObject *pResult = HooksPy::callPythonFunction((PyObject *)pFunc, Py_BuildValue("(isL)", argument->thread_id, ThreadManager::stall_type_names[argument->reason], time.getFS()));
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(isL)", argument->thread_id, ThreadManager::stall_type_names[argument->reason], time.getFS()));
    SInt64 result = hookCallbackResult(pResult);
-   PyGILState_Release(state);
+   HooksPy::releaseGIL(state);
    check_and_abort();
    return result;
 }
 
-static SInt64 hookCallbackThreadResumeType(UInt64 pFunc, UInt64 _argument)
+static SInt64 hookCallbackThreadResumeType(UInt64 _callable, UInt64 _argument)
 {
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
    HooksManager::ThreadResume* argument = (HooksManager::ThreadResume*)_argument;
    SubsecondTime time(argument->time);
-   PyGILState_STATE state = PyGILState_Ensure();
-   PyObject *pResult = HooksPy::callPythonFunction((PyObject *)pFunc, Py_BuildValue("(iiL)", argument->thread_id, argument->thread_by, time.getFS()));
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(iiL)", argument->thread_id, argument->thread_by, time.getFS()));
    SInt64 result = hookCallbackResult(pResult);
-   PyGILState_Release(state);
+   HooksPy::releaseGIL(state);
    check_and_abort();
    return result;
 }
 
-static SInt64 hookCallbackThreadMigrateType(UInt64 pFunc, UInt64 _argument)
+static SInt64 hookCallbackThreadMigrateType(UInt64 _callable, UInt64 _argument)
 {
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
    HooksManager::ThreadMigrate* argument = (HooksManager::ThreadMigrate*)_argument;
    SubsecondTime time(argument->time);
-   PyGILState_STATE state = PyGILState_Ensure();
-   PyObject *pResult = HooksPy::callPythonFunction((PyObject *)pFunc, Py_BuildValue("(iiL)", argument->thread_id, argument->core_id, time.getFS()));
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(iiL)", argument->thread_id, argument->core_id, time.getFS()));
    SInt64 result = hookCallbackResult(pResult);
-   PyGILState_Release(state);
+   HooksPy::releaseGIL(state);
    check_and_abort();
    return result;
 }
 
-static SInt64 hookCallbackSyscallEnter(UInt64 pFunc, UInt64 _argument)
+static SInt64 hookCallbackSyscallEnter(UInt64 _callable, UInt64 _argument)
 {
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
    SyscallMdl::HookSyscallEnter* argument = (SyscallMdl::HookSyscallEnter*)_argument;
    SubsecondTime time(argument->time);
-   PyGILState_STATE state = PyGILState_Ensure();
-   PyObject *pResult = HooksPy::callPythonFunction((PyObject *)pFunc, Py_BuildValue("(iiLi(llllll))", argument->thread_id, argument->core_id, time.getFS(),
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(iiLi(llllll))", argument->thread_id, argument->core_id, time.getFS(),
       argument->syscall_number, argument->args.arg0, argument->args.arg1, argument->args.arg2, argument->args.arg3, argument->args.arg4, argument->args.arg5));
    SInt64 result = hookCallbackResult(pResult);
-   PyGILState_Release(state);
+   HooksPy::releaseGIL(state);
    check_and_abort();
    return result;
 }
 
-static SInt64 hookCallbackSyscallExit(UInt64 pFunc, UInt64 _argument)
+static SInt64 hookCallbackSyscallExit(UInt64 _callable, UInt64 _argument)
 {
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
    SyscallMdl::HookSyscallExit* argument = (SyscallMdl::HookSyscallExit*)_argument;
    SubsecondTime time(argument->time);
-   PyGILState_STATE state = PyGILState_Ensure();
-   PyObject *pResult = HooksPy::callPythonFunction((PyObject *)pFunc, Py_BuildValue("(iiLiO)", argument->thread_id, argument->core_id, time.getFS(),
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(iiLiO)", argument->thread_id, argument->core_id, time.getFS(),
       argument->ret_val, argument->emulated ? Py_True : Py_False));
    SInt64 result = hookCallbackResult(pResult);
-   PyGILState_Release(state);
+   HooksPy::releaseGIL(state);
    check_and_abort();
    return result;
 }
@@ -189,7 +204,7 @@ static SInt64 hookCallbackSyscallExit(UInt64 pFunc, UInt64 _argument)
  * - Handles Python reference counting and error checking
  *
  * Parameters:
- *   pFunc (UInt64): Pointer to the Python callback function (cast from PyObject*)
+ *   _callable (UInt64): Pointer to the Python callback function (cast from HooksPy::Callable*)
  *   argument (UInt64): Pointer to BranchPrediction struct containing:
  *     - ip: Instruction pointer where branch occurred
  *     - predicted: Branch predictor's guess (true/false)
@@ -199,9 +214,10 @@ static SInt64 hookCallbackSyscallExit(UInt64 pFunc, UInt64 _argument)
  * Returns:
  *   SInt64: 0 on success, -1 on Python error
  */
-static SInt64 hookCallbackBranchPredict(UInt64 pFunc, UInt64 argument)
+static SInt64 hookCallbackBranchPredict(UInt64 _callable, UInt64 argument)
 {
-    PyGILState_STATE state = PyGILState_Ensure();  // Acquire the Python GIL
+    HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
+    HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);  // Acquire the Python GIL
     
     HooksManager::BranchPrediction* info = (HooksManager::BranchPrediction*)argument;
     
@@ -217,27 +233,113 @@ static SInt64 hookCallbackBranchPredict(UInt64 pFunc, UInt64 argument)
     // Check if argument building failed, print error and cleanup if so
     if (args == NULL) {
         PyErr_Print();
-        PyGILState_Release(state);
+        HooksPy::releaseGIL(state);
         return -1;
     }
     
     // Call the Python function
-    PyObject* ret = PyObject_CallObject((PyObject*)pFunc, args);
+    PyObject* ret = PyObject_CallObject(callable->func, args);
     Py_DECREF(args);
     
     // Check if Python function call failed, print error and cleanup if so
     if (ret == NULL) {
         PyErr_Print();
-        PyGILState_Release(state);
+        HooksPy::releaseGIL(state);
         return -1;
     }
     
     // Cleanup Python objects and release GIL before returning success
     Py_DECREF(ret);
-    PyGILState_Release(state);
+    HooksPy::releaseGIL(state);
     return 0;
 }
 
+/*
+ * Callback for batched branch prediction events
+ *
+ * Calls the Python function as func(core_id, records), where records is a read-only memoryview over
+ * count HooksManager::BranchPrediction structs (16 bytes each, see sim.util.EveryBranchBatch for the layout).
+ * The underlying memory is reused for the next batch, so the view is released after the callback returns;
+ * scripts that want to keep the data must copy it.
+ */
+static SInt64 hookCallbackBranchPredictBatch(UInt64 _callable, UInt64 _argument)
+{
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
+   HooksManager::BranchPredictionBatch* batch = (HooksManager::BranchPredictionBatch*)_argument;
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pView = PyMemoryView_FromMemory((char*)batch->records, batch->count * sizeof(HooksManager::BranchPrediction), PyBUF_READ);
+   if (pView == NULL) {
+      PyErr_Print();
+      HooksPy::releaseGIL(state);
+      return -1;
+   }
+   Py_INCREF(pView);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(iN)", batch->core_id, pView));
+   SInt64 result = hookCallbackResult(pResult);
+   // Invalidate the view, this fails with BufferError if the script still holds an export (e.g. numpy.frombuffer)
+   PyObject *pRelease = PyObject_CallMethod(pView, "release", NULL);
+   if (pRelease == NULL)
+      PyErr_Clear();
+   else
+      Py_DECREF(pRelease);
+   Py_DECREF(pView);
+   HooksPy::releaseGIL(state);
+   check_and_abort();
+   return result;
+}
+
+/*
+ * Callback for batched memory access samples
+ *
+ * Calls the Python function as func(core_id, records), where records is a read-only memoryview over
+ * count HooksManager::MemorySample structs (32 bytes each, see sim.util.EveryMemorySampleBatch for the layout).
+ * As for branch batches, the view is released after the callback returns.
+ */
+static SInt64 hookCallbackMemorySampleBatch(UInt64 _callable, UInt64 _argument)
+{
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
+   HooksManager::MemorySampleBatch* batch = (HooksManager::MemorySampleBatch*)_argument;
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pView = PyMemoryView_FromMemory((char*)batch->records, batch->count * sizeof(HooksManager::MemorySample), PyBUF_READ);
+   if (pView == NULL) {
+      PyErr_Print();
+      HooksPy::releaseGIL(state);
+      return -1;
+   }
+   Py_INCREF(pView);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(iN)", batch->core_id, pView));
+   SInt64 result = hookCallbackResult(pResult);
+   PyObject *pRelease = PyObject_CallMethod(pView, "release", NULL);
+   if (pRelease == NULL)
+      PyErr_Clear();
+   else
+      Py_DECREF(pRelease);
+   Py_DECREF(pView);
+   HooksPy::releaseGIL(state);
+   check_and_abort();
+   return result;
+}
+
+/*
+ * Callback for core state changes
+ *
+ * Calls the Python function as func(core_id, old_state, new_state, time). Callbacks for a subset of cores
+ * are registered with HooksManager per core, so scripts only interested in a few cores never get called
+ * (nor take the GIL) for the others.
+ */
+static SInt64 hookCallbackCoreStateChange(UInt64 _callable, UInt64 _argument)
+{
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
+   HooksManager::CoreStateChange* argument = (HooksManager::CoreStateChange*)_argument;
+   SubsecondTime time(argument->time);
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(iiiL)", argument->core_id, argument->old_state, argument->new_state, time.getFS()));
+   SInt64 result = hookCallbackResult(pResult);
+   HooksPy::releaseGIL(state);
+   check_and_abort();
+   return result;
+}
+
 static PyObject *
 registerHook(PyObject *self, PyObject *args)
 {
@@ -256,12 +358,12 @@ registerHook(PyObject *self, PyObject *args)
       return NULL;
    }
 
-   Py_INCREF(pFunc);
+   HooksPy::Callable *callable = HooksPy::makeCallable(pFunc);
 
    HookType::hook_type_t type = HookType::hook_type_t(hook);
    switch(type) {
       case HookType::HOOK_PERIODIC:
-         Sim()->getHooksManager()->registerHook(type, hookCallbackSubsecondTime, (UInt64)pFunc);
+         Sim()->getHooksManager()->registerHook(type, hookCallbackSubsecondTime, (UInt64)callable);
          break;
       case HookType::HOOK_SIM_START:
       case HookType::HOOK_SIM_END:
@@ -270,7 +372,7 @@ registerHook(PyObject *self, PyObject *args)
       case HookType::HOOK_APPLICATION_ROI_BEGIN:
       case HookType::HOOK_APPLICATION_ROI_END:
       case HookType::HOOK_SIGUSR1:
-         Sim()->getHooksManager()->registerHook(type, hookCallbackNone, (UInt64)pFunc);
+         Sim()->getHooksManager()->registerHook(type, hookCallbackNone, (UInt64)callable);
          break;
       case HookType::HOOK_PERIODIC_INS:
       case HookType::HOOK_CPUFREQ_CHANGE:
@@ -278,39 +380,48 @@ registerHook(PyObject *self, PyObject *args)
       case HookType::HOOK_INSTRUMENT_MODE:
       case HookType::HOOK_APPLICATION_START:
       case HookType::HOOK_APPLICATION_EXIT:
-         Sim()->getHooksManager()->registerHook(type, hookCallbackInt, (UInt64)pFunc);
+         Sim()->getHooksManager()->registerHook(type, hookCallbackInt, (UInt64)callable);
          break;
       case HookType::HOOK_PRE_STAT_WRITE:
-         Sim()->getHooksManager()->registerHook(type, hookCallbackString, (UInt64)pFunc);
+         Sim()->getHooksManager()->registerHook(type, hookCallbackString, (UInt64)callable);
          break;
       case HookType::HOOK_MAGIC_MARKER:
       case HookType::HOOK_MAGIC_USER:
-         Sim()->getHooksManager()->registerHook(type, hookCallbackMagicMarkerType, (UInt64)pFunc);
+         Sim()->getHooksManager()->registerHook(type, hookCallbackMagicMarkerType, (UInt64)callable);
          break;
       case HookType::HOOK_THREAD_CREATE:
-         Sim()->getHooksManager()->registerHook(type, hookCallbackThreadCreateType, (UInt64)pFunc);
+         Sim()->getHooksManager()->registerHook(type, hookCallbackThreadCreateType, (UInt64)callable);
          break;
       case HookType::HOOK_THREAD_START:
       case HookType::HOOK_THREAD_EXIT:
-         Sim()->getHooksManager()->registerHook(type, hookCallbackThreadTimeType, (UInt64)pFunc);
+         Sim()->getHooksManager()->registerHook(type, hookCallbackThreadTimeType, (UInt64)callable);
          break;
       case HookType::HOOK_THREAD_STALL:
-         Sim()->getHooksManager()->registerHook(type, hookCallbackThreadStallType, (UInt64)pFunc);
+         Sim()->getHooksManager()->registerHook(type, hookCallbackThreadStallType, (UInt64)callable);
          break;
       case HookType::HOOK_THREAD_RESUME:
-         Sim()->getHooksManager()->registerHook(type, hookCallbackThreadResumeType, (UInt64)pFunc);
+         Sim()->getHooksManager()->registerHook(type, hookCallbackThreadResumeType, (UInt64)callable);
          break;
       case HookType::HOOK_THREAD_MIGRATE:
-         Sim()->getHooksManager()->registerHook(type, hookCallbackThreadMigrateType, (UInt64)pFunc);
+         Sim()->getHooksManager()->registerHook(type, hookCallbackThreadMigrateType, (UInt64)callable);
          break;
       case HookType::HOOK_SYSCALL_ENTER:
-         Sim()->getHooksManager()->registerHook(type, hookCallbackSyscallEnter, (UInt64)pFunc);
+         Sim()->getHooksManager()->registerHook(type, hookCallbackSyscallEnter, (UInt64)callable);
          break;
       case HookType::HOOK_SYSCALL_EXIT:
-         Sim()->getHooksManager()->registerHook(type, hookCallbackSyscallExit, (UInt64)pFunc);
+         Sim()->getHooksManager()->registerHook(type, hookCallbackSyscallExit, (UInt64)callable);
          break;
       case HookType::HOOK_BRANCH_PREDICT: // PaulRosu@ULBS
-         Sim()->getHooksManager()->registerHook(type, hookCallbackBranchPredict, (UInt64)pFunc);
+         Sim()->getHooksManager()->registerHook(type, hookCallbackBranchPredict, (UInt64)callable);
+         break;
+      case HookType::HOOK_BRANCH_PREDICT_BATCH:
+         Sim()->getHooksManager()->registerHook(type, hookCallbackBranchPredictBatch, (UInt64)callable);
+         break;
+      case HookType::HOOK_CORE_STATE_CHANGE:
+         Sim()->getHooksManager()->registerHook(type, hookCallbackCoreStateChange, (UInt64)callable);
+         break;
+      case HookType::HOOK_MEMORY_SAMPLE_BATCH:
+         Sim()->getHooksManager()->registerHook(type, hookCallbackMemorySampleBatch, (UInt64)callable);
          break;
       case HookType::HOOK_TYPES_MAX:
          assert(0);
@@ -319,6 +430,45 @@ registerHook(PyObject *self, PyObject *args)
    Py_RETURN_NONE;
 }
 
+static PyObject *
+registerCoreStateChange(PyObject *self, PyObject *args)
+{
+   PyObject *pFunc = NULL, *pCores = NULL;
+
+   if (!PyArg_ParseTuple(args, "OO", &pFunc, &pCores))
+      return NULL;
+
+   if (!PyCallable_Check(pFunc)) {
+      PyErr_SetString(PyExc_TypeError, "First argument must be callable");
+      return NULL;
+   }
+
+   PyObject *pSeq = PySequence_Fast(pCores, "Second argument must be a sequence of core ids");
+   if (!pSeq)
+      return NULL;
+
+   long num_cores = Sim()->getConfig()->getApplicationCores();
+   std::vector<bool> cores(num_cores, false);
+   for(Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(pSeq); ++i) {
+      long core_id = PyLong_AsLong(PySequence_Fast_GET_ITEM(pSeq, i));
+      if (core_id < 0 || core_id >= num_cores) {
+         Py_DECREF(pSeq);
+         if (!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "Invalid core ID");
+         return NULL;
+      }
+      cores[core_id] = true;
+   }
+   Py_DECREF(pSeq);
+
+   HooksPy::Callable *callable = HooksPy::makeCallable(pFunc);
+   for(core_id_t core_id = 0; core_id < num_cores; ++core_id)
+      if (cores[core_id])
+         Sim()->getHooksManager()->registerHook(HookType::HOOK_CORE_STATE_CHANGE, hookCallbackCoreStateChange, (UInt64)callable, HooksManager::ORDER_NOTIFY_PRE, core_id);
+
+   Py_RETURN_NONE;
+}
+
 static PyObject *
 triggerHookMagicUser(PyObject *self, PyObject *args)
 {
@@ -332,24 +482,102 @@ triggerHookMagicUser(PyObject *self, PyObject *args)
    return PyLong_FromLong(res);
 }
 
+static PyObject *
+registerHookAsync(PyObject *self, PyObject *args)
+{
+   int hook = -1;
+   PyObject *pFunc = NULL;
+
+   if (!PyArg_ParseTuple(args, "lO", &hook, &pFunc))
+      return NULL;
+
+   if (hook < 0 || hook >= HookType::HOOK_TYPES_MAX) {
+      PyErr_SetString(PyExc_ValueError, "Hook type out of range");
+      return NULL;
+   }
+   if (!HooksPyAsync::isSupported(HookType::hook_type_t(hook))) {
+      PyErr_SetString(PyExc_ValueError, "Hook type cannot be called asynchronously");
+      return NULL;
+   }
+   if (!PyCallable_Check(pFunc)) {
+      PyErr_SetString(PyExc_TypeError, "Second argument must be callable");
+      return NULL;
+   }
+
+   HooksPyAsync::registerHook(HookType::hook_type_t(hook), HooksPy::makeCallable(pFunc));
+
+   Py_RETURN_NONE;
+}
+
+// Native timers: the GIL is taken once for all Python timers of the same interpreter that are due at the same barrier
+static thread_local HooksPy::GILState timerGILState;
+
+static void timerBatchPython(UInt64 interp, bool enter)
+{
+   if (enter) {
+      timerGILState = HooksPy::ensureGIL((PyInterpreterState *)interp);
+   } else {
+      HooksPy::releaseGIL(timerGILState);
+      check_and_abort();
+   }
+}
+
+static UInt64 timerCallbackPython(UInt64 _callable, UInt64 now)
+{
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(L)", now));
+   // The callback returns when it wants to be called next, anything else stops the timer
+   UInt64 next = HooksManager::TIMER_STOP;
+   if (pResult && PyLong_Check(pResult)) {
+      long long when = PyLong_AsLongLong(pResult);
+      if (when >= 0)
+         next = when;
+   }
+   Py_XDECREF(pResult);
+   if (next == HooksManager::TIMER_STOP) {
+      Py_DECREF(callable->func);
+      delete callable;
+   }
+   return next;
+}
+
+static PyObject *
+scheduleTimer(PyObject *self, PyObject *args)
+{
+   long long when = 0;
+   PyObject *pFunc = NULL;
+   int instructions = 0;
+
+   if (!PyArg_ParseTuple(args, "LO|i", &when, &pFunc, &instructions))
+      return NULL;
+
+   if (when < 0) {
+      PyErr_SetString(PyExc_ValueError, "Timer due time cannot be negative");
+      return NULL;
+   }
+   if (!PyCallable_Check(pFunc)) {
+      PyErr_SetString(PyExc_TypeError, "Second argument must be callable");
+      return NULL;
+   }
+
+   HooksPy::Callable *callable = HooksPy::makeCallable(pFunc);
+   Sim()->getHooksManager()->scheduleTimer(instructions ? HooksManager::TIMER_INSTRUCTIONS : HooksManager::TIMER_TIME,
+      when, timerCallbackPython, (UInt64)callable, timerBatchPython, (UInt64)callable->interp);
+
+   Py_RETURN_NONE;
+}
+
 static PyMethodDef PyHooksMethods[] = {
    {"register",  registerHook, METH_VARARGS, "Register callback function to a Sniper hook."},
+   {"register_async",  registerHookAsync, METH_VARARGS, "Register callback function to a notification-only Sniper hook, to be called from a separate thread."},
+   {"schedule", scheduleTimer, METH_VARARGS, "Call a function once a time (in fs), or global instruction count, has been reached. It returns when to be called next, or None to stop."},
+   {"register_core_state_change", registerCoreStateChange, METH_VARARGS, "Register callback function to HOOK_CORE_STATE_CHANGE for a subset of cores."},
    {"trigger_magic_user", triggerHookMagicUser, METH_VARARGS, "Trigger HOOK_MAGIC_USER hook."},
    {NULL, NULL, 0, NULL} /* Sentinel */
 };
 
-static PyModuleDef PyHooksModule = {
-	PyModuleDef_HEAD_INIT,
-	"sim_hooks",
-	"",
-	-1,
-	PyHooksMethods,
-	NULL, NULL, NULL, NULL
-};
-
-PyMODINIT_FUNC PyInit_sim_hooks(void)
+static int PyHooksExec(PyObject *pModule)
 {
-   PyObject *pModule = PyModule_Create(&PyHooksModule);
    PyObject *pHooks = PyDict_New();
    PyObject_SetAttrString(pModule, "hooks", pHooks);
 
@@ -360,5 +588,36 @@ PyMODINIT_FUNC PyInit_sim_hooks(void)
       Py_DECREF(pGlobalConst);
    }
    Py_DECREF(pHooks);
-   return pModule;
+
+   PyObject *pAsync = PyList_New(0);
+   for(int i = 0; i < int(HookType::HOOK_TYPES_MAX); ++i) {
+      if (HooksPyAsync::isSupported(HookType::hook_type_t(i))) {
+         PyObject *pName = PyUnicode_FromString(HookType::hook_type_names[i]);
+         PyList_Append(pAsync, pName);
+         Py_DECREF(pName);
+      }
+   }
+   PyObject_SetAttrString(pModule, "async_hooks", pAsync);
+   Py_DECREF(pAsync);
+   return 0;
+}
+
+static PyModuleDef_Slot PyHooksSlots[] = {
+   {Py_mod_exec, (void *)PyHooksExec},
+   HOOKS_PY_MODULE_SLOTS
+   {0, NULL}
+};
+
+static PyModuleDef PyHooksModule = {
+	PyModuleDef_HEAD_INIT,
+	"sim_hooks",
+	"",
+	0,
+	PyHooksMethods,
+	PyHooksSlots, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_sim_hooks(void)
+{
+   return PyModuleDef_Init(&PyHooksModule);
 }
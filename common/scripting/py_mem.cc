@@ -59,16 +59,21 @@ static PyMethodDef PyMemMethods[] = {
    { NULL, NULL, 0, NULL } /* Sentinel */
 };
 
+static PyModuleDef_Slot PyMemSlots[] = {
+   HOOKS_PY_MODULE_SLOTS
+   {0, NULL}
+};
+
 static PyModuleDef PyMemModule = {
 	PyModuleDef_HEAD_INIT,
 	"sim_mem",
 	"",
-	-1,
+	0,
 	PyMemMethods,
-	NULL, NULL, NULL, NULL
+	PyMemSlots, NULL, NULL, NULL
 };
 
 PyMODINIT_FUNC PyInit_sim_mem(void)
 {
-   return PyModule_Create(&PyMemModule);
+   return PyModuleDef_Init(&PyMemModule);
 }
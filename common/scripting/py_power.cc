@@ -0,0 +1,189 @@
+#include "hooks_py.h"
+#include "simulator.h"
+#include "energy_model.h"
+#include "stats.h"
+
+
+//////////
+// set_component(): define the energy model of a component
+//   (name, index, core_id (-1: not in a core's DVFS domain), static power in W,
+//    [ (objectName, index, metricName, energy per event in J), ... ])
+//////////
+
+static PyObject *
+setComponent(PyObject *self, PyObject *args)
+{
+   const char *name = NULL;
+   long int index = -1, core_id = -1;
+   double static_power = 0;
+   PyObject *pTerms = NULL;
+
+   if (!PyArg_ParseTuple(args, "slldO", &name, &index, &core_id, &static_power, &pTerms))
+      return NULL;
+
+   PyObject *pSeq = PySequence_Fast(pTerms, "Expected a sequence of (objectName, index, metricName, energy) terms");
+   if (!pSeq)
+      return NULL;
+
+   std::vector<EnergyModel::Term> terms;
+   for(Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(pSeq); ++i) {
+      const char *objectName = NULL, *metricName = NULL;
+      long int metricIndex = -1;
+      double energy = 0;
+
+      if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(pSeq, i), "slsd", &objectName, &metricIndex, &metricName, &energy)) {
+         Py_DECREF(pSeq);
+         return NULL;
+      }
+
+      StatsMetricBase *metric = Sim()->getStatsManager()->getMetricObject(objectName, metricIndex, metricName);
+      if (!metric) {
+         Py_DECREF(pSeq);
+         PyErr_Format(PyExc_ValueError, "Stats metric %s[%ld].%s not found", objectName, metricIndex, metricName);
+         return NULL;
+      }
+
+      EnergyModel::Term term = { metric, energy };
+      terms.push_back(term);
+   }
+   Py_DECREF(pSeq);
+
+   if (core_id >= (long int)Sim()->getConfig()->getApplicationCores()) {
+      PyErr_SetString(PyExc_ValueError, "Invalid core ID");
+      return NULL;
+   }
+
+   Sim()->getEnergyModel()->setComponent(name, index, core_id < 0 ? INVALID_CORE_ID : core_id, static_power, terms);
+
+   Py_RETURN_NONE;
+}
+
+
+//////////
+// set_vdd_table(): [ (frequency in MHz, Vdd in V), ... ] from high to low frequency
+//////////
+
+static PyObject *
+setVddTable(PyObject *self, PyObject *args)
+{
+   PyObject *pTable = NULL;
+
+   if (!PyArg_ParseTuple(args, "O", &pTable))
+      return NULL;
+
+   PyObject *pSeq = PySequence_Fast(pTable, "Expected a sequence of (frequency, vdd) pairs");
+   if (!pSeq)
+      return NULL;
+
+   std::vector<std::pair<UInt64, double> > table;
+   for(Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(pSeq); ++i) {
+      unsigned long long freq_mhz = 0;
+      double vdd = 0;
+
+      if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(pSeq, i), "Kd", &freq_mhz, &vdd)) {
+         Py_DECREF(pSeq);
+         return NULL;
+      }
+      table.push_back(std::pair<UInt64, double>(freq_mhz, vdd));
+   }
+   Py_DECREF(pSeq);
+
+   Sim()->getEnergyModel()->setVddTable(table);
+
+   Py_RETURN_NONE;
+}
+
+
+//////////
+// update(): integrate energy up to the current time
+//////////
+
+static PyObject *
+update(PyObject *self, PyObject *args)
+{
+   Sim()->getEnergyModel()->update();
+
+   Py_RETURN_NONE;
+}
+
+
+//////////
+// get_energy(): (static, dynamic) energy of a component so far, in J
+// get_power(): (static, dynamic) average power of a component over the last update period, in W
+//////////
+
+static PyObject *
+getEnergy(PyObject *self, PyObject *args)
+{
+   const char *name = NULL;
+   long int index = -1;
+
+   if (!PyArg_ParseTuple(args, "sl", &name, &index))
+      return NULL;
+
+   UInt64 energy_static, energy_dynamic;
+   if (!Sim()->getEnergyModel()->getEnergy(name, index, energy_static, energy_dynamic)) {
+      PyErr_SetString(PyExc_ValueError, "Energy model component not found");
+      return NULL;
+   }
+
+   return Py_BuildValue("(dd)", energy_static * 1e-15, energy_dynamic * 1e-15);
+}
+
+static PyObject *
+getPower(PyObject *self, PyObject *args)
+{
+   const char *name = NULL;
+   long int index = -1;
+
+   if (!PyArg_ParseTuple(args, "sl", &name, &index))
+      return NULL;
+
+   double power_static, power_dynamic;
+   if (!Sim()->getEnergyModel()->getPower(name, index, power_static, power_dynamic)) {
+      PyErr_SetString(PyExc_ValueError, "Energy model component not found");
+      return NULL;
+   }
+
+   return Py_BuildValue("(dd)", power_static, power_dynamic);
+}
+
+
+//////////
+// module definition
+//////////
+
+static PyMethodDef PyPowerMethods[] = {
+   {"set_component", setComponent, METH_VARARGS, "Define the energy model of a component (name, index, core_id, static_power, [(objectName, index, metricName, energy), ...])."},
+   {"set_vdd_table", setVddTable, METH_VARARGS, "Set the (frequency in MHz, Vdd) table used to scale energy with DVFS."},
+   {"update", update, METH_NOARGS, "Integrate energy up to the current time."},
+   {"get_energy", getEnergy, METH_VARARGS, "Get the (static, dynamic) energy of a component (name, index), in J."},
+   {"get_power", getPower, METH_VARARGS, "Get the (static, dynamic) power of a component (name, index) over the last update period, in W."},
+   {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+static int PyPowerExec(PyObject *pModule)
+{
+
+   return 0;
+}
+
+static PyModuleDef_Slot PyPowerSlots[] = {
+   {Py_mod_exec, (void *)PyPowerExec},
+   HOOKS_PY_MODULE_SLOTS
+   {0, NULL}
+};
+
+static PyModuleDef PyPowerModule = {
+	PyModuleDef_HEAD_INIT,
+	"sim_power",
+	"",
+	0,
+	PyPowerMethods,
+	PyPowerSlots, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_sim_power(void)
+{
+   return PyModuleDef_Init(&PyPowerModule);
+}
@@ -0,0 +1,267 @@
+#include "hooks_py.h"
+#include "simulator.h"
+#include "qos_manager.h"
+#include "config.hpp"
+
+
+static QosManager * getQos()
+{
+   QosManager *qos = Sim()->getQosManager();
+   if (!qos)
+      PyErr_SetString(PyExc_RuntimeError, "QoS is not enabled (perf_model/qos/enabled)");
+   return qos;
+}
+
+static bool checkCore(long int core_id)
+{
+   if (core_id < 0 || core_id >= (long int)Sim()->getConfig()->getApplicationCores()) {
+      PyErr_SetString(PyExc_ValueError, "Invalid core ID");
+      return false;
+   }
+   return true;
+}
+
+static bool checkClass(QosManager *qos, long int clos)
+{
+   if (clos < 0 || clos >= (long int)qos->getNumClasses()) {
+      PyErr_SetString(PyExc_ValueError, "Invalid class of service");
+      return false;
+   }
+   return true;
+}
+
+
+//////////
+// Allocation: classes of service, way masks (CAT) and bandwidth limits (MBA)
+//////////
+
+static PyObject *
+getNumClasses(PyObject *self, PyObject *args)
+{
+   QosManager *qos = getQos();
+   if (!qos)
+      return NULL;
+
+   return PyLong_FromLong(qos->getNumClasses());
+}
+
+static PyObject *
+getClass(PyObject *self, PyObject *args)
+{
+   long int core_id = -1;
+
+   if (!PyArg_ParseTuple(args, "l", &core_id))
+      return NULL;
+
+   QosManager *qos = getQos();
+   if (!qos || !checkCore(core_id))
+      return NULL;
+
+   return PyLong_FromLong(qos->getClass(core_id));
+}
+
+static PyObject *
+setClass(PyObject *self, PyObject *args)
+{
+   long int core_id = -1, clos = -1;
+
+   if (!PyArg_ParseTuple(args, "ll", &core_id, &clos))
+      return NULL;
+
+   QosManager *qos = getQos();
+   if (!qos || !checkCore(core_id) || !checkClass(qos, clos))
+      return NULL;
+
+   qos->setClass(core_id, clos);
+
+   Py_RETURN_NONE;
+}
+
+static PyObject *
+getWayMask(PyObject *self, PyObject *args)
+{
+   long int clos = -1;
+
+   if (!PyArg_ParseTuple(args, "l", &clos))
+      return NULL;
+
+   QosManager *qos = getQos();
+   if (!qos || !checkClass(qos, clos))
+      return NULL;
+
+   return PyLong_FromUnsignedLongLong(qos->getWayMask(clos));
+}
+
+static PyObject *
+setWayMask(PyObject *self, PyObject *args)
+{
+   long int clos = -1;
+   unsigned long long way_mask = 0;
+
+   if (!PyArg_ParseTuple(args, "lK", &clos, &way_mask))
+      return NULL;
+
+   QosManager *qos = getQos();
+   if (!qos || !checkClass(qos, clos))
+      return NULL;
+
+   UInt64 shifted = way_mask ? way_mask >> __builtin_ctzll(way_mask) : 0;
+   if (shifted & (shifted + 1)) {
+      PyErr_SetString(PyExc_ValueError, "Way mask must be contiguous");
+      return NULL;
+   }
+
+   qos->setWayMask(clos, way_mask);
+
+   Py_RETURN_NONE;
+}
+
+static PyObject *
+getBandwidth(PyObject *self, PyObject *args)
+{
+   long int clos = -1;
+
+   if (!PyArg_ParseTuple(args, "l", &clos))
+      return NULL;
+
+   QosManager *qos = getQos();
+   if (!qos || !checkClass(qos, clos))
+      return NULL;
+
+   return PyFloat_FromDouble(qos->getBandwidth(clos));
+}
+
+static PyObject *
+setBandwidth(PyObject *self, PyObject *args)
+{
+   long int clos = -1;
+   double bandwidth = 0;
+
+   if (!PyArg_ParseTuple(args, "ld", &clos, &bandwidth))
+      return NULL;
+
+   QosManager *qos = getQos();
+   if (!qos || !checkClass(qos, clos))
+      return NULL;
+
+   if (bandwidth < 0) {
+      PyErr_SetString(PyExc_ValueError, "Bandwidth limit cannot be negative");
+      return NULL;
+   }
+
+   qos->setBandwidth(clos, bandwidth);
+
+   Py_RETURN_NONE;
+}
+
+
+//////////
+// Monitoring: last-level cache occupancy (CMT) and memory traffic (MBM), in bytes, per core
+//////////
+
+static PyObject *
+getOccupancy(PyObject *self, PyObject *args)
+{
+   long int core_id = -1;
+
+   if (!PyArg_ParseTuple(args, "l", &core_id))
+      return NULL;
+
+   QosManager *qos = getQos();
+   if (!qos || !checkCore(core_id))
+      return NULL;
+
+   return PyLong_FromUnsignedLongLong(qos->getOccupancy(core_id) * Sim()->getCfg()->getInt("perf_model/l1_dcache/cache_block_size"));
+}
+
+static PyObject *
+getOccupancyAll(PyObject *self, PyObject *args)
+{
+   QosManager *qos = getQos();
+   if (!qos)
+      return NULL;
+
+   UInt32 num_cores = Sim()->getConfig()->getApplicationCores();
+   UInt64 block_size = Sim()->getCfg()->getInt("perf_model/l1_dcache/cache_block_size");
+   std::vector<UInt64> occupancy(num_cores);
+   for(UInt32 core_id = 0; core_id < num_cores; ++core_id)
+      occupancy[core_id] = qos->getOccupancy(core_id) * block_size;
+
+   return HooksPy::makeArray(occupancy.data(), occupancy.size());
+}
+
+static PyObject *
+getTraffic(PyObject *self, PyObject *args)
+{
+   long int core_id = -1;
+
+   if (!PyArg_ParseTuple(args, "l", &core_id))
+      return NULL;
+
+   QosManager *qos = getQos();
+   if (!qos || !checkCore(core_id))
+      return NULL;
+
+   return PyLong_FromUnsignedLongLong(qos->getMemoryBytes(core_id));
+}
+
+static PyObject *
+getTrafficAll(PyObject *self, PyObject *args)
+{
+   QosManager *qos = getQos();
+   if (!qos)
+      return NULL;
+
+   UInt32 num_cores = Sim()->getConfig()->getApplicationCores();
+   std::vector<UInt64> traffic(num_cores);
+   for(UInt32 core_id = 0; core_id < num_cores; ++core_id)
+      traffic[core_id] = qos->getMemoryBytes(core_id);
+
+   return HooksPy::makeArray(traffic.data(), traffic.size());
+}
+
+
+//////////
+// module definition
+//////////
+
+static PyMethodDef PyQosMethods[] = {
+   {"get_num_classes", getNumClasses, METH_NOARGS, "Get the number of classes of service."},
+   {"get_class", getClass, METH_VARARGS, "Get the class of service of a core."},
+   {"set_class", setClass, METH_VARARGS, "Set the class of service of a core (core, class)."},
+   {"get_way_mask", getWayMask, METH_VARARGS, "Get the last-level cache way mask of a class of service (0: all ways)."},
+   {"set_way_mask", setWayMask, METH_VARARGS, "Set the last-level cache way mask of a class of service (class, contiguous mask, 0: all ways)."},
+   {"get_bandwidth", getBandwidth, METH_VARARGS, "Get the per-core DRAM bandwidth limit of a class of service, in GB/s (0: unlimited)."},
+   {"set_bandwidth", setBandwidth, METH_VARARGS, "Set the per-core DRAM bandwidth limit of a class of service (class, GB/s, 0: unlimited)."},
+   {"get_occupancy", getOccupancy, METH_VARARGS, "Get the last-level cache occupancy of a core, in bytes."},
+   {"get_occupancy_all", getOccupancyAll, METH_NOARGS, "Get the last-level cache occupancy of all cores as an array, in bytes."},
+   {"get_traffic", getTraffic, METH_VARARGS, "Get the DRAM traffic of a core so far, in bytes."},
+   {"get_traffic_all", getTrafficAll, METH_NOARGS, "Get the DRAM traffic of all cores so far as an array, in bytes."},
+   {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+static int PyQosExec(PyObject *pModule)
+{
+
+   return 0;
+}
+
+static PyModuleDef_Slot PyQosSlots[] = {
+   {Py_mod_exec, (void *)PyQosExec},
+   HOOKS_PY_MODULE_SLOTS
+   {0, NULL}
+};
+
+static PyModuleDef PyQosModule = {
+	PyModuleDef_HEAD_INIT,
+	"sim_qos",
+	"",
+	0,
+	PyQosMethods,
+	PyQosSlots, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_sim_qos(void)
+{
+   return PyModuleDef_Init(&PyQosModule);
+}
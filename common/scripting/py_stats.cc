@@ -47,17 +47,32 @@ statsGetterGet(PyObject *self, PyObject *args, PyObject *kw)
    return PyLong_FromUnsignedLongLong(metric->recordMetric());
 }
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
-static PyTypeObject statsGetterType = {
-   .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
-   .tp_name = "statsGetter",
-   .tp_basicsize = sizeof(statsGetterObject),
-   .tp_call = statsGetterGet,
-   .tp_flags = Py_TPFLAGS_DEFAULT,
-   .tp_doc = PyDoc_STR("Stats getter objects"),
+// Heap types, created per module instance: static types cannot be shared between interpreters with their own GIL
+static PyType_Slot statsGetterSlots[] = {
+   {Py_tp_call, (void *)statsGetterGet},
+   {Py_tp_new, (void *)PyType_GenericNew},
+   {Py_tp_doc, (void *)PyDoc_STR("Stats getter objects")},
+   {0, NULL}
 };
-#pragma GCC diagnostic pop
+
+static PyType_Spec statsGetterSpec = {
+   "statsGetter",
+   sizeof(statsGetterObject),
+   0,
+   Py_TPFLAGS_DEFAULT,
+   statsGetterSlots
+};
+
+typedef struct {
+   PyTypeObject *getterType;
+   PyTypeObject *vectorGetterType;
+} statsModuleState;
+
+static statsModuleState *
+getModuleState(PyObject *pModule)
+{
+   return (statsModuleState *)PyModule_GetState(pModule);
+}
 
 static PyObject *
 getStatsGetter(PyObject *self, PyObject *args)
@@ -75,13 +90,111 @@ getStatsGetter(PyObject *self, PyObject *args)
       return NULL;
    }
 
-   statsGetterObject *pGetter = PyObject_New(statsGetterObject, &statsGetterType);
+   statsGetterObject *pGetter = PyObject_New(statsGetterObject, getModuleState(self)->getterType);
    pGetter->metric = metric;
 
    return (PyObject *)pGetter;
 }
 
 
+//////////
+// get_all() / vector_getter(): retrieve a stats value for all cores at once, as an array.array('Q')
+// vector_getter() looks up the metrics once and returns a statsVectorGetterObject that reads them when called
+//////////
+
+typedef struct {
+   PyObject_HEAD
+   StatsMetricBase **metrics; // NULL where the metric does not exist for a core, which reads as zero
+   UInt64 *values;
+   UInt32 count;
+} statsVectorGetterObject;
+
+static PyObject *
+statsVectorGetterGet(PyObject *self, PyObject *args, PyObject *kw)
+{
+   statsVectorGetterObject *getter = (statsVectorGetterObject *)self;
+   for(UInt32 i = 0; i < getter->count; ++i)
+      getter->values[i] = getter->metrics[i] ? getter->metrics[i]->recordMetric() : 0;
+   return HooksPy::makeArray(getter->values, getter->count);
+}
+
+static void
+statsVectorGetterDealloc(PyObject *self)
+{
+   statsVectorGetterObject *getter = (statsVectorGetterObject *)self;
+   delete [] getter->metrics;
+   delete [] getter->values;
+   PyTypeObject *type = Py_TYPE(self);
+   type->tp_free(self);
+   // Instances of heap types own a reference to their type
+   Py_DECREF(type);
+}
+
+static PyType_Slot statsVectorGetterSlots[] = {
+   {Py_tp_dealloc, (void *)statsVectorGetterDealloc},
+   {Py_tp_call, (void *)statsVectorGetterGet},
+   {Py_tp_new, (void *)PyType_GenericNew},
+   {Py_tp_doc, (void *)PyDoc_STR("Stats getter objects for all cores")},
+   {0, NULL}
+};
+
+static PyType_Spec statsVectorGetterSpec = {
+   "statsVectorGetter",
+   sizeof(statsVectorGetterObject),
+   0,
+   Py_TPFLAGS_DEFAULT,
+   statsVectorGetterSlots
+};
+
+static statsVectorGetterObject *
+newStatsVectorGetter(PyObject *pModule, PyObject *args)
+{
+   const char *objectName = NULL, *metricName = NULL;
+
+   if (!PyArg_ParseTuple(args, "ss", &objectName, &metricName))
+      return NULL;
+
+   UInt32 count = Sim()->getConfig()->getTotalCores();
+   StatsMetricBase **metrics = new StatsMetricBase*[count];
+   bool found = false;
+   for(UInt32 i = 0; i < count; ++i) {
+      metrics[i] = Sim()->getStatsManager()->getMetricObject(objectName, i, metricName);
+      found |= metrics[i] != NULL;
+   }
+
+   if (!found) {
+      delete [] metrics;
+      PyErr_SetString(PyExc_ValueError, "Stats metric not found");
+      return NULL;
+   }
+
+   statsVectorGetterObject *pGetter = PyObject_New(statsVectorGetterObject, getModuleState(pModule)->vectorGetterType);
+   pGetter->metrics = metrics;
+   pGetter->values = new UInt64[count];
+   pGetter->count = count;
+
+   return pGetter;
+}
+
+static PyObject *
+getStatsValues(PyObject *self, PyObject *args)
+{
+   statsVectorGetterObject *pGetter = newStatsVectorGetter(self, args);
+   if (!pGetter)
+      return NULL;
+
+   PyObject *pValues = statsVectorGetterGet((PyObject *)pGetter, NULL, NULL);
+   Py_DECREF(pGetter);
+   return pValues;
+}
+
+static PyObject *
+getStatsVectorGetter(PyObject *self, PyObject *args)
+{
+   return (PyObject *)newStatsVectorGetter(self, args);
+}
+
+
 //////////
 // write(): write the current set of statistics out to sim.stats or our own file
 //////////
@@ -104,20 +217,23 @@ writeStats(PyObject *self, PyObject *args)
 // register(): register a callback function that returns a statistics value
 //////////
 
-static UInt64 statsCallback(String objectName, UInt32 index, String metricName, UInt64 _pFunc)
+static UInt64 statsCallback(String objectName, UInt32 index, String metricName, UInt64 _callable)
 {
-   PyObject *pFunc = (PyObject*)_pFunc;
-   PyObject *pResult = HooksPy::callPythonFunction(pFunc, Py_BuildValue("(sls)", objectName.c_str(), index, metricName.c_str()));
+   HooksPy::Callable *callable = (HooksPy::Callable *)_callable;
+   HooksPy::GILState state = HooksPy::ensureGIL(callable->interp);
+   PyObject *pResult = HooksPy::callPythonFunction(callable->func, Py_BuildValue("(sls)", objectName.c_str(), index, metricName.c_str()));
 
    if (!pResult || !PyLong_Check(pResult)) {
       LOG_PRINT_WARNING("Stats callback: return value must be (convertable into) 64-bit unsigned integer");
       if (pResult)
          Py_XDECREF(pResult);
+      HooksPy::releaseGIL(state);
       return 0;
    }
 
    UInt64 val = PyLong_AsLongLong(pResult);
    Py_XDECREF(pResult);
+   HooksPy::releaseGIL(state);
 
    return val;
 }
@@ -136,9 +252,9 @@ registerStats(PyObject *self, PyObject *args)
       PyErr_SetString(PyExc_TypeError, "Fourth argument must be callable");
       return NULL;
    }
-   Py_INCREF(pFunc);
+   HooksPy::Callable *callable = HooksPy::makeCallable(pFunc);
 
-   Sim()->getStatsManager()->registerMetric(new StatsMetricCallback(objectName, index, metricName, (StatsCallback)statsCallback, (UInt64)pFunc));
+   Sim()->getStatsManager()->registerMetric(new StatsMetricCallback(objectName, index, metricName, (StatsCallback)statsCallback, (UInt64)callable));
 
    Py_RETURN_NONE;
 }
@@ -207,6 +323,8 @@ getIcount(PyObject *self, PyObject *args)
 static PyMethodDef PyStatsMethods[] = {
    {"get",  getStatsValue, METH_VARARGS, "Retrieve current value of statistic (objectName, index, metricName)."},
    {"getter", getStatsGetter, METH_VARARGS, "Return object to retrieve statistics value."},
+   {"get_all", getStatsValues, METH_VARARGS, "Retrieve current value of statistic for all cores, as an array (objectName, metricName)."},
+   {"vector_getter", getStatsVectorGetter, METH_VARARGS, "Return object to retrieve statistics value for all cores, as an array (objectName, metricName)."},
    {"write", writeStats, METH_VARARGS, "Write statistics (<prefix>, [<filename>])."},
    {"register", registerStats, METH_VARARGS, "Register callback that defines statistics value for (objectName, index, metricName)."},
    {"register_per_thread", registerPerThread, METH_VARARGS, "Add a per-thread statistic (perthreadName) based on a named statistic (objectName, metricName)."},
@@ -216,25 +334,58 @@ static PyMethodDef PyStatsMethods[] = {
    {NULL, NULL, 0, NULL} /* Sentinel */
 };
 
+static int PyStatsExec(PyObject *pModule)
+{
+   statsModuleState *state = getModuleState(pModule);
+
+   state->getterType = (PyTypeObject *)PyType_FromSpec(&statsGetterSpec);
+   if (!state->getterType)
+      return -1;
+
+   Py_INCREF(state->getterType);
+   PyModule_AddObject(pModule, "Getter", (PyObject *)state->getterType);
+
+   state->vectorGetterType = (PyTypeObject *)PyType_FromSpec(&statsVectorGetterSpec);
+   if (!state->vectorGetterType)
+      return -1;
+
+   Py_INCREF(state->vectorGetterType);
+   PyModule_AddObject(pModule, "VectorGetter", (PyObject *)state->vectorGetterType);
+   return 0;
+}
+
+static int PyStatsTraverse(PyObject *pModule, visitproc visit, void *arg)
+{
+   statsModuleState *state = getModuleState(pModule);
+   Py_VISIT(state->getterType);
+   Py_VISIT(state->vectorGetterType);
+   return 0;
+}
+
+static int PyStatsClear(PyObject *pModule)
+{
+   statsModuleState *state = getModuleState(pModule);
+   Py_CLEAR(state->getterType);
+   Py_CLEAR(state->vectorGetterType);
+   return 0;
+}
+
+static PyModuleDef_Slot PyStatsSlots[] = {
+   {Py_mod_exec, (void *)PyStatsExec},
+   HOOKS_PY_MODULE_SLOTS
+   {0, NULL}
+};
+
 static PyModuleDef PyStatsModule = {
 	PyModuleDef_HEAD_INIT,
 	"sim_stats",
 	"",
-	-1,
+	sizeof(statsModuleState),
 	PyStatsMethods,
-	NULL, NULL, NULL, NULL
+	PyStatsSlots, PyStatsTraverse, PyStatsClear, NULL
 };
 
 PyMODINIT_FUNC PyInit_sim_stats(void)
 {
-   PyObject *pModule = PyModule_Create(&PyStatsModule);
-
-   statsGetterType.tp_new = PyType_GenericNew;
-   if (PyType_Ready(&statsGetterType) < 0)
-      return NULL;
-
-   Py_INCREF(&statsGetterType);
-   PyModule_AddObject(pModule, "Getter", (PyObject *)&statsGetterType);
-   return pModule;
+   return PyModuleDef_Init(&PyStatsModule);
 }
-
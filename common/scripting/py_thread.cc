@@ -145,16 +145,21 @@ static PyMethodDef PyThreadMethods[] = {
    { NULL, NULL, 0, NULL } /* Sentinel */
 };
 
+static PyModuleDef_Slot PyThreadSlots[] = {
+   HOOKS_PY_MODULE_SLOTS
+   {0, NULL}
+};
+
 static PyModuleDef PyThreadModule = {
 	PyModuleDef_HEAD_INIT,
 	"sim_thread",
 	"",
-	-1,
+	0,
 	PyThreadMethods,
-	NULL, NULL, NULL, NULL
+	PyThreadSlots, NULL, NULL, NULL
 };
 
 PyMODINIT_FUNC PyInit_sim_thread(void)
 {
-   return PyModule_Create(&PyThreadModule);
+   return PyModuleDef_Init(&PyThreadModule);
 }
@@ -50,5 +50,15 @@ BarrierSyncClient::synchronize(SubsecondTime time, bool ignore_time, bool abort_
       m_barrier_interval = Sim()->getClockSkewMinimizationServer()->getBarrierInterval();
       // Update 'm_next_sync_time'
       m_next_sync_time = ((curr_elapsed_time / m_barrier_interval) * m_barrier_interval) + m_barrier_interval;
+
+      // With relaxed synchronization we may have been allowed to run ahead of a barrier that is not yet released,
+      // in which case we need to check back at the end of the lookahead window
+      SubsecondTime lookahead = Sim()->getClockSkewMinimizationServer()->getLookahead();
+      if (lookahead > SubsecondTime::Zero())
+      {
+         SubsecondTime deadline = Sim()->getClockSkewMinimizationServer()->getGlobalTime(true) + lookahead;
+         if (curr_elapsed_time < deadline && deadline < m_next_sync_time)
+            m_next_sync_time = deadline;
+      }
    }
 }
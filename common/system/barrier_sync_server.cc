@@ -12,6 +12,12 @@
 #include "stats.h"
 #include "config.hpp"
 #include "circular_log.h"
+#include "trace_log.h"
+#include "self_profiler.h"
+#include "trace_manager.h"
+#include "deterministic_order.h"
+#include "telemetry.h"
+#include "timer.h"
 
 #include <algorithm>
 
@@ -24,6 +30,24 @@ BarrierSyncServer::BarrierSyncServer()
    , m_global_time(SubsecondTime::Zero())
    , m_fastforward(false)
    , m_disable(false)
+   , m_relaxed(Sim()->getCfg()->getBool("clock_skew_minimization/barrier/relaxed"))
+   , m_lookahead(SubsecondTime::Zero())
+   , m_relaxed_skips(0)
+   , m_relaxed_skipped_time(SubsecondTime::Zero())
+   , m_adaptive(Sim()->getCfg()->getBool("clock_skew_minimization/barrier/adaptive/enabled"))
+   , m_min_interval(SubsecondTime::Zero())
+   , m_max_interval(SubsecondTime::Zero())
+   , m_widen_threshold(0)
+   , m_narrow_threshold(0)
+   , m_sharing_events(0)
+   , m_quanta(0)
+   , m_quanta_widened(0)
+   , m_quanta_narrowed(0)
+   , m_quantum_max_reached(SubsecondTime::Zero())
+   , m_skip_idle(Sim()->getCfg()->getBool("clock_skew_minimization/barrier/skip_idle"))
+   , m_idle_skips(0)
+   , m_idle_skipped_time(SubsecondTime::Zero())
+   , m_active_index(Sim()->getConfig()->getApplicationCores(), -1)
 {
    try
    {
@@ -45,14 +69,73 @@ BarrierSyncServer::BarrierSyncServer()
    for(core_id_t core_id = 0; core_id < (core_id_t)Sim()->getConfig()->getApplicationCores(); ++core_id)
       m_core_cond[core_id] = new ConditionVariable();
 
+   if (m_barrier_interval == SubsecondTime::MaxTime())
+      m_adaptive = false;
+   if (m_adaptive)
+   {
+      m_min_interval = SubsecondTime::NS() * Sim()->getCfg()->getInt("clock_skew_minimization/barrier/adaptive/min_quantum");
+      m_max_interval = SubsecondTime::NS() * Sim()->getCfg()->getInt("clock_skew_minimization/barrier/adaptive/max_quantum");
+      m_widen_threshold = Sim()->getCfg()->getFloat("clock_skew_minimization/barrier/adaptive/widen_threshold");
+      m_narrow_threshold = Sim()->getCfg()->getFloat("clock_skew_minimization/barrier/adaptive/narrow_threshold");
+      LOG_ASSERT_ERROR(m_min_interval > SubsecondTime::Zero() && m_min_interval <= m_max_interval,
+         "clock_skew_minimization/barrier/adaptive: need 0 < min_quantum <= max_quantum");
+      LOG_ASSERT_ERROR(m_widen_threshold <= m_narrow_threshold,
+         "clock_skew_minimization/barrier/adaptive: widen_threshold cannot be larger than narrow_threshold");
+      // Start from the configured quantum
+      m_barrier_interval = std::min(std::max(m_barrier_interval, m_min_interval), m_max_interval);
+   }
+   m_quantum_max_reached = m_barrier_interval;
+
    m_next_barrier_time = m_barrier_interval;
 
+   if (m_relaxed)
+   {
+      m_lookahead = computeLookahead();
+      // Running ahead past the next barrier as well would break the release logic
+      if (m_lookahead > m_barrier_interval)
+         m_lookahead = m_barrier_interval;
+      if (m_adaptive && m_lookahead > m_min_interval)
+         m_lookahead = m_min_interval;
+      if (m_lookahead == SubsecondTime::Zero())
+         m_relaxed = false;
+   }
+
    // Order our hooks to occur after possible reschedulings (which are done with ORDER_ACTION)
    Sim()->getHooksManager()->registerHook(HookType::HOOK_THREAD_EXIT, BarrierSyncServer::hookThreadExit, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
    Sim()->getHooksManager()->registerHook(HookType::HOOK_THREAD_STALL, BarrierSyncServer::hookThreadStall, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
    Sim()->getHooksManager()->registerHook(HookType::HOOK_THREAD_MIGRATE, BarrierSyncServer::hookThreadMigrate, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
+   // Cores are created IDLE, they join the active set once they start running
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_CORE_STATE_CHANGE, BarrierSyncServer::hookCoreStateChange, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
 
    registerStatsMetric("barrier", 0, "global_time", &m_global_time);
+   registerStatsMetric("barrier", 0, "relaxed_skips", &m_relaxed_skips);
+   registerStatsMetric("barrier", 0, "relaxed_skipped_time", &m_relaxed_skipped_time);
+   registerStatsMetric("barrier", 0, "quantum", &m_barrier_interval);
+   registerStatsMetric("barrier", 0, "quanta", &m_quanta);
+   registerStatsMetric("barrier", 0, "quanta_widened", &m_quanta_widened);
+   registerStatsMetric("barrier", 0, "quanta_narrowed", &m_quanta_narrowed);
+   registerStatsMetric("barrier", 0, "quantum_max_reached", &m_quantum_max_reached);
+   registerStatsMetric("barrier", 0, "idle_skips", &m_idle_skips);
+   registerStatsMetric("barrier", 0, "idle_skipped_time", &m_idle_skipped_time);
+}
+
+SubsecondTime
+BarrierSyncServer::computeLookahead()
+{
+   SInt64 lookahead = Sim()->getCfg()->getInt("clock_skew_minimization/barrier/lookahead");
+   if (lookahead > 0)
+      return SubsecondTime::NS() * lookahead;
+
+   // A core can only observe another core's actions through the coherence protocol, which always involves
+   // at least a directory lookup (the network, if any, only adds to this). Use the fastest core's clock
+   // to be conservative.
+   UInt64 cycles = Sim()->getCfg()->getInt("perf_model/dram_directory/directory_cache_access_time");
+   float max_frequency = 0;
+   for(core_id_t core_id = 0; core_id < (core_id_t)Sim()->getConfig()->getApplicationCores(); ++core_id)
+      max_frequency = std::max(max_frequency, (float)Sim()->getCfg()->getFloatArray("perf_model/core/frequency", core_id));
+   LOG_ASSERT_ERROR(max_frequency > 0, "Invalid core frequency");
+
+   return ComponentPeriod::fromFreqHz(max_frequency * 1000000000).getPeriod() * cycles;
 }
 
 BarrierSyncServer::~BarrierSyncServer()
@@ -64,6 +147,9 @@ BarrierSyncServer::~BarrierSyncServer()
 void
 BarrierSyncServer::synchronize(core_id_t core_id, SubsecondTime time)
 {
+   // Includes waiting for the thread manager lock
+   SELF_PROFILE(BARRIER);
+
    ScopedLock sl(Sim()->getThreadManager()->getLock());
    if (m_disable)
       return;
@@ -83,6 +169,19 @@ BarrierSyncServer::synchronize(core_id_t core_id, SubsecondTime time)
    LOG_ASSERT_ERROR(core->getState() == Core::RUNNING || core->getState() == Core::INITIALIZING, "Core(%i) is not running or initializing at time(%s)", core_id, itostr(time).c_str());
    LOG_ASSERT_ERROR(m_barrier_acquire_list[master_core_id] == false, "Core(%i) or its sibling is already in the barrier (this is thread %d, we have thread %d)", master_core_id, thread_me, m_core_thread[master_core_id]);
 
+   if (m_relaxed && !m_fastforward && time >= m_next_barrier_time && time < m_next_barrier_time + m_lookahead)
+   {
+      // Within the lookahead window nobody can observe us being ahead, so record our progress and keep going.
+      // BarrierSyncClient will come back at the end of the window if the barrier has not been released by then.
+      ++m_relaxed_skips;
+      m_relaxed_skipped_time += time - m_next_barrier_time;
+      m_local_clock_list[master_core_id] = time;
+      CLOG("barrier", "Core %d relaxed exit", core_id);
+      // We may have been the last one the barrier was waiting for
+      signal();
+      return;
+   }
+
    if (time < m_next_barrier_time && !m_fastforward)
    {
       LOG_PRINT("Sent 'SIM_BARRIER_RELEASE' immediately time(%s), m_next_barrier_time(%s)", itostr(time).c_str(), itostr(m_next_barrier_time).c_str());
@@ -99,13 +198,30 @@ BarrierSyncServer::synchronize(core_id_t core_id, SubsecondTime time)
    m_local_clock_list[master_core_id] = time;
    m_barrier_acquire_list[master_core_id] = true;
    m_core_thread[master_core_id] = thread_me;
+   // The master of an SMT group can be idle while one of its siblings enters
+   updateActive(master_core_id);
+
+   // While we wait, other cores can interact up to the barrier without waiting for us
+   if (DeterministicOrder *order = Sim()->getDeterministicOrder())
+      order->threadIdle(thread_me);
 
    bool mustWait = true;
    if (isBarrierReached())
       mustWait = barrierRelease(thread_me);
 
    if (mustWait)
-      m_core_cond[master_core_id]->wait(Sim()->getThreadManager()->getLock());
+   {
+      UInt64 t_start = Telemetry::isEnabled() ? Timer::now() : 0;
+      if (m_relaxed)
+      {
+         while (m_barrier_acquire_list[master_core_id])
+            m_release_generation.wait(Sim()->getThreadManager()->getLock());
+      }
+      else
+         m_core_cond[master_core_id]->wait(Sim()->getThreadManager()->getLock());
+      if (t_start)
+         Telemetry::addBarrierWaitTime(Timer::now() - t_start);
+   }
    else
       master_core->getPerformanceModel()->barrierExit();
 
@@ -139,11 +255,43 @@ BarrierSyncServer::threadMigrate(HooksManager::ThreadMigrate *argument)
    // Migration because of pre-emption is done only inside periodic(), we'll return into barrierRelease()
 }
 
+void
+BarrierSyncServer::coreStateChange(HooksManager::CoreStateChange *argument)
+{
+   if ((size_t)argument->core_id < m_active_index.size())
+      updateActive(argument->core_id);
+}
+
+void
+BarrierSyncServer::updateActive(core_id_t core_id)
+{
+   Core::State state = Sim()->getCoreManager()->getCoreFromID(core_id)->getState();
+   bool active = (state != Core::SLEEPING && state != Core::IDLE) || m_barrier_acquire_list[core_id];
+   SInt32 index = m_active_index[core_id];
+
+   if (active && index < 0)
+   {
+      m_active_index[core_id] = m_active.size();
+      m_active.push_back(core_id);
+   }
+   else if (!active && index >= 0)
+   {
+      // Move the last one into our place
+      core_id_t last = m_active.back();
+      m_active[index] = last;
+      m_active_index[last] = index;
+      m_active.pop_back();
+      m_active_index[core_id] = -1;
+   }
+}
+
 void
 BarrierSyncServer::releaseThread(thread_id_t thread_id)
 {
-   for(core_id_t core_id = 0; core_id < (core_id_t) Sim()->getConfig()->getApplicationCores(); core_id++)
+   // Cores in the barrier are always in the active set
+   for(std::vector<core_id_t>::iterator it = m_active.begin(); it != m_active.end(); ++it)
    {
+      core_id_t core_id = *it;
       if (m_barrier_acquire_list[core_id] && m_core_thread[core_id] == thread_id)
       {
          // Make sure thread is released on next barrierRelease()
@@ -204,8 +352,10 @@ BarrierSyncServer::isBarrierReached()
 
    // Check if all cores have reached the barrier
    // All least one core must have (sync_time > m_next_barrier_time)
-   for (core_id_t core_id = 0; core_id < (core_id_t) Sim()->getConfig()->getApplicationCores(); core_id++)
+   // Quiescent cores are neither running nor in the barrier, so only the active ones need to be checked
+   for (std::vector<core_id_t>::iterator it = m_active.begin(); it != m_active.end(); ++it)
    {
+      core_id_t core_id = *it;
       // In fastforward mode, it's enough that a core is waiting. In detailed mode, it needs to have advanced up to the predefined barrier time
       if (m_fastforward)
       {
@@ -214,20 +364,17 @@ BarrierSyncServer::isBarrierReached()
             // At least one core has reached the barrier
             single_core_barrier_reached = true;
          }
-         else if (isCoreRunning(core_id))
+         else if (isCoreRunning(core_id, false))
          {
             // Core is running but hasn't checked in yet. Wait for it to sync.
             return false;
          }
       }
-      else if (m_core_group[core_id] != INVALID_CORE_ID)
+      else if (isCoreRunning(core_id, false))
       {
-         // Only consider group masters
-         continue;
-      }
-      else if (isCoreRunning(core_id))
-      {
-         if (m_local_clock_list[core_id] < m_next_barrier_time)
+         // A running group member is represented by its master
+         core_id_t master_core_id = m_core_group[core_id] == INVALID_CORE_ID ? core_id : m_core_group[core_id];
+         if (m_local_clock_list[master_core_id] < m_next_barrier_time)
          {
             // Core running on this core has not reached the barrier
             // Wait for it to sync
@@ -276,6 +423,7 @@ BarrierSyncServer::barrierRelease(thread_id_t caller_id, bool continue_until_rel
    {
       m_global_time = m_next_barrier_time;
       CLOG("barrier", "Barrier %" PRId64 "ns", m_next_barrier_time.getNS());
+      TRACE(SYNC, INFO, "Barrier %" PRId64 "ns", m_next_barrier_time.getNS());
       Sim()->getHooksManager()->callHooks(HookType::HOOK_PERIODIC, static_cast<subsecond_time_t>(m_next_barrier_time).m_time);
 
       if (continue_until_release)
@@ -291,11 +439,19 @@ BarrierSyncServer::barrierRelease(thread_id_t caller_id, bool continue_until_rel
       if (m_disable)
          return false;
 
+      if (m_adaptive && !m_fastforward)
+         adaptInterval();
+      // Nobody is running (we would have returned above otherwise), skip over quanta in which nothing can happen
+      if (continue_until_release && m_skip_idle && !m_fastforward)
+         skipIdle();
+
       m_next_barrier_time += m_barrier_interval;
       LOG_PRINT("m_next_barrier_time updated to (%s)", itostr(m_next_barrier_time).c_str());
 
-      for (core_id_t core_id = 0; core_id < (core_id_t) Sim()->getConfig()->getApplicationCores(); core_id++)
+      // Backwards, so cores that leave the active set once released are swapped out behind us
+      for (SInt32 idx = (SInt32)m_active.size() - 1; idx >= 0; --idx)
       {
+         core_id_t core_id = m_active[idx];
          if (m_local_clock_list[core_id] < m_next_barrier_time)
          {
             // Check if this core was running. If yes, release that core
@@ -306,6 +462,8 @@ BarrierSyncServer::barrierRelease(thread_id_t caller_id, bool continue_until_rel
 
                m_barrier_acquire_list[core_id] = false;
                core_resumed = true;
+               releaseDeterministic(core_id);
+               updateActive(core_id);
 
                if (m_core_thread[core_id] == caller_id)
                   must_wait = false;
@@ -323,17 +481,88 @@ BarrierSyncServer::barrierRelease(thread_id_t caller_id, bool continue_until_rel
    // To avoid overwhelming the OS scheduler, we only release N threads at a time (N ~= host cores).
    // Once a thread is done (stops executing because it completed the next barrier quantum, or due to thread stall),
    // one more thread is released so we always have at most N running threads.
+   // Trace threads running on a fiber pool are bounded by its workers already, so release them all as one phase.
+   // In deterministic mode, released cores already hold back the others, so they all need to run.
    std::shuffle(m_to_release.begin(), m_to_release.end(), generator);
-   doRelease(m_fastforward ? -1 : Sim()->getConfig()->getNumHostCores());
+   bool pooled = Sim()->getTraceManager() && Sim()->getTraceManager()->getFiberPool();
+   doRelease(m_fastforward || pooled || Sim()->getDeterministicOrder() ? -1 : Sim()->getConfig()->getNumHostCores());
 
    return must_wait;
 }
 
+void
+BarrierSyncServer::skipIdle()
+{
+   // Unscheduled threads are placed by the scheduler from HOOK_PERIODIC, we cannot know when
+   if (Sim()->getThreadManager()->anyThreadStalled(ThreadManager::STALL_UNSCHEDULED))
+      return;
+
+   SubsecondTime wakeup = Sim()->getSyscallServer()->getNextTimeout(m_global_time);
+   UInt64 timer = Sim()->getHooksManager()->getNextTimerTime();
+   if (timer != HooksManager::TIMER_STOP)
+      wakeup = std::min(wakeup, SubsecondTime::FS(timer));
+
+   // The wakeup happens at the first barrier at or after its time, make that the next one
+   SubsecondTime next = m_next_barrier_time + m_barrier_interval;
+   if (wakeup <= next)
+      return;
+   UInt64 quanta = (wakeup - next).getFS() / m_barrier_interval.getFS();
+   if ((wakeup - next).getFS() % m_barrier_interval.getFS())
+      ++quanta;
+   SubsecondTime skip = m_barrier_interval * quanta;
+
+   ++m_idle_skips;
+   m_idle_skipped_time += skip;
+   m_next_barrier_time += skip;
+   CLOG("barrier", "Idle skip %" PRId64 "ns to %" PRId64 "ns", skip.getNS(), (m_next_barrier_time + m_barrier_interval).getNS());
+}
+
+void
+BarrierSyncServer::adaptInterval()
+{
+   // Sharing during the quantum that just ended, normalized so that wider quanta are not penalized for being wider
+   UInt64 events = __sync_lock_test_and_set(&m_sharing_events, 0);
+   double rate = events / (m_barrier_interval.getFS() * 1e-9) / Sim()->getConfig()->getApplicationCores();
+
+   ++m_quanta;
+   SubsecondTime interval = m_barrier_interval;
+   if (rate > m_narrow_threshold && interval > m_min_interval)
+   {
+      // Communication is back, be accurate again right away
+      interval = m_min_interval;
+      ++m_quanta_narrowed;
+   }
+   else if (rate < m_widen_threshold && interval < m_max_interval)
+   {
+      interval = std::min(interval * 2, m_max_interval);
+      ++m_quanta_widened;
+   }
+
+   if (interval != m_barrier_interval)
+   {
+      CLOG("barrier", "Quantum %" PRId64 "ns > %" PRId64 "ns (%.3f sharing events per core per us)", m_barrier_interval.getNS(), interval.getNS(), rate);
+      m_barrier_interval = interval;
+      m_quantum_max_reached = std::max(m_quantum_max_reached, interval);
+   }
+}
+
 void
 BarrierSyncServer::doRelease(int n)
 {
    // Release up to n threads from the list.
    // When n == -1, all threads are released
+   if (m_relaxed)
+   {
+      // Released cores have already cleared their m_barrier_acquire_list entry,
+      // wake them all with one generation update rather than signaling them one by one
+      if (m_to_release.size())
+      {
+         m_to_release.clear();
+         m_release_generation.advance();
+      }
+      return;
+   }
+
    while(m_to_release.size() && n--)
    {
       core_id_t core_id = m_to_release.back();
@@ -342,22 +571,39 @@ BarrierSyncServer::doRelease(int n)
    }
 }
 
+void
+BarrierSyncServer::releaseDeterministic(core_id_t core_id)
+{
+   // Publish the time of a released core before anyone can run, its clock may have been reset by releaseThread()
+   if (DeterministicOrder *order = Sim()->getDeterministicOrder())
+      order->threadRunning(m_core_thread[core_id], std::max(m_local_clock_list[core_id], m_global_time));
+}
+
 void
 BarrierSyncServer::abortBarrier()
 {
    CLOG("barrier", "Abort");
-   for(core_id_t core_id = 0; core_id < (core_id_t) Sim()->getConfig()->getApplicationCores(); core_id++)
+   bool released = false;
+   for (SInt32 idx = (SInt32)m_active.size() - 1; idx >= 0; --idx)
    {
+      core_id_t core_id = m_active[idx];
       // Check if this core was running. If yes, release that core
       if (m_barrier_acquire_list[core_id] == true)
       {
          m_barrier_acquire_list[core_id] = false;
+         releaseDeterministic(core_id);
+         updateActive(core_id);
 
          Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
          core->getPerformanceModel()->barrierExit();
-         m_core_cond[core_id]->signal();
+         if (m_relaxed)
+            released = true;
+         else
+            m_core_cond[core_id]->signal();
       }
    }
+   if (released)
+      m_release_generation.advance();
 }
 
 void
@@ -389,6 +635,16 @@ BarrierSyncServer::setFastForward(bool fastforward, SubsecondTime next_barrier_t
    }
 }
 
+void
+BarrierSyncServer::restoreTime(SubsecondTime time)
+{
+   // The checkpoint was taken at the barrier at <time>, continue towards the next one
+   m_global_time = time;
+   m_next_barrier_time = m_barrier_interval == SubsecondTime::MaxTime() ? m_barrier_interval : time + m_barrier_interval;
+   for(core_id_t core_id = 0; core_id < (core_id_t) Sim()->getConfig()->getApplicationCores(); core_id++)
+      m_local_clock_list[core_id] = time;
+}
+
 void
 BarrierSyncServer::printState(void)
 {
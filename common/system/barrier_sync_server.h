@@ -3,6 +3,7 @@
 
 #include "fixed_types.h"
 #include "cond.h"
+#include "generation_counter.h"
 #include "hooks_manager.h"
 
 #include <vector>
@@ -25,6 +26,39 @@ class BarrierSyncServer : public ClockSkewMinimizationServer
       bool m_fastforward;
       volatile bool m_disable;
 
+      // Relaxed mode: cores may run up to m_lookahead past the barrier without waiting,
+      // waiting cores are all released at once through a single generation counter
+      bool m_relaxed;
+      SubsecondTime m_lookahead;
+      GenerationCounter m_release_generation;
+      UInt64 m_relaxed_skips;
+      SubsecondTime m_relaxed_skipped_time;
+
+      // Adaptive mode: the quantum doubles after quanta with little sharing (per core per microsecond) and drops back
+      // to the minimum as soon as sharing goes up, always staying within [min_quantum, max_quantum]
+      bool m_adaptive;
+      SubsecondTime m_min_interval, m_max_interval;
+      double m_widen_threshold, m_narrow_threshold;
+      UInt64 m_sharing_events;
+      UInt64 m_quanta, m_quanta_widened, m_quanta_narrowed;
+      SubsecondTime m_quantum_max_reached;
+
+      // When no thread is running, jump straight to the barrier at which the earliest timed wakeup (sleep, futex timeout,
+      // native timer) is due rather than going through every quantum in between
+      bool m_skip_idle;
+      UInt64 m_idle_skips;
+      SubsecondTime m_idle_skipped_time;
+
+      // Cores that are SLEEPING or IDLE cannot hold up a barrier, only the others (and quiescent cores still waiting
+      // in the barrier, until they are released) are visited, so the cost of a barrier scales with the active cores
+      std::vector<core_id_t> m_active;
+      std::vector<SInt32> m_active_index;    // Position in m_active, -1 when the core is quiescent
+
+      SubsecondTime computeLookahead();
+      void updateActive(core_id_t core_id);
+      void adaptInterval();
+      void skipIdle();
+
       bool isBarrierReached(void);
       bool barrierRelease(thread_id_t thread_id = INVALID_THREAD_ID, bool continue_until_release = false);
       void abortBarrier(void);
@@ -32,6 +66,7 @@ class BarrierSyncServer : public ClockSkewMinimizationServer
       void releaseThread(thread_id_t thread_id);
       void signal();
       void doRelease(int n);
+      void releaseDeterministic(core_id_t core_id);
 
       static SInt64 hookThreadExit(UInt64 object, UInt64 argument) {
          ((BarrierSyncServer*)object)->threadExit((HooksManager::ThreadTime*)argument); return 0;
@@ -42,9 +77,13 @@ class BarrierSyncServer : public ClockSkewMinimizationServer
       static SInt64 hookThreadMigrate(UInt64 object, UInt64 argument) {
          ((BarrierSyncServer*)object)->threadMigrate((HooksManager::ThreadMigrate*)argument); return 0;
       }
+      static SInt64 hookCoreStateChange(UInt64 object, UInt64 argument) {
+         ((BarrierSyncServer*)object)->coreStateChange((HooksManager::CoreStateChange*)argument); return 0;
+      }
       void threadExit(HooksManager::ThreadTime *argument);
       void threadStall(HooksManager::ThreadStall *argument);
       void threadMigrate(HooksManager::ThreadMigrate *argument);
+      void coreStateChange(HooksManager::CoreStateChange *argument);
       std::default_random_engine generator;
 
    public:
@@ -60,6 +99,9 @@ class BarrierSyncServer : public ClockSkewMinimizationServer
       SubsecondTime getGlobalTime(bool upper_bound = false) { return m_barrier_interval == SubsecondTime::MaxTime() ? m_global_time : (upper_bound ? m_next_barrier_time : m_global_time); }
       void setBarrierInterval(SubsecondTime barrier_interval) { m_barrier_interval = barrier_interval; }
       SubsecondTime getBarrierInterval() const { return m_barrier_interval; }
+      void restoreTime(SubsecondTime time);
+      SubsecondTime getLookahead() const { return m_relaxed ? m_lookahead : SubsecondTime::Zero(); }
+      void notifySharing() { if (m_adaptive) __sync_fetch_and_add(&m_sharing_events, 1); }
 
       void printState(void);
 };
@@ -0,0 +1,68 @@
+#include "cache_efficiency_tracker.h"
+#include "simulator.h"
+#include "config.h"
+#include "hooks_manager.h"
+#include "log.h"
+
+namespace CacheEfficiencyTracker
+{
+
+static UInt64 roundUpPowerOfTwo(UInt64 value)
+{
+   UInt64 result = 1;
+   while (result < value)
+      result <<= 1;
+   return result;
+}
+
+Batch::Batch(const Callbacks &callbacks, UInt32 size)
+   : m_callbacks(callbacks)
+   , m_size(roundUpPowerOfTwo(size))
+   , m_num_rings(Sim()->getConfig()->getTotalCores())
+{
+   LOG_ASSERT_ERROR(size > 0, "Cache efficiency batches need at least one entry");
+
+   m_rings = new Ring[m_num_rings];
+   for(UInt32 i = 0; i < m_num_rings; ++i)
+   {
+      m_rings[i].head = 0;
+      m_rings[i].tail = 0;
+      m_rings[i].records = new Record[m_size];
+   }
+
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, hookDrain, (UInt64)this);
+   // Complete the ROI's records before the trackers look at the ROI-end usage walk, and before they write their results
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_END, hookDrain, (UInt64)this, HooksManager::ORDER_NOTIFY_PRE);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_SIM_END, hookDrain, (UInt64)this, HooksManager::ORDER_NOTIFY_PRE);
+}
+
+Batch::~Batch()
+{
+   for(UInt32 i = 0; i < m_num_rings; ++i)
+      delete [] m_rings[i].records;
+   delete [] m_rings;
+}
+
+void Batch::drain()
+{
+   for(UInt32 i = 0; i < m_num_rings; ++i)
+      drainRing(m_rings[i]);
+}
+
+void Batch::drainRing(Ring &ring)
+{
+   ScopedLock sl(ring.lock);
+
+   UInt64 head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+   for(UInt64 tail = ring.tail; tail != head; ++tail)
+   {
+      const Record &record = ring.records[tail & (m_size - 1)];
+      if (record.evict)
+         m_callbacks.call_notify_evict(false, record.owner, record.evictor, record.bits_used, record.bits_total);
+      else
+         m_callbacks.call_notify_access(record.owner, record.mem_op_type, record.hit_where);
+   }
+   __atomic_store_n(&ring.tail, head, __ATOMIC_RELEASE);
+}
+
+}
@@ -4,6 +4,7 @@
 #include "cache_block_info.h"
 #include "hit_where.h"
 #include "core.h"
+#include "lock.h"
 
 namespace CacheEfficiencyTracker
 {
@@ -11,21 +12,117 @@ namespace CacheEfficiencyTracker
    typedef void (*CallbackNotifyAccess)(UInt64 user, UInt64 owner, Core::mem_op_t mem_op_type, HitWhere::where_t hit_where);
    typedef void (*CallbackNotifyEvict)(UInt64 user, bool on_roi_end, UInt64 owner, UInt64 evictor, CacheBlockInfo::BitsUsedType bits_used, UInt32 bits_total);
 
+   class Batch;
+
    struct Callbacks
    {
       CacheEfficiencyTracker::CallbackGetOwner get_owner_func;
       CacheEfficiencyTracker::CallbackNotifyAccess notify_access_func;
       CacheEfficiencyTracker::CallbackNotifyEvict notify_evict_func;
       UInt64 user_arg;
+      Batch *batch;
 
-      Callbacks() : get_owner_func(NULL), notify_access_func(NULL), notify_evict_func(NULL), user_arg(0) {}
+      Callbacks() : get_owner_func(NULL), notify_access_func(NULL), notify_evict_func(NULL), user_arg(0), batch(NULL) {}
 
       UInt64 call_get_owner(core_id_t core_id, UInt64 address) const { return get_owner_func(user_arg, core_id, address); }
       void call_notify_access(UInt64 owner, Core::mem_op_t mem_op_type, HitWhere::where_t hit_where) const
       { notify_access_func(user_arg, owner, mem_op_type, hit_where); }
       void call_notify_evict(bool on_roi_end, UInt64 owner, UInt64 evictor, CacheBlockInfo::BitsUsedType bits_used, UInt32 bits_total) const
       { notify_evict_func(user_arg, on_roi_end, owner, evictor, bits_used, bits_total); }
+
+      // Used by the cache controllers: delivered right away, or through core_id's ring when batching is enabled
+      inline void notify_access(core_id_t core_id, UInt64 owner, Core::mem_op_t mem_op_type, HitWhere::where_t hit_where) const;
+      inline void notify_evict(core_id_t core_id, UInt64 owner, UInt64 evictor, CacheBlockInfo::BitsUsedType bits_used, UInt32 bits_total) const;
+   };
+
+   // Per-core rings of access and eviction records ([routine_tracer] cache_efficiency_batch), so the cache controllers
+   // only append a record while holding their locks. Rings are drained into the tracker's callbacks at every barrier
+   // (HOOK_PERIODIC), at the end of the ROI and of the simulation, or by the producer itself when its ring is full.
+   // Each ring has a single producer, the thread simulating that core, and needs no locking on push.
+   class Batch
+   {
+      public:
+         Batch(const Callbacks &callbacks, UInt32 size);
+         ~Batch();
+
+         void pushAccess(core_id_t core_id, UInt64 owner, Core::mem_op_t mem_op_type, HitWhere::where_t hit_where)
+         {
+            Record *record = reserve(core_id);
+            record->evict = false;
+            record->owner = owner;
+            record->mem_op_type = mem_op_type;
+            record->hit_where = hit_where;
+            commit(core_id);
+         }
+         void pushEvict(core_id_t core_id, UInt64 owner, UInt64 evictor, CacheBlockInfo::BitsUsedType bits_used, UInt32 bits_total)
+         {
+            Record *record = reserve(core_id);
+            record->evict = true;
+            record->owner = owner;
+            record->evictor = evictor;
+            record->bits_used = bits_used;
+            record->bits_total = bits_total;
+            commit(core_id);
+         }
+         bool hasRing(core_id_t core_id) const { return core_id >= 0 && (UInt32)core_id < m_num_rings; }
+
+         // Deliver all pending records
+         void drain();
+
+      private:
+         struct Record
+         {
+            UInt64 owner;
+            UInt64 evictor;
+            UInt32 bits_total;
+            Core::mem_op_t mem_op_type;
+            HitWhere::where_t hit_where;
+            CacheBlockInfo::BitsUsedType bits_used;
+            bool evict;
+         };
+         struct Ring
+         {
+            UInt64 head;         // Written by the producer only
+            UInt64 tail;         // Written while holding lock only
+            Lock lock;           // Serializes consumers
+            Record *records;
+         } __attribute__((aligned(64)));
+
+         const Callbacks &m_callbacks;
+         const UInt64 m_size;    // Power of two
+         const UInt32 m_num_rings;
+         Ring *m_rings;
+
+         Record* reserve(core_id_t core_id)
+         {
+            Ring &ring = m_rings[core_id];
+            if (ring.head - __atomic_load_n(&ring.tail, __ATOMIC_ACQUIRE) == m_size)
+               drainRing(ring);
+            return &ring.records[ring.head & (m_size - 1)];
+         }
+         void commit(core_id_t core_id)
+         {
+            __atomic_store_n(&m_rings[core_id].head, m_rings[core_id].head + 1, __ATOMIC_RELEASE);
+         }
+         void drainRing(Ring &ring);
+
+         static SInt64 hookDrain(UInt64 arg, UInt64 val) { ((Batch*)arg)->drain(); return 0; }
    };
+
+   void Callbacks::notify_access(core_id_t core_id, UInt64 owner, Core::mem_op_t mem_op_type, HitWhere::where_t hit_where) const
+   {
+      if (batch && batch->hasRing(core_id))
+         batch->pushAccess(core_id, owner, mem_op_type, hit_where);
+      else
+         call_notify_access(owner, mem_op_type, hit_where);
+   }
+   void Callbacks::notify_evict(core_id_t core_id, UInt64 owner, UInt64 evictor, CacheBlockInfo::BitsUsedType bits_used, UInt32 bits_total) const
+   {
+      if (batch && batch->hasRing(core_id))
+         batch->pushEvict(core_id, owner, evictor, bits_used, bits_total);
+      else
+         call_notify_evict(false, owner, evictor, bits_used, bits_total);
+   }
 };
 
 #endif // __CACHE_EFFICIENCY_TRACKER_H
@@ -0,0 +1,147 @@
+#include "checkpoint.h"
+#include "log.h"
+
+#include <cstring>
+
+static const UInt32 CHECKPOINT_MAGIC = 0x4b434e53; // "SNCK"
+static const UInt32 CHECKPOINT_VERSION = 2;
+
+CheckpointWriter::CheckpointWriter(String filename)
+   : m_filename(filename)
+{
+   m_fp = fopen(filename.c_str(), "wb");
+   LOG_ASSERT_ERROR(m_fp != NULL, "Cannot open checkpoint file %s for writing", filename.c_str());
+
+   put(CHECKPOINT_MAGIC);
+   put(CHECKPOINT_VERSION);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+   LOG_ASSERT_ERROR(m_sections.empty(), "Checkpoint section not closed");
+   fclose(m_fp);
+}
+
+void CheckpointWriter::beginSection(const char *name)
+{
+   UInt32 length = strlen(name);
+   put(length);
+   write(name, length);
+
+   // Reserve room for the section length, filled in by endSection()
+   m_sections.push_back(ftell(m_fp));
+   put(UInt64(0));
+}
+
+void CheckpointWriter::endSection()
+{
+   LOG_ASSERT_ERROR(!m_sections.empty(), "No open checkpoint section");
+
+   long start = m_sections.back();
+   m_sections.pop_back();
+
+   long end = ftell(m_fp);
+   UInt64 length = end - start - sizeof(UInt64);
+   fseek(m_fp, start, SEEK_SET);
+   put(length);
+   fseek(m_fp, end, SEEK_SET);
+}
+
+void CheckpointWriter::write(const void *data, size_t size)
+{
+   size_t written = fwrite(data, 1, size, m_fp);
+   LOG_ASSERT_ERROR(written == size, "Error writing checkpoint %s", m_filename.c_str());
+}
+
+void CheckpointWriter::put(const std::vector<bool> &values)
+{
+   put<UInt64>(values.size());
+   for(std::vector<bool>::const_iterator it = values.begin(); it != values.end(); ++it)
+      put<UInt8>(*it);
+}
+
+void CheckpointWriter::put(const String &value)
+{
+   put<UInt32>(value.size());
+   write(value.data(), value.size());
+}
+
+
+CheckpointReader::CheckpointReader(String filename)
+   : m_filename(filename)
+{
+   m_fp = fopen(filename.c_str(), "rb");
+   LOG_ASSERT_ERROR(m_fp != NULL, "Cannot open checkpoint file %s", filename.c_str());
+
+   UInt32 magic, version;
+   get(magic);
+   get(version);
+   LOG_ASSERT_ERROR(magic == CHECKPOINT_MAGIC, "%s is not a checkpoint file", filename.c_str());
+   LOG_ASSERT_ERROR(version == CHECKPOINT_VERSION, "Checkpoint %s has unsupported version %d", filename.c_str(), version);
+}
+
+CheckpointReader::~CheckpointReader()
+{
+   fclose(m_fp);
+}
+
+void CheckpointReader::beginSection(const char *name)
+{
+   UInt32 length;
+   get(length);
+   std::vector<char> section(length + 1, '\0');
+   read(section.data(), length);
+   LOG_ASSERT_ERROR(strcmp(section.data(), name) == 0, "Checkpoint %s: expected section %s, found %s", m_filename.c_str(), name, section.data());
+
+   UInt64 size;
+   get(size);
+   m_sections.push_back(ftell(m_fp) + size);
+}
+
+void CheckpointReader::endSection()
+{
+   LOG_ASSERT_ERROR(!m_sections.empty(), "No open checkpoint section");
+
+   // Skip whatever the component did not read
+   fseek(m_fp, m_sections.back(), SEEK_SET);
+   m_sections.pop_back();
+}
+
+bool CheckpointReader::more()
+{
+   return !m_sections.empty() && ftell(m_fp) < m_sections.back();
+}
+
+void CheckpointReader::read(void *data, size_t size)
+{
+   LOG_ASSERT_ERROR(m_sections.empty() || ftell(m_fp) + long(size) <= m_sections.back(), "Checkpoint %s: read past the end of a section", m_filename.c_str());
+   size_t count = fread(data, 1, size, m_fp);
+   LOG_ASSERT_ERROR(count == size, "Checkpoint %s is truncated", m_filename.c_str());
+}
+
+void CheckpointReader::get(std::vector<bool> &values)
+{
+   checkSize(values.size());
+   for(size_t i = 0; i < values.size(); ++i)
+   {
+      UInt8 value;
+      get(value);
+      values[i] = value;
+   }
+}
+
+void CheckpointReader::get(String &value)
+{
+   UInt32 length;
+   get(length);
+   std::vector<char> data(length);
+   read(data.data(), length);
+   value = String(data.data(), length);
+}
+
+void CheckpointReader::checkSize(UInt64 size)
+{
+   UInt64 saved;
+   get(saved);
+   LOG_ASSERT_ERROR(saved == size, "Checkpoint %s does not match the current configuration (table of %ld entries, expected %ld)", m_filename.c_str(), saved, size);
+}
@@ -0,0 +1,95 @@
+#ifndef __CHECKPOINT_H
+#define __CHECKPOINT_H
+
+#include "fixed_types.h"
+#include "cache_state.h"
+
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+
+// Binary checkpoint files of warmed microarchitectural state (see CheckpointManager).
+// A checkpoint is a sequence of named, length-prefixed sections. Components write their state in a section
+// and read it back in the same order; when a component saved nothing (or a restore stops reading early),
+// the rest of the section is skipped. State is only valid for the configuration it was saved with,
+// table geometries are checked on restore.
+
+class CheckpointWriter
+{
+   public:
+      CheckpointWriter(String filename);
+      ~CheckpointWriter();
+
+      void beginSection(const char *name);
+      void endSection();
+
+      void write(const void *data, size_t size);
+      template <typename T> void put(const T &value)
+      {
+         static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be checkpointed directly");
+         write(&value, sizeof(T));
+      }
+      template <typename T> void put(const std::vector<T> &values)
+      {
+         put<UInt64>(values.size());
+         if constexpr (std::is_trivially_copyable<T>::value)
+            write(values.data(), values.size() * sizeof(T));
+         else
+            for(typename std::vector<T>::const_iterator it = values.begin(); it != values.end(); ++it)
+               put(*it);
+      }
+      void put(const std::vector<bool> &values);
+      void put(const String &value);
+
+   private:
+      FILE *m_fp;
+      String m_filename;
+      std::vector<long> m_sections; // File offsets of the length fields of all open sections
+};
+
+class CheckpointReader
+{
+   public:
+      CheckpointReader(String filename);
+      ~CheckpointReader();
+
+      void beginSection(const char *name);
+      void endSection();
+      // Whether unread data remains in the current section
+      bool more();
+
+      void read(void *data, size_t size);
+      template <typename T> void get(T &value)
+      {
+         static_assert(std::is_trivially_copyable<T>::value, "Only plain data can be checkpointed directly");
+         read(&value, sizeof(T));
+      }
+      // Vectors must already have the size they were saved with
+      template <typename T> void get(std::vector<T> &values)
+      {
+         checkSize(values.size());
+         if constexpr (std::is_trivially_copyable<T>::value)
+            read(values.data(), values.size() * sizeof(T));
+         else
+            for(typename std::vector<T>::iterator it = values.begin(); it != values.end(); ++it)
+               get(*it);
+      }
+      void get(std::vector<bool> &values);
+      void get(String &value);
+
+   private:
+      FILE *m_fp;
+      String m_filename;
+      std::vector<long> m_sections; // File offsets of the end of all open sections
+
+      void checkSize(UInt64 size);
+};
+
+// A cache line as recorded in a checkpoint, used to rebuild cache contents by replaying accesses
+struct CheckpointLine
+{
+   IntPtr address;
+   CacheState::cstate_t cstate;
+};
+
+#endif // __CHECKPOINT_H
@@ -0,0 +1,420 @@
+#include "checkpoint_manager.h"
+#include "checkpoint.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "memory_manager_base.h"
+#include "performance_model.h"
+#include "branch_predictor.h"
+#include "hooks_manager.h"
+#include "magic_server.h"
+#include "trace_manager.h"
+#include "clock_skew_minimization_object.h"
+#include "stats.h"
+#include "config.hpp"
+#include "itostr.h"
+
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+
+CheckpointManager* CheckpointManager::create()
+{
+   String save_file = Sim()->getCfg()->getString("checkpoint/save");
+   String restore_file = Sim()->getCfg()->getString("checkpoint/restore");
+   String resume_save_dir = Sim()->getCfg()->getString("checkpoint/resume_save");
+   String resume_dir = Sim()->getCfg()->getString("checkpoint/resume");
+
+   if (save_file == "" && restore_file == "" && resume_save_dir == "" && resume_dir == "")
+      return NULL;
+   else
+      return new CheckpointManager(save_file, restore_file, resume_save_dir, resume_dir);
+}
+
+CheckpointManager::CheckpointManager(String save_file, String restore_file, String resume_save_dir, String resume_dir)
+   : m_save_file(save_file)
+   , m_restore_file(restore_file)
+   , m_save_icount(Sim()->getCfg()->getInt("checkpoint/save_icount"))
+   , m_save_marker(Sim()->getCfg()->getInt("checkpoint/save_marker"))
+   , m_save_pending(false)
+   , m_saved(false)
+   , m_resume_save_dir(resume_save_dir)
+   , m_resume_interval(Sim()->getCfg()->getInt("checkpoint/resume_interval"))
+   , m_resume_threads(Sim()->getCfg()->getInt("checkpoint/resume_threads"))
+   , m_resume_seq(0)
+   , m_resume_last(time(NULL))
+{
+   if (m_save_file != "")
+   {
+      LOG_ASSERT_ERROR(m_save_icount > 0 || m_save_marker >= 0, "checkpoint/save is set but neither checkpoint/save_icount nor checkpoint/save_marker is");
+
+      if (m_save_icount > 0)
+         Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC_INS, CheckpointManager::hook_periodic_ins, (UInt64)this);
+      if (m_save_marker >= 0)
+         Sim()->getHooksManager()->registerHook(HookType::HOOK_MAGIC_MARKER, CheckpointManager::hook_magic_marker, (UInt64)this);
+   }
+
+   if (m_resume_save_dir != "" || resume_dir != "")
+   {
+      // Threads are restarted from their position in the trace, which needs offline traces
+      // and a barrier at which no core has run ahead
+      LOG_ASSERT_ERROR(Sim()->getConfig()->getSimulationMode() == Config::STANDALONE && Sim()->getCfg()->getBool("traceinput/enabled"),
+         "Resume checkpoints are only supported in trace-driven simulation");
+      LOG_ASSERT_ERROR(!Sim()->getCfg()->getBool("traceinput/emulate_syscalls"),
+         "Resume checkpoints need recorded traces, they cannot be used with a live SIFT recorder");
+      LOG_ASSERT_ERROR(Sim()->getConfig()->getClockSkewMinimizationScheme() == ClockSkewMinimizationObject::BARRIER
+                       && !Sim()->getCfg()->getBool("clock_skew_minimization/barrier/relaxed"),
+         "Resume checkpoints need the barrier clock skew minimization scheme, without clock_skew_minimization/barrier/relaxed");
+   }
+
+   if (m_resume_save_dir != "")
+   {
+      LOG_ASSERT_ERROR(m_resume_interval > 0, "checkpoint/resume_save is set but checkpoint/resume_interval is zero");
+      mkdir(m_resume_save_dir.c_str(), 0755);
+      // Continue the numbering of an earlier (preempted) run writing to the same directory
+      String latest = readLatest(m_resume_save_dir);
+      if (latest != "")
+         m_resume_seq = strtoull(latest.c_str() + strlen("ckpt-"), NULL, 10);
+      if (m_resume_threads == 0)
+         m_resume_threads = sysconf(_SC_NPROCESSORS_ONLN);
+   }
+
+   if (m_save_file != "" || m_resume_save_dir != "")
+      // Save after everyone else has seen this barrier, while all cores are stopped
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, CheckpointManager::hook_periodic, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
+
+   if (m_restore_file != "")
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_SIM_START, CheckpointManager::hook_sim_start, (UInt64)this, HooksManager::ORDER_ACTION);
+
+   if (resume_dir != "")
+   {
+      LOG_ASSERT_ERROR(m_restore_file == "", "checkpoint/restore and checkpoint/resume cannot be combined");
+      String latest = readLatest(resume_dir);
+      LOG_ASSERT_ERROR(latest != "", "No checkpoint to resume from in %s", resume_dir.c_str());
+      m_resume_path = resume_dir + "/" + latest;
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_SIM_START, CheckpointManager::hook_sim_start_resume, (UInt64)this, HooksManager::ORDER_ACTION);
+   }
+}
+
+SInt64 CheckpointManager::hook_magic_marker(UInt64 self, UInt64 _marker)
+{
+   MagicServer::MagicMarkerType *marker = (MagicServer::MagicMarkerType *)_marker;
+   CheckpointManager *cm = (CheckpointManager *)self;
+   if (marker->arg0 == (UInt64)cm->m_save_marker)
+      cm->requestSave();
+   return 0;
+}
+
+void CheckpointManager::periodicIns(UInt64 icount)
+{
+   if (icount >= m_save_icount)
+      requestSave();
+}
+
+void CheckpointManager::requestSave()
+{
+   if (m_saved || m_save_pending)
+      return;
+
+   if (Sim()->getConfig()->getClockSkewMinimizationScheme() == ClockSkewMinimizationObject::BARRIER)
+      // Wait for the next barrier so no core is in the middle of a memory access
+      m_save_pending = true;
+   else
+      save();
+}
+
+void CheckpointManager::periodic()
+{
+   if (m_save_pending)
+   {
+      m_save_pending = false;
+      save();
+   }
+
+   if (m_resume_save_dir != "" && UInt64(time(NULL) - m_resume_last) >= m_resume_interval)
+      saveResume();
+}
+
+// Per-core parts of a checkpoint, shared by warm-state checkpoints (all cores in one file)
+// and resume checkpoints (one file per core)
+
+static void saveCache(CheckpointWriter &ckpt, core_id_t core_id, SInt32 level)
+{
+   ckpt.beginSection("cache");
+   Sim()->getCoreManager()->getCoreFromID(core_id)->getMemoryManager()->saveCheckpointCache(MemComponent::component_t(level), ckpt);
+   ckpt.endSection();
+}
+
+static UInt64 replayCache(CheckpointReader &ckpt, core_id_t core_id, SInt32 level)
+{
+   Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+   std::vector<CheckpointLine> lines;
+
+   ckpt.beginSection("cache");
+   core->getMemoryManager()->loadCheckpointCache(MemComponent::component_t(level), ckpt, lines);
+   ckpt.endSection();
+
+   // Re-install the lines through the normal (unmodeled) access path. Accesses from this core allocate
+   // the line in all of its levels, inner levels are then overwritten by their own replay.
+   for(std::vector<CheckpointLine>::iterator it = lines.begin(); it != lines.end(); ++it)
+   {
+      if (level == MemComponent::L1_ICACHE)
+      {
+         if (Sim()->getConfig()->getEnableICacheModeling())
+            core->readInstructionMemory(it->address, 1);
+      }
+      else
+      {
+         Core::mem_op_t mem_op_type = it->cstate == CacheState::MODIFIED ? Core::WRITE
+                                    : it->cstate == CacheState::EXCLUSIVE ? Core::READ_EX
+                                    : Core::READ;
+         core->accessMemory(Core::NONE, mem_op_type, it->address, NULL, 1, Core::MEM_MODELED_NONE);
+      }
+   }
+   return lines.size();
+}
+
+static void saveMemory(CheckpointWriter &ckpt, core_id_t core_id)
+{
+   ckpt.beginSection("memory");
+   Sim()->getCoreManager()->getCoreFromID(core_id)->getMemoryManager()->saveCheckpoint(ckpt);
+   ckpt.endSection();
+}
+
+static void loadMemory(CheckpointReader &ckpt, core_id_t core_id)
+{
+   ckpt.beginSection("memory");
+   Sim()->getCoreManager()->getCoreFromID(core_id)->getMemoryManager()->loadCheckpoint(ckpt);
+   ckpt.endSection();
+}
+
+static void saveBranchPredictor(CheckpointWriter &ckpt, core_id_t core_id)
+{
+   ckpt.beginSection("bpred");
+   BranchPredictor *bp = Sim()->getCoreManager()->getCoreFromID(core_id)->getPerformanceModel()->getBranchPredictor();
+   if (bp)
+      bp->saveState(ckpt);
+   ckpt.endSection();
+}
+
+static void loadBranchPredictor(CheckpointReader &ckpt, core_id_t core_id)
+{
+   ckpt.beginSection("bpred");
+   BranchPredictor *bp = Sim()->getCoreManager()->getCoreFromID(core_id)->getPerformanceModel()->getBranchPredictor();
+   if (bp && ckpt.more())
+      bp->loadState(ckpt);
+   ckpt.endSection();
+}
+
+void CheckpointManager::save()
+{
+   m_saved = true;
+
+   CheckpointWriter ckpt(m_save_file);
+   UInt32 num_cores = Sim()->getConfig()->getApplicationCores();
+   UInt32 num_levels = Sim()->getCfg()->getInt("perf_model/cache/levels");
+   ckpt.put(num_cores);
+
+   // Outer levels first, this is also the order in which they will be replayed
+   for(SInt32 level = MemComponent::L1_ICACHE + num_levels; level >= MemComponent::L1_ICACHE; --level)
+      for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+         saveCache(ckpt, core_id, level);
+
+   for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+      saveMemory(ckpt, core_id);
+
+   for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+      saveBranchPredictor(ckpt, core_id);
+
+   printf("[CHECKPOINT] Saved microarchitectural state to %s\n", m_save_file.c_str());
+}
+
+void CheckpointManager::restore()
+{
+   CheckpointReader ckpt(m_restore_file);
+   UInt32 num_cores = Sim()->getConfig()->getApplicationCores();
+   UInt32 num_levels = Sim()->getCfg()->getInt("perf_model/cache/levels");
+   UInt32 saved_cores;
+   ckpt.get(saved_cores);
+   LOG_ASSERT_ERROR(saved_cores == num_cores, "Checkpoint %s was saved with %d cores, expected %d", m_restore_file.c_str(), saved_cores, num_cores);
+
+   UInt64 num_lines = 0;
+   for(SInt32 level = MemComponent::L1_ICACHE + num_levels; level >= MemComponent::L1_ICACHE; --level)
+      for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+         num_lines += replayCache(ckpt, core_id, level);
+
+   // Restore non-coherent state last, so it is not disturbed by the cache replay
+   for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+      loadMemory(ckpt, core_id);
+
+   for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+      loadBranchPredictor(ckpt, core_id);
+
+   printf("[CHECKPOINT] Restored microarchitectural state from %s (%" PRIu64 " cache lines)\n", m_restore_file.c_str(), num_lines);
+}
+
+// Work shared by the resume checkpoint writer threads: each takes cores off the list until all are written
+struct ResumeSaveWork
+{
+   String dir;
+   UInt32 num_cores;
+   UInt32 num_levels;
+   UInt32 next_core;
+};
+
+static void* saveResumeCores(void *arg)
+{
+   ResumeSaveWork *work = (ResumeSaveWork*)arg;
+   while (true)
+   {
+      core_id_t core_id = __sync_fetch_and_add(&work->next_core, 1);
+      if (core_id >= (core_id_t)work->num_cores)
+         break;
+
+      CheckpointWriter ckpt(work->dir + "/core-" + itostr(core_id) + ".ckpt");
+      for(SInt32 level = MemComponent::L1_ICACHE + work->num_levels; level >= MemComponent::L1_ICACHE; --level)
+         saveCache(ckpt, core_id, level);
+      saveMemory(ckpt, core_id);
+      saveBranchPredictor(ckpt, core_id);
+   }
+   return NULL;
+}
+
+void CheckpointManager::saveResume()
+{
+   time_t start = ::time(NULL);
+   UInt32 num_cores = Sim()->getConfig()->getApplicationCores();
+   SubsecondTime time = Sim()->getClockSkewMinimizationServer()->getGlobalTime();
+   String previous = readLatest(m_resume_save_dir);
+   String name = "ckpt-" + itostr(++m_resume_seq);
+   String dir = m_resume_save_dir + "/" + name;
+
+   // Left behind by a run that was preempted while saving
+   removeResumeDir(dir);
+   int res = mkdir(dir.c_str(), 0755);
+   LOG_ASSERT_ERROR(res == 0, "Cannot create checkpoint directory %s", dir.c_str());
+
+   {
+      CheckpointWriter ckpt(dir + "/global.ckpt");
+      ckpt.put(num_cores);
+      ckpt.put<UInt64>(time.getFS());
+      ckpt.put<UInt8>(Sim()->getMagicServer()->inROI());
+      ckpt.put<UInt32>(Sim()->getInstrumentationMode());
+      ckpt.beginSection("stats");
+      Sim()->getStatsManager()->saveCheckpoint(ckpt);
+      ckpt.endSection();
+   }
+
+   {
+      CheckpointWriter ckpt(dir + "/trace.ckpt");
+      ckpt.beginSection("trace");
+      Sim()->getTraceManager()->saveCheckpoint(ckpt);
+      ckpt.endSection();
+   }
+
+   // Per-core state is the bulk of the checkpoint, write it in parallel
+   ResumeSaveWork work = { dir, num_cores, (UInt32)Sim()->getCfg()->getInt("perf_model/cache/levels"), 0 };
+   UInt32 num_threads = std::min(m_resume_threads, num_cores);
+   std::vector<pthread_t> threads(num_threads);
+   for (UInt32 i = 0; i < num_threads; ++i)
+   {
+      res = pthread_create(&threads[i], NULL, saveResumeCores, &work);
+      LOG_ASSERT_ERROR(res == 0, "Cannot create checkpoint thread");
+   }
+   for (UInt32 i = 0; i < num_threads; ++i)
+      pthread_join(threads[i], NULL);
+
+   Sim()->getStatsManager()->saveDatabase(dir + "/sim.stats.sqlite3");
+
+   // Only now switch over to the new checkpoint, a run preempted while saving still finds the previous one
+   String latest = m_resume_save_dir + "/latest";
+   FILE *fp = fopen((latest + ".tmp").c_str(), "w");
+   LOG_ASSERT_ERROR(fp, "Cannot write %s.tmp", latest.c_str());
+   fprintf(fp, "%s\n", name.c_str());
+   fflush(fp);
+   fsync(fileno(fp));
+   fclose(fp);
+   res = rename((latest + ".tmp").c_str(), latest.c_str());
+   LOG_ASSERT_ERROR(res == 0, "Cannot update %s", latest.c_str());
+
+   if (previous != "" && previous != name)
+      removeResumeDir(m_resume_save_dir + "/" + previous);
+
+   printf("[CHECKPOINT] Saved resume checkpoint %s at %" PRIu64 " ns in %ld seconds\n", dir.c_str(), time.getNS(), long(::time(NULL) - start));
+   m_resume_last = ::time(NULL);
+}
+
+void CheckpointManager::resume()
+{
+   CheckpointReader global(getResumeFile("global.ckpt"));
+   UInt32 num_cores = Sim()->getConfig()->getApplicationCores();
+   UInt32 num_levels = Sim()->getCfg()->getInt("perf_model/cache/levels");
+   UInt32 saved_cores, inst_mode;
+   UInt64 time_fs;
+   UInt8 in_roi;
+   global.get(saved_cores);
+   LOG_ASSERT_ERROR(saved_cores == num_cores, "Checkpoint %s was saved with %d cores, expected %d", m_resume_path.c_str(), saved_cores, num_cores);
+   global.get(time_fs);
+   global.get(in_roi);
+   global.get(inst_mode);
+
+   std::vector<CheckpointReader*> cores(num_cores);
+   for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+      cores[core_id] = new CheckpointReader(getResumeFile("core-" + itostr(core_id) + ".ckpt"));
+
+   // Same order as a warm-state restore: all cores level by level, then the non-coherent state
+   UInt64 num_lines = 0;
+   for(SInt32 level = MemComponent::L1_ICACHE + num_levels; level >= MemComponent::L1_ICACHE; --level)
+      for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+         num_lines += replayCache(*cores[core_id], core_id, level);
+
+   for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+   {
+      loadMemory(*cores[core_id], core_id);
+      loadBranchPredictor(*cores[core_id], core_id);
+      delete cores[core_id];
+   }
+
+   // Statistics last, they overwrite whatever the replay counted. This includes the elapsed time of each core.
+   global.beginSection("stats");
+   Sim()->getStatsManager()->loadCheckpoint(global);
+   global.endSection();
+
+   SubsecondTime time = SubsecondTime::FS(time_fs);
+   Sim()->getClockSkewMinimizationServer()->restoreTime(time);
+   for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+      Sim()->getCoreManager()->getCoreFromID(core_id)->getPerformanceModel()->notifyTimeRestored();
+
+   if (in_roi)
+      Sim()->getMagicServer()->setPerformance(true, true /* resume */);
+   Sim()->setInstrumentationMode(InstMode::inst_mode_t(inst_mode), true /* update_barrier */);
+
+   // Snapshots and events of the run up to the checkpoint
+   Sim()->getStatsManager()->mergeDatabase(getResumeFile("sim.stats.sqlite3"));
+
+   printf("[CHECKPOINT] Resuming from %s at %" PRIu64 " ns (%" PRIu64 " cache lines)\n", m_resume_path.c_str(), time.getNS(), num_lines);
+}
+
+String CheckpointManager::readLatest(String dir)
+{
+   char name[256] = "";
+   FILE *fp = fopen((dir + "/latest").c_str(), "r");
+   if (!fp)
+      return "";
+   if (fscanf(fp, "%255s", name) != 1)
+      name[0] = '\0';
+   fclose(fp);
+   return name;
+}
+
+void CheckpointManager::removeResumeDir(String dir)
+{
+   DIR *dp = opendir(dir.c_str());
+   if (!dp)
+      return;
+   while (struct dirent *entry = readdir(dp))
+      if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, ".."))
+         unlink((dir + "/" + entry->d_name).c_str());
+   closedir(dp);
+   rmdir(dir.c_str());
+}
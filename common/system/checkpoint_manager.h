@@ -0,0 +1,67 @@
+#ifndef __CHECKPOINT_MANAGER_H
+#define __CHECKPOINT_MANAGER_H
+
+#include "fixed_types.h"
+
+#include <ctime>
+
+// Save and restore of warmed microarchitectural state (caches, TLBs, prefetchers and branch predictors),
+// so repeated simulations of a region do not each need to re-run its warmup.
+// A checkpoint is written to [checkpoint/save] once [checkpoint/save_icount] instructions have been executed,
+// or when a SimMarker with [checkpoint/save_marker] as its first argument is seen. When [checkpoint/restore]
+// is set, the state is loaded at simulation start. Cache contents are re-installed by replaying their lines
+// through the memory hierarchy (outer levels first, least recently used lines first), so directory and
+// coherence state is rebuilt as well; the other structures are restored as-is.
+//
+// Resume checkpoints capture a whole trace-driven simulation, so a preempted run can continue where it stopped.
+// Every [checkpoint/resume_interval] seconds of host time, at the next barrier, a checkpoint is written to a new
+// subdirectory of [checkpoint/resume_save]: the warm state above (one file per core, written in parallel),
+// all restorable statistics, the simulated time and ROI state, the trace position of every thread, and a copy
+// of sim.stats.sqlite3. The file <dir>/latest names the most recent complete checkpoint. With [checkpoint/resume],
+// threads are recreated at their trace positions and simulation continues from the saved time.
+
+class CheckpointManager
+{
+   public:
+      static CheckpointManager* create();
+
+      CheckpointManager(String save_file, String restore_file, String resume_save_dir, String resume_dir);
+
+      void save();
+      void restore();
+      void saveResume();
+      void resume();
+
+      bool isResuming() const { return m_resume_path != ""; }
+      String getResumeFile(String name) const { return m_resume_path + "/" + name; }
+
+   private:
+      const String m_save_file;
+      const String m_restore_file;
+      const UInt64 m_save_icount;
+      const SInt64 m_save_marker;
+      bool m_save_pending;
+      bool m_saved;
+
+      const String m_resume_save_dir;
+      const UInt64 m_resume_interval;
+      UInt32 m_resume_threads;
+      String m_resume_path;          // Checkpoint being resumed from, <resume>/<latest>
+      UInt64 m_resume_seq;           // Sequence number of the last checkpoint in m_resume_save_dir
+      time_t m_resume_last;          // Host time of the last resume checkpoint
+
+      static SInt64 hook_periodic(UInt64 self, UInt64 time) { ((CheckpointManager*)self)->periodic(); return 0; }
+      static SInt64 hook_periodic_ins(UInt64 self, UInt64 icount) { ((CheckpointManager*)self)->periodicIns(icount); return 0; }
+      static SInt64 hook_magic_marker(UInt64 self, UInt64 marker);
+      static SInt64 hook_sim_start(UInt64 self, UInt64 arg) { ((CheckpointManager*)self)->restore(); return 0; }
+      static SInt64 hook_sim_start_resume(UInt64 self, UInt64 arg) { ((CheckpointManager*)self)->resume(); return 0; }
+
+      void periodic();
+      void periodicIns(UInt64 icount);
+      void requestSave();
+
+      static String readLatest(String dir);
+      static void removeResumeDir(String dir);
+};
+
+#endif // __CHECKPOINT_MANAGER_H
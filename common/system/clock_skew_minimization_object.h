@@ -64,6 +64,12 @@ public:
    virtual SubsecondTime getGlobalTime(bool upper_bound = false);
    virtual void setBarrierInterval(SubsecondTime barrier_interval) = 0;
    virtual SubsecondTime getBarrierInterval() const = 0;
+   // Continue from a time saved in a checkpoint (see CheckpointManager)
+   virtual void restoreTime(SubsecondTime time) {}
+   // How far past the next barrier a core may run before it has to wait (relaxed synchronization)
+   virtual SubsecondTime getLookahead() const { return SubsecondTime::Zero(); }
+   // Inter-core communication (coherence requests to lines cached by other cores, futex calls), used to adapt the quantum
+   virtual void notifySharing() {}
 
    virtual void printState(void) {}
 };
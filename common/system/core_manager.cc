@@ -12,6 +12,13 @@
 #include "network.h"
 #include "cache.h"
 #include "config.h"
+#include "instruction_aggregator.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "itostr.h"
+#include "host_topology.h"
+
+#include <pthread.h>
 
 #include "log.h"
 
@@ -20,22 +27,113 @@ CoreManager::CoreManager()
       , m_thread_type_tls(TLS::create())
       , m_num_registered_sim_threads(0)
       , m_num_registered_core_threads(0)
+      , m_instruction_aggregator(new InstructionAggregator(Config::getSingleton()->getTotalCores()))
 {
    LOG_PRINT("Starting CoreManager Constructor.");
 
-   for (UInt32 i = 0; i < Config::getSingleton()->getTotalCores(); i++)
+   UInt32 num_threads = Sim()->getCfg()->getInt("general/startup_threads");
+   // Only the default memory hierarchy is safe to construct in parallel, and Pin does not run its internal threads yet
+   if (num_threads > 1 && Sim()->getConfig()->getSimulationMode() == Config::STANDALONE
+       && Sim()->getCfg()->getString("caching_protocol/type") == "parametric_dram_directory_msi"
+       && !Sim()->getCfg()->getBool("core/cheetah/enabled"))
+   {
+      createCoresParallel(num_threads);
+   }
+   else
    {
-      m_cores.push_back(new Core(i));
+      // Construct each core while running on its host node, so its structures are allocated there
+      for (UInt32 i = 0; i < Config::getSingleton()->getTotalCores(); i++)
+      {
+         Sim()->getHostTopology()->bindThread(i);
+         m_cores.push_back(new Core(i));
+      }
+      Sim()->getHostTopology()->unbindThread();
    }
 
    LOG_PRINT("Finished CoreManager Constructor.");
 }
 
+// Work shared by the startup threads: each takes groups of cores off the list until it is empty
+struct CoreConstructionWork
+{
+   std::vector<Core*> *cores;
+   const std::vector<core_id_t> *group_starts;
+   UInt32 next_group;
+};
+
+static void* constructCoreGroups(void *arg)
+{
+   CoreConstructionWork *work = (CoreConstructionWork*)arg;
+   while (true)
+   {
+      UInt32 group = __sync_fetch_and_add(&work->next_group, 1);
+      if (group + 1 >= work->group_starts->size())
+         break;
+      Sim()->getHostTopology()->bindThread((*work->group_starts)[group]);
+      for (core_id_t core_id = (*work->group_starts)[group]; core_id < (*work->group_starts)[group + 1]; ++core_id)
+         (*work->cores)[core_id] = new Core(core_id);
+   }
+   return NULL;
+}
+
+bool CoreManager::isCoreGroupStart(core_id_t core_id)
+{
+   // A core that shares a cache, or an SMT core, with lower-numbered cores uses their objects while being constructed
+   UInt32 smt_cores = Sim()->getCfg()->getIntArray("perf_model/core/logical_cpus", core_id);
+   if (core_id % smt_cores)
+      return false;
+
+   if (core_id >= (core_id_t)Config::getSingleton()->getApplicationCores())
+      return true;
+
+   UInt32 levels = Sim()->getCfg()->getInt("perf_model/cache/levels");
+   for (UInt32 level = 1; level <= levels; ++level)
+   {
+      std::vector<String> names;
+      if (level == 1)
+         names = { "l1_icache", "l1_dcache" };
+      else
+         names = { "l" + itostr(level) + "_cache" };
+
+      for (auto it = names.begin(); it != names.end(); ++it)
+         if (core_id % (Sim()->getCfg()->getIntArray("perf_model/" + *it + "/shared_cores", core_id) * smt_cores))
+            return false;
+   }
+   return true;
+}
+
+void CoreManager::createCoresParallel(UInt32 num_threads)
+{
+   // Groups of cores that share caches are constructed in order by the same thread, groups in parallel
+   UInt32 total_cores = Config::getSingleton()->getTotalCores();
+   std::vector<core_id_t> group_starts;
+   for (core_id_t core_id = 0; core_id < (core_id_t)total_cores; ++core_id)
+      if (isCoreGroupStart(core_id))
+         group_starts.push_back(core_id);
+   group_starts.push_back(total_cores);
+
+   num_threads = std::min(num_threads, UInt32(group_starts.size() - 1));
+   m_cores.resize(total_cores, NULL);
+
+   CoreConstructionWork work = { &m_cores, &group_starts, 0 };
+   std::vector<pthread_t> threads(num_threads);
+   for (UInt32 i = 0; i < num_threads; ++i)
+   {
+      int res = pthread_create(&threads[i], NULL, constructCoreGroups, &work);
+      LOG_ASSERT_ERROR(res == 0, "Cannot create startup thread");
+   }
+   for (UInt32 i = 0; i < num_threads; ++i)
+      pthread_join(threads[i], NULL);
+
+   LOG_PRINT("Constructed %u cores in %u groups using %u threads", total_cores, group_starts.size() - 1, num_threads);
+}
+
 CoreManager::~CoreManager()
 {
    for (std::vector<Core *>::iterator i = m_cores.begin(); i != m_cores.end(); i++)
       delete *i;
 
+   delete m_instruction_aggregator;
    delete m_core_tls;
    delete m_thread_type_tls;
 }
@@ -13,6 +13,7 @@
 #include <vector>
 
 class Core;
+class InstructionAggregator;
 
 class CoreManager
 {
@@ -46,10 +47,14 @@ class CoreManager
       }
 
       Core *getCoreFromID(core_id_t core_id);
+      InstructionAggregator *getInstructionAggregator() { return m_instruction_aggregator; }
 
       bool amiUserThread();
       bool amiCoreThread();
       bool amiSimThread();
+      // First core of a group of cores that share a cache (or SMT core), these are constructed together
+      static bool isCoreGroupStart(core_id_t core_id);
+
    private:
 
       UInt32 *tid_map;
@@ -60,7 +65,11 @@ class CoreManager
       UInt32 m_num_registered_core_threads;
       Lock m_num_registered_threads_lock;
 
+      InstructionAggregator *m_instruction_aggregator;
       std::vector<Core*> m_cores;
+
+      // general/startup_threads > 1: construct groups of cores that share a cache in parallel
+      void createCoresParallel(UInt32 num_threads);
 };
 
 #endif
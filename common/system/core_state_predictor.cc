@@ -0,0 +1,38 @@
+#include "core_state_predictor.h"
+#include "core_state_predictor_last_value.h"
+#include "core_state_predictor_nbit.h"
+#include "core_state_predictor_markov.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "config.hpp"
+#include "log.h"
+
+CoreStatePredictor* CoreStatePredictor::create(String type, core_id_t core_id)
+{
+   if (type == "last_value")
+   {
+      UInt32 confidence = Sim()->getCfg()->getIntArray("core_state_predictor/last_value/confidence", core_id);
+      return new CoreStatePredictorLastValue(core_id, confidence);
+   }
+   else if (type == "nbit")
+   {
+      UInt32 bits = Sim()->getCfg()->getIntArray("core_state_predictor/nbit/bits", core_id);
+      return new CoreStatePredictorNBit(core_id, bits);
+   }
+   else if (type == "markov")
+   {
+      UInt32 table_size = Sim()->getCfg()->getIntArray("core_state_predictor/markov/table_size", core_id);
+      UInt32 order = Sim()->getCfg()->getIntArray("core_state_predictor/markov/order", core_id);
+      UInt32 tag_bits = Sim()->getCfg()->getIntArray("core_state_predictor/markov/tag_bits", core_id);
+      return new CoreStatePredictorMarkov(core_id, table_size, order, tag_bits);
+   }
+   else
+   {
+      LOG_PRINT_ERROR("Invalid core state predictor type %s", type.c_str());
+   }
+}
+
+const CoreStateHistory* CoreStatePredictor::getStateHistory() const
+{
+   return Sim()->getCoreManager()->getCoreFromID(m_core_id)->getStateHistory();
+}
@@ -0,0 +1,39 @@
+#ifndef __CORE_STATE_PREDICTOR_H
+#define __CORE_STATE_PREDICTOR_H
+
+#include "fixed_types.h"
+#include "core.h"
+
+// Predicts the state of a core for the next sampling interval.
+// One instance exists per application core, driven by CoreStatePredictorManager.
+
+class CoreStatePredictor
+{
+   public:
+      static CoreStatePredictor* create(String type, core_id_t core_id);
+
+      CoreStatePredictor(core_id_t core_id) : m_core_id(core_id) {}
+      virtual ~CoreStatePredictor() {}
+
+      // Observe the actual state at the end of a sampling interval
+      virtual void update(Core::State actual) = 0;
+      // Predicted state for the next sampling interval
+      virtual Core::State predict() = 0;
+      // Whether the prediction is reliable enough to act upon
+      virtual bool isConfident() { return true; }
+
+      // Core::setState() was called (only state changes are reported)
+      virtual void stateChanged(Core::State old_state, Core::State new_state) {}
+
+      // Branch outcomes, only delivered if needsBranches() returns true
+      virtual bool needsBranches() const { return false; }
+      virtual void branch(IntPtr ip, bool taken) {}
+
+   protected:
+      const core_id_t m_core_id;
+
+      // The core's recent states and their exact durations, NULL unless [core/state_history] size is set
+      const CoreStateHistory* getStateHistory() const;
+};
+
+#endif // __CORE_STATE_PREDICTOR_H
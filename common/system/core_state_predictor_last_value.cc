@@ -0,0 +1,22 @@
+#include "core_state_predictor_last_value.h"
+
+CoreStatePredictorLastValue::CoreStatePredictorLastValue(core_id_t core_id, UInt32 confidence_threshold)
+   : CoreStatePredictor(core_id)
+   , m_confidence_threshold(confidence_threshold)
+   , m_confidence(0)
+   , m_last(Core::NUM_STATES) // No history yet, never matches
+{
+}
+
+void CoreStatePredictorLastValue::update(Core::State actual)
+{
+   if (actual == m_last)
+   {
+      if (m_confidence < m_confidence_threshold)
+         ++m_confidence;
+   }
+   else
+      m_confidence = 0;
+
+   m_last = actual;
+}
@@ -0,0 +1,25 @@
+#ifndef __CORE_STATE_PREDICTOR_LAST_VALUE_H
+#define __CORE_STATE_PREDICTOR_LAST_VALUE_H
+
+#include "core_state_predictor.h"
+
+// Predict that the next interval has the same state as the last one (ACAPS SCSP).
+// A saturating confidence counter is incremented on every correct prediction and reset on a misprediction,
+// predictions are only considered reliable once the counter reaches the threshold.
+
+class CoreStatePredictorLastValue : public CoreStatePredictor
+{
+   public:
+      CoreStatePredictorLastValue(core_id_t core_id, UInt32 confidence_threshold);
+
+      void update(Core::State actual);
+      Core::State predict() { return m_last; }
+      bool isConfident() { return m_confidence >= m_confidence_threshold; }
+
+   private:
+      const UInt32 m_confidence_threshold;
+      UInt32 m_confidence;
+      Core::State m_last;
+};
+
+#endif // __CORE_STATE_PREDICTOR_LAST_VALUE_H
@@ -0,0 +1,174 @@
+#include "core_state_predictor_manager.h"
+#include "core_state_predictor.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "dvfs_manager.h"
+#include "hooks_manager.h"
+#include "magic_server.h"
+#include "clock_skew_minimization_object.h"
+#include "config.hpp"
+#include "stats.h"
+
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+
+CoreStatePredictorManager* CoreStatePredictorManager::create()
+{
+   String type = Sim()->getCfg()->getString("core_state_predictor/type");
+
+   if (type == "none")
+      return NULL;
+   else
+      return new CoreStatePredictorManager(type);
+}
+
+CoreStatePredictorManager::CoreStatePredictorManager(String type)
+   : m_num_cores(Sim()->getConfig()->getApplicationCores())
+   , m_interval(SubsecondTime::NS(Sim()->getCfg()->getInt("core_state_predictor/interval")))
+   , m_dvfs(Sim()->getCfg()->getBool("core_state_predictor/dvfs"))
+   , m_idle_freq_mhz(Sim()->getCfg()->getInt("core_state_predictor/idle_frequency"))
+   , m_time_next(SubsecondTime::Zero())
+   , m_needs_branches(false)
+{
+   LOG_ASSERT_ERROR(m_idle_freq_mhz > 0, "core_state_predictor/idle_frequency must be non-zero");
+
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+      m_nominal_freq.push_back(ComponentPeriod::fromFreqHz(Sim()->getCfg()->getFloatArray("perf_model/core/frequency", core_id) * 1000000000));
+
+   // The configured predictor keeps the original statistics names, shadow predictors are reported
+   // as core_state_predictor-<type>
+   addShadow("core_state_predictor", type);
+
+   String shadows = Sim()->getCfg()->getString("core_state_predictor/shadow");
+   std::vector<String> selected;
+   boost::split(selected, shadows, boost::is_any_of(" ,"), boost::token_compress_on);
+   for(std::vector<String>::iterator it = selected.begin(); it != selected.end(); ++it)
+   {
+      if (it->empty())
+         continue;
+      LOG_ASSERT_ERROR(*it != type && std::count(selected.begin(), it, *it) == 0, "Core state predictor %s is configured more than once", it->c_str());
+      addShadow("core_state_predictor-" + *it, *it);
+   }
+
+   // We change core frequencies, so run as an action (after ORDER_NOTIFY_PRE callbacks have seen the current state)
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, CoreStatePredictorManager::hook_periodic, (UInt64)this, HooksManager::ORDER_ACTION);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_CORE_STATE_CHANGE, CoreStatePredictorManager::hook_core_state_change, (UInt64)this);
+}
+
+CoreStatePredictorManager::~CoreStatePredictorManager()
+{
+   for(auto it = m_shadows.begin(); it != m_shadows.end(); ++it)
+   {
+      for(auto jt = (*it)->predictors.begin(); jt != (*it)->predictors.end(); ++jt)
+         delete *jt;
+      delete *it;
+   }
+}
+
+void CoreStatePredictorManager::addShadow(String name, String type)
+{
+   Shadow *shadow = new Shadow();
+   shadow->predicted.resize(m_num_cores, Core::NUM_STATES);
+   shadow->stats.resize(m_num_cores, CoreStats{0, 0, 0, 0, 0});
+   m_shadows.push_back(shadow);
+
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+   {
+      CoreStatePredictor *predictor = CoreStatePredictor::create(type, core_id);
+      shadow->predictors.push_back(predictor);
+      m_needs_branches |= predictor->needsBranches();
+
+      registerStatsMetric(name, core_id, "predictions", &shadow->stats[core_id].num_predictions);
+      registerStatsMetric(name, core_id, "correct", &shadow->stats[core_id].num_correct);
+      registerStatsMetric(name, core_id, "incorrect", &shadow->stats[core_id].num_incorrect);
+      registerStatsMetric(name, core_id, "unconfident", &shadow->stats[core_id].num_unconfident);
+      // Shadows don't change frequencies, their count stays at zero
+      if (shadow == m_shadows[0])
+         registerStatsMetric(name, core_id, "frequency-changes", &shadow->stats[core_id].num_freq_changes);
+   }
+}
+
+SInt64 CoreStatePredictorManager::hook_core_state_change(UInt64 self, UInt64 _info)
+{
+   HooksManager::CoreStateChange *info = (HooksManager::CoreStateChange *)_info;
+   CoreStatePredictorManager *csp = (CoreStatePredictorManager *)self;
+   if ((UInt32)info->core_id < csp->m_num_cores)
+      for(auto it = csp->m_shadows.begin(); it != csp->m_shadows.end(); ++it)
+         (*it)->predictors[info->core_id]->stateChanged(info->old_state, info->new_state);
+   return 0;
+}
+
+void CoreStatePredictorManager::periodic(SubsecondTime time)
+{
+   if (!Sim()->getMagicServer()->inROI() || time < m_time_next)
+      return;
+   m_time_next = time + m_interval;
+
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_num_cores; ++core_id)
+      sample(core_id);
+}
+
+void CoreStatePredictorManager::sample(core_id_t core_id)
+{
+   Core::State actual = Sim()->getCoreManager()->getCoreFromID(core_id)->getState();
+
+   for(auto it = m_shadows.begin(); it != m_shadows.end(); ++it)
+   {
+      Shadow *shadow = *it;
+      bool drives_dvfs = shadow == m_shadows[0];
+      CoreStatePredictor *predictor = shadow->predictors[core_id];
+      Core::State &predicted = shadow->predicted[core_id];
+      CoreStats &stats = shadow->stats[core_id];
+
+      // Score the prediction made for the interval that just ended
+      if (predicted != Core::NUM_STATES)
+      {
+         ++stats.num_predictions;
+         if (predicted == actual)
+            ++stats.num_correct;
+         else
+         {
+            ++stats.num_incorrect;
+            // Recover from the misprediction
+            if (drives_dvfs)
+               setFrequency(core_id, actual, stats);
+         }
+      }
+
+      predictor->update(actual);
+
+      if (predictor->isConfident())
+      {
+         predicted = predictor->predict();
+         if (drives_dvfs)
+            setFrequency(core_id, predicted, stats);
+      }
+      else
+      {
+         predicted = Core::NUM_STATES;
+         ++stats.num_unconfident;
+      }
+   }
+}
+
+void CoreStatePredictorManager::setFrequency(core_id_t core_id, Core::State state, CoreStats &stats)
+{
+   if (!m_dvfs)
+      return;
+
+   ComponentPeriod new_freq = state == Core::IDLE ? ComponentPeriod::fromFreqHz(m_idle_freq_mhz * 1000000) : m_nominal_freq[core_id];
+   if (new_freq.getPeriod() == Sim()->getDvfsManager()->getCoreDomain(core_id)->getPeriod())
+      return;
+
+   ++stats.num_freq_changes;
+   if (Sim()->getDvfsManager()->isAsync())
+   {
+      // Applied by the core once it reaches the current global time, which also calls the hooks
+      Sim()->getDvfsManager()->postCoreDomain(core_id, new_freq, Sim()->getClockSkewMinimizationServer()->getGlobalTime());
+   }
+   else
+   {
+      Sim()->getDvfsManager()->setCoreDomain(core_id, new_freq);
+      Sim()->getHooksManager()->callHooks(HookType::HOOK_CPUFREQ_CHANGE, core_id);
+   }
+}
@@ -0,0 +1,72 @@
+#ifndef __CORE_STATE_PREDICTOR_MANAGER_H
+#define __CORE_STATE_PREDICTOR_MANAGER_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "core.h"
+#include "core_state_predictor.h"
+
+#include <vector>
+
+// Native core-state prediction (replaces the periodic ACAPS/SCSP/n-bit Python scripts).
+// Every [core_state_predictor/interval] ns of simulated time (in the ROI), the state of each application core
+// is sampled and fed to its predictor. When a prediction is confident, the core's DVFS frequency is set to
+// [core_state_predictor/idle_frequency] if it is predicted to be idle, or back to its nominal frequency otherwise.
+// Additional predictor types in [core_state_predictor/shadow] see the same samples and events and are scored
+// the same way, reported as core_state_predictor-<type>, but never change frequencies.
+
+class CoreStatePredictorManager
+{
+   public:
+      static CoreStatePredictorManager* create();
+
+      CoreStatePredictorManager(String type);
+      ~CoreStatePredictorManager();
+
+      CoreStatePredictor* getPredictor(core_id_t core_id) { return m_shadows[0]->predictors.at(core_id); }
+
+      // Called by BranchPredictor::update for every resolved branch, on the core's own thread
+      void branch(core_id_t core_id, IntPtr ip, bool taken)
+      {
+         if (m_needs_branches && (UInt32)core_id < m_num_cores)
+            for(auto it = m_shadows.begin(); it != m_shadows.end(); ++it)
+               (*it)->predictors[core_id]->branch(ip, taken);
+      }
+
+   private:
+      struct CoreStats
+      {
+         UInt64 num_predictions;
+         UInt64 num_correct;
+         UInt64 num_incorrect;
+         UInt64 num_unconfident;
+         UInt64 num_freq_changes;
+      };
+      struct Shadow
+      {
+         std::vector<CoreStatePredictor*> predictors;
+         std::vector<Core::State> predicted;    // Last confident prediction, NUM_STATES if none
+         std::vector<CoreStats> stats;
+      };
+
+      const UInt32 m_num_cores;
+      const SubsecondTime m_interval;
+      const bool m_dvfs;
+      const UInt64 m_idle_freq_mhz;
+      SubsecondTime m_time_next;
+      bool m_needs_branches;
+
+      // The first one drives DVFS
+      std::vector<Shadow*> m_shadows;
+      std::vector<ComponentPeriod> m_nominal_freq;
+
+      static SInt64 hook_periodic(UInt64 self, UInt64 time) { ((CoreStatePredictorManager*)self)->periodic(*(subsecond_time_t*)&time); return 0; }
+      static SInt64 hook_core_state_change(UInt64 self, UInt64 info);
+
+      void periodic(SubsecondTime time);
+      void addShadow(String name, String type);
+      void sample(core_id_t core_id);
+      void setFrequency(core_id_t core_id, Core::State state, CoreStats &stats);
+};
+
+#endif // __CORE_STATE_PREDICTOR_MANAGER_H
@@ -0,0 +1,90 @@
+#include "core_state_predictor_markov.h"
+#include "log.h"
+
+#include <algorithm>
+
+CoreStatePredictorMarkov::CoreStatePredictorMarkov(core_id_t core_id, UInt32 table_size, UInt32 order, UInt32 tag_bits)
+   : CoreStatePredictor(core_id)
+   , m_table(table_size, Transition{0, 0, 0})
+   , m_mask(table_size - 1)
+   , m_order(order)
+   , m_tag_mask((1 << tag_bits) - 1)
+   , m_history_length(0)
+   , m_last_index(0)
+   , m_last_tag(0)
+   , m_idle_seen(false)
+{
+   LOG_ASSERT_ERROR(table_size && (table_size & (table_size - 1)) == 0, "Markov core state predictor table size must be a power of two, got %d", table_size);
+   LOG_ASSERT_ERROR(order >= 1 && order <= MAX_ORDER, "Markov core state predictor order must be between 1 and %d, got %d", MAX_ORDER, order);
+   LOG_ASSERT_ERROR(tag_bits <= 16, "Markov core state predictor tags can be at most 16 bits, got %d", tag_bits);
+}
+
+const CoreStatePredictorMarkov::Transition* CoreStatePredictorMarkov::lookup() const
+{
+   if (m_history_length < m_order)
+      return NULL;
+   const Transition &t = m_table[m_last_index];
+   return t.count > 0 && t.tag == m_last_tag ? &t : NULL;
+}
+
+Core::State CoreStatePredictorMarkov::predict()
+{
+   const Transition *t = lookup();
+   if (!t)
+      return Core::RUNNING;
+   return 2 * UInt32(t->idle_count) > t->count ? Core::IDLE : Core::RUNNING;
+}
+
+bool CoreStatePredictorMarkov::isConfident()
+{
+   return lookup() != NULL;
+}
+
+void CoreStatePredictorMarkov::stateChanged(Core::State old_state, Core::State new_state)
+{
+   if (new_state == Core::IDLE)
+      m_idle_seen = true;
+}
+
+void CoreStatePredictorMarkov::branch(IntPtr ip, bool taken)
+{
+   // Train the context that ended at the previous branch
+   if (m_history_length == m_order)
+   {
+      Transition &t = m_table[m_last_index];
+      if (t.tag != m_last_tag && t.count > 0)
+      {
+         t.count >>= 1;
+         t.idle_count >>= 1;
+      }
+      if (t.count == 0)
+      {
+         t.tag = m_last_tag;
+         t.idle_count = 0;
+      }
+      if (t.tag == m_last_tag)
+      {
+         if (t.count == COUNTER_MAX)
+         {
+            // Age both counters to keep the ratio while making room
+            t.count >>= 1;
+            t.idle_count >>= 1;
+         }
+         ++t.count;
+         if (m_idle_seen)
+            ++t.idle_count;
+      }
+   }
+
+   for(UInt32 i = std::min(m_history_length, m_order - 1); i > 0; --i)
+      m_history[i] = m_history[i - 1];
+   m_history[0] = ((ip >> 2) << 1) | (taken ? 1 : 0);
+   m_history_length = std::min(m_history_length + 1, m_order);
+
+   UInt64 hash = 0;
+   for(UInt32 i = 0; i < m_history_length; ++i)
+      hash = (hash ^ m_history[i]) * 0x9e3779b97f4a7c15ULL;
+   m_last_index = (hash >> 16) & m_mask;
+   m_last_tag = (hash >> 48) & m_tag_mask;
+   m_idle_seen = false;
+}
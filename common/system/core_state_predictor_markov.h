@@ -0,0 +1,52 @@
+#ifndef __CORE_STATE_PREDICTOR_MARKOV_H
+#define __CORE_STATE_PREDICTOR_MARKOV_H
+
+#include "core_state_predictor.h"
+
+#include <vector>
+
+// Markov chain over branch history: for every context of the last <order> (ip, taken) branch states, count how
+// often the transition to the next branch on this core had the core go idle in between.
+// Predicts IDLE if, from the most recent context, more than half of the observed transitions went idle.
+// Contexts are hashed into a direct-mapped table of saturating counters, tagged with other bits of the hash.
+// A context that maps onto an entry owned by another one ages that entry, and takes it over once it has decayed.
+
+class CoreStatePredictorMarkov : public CoreStatePredictor
+{
+   public:
+      CoreStatePredictorMarkov(core_id_t core_id, UInt32 table_size, UInt32 order, UInt32 tag_bits);
+
+      void update(Core::State actual) {}
+      Core::State predict();
+      bool isConfident();
+
+      void stateChanged(Core::State old_state, Core::State new_state);
+
+      bool needsBranches() const { return true; }
+      void branch(IntPtr ip, bool taken);
+
+   private:
+      static const UInt32 MAX_ORDER = 8;
+      static const UInt8 COUNTER_MAX = UINT8_MAX;
+
+      struct Transition
+      {
+         UInt16 tag;
+         UInt8 count;
+         UInt8 idle_count;
+      };
+
+      std::vector<Transition> m_table;
+      const UInt32 m_mask;
+      const UInt32 m_order;
+      const UInt16 m_tag_mask;
+      UInt64 m_history[MAX_ORDER]; // Hashed branch states, most recent first
+      UInt32 m_history_length;
+      UInt32 m_last_index;
+      UInt16 m_last_tag;
+      bool m_idle_seen;
+
+      const Transition* lookup() const;
+};
+
+#endif // __CORE_STATE_PREDICTOR_MARKOV_H
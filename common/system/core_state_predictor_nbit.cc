@@ -0,0 +1,24 @@
+#include "core_state_predictor_nbit.h"
+#include "log.h"
+
+CoreStatePredictorNBit::CoreStatePredictorNBit(core_id_t core_id, UInt32 bits)
+   : CoreStatePredictor(core_id)
+   , m_max((1 << bits) - 1)
+   , m_counter(0)
+{
+   LOG_ASSERT_ERROR(bits >= 1 && bits <= 16, "Invalid number of bits %d for core state predictor", bits);
+}
+
+void CoreStatePredictorNBit::update(Core::State actual)
+{
+   if (actual == Core::IDLE)
+   {
+      if (m_counter > 0)
+         --m_counter;
+   }
+   else
+   {
+      if (m_counter < m_max)
+         ++m_counter;
+   }
+}
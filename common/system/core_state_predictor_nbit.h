@@ -0,0 +1,22 @@
+#ifndef __CORE_STATE_PREDICTOR_NBIT_H
+#define __CORE_STATE_PREDICTOR_NBIT_H
+
+#include "core_state_predictor.h"
+
+// N-bit saturating counter predicting idle vs. active: incremented for every active interval,
+// decremented for every idle interval. Predicts RUNNING when the counter is in the upper half, else IDLE.
+
+class CoreStatePredictorNBit : public CoreStatePredictor
+{
+   public:
+      CoreStatePredictorNBit(core_id_t core_id, UInt32 bits);
+
+      void update(Core::State actual);
+      Core::State predict() { return m_counter >= m_max / 2 ? Core::RUNNING : Core::IDLE; }
+
+   private:
+      const UInt32 m_max;
+      UInt32 m_counter;
+};
+
+#endif // __CORE_STATE_PREDICTOR_NBIT_H
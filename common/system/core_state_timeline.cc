@@ -0,0 +1,142 @@
+#include "core_state_timeline.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "performance_model.h"
+#include "hooks_manager.h"
+#include "magic_server.h"
+#include "clock_skew_minimization_object.h"
+#include "config.hpp"
+#include "log.h"
+
+CoreStateTimeline* CoreStateTimeline::create()
+{
+   if (Sim()->getCfg()->getBool("core_state_timeline/enabled"))
+      return new CoreStateTimeline();
+   else
+      return NULL;
+}
+
+CoreStateTimeline::CoreStateTimeline()
+   : m_num_cores(Sim()->getConfig()->getApplicationCores())
+   , m_in_roi(false)
+   , m_fp(NULL)
+{
+   String filename = Sim()->getConfig()->formatOutputFileName("core_state_timeline.bin");
+   m_fp = fopen(filename.c_str(), "wb");
+   LOG_ASSERT_ERROR(m_fp, "Cannot write core state timeline %s", filename.c_str());
+
+   Header header = { MAGIC, VERSION, m_num_cores, sizeof(Run) };
+   fwrite(&header, sizeof(header), 1, m_fp);
+
+   for(UInt32 core_id = 0; core_id < m_num_cores; ++core_id)
+   {
+      CoreRun *run = new CoreRun();
+      run->state = Core::IDLE;
+      run->start = SubsecondTime::Zero();
+      run->in_roi = false;
+      run->started = false;
+      m_cores.push_back(run);
+   }
+   m_buffer.reserve(BUFFER_RUNS);
+
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_CORE_STATE_CHANGE, CoreStateTimeline::hook_core_state_change, (UInt64)this);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_BEGIN, CoreStateTimeline::hook_roi_begin, (UInt64)this);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_END, CoreStateTimeline::hook_roi_end, (UInt64)this);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_SIM_END, CoreStateTimeline::hook_sim_end, (UInt64)this);
+}
+
+CoreStateTimeline::~CoreStateTimeline()
+{
+   finish();
+   for(auto it = m_cores.begin(); it != m_cores.end(); ++it)
+      delete *it;
+}
+
+SInt64 CoreStateTimeline::hook_core_state_change(UInt64 self, UInt64 _info)
+{
+   HooksManager::CoreStateChange *info = (HooksManager::CoreStateChange *)_info;
+   ((CoreStateTimeline*)self)->stateChange(info->core_id, info->old_state, info->new_state, info->time);
+   return 0;
+}
+
+void CoreStateTimeline::stateChange(core_id_t core_id, Core::State old_state, Core::State new_state, SubsecondTime time)
+{
+   if ((UInt32)core_id >= m_num_cores)
+      return;
+
+   CoreRun *run = m_cores[core_id];
+   ScopedLock sl(run->lock);
+   if (!run->started)
+   {
+      // Everything before the first change was spent in its old state
+      run->state = old_state;
+      run->started = true;
+   }
+   endRun(core_id, time, new_state, m_in_roi);
+}
+
+void CoreStateTimeline::setROI(bool in_roi)
+{
+   SubsecondTime time = Sim()->getClockSkewMinimizationServer()->getGlobalTime();
+   m_in_roi = in_roi;
+   for(UInt32 core_id = 0; core_id < m_num_cores; ++core_id)
+   {
+      CoreRun *run = m_cores[core_id];
+      ScopedLock sl(run->lock);
+      if (!run->started)
+      {
+         run->state = Sim()->getCoreManager()->getCoreFromID(core_id)->getState();
+         run->started = true;
+      }
+      endRun(core_id, time, run->state, in_roi);
+   }
+}
+
+void CoreStateTimeline::finish()
+{
+   if (!m_fp)
+      return;
+
+   // Close every core's last run at the core's own time
+   for(UInt32 core_id = 0; core_id < m_num_cores; ++core_id)
+   {
+      CoreRun *run = m_cores[core_id];
+      Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+      ScopedLock sl(run->lock);
+      if (!run->started)
+         run->state = core->getState();
+      endRun(core_id, core->getPerformanceModel()->getElapsedTime(), run->state, run->in_roi);
+   }
+
+   ScopedLock sl(m_buffer_lock);
+   flush();
+   fclose(m_fp);
+   m_fp = NULL;
+}
+
+void CoreStateTimeline::endRun(core_id_t core_id, SubsecondTime time, Core::State new_state, bool in_roi)
+{
+   CoreRun *run = m_cores[core_id];
+   // Core-local time can lag behind the global time used for ROI boundaries, never let runs overlap
+   if (time > run->start)
+   {
+      Run record = { run->start.getFS(), (time - run->start).getFS(), UInt32(core_id), UInt16(run->state), UInt16(run->in_roi) };
+      ScopedLock sl(m_buffer_lock);
+      if (m_fp)
+      {
+         m_buffer.push_back(record);
+         if (m_buffer.size() == BUFFER_RUNS)
+            flush();
+      }
+      run->start = time;
+   }
+   run->state = new_state;
+   run->in_roi = in_roi;
+}
+
+void CoreStateTimeline::flush()
+{
+   if (!m_buffer.empty())
+      fwrite(m_buffer.data(), sizeof(Run), m_buffer.size(), m_fp);
+   m_buffer.clear();
+}
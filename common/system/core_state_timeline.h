@@ -0,0 +1,81 @@
+#ifndef __CORE_STATE_TIMELINE_H
+#define __CORE_STATE_TIMELINE_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "lock.h"
+#include "core.h"
+
+#include <vector>
+#include <cstdio>
+
+// Oracle timeline of core states ([core_state_timeline/enabled]), to score core-state predictors offline
+// (lib/sniper-branch-replay --core_state_timeline) instead of re-running a simulation for every predictor.
+// core_state_timeline.bin is a Header followed by Runs: periods during which a core stayed in one state, in fs of
+// the core's own time, so the file only grows with the number of state changes. Runs of different cores are
+// interleaved. Per core, they are in time order and cover the whole simulation; runs are split at ROI begin and end.
+
+class CoreStateTimeline
+{
+   public:
+      static const UInt32 MAGIC = 0x54534353; // "SCST"
+      static const UInt32 VERSION = 1;
+
+      struct Header
+      {
+         UInt32 magic;
+         UInt32 version;
+         UInt32 num_cores;
+         UInt32 run_size;
+      };
+
+      struct Run
+      {
+         UInt64 start;     // In fs
+         UInt64 length;    // In fs
+         UInt32 core_id;
+         UInt16 state;     // Core::State
+         UInt16 in_roi;
+      };
+
+      static CoreStateTimeline* create();
+
+      CoreStateTimeline();
+      ~CoreStateTimeline();
+
+   private:
+      static const UInt32 BUFFER_RUNS = 4096;
+
+      // The run a core is in now, only written out once it ends
+      struct CoreRun
+      {
+         Lock lock;
+         Core::State state;
+         SubsecondTime start;
+         bool in_roi;
+         bool started;    // No state change seen yet, the initial state is only known from the first one
+      };
+
+      const UInt32 m_num_cores;
+      std::vector<CoreRun*> m_cores;
+      bool m_in_roi;
+
+      FILE *m_fp;
+      std::vector<Run> m_buffer;
+      Lock m_buffer_lock;
+
+      static SInt64 hook_core_state_change(UInt64 self, UInt64 info);
+      static SInt64 hook_roi_begin(UInt64 self, UInt64) { ((CoreStateTimeline*)self)->setROI(true); return 0; }
+      static SInt64 hook_roi_end(UInt64 self, UInt64) { ((CoreStateTimeline*)self)->setROI(false); return 0; }
+      static SInt64 hook_sim_end(UInt64 self, UInt64) { ((CoreStateTimeline*)self)->finish(); return 0; }
+
+      void stateChange(core_id_t core_id, Core::State old_state, Core::State new_state, SubsecondTime time);
+      void setROI(bool in_roi);
+      void finish();
+
+      // Close the current run of a core at <time> and start a new one (caller holds the core's lock)
+      void endRun(core_id_t core_id, SubsecondTime time, Core::State new_state, bool in_roi);
+      void flush();
+};
+
+#endif // __CORE_STATE_TIMELINE_H
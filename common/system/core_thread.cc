@@ -6,6 +6,7 @@
 #include "core.h"
 #include "sim_thread_manager.h"
 #include "sim_api.h"
+#include "host_topology.h"
 
 #include <unistd.h>
 
@@ -26,6 +27,7 @@ void CoreThread::run()
    // Set thread name for Sniper-in-Sniper simulations
    String threadName = String("core-") + itostr(core_id);
    SimSetThreadName(threadName.c_str());
+   Sim()->getHostTopology()->bindThread(core_id);
 
    LOG_PRINT("Core thread starting...");
 
@@ -0,0 +1,183 @@
+#include "cstate_manager.h"
+#include "core_state_predictor_manager.h"
+#include "core_state_predictor.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "thread.h"
+#include "config.hpp"
+#include "stats.h"
+
+CStateManager* CStateManager::create()
+{
+   if (Sim()->getCfg()->getBool("cstate/enabled"))
+      return new CStateManager();
+   else
+      return NULL;
+}
+
+CStateManager::governor_t CStateManager::parseGovernor(String governor)
+{
+   if (governor == "deepest")
+      return GOVERNOR_DEEPEST;
+   else if (governor == "menu")
+      return GOVERNOR_MENU;
+   else if (governor == "predictor")
+   {
+      LOG_ASSERT_ERROR(Sim()->getCfg()->getString("core_state_predictor/type") != "none",
+                       "cstate/governor=predictor needs a core_state_predictor/type");
+      return GOVERNOR_PREDICTOR;
+   }
+   LOG_PRINT_ERROR("Unknown C-state governor %s", governor.c_str());
+   return GOVERNOR_MENU;
+}
+
+CStateManager::CStateManager()
+   : m_governor(parseGovernor(Sim()->getCfg()->getString("cstate/governor")))
+{
+   UInt32 num_states = Sim()->getCfg()->getInt("cstate/num_states");
+   LOG_ASSERT_ERROR(num_states > 0, "cstate/num_states must be at least 1");
+
+   for(UInt32 i = 0; i < num_states; ++i)
+   {
+      CState state = {
+         Sim()->getCfg()->getStringArray("cstate/name", i),
+         SubsecondTime::NS(Sim()->getCfg()->getIntArray("cstate/entry_latency", i)),
+         SubsecondTime::NS(Sim()->getCfg()->getIntArray("cstate/exit_latency", i)),
+         SubsecondTime::NS(Sim()->getCfg()->getIntArray("cstate/target_residency", i)),
+         Sim()->getCfg()->getFloatArray("cstate/leakage", i),
+      };
+      LOG_ASSERT_ERROR(i == 0 || state.target_residency >= m_states.back().target_residency,
+                       "C-states must be ordered from shallow to deep (non-decreasing cstate/target_residency)");
+      m_states.push_back(state);
+   }
+
+   UInt32 num_cores = Sim()->getConfig()->getApplicationCores();
+   m_cores.resize(num_cores);
+   for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+   {
+      CoreIdle &core = m_cores[core_id];
+      core.thread_id = INVALID_THREAD_ID;
+      core.state = 0;
+      core.since = SubsecondTime::Zero();
+      core.predicted = SubsecondTime::Zero();
+      core.leakage_saved = SubsecondTime::Zero();
+      core.wakeup_latency = SubsecondTime::Zero();
+      core.too_deep = 0;
+      core.too_shallow = 0;
+      core.stats.resize(num_states, StateStats{0, SubsecondTime::Zero()});
+
+      for(UInt32 i = 0; i < num_states; ++i)
+      {
+         registerStatsMetric("cstate", core_id, m_states[i].name + "-entries", &core.stats[i].entries);
+         registerStatsMetric("cstate", core_id, m_states[i].name + "-residency", &core.stats[i].residency);
+      }
+      registerStatsMetric("cstate", core_id, "wakeup-latency", &core.wakeup_latency);
+      registerStatsMetric("cstate", core_id, "too-deep", &core.too_deep);
+      registerStatsMetric("cstate", core_id, "too-shallow", &core.too_shallow);
+   }
+}
+
+void CStateManager::threadStall(thread_id_t thread_id, ThreadManager::stall_type_t reason, SubsecondTime time)
+{
+   // Threads without a core (or on a broken one) don't leave an idle core behind
+   if (reason == ThreadManager::STALL_UNSCHEDULED || reason == ThreadManager::STALL_BROKEN)
+      return;
+
+   Core *core = Sim()->getThreadManager()->getThreadFromID(thread_id)->getCore();
+   if (!core || core->getId() >= (core_id_t)m_cores.size())
+      return;
+
+   core_id_t core_id = core->getId();
+   // Another thread that idled here was moved away and hasn't resumed yet: its idle period ends now
+   if (m_cores[core_id].thread_id != INVALID_THREAD_ID)
+      wake(core_id, time);
+
+   CoreIdle &idle = m_cores[core_id];
+   idle.thread_id = thread_id;
+   idle.state = selectState(core_id);
+   idle.since = time;
+   ++idle.stats[idle.state].entries;
+
+   if (m_thread_core.size() <= (size_t)thread_id)
+      m_thread_core.resize(thread_id + 1, INVALID_CORE_ID);
+   m_thread_core[thread_id] = core_id;
+
+   core->setState(Core::SLEEPING);
+}
+
+SubsecondTime CStateManager::threadResume(thread_id_t thread_id, SubsecondTime time)
+{
+   if ((size_t)thread_id >= m_thread_core.size() || m_thread_core[thread_id] == INVALID_CORE_ID)
+      return SubsecondTime::Zero();
+
+   core_id_t core_id = m_thread_core[thread_id];
+   m_thread_core[thread_id] = INVALID_CORE_ID;
+   if (m_cores[core_id].thread_id != thread_id)
+      return SubsecondTime::Zero();
+
+   SubsecondTime latency = wake(core_id, time);
+
+   // If the thread was moved to another core while stalled, it doesn't wait for this one to wake up
+   Core *core = Sim()->getThreadManager()->getThreadFromID(thread_id)->getCore();
+   if (!core || core->getId() != core_id)
+      return SubsecondTime::Zero();
+
+   m_cores[core_id].wakeup_latency += latency;
+   if (core->getState() == Core::SLEEPING)
+      core->setState(Core::RUNNING);
+
+   return latency;
+}
+
+SubsecondTime CStateManager::wake(core_id_t core_id, SubsecondTime time)
+{
+   CoreIdle &idle = m_cores[core_id];
+   const CState &state = m_states[idle.state];
+
+   SubsecondTime duration = time > idle.since ? time - idle.since : SubsecondTime::Zero();
+   idle.stats[idle.state].residency += duration;
+   if (duration > state.entry_latency)
+      idle.leakage_saved += (duration - state.entry_latency) * (1. - state.leakage);
+
+   // Score the choice against the state that would have been best for this idle period
+   UInt32 best = fittingState(duration);
+   if (idle.state > best)
+      ++idle.too_deep;
+   else if (idle.state < best)
+      ++idle.too_shallow;
+
+   idle.predicted = (idle.predicted + duration) / 2;
+   idle.thread_id = INVALID_THREAD_ID;
+
+   return state.exit_latency;
+}
+
+UInt32 CStateManager::selectState(core_id_t core_id)
+{
+   switch(m_governor)
+   {
+      case GOVERNOR_DEEPEST:
+         return m_states.size() - 1;
+
+      case GOVERNOR_PREDICTOR:
+      {
+         CoreStatePredictor *predictor = Sim()->getCoreStatePredictorManager()->getPredictor(core_id);
+         if (predictor->isConfident())
+            return predictor->predict() == Core::RUNNING ? 0 : m_states.size() - 1;
+         // Not confident: fall back to the menu governor
+         return fittingState(m_cores[core_id].predicted);
+      }
+
+      case GOVERNOR_MENU:
+      default:
+         return fittingState(m_cores[core_id].predicted);
+   }
+}
+
+UInt32 CStateManager::fittingState(SubsecondTime duration)
+{
+   UInt32 state = 0;
+   while (state + 1 < m_states.size() && m_states[state + 1].target_residency <= duration)
+      ++state;
+   return state;
+}
@@ -0,0 +1,83 @@
+#ifndef __CSTATE_MANAGER_H
+#define __CSTATE_MANAGER_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "thread_manager.h"
+
+#include <vector>
+
+// Idle (C-)states of application cores ([cstate])
+//
+// When a thread stalls on its core (join, mutex, futex, sleep, ...), the core enters one of a ladder of idle states,
+// chosen by a governor:
+// - deepest: always the deepest state
+// - menu: the deepest state whose target residency fits the predicted idle time (running average of past idle times)
+// - predictor: the deepest state when the native core-state predictor confidently predicts the core not to be running,
+//   the shallowest when it predicts it to be running, and the menu choice otherwise
+// Resuming the thread adds the exit latency of the state to its wakeup time, so wakeup latency is on the critical path.
+// Time spent in a state (after its entry latency) saves the state's fraction of static power in the energy model.
+
+class CStateManager
+{
+   public:
+      static CStateManager* create();
+
+      CStateManager();
+
+      // Called by ThreadManager with the thread lock held
+      void threadStall(thread_id_t thread_id, ThreadManager::stall_type_t reason, SubsecondTime time);
+      // Returns the exit latency the core takes to leave its idle state
+      SubsecondTime threadResume(thread_id_t thread_id, SubsecondTime time);
+
+      // Total time of static power saved by a core in idle states (residency weighted by 1 - leakage)
+      SubsecondTime getLeakageSavedTime(core_id_t core_id) const { return m_cores.at(core_id).leakage_saved; }
+
+   private:
+      enum governor_t
+      {
+         GOVERNOR_DEEPEST,
+         GOVERNOR_MENU,
+         GOVERNOR_PREDICTOR,
+      };
+
+      struct CState
+      {
+         String name;
+         SubsecondTime entry_latency;
+         SubsecondTime exit_latency;
+         SubsecondTime target_residency;
+         double leakage;  // Fraction of static power remaining in this state
+      };
+
+      struct StateStats
+      {
+         UInt64 entries;
+         SubsecondTime residency;
+      };
+
+      struct CoreIdle
+      {
+         thread_id_t thread_id;  // Stalled thread, INVALID_THREAD_ID when the core is not idle
+         UInt32 state;
+         SubsecondTime since;
+         SubsecondTime predicted;
+         SubsecondTime leakage_saved;
+         SubsecondTime wakeup_latency;
+         UInt64 too_deep;
+         UInt64 too_shallow;
+         std::vector<StateStats> stats;
+      };
+
+      const governor_t m_governor;
+      std::vector<CState> m_states;
+      std::vector<CoreIdle> m_cores;
+      std::vector<core_id_t> m_thread_core;  // Core a stalled thread is idling on
+
+      static governor_t parseGovernor(String governor);
+      UInt32 selectState(core_id_t core_id);
+      UInt32 fittingState(SubsecondTime duration);
+      SubsecondTime wake(core_id_t core_id, SubsecondTime time);
+};
+
+#endif // __CSTATE_MANAGER_H
@@ -0,0 +1,196 @@
+#include "deterministic_order.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "core.h"
+#include "thread.h"
+#include "thread_manager.h"
+#include "performance_model.h"
+#include "config.hpp"
+#include "log.h"
+
+#include <sched.h>
+
+// Nesting depth of the current host thread (trace threads each have their own host thread, see create())
+static __thread UInt32 t_depth = 0;
+
+DeterministicOrder* DeterministicOrder::create()
+{
+   if (!Sim()->getCfg()->getBool("clock_skew_minimization/barrier/deterministic"))
+      return NULL;
+
+   LOG_ASSERT_ERROR(Sim()->getCfg()->getString("clock_skew_minimization/scheme") == "barrier",
+      "clock_skew_minimization/barrier/deterministic requires clock_skew_minimization/scheme = barrier");
+   // Cores running ahead of the barrier would be released without their new time being known
+   LOG_ASSERT_ERROR(!Sim()->getCfg()->getBool("clock_skew_minimization/barrier/relaxed"),
+      "clock_skew_minimization/barrier/deterministic cannot be combined with clock_skew_minimization/barrier/relaxed");
+   // A fiber waiting for its turn would block the worker that has to run the fiber it waits for
+   LOG_ASSERT_ERROR(!Sim()->getCfg()->getBool("traceinput/enabled") || !Sim()->getCfg()->getBool("traceinput/thread_pool"),
+      "clock_skew_minimization/barrier/deterministic cannot be combined with traceinput/thread_pool");
+
+   return new DeterministicOrder();
+}
+
+DeterministicOrder::DeterministicOrder()
+   : m_num_cores(Sim()->getConfig()->getApplicationCores())
+   , m_turns(new Turn[m_num_cores])
+   , m_core_thread(m_num_cores, INVALID_THREAD_ID)
+{
+   for(UInt32 core_id = 0; core_id < m_num_cores; ++core_id)
+      setTime(core_id, IDLE);
+
+   // After possible reschedulings, so we know where threads end up
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_THREAD_CREATE, DeterministicOrder::hookThreadCreate, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_THREAD_MIGRATE, DeterministicOrder::hookThreadMigrate, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_THREAD_STALL, DeterministicOrder::hookThreadStall, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_THREAD_RESUME, DeterministicOrder::hookThreadResume, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_THREAD_EXIT, DeterministicOrder::hookThreadExit, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
+}
+
+DeterministicOrder::~DeterministicOrder()
+{
+   delete [] m_turns;
+}
+
+bool
+DeterministicOrder::mustWait(core_id_t core_id, UInt64 time, core_id_t &other)
+{
+   // Check the core that held us back last time first, it is the most likely one to do so again
+   if (other != INVALID_CORE_ID)
+   {
+      UInt64 other_time = m_turns[other].time.load();
+      if (other_time < time || (other_time == time && other < core_id))
+         return true;
+   }
+   for(core_id_t core = 0; core < (core_id_t)m_num_cores; ++core)
+   {
+      if (core == core_id)
+         continue;
+      UInt64 other_time = m_turns[core].time.load();
+      if (other_time < time || (other_time == time && core < core_id))
+      {
+         other = core;
+         return true;
+      }
+   }
+   return false;
+}
+
+void
+DeterministicOrder::acquire(core_id_t core_id, SubsecondTime time)
+{
+   if (t_depth++)
+      return;
+
+   // Our published time may only go up while we run: other cores have already gone ahead of it
+   UInt64 now = time.getFS();
+   UInt64 published = m_turns[core_id].time.load();
+   if (published != IDLE && published > now)
+      now = published;
+   setTime(core_id, now);
+
+   core_id_t other = INVALID_CORE_ID;
+   for(UInt64 spins = 0; mustWait(core_id, now, other); ++spins)
+   {
+      if (spins > 1000)
+         sched_yield();
+      else
+         __builtin_ia32_pause();
+   }
+}
+
+void
+DeterministicOrder::release(core_id_t core_id)
+{
+   LOG_ASSERT_ERROR(t_depth > 0, "Core %d leaves a deterministic interaction it did not enter", core_id);
+   // Our time stays published: the next core can go once we want to interact at a later time, or stop running
+   --t_depth;
+}
+
+void
+DeterministicOrder::threadIdle(thread_id_t thread_id)
+{
+   std::unordered_map<thread_id_t, core_id_t>::iterator it = m_thread_core.find(thread_id);
+   if (it != m_thread_core.end() && it->second != INVALID_CORE_ID && m_core_thread[it->second] == thread_id)
+      setTime(it->second, IDLE);
+}
+
+void
+DeterministicOrder::threadRunning(thread_id_t thread_id, SubsecondTime time)
+{
+   // Only threads that are actually running hold back other cores
+   if (!Sim()->getThreadManager()->isThreadRunning(thread_id))
+      return;
+   std::unordered_map<thread_id_t, core_id_t>::iterator it = m_thread_core.find(thread_id);
+   if (it != m_thread_core.end() && it->second != INVALID_CORE_ID && m_core_thread[it->second] == thread_id)
+      setTime(it->second, time.getFS());
+}
+
+void
+DeterministicOrder::threadCreate(HooksManager::ThreadCreate *args)
+{
+   Thread *thread = Sim()->getThreadManager()->getThreadFromID(args->thread_id);
+   if (!thread->getCore())
+      return;
+
+   // The new thread cannot start before its creator's current time
+   SubsecondTime time = SubsecondTime::Zero();
+   if (args->creator_thread_id != INVALID_THREAD_ID)
+   {
+      Core *creator = Sim()->getThreadManager()->getThreadFromID(args->creator_thread_id)->getCore();
+      if (creator)
+         time = creator->getPerformanceModel()->getElapsedTime();
+   }
+
+   core_id_t core_id = thread->getCore()->getId();
+   m_thread_core[args->thread_id] = core_id;
+   m_core_thread[core_id] = args->thread_id;
+   setTime(core_id, time.getFS());
+}
+
+void
+DeterministicOrder::threadMigrate(HooksManager::ThreadMigrate *args)
+{
+   std::unordered_map<thread_id_t, core_id_t>::iterator it = m_thread_core.find(args->thread_id);
+   if (it != m_thread_core.end() && it->second != INVALID_CORE_ID && it->second != args->core_id && m_core_thread[it->second] == args->thread_id)
+   {
+      m_core_thread[it->second] = INVALID_THREAD_ID;
+      setTime(it->second, IDLE);
+   }
+
+   m_thread_core[args->thread_id] = args->core_id;
+   if (args->core_id != INVALID_CORE_ID)
+   {
+      m_core_thread[args->core_id] = args->thread_id;
+      if (Sim()->getThreadManager()->isThreadRunning(args->thread_id))
+         setTime(args->core_id, SubsecondTime(args->time).getFS());
+      else
+         setTime(args->core_id, IDLE);
+   }
+}
+
+void
+DeterministicOrder::threadExit(thread_id_t thread_id)
+{
+   threadIdle(thread_id);
+   std::unordered_map<thread_id_t, core_id_t>::iterator it = m_thread_core.find(thread_id);
+   if (it != m_thread_core.end())
+   {
+      if (it->second != INVALID_CORE_ID && m_core_thread[it->second] == thread_id)
+         m_core_thread[it->second] = INVALID_THREAD_ID;
+      m_thread_core.erase(it);
+   }
+}
+
+DeterministicOrder::Scope::Scope(core_id_t core_id, SubsecondTime time)
+   : m_order(Sim()->getDeterministicOrder())
+   , m_core_id(core_id)
+{
+   if (m_order)
+      m_order->acquire(m_core_id, time);
+}
+
+DeterministicOrder::Scope::~Scope()
+{
+   if (m_order)
+      m_order->release(m_core_id);
+}
@@ -0,0 +1,86 @@
+#ifndef __DETERMINISTIC_ORDER_H
+#define __DETERMINISTIC_ORDER_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "hooks_manager.h"
+
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+
+// Deterministic parallel simulation ([clock_skew_minimization/barrier/deterministic]).
+//
+// Cores keep running in parallel on their own host threads, but every interaction with state that other cores
+// can see (memory accesses, system calls, thread creation and joins, magic instructions) is done in a canonical
+// order: by the simulated time of the core, then by core id. Each core publishes its time when it wants to interact,
+// and may only go ahead once no other running core can still interact at an earlier (time, core id).
+// This is a deterministic turn (as in Kendo, Olszewski et al., ASPLOS 2009) with simulated time as the logical clock,
+// so results no longer depend on how host threads interleave inside a quantum.
+// Cores without a running thread, or waiting in the barrier, do not hold back the others; cores leaving that state
+// are given their new time by whoever releases them (the waker, or the barrier), which is itself done in turn.
+//
+// Only one core at a time is inside an interaction, and a core waits for the slowest running core to catch up
+// before it can interact, so this costs simulation speed, in particular with many memory-intensive cores.
+
+class DeterministicOrder
+{
+   public:
+      static DeterministicOrder* create();
+
+      DeterministicOrder();
+      ~DeterministicOrder();
+
+      // Wait for our turn to interact at <time>. Calls nest (per host thread), only the outermost one waits
+      void acquire(core_id_t core_id, SubsecondTime time);
+      void release(core_id_t core_id);
+
+      // Threads entering and leaving the barrier, called with the thread manager lock held
+      void threadIdle(thread_id_t thread_id);
+      void threadRunning(thread_id_t thread_id, SubsecondTime time);
+
+      class Scope
+      {
+         public:
+            Scope(core_id_t core_id, SubsecondTime time);
+            ~Scope();
+         private:
+            DeterministicOrder *m_order;
+            core_id_t m_core_id;
+      };
+
+   private:
+      static const UInt64 IDLE = UINT64_MAX;
+
+      struct Turn
+      {
+         std::atomic<UInt64> time;   // fs, IDLE when the core does not run
+      } __attribute__((aligned(64)));
+
+      const UInt32 m_num_cores;
+      Turn *m_turns;
+      // Which thread runs where, updated from (serialized) thread hooks
+      std::unordered_map<thread_id_t, core_id_t> m_thread_core;
+      std::vector<thread_id_t> m_core_thread;
+
+      void setTime(core_id_t core_id, UInt64 time) { m_turns[core_id].time.store(time); }
+      bool mustWait(core_id_t core_id, UInt64 time, core_id_t &other);
+
+      static SInt64 hookThreadCreate(UInt64 object, UInt64 argument)
+      { ((DeterministicOrder*)object)->threadCreate((HooksManager::ThreadCreate*)argument); return 0; }
+      static SInt64 hookThreadMigrate(UInt64 object, UInt64 argument)
+      { ((DeterministicOrder*)object)->threadMigrate((HooksManager::ThreadMigrate*)argument); return 0; }
+      static SInt64 hookThreadStall(UInt64 object, UInt64 argument)
+      { ((DeterministicOrder*)object)->threadIdle(((HooksManager::ThreadStall*)argument)->thread_id); return 0; }
+      static SInt64 hookThreadResume(UInt64 object, UInt64 argument)
+      { HooksManager::ThreadResume *args = (HooksManager::ThreadResume*)argument;
+        ((DeterministicOrder*)object)->threadRunning(args->thread_id, args->time); return 0; }
+      static SInt64 hookThreadExit(UInt64 object, UInt64 argument)
+      { ((DeterministicOrder*)object)->threadExit(((HooksManager::ThreadTime*)argument)->thread_id); return 0; }
+
+      void threadCreate(HooksManager::ThreadCreate *args);
+      void threadMigrate(HooksManager::ThreadMigrate *args);
+      void threadExit(thread_id_t thread_id);
+};
+
+#endif // __DETERMINISTIC_ORDER_H
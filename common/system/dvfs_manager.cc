@@ -1,5 +1,7 @@
 
 #include <cassert>
+#include <cstring>
+#include <algorithm>
 
 #include "dvfs_manager.h"
 #include "simulator.h"
@@ -9,13 +11,20 @@
 #include "instruction.h"
 #include "log.h"
 #include "config.hpp"
+#include "stats.h"
+#include "clock_skew_minimization_object.h"
+#include "hooks_manager.h"
 
 DvfsManager::DvfsManager()
+   : m_trace_fp(NULL)
+   , m_trace_time(SubsecondTime::Zero())
+   , m_trace_pending(false)
+   , m_async(false)
+   , m_pending(NULL)
 {
    m_num_app_cores = Config::getSingleton()->getApplicationCores();
 
    m_cores_per_socket = Sim()->getCfg()->getInt("dvfs/simple/cores_per_socket");
-   m_transition_latency = SubsecondTime::NS() * Sim()->getCfg()->getInt("dvfs/transition_latency");
 
    LOG_ASSERT_ERROR("simple" == Sim()->getCfg()->getString("dvfs/type"), "Currently, only this simple dvfs scheme is defined");
 
@@ -46,6 +55,60 @@ DvfsManager::DvfsManager()
 
    // Allocate global domains for all other non-application processors
    global_domains.resize(DOMAIN_GLOBAL_MAX, core_period);
+
+   // Transition cost can be set per domain: dvfs/transition_latency[] and dvfs/transition_energy[]
+   m_transitions.resize(m_num_proc_domains);
+   for(UInt32 domain_id = 0; domain_id < m_num_proc_domains; ++domain_id)
+   {
+      DomainTransition &transition = m_transitions[domain_id];
+      transition.latency = SubsecondTime::NS() * Sim()->getCfg()->getIntArray("dvfs/transition_latency", domain_id);
+      transition.energy = 1000 * Sim()->getCfg()->getFloatArray("dvfs/transition_energy", domain_id);
+      transition.transitions = 0;
+      transition.total_latency = SubsecondTime::Zero();
+      transition.total_energy = 0;
+      registerStatsMetric("dvfs", domain_id, "transitions", &transition.transitions);
+      registerStatsMetric("dvfs", domain_id, "transition-time", &transition.total_latency);
+      registerStatsMetric("dvfs", domain_id, "transition-energy", &transition.total_energy);
+   }
+
+   if (Sim()->getCfg()->getBool("dvfs/async"))
+   {
+      // A shared domain would have to be changed from the thread of one of its cores while the others run
+      if (m_cores_per_socket == 1)
+      {
+         m_async = true;
+         m_pending = new PendingChanges[m_num_app_cores];
+      }
+      else
+         LOG_PRINT_WARNING("dvfs/async requires dvfs/simple/cores_per_socket = 1, frequency changes remain synchronous");
+   }
+
+   if (Sim()->getCfg()->getBool("dvfs/trace"))
+   {
+      // sim.dvfs.bin: "SNIPDVFS", UInt64 version, UInt64 number of domains, UInt64 cores per domain,
+      // then one record per change: UInt64 global time (fs), UInt32 frequency (MHz) of each domain (zero padded to 8 bytes)
+      String filename = Sim()->getConfig()->formatOutputFileName("sim.dvfs.bin");
+      m_trace_fp = fopen(filename.c_str(), "w");
+      LOG_ASSERT_ERROR(m_trace_fp, "Cannot create %s", filename.c_str());
+
+      UInt64 header[4] = { 0, 1, m_num_proc_domains, m_cores_per_socket };
+      memcpy(&header[0], "SNIPDVFS", 8);
+      fwrite(header, sizeof(header), 1, m_trace_fp);
+
+      m_trace_record.resize((m_num_proc_domains + 1) & ~1, 0);
+      traceDomains();
+   }
+}
+
+DvfsManager::~DvfsManager()
+{
+   if (m_pending)
+      delete [] m_pending;
+   if (m_trace_fp)
+   {
+      flushTrace();
+      fclose(m_trace_fp);
+   }
 }
 
 UInt32 DvfsManager::getCoreDomainId(UInt32 core_id)
@@ -81,14 +144,8 @@ void DvfsManager::setCoreDomain(UInt32 core_id, ComponentPeriod new_freq)
 {
    if (core_id < m_num_app_cores)
    {
-      if (new_freq.getPeriod() != app_proc_domains[getCoreDomainId(core_id)].getPeriod())
-      {
-         /* queue a fake instruction that will account for the transition latency */
-         PseudoInstruction *i = new DelayInstruction(m_transition_latency, DelayInstruction::DVFS_TRANSITION);
-         Sim()->getCoreManager()->getCoreFromID(core_id)->getPerformanceModel()->queuePseudoInstruction(i);
-      }
-
-      app_proc_domains[getCoreDomainId(core_id)] = new_freq;
+      if (transitionDomain(getCoreDomainId(core_id), new_freq))
+         traceDomains();
    }
    else
    {
@@ -96,3 +153,115 @@ void DvfsManager::setCoreDomain(UInt32 core_id, ComponentPeriod new_freq)
       LOG_PRINT_ERROR("Cannot change non-core frequency");
    }
 }
+
+std::vector<UInt32> DvfsManager::setCoreDomains(const std::vector<UInt64> &freqs_in_mhz)
+{
+   LOG_ASSERT_ERROR(freqs_in_mhz.size() == m_num_app_cores, "Expected %u frequencies, got %u", m_num_app_cores, freqs_in_mhz.size());
+
+   std::vector<UInt64> domain_freqs(m_num_proc_domains, 0);
+   for(UInt32 core_id = 0; core_id < m_num_app_cores; ++core_id)
+      domain_freqs[getCoreDomainId(core_id)] = std::max(domain_freqs[getCoreDomainId(core_id)], freqs_in_mhz[core_id]);
+
+   std::vector<UInt32> changed;
+   for(UInt32 domain_id = 0; domain_id < m_num_proc_domains; ++domain_id)
+   {
+      if (domain_freqs[domain_id] && transitionDomain(domain_id, ComponentPeriod::fromFreqHz(1000000 * domain_freqs[domain_id])))
+      {
+         for(UInt32 core_id = domain_id * m_cores_per_socket; core_id < std::min((domain_id + 1) * m_cores_per_socket, m_num_app_cores); ++core_id)
+            changed.push_back(core_id);
+      }
+   }
+
+   if (changed.size())
+      traceDomains();
+
+   return changed;
+}
+
+void DvfsManager::postCoreDomain(UInt32 core_id, ComponentPeriod new_freq, SubsecondTime time)
+{
+   LOG_ASSERT_ERROR(m_async, "Asynchronous frequency changes are not enabled");
+   LOG_ASSERT_ERROR(core_id < m_num_app_cores, "Cannot change non-core frequency");
+
+   PendingChanges &pending = m_pending[core_id];
+   ScopedLock sl(pending.lock);
+   // Changes posted for the same time keep their order
+   auto it = pending.changes.begin();
+   while (it != pending.changes.end() && it->first <= time)
+      ++it;
+   pending.changes.insert(it, std::make_pair(time, new_freq));
+   pending.next.store(pending.changes.front().first.getFS(), std::memory_order_release);
+}
+
+void DvfsManager::applyPendingChanges(UInt32 core_id, SubsecondTime now)
+{
+   PendingChanges &pending = m_pending[core_id];
+   bool changed = false;
+   {
+      ScopedLock sl(pending.lock);
+      // Each change that has come due is a transition of its own, as if it had been applied right on time
+      auto it = pending.changes.begin();
+      for( ; it != pending.changes.end() && it->first <= now; ++it)
+         changed |= transitionDomain(getCoreDomainId(core_id), it->second);
+      pending.changes.erase(pending.changes.begin(), it);
+      pending.next.store(pending.changes.empty() ? UINT64_MAX : pending.changes.front().first.getFS(), std::memory_order_release);
+   }
+
+   if (changed)
+   {
+      traceDomains();
+      Sim()->getHooksManager()->callHooks(HookType::HOOK_CPUFREQ_CHANGE, core_id);
+   }
+}
+
+bool DvfsManager::transitionDomain(UInt32 domain_id, ComponentPeriod new_freq)
+{
+   if (new_freq.getPeriod() == app_proc_domains[domain_id].getPeriod())
+      return false;
+
+   DomainTransition &transition = m_transitions[domain_id];
+   if (transition.latency > SubsecondTime::Zero())
+   {
+      /* queue a fake instruction on all cores in the domain that will account for the transition latency */
+      for(UInt32 core_id = domain_id * m_cores_per_socket; core_id < std::min((domain_id + 1) * m_cores_per_socket, m_num_app_cores); ++core_id)
+      {
+         PseudoInstruction *i = new DelayInstruction(transition.latency, DelayInstruction::DVFS_TRANSITION);
+         Sim()->getCoreManager()->getCoreFromID(core_id)->getPerformanceModel()->queuePseudoInstruction(i);
+      }
+   }
+   ++transition.transitions;
+   transition.total_latency += transition.latency;
+   transition.total_energy += transition.energy;
+
+   app_proc_domains[domain_id] = new_freq;
+   return true;
+}
+
+void DvfsManager::traceDomains()
+{
+   if (!m_trace_fp)
+      return;
+
+   ScopedLock sl(m_trace_lock);
+
+   // Changes made at the same global time (e.g. by a script setting cores one by one) share a single record
+   SubsecondTime now = Sim()->getClockSkewMinimizationServer() ? Sim()->getClockSkewMinimizationServer()->getGlobalTime() : SubsecondTime::Zero();
+   if (m_trace_pending && now != m_trace_time)
+      flushTrace();
+
+   for(UInt32 domain_id = 0; domain_id < m_num_proc_domains; ++domain_id)
+      m_trace_record[domain_id] = 1000000000 / app_proc_domains[domain_id].getPeriod().getFS();
+   m_trace_time = now;
+   m_trace_pending = true;
+}
+
+void DvfsManager::flushTrace()
+{
+   if (!m_trace_pending)
+      return;
+
+   UInt64 time = m_trace_time.getFS();
+   fwrite(&time, sizeof(time), 1, m_trace_fp);
+   fwrite(m_trace_record.data(), sizeof(UInt32), m_trace_record.size(), m_trace_fp);
+   m_trace_pending = false;
+}
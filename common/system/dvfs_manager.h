@@ -2,8 +2,11 @@
 #define __DVFS_MANAGER_H
 
 #include "subsecond_time.h"
+#include "lock.h"
 
+#include <atomic>
 #include <vector>
+#include <stdio.h>
 
 // Each process has a copy of all global frequencies, and of the core frequencies local to that process
 // In addition, process 0 has a copy of all core frequencies so as to quickly fulfill queries from the MCP/scripts
@@ -17,20 +20,68 @@ public:
       DOMAIN_GLOBAL_MAX
    };
    DvfsManager();
+   ~DvfsManager();
    UInt32 getCoreDomainId(UInt32 core_id);
+   UInt32 getNumCoreDomains() const { return m_num_proc_domains; }
    const ComponentPeriod* getCoreDomain(UInt32 core_id);
    const ComponentPeriod* getGlobalDomain(DvfsGlobalDomain domain_id = DOMAIN_GLOBAL_DEFAULT);
+
+   // Asynchronous frequency changes ([dvfs/async], only with one core per domain): changes are posted with a
+   // timestamp and applied by the core's own thread once its time reaches it, without the thread lock or a barrier
+   bool isAsync() const { return m_async; }
+   void postCoreDomain(UInt32 core_id, ComponentPeriod new_freq, SubsecondTime time);
+   // Called by the core's thread at every instruction boundary, cheap when no change is due
+   void applyPending(UInt32 core_id, SubsecondTime now)
+   {
+      if (m_async && core_id < m_num_app_cores && now.getFS() >= m_pending[core_id].next.load(std::memory_order_acquire))
+         applyPendingChanges(core_id, now);
+   }
 protected:
    // Make sure all frequency updates pass through the correct path
    void setCoreDomain(UInt32 core_id, ComponentPeriod new_freq);
+   // Apply new frequencies for all application cores at once (0: leave the core's domain unchanged).
+   // When cores sharing a domain ask for different frequencies, the domain runs at the highest one.
+   // Returns the ids of the cores for which the frequency changed.
+   std::vector<UInt32> setCoreDomains(const std::vector<UInt64> &freqs_in_mhz);
    friend class MagicServer;
+   friend class CoreStatePredictorManager;
 private:
+   struct DomainTransition {
+      SubsecondTime latency;  // Time the domain's cores are stalled while voltage and frequency settle
+      UInt64 energy;          // Energy spent per transition, in pJ
+      UInt64 transitions;
+      SubsecondTime total_latency;
+      UInt64 total_energy;
+   };
+
    UInt32 m_cores_per_socket;
-   SubsecondTime m_transition_latency;
    UInt32 m_num_proc_domains;
    UInt32 m_num_app_cores;
    std::vector<ComponentPeriod> app_proc_domains;
    std::vector<ComponentPeriod> global_domains;
+   std::vector<DomainTransition> m_transitions;
+
+   // Frequency trace (dvfs/trace): the frequencies of all core domains after each change, one record per global time
+   FILE *m_trace_fp;
+   SubsecondTime m_trace_time;
+   bool m_trace_pending;
+   std::vector<UInt32> m_trace_record;
+
+   struct PendingChanges {
+      Lock lock;
+      std::atomic<UInt64> next;  // Time (in fs) of the earliest posted change, UINT64_MAX if there is none
+      std::vector<std::pair<SubsecondTime, ComponentPeriod> > changes;  // Ordered by time
+      PendingChanges() : next(UINT64_MAX) {}
+   };
+
+   bool m_async;
+   PendingChanges *m_pending;
+   Lock m_trace_lock;  // Asynchronous changes trace from the core threads
+
+   void applyPendingChanges(UInt32 core_id, SubsecondTime now);
+   bool transitionDomain(UInt32 domain_id, ComponentPeriod new_freq);
+   void traceDomains();
+   void flushTrace();
 };
 
 #endif /* __DVFS_MANAGER_H */
@@ -0,0 +1,168 @@
+#include "energy_model.h"
+#include "simulator.h"
+#include "hooks_manager.h"
+#include "dvfs_manager.h"
+#include "thread_manager.h"
+#include "cstate_manager.h"
+#include "clock_skew_minimization_object.h"
+#include "stats.h"
+#include "log.h"
+
+#include <algorithm>
+
+EnergyModel::EnergyModel()
+   : m_last_time(SubsecondTime::Zero())
+   , m_hooks_registered(false)
+{
+}
+
+EnergyModel::~EnergyModel()
+{
+   for(std::vector<Component*>::iterator it = m_components.begin(); it != m_components.end(); ++it)
+      delete *it;
+}
+
+void EnergyModel::setComponent(String name, UInt32 index, core_id_t core_id, double static_power, const std::vector<Term> &terms)
+{
+   LOG_ASSERT_ERROR(core_id == INVALID_CORE_ID || core_id < (core_id_t)Sim()->getConfig()->getApplicationCores(),
+                    "Invalid core %d for energy model component %s[%u]", core_id, name.c_str(), index);
+
+   if (!m_hooks_registered)
+   {
+      m_last_time = Sim()->getClockSkewMinimizationServer()->getGlobalTime();
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, EnergyModel::hook_update, (UInt64)this);
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_PRE_STAT_WRITE, EnergyModel::hook_update, (UInt64)this);
+      m_hooks_registered = true;
+   }
+   else
+   {
+      // Account for the time so far with the old coefficients
+      update();
+   }
+
+   Component *component = findComponent(name, index);
+   if (!component)
+   {
+      component = new Component();
+      component->name = name;
+      component->index = index;
+      component->energy_static = 0;
+      component->energy_dynamic = 0;
+      component->power_static = 0;
+      component->power_dynamic = 0;
+      m_components.push_back(component);
+      registerStatsMetric(name, index, "energy-static", &component->energy_static);
+      registerStatsMetric(name, index, "energy-dynamic", &component->energy_dynamic);
+   }
+
+   component->core_id = core_id;
+   component->static_power = static_power;
+   component->vdd_ref = getVdd(core_id);
+   component->last_saved = getLeakageSavedTime(core_id);
+   component->terms = terms;
+   component->last_values.resize(terms.size());
+   for(UInt32 i = 0; i < terms.size(); ++i)
+      component->last_values[i] = terms[i].metric->recordMetric();
+}
+
+void EnergyModel::setVddTable(const std::vector<std::pair<UInt64, double> > &table)
+{
+   update();
+   m_vdd_table = table;
+
+   // Coefficients are valid for the frequency the component was defined at
+   for(std::vector<Component*>::iterator it = m_components.begin(); it != m_components.end(); ++it)
+      (*it)->vdd_ref = getVdd((*it)->core_id);
+}
+
+void EnergyModel::update()
+{
+   SubsecondTime now = Sim()->getClockSkewMinimizationServer()->getGlobalTime();
+   if (now <= m_last_time)
+      return;
+   double time_delta = (now - m_last_time).getFS();
+   m_last_time = now;
+
+   for(std::vector<Component*>::iterator it = m_components.begin(); it != m_components.end(); ++it)
+   {
+      Component *component = *it;
+      double scale = getVdd(component->core_id) / component->vdd_ref;
+
+      // Time in idle states of the component's core only leaks a fraction of static power
+      SubsecondTime saved = getLeakageSavedTime(component->core_id);
+      double time_static = time_delta;
+      if (saved > component->last_saved)
+         time_static = std::max(0., time_static - (saved - component->last_saved).getFS());
+      component->last_saved = saved;
+
+      // W * fs = fJ
+      double energy_static = scale * component->static_power * time_static;
+
+      double energy_dynamic = 0;
+      for(UInt32 i = 0; i < component->terms.size(); ++i)
+      {
+         UInt64 value = component->terms[i].metric->recordMetric();
+         // Statistics can be reset (e.g. at the start of the ROI), don't count negative activity
+         if (value > component->last_values[i])
+            energy_dynamic += (value - component->last_values[i]) * component->terms[i].energy * 1e15;
+         component->last_values[i] = value;
+      }
+      energy_dynamic *= scale * scale;
+
+      component->energy_static += energy_static;
+      component->energy_dynamic += energy_dynamic;
+      component->power_static = energy_static / time_delta;
+      component->power_dynamic = energy_dynamic / time_delta;
+   }
+}
+
+bool EnergyModel::getEnergy(String name, UInt32 index, UInt64 &energy_static, UInt64 &energy_dynamic)
+{
+   Component *component = findComponent(name, index);
+   if (!component)
+      return false;
+
+   update();
+   energy_static = component->energy_static;
+   energy_dynamic = component->energy_dynamic;
+   return true;
+}
+
+bool EnergyModel::getPower(String name, UInt32 index, double &power_static, double &power_dynamic)
+{
+   Component *component = findComponent(name, index);
+   if (!component)
+      return false;
+
+   power_static = component->power_static;
+   power_dynamic = component->power_dynamic;
+   return true;
+}
+
+EnergyModel::Component *EnergyModel::findComponent(String name, UInt32 index)
+{
+   for(std::vector<Component*>::iterator it = m_components.begin(); it != m_components.end(); ++it)
+      if ((*it)->name == name && (*it)->index == index)
+         return *it;
+   return NULL;
+}
+
+SubsecondTime EnergyModel::getLeakageSavedTime(core_id_t core_id)
+{
+   CStateManager *cstate_manager = Sim()->getThreadManager()->getCStateManager();
+   if (core_id == INVALID_CORE_ID || !cstate_manager)
+      return SubsecondTime::Zero();
+   return cstate_manager->getLeakageSavedTime(core_id);
+}
+
+double EnergyModel::getVdd(core_id_t core_id)
+{
+   if (core_id == INVALID_CORE_ID || m_vdd_table.empty())
+      return 1.;
+
+   UInt64 freq_mhz = 1000000000 / Sim()->getDvfsManager()->getCoreDomain(core_id)->getPeriod().getFS();
+   for(std::vector<std::pair<UInt64, double> >::iterator it = m_vdd_table.begin(); it != m_vdd_table.end(); ++it)
+      if (freq_mhz >= it->first)
+         return it->second;
+   return m_vdd_table.back().second;
+}
@@ -0,0 +1,75 @@
+#ifndef __ENERGY_MODEL_H
+#define __ENERGY_MODEL_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+
+#include <vector>
+
+class StatsMetricBase;
+
+// In-simulator energy model
+//
+// Each component (e.g. core, L1-D, L2, dram) has a static power and a dynamic energy per event for a set of
+// statistics. Usually, these coefficients are derived once from a McPAT run (see scripts/energymodel.py).
+// Energy is then integrated natively from statistics deltas at every periodic callback and before statistics
+// are written, and exported as <component>.energy-static and <component>.energy-dynamic (fJ), the same statistics
+// scripts/energystats.py provides by running McPAT at every interval.
+// When a Vdd table is set, the energy of components that belong to a core follows that core's DVFS domain:
+// dynamic energy scales with Vdd^2, static power with Vdd, relative to the Vdd at the time the component was defined.
+// When C-states are enabled ([cstate]), static energy of a core's components excludes the leakage saved in idle states.
+
+class EnergyModel
+{
+   public:
+      struct Term
+      {
+         StatsMetricBase *metric;
+         double energy;          // Energy per unit of this statistic, in J
+      };
+
+      EnergyModel();
+      ~EnergyModel();
+
+      // Define or redefine a component. core_id is the core whose DVFS domain the component is in, or INVALID_CORE_ID
+      void setComponent(String name, UInt32 index, core_id_t core_id, double static_power, const std::vector<Term> &terms);
+      // (frequency in MHz, Vdd in V) pairs, from high to low frequency
+      void setVddTable(const std::vector<std::pair<UInt64, double> > &table);
+
+      // Integrate energy up to the current global time
+      void update();
+
+      bool getEnergy(String name, UInt32 index, UInt64 &energy_static, UInt64 &energy_dynamic);
+      // Average power over the last update period (periodic callback or statistics write), in W
+      bool getPower(String name, UInt32 index, double &power_static, double &power_dynamic);
+
+   private:
+      struct Component
+      {
+         String name;
+         UInt32 index;
+         core_id_t core_id;
+         double static_power;
+         double vdd_ref;
+         std::vector<Term> terms;
+         std::vector<UInt64> last_values;
+         SubsecondTime last_saved;  // Leakage-saved time of the core's C-states at the last update
+         UInt64 energy_static;   // fJ
+         UInt64 energy_dynamic;  // fJ
+         double power_static;
+         double power_dynamic;
+      };
+
+      std::vector<Component*> m_components;
+      std::vector<std::pair<UInt64, double> > m_vdd_table;
+      SubsecondTime m_last_time;
+      bool m_hooks_registered;
+
+      Component *findComponent(String name, UInt32 index);
+      double getVdd(core_id_t core_id);
+      SubsecondTime getLeakageSavedTime(core_id_t core_id);
+
+      static SInt64 hook_update(UInt64 self, UInt64) { ((EnergyModel*)self)->update(); return 0; }
+};
+
+#endif // __ENERGY_MODEL_H
@@ -14,7 +14,7 @@ FastForwardPerformanceManager::create(void)
 
    if (model == "none")
       return NULL;
-   else if (model == "oneipc")
+   else if (model == "oneipc" || model == "interval")
       return new FastForwardPerformanceManager();
    else
       LOG_PRINT_ERROR("Unknown fast-forward performance model %s", model.c_str());
@@ -34,7 +34,7 @@ FastForwardPerformanceManager::enable()
 {
    m_enabled = true;
    for (UInt32 i = 0; i < Sim()->getConfig()->getTotalCores(); i++)
-      Sim()->getCoreManager()->getCoreFromID(i)->enablePerformanceModels();
+      Sim()->getCoreManager()->getCoreFromID(i)->setPerformanceModelsEnabled(true);
 
    Sim()->getClockSkewMinimizationServer()->setFastForward(true);
    // Make sure all threads are released, as the barrier has just changed from per-core to per-HW-context mode
@@ -53,7 +53,7 @@ FastForwardPerformanceManager::disable()
    for(unsigned int core_id = 0; core_id < Sim()->getConfig()->getApplicationCores(); ++core_id)
    {
       Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
-      core->disablePerformanceModels(); // Probably someone else will turn them on again soon, but let's do this anyway
+      core->setPerformanceModelsEnabled(false); // Probably someone else will turn them on again soon, which then cancels this out
       core->getPerformanceModel()->setFastForward(false);
       core->disableInstructionsCallback();
       if (core->getThread() && Sim()->getThreadManager()->isThreadRunning(core->getThread()->getId()))
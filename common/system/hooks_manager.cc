@@ -1,10 +1,15 @@
 #include "hooks_manager.h"
 #include "log.h"
+#include "config.h"
+#include "self_profiler.h"
+
+#include <algorithm>
 
 const char* HookType::hook_type_names[] = {
    "HOOK_PERIODIC",
    "HOOK_PERIODIC_INS",
    "HOOK_BRANCH_PREDICT", // PaulRosu@ULBS
+   "HOOK_BRANCH_PREDICT_BATCH",
    "HOOK_SIM_START",
    "HOOK_SIM_END",
    "HOOK_ROI_BEGIN",
@@ -28,33 +33,174 @@ const char* HookType::hook_type_names[] = {
    "HOOK_APPLICATION_ROI_BEGIN",
    "HOOK_APPLICATION_ROI_END",
    "HOOK_SIGUSR1",
+   "HOOK_CORE_STATE_CHANGE",
+   "HOOK_MEMORY_SAMPLE_BATCH",
 };
 static_assert(HookType::HOOK_TYPES_MAX == sizeof(HookType::hook_type_names) / sizeof(HookType::hook_type_names[0]),
               "Not enough values in HookType::hook_type_names");
 
 HooksManager::HooksManager()
 {
+   UInt32 num_cores = Config::getSingleton()->getTotalCores();
+   for(unsigned int type = 0; type < HookType::HOOK_TYPES_MAX; ++type)
+   {
+      m_core_registry[type].resize(num_cores);
+      m_has_subscribers[type] = false;
+   }
+   for(unsigned int clock = 0; clock < NUM_TIMER_CLOCKS; ++clock)
+      m_timers_hooked[clock] = false;
 }
 
-void HooksManager::registerHook(HookType::hook_type_t type, HookCallbackFunc func, UInt64 argument, HookCallbackOrder order)
+void HooksManager::insertSorted(CallbackList &list, const HookCallback &callback)
 {
-   m_registry[type].push_back(HookCallback(func, argument, order));
+   // Insert after all callbacks with the same or an earlier order
+   CallbackList::iterator it = list.begin();
+   while(it != list.end() && it->order <= callback.order)
+      ++it;
+   list.insert(it, callback);
 }
 
-SInt64 HooksManager::callHooks(HookType::hook_type_t type, UInt64 arg, bool expect_return)
+void HooksManager::registerHook(HookType::hook_type_t type, HookCallbackFunc func, UInt64 argument, HookCallbackOrder order, core_id_t core_id)
 {
-   for(unsigned int order = 0; order < NUM_HOOK_ORDER; ++order)
+   HookCallback callback(func, argument, order);
+   ScopedLock sl(m_register_lock);
+
+   if (core_id == INVALID_CORE_ID)
+   {
+      insertSorted(m_registry[type], callback);
+      for(std::vector<CallbackList>::iterator it = m_core_registry[type].begin(); it != m_core_registry[type].end(); ++it)
+         insertSorted(*it, callback);
+   }
+   else
+   {
+      LOG_ASSERT_ERROR(core_id >= 0 && (size_t)core_id < m_core_registry[type].size(), "Invalid core id %d for hook %s", core_id, HookType::hook_type_names[type]);
+      insertSorted(m_core_registry[type][core_id], callback);
+   }
+
+   __atomic_store_n(&m_has_subscribers[type], true, __ATOMIC_RELEASE);
+}
+
+SInt64 HooksManager::callHooks(HookType::hook_type_t type, UInt64 arg, bool expect_return, core_id_t core_id)
+{
+   if (!hasSubscribers(type))
+      return -1;
+
+   SELF_PROFILE(HOOKS);
+
+   const CallbackList &callbacks = getCallbacks(type, core_id);
+   // Index-based, callbacks may register new hooks which can reallocate the list
+   for(size_t idx = 0; idx < callbacks.size(); ++idx)
    {
-      for(std::vector<HookCallback>::iterator it = m_registry[type].begin(); it != m_registry[type].end(); ++it)
-      {
-         if (it->order == (HookCallbackOrder)order)
-         {
-            SInt64 result = it->func(it->arg, arg);
-            if (expect_return && result != -1)
-               return result;
-         }
-      }
+      HookCallback callback = callbacks[idx];
+      SInt64 result = callback.func(callback.arg, arg);
+      if (expect_return && result != -1)
+         return result;
    }
 
    return -1;
 }
+
+void HooksManager::scheduleTimer(TimerClock clock, UInt64 when, TimerCallbackFunc func, UInt64 arg, TimerBatchFunc batch, UInt64 batch_arg)
+{
+   Timer *timer = new Timer();
+   timer->func = func;
+   timer->arg = arg;
+   timer->batch = batch;
+   timer->batch_arg = batch_arg;
+   timer->when = when;
+
+   bool hook;
+   {
+      ScopedLock sl(m_timer_lock);
+      m_timers[clock].insert(timerTick(clock, when, true), timer);
+      hook = !m_timers_hooked[clock];
+      m_timers_hooked[clock] = true;
+   }
+
+   // Only hook into the periodic callbacks once there are timers to check
+   if (hook)
+   {
+      if (clock == TIMER_TIME)
+         registerHook(HookType::HOOK_PERIODIC, hookTimersTime, (UInt64)this);
+      else
+         registerHook(HookType::HOOK_PERIODIC_INS, hookTimersInstructions, (UInt64)this);
+   }
+}
+
+UInt64 HooksManager::getNextTimerTime()
+{
+   ScopedLock sl(m_timer_lock);
+   UInt64 tick = m_timers[TIMER_TIME].next();
+   return tick == UINT64_MAX ? TIMER_STOP : tick * SubsecondTime::NS().getFS();
+}
+
+UInt64 HooksManager::timerTick(TimerClock clock, UInt64 when, bool round_up)
+{
+   if (clock == TIMER_INSTRUCTIONS)
+      return when;
+   // Due times are rounded up and the current time down, so a timer never fires early
+   const UInt64 fs_per_tick = SubsecondTime::NS().getFS();
+   return round_up ? (when / fs_per_tick + (when % fs_per_tick ? 1 : 0)) : when / fs_per_tick;
+}
+
+typedef std::pair<std::pair<HooksManager::TimerBatchFunc, UInt64>, size_t> TimerBatchKey;
+
+static bool timerBatchOrder(const TimerBatchKey &a, const TimerBatchKey &b)
+{
+   return a.first < b.first;
+}
+
+void HooksManager::runTimers(TimerClock clock, UInt64 now)
+{
+   std::vector<Timer*> due;
+   {
+      ScopedLock sl(m_timer_lock);
+      if (m_timers[clock].empty())
+         return;
+      struct Collect {
+         std::vector<Timer*> &due;
+         void operator()(UInt64, Timer *timer) { due.push_back(timer); }
+      } collect = { due };
+      m_timers[clock].advance(timerTick(clock, now, false), collect);
+   }
+   if (due.empty())
+      return;
+
+   // Run timers sharing a batch function and argument back-to-back, each group in order of expiry.
+   // Callbacks run without m_timer_lock held, they may schedule new timers.
+   std::vector<TimerBatchKey> order;
+   for(size_t idx = 0; idx < due.size(); ++idx)
+      order.push_back(std::make_pair(std::make_pair(due[idx]->batch, due[idx]->batch_arg), idx));
+   std::stable_sort(order.begin(), order.end(), timerBatchOrder);
+
+   for(size_t idx = 0; idx < order.size(); ++idx)
+   {
+      Timer *timer = due[order[idx].second];
+      if (timer->batch && (idx == 0 || order[idx - 1].first != order[idx].first))
+         timer->batch(timer->batch_arg, true);
+      timer->when = timer->func(timer->arg, now);
+      if (timer->batch && (idx == order.size() - 1 || order[idx + 1].first != order[idx].first))
+         timer->batch(timer->batch_arg, false);
+   }
+
+   ScopedLock sl(m_timer_lock);
+   for(std::vector<Timer*>::iterator it = due.begin(); it != due.end(); ++it)
+   {
+      if ((*it)->when == TIMER_STOP)
+         delete *it;
+      else
+         m_timers[clock].insert(timerTick(clock, (*it)->when, true), *it);
+   }
+}
+
+SInt64 HooksManager::hookTimersTime(UInt64 self, UInt64 time)
+{
+   ((HooksManager*)self)->runTimers(TIMER_TIME, SubsecondTime(*(subsecond_time_t*)&time).getFS());
+   return 0;
+}
+
+SInt64 HooksManager::hookTimersInstructions(UInt64 self, UInt64 icount)
+{
+   ((HooksManager*)self)->runTimers(TIMER_INSTRUCTIONS, icount);
+   return 0;
+}
@@ -3,10 +3,11 @@
 
 #include "fixed_types.h"
 #include "subsecond_time.h"
+#include "lock.h"
 #include "thread_manager.h"
+#include "timer_wheel.h"
 
 #include <vector>
-#include <unordered_map>
 
 class HookType
 {
@@ -16,6 +17,7 @@ public:
       HOOK_PERIODIC,            // SubsecondTime current_time        Barrier was reached
       HOOK_PERIODIC_INS,        // UInt64 icount                     Instruction-based periodic callback
       HOOK_BRANCH_PREDICT,      // BranchPrediction* info            Branch prediction (ip, predicted, actual, indirect) PaulRosu@ULBS
+      HOOK_BRANCH_PREDICT_BATCH, // BranchPredictionBatch* batch     Batch of buffered branch predictions for one core
       HOOK_SIM_START,           // none                              Simulation start
       HOOK_SIM_END,             // none                              Simulation end
       HOOK_ROI_BEGIN,           // none                              ROI begin
@@ -39,21 +41,13 @@ public:
       HOOK_APPLICATION_ROI_BEGIN, // none                            ROI begin, always triggers
       HOOK_APPLICATION_ROI_END,   // none                            ROI end, always triggers
       HOOK_SIGUSR1,             // none                              Sniper process received SIGUSR1
+      HOOK_CORE_STATE_CHANGE,   // HooksManager::CoreStateChange     Core changed state (Core::setState)
+      HOOK_MEMORY_SAMPLE_BATCH, // MemorySampleBatch* batch          Batch of sampled memory accesses for one core (see MemorySampler)
       HOOK_TYPES_MAX
    };
    static const char* hook_type_names[];
 };
 
-namespace std
-{
-   template <> struct hash<HookType::hook_type_t> {
-      size_t operator()(const HookType::hook_type_t & type) const {
-         //return std::hash<int>(type);
-         return (int)type;
-      }
-   };
-}
-
 class HooksManager
 {
 public:
@@ -95,6 +89,13 @@ public:
       subsecond_time_t time;  // Current time
    } ThreadMigrate;
 
+   typedef struct {
+      core_id_t core_id;      // Core changing state
+      Core::State old_state;  // State before the change
+      Core::State new_state;  // State after the change
+      subsecond_time_t time;  // Core-local time at which the change happens
+   } CoreStateChange;
+
    // PaulRosu@ULBS
    typedef struct {
       IntPtr ip;              // Instruction pointer
@@ -103,15 +104,104 @@ public:
       bool indirect;          // Whether this was an indirect branch
       core_id_t core_id;      // Core ID
    } BranchPrediction;
+   // Layout is exported to Python as a raw buffer (see sim.util.EveryBranchBatch), keep both in sync
+   static_assert(sizeof(BranchPrediction) == 16, "BranchPrediction layout changed, update sim.util.EveryBranchBatch");
+   typedef struct {
+      core_id_t core_id;      // Core that produced the records
+      UInt64 count;           // Number of valid records
+      const BranchPrediction *records; // Contiguous array, only valid during the callback
+   } BranchPredictionBatch;
+
+   typedef struct {
+      UInt64 address;         // Data address
+      UInt64 eip;             // Instruction pointer
+      UInt64 latency;         // Access latency, in femtoseconds
+      SInt32 core_id;         // Core ID
+      UInt8 hit_where;        // HitWhere::where_t
+      UInt8 is_write;
+      UInt16 reserved;
+   } MemorySample;
+   // Layout is exported to Python as a raw buffer (see sim.util.EveryMemorySampleBatch) and written to sim.memsamples.bin
+   static_assert(sizeof(MemorySample) == 32, "MemorySample layout changed, update sim.util.EveryMemorySampleBatch");
+   typedef struct {
+      core_id_t core_id;      // Core that produced the records
+      UInt64 count;           // Number of valid records
+      const MemorySample *records; // Contiguous array, only valid during the callback
+   } MemorySampleBatch;
 
    HooksManager();
    void init();
    void fini();
-   void registerHook(HookType::hook_type_t type, HookCallbackFunc func, UInt64 argument, HookCallbackOrder order = ORDER_NOTIFY_PRE);
-   SInt64 callHooks(HookType::hook_type_t type, UInt64 argument, bool expect_return = false);
+   // Hooks registered with a core_id only fire for callHooks() with that same core_id,
+   // hooks registered without one fire for all callHooks(), with or without core_id
+   void registerHook(HookType::hook_type_t type, HookCallbackFunc func, UInt64 argument, HookCallbackOrder order = ORDER_NOTIFY_PRE, core_id_t core_id = INVALID_CORE_ID);
+   SInt64 callHooks(HookType::hook_type_t type, UInt64 argument, bool expect_return = false, core_id_t core_id = INVALID_CORE_ID);
+   // Cheap check to be used on hot paths to avoid constructing hook arguments nobody will see
+   bool hasHooks(HookType::hook_type_t type, core_id_t core_id = INVALID_CORE_ID) const
+   {
+      return hasSubscribers(type) && !getCallbacks(type, core_id).empty();
+   }
+
+   // Native timers, checked at every barrier (HOOK_PERIODIC) or HOOK_PERIODIC_INS callback. A timer callback is given
+   // the current time (in fs) or global instruction count, and returns when it wants to be called next (TIMER_STOP to remove it).
+   // Due times at or before the current one fire at the next check.
+   enum TimerClock {
+      TIMER_TIME,
+      TIMER_INSTRUCTIONS,
+      NUM_TIMER_CLOCKS,
+   };
+   static const UInt64 TIMER_STOP = UINT64_MAX;
+   typedef UInt64 (*TimerCallbackFunc)(UInt64 arg, UInt64 now);
+   // Called with true before and false after a run of due timers that share it and its argument, e.g. to take the GIL only once
+   typedef void (*TimerBatchFunc)(UInt64 batch_arg, bool enter);
+   void scheduleTimer(TimerClock clock, UInt64 when, TimerCallbackFunc func, UInt64 arg, TimerBatchFunc batch = NULL, UInt64 batch_arg = 0);
+   // Earliest time (in fs) a TIMER_TIME timer is due, TIMER_STOP if there are none
+   UInt64 getNextTimerTime();
 
 private:
-   std::unordered_map<HookType::hook_type_t, std::vector<HookCallback> > m_registry;
+   typedef std::vector<HookCallback> CallbackList;
+
+   // All lists are kept sorted by HookCallbackOrder (and by registration order within the same order)
+   CallbackList m_registry[HookType::HOOK_TYPES_MAX];
+   // Per-core lists contain both the global and the core-specific callbacks
+   std::vector<CallbackList> m_core_registry[HookType::HOOK_TYPES_MAX];
+
+   // Set as soon as a callback is registered for a hook type (for any core, natively or from Python),
+   // so hook types nobody listens to cost a single load
+   bool m_has_subscribers[HookType::HOOK_TYPES_MAX];
+
+   bool hasSubscribers(HookType::hook_type_t type) const
+   {
+      return __atomic_load_n(&m_has_subscribers[type], __ATOMIC_ACQUIRE);
+   }
+   const CallbackList& getCallbacks(HookType::hook_type_t type, core_id_t core_id) const
+   {
+      if (core_id >= 0 && (size_t)core_id < m_core_registry[type].size())
+         return m_core_registry[type][core_id];
+      else
+         return m_registry[type];
+   }
+   static void insertSorted(CallbackList &list, const HookCallback &callback);
+
+   // Hooks can be registered by cores constructed in parallel (general/startup_threads)
+   Lock m_register_lock;
+
+   struct Timer {
+      TimerCallbackFunc func;
+      UInt64 arg;
+      TimerBatchFunc batch;
+      UInt64 batch_arg;
+      UInt64 when;
+   };
+   // Time wheels tick in ns, instruction wheels in instructions
+   TimerWheel<Timer*> m_timers[NUM_TIMER_CLOCKS];
+   bool m_timers_hooked[NUM_TIMER_CLOCKS];
+   Lock m_timer_lock;
+
+   static UInt64 timerTick(TimerClock clock, UInt64 when, bool round_up);
+   void runTimers(TimerClock clock, UInt64 now);
+   static SInt64 hookTimersTime(UInt64 self, UInt64 time);
+   static SInt64 hookTimersInstructions(UInt64 self, UInt64 icount);
 };
 
 #endif /* __HOOKS_MANAGER_H */
@@ -0,0 +1,145 @@
+#include "host_topology.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "config.h"
+#include "config.hpp"
+#include "itostr.h"
+#include "log.h"
+
+#include <sys/mman.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+__thread SInt32 HostTopology::t_bound_node = -1;
+
+HostTopology::HostTopology()
+   : m_numa_enabled(Sim()->getCfg()->getBool("general/host_numa"))
+   , m_hugepages(Sim()->getCfg()->getBool("general/host_hugepages"))
+{
+   if (!m_numa_enabled)
+      return;
+
+   sched_getaffinity(0, sizeof(m_original_mask), &m_original_mask);
+   if (!readNodes() || m_node_cpus.size() < 2)
+   {
+      // A single node has nothing to keep local, leave the host scheduler alone
+      m_numa_enabled = false;
+      return;
+   }
+
+   // Contiguous groups of cores per node, starting a new node only where CoreManager starts a new group of
+   // cores that share caches
+   UInt32 total_cores = Config::getSingleton()->getTotalCores();
+   m_core_node.resize(total_cores, 0);
+   for (core_id_t core_id = 0; core_id < (core_id_t)total_cores; ++core_id)
+   {
+      if (core_id == 0 || CoreManager::isCoreGroupStart(core_id))
+         m_core_node[core_id] = UInt64(core_id) * m_node_cpus.size() / total_cores;
+      else
+         m_core_node[core_id] = m_core_node[core_id - 1];
+   }
+
+   LOG_PRINT("Placing %u cores on %u host NUMA nodes", total_cores, m_node_cpus.size());
+}
+
+bool
+HostTopology::readNodes()
+{
+   // Nodes are listed as /sys/devices/system/node/node<n>/cpulist, with CPU ranges like 0-7,16-23
+   for (UInt32 node = 0; ; ++node)
+   {
+      String filename = "/sys/devices/system/node/node" + itostr(node) + "/cpulist";
+      FILE *fp = fopen(filename.c_str(), "r");
+      if (!fp)
+         break;
+
+      cpu_set_t mask;
+      CPU_ZERO(&mask);
+      int first, last;
+      while (fscanf(fp, "%d", &first) == 1)
+      {
+         last = first;
+         int c = fgetc(fp);
+         if (c == '-')
+         {
+            if (fscanf(fp, "%d", &last) != 1)
+               break;
+            c = fgetc(fp);
+         }
+         for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+            if (CPU_ISSET(cpu, &m_original_mask))
+               CPU_SET(cpu, &mask);
+         if (c != ',')
+            break;
+      }
+      fclose(fp);
+
+      // Nodes without usable CPUs (memory-only, or excluded by the original affinity) get no cores
+      if (CPU_COUNT(&mask))
+         m_node_cpus.push_back(mask);
+   }
+   return !m_node_cpus.empty();
+}
+
+void
+HostTopology::bindThread(core_id_t core_id)
+{
+   if (!m_numa_enabled)
+      return;
+
+   SInt32 node = getCoreNode(core_id);
+   if (node == t_bound_node)
+      return;
+
+   if (sched_setaffinity(0, sizeof(m_node_cpus[node]), &m_node_cpus[node]) == 0)
+      t_bound_node = node;
+   else
+      LOG_PRINT_WARNING_ONCE("Cannot pin simulation threads to host NUMA nodes");
+}
+
+void
+HostTopology::unbindThread()
+{
+   if (!m_numa_enabled || t_bound_node == -1)
+      return;
+
+   sched_setaffinity(0, sizeof(m_original_mask), &m_original_mask);
+   t_bound_node = -1;
+}
+
+void *
+HostTopology::allocLarge(size_t size)
+{
+   // Arrays smaller than a huge page stay on the heap
+   if (!m_hugepages || size < HUGE_PAGE_SIZE)
+   {
+      void *ptr = calloc(1, size);
+      LOG_ASSERT_ERROR(ptr || !size, "Cannot allocate %ld bytes", size);
+      return ptr;
+   }
+
+   // Over-allocate to align the start to a huge page boundary, and give back the unaligned ends
+   size_t length = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+   char *map = (char*)mmap(NULL, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   LOG_ASSERT_ERROR(map != MAP_FAILED, "Cannot map %ld bytes", length);
+   char *ptr = (char*)(((uintptr_t)map + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+   if (ptr > map)
+      munmap(map, ptr - map);
+   if (ptr + length < map + length + HUGE_PAGE_SIZE)
+      munmap(ptr + length, map + length + HUGE_PAGE_SIZE - (ptr + length));
+
+#ifdef MADV_HUGEPAGE
+   // Only a hint: without transparent huge page support this is normal, zero-filled memory
+   madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+   return ptr;
+}
+
+void
+HostTopology::freeLarge(void *ptr, size_t size)
+{
+   if (!m_hugepages || size < HUGE_PAGE_SIZE)
+      free(ptr);
+   else if (ptr)
+      munmap(ptr, (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+}
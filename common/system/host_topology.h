@@ -0,0 +1,54 @@
+#ifndef __HOST_TOPOLOGY_H
+#define __HOST_TOPOLOGY_H
+
+#include "fixed_types.h"
+
+#include <vector>
+#include <sched.h>
+
+// Placement of simulator state on the host machine (general/host_numa, general/host_hugepages).
+//
+// With host_numa, simulated cores are split into contiguous groups, one per host NUMA node (as listed in
+// /sys/devices/system/node), keeping cores that share a cache together. The threads that construct a core
+// and later simulate it (trace threads, sim threads) are pinned to the CPUs of its node, so first-touch
+// placement puts the core's caches, directory and timing models in memory local to the threads using them.
+// With host_hugepages, large arrays (cache tags and blocks, cache data, directory entries) are mapped
+// separately and aligned to 2 MB, and transparent huge pages are requested for them.
+// Both default to off, in which case all calls below do nothing special.
+
+class HostTopology
+{
+   public:
+      static const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+      HostTopology();
+
+      bool isNumaEnabled() const { return m_numa_enabled; }
+      bool useHugePages() const { return m_hugepages; }
+      UInt32 getNumNodes() const { return m_node_cpus.size(); }
+      UInt32 getCoreNode(core_id_t core_id) const
+      { return core_id >= 0 && UInt32(core_id) < m_core_node.size() ? m_core_node[core_id] : 0; }
+
+      // Pin the calling thread to the host node of core_id (no-op if it already runs there)
+      void bindThread(core_id_t core_id);
+      // Return the calling thread to the CPUs the simulator was started on
+      void unbindThread();
+
+      // Zero-filled memory for large arrays, huge-page backed when enabled and worth it.
+      // Must be released with freeLarge() using the same size.
+      void *allocLarge(size_t size);
+      void freeLarge(void *ptr, size_t size);
+
+   private:
+      bool m_numa_enabled;
+      const bool m_hugepages;
+      cpu_set_t m_original_mask;
+      std::vector<cpu_set_t> m_node_cpus;
+      std::vector<UInt32> m_core_node;
+
+      static __thread SInt32 t_bound_node;
+
+      bool readNodes();
+};
+
+#endif // __HOST_TOPOLOGY_H
@@ -13,6 +13,9 @@ InstMode::inst_mode_t InstMode::inst_mode_end  = InstMode::INVALID;
 // Initial instrumentation mode
 InstMode::inst_mode_t InstMode::inst_mode = InstMode::INVALID;
 
+bool InstMode::reinstrument_fast_forward = false;
+bool InstMode::fast_forward_only = false;
+
 
 __attribute__((weak)) void
 InstMode::updateInstrumentationMode()
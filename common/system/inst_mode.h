@@ -11,9 +11,14 @@ class InstMode
       };
       static inst_mode_t inst_mode_init, inst_mode_roi, inst_mode_end;
       static inst_mode_t fromString(const String str);
+      // Fast-forward code carries only the instrumentation it needs, rather than a switch to all modes
+      static bool reinstrument_fast_forward;
+      static bool isFastForwardOnly() { return fast_forward_only; }
 
    private:
       static inst_mode_t inst_mode;
+      // Instrumentation currently in the code cache was made for fast-forward only
+      static bool fast_forward_only;
       static void updateInstrumentationMode();
 
       // Access through Sim()
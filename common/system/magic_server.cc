@@ -6,12 +6,14 @@
 #include "performance_model.h"
 #include "fastforward_performance_model.h"
 #include "core_manager.h"
+#include "instruction_aggregator.h"
 #include "dvfs_manager.h"
 #include "hooks_manager.h"
 #include "stats.h"
 #include "timer.h"
 #include "thread.h"
 #include "core.h"
+#include "clock_skew_minimization_object.h"
 
 MagicServer::MagicServer()
       : m_performance_enabled(false)
@@ -23,11 +25,33 @@ MagicServer::~MagicServer()
 
 UInt64 MagicServer::Magic(thread_id_t thread_id, core_id_t core_id, UInt64 cmd, UInt64 arg0, UInt64 arg1)
 {
+   if (!needsLock(cmd))
+      return Magic_unlocked(thread_id, core_id, cmd, arg0, arg1);
+
    ScopedLock sl(Sim()->getThreadManager()->getLock());
 
    return Magic_unlocked(thread_id, core_id, cmd, arg0, arg1);
 }
 
+bool MagicServer::needsLock(UInt64 cmd)
+{
+   switch(cmd)
+   {
+      case SIM_CMD_MHZ_GET:
+         // A domain's period is a single word, DvfsManager updates it in place
+         return false;
+      case SIM_CMD_MARKER:
+      case SIM_CMD_NAMED_MARKER:
+         // Markers only touch the calling thread's own core, unless someone listens to them.
+         // Hooks are registered during startup, so the lists don't change underneath us.
+         return Sim()->getHooksManager()->hasHooks(HookType::HOOK_MAGIC_MARKER);
+      case SIM_CMD_USER:
+         return Sim()->getHooksManager()->hasHooks(HookType::HOOK_MAGIC_USER);
+      default:
+         return true;
+   }
+}
+
 UInt64 MagicServer::Magic_unlocked(thread_id_t thread_id, core_id_t core_id, UInt64 cmd, UInt64 arg0, UInt64 arg1)
 {
    switch(cmd)
@@ -108,9 +132,10 @@ UInt64 MagicServer::Magic_unlocked(thread_id_t thread_id, core_id_t core_id, UIn
 
 UInt64 MagicServer::getGlobalInstructionCount(void)
 {
-   UInt64 ninstrs = 0;
+   // Socket shards of the HOOK_PERIODIC_INS aggregation, plus what each core has not handed in yet
+   UInt64 ninstrs = Sim()->getCoreManager()->getInstructionAggregator()->getCount();
    for (UInt32 i = 0; i < Sim()->getConfig()->getApplicationCores(); i++)
-      ninstrs += Sim()->getCoreManager()->getCoreFromID(i)->getInstructionCount();
+      ninstrs += Sim()->getCoreManager()->getCoreFromID(i)->getInstructionCountUnaggregated();
    return ninstrs;
 }
 
@@ -118,9 +143,10 @@ static Timer t_start;
 UInt64 ninstrs_start;
 __attribute__((weak)) void PinDetach(void) {}
 
-void MagicServer::enablePerformance()
+void MagicServer::enablePerformance(bool resume)
 {
-   Sim()->getStatsManager()->recordStats("roi-begin");
+   if (!resume)
+      Sim()->getStatsManager()->recordStats("roi-begin");
    ninstrs_start = getGlobalInstructionCount();
    t_start.start();
 
@@ -164,7 +190,7 @@ void MagicServer::disablePerformance()
 
 void print_allocations();
 
-UInt64 MagicServer::setPerformance(bool enabled)
+UInt64 MagicServer::setPerformance(bool enabled, bool resume)
 {
    if (m_performance_enabled == enabled)
       return 1;
@@ -195,7 +221,7 @@ UInt64 MagicServer::setPerformance(bool enabled)
    }
 
    if (enabled)
-      enablePerformance();
+      enablePerformance(resume);
    else
       disablePerformance();
 
@@ -212,7 +238,12 @@ UInt64 MagicServer::setFrequency(UInt64 core_number, UInt64 freq_in_mhz)
 
    printf("[SNIPER] Setting frequency for core %" PRId64 " in DVFS domain %d to %" PRId64 " MHz\n", core_number, Sim()->getDvfsManager()->getCoreDomainId(core_number), freq_in_mhz);
 
-   if (freq_in_hz > 0)
+   if (freq_in_hz > 0 && Sim()->getDvfsManager()->isAsync()) {
+      // The core applies the change itself and calls the hooks then
+      Sim()->getDvfsManager()->postCoreDomain(core_number, ComponentPeriod::fromFreqHz(freq_in_hz), Sim()->getClockSkewMinimizationServer()->getGlobalTime());
+      return 0;
+   }
+   else if (freq_in_hz > 0)
       Sim()->getDvfsManager()->setCoreDomain(core_number, ComponentPeriod::fromFreqHz(freq_in_hz));
    else {
       Sim()->getThreadManager()->stallThread_async(core_number, ThreadManager::STALL_BROKEN, SubsecondTime::MaxTime());
@@ -225,6 +256,28 @@ UInt64 MagicServer::setFrequency(UInt64 core_number, UInt64 freq_in_mhz)
    return 0;
 }
 
+UInt64 MagicServer::setFrequencies(const std::vector<UInt64> &freqs_in_mhz)
+{
+   if (freqs_in_mhz.size() != Sim()->getConfig()->getApplicationCores())
+      return 1;
+
+   if (Sim()->getDvfsManager()->isAsync())
+   {
+      SubsecondTime now = Sim()->getClockSkewMinimizationServer()->getGlobalTime();
+      for(UInt32 core_id = 0; core_id < freqs_in_mhz.size(); ++core_id)
+         if (freqs_in_mhz[core_id])
+            Sim()->getDvfsManager()->postCoreDomain(core_id, ComponentPeriod::fromFreqHz(1000000 * freqs_in_mhz[core_id]), now);
+      return 0;
+   }
+
+   std::vector<UInt32> changed = Sim()->getDvfsManager()->setCoreDomains(freqs_in_mhz);
+
+   for(std::vector<UInt32>::iterator it = changed.begin(); it != changed.end(); ++it)
+      Sim()->getHooksManager()->callHooks(HookType::HOOK_CPUFREQ_CHANGE, *it);
+
+   return 0;
+}
+
 UInt64 MagicServer::getFrequency(UInt64 core_number)
 {
    UInt32 num_cores = Sim()->getConfig()->getApplicationCores();
@@ -4,6 +4,8 @@
 #include "fixed_types.h"
 #include "progress.h"
 
+#include <vector>
+
 class MagicServer
 {
    public:
@@ -25,11 +27,14 @@ class MagicServer
       // To be called while holding the thread manager lock
       UInt64 Magic_unlocked(thread_id_t thread_id, core_id_t core_id, UInt64 cmd, UInt64 arg0, UInt64 arg1);
       UInt64 setFrequency(UInt64 core_number, UInt64 freq_in_mhz);
+      // Set the frequency of all application cores in one step (0: unchanged), see DvfsManager::setCoreDomains
+      UInt64 setFrequencies(const std::vector<UInt64> &freqs_in_mhz);
       UInt64 getFrequency(UInt64 core_number);
 
-      void enablePerformance();
+      // When resuming from a checkpoint, the ROI is re-entered without a new roi-begin snapshot
+      void enablePerformance(bool resume = false);
       void disablePerformance();
-      UInt64 setPerformance(bool enabled);
+      UInt64 setPerformance(bool enabled, bool resume = false);
 
       UInt64 setInstrumentationMode(UInt64 sim_api_opt);
 
@@ -41,6 +46,9 @@ class MagicServer
    private:
       bool m_performance_enabled;
       Progress m_progress;
+
+      // Commands that only read simulator state, or have no side effects beyond the calling thread, skip the thread manager lock
+      static bool needsLock(UInt64 cmd);
 };
 
 #endif // SYNC_SERVER_H
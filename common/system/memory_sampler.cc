@@ -0,0 +1,104 @@
+#include "memory_sampler.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "stats.h"
+#include "log.h"
+
+const char MemorySampler::MAGIC[8] = { 'S', 'N', 'M', 'E', 'M', 'S', 'M', '1' };
+
+MemorySampler* MemorySampler::create()
+{
+   if (Sim()->getCfg()->getBool("memory_sampler/enabled"))
+      return new MemorySampler();
+   else
+      return NULL;
+}
+
+MemorySampler::MemorySampler()
+   : m_interval(Sim()->getCfg()->getInt("memory_sampler/interval"))
+   , m_miss_level(Sim()->getCfg()->getInt("memory_sampler/miss_level"))
+   , m_per_core(Sim()->getConfig()->getApplicationCores())
+   , m_fp(NULL)
+{
+   LOG_ASSERT_ERROR(m_interval > 0, "memory_sampler/interval must be at least 1");
+   LOG_ASSERT_ERROR(m_miss_level <= 4, "memory_sampler/miss_level must be between 0 (all accesses) and 4 (L4 misses)");
+
+   UInt64 buffer_size = Sim()->getCfg()->getInt("memory_sampler/buffer_size");
+   LOG_ASSERT_ERROR(buffer_size > 0, "memory_sampler/buffer_size must be at least 1");
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_per_core.size(); ++core_id)
+   {
+      PerCore &per_core = m_per_core[core_id];
+      per_core.countdown = m_interval;
+      per_core.count = 0;
+      per_core.samples.resize(buffer_size);
+      per_core.num_samples = 0;
+      registerStatsMetric("memory_sampler", core_id, "samples", &per_core.num_samples);
+   }
+
+   String output = Sim()->getCfg()->getString("memory_sampler/output");
+   if (output == "file")
+   {
+      String filename = Sim()->getConfig()->formatOutputFileName("sim.memsamples.bin");
+      m_fp = fopen(filename.c_str(), "wb");
+      LOG_ASSERT_ERROR(m_fp, "Cannot open %s", filename.c_str());
+      fwrite(MAGIC, sizeof(MAGIC), 1, m_fp);
+   }
+   else
+   {
+      LOG_ASSERT_ERROR(output == "python", "Invalid memory_sampler/output %s, should be python or file", output.c_str());
+   }
+
+   // Cores are stopped at these points, so their buffers can be flushed from here
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, __flushAll, (UInt64)this);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_END, __flushAll, (UInt64)this);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_SIM_END, __flushAll, (UInt64)this);
+}
+
+MemorySampler::~MemorySampler()
+{
+   if (m_fp)
+      fclose(m_fp);
+}
+
+void MemorySampler::record(PerCore &per_core, core_id_t core_id, IntPtr address, IntPtr eip, HitWhere::where_t hit_where, SubsecondTime latency, bool is_write)
+{
+   HooksManager::MemorySample &sample = per_core.samples[per_core.count++];
+   sample.address = address;
+   sample.eip = eip;
+   sample.latency = latency.getFS();
+   sample.core_id = core_id;
+   sample.hit_where = hit_where;
+   sample.is_write = is_write;
+   sample.reserved = 0;
+   ++per_core.num_samples;
+
+   if (per_core.count == per_core.samples.size())
+      flush(core_id);
+}
+
+void MemorySampler::flush(core_id_t core_id)
+{
+   PerCore &per_core = m_per_core[core_id];
+   if (per_core.count == 0)
+      return;
+
+   if (m_fp)
+   {
+      ScopedLock sl(m_fp_lock);
+      fwrite(per_core.samples.data(), sizeof(HooksManager::MemorySample), per_core.count, m_fp);
+   }
+   else
+   {
+      HooksManager::MemorySampleBatch batch = { core_id, per_core.count, per_core.samples.data() };
+      Sim()->getHooksManager()->callHooks(HookType::HOOK_MEMORY_SAMPLE_BATCH, (UInt64)&batch, false, core_id);
+   }
+   per_core.count = 0;
+}
+
+void MemorySampler::flushAll()
+{
+   for(core_id_t core_id = 0; core_id < (core_id_t)m_per_core.size(); ++core_id)
+      flush(core_id);
+   if (m_fp)
+      fflush(m_fp);
+}
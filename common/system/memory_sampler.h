@@ -0,0 +1,67 @@
+#ifndef __MEMORY_SAMPLER_H
+#define __MEMORY_SAMPLER_H
+
+#include "fixed_types.h"
+#include "subsecond_time.h"
+#include "hit_where.h"
+#include "hooks_manager.h"
+#include "lock.h"
+
+#include <vector>
+
+// Sampled memory access events ([memory_sampler]), for data-centric profiling at bounded cost.
+//
+// Every <interval>th data access of a core, or with <miss_level> set, every <interval>th access that missed in that
+// cache level, is recorded (address, eip, hit_where, latency, core) in a per-core buffer. Full buffers, and whatever
+// is buffered at every barrier, ROI end and simulation end, go to HOOK_MEMORY_SAMPLE_BATCH subscribers (see
+// sim.util.EveryMemorySampleBatch) or are appended to sim.memsamples.bin (an 8-byte magic followed by
+// HooksManager::MemorySample records). Accesses that are not sampled only cost a counter decrement.
+class MemorySampler
+{
+   public:
+      static MemorySampler* create();
+
+      MemorySampler();
+      ~MemorySampler();
+
+      void access(core_id_t core_id, IntPtr address, IntPtr eip, HitWhere::where_t hit_where, SubsecondTime latency, bool is_write)
+      {
+         if (m_miss_level && isHit(hit_where))
+            return;
+         PerCore &per_core = m_per_core[core_id];
+         if (--per_core.countdown)
+            return;
+         per_core.countdown = m_interval;
+         record(per_core, core_id, address, eip, hit_where, latency, is_write);
+      }
+
+      static const char MAGIC[8];
+
+   private:
+      struct PerCore
+      {
+         UInt64 countdown;
+         UInt64 count;
+         std::vector<HooksManager::MemorySample> samples;
+         UInt64 num_samples;
+         char padding[64];
+      };
+
+      const UInt64 m_interval;
+      const UInt32 m_miss_level;       // Number of private cache levels an access has to miss in, 0 = all accesses
+      std::vector<PerCore> m_per_core;
+      FILE *m_fp;
+      Lock m_fp_lock;
+
+      bool isHit(HitWhere::where_t hit_where) const
+      {
+         return hit_where >= HitWhere::L1_OWN && hit_where < HitWhere::where_t(HitWhere::L1_OWN + m_miss_level);
+      }
+      void record(PerCore &per_core, core_id_t core_id, IntPtr address, IntPtr eip, HitWhere::where_t hit_where, SubsecondTime latency, bool is_write);
+      void flush(core_id_t core_id);
+      void flushAll();
+
+      static SInt64 __flushAll(UInt64 arg, UInt64 val) { ((MemorySampler*)arg)->flushAll(); return 0; }
+};
+
+#endif // __MEMORY_SAMPLER_H
@@ -6,6 +6,8 @@
 #include <unordered_set>
 
 MemoryTracker::MemoryTracker()
+   : m_generation(1)
+   , m_owner_cache(Sim()->getConfig()->getTotalCores())
 {
    Sim()->getConfig()->setCacheEfficiencyCallbacks(__ce_get_owner, __ce_notify_access, __ce_notify_evict, (UInt64)this);
 }
@@ -23,11 +25,11 @@ MemoryTracker::~MemoryTracker()
 
    for(auto it = m_allocation_sites.begin(); it != m_allocation_sites.end(); ++it)
    {
-      const CallStack &stack = it->first;
       const AllocationSite *site = it->second;
 
       if (site->total_loads + site->total_stores)
       {
+         const CallStack stack = Sim()->getRoutineTracer()->getCallStacks()->getStack(it->first);
          for(auto jt = stack.begin(); jt != stack.end(); ++jt)
          {
             if (sites_printed.count(*jt) == 0)
@@ -68,17 +70,11 @@ void MemoryTracker::logMalloc(thread_id_t thread_id, UInt64 eip, UInt64 address,
    ScopedLock sl(m_lock);
 
    ::RoutineTracerThread *tracer = Sim()->getThreadManager()->getThreadFromID(thread_id)->getRoutineTracer();
-   const CallStack stack = dynamic_cast<MemoryTracker::RoutineTracerThread*>(tracer)->getCallsiteStack();
+   CallStackTrie::Id stack_id = dynamic_cast<MemoryTracker::RoutineTracerThread*>(tracer)->getCallsiteStackId();
 
-   AllocationSite *site = NULL;
-   AllocationSites::iterator it = m_allocation_sites.find(stack);
-   if (it != m_allocation_sites.end())
-      site = it->second;
-   else
-   {
+   AllocationSite *&site = m_allocation_sites[stack_id];
+   if (site == NULL)
       site = new AllocationSite();
-      m_allocation_sites[stack] = site;
-   }
 
    // Store the first address of the first cache line that no longer belongs to the allocation
    UInt64 lower = address & ~63, upper = (address + size + 63) & ~63;
@@ -108,13 +104,25 @@ void MemoryTracker::logMalloc(thread_id_t thread_id, UInt64 eip, UInt64 address,
 
    m_allocations[upper] = Allocation(upper - lower, site);
 
+   // Pages fully inside the new allocation now belong to it, the (partial) first and last page are owned by more than one
+   UInt64 page_lower = lower >> PAGE_SHIFT, page_upper = (upper - 1) >> PAGE_SHIFT;
+   for(UInt64 page = page_lower; page <= page_upper; ++page)
+   {
+      if ((page << PAGE_SHIFT) >= lower && ((page + 1) << PAGE_SHIFT) <= upper)
+         m_allocation_pages[page] = site;
+      else
+         m_allocation_pages.erase(page);
+   }
+   // Invalidate all per-core owner caches
+   ++m_generation;
+
    #ifdef ASSERT_FIND_OWNER
       for(UInt64 addr = lower; addr < upper; addr += 64)
          m_allocations_slow[addr] = site;
    #endif
 
-   m_allocation_sites[stack]->num_allocations++;
-   m_allocation_sites[stack]->total_size += size;
+   site->num_allocations++;
+   site->total_size += size;
 }
 
 void MemoryTracker::logFree(thread_id_t thread_id, UInt64 eip, UInt64 address)
@@ -126,15 +134,39 @@ void MemoryTracker::logFree(thread_id_t thread_id, UInt64 eip, UInt64 address)
 
 UInt64 MemoryTracker::ce_get_owner(core_id_t core_id, UInt64 address)
 {
-   ScopedLock sl(m_lock);
+   ScopedReadLock sl(m_lock);
    AllocationSite *owner = NULL;
 
-   // upper_bound returns the first entry greater than address
-   // Because the key in m_allocations is the first cache line that no longer falls into the range,
-   // we will find the correct alloction *if* address falls within it
-   auto upper = m_allocations.upper_bound(address);
-   if (upper != m_allocations.end() && address >= upper->first - upper->second.size)
-      owner = upper->second.site;
+   // Each core only updates its own entry, which is safe under the read lock
+   OwnerCache *cache = (core_id >= 0 && (UInt32)core_id < m_owner_cache.size()) ? &m_owner_cache[core_id] : NULL;
+   AllocationPages::const_iterator page;
+
+   if (cache && cache->generation == m_generation && address >= cache->start && address < cache->end)
+   {
+      owner = cache->site;
+   }
+   else if ((page = m_allocation_pages.find(address >> PAGE_SHIFT)) != m_allocation_pages.end())
+   {
+      owner = page->second;
+   }
+   else
+   {
+      // upper_bound returns the first entry greater than address
+      // Because the key in m_allocations is the first cache line that no longer falls into the range,
+      // we will find the correct alloction *if* address falls within it
+      auto upper = m_allocations.upper_bound(address);
+      if (upper != m_allocations.end() && address >= upper->first - upper->second.size)
+      {
+         owner = upper->second.site;
+         if (cache)
+         {
+            cache->generation = m_generation;
+            cache->start = upper->first - upper->second.size;
+            cache->end = upper->first;
+            cache->site = owner;
+         }
+      }
+   }
 
    #ifdef ASSERT_FIND_OWNER
       AllocationSite *owner_slow = (m_allocations_slow.count(address & ~63) == 0) ? NULL : m_allocations_slow[address & ~63];
@@ -203,10 +235,10 @@ bool MemoryTracker::RoutineTracer::hasRoutine(IntPtr eip)
 
 void MemoryTracker::RoutineTracerThread::functionEnter(IntPtr eip, IntPtr callEip)
 {
-   m_callsite_stack.push_back(callEip);
+   m_callsite_ids.push_back(m_call_stacks->push(getCallsiteStackId(), callEip));
 }
 
 void MemoryTracker::RoutineTracerThread::functionExit(IntPtr eip)
 {
-   m_callsite_stack.pop_back();
+   m_callsite_ids.pop_back();
 }
@@ -21,14 +21,15 @@ class MemoryTracker
       {
          public:
             RoutineTracerThread(Thread *thread) : ::RoutineTracerThread(thread) {}
-            const CallStack& getCallsiteStack() const { return m_callsite_stack; }
+            CallStackTrie::Id getCallsiteStackId() const { return m_callsite_ids.empty() ? CallStackTrie::EMPTY : m_callsite_ids.back(); }
          protected:
             virtual void functionEnter(IntPtr eip, IntPtr callEip);
             virtual void functionExit(IntPtr eip);
             virtual void functionChildEnter(IntPtr eip, IntPtr eip_child) {}
             virtual void functionChildExit(IntPtr eip, IntPtr eip_child) {}
          private:
-            CallStack m_callsite_stack;
+            // Interned id of the stack of call sites at each depth
+            std::vector<CallStackTrie::Id> m_callsite_ids;
       };
       class RoutineTracer : public ::RoutineTracer
       {
@@ -68,7 +69,7 @@ class MemoryTracker
          std::vector<UInt64> hit_where_load, hit_where_store;
          std::unordered_map<AllocationSite*, UInt64> evicted_by;
       };
-      typedef std::unordered_map<CallStack, AllocationSite*> AllocationSites;
+      typedef std::unordered_map<CallStackTrie::Id, AllocationSite*> AllocationSites;
 
       struct Allocation
       {
@@ -79,9 +80,25 @@ class MemoryTracker
       };
       typedef std::map<UInt64, Allocation> Allocations;
 
-      Lock m_lock;
+      // Pages that are completely covered by a single allocation, so most lookups can skip the ordered search
+      static const UInt64 PAGE_SHIFT = 12;
+      typedef std::unordered_map<UInt64, AllocationSite*> AllocationPages;
+
+      // Last allocation found by each core, valid as long as no allocations were added since (m_generation unchanged)
+      struct OwnerCache
+      {
+         OwnerCache() : generation(0), start(0), end(0), site(NULL) {}
+         UInt64 generation;
+         UInt64 start, end;
+         AllocationSite *site;
+      };
+
+      RwLock m_lock;
       Allocations m_allocations;
+      AllocationPages m_allocation_pages;
       AllocationSites m_allocation_sites;
+      UInt64 m_generation;
+      std::vector<OwnerCache> m_owner_cache;
 
       #ifdef ASSERT_FIND_OWNER
          std::unordered_map<UInt64, AllocationSite*> m_allocations_slow;
@@ -9,8 +9,38 @@
 
 #include <cstring>
 
+CallStackTrie::CallStackTrie()
+{
+   // Node 0 is the empty stack
+   m_nodes.push_back(Node(EMPTY, 0));
+}
+
+CallStackTrie::Id CallStackTrie::push(Id parent, IntPtr eip)
+{
+   ScopedLock sl(m_lock);
+
+   Id &id = m_children[Key(parent, eip)];
+   if (id == EMPTY)
+   {
+      id = m_nodes.size();
+      m_nodes.push_back(Node(parent, eip));
+   }
+   return id;
+}
+
+CallStack CallStackTrie::getStack(Id id) const
+{
+   ScopedLock sl(m_lock);
+
+   CallStack stack;
+   for( ; id != EMPTY; id = m_nodes[id].parent)
+      stack.push_front(m_nodes[id].eip);
+   return stack;
+}
+
 RoutineTracerThread::RoutineTracerThread(Thread *thread)
    : m_thread(thread)
+   , m_call_stacks(Sim()->getRoutineTracer()->getCallStacks())
 {
    Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_BEGIN, __hook_roi_begin, (UInt64)this);
    Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_END, __hook_roi_end, (UInt64)this);
@@ -33,7 +63,7 @@ void RoutineTracerThread::routineEnter_unlocked(IntPtr eip, IntPtr esp, IntPtr c
       if (Sim()->getMagicServer()->inROI())
          functionChildEnter(m_stack.back(), eip);
 
-   m_stack.push_back(eip);
+   stackPush(eip);
    m_last_esp = esp;
 
    if (Sim()->getMagicServer()->inROI())
@@ -63,7 +93,7 @@ void RoutineTracerThread::routineExit(IntPtr eip, IntPtr esp)
       // Unwound into eip, now exit it
       if (Sim()->getMagicServer()->inROI())
          functionExit(eip);
-      m_stack.pop_back();
+      stackPop();
    }
 
    m_last_esp = esp;
@@ -123,7 +153,7 @@ bool RoutineTracerThread::unwindTo(IntPtr eip)
          {
             if (Sim()->getMagicServer()->inROI())
                functionExit(m_stack.back());
-            m_stack.pop_back();
+            stackPop();
             if (Sim()->getMagicServer()->inROI())
                functionChildExit(m_stack.back(), eip);
          }
@@ -164,15 +194,27 @@ void RoutineTracerThread::hookRoiEnd()
       functionExit(m_stack.back());
       eip_child = m_stack.back();
       stack_save.push_back(m_stack.back());
-      m_stack.pop_back();
+      stackPop();
    }
    while(stack_save.size())
    {
-      m_stack.push_back(stack_save.back());
+      stackPush(stack_save.back());
       stack_save.pop_back();
    }
 }
 
+void RoutineTracerThread::stackPush(IntPtr eip)
+{
+   m_stack_ids.push_back(m_call_stacks->push(getCallStackId(), eip));
+   m_stack.push_back(eip);
+}
+
+void RoutineTracerThread::stackPop()
+{
+   m_stack_ids.pop_back();
+   m_stack.pop_back();
+}
+
 RoutineTracer::Routine::Routine(IntPtr eip, const char *name, const char *imgname, IntPtr offset, int column, int line, const char *filename)
    : m_eip(eip)
    , m_name(NULL)
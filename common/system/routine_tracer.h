@@ -5,25 +5,47 @@
 #include "subsecond_time.h"
 
 #include <deque>
-#include <boost/functional/hash.hpp>
-
-// From http://stackoverflow.com/questions/8027368/are-there-no-specializations-of-stdhash-for-standard-containers
-namespace std
-{
-   template<typename T>
-   struct hash<std::deque<T> >
-   {
-      size_t operator()(const std::deque<T>& a) const
-      {
-         return boost::hash_range(a.begin(), a.end());
-      }
-   };
-}
+#include <vector>
+#include <unordered_map>
 
 class Thread;
 
 typedef std::deque<IntPtr> CallStack;
 
+// Interned call stacks: each stack is a trie node made of its parent stack and the eip on top, identified by an integer.
+// Entering a function is one lookup of a (parent, eip) pair, returning just drops back to the parent id,
+// and stacks can be used as map keys without hashing all of their entries.
+class CallStackTrie
+{
+   public:
+      typedef UInt64 Id;
+      static const Id EMPTY = 0;
+
+      CallStackTrie();
+
+      // Id of the stack parent with eip pushed on top, creating it on first use
+      Id push(Id parent, IntPtr eip);
+      // Reconstruct the stack for id, outermost entry first
+      CallStack getStack(Id id) const;
+
+   private:
+      struct Node
+      {
+         Node(Id _parent, IntPtr _eip) : parent(_parent), eip(_eip) {}
+         Id parent;
+         IntPtr eip;
+      };
+      typedef std::pair<Id, IntPtr> Key;
+      struct KeyHash
+      {
+         size_t operator()(const Key &key) const { return std::hash<Id>()(key.first * 0x9e3779b97f4a7c15ULL) ^ std::hash<IntPtr>()(key.second); }
+      };
+
+      mutable Lock m_lock;
+      std::vector<Node> m_nodes;
+      std::unordered_map<Key, Id, KeyHash> m_children;
+};
+
 class RoutineTracerThread
 {
    public:
@@ -35,14 +57,21 @@ class RoutineTracerThread
       void routineAssert(IntPtr eip, IntPtr esp);
 
       const CallStack& getCallStack() const { return m_stack; }
+      CallStackTrie::Id getCallStackId() const { return m_stack_ids.empty() ? CallStackTrie::EMPTY : m_stack_ids.back(); }
 
    protected:
       Lock m_lock;
       Thread *m_thread;
+      CallStackTrie *m_call_stacks;
       CallStack m_stack;
       IntPtr m_last_esp;
 
    private:
+      // Interned id of m_stack at each depth
+      std::vector<CallStackTrie::Id> m_stack_ids;
+
+      void stackPush(IntPtr eip);
+      void stackPop();
       bool unwindTo(IntPtr eip);
 
       void routineEnter_unlocked(IntPtr eip, IntPtr esp, IntPtr callEip);
@@ -83,6 +112,11 @@ class RoutineTracer
       virtual RoutineTracerThread* getThreadHandler(Thread *thread) = 0;
 
       virtual const Routine* getRoutineInfo(IntPtr eip) { return NULL; }
+
+      CallStackTrie* getCallStacks() { return &m_call_stacks; }
+
+   private:
+      CallStackTrie m_call_stacks;
 };
 
 #endif // __ROUTINE_TRACER_H
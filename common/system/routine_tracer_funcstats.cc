@@ -8,6 +8,9 @@
 #include "stats.h"
 #include "cache_efficiency_tracker.h"
 #include "utils.h"
+#include "hooks_manager.h"
+#include "magic_server.h"
+#include "config.hpp"
 
 #include <sstream>
 
@@ -59,15 +62,16 @@ void RoutineTracerFunctionStats::RtnThread::functionEndHelper(IntPtr eip, UInt64
    m_master->updateRoutine(eip, count, values);
 }
 
-void RoutineTracerFunctionStats::RtnThread::functionEndFullHelper(const CallStack &stack, UInt64 count)
+void RoutineTracerFunctionStats::RtnThread::functionEndFullHelper(CallStackTrie::Id stack_id, IntPtr eip, UInt64 count)
 {
    RtnValues values;
+   RtnValues &values_start = m_values_start_full[stack_id];
    const ThreadStatsManager::ThreadStatTypeList& types = Sim()->getThreadStatsManager()->getThreadStatTypes();
    for(auto it = types.begin(); it != types.end(); ++it)
    {
-      values[*it] = getThreadStat(*it) - m_values_start_full[stack][*it];
+      values[*it] = getThreadStat(*it) - values_start[*it];
    }
-   m_master->updateRoutineFull(stack, count, values);
+   m_master->updateRoutineFull(stack_id, eip, count, values);
 }
 
 void RoutineTracerFunctionStats::RtnThread::functionBegin(IntPtr eip)
@@ -76,7 +80,7 @@ void RoutineTracerFunctionStats::RtnThread::functionBegin(IntPtr eip)
 
    functionBeginHelper(eip, m_values_start);
    if (m_stack.size())
-      functionBeginHelper(eip, m_values_start_full[m_stack]);
+      functionBeginHelper(eip, m_values_start_full[getCallStackId()]);
 
 }
 
@@ -86,7 +90,7 @@ void RoutineTracerFunctionStats::RtnThread::functionEnd(IntPtr eip, bool is_func
 
    functionEndHelper(eip, is_function_start ? 1 : 0);
    if (m_stack.size())
-      functionEndFullHelper(m_stack, is_function_start ? 1 : 0);
+      functionEndFullHelper(getCallStackId(), m_stack.back(), is_function_start ? 1 : 0);
 }
 
 UInt64 RoutineTracerFunctionStats::RtnThread::getThreadStat(ThreadStatsManager::ThreadStatType type)
@@ -99,12 +103,44 @@ UInt64 RoutineTracerFunctionStats::RtnThread::getCurrentRoutineId()
    ScopedLock sl(m_lock);
 
    if (m_stack.size())
-      return (UInt64)m_master->getRoutineFullPtr(m_stack);
+      return (UInt64)m_master->getRoutineFullPtr(getCallStackId(), m_stack.back());
    else
       return 0;
 }
 
+RoutineTracerFunctionStats::SampledRtnThread::SampledRtnThread(RoutineTracerFunctionStats::RtnMaster *master, Thread *thread)
+   : RtnThread(master, thread)
+   , m_master(master)
+{
+}
+
+void RoutineTracerFunctionStats::SampledRtnThread::sample(bool attribute)
+{
+   ScopedLock sl(m_lock);
+
+   Sim()->getThreadStatsManager()->update(m_thread->getId());
+
+   RtnValues values;
+   bool changed = false;
+   const ThreadStatsManager::ThreadStatTypeList& types = Sim()->getThreadStatsManager()->getThreadStatTypes();
+   for(auto it = types.begin(); it != types.end(); ++it)
+   {
+      UInt64 value = Sim()->getThreadStatsManager()->getThreadStatistic(m_thread->getId(), *it);
+      values[*it] = value - m_values_last[*it];
+      changed |= values[*it] != 0;
+      m_values_last[*it] = value;
+   }
+
+   // Threads that did not run or wait since the last sample do not add a sample to their current routine
+   if (attribute && changed && m_stack.size())
+   {
+      m_master->updateRoutine(m_stack.back(), 1, values);
+      m_master->updateRoutineFull(getCallStackId(), m_stack.back(), 1, values);
+   }
+}
+
 RoutineTracerFunctionStats::RtnMaster::RtnMaster()
+   : m_sample_interval(Sim()->getCfg()->getInt("routine_tracer/funcstats/sample_interval") * SubsecondTime::NS().getFS())
 {
    ThreadStatNamedStat::registerStat("fp_addsub", "interval_timer", "uop_fp_addsub");
    ThreadStatNamedStat::registerStat("fp_muldiv", "interval_timer", "uop_fp_muldiv");
@@ -117,10 +153,21 @@ RoutineTracerFunctionStats::RtnMaster::RtnMaster()
       ThreadStatNamedStat::registerStat("cpiBranchPredictor", "rob_timer", "cpiBranchPredictor");
    ThreadStatCpiMem::registerStat();
    Sim()->getConfig()->setCacheEfficiencyCallbacks(__ce_get_owner, NULL, __ce_notify_evict, (UInt64)this);
+
+   if (isSampled())
+   {
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_BEGIN, __hook_roi_begin, (UInt64)this);
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_ROI_END, __hook_roi_end, (UInt64)this);
+      Sim()->getHooksManager()->scheduleTimer(HooksManager::TIMER_TIME, m_sample_interval, __sample_timer, (UInt64)this);
+   }
 }
 
 RoutineTracerFunctionStats::RtnMaster::~RtnMaster()
 {
+   // Charge the tail of the run when the ROI was never closed
+   if (isSampled() && Sim()->getMagicServer()->inROI())
+      sampleThreads(true);
+
    writeResults(Sim()->getConfig()->formatOutputFileName("sim.rtntrace").c_str());
    writeResultsFull(Sim()->getConfig()->formatOutputFileName("sim.rtntracefull").c_str());
 }
@@ -152,9 +199,24 @@ void RoutineTracerFunctionStats::RtnMaster::ce_notify_evict(bool on_roi_end, UIn
    rtn->m_bits_total += bits_total;
 }
 
+UInt64 RoutineTracerFunctionStats::RtnMaster::__sample_timer(UInt64 user, UInt64 now)
+{
+   RtnMaster *master = (RtnMaster*)user;
+   if (Sim()->getMagicServer()->inROI())
+      master->sampleThreads(true);
+   return now + master->m_sample_interval;
+}
+
+void RoutineTracerFunctionStats::RtnMaster::sampleThreads(bool attribute)
+{
+   // Without attribution (at the start of the ROI), this only moves each thread's baseline forward
+   for(auto it = m_threads.begin(); it != m_threads.end(); ++it)
+      ((SampledRtnThread*)it->second)->sample(attribute);
+}
+
 RoutineTracerThread* RoutineTracerFunctionStats::RtnMaster::getThreadHandler(Thread *thread)
 {
-   RtnThread* thread_handler = new RtnThread(this, thread);
+   RtnThread* thread_handler = isSampled() ? new SampledRtnThread(this, thread) : new RtnThread(this, thread);
    m_threads[thread->getId()] = thread_handler;
    return thread_handler;
 }
@@ -203,27 +265,28 @@ void RoutineTracerFunctionStats::RtnMaster::updateRoutine(IntPtr eip, UInt64 cal
    }
 }
 
-RoutineTracerFunctionStats::Routine* RoutineTracerFunctionStats::RtnMaster::getRoutineFullPtr(const CallStack& stack)
+RoutineTracerFunctionStats::Routine* RoutineTracerFunctionStats::RtnMaster::getRoutineFullPtr(CallStackTrie::Id stack_id, IntPtr eip)
 {
    ScopedLock sl(m_lock);
 
-   if (m_routines.count(stack.back()) == 0)
+   RoutineTracerFunctionStats::Routine *&rtn_full = m_callstack_routines[stack_id];
+   if (rtn_full == NULL)
    {
-      m_routines[stack.back()] = new RoutineTracerFunctionStats::Routine(stack.back(), "(unknown)", "(unknown)", 0, 0, 0, "");
-      m_routines[stack.back()]->setProvisional(true);
-   }
+      if (m_routines.count(eip) == 0)
+      {
+         m_routines[eip] = new RoutineTracerFunctionStats::Routine(eip, "(unknown)", "(unknown)", 0, 0, 0, "");
+         m_routines[eip]->setProvisional(true);
+      }
 
-   if (m_callstack_routines.count(stack) == 0)
-   {
-      m_callstack_routines[stack] = new RoutineTracerFunctionStats::Routine(*m_routines[stack.back()]);
+      rtn_full = new RoutineTracerFunctionStats::Routine(*m_routines[eip]);
    }
 
-   return m_callstack_routines[stack];
+   return rtn_full;
 }
 
-void RoutineTracerFunctionStats::RtnMaster::updateRoutineFull(const CallStack& stack, UInt64 calls, RtnValues values)
+void RoutineTracerFunctionStats::RtnMaster::updateRoutineFull(CallStackTrie::Id stack_id, IntPtr eip, UInt64 calls, RtnValues values)
 {
-   updateRoutineFull(getRoutineFullPtr(stack), calls, values);
+   updateRoutineFull(getRoutineFullPtr(stack_id, eip), calls, values);
 }
 
 void RoutineTracerFunctionStats::RtnMaster::updateRoutineFull(RoutineTracerFunctionStats::Routine* rtn, UInt64 calls, RtnValues values)
@@ -284,9 +347,10 @@ void RoutineTracerFunctionStats::RtnMaster::writeResultsFull(const char *filenam
    {
       if (it->second->m_calls)
       {
+         const CallStack stack = getCallStacks()->getStack(it->first);
          std::ostringstream s;
-         s << std::hex << it->first.front();
-         for (auto kt = ++it->first.begin(); kt != it->first.end(); ++kt)
+         s << std::hex << stack.front();
+         for (auto kt = ++stack.begin(); kt != stack.end(); ++kt)
          {
             s << ":" << std::hex << *kt << std::dec;
          }
@@ -45,21 +45,26 @@ class RoutineTracerFunctionStats
             RtnMaster();
             virtual ~RtnMaster();
 
+            // Sampling mode ([routine_tracer/funcstats/sample_interval] != 0): threads only keep their call stack,
+            // statistics are attributed to the innermost routine of each stack once per interval
+            bool isSampled() const { return m_sample_interval != 0; }
+
             virtual RoutineTracerThread* getThreadHandler(Thread *thread);
             virtual void addRoutine(IntPtr eip, const char *name, const char *imgname, IntPtr offset, int column, int line, const char *filename);
             virtual bool hasRoutine(IntPtr eip);
             void updateRoutine(IntPtr eip, UInt64 calls, RtnValues values);
-            void updateRoutineFull(const CallStack& stack, UInt64 calls, RtnValues values);
+            void updateRoutineFull(CallStackTrie::Id stack_id, IntPtr eip, UInt64 calls, RtnValues values);
             void updateRoutineFull(RoutineTracerFunctionStats::Routine* rtn, UInt64 calls, RtnValues values);
-            RoutineTracerFunctionStats::Routine* getRoutineFullPtr(const CallStack& stack);
+            RoutineTracerFunctionStats::Routine* getRoutineFullPtr(CallStackTrie::Id stack_id, IntPtr eip);
 
          private:
             Lock m_lock;
+            const UInt64 m_sample_interval; // in fs
             // Flat-profile per-thread statistics (excludes statistics from child calls).
             typedef std::unordered_map<IntPtr, RoutineTracerFunctionStats::Routine*> RoutineMap;
             RoutineMap m_routines;
             // Call-stack-based statistics (includes statistics from child calls).
-            typedef std::unordered_map<CallStack, RoutineTracerFunctionStats::Routine*> RoutineMapFull;
+            typedef std::unordered_map<CallStackTrie::Id, RoutineTracerFunctionStats::Routine*> RoutineMapFull;
             RoutineMapFull m_callstack_routines;
 
             UInt64 ce_get_owner(core_id_t core_id, UInt64 address);
@@ -70,6 +75,11 @@ class RoutineTracerFunctionStats
             static void __ce_notify_evict(UInt64 user, bool on_roi_end, UInt64 owner, UInt64 evictor, CacheBlockInfo::BitsUsedType bits_used, UInt32 bits_total)
             { ((RtnMaster*)user)->ce_notify_evict(on_roi_end, owner, evictor, bits_used, bits_total); }
 
+            void sampleThreads(bool attribute);
+            static UInt64 __sample_timer(UInt64 user, UInt64 now);
+            static SInt64 __hook_roi_begin(UInt64 user, UInt64 arg) { ((RtnMaster*)user)->sampleThreads(false); return 0; }
+            static SInt64 __hook_roi_end(UInt64 user, UInt64 arg) { ((RtnMaster*)user)->sampleThreads(true); return 0; }
+
             void writeResults(const char *filename);
             void writeResultsFull(const char *filename);
       };
@@ -85,14 +95,14 @@ class RoutineTracerFunctionStats
 
             IntPtr m_current_eip;
             RtnValues m_values_start;
-            std::unordered_map<CallStack, RtnValues> m_values_start_full;
+            std::unordered_map<CallStackTrie::Id, RtnValues> m_values_start_full;
 
             void functionBegin(IntPtr eip);
             void functionEnd(IntPtr eip, bool is_function_start);
 
             void functionBeginHelper(IntPtr eip, RtnValues&);
             void functionEndHelper(IntPtr eip, UInt64 count);
-            void functionEndFullHelper(const CallStack &stack, UInt64 count);
+            void functionEndFullHelper(CallStackTrie::Id stack_id, IntPtr eip, UInt64 count);
 
             UInt64 getThreadStat(ThreadStatsManager::ThreadStatType type);
 
@@ -103,6 +113,26 @@ class RoutineTracerFunctionStats
             virtual void functionChildExit(IntPtr eip, IntPtr eip_child);
       };
 
+      // Thread handler for sampling mode: routine entries and exits only maintain the call stack,
+      // the master periodically calls sample() to charge the statistics accrued since the previous sample.
+      // The calls column then counts samples rather than calls.
+      class SampledRtnThread : public RtnThread
+      {
+         public:
+            SampledRtnThread(RtnMaster *master, Thread *thread);
+            void sample(bool attribute);
+
+         private:
+            RtnMaster *m_master;
+            RtnValues m_values_last;
+
+         protected:
+            virtual void functionEnter(IntPtr eip, IntPtr callEip) {}
+            virtual void functionExit(IntPtr eip) {}
+            virtual void functionChildEnter(IntPtr eip, IntPtr eip_child) {}
+            virtual void functionChildExit(IntPtr eip, IntPtr eip_child) {}
+      };
+
       class ThreadStatAggregates
       {
          public:
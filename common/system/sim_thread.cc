@@ -5,6 +5,7 @@
 #include "core.h"
 #include "sim_thread_manager.h"
 #include "sim_api.h"
+#include "host_topology.h"
 
 SimThread::SimThread()
    : m_thread(NULL)
@@ -23,6 +24,7 @@ void SimThread::run()
    // Set thread name for Sniper-in-Sniper simulations
    String threadName = String("sim-") + itostr(core_id);
    SimSetThreadName(threadName.c_str());
+   Sim()->getHostTopology()->bindThread(core_id);
 
    LOG_PRINT("Sim thread starting...");
 
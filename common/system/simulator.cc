@@ -27,6 +27,19 @@
 #include "instruction_tracer.h"
 #include "memory_tracker.h"
 #include "circular_log.h"
+#include "trace_log.h"
+#include "self_profiler.h"
+#include "core_state_predictor_manager.h"
+#include "core_state_timeline.h"
+#include "numa_topology.h"
+#include "host_topology.h"
+#include "qos_manager.h"
+#include "checkpoint_manager.h"
+#include "warmup_sampler.h"
+#include "energy_model.h"
+#include "deterministic_order.h"
+#include "telemetry.h"
+#include "memory_sampler.h"
 
 #include <sstream>
 
@@ -122,6 +135,17 @@ Simulator::Simulator()
    , m_faultinjection_manager(NULL)
    , m_rtn_tracer(NULL)
    , m_memory_tracker(NULL)
+   , m_core_state_predictor_manager(NULL)
+   , m_core_state_timeline(NULL)
+   , m_numa_topology(NULL)
+   , m_host_topology(NULL)
+   , m_qos_manager(NULL)
+   , m_checkpoint_manager(NULL)
+   , m_warmup_sampler(NULL)
+   , m_energy_model(NULL)
+   , m_deterministic_order(NULL)
+   , m_telemetry(NULL)
+   , m_memory_sampler(NULL)
    , m_running(false)
    , m_inst_mode_output(true)
 {
@@ -143,13 +167,24 @@ void Simulator::start()
    m_faultinjection_manager = FaultinjectionManager::create();
    m_thread_stats_manager = new ThreadStatsManager();
    m_clock_skew_minimization_manager = ClockSkewMinimizationManager::create();
+   m_deterministic_order = DeterministicOrder::create();
    m_clock_skew_minimization_server = ClockSkewMinimizationServer::create();
+   m_numa_topology = NumaTopology::create();
+   m_qos_manager = QosManager::create();
+   m_host_topology = new HostTopology();
    m_core_manager = new CoreManager();
    m_sim_thread_manager = new SimThreadManager();
    m_sampling_manager = new SamplingManager();
    m_fastforward_performance_manager = FastForwardPerformanceManager::create();
    m_rtn_tracer = RoutineTracer::create();
    m_thread_manager = new ThreadManager();
+   m_core_state_predictor_manager = CoreStatePredictorManager::create();
+   m_core_state_timeline = CoreStateTimeline::create();
+   m_checkpoint_manager = CheckpointManager::create();
+   m_warmup_sampler = WarmupSampler::create();
+   m_energy_model = new EnergyModel();
+   m_telemetry = Telemetry::create();
+   m_memory_sampler = MemorySampler::create();
 
    if (Sim()->getCfg()->getBool("traceinput/enabled"))
       m_trace_manager = new TraceManager();
@@ -157,6 +192,9 @@ void Simulator::start()
       m_trace_manager = NULL;
 
    CircularLog::enableCallbacks();
+   TraceLog::enableCallbacks();
+   m_stats_manager->enableCallbacks();
+   SelfProfiler::init();
 
    InstructionTracer::init();
 
@@ -176,6 +214,7 @@ void Simulator::start()
    InstMode::inst_mode_roi  = InstMode::fromString(getCfg()->getString("general/inst_mode_roi"));
    InstMode::inst_mode_end  = InstMode::fromString(getCfg()->getString("general/inst_mode_end"));
    m_inst_mode_output = getCfg()->getBool("general/inst_mode_output");
+   InstMode::reinstrument_fast_forward = getConfig()->getSimulationMode() == Config::PINTOOL && getCfg()->getBool("general/reinstrument_fast_forward");
 
    printInstModeSummary();
    setInstrumentationMode(InstMode::inst_mode_init, true /* update_barrier */);
@@ -187,7 +226,9 @@ void Simulator::start()
 //   m_transport->barrier();
 
    m_hooks_manager->callHooks(HookType::HOOK_SIM_START, 0);
-   m_stats_manager->recordStats("start");
+   // A resumed simulation already has its start snapshot, copied from the checkpoint
+   if (!(m_checkpoint_manager && m_checkpoint_manager->isResuming()))
+      m_stats_manager->recordStats("start");
    if (Sim()->getFastForwardPerformanceManager())
    {
       Sim()->getFastForwardPerformanceManager()->enable();
@@ -222,6 +263,14 @@ Simulator::~Simulator()
 
    m_hooks_manager->fini();
 
+   if (m_telemetry)
+   {
+      delete m_telemetry;              m_telemetry = NULL;
+   }
+   if (m_memory_sampler)
+   {
+      delete m_memory_sampler;         m_memory_sampler = NULL;
+   }
    if (m_clock_skew_minimization_manager)
    {
       delete m_clock_skew_minimization_manager; m_clock_skew_minimization_manager = NULL;
@@ -241,6 +290,23 @@ Simulator::~Simulator()
    }
    // Don't remove the trace manager as threads could still be alive even if they are done
    //delete m_trace_manager;             m_trace_manager = NULL;
+   if (m_core_state_predictor_manager)
+   {
+      delete m_core_state_predictor_manager; m_core_state_predictor_manager = NULL;
+   }
+   if (m_core_state_timeline)
+   {
+      delete m_core_state_timeline;    m_core_state_timeline = NULL;
+   }
+   if (m_checkpoint_manager)
+   {
+      delete m_checkpoint_manager;     m_checkpoint_manager = NULL;
+   }
+   if (m_warmup_sampler)
+   {
+      delete m_warmup_sampler;         m_warmup_sampler = NULL;
+   }
+   delete m_energy_model;              m_energy_model = NULL;
    delete m_sampling_manager;          m_sampling_manager = NULL;
    if (m_faultinjection_manager)
    {
@@ -251,6 +317,19 @@ Simulator::~Simulator()
    //delete m_thread_manager;            m_thread_manager = NULL;
    delete m_thread_stats_manager;      m_thread_stats_manager = NULL;
    delete m_core_manager;              m_core_manager = NULL;
+   if (m_deterministic_order)
+   {
+      delete m_deterministic_order;    m_deterministic_order = NULL;
+   }
+   delete m_host_topology;             m_host_topology = NULL;
+   if (m_numa_topology)
+   {
+      delete m_numa_topology;          m_numa_topology = NULL;
+   }
+   if (m_qos_manager)
+   {
+      delete m_qos_manager;            m_qos_manager = NULL;
+   }
    delete m_dvfs_manager;              m_dvfs_manager = NULL;
    delete m_magic_server;              m_magic_server = NULL;
    delete m_sync_server;               m_sync_server = NULL;
@@ -261,18 +340,19 @@ Simulator::~Simulator()
    delete m_stats_manager;             m_stats_manager = NULL;
 }
 
+// Cores switch their models at their next instruction boundary, see Core::setPerformanceModelsEnabled
 void Simulator::enablePerformanceModels()
 {
    if (Sim()->getFastForwardPerformanceManager() && InstMode::inst_mode_roi == InstMode::DETAILED)
       Sim()->getFastForwardPerformanceManager()->disable();
    for (UInt32 i = 0; i < Sim()->getConfig()->getTotalCores(); i++)
-      Sim()->getCoreManager()->getCoreFromID(i)->enablePerformanceModels();
+      Sim()->getCoreManager()->getCoreFromID(i)->setPerformanceModelsEnabled(true);
 }
 
 void Simulator::disablePerformanceModels()
 {
    for (UInt32 i = 0; i < Sim()->getConfig()->getTotalCores(); i++)
-      Sim()->getCoreManager()->getCoreFromID(i)->disablePerformanceModels();
+      Sim()->getCoreManager()->getCoreFromID(i)->setPerformanceModelsEnabled(false);
    if (Sim()->getFastForwardPerformanceManager() && InstMode::inst_mode_roi == InstMode::DETAILED)
       Sim()->getFastForwardPerformanceManager()->enable();
 }
@@ -29,6 +29,17 @@ class FaultinjectionManager;
 class TagsManager;
 class RoutineTracer;
 class MemoryTracker;
+class CoreStatePredictorManager;
+class CoreStateTimeline;
+class NumaTopology;
+class QosManager;
+class HostTopology;
+class CheckpointManager;
+class WarmupSampler;
+class EnergyModel;
+class DeterministicOrder;
+class Telemetry;
+class MemorySampler;
 namespace config { class Config; }
 
 class Simulator
@@ -70,6 +81,16 @@ public:
    TagsManager *getTagsManager() { return m_tags_manager; }
    RoutineTracer *getRoutineTracer() { return m_rtn_tracer; }
    MemoryTracker *getMemoryTracker() { return m_memory_tracker; }
+   CoreStatePredictorManager *getCoreStatePredictorManager() { return m_core_state_predictor_manager; }
+   CoreStateTimeline *getCoreStateTimeline() { return m_core_state_timeline; }
+   NumaTopology *getNumaTopology() { return m_numa_topology; }
+   HostTopology *getHostTopology() { return m_host_topology; }
+   QosManager *getQosManager() { return m_qos_manager; }
+   CheckpointManager *getCheckpointManager() { return m_checkpoint_manager; }
+   WarmupSampler *getWarmupSampler() { return m_warmup_sampler; }
+   EnergyModel *getEnergyModel() { return m_energy_model; }
+   DeterministicOrder *getDeterministicOrder() { return m_deterministic_order; }
+   MemorySampler *getMemorySampler() { return m_memory_sampler; }
    void setMemoryTracker(MemoryTracker *memory_tracker) { m_memory_tracker = memory_tracker; }
 
    bool isRunning() { return m_running; }
@@ -106,6 +127,17 @@ private:
    FaultinjectionManager *m_faultinjection_manager;
    RoutineTracer *m_rtn_tracer;
    MemoryTracker *m_memory_tracker;
+   CoreStatePredictorManager *m_core_state_predictor_manager;
+   CoreStateTimeline *m_core_state_timeline;
+   NumaTopology *m_numa_topology;
+   HostTopology *m_host_topology;
+   QosManager *m_qos_manager;
+   CheckpointManager *m_checkpoint_manager;
+   WarmupSampler *m_warmup_sampler;
+   EnergyModel *m_energy_model;
+   DeterministicOrder *m_deterministic_order;
+   Telemetry *m_telemetry;
+   MemorySampler *m_memory_sampler;
 
    bool m_running;
    bool m_inst_mode_output;
@@ -39,6 +39,11 @@ std::pair<SubsecondTime, bool> SyncClient::mutexTrylock(carbon_mutex_t *mux)
 std::pair<SubsecondTime, bool> SyncClient::__mutexLock(carbon_mutex_t *mux, bool tryLock, SubsecondTime delay)
 {
    Thread *thread = Sim()->getThreadManager()->getCurrentThread();
+
+   // Uncontended: no futex call, the only cost is the access to the mutex which the caller already modeled
+   if (m_server->isFastMutex() && m_server->mutexLockFast(thread->getId(), mux))
+      return std::pair<SubsecondTime, bool>(SubsecondTime::Zero(), true);
+
    Core *core = thread->getCore();
    SubsecondTime start_time = core->getPerformanceModel()->getElapsedTime() + delay;
 
@@ -55,6 +60,10 @@ std::pair<SubsecondTime, bool> SyncClient::__mutexLock(carbon_mutex_t *mux, bool
 SubsecondTime SyncClient::mutexUnlock(carbon_mutex_t *mux, SubsecondTime delay)
 {
    Thread *thread = Sim()->getThreadManager()->getCurrentThread();
+
+   if (m_server->isFastMutex() && m_server->mutexUnlockFast(thread->getId(), mux))
+      return SubsecondTime::Zero();
+
    SubsecondTime start_time = thread->getCore()->getPerformanceModel()->getElapsedTime() + delay;
 
    SubsecondTime time = m_server->mutexUnlock(thread->getId(), mux, start_time);
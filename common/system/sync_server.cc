@@ -8,7 +8,8 @@
 // -- SimMutex -- //
 
 SimMutex::SimMutex()
-      : m_owner(NO_OWNER)
+      : m_state(UNLOCKED)
+      , m_owner(NO_OWNER)
 { }
 
 SimMutex::~SimMutex()
@@ -27,7 +28,7 @@ SimMutex::~SimMutex()
 
 bool SimMutex::isLocked(thread_id_t thread_id)
 {
-   if (m_owner == NO_OWNER)
+   if (m_state.load(std::memory_order_acquire) == UNLOCKED)
       return false;
    else if (m_owner == thread_id)
       return false;
@@ -35,11 +36,53 @@ bool SimMutex::isLocked(thread_id_t thread_id)
       return true;
 }
 
-SubsecondTime SimMutex::lock(thread_id_t thread_id, SubsecondTime time)
+bool SimMutex::lockFast(thread_id_t thread_id)
 {
-   if (m_owner == NO_OWNER)
+   UInt32 state = UNLOCKED;
+   if (m_state.compare_exchange_strong(state, LOCKED, std::memory_order_acquire))
    {
       m_owner = thread_id;
+      return true;
+   }
+   return false;
+}
+
+bool SimMutex::unlockFast(thread_id_t thread_id)
+{
+   assert(m_owner == thread_id);
+   // Once we release the lock, someone else may take it and set m_owner
+   m_owner = NO_OWNER;
+   UInt32 state = LOCKED;
+   if (m_state.compare_exchange_strong(state, UNLOCKED, std::memory_order_release))
+      return true;
+   m_owner = thread_id;
+   return false;
+}
+
+bool SimMutex::acquireOrMarkWaiting(thread_id_t thread_id)
+{
+   UInt32 state = m_state.load(std::memory_order_relaxed);
+   while (true)
+   {
+      if (state == UNLOCKED)
+      {
+         if (m_state.compare_exchange_weak(state, LOCKED, std::memory_order_acquire))
+         {
+            m_owner = thread_id;
+            return true;
+         }
+      }
+      else if (state == LOCKED_WAITERS || m_state.compare_exchange_weak(state, LOCKED_WAITERS, std::memory_order_relaxed))
+      {
+         return false;
+      }
+   }
+}
+
+SubsecondTime SimMutex::lock(thread_id_t thread_id, SubsecondTime time)
+{
+   if (acquireOrMarkWaiting(thread_id))
+   {
       return time;
    }
    else
@@ -51,9 +94,8 @@ SubsecondTime SimMutex::lock(thread_id_t thread_id, SubsecondTime time)
 
 bool SimMutex::lock_async(thread_id_t thread_id, thread_id_t thread_by, SubsecondTime time)
 {
-   if (m_owner == NO_OWNER)
+   if (acquireOrMarkWaiting(thread_id))
    {
-      m_owner = thread_id;
       Sim()->getThreadManager()->resumeThread(m_owner, thread_by, time);
       return true;
    }
@@ -69,16 +111,21 @@ thread_id_t SimMutex::unlock(thread_id_t thread_id, SubsecondTime time)
    assert(m_owner == thread_id);
    if (m_waiting.empty())
    {
+      // Waiters only queue up under the thread lock, which we hold: nobody can be marking the mutex right now
       m_owner = NO_OWNER;
+      m_state.store(UNLOCKED, std::memory_order_release);
+      return NO_OWNER;
    }
    else
    {
       thread_id_t waiter = m_waiting.front();
       m_waiting.pop();
       m_owner = waiter;
-      Sim()->getThreadManager()->resumeThread(m_owner, thread_id, time);
+      if (m_waiting.empty())
+         m_state.store(LOCKED, std::memory_order_relaxed);
+      Sim()->getThreadManager()->resumeThread(waiter, thread_id, time);
+      return waiter;
    }
-   return m_owner;
 }
 
 // -- SimCond -- //
@@ -185,6 +232,7 @@ SubsecondTime SimBarrier::wait(thread_id_t thread_id, SubsecondTime time)
 SyncServer::SyncServer()
 {
    m_reschedule_cost = SubsecondTime::NS() * Sim()->getCfg()->getInt("perf_model/sync/reschedule_cost");
+   m_fast_mutex = Sim()->getCfg()->getBool("perf_model/sync/fast_mutex");
 }
 
 SyncServer::~SyncServer()
@@ -194,12 +242,13 @@ SimMutex * SyncServer::getMutex(carbon_mutex_t *mux, bool canCreate)
 {
    // if mux is the address of a pthread mutex (with default initialization, not through pthread_mutex_init),
    // look it up in m_mutexes or create a new one if it's the first time we see it
-   if (m_mutexes.count(mux))
-      return &m_mutexes[mux];
+   MutexStripe &stripe = m_mutexes[(uintptr_t(mux) >> 6) % MUTEX_STRIPES];
+   ScopedLock sl(stripe.lock);
+   if (stripe.mutexes.count(mux))
+      return &stripe.mutexes[mux];
    else if (canCreate)
    {
-      m_mutexes[mux] = SimMutex();
-      return &m_mutexes[mux];
+      return &stripe.mutexes[mux];
    }
    else
    {
@@ -242,6 +291,16 @@ SubsecondTime SyncServer::mutexUnlock(thread_id_t thread_id, carbon_mutex_t *mux
    return new_time;
 }
 
+bool SyncServer::mutexLockFast(thread_id_t thread_id, carbon_mutex_t *mux)
+{
+   return getMutex(mux)->lockFast(thread_id);
+}
+
+bool SyncServer::mutexUnlockFast(thread_id_t thread_id, carbon_mutex_t *mux)
+{
+   return getMutex(mux, false)->unlockFast(thread_id);
+}
+
 // -- Condition Variable Stuffs -- //
 SimCond * SyncServer::getCond(carbon_cond_t *cond, bool canCreate)
 {
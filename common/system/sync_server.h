@@ -7,7 +7,9 @@
 #include "network.h"
 #include "packetize.h"
 #include "stable_iterator.h"
+#include "lock.h"
 
+#include <atomic>
 #include <queue>
 #include <vector>
 #include <limits.h>
@@ -25,6 +27,11 @@ class SimMutex
       // returns true if the lock is owned by someone that is not this thread
       bool isLocked(thread_id_t thread_id);
 
+      // uncontended fast path, can be called without holding the thread lock:
+      // lockFast() takes the lock only if it is free, unlockFast() releases it only if there are no waiters
+      bool lockFast(thread_id_t thread_id);
+      bool unlockFast(thread_id_t thread_id);
+
       // returns the time when this thread owns the lock
       SubsecondTime lock(thread_id_t thread_id, SubsecondTime time);
 
@@ -37,8 +44,16 @@ class SimMutex
    private:
       typedef std::queue<thread_id_t> ThreadQueue;
 
+      // Like a futex word: threads that queue up (always under the thread lock) first mark the mutex as
+      // LOCKED_WAITERS, which makes the owner's unlockFast() fail so it hands off the lock through unlock()
+      enum state_t { UNLOCKED, LOCKED, LOCKED_WAITERS };
+
       ThreadQueue m_waiting;
+      std::atomic<UInt32> m_state;
       thread_id_t m_owner;
+
+      // takes the lock if it is free, else marks it as having waiters; returns true when the lock was taken
+      bool acquireOrMarkWaiting(thread_id_t thread_id);
 };
 
 class SimCond
@@ -87,7 +102,16 @@ class SyncServer
       typedef std::unordered_map<carbon_cond_t *, SimCond> CondVector;
       typedef std::vector<SimBarrier> BarrierVector;
 
-      MutexVector m_mutexes;
+      // Mutexes are spread over stripes with their own lock, so the fast path can look them up without
+      // taking the thread lock. Elements of an unordered_map never move, SimMutex pointers stay valid.
+      static const UInt32 MUTEX_STRIPES = 64;
+      struct MutexStripe
+      {
+         Lock lock;
+         MutexVector mutexes;
+      };
+
+      MutexStripe m_mutexes[MUTEX_STRIPES];
       CondVector m_conds;
       BarrierVector m_barriers;
 
@@ -99,6 +123,12 @@ class SyncServer
       std::pair<SubsecondTime, bool> mutexLock(thread_id_t thread_id, carbon_mutex_t *mux, bool tryLock, SubsecondTime time);
       SubsecondTime mutexUnlock(thread_id_t thread_id, carbon_mutex_t *mux, SubsecondTime time);
 
+      // With perf_model/sync/fast_mutex, uncontended lock and unlock are handled by the calling thread,
+      // the caller falls back to mutexLock() / mutexUnlock() when these return false
+      bool isFastMutex() const { return m_fast_mutex; }
+      bool mutexLockFast(thread_id_t thread_id, carbon_mutex_t *mux);
+      bool mutexUnlockFast(thread_id_t thread_id, carbon_mutex_t *mux);
+
       void condInit(thread_id_t thread_id, carbon_cond_t *cond);
       SubsecondTime condWait(thread_id_t thread_id, carbon_cond_t *cond, carbon_mutex_t *mux, SubsecondTime time);
       SubsecondTime condSignal(thread_id_t thread_id, carbon_cond_t *cond, SubsecondTime time);
@@ -109,6 +139,7 @@ class SyncServer
 
    private:
       SubsecondTime m_reschedule_cost;
+      bool m_fast_mutex;
 
       SimMutex * getMutex(carbon_mutex_t * mux, bool canCreate = true);
       SimCond * getCond(carbon_cond_t * cond, bool canCreate = true);
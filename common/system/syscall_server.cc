@@ -9,11 +9,13 @@
 #include "core_manager.h"
 #include "log.h"
 #include "circular_log.h"
+#include "clock_skew_minimization_object.h"
 
 #include <sys/syscall.h>
 #include "os_compat.h"
 
 SyscallServer::SyscallServer()
+   : m_next_ticket(0)
 {
    m_reschedule_cost = SubsecondTime::NS() * Sim()->getCfg()->getInt("perf_model/sync/reschedule_cost");
 
@@ -28,7 +30,7 @@ void SyscallServer::handleSleepCall(thread_id_t thread_id, SubsecondTime wake_ti
 {
    ScopedLock sl(Sim()->getThreadManager()->getLock());
 
-   m_sleeping.push_back(SimFutex::Waiter(thread_id, 0, wake_time));
+   addTimeout(thread_id, NULL, SimFutex::ThreadQueue::iterator(), wake_time);
    end_time = Sim()->getThreadManager()->stallThread(thread_id, ThreadManager::STALL_SLEEP, curr_time);
 }
 
@@ -36,6 +38,7 @@ IntPtr SyscallServer::handleFutexCall(thread_id_t thread_id, futex_args_t &args,
 {
    ScopedLock sl(Sim()->getThreadManager()->getLock());
    CLOG("futex", "Futex enter thread %d", thread_id);
+   Sim()->getClockSkewMinimizationServer()->notifySharing();
 
    int cmd = (args.op & FUTEX_CMD_MASK) & ~FUTEX_PRIVATE_FLAG;
    SubsecondTime timeout_time = SubsecondTime::MaxTime();
@@ -317,46 +320,54 @@ IntPtr SyscallServer::futexCmpRequeue(thread_id_t thread_id, int *uaddr, int val
    }
 }
 
+void SyscallServer::addTimeout(thread_id_t thread_id, SimFutex *sim_futex, SimFutex::ThreadQueue::iterator it, SubsecondTime timeout)
+{
+   if (m_timed_waits.size() <= (size_t)thread_id)
+      m_timed_waits.resize(thread_id + 16, TimedWait { 0, NULL, SimFutex::ThreadQueue::iterator() });
+
+   TimedWait &wait = m_timed_waits[thread_id];
+   wait.ticket = ++m_next_ticket;
+   wait.futex = sim_futex;
+   wait.it = it;
+   m_timeouts.push(Timeout { timeout, thread_id, wait.ticket });
+}
+
+void SyscallServer::dropCancelledTimeouts()
+{
+   while(!m_timeouts.empty() && m_timed_waits[m_timeouts.top().thread_id].ticket != m_timeouts.top().ticket)
+      m_timeouts.pop();
+}
+
 void SyscallServer::futexPeriodic(SubsecondTime time)
 {
-   // Wake sleeping threads
-   for(SimFutex::ThreadQueue::iterator it = m_sleeping.begin(); it != m_sleeping.end(); ++it)
+   // Wake sleeping threads and timed out futex waiters
+   while(true)
    {
-      if (it->timeout <= time)
-      {
-         thread_id_t waiter = it->thread_id;
-         m_sleeping.erase(it);
+      dropCancelledTimeouts();
+      if (m_timeouts.empty() || m_timeouts.top().timeout > time)
+         break;
 
-         Sim()->getThreadManager()->resumeThread(waiter, waiter, time, (void*)false);
+      thread_id_t waiter = m_timeouts.top().thread_id;
+      m_timeouts.pop();
 
-         // Iterator will be invalid, wake up potential others in the next barrier synchronization which should only be 100ns away
-         break;
+      TimedWait &wait = m_timed_waits[waiter];
+      wait.ticket = 0;
+      if (wait.futex)
+      {
+         wait.futex->removeWaiter(wait.it);
+         Sim()->getThreadManager()->resumeThread(waiter, INVALID_THREAD_ID, time, (void*)false);
+      }
+      else
+      {
+         Sim()->getThreadManager()->resumeThread(waiter, waiter, time, (void*)false);
       }
-   }
-   // Wake timeout futexes
-   for(FutexMap::iterator it = m_futexes.begin(); it != m_futexes.end(); ++it)
-   {
-      it->second.wakeTimedOut(time);
    }
 }
 
 SubsecondTime SyscallServer::getNextTimeout(SubsecondTime time)
 {
-   SubsecondTime next = SubsecondTime::MaxTime();
-   // Sleeping threads
-   for(SimFutex::ThreadQueue::iterator it = m_sleeping.begin(); it != m_sleeping.end(); ++it)
-   {
-      if (it->timeout < SubsecondTime::MaxTime())
-         next = it->timeout;
-   }
-   // Timeout futexes
-   for(FutexMap::iterator it = m_futexes.begin(); it != m_futexes.end(); ++it)
-   {
-      SubsecondTime t = it->second.getNextTimeout(time);
-      if (t < next)
-         next = t;
-   }
-   return next;
+   dropCancelledTimeouts();
+   return m_timeouts.empty() ? SubsecondTime::MaxTime() : m_timeouts.top().timeout;
 }
 
 // -- SimFutex -- //
@@ -381,7 +392,9 @@ SimFutex::~SimFutex()
 
 bool SimFutex::enqueueWaiter(thread_id_t thread_id, int mask, SubsecondTime time, SubsecondTime timeout_time, SubsecondTime &time_end)
 {
-   m_waiting.push_back(Waiter(thread_id, mask, timeout_time));
+   ThreadQueue::iterator it = m_waiting.insert(m_waiting.end(), Waiter(thread_id, mask, timeout_time));
+   if (timeout_time < SubsecondTime::MaxTime())
+      Sim()->getSyscallServer()->addTimeout(thread_id, this, it, timeout_time);
    time_end = Sim()->getThreadManager()->stallThread(thread_id, ThreadManager::STALL_FUTEX, time);
    return Sim()->getThreadManager()->getThreadFromID(thread_id)->getWakeupMsg();
 }
@@ -397,6 +410,8 @@ thread_id_t SimFutex::dequeueWaiter(thread_id_t thread_by, int mask, SubsecondTi
          if (mask & it->mask)
          {
             thread_id_t waiter = it->thread_id;
+            if (it->timeout < SubsecondTime::MaxTime())
+               Sim()->getSyscallServer()->cancelTimeout(waiter);
             m_waiting.erase(it);
 
             Sim()->getThreadManager()->resumeThread(waiter, thread_by, time, (void*)true);
@@ -413,38 +428,12 @@ thread_id_t SimFutex::requeueWaiter(SimFutex *requeue_futex)
       return INVALID_THREAD_ID;
    else
    {
-      Waiter waiter = m_waiting.front();
-      m_waiting.pop_front();
-      requeue_futex->m_waiting.push_back(waiter);
-
-      return waiter.thread_id;
-   }
-}
-
-void SimFutex::wakeTimedOut(SubsecondTime time)
-{
-   for(ThreadQueue::iterator it = m_waiting.begin(); it != m_waiting.end(); ++it)
-   {
-      if (it->timeout <= time)
-      {
-         thread_id_t waiter = it->thread_id;
-         m_waiting.erase(it);
-
-         Sim()->getThreadManager()->resumeThread(waiter, INVALID_THREAD_ID, time, (void*)false);
-
-         // Iterator will be invalid, wake up potential others in the next barrier synchronization which should only be 100ns away
-         break;
-      }
-   }
-}
-
-SubsecondTime SimFutex::getNextTimeout(SubsecondTime time)
-{
-   SubsecondTime next = SubsecondTime::MaxTime();
-   for(ThreadQueue::iterator it = m_waiting.begin(); it != m_waiting.end(); ++it)
-   {
+      // Move the list node rather than copying it, so a pending timeout keeps pointing at this waiter
+      ThreadQueue::iterator it = m_waiting.begin();
+      requeue_futex->m_waiting.splice(requeue_futex->m_waiting.end(), m_waiting, it);
       if (it->timeout < SubsecondTime::MaxTime())
-         next = it->timeout;
+         Sim()->getSyscallServer()->moveTimeout(it->thread_id, requeue_futex);
+
+      return it->thread_id;
    }
-   return next;
 }
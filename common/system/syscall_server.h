@@ -7,6 +7,9 @@
 #include <iostream>
 #include <unordered_map>
 #include <list>
+#include <vector>
+#include <queue>
+#include <functional>
 
 // -- For futexes --
 #include <linux/futex.h>
@@ -39,8 +42,7 @@ class SimFutex
       bool enqueueWaiter(thread_id_t thread_id, int mask, SubsecondTime time, SubsecondTime timeout_time, SubsecondTime &time_end);
       thread_id_t dequeueWaiter(thread_id_t thread_by, int mask, SubsecondTime time);
       thread_id_t requeueWaiter(SimFutex *requeue_futex);
-      void wakeTimedOut(SubsecondTime time);
-      SubsecondTime getNextTimeout(SubsecondTime time);
+      void removeWaiter(ThreadQueue::iterator it) { m_waiting.erase(it); }
 };
 
 class SyscallServer
@@ -76,6 +78,14 @@ class SyscallServer
 
       void futexPeriodic(SubsecondTime time);
 
+      // Timeouts of sleeping threads and futex waits with a timeout, in a single min-heap of deadlines.
+      // Waking up or requeueing a waiter doesn't touch the heap: its entry is skipped once it's on top
+      // and the thread's ticket has moved on.
+      void addTimeout(thread_id_t thread_id, SimFutex *sim_futex, SimFutex::ThreadQueue::iterator it, SubsecondTime timeout);
+      void moveTimeout(thread_id_t thread_id, SimFutex *sim_futex) { m_timed_waits[thread_id].futex = sim_futex; }
+      void cancelTimeout(thread_id_t thread_id) { m_timed_waits[thread_id].ticket = 0; }
+      void dropCancelledTimeouts();
+
       SubsecondTime applyRescheduleCost(thread_id_t thread_id, bool conditional = true);
 
       static SInt64 hook_periodic(UInt64 ptr, UInt64 time)
@@ -86,14 +96,29 @@ class SyscallServer
 
       SubsecondTime m_reschedule_cost;
 
-      // Sleeping threads
-      SimFutex::ThreadQueue m_sleeping;
+      struct Timeout
+      {
+         SubsecondTime timeout;
+         thread_id_t thread_id;
+         UInt64 ticket;
+         bool operator>(const Timeout &other) const { return timeout > other.timeout; }
+      };
+      struct TimedWait
+      {
+         UInt64 ticket;                         // Ticket of the thread's pending timeout, 0 if none
+         SimFutex *futex;                       // Futex the thread waits on, NULL when sleeping
+         SimFutex::ThreadQueue::iterator it;
+      };
+      std::priority_queue<Timeout, std::vector<Timeout>, std::greater<Timeout> > m_timeouts;
+      std::vector<TimedWait> m_timed_waits;    // Keyed by thread_id
+      UInt64 m_next_ticket;
 
-      // Handling Futexes
+      // Handling Futexes, hashed by (physical) address
       typedef std::unordered_map<IntPtr, SimFutex> FutexMap;
       FutexMap m_futexes;
 
       friend class ThreadManager;
+      friend class SimFutex;
 };
 
 #endif
@@ -0,0 +1,241 @@
+#include "telemetry.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "performance_model.h"
+#include "hooks_manager.h"
+#include "clock_skew_minimization_object.h"
+#include "stats.h"
+#include "timer.h"
+#include "config.hpp"
+#include "log.h"
+
+#include <sstream>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+bool Telemetry::s_enabled = false;
+UInt64 Telemetry::s_barrier_wait_ns = 0;
+UInt64 Telemetry::s_python_ns = 0;
+
+Telemetry* Telemetry::create()
+{
+   UInt32 port = Sim()->getCfg()->getInt("telemetry/port");
+   if (port)
+      return new Telemetry(port);
+   else
+      return NULL;
+}
+
+Telemetry::Telemetry(UInt32 port)
+   : m_interval(Sim()->getCfg()->getInt("telemetry/interval") * 1000000ULL)
+   , m_stats_resolved(false)
+   , m_next_snapshot(0)
+   , m_last_time(Timer::now())
+   , m_last_barrier_wait_ns(0)
+   , m_last_instructions(Sim()->getConfig()->getApplicationCores(), 0)
+   , m_published(new std::string())
+   , m_socket(-1)
+   , m_quit(false)
+   , m_exited(0)
+   , m_thread(NULL)
+{
+   // Statistics to export, as a comma-separated list of object.metric (split at the last dot)
+   String stats = Sim()->getCfg()->getString("telemetry/stats");
+   for (size_t start = 0; start < stats.size(); )
+   {
+      size_t end = stats.find(',', start);
+      if (end == String::npos)
+         end = stats.size();
+      String name = stats.substr(start, end - start);
+      if (!name.empty())
+      {
+         LOG_ASSERT_ERROR(name.rfind('.') != String::npos, "Invalid statistic %s in telemetry/stats, should be object.metric", name.c_str());
+         m_stat_names.push_back(name);
+      }
+      start = end + 1;
+   }
+
+   String bind_address = Sim()->getCfg()->getString("telemetry/bind");
+   struct sockaddr_in addr;
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family = AF_INET;
+   addr.sin_port = htons(port);
+   LOG_ASSERT_ERROR(inet_pton(AF_INET, bind_address.c_str(), &addr.sin_addr) == 1, "Invalid telemetry/bind address %s", bind_address.c_str());
+
+   m_socket = socket(AF_INET, SOCK_STREAM, 0);
+   LOG_ASSERT_ERROR(m_socket >= 0, "Cannot create telemetry socket: %s", strerror(errno));
+   int one = 1;
+   setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+   if (bind(m_socket, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(m_socket, 16) < 0)
+   {
+      // Other simulations on this host may be using the port already: run without the endpoint
+      LOG_PRINT_WARNING("Cannot listen on %s:%u for telemetry: %s", bind_address.c_str(), port, strerror(errno));
+      close(m_socket);
+      m_socket = -1;
+      return;
+   }
+
+   s_enabled = true;
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, __snapshot, (UInt64)this);
+   Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC_INS, __snapshot, (UInt64)this);
+
+   m_thread = _Thread::create(this);
+   m_thread->run();
+}
+
+Telemetry::~Telemetry()
+{
+   s_enabled = false;
+   if (m_thread)
+   {
+      // Wakes up the server thread from accept()
+      m_quit = true;
+      shutdown(m_socket, SHUT_RDWR);
+      m_exited.wait();
+      delete m_thread;
+   }
+   if (m_socket >= 0)
+      close(m_socket);
+}
+
+void Telemetry::resolveStats()
+{
+   for (auto it = m_stat_names.begin(); it != m_stat_names.end(); ++it)
+   {
+      size_t dot = it->rfind('.');
+      String object = it->substr(0, dot), metric = it->substr(dot + 1);
+      bool found = false;
+      for (UInt32 index = 0; index < Sim()->getConfig()->getTotalCores(); ++index)
+      {
+         StatsMetricBase *m = Sim()->getStatsManager()->getMetricObject(object, index, metric);
+         if (m)
+         {
+            Stat stat = { *it, index, m };
+            m_stats.push_back(stat);
+            found = true;
+         }
+      }
+      if (!found)
+         LOG_PRINT_WARNING("Telemetry statistic %s not found", it->c_str());
+   }
+   m_stats_resolved = true;
+}
+
+void Telemetry::snapshot()
+{
+   // Cheap, unlocked check first: periodic hooks are called much more often than snapshots are taken
+   UInt64 now = Timer::now();
+   if (now < m_next_snapshot)
+      return;
+
+   ScopedLock sl(m_lock);
+   if (now < m_next_snapshot)
+      return;
+   m_next_snapshot = now + m_interval;
+
+   if (!m_stats_resolved)
+      resolveStats();
+
+   double elapsed = (now - m_last_time) / 1e9;
+   std::ostringstream s;
+
+   s << "# HELP sniper_kips Simulated instructions per host second (in thousands) since the previous snapshot\n"
+     << "# TYPE sniper_kips gauge\n";
+   UInt64 total_instructions = 0;
+   for (core_id_t core_id = 0; core_id < (core_id_t)m_last_instructions.size(); ++core_id)
+   {
+      UInt64 instructions = Sim()->getCoreManager()->getCoreFromID(core_id)->getPerformanceModel()->getInstructionCount();
+      s << "sniper_kips{core=\"" << core_id << "\"} " << (instructions - m_last_instructions[core_id]) / elapsed / 1e3 << "\n";
+      m_last_instructions[core_id] = instructions;
+      total_instructions += instructions;
+   }
+   s << "# TYPE sniper_instructions_total counter\n"
+     << "sniper_instructions_total " << total_instructions << "\n";
+
+   s << "# HELP sniper_simulated_seconds Global simulated time\n"
+     << "# TYPE sniper_simulated_seconds gauge\n"
+     << "sniper_simulated_seconds " << Sim()->getClockSkewMinimizationServer()->getGlobalTime().getFS() / 1e15 << "\n";
+
+   UInt64 barrier_wait_ns = s_barrier_wait_ns;
+   s << "# HELP sniper_barrier_wait_fraction Fraction of host time application cores spent waiting in the barrier since the previous snapshot\n"
+     << "# TYPE sniper_barrier_wait_fraction gauge\n"
+     << "sniper_barrier_wait_fraction " << (barrier_wait_ns - m_last_barrier_wait_ns) / 1e9 / elapsed / m_last_instructions.size() << "\n";
+   m_last_barrier_wait_ns = barrier_wait_ns;
+
+   s << "# HELP sniper_python_hook_seconds_total Host time spent in Python hook callbacks\n"
+     << "# TYPE sniper_python_hook_seconds_total counter\n"
+     << "sniper_python_hook_seconds_total " << s_python_ns / 1e9 << "\n";
+
+   if (m_stats.size())
+   {
+      s << "# TYPE sniper_stat gauge\n";
+      for (auto it = m_stats.begin(); it != m_stats.end(); ++it)
+         s << "sniper_stat{name=\"" << it->name << "\",index=\"" << it->index << "\"} " << it->metric->recordMetric() << "\n";
+   }
+
+   m_last_time = now;
+   std::atomic_store(&m_published, std::shared_ptr<const std::string>(new std::string(s.str())));
+}
+
+UInt64 Telemetry::getRss()
+{
+   FILE *fp = fopen("/proc/self/statm", "r");
+   if (!fp)
+      return 0;
+   unsigned long size = 0, resident = 0;
+   if (fscanf(fp, "%lu %lu", &size, &resident) != 2)
+      resident = 0;
+   fclose(fp);
+   return UInt64(resident) * sysconf(_SC_PAGESIZE);
+}
+
+void Telemetry::serve(int fd)
+{
+   // Any request gets the metrics, consume it so the client sees a clean close
+   char request[1024];
+   if (recv(fd, request, sizeof(request), 0) < 0)
+      return;
+
+   std::shared_ptr<const std::string> published = std::atomic_load(&m_published);
+   std::ostringstream body;
+   body << *published
+        << "# HELP sniper_host_rss_bytes Resident set size of the simulator process\n"
+        << "# TYPE sniper_host_rss_bytes gauge\n"
+        << "sniper_host_rss_bytes " << getRss() << "\n";
+   String content = body.str().c_str();
+
+   std::ostringstream header;
+   header << "HTTP/1.0 200 OK\r\n"
+          << "Content-Type: text/plain; version=0.0.4\r\n"
+          << "Content-Length: " << content.size() << "\r\n"
+          << "Connection: close\r\n\r\n";
+   String response = String(header.str().c_str()) + content;
+
+   for (size_t sent = 0; sent < response.size(); )
+   {
+      ssize_t res = send(fd, response.c_str() + sent, response.size() - sent, MSG_NOSIGNAL);
+      if (res <= 0)
+         break;
+      sent += res;
+   }
+}
+
+void Telemetry::run()
+{
+   while (!m_quit)
+   {
+      int fd = accept(m_socket, NULL, NULL);
+      if (fd < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         break;
+      }
+      serve(fd);
+      close(fd);
+   }
+   m_exited.signal();
+}
@@ -0,0 +1,72 @@
+#ifndef __TELEMETRY_H
+#define __TELEMETRY_H
+
+#include "fixed_types.h"
+#include "lock.h"
+#include "sem.h"
+#include "_thread.h"
+
+#include <memory>
+#include <vector>
+
+class StatsMetricBase;
+
+// Live telemetry endpoint ([telemetry/port]): serves simulation speed and health in the Prometheus text format
+// over HTTP, so running jobs can be scraped without waiting for their output.
+// At most once per [telemetry/interval], a periodic hook takes a snapshot of the counters (per-core instruction
+// counts, simulated time, barrier wait and Python hook time, and the statistics listed in [telemetry/stats]) and
+// publishes it, already formatted, through an atomically swapped pointer. The server thread only ever reads
+// published snapshots, so a scrape never touches simulator state or holds up a simulation thread.
+class Telemetry : public Runnable
+{
+   public:
+      static Telemetry* create();
+
+      Telemetry(UInt32 port);
+      ~Telemetry();
+
+      // Host time accounting, only done while telemetry is enabled
+      static bool isEnabled() { return s_enabled; }
+      static void addBarrierWaitTime(UInt64 ns) { __sync_fetch_and_add(&s_barrier_wait_ns, ns); }
+      static void addPythonTime(UInt64 ns) { __sync_fetch_and_add(&s_python_ns, ns); }
+
+   private:
+      struct Stat
+      {
+         String name;
+         UInt32 index;
+         StatsMetricBase *metric;
+      };
+
+      static bool s_enabled;
+      static UInt64 s_barrier_wait_ns;
+      static UInt64 s_python_ns;
+
+      const UInt64 m_interval;        // in ns of host time
+      std::vector<String> m_stat_names;
+      std::vector<Stat> m_stats;      // Resolved on the first snapshot, once all components have registered theirs
+      bool m_stats_resolved;
+
+      Lock m_lock;
+      UInt64 m_next_snapshot;
+      UInt64 m_last_time;
+      UInt64 m_last_barrier_wait_ns;
+      std::vector<UInt64> m_last_instructions;
+
+      std::shared_ptr<const std::string> m_published;
+
+      int m_socket;
+      bool m_quit;
+      Semaphore m_exited;
+      _Thread *m_thread;
+
+      static SInt64 __snapshot(UInt64 arg, UInt64 val) { ((Telemetry*)arg)->snapshot(); return 0; }
+      void snapshot();
+      void resolveStats();
+
+      void run() override; // Server thread
+      void serve(int fd);
+      static UInt64 getRss();
+};
+
+#endif // __TELEMETRY_H
@@ -12,6 +12,7 @@
 #include "core.h"
 #include "thread.h"
 #include "scheduler.h"
+#include "cstate_manager.h"
 #include "syscall_server.h"
 #include "circular_log.h"
 
@@ -25,14 +26,21 @@ static_assert(ThreadManager::STALL_TYPES_MAX == sizeof(ThreadManager::stall_type
               "Not enough values in ThreadManager::stall_type_names");
 
 ThreadManager::ThreadManager()
-   : m_thread_tls(TLS::create())
+   : m_thread_state(MAX_THREADS)
+   , m_threads(MAX_THREADS, NULL)
+   , m_num_threads(0)
+   , m_thread_spawn_list(MAX_THREADS)
+   , m_thread_spawn_head(0)
+   , m_thread_spawn_tail(0)
+   , m_thread_tls(TLS::create())
    , m_scheduler(Scheduler::create(this))
+   , m_cstate_manager(CStateManager::create())
 {
 }
 
 ThreadManager::~ThreadManager()
 {
-   for (UInt32 i = 0; i < m_thread_state.size(); i++)
+   for (UInt32 i = 0; i < m_num_threads; i++)
    {
       #if 0 // Disabled: applications are not required to do proper cleanup
       if (m_thread_state[i].status != Core::IDLE)
@@ -43,12 +51,13 @@ ThreadManager::~ThreadManager()
 
    delete m_thread_tls;
    delete m_scheduler;
+   delete m_cstate_manager;
 }
 
 Thread* ThreadManager::getThreadFromID(thread_id_t thread_id)
 {
-   LOG_ASSERT_ERROR((size_t)thread_id < m_threads.size(), "Invalid thread_id %d", thread_id);
-   return m_threads.at(thread_id);
+   LOG_ASSERT_ERROR((UInt64)thread_id < getNumThreads(), "Invalid thread_id %d", thread_id);
+   return m_threads[thread_id];
 }
 Thread* ThreadManager::getCurrentThread(int threadIndex)
 {
@@ -57,10 +66,10 @@ Thread* ThreadManager::getCurrentThread(int threadIndex)
 
 Thread* ThreadManager::findThreadByTid(pid_t tid)
 {
-   for (UInt32 thread_id = 0; thread_id < m_threads.size(); ++thread_id)
+   for (UInt32 thread_id = 0; thread_id < getNumThreads(); ++thread_id)
    {
-      if (m_threads.at(thread_id)->m_os_info.tid == tid)
-         return m_threads.at(thread_id);
+      if (m_threads[thread_id]->m_os_info.tid == tid)
+         return m_threads[thread_id];
    }
    return NULL;
 }
@@ -73,11 +82,14 @@ Thread* ThreadManager::createThread(app_id_t app_id, thread_id_t creator_thread_
 
 Thread* ThreadManager::createThread_unlocked(app_id_t app_id, thread_id_t creator_thread_id)
 {
-   thread_id_t thread_id = m_threads.size();
+   LOG_ASSERT_ERROR(m_num_threads < MAX_THREADS, "Too many application threads, increase ThreadManager::MAX_THREADS");
+   thread_id_t thread_id = m_num_threads;
    Thread *thread = new Thread(thread_id, app_id);
-   m_threads.push_back(thread);
-   m_thread_state.push_back(ThreadState());
-   m_thread_state[thread->getId()].status = Core::INITIALIZING;
+   m_threads[thread_id] = thread;
+   m_thread_state[thread_id] = ThreadState();
+   m_thread_state[thread_id].status = Core::INITIALIZING;
+   // Publish the new thread to lock-free readers of getNumThreads()
+   __atomic_store_n(&m_num_threads, m_num_threads + 1, __ATOMIC_RELEASE);
 
    core_id_t core_id = m_scheduler->threadCreate(thread_id);
    if (core_id != INVALID_CORE_ID)
@@ -151,7 +163,7 @@ void ThreadManager::onThreadExit(thread_id_t thread_id)
 {
    ScopedLock sl(m_thread_lock);
 
-   LOG_ASSERT_ERROR((UInt32)thread_id < m_thread_state.size(), "Thread id out of range: %d", thread_id);
+   LOG_ASSERT_ERROR((UInt32)thread_id < m_num_threads, "Thread id out of range: %d", thread_id);
 
    Thread *thread = getThreadFromID(thread_id);
    Core *core = thread->getCore();
@@ -206,7 +218,8 @@ thread_id_t ThreadManager::spawnThread(thread_id_t thread_id, app_id_t app_id)
 
    // Insert the request in the thread request queue
    ThreadSpawnRequest req = { thread_id, new_thread->getId(), time_start };
-   m_thread_spawn_list.push(req);
+   m_thread_spawn_list[m_thread_spawn_head] = req;
+   __atomic_store_n(&m_thread_spawn_head, m_thread_spawn_head + 1, __ATOMIC_RELEASE);
 
    LOG_PRINT("Done with (2)");
 
@@ -215,12 +228,11 @@ thread_id_t ThreadManager::spawnThread(thread_id_t thread_id, app_id_t app_id)
 
 thread_id_t ThreadManager::getThreadToSpawn(SubsecondTime &time)
 {
-   ScopedLock sl(getLock());
-
-   LOG_ASSERT_ERROR(!m_thread_spawn_list.empty(), "Have no thread to spawn");
+   // The spawning thread queued the request before the new thread was created, so it is always there
+   UInt32 index = __atomic_fetch_add(&m_thread_spawn_tail, 1, __ATOMIC_ACQ_REL);
+   LOG_ASSERT_ERROR(index < __atomic_load_n(&m_thread_spawn_head, __ATOMIC_ACQUIRE), "Have no thread to spawn");
 
-   ThreadSpawnRequest req = m_thread_spawn_list.front();
-   m_thread_spawn_list.pop();
+   const ThreadSpawnRequest &req = m_thread_spawn_list[index];
 
    time = req.time;
    return req.thread_id;
@@ -284,7 +296,7 @@ bool ThreadManager::areAllCoresRunning()
 {
    // Check if all the cores are running
    bool is_all_running = true;
-   for (SInt32 i = 0; i < (SInt32) m_thread_state.size(); i++)
+   for (SInt32 i = 0; i < (SInt32) m_num_threads; i++)
    {
       if (m_thread_state[i].status == Core::IDLE)
       {
@@ -349,6 +361,8 @@ void ThreadManager::stallThread_async(thread_id_t thread_id, stall_type_t reason
    LOG_PRINT("Core(%i) -> STALLED", thread_id);
    m_thread_state[thread_id].status = Core::STALLED;
    m_thread_state[thread_id].stalled_reason = reason;
+   if (m_cstate_manager)
+      m_cstate_manager->threadStall(thread_id, reason, time);
 
    HooksManager::ThreadStall args = { thread_id: thread_id, reason: reason, time: time };
    Sim()->getHooksManager()->callHooks(HookType::HOOK_THREAD_STALL, (UInt64)&args);
@@ -377,6 +391,10 @@ void ThreadManager::resumeThread_async(thread_id_t thread_id, thread_id_t thread
 {
    LOG_PRINT("Core(%i) -> RUNNING", thread_id);
    m_thread_state[thread_id].status = Core::RUNNING;
+   // Closes the idle period of the thread's core. Callers that wake up the thread themselves
+   // have already done this in resumeThread (and accounted for the exit latency), so this is a no-op then
+   if (m_cstate_manager)
+      m_cstate_manager->threadResume(thread_id, time);
 
    HooksManager::ThreadResume args = { thread_id: thread_id, thread_by: thread_by, time: time };
    Sim()->getHooksManager()->callHooks(HookType::HOOK_THREAD_RESUME, (UInt64)&args);
@@ -385,6 +403,10 @@ void ThreadManager::resumeThread_async(thread_id_t thread_id, thread_id_t thread
 
 void ThreadManager::resumeThread(thread_id_t thread_id, thread_id_t thread_by, SubsecondTime time, void *msg)
 {
+   // The thread only starts running once its core has left its idle state
+   if (m_cstate_manager)
+      time += m_cstate_manager->threadResume(thread_id, time);
+
    // We still have the m_thread_lock, so thread doesn't actually start running again until caller releases this lock
    getThreadFromID(thread_id)->signal(time, msg);
 
@@ -401,6 +423,16 @@ bool ThreadManager::isThreadInitializing(thread_id_t thread_id)
    return (m_thread_state[thread_id].status == Core::INITIALIZING);
 }
 
+bool ThreadManager::anyThreadStalled(stall_type_t reason)
+{
+   for(thread_id_t thread_id = 0; thread_id < (thread_id_t)getNumThreads(); ++thread_id)
+   {
+      if (m_thread_state[thread_id].status == Core::STALLED && m_thread_state[thread_id].stalled_reason == reason)
+         return true;
+   }
+   return false;
+}
+
 bool ThreadManager::anyThreadRunning()
 {
    for(thread_id_t thread_id = 0; thread_id < (thread_id_t)getNumThreads(); ++thread_id)
@@ -8,11 +8,11 @@
 #include "subsecond_time.h"
 
 #include <vector>
-#include <queue>
 
 class TLS;
 class Thread;
 class Scheduler;
+class CStateManager;
 
 class ThreadManager
 {
@@ -34,17 +34,21 @@ public:
    };
    static const char* stall_type_names[];
 
+   // Thread slots are allocated up front, so threads can be looked up without holding the lock while others are created
+   static const UInt32 MAX_THREADS = 4096;
+
    ThreadManager();
    ~ThreadManager();
 
    Lock &getLock() { return m_thread_lock; }
    Scheduler *getScheduler() const { return m_scheduler; }
+   CStateManager *getCStateManager() const { return m_cstate_manager; }
 
    Thread* createThread(app_id_t app_id, thread_id_t creator_thread_id);
 
    Thread *getThreadFromID(thread_id_t thread_id);
    Thread *getCurrentThread(int threadIndex = -1);
-   UInt64 getNumThreads() const { return m_threads.size(); }
+   UInt64 getNumThreads() const { return __atomic_load_n(&m_num_threads, __ATOMIC_ACQUIRE); }
    Core::State getThreadState(thread_id_t thread_id) const { return m_thread_state.at(thread_id).status; }
    stall_type_t getThreadStallReason(thread_id_t thread_id) const { return m_thread_state.at(thread_id).stalled_reason; }
 
@@ -69,6 +73,7 @@ public:
    bool isThreadRunning(thread_id_t thread_id);
    bool isThreadInitializing(thread_id_t thread_id);
    bool anyThreadRunning();
+   bool anyThreadStalled(stall_type_t reason);
 
    void moveThread(thread_id_t thread_id, core_id_t core_id, SubsecondTime time);
 
@@ -89,17 +94,25 @@ private:
       thread_id_t waiter;
 
       ThreadState() : status(Core::IDLE), waiter(INVALID_THREAD_ID) {}
-   };
+   } __attribute__((aligned(64)));  // Own cache line, threads on different cores update their state concurrently
 
    Lock m_thread_lock;
 
+   // Both are MAX_THREADS long and never reallocated, the first m_num_threads are valid
    std::vector<ThreadState> m_thread_state;
-   std::queue<ThreadSpawnRequest> m_thread_spawn_list;
-
    std::vector<Thread*> m_threads;
+   UInt32 m_num_threads;
+
+   // Spawn requests in order, consumed without taking m_thread_lock. Each thread is spawned at most once,
+   // so there are never more than MAX_THREADS of them.
+   std::vector<ThreadSpawnRequest> m_thread_spawn_list;
+   UInt32 m_thread_spawn_head;      // Written under m_thread_lock
+   UInt32 m_thread_spawn_tail;      // Claimed atomically by getThreadToSpawn
+
    TLS *m_thread_tls;
 
    Scheduler *m_scheduler;
+   CStateManager *m_cstate_manager;
 
    Thread* createThread_unlocked(app_id_t app_id, thread_id_t creator_thread_id);
    void wakeUpWaiter(thread_id_t thread_id, SubsecondTime time);
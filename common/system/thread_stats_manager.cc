@@ -43,15 +43,12 @@ ThreadStatsManager::ThreadStatType ThreadStatsManager::registerThreadStatMetric(
       ++m_next_dynamic_type;
    }
    m_thread_stat_types.push_back(type);
+   if (type >= m_thread_stat_callbacks.size())
+      m_thread_stat_callbacks.resize(type + 1);
    m_thread_stat_callbacks[type] = StatCallback(name, func, user);
    return type;
 }
 
-UInt64 ThreadStatsManager::callThreadStatCallback(ThreadStatType type, thread_id_t thread_id, Core *core)
-{
-   return m_thread_stat_callbacks[type].call(type, thread_id, core);
-}
-
 void ThreadStatsManager::update(thread_id_t thread_id, SubsecondTime time)
 {
    if (time == SubsecondTime::MaxTime())
@@ -177,6 +174,7 @@ ThreadStatsManager::ThreadStats::ThreadStats(thread_id_t thread_id)
    , m_time_last(SubsecondTime::Zero())
    , m_counts()
    , m_last()
+   , m_num_types(0)
 {
    registerStatsMetric("thread", thread_id, "elapsed_time", &m_elapsed_time);
    registerStatsMetric("thread", thread_id, "unscheduled_time", &m_unscheduled_time);
@@ -186,12 +184,12 @@ ThreadStatsManager::ThreadStats::ThreadStats(thread_id_t thread_id)
       registerStatsMetric("thread", thread_id, "instructions_by_core[" + itostr(core_id) + "]", &insn_by_core[core_id]);
    }
    ThreadStatsManager *tsm = Sim()->getThreadStatsManager();
-   for(std::vector<ThreadStatType>::const_iterator it = tsm->getThreadStatTypes().begin(); it != tsm->getThreadStatTypes().end(); ++it)
-   {
-      m_counts[*it] = 0;
-      m_last[*it] = 0;
-      registerStatsMetric("thread", thread_id, tsm->getThreadStatName(*it), &m_counts[*it]);
-   }
+   const ThreadStatTypeList &types = tsm->getThreadStatTypes();
+   m_num_types = types.size();
+   m_counts.resize(tsm->m_thread_stat_callbacks.size(), 0);
+   m_last.resize(tsm->m_thread_stat_callbacks.size(), 0);
+   for(UInt32 i = 0; i < m_num_types; ++i)
+      registerStatsMetric("thread", thread_id, tsm->getThreadStatName(types[i]), &m_counts[types[i]]);
 }
 
 void ThreadStatsManager::ThreadStats::update(SubsecondTime time, bool init)
@@ -200,6 +198,9 @@ void ThreadStatsManager::ThreadStats::update(SubsecondTime time, bool init)
        || Sim()->getThreadManager()->getThreadState(m_thread->getId()) == Core::INITIALIZING)
       return;
 
+   ThreadStatsManager *tsm = Sim()->getThreadStatsManager();
+   const ThreadStatTypeList &types = tsm->getThreadStatTypes();
+
    // Increment per-thread statistics based on the progress our core has made since last time
    SubsecondTime time_delta = init || m_time_last > time ? SubsecondTime::Zero() : time - m_time_last;
    if (m_core_id == INVALID_CORE_ID)
@@ -213,9 +214,10 @@ void ThreadStatsManager::ThreadStats::update(SubsecondTime time, bool init)
       m_elapsed_time += time_delta;
       time_by_core[core->getId()] += core->getPerformanceModel()->getNonIdleElapsedTime().getFS() - m_last[ELAPSED_NONIDLE_TIME];
       insn_by_core[core->getId()] += core->getPerformanceModel()->getInstructionCount() - m_last[INSTRUCTIONS];
-      for(std::unordered_map<ThreadStatType, UInt64>::iterator it = m_counts.begin(); it != m_counts.end(); ++it)
+      for(UInt32 i = 0; i < m_num_types; ++i)
       {
-         m_counts[it->first] += Sim()->getThreadStatsManager()->callThreadStatCallback(it->first, m_thread->getId(), core) - m_last[it->first];
+         ThreadStatType type = types[i];
+         m_counts[type] += tsm->callThreadStatCallback(type, m_thread->getId(), core) - m_last[type];
       }
    }
    // Take a snapshot of our current core's statistics for later comparison
@@ -223,10 +225,8 @@ void ThreadStatsManager::ThreadStats::update(SubsecondTime time, bool init)
    if (core)
    {
       m_core_id = core->getId();
-      for(std::unordered_map<ThreadStatType, UInt64>::iterator it = m_counts.begin(); it != m_counts.end(); ++it)
-      {
-         m_last[it->first] = Sim()->getThreadStatsManager()->callThreadStatCallback(it->first, m_thread->getId(), core);
-      }
+      for(UInt32 i = 0; i < m_num_types; ++i)
+         m_last[types[i]] = tsm->callThreadStatCallback(types[i], m_thread->getId(), core);
    }
    else
       m_core_id = INVALID_CORE_ID;
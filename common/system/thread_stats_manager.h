@@ -37,8 +37,11 @@ class ThreadStatsManager
 
          private:
             SubsecondTime m_time_last;    // Time of last snapshot
-            std::unordered_map<ThreadStatType, UInt64> m_counts; // Running total of thread statistics
-            std::unordered_map<ThreadStatType, UInt64> m_last;   // Snapshot of core's statistics when we last updated m_current
+            // Indexed by ThreadStatType, sized for the types that were registered when this thread was created.
+            // Metrics point into m_counts, so neither vector is resized afterwards.
+            std::vector<UInt64> m_counts; // Running total of thread statistics
+            std::vector<UInt64> m_last;   // Snapshot of core's statistics when we last updated m_current
+            UInt32 m_num_types;           // Prefix of getThreadStatTypes() that this thread tracks
 
             friend class ThreadStatsManager;
       };
@@ -54,7 +57,11 @@ class ThreadStatsManager
 
       const ThreadStatTypeList& getThreadStatTypes() { return m_thread_stat_types; }
       const char* getThreadStatName(ThreadStatType type) { return m_thread_stat_callbacks[type].m_name; }
-      UInt64 getThreadStatistic(thread_id_t thread_id, ThreadStatType type) { return m_threads_stats[thread_id]->m_counts[type]; }
+      UInt64 getThreadStatistic(thread_id_t thread_id, ThreadStatType type)
+      {
+         const std::vector<UInt64> &counts = m_threads_stats[thread_id]->m_counts;
+         return type < counts.size() ? counts[type] : 0;
+      }
 
       ThreadStatType registerThreadStatMetric(ThreadStatType type, const char* name, ThreadStatCallback func, UInt64 user);
 
@@ -64,22 +71,23 @@ private:
          ThreadStatCallback m_func;
          UInt64 m_user;
 
-         StatCallback() {};
+         StatCallback() : m_name(NULL), m_func(NULL), m_user(0) {};
          StatCallback(const char* name, ThreadStatCallback func, UInt64 user) : m_name(name), m_func(func), m_user(user) {}
          UInt64 call(ThreadStatType type, thread_id_t thread_id, Core *core) { return m_func(type, thread_id, core, m_user); }
       };
       // Make sure m_threads_stats is statically allocated, as we may do inserts and reads simultaneously
       // which does not work on an unordered_map
-      static const int MAX_THREADS = 4096;
+      static const int MAX_THREADS = ThreadManager::MAX_THREADS;
       std::vector<ThreadStats*> m_threads_stats;
       ThreadStatTypeList m_thread_stat_types;
-      std::unordered_map<ThreadStatType, StatCallback> m_thread_stat_callbacks;
+      std::vector<StatCallback> m_thread_stat_callbacks;  // Indexed by ThreadStatType
       ThreadStatType m_next_dynamic_type;
       BottleGraphManager m_bottlegraphs;
       SubsecondTime m_waiting_time_last;
 
       static UInt64 metricCallback(ThreadStatType type, thread_id_t thread_id, Core *core, UInt64 user);
-      UInt64 callThreadStatCallback(ThreadStatType type, thread_id_t thread_id, Core *core);
+      UInt64 callThreadStatCallback(ThreadStatType type, thread_id_t thread_id, Core *core)
+      { return m_thread_stat_callbacks[type].call(type, thread_id, core); }
 
       void pre_stat_write();
       void threadCreate(thread_id_t thread_id);
@@ -0,0 +1,129 @@
+#include "warmup_sampler.h"
+#include "checkpoint.h"
+#include "simulator.h"
+#include "core_manager.h"
+#include "memory_manager_base.h"
+#include "hooks_manager.h"
+#include "inst_mode.h"
+#include "config.hpp"
+#include "stats.h"
+#include "utils.h"
+#include "itostr.h"
+#include "log.h"
+
+WarmupSampler* WarmupSampler::create()
+{
+   UInt32 sampled_sets = Sim()->getCfg()->getInt("perf_model/warmup/sampled_sets");
+
+   if (sampled_sets <= 1)
+      return NULL;
+   else
+      return new WarmupSampler(sampled_sets, Sim()->getCfg()->getBool("perf_model/warmup/reconstruct"));
+}
+
+WarmupSampler::WarmupSampler(UInt32 sampled_sets, bool reconstruct)
+   : m_sampled_sets(sampled_sets)
+   , m_reconstruct(reconstruct)
+   , m_skipped(false)
+   , m_reconstruct_pending(false)
+   , m_reconstructed_lines(0)
+{
+   UInt32 levels = Sim()->getCfg()->getInt("perf_model/cache/levels");
+   String llc = "perf_model/l" + itostr(levels) + "_cache";
+   UInt32 block_size = Sim()->getCfg()->getInt(llc + "/cache_block_size");
+   UInt32 num_sets = Sim()->getCfg()->getInt(llc + "/cache_size") * 1024 / (block_size * Sim()->getCfg()->getInt(llc + "/associativity"));
+
+   LOG_ASSERT_ERROR(Sim()->getCfg()->getString(llc + "/address_hash") == "mask", "Warmup set sampling needs %s/address_hash = mask", llc.c_str());
+   LOG_ASSERT_ERROR(isPower2(sampled_sets) && isPower2(num_sets) && sampled_sets <= num_sets,
+      "perf_model/warmup/sampled_sets (%u) must be a power of two of at most the number of last-level cache sets (%u)", sampled_sets, num_sets);
+
+   m_block_shift = floorLog2(block_size);
+   m_num_sets = num_sets;
+   m_sampled_range = num_sets / sampled_sets;
+
+   registerStatsMetric("warmup", 0, "reconstructed-lines", &m_reconstructed_lines);
+
+   if (m_reconstruct)
+   {
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_INSTRUMENT_MODE, WarmupSampler::hook_instrument_mode, (UInt64)this);
+      // Replay after everyone else has seen this barrier, while all cores are stopped
+      Sim()->getHooksManager()->registerHook(HookType::HOOK_PERIODIC, WarmupSampler::hook_periodic, (UInt64)this, HooksManager::ORDER_NOTIFY_POST);
+   }
+}
+
+SInt64 WarmupSampler::hook_instrument_mode(UInt64 self, UInt64 mode)
+{
+   WarmupSampler *ws = (WarmupSampler *)self;
+   if (mode == InstMode::DETAILED && ws->m_skipped)
+      ws->m_reconstruct_pending = true;
+   return 0;
+}
+
+void WarmupSampler::periodic()
+{
+   if (m_reconstruct_pending)
+   {
+      m_reconstruct_pending = false;
+      m_skipped = false;
+      reconstruct();
+   }
+}
+
+void WarmupSampler::reconstruct()
+{
+   UInt32 num_cores = Sim()->getConfig()->getApplicationCores();
+   UInt32 levels = Sim()->getCfg()->getInt("perf_model/cache/levels");
+   MemComponent::component_t llc = MemComponent::component_t(MemComponent::L2_CACHE + levels - 2);
+   const IntPtr range_size = IntPtr(m_sampled_range) << m_block_shift;
+   UInt64 num_lines = 0;
+
+   // The replay goes through (and displaces) the inner levels, so take their contents first
+   std::vector<std::vector<CheckpointLine> > inner_lines((llc - MemComponent::L1_ICACHE) * num_cores);
+   for(SInt32 level = MemComponent::L1_ICACHE; level < llc; ++level)
+      for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+         Sim()->getCoreManager()->getCoreFromID(core_id)->getMemoryManager()->getCacheLines(MemComponent::component_t(level),
+            inner_lines[(level - MemComponent::L1_ICACHE) * num_cores + core_id]);
+
+   // Fill the skipped sets of each last-level cache from its sampled sets
+   for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+   {
+      Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+      std::vector<CheckpointLine> lines;
+      core->getMemoryManager()->getCacheLines(llc, lines);
+
+      for(std::vector<CheckpointLine>::iterator it = lines.begin(); it != lines.end(); ++it)
+      {
+         if (!isSampled(it->address))
+            continue;
+         for(UInt32 range = 1; range < m_sampled_sets; ++range)
+            core->accessMemory(Core::NONE, Core::READ, it->address + range * range_size, NULL, 1, Core::MEM_MODELED_NONE);
+         num_lines += m_sampled_sets - 1;
+      }
+   }
+
+   // Re-install the inner levels, outer levels first
+   for(SInt32 level = llc - 1; level >= MemComponent::L1_ICACHE; --level)
+      for(core_id_t core_id = 0; core_id < (core_id_t)num_cores; ++core_id)
+      {
+         Core *core = Sim()->getCoreManager()->getCoreFromID(core_id);
+         std::vector<CheckpointLine> &lines = inner_lines[(level - MemComponent::L1_ICACHE) * num_cores + core_id];
+
+         for(std::vector<CheckpointLine>::iterator it = lines.begin(); it != lines.end(); ++it)
+         {
+            if (level == MemComponent::L1_ICACHE)
+            {
+               if (Sim()->getConfig()->getEnableICacheModeling())
+                  core->readInstructionMemory(it->address, 1);
+            }
+            else
+            {
+               Core::mem_op_t mem_op_type = it->cstate == CacheState::MODIFIED ? Core::WRITE
+                                          : it->cstate == CacheState::EXCLUSIVE ? Core::READ_EX
+                                          : Core::READ;
+               core->accessMemory(Core::NONE, mem_op_type, it->address, NULL, 1, Core::MEM_MODELED_NONE);
+            }
+         }
+      }
+
+   m_reconstructed_lines += num_lines;
+}
@@ -0,0 +1,43 @@
+#ifndef __WARMUP_SAMPLER_H
+#define __WARMUP_SAMPLER_H
+
+#include "fixed_types.h"
+
+// Set-sampled cache warmup for long cache-only phases.
+// With [perf_model/warmup/sampled_sets] = N > 1, cache-only warmup only performs the data accesses that map to
+// the first 1/N of the last-level cache sets (so also all sets of smaller inner caches), the other accesses are skipped.
+// Since the sampled sets form a contiguous range, every tag in them also has neighbouring lines in the same position
+// of each other range. When switching to detailed mode with [perf_model/warmup/reconstruct] set, the skipped sets are
+// filled by replaying those neighbouring lines, least recently used first, through the memory hierarchy (like
+// CheckpointManager::restore), after which the inner cache levels are restored by replaying their own lines.
+// ATDs already track only sampled sets, and only see the accesses that are not skipped.
+
+class WarmupSampler
+{
+   public:
+      static WarmupSampler* create();
+
+      WarmupSampler(UInt32 sampled_sets, bool reconstruct);
+
+      // Should a cache-only mode data access to this address be performed
+      bool isSampled(IntPtr address) const { return ((address >> m_block_shift) & (m_num_sets - 1)) < m_sampled_range; }
+      void notifySkipped() { if (!m_skipped) m_skipped = true; } // Check first to keep the line shared between threads
+
+   private:
+      const UInt32 m_sampled_sets;
+      const bool m_reconstruct;
+      UInt32 m_block_shift;
+      UInt32 m_num_sets;      // Sets of (each slice of) the last-level cache
+      UInt32 m_sampled_range; // Sets [0, m_sampled_range) are warmed
+      bool m_skipped;
+      bool m_reconstruct_pending;
+      UInt64 m_reconstructed_lines;
+
+      static SInt64 hook_instrument_mode(UInt64 self, UInt64 mode);
+      static SInt64 hook_periodic(UInt64 self, UInt64 time) { ((WarmupSampler*)self)->periodic(); return 0; }
+
+      void periodic();
+      void reconstruct();
+};
+
+#endif // __WARMUP_SAMPLER_H
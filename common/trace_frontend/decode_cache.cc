@@ -0,0 +1,48 @@
+#include "decode_cache.h"
+
+DecodeCache::DecodeCache()
+   : m_decoded(1 << 16)
+   , m_instructions(1 << 16)
+{
+}
+
+DecodeCache::~DecodeCache()
+{
+   // Instruction objects may still be referenced by the performance models, only the decoder output is ours to free
+   m_decoded.forEach([](const Key &key, const Decoded &decoded) { if (!decoded.stored) delete decoded.dec_inst; });
+}
+
+DecodeCache::Decoded DecodeCache::Decoded::fromDecoder(dl::Decoder *decoder, const dl::DecodedInst *dec_inst)
+{
+   Decoded decoded;
+   memset(&decoded, 0, sizeof(decoded));
+   decoded.dec_inst = dec_inst;
+   decoded.flags = summarizeFlags(dec_inst);
+
+   // Ignore memory-referencing operands in NOP instructions
+   if (!decoded.isNop())
+   {
+      decoded.num_memory_operands = decoder->num_memory_operands(dec_inst);
+      LOG_ASSERT_ERROR(decoded.num_memory_operands <= MAX_MEMORY_OPERANDS, "Got more than MAX_MEMORY_OPERANDS(%d) memory operands", MAX_MEMORY_OPERANDS);
+      for(UInt32 mem_idx = 0; mem_idx < decoded.num_memory_operands; ++mem_idx)
+      {
+         if (decoder->op_read_mem(dec_inst, mem_idx))
+            decoded.read_mask |= 1 << mem_idx;
+         if (decoder->op_write_mem(dec_inst, mem_idx))
+            decoded.write_mask |= 1 << mem_idx;
+         if ((decoded.read_mask | decoded.write_mask) & (1 << mem_idx))
+            decoded.mem_size[mem_idx] = decoder->size_mem_op(dec_inst, mem_idx);
+      }
+   }
+
+   return decoded;
+}
+
+UInt8 DecodeCache::Decoded::summarizeFlags(const dl::DecodedInst *dec_inst)
+{
+   return (dec_inst->is_nop() ? FLAG_NOP : 0)
+        | (dec_inst->is_atomic() ? FLAG_ATOMIC : 0)
+        | (dec_inst->is_prefetch() ? FLAG_PREFETCH : 0)
+        | (dec_inst->is_mem_pair() ? FLAG_MEM_PAIR : 0)
+        | (dec_inst->is_indirect_branch() ? FLAG_INDIRECT_BRANCH : 0);
+}
@@ -0,0 +1,238 @@
+#ifndef __DECODE_CACHE_H
+#define __DECODE_CACHE_H
+
+#include "fixed_types.h"
+#include "lock.h"
+#include "log.h"
+#include "sift_reader.h"
+
+#include <decoder.h>
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+class Instruction;
+
+// Insert-only open-addressing hash table, safe for lookups concurrent with inserts.
+// Lookups take no locks: entries are immutable once published, and when the table grows the old
+// slot array is retired (but kept until destruction) so readers still probing it stay valid.
+template <typename K, typename V>
+class InsertOnlyHashTable
+{
+   private:
+      struct Entry
+      {
+         K key;
+         V value;
+         Entry(const K &_key, const V &_value) : key(_key), value(_value) {}
+      };
+
+      struct Table
+      {
+         UInt64 mask;
+         std::atomic<Entry*> *slots;
+         Table(UInt64 size) : mask(size - 1), slots(new std::atomic<Entry*>[size])
+         {
+            for(UInt64 i = 0; i < size; ++i)
+               slots[i].store(NULL, std::memory_order_relaxed);
+         }
+         ~Table() { delete [] slots; }
+      };
+
+      std::atomic<Table*> m_table;
+      std::vector<Table*> m_retired;
+      std::vector<Entry*> m_entries;
+      Lock m_lock;
+
+      static Entry* probe(const Table *table, const K &key, UInt64 &index)
+      {
+         for(index = key.hash() & table->mask; ; index = (index + 1) & table->mask)
+         {
+            Entry *entry = table->slots[index].load(std::memory_order_acquire);
+            if (!entry || entry->key == key)
+               return entry;
+         }
+      }
+
+      void grow()
+      {
+         Table *table = m_table.load(std::memory_order_relaxed);
+         Table *new_table = new Table(2 * (table->mask + 1));
+         for(typename std::vector<Entry*>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+         {
+            UInt64 index;
+            probe(new_table, (*it)->key, index);
+            new_table->slots[index].store(*it, std::memory_order_relaxed);
+         }
+         m_table.store(new_table, std::memory_order_release);
+         m_retired.push_back(table);
+      }
+
+   public:
+      InsertOnlyHashTable(UInt64 initial_size = 4096)
+      {
+         LOG_ASSERT_ERROR(initial_size && (initial_size & (initial_size - 1)) == 0, "Table size must be a power of two");
+         m_table.store(new Table(initial_size), std::memory_order_relaxed);
+      }
+
+      ~InsertOnlyHashTable()
+      {
+         for(typename std::vector<Entry*>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+            delete *it;
+         for(typename std::vector<Table*>::iterator it = m_retired.begin(); it != m_retired.end(); ++it)
+            delete *it;
+         delete m_table.load(std::memory_order_relaxed);
+      }
+
+      // Returns NULL if not found
+      const V* find(const K &key) const
+      {
+         UInt64 index;
+         const Entry *entry = probe(m_table.load(std::memory_order_acquire), key, index);
+         return entry ? &entry->value : NULL;
+      }
+
+      // Returns the value for <key>, calling create() to make it if it is not yet there.
+      // create() runs with the insert lock held, so every value is created exactly once.
+      template <typename F> const V* findOrInsert(const K &key, F create)
+      {
+         const V *value = find(key);
+         if (value)
+            return value;
+
+         ScopedLock sl(m_lock);
+
+         UInt64 index;
+         const Entry *entry = probe(m_table.load(std::memory_order_relaxed), key, index);
+         if (entry)
+            return &entry->value;
+
+         Entry *new_entry = new Entry(key, create());
+
+         // Keep the load factor below 1/2 so probe sequences stay short
+         Table *table = m_table.load(std::memory_order_relaxed);
+         if (2 * (m_entries.size() + 1) > table->mask + 1)
+         {
+            grow();
+            table = m_table.load(std::memory_order_relaxed);
+            probe(table, key, index);
+         }
+
+         m_entries.push_back(new_entry);
+         table->slots[index].store(new_entry, std::memory_order_release);
+         return &new_entry->value;
+      }
+
+      template <typename F> void forEach(F func)
+      {
+         ScopedLock sl(m_lock);
+         for(typename std::vector<Entry*>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+            func((*it)->key, (*it)->value);
+      }
+};
+
+// Process-wide cache of decoded instructions, shared by all TraceThreads.
+// Static decoding only depends on the instruction bytes, address and ISA, so entries are keyed on exactly
+// that: threads (and applications) running the same code share the decoder output. Instruction objects
+// also embed the (per-application) physical address, which is made part of their key.
+class DecodeCache
+{
+   public:
+      struct Key
+      {
+         UInt64 addr;
+         UInt64 pa;
+         UInt8 size;
+         UInt8 isa;
+         UInt8 is_branch;
+         UInt8 data[16];
+
+         Key() { memset(this, 0, sizeof(*this)); }
+         Key(const Sift::Instruction &inst, UInt64 _pa, bool with_instruction)
+         {
+            memset(this, 0, sizeof(*this));
+            addr = inst.sinst->addr;
+            size = inst.sinst->size;
+            isa = inst.isa;
+            memcpy(data, inst.sinst->data, size);
+            if (with_instruction)
+            {
+               pa = _pa;
+               is_branch = inst.is_branch;
+            }
+         }
+         bool operator==(const Key &other) const { return memcmp(this, &other, sizeof(*this)) == 0; }
+         bool operator<(const Key &other) const { return memcmp(this, &other, sizeof(*this)) < 0; }
+         UInt64 hash() const
+         {
+            UInt64 words[2];
+            memcpy(words, data, sizeof(words));
+            UInt64 h = (addr ^ (pa * 0x9e3779b97f4a7c15ULL) ^ words[0] ^ (words[1] << 1) ^ (UInt64(size) << 56)) * 0xff51afd7ed558ccdULL;
+            return h ^ (h >> 32);
+         }
+      };
+
+      // Decoder output of one static instruction. Its memory operands, and the properties the per-instruction
+      // replay loop needs, are summarized once here, so the trace threads need not go back to the (ISA-specific,
+      // virtual) decoder interface for every dynamic instance.
+      struct Decoded
+      {
+         static const UInt32 MAX_MEMORY_OPERANDS = 8;
+
+         enum {
+            FLAG_NOP = 1,
+            FLAG_ATOMIC = 2,
+            FLAG_PREFETCH = 4,
+            FLAG_MEM_PAIR = 8,
+            FLAG_INDIRECT_BRANCH = 16,
+         };
+
+         const dl::DecodedInst *dec_inst;
+         bool stored;                  //< dec_inst lives in the StaticInstDatabase, not owned by us
+         UInt8 flags;
+         UInt8 num_memory_operands;    //< Zero for NOPs, their memory operands are never accessed
+         UInt8 read_mask;
+         UInt8 write_mask;
+         UInt16 mem_size[MAX_MEMORY_OPERANDS];
+
+         UInt32 numMemoryOperands() const { return num_memory_operands; }
+         bool opReadMem(UInt32 mem_idx) const { return read_mask & (1 << mem_idx); }
+         bool opWriteMem(UInt32 mem_idx) const { return write_mask & (1 << mem_idx); }
+         UInt32 sizeMemOp(UInt32 mem_idx) const { return mem_size[mem_idx]; }
+
+         bool isNop() const { return flags & FLAG_NOP; }
+         bool isAtomic() const { return flags & FLAG_ATOMIC; }
+         bool isPrefetch() const { return flags & FLAG_PREFETCH; }
+         bool isMemPair() const { return flags & FLAG_MEM_PAIR; }
+         bool isIndirectBranch() const { return flags & FLAG_INDIRECT_BRANCH; }
+
+         // Summarize the output of the full decoder
+         static Decoded fromDecoder(dl::Decoder *decoder, const dl::DecodedInst *dec_inst);
+         static UInt8 summarizeFlags(const dl::DecodedInst *dec_inst);
+      };
+
+      struct Entry
+      {
+         Instruction *instruction;
+         const Decoded *decoded;
+      };
+
+      DecodeCache();
+      ~DecodeCache();
+
+      template <typename F> const Decoded* getDecoded(const Key &key, F create)
+      {
+         return m_decoded.findOrInsert(key, create);
+      }
+      template <typename F> const Entry* getInstruction(const Key &key, F create)
+      {
+         return m_instructions.findOrInsert(key, create);
+      }
+
+   private:
+      InsertOnlyHashTable<Key, Decoded> m_decoded;
+      InsertOnlyHashTable<Key, Entry> m_instructions;
+};
+
+#endif // __DECODE_CACHE_H
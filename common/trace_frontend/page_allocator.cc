@@ -0,0 +1,220 @@
+#include "page_allocator.h"
+#include "simulator.h"
+#include "config.hpp"
+#include "stats.h"
+#include "rng.h"
+#include "log.h"
+
+PageAllocator* PageAllocator::create()
+{
+   if (Sim()->getCfg()->getBool("traceinput/page_allocator/enabled"))
+      return new PageAllocator();
+   else
+      return NULL;
+}
+
+static UInt32 parseNumaPolicy(String policy)
+{
+   if (policy == "first_touch")
+      return 0;
+   else if (policy == "interleave")
+      return 1;
+   LOG_PRINT_ERROR("Invalid traceinput/page_allocator/numa_policy %s", policy.c_str());
+}
+
+static UInt32 parseColorPolicy(String policy)
+{
+   if (policy == "none")
+      return 0;
+   else if (policy == "virtual")
+      return 1;
+   else if (policy == "bin_hopping")
+      return 2;
+   LOG_PRINT_ERROR("Invalid traceinput/page_allocator/coloring %s", policy.c_str());
+}
+
+PageAllocator::PageAllocator()
+   : m_num_nodes(Sim()->getCfg()->getInt("traceinput/page_allocator/numa_nodes"))
+   , m_node_frames((UInt64(Sim()->getCfg()->getInt("traceinput/page_allocator/memory_size")) << (20 - PAGE_SHIFT)) / std::max(m_num_nodes, 1U))
+   , m_numa_policy((numa_policy_t)parseNumaPolicy(Sim()->getCfg()->getString("traceinput/page_allocator/numa_policy")))
+   , m_color_policy((color_policy_t)parseColorPolicy(Sim()->getCfg()->getString("traceinput/page_allocator/coloring")))
+   , m_num_colors(Sim()->getCfg()->getInt("traceinput/page_allocator/colors"))
+   , m_huge_pages(Sim()->getCfg()->getBool("traceinput/page_allocator/huge_pages"))
+   , m_page_table(1 << 16)
+   , m_huge_table(1 << 10)
+   , m_next_node(0)
+   , m_pages(0)
+   , m_huge(0)
+   , m_huge_fallbacks(0)
+   , m_color_fallbacks(0)
+   , m_remote(0)
+{
+   LOG_ASSERT_ERROR(m_num_nodes > 0, "traceinput/page_allocator/numa_nodes must be at least 1");
+   LOG_ASSERT_ERROR(m_node_frames && m_node_frames % (1 << MAX_ORDER) == 0,
+      "traceinput/page_allocator/memory_size must be a multiple of %d MB per NUMA node", (1 << (MAX_ORDER + PAGE_SHIFT)) >> 20);
+   LOG_ASSERT_ERROR(m_color_policy == COLOR_NONE || (m_num_colors && (m_num_colors & (m_num_colors - 1)) == 0),
+      "traceinput/page_allocator/colors must be a power of two");
+
+   // All of memory starts out as free blocks of the largest order
+   for(UInt32 order = 0; order <= MAX_ORDER; ++order)
+      m_free[order].resize(m_num_nodes);
+   for(UInt32 node = 0; node < m_num_nodes; ++node)
+      for(UInt64 frame = node * m_node_frames; frame < (node + 1) * m_node_frames; frame += 1 << MAX_ORDER)
+         m_free[MAX_ORDER][node].insert(m_free[MAX_ORDER][node].end(), frame);
+
+   // Model a system that has been running for a while: frames used by others are scattered over memory
+   float fragmentation = Sim()->getCfg()->getFloat("traceinput/page_allocator/fragmentation");
+   LOG_ASSERT_ERROR(fragmentation >= 0 && fragmentation < 1, "traceinput/page_allocator/fragmentation must be in [0, 1)");
+   UInt64 total_frames = m_num_nodes * m_node_frames;
+   UInt64 state = rng_seed(Sim()->getCfg()->getInt("traceinput/page_allocator/seed"));
+   for(UInt64 reserved = 0; reserved < UInt64(fragmentation * total_frames); )
+   {
+      UInt64 frame = ((rng_next(state) << 32) | rng_next(state)) % total_frames;
+      if (reserve(frame))
+         ++reserved;
+   }
+
+   registerStatsMetric("page_allocator", 0, "pages", &m_pages);
+   registerStatsMetric("page_allocator", 0, "huge-pages", &m_huge);
+   registerStatsMetric("page_allocator", 0, "huge-fallbacks", &m_huge_fallbacks);
+   registerStatsMetric("page_allocator", 0, "color-fallbacks", &m_color_fallbacks);
+   registerStatsMetric("page_allocator", 0, "remote-pages", &m_remote);
+}
+
+PageAllocator::~PageAllocator()
+{
+}
+
+UInt32 PageAllocator::homeNode(core_id_t core_id)
+{
+   if (m_numa_policy == NUMA_INTERLEAVE)
+      return m_next_node++ % m_num_nodes;
+   UInt32 num_cores = Sim()->getConfig()->getApplicationCores();
+   return core_id < 0 ? 0 : (UInt64(core_id) * m_num_nodes / num_cores) % m_num_nodes;
+}
+
+UInt64 PageAllocator::allocatePage(UInt64 process, UInt64 vpage, core_id_t core_id)
+{
+   ScopedLock sl(m_lock);
+
+   UInt64 color = INVALID_FRAME;
+   if (m_color_policy == COLOR_VIRTUAL)
+      color = vpage & (m_num_colors - 1);
+   else if (m_color_policy == COLOR_BIN_HOPPING)
+      color = m_next_color[process]++ & (m_num_colors - 1);
+
+   UInt64 frame = allocate(0, color, core_id);
+   LOG_ASSERT_ERROR(frame != INVALID_FRAME, "Page allocator is out of physical memory, increase traceinput/page_allocator/memory_size");
+   ++m_pages;
+   return frame;
+}
+
+UInt64 PageAllocator::allocateHuge(UInt64 process, core_id_t core_id)
+{
+   ScopedLock sl(m_lock);
+
+   UInt64 frame = allocate(HUGE_ORDER, INVALID_FRAME, core_id);
+   if (frame == INVALID_FRAME)
+      ++m_huge_fallbacks;
+   else
+      ++m_huge;
+   return frame;
+}
+
+UInt64 PageAllocator::allocate(UInt32 order, UInt64 color, core_id_t core_id)
+{
+   UInt32 home = homeNode(core_id);
+   UInt64 frame;
+
+   for(UInt32 i = 0; i < m_num_nodes; ++i)
+   {
+      UInt32 node = (home + i) % m_num_nodes;
+      if (allocateFromNode(node, order, color, frame))
+      {
+         if (i > 0)
+            m_remote += 1 << order;
+         return frame;
+      }
+   }
+
+   // No frame of the right colour anywhere, take any one
+   if (color != INVALID_FRAME)
+   {
+      ++m_color_fallbacks;
+      return allocate(order, INVALID_FRAME, core_id);
+   }
+   return INVALID_FRAME;
+}
+
+bool PageAllocator::allocateFromNode(UInt32 node, UInt32 order, UInt64 color, UInt64 &frame)
+{
+   for(UInt32 k = order; k <= MAX_ORDER; ++k)
+   {
+      std::set<UInt64> &free = m_free[k][node];
+      if (free.empty())
+         continue;
+
+      if (color == INVALID_FRAME || (UInt64(1) << k) >= m_num_colors)
+      {
+         // Blocks of this size contain every colour (blocks are aligned to their size, so colour c is at offset c)
+         UInt64 block = *free.begin();
+         free.erase(free.begin());
+         frame = split(node, block, k, order, color == INVALID_FRAME ? block : block + color);
+         return true;
+      }
+
+      // A smaller block only has some of the colours, look for one that has ours
+      UInt32 scanned = 0;
+      for(std::set<UInt64>::iterator it = free.begin(); it != free.end() && scanned < COLOR_SCAN; ++it, ++scanned)
+      {
+         UInt64 offset = (color - *it) & (m_num_colors - 1);
+         if (offset < (UInt64(1) << k))
+         {
+            UInt64 block = *it;
+            free.erase(it);
+            frame = split(node, block, k, order, block + offset);
+            return true;
+         }
+      }
+   }
+   return false;
+}
+
+bool PageAllocator::reserve(UInt64 frame)
+{
+   UInt32 node = frame / m_node_frames;
+   for(UInt32 k = 0; k <= MAX_ORDER; ++k)
+   {
+      UInt64 block = frame & ~((UInt64(1) << k) - 1);
+      std::set<UInt64>::iterator it = m_free[k][node].find(block);
+      if (it != m_free[k][node].end())
+      {
+         m_free[k][node].erase(it);
+         split(node, block, k, 0, frame);
+         return true;
+      }
+   }
+   // Already taken
+   return false;
+}
+
+UInt64 PageAllocator::split(UInt32 node, UInt64 block, UInt32 order, UInt32 target_order, UInt64 target)
+{
+   // Halve the block until it has the requested order, keeping the half that contains <target>
+   // and returning the other one to the free lists
+   while(order > target_order)
+   {
+      --order;
+      UInt64 half = UInt64(1) << order;
+      if (target >= block + half)
+      {
+         m_free[order][node].insert(block);
+         block += half;
+      }
+      else
+      {
+         m_free[order][node].insert(block + half);
+      }
+   }
+   return block;
+}
@@ -0,0 +1,102 @@
+#ifndef __PAGE_ALLOCATOR_H
+#define __PAGE_ALLOCATOR_H
+
+#include "fixed_types.h"
+#include "lock.h"
+#include "decode_cache.h"
+
+#include <set>
+#include <vector>
+#include <unordered_map>
+
+// Model of an OS physical page allocator for trace-driven simulation ([traceinput/page_allocator]).
+// Each process (application, or core with the sequential scheduler) gets a page table that is filled lazily:
+// the first touch of a virtual page allocates a physical frame from a buddy allocator, after that the
+// translation is fixed for the rest of the simulation (pages are never freed).
+// Physical memory is split into contiguous NUMA nodes, frames come from the node of the touching core
+// (first_touch) or round-robin over all nodes (interleave), falling back to other nodes when one is full.
+// Page colouring picks frames whose colour (frame number modulo the number of colours) matches the virtual
+// page (virtual), or hands out colours round-robin per process (bin_hopping). With huge_pages, the first touch
+// of a 2 MB aligned region allocates a 2 MB frame for all of it if one is available.
+// A fraction of memory can be taken away at random before the simulation starts, to model a fragmented system.
+class PageAllocator
+{
+   public:
+      static const UInt64 PAGE_SHIFT = 12;
+      static const UInt64 HUGE_ORDER = 9; // 2 MB
+
+      static PageAllocator* create();
+
+      PageAllocator();
+      ~PageAllocator();
+
+      // Physical page (frame number) for a virtual page of a process, allocating it on first touch
+      UInt64 translate(UInt64 process, UInt64 vpage, core_id_t core_id)
+      {
+         if (m_huge_pages)
+         {
+            UInt64 base = *m_huge_table.findOrInsert(Key(process, vpage >> HUGE_ORDER), [&]() { return allocateHuge(process, core_id); });
+            if (base != INVALID_FRAME)
+               return base + (vpage & ((1 << HUGE_ORDER) - 1));
+         }
+         return *m_page_table.findOrInsert(Key(process, vpage), [&]() { return allocatePage(process, vpage, core_id); });
+      }
+
+   private:
+      static const UInt32 MAX_ORDER = 10;
+      static const UInt32 COLOR_SCAN = 64;
+      static const UInt64 INVALID_FRAME = ~UInt64(0);
+
+      struct Key
+      {
+         UInt64 process;
+         UInt64 vpage;
+         Key(UInt64 _process, UInt64 _vpage) : process(_process), vpage(_vpage) {}
+         bool operator==(const Key &other) const { return process == other.process && vpage == other.vpage; }
+         UInt64 hash() const { UInt64 h = (vpage ^ (process << 40)) * 0x9e3779b97f4a7c15ULL; return h ^ (h >> 29); }
+      };
+
+      enum numa_policy_t
+      {
+         NUMA_FIRST_TOUCH,
+         NUMA_INTERLEAVE,
+      };
+      enum color_policy_t
+      {
+         COLOR_NONE,
+         COLOR_VIRTUAL,
+         COLOR_BIN_HOPPING,
+      };
+
+      const UInt32 m_num_nodes;
+      const UInt64 m_node_frames;
+      const numa_policy_t m_numa_policy;
+      const color_policy_t m_color_policy;
+      const UInt64 m_num_colors;
+      const bool m_huge_pages;
+
+      InsertOnlyHashTable<Key, UInt64> m_page_table;
+      InsertOnlyHashTable<Key, UInt64> m_huge_table; // Base frame of each 2 MB region, INVALID_FRAME if it uses 4 KB pages
+
+      Lock m_lock;
+      // Buddy allocator state, global frame numbers of the free blocks, per node and order
+      std::vector<std::set<UInt64> > m_free[MAX_ORDER + 1];
+      UInt64 m_next_node;
+      std::unordered_map<UInt64, UInt64> m_next_color;
+
+      UInt64 m_pages;
+      UInt64 m_huge;
+      UInt64 m_huge_fallbacks;
+      UInt64 m_color_fallbacks;
+      UInt64 m_remote;
+
+      UInt32 homeNode(core_id_t core_id);
+      UInt64 allocatePage(UInt64 process, UInt64 vpage, core_id_t core_id);
+      UInt64 allocateHuge(UInt64 process, core_id_t core_id);
+      UInt64 allocate(UInt32 order, UInt64 color, core_id_t core_id);
+      bool allocateFromNode(UInt32 node, UInt32 order, UInt64 color, UInt64 &frame);
+      bool reserve(UInt64 frame);
+      UInt64 split(UInt32 node, UInt64 block, UInt32 order, UInt32 target_order, UInt64 target);
+};
+
+#endif // __PAGE_ALLOCATOR_H
@@ -0,0 +1,315 @@
+#include "static_inst_db.h"
+#include "micro_op.h"
+#include "simulator.h"
+#include "log.h"
+#include "itostr.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char s_magic[8] = { 'S', 'I', 'F', 'T', 'S', 'I', 'D', 'B' };
+
+StaticInstDatabase::StoredInst::StoredInst(const Record *record, const char *disassembly)
+   : m_record(record)
+   , m_disassembly(disassembly)
+{
+   m_already_decoded = true;
+   m_dec = NULL;
+   m_size = record->key.size;
+   m_code = record->key.data;
+   m_address = record->key.addr;
+}
+
+StaticInstDatabase* StaticInstDatabase::open(const String &directory, const std::vector<String> &tracefiles)
+{
+#ifdef ENABLE_MICROOP_STRINGS
+   // Microops carrying strings cannot be stored as plain data
+   LOG_PRINT_WARNING("Static-instruction database not supported with ENABLE_MICROOP_STRINGS");
+   return NULL;
+#else
+   static_assert(std::is_trivially_copyable<MicroOp>::value, "MicroOp templates are stored as plain data");
+
+   UInt64 hash = 0;
+   for(std::vector<String>::const_iterator it = tracefiles.begin(); it != tracefiles.end(); ++it)
+      if (!hashFile(*it, hash))
+         return NULL;
+
+   char filename[32];
+   snprintf(filename, sizeof(filename), "%016" PRIx64 ".sidb", hash);
+   StaticInstDatabase *db = new StaticInstDatabase(directory + "/" + filename, hash);
+   db->load();
+   return db;
+#endif
+}
+
+StaticInstDatabase::StaticInstDatabase(const String &filename, UInt64 trace_hash)
+   : m_filename(filename)
+   , m_trace_hash(trace_hash)
+   , m_data(NULL)
+   , m_size(0)
+   , m_records(NULL)
+   , m_uops(NULL)
+   , m_strings(NULL)
+{
+   fillHeader(m_header, 0, 0, 0);
+}
+
+StaticInstDatabase::~StaticInstDatabase()
+{
+   if (!m_pending.empty())
+      write();
+   if (m_data)
+      munmap((void*)m_data, m_size);
+}
+
+bool StaticInstDatabase::hashFile(const String &filename, UInt64 &hash)
+{
+   int fd = ::open(filename.c_str(), O_RDONLY);
+   if (fd < 0)
+      return false;
+
+   struct stat filestatus;
+   if (fstat(fd, &filestatus) != 0 || !S_ISREG(filestatus.st_mode))
+   {
+      close(fd);
+      return false;
+   }
+
+   size_t size = filestatus.st_size;
+   UInt64 h = (hash ^ size) * 0x9e3779b97f4a7c15ULL;
+   if (size)
+   {
+      void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+      if (data == MAP_FAILED)
+      {
+         close(fd);
+         return false;
+      }
+      madvise(data, size, MADV_SEQUENTIAL);
+
+      const UInt8 *bytes = (const UInt8 *)data;
+      size_t offset = 0;
+      for( ; offset + sizeof(UInt64) <= size; offset += sizeof(UInt64))
+      {
+         UInt64 word;
+         memcpy(&word, bytes + offset, sizeof(word));
+         h = (h ^ word) * 0xff51afd7ed558ccdULL;
+         h ^= h >> 32;
+      }
+      for( ; offset < size; ++offset)
+         h = (h ^ bytes[offset]) * 0xff51afd7ed558ccdULL;
+
+      munmap(data, size);
+   }
+   close(fd);
+
+   hash = h ^ (h >> 29);
+   return true;
+}
+
+void StaticInstDatabase::fillHeader(Header &header, UInt64 num_records, UInt64 num_uops, UInt64 strings_size) const
+{
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, s_magic, sizeof(header.magic));
+   header.version = VERSION;
+   // Opcodes and registers are decoder enumerations, and microops are stored as they are laid out in memory:
+   // a file made by a different decoder or build is not used
+   dl::Decoder *decoder = Sim()->getDecoder();
+   header.fingerprint[0] = decoder->get_arch();
+   header.fingerprint[1] = decoder->last_reg();
+   header.fingerprint[2] = sizeof(MicroOp);
+   header.fingerprint[3] = sizeof(Record);
+   header.trace_hash = m_trace_hash;
+   header.num_records = num_records;
+   header.num_uops = num_uops;
+   header.strings_size = strings_size;
+}
+
+void StaticInstDatabase::load()
+{
+   int fd = ::open(m_filename.c_str(), O_RDONLY);
+   if (fd < 0)
+      return;
+
+   struct stat filestatus;
+   if (fstat(fd, &filestatus) == 0 && S_ISREG(filestatus.st_mode) && size_t(filestatus.st_size) >= sizeof(Header))
+   {
+      void *data = mmap(NULL, filestatus.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (data != MAP_FAILED)
+      {
+         m_data = (const char *)data;
+         m_size = filestatus.st_size;
+      }
+   }
+   // The mapping stays valid after closing the file
+   close(fd);
+   if (!m_data)
+      return;
+
+   const Header *header = (const Header *)m_data;
+   Header expected;
+   fillHeader(expected, header->num_records, header->num_uops, header->strings_size);
+   if (memcmp(header, &expected, sizeof(Header)) != 0
+      || m_size != sizeof(Header) + header->num_records * sizeof(Record) + header->num_uops * sizeof(MicroOp) + header->strings_size)
+   {
+      LOG_PRINT_WARNING("Ignoring stale static-instruction database %s", m_filename.c_str());
+      munmap((void*)m_data, m_size);
+      m_data = NULL;
+      m_size = 0;
+      return;
+   }
+
+   m_header = *header;
+   m_records = (const Record *)(m_data + sizeof(Header));
+   m_uops = (const MicroOp *)(m_records + m_header.num_records);
+   m_strings = (const char *)(m_uops + m_header.num_uops);
+
+   // Never reallocated: the decoded instructions are handed out by pointer
+   m_stored.reserve(m_header.num_records);
+   m_decoded.reserve(m_header.num_records);
+   for(UInt64 idx = 0; idx < m_header.num_records; ++idx)
+   {
+      const Record *record = &m_records[idx];
+      m_stored.emplace_back(record, m_strings + record->disassembly_offset);
+
+      DecodeCache::Decoded decoded;
+      memset(&decoded, 0, sizeof(decoded));
+      decoded.dec_inst = &m_stored.back();
+      decoded.stored = true;
+      decoded.flags = DecodeCache::Decoded::summarizeFlags(decoded.dec_inst);
+      decoded.num_memory_operands = record->num_memory_operands;
+      decoded.read_mask = record->read_mask;
+      decoded.write_mask = record->write_mask;
+      memcpy(decoded.mem_size, record->mem_size, sizeof(decoded.mem_size));
+      m_decoded.push_back(decoded);
+   }
+
+   printf("[TRACE] Using %" PRIu64 " decoded instructions from %s\n", m_header.num_records, m_filename.c_str());
+}
+
+const DecodeCache::Decoded* StaticInstDatabase::find(const DecodeCache::Key &key)
+{
+   const Record *begin = m_records, *end = m_records + m_header.num_records;
+   const Record *record = std::lower_bound(begin, end, key, [](const Record &r, const DecodeCache::Key &k) { return r.key < k; });
+   if (record == end || !(record->key == key))
+      return NULL;
+   return &m_decoded[record - begin];
+}
+
+const std::vector<const MicroOp*>* StaticInstDatabase::getMicroOps(const DecodeCache::Decoded &decoded, Instruction *instruction)
+{
+   const Record *record = static_cast<const StoredInst*>(decoded.dec_inst)->getRecord();
+
+   // Same layout InstructionDecoder::decode uses: one contiguous block per instruction
+   MicroOp *microOps = new MicroOp[record->num_uops];
+   std::vector<const MicroOp*> *uops = new std::vector<const MicroOp*>();
+   uops->reserve(record->num_uops);
+   for(UInt32 idx = 0; idx < record->num_uops; ++idx)
+   {
+      microOps[idx] = m_uops[record->uops_index + idx];
+      microOps[idx].setInstruction(instruction);
+      microOps[idx].setDecodedInstruction(decoded.dec_inst);
+      uops->push_back(&microOps[idx]);
+   }
+   return uops;
+}
+
+void StaticInstDatabase::record(const DecodeCache::Key &key, const DecodeCache::Decoded &decoded, const std::vector<const MicroOp*> *uops)
+{
+   ScopedLock sl(m_lock);
+
+   if (m_pending.count(key))
+      return;
+
+   const dl::DecodedInst *dec_inst = decoded.dec_inst;
+   Pending &pending = m_pending[key];
+   pending.record = Record();
+   memcpy(&pending.record.key, &key, sizeof(key));
+   pending.record.inst_num_id = dec_inst->inst_num_id();
+   pending.record.flags =
+        (dec_inst->is_nop() ? FLAG_NOP : 0)
+      | (dec_inst->is_atomic() ? FLAG_ATOMIC : 0)
+      | (dec_inst->is_prefetch() ? FLAG_PREFETCH : 0)
+      | (dec_inst->is_serializing() ? FLAG_SERIALIZING : 0)
+      | (dec_inst->is_conditional_branch() ? FLAG_CONDITIONAL_BRANCH : 0)
+      | (dec_inst->is_indirect_branch() ? FLAG_INDIRECT_BRANCH : 0)
+      | (dec_inst->is_barrier() ? FLAG_BARRIER : 0)
+      | (dec_inst->src_dst_merge() ? FLAG_SRC_DST_MERGE : 0)
+      | (dec_inst->is_X87() ? FLAG_X87 : 0)
+      | (dec_inst->has_modifiers() ? FLAG_MODIFIERS : 0)
+      | (dec_inst->is_mem_pair() ? FLAG_MEM_PAIR : 0)
+      | (dec_inst->is_writeback() ? FLAG_WRITEBACK : 0);
+   pending.record.num_uops = uops->size();
+   pending.record.num_memory_operands = decoded.num_memory_operands;
+   pending.record.read_mask = decoded.read_mask;
+   pending.record.write_mask = decoded.write_mask;
+   memcpy(pending.record.mem_size, decoded.mem_size, sizeof(pending.record.mem_size));
+   pending.disassembly = dec_inst->disassembly_to_str();
+
+   // Templates do not point into this process, find() and getMicroOps() fill that in
+   for(std::vector<const MicroOp*>::const_iterator it = uops->begin(); it != uops->end(); ++it)
+   {
+      pending.uops.push_back(**it);
+      pending.uops.back().setInstruction(NULL);
+      pending.uops.back().setDecodedInstruction(NULL);
+   }
+}
+
+void StaticInstDatabase::write()
+{
+   // Merge the records we loaded with the new ones, rebuilding the file sorted on key
+   for(UInt64 idx = 0; idx < m_header.num_records; ++idx)
+   {
+      const Record &record = m_records[idx];
+      Pending &pending = m_pending[record.key];
+      pending.record = record;
+      pending.disassembly = std::string(m_strings + record.disassembly_offset, record.disassembly_size);
+      pending.uops.assign(m_uops + record.uops_index, m_uops + record.uops_index + record.num_uops);
+   }
+
+   std::vector<Record> records;
+   std::vector<MicroOp> uops;
+   std::string strings;
+   records.reserve(m_pending.size());
+   for(std::map<DecodeCache::Key, Pending>::iterator it = m_pending.begin(); it != m_pending.end(); ++it)
+   {
+      Record record = it->second.record;
+      record.uops_index = uops.size();
+      record.disassembly_offset = strings.size();
+      record.disassembly_size = it->second.disassembly.size();
+      records.push_back(record);
+      uops.insert(uops.end(), it->second.uops.begin(), it->second.uops.end());
+      strings += it->second.disassembly;
+   }
+
+   Header header;
+   fillHeader(header, records.size(), uops.size(), strings.size());
+
+   // Write under a private name and rename, so concurrent runs only ever map a complete file
+   String tmpname = m_filename + ".tmp." + itostr(getpid());
+   FILE *fp = fopen(tmpname.c_str(), "wb");
+   if (!fp)
+   {
+      LOG_PRINT_WARNING("Cannot write static-instruction database %s", tmpname.c_str());
+      return;
+   }
+   bool ok = fwrite(&header, sizeof(header), 1, fp) == 1
+      && fwrite(records.data(), sizeof(Record), records.size(), fp) == records.size()
+      && fwrite(uops.data(), sizeof(MicroOp), uops.size(), fp) == uops.size()
+      && fwrite(strings.data(), 1, strings.size(), fp) == strings.size();
+   ok = (fclose(fp) == 0) && ok;
+
+   if (ok && rename(tmpname.c_str(), m_filename.c_str()) == 0)
+      printf("[TRACE] Wrote %zu decoded instructions to %s\n", records.size(), m_filename.c_str());
+   else
+   {
+      LOG_PRINT_WARNING("Cannot write static-instruction database %s", m_filename.c_str());
+      unlink(tmpname.c_str());
+   }
+}
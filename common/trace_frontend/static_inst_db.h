@@ -0,0 +1,142 @@
+#ifndef __STATIC_INST_DB_H
+#define __STATIC_INST_DB_H
+
+#include "fixed_types.h"
+#include "decode_cache.h"
+#include "lock.h"
+
+#include <decoder.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+class Instruction;
+struct MicroOp;
+
+// Persistent database of decoded static instructions, a sidecar file next to the traces ([traceinput/static_db]).
+// The file is named after a hash of the trace contents and holds, per static instruction, the decoder properties
+// the simulator uses and the microop templates InstructionDecoder made for it. It is memory-mapped read-only:
+// warm runs get their decoded instructions and microops from it without invoking the decoder, and all processes
+// on a host simulating the same traces share its pages.
+// Instructions that are not in the file yet are decoded as usual, recorded, and written to a new version
+// of the file when the simulation ends.
+class StaticInstDatabase
+{
+   public:
+      // Returns NULL when the traces cannot be hashed (pipes, live frontends)
+      static StaticInstDatabase* open(const String &directory, const std::vector<String> &tracefiles);
+      ~StaticInstDatabase();
+
+      // Decoded instruction from the file, or NULL if it is not there
+      const DecodeCache::Decoded* find(const DecodeCache::Key &key);
+      // Microops for an instruction returned by find(), made from the templates in the file
+      const std::vector<const MicroOp*>* getMicroOps(const DecodeCache::Decoded &decoded, Instruction *instruction);
+      // Remember the decoder output of an instruction that was not in the file
+      void record(const DecodeCache::Key &key, const DecodeCache::Decoded &decoded, const std::vector<const MicroOp*> *uops);
+
+   private:
+      static const UInt32 VERSION = 1;
+
+      enum Flags
+      {
+         FLAG_NOP = 1 << 0,
+         FLAG_ATOMIC = 1 << 1,
+         FLAG_PREFETCH = 1 << 2,
+         FLAG_SERIALIZING = 1 << 3,
+         FLAG_CONDITIONAL_BRANCH = 1 << 4,
+         FLAG_INDIRECT_BRANCH = 1 << 5,
+         FLAG_BARRIER = 1 << 6,
+         FLAG_SRC_DST_MERGE = 1 << 7,
+         FLAG_X87 = 1 << 8,
+         FLAG_MODIFIERS = 1 << 9,
+         FLAG_MEM_PAIR = 1 << 10,
+         FLAG_WRITEBACK = 1 << 11,
+      };
+
+      struct Header
+      {
+         char magic[8];
+         UInt32 version;
+         UInt32 fingerprint[4];        //< Decoder and build properties the records depend on
+         UInt64 trace_hash;
+         UInt64 num_records;
+         UInt64 num_uops;
+         UInt64 strings_size;
+      };
+
+      // Fixed-size record per static instruction, sorted on key. Followed in the file by all microop templates,
+      // then the disassembly strings.
+      struct Record
+      {
+         DecodeCache::Key key;
+         UInt32 inst_num_id;
+         UInt32 flags;
+         UInt64 uops_index;
+         UInt64 disassembly_offset;
+         UInt32 disassembly_size;
+         UInt16 num_uops;
+         UInt8 num_memory_operands;
+         UInt8 read_mask;
+         UInt8 write_mask;
+         UInt16 mem_size[DecodeCache::Decoded::MAX_MEMORY_OPERANDS];
+      };
+
+      // A decoded instruction backed by its record in the mapping, in place of the decoder's own
+      class StoredInst : public dl::DecodedInst
+      {
+         public:
+            StoredInst(const Record *record, const char *disassembly);
+            const Record *getRecord() const { return m_record; }
+
+            unsigned int inst_num_id() const { return m_record->inst_num_id; }
+            std::string disassembly_to_str() const { return std::string(m_disassembly, m_record->disassembly_size); }
+            bool is_nop() const { return m_record->flags & FLAG_NOP; }
+            bool is_atomic() const { return m_record->flags & FLAG_ATOMIC; }
+            bool is_prefetch() const { return m_record->flags & FLAG_PREFETCH; }
+            bool is_serializing() const { return m_record->flags & FLAG_SERIALIZING; }
+            bool is_conditional_branch() const { return m_record->flags & FLAG_CONDITIONAL_BRANCH; }
+            bool is_indirect_branch() const { return m_record->flags & FLAG_INDIRECT_BRANCH; }
+            bool is_barrier() const { return m_record->flags & FLAG_BARRIER; }
+            bool src_dst_merge() const { return m_record->flags & FLAG_SRC_DST_MERGE; }
+            bool is_X87() const { return m_record->flags & FLAG_X87; }
+            bool has_modifiers() const { return m_record->flags & FLAG_MODIFIERS; }
+            bool is_mem_pair() const { return m_record->flags & FLAG_MEM_PAIR; }
+            bool is_writeback() const { return m_record->flags & FLAG_WRITEBACK; }
+
+         private:
+            const Record *m_record;
+            const char *m_disassembly;
+      };
+
+      // Instruction recorded during this run, in the form it is written in
+      struct Pending
+      {
+         Record record;
+         std::string disassembly;
+         std::vector<MicroOp> uops;
+      };
+
+      const String m_filename;
+      const UInt64 m_trace_hash;
+      Header m_header;
+      // Mapped file, if there was a valid one
+      const char *m_data;
+      size_t m_size;
+      const Record *m_records;
+      const MicroOp *m_uops;
+      const char *m_strings;
+      std::vector<StoredInst> m_stored;
+      std::vector<DecodeCache::Decoded> m_decoded;
+
+      std::map<DecodeCache::Key, Pending> m_pending;
+      Lock m_lock;
+
+      StaticInstDatabase(const String &filename, UInt64 trace_hash);
+      static bool hashFile(const String &filename, UInt64 &hash);
+      void fillHeader(Header &header, UInt64 num_records, UInt64 num_uops, UInt64 strings_size) const;
+      void load();
+      void write();
+};
+
+#endif // __STATIC_INST_DB_H
@@ -1,11 +1,19 @@
 #include "trace_manager.h"
 #include "trace_thread.h"
+#include "decode_cache.h"
+#include "static_inst_db.h"
+#include "page_allocator.h"
+#include "fiber_pool.h"
 #include "simulator.h"
 #include "thread_manager.h"
 #include "hooks_manager.h"
 #include "config.hpp"
 #include "sim_api.h"
 #include "stats.h"
+#include "shm_stream.h"
+#include "checkpoint.h"
+#include "checkpoint_manager.h"
+#include "shared_stream.h"
 
 #include <unistd.h>
 #include <sys/types.h>
@@ -20,13 +28,28 @@ TraceManager::TraceManager()
    , m_stop_with_first_app(Sim()->getCfg()->getBool("traceinput/stop_with_first_app"))
    , m_app_restart(Sim()->getCfg()->getBool("traceinput/restart_apps"))
    , m_emulate_syscalls(Sim()->getCfg()->getBool("traceinput/emulate_syscalls"))
+   , m_shm_transport(Sim()->getCfg()->getString("traceinput/transport") == "shm")
+   , m_shm_ring_size(Sim()->getCfg()->getInt("traceinput/shm_ring_size") * 1024)
    , m_num_apps(Sim()->getCfg()->getInt("traceinput/num_apps"))
    , m_num_apps_nonfinish(m_num_apps)
    , m_app_info(m_num_apps)
    , m_tracefiles(m_num_apps)
    , m_responsefiles(m_num_apps)
+   , m_decode_cache(new DecodeCache())
+   , m_static_db(NULL)
+   , m_page_allocator(PageAllocator::create())
+   , m_fiber_pool(FiberPool::create())
 {
    setupTraceFiles(0);
+
+   // Only offline traces can be hashed up front, live frontends decode as they go
+   String static_db = Sim()->getCfg()->getString("traceinput/static_db");
+   if (static_db != "" && m_trace_prefix == "")
+   {
+      m_static_db = StaticInstDatabase::open(static_db, m_tracefiles);
+      if (!m_static_db)
+         LOG_PRINT_WARNING("Cannot hash the trace files, not using the static-instruction database");
+   }
 }
 
 void TraceManager::setupTraceFiles(int index)
@@ -61,9 +84,49 @@ void TraceManager::setupTraceFiles(int index)
 
 void TraceManager::init()
 {
+   if (Sim()->getCheckpointManager() && Sim()->getCheckpointManager()->isResuming())
+   {
+      CheckpointReader ckpt(Sim()->getCheckpointManager()->getResumeFile("trace.ckpt"));
+      ckpt.beginSection("trace");
+      loadCheckpoint(ckpt);
+      ckpt.endSection();
+      return;
+   }
+
+   if (Sim()->getCfg()->getBool("traceinput/shared_reader"))
+      setupSharedTraces();
+
    for (UInt32 i = 0 ; i < m_num_apps ; i++ )
    {
       newThread(i /*app_id*/, true /*first*/, false /*init_fifo*/, false /*spawn*/, SubsecondTime::Zero(), INVALID_THREAD_ID);
+      if (m_shared_traces.count(m_tracefiles[i]))
+         m_threads.back()->setSharedTrace(m_shared_traces[m_tracefiles[i]]);
+   }
+}
+
+void TraceManager::setupSharedTraces()
+{
+   // Only offline traces that are read from start to end exactly once per application can be shared:
+   // no frontend to respond to, no seeking to a start instruction, and no restarting applications
+   if (m_trace_prefix != "" || m_app_restart || Sim()->getCfg()->getInt("traceinput/start_icount"))
+      return;
+
+   std::map<String, UInt32> copies;
+   for (UInt32 i = 0 ; i < m_num_apps ; i++ )
+      ++copies[m_tracefiles[i]];
+
+   UInt64 chunksize = Sim()->getCfg()->getInt("traceinput/shared_reader_chunk_size") * 1024;
+   for(std::map<String, UInt32>::iterator it = copies.begin(); it != copies.end(); ++it)
+   {
+      if (it->second < 2)
+         continue;
+      // Returns NULL for pipes, those are read by each application on its own
+      SharedTrace *shared = SharedTrace::open(it->first.c_str(), it->second, chunksize);
+      if (shared)
+      {
+         m_shared_traces[it->first] = shared;
+         printf("[TRACE] Reading %s once for %u applications\n", it->first.c_str(), it->second);
+      }
    }
 }
 
@@ -71,7 +134,15 @@ String TraceManager::getFifoName(app_id_t app_id, UInt64 thread_num, bool respon
 {
    String filename = m_trace_prefix + (response ? "_response" : "") + ".app" + itostr(app_id) + ".th" + itostr(thread_num) + ".sift";
    if (create)
-      mkfifo(filename.c_str(), 0600);
+   {
+      if (m_shm_transport)
+      {
+         bool created = ShmRing::create(filename.c_str(), m_shm_ring_size);
+         LOG_ASSERT_ERROR(created, "Cannot create shared-memory ring %s", filename.c_str());
+      }
+      else
+         mkfifo(filename.c_str(), 0600);
+   }
    return filename;
 }
 
@@ -123,6 +194,7 @@ thread_id_t TraceManager::newThread(app_id_t app_id, bool first, bool init_fifo,
    Thread *thread = Sim()->getThreadManager()->createThread(app_id, creator_thread_id);
    TraceThread *tthread = new TraceThread(thread, time, tracefile, responsefile, app_id, init_fifo /*cleaup*/);
    m_threads.push_back(tthread);
+   m_thread_info.push_back(thread_info_t{ first, init_fifo });
 
    if (spawn)
    {
@@ -197,7 +269,10 @@ void TraceManager::signalDone(TraceThread *thread, SubsecondTime time, bool abor
             // Stop condition not met. Restart app?
             if (m_app_restart)
             {
-               newThread(app_id, true /*first*/, false /*init_fifo*/, true /*spawn*/, time, INVALID_THREAD_ID);
+               newThread(app_id, true /*first*/, false /*init_fifo*/, false /*spawn*/, time, INVALID_THREAD_ID);
+               // Replay the trace without reopening and re-parsing it when it ended on this thread
+               m_threads.back()->restartFrom(thread);
+               m_threads.back()->spawn();
             }
          }
       }
@@ -235,6 +310,7 @@ void TraceManager::cleanup()
    for(std::vector<TraceThread *>::iterator it = m_threads.begin(); it != m_threads.end(); ++it)
       delete *it;
    m_threads.clear();
+   m_thread_info.clear();
 
    m_num_threads_running = 0;
    m_app_info.clear();
@@ -245,6 +321,16 @@ void TraceManager::cleanup()
 TraceManager::~TraceManager()
 {
    cleanup();
+   // After cleanup(), the threads' readers have let go of the shared traces
+   for(std::map<String, SharedTrace*>::iterator it = m_shared_traces.begin(); it != m_shared_traces.end(); ++it)
+      delete it->second;
+   delete m_decode_cache;
+   // Writes out the instructions decoded during this run
+   if (m_static_db)
+      delete m_static_db;
+   if (m_page_allocator)
+      delete m_page_allocator;
+   // m_fiber_pool is not deleted: threads that are still blocked keep running on it until the process exits
 }
 
 void TraceManager::start()
@@ -291,6 +377,88 @@ void TraceManager::run()
    wait();
 }
 
+void TraceManager::saveCheckpoint(CheckpointWriter &ckpt)
+{
+   // Called at a barrier, while all threads are stopped. Not taking m_lock: a thread blocked in createThread holds it.
+   ckpt.put<UInt64>(Sim()->getClockSkewMinimizationServer()->getGlobalTime().getFS());
+   ckpt.put<UInt32>(m_num_apps);
+   ckpt.put<UInt32>(m_num_apps_nonfinish);
+   for(std::vector<app_info_t>::iterator it = m_app_info.begin(); it != m_app_info.end(); ++it)
+   {
+      ckpt.put<UInt32>(it->thread_count);
+      ckpt.put<UInt32>(it->num_threads);
+      ckpt.put<UInt32>(it->num_runs);
+   }
+
+   ckpt.put<UInt64>(m_threads.size());
+   for(size_t i = 0; i < m_threads.size(); ++i)
+   {
+      UInt64 icount, callbacks;
+      m_threads[i]->getResumePoint(icount, callbacks);
+      ckpt.put<SInt32>(m_threads[i]->getThread()->getAppId());
+      ckpt.put<UInt8>(m_thread_info[i].first);
+      ckpt.put<UInt8>(m_thread_info[i].init_fifo);
+      ckpt.put<UInt8>(m_threads[i]->m_stopped);
+      ckpt.put<UInt64>(icount);
+      ckpt.put<UInt64>(callbacks);
+   }
+}
+
+void TraceManager::loadCheckpoint(CheckpointReader &ckpt)
+{
+   UInt64 time_fs;
+   UInt32 num_apps, num_apps_nonfinish;
+   ckpt.get(time_fs);
+   ckpt.get(num_apps);
+   ckpt.get(num_apps_nonfinish);
+   LOG_ASSERT_ERROR(num_apps >= m_num_apps, "Checkpoint has %u applications, expected at least %u", num_apps, m_num_apps);
+
+   // Applications started through fork() come after the configured ones
+   m_num_apps = num_apps;
+   m_app_info.resize(m_num_apps);
+   std::vector<app_info_t> app_info(m_num_apps);
+   for(std::vector<app_info_t>::iterator it = app_info.begin(); it != app_info.end(); ++it)
+   {
+      ckpt.get(it->thread_count);
+      ckpt.get(it->num_threads);
+      ckpt.get(it->num_runs);
+   }
+
+   // Recreate threads in their original order, so they get the same thread ids
+   SubsecondTime time = SubsecondTime::FS(time_fs);
+   UInt64 num_threads;
+   ckpt.get(num_threads);
+   for(UInt64 i = 0; i < num_threads; ++i)
+   {
+      SInt32 app_id;
+      UInt8 first, init_fifo, stopped;
+      UInt64 icount, callbacks;
+      ckpt.get(app_id);
+      ckpt.get(first);
+      ckpt.get(init_fifo);
+      ckpt.get(stopped);
+      ckpt.get(icount);
+      ckpt.get(callbacks);
+
+      thread_id_t thread_id = newThread(app_id, first, init_fifo, false /*spawn*/, time, INVALID_THREAD_ID);
+      LOG_ASSERT_ERROR(thread_id == (thread_id_t)i, "Resumed thread %ld got thread id %d", i, thread_id);
+
+      TraceThread *tthread = m_threads.back();
+      if (stopped)
+      {
+         tthread->setResumePoint(0, 0, true /*finished*/);
+         // Finished threads are only started and ended again, they should not be counted a second time
+         tthread->m_stopped = true;
+         m_num_threads_running--;
+      }
+      else
+         tthread->setResumePoint(icount, callbacks, false /*finished*/);
+   }
+
+   m_app_info = app_info;
+   m_num_apps_nonfinish = num_apps_nonfinish;
+}
+
 UInt64 TraceManager::getProgressExpect()
 {
    return 1000000;
@@ -7,8 +7,16 @@
 #include "_thread.h"
 
 #include <vector>
+#include <map>
 
 class TraceThread;
+class DecodeCache;
+class StaticInstDatabase;
+class PageAllocator;
+class FiberPool;
+class CheckpointWriter;
+class CheckpointReader;
+class SharedTrace;
 
 class TraceManager
 {
@@ -38,24 +46,40 @@ class TraceManager
          UInt32 num_runs;           //< Number of completed runs
       };
 
+      struct thread_info_t
+      {
+         bool first;                //< First thread of its application (reads the application's trace file)
+         bool init_fifo;            //< Reads a per-thread trace file named after the trace prefix
+      };
+
       Monitor *m_monitor;
       std::vector<TraceThread *> m_threads;
+      std::vector<thread_info_t> m_thread_info; //< How each of m_threads was created, to recreate them when resuming
       UInt32 m_num_threads_started;
       UInt32 m_num_threads_running;
       Semaphore m_done;
       const bool m_stop_with_first_app;
       const bool m_app_restart;
       const bool m_emulate_syscalls;
+      const bool m_shm_transport;
+      const UInt64 m_shm_ring_size;
       UInt32 m_num_apps;
       UInt32 m_num_apps_nonfinish;  //< Number of applications that have yet to complete their first run
       std::vector<app_info_t> m_app_info;
       std::vector<String> m_tracefiles;
       std::vector<String> m_responsefiles;
       String m_trace_prefix;
+      DecodeCache *m_decode_cache;
+      StaticInstDatabase *m_static_db;  //< Decoded instructions persisted across runs (traceinput/static_db), or NULL
+      PageAllocator *m_page_allocator;
+      FiberPool *m_fiber_pool;
+      std::map<String, SharedTrace*> m_shared_traces; //< Trace files replayed by several applications, read only once
       Lock m_lock;
 
       String getFifoName(app_id_t app_id, UInt64 thread_num, bool response, bool create);
       thread_id_t newThread(app_id_t app_id, bool first, bool init_fifo, bool spawn, SubsecondTime time, thread_id_t creator_thread_id);
+      void loadCheckpoint(CheckpointReader &ckpt);
+      void setupSharedTraces();
 
       friend class Monitor;
 
@@ -78,8 +102,17 @@ class TraceManager
       void endFrontEnd(); //Ask all trace_threads to send signal to front-end to shutdown
       void accessMemory(int core_id, Core::lock_signal_t lock_signal, Core::mem_op_t mem_op_type, IntPtr d_addr, char* data_buffer, UInt32 data_size);
 
+      DecodeCache* getDecodeCache() { return m_decode_cache; }
+      StaticInstDatabase* getStaticInstDatabase() { return m_static_db; }
+      PageAllocator* getPageAllocator() { return m_page_allocator; }
+      FiberPool* getFiberPool() { return m_fiber_pool; }
+
       UInt64 getProgressExpect();
       UInt64 getProgressValue();
+
+      // Resume checkpoints (see CheckpointManager): applications, threads and their trace positions.
+      // When resuming, init() recreates all threads from the checkpoint instead of starting each application afresh.
+      void saveCheckpoint(CheckpointWriter &ckpt);
 };
 
 #endif // __TRACE_MANAGER_H
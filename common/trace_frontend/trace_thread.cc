@@ -1,5 +1,8 @@
 #include "trace_thread.h"
 #include "trace_manager.h"
+#include "decode_cache.h"
+#include "static_inst_db.h"
+#include "page_allocator.h"
 #include "simulator.h"
 #include "core_manager.h"
 #include "thread_manager.h"
@@ -19,14 +22,17 @@
 #include "sim_api.h"
 
 #include "stats.h"
+#include "warmup_sampler.h"
+#include "self_profiler.h"
+#include "fiber_pool.h"
+#include "host_topology.h"
+#include "deterministic_order.h"
 
 #include <unistd.h>
 #include <sys/syscall.h>
 
 #include <x86_decoder.h>  // TODO remove when the decode function in microop perf model is adapted
 
-int TraceThread::m_isa = 0;
-
 TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracefile, String responsefile, app_id_t app_id, bool cleanup)
    : m__thread(NULL)
    , m_thread(thread)
@@ -35,7 +41,10 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
    , m_trace_has_pa(false)
    , m_address_randomization(Sim()->getCfg()->getBool("traceinput/address_randomization"))
    , m_appid_from_coreid(Sim()->getCfg()->getString("scheduler/type") == "sequential" ? true : false)
+   , m_page_allocator(Sim()->getTraceManager()->getPageAllocator())
    , m_stop(false)
+   , m_decode_cache(Sim()->getTraceManager()->getDecodeCache())
+   , m_static_db(Sim()->getTraceManager()->getStaticInstDatabase())
    , m_bbv_base(0)
    , m_bbv_count(0)
    , m_bbv_last(0)
@@ -47,9 +56,29 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
    , m_blocked(false)
    , m_cleanup(cleanup)
    , m_started(false)
+   , m_branch_batch_size(Sim()->getCfg()->getInt("traceinput/branch_batch"))
+   , m_branch_lookahead(m_branch_batch_size > 2 ? m_branch_batch_size - 2 : 0)
+   , m_branch_batch_pos(0)
+   , m_branch_batch_core(NULL)
+   , m_cache_only_batch_size(Sim()->getCfg()->getInt("traceinput/cache_only_batch"))
+   , m_cache_only_batch_core(NULL)
+   , m_icount(0)
+   , m_callbacks(0)
+   , m_blocked_callbacks(0)
+   , m_resume_icount(0)
+   , m_resume_callbacks(0)
+   , m_resume_finished(false)
+   , m_skipping(false)
+   , m_restarted(false)
    , m_stopped(false)
 {
 
+   // Branch traces are written by Core::accessBranchPredictor, at the time each branch is executed
+   if (Sim()->getCfg()->getBool("branch_trace/enabled"))
+      m_branch_batch_size = 0;
+
+   m_cache_only_batch.reserve(m_cache_only_batch_size);
+
    m_trace.setHandleInstructionCountFunc(TraceThread::__handleInstructionCountFunc, this);
    m_trace.setHandleCacheOnlyFunc(TraceThread::__handleCacheOnlyFunc, this);
    if (Sim()->getCfg()->getBool("traceinput/mirror_output"))
@@ -62,6 +91,10 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
    m_trace.setHandleForkFunc(TraceThread::__handleForkFunc, this);
    if (Sim()->getRoutineTracer())
       m_trace.setHandleRoutineFunc(TraceThread::__handleRoutineChangeFunc, TraceThread::__handleRoutineAnnounceFunc, this);
+   if (Sim()->getCfg()->getBool("traceinput/prefetch"))
+      m_trace.setPrefetch(Sim()->getCfg()->getInt("traceinput/prefetch_buffers"), Sim()->getCfg()->getInt("traceinput/prefetch_buffer_size") * 1024);
+   if (Sim()->getCfg()->getBool("traceinput/mmap"))
+      m_trace.setMmap(true);
 
    if (m_address_randomization)
    {
@@ -78,6 +111,13 @@ TraceThread::TraceThread(Thread *thread, SubsecondTime time_start, String tracef
       }
    }
 
+   if (m_page_allocator)
+   {
+      UInt32 entries = Sim()->getCfg()->getInt("traceinput/page_allocator/translation_cache");
+      LOG_ASSERT_ERROR(entries && (entries & (entries - 1)) == 0, "traceinput/page_allocator/translation_cache must be a power of two");
+      m_translations.resize(entries, Translation{ ~UInt64(0), 0, 0 });
+   }
+
    thread->setVa2paFunc(_va2pa, (UInt64)this);
    
 }
@@ -90,10 +130,6 @@ TraceThread::~TraceThread()
       unlink(m_tracefile.c_str());
       unlink(m_responsefile.c_str());
    }
-   for(std::unordered_map<IntPtr, const dl::DecodedInst *>::iterator i = m_decoder_cache.begin() ; i != m_decoder_cache.end() ; ++i)
-   {
-      delete (*i).second;
-   }
 }
 
 UInt64 TraceThread::va2pa(UInt64 va, bool *noMapping)
@@ -129,7 +165,19 @@ UInt64 TraceThread::va2pa(UInt64 va, bool *noMapping)
         haddr = UInt64(m_thread->getAppId());
    }
 
-   if (m_address_randomization)
+   if (m_page_allocator)
+   {
+      UInt64 vpage = va >> va_page_shift;
+      Translation &entry = m_translations[vpage & (m_translations.size() - 1)];
+      if (entry.vpage != vpage || entry.process != haddr)
+      {
+         entry.vpage = vpage;
+         entry.process = haddr;
+         entry.ppage = m_page_allocator->translate(haddr, vpage, m_thread->getCore() ? m_thread->getCore()->getId() : INVALID_CORE_ID);
+      }
+      return (entry.ppage << va_page_shift) | (va & va_page_mask);
+   }
+   else if (m_address_randomization)
    {
       // Set 16 bits to app_id | remap middle 36 bits using app_id-specific mapping | keep lower 12 bits (page offset)
       return (haddr << pa_core_shift) | (remapAddress(va >> va_page_shift) << va_page_shift) | (va & va_page_mask);
@@ -197,6 +245,8 @@ void TraceThread::handleOutputFunc(uint8_t fd, const uint8_t *data, uint32_t siz
 
 uint64_t TraceThread::handleSyscallFunc(uint16_t syscall_number, const uint8_t *data, uint32_t size)
 {
+   flushCacheOnlyBatch();
+
    // We may have been blocked in a system call, if we start executing instructions again that means we're continuing
    if (m_blocked)
    {
@@ -204,6 +254,7 @@ uint64_t TraceThread::handleSyscallFunc(uint16_t syscall_number, const uint8_t *
    }
 
    LOG_ASSERT_ERROR(m_thread->getCore(), "Cannot execute while not on a core");
+   DeterministicOrder::Scope order(m_thread->getCore()->getId(), getCurrentTime());
    uint64_t ret = 0;
 
    switch(syscall_number)
@@ -223,6 +274,11 @@ uint64_t TraceThread::handleSyscallFunc(uint16_t syscall_number, const uint8_t *
          {
             ret = m_thread->getSyscallMdl()->runExit(ret);
          }
+         else
+         {
+            // A checkpoint taken while blocked resumes with this system call
+            m_blocked_callbacks = m_callbacks;
+         }
          break;
       }
    }
@@ -232,22 +288,34 @@ uint64_t TraceThread::handleSyscallFunc(uint16_t syscall_number, const uint8_t *
 
 int32_t TraceThread::handleNewThreadFunc()
 {
+   flushCacheOnlyBatch();
+
+   DeterministicOrder::Scope order(m_thread->getCore()->getId(), getCurrentTime());
    return Sim()->getTraceManager()->createThread(m_app_id, getCurrentTime(), m_thread->getId());
 }
 
 int32_t TraceThread::handleForkFunc()
 {
+   flushCacheOnlyBatch();
+
+   DeterministicOrder::Scope order(m_thread->getCore()->getId(), getCurrentTime());
    return Sim()->getTraceManager()->createApplication(getCurrentTime(), m_thread->getId());
 }
 
 int32_t TraceThread::handleJoinFunc(int32_t join_thread_id)
 {
+   flushCacheOnlyBatch();
+
+   DeterministicOrder::Scope order(m_thread->getCore()->getId(), getCurrentTime());
    Sim()->getThreadManager()->joinThread(m_thread->getId(), join_thread_id);
    return 0;
 }
 
 uint64_t TraceThread::handleMagicFunc(uint64_t a, uint64_t b, uint64_t c)
 {
+   flushCacheOnlyBatch();
+
+   DeterministicOrder::Scope order(m_thread->getCore()->getId(), getCurrentTime());
    return handleMagicInstruction(m_thread->getId(), a, b, c);
 }
 
@@ -271,6 +339,8 @@ void TraceThread::handleRoutineChangeFunc(Sift::RoutineOpType event, uint64_t ei
 
 bool TraceThread::handleEmuFunc(Sift::EmuType type, Sift::EmuRequest &req, Sift::EmuReply &res)
 {
+   flushCacheOnlyBatch();
+
    // We may have been blocked in a system call, if we start executing instructions again that means we're continuing
    if (m_blocked)
    {
@@ -375,26 +445,27 @@ SubsecondTime TraceThread::getCurrentTime() const
    return m_thread->getCore()->getPerformanceModel()->getElapsedTime();
 }
 
-Instruction* TraceThread::decode(Sift::Instruction &inst)
+const DecodeCache::Decoded& TraceThread::getDecodedInst(Sift::Instruction &inst)
 {
+   return *m_decode_cache->getDecoded(DecodeCache::Key(inst, 0, false), [&]() { return staticDecode(inst); });
+}
 
-   //printf("PC: %lx Size: %d num_addresses=%d is_branch=%d\n", inst.sinst->addr, inst.sinst->size, inst.num_addresses, inst.is_branch);
-   if (m_decoder_cache.count(inst.sinst->addr) == 0)
-      m_decoder_cache[inst.sinst->addr] = staticDecode(inst);
-   
-   const dl::DecodedInst& dec_inst = *(m_decoder_cache[inst.sinst->addr]);
+Instruction* TraceThread::decode(Sift::Instruction &inst, const DecodeCache::Decoded &decoded, IntPtr pa)
+{
+   const dl::DecodedInst &dec_inst = *decoded.dec_inst;
 
+   //printf("PC: %lx Size: %d num_addresses=%d is_branch=%d\n", inst.sinst->addr, inst.sinst->size, inst.num_addresses, inst.is_branch);
    OperandList list;
 
    // Ignore memory-referencing operands in NOP instructions
    if (!(dec_inst.is_nop()))
    {
-      for(uint32_t mem_idx = 0; mem_idx < Sim()->getDecoder()->num_memory_operands(&dec_inst); ++mem_idx)
-         if (Sim()->getDecoder()->op_read_mem(&dec_inst, mem_idx))
+      for(uint32_t mem_idx = 0; mem_idx < decoded.numMemoryOperands(); ++mem_idx)
+         if (decoded.opReadMem(mem_idx))
             list.push_back(Operand(Operand::MEMORY, 0, Operand::READ));
 
-      for(uint32_t mem_idx = 0; mem_idx < Sim()->getDecoder()->num_memory_operands(&dec_inst); ++mem_idx)
-         if (Sim()->getDecoder()->op_write_mem(&dec_inst, mem_idx))
+      for(uint32_t mem_idx = 0; mem_idx < decoded.numMemoryOperands(); ++mem_idx)
+         if (decoded.opWriteMem(mem_idx))
             list.push_back(Operand(Operand::MEMORY, 0, Operand::WRITE));
    }
 
@@ -405,12 +476,22 @@ Instruction* TraceThread::decode(Sift::Instruction &inst)
    else
       instruction = new GenericInstruction(list);
 
-   instruction->setAddress(va2pa(inst.sinst->addr));
+   instruction->setAddress(pa);
    instruction->setSize(inst.sinst->size);
    instruction->setAtomic(dec_inst.is_atomic());
    instruction->setDisassembly(dec_inst.disassembly_to_str().c_str());
    
-   const std::vector<const MicroOp*> *uops = InstructionDecoder::decode(inst.sinst->addr, &dec_inst, instruction);
+   const std::vector<const MicroOp*> *uops;
+   if (decoded.stored)
+   {
+      uops = m_static_db->getMicroOps(decoded, instruction);
+   }
+   else
+   {
+      uops = InstructionDecoder::decode(inst.sinst->addr, &dec_inst, instruction);
+      if (m_static_db)
+         m_static_db->record(DecodeCache::Key(inst, 0, false), decoded, uops);
+   }
    instruction->setMicroOps(uops);
 
    return instruction;
@@ -418,6 +499,8 @@ Instruction* TraceThread::decode(Sift::Instruction &inst)
 
 Sift::Mode TraceThread::handleInstructionCountFunc(uint32_t icount)
 {
+   flushCacheOnlyBatch();
+
    if (!m_started)
    {
       // Received first instruction, let TraceManager know our SIFT connection is up and running
@@ -451,6 +534,11 @@ Sift::Mode TraceThread::handleInstructionCountFunc(uint32_t icount)
       core->getPerformanceModel()->queuePseudoInstruction(new SyncInstruction(time, SyncInstruction::UNSCHEDULED));
    }
 
+   return getSiftMode();
+}
+
+Sift::Mode TraceThread::getSiftMode()
+{
    switch(Sim()->getInstrumentationMode())
    {
       case InstMode::FAST_FORWARD:
@@ -492,50 +580,81 @@ void TraceThread::handleCacheOnlyFunc(uint8_t icount, Sift::CacheOnlyType type,
 
       case Sift::CacheOnlyMemRead:
       case Sift::CacheOnlyMemWrite:
-         core->accessMemory(
-               Core::NONE,
-               type == Sift::CacheOnlyMemRead ? Core::READ : Core::WRITE,
-               va2pa(address),
-               NULL,
-               4,
-               Core::MEM_MODELED_COUNT,
-               va2pa(eip));
+         if (m_cache_only_batch_size)
+         {
+            if (core != m_cache_only_batch_core)
+               flushCacheOnlyBatch();
+            m_cache_only_batch.push_back({ type == Sift::CacheOnlyMemRead ? Core::READ : Core::WRITE, va2pa(address), va2pa(eip) });
+            m_cache_only_batch_core = core;
+            if (m_cache_only_batch.size() >= m_cache_only_batch_size)
+               flushCacheOnlyBatch();
+         }
+         else
+         {
+            core->accessMemory(
+                  Core::NONE,
+                  type == Sift::CacheOnlyMemRead ? Core::READ : Core::WRITE,
+                  va2pa(address),
+                  NULL,
+                  4,
+                  Core::MEM_MODELED_COUNT,
+                  va2pa(eip));
+         }
          break;
 
       case Sift::CacheOnlyMemIcache:
          if (Sim()->getConfig()->getEnableICacheModeling())
+         {
+            // Keep the order of instruction and data fetches into the shared levels
+            flushCacheOnlyBatch();
             core->readInstructionMemory(va2pa(eip), address);
+         }
          break;
    }
 }
 
-const dl::DecodedInst* TraceThread::staticDecode(Sift::Instruction &inst)
+void TraceThread::flushCacheOnlyBatch()
 {
+   if (m_cache_only_batch.empty())
+      return;
+
+   m_cache_only_batch_core->warmMemoryBatch(m_cache_only_batch.data(), m_cache_only_batch.size());
+   m_cache_only_batch.clear();
+}
+
+DecodeCache::Decoded TraceThread::staticDecode(Sift::Instruction &inst)
+{
+   if (m_static_db)
+   {
+      const DecodeCache::Decoded *stored = m_static_db->find(DecodeCache::Key(inst, 0, false));
+      if (stored)
+         return *stored;
+   }
+
    dl::DecodedInst *dec_inst = m_factory->CreateInstruction(Sim()->getDecoder(), inst.sinst->data, 
                                                             inst.sinst->size, inst.sinst->addr);
    Sim()->getDecoder()->decode(dec_inst, (dl::dl_isa)inst.isa);
-   return dec_inst;
+   return DecodeCache::Decoded::fromDecoder(Sim()->getDecoder(), dec_inst);
 }
 
 void TraceThread::handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruction &next_inst, Core *core, bool do_icache_warmup, UInt64 icache_warmup_addr, UInt64 icache_warmup_size)
 {
-   if (m_decoder_cache.count(inst.sinst->addr) == 0)
-      m_decoder_cache[inst.sinst->addr] = staticDecode(inst);
-   
-   const dl::DecodedInst &dec_inst = *(m_decoder_cache[inst.sinst->addr]);
+   const DecodeCache::Decoded &decoded = getDecodedInst(inst);
 
    // Warmup instruction caches
 
    if (do_icache_warmup && Sim()->getConfig()->getEnableICacheModeling())
    {
-      core->readInstructionMemory(va2pa(icache_warmup_addr), icache_warmup_size);
+      core->readInstructionBlock(va2pa(icache_warmup_addr), icache_warmup_size);
    }
 
    // Warmup branch predictor
 
    if (inst.is_branch)
    {
-      bool mispredict = core->accessBranchPredictor(va2pa(inst.sinst->addr), inst.taken, dec_inst.is_indirect_branch(), va2pa(next_inst.sinst->addr));
+      bool mispredict = m_branch_batch_size
+         ? predictBranchBatched(inst, next_inst, core, decoded.isIndirectBranch())
+         : core->accessBranchPredictor(va2pa(inst.sinst->addr), inst.taken, decoded.isIndirectBranch(), va2pa(next_inst.sinst->addr));
       if (mispredict)
          core->getPerformanceModel()->handleBranchMispredict();
    }
@@ -544,23 +663,25 @@ void TraceThread::handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruc
 
    if (inst.executed)
    {
-      const bool is_atomic_update = dec_inst.is_atomic();
-      const bool is_prefetch = dec_inst.is_prefetch();
+      const bool is_atomic_update = decoded.isAtomic();
+      const bool is_prefetch = decoded.isPrefetch();
+      // Only warm the sampled last-level cache sets, if enabled
+      WarmupSampler *warmup_sampler = Sim()->getWarmupSampler();
 
       // Ignore memory-referencing operands in NOP instructions
-      if (!dec_inst.is_nop())
+      if (!decoded.isNop())
       {
-         for(uint32_t mem_idx = 0; mem_idx <  Sim()->getDecoder()->num_memory_operands(&dec_inst); ++mem_idx)
+         for(uint32_t mem_idx = 0; mem_idx < decoded.numMemoryOperands(); ++mem_idx)
          {
-            if (Sim()->getDecoder()->op_read_mem(&dec_inst, mem_idx))
+            if (decoded.opReadMem(mem_idx))
             {
                UInt64 mem_address;
                // LDP ARM instructions, second element to be loaded, using the address of the first element
-               if (dec_inst.is_mem_pair() && ((int)mem_idx == (inst.num_addresses + 1)))  
+               if (decoded.isMemPair() && ((int)mem_idx == (inst.num_addresses + 1)))  
                {
                   LOG_ASSERT_ERROR((int)mem_idx < (inst.num_addresses + 1), "Did not receive enough data addresses");
                   
-                  mem_address = inst.addresses[mem_idx - 1] + Sim()->getDecoder()->size_mem_op(&dec_inst, mem_idx);
+                  mem_address = inst.addresses[mem_idx - 1] + decoded.sizeMemOp(mem_idx);
                }
                else
                {
@@ -574,28 +695,34 @@ void TraceThread::handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruc
                if (no_mapping)
                   continue;
 
+               if (warmup_sampler && !warmup_sampler->isSampled(pa))
+               {
+                  warmup_sampler->notifySkipped();
+                  continue;
+               }
+
                core->accessMemory(
                      /*(is_atomic_update) ? Core::LOCK :*/ Core::NONE,
                      (is_atomic_update) ? Core::READ_EX : Core::READ,
                      pa,
                      NULL,
-                     Sim()->getDecoder()->size_mem_op(&dec_inst, mem_idx),
+                     decoded.sizeMemOp(mem_idx),
                      Core::MEM_MODELED_COUNT,
                      va2pa(inst.sinst->addr));
             }
          }
 
-         for(uint32_t mem_idx = 0; mem_idx < Sim()->getDecoder()->num_memory_operands(&dec_inst); ++mem_idx)
+         for(uint32_t mem_idx = 0; mem_idx < decoded.numMemoryOperands(); ++mem_idx)
          {
-            if (Sim()->getDecoder()->op_write_mem(&dec_inst, mem_idx))
+            if (decoded.opWriteMem(mem_idx))
             {
                UInt64 mem_address;
                // STP ARM instructions, second element to be stored, using the address of the first element
-               if (dec_inst.is_mem_pair() && ((int)mem_idx == (inst.num_addresses + 1)))  
+               if (decoded.isMemPair() && ((int)mem_idx == (inst.num_addresses + 1)))  
                {
                   LOG_ASSERT_ERROR((int)mem_idx < (inst.num_addresses + 1), "Did not receive enough data addresses");
                   
-                  mem_address = inst.addresses[mem_idx - 1] + Sim()->getDecoder()->size_mem_op(&dec_inst, mem_idx);
+                  mem_address = inst.addresses[mem_idx - 1] + decoded.sizeMemOp(mem_idx);
                }
                else
                {
@@ -609,6 +736,12 @@ void TraceThread::handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruc
                if (no_mapping)
                   continue;
 
+               if (warmup_sampler && !warmup_sampler->isSampled(pa))
+               {
+                  warmup_sampler->notifySkipped();
+                  continue;
+               }
+
                if (is_atomic_update)
                   core->logMemoryHit(false, Core::WRITE, pa, Core::MEM_MODELED_COUNT, va2pa(inst.sinst->addr));
                else
@@ -617,7 +750,7 @@ void TraceThread::handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruc
                         Core::WRITE,
                         pa,
                         NULL,
-                        Sim()->getDecoder()->size_mem_op(&dec_inst, mem_idx),
+                        decoded.sizeMemOp(mem_idx),
                         Core::MEM_MODELED_COUNT,
                         va2pa(inst.sinst->addr));
             }
@@ -626,50 +759,123 @@ void TraceThread::handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruc
    }
 }
 
+bool TraceThread::predictBranchBatched(Sift::Instruction &inst, Sift::Instruction &next_inst, Core *core, bool indirect)
+{
+   IntPtr ip = va2pa(inst.sinst->addr);
+   if (m_branch_batch_pos < m_branch_batch.size() && m_branch_batch_core == core)
+   {
+      const BranchPredictor::Branch &branch = m_branch_batch[m_branch_batch_pos++];
+      LOG_ASSERT_ERROR(branch.ip == ip && branch.taken == inst.taken, "Batched branch prediction out of sync with the trace");
+      return branch.mispredict;
+   }
+
+   BranchPredictor *bp = core->getPerformanceModel()->getBranchPredictor();
+   if (!bp)
+      return false;
+
+   // Start a new batch with this branch, followed by the ones still ahead of us in the current basic-block run.
+   // Our next instruction has already been read, if it is a branch its target is the next one the reader returns.
+   m_branch_batch.clear();
+   m_branch_batch.push_back({ ip, va2pa(next_inst.sinst->addr), inst.taken, indirect, false });
+   if (m_branch_batch_size > 1)
+   {
+      uint64_t next_addr = 0;
+      size_t count = m_trace.peekBranches(m_branch_lookahead.data(), m_branch_lookahead.size(), next_addr);
+      if (next_inst.is_branch)
+      {
+         if (next_addr)
+            m_branch_batch.push_back({ va2pa(next_inst.sinst->addr), va2pa(next_addr), next_inst.taken, getDecodedInst(next_inst).isIndirectBranch(), false });
+         else
+            count = 0;
+      }
+      for(size_t i = 0; i < count; ++i)
+      {
+         Sift::Instruction peek_inst;
+         peek_inst.sinst = m_branch_lookahead[i].sinst;
+         peek_inst.isa = inst.isa;
+         m_branch_batch.push_back({ va2pa(peek_inst.sinst->addr), va2pa(m_branch_lookahead[i].target), m_branch_lookahead[i].taken, getDecodedInst(peek_inst).isIndirectBranch(), false });
+      }
+   }
+
+   bp->predictAndUpdate(m_branch_batch.data(), m_branch_batch.size());
+   m_branch_batch_pos = 1;
+   m_branch_batch_core = core;
+   return m_branch_batch[0].mispredict;
+}
+
 void TraceThread::handleInstructionDetailed(Sift::Instruction &inst, Sift::Instruction &next_inst, PerformanceModel *prfmdl)
 {
 
    // Set up instruction
 
-   if (m_icache.count(inst.sinst->addr) == 0)
-      m_icache[inst.sinst->addr] = decode(inst);
-   // Here get the decoder instruction without checking, because we must have it for sure
-   const dl::DecodedInst &dec_inst = *(m_decoder_cache[inst.sinst->addr]);
+   IntPtr pa = va2pa(inst.sinst->addr);
+   const DecodeCache::Entry *entry = m_decode_cache->getInstruction(DecodeCache::Key(inst, pa, true), [&]() {
+      const DecodeCache::Decoded &decoded = getDecodedInst(inst);
+      DecodeCache::Entry new_entry = { decode(inst, decoded, pa), &decoded };
+      return new_entry;
+   });
+   const DecodeCache::Decoded &decoded = *entry->decoded;
 
-   Instruction *ins = m_icache[inst.sinst->addr];
-   DynamicInstruction *dynins = prfmdl->createDynamicInstruction(ins, va2pa(inst.sinst->addr));
+   Instruction *ins = entry->instruction;
 
-   // Add dynamic instruction info
+   // Collect dynamic instruction info
 
+   DynamicInstruction::BranchInfo branch_info = { false, false, false, 0 };
    if (inst.is_branch)
    {
-      dynins->addBranch(inst.taken, va2pa(next_inst.sinst->addr), dec_inst.is_indirect_branch());
+      branch_info.is_branch = true;
+      branch_info.is_indirect = decoded.isIndirectBranch();
+      branch_info.taken = inst.taken;
+      branch_info.target = va2pa(next_inst.sinst->addr);
    }
 
    // Ignore memory-referencing operands in NOP instructions
-   if (!dec_inst.is_nop())
+   UInt8 max_memory = 0;
+   if (!decoded.isNop())
    {
-      const bool is_prefetch = dec_inst.is_prefetch();
+      for(uint32_t mem_idx = 0; mem_idx < decoded.numMemoryOperands(); ++mem_idx)
+         max_memory += decoded.opReadMem(mem_idx) + decoded.opWriteMem(mem_idx);
+   }
+
+   // Models that need no DynamicInstruction (one-IPC) simulate the instruction right away, from a stack copy.
+   // Otherwise the memory operands are written straight into the DynamicInstruction record.
+   DynamicInstruction::MemoryInfo direct_memory_info[2 * DecodeCache::Decoded::MAX_MEMORY_OPERANDS];
+   DynamicInstruction *dynins = prfmdl->hasDirectPath() ? NULL : prfmdl->createDynamicInstruction(ins, pa, max_memory);
+   DynamicInstruction::MemoryInfo *memory_info = dynins ? dynins->memory_info : direct_memory_info;
+   UInt8 num_memory = 0;
 
-      for(uint32_t mem_idx = 0; mem_idx < Sim()->getDecoder()->num_memory_operands(&dec_inst); ++mem_idx)
+   if (max_memory)
+   {
+      const bool is_prefetch = decoded.isPrefetch();
+
+      for(uint32_t mem_idx = 0; mem_idx < decoded.numMemoryOperands(); ++mem_idx)
       {
-         if (Sim()->getDecoder()->op_read_mem(&dec_inst, mem_idx))
+         if (decoded.opReadMem(mem_idx))
          {
-            addDetailedMemoryInfo(dynins, inst, dec_inst, mem_idx, Operand::READ, is_prefetch, prfmdl);
+            addDetailedMemoryInfo(memory_info, num_memory, inst, decoded, mem_idx, Operand::READ, is_prefetch);
          }
       }
 
-      for(uint32_t mem_idx = 0; mem_idx < Sim()->getDecoder()->num_memory_operands(&dec_inst); ++mem_idx)
+      for(uint32_t mem_idx = 0; mem_idx < decoded.numMemoryOperands(); ++mem_idx)
       {
-         if (Sim()->getDecoder()->op_write_mem(&dec_inst, mem_idx))
+         if (decoded.opWriteMem(mem_idx))
          {
-            addDetailedMemoryInfo(dynins, inst, dec_inst, mem_idx, Operand::WRITE, is_prefetch, prfmdl);
+            addDetailedMemoryInfo(memory_info, num_memory, inst, decoded, mem_idx, Operand::WRITE, is_prefetch);
          }
       }
    }
 
+   if (!dynins)
+   {
+      prfmdl->iterateDirect(ins, pa, branch_info, memory_info, num_memory);
+      return;
+   }
+
    // Push instruction
 
+   dynins->branch_info = branch_info;
+   dynins->num_memory = num_memory;
+
    prfmdl->queueInstruction(dynins);
 
    // simulate
@@ -677,14 +883,14 @@ void TraceThread::handleInstructionDetailed(Sift::Instruction &inst, Sift::Instr
    prfmdl->iterate();
 }
 
-void TraceThread::addDetailedMemoryInfo(DynamicInstruction *dynins, Sift::Instruction &inst, const dl::DecodedInst &decoded_inst, uint32_t mem_idx, Operand::Direction op_type, bool is_prefetch, PerformanceModel *prfmdl)
+void TraceThread::addDetailedMemoryInfo(DynamicInstruction::MemoryInfo *memory_info, UInt8 &num_memory, Sift::Instruction &inst, const DecodeCache::Decoded &decoded, uint32_t mem_idx, Operand::Direction op_type, bool is_prefetch)
 {
    UInt64 mem_address;
    // LDP/STP ARM instructions, second element to be ld/st, using the address of the first element
-   if (decoded_inst.is_mem_pair() && ((int)mem_idx == inst.num_addresses))  
+   if (decoded.isMemPair() && ((int)mem_idx == inst.num_addresses))  
    {
       assert((int)mem_idx < (inst.num_addresses + 1));
-      mem_address = inst.addresses[mem_idx - 1] + Sim()->getDecoder()->size_mem_op(&decoded_inst, mem_idx);
+      mem_address = inst.addresses[mem_idx - 1] + decoded.sizeMemOp(mem_idx);
    }
    else
    {
@@ -695,28 +901,14 @@ void TraceThread::addDetailedMemoryInfo(DynamicInstruction *dynins, Sift::Instru
    bool no_mapping = false;
    UInt64 pa = va2pa(mem_address, is_prefetch ? &no_mapping : NULL);
 
-   if (no_mapping)
-   {
-      dynins->addMemory(
-         inst.executed,
-         SubsecondTime::Zero(),
-         0,
-         Sim()->getDecoder()->size_mem_op(&decoded_inst, mem_idx),
-         op_type,
-         0,
-         HitWhere::PREFETCH_NO_MAPPING);
-   }
-   else
-   {
-      dynins->addMemory(
-         inst.executed,
-         SubsecondTime::Zero(),
-         pa,
-         Sim()->getDecoder()->size_mem_op(&decoded_inst, mem_idx),
-         op_type,
-         0,
-         HitWhere::UNKNOWN);
-   }
+   DynamicInstruction::MemoryInfo &info = memory_info[num_memory++];
+   info.executed = inst.executed;
+   info.dir = op_type;
+   info.latency = SubsecondTime::Zero();
+   info.addr = no_mapping ? 0 : pa;
+   info.size = decoded.sizeMemOp(mem_idx);
+   info.num_misses = 0;
+   info.hit_where = no_mapping ? HitWhere::PREFETCH_NO_MAPPING : HitWhere::UNKNOWN;
 }
 
 void TraceThread::unblock()
@@ -724,6 +916,7 @@ void TraceThread::unblock()
    LOG_ASSERT_ERROR(m_blocked == true, "Must call only when m_blocked == true");
 
    SubsecondTime end_time = Sim()->getClockSkewMinimizationServer()->getGlobalTime(true /*upper_bound*/);
+   DeterministicOrder::Scope order(m_thread->getCore()->getId(), getCurrentTime());
    m_thread->getSyscallMdl()->runExit(0);
    {
       ScopedLock sl(Sim()->getThreadManager()->getLock());
@@ -749,6 +942,8 @@ void TraceThread::unblock()
 
 void TraceThread::run()
 {
+   SELF_PROFILE(FRONTEND);
+
    // Set thread name for Sniper-in-Sniper simulations
    String threadName = String("trace-") + itostr(m_thread->getId());
    SimSetThreadName(threadName.c_str());
@@ -756,8 +951,31 @@ void TraceThread::run()
    Sim()->getThreadManager()->onThreadStart(m_thread->getId(), m_time_start);
 
    // Open the trace (be sure to do this before potentially blocking on reschedule() as this causes deadlock)
-   m_trace.initStream();
-   m_trace_has_pa = m_trace.getTraceHasPhysicalAddresses();
+   if (!m_resume_finished)
+   {
+      if (!m_restarted)
+         m_trace.initStream();
+      m_trace_has_pa = m_trace.getTraceHasPhysicalAddresses();
+   }
+
+   // Skip ahead to the block containing the requested start instruction (block-compressed traces only)
+   UInt64 start_icount = Sim()->getCfg()->getInt("traceinput/start_icount");
+   if (m_resume_icount && !m_resume_finished)
+   {
+      // Resuming from a checkpoint: seek close to the resume point when the trace has a block index,
+      // else read through the trace from the start
+      uint64_t actual = 0;
+      if (m_trace.Seek(m_resume_icount, &actual))
+         m_icount = actual;
+   }
+   else if (start_icount)
+   {
+      uint64_t actual = 0;
+      bool seek_ok = m_trace.Seek(start_icount, &actual);
+      LOG_ASSERT_ERROR(seek_ok, "Cannot start trace %s at instruction %ld, it has no block index (record it with block compression)", m_tracefile.c_str(), start_icount);
+      printf("[TRACE:%u] Starting at instruction %" PRIu64 "\n", m_thread->getId(), actual);
+      m_icount = actual;
+   }
 
    if (m_thread->getCore() == NULL)
    {
@@ -768,13 +986,33 @@ void TraceThread::run()
 
    Core *core = m_thread->getCore();
    PerformanceModel *prfmdl = core->getPerformanceModel();
+   Sim()->getHostTopology()->bindThread(core->getId());
 
    Sift::Instruction inst, next_inst;
 
-   bool have_first = m_trace.Read(inst);
+   // A thread that had already ended when the checkpoint was taken only goes through start and exit
+   bool have_first = m_resume_finished ? false : m_trace.Read(inst);
+
+   if (m_resume_icount || m_resume_callbacks)
+   {
+      // Read up to the instruction that was being handled when the checkpoint was taken, suppressing all callbacks,
+      // then suppress the callbacks that were handled after it (skipCallback)
+      m_skipping = true;
+      while(have_first && m_icount < m_resume_icount)
+      {
+         have_first = m_trace.Read(inst);
+         ++m_icount;
+      }
+      m_skipping = false;
+      m_callbacks = 0;
+      printf("[TRACE:%u] Resuming at instruction %" PRIu64 "\n", m_thread->getId(), m_icount);
+   }
 
    while(have_first && m_trace.Read(next_inst))
    {
+      // Cache-only records read along with this instruction
+      flushCacheOnlyBatch();
+
       if (!m_started)
       {
          // Received first instructions, let TraceManager know our SIFT connection is up and running
@@ -819,6 +1057,7 @@ void TraceThread::run()
       switch(Sim()->getInstrumentationMode())
       {
          case InstMode::FAST_FORWARD:
+            m_branch_batch.clear();
             break;
 
          case InstMode::CACHE_ONLY:
@@ -826,6 +1065,8 @@ void TraceThread::run()
             break;
 
          case InstMode::DETAILED:
+            // Branches predicted ahead of a mode change have already trained the predictor, just drop their outcomes
+            m_branch_batch.clear();
             handleInstructionDetailed(inst, next_inst, prfmdl);
             break;
 
@@ -842,6 +1083,8 @@ void TraceThread::run()
       {
          core = m_thread->getCore();
          prfmdl = core->getPerformanceModel();
+         // Follow the core to its host node
+         Sim()->getHostTopology()->bindThread(core->getId());
       }
 
 
@@ -849,19 +1092,61 @@ void TraceThread::run()
          break;
 
       inst = next_inst;
+      ++m_icount;
+      m_callbacks = 0;
    }
 
+   flushCacheOnlyBatch();
+
    printf("[TRACE:%u] -- %s --\n", m_thread->getId(), m_stop ? "STOP" : "DONE");
 
    SubsecondTime time_end = prfmdl->getElapsedTime();
 
-   Sim()->getThreadManager()->onThreadExit(m_thread->getId());
+   {
+      DeterministicOrder::Scope order(m_thread->getCore()->getId(), time_end);
+      Sim()->getThreadManager()->onThreadExit(m_thread->getId());
+   }
    Sim()->getTraceManager()->signalDone(this, time_end, m_stop /*aborted*/);
 }
 
+bool TraceThread::restartFrom(TraceThread *finished)
+{
+   // finished has returned from its last call into the reader (signalDone), so its trace can be taken over
+   m_restarted = m_trace.Restart(finished->m_trace);
+   return m_restarted;
+}
+
+bool TraceThread::skipCallback()
+{
+   if (m_skipping)
+      return true;
+   if (m_resume_callbacks)
+   {
+      // Already handled before the checkpoint
+      --m_resume_callbacks;
+      ++m_callbacks;
+      return true;
+   }
+   return false;
+}
+
+void TraceThread::getResumePoint(UInt64 &icount, UInt64 &callbacks) const
+{
+   icount = m_icount;
+   callbacks = m_blocked ? m_blocked_callbacks : m_callbacks;
+}
+
+void TraceThread::setResumePoint(UInt64 icount, UInt64 callbacks, bool finished)
+{
+   m_resume_icount = icount;
+   m_resume_callbacks = callbacks;
+   m_resume_finished = finished;
+}
+
 void TraceThread::spawn()
 {
-   m__thread = _Thread::create(this);
+   FiberPool *fiber_pool = Sim()->getTraceManager()->getFiberPool();
+   m__thread = fiber_pool ? fiber_pool->createThread(this) : _Thread::create(this);
    m__thread->run();
 }
 
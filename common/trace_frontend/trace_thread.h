@@ -6,13 +6,14 @@
 #include "thread.h"
 #include "core.h"
 #include "sift_reader.h"
+#include "branch_predictor.h"
 #include "operand.h"
+#include "dynamic_instruction.h"
+#include "decode_cache.h"
 #include "sem.h"
 
 #include <decoder.h>
 
-#include <unordered_map>
-
 #define NUM_PAPI_COUNTERS 6
 
 #define PAPI_TOT_INS 0
@@ -24,6 +25,8 @@
 
 class Instruction;
 class DynamicInstruction;
+class StaticInstDatabase;
+class PageAllocator;
 
 class TraceThread : public Runnable
 {
@@ -54,14 +57,22 @@ class TraceThread : public Runnable
       bool m_address_randomization;
       bool m_appid_from_coreid;
       uint8_t m_address_randomization_table[256];
+      // With [traceinput/page_allocator], recent translations of this thread, direct mapped on the virtual page
+      struct Translation
+      {
+         UInt64 vpage;
+         UInt64 process;
+         UInt64 ppage;
+      };
+      PageAllocator *m_page_allocator;
+      std::vector<Translation> m_translations;
       bool m_stop;
-      std::unordered_map<IntPtr, Instruction *> m_icache;
-      std::unordered_map<IntPtr, const dl::DecodedInst *> m_decoder_cache;
+      DecodeCache *m_decode_cache;
+      StaticInstDatabase *m_static_db;
       UInt64 m_bbv_base;
       UInt64 m_bbv_count;
       UInt64 m_bbv_last;
       bool m_bbv_end;
-      static int m_isa;
       uint8_t m_output_leftover[160];
       uint16_t m_output_leftover_size;
       String m_tracefile;
@@ -70,33 +81,62 @@ class TraceThread : public Runnable
       bool m_blocked;
       bool m_cleanup;
       bool m_started;
+      // Cache-only warmup: branches of the current basic-block run predicted ahead of time (traceinput/branch_batch)
+      UInt32 m_branch_batch_size;
+      std::vector<Sift::BranchOutcome> m_branch_lookahead;
+      std::vector<BranchPredictor::Branch> m_branch_batch;
+      UInt32 m_branch_batch_pos;
+      Core *m_branch_batch_core;
+      // Cache-only records: data accesses buffered and sent to the memory hierarchy in one call (traceinput/cache_only_batch)
+      UInt32 m_cache_only_batch_size;
+      std::vector<Core::CacheOnlyAccess> m_cache_only_batch;
+      Core *m_cache_only_batch_core;
+
+      // Resume checkpoints: m_icount is the trace position of the instruction being handled, m_callbacks the number of
+      // reader callbacks (records between it and the next instruction) handled since. When resuming, everything up to the
+      // saved point is read but not simulated. A thread blocked in a system call saves the point before that call,
+      // so the call is re-issued on resume and rebuilds the futex/sleep state.
+      UInt64 m_icount;
+      UInt64 m_callbacks;
+      UInt64 m_blocked_callbacks;
+      UInt64 m_resume_icount;
+      UInt64 m_resume_callbacks;
+      bool m_resume_finished;
+      bool m_skipping;
+      bool m_restarted;
+
+      bool skipCallback();
+      template <typename T> T callbackDone(T ret) { ++m_callbacks; return ret; }
 
       void run();
       static Sift::Mode __handleInstructionCountFunc(void* arg, uint32_t icount)
-      { return ((TraceThread*)arg)->handleInstructionCountFunc(icount); }
+      { TraceThread *self = (TraceThread*)arg; return self->skipCallback() ? self->getSiftMode() : self->callbackDone(self->handleInstructionCountFunc(icount)); }
       static void __handleCacheOnlyFunc(void* arg, uint8_t icount, Sift::CacheOnlyType type, uint64_t eip, uint64_t address)
-      { ((TraceThread*)arg)->handleCacheOnlyFunc(icount, type, eip, address); }
+      { TraceThread *self = (TraceThread*)arg; if (!self->skipCallback()) { self->handleCacheOnlyFunc(icount, type, eip, address); ++self->m_callbacks; } }
       static void __handleOutputFunc(void* arg, uint8_t fd, const uint8_t *data, uint32_t size)
-      { ((TraceThread*)arg)->handleOutputFunc(fd, data, size); }
+      { TraceThread *self = (TraceThread*)arg; if (!self->skipCallback()) { self->handleOutputFunc(fd, data, size); ++self->m_callbacks; } }
       static uint64_t __handleSyscallFunc(void* arg, uint16_t syscall_number, const uint8_t *data, uint32_t size)
-      { return ((TraceThread*)arg)->handleSyscallFunc(syscall_number, data, size); }
+      { TraceThread *self = (TraceThread*)arg; return self->skipCallback() ? 0 : self->callbackDone(self->handleSyscallFunc(syscall_number, data, size)); }
       static int32_t __handleNewThreadFunc(void* arg)
-      { return ((TraceThread*)arg)->handleNewThreadFunc(); }
+      { TraceThread *self = (TraceThread*)arg; return self->skipCallback() ? 0 : self->callbackDone(self->handleNewThreadFunc()); }
       static int32_t __handleJoinFunc(void* arg, int32_t join_thread_id)
-      { return ((TraceThread*)arg)->handleJoinFunc(join_thread_id); }
+      { TraceThread *self = (TraceThread*)arg; return self->skipCallback() ? 0 : self->callbackDone(self->handleJoinFunc(join_thread_id)); }
       static uint64_t __handleMagicFunc(void* arg, uint64_t a, uint64_t b, uint64_t c)
-      { return ((TraceThread*)arg)->handleMagicFunc(a, b, c); }
+      { TraceThread *self = (TraceThread*)arg; return self->skipCallback() ? 0 : self->callbackDone(self->handleMagicFunc(a, b, c)); }
       static bool __handleEmuFunc(void* arg, Sift::EmuType type, Sift::EmuRequest &req, Sift::EmuReply &res)
-      { return ((TraceThread*)arg)->handleEmuFunc(type, req, res); }
+      { TraceThread *self = (TraceThread*)arg; return self->skipCallback() ? false : self->callbackDone(self->handleEmuFunc(type, req, res)); }
       static void __handleRoutineChangeFunc(void* arg, Sift::RoutineOpType event, uint64_t eip, uint64_t esp, uint64_t callEip)
-      { ((TraceThread*)arg)->handleRoutineChangeFunc(event, eip, esp, callEip); }
+      { TraceThread *self = (TraceThread*)arg; if (!self->skipCallback()) { self->handleRoutineChangeFunc(event, eip, esp, callEip); ++self->m_callbacks; } }
+      // Routine announcements are not skipped when resuming, the routine tracer of the new run needs all of them
       static void __handleRoutineAnnounceFunc(void* arg, uint64_t eip, const char *name, const char *imgname, uint64_t offset, uint32_t line, uint32_t column, const char *filename)
       { ((TraceThread*)arg)->handleRoutineAnnounceFunc(eip, name, imgname, offset, line, column, filename); }
       static int32_t __handleForkFunc(void* arg)
-      { return ((TraceThread*)arg)->handleForkFunc();}
+      { TraceThread *self = (TraceThread*)arg; return self->skipCallback() ? 0 : self->callbackDone(self->handleForkFunc()); }
 
       Sift::Mode handleInstructionCountFunc(uint32_t icount);
+      Sift::Mode getSiftMode();
       void handleCacheOnlyFunc(uint8_t icount, Sift::CacheOnlyType type, uint64_t eip, uint64_t address);
+      void flushCacheOnlyBatch();
       void handleOutputFunc(uint8_t fd, const uint8_t *data, uint32_t size);
       uint64_t handleSyscallFunc(uint16_t syscall_number, const uint8_t *data, uint32_t size);
       int32_t handleNewThreadFunc();
@@ -107,16 +147,18 @@ class TraceThread : public Runnable
       void handleRoutineChangeFunc(Sift::RoutineOpType event, uint64_t eip, uint64_t esp, uint64_t callEip);
       void handleRoutineAnnounceFunc(uint64_t eip, const char *name, const char *imgname, uint64_t offset, uint32_t line, uint32_t column, const char *filename);
 
-      Instruction* decode(Sift::Instruction &inst);
+      Instruction* decode(Sift::Instruction &inst, const DecodeCache::Decoded &decoded, IntPtr pa);
+      const DecodeCache::Decoded& getDecodedInst(Sift::Instruction &inst);
       void handleInstructionWarmup(Sift::Instruction &inst, Sift::Instruction &next_inst, Core *core, bool do_icache_warmup, UInt64 icache_warmup_addr, UInt64 icache_warmup_size);
+      bool predictBranchBatched(Sift::Instruction &inst, Sift::Instruction &next_inst, Core *core, bool indirect);
       void handleInstructionDetailed(Sift::Instruction &inst, Sift::Instruction &next_inst, PerformanceModel *prfmdl);
-      void addDetailedMemoryInfo(DynamicInstruction *dynins, Sift::Instruction &inst, const dl::DecodedInst &decoded_inst, uint32_t mem_idx, Operand::Direction op_type, bool is_pretetch, PerformanceModel *prfmdl);
+      void addDetailedMemoryInfo(DynamicInstruction::MemoryInfo *memory_info, UInt8 &num_memory, Sift::Instruction &inst, const DecodeCache::Decoded &decoded, uint32_t mem_idx, Operand::Direction op_type, bool is_prefetch);
       void unblock();
 
       SubsecondTime getCurrentTime() const;
       
       dl::DecoderFactory *m_factory;  // we need a factory here to be able to create instructions of any kind
-      const dl::DecodedInst* staticDecode(Sift::Instruction &inst);
+      DecodeCache::Decoded staticDecode(Sift::Instruction &inst);
 
       long long *m_papi_counters;
       
@@ -134,7 +176,16 @@ class TraceThread : public Runnable
       UInt64 getProgressExpect();
       UInt64 getProgressValue();
       Thread* getThread() const { return m_thread; }
+      // Read the trace from a reader shared with the other copies of the same trace, set before the thread is spawned
+      void setSharedTrace(SharedTrace *shared) { m_trace.setShared(shared); }
+      // Restarting an application ([traceinput] restart_apps): replay the trace <finished> has just completed,
+      // reusing its open trace and the static instructions it has read. Set before the thread is spawned.
+      bool restartFrom(TraceThread *finished);
       void handleAccessMemory(Core::lock_signal_t lock_signal, Core::mem_op_t mem_op_type, IntPtr d_addr, char* data_buffer, UInt32 data_size);
+
+      // Resume checkpoints (see CheckpointManager), the resume point is set before the thread is spawned
+      void getResumePoint(UInt64 &icount, UInt64 &callbacks) const;
+      void setResumePoint(UInt64 icount, UInt64 callbacks, bool finished);
 };
 
 #endif // __TRACE_THREAD_H
@@ -0,0 +1,90 @@
+#include "buffer_pool.h"
+#include "log.h"
+
+#include <stdlib.h>
+
+BufferPool::ThreadCache::ThreadCache()
+{
+   for(UInt32 size_class = 0; size_class < NUM_SIZE_CLASSES; ++size_class)
+   {
+      head[size_class] = NULL;
+      count[size_class] = 0;
+   }
+}
+
+BufferPool::ThreadCache::~ThreadCache()
+{
+   for(UInt32 size_class = 0; size_class < NUM_SIZE_CLASSES; ++size_class)
+   {
+      while (head[size_class])
+      {
+         FreeBuffer *next = head[size_class]->next;
+         ::free(head[size_class]);
+         head[size_class] = next;
+      }
+   }
+}
+
+BufferPool::ThreadCache& BufferPool::getThreadCache()
+{
+   static thread_local ThreadCache cache;
+   return cache;
+}
+
+UInt32 BufferPool::getSizeClass(UInt32 size)
+{
+   for(UInt32 size_class = 0; size_class < NUM_SIZE_CLASSES; ++size_class)
+      if (size <= (1u << (MIN_SIZE_SHIFT + size_class)) - HEADER_SIZE)
+         return size_class;
+   return UNPOOLED;
+}
+
+Byte* BufferPool::alloc(UInt32 size)
+{
+   UInt32 size_class = getSizeClass(size);
+   Byte *block = NULL;
+
+   if (size_class != UNPOOLED)
+   {
+      ThreadCache &cache = getThreadCache();
+      if (cache.head[size_class])
+      {
+         block = (Byte*)cache.head[size_class];
+         cache.head[size_class] = cache.head[size_class]->next;
+         --cache.count[size_class];
+      }
+      else
+         block = (Byte*)malloc(1u << (MIN_SIZE_SHIFT + size_class));
+   }
+   else
+      block = (Byte*)malloc(size + HEADER_SIZE);
+
+   LOG_ASSERT_ERROR(block != NULL, "Could not allocate %u byte buffer", size);
+
+   *(UInt32*)block = size_class;
+   return block + HEADER_SIZE;
+}
+
+void BufferPool::free(Byte *buffer)
+{
+   if (buffer == NULL)
+      return;
+
+   Byte *block = buffer - HEADER_SIZE;
+   UInt32 size_class = *(UInt32*)block;
+
+   if (size_class != UNPOOLED)
+   {
+      ThreadCache &cache = getThreadCache();
+      if (cache.count[size_class] < MAX_CACHED)
+      {
+         FreeBuffer *free_buffer = (FreeBuffer*)block;
+         free_buffer->next = cache.head[size_class];
+         cache.head[size_class] = free_buffer;
+         ++cache.count[size_class];
+         return;
+      }
+   }
+
+   ::free(block);
+}
@@ -0,0 +1,39 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include "fixed_types.h"
+
+// Size-class pool for short-lived message buffers that are allocated on one thread and
+// usually freed on another (sender allocates, receiver frees). Each thread keeps a bounded
+// cache of free buffers per size class, so the common case takes no locks and no malloc.
+// Buffers larger than the biggest size class go straight to malloc/free.
+
+class BufferPool
+{
+public:
+   static Byte* alloc(UInt32 size);
+   static void free(Byte *buffer);
+
+private:
+   static const UInt32 MIN_SIZE_SHIFT = 6;      // 64 bytes
+   static const UInt32 NUM_SIZE_CLASSES = 7;    // up to 4 KB
+   static const UInt32 MAX_CACHED = 256;        // per size class, per thread
+   static const UInt32 HEADER_SIZE = 16;        // keeps the payload 16-byte aligned
+   static const UInt32 UNPOOLED = NUM_SIZE_CLASSES;
+
+   struct FreeBuffer { FreeBuffer *next; };
+
+   struct ThreadCache
+   {
+      FreeBuffer *head[NUM_SIZE_CLASSES];
+      UInt32 count[NUM_SIZE_CLASSES];
+
+      ThreadCache();
+      ~ThreadCache();
+   };
+
+   static ThreadCache& getThreadCache();
+   static UInt32 getSizeClass(UInt32 size);
+};
+
+#endif // BUFFER_POOL_H
@@ -0,0 +1,263 @@
+#include <string.h>
+
+#include "ringtransport.h"
+#include "buffer_pool.h"
+#include "simulator.h"
+#include "config.h"
+#include "config.hpp"
+#include "log.h"
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <algorithm>
+
+// -- RingTransport -- //
+
+RingTransport::RingTransport()
+   : m_ring_size(Sim()->getCfg()->getInt("transport/ring/size"))
+   , m_max_spin(Sim()->getCfg()->getInt("transport/ring/spin"))
+{
+   LOG_ASSERT_ERROR(m_ring_size >= 2 && (m_ring_size & (m_ring_size - 1)) == 0, "transport/ring/size must be a power of two, got %u", m_ring_size);
+
+   m_global_node = new RingNode(-1, this);
+   m_core_nodes = new RingNode* [ Config::getSingleton()->getTotalCores() ];
+   for (UInt32 i = 0; i < Config::getSingleton()->getTotalCores(); i++)
+      m_core_nodes[i] = NULL;
+}
+
+RingTransport::~RingTransport()
+{
+   // The networks actually delete the Transport::Nodes, so we
+   // shouldn't do it ourselves.
+   delete [] m_core_nodes;
+   delete m_global_node;
+}
+
+Transport::Node* RingTransport::createNode(core_id_t core_id)
+{
+   LOG_ASSERT_ERROR((UInt32)core_id < Config::getSingleton()->getTotalCores(),
+                    "Request index out of range: %d", core_id);
+   LOG_ASSERT_ERROR(m_core_nodes[core_id] == NULL,
+                    "Transport already allocated for id: %d.", core_id);
+
+   m_core_nodes[core_id] = new RingNode(core_id, this);
+
+   LOG_PRINT("Created node: %p on id: %d", m_core_nodes[core_id], core_id);
+
+   return m_core_nodes[core_id];
+}
+
+void RingTransport::barrier()
+{
+   // We assume a single process, so this is a NOOP
+}
+
+Transport::Node* RingTransport::getGlobalNode()
+{
+   return m_global_node;
+}
+
+Byte* RingTransport::allocBuffer(UInt32 size)
+{
+   return BufferPool::alloc(size);
+}
+
+void RingTransport::freeBuffer(Byte *buffer)
+{
+   BufferPool::free(buffer);
+}
+
+RingTransport::RingNode* RingTransport::getNodeFromId(core_id_t core_id)
+{
+   LOG_ASSERT_ERROR((UInt32)core_id < Config::getSingleton()->getTotalCores(),
+                    "Core id out of range: %d", core_id);
+   return m_core_nodes[core_id];
+}
+
+void RingTransport::clearNodeForId(core_id_t core_id)
+{
+   if ((UInt32)core_id < Config::getSingleton()->getTotalCores())
+      m_core_nodes[core_id] = NULL;
+}
+
+// -- RingTransportNode -- //
+
+RingTransport::RingNode::RingNode(core_id_t core_id, RingTransport *rt)
+   : Node(core_id)
+   , m_rt(rt)
+   , m_cells(new Cell[rt->m_ring_size])
+   , m_mask(rt->m_ring_size - 1)
+   , m_enqueue_pos(0)
+   , m_dequeue_pos(0)
+   , m_overflowed(false)
+   , m_waiting(false)
+   , m_futx(0)
+   , m_spin_count(rt->m_max_spin)
+{
+   for (UInt64 i = 0; i <= m_mask; ++i)
+   {
+      m_cells[i].sequence.store(i, std::memory_order_relaxed);
+      m_cells[i].data = NULL;
+   }
+}
+
+RingTransport::RingNode::~RingNode()
+{
+   LOG_ASSERT_WARNING(!query(), "Unread messages in queue for core: %d", getCoreId());
+   m_rt->clearNodeForId(getCoreId());
+   delete [] m_cells;
+}
+
+void RingTransport::RingNode::globalSend(SInt32 dest_proc, const void *buffer, UInt32 length)
+{
+   LOG_ASSERT_ERROR(dest_proc == 0, "Destination other than zero: %d", dest_proc);
+   send((RingNode*)m_rt->getGlobalNode(), buffer, length);
+}
+
+void RingTransport::RingNode::send(SInt32 dest_id, const void* buffer, UInt32 length)
+{
+   RingNode *dest_node = m_rt->getNodeFromId(dest_id);
+   LOG_ASSERT_ERROR(dest_node != NULL, "Attempt to send to non-existent node: %d", dest_id);
+   send(dest_node, buffer, length);
+}
+
+void RingTransport::RingNode::send(RingNode *dest_node, const void *buffer, UInt32 length)
+{
+   Byte *data = BufferPool::alloc(length);
+   memcpy(data, buffer, length);
+
+   LOG_PRINT("sending msg -- size: %i, data: %p, dest: %p", length, data, dest_node);
+
+   dest_node->push(data);
+   dest_node->wakeUp();
+}
+
+void RingTransport::RingNode::sendBuffer(SInt32 dest_id, Byte* buffer, UInt32 length)
+{
+   RingNode *dest_node = m_rt->getNodeFromId(dest_id);
+   LOG_ASSERT_ERROR(dest_node != NULL, "Attempt to send to non-existent node: %d", dest_id);
+
+   LOG_PRINT("sending msg -- size: %i, data: %p, dest: %p", length, buffer, dest_node);
+
+   dest_node->push(buffer);
+   dest_node->wakeUp();
+}
+
+void RingTransport::RingNode::push(Byte *data)
+{
+   if (!m_overflowed.load(std::memory_order_acquire))
+   {
+      UInt64 pos = m_enqueue_pos.load(std::memory_order_relaxed);
+      while (true)
+      {
+         Cell *cell = &m_cells[pos & m_mask];
+         SInt64 diff = (SInt64)cell->sequence.load(std::memory_order_acquire) - (SInt64)pos;
+         if (diff == 0)
+         {
+            if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+               cell->data = data;
+               cell->sequence.store(pos + 1, std::memory_order_release);
+               return;
+            }
+         }
+         else if (diff < 0)
+            break; // Full
+         else
+            pos = m_enqueue_pos.load(std::memory_order_relaxed);
+      }
+   }
+
+   // Ring is full (or was recently): the consumer only looks at the overflow queue once the ring is empty
+   ScopedLock sl(m_overflow_lock);
+   m_overflow.push_back(data);
+   m_overflowed.store(true, std::memory_order_release);
+}
+
+Byte* RingTransport::RingNode::pop()
+{
+   Cell *cell = &m_cells[m_dequeue_pos & m_mask];
+   if (cell->sequence.load(std::memory_order_acquire) == m_dequeue_pos + 1)
+   {
+      Byte *data = cell->data;
+      cell->sequence.store(m_dequeue_pos + m_mask + 1, std::memory_order_release);
+      ++m_dequeue_pos;
+      return data;
+   }
+
+   if (m_overflowed.load(std::memory_order_acquire))
+   {
+      ScopedLock sl(m_overflow_lock);
+      if (!m_overflow.empty())
+      {
+         Byte *data = m_overflow.front();
+         m_overflow.pop_front();
+         if (m_overflow.empty())
+            m_overflowed.store(false, std::memory_order_release);
+         return data;
+      }
+   }
+
+   return NULL;
+}
+
+void RingTransport::RingNode::wakeUp()
+{
+   // Pairs with the fence in recv(): either the consumer sees our message, or we see it waiting
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   if (m_waiting.load(std::memory_order_relaxed))
+   {
+      m_futx.fetch_add(1, std::memory_order_relaxed);
+      syscall(SYS_futex, (void*) &m_futx, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, 1, NULL, NULL, 0);
+   }
+}
+
+Byte* RingTransport::RingNode::recv()
+{
+   LOG_PRINT("attempting recv -- this: %p", this);
+
+   while (true)
+   {
+      // Spin first: with many cores exchanging messages, the next one usually arrives quickly
+      for (UInt32 spin = 0; spin < m_spin_count; ++spin)
+      {
+         Byte *data = pop();
+         if (data)
+         {
+            // Spinning paid off, allow spinning a bit longer next time
+            m_spin_count = std::min(2 * m_spin_count + 1, m_rt->m_max_spin);
+            LOG_PRINT("msg recv'd -- data: %p, this: %p", data, this);
+            return data;
+         }
+         if ((spin & 63) == 63)
+            sched_yield();
+      }
+
+      int futx = m_futx.load(std::memory_order_relaxed);
+      m_waiting.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      Byte *data = pop();
+      if (data)
+      {
+         m_waiting.store(false, std::memory_order_relaxed);
+         LOG_PRINT("msg recv'd -- data: %p, this: %p", data, this);
+         return data;
+      }
+
+      syscall(SYS_futex, (void*) &m_futx, FUTEX_WAIT | FUTEX_PRIVATE_FLAG, futx, NULL, NULL, 0);
+      m_waiting.store(false, std::memory_order_relaxed);
+
+      // We had to sleep, spinning is not helping much right now
+      m_spin_count /= 2;
+   }
+}
+
+bool RingTransport::RingNode::query()
+{
+   const Cell *cell = &m_cells[m_dequeue_pos & m_mask];
+   return cell->sequence.load(std::memory_order_acquire) == m_dequeue_pos + 1
+      || m_overflowed.load(std::memory_order_acquire);
+}
@@ -0,0 +1,83 @@
+#ifndef RINGTRANSPORT_H
+#define RINGTRANSPORT_H
+
+#include <atomic>
+#include <deque>
+
+#include "transport.h"
+#include "lock.h"
+
+// Shared-memory transport where every node receives through a bounded lock-free
+// multi-producer single-consumer ring. Message buffers come from BufferPool, and
+// receivers spin for a while (adaptively) before going to sleep on a futex.
+
+class RingTransport : public Transport
+{
+public:
+   RingTransport();
+   ~RingTransport();
+
+   class RingNode : public Node
+   {
+   public:
+      RingNode(core_id_t core_id, RingTransport *rt);
+      ~RingNode();
+
+      void globalSend(SInt32, const void*, UInt32);
+      void send(core_id_t, const void*, UInt32);
+      void sendBuffer(core_id_t, Byte*, UInt32);
+      Byte* recv();
+      bool query();
+
+   private:
+      struct Cell
+      {
+         std::atomic<UInt64> sequence;
+         Byte *data;
+      };
+
+      void send(RingNode *dest, const void *buffer, UInt32 length);
+      void push(Byte *data);
+      Byte* pop();
+      void wakeUp();
+
+      RingTransport *m_rt;
+
+      // Vyukov-style bounded queue: producers claim slots by CAS on m_enqueue_pos,
+      // the single consumer owns m_dequeue_pos
+      Cell *m_cells;
+      const UInt64 m_mask;
+      alignas(64) std::atomic<UInt64> m_enqueue_pos;
+      alignas(64) UInt64 m_dequeue_pos;
+
+      // Used only when the ring is full. While it is non-empty, all producers go here
+      // too so messages from a given sender stay in order.
+      alignas(64) std::atomic<bool> m_overflowed;
+      std::deque<Byte*> m_overflow;
+      Lock m_overflow_lock;
+
+      // Sleeping consumer
+      alignas(64) std::atomic<bool> m_waiting;
+      std::atomic<int> m_futx;
+      UInt32 m_spin_count;
+   };
+
+   Node* createNode(core_id_t core_id);
+
+   void barrier();
+   Node* getGlobalNode();
+
+   Byte* allocBuffer(UInt32 size);
+   void freeBuffer(Byte *buffer);
+
+private:
+   Node *m_global_node;
+   RingNode **m_core_nodes;
+   const UInt32 m_ring_size;
+   const UInt32 m_max_spin;
+
+   RingNode *getNodeFromId(core_id_t core_id);
+   void clearNodeForId(core_id_t core_id);
+};
+
+#endif
@@ -93,15 +93,30 @@ void SmTransport::SmNode::send(SInt32 dest_id, const void* buffer, UInt32 length
 
 void SmTransport::SmNode::send(SmNode *dest_node, const void *buffer, UInt32 length)
 {
-   Byte *data = new Byte[length];
+   Byte *data = m_smt->allocBuffer(length);
    memcpy(data, buffer, length);
 
    LOG_PRINT("sending msg -- size: %i, data: %p, dest: %p", length, data, dest_node);
 
-   dest_node->m_lock.acquire();
-   dest_node->m_queue.push(data);
-   dest_node->m_lock.release();
-   dest_node->m_cond.broadcast();
+   dest_node->push(data);
+}
+
+void SmTransport::SmNode::sendBuffer(SInt32 dest_id, Byte* buffer, UInt32 length)
+{
+   SmNode *dest_node = m_smt->getNodeFromId(dest_id);
+   LOG_ASSERT_ERROR(dest_node != NULL, "Attempt to send to non-existent node: %d", dest_id);
+
+   LOG_PRINT("sending msg -- size: %i, data: %p, dest: %p", length, buffer, dest_node);
+
+   dest_node->push(buffer);
+}
+
+void SmTransport::SmNode::push(Byte *data)
+{
+   m_lock.acquire();
+   m_queue.push(data);
+   m_lock.release();
+   m_cond.broadcast();
 }
 
 Byte* SmTransport::SmNode::recv()
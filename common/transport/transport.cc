@@ -4,6 +4,9 @@
 
 #include "transport.h"
 #include "smtransport.h"
+#include "ringtransport.h"
+#include "simulator.h"
+#include "config.hpp"
 
 #include "config.h"
 #include "log.h"
@@ -20,7 +23,13 @@ Transport* Transport::create()
 {
    assert(m_singleton == NULL);
 
-   m_singleton = new SmTransport();
+   String type = Sim()->getCfg()->getString("transport/type");
+   if (type == "sm")
+      m_singleton = new SmTransport();
+   else if (type == "ring")
+      m_singleton = new RingTransport();
+   else
+      LOG_PRINT_ERROR("Unknown transport type %s", type.c_str());
 
    return m_singleton;
 }
@@ -37,6 +46,12 @@ Transport::Node::Node(core_id_t core_id)
 {
 }
 
+void Transport::Node::sendBuffer(core_id_t dest, Byte *buffer, UInt32 length)
+{
+   send(dest, buffer, length);
+   Transport::getSingleton()->freeBuffer(buffer);
+}
+
 core_id_t Transport::Node::getCoreId()
 {
    return m_core_id;
@@ -17,6 +17,8 @@ public:
 
       virtual void globalSend(SInt32 dest_proc, const void *buffer, UInt32 length) = 0;
       virtual void send(core_id_t dest, const void *buffer, UInt32 length) = 0;
+      // Zero-copy send: <buffer> must come from Transport::allocBuffer(), ownership passes to the receiver
+      virtual void sendBuffer(core_id_t dest, Byte *buffer, UInt32 length);
       virtual Byte* recv() = 0;
       virtual bool query() = 0;
 
@@ -36,6 +38,10 @@ public:
    virtual void barrier() = 0;
    virtual Node* getGlobalNode() = 0; // for communication not linked to a core
 
+   // Buffers passed to Node::send() or returned by Node::recv() must be allocated and freed through these
+   virtual Byte* allocBuffer(UInt32 size) { return new Byte[size]; }
+   virtual void freeBuffer(Byte *buffer) { delete [] buffer; }
+
 protected:
    Transport();
 
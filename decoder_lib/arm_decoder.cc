@@ -106,6 +106,38 @@ void ARMDecoder::decode(DecodedInst * inst, dl_isa isa)
   inst->set_already_decoded(true);
 }
 
+DecodedBlock * ARMDecoder::decode_block(const uint8_t * code, size_t size, uint64_t addr, dl_isa isa,
+                                        unsigned int max_insts)
+{
+  TDecodedBlock<ARMDecodedInst> * block = new TDecodedBlock<ARMDecodedInst>(max_insts);
+  csh handle = (isa == DL_ISA_THUMB) ? m_handle_aux : m_handle;
+  ARMDecodedInst * inst;
+  
+  while(size > 0 && (inst = block->append(this, code, size, addr)))
+  {
+    // cs_disasm_iter advances code, size and addr past the decoded instruction
+    const uint8_t * inst_code = code;
+    uint64_t inst_addr = addr;
+    if (!cs_disasm_iter(handle, &code, &size, &addr, inst->get_capstone_inst()))
+    {
+      block->remove_last();
+      break;
+    }
+    
+    inst->get_code() = inst_code;
+    inst->get_size() = code - inst_code;
+    inst->get_address() = inst_addr;
+    inst->set_already_decoded(true);
+    inst->set_disassembly();
+    block->add_size(code - inst_code);
+    
+    if (is_branch_opcode(inst->inst_num_id()))
+      break;
+  }
+  
+  return block;
+}
+
 void ARMDecoder::change_isa_mode(dl_isa new_isa)
 {
   if (new_isa != this->m_isa)
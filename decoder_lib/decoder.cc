@@ -58,6 +58,15 @@ uint64_t & DecodedInst::get_address()
   return m_address;
 }
 
+// DecodedBlock
+
+DecodedBlock::~DecodedBlock() {}
+
+size_t DecodedBlock::get_size() const
+{
+  return m_size;
+}
+
 // DecoderFactory
   
 Decoder *DecoderFactory::CreateDecoder(dl_arch arch, dl_mode mode, dl_syntax syntax)
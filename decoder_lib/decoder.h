@@ -4,6 +4,7 @@
 #include <string>
 #include <cassert>
 #include <cstdint>
+#include <vector>
 
 namespace dl
 {
@@ -44,6 +45,7 @@ typedef enum dl_isa {
 } dl_isa;
   
 class DecodedInst;
+class DecodedBlock;
   
 class Decoder
 {
@@ -58,6 +60,12 @@ class Decoder
     virtual ~Decoder();  // dtor
     virtual void decode(DecodedInst * inst) = 0;  // pure virtual method; implement in subclass
     virtual void decode(DecodedInst * inst, dl_isa isa) = 0;
+
+    /// Decode a basic block: the consecutive instructions in code (size bytes, the first one at address addr),
+    /// up to and including the first branch. Stops early after max_insts instructions, at the end of the buffer
+    /// or at bytes that do not decode. The returned block refers to code, which must outlive it.
+    virtual DecodedBlock * decode_block(const uint8_t * code, size_t size, uint64_t addr, dl_isa isa,
+                                        unsigned int max_insts) = 0;
     
     /// Change the ISA mode to new_mode
     virtual void change_isa_mode(dl_isa new_isa) = 0;
@@ -258,6 +266,59 @@ class DecodedInst
     std::string m_disassembly;
 };
 
+/// Instructions decoded by Decoder::decode_block
+class DecodedBlock
+{
+  public:
+    virtual ~DecodedBlock();
+    
+    /// Get the number of instructions in the block
+    virtual unsigned int num_insts() const = 0;
+    
+    /// Get instruction idx of the block
+    virtual DecodedInst * get_inst(unsigned int idx) = 0;
+    
+    /// Get the size in bytes of all instructions in the block
+    size_t get_size() const;
+    
+  protected:
+    /// Code size of the instructions in the block
+    size_t m_size;
+};
+
+/// DecodedBlock of a specific DecodedInst type, stored in one contiguous array
+template <class T> class TDecodedBlock : public DecodedBlock
+{
+  public:
+    TDecodedBlock(unsigned int max_insts)
+    {
+      // Never reallocate: instructions may own resources that must not be copied
+      m_insts.reserve(max_insts);
+      m_size = 0;
+    }
+    
+    virtual unsigned int num_insts() const override { return m_insts.size(); }
+    virtual DecodedInst * get_inst(unsigned int idx) override { return &m_insts[idx]; }
+    
+    /// Add a new (not yet decoded) instruction to the block, returns NULL if the block is full
+    T * append(Decoder * d, const uint8_t * code, size_t size, uint64_t addr)
+    {
+      if (m_insts.size() == m_insts.capacity())
+        return NULL;
+      m_insts.emplace_back(d, code, size, addr);
+      return &m_insts.back();
+    }
+    
+    /// Remove the last instruction again, when it failed to decode
+    void remove_last() { m_insts.pop_back(); }
+    
+    /// Account for the size of the last instruction once it was decoded
+    void add_size(size_t size) { m_size += size; }
+    
+  private:
+    std::vector<T> m_insts;
+};
+
 class DecoderFactory
 {
   public:
@@ -6,6 +6,7 @@
 #include <cstdio>
 #include <cstdarg>
 #include <alloca.h>
+#include <algorithm>
 // Instead of linking to the rv8 binaries, compile the data directly into this object
 #include "asm/meta.cc"
 #include "asm/format.cc"
@@ -84,28 +85,168 @@ const char* reg_name_sym[] = {
       nullptr
     };
 
+/// Get the number of memory operands of instructions with this format
+static unsigned int format_num_memory_operands(const char *format)
+{
+  unsigned int num_memory_operands = 0;
+  if (format == rv_fmt_rd_offset_rs1  /* lb, lh, lw, lbu, lhu, lwu, ld, ldu, lq, c.lwsp, c.ld, c.ldsp, c.lq, c.lqsp */
+    || format == rv_fmt_frd_offset_rs1 /* flw, fld, flq, c.fld, c.flw, c.fldsp, c.flwsp */
+    || format == rv_fmt_rs2_offset_rs1  /* sb, sh, sw, sd, sq, c.sw, c.swsp, c.sd, c.sdsp, c.sq, c.sqsp */
+    || format == rv_fmt_frs2_offset_rs1  /* fsw, fsd, fsq, c.fsd, c.fsw, c.fsdsp, c.fswsp */
+    || format == rv_fmt_aqrl_rd_rs2_rs1 /* amoswap.w */
+    || format == rv_fmt_aqrl_rd_rs2_rs1 /* amoswap.d */ 
+    || format == rv_fmt_aqrl_rd_rs2_rs1 /* amoswap.q */) {
+     num_memory_operands++;
+  }
+  return num_memory_operands;
+}
+
+/// Check if instructions with this format read from memory
+static bool format_read_mem(const char *format)
+{
+  // if operation is a load, we must be reading from memory
+  bool res = false;
+  if (format == rv_fmt_rd_offset_rs1  /* lb, lh, lw, lbu, lhu, lwu, ld, ldu, lq, c.lwsp, c.ld, c.ldsp, c.lq, c.lqsp */
+    || format == rv_fmt_frd_offset_rs1 /* flw, fld, flq, c.fld, c.flw, c.fldsp, c.flwsp */ ) {
+     res = true; 
+  }
+  return res;
+}
+
+/// Check if instructions with this format write to memory
+static bool format_write_mem(const char *format)
+{
+  // if this operation is a store, we must be writing to memory
+  bool res = false;
+  if (format == rv_fmt_rs2_offset_rs1  /* sb, sh, sw, sd, sq, c.sw, c.swsp, c.sd, c.sdsp, c.sq, c.sqsp */
+    || format == rv_fmt_frs2_offset_rs1  /* fsw, fsd, fsq, c.fsd, c.fsw, c.fsdsp, c.fswsp */ ) {
+     res = true;
+  }
+  return res;
+}
+
+/// Get the size in bytes of the memory operand of this opcode
+static unsigned int opcode_size_mem_op(unsigned int op)
+{
+  unsigned int size = 0;
+  switch(op) {
+    case rv_op_lb: 			/* Load Byte */
+    case rv_op_lbu: 		/* Load Byte Unsigned */
+    case rv_op_flw: 		/* FP Load (SP) */
+    case rv_op_sb: 			/* Store Byte */
+    case rv_op_fsw: 		/* FP Store (SP) */
+    case rv_op_lr_w: 	 	/* Load Reserved Word */
+    case rv_op_sc_w: 		/* Store Conditional Word */
+                        size = 1;
+                        break;
+    case rv_op_lh: 			/* Load Half */
+    case rv_op_lhu: 		/* Load Half Unsigned */
+    case rv_op_sh: 			/* Store Half */
+                        size = 2;
+                        break;
+    case rv_op_lw: 			/* Load Word */
+    case rv_op_lwu: 		/* Load Word Unsigned */
+    case rv_op_sw: 			/* Store Word */
+                        size = 4;
+                        break;
+    case rv_op_ld: 			/* Load Double */
+    case rv_op_fld: 		/* FP Load (DP) */
+    case rv_op_sd: 			/* Store Double */
+    case rv_op_fsd: 		/* FP Store (DP) */
+    case rv_op_lr_d: 		/* Load Reserved Double Word */
+    case rv_op_sc_d: 		/* Store Conditional Double Word */
+                        size = 8;
+                        break;
+  }
+  return size;
+}
+
+/// Check if the opcode is a division instruction
+static bool opcode_is_div(unsigned int opcd)
+{
+  bool res = false;
+  switch(opcd) {
+    case rv_op_div:
+    case rv_op_divu:
+    case rv_op_divw:
+    case rv_op_divuw:
+    case rv_op_divd:
+    case rv_op_divud:
+      res = true; break;
+  }
+  return res;
+}
+
+/// Check if the opcode is a branch instruction
+static bool opcode_is_branch(unsigned int opcd)
+{
+  bool res = false;
+  switch(opcd) {
+    case rv_op_beq:		/* Branch Equal */
+    case rv_op_bne:		/* Branch Not Equal */
+    case rv_op_blt:		/* Branch Less Than */
+    case rv_op_bge:		/* Branch Greater than Equal */
+    case rv_op_bltu:	/* Branch Less Than Unsigned */
+    case rv_op_bgeu:	/* Branch Greater than Equal Unsigned */
+    case rv_op_beqz:	/* Branch if = zero */
+    case rv_op_bnez:	/* Branch if ≠ zero */
+    case rv_op_blez:	/* Branch if ≤ zero */
+    case rv_op_bgez:	/* Branch if ≥ zero */
+    case rv_op_bltz:	/* Branch if < zero */
+    case rv_op_bgtz:	/* Branch if > zero */
+    case rv_op_ble:
+    case rv_op_bleu:
+    case rv_op_bgt:
+    case rv_op_bgtu:
+      res = true; break;
+  }
+  return res;
+}
+
 RISCVDecoder::RISCVDecoder(dl_arch arch, dl_mode mode, dl_syntax syntax)
 {
   this->m_arch = arch;
   this->m_mode = mode;
   this->m_syntax = syntax;
   this->m_isa = DL_ISA_RISCV;
+
+  // Classify every opcode once, so the per-instruction queries are a lookup into m_op_info
+  m_num_ops = sizeof(rv_inst_format) / sizeof(rv_inst_format[0]);
+  m_op_info = new op_info[m_num_ops + 1];
+  for (unsigned int op = 0; op < m_num_ops; op++)
+  {
+    const char *format = rv_inst_format[op];
+    m_op_info[op].num_memory_operands = format_num_memory_operands(format);
+    m_op_info[op].size_mem_op = opcode_size_mem_op(op);
+    m_op_info[op].read_mem = format_read_mem(format);
+    m_op_info[op].write_mem = format_write_mem(format);
+    m_op_info[op].is_branch = opcode_is_branch(op);
+    m_op_info[op].is_div = opcode_is_div(op);
+  }
+  // Returned for out-of-range opcodes
+  m_op_info[m_num_ops] = op_info();
 }
 
 RISCVDecoder::~RISCVDecoder()
 {
+  delete [] m_op_info;
 }
 
 void RISCVDecoder::decode(DecodedInst * inst)
 {  
-  riscv::decode dec;
-
   if(inst->get_already_decoded())
     return;
   
   riscv::inst_t r_inst;
   memcpy(&r_inst, inst->get_code(), 8);  // TODO: num_bytes from sift
 
+  decode_rv8(inst, r_inst);
+}
+
+void RISCVDecoder::decode_rv8(DecodedInst * inst, riscv::inst_t r_inst)
+{
+  riscv::decode dec;
+
   riscv::decode_inst_rv64(dec, r_inst);
   decode_inst_type(dec, r_inst);
   decode_pseudo_inst(dec);
@@ -122,6 +263,38 @@ void RISCVDecoder::decode(DecodedInst * inst, dl_isa isa)
   this->decode(inst);
 }
 
+DecodedBlock * RISCVDecoder::decode_block(const uint8_t * code, size_t size, uint64_t addr, dl_isa isa,
+                                          unsigned int max_insts)
+{
+  TDecodedBlock<RISCVDecodedInst> * block = new TDecodedBlock<RISCVDecodedInst>(max_insts);
+  RISCVDecodedInst * inst;
+  
+  while(size > 0 && (inst = block->append(this, code, size, addr)))
+  {
+    // Unlike decode(), don't read past the end of the buffer
+    riscv::inst_t r_inst = 0;
+    memcpy(&r_inst, code, std::min(size, sizeof(r_inst)));
+    size_t length = riscv::inst_length(r_inst);
+    if (length == 0 || length > size)
+    {
+      block->remove_last();
+      break;
+    }
+    
+    decode_rv8(inst, r_inst);
+    inst->get_size() = length;
+    block->add_size(length);
+    code += length;
+    size -= length;
+    addr += length;
+    
+    if (is_branch_opcode(inst->inst_num_id()))
+      break;
+  }
+  
+  return block;
+}
+
 /// Change the ISA mode to new_mode
 // This function has no real effect for XED and RISCV, because the initialization is already done
 void RISCVDecoder::change_isa_mode(dl_isa new_isa)
@@ -184,19 +357,7 @@ unsigned int RISCVDecoder::num_operands(const DecodedInst * inst)
 /// Get the number of memory operands of the specified instruction
 unsigned int RISCVDecoder::num_memory_operands(const DecodedInst * inst)
 {
-  unsigned int num_memory_operands = 0;
-  riscv::decode *dec = ((RISCVDecodedInst *)inst)->get_rv8_dec();
-  const char *format = rv_inst_format[dec->op];
-  if (format == rv_fmt_rd_offset_rs1  /* lb, lh, lw, lbu, lhu, lwu, ld, ldu, lq, c.lwsp, c.ld, c.ldsp, c.lq, c.lqsp */
-    || format == rv_fmt_frd_offset_rs1 /* flw, fld, flq, c.fld, c.flw, c.fldsp, c.flwsp */
-    || format == rv_fmt_rs2_offset_rs1  /* sb, sh, sw, sd, sq, c.sw, c.swsp, c.sd, c.sdsp, c.sq, c.sqsp */
-    || format == rv_fmt_frs2_offset_rs1  /* fsw, fsd, fsq, c.fsd, c.fsw, c.fsdsp, c.fswsp */
-    || format == rv_fmt_aqrl_rd_rs2_rs1 /* amoswap.w */
-    || format == rv_fmt_aqrl_rd_rs2_rs1 /* amoswap.d */ 
-    || format == rv_fmt_aqrl_rd_rs2_rs1 /* amoswap.q */) {
-     num_memory_operands++;
-  }
-  return num_memory_operands;
+  return get_op_info(((RISCVDecodedInst *)inst)->get_rv8_dec()->op).num_memory_operands;
 }
 
 
@@ -225,29 +386,13 @@ Decoder::decoder_reg RISCVDecoder::mem_index_reg (const DecodedInst * inst, unsi
 /// Check if the operand mem_idx from instruction inst is read from memory
 bool RISCVDecoder::op_read_mem(const DecodedInst * inst, unsigned int mem_idx)
 {
-  // if operation is a load, we must be reading from memory
-  bool res = false;
-  riscv::decode *dec = ((RISCVDecodedInst *)inst)->get_rv8_dec();
-  const char *format = rv_inst_format[dec->op];
-  if (format == rv_fmt_rd_offset_rs1  /* lb, lh, lw, lbu, lhu, lwu, ld, ldu, lq, c.lwsp, c.ld, c.ldsp, c.lq, c.lqsp */
-    || format == rv_fmt_frd_offset_rs1 /* flw, fld, flq, c.fld, c.flw, c.fldsp, c.flwsp */ ) {
-     res = true; 
-  }
-  return res;
+  return get_op_info(((RISCVDecodedInst *)inst)->get_rv8_dec()->op).read_mem;
 }
 
 /// Check if the operand mem_idx from instruction inst is written to memory
 bool RISCVDecoder::op_write_mem(const DecodedInst * inst, unsigned int mem_idx)
 {
-  // if this operation is a store, we must be writing to memory
-  bool res = false;
-  riscv::decode *dec = ((RISCVDecodedInst *)inst)->get_rv8_dec();
-  const char *format = rv_inst_format[dec->op];
-  if (format == rv_fmt_rs2_offset_rs1  /* sb, sh, sw, sd, sq, c.sw, c.swsp, c.sd, c.sdsp, c.sq, c.sqsp */
-    || format == rv_fmt_frs2_offset_rs1  /* fsw, fsd, fsq, c.fsd, c.fsw, c.fsdsp, c.fswsp */ ) {
-     res = true;
-  }
-  return res;
+  return get_op_info(((RISCVDecodedInst *)inst)->get_rv8_dec()->op).write_mem;
 }
 
 /// Check if the operand idx from instruction inst reads from a register
@@ -320,38 +465,7 @@ Decoder::decoder_reg RISCVDecoder::get_op_reg (const DecodedInst * inst, unsigne
 /// Get the size in bytes of the memory operand pointed by mem_idx
 unsigned int RISCVDecoder::size_mem_op (const DecodedInst * inst, unsigned int mem_idx)
 {
-  unsigned int size = 0;
-  riscv::decode *dec = ((RISCVDecodedInst *)inst)->get_rv8_dec();
-  switch(dec->op) {
-    case rv_op_lb: 			/* Load Byte */
-    case rv_op_lbu: 		/* Load Byte Unsigned */
-    case rv_op_flw: 		/* FP Load (SP) */
-    case rv_op_sb: 			/* Store Byte */
-    case rv_op_fsw: 		/* FP Store (SP) */
-    case rv_op_lr_w: 	 	/* Load Reserved Word */
-    case rv_op_sc_w: 		/* Store Conditional Word */
-                        size = 1;
-                        break;
-    case rv_op_lh: 			/* Load Half */
-    case rv_op_lhu: 		/* Load Half Unsigned */
-    case rv_op_sh: 			/* Store Half */
-                        size = 2;
-                        break;
-    case rv_op_lw: 			/* Load Word */
-    case rv_op_lwu: 		/* Load Word Unsigned */
-    case rv_op_sw: 			/* Store Word */
-                        size = 4;
-                        break;
-    case rv_op_ld: 			/* Load Double */
-    case rv_op_fld: 		/* FP Load (DP) */
-    case rv_op_sd: 			/* Store Double */
-    case rv_op_fsd: 		/* FP Store (DP) */
-    case rv_op_lr_d: 		/* Load Reserved Double Word */
-    case rv_op_sc_d: 		/* Store Conditional Double Word */
-                        size = 8;
-                        break;
-  }
-  return size;
+  return get_op_info(((RISCVDecodedInst *)inst)->get_rv8_dec()->op).size_mem_op;
 }
 
 /// Get the number of execution micro operations contained in instruction 'ins' 
@@ -424,17 +538,7 @@ bool RISCVDecoder::is_cache_flush_opcode(decoder_opcode opcd)
 /// Check if the opcode is a division instruction
 bool RISCVDecoder::is_div_opcode(decoder_opcode opcd) 
 {
-  bool res = false;
-  switch(opcd) {
-    case rv_op_div:
-    case rv_op_divu:
-    case rv_op_divw:
-    case rv_op_divuw:
-    case rv_op_divd:
-    case rv_op_divud:
-      res = true; break;
-  }
-  return res;
+  return get_op_info(opcd).is_div;
 }
 
 /// Check if the opcode is a pause instruction
@@ -447,27 +551,7 @@ bool RISCVDecoder::is_pause_opcode(decoder_opcode opcd)
 /// Check if the opcode is a branch instruction
 bool RISCVDecoder::is_branch_opcode(decoder_opcode opcd) 
 {
-  bool res = false;
-  switch(opcd) {
-    case rv_op_beq:		/* Branch Equal */
-    case rv_op_bne:		/* Branch Not Equal */
-    case rv_op_blt:		/* Branch Less Than */
-    case rv_op_bge:		/* Branch Greater than Equal */
-    case rv_op_bltu:	/* Branch Less Than Unsigned */
-    case rv_op_bgeu:	/* Branch Greater than Equal Unsigned */
-    case rv_op_beqz:	/* Branch if = zero */
-    case rv_op_bnez:	/* Branch if ≠ zero */
-    case rv_op_blez:	/* Branch if ≤ zero */
-    case rv_op_bgez:	/* Branch if ≥ zero */
-    case rv_op_bltz:	/* Branch if < zero */
-    case rv_op_bgtz:	/* Branch if > zero */
-    case rv_op_ble:
-    case rv_op_bleu:
-    case rv_op_bgt:
-    case rv_op_bgtu:
-      res = true; break;
-  }
-  return res;
+  return get_op_info(opcd).is_branch;
 }
 
 /// Check if the opcode is an add/sub instruction that operates in vector and FP registers
@@ -519,7 +603,7 @@ void RISCVDecodedInst::set_rv8_dec(riscv::decode d) {
 /// Get the instruction numerical Id 
 unsigned int RISCVDecodedInst::inst_num_id() const
 {
-  riscv::decode dec = this->rv8_dec;
+  const riscv::decode &dec = this->rv8_dec;
   return dec.op;
 }
 
@@ -547,7 +631,7 @@ std::string format_str(const char* fmt, ...) //rv8 src/util/util.cc
 /// Get a string with the disassembled instruction
 void RISCVDecodedInst::disassembly_to_str(char *str, int len) const
 { 
-  riscv::decode dec = this->rv8_dec;
+  const riscv::decode &dec = this->rv8_dec;
   std::string args;
   const char *fmt = rv_inst_format[dec.op];
   while (*fmt) {
@@ -614,7 +698,7 @@ void RISCVDecodedInst::disassembly_to_str(char *str, int len) const
 bool RISCVDecodedInst::is_nop() const
 {
   bool res = false;
-  riscv::decode dec = this->rv8_dec;
+  const riscv::decode &dec = this->rv8_dec;
   if (dec.op == rv_op_nop) {
     return true;
   }
@@ -626,7 +710,7 @@ bool RISCVDecodedInst::is_atomic() const
 {
   // meta.cc or refer meta/opcode-classes
   bool res = false;
-  riscv::decode dec = this->rv8_dec;
+  const riscv::decode &dec = this->rv8_dec;
   if (dec.codec == rv_codec_r_l || dec.codec == rv_codec_r_a) {
     return true;
   }
@@ -649,7 +733,7 @@ bool RISCVDecodedInst::is_serializing() const
 bool RISCVDecodedInst::is_conditional_branch() const
 {
   bool res = false;
-  riscv::decode dec = this->rv8_dec;
+  const riscv::decode &dec = this->rv8_dec;
   switch (dec.op) {
     case rv_op_beq:		/* Branch Equal */
     case rv_op_bne:		/* Branch Not Equal */
@@ -681,7 +765,7 @@ bool RISCVDecodedInst::is_barrier() const
 {
   // if DMB, DSB, and ISB Data Memory Barrier, Data Synchronization Barrier, and Instruction Synchronization Barrier.
   bool res = false;
-  riscv::decode dec = this->rv8_dec;
+  const riscv::decode &dec = this->rv8_dec;
   switch (dec.op) {
     case rv_op_fence:		  /* Fence */
     case rv_op_fence_i:		/* Fence Instruction */
@@ -96,6 +96,8 @@ class RISCVDecoder : public Decoder
     
     virtual void decode(DecodedInst * inst) override; // pure virtual method; implement in subclass
     virtual void decode(DecodedInst * inst, dl_isa isa) override;
+    virtual DecodedBlock * decode_block(const uint8_t * code, size_t size, uint64_t addr, dl_isa isa,
+                                        unsigned int max_insts) override;
     
     /// Change the ISA mode to new_mode
     virtual void change_isa_mode(dl_isa new_isa) override; 
@@ -179,6 +181,23 @@ class RISCVDecoder : public Decoder
     // /// Get the target syntax of the decoder
     // dl_syntax get_syntax();
 
+  private:
+    /// Properties of an opcode, as needed by the per-instruction queries
+    struct op_info
+    {
+      uint8_t num_memory_operands;
+      uint8_t size_mem_op;
+      bool read_mem;
+      bool write_mem;
+      bool is_branch;
+      bool is_div;
+      op_info() : num_memory_operands(0), size_mem_op(0), read_mem(false), write_mem(false), is_branch(false), is_div(false) {}
+    };
+    op_info * m_op_info;
+    unsigned int m_num_ops;
+
+    const op_info & get_op_info(unsigned int op) const { return m_op_info[op < m_num_ops ? op : m_num_ops]; }
+    void decode_rv8(DecodedInst * inst, riscv::inst_t r_inst);
 };
 
 class RISCVDecodedInst : public DecodedInst
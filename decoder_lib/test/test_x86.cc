@@ -9,6 +9,8 @@ extern "C"
 } 
 
 #define X86_CODE64 "\x55\x48\x8b\x05\xb8\x13\x00\x00"
+// push rbp; mov rax, [rip+0x13b8]; add rax, 1; jmp -2; nop
+#define X86_BLOCK64 "\x55\x48\x8b\x05\xb8\x13\x00\x00\x48\x83\xc0\x01\xeb\xfe\x90"
 
 int main(int argc, const char* argv[])
 {
@@ -84,4 +86,16 @@ int main(int argc, const char* argv[])
   std::cout << "Disassembly: " << std::endl;
   std::cout << dis_str << std::endl;
 
+  // Basic block decode test: stops after the jmp, the nop is not part of the block
+
+  dl::DecodedBlock *b = d->decode_block((const uint8_t*)X86_BLOCK64, sizeof(X86_BLOCK64) - 1, addr, dl::DL_ISA_X86_64, 16);
+  std::cout << "Decoded block: " << b->num_insts() << " instructions, " << b->get_size() << " bytes" << std::endl;
+  for(unsigned int idx = 0; idx < b->num_insts(); ++idx)
+  {
+    dl::DecodedInst *bi = b->get_inst(idx);
+    std::cout << " " << std::hex << bi->get_address() << std::dec << " (" << bi->get_size() << "): " \
+      << d->inst_name(bi->inst_num_id()) << std::endl;
+  }
+  delete b;
+
 }
\ No newline at end of file
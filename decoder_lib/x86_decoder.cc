@@ -1,5 +1,6 @@
 #include "x86_decoder.h"
 #include <iostream>
+#include <algorithm>
 
 extern "C" 
 {
@@ -65,6 +66,37 @@ void X86Decoder::decode(DecodedInst * inst, dl_isa isa)
   this->decode(inst);
 }
 
+DecodedBlock * X86Decoder::decode_block(const uint8_t * code, size_t size, uint64_t addr, dl_isa isa,
+                                        unsigned int max_insts)
+{
+  TDecodedBlock<X86DecodedInst> * block = new TDecodedBlock<X86DecodedInst>(max_insts);
+  X86DecodedInst * inst;
+  
+  while(size > 0 && (inst = block->append(this, code, size, addr)))
+  {
+    xed_decoded_inst_t* xi = inst->get_xed_inst();
+    xed_decoded_inst_zero_set_mode(xi, &m_xed_state_init);
+    if (xed_decode(xi, code, std::min(size, (size_t)XED_MAX_INSTRUCTION_BYTES)) != XED_ERROR_NONE)
+    {
+      block->remove_last();
+      break;
+    }
+    
+    size_t length = xed_decoded_inst_get_length(xi);
+    inst->get_size() = length;
+    inst->set_already_decoded(true);
+    block->add_size(length);
+    code += length;
+    size -= length;
+    addr += length;
+    
+    if (is_branch_opcode(inst->inst_num_id()))
+      break;
+  }
+  
+  return block;
+}
+
 // This function has no real effect for XED, because the initialization is already done
 void X86Decoder::change_isa_mode(dl_isa new_isa)
 {
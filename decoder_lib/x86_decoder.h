@@ -18,6 +18,8 @@ class X86Decoder : public Decoder
     virtual ~X86Decoder();
     virtual void decode(DecodedInst * inst) override;
     virtual void decode(DecodedInst * inst, dl_isa isa) override;
+    virtual DecodedBlock * decode_block(const uint8_t * code, size_t size, uint64_t addr, dl_isa isa,
+                                        unsigned int max_insts) override;
     virtual void change_isa_mode(dl_isa new_isa) override;
     virtual const char* inst_name(unsigned int inst_id) override;
     virtual const char* reg_name(unsigned int reg_id) override;
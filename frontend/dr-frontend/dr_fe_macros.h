@@ -9,6 +9,10 @@
 // The maximum size of buffer for holding instructions
 #define MEM_BUF_SIZE (sizeof(instruction_t) * MAX_NUM_INS_REFS)
 
+// Number of instructions in the per-thread trace buffer used in fast mode, which is only emptied when full
+#define MAX_NUM_TRACE_REFS 32768
+#define TRACE_BUF_SIZE (sizeof(instruction_t) * MAX_NUM_TRACE_REFS)
+
 // For thread-local storage addressing
 #define TLS_SLOT(tls_base, enum_val) (void **)((byte *)(tls_base)+tls_offs+(enum_val))
 #define BUF_PTR(tls_base) *(instruction_t **)TLS_SLOT(tls_base, FRONTEND_TLS_OFFS_BUF_PTR)
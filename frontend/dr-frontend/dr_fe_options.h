@@ -57,6 +57,10 @@ static droption_t<bool> DRVerbose
 static droption_t<unsigned int> DRStopAddress
 (DROPTION_SCOPE_CLIENT, "stop", 0, "stop address",
  "Stop address (0 = disabled).");
+static droption_t<bool> DRFastBuffer
+(DROPTION_SCOPE_CLIENT, "fastbuf", false, "send instructions from a trace buffer in bulk",
+ "Write instructions to a per-thread drx_buf trace buffer with inlined stores and send them to the backend "
+ "only when the buffer fills up, rather than through a clean call in every basic block.");
 static droption_t<bool> DRSSH
 (DROPTION_SCOPE_CLIENT, "ssh", false, "frontend and backend connected by network",
  "Backend and frontend communicate over the network.");
@@ -3,6 +3,7 @@
 #include "drmgr.h"
 #include "drutil.h"
 #include "drreg.h"
+#include "drx.h"
 
 #include "dr_fe_options.h"
 #include "dr_fe_copy.h"
@@ -21,6 +22,8 @@ reg_id_t DRFrontend::tls_seg;
 uint DRFrontend::tls_offs;
 app_pc DRFrontend::last_opnd;
 int DRFrontend::last_mode = -1;
+bool DRFrontend::use_trace_buffer = false;
+drx_buf_t *DRFrontend::trace_buf = NULL;
 
 // -----------------------------------------------------------
 // Specialization of functions declared in frontend.h classes
@@ -68,6 +71,15 @@ void DRFrontend::init()
 
   if(!drmgr_init() || drreg_init(&ops) != DRREG_SUCCESS)
     DR_ASSERT(false);
+
+  use_trace_buffer = DRFastBuffer.get_value();
+  if (use_trace_buffer)
+  {
+    if (!drx_init())
+      DR_ASSERT(false);
+    trace_buf = drx_buf_create_trace_buffer(TRACE_BUF_SIZE, event_trace_buffer_full);
+    DR_ASSERT(trace_buf != NULL);
+  }
     
   dr_set_client_name("Sniper's frontend based on DynamoRIO", "http://snipersim.org");
   
@@ -86,6 +98,10 @@ void DRFrontend::init()
       exit(1);
     }
 
+    // Buffered instructions have to reach the backend before the syscall does: register this one first
+    if (use_trace_buffer)
+      drmgr_register_pre_syscall_event(event_pre_syscall_flush);
+
     m_sysmodel->set_map_threads(&map_threadids);
     m_sysmodel->initSyscallModeling();
   }
@@ -105,7 +121,8 @@ void DRFrontend::init()
   DR_ASSERT(tls_idx != -1);
   // The TLS field provided by DR cannot be directly accessed from the code cache.
   // For better performance, we allocate raw TLS so that we can directly access and update it with a single instruction.
-  if (!dr_raw_tls_calloc(&tls_seg, &tls_offs, FRONTEND_TLS_COUNT, 0))
+  // In fast mode drx_buf keeps the buffer pointer in its own raw TLS slot.
+  if (!use_trace_buffer && !dr_raw_tls_calloc(&tls_seg, &tls_offs, FRONTEND_TLS_COUNT, 0))
     DR_ASSERT(false);
      
 }
@@ -127,12 +144,22 @@ void DRFrontend::event_thread_init(void *drcontext)
   // store it in the slot of the thread local storage (TLS) provided in the drcontext and initialize its fields
   drmgr_set_tls_field(drcontext, tls_idx, data);
 
-  // Keep seg_base in a per-thread data structure so we can get the TLS slot and find where the pointer points to in the buffer.
-  data->seg_base = (byte*) dr_get_dr_segment_base(tls_seg);
-  data->inst_buf = (instruction_t*)dr_raw_mem_alloc(MEM_BUF_SIZE, DR_MEMPROT_READ | DR_MEMPROT_WRITE, NULL);
-  DR_ASSERT(data->seg_base != NULL && data->inst_buf != NULL);
-  // put inst_buf to TLS as starting buf_ptr 
-  BUF_PTR(data->seg_base) = data->inst_buf;
+  data->has_pending = false;
+  if (use_trace_buffer)
+  {
+    // The trace buffer itself is allocated by drx_buf
+    data->seg_base = NULL;
+    data->inst_buf = NULL;
+  }
+  else
+  {
+    // Keep seg_base in a per-thread data structure so we can get the TLS slot and find where the pointer points to in the buffer.
+    data->seg_base = (byte*) dr_get_dr_segment_base(tls_seg);
+    data->inst_buf = (instruction_t*)dr_raw_mem_alloc(MEM_BUF_SIZE, DR_MEMPROT_READ | DR_MEMPROT_WRITE, NULL);
+    DR_ASSERT(data->seg_base != NULL && data->inst_buf != NULL);
+    // put inst_buf to TLS as starting buf_ptr 
+    BUF_PTR(data->seg_base) = data->inst_buf;
+  }
 
   // get DR's internal threadid
   int threadid_dr = dr_get_thread_id(drcontext);  
@@ -155,7 +182,11 @@ void DRFrontend::event_thread_init(void *drcontext)
 
 void DRFrontend::event_thread_exit(void *drcontext)
 {
-  process_instructions_buffer(drcontext); // dump remaining contents
+  // dump remaining contents
+  if (use_trace_buffer)
+    flush_trace_buffer(drcontext, true);
+  else
+    process_instructions_buffer(drcontext);
   
   // get DR's internal threadid
   int threadid_dr = dr_get_thread_id(drcontext);  
@@ -173,7 +204,8 @@ void DRFrontend::event_thread_exit(void *drcontext)
   
   // free allocated memory for tls 
   per_thread_t *data = (per_thread_t *) drmgr_get_tls_field(drcontext, tls_idx);
-  dr_raw_mem_free(data->inst_buf, MEM_BUF_SIZE);
+  if (!use_trace_buffer)
+    dr_raw_mem_free(data->inst_buf, MEM_BUF_SIZE);
   dr_thread_free(drcontext, data, sizeof(per_thread_t));
 
   m_threads->threadFinish(threadid_fe, 0);  // TODO are flags here relevant?
@@ -186,7 +218,12 @@ void DRFrontend::event_exit(void)
     std::cerr << "[Exit event] Begin."  << std::endl;
   }
 
-  if (!dr_raw_tls_cfree(tls_offs, FRONTEND_TLS_COUNT))
+  if (use_trace_buffer)
+  {
+    drx_buf_free(trace_buf);
+    drx_exit();
+  }
+  else if (!dr_raw_tls_cfree(tls_offs, FRONTEND_TLS_COUNT))
     DR_ASSERT(false);
         
   if (!drmgr_unregister_tls_field(tls_idx) ||
@@ -239,6 +276,56 @@ dr_emit_flags_t DRFrontend::event_bb_analysis(void *drcontext, void *tag, instrl
     return DR_EMIT_DEFAULT;
 }
 
+void DRFrontend::send_instruction(instruction_t *instruction, app_pc next_pc)
+{
+  // Update branch information
+  bool taken = false;
+  if (instruction->is_branch && next_pc != NULL){
+    // Compare the next instruction's address with the recorded value for the taken path
+    taken = map_taken_branch[instruction->threadid][(ptr_uint_t)instruction->pc] == (ptr_uint_t)next_pc;
+  }
+  
+/*  dr_fprintf(STDERR, "[%d] " PFX "(%d):%d[%d],b:%d,t:%d,p:%d,e:%d,a:%d,z:%d\n", instruction->threadid, (ptr_uint_t)instruction->pc, instruction->isize,
+                                            instruction->num_addresses, instruction->ndynaddr, instruction->is_branch, taken,
+                                            instruction->is_predicate, instruction->is_executing, 
+                                            instruction->is_before, instruction->is_pause);*/
+  
+  // Update dynamic addresses information in the thread data structure      
+  m_thread_data[instruction->threadid].num_dyn_addresses = instruction->ndynaddr;
+  for (unsigned int i = 0; i < m_thread_data[instruction->threadid].num_dyn_addresses; i++)
+  {
+    switch(i)
+    {
+      case 0:
+        m_thread_data[instruction->threadid].dyn_addresses[0] = (ptr_uint_t)instruction->dynaddr_0;
+        break;
+      case 1:
+        m_thread_data[instruction->threadid].dyn_addresses[1] = (ptr_uint_t)instruction->dynaddr_1;
+        break;
+      case 2:
+        m_thread_data[instruction->threadid].dyn_addresses[2] = (ptr_uint_t)instruction->dynaddr_2;
+        break;        
+    }
+  }
+  
+  // Do we have to change the ISA mode? (ARM-32 only)
+  IF_ARM
+  (
+    if(last_mode != instruction->isa_mode)
+    {
+      m_callbacks->changeISA((threadid_t)instruction->threadid, instruction->isa_mode);
+      last_mode = instruction->isa_mode;
+    }
+  )
+  
+  //TODO: NEETHUM
+  m_callbacks->sendInstruction((threadid_t)instruction->threadid, (addr_t)instruction->pc, instruction->isize,
+                                              instruction->num_addresses, instruction->is_branch, 
+                                              taken, instruction->is_predicate, 
+                                              instruction->is_executing, instruction->is_before, instruction->is_pause);
+  instruction->ndynaddr = 0;
+}
+
 void DRFrontend::process_instructions_buffer(void *drcontext)
 {
   per_thread_t *data = (per_thread_t*)drmgr_get_tls_field(drcontext, tls_idx);
@@ -246,57 +333,55 @@ void DRFrontend::process_instructions_buffer(void *drcontext)
   
   for (instruction_t *instruction = (instruction_t *)data->inst_buf; instruction < buf_ptr; instruction++) 
   {
-    // Update branch information
-    bool taken = false;
-    if (instruction->is_branch && (instruction+1) < buf_ptr){
-      // Check next instruction's address to see if the branch has been taken
-      ptr_uint_t next_address = (ptr_uint_t)(instruction+1)->pc;
-      // Compare with the recorded value for the taken path
-      taken = map_taken_branch[instruction->threadid][(ptr_uint_t)instruction->pc] == next_address;
-    }
-    
-/*    dr_fprintf(STDERR, "[%d] " PFX "(%d):%d[%d],b:%d,t:%d,p:%d,e:%d,a:%d,z:%d\n", instruction->threadid, (ptr_uint_t)instruction->pc, instruction->isize,
-                                              instruction->num_addresses, instruction->ndynaddr, instruction->is_branch, taken,
-                                              instruction->is_predicate, instruction->is_executing, 
-                                              instruction->is_before, instruction->is_pause);*/
-    
-    // Update dynamic addresses information in the thread data structure      
-    m_thread_data[instruction->threadid].num_dyn_addresses = instruction->ndynaddr;
-    for (unsigned int i = 0; i < m_thread_data[instruction->threadid].num_dyn_addresses; i++)
+    // Check next instruction's address to see if a branch has been taken
+    send_instruction(instruction, (instruction+1) < buf_ptr ? (instruction+1)->pc : NULL);
+  }
+  BUF_PTR(data->seg_base) = data->inst_buf;
+
+}
+
+void DRFrontend::send_trace_buffer(void *drcontext, instruction_t *begin, instruction_t *end, bool final)
+{
+  per_thread_t *data = (per_thread_t*)drmgr_get_tls_field(drcontext, tls_idx);
+
+  // A branch held back from the previous buffer: its successor is the first instruction of this one
+  if (data->has_pending && (begin < end || final))
+  {
+    send_instruction(&data->pending, begin < end ? begin->pc : NULL);
+    data->has_pending = false;
+  }
+
+  for (instruction_t *instruction = begin; instruction < end; instruction++)
+  {
+    if (instruction + 1 == end && instruction->is_branch && !final)
     {
-      switch(i)
-      {
-        case 0:
-          m_thread_data[instruction->threadid].dyn_addresses[0] = (ptr_uint_t)instruction->dynaddr_0;
-          break;
-        case 1:
-          m_thread_data[instruction->threadid].dyn_addresses[1] = (ptr_uint_t)instruction->dynaddr_1;
-          break;
-        case 2:
-          m_thread_data[instruction->threadid].dyn_addresses[2] = (ptr_uint_t)instruction->dynaddr_2;
-          break;        
-      }
+      data->pending = *instruction;
+      data->has_pending = true;
+      break;
     }
-    
-    // Do we have to change the ISA mode? (ARM-32 only)
-    IF_ARM
-    (
-      if(last_mode != instruction->isa_mode)
-      {
-        m_callbacks->changeISA((threadid_t)instruction->threadid, instruction->isa_mode);
-        last_mode = instruction->isa_mode;
-      }
-    )
-    
-    //TODO: NEETHUM
-    m_callbacks->sendInstruction((threadid_t)instruction->threadid, (addr_t)instruction->pc, instruction->isize,
-                                                instruction->num_addresses, instruction->is_branch, 
-                                                taken, instruction->is_predicate, 
-                                                instruction->is_executing, instruction->is_before, instruction->is_pause);
-    instruction->ndynaddr = 0;
+    send_instruction(instruction, (instruction+1) < end ? (instruction+1)->pc : NULL);
   }
-  BUF_PTR(data->seg_base) = data->inst_buf;
+}
+
+void DRFrontend::event_trace_buffer_full(void *drcontext, void *buf_base, size_t size)
+{
+  // drx_buf resets the buffer pointer itself when we return
+  instruction_t *begin = (instruction_t *)buf_base;
+  send_trace_buffer(drcontext, begin, begin + size / sizeof(instruction_t), false);
+}
+
+void DRFrontend::flush_trace_buffer(void *drcontext, bool final)
+{
+  instruction_t *begin = (instruction_t *)drx_buf_get_buffer_base(drcontext, trace_buf);
+  instruction_t *end = (instruction_t *)drx_buf_get_buffer_ptr(drcontext, trace_buf);
+  send_trace_buffer(drcontext, begin, end, final);
+  drx_buf_set_buffer_ptr(drcontext, trace_buf, (byte *)begin);
+}
 
+bool DRFrontend::event_pre_syscall_flush(void *drcontext, int sysnum)
+{
+  flush_trace_buffer(drcontext, false);
+  return true;
 }
 
 void DRFrontend::clean_call(void)
@@ -307,11 +392,23 @@ void DRFrontend::clean_call(void)
 
 void DRFrontend::insert_load_buf_ptr(void *drcontext, instrlist_t *bb, instr_t *instr, reg_id_t reg_ptr)
 {
+  if (use_trace_buffer)
+  {
+    drx_buf_insert_load_buf_ptr(drcontext, trace_buf, bb, instr, reg_ptr);
+    return;
+  }
   dr_insert_read_raw_tls(drcontext, bb, instr, tls_seg, tls_offs + FRONTEND_TLS_OFFS_BUF_PTR, reg_ptr);
 }
 
-void DRFrontend::insert_update_buf_ptr(void *drcontext, instrlist_t *bb, instr_t *instr, reg_id_t reg_ptr, int adjust)
+void DRFrontend::insert_update_buf_ptr(void *drcontext, instrlist_t *bb, instr_t *instr, reg_id_t reg_ptr, reg_id_t scratch,
+                                       int adjust)
 {
+  if (use_trace_buffer)
+  {
+    // Writes past the end of the trace buffer hit drx_buf's guard page, which calls event_trace_buffer_full
+    drx_buf_insert_update_buf_ptr(drcontext, trace_buf, bb, instr, reg_ptr, scratch, adjust);
+    return;
+  }
   instrlist_meta_preinsert( bb, instr,
                             XINST_CREATE_add(drcontext, opnd_create_reg(reg_ptr), OPND_CREATE_INT16(adjust))
                           );
@@ -447,6 +544,9 @@ unsigned int DRFrontend::addMemoryModeling( threadid_t threadid, void *drcontext
 void DRFrontend::magic_clean_call()
 {
   void * drcontext = dr_get_current_drcontext();
+  // Instructions before the magic one must reach the backend first
+  if (use_trace_buffer)
+    flush_trace_buffer(drcontext, false);
   dr_mcontext_t mc = {sizeof(mc),DR_MC_ALL,};
   dr_get_mcontext(drcontext, &mc);
   IF_X86
@@ -470,6 +570,8 @@ void DRFrontend::magic_clean_call()
 void DRFrontend::invoke_endROI()
 {
   void * drcontext = dr_get_current_drcontext();
+  if (use_trace_buffer)
+    flush_trace_buffer(drcontext, true);
   m_control->endROI(map_threadids[dr_get_thread_id(drcontext)]);
 }
 
@@ -618,15 +720,16 @@ dr_emit_flags_t DRFrontend::event_app_instruction(void *drcontext, void *tag, in
       )
       
       // Update buffer's pointer for next instruction
-      insert_update_buf_ptr(drcontext, bb, instr, reg_ptr, sizeof(instruction_t));
+      insert_update_buf_ptr(drcontext, bb, instr, reg_ptr, reg_tmp, sizeof(instruction_t));
 
       // Restore scratch registers
       if (drreg_unreserve_register(drcontext, bb, instr, reg_ptr) != DRREG_SUCCESS || 
           drreg_unreserve_register(drcontext, bb, instr, reg_tmp) != DRREG_SUCCESS)
             DR_ASSERT(false);
   
-      // Insert clean call to send this instruction to Sniper's backend
-      if (drmgr_is_first_instr(drcontext, instr) &&
+      // Insert clean call to send this instruction to Sniper's backend, in fast mode this only happens when the
+      // trace buffer is full
+      if (!use_trace_buffer && drmgr_is_first_instr(drcontext, instr) &&
           IF_ARM_ELSE(!instr_is_predicated(instr), true)
           IF_AARCHXX(&& !instr_is_exclusive_store(instr)))
       {
@@ -4,6 +4,7 @@
 #include "frontend.h"
 
 #include "dr_api.h"
+#include "drx.h"
 
 #include <unordered_map>
 
@@ -48,6 +49,12 @@ class DRFrontend : public frontend::Frontend<DRFrontend>
     
     /// DR clean call to process and send instructions from a buffer to the backend.
     static void process_instructions_buffer(void *drcontext);
+    /// drx_buf callback invoked when the trace buffer of a thread is full (fast mode only).
+    static void event_trace_buffer_full(void *drcontext, void *buf_base, size_t size);
+    /// Sends the contents of the trace buffer of the current thread to the backend and empties it (fast mode only).
+    static void flush_trace_buffer(void *drcontext, bool final);
+    /// DR callback to flush the trace buffer before a syscall is emulated (fast mode only).
+    static bool event_pre_syscall_flush(void *drcontext, int sysnum);
     static void clean_call(void);
     
     /// DR clean call to process magic instructions.
@@ -66,7 +73,8 @@ class DRFrontend : public frontend::Frontend<DRFrontend>
     static void insert_save_pc(void *drcontext, instrlist_t *bb, instr_t *instr, reg_id_t base, reg_id_t scratch, app_pc pc);
     static void insert_save_int(void *drcontext, instrlist_t *bb, instr_t *instr, reg_id_t base, reg_id_t scratch, int disp, int tid);
     static void insert_load_buf_ptr(void *drcontext, instrlist_t *bb, instr_t *instr, reg_id_t reg_ptr);
-    static void insert_update_buf_ptr(void *drcontext, instrlist_t *bb, instr_t *instr, reg_id_t reg_ptr, int adjust);
+    static void insert_update_buf_ptr(void *drcontext, instrlist_t *bb, instr_t *instr, reg_id_t reg_ptr, reg_id_t scratch,
+                                      int adjust);
 
   private:
     /// Struct that contains the instruction information
@@ -108,6 +116,9 @@ class DRFrontend : public frontend::Frontend<DRFrontend>
     typedef struct {
       byte      *seg_base;
       instruction_t *inst_buf;
+      // Fast mode: last branch of a full trace buffer, held back until we know the next instruction
+      instruction_t pending;
+      bool has_pending;
     } per_thread_t;
     /// Allocated TLS slot offsets
     enum {
@@ -125,6 +136,12 @@ class DRFrontend : public frontend::Frontend<DRFrontend>
     /// current basic block (instrlist_t *bb), saved in user_data.
     static dr_emit_flags_t event_bb_analysis(void *drcontext, void *tag, instrlist_t *bb,
                   bool for_trace, bool translating, void **user_data);
+
+    /// Sends one buffered instruction to the backend, next_pc is the address of the instruction executed after it
+    /// (NULL if not known yet) to find out whether a branch was taken.
+    static void send_instruction(instruction_t *instruction, app_pc next_pc);
+    /// Sends the buffered instructions [begin, end) of the current thread in fast mode.
+    static void send_trace_buffer(void *drcontext, instruction_t *begin, instruction_t *end, bool final);
   // Variables
     /// Correspondance DR thread id / Frontend thread Id
     static std::unordered_map<int, threadid_t> map_threadids;
@@ -145,6 +162,11 @@ class DRFrontend : public frontend::Frontend<DRFrontend>
     static app_pc last_opnd;
     /// Keeps the mode of the last instruction of the previously processed buffer
     static int last_mode;
+    /// Fast mode: instructions are written to a drx_buf trace buffer with inlined stores, and only sent to the
+    /// backend in bulk when the buffer fills up, instead of through a clean call in every basic block
+    static bool use_trace_buffer;
+    /// Per-thread trace buffer used in fast mode
+    static drx_buf_t *trace_buf;
 };
 
 #endif // _DR_FRONTEND_H_
@@ -0,0 +1,80 @@
+#ifndef _FRONTEND_BATCH_H_
+#define _FRONTEND_BATCH_H_
+
+#include "sift_writer.h"
+#include "frontend_defs.h"
+#include "frontend_callbacks.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace frontend
+{
+
+/**
+ * @class FrontendBatch
+ *
+ * Collects the instructions of each frontend thread into basic-block-sized buffers, which writer threads send to
+ * the thread's SIFT output with one FrontendCallbacks::sendInstructionBlock call per block.
+ * Frontend thread i is drained by writer i % num_writers, so each Sift::Writer is only used by one writer at a time.
+ * Anything else that writes to a thread's output (syscalls, thread exit, end of simulation) has to flush() first.
+ * T: Frontend type
+ */
+template <typename T> class FrontendBatch
+{
+  public:
+  /// Constructor: starts the writer threads
+  FrontendBatch(uint32_t num_writers, thread_data_t* td);
+
+  /// Destructor: writes out all buffered instructions and stops the writer threads
+  ~FrontendBatch();
+
+  /// Buffer an instruction; its memory addresses are taken from the thread data (see Frontend::handleMemory)
+  void addInstruction(threadid_t threadid, addr_t addr, uint32_t size, uint32_t num_addresses, bool is_branch,
+                      bool taken, bool is_predicate, bool executing, bool ispause);
+
+  /// Write out the buffered instructions of a thread, and wait until they have been written
+  void flush(threadid_t threadid);
+
+  /// Same as flush, for all threads
+  void flushAll();
+
+  private:
+  static const uint32_t MAX_BLOCK_INSNS = 64;
+  static const uint32_t QUEUE_SIZE = 64;  // Blocks per thread, power of two
+
+  struct Block
+  {
+    uint32_t count;
+    uint32_t num_addresses;
+    bool ispause;
+    Sift::InstructionInfo insns[MAX_BLOCK_INSNS];
+    uint64_t addresses[MAX_BLOCK_INSNS * Sift::MAX_DYNAMIC_ADDRESSES];
+  };
+
+  /// Ring of blocks with a single producer (the emulation thread) and a single consumer (the thread's writer).
+  /// The block at head is the one being filled, the producer makes sure it is never still in use by the writer.
+  struct Queue
+  {
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    Block *blocks;    // Allocated on first use
+    addr_t next_addr; // Producer only: address that continues the current block
+  } __attribute__((aligned(LINE_SIZE_BYTES)));
+
+  thread_data_t* m_thread_data;
+  Queue m_queues[MAX_NUM_THREADS];
+  std::vector<std::thread> m_writers;
+  std::atomic<bool> m_stop;
+
+  Block* currentBlock(threadid_t threadid);
+  void endBlock(threadid_t threadid);
+  void waitWritten(threadid_t threadid);
+  void writer(uint32_t index, uint32_t num_writers);
+};
+
+} // namespace frontend
+
+#include "frontend_batch.tcc"
+
+#endif // _FRONTEND_BATCH_H_
@@ -0,0 +1,161 @@
+#include "sift_assert.h"
+#include <chrono>
+
+namespace frontend
+{
+
+template <typename T>
+FrontendBatch<T>::FrontendBatch(uint32_t num_writers, thread_data_t* td)
+  : m_thread_data(td)
+  , m_stop(false)
+{
+  sift_assert(num_writers > 0);
+
+  for (uint32_t i = 0; i < MAX_NUM_THREADS; i++)
+  {
+    m_queues[i].head.store(0, std::memory_order_relaxed);
+    m_queues[i].tail.store(0, std::memory_order_relaxed);
+    m_queues[i].blocks = NULL;
+    m_queues[i].next_addr = 0;
+  }
+
+  for (uint32_t i = 0; i < num_writers; i++)
+    m_writers.push_back(std::thread(&FrontendBatch<T>::writer, this, i, num_writers));
+}
+
+template <typename T>
+FrontendBatch<T>::~FrontendBatch()
+{
+  flushAll();
+
+  m_stop.store(true, std::memory_order_release);
+  for (std::vector<std::thread>::iterator it = m_writers.begin(); it != m_writers.end(); ++it)
+    it->join();
+
+  for (uint32_t i = 0; i < MAX_NUM_THREADS; i++)
+    delete [] m_queues[i].blocks;
+}
+
+template <typename T>
+typename FrontendBatch<T>::Block* FrontendBatch<T>::currentBlock(threadid_t threadid)
+{
+  Queue &queue = m_queues[threadid];
+  if (!queue.blocks)
+    queue.blocks = new Block[QUEUE_SIZE]();
+  return &queue.blocks[queue.head.load(std::memory_order_relaxed) & (QUEUE_SIZE - 1)];
+}
+
+template <typename T>
+void FrontendBatch<T>::addInstruction(threadid_t threadid, addr_t addr, uint32_t size, uint32_t num_addresses, bool is_branch, bool taken, bool is_predicate, bool executing, bool ispause)
+{
+  // Same as sendInstruction: nothing is sent while the output is closed
+  if (!m_thread_data[threadid].output)
+  {
+    m_thread_data[threadid].num_dyn_addresses = 0;
+    return;
+  }
+  sift_assert(m_thread_data[threadid].num_dyn_addresses == num_addresses);
+
+  Block *block = currentBlock(threadid);
+  // Blocks are straight-line code
+  if (block->count && addr != m_queues[threadid].next_addr)
+  {
+    endBlock(threadid);
+    block = currentBlock(threadid);
+  }
+
+  Sift::InstructionInfo &insn = block->insns[block->count++];
+  insn.addr = addr;
+  insn.size = size;
+  insn.num_addresses = num_addresses;
+  insn.is_branch = is_branch;
+  insn.taken = taken;
+  insn.is_predicate = is_predicate;
+  insn.executed = executing;
+  for (uint32_t i = 0; i < num_addresses; i++)
+    block->addresses[block->num_addresses++] = m_thread_data[threadid].dyn_addresses[i];
+  m_thread_data[threadid].num_dyn_addresses = 0;
+  m_queues[threadid].next_addr = addr + size;
+
+  // Pauses are sent right away, they trigger flow control
+  if (is_branch || ispause || block->count == MAX_BLOCK_INSNS)
+  {
+    block->ispause = ispause;
+    endBlock(threadid);
+  }
+}
+
+template <typename T>
+void FrontendBatch<T>::endBlock(threadid_t threadid)
+{
+  Queue &queue = m_queues[threadid];
+  uint64_t head = queue.head.load(std::memory_order_relaxed);
+  if (!queue.blocks || queue.blocks[head & (QUEUE_SIZE - 1)].count == 0)
+    return;
+
+  queue.head.store(++head, std::memory_order_release);
+
+  // Wait until the writer is done with the next slot before starting to fill it
+  while (head - queue.tail.load(std::memory_order_acquire) >= QUEUE_SIZE)
+    std::this_thread::yield();
+  Block &block = queue.blocks[head & (QUEUE_SIZE - 1)];
+  block.count = 0;
+  block.num_addresses = 0;
+  block.ispause = false;
+}
+
+template <typename T>
+void FrontendBatch<T>::waitWritten(threadid_t threadid)
+{
+  Queue &queue = m_queues[threadid];
+  while (queue.tail.load(std::memory_order_acquire) != queue.head.load(std::memory_order_relaxed))
+    std::this_thread::yield();
+}
+
+template <typename T>
+void FrontendBatch<T>::flush(threadid_t threadid)
+{
+  endBlock(threadid);
+  waitWritten(threadid);
+}
+
+template <typename T>
+void FrontendBatch<T>::flushAll()
+{
+  // Hand over everything first, so all writers work in parallel
+  for (threadid_t i = 0; i < MAX_NUM_THREADS; i++)
+    endBlock(i);
+  for (threadid_t i = 0; i < MAX_NUM_THREADS; i++)
+    waitWritten(i);
+}
+
+template <typename T>
+void FrontendBatch<T>::writer(uint32_t index, uint32_t num_writers)
+{
+  while (true)
+  {
+    // Read before draining, so blocks published before stopping are still written
+    bool stop = m_stop.load(std::memory_order_acquire);
+    bool idle = true;
+
+    for (threadid_t threadid = index; threadid < MAX_NUM_THREADS; threadid += num_writers)
+    {
+      Queue &queue = m_queues[threadid];
+      uint64_t head = queue.head.load(std::memory_order_acquire);
+      for (uint64_t tail = queue.tail.load(std::memory_order_relaxed); tail != head; ++tail)
+      {
+        Block &block = queue.blocks[tail & (QUEUE_SIZE - 1)];
+        FrontendCallbacks<T>::sendInstructionBlock(threadid, block.insns, block.count, block.addresses, block.ispause);
+        queue.tail.store(tail + 1, std::memory_order_release);
+        idle = false;
+      }
+    }
+
+    if (stop)
+      break;
+    if (idle)
+      std::this_thread::sleep_for(std::chrono::microseconds(10));
+  }
+}
+
+} // namespace frontend
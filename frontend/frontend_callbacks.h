@@ -35,6 +35,11 @@ template <typename T> class FrontendCallbacks
   static void sendInstruction(threadid_t threadid, addr_t addr, uint32_t size, uint32_t num_addresses, bool is_branch, 
                               bool taken, bool is_predicate, bool executing, bool isbefore, bool ispause);
   
+  /// Method to send a run of buffered instructions (see FrontendBatch) to Sniper's backend with a single Writer call;
+  /// addresses holds the memory addresses of all instructions, in order. Flow control is checked once per run.
+  static void sendInstructionBlock(threadid_t threadid, const Sift::InstructionInfo *insns, uint32_t count, uint64_t *addresses,
+                                   bool ispause);
+
   /// Code specific to the running frontend implementation to be executed inside sendInstruction
   static void __sendInstructionSpecialized(threadid_t threadid, uint32_t num_addresses, bool isbefore);
   
@@ -103,6 +103,41 @@ void FrontendCallbacks <T>::sendInstruction(threadid_t threadid, addr_t addr, ui
   // TODO fill in cases with use response files, detailed target, blocksize
 }
 
+template <typename T>
+void FrontendCallbacks <T>::sendInstructionBlock(threadid_t threadid, const Sift::InstructionInfo *insns, uint32_t count, uint64_t *addresses, bool ispause)
+{
+  // We're still called for instructions in the same basic block as ROI end, ignore these
+  if (!m_thread_data[threadid].output)
+    return;
+
+  m_thread_data[threadid].icount += count;
+  m_thread_data[threadid].icount_detailed += count;
+
+  // Same basic block reconstruction as sendInstruction
+  for (uint32_t i = 0; i < count; i++)
+  {
+    if (m_thread_data[threadid].bbv_end || m_thread_data[threadid].bbv_last != insns[i].addr)
+    {
+      m_thread_data[threadid].bbv->count(m_thread_data[threadid].bbv_base, m_thread_data[threadid].bbv_count);
+      m_thread_data[threadid].bbv_base = insns[i].addr;
+      m_thread_data[threadid].bbv_count = 0;
+    }
+    m_thread_data[threadid].bbv_count++;
+    m_thread_data[threadid].bbv_last = insns[i].addr + insns[i].size;
+    m_thread_data[threadid].bbv_end = insns[i].is_branch;
+  }
+
+  m_thread_data[threadid].output->InstructionBlock(count, insns, addresses);
+
+  if (m_options->get_response_files() && m_options->get_flow_control()
+      && (m_thread_data[threadid].icount > m_thread_data[threadid].flowcontrol_target || ispause))
+  {
+    Sift::Mode mode = m_thread_data[threadid].output->Sync();
+    m_thread_data[threadid].flowcontrol_target = m_thread_data[threadid].icount + 1000;//KnobFlowControl.Value();
+    m_control->setInstrumentationMode(mode);
+  }
+}
+
 template <typename T>
 void FrontendCallbacks <T>::changeISA(threadid_t threadid, int new_isa)
 {
@@ -102,6 +102,11 @@ template <typename T> inline uint32_t FrontendOptions<T>::get_ncores()
   return ncores;
 }
 
+template <typename T> inline uint32_t FrontendOptions<T>::get_writers()
+{
+  return writers;
+}
+
 template <typename T> inline std::string FrontendOptions<T>::get_statefile()
 {
   return statefile;
@@ -120,6 +120,7 @@ template <typename T> class FrontendOptions : public OptionsBase<T>
 
   /// Get private fields
   uint32_t get_ncores();
+  uint32_t get_writers();
   std::string get_statefile();
   std::string get_cmd_app();
   FrontendISA get_theISA();
@@ -134,6 +135,9 @@ template <typename T> class FrontendOptions : public OptionsBase<T>
   /// Number of cores -- not common to all frontends
   uint32_t ncores;
 
+  /// Number of threads writing batched instructions (see FrontendBatch), 0 = no batching -- not common to all frontends
+  uint32_t writers;
+
   /// Route to the file that keeps the state of the frontend for the next run -- not common to all frontends
   std::string statefile;
   
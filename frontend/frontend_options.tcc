@@ -10,9 +10,10 @@ FrontendOptions<T>::FrontendOptions(int argc, const char * argv [])
   this->current_mode = Sift::ModeIcount;
   this->verbose = false;
   this->ncores = 1;
+  this->writers = 0;
   
   // TODO add to -frontend a name, with something like typeid(T).name(), or the solution described in http://stackoverflow.com/questions/1055452/c-get-name-of-type-in-template
-  this->opt.syntax = "-frontend -ncores N -verbose [0,1] -roi [0,1] -f [#FF_instructions] -d [0,1] -b [blocksize] -o [outputfile] -e [0,1] -s [siftcountoffset] -r [0,1] -pa [0,1] -stop [stop_address] -statefile [route/file] -app [...]\n\n";
+  this->opt.syntax = "-frontend -ncores N -writers N -verbose [0,1] -roi [0,1] -f [#FF_instructions] -d [0,1] -b [blocksize] -o [outputfile] -e [0,1] -s [siftcountoffset] -r [0,1] -pa [0,1] -stop [stop_address] -statefile [route/file] -app [...]\n\n";
   this->opt.example = "-frontend -roi 1 -f 0 -d 0 -b 32 -o file.out -e 1 -s 0 -r 1 -pa 0 -stop 1000000 -app /bin/ls\n\n";
   this->opt.overview = "Frontend options";
 
@@ -27,6 +28,7 @@ FrontendOptions<T>::FrontendOptions(int argc, const char * argv [])
   );
   this->opt.add("0", 0, 1, 0, "Verbose output.", "-verbose");
   this->opt.add("0", 0, 1, 0, "Number of frontend emulated cores.", "-ncores");
+  this->opt.add("0", 0, 1, 0, "Number of threads writing instructions batched per basic block (0 = no batching).", "-writers");
   this->opt.add("0", 0, 1, 0, "Number of instructions to fast forward.", "-f");
   this->opt.add("0", 0, 1, 0, "Number of instructions to trace in detail (default = all).", "-d");
   this->opt.add("0", 0, 1, 0, "Blocksize.", "-b");  
@@ -69,6 +71,14 @@ FrontendOptions<T>::FrontendOptions(int argc, const char * argv [])
     this->ncores = 1;
   }
   
+  if (opt.isSet("-writers")) {
+    int writers_value;
+    this->opt.get("-writers")->getInt(writers_value);
+    this->writers = writers_value;
+  } else {
+    this->writers = 0;
+  }
+  
   if (opt.isSet("-f")) {
     int ff_value;
     this->opt.get("-f")->getInt(ff_value);
@@ -5,6 +5,7 @@
 #include <capstone.h>
 #include "distorm.h"
 #include "frontend.h"
+#include "frontend_batch.h"
 
 /**
  * @class QsimFrontend
@@ -103,6 +104,9 @@ class QsimFrontend : public frontend::Frontend<QsimFrontend>
   
     // Current instrumented instruction
     QsimInstruction cur_inst;
+
+    // Instructions batched per basic block and written by parallel writer threads (-writers), or NULL
+    frontend::FrontendBatch<QsimFrontend>* m_batch;
     
     static void __sendInstructionSpecialized(threadid_t threadid, uint32_t num_addresses, bool isbefore);
 };
@@ -173,6 +177,7 @@ void Frontend<QsimFrontend>::__sendInstructionSpecialized(threadid_t threadid, u
 
 QsimFrontend::QsimFrontend(FrontendISA theISA) 
 : finished(false)
+, m_batch(NULL)
 {
   switch(theISA)
   {
@@ -200,6 +205,9 @@ void QsimFrontend::init(int ncores, std::string statefile)
   //std::cout << "[DEBUG] Success creating OSDomain" << std::endl;
   this->m_sysmodel->set_osd(osd_p);
 
+  if (m_options->get_writers() > 0)
+    m_batch = new frontend::FrontendBatch<QsimFrontend>(m_options->get_writers(), m_thread_data);
+
   // Setup callbacks
   osd_p->set_app_start_cb(this, &QsimFrontend::app_start_cb);
   //std::cout << "[DEBUG] Success setting callbacks" << std::endl;
@@ -242,7 +250,7 @@ int QsimFrontend::app_start_cb(int c)
 
 void QsimFrontend::inst_cb(int cpu, uint64_t va, uint64_t pa, uint8_t len, const uint8_t *bytes, enum inst_type t)
 {
-  std::vector<std::string> branch_insts = {"JO", "JNO", "JB", "JAE", "JZ", "JNZ", "JBE", "JA", "JS", "JNS", "JP", "JNP", "JL", "JGE", "JLE", "JG"};
+  static const std::vector<std::string> branch_insts = {"JO", "JNO", "JB", "JAE", "JZ", "JNZ", "JBE", "JA", "JS", "JNS", "JP", "JNP", "JL", "JGE", "JLE", "JG"};
   
   if(this->num_threads == 0)  // First instruction -- initialize for the next execution
   {
@@ -323,6 +331,10 @@ void QsimFrontend::inst_cb(int cpu, uint64_t va, uint64_t pa, uint8_t len, const
       std::cerr << "[FRONTEND:"<<cur_inst.threadid<<"] emulateSyscallFunc: syscall number = " << syscall_number << std::endl;
       sift_assert(syscall_number < MAX_NUM_SYSCALLS);
 
+      // The syscall is written to the thread's output directly, after everything before it
+      if (m_batch)
+        m_batch->flush(cur_inst.threadid);
+
       // Emulate Syscall 
       m_sysmodel->emulateSyscallFunc(cur_inst.threadid, cur_inst.cpu, syscall_number);  
       std::cerr << "Last threadid: " << last_threadid << std::endl;
@@ -337,9 +349,10 @@ void QsimFrontend::inst_cb(int cpu, uint64_t va, uint64_t pa, uint8_t len, const
       }
     }
     // Send previous instruction
-    std::cerr << "["<<cur_inst.threadid<<"] Invoking sendInstruction (type = " << cur_inst.itype << \
-    ", branch = " << cur_inst.is_branch << "); Decoded: " << cur_inst.dinst->mnemonic << " " << \
-    cur_inst.dinst->operands << " A: " << std::hex << cur_inst.vaddr << " ( " << cur_inst.paddr << " ) " << " with num_addresses: " << cur_inst.num_addresses << std::endl;
+    if (m_options->get_verbose())
+      std::cerr << "["<<cur_inst.threadid<<"] Invoking sendInstruction (type = " << cur_inst.itype << \
+      ", branch = " << cur_inst.is_branch << "); Decoded: " << cur_inst.dinst->mnemonic << " " << \
+      cur_inst.dinst->operands << " A: " << std::hex << cur_inst.vaddr << " ( " << cur_inst.paddr << " ) " << " with num_addresses: " << cur_inst.num_addresses << std::dec << std::endl;
     /*
     std::cerr << "[REGs] ";
     for (std::vector<int>::const_iterator i = cur_inst.regs.begin(); i != cur_inst.regs.end(); ++i)
@@ -348,7 +361,10 @@ void QsimFrontend::inst_cb(int cpu, uint64_t va, uint64_t pa, uint8_t len, const
     for (std::vector<int>::const_iterator i = cur_inst.regtypes.begin(); i != cur_inst.regtypes.end(); ++i)
       std::cout << *i << ' ';
     std::cout << std::endl;*/
-    sendInstruction(cur_inst.threadid, cur_inst.vaddr, cur_inst.ilen, cur_inst.num_addresses, cur_inst.is_branch, cur_inst.taken, cur_inst.is_predicate, cur_inst.executing, cur_inst.isbefore, cur_inst.ispause);
+    if (m_batch)
+      m_batch->addInstruction(cur_inst.threadid, cur_inst.vaddr, cur_inst.ilen, cur_inst.num_addresses, cur_inst.is_branch, cur_inst.taken, cur_inst.is_predicate, cur_inst.executing, cur_inst.ispause);
+    else
+      sendInstruction(cur_inst.threadid, cur_inst.vaddr, cur_inst.ilen, cur_inst.num_addresses, cur_inst.is_branch, cur_inst.taken, cur_inst.is_predicate, cur_inst.executing, cur_inst.isbefore, cur_inst.ispause);
   }  
 
   // clear and update data of cur_inst for the next sending 
@@ -392,6 +408,13 @@ int QsimFrontend::app_end_cb(int c)
 {
   //std::cout << "Entered finish " << std::endl;
   finished = true;
+
+  // Write out all batched instructions before the outputs are closed
+  if (m_batch)
+  {
+    delete m_batch;
+    m_batch = NULL;
+  }
   
   //call to Fini function
   m_control->Fini(0, NULL);
@@ -2,8 +2,22 @@
 #include "inst_mode_macros.h"
 #include "pin.H"
 
+extern bool done_app_initialization;
+
 void
 InstMode::updateInstrumentationMode()
 {
-   // With TraceVersion, nothing to do here
+   // With TraceVersion, nothing to do here, unless fast-forward code is instrumented on its own
+   if (!reinstrument_fast_forward)
+      return;
+
+   bool ff_only = (inst_mode == FAST_FORWARD);
+   if (ff_only != fast_forward_only)
+   {
+      fast_forward_only = ff_only;
+      // Drop all instrumented code, traces are instrumented again (through traceCallback) when they next execute.
+      // Before the application starts there is nothing to flush yet.
+      if (done_app_initialization)
+         PIN_RemoveInstrumentation();
+   }
 }
@@ -20,9 +20,15 @@
 #include "dvfs_manager.h"
 #include "hooks_manager.h"
 #include "branch_predictor.h"
+#include "clock_skew_minimization_object.h"
 
 #include <unordered_map>
 
+static inline bool isSkippingSpin(THREADID thread_id)
+{
+   return localStore[thread_id].sld.sld && localStore[thread_id].sld.sld->isSkipping();
+}
+
 void InstructionModeling::handleInstruction(THREADID thread_id, Instruction *instruction)
 {
    Thread *thread = localStore[thread_id].thread;
@@ -30,9 +36,14 @@ void InstructionModeling::handleInstruction(THREADID thread_id, Instruction *ins
    PerformanceModel *prfmdl = core->getPerformanceModel();
 
    if (localStore[thread_id].dynins)
-      prfmdl->queueInstruction(localStore[thread_id].dynins);
+   {
+      if (isSkippingSpin(thread_id))
+         delete localStore[thread_id].dynins;
+      else
+         prfmdl->queueInstruction(localStore[thread_id].dynins);
+   }
 
-   localStore[thread_id].dynins = prfmdl->createDynamicInstruction(instruction, instruction->getAddress());
+   localStore[thread_id].dynins = prfmdl->createDynamicInstruction(instruction, instruction->getAddress(), instruction->getMemoryOperandCount());
 }
 
 void InstructionModeling::handleBasicBlock(THREADID thread_id)
@@ -44,10 +55,20 @@ void InstructionModeling::handleBasicBlock(THREADID thread_id)
 
    if (localStore[thread_id].dynins)
    {
-      prfmdl->queueInstruction(localStore[thread_id].dynins);
+      if (isSkippingSpin(thread_id))
+         delete localStore[thread_id].dynins;
+      else
+         prfmdl->queueInstruction(localStore[thread_id].dynins);
       localStore[thread_id].dynins = NULL;
    }
 
+   if (isSkippingSpin(thread_id))
+   {
+      // Confirmed spin loop: nothing it does can change until another core writes the data it spins on,
+      // which in simulated time cannot happen before the others reach the next barrier. Idle until then.
+      prfmdl->queuePseudoInstruction(new SyncInstruction(Sim()->getClockSkewMinimizationServer()->getGlobalTime(true /*upper_bound*/), SyncInstruction::SPIN));
+   }
+
 #ifndef ENABLE_PERF_MODEL_OWN_THREAD
    prfmdl->iterate();
    SubsecondTime time = prfmdl->getElapsedTime();
@@ -17,10 +17,40 @@ namespace lite
 
 Lock g_atomic_lock;
 
+// Memory operands recorded into localStore[].memops since the last handleMemoryBatch call we inserted.
+// Instrumentation is serialized by Pin, and a basic block is instrumented in one go.
+static UInt32 g_batched_memops = 0;
+
+static bool batchMemoryOperands(InstMode::inst_mode_t inst_mode)
+{
+   return INSTR_IF_CACHEONLY(inst_mode) && Sim()->getConfig()->getBatchMemopsWarmup() && !Sim()->getFaultinjectionManager();
+}
+
+static void insertMemoryBatch(INS ins)
+{
+   INS_InsertCall(ins, IPOINT_BEFORE, AFUNPTR(lite::handleMemoryBatch), IARG_THREAD_ID, IARG_END);
+   g_batched_memops = 0;
+}
+
 void addMemoryModeling(TRACE trace, INS ins, InstMode::inst_mode_t inst_mode)
 {
    if (INS_IsMemoryRead (ins) || INS_IsMemoryWrite (ins))
    {
+      // REP-prefixed instructions repeat their IPOINT_BEFORE calls for every iteration, keep those on the direct path
+      bool batch = batchMemoryOperands(inst_mode) && !INS_HasRealRep(ins);
+      if (batch)
+      {
+         // Atomic writes are only logged as a hit, keep those on the direct path
+         UInt32 count = 0;
+         for (unsigned int i = 0; i < INS_MemoryOperandCount(ins); i++)
+            count += INS_MemoryOperandIsRead(ins, i) + (INS_MemoryOperandIsWritten(ins, i) && !INS_IsAtomicUpdate(ins));
+         // Only fill half of the buffer, the other half absorbs accesses left behind by a block
+         // that did not run to its end (signal, exception)
+         if (g_batched_memops + count > ThreadLocalStorage::MAX_BATCHED_MEMOPS / 2)
+            insertMemoryBatch(ins);
+         g_batched_memops += count;
+      }
+
       for (unsigned int i = 0; i < INS_MemoryOperandCount(ins); i++)
       {
          if (INS_MemoryOperandIsRead(ins, i))
@@ -82,6 +112,15 @@ void addMemoryModeling(TRACE trace, INS ins, InstMode::inst_mode_t inst_mode)
                      IARG_END);
                }
             }
+            else if (batch)
+            {
+               INS_InsertPredicatedCall(ins, IPOINT_BEFORE, AFUNPTR(lite::recordMemoryAccess),
+                     IARG_FAST_ANALYSIS_CALL,
+                     IARG_THREAD_ID,
+                     IARG_BOOL, false,
+                     IARG_MEMORYOP_EA, i,
+                     IARG_END);
+            }
             else
             {
                INSTRUMENT(
@@ -143,6 +182,15 @@ void addMemoryModeling(TRACE trace, INS ins, InstMode::inst_mode_t inst_mode)
                      IARG_UINT32, INS_MemoryOperandSize(ins, i),
                      IARG_END);
             }
+            else if (batch && !INS_IsAtomicUpdate(ins))
+            {
+               INS_InsertPredicatedCall(ins, IPOINT_BEFORE, AFUNPTR(lite::recordMemoryAccess),
+                     IARG_FAST_ANALYSIS_CALL,
+                     IARG_THREAD_ID,
+                     IARG_BOOL, true,
+                     IARG_MEMORYOP_EA, i,
+                     IARG_END);
+            }
             else
             {
                INSTRUMENT(
@@ -176,6 +224,31 @@ void addMemoryModeling(TRACE trace, INS ins, InstMode::inst_mode_t inst_mode)
    }
 }
 
+void addMemoryBatchFlush(TRACE trace, INS ins, InstMode::inst_mode_t inst_mode)
+{
+   // Called for the last instruction of a basic block, after its memory operands were recorded
+   if (g_batched_memops)
+      insertMemoryBatch(ins);
+}
+
+// Simple enough for Pin to inline: no calls, no branches
+VOID PIN_FAST_ANALYSIS_CALL recordMemoryAccess(THREADID thread_id, BOOL is_write, ADDRINT address)
+{
+   ThreadLocalStorage &ls = localStore[thread_id];
+   ls.memops.address[ls.memops.count] = address;
+   ls.memops.is_write[ls.memops.count] = is_write;
+   ++ls.memops.count;
+}
+
+void handleMemoryBatch(THREADID thread_id)
+{
+   Core *core = localStore[thread_id].thread->getCore();
+   assert(core);
+   for (UInt32 i = 0; i < localStore[thread_id].memops.count; ++i)
+      core->accessMemoryFast(false, localStore[thread_id].memops.is_write[i] ? Core::WRITE : Core::READ, localStore[thread_id].memops.address[i]);
+   localStore[thread_id].memops.count = 0;
+}
+
 void handleMemoryRead(THREADID thread_id, BOOL executing, ADDRINT eip, bool is_atomic_update, IntPtr read_address, UInt32 read_data_size)
 {
    Core *core = localStore[thread_id].thread->getCore();
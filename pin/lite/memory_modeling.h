@@ -8,6 +8,10 @@ namespace lite
 {
 
 void addMemoryModeling(TRACE trace, INS ins, InstMode::inst_mode_t inst_mode);
+// With general/batch_memops_warmup, cache-only accesses are recorded inline and issued at the end of each basic block
+void addMemoryBatchFlush(TRACE trace, INS ins, InstMode::inst_mode_t inst_mode);
+VOID PIN_FAST_ANALYSIS_CALL recordMemoryAccess(THREADID thread_id, BOOL is_write, ADDRINT address);
+void handleMemoryBatch(THREADID thread_id);
 void handleMemoryRead(THREADID thread_id, BOOL executing, ADDRINT eip, bool is_atomic_update, IntPtr read_address, UInt32 read_data_size);
 void handleMemoryReadDetailed(THREADID thread_id, BOOL executing, ADDRINT eip, bool is_atomic_update, IntPtr read_address, UInt32 read_data_size);
 void handleMemoryReadDetailedIssue(THREADID thread_id, BOOL executing, ADDRINT eip, bool is_atomic_update, IntPtr read_address, UInt32 read_data_size);
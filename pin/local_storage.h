@@ -37,6 +37,15 @@ struct ThreadLocalStorage
    static const unsigned int NUM_SCRATCHPADS = 3;
    static const size_t SCRATCHPAD_SIZE = 1024;
    char* scratch[NUM_SCRATCHPADS];
+
+   // Cache-only memory accesses of the current basic block, issued by lite::handleMemoryBatch
+   static const unsigned int MAX_BATCHED_MEMOPS = 64;
+   struct
+   {
+      UInt32 count;
+      ADDRINT address[MAX_BATCHED_MEMOPS];
+      bool is_write[MAX_BATCHED_MEMOPS];
+   } memops;
 };
 // Keep track of THREADID to Thread* pointers (and some other stuff), way faster than a PinTLS lookup
 extern std::vector<ThreadLocalStorage> localStore;
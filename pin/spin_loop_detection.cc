@@ -21,6 +21,10 @@ static void spinloopHandleBranch(THREADID thread_id, ADDRINT eip, BOOL taken, AD
    {
       localStore[thread_id].sld.sld->commitBCT(eip);
    }
+   else if (!taken)
+   {
+      localStore[thread_id].sld.sld->commitFallThrough(eip);
+   }
 }
 
 static void spinloopHandleWriteBefore(THREADID thread_id, ADDRINT addr)
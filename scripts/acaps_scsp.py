@@ -60,34 +60,15 @@ class Scsp:
       self.avg_core_frequency_cont[i] = 0.0
 
     self.results_folder = sim.config.output_dir
-    self.stats_file = sim.config.output_dir + "acaps_scsp_stats.csv"
     self.res_file = sim.config.output_dir + "acaps_scsp_res.csv"
 
     print("[ACAPS_SCSP] Calling interval [ns]: " + str(self.calling_interval_ns))
     print("[ACAPS_SCSP] Idle freq. [MHz]: " + str(self.idle_freq_mhz))
     print("[ACAPS_SCSP] Predictor confidence: " + str(self.predictor_confidence))
 
-    # Check if the file exists, and delete it if it does
-    if os.path.exists(self.stats_file):
-        os.remove(self.stats_file)
-
-    with open(self.stats_file, 'w') as csvfile:
-      # Create a CSV writer object
-      csv_writer = csv.writer(csvfile)
-      
-      # Write the header to the CSV file
-      header = ["Time", "Core" , "Actual State", "Predicted State"]
-      csv_writer.writerow(header)
+    # Frequency decisions are applied in one batch per period, run with -g --dvfs/trace=true to record them in sim.dvfs.bin
+    self.decisions = [ 0 ] * self.num_cores
 
-  def append_stats(self, data):
-    # Append data to an existing CSV file
-    with open(self.stats_file, 'a', ) as csvfile:
-        # Create a CSV writer object
-        csv_writer = csv.writer(csvfile)
-        
-        # Write the data to the CSV file
-        csv_writer.writerow(data)
-  
   def adjust_frequency(self, core, state):
       new_freq = None
       
@@ -98,25 +79,25 @@ class Scsp:
       else:
         new_freq = self.config_freq_mhz
 
-      actual_freq = sim.dvfs.get_frequency(core)
-
-      if (actual_freq != new_freq):
-        sim.dvfs.set_frequency(core, new_freq)
+      # Applied at the end of the period, together with the decisions for the other cores
+      self.decisions[core] = new_freq
 
   def periodic(self, time, time_delta):
     # Don't do anythin on the first call 
     if time_delta == 0:
       return
 
+    states = sim.dvfs.get_core_states()
+    freqs = sim.dvfs.get_frequencies()
     for core in range(0, self.num_cores):
-      actual_state = sim.dvfs.get_core_state(core)
+      actual_state = states[core]
       # if core state is 5, print the actual state
       if actual_state == 5:
         print("Core %d is in IDLE state" % core)
       predictor = self.acsp[core]
 
       # Calculate average frequency for each core
-      actual_freq = float(sim.dvfs.get_frequency(core))
+      actual_freq = float(freqs[core])
       self.avg_core_frequency_cont[core] += 1.0
       self.avg_core_frequency[core] = ((self.avg_core_frequency_cont[core] - 1) * self.avg_core_frequency[core] + actual_freq) / self.avg_core_frequency_cont[core]
       
@@ -132,10 +113,6 @@ class Scsp:
         if (predicted_value != actual_state):
           self.adjust_frequency(core, actual_state)
 
-        # stats = predictor.get_stats()
-        # data = [time, core, actual_state, predicted_value]
-        # self.append_stats(data)
-
       # Regular predictor updates
       predictor.update(actual_state)
 
@@ -144,6 +121,11 @@ class Scsp:
           predicted_state = predictor.predict_next_value()
           self.adjust_frequency(core, predicted_state)
 
+    # Domains whose frequency does not change are not charged a transition
+    if any(self.decisions):
+      sim.dvfs.set_frequencies(self.decisions)
+      self.decisions = [ 0 ] * self.num_cores
+
   def build_dvfs_table(self, tech):
     # Build a table of (frequency, voltage) pairs.
     # Frequencies should be from high to low, and end with zero (or the lowest possible frequency)
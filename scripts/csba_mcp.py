@@ -271,11 +271,12 @@ class CoreStateAndBranchMonitor:
             return
 
         num_cores = sim.config.ncores
+        states = sim.dvfs.get_core_states()
         for core_id in range(num_cores):
             event_id = self.global_event_id
             self.global_event_id += 1
 
-            state_id = sim.dvfs.get_core_state(core_id)
+            state_id = states[core_id]
             
             # Log the current core state
             self.core_state_log.append((event_id, core_id, state_id, time_fs))
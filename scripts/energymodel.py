@@ -0,0 +1,152 @@
+"""
+Make energy available as a statistic using the in-simulator energy model
+
+Like energystats.py, this provides <component>.energy-static and <component>.energy-dynamic statistics (fJ),
+for core, L1-I, L1-D and L2 (per core), uncore (the rest of the processor) and dram.
+Instead of running McPAT at every interval, McPAT is run once, over a calibration period at the start of the ROI.
+From its result, a static power and a dynamic energy per event (instructions, cache and DRAM accesses) are derived
+for every component, after which the simulator evaluates energy natively from the statistics (sim.power).
+Energy follows DVFS changes through the Vdd table for the technology node.
+
+Argument is the length of the calibration period in ns (default: 1 ms)
+Example:
+-s energymodel:500000
+"""
+
+import sys, os, sim
+
+
+def build_dvfs_table(tech):
+  # Build a table of (frequency, voltage) pairs.
+  # Frequencies should be from high to low, and end with zero (or the lowest possible frequency)
+  if tech == 22:
+    return [ (2000, 1.0), (1800, 0.9), (1500, 0.8), (1000, 0.7), (0, 0.6) ]
+  elif tech == 45:
+    return [ (2000, 1.2), (1800, 1.1), (1500, 1.0), (1000, 0.9), (0, 0.8) ]
+  else:
+    raise ValueError('No DVFS table available for %d nm technology node' % tech)
+
+
+class EnergyModel:
+  def setup(self, args):
+    args = dict(enumerate((args or '').split(':')))
+    calibration_ns = int(args.get(0, None) or 1000000)
+    sim.util.Every(calibration_ns * sim.util.Time.NS, self.periodic, roi_only = True)
+    self.dvfs_table = build_dvfs_table(int(sim.config.get('power/technology_node')))
+    sim.power.set_vdd_table(self.dvfs_table)
+    self.name_begin = None
+    self.calibrated = False
+
+  def periodic(self, time, time_delta):
+    if self.calibrated:
+      return
+    if not self.name_begin:
+      self.name_begin = 'energymodel-calibration-begin'
+      sim.stats.write(self.name_begin)
+      self.time_begin = sim.stats.time()
+      self.activity_begin = self.get_activity()
+    elif sim.stats.time() > self.time_begin:
+      name_end = 'energymodel-calibration-end'
+      sim.stats.write(name_end)
+      seconds = (sim.stats.time() - self.time_begin) / 1e15
+      activity = self.get_activity()
+      for component in activity:
+        activity[component] = sum(activity[component].values()) - sum(self.activity_begin[component].values())
+      self.calibrate(self.run_power(self.name_begin, name_end), activity, seconds)
+      sim.util.db_delete(self.name_begin)
+      sim.util.db_delete(name_end)
+      self.calibrated = True
+
+  def get_terms(self):
+    # Statistics that drive the dynamic energy of each component
+    terms = {}
+    for core in range(sim.config.ncores):
+      terms[('core', core)] = [ ('performance_model', core, 'instruction_count') ]
+      terms[('L1-I', core)] = [ ('L1-I', core, 'loads') ]
+      terms[('L1-D', core)] = [ ('L1-D', core, 'loads'), ('L1-D', core, 'stores') ]
+      terms[('L2', core)] = [ ('L2', core, 'loads'), ('L2', core, 'stores') ]
+    terms[('uncore', 0)] = self.existing([ ('L3', core, metric) for core in range(sim.config.ncores) for metric in ('loads', 'stores') ])
+    terms[('dram', 0)] = self.existing([ ('dram', core, metric) for core in range(sim.config.ncores) for metric in ('reads', 'writes') ])
+    return terms
+
+  def existing(self, terms):
+    def exists(term):
+      try:
+        sim.stats.get(*term)
+        return True
+      except ValueError:
+        return False
+    return list(filter(exists, terms))
+
+  def get_activity(self):
+    return dict([ (component, dict([ (term, sim.stats.get(*term)) for term in terms ])) for component, terms in self.get_terms().items() ])
+
+  def get_power(self, power):
+    def get_power(component, prefix = ''):
+      return (component[prefix + 'Subthreshold Leakage'] + component[prefix + 'Gate Leakage'], component[prefix + 'Runtime Dynamic'])
+    def sub(a, *b):
+      return (a[0] - sum([ v[0] for v in b ]), a[1] - sum([ v[1] for v in b ]))
+    result = {}
+    for core in range(sim.config.ncores):
+      result[('L1-I', core)] = get_power(power['Core'][core], 'Instruction Fetch Unit/Instruction Cache/')
+      result[('L1-D', core)] = get_power(power['Core'][core], 'Load Store Unit/Data Cache/')
+      result[('L2',   core)] = get_power(power['Core'][core], 'L2/')
+      result[('core', core)] = sub(get_power(power['Core'][core]), result[('L1-I', core)], result[('L1-D', core)], result[('L2', core)])
+    result[('uncore', 0)] = sub(get_power(power['Processor']), *[ get_power(power['Core'][core]) for core in range(sim.config.ncores) ])
+    result[('dram', 0)] = get_power(power['DRAM'])
+    return result
+
+  def calibrate(self, power, activity, seconds):
+    terms = self.get_terms()
+    print('[ENERGYMODEL] Calibrated over %.1f us:' % (seconds * 1e6))
+    for (component, index), (static, dynamic) in sorted(self.get_power(power).items()):
+      events = activity[(component, index)]
+      if events:
+        energy = dynamic * seconds / events
+      else:
+        # No activity to attribute dynamic power to: count it as static
+        static += dynamic
+        energy = 0
+      core = index if component not in ('uncore', 'dram') else -1
+      sim.power.set_component(component, index, core, static, [ term + (energy,) for term in terms[(component, index)] ])
+      print('[ENERGYMODEL]   %-6s %3d: static %.3f W, dynamic %.3f nJ/event' % (component, index, static, energy * 1e9))
+
+  def gen_config(self, outputbase):
+    freq = [ sim.dvfs.get_frequency(core) for core in range(sim.config.ncores) ]
+    vdd = [ self.get_vdd_from_freq(f) for f in freq ]
+    configfile = outputbase+'.cfg'
+    cfg = open(configfile, 'w')
+    cfg.write('''
+[perf_model/core]
+frequency[] = %s
+[power]
+vdd[] = %s
+    ''' % (','.join(['%f' % (f / 1000.) for f in freq]), ','.join(map(str, vdd))))
+    cfg.close()
+    return configfile
+
+  def get_vdd_from_freq(self, f):
+    # Assume self.dvfs_table is sorted from highest frequency to lowest
+    for _f, _v in self.dvfs_table:
+      if f >= _f:
+        return _v
+    assert ValueError('Could not find a Vdd for invalid frequency %f' % f)
+
+  def run_power(self, name0, name1):
+    outputbase = os.path.join(sim.config.output_dir, 'energymodel-calibration')
+
+    configfile = self.gen_config(outputbase)
+
+    os.system('unset PYTHONHOME; %s -d %s -o %s -c %s --partial=%s:%s --no-graph --no-text' % (
+      os.path.join(os.getenv('SNIPER_ROOT'), 'tools/mcpat.py'),
+      sim.config.output_dir,
+      outputbase,
+      configfile,
+      name0, name1
+    ))
+
+    result = {}
+    exec(compile(open(outputbase + '.py', "rb").read(), outputbase + '.py', 'exec'), {}, result)
+    return result['power']
+
+sim.util.register(EnergyModel())
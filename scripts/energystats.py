@@ -6,6 +6,8 @@ Works by registering a PRE_STAT_WRITE hook, which, before a stats snapshot write
 - Calls McPAT on the partial period (last-snapshot, energystats-temp)
 - Processes the McPAT results, making them available through custom-callback statistics
 - Finally the actual snapshot is written, including updated values for all energy counters
+
+For fine-grained intervals, energymodel.py runs McPAT only once and evaluates energy inside the simulator.
 """
 
 import sys, os, sim
@@ -0,0 +1,55 @@
+"""
+qos-partition.py
+
+Dynamic last-level cache partitioning through sim.qos (needs perf_model/qos/enabled=true).
+Every interval, the ways of the last-level cache are split over the classes of service that have cores,
+proportionally to the DRAM traffic each class generated in that interval (at least one way each),
+as contiguous way masks like Intel CAT requires.
+
+Arguments:
+- <interval_ns> repartitioning interval (default 1 ms)
+- <min_ways> minimum number of ways per class (default 1)
+
+Example:
+-s qos-partition:100000:2
+"""
+
+import sim
+
+class QosPartition:
+  def setup(self, args):
+    args = dict(enumerate((args or '').split(':')))
+    self.interval = int(int(args.get(0, '') or 1000000) * sim.util.Time.NS)
+    self.min_ways = int(args.get(1, '') or 1)
+
+    levels = int(sim.config.get('perf_model/cache/levels'))
+    self.ways = int(sim.config.get('perf_model/l%d_cache/associativity' % levels))
+    self.traffic = list(sim.qos.get_traffic_all())
+    sim.util.Every(self.interval, self.periodic, roi_only = True)
+
+  def periodic(self, time, time_delta):
+    traffic = list(sim.qos.get_traffic_all())
+    classes = {}
+    for core in range(sim.config.ncores):
+      clos = sim.qos.get_class(core)
+      classes[clos] = classes.get(clos, 0) + traffic[core] - self.traffic[core]
+    self.traffic = traffic
+
+    if len(classes) * self.min_ways > self.ways:
+      return
+
+    # Hand out the minimum, then the rest of the ways proportionally to each class' traffic
+    spare = self.ways - len(classes) * self.min_ways
+    total = sum(classes.values())
+    order = sorted(classes)
+    alloc = { clos: self.min_ways + (spare * classes[clos] // total if total else spare // len(classes)) for clos in order }
+    # Give ways lost to rounding to the classes with the most traffic
+    for clos in sorted(order, key = lambda clos: -classes[clos])[:self.ways - sum(alloc.values())]:
+      alloc[clos] += 1
+
+    first = 0
+    for clos in order:
+      sim.qos.set_way_mask(clos, ((1 << alloc[clos]) - 1) << first)
+      first += alloc[clos]
+
+sim.util.register(QosPartition())
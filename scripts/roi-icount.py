@@ -3,10 +3,10 @@
 # This script will switch to warmup after X instructions,
 # run in cache-only mode for Y instructions,
 # run Z instructions in detailed mode,
-# and then fast-forward to the end.
+# and then fast-forward to the end (or stop the simulation if the fourth argument is "stop").
 # X can be roi+X for ROI-relative start
 #
-# run-sniper --roi-script --no-cache-warming -s roi-icount:X:Y:Z
+# run-sniper --roi-script --no-cache-warming -s roi-icount:X:Y:Z[:stop]
 #
 # Start the simulation with "--roi-script --no-cache-warming"
 # to start in fast-forward mode and ignore SimRoi{Start,End}
@@ -34,6 +34,7 @@ class RoiIcount:
     self.init_length = int(start or 0)
     self.warmup_length = int(args.get(1, '') or 0)
     self.detailed_length = int(args.get(2, '') or 0)
+    self.stop = args.get(3, '') == 'stop'
 
     if self.detailed_length < 1:
       print('[ROI-ICOUNT] Detailed instrucion count cannot be 0', file=sys.stderr)
@@ -83,6 +84,9 @@ class RoiIcount:
       print('[ROI-ICOUNT] Icount = %d: ending ROI' % icount)
       sim.control.set_roi(False)
       self.state = 'done'
+      if self.stop:
+        print('[ROI-ICOUNT] Stopping simulation')
+        sim.control.abort()
 
     if self.state in ('init', 'warmup') and icount >= self.offset + self.init_length + self.warmup_length:
       print('[ROI-ICOUNT] Icount = %d: beginning ROI' % icount)
@@ -6,6 +6,8 @@ import sim_control as control
 import sim_bbv as bbv
 import sim_mem as mem
 import sim_thread as thread
+import sim_power as power
+import sim_qos as qos
 import sim.util
 
 import os, sqlite3
@@ -1,4 +1,4 @@
-import sys, sim
+import sys, struct, sim
 
 """
 Conversion factors for subsecondtime (femtoseconds) to other units
@@ -19,14 +19,19 @@ Register an object as being a hooks listener.
   Will register hooks callback functions to the object's member functions with matching (lowercase) names
   I.e. obj.hook_roi_begin will be called at HOOK_ROI_BEGIN, etc.
   Additionally, obj.setup(arg) will be called with <arg> being the script's arguments
+  With asynchronous = True, callbacks for hooks in sim.hooks.async_hooks run on a separate thread, after the event
+  (though before ROI end and statistics writes), so they cannot return a value and see the simulator at a later time
 """
 
-def register(obj):
+def register(obj, asynchronous = False):
 
   for name, hook in list(sim.hooks.hooks.items()):
     func = getattr(obj, name.lower(), None)
     if func and callable(func):
-      sim.hooks.register(hook, func)
+      if asynchronous and name in sim.hooks.async_hooks:
+        sim.hooks.register_async(hook, func)
+      else:
+        sim.hooks.register(hook, func)
 
   if hasattr(obj, 'setup') and callable(obj.setup):
     obj.setup(sys.argv[1])
@@ -130,6 +135,21 @@ class StatsDelta:
       return True
 
 
+def schedule(interval, callback, instructions = False):
+  """
+  Call callback(now, now_delta) every <interval> fs, or instructions with instructions = True.
+    The interval is tracked natively, Python is only entered when the callback is due.
+    Return False from the callback to stop.
+  """
+  last = [ 0 ]
+  def timer(now):
+    now_delta, last[0] = now - last[0], now
+    if callback(now, now_delta) is False:
+      return None
+    return int(now + interval)
+  sim.hooks.schedule(int(interval), timer, instructions)
+
+
 class Every:
   def __init__(self, interval, callback, statsdelta = None, roi_only = True):
     min_interval = int(sim.config.get('clock_skew_minimization/barrier/quantum')) * 1e6
@@ -142,11 +162,30 @@ class Every:
     self.time_next = 0
     self.time_last = 0
     self.in_roi = False
-    register(self)
+    self.scheduled = False
+    # No HOOK_PERIODIC, a native timer calls us when time_next is reached
+    sim.hooks.register(sim.hooks.HOOK_ROI_BEGIN, self.hook_roi_begin)
+    sim.hooks.register(sim.hooks.HOOK_ROI_END, self.hook_roi_end)
+    if not self.roi_only:
+      self.schedule()
+
+  def schedule(self):
+    if not self.scheduled:
+      self.scheduled = True
+      sim.hooks.schedule(int(self.time_next), self.timer)
+
+  def timer(self, time):
+    if self.roi_only and not self.in_roi:
+      # Rescheduled at the next ROI begin
+      self.scheduled = False
+      return None
+    self.hook_periodic(time)
+    return int(self.time_next)
 
   def hook_roi_begin(self):
     self.in_roi = True
     self.hook_periodic(sim.stats.time())
+    self.schedule()
 
   def hook_roi_end(self):
     self.hook_periodic(sim.stats.time())
@@ -178,10 +217,27 @@ class EveryIns:
     self.icount_next = interval
     self.icount_last = 0
     self.in_roi = False
-    register(self)
+    self.scheduled = False
+    sim.hooks.register(sim.hooks.HOOK_ROI_BEGIN, self.hook_roi_begin)
+    sim.hooks.register(sim.hooks.HOOK_ROI_END, self.hook_roi_end)
+    if not self.roi_only:
+      self.schedule()
+
+  def schedule(self):
+    if not self.scheduled:
+      self.scheduled = True
+      sim.hooks.schedule(int(self.icount_next), self.timer, True)
+
+  def timer(self, icount):
+    if self.roi_only and not self.in_roi:
+      self.scheduled = False
+      return None
+    self.hook_periodic_ins(icount)
+    return int(self.icount_next)
 
   def hook_roi_begin(self):
     self.in_roi = True
+    self.schedule()
 
   def hook_roi_end(self):
     self.in_roi = False
@@ -235,6 +291,180 @@ class EveryBranch:
             self.callback(ip, predicted == 1, actual == 1, indirect == 1, core_id)
 
 
+class EveryBranchBatch:
+    """
+    Batched variant of EveryBranch.
+
+    Branch records are buffered per core on the simulator side and delivered in batches of up to
+    hooks/branch_batch_size records, and at every barrier (HOOK_PERIODIC), ROI end and simulation end.
+    The callback receives:
+        core_id (int): ID of the core the records belong to
+        records: a numpy structured array with fields ip, predicted, actual, indirect, core_id
+                 if numpy is available (and as_numpy is set), else a list of
+                 (ip, predicted, actual, indirect, core_id) tuples
+
+    The numpy array is only valid for the duration of the callback, use records.copy() to keep it.
+
+    Example usage:
+        def handle_branches(core_id, records):
+            mispredicts = (records['predicted'] != records['actual']).sum()
+
+        sim.util.EveryBranchBatch(handle_branches)
+    """
+    # Must match HooksManager::BranchPrediction
+    FORMAT = '=QBBBxi'
+
+    def __init__(self, callback, roi_only=True, as_numpy=True):
+        self.callback = callback
+        self.roi_only = roi_only
+        self.in_roi = False
+        self.numpy = None
+        if as_numpy:
+            try:
+                import numpy
+                self.numpy = numpy
+                self.dtype = numpy.dtype([('ip', '<u8'), ('predicted', 'u1'), ('actual', 'u1'), ('indirect', 'u1'), ('_pad', 'u1'), ('core_id', '<i4')])
+            except ImportError:
+                pass
+        register(self)
+
+    def hook_roi_begin(self):
+        self.in_roi = True
+
+    def hook_roi_end(self):
+        self.in_roi = False
+
+    def hook_branch_predict_batch(self, core_id, view):
+        if not self.roi_only or self.in_roi:
+            if self.numpy:
+                records = self.numpy.frombuffer(view, dtype=self.dtype)
+            else:
+                import struct
+                records = list(struct.iter_unpack(self.FORMAT, view))
+            self.callback(core_id, records)
+
+
+class EveryMemorySampleBatch:
+    """
+    Receive sampled memory accesses ([memory_sampler] with output = python).
+
+    Samples are buffered per core on the simulator side and delivered in batches of up to
+    memory_sampler/buffer_size records, and at every barrier (HOOK_PERIODIC), ROI end and simulation end.
+    The callback receives:
+        core_id (int): ID of the core the records belong to
+        records: a numpy structured array with fields address, eip, latency (fs), core_id, hit_where, is_write
+                 if numpy is available (and as_numpy is set), else a list of
+                 (address, eip, latency, core_id, hit_where, is_write) tuples
+
+    The numpy array is only valid for the duration of the callback, use records.copy() to keep it.
+    sim.memsamples.bin (output = file) holds the same records after an 8-byte magic.
+
+    Example usage:
+        def handle_samples(core_id, records):
+            pages = numpy.unique(records['address'] >> 12)
+
+        sim.util.EveryMemorySampleBatch(handle_samples)
+    """
+    # Must match HooksManager::MemorySample
+    FORMAT = '=QQQiBBxx'
+
+    def __init__(self, callback, roi_only=True, as_numpy=True):
+        self.callback = callback
+        self.roi_only = roi_only
+        self.in_roi = False
+        self.numpy = None
+        if as_numpy:
+            try:
+                import numpy
+                self.numpy = numpy
+                self.dtype = numpy.dtype([('address', '<u8'), ('eip', '<u8'), ('latency', '<u8'), ('core_id', '<i4'), ('hit_where', 'u1'), ('is_write', 'u1'), ('_pad', '<u2')])
+            except ImportError:
+                pass
+        register(self)
+
+    def hook_roi_begin(self):
+        self.in_roi = True
+
+    def hook_roi_end(self):
+        self.in_roi = False
+
+    def hook_memory_sample_batch(self, core_id, view):
+        if not self.roi_only or self.in_roi:
+            if self.numpy:
+                records = self.numpy.frombuffer(view, dtype=self.dtype)
+            else:
+                import struct
+                records = list(struct.iter_unpack(self.FORMAT, view))
+            self.callback(core_id, records)
+
+
+class EveryCoreStateChange:
+  """
+  Call a function whenever a core changes state (HOOK_CORE_STATE_CHANGE).
+    The callback receives (core_id, old_state, new_state, time), with states as in Core::State
+    (RUNNING = 0, INITIALIZING, STALLED, SLEEPING, WAKING_UP, IDLE, BROKEN) and time in femtoseconds.
+    When <cores> is given, only changes on those cores are reported (filtered inside the simulator).
+  """
+  def __init__(self, callback, cores = None, roi_only = False):
+    self.callback = callback
+    self.roi_only = roi_only
+    self.in_roi = False
+    if cores is None:
+      sim.hooks.register(sim.hooks.HOOK_CORE_STATE_CHANGE, self.hook_core_state_change)
+    else:
+      sim.hooks.register_core_state_change(self.hook_core_state_change, list(cores))
+    if roi_only:
+      sim.hooks.register(sim.hooks.HOOK_ROI_BEGIN, self.hook_roi_begin)
+      sim.hooks.register(sim.hooks.HOOK_ROI_END, self.hook_roi_end)
+
+  def hook_roi_begin(self):
+    self.in_roi = True
+
+  def hook_roi_end(self):
+    self.in_roi = False
+
+  def hook_core_state_change(self, core_id, old_state, new_state, time):
+    if not self.roi_only or self.in_roi:
+      self.callback(core_id, old_state, new_state, time)
+
+
+class CoreStateHistory:
+  """
+  Read a core's most recent states and how long it spent in each ([core/state_history] size),
+    maintained by the simulator on every state change, without any bookkeeping in Python.
+    Entries are (state, duration) pairs, with states as in Core::State and durations in femtoseconds;
+    last(n) returns the n newest ones, oldest first. The view is on the live ring, so every call
+    reflects the changes up to now. as_numpy() gives the raw ring as a numpy structured array
+    (in ring order, use count() % size to find the oldest entry once the ring has wrapped).
+  """
+  # Must match CoreStateHistory::Header and CoreStateHistory::Entry
+  HEADER = '=QII'
+  ENTRY = '=IIQ'
+
+  def __init__(self, core_id):
+    self.view = sim.control.get_core_state_history(core_id)
+    if self.view is None:
+      raise ValueError('Core state history is disabled, set core/state_history/size')
+    self.size = struct.unpack_from(self.HEADER, self.view)[1]
+    self.offset = struct.calcsize(self.HEADER)
+    self.entry_size = struct.calcsize(self.ENTRY)
+
+  def count(self):
+    return struct.unpack_from('=Q', self.view)[0]
+
+  def __len__(self):
+    return min(self.count(), self.size)
+
+  def last(self, n = None):
+    count = self.count()
+    n = min(count, self.size, self.size if n is None else n)
+    return [ struct.unpack_from(self.ENTRY, self.view, self.offset + self.entry_size * (i % self.size))[::2] for i in range(count - n, count) ]
+
+  def as_numpy(self):
+    import numpy
+    return numpy.frombuffer(self.view, dtype = numpy.dtype([('state', '<u4'), ('_pad', '<u4'), ('duration', '<u8')]), offset = self.offset)
+
+
 have_deleted_stats = False
 def db_delete(prefix, in_sim_end = False):
   global have_deleted_stats
@@ -0,0 +1,183 @@
+"""
+viz-stream.py
+
+Generate the level 2 data of tools/viz (cycle stacks and IPC over time) while the simulation runs
+1st argument is the interval size in nanoseconds (default is 1e6 = 1 ms of simulated time)
+2nd argument is the visualization output directory, relative to the simulation output directory (default is viz)
+
+Every interval a periodic-<time> statistics snapshot is written, as periodic-stats.py does (do not use both).
+The CPI stack of the interval is computed from the pre-aggregated sim.cpistack file (general/cpistack_file = true)
+and appended to <vizdir>/levels/level2/data/stream.jsonl, only the last snapshot is kept in memory.
+At the end of the simulation the stream is converted into the level 2 JSON files, the other levels can then be
+added with: tools/viz/viz.py --streamed -o <vizdir>
+The fixed instruction count views need the total instruction count up front and are left empty.
+"""
+
+import sys, os, json, sim
+
+sys.path.append(os.path.join(os.getenv('SNIPER_ROOT'), 'tools'))
+import sniper_lib, sniper_stats, cpistack, cpistack_items
+
+
+class CpiStackTail(sniper_stats.SniperStatsBase):
+  """Reads sim.cpistack as it is being written, holding only the two most recent snapshots."""
+  def __init__(self, filename):
+    self.fp = open(filename, 'rb')
+    self.names = {}
+    self.prefixes = []
+    self.snapshots = {}
+
+  def update(self):
+    # Snapshots are flushed whole, so everything up to EOF is complete
+    values = None
+    for line in self.fp.readlines():
+      if line.startswith(b'name '):
+        _, nameid, objectname, metricname = line.split()
+        self.names[int(nameid)] = (objectname.decode(), metricname.decode())
+      elif line.startswith(b'snapshot '):
+        prefix = line[9:].rstrip(b'\n').decode()
+        values = {}
+        self.snapshots[prefix] = values
+        self.prefixes.append(prefix)
+        while len(self.prefixes) > 2:
+          del self.snapshots[self.prefixes.pop(0)]
+      elif line.startswith(b'#') or values is None:
+        continue
+      else:
+        fields = line.split()
+        values[int(fields[0])] = dict([ (idx, int(value)) for idx, value in enumerate(fields[1:]) if value != b'0' ])
+
+  def get_snapshots(self):
+    return self.prefixes
+
+  def read_snapshot(self, prefix, metrics = None):
+    if prefix not in self.snapshots:
+      raise ValueError('Invalid prefix %s' % prefix)
+    return self.snapshots[prefix]
+
+
+class VizStream:
+  def setup(self, args):
+    args = dict(enumerate((args or '').split(':')))
+    interval = int(args.get(0, '') or 1000000)
+    self.outputdir = os.path.join(sim.config.output_dir, args.get(1, '') or 'viz')
+    self.datadir = os.path.join(self.outputdir, 'levels', 'level2', 'data')
+    self.title = os.path.basename(os.path.abspath(sim.config.output_dir)).replace(' ', '_')
+    self.interval = int(interval * sim.util.Time.NS)
+    self.next_interval = float('inf')
+    self.num_intervals = 0
+    self.last_prefix = None
+    self.stream = None
+    self.used = set()
+    self.enabled = sim.config.get_bool('general/cpistack_file')
+    if not self.enabled:
+      print('[VIZ] general/cpistack_file is disabled, not streaming visualization data', file = sys.stderr)
+      return
+    sim.util.Every(self.interval, self.periodic, roi_only = True)
+
+  def hook_roi_begin(self):
+    if not self.enabled:
+      return
+    if self.stream is None:
+      if not os.path.isdir(self.datadir):
+        os.makedirs(self.datadir)
+      # sim.cfg and sim.cpistack exist once the simulation has started
+      self.config = sniper_lib.get_config(resultsdir = sim.config.output_dir)
+      self.tail = CpiStackTail(os.path.join(sim.config.output_dir, 'sim.cpistack'))
+      self.stream = open(os.path.join(self.datadir, 'stream.jsonl'), 'w')
+    self.next_interval = sim.stats.time() + self.interval
+    # No record for the time spent outside of the ROI
+    self.last_prefix = None
+    self.snapshot('periodic-%d' % (self.num_intervals * self.interval))
+
+  def hook_roi_end(self):
+    self.next_interval = float('inf')
+
+  def periodic(self, time, time_delta):
+    if time >= self.next_interval:
+      self.num_intervals += 1
+      self.snapshot('periodic-%d' % (self.num_intervals * self.interval))
+      self.next_interval += self.interval
+
+  def snapshot(self, prefix):
+    sim.stats.write(prefix)
+    self.tail.update()
+    if self.last_prefix:
+      try:
+        results = cpistack.cpistack_compute(
+          config = self.config,
+          stats = self.tail,
+          partial = (self.last_prefix, prefix),
+          use_simple = False,
+          use_simple_mem = True,
+          no_collapse = True,
+          aggregate = True,
+        )
+        data = results.get_data('cpi')[0]
+      except ValueError:
+        # Nothing useful in this interval
+        data = {}
+      cpi = dict([ (key, value) for key, value in data.items() if value > 0 ])
+      totalcpi = sum(cpi.values())
+      record = dict(x = (self.num_intervals - 1) * self.interval / 1e9, ipc = 1. / totalcpi if totalcpi > 0 else 0, cpi = cpi)
+      self.stream.write(json.dumps(record) + '\n')
+      self.stream.flush()
+      self.used.update(cpi.keys())
+    self.last_prefix = prefix
+
+  def records(self):
+    for line in open(os.path.join(self.datadir, 'stream.jsonl')):
+      yield json.loads(line)
+
+  def write_series(self, name, components, value):
+    # One pass over the stream per component, so the output never has to be held in memory
+    out = open(os.path.join(self.datadir, '%s-%s.json' % (self.title, name)), 'w')
+    out.write('[')
+    for i, component in enumerate(components):
+      out.write('%s\n  {"name": %s, "data": [' % (',' if i else '', json.dumps(component)))
+      for j, record in enumerate(self.records()):
+        out.write('%s{"x": %s, "y": %s}' % (',' if j else '', json.dumps(record['x']), json.dumps(value(record, component))))
+      out.write(']}')
+    out.write('\n]\n')
+    out.close()
+
+  def hook_sim_end(self):
+    if self.stream is None:
+      return
+    self.stream.close()
+    self.stream = None
+
+    cpiitems = cpistack_items.CpiItems(use_simple_mem = True)
+    cpiitemssimple = cpistack_items.CpiItems(use_simple = True, use_simple_mem = True)
+    usedcomponents = [ name for name in cpiitems.names if name in self.used ]
+    usedsimple = []
+    for name in usedcomponents:
+      if cpiitems.names_to_contributions[name] not in usedsimple:
+        usedsimple.append(cpiitems.names_to_contributions[name])
+
+    def percentage(record, names):
+      total = sum(record['cpi'].values())
+      return 100. * sum([ record['cpi'].get(name, 0) for name in names ]) / total if total > 0 else 0
+
+    self.write_series('cpipercentage', usedcomponents, lambda record, name: percentage(record, [ name ]))
+    self.write_series('cpipercentagesimplified', usedsimple,
+      lambda record, name: percentage(record, [ key for key in usedcomponents if cpiitems.names_to_contributions[key] == name ]))
+    self.write_series('ipc', [ 'IPC' ], lambda record, name: record['ipc'])
+    for name, empty in (('cpific', []), ('cpificsimple', []), ('ipcfic', [ dict(name = 'IPC', data = []) ])):
+      open(os.path.join(self.datadir, '%s-%s.json' % (self.title, name)), 'w').write(json.dumps(empty))
+
+    info = open(os.path.join(self.datadir, 'info.txt'), 'w')
+    info.write("infostr = '"+json.dumps(dict(name = self.title, intervalsize = self.interval, num_intervals = self.num_intervals, use_mcpat = False))+"';\n")
+    info.write("palette = new Rickshaw.Color.Palette( { scheme: 'munin' } );\n")
+    for name, items, components in (('cpipercentage', cpiitems, usedcomponents), ('cpipercentagesimplified', cpiitemssimple, usedsimple),
+                                    ('cpific', cpiitems, []), ('simple', cpiitemssimple, usedsimple)):
+      colors = items.get_colors(components)
+      info.write(name+"labels = "+json.dumps([ dict(name = key, color = "rgb(%d,%d,%d)" % colors[key]) for key in components ])+";\n")
+    info.close()
+
+    # Picked up by tools/viz/viz.py --streamed
+    json.dump(dict(title = self.title, interval = self.interval, num_intervals = self.num_intervals),
+              open(os.path.join(self.datadir, 'stream.json'), 'w'))
+    print('[VIZ] Level 2 data for %d intervals written to %s' % (self.num_intervals, self.outputdir))
+
+sim.util.register(VizStream())
@@ -0,0 +1,203 @@
+#include "async_stream.h"
+#include "zbstream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sched.h>
+#include <unistd.h>
+
+// Time the writer thread sleeps when none of its streams have data
+static const useconds_t IDLE_SLEEP_US = 1000;
+
+AsyncWriter::AsyncWriter(size_t max_streams)
+   : m_slots(max_streams)
+   , m_stop(false)
+{
+   for (auto &slot : m_slots)
+   {
+      slot.stream = NULL;
+      slot.busy = 0;
+   }
+}
+
+void AsyncWriter::run()
+{
+   while (!__atomic_load_n(&m_stop, __ATOMIC_ACQUIRE))
+   {
+      bool progress = false;
+      for (auto &slot : m_slots)
+      {
+         if (__atomic_load_n(&slot.stream, __ATOMIC_ACQUIRE))
+            progress |= tryDrain(&slot);
+      }
+      if (!progress)
+         usleep(IDLE_SLEEP_US);
+   }
+}
+
+void AsyncWriter::stop()
+{
+   // Streams keep working after this point, their owners write out chunks themselves
+   __atomic_store_n(&m_stop, true, __ATOMIC_RELEASE);
+}
+
+AsyncWriter::Slot* AsyncWriter::add(asyncostream *stream)
+{
+   for (auto &slot : m_slots)
+   {
+      asyncostream *expected = NULL;
+      if (__atomic_compare_exchange_n(&slot.stream, &expected, stream, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+         return &slot;
+   }
+   // No free slot: the stream is drained by its owner only
+   return NULL;
+}
+
+void AsyncWriter::remove(Slot *slot)
+{
+   // Caller holds slot->busy, so the writer thread is no longer looking at this stream
+   __atomic_store_n(&slot->stream, (asyncostream*)NULL, __ATOMIC_RELEASE);
+   __atomic_store_n(&slot->busy, 0, __ATOMIC_RELEASE);
+}
+
+bool AsyncWriter::tryDrain(Slot *slot)
+{
+   uint32_t expected = 0;
+   if (!__atomic_compare_exchange_n(&slot->busy, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return false;
+
+   bool progress = false;
+   // The stream may have been removed between our first look and claiming the slot
+   asyncostream *stream = __atomic_load_n(&slot->stream, __ATOMIC_ACQUIRE);
+   if (stream && stream->m_tail != __atomic_load_n(&stream->m_head, __ATOMIC_ACQUIRE))
+   {
+      stream->drain();
+      progress = true;
+   }
+
+   __atomic_store_n(&slot->busy, 0, __ATOMIC_RELEASE);
+   return progress;
+}
+
+asyncostream::asyncostream(vostream *output, AsyncWriter *writer, obzstream *block_output, size_t block_size, size_t num_chunks, size_t chunksize)
+   : output(output)
+   , m_block_output(block_output)
+   , m_writer(writer)
+   , m_slot(NULL)
+   , m_chunksize(chunksize)
+   , m_block_size(block_output ? block_size : 0)
+   , m_chunks(std::max(num_chunks, size_t(2)))
+   , m_head(0)
+   , m_tail(0)
+   , m_block_bytes(0)
+{
+   for (auto &chunk : m_chunks)
+   {
+      chunk.data.resize(m_chunksize);
+      chunk.size = 0;
+      chunk.start_block = false;
+      chunk.icount = 0;
+   }
+   m_current = &m_chunks[0];
+
+   if (m_writer)
+      m_slot = m_writer->add(this);
+}
+
+asyncostream::~asyncostream()
+{
+   if (m_current->size || m_current->start_block)
+      handoff();
+
+   // Take over from the writer thread and write out whatever is left
+   if (m_slot)
+   {
+      uint32_t expected = 0;
+      while (!__atomic_compare_exchange_n(&m_slot->busy, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      {
+         expected = 0;
+         sched_yield();
+      }
+      drain();
+      m_writer->remove(m_slot);
+   }
+   else
+   {
+      drain();
+   }
+
+   delete output;
+}
+
+void asyncostream::write(const char* s, std::streamsize n)
+{
+   m_block_bytes += n;
+   while (n > 0)
+   {
+      size_t len = std::min(size_t(n), m_chunksize - m_current->size);
+      memcpy(&m_current->data[m_current->size], s, len);
+      m_current->size += len;
+      s += len;
+      n -= len;
+      if (m_current->size == m_chunksize)
+         handoff();
+   }
+}
+
+void asyncostream::startBlock(uint64_t icount)
+{
+   // Blocks of the underlying obzstream must start exactly here: cut the chunk and mark the next one
+   if (m_current->size || m_current->start_block)
+      handoff();
+   m_current->start_block = true;
+   m_current->icount = icount;
+   m_block_bytes = 0;
+}
+
+void asyncostream::handoff()
+{
+   uint64_t head = m_head + 1;
+   __atomic_store_n(&m_head, head, __ATOMIC_RELEASE);
+
+   // Wait for the next chunk to become free. Rather than waiting on a slow (or stopped) writer thread,
+   // write out our own chunks when the ring is full.
+   while (head - __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE) == m_chunks.size())
+   {
+      if (m_slot)
+      {
+         uint32_t expected = 0;
+         if (__atomic_compare_exchange_n(&m_slot->busy, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+         {
+            drain();
+            __atomic_store_n(&m_slot->busy, 0, __ATOMIC_RELEASE);
+         }
+         else
+         {
+            sched_yield();
+         }
+      }
+      else
+      {
+         drain();
+      }
+   }
+
+   m_current = &m_chunks[head % m_chunks.size()];
+   m_current->size = 0;
+   m_current->start_block = false;
+}
+
+void asyncostream::drain()
+{
+   // Runs on whoever holds the slot: the writer thread, or the producer itself
+   uint64_t head = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+   for (uint64_t tail = m_tail; tail != head; ++tail)
+   {
+      Chunk &chunk = m_chunks[tail % m_chunks.size()];
+      if (chunk.start_block)
+         m_block_output->startBlock(chunk.icount);
+      if (chunk.size)
+         output->write(&chunk.data[0], chunk.size);
+      __atomic_store_n(&m_tail, tail + 1, __ATOMIC_RELEASE);
+   }
+}
@@ -0,0 +1,93 @@
+#ifndef __ASYNC_STREAM_H
+#define __ASYNC_STREAM_H
+
+#include "zfstream.h"
+
+#include <stdint.h>
+#include <vector>
+
+class obzstream;
+class asyncostream;
+
+// Dedicated writer thread for a set of asyncostreams: drains their filled chunks into the underlying streams, so the
+// (block) compression and file I/O of all streams happen off the threads that produce them. The thread itself is
+// provided by the client (a Pin tool must use an internal thread), which calls run() on it.
+class AsyncWriter
+{
+   public:
+      AsyncWriter(size_t max_streams);
+      // Writer loop, returns after stop()
+      void run();
+      void stop();
+
+   private:
+      friend class asyncostream;
+
+      struct Slot
+      {
+         asyncostream *stream;
+         uint32_t busy;          // Whoever drains the stream (writer thread or owner) holds this
+      };
+
+      std::vector<Slot> m_slots;
+      bool m_stop;
+
+      Slot *add(asyncostream *stream);
+      void remove(Slot *slot);
+      bool tryDrain(Slot *slot);
+};
+
+// Write-behind wrapper around a vostream: the producing thread copies records into a small ring of chunks, which
+// are handed to the AsyncWriter without taking any locks. Flushes are no-ops, so this is only meant for streams that
+// nobody waits on (trace files written without response channels).
+// To keep blocks of a wrapped obzstream aligned with the records, block boundaries are tracked here and passed on
+// with the chunks, use full() and startBlock() of this stream instead of those of the obzstream.
+class asyncostream : public vostream
+{
+   private:
+      struct Chunk
+      {
+         std::vector<char> data;
+         size_t size;
+         bool start_block;       // Call startBlock(icount) on the block output before writing this chunk
+         uint64_t icount;
+      };
+
+      vostream *output;
+      obzstream *m_block_output;
+      AsyncWriter *m_writer;
+      AsyncWriter::Slot *m_slot;
+      const size_t m_chunksize;
+      const size_t m_block_size;
+      std::vector<Chunk> m_chunks;
+
+      // Chunks [m_tail, m_head) are ready for the writer, only m_head is written by the producer
+      uint64_t m_head;
+      uint64_t m_tail;
+
+      // Producer side
+      Chunk *m_current;
+      size_t m_block_bytes;
+
+      void handoff();
+      void drain();
+
+      friend class AsyncWriter;
+
+   public:
+      // block_output: the obzstream being wrapped, either output itself or below it (NULL if blocks are not used)
+      asyncostream(vostream *output, AsyncWriter *writer, obzstream *block_output = NULL, size_t block_size = 0,
+                   size_t num_chunks = 4, size_t chunksize = 256 * 1024);
+      virtual ~asyncostream();
+      virtual void write(const char* s, std::streamsize n);
+      virtual void flush() {}
+      virtual bool fail()
+         { return output->fail(); }
+      virtual bool is_open()
+         { return output->is_open(); }
+
+      bool full() const { return m_block_size && m_block_bytes >= m_block_size; }
+      void startBlock(uint64_t icount);
+};
+
+#endif // __ASYNC_STREAM_H
@@ -0,0 +1,104 @@
+#include "mmap_stream.h"
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::unordered_map<std::string, std::pair<const char*, size_t> > s_preloaded;
+
+bool mmapistream::preload(const char *filename)
+{
+   if (s_preloaded.count(filename))
+      return true;
+
+   int fd = open(filename, O_RDONLY);
+   if (fd < 0)
+      return false;
+
+   struct stat filestatus;
+   bool ok = false;
+   if (fstat(fd, &filestatus) == 0 && S_ISREG(filestatus.st_mode) && filestatus.st_size > 0)
+   {
+      void *data = mmap(NULL, filestatus.st_size, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
+      if (data != MAP_FAILED)
+      {
+#ifdef MADV_HUGEPAGE
+         madvise(data, filestatus.st_size, MADV_HUGEPAGE);
+#endif
+         s_preloaded[filename] = std::make_pair((const char *)data, size_t(filestatus.st_size));
+         ok = true;
+      }
+   }
+   close(fd);
+   return ok;
+}
+
+mmapistream::mmapistream(const char *filename)
+   : m_data(NULL)
+   , m_size(0)
+   , m_offset(0)
+   , m_fail(false)
+   , m_gcount(0)
+   , m_preloaded(false)
+{
+   auto it = s_preloaded.find(filename);
+   if (it != s_preloaded.end())
+   {
+      m_data = it->second.first;
+      m_size = it->second.second;
+      m_preloaded = true;
+      return;
+   }
+
+   int fd = open(filename, O_RDONLY);
+   if (fd < 0)
+      return;
+
+   struct stat filestatus;
+   if (fstat(fd, &filestatus) == 0 && S_ISREG(filestatus.st_mode) && filestatus.st_size > 0)
+   {
+      void *data = mmap(NULL, filestatus.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (data != MAP_FAILED)
+      {
+         m_data = (const char *)data;
+         m_size = filestatus.st_size;
+         // Traces are consumed front to back: read ahead aggressively and use huge pages where the file system supports them
+         madvise(data, m_size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+         madvise(data, m_size, MADV_HUGEPAGE);
+#endif
+      }
+   }
+   // The mapping stays valid after closing the file
+   close(fd);
+}
+
+mmapistream::~mmapistream()
+{
+   if (m_data && !m_preloaded)
+      munmap((void *)m_data, m_size);
+}
+
+void mmapistream::read(char* s, std::streamsize n)
+{
+   size_t len = std::min(size_t(n), m_size - m_offset);
+   memcpy(s, m_data + m_offset, len);
+   m_offset += len;
+   m_gcount = len;
+   if (len < size_t(n))
+      m_fail = true;
+}
+
+int mmapistream::peek()
+{
+   if (m_offset == m_size)
+   {
+      m_fail = true;
+      return 0;
+   }
+   return (unsigned char)m_data[m_offset];
+}
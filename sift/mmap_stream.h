@@ -0,0 +1,37 @@
+#ifndef __MMAP_STREAM_H
+#define __MMAP_STREAM_H
+
+#include "zfstream.h"
+
+#include <algorithm>
+
+// Input stream backed by a read-only, shared mapping of a regular file. Multiple readers of the same
+// file share its page cache pages, and reads avoid the std::ifstream buffering layer.
+class mmapistream : public vistream
+{
+   private:
+      const char *m_data;
+      size_t m_size;
+      size_t m_offset;
+      bool m_fail;
+      std::streamsize m_gcount;
+      bool m_preloaded;
+   public:
+      // Map a file once, with all of its pages read in, for the lifetime of this process and of processes forked
+      // from it (server mode). Streams opened on the same file afterwards reuse the mapping. Not thread safe,
+      // call before any streams are created.
+      static bool preload(const char *filename);
+
+      mmapistream(const char *filename);
+      virtual ~mmapistream();
+      virtual void read(char* s, std::streamsize n);
+      virtual int peek();
+      virtual bool fail() const { return m_fail; }
+      virtual std::streamsize gcount() const { return m_gcount; }
+
+      bool is_open() const { return m_data != NULL; }
+      uint64_t tell() const { return m_offset; }
+      void seek(uint64_t offset) { m_offset = std::min(offset, uint64_t(m_size)); m_fail = false; }
+};
+
+#endif // __MMAP_STREAM_H
@@ -0,0 +1,132 @@
+#include "prefetch_stream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+prefetchistream::prefetchistream(vistream *input, size_t num_chunks, size_t chunksize)
+   : input(input)
+   , m_chunksize(chunksize)
+   , m_chunks(num_chunks)
+   , m_head(0)
+   , m_tail(0)
+   , m_count(0)
+   , m_stop(false)
+   , m_current(NULL)
+   , m_offset(0)
+   , m_eof(false)
+   , m_fail(false)
+   , m_gcount(0)
+{
+   assert(num_chunks >= 2);
+   assert(chunksize > 0);
+   for(std::vector<Chunk>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+   {
+      it->data = new char[chunksize];
+      it->size = 0;
+      it->last = false;
+   }
+   m_thread = std::thread(&prefetchistream::fill, this);
+}
+
+prefetchistream::~prefetchistream()
+{
+   {
+      std::lock_guard<std::mutex> guard(m_lock);
+      m_stop = true;
+   }
+   m_cond_empty.notify_one();
+   m_thread.join();
+
+   for(std::vector<Chunk>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it)
+      delete [] it->data;
+   delete input;
+}
+
+void prefetchistream::fill()
+{
+   while(true)
+   {
+      Chunk *chunk;
+      {
+         std::unique_lock<std::mutex> guard(m_lock);
+         // m_count includes the chunk the consumer is currently reading from
+         m_cond_empty.wait(guard, [this]{ return m_stop || m_count < m_chunks.size(); });
+         if (m_stop)
+            return;
+         chunk = &m_chunks[m_head];
+      }
+
+      // Read without holding the lock, the chunk at m_head is not visible to the consumer yet
+      input->read(chunk->data, m_chunksize);
+      chunk->size = input->fail() ? std::min(input->gcount(), m_chunksize) : m_chunksize;
+      chunk->last = input->fail() || chunk->size < m_chunksize;
+
+      {
+         std::lock_guard<std::mutex> guard(m_lock);
+         m_head = (m_head + 1) % m_chunks.size();
+         ++m_count;
+      }
+      m_cond_full.notify_one();
+
+      if (chunk->last)
+         return;
+   }
+}
+
+bool prefetchistream::nextChunk()
+{
+   if (m_eof)
+      return false;
+
+   std::unique_lock<std::mutex> guard(m_lock);
+   if (m_current)
+   {
+      // Hand the chunk we just finished back to the helper thread
+      m_tail = (m_tail + 1) % m_chunks.size();
+      --m_count;
+      m_cond_empty.notify_one();
+   }
+   m_cond_full.wait(guard, [this]{ return m_count > 0; });
+   m_current = &m_chunks[m_tail];
+   m_offset = 0;
+   if (m_current->last)
+      m_eof = true;
+
+   return true;
+}
+
+void prefetchistream::read(char* s, std::streamsize n)
+{
+   m_gcount = 0;
+   while(n > 0)
+   {
+      if (m_current == NULL || m_offset == m_current->size)
+      {
+         if (!nextChunk() || m_current->size == 0)
+         {
+            m_fail = true;
+            return;
+         }
+      }
+      std::streamsize len = std::min(n, m_current->size - m_offset);
+      memcpy(s, m_current->data + m_offset, len);
+      m_offset += len;
+      m_gcount += len;
+      s += len;
+      n -= len;
+   }
+}
+
+int prefetchistream::peek()
+{
+   if (m_current == NULL || m_offset == m_current->size)
+   {
+      if (!nextChunk() || m_current->size == 0)
+      {
+         m_fail = true;
+         return 0;
+      }
+   }
+   return (unsigned char)m_current->data[m_offset];
+}
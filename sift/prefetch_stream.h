@@ -0,0 +1,58 @@
+#ifndef __PREFETCH_STREAM_H
+#define __PREFETCH_STREAM_H
+
+#include "zfstream.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Read-ahead wrapper around a vistream: a helper thread reads (and, when wrapping an izstream,
+// inflates) fixed-size chunks from the underlying stream into a ring of buffers ahead of the consumer.
+// Only safe for streams that do not depend on the consumer to make progress (i.e., regular files,
+// not pipes whose writer waits for responses).
+class prefetchistream : public vistream
+{
+   private:
+      struct Chunk
+      {
+         char *data;
+         std::streamsize size;
+         bool last;
+      };
+
+      vistream *input;
+      const std::streamsize m_chunksize;
+      std::vector<Chunk> m_chunks;
+
+      // Filled by the helper thread at m_head, consumed at m_tail, protected by m_lock
+      size_t m_head;
+      size_t m_tail;
+      size_t m_count;
+      bool m_stop;
+      std::mutex m_lock;
+      std::condition_variable m_cond_full;
+      std::condition_variable m_cond_empty;
+      std::thread m_thread;
+
+      // Consumer side, only touched by the reading thread
+      Chunk *m_current;
+      std::streamsize m_offset;
+      bool m_eof;
+      bool m_fail;
+      std::streamsize m_gcount;
+
+      void fill();
+      bool nextChunk();
+
+   public:
+      prefetchistream(vistream *input, size_t num_chunks, size_t chunksize);
+      virtual ~prefetchistream();
+      virtual void read(char* s, std::streamsize n);
+      virtual int peek();
+      virtual bool fail() const { return m_fail; }
+      virtual std::streamsize gcount() const { return m_gcount; }
+};
+
+#endif // __PREFETCH_STREAM_H
@@ -6,9 +6,13 @@ KNOB<UINT64> KnobUseROI(KNOB_MODE_WRITEONCE, "pintool", "sniper:roi", "0", "use
 KNOB<UINT64> KnobMPIImplicitROI(KNOB_MODE_WRITEONCE, "pintool", "sniper:roi-mpi", "0", "Implicit ROI between MPI_Init and MPI_Finalize");
 KNOB<UINT64> KnobFastForwardTarget(KNOB_MODE_WRITEONCE, "pintool", "sniper:f", "0", "instructions to fast forward");
 KNOB<UINT64> KnobDetailedTarget(KNOB_MODE_WRITEONCE, "pintool", "sniper:d", "0", "instructions to trace in detail (default = all)");
+KNOB<std::string> KnobRegions(KNOB_MODE_WRITEONCE, "pintool", "sniper:regions", "", "file with regions (<start> <length> per line, in instructions, increasing and not overlapping) to record in a single run, each to <o>.region<n>.sift and listed in <o>.regions, without response files only");
 KNOB<UINT64> KnobUseResponseFiles(KNOB_MODE_WRITEONCE, "pintool", "sniper:r", "0", "use response files (required for multithreaded applications or when emulating syscalls, default = 0)");
 KNOB<UINT64> KnobEmulateSyscalls(KNOB_MODE_WRITEONCE, "pintool", "sniper:e", "0", "emulate syscalls (required for multithreaded applications, default = 0)");
 KNOB<BOOL>   KnobSendPhysicalAddresses(KNOB_MODE_WRITEONCE, "pintool", "sniper:pa", "0", "send logical to physical address mapping");
+KNOB<std::string> KnobBlockCompression(KNOB_MODE_WRITEONCE, "pintool", "sniper:blockcomp", "", "write a seekable block-compressed trace using this codec (zlib, zstd, lz4), without response files only (default = single zlib stream)");
+KNOB<BOOL> KnobAsyncWriter(KNOB_MODE_WRITEONCE, "pintool", "sniper:async", "0", "stage trace output per thread and write (and block-compress) it from a dedicated thread, without response files only");
+KNOB<BOOL> KnobBasicBlocks(KNOB_MODE_WRITEONCE, "pintool", "sniper:bbenc", "0", "encode instructions as announced basic blocks with address deltas (smaller traces, faster replay)");
 KNOB<UINT64> KnobFlowControl(KNOB_MODE_WRITEONCE, "pintool", "sniper:flow", "1000", "number of instructions to send before syncing up");
 KNOB<UINT64> KnobFlowControlFF(KNOB_MODE_WRITEONCE, "pintool", "sniper:flowff", "100000", "number of instructions to batch up before sending instruction counts in fast-forward mode");
 KNOB<INT64> KnobSiftAppId(KNOB_MODE_WRITEONCE, "pintool", "sniper:s", "0", "sift app id (default = 0)");
@@ -43,10 +47,13 @@ UINT32 max_num_threads = MAX_NUM_THREADS_DEFAULT;
 UINT64 blocksize;
 UINT64 fast_forward_target = 0;
 UINT64 detailed_target = 0;
+std::vector<region_t> regions;
+UINT32 current_region = 0;
 PIN_LOCK access_memory_lock;
 PIN_LOCK new_threadid_lock;
 std::deque<ADDRINT> tidptrs;
 PIN_LOCK output_lock;
+AsyncWriter *async_writer = NULL;
 INT32 child_app_id = -1;
 BOOL in_roi = false;
 BOOL any_thread_in_detail = false;
@@ -13,6 +13,9 @@
 #include "control_manager.H"
 #include <unordered_map>
 #include <deque>
+#include <vector>
+
+class AsyncWriter;
 
 //#define DEBUG_OUTPUT 1
 #define DEBUG_OUTPUT 0
@@ -27,9 +30,13 @@ extern KNOB<UINT64> KnobUseROI;
 extern KNOB<UINT64> KnobMPIImplicitROI;
 extern KNOB<UINT64> KnobFastForwardTarget;
 extern KNOB<UINT64> KnobDetailedTarget;
+extern KNOB<std::string> KnobRegions;
 extern KNOB<UINT64> KnobUseResponseFiles;
 extern KNOB<UINT64> KnobEmulateSyscalls;
 extern KNOB<BOOL>   KnobSendPhysicalAddresses;
+extern KNOB<std::string> KnobBlockCompression;
+extern KNOB<BOOL> KnobAsyncWriter;
+extern KNOB<BOOL> KnobBasicBlocks;
 extern KNOB<UINT64> KnobFlowControl;
 extern KNOB<UINT64> KnobFlowControlFF;
 extern KNOB<INT64> KnobSiftAppId;
@@ -55,9 +62,18 @@ extern UINT32 max_num_threads;
 extern UINT64 blocksize;
 extern UINT64 fast_forward_target;
 extern UINT64 detailed_target;
+
+typedef struct {
+   UINT64 start;  // Instruction count at which the region starts
+   UINT64 length; // Instructions to record
+} region_t;
+
+extern std::vector<region_t> regions;
+extern UINT32 current_region;
 extern PIN_LOCK access_memory_lock;
 extern PIN_LOCK new_threadid_lock;
 extern PIN_LOCK output_lock;
+extern AsyncWriter *async_writer;
 extern std::deque<ADDRINT> tidptrs;
 extern INT32 child_app_id;
 extern BOOL in_roi;
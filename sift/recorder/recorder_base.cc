@@ -85,6 +85,8 @@ VOID sendInstruction(THREADID threadid, ADDRINT addr, UINT32 size, UINT32 num_ad
    if (detailed_target != 0 && thread_data[threadid].icount_detailed >= detailed_target)
    {
       closeFile(threadid);
+      if (!regions.empty() && nextRegion(threadid))
+         return;
       PIN_Detach();
       return;
    }
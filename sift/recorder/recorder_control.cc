@@ -342,6 +342,8 @@ void openFile(THREADID threadid)
    {
       if (blocksize)
          sprintf(filename, "%s.%" PRIu64 ".sift", KnobOutputFile.Value().c_str(), thread_data[threadid].blocknum);
+      else if (!regions.empty())
+         sprintf(filename, "%s.region%" PRIu32 ".sift", KnobOutputFile.Value().c_str(), current_region);
       else
          sprintf(filename, "%s.sift", KnobOutputFile.Value().c_str());
    }
@@ -370,7 +372,22 @@ void openFile(THREADID threadid)
    #else
       const bool arch32 = false;
    #endif
-   thread_data[threadid].output = new Sift::Writer(filename, getCode, KnobUseResponseFiles.Value() ? false : true, response_filename, threadid, arch32, false, KnobSendPhysicalAddresses.Value());
+   Sift::BlockCodec block_codec = Sift::BlockCodecNone;
+   if (!KnobUseResponseFiles.Value() && KnobBlockCompression.Value() != "")
+   {
+      if (KnobBlockCompression.Value() == "zlib")
+         block_codec = Sift::BlockCodecZlib;
+      else if (KnobBlockCompression.Value() == "zstd")
+         block_codec = Sift::BlockCodecZstd;
+      else if (KnobBlockCompression.Value() == "lz4")
+         block_codec = Sift::BlockCodecLz4;
+      else
+      {
+         std::cerr << "[SIFT_RECORDER] Error: Unknown block codec " << KnobBlockCompression.Value() << std::endl;
+         exit(1);
+      }
+   }
+   thread_data[threadid].output = new Sift::Writer(filename, getCode, KnobUseResponseFiles.Value() ? false : true, response_filename, threadid, arch32, false, KnobSendPhysicalAddresses.Value(), NULL, NULL, block_codec, Sift::BlockSizeDefault, async_writer, KnobBasicBlocks.Value());
 
    if (!thread_data[threadid].output->IsOpen())
    {
@@ -397,6 +414,17 @@ void closeFile(THREADID threadid)
    output->End();
    delete output;
 
+   if (!regions.empty())
+   {
+      // Add the region to the index, with the number of instructions actually recorded (less if the application ended)
+      char filename[1024];
+      sprintf(filename, "%s.regions", KnobOutputFile.Value().c_str());
+      FILE *fp = fopen(filename, current_region == 0 ? "w" : "a");
+      fprintf(fp, "%" PRIu32 " %" PRIu64 " %" PRIu64 " %s.region%" PRIu32 ".sift\n", current_region, regions[current_region].start,
+         thread_data[threadid].icount_detailed, KnobOutputFile.Value().c_str(), current_region);
+      fclose(fp);
+   }
+
    if (blocksize)
    {
       if (thread_data[threadid].bbv_count)
@@ -419,6 +447,68 @@ void closeFile(THREADID threadid)
    }
 }
 
+void initRegions()
+{
+   if (KnobUseResponseFiles.Value() || KnobUseROI.Value() || KnobMPIImplicitROI.Value() || blocksize || fast_forward_target || detailed_target)
+   {
+      std::cerr << "[SIFT_RECORDER] Error: Regions cannot be combined with response files, ROI markers, blocks or -f/-d" << std::endl;
+      exit(1);
+   }
+
+   FILE *fp = fopen(KnobRegions.Value().c_str(), "r");
+   if (!fp)
+   {
+      std::cerr << "[SIFT_RECORDER] Error: Unable to open the regions file " << KnobRegions.Value() << std::endl;
+      exit(1);
+   }
+   char line[1024];
+   while (fgets(line, sizeof(line), fp))
+   {
+      region_t region;
+      // Lines are <start> <length> [<anything else>], # starts a comment
+      if (line[0] == '#' || sscanf(line, "%" SCNu64 " %" SCNu64, &region.start, &region.length) != 2)
+         continue;
+      if (region.length == 0 || (!regions.empty() && region.start < regions.back().start + regions.back().length))
+      {
+         std::cerr << "[SIFT_RECORDER] Error: Region " << regions.size() << " is empty or overlaps with the previous one" << std::endl;
+         exit(1);
+      }
+      regions.push_back(region);
+   }
+   fclose(fp);
+
+   if (regions.empty())
+   {
+      std::cerr << "[SIFT_RECORDER] Error: No regions found in " << KnobRegions.Value() << std::endl;
+      exit(1);
+   }
+
+   current_region = 0;
+   fast_forward_target = regions[0].start;
+   detailed_target = regions[0].length;
+}
+
+bool nextRegion(THREADID threadid)
+{
+   // Called after closing the output of the current region, returns false when this was the last one
+   if (current_region + 1 >= regions.size())
+      return false;
+
+   const region_t &previous = regions[current_region++];
+   if (KnobVerbose.Value())
+      std::cerr << "[SIFT_RECORDER:" << app_id << "] Region " << current_region << " starts in " << regions[current_region].start - (previous.start + previous.length) << " instructions" << std::endl;
+
+   // icount restarted at zero when the previous region began, and is reset again once the next one begins
+   fast_forward_target = regions[current_region].start - (previous.start + previous.length);
+   detailed_target = regions[current_region].length;
+   thread_data[threadid].icount = 0;
+   thread_data[threadid].icount_detailed = 0;
+   thread_data[threadid].icount_reported = 0;
+   in_roi = false;
+   setInstrumentationMode(Sift::ModeIcount);
+   return true;
+}
+
 bool rtn_in_extrae(RTN rtn)
 {
    ADDRINT rtn_addr = RTN_Address(rtn);
@@ -18,6 +18,9 @@ void closeFile(THREADID threadid);
 
 void findMyAppId();
 
+void initRegions();
+bool nextRegion(THREADID threadid);
+
 void initRecorderControl();
 
 bool rtn_in_extrae(RTN routine);
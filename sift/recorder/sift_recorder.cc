@@ -31,6 +31,7 @@
 #include "trace_rtn.h"
 #include "emulation.h"
 #include "sift_writer.h"
+#include "async_stream.h"
 #include "sift_assert.h"
 #include "pinboost_debug.h"
 #include "icountsniper.h"
@@ -50,6 +51,14 @@ VOID Fini(INT32 code, VOID *v)
          closeFile(i);
       }
    }
+
+   if (async_writer)
+      async_writer->stop();
+}
+
+static VOID asyncWriterThread(VOID *arg)
+{
+   async_writer->run();
 }
 
 VOID Detach(VOID *v)
@@ -201,10 +210,19 @@ int main(int argc, char **argv)
    PIN_InitLock(&access_memory_lock);
    PIN_InitLock(&new_threadid_lock);
 
+   if (KnobAsyncWriter.Value() && !KnobUseResponseFiles.Value())
+   {
+      // Must exist before the first openFile()
+      async_writer = new AsyncWriter(max_num_threads);
+      PIN_SpawnInternalThread(asyncWriterThread, NULL, 0, NULL);
+   }
+
    app_id = KnobSiftAppId.Value();
    blocksize = KnobBlocksize.Value();
    fast_forward_target = KnobFastForwardTarget.Value();
    detailed_target = KnobDetailedTarget.Value();
+   if (KnobRegions.Value() != "")
+      initRegions();
 
    if (KnobEmulateSyscalls.Value() || (!KnobUseROI.Value() && !KnobMPIImplicitROI.Value()))
    {
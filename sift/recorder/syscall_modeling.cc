@@ -150,13 +150,14 @@ VOID emulateSyscallFunc(THREADID threadid, CONTEXT *ctxt)
             break;
          }
 
-         // System calls not emulated (passed through to OS)
+         // System calls not emulated (passed through to OS), the simulator only models their timing
+         // so there is no need to wait for its answer
          case SYS_read:
          case SYS_write:
          case SYS_wait4:
             thread_data[threadid].last_syscall_number = syscall_number;
             thread_data[threadid].last_syscall_emulated = false;
-            thread_data[threadid].output->Syscall(syscall_number, (char*)args, sizeof(args));
+            thread_data[threadid].output->SyscallAsync(syscall_number, (char*)args, sizeof(args));
             break;
 
          // System calls emulated (not passed through to OS)
@@ -0,0 +1,210 @@
+#include "shared_stream.h"
+#include "sift_format.h"
+#include "zbstream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+SharedTrace* SharedTrace::open(const char *filename, uint32_t num_consumers, size_t chunksize)
+{
+   struct stat filestatus;
+   if (stat(filename, &filestatus) != 0 || !S_ISREG(filestatus.st_mode))
+      return NULL;
+
+   std::ifstream *inputstream = new std::ifstream(filename, std::ios::in);
+   if ((!inputstream->is_open()) || (!inputstream->good()))
+   {
+      delete inputstream;
+      return NULL;
+   }
+   vistream *input = new vifstream(inputstream);
+
+   // Same header handling as Sift::Reader::initStream, consumers get the stream after the header, decompressed
+   Sift::Header hdr;
+   input->read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+   if (input->fail() || hdr.magic != Sift::MagicNumber)
+   {
+      std::cerr << "[SIFT] Invalid magic number in " << filename << "\n";
+      delete input;
+      return NULL;
+   }
+
+   if (hdr.options & Sift::CompressionZlib)
+   {
+#if SIFT_USE_ZLIB
+      input = new izstream(input);
+      hdr.options &= ~Sift::CompressionZlib;
+#else
+      delete input;
+      return NULL;
+#endif
+   }
+   if (hdr.options & Sift::CompressionBlock)
+   {
+      input = new ibzstream(input);
+      hdr.options &= ~Sift::CompressionBlock;
+   }
+   bool trace_has_pa = hdr.options & Sift::PhysicalAddress;
+   hdr.options &= ~(Sift::ArchIA32 | Sift::PhysicalAddress | Sift::IcacheVariable | Sift::BasicBlocks);
+
+   if (hdr.options != 0)
+   {
+      delete input;
+      return NULL;
+   }
+
+   return new SharedTrace(inputstream, input, num_consumers, chunksize, filestatus.st_size, trace_has_pa);
+}
+
+SharedTrace::SharedTrace(std::ifstream *inputstream, vistream *input, uint32_t num_consumers, size_t chunksize, uint64_t filesize, bool trace_has_pa)
+   : m_inputstream(inputstream)
+   , m_input(input)
+   , m_chunksize(chunksize)
+   , m_filesize(filesize)
+   , m_trace_has_pa(trace_has_pa)
+   , m_consumers(0)
+   , m_num_consumers(num_consumers)
+   , m_first(0)
+   , m_active(num_consumers)
+   , m_eof(false)
+{
+   assert(chunksize > 0);
+}
+
+SharedTrace::~SharedTrace()
+{
+   delete m_input;
+}
+
+sharedistream* SharedTrace::newConsumer()
+{
+   std::lock_guard<std::mutex> guard(m_lock);
+   assert(m_consumers < m_num_consumers);
+   ++m_consumers;
+   return new sharedistream(this);
+}
+
+SharedTrace::ChunkPtr SharedTrace::getChunk(uint64_t index)
+{
+   std::lock_guard<std::mutex> guard(m_lock);
+   assert(index >= m_first);
+
+   // The consumer that is furthest ahead reads (and decompresses) new chunks, the others find them here
+   while(index >= m_first + m_chunks.size())
+   {
+      if (m_eof)
+         return ChunkPtr();
+
+      Chunk *chunk = new Chunk();
+      chunk->data.resize(m_chunksize);
+      m_input->read(chunk->data.data(), m_chunksize);
+      size_t size = m_input->fail() ? std::min<size_t>(m_input->gcount(), m_chunksize) : m_chunksize;
+      chunk->data.resize(size);
+      chunk->position = m_inputstream->good() ? uint64_t(m_inputstream->tellg()) : m_filesize;
+      chunk->last = m_input->fail() || size < m_chunksize;
+      m_eof = chunk->last;
+
+      m_chunks.push_back(ChunkPtr(chunk));
+      m_readers.push_back(m_active);
+   }
+
+   return m_chunks[index - m_first];
+}
+
+void SharedTrace::done(uint64_t index)
+{
+   std::lock_guard<std::mutex> guard(m_lock);
+   assert(index >= m_first && index < m_first + m_chunks.size());
+   --m_readers[index - m_first];
+   dropFinished();
+}
+
+void SharedTrace::detach(uint64_t index)
+{
+   // The consumer will not read chunk <index> (if it was on it, it did not finish it) nor any later one
+   std::lock_guard<std::mutex> guard(m_lock);
+   for(uint64_t i = std::max(index, m_first); i < m_first + m_chunks.size(); ++i)
+      --m_readers[i - m_first];
+   --m_active;
+   dropFinished();
+}
+
+void SharedTrace::dropFinished()
+{
+   // Consumers that still hold a dropped chunk keep it alive through their reference
+   while(!m_readers.empty() && m_readers.front() == 0)
+   {
+      m_chunks.pop_front();
+      m_readers.pop_front();
+      ++m_first;
+   }
+}
+
+sharedistream::sharedistream(SharedTrace *shared)
+   : m_shared(shared)
+   , m_current()
+   , m_index(0)
+   , m_offset(0)
+   , m_fail(false)
+   , m_gcount(0)
+{
+}
+
+sharedistream::~sharedistream()
+{
+   // Every chunk before m_index has been passed on with done()
+   m_shared->detach(m_index);
+}
+
+bool sharedistream::nextChunk()
+{
+   if (m_current)
+   {
+      if (m_current->last)
+         return false;
+      m_shared->done(m_index);
+      ++m_index;
+   }
+   m_current = m_shared->getChunk(m_index);
+   m_offset = 0;
+   return m_current && m_current->data.size() > 0;
+}
+
+void sharedistream::read(char* s, std::streamsize n)
+{
+   m_gcount = 0;
+   while(n > 0)
+   {
+      if (m_current == NULL || m_offset == m_current->data.size())
+      {
+         if (!nextChunk())
+         {
+            m_fail = true;
+            return;
+         }
+      }
+      std::streamsize len = std::min<std::streamsize>(n, m_current->data.size() - m_offset);
+      memcpy(s, m_current->data.data() + m_offset, len);
+      m_offset += len;
+      m_gcount += len;
+      s += len;
+      n -= len;
+   }
+}
+
+int sharedistream::peek()
+{
+   if (m_current == NULL || m_offset == m_current->data.size())
+   {
+      if (!nextChunk())
+      {
+         m_fail = true;
+         return 0;
+      }
+   }
+   return (unsigned char)m_current->data[m_offset];
+}
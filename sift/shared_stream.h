@@ -0,0 +1,90 @@
+#ifndef __SHARED_STREAM_H
+#define __SHARED_STREAM_H
+
+#include "zfstream.h"
+
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+class sharedistream;
+
+// Single-reader fan-out of one trace file to several Readers, for replaying the same trace in many copies:
+// the file is opened, decompressed and read only once, into reference-counted chunks of decompressed trace data.
+// Each consumer walks the chunks at its own pace, the first one to need a chunk reads it. A chunk is dropped once
+// every consumer has moved past it, so memory use is bounded by the distance between the fastest and slowest copy.
+// Only for regular files, there is no response channel.
+class SharedTrace
+{
+   public:
+      // Returns NULL if the file cannot be opened or is not a SIFT trace we can read
+      static SharedTrace* open(const char *filename, uint32_t num_consumers, size_t chunksize);
+      ~SharedTrace();
+
+      // A stream for one of the <num_consumers> consumers, which start reading at the beginning of the trace
+      sharedistream* newConsumer();
+
+      bool getTraceHasPhysicalAddresses() const { return m_trace_has_pa; }
+      uint64_t getLength() const { return m_filesize; }
+
+   private:
+      friend class sharedistream;
+
+      struct Chunk
+      {
+         std::vector<char> data;
+         uint64_t position;         // File offset after this chunk was read, for progress reporting
+         bool last;
+      };
+      typedef std::shared_ptr<const Chunk> ChunkPtr;
+
+      SharedTrace(std::ifstream *inputstream, vistream *input, uint32_t num_consumers, size_t chunksize, uint64_t filesize, bool trace_has_pa);
+
+      std::ifstream *m_inputstream;
+      vistream *m_input;
+      const size_t m_chunksize;
+      const uint64_t m_filesize;
+      const bool m_trace_has_pa;
+      uint32_t m_consumers;           // Consumers handed out so far
+      const uint32_t m_num_consumers;
+
+      // Chunks m_first .. m_first + m_chunks.size() - 1, with the number of consumers that still have to read each
+      std::mutex m_lock;
+      std::deque<ChunkPtr> m_chunks;
+      std::deque<uint32_t> m_readers;
+      uint64_t m_first;
+      uint32_t m_active;              // Consumers that have not stopped reading
+      bool m_eof;
+
+      ChunkPtr getChunk(uint64_t index);
+      void done(uint64_t index);
+      void detach(uint64_t index);
+      void dropFinished();
+};
+
+class sharedistream : public vistream
+{
+   private:
+      SharedTrace *m_shared;
+      SharedTrace::ChunkPtr m_current;
+      uint64_t m_index;
+      size_t m_offset;
+      bool m_fail;
+      std::streamsize m_gcount;
+
+      bool nextChunk();
+
+   public:
+      sharedistream(SharedTrace *shared);
+      virtual ~sharedistream();
+      virtual void read(char* s, std::streamsize n);
+      virtual int peek();
+      virtual bool fail() const { return m_fail; }
+      virtual std::streamsize gcount() const { return m_gcount; }
+      uint64_t tell() const { return m_current ? m_current->position : 0; }
+};
+
+#endif // __SHARED_STREAM_H
@@ -0,0 +1,292 @@
+#include "shm_stream.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Number of polls of the peer's position before going to sleep
+static const int SPIN_COUNT = 1000;
+// Sleeps time out periodically to notice a peer that died without detaching
+static const long WAIT_TIMEOUT_NS = 100 * 1000 * 1000;
+
+static void futexWait(uint32_t *addr, uint32_t value)
+{
+   struct timespec timeout = { 0, WAIT_TIMEOUT_NS };
+   // Shared (non-private) futex: the other end lives in another process
+   syscall(SYS_futex, addr, FUTEX_WAIT, value, &timeout, NULL, 0);
+}
+
+static void futexWake(uint32_t *addr)
+{
+   syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+bool ShmRing::create(const char *filename, uint64_t size)
+{
+   uint64_t data_size = HEADER_SIZE;
+   while (data_size < size)
+      data_size <<= 1;
+
+   // Replace any FIFO or stale ring of the same name
+   unlink(filename);
+   int fd = open(filename, O_RDWR | O_CREAT | O_EXCL, 0600);
+   if (fd < 0)
+      return false;
+
+   Header hdr;
+   memset(&hdr, 0, sizeof(hdr));
+   hdr.magic = MAGIC;
+   hdr.version = VERSION;
+   hdr.size = data_size;
+   bool ok = ftruncate(fd, HEADER_SIZE + data_size) == 0 && pwrite(fd, &hdr, sizeof(hdr), 0) == sizeof(hdr);
+   close(fd);
+   return ok;
+}
+
+bool ShmRing::isRing(const char *filename)
+{
+   struct stat filestatus;
+   if (stat(filename, &filestatus) != 0 || !S_ISREG(filestatus.st_mode) || uint64_t(filestatus.st_size) < HEADER_SIZE)
+      return false;
+
+   int fd = open(filename, O_RDONLY);
+   if (fd < 0)
+      return false;
+   uint32_t magic = 0;
+   bool ok = pread(fd, &magic, sizeof(magic), 0) == sizeof(magic) && magic == MAGIC;
+   close(fd);
+   return ok;
+}
+
+ShmRing::ShmRing(const char *filename)
+   : m_hdr(NULL)
+   , m_data(NULL)
+   , m_size(0)
+   , m_mask(0)
+{
+   int fd = open(filename, O_RDWR);
+   if (fd < 0)
+      return;
+
+   struct stat filestatus;
+   if (fstat(fd, &filestatus) == 0 && S_ISREG(filestatus.st_mode) && uint64_t(filestatus.st_size) > HEADER_SIZE)
+   {
+      void *data = mmap(NULL, filestatus.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (data != MAP_FAILED)
+      {
+         Header *hdr = (Header *)data;
+         uint64_t size = hdr->size;
+         if (hdr->magic == MAGIC && hdr->version == VERSION && size && (size & (size - 1)) == 0
+             && HEADER_SIZE + size == uint64_t(filestatus.st_size))
+         {
+            m_hdr = hdr;
+            m_data = (char *)data + HEADER_SIZE;
+            m_size = size;
+            m_mask = size - 1;
+         }
+         else
+         {
+            munmap(data, filestatus.st_size);
+         }
+      }
+   }
+   // The mapping stays valid after closing the file
+   close(fd);
+}
+
+ShmRing::~ShmRing()
+{
+   if (m_hdr)
+      munmap(m_hdr, HEADER_SIZE + m_size);
+}
+
+void ShmRing::attach(Endpoint &self)
+{
+   // A previous user of this end may still be waiting for the other end to detach so the ring can be reset
+   while (__atomic_load_n(&self.closed, __ATOMIC_ACQUIRE))
+      usleep(1000);
+   __atomic_store_n(&self.pid, getpid(), __ATOMIC_RELEASE);
+}
+
+void ShmRing::detach(Endpoint &self)
+{
+   __atomic_store_n(&self.closed, 1, __ATOMIC_SEQ_CST);
+   // Wake up a peer waiting on us so it notices we're gone
+   __atomic_add_fetch(&self.seq, 1, __ATOMIC_SEQ_CST);
+   futexWake(&self.seq);
+
+   if (__atomic_add_fetch(&m_hdr->detached, 1, __ATOMIC_ACQ_REL) == 2)
+   {
+      // Both ends are gone: reset the ring for the next pair of users, reopening the ends last
+      Endpoint *ends[] = { &m_hdr->producer, &m_hdr->consumer };
+      for (Endpoint *end : ends)
+      {
+         end->position = 0;
+         end->waiters = 0;
+         end->pid = 0;
+      }
+      m_hdr->detached = 0;
+      for (Endpoint *end : ends)
+         __atomic_store_n(&end->closed, 0, __ATOMIC_RELEASE);
+   }
+}
+
+void ShmRing::publish(Endpoint &self, uint64_t position)
+{
+   __atomic_store_n(&self.position, position, __ATOMIC_SEQ_CST);
+   // Only enter the kernel when the peer is asleep, or about to be. Only the waiter clears waiters.
+   if (__atomic_load_n(&self.waiters, __ATOMIC_SEQ_CST))
+   {
+      __atomic_add_fetch(&self.seq, 1, __ATOMIC_SEQ_CST);
+      futexWake(&self.seq);
+   }
+}
+
+bool ShmRing::waitFor(Endpoint &peer, uint64_t position)
+{
+   for (int spin = 0; spin < SPIN_COUNT; ++spin)
+   {
+      if (__atomic_load_n(&peer.position, __ATOMIC_ACQUIRE) != position)
+         return true;
+   }
+
+   while (true)
+   {
+      // Announce ourselves before the final check: a publish that we miss here will see waiters set and bump seq
+      __atomic_store_n(&peer.waiters, 1, __ATOMIC_SEQ_CST);
+      uint32_t seq = __atomic_load_n(&peer.seq, __ATOMIC_SEQ_CST);
+      if (__atomic_load_n(&peer.position, __ATOMIC_SEQ_CST) != position)
+         break;
+
+      int32_t pid = __atomic_load_n(&peer.pid, __ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&peer.closed, __ATOMIC_ACQUIRE) || (pid && kill(pid, 0) == -1 && errno == ESRCH))
+      {
+         // The peer may have published its last bytes just before detaching
+         __atomic_store_n(&peer.waiters, 0, __ATOMIC_RELAXED);
+         return __atomic_load_n(&peer.position, __ATOMIC_ACQUIRE) != position;
+      }
+
+      futexWait(&peer.seq, seq);
+   }
+   __atomic_store_n(&peer.waiters, 0, __ATOMIC_RELAXED);
+   return true;
+}
+
+void ShmRing::copyIn(uint64_t position, const char *s, size_t n)
+{
+   size_t offset = position & m_mask;
+   size_t first = std::min(n, size_t(m_size - offset));
+   memcpy(m_data + offset, s, first);
+   memcpy(m_data, s + first, n - first);
+}
+
+void ShmRing::copyOut(uint64_t position, char *s, size_t n)
+{
+   size_t offset = position & m_mask;
+   size_t first = std::min(n, size_t(m_size - offset));
+   memcpy(s, m_data + offset, first);
+   memcpy(s + first, m_data, n - first);
+}
+
+shmostream::shmostream(const char *filename)
+   : ShmRing(filename)
+   , m_fail(false)
+{
+   if (m_hdr)
+      attach(m_hdr->producer);
+   else
+      m_fail = true;
+}
+
+shmostream::~shmostream()
+{
+   if (m_hdr)
+      detach(m_hdr->producer);
+}
+
+void shmostream::write(const char* s, std::streamsize n)
+{
+   while (n > 0 && !m_fail)
+   {
+      uint64_t head = m_hdr->producer.position;
+      uint64_t tail = __atomic_load_n(&m_hdr->consumer.position, __ATOMIC_ACQUIRE);
+      uint64_t space = m_size - (head - tail);
+      if (space == 0)
+      {
+         // Ring is full: wait for the consumer to catch up, data written after the consumer has gone is lost
+         if (!waitFor(m_hdr->consumer, tail))
+            m_fail = true;
+         continue;
+      }
+      size_t len = std::min(uint64_t(n), space);
+      copyIn(head, s, len);
+      publish(m_hdr->producer, head + len);
+      s += len;
+      n -= len;
+   }
+}
+
+shmistream::shmistream(const char *filename)
+   : ShmRing(filename)
+   , m_fail(false)
+   , m_gcount(0)
+{
+   if (m_hdr)
+      attach(m_hdr->consumer);
+   else
+      m_fail = true;
+}
+
+shmistream::~shmistream()
+{
+   if (m_hdr)
+      detach(m_hdr->consumer);
+}
+
+void shmistream::read(char* s, std::streamsize n)
+{
+   m_gcount = 0;
+   while (n > 0)
+   {
+      uint64_t tail = m_hdr->consumer.position;
+      uint64_t head = __atomic_load_n(&m_hdr->producer.position, __ATOMIC_ACQUIRE);
+      if (head == tail)
+      {
+         if (!waitFor(m_hdr->producer, head))
+         {
+            // Producer detached and the ring is drained: end of stream
+            m_fail = true;
+            return;
+         }
+         continue;
+      }
+      size_t len = std::min(uint64_t(n), head - tail);
+      copyOut(tail, s, len);
+      publish(m_hdr->consumer, tail + len);
+      s += len;
+      n -= len;
+      m_gcount += len;
+   }
+}
+
+int shmistream::peek()
+{
+   uint64_t tail = m_hdr->consumer.position;
+   while (__atomic_load_n(&m_hdr->producer.position, __ATOMIC_ACQUIRE) == tail)
+   {
+      if (!waitFor(m_hdr->producer, tail))
+      {
+         m_fail = true;
+         return 0;
+      }
+   }
+   return (unsigned char)m_data[tail & m_mask];
+}
@@ -0,0 +1,94 @@
+#ifndef __SHM_STREAM_H
+#define __SHM_STREAM_H
+
+#include "zfstream.h"
+
+#include <stdint.h>
+
+// Single-producer, single-consumer byte ring in a shared file mapping, a drop-in replacement for the named pipes
+// between a frontend and the simulator. The simulator side creates the ring file (ShmRing::create) where it would
+// otherwise create a FIFO, Sift::Writer and Sift::Reader recognize it by its magic number and attach to it.
+// A full ring blocks the producer (back-pressure) and an empty ring blocks the consumer. A blocked side spins briefly,
+// then sleeps on a futex that the other side only rings when someone is actually waiting, so a stream that keeps up
+// never enters the kernel. Once both ends have detached the ring is reset, so a restarted application can reuse it.
+class ShmRing
+{
+   public:
+      static const uint32_t MAGIC = 0x52534853; // "SHSR"
+      static const uint32_t VERSION = 1;
+      static const uint64_t HEADER_SIZE = 4096;
+
+      // Create (or replace) filename as an empty ring of size bytes, rounded up to a power of two
+      static bool create(const char *filename, uint64_t size);
+      static bool isRing(const char *filename);
+
+   protected:
+      // Layout is shared with tools that create rings (run-sniper), which only fill in magic, version and size
+      struct Endpoint
+      {
+         uint64_t position;   // Bytes produced or consumed so far, only written by this end
+         uint32_t seq;        // Futex word, bumped whenever position moves while the other end is waiting on it
+         uint32_t waiters;    // Set by the other end before it sleeps on seq
+         int32_t pid;         // Process attached to this end, 0 if none
+         uint32_t closed;     // This end has detached, cleared when the ring is reset
+         char pad[40];
+      };
+      struct Header
+      {
+         uint32_t magic;
+         uint32_t version;
+         uint64_t size;       // Bytes in the data area, a power of two
+         uint32_t detached;   // Number of ends that have detached since the last reset
+         char pad[44];
+         Endpoint producer;
+         Endpoint consumer;
+      };
+
+      ShmRing(const char *filename);
+      ~ShmRing();
+
+      void attach(Endpoint &self);
+      void detach(Endpoint &self);
+      void publish(Endpoint &self, uint64_t position);
+      // Wait until peer.position differs from position, returns false if the peer detached or died first
+      bool waitFor(Endpoint &peer, uint64_t position);
+
+      void copyIn(uint64_t position, const char *s, size_t n);
+      void copyOut(uint64_t position, char *s, size_t n);
+
+      Header *m_hdr;
+      char *m_data;
+      uint64_t m_size;
+      uint64_t m_mask;
+};
+
+class shmostream : public vostream, private ShmRing
+{
+   private:
+      bool m_fail;
+   public:
+      shmostream(const char *filename);
+      virtual ~shmostream();
+      virtual void write(const char* s, std::streamsize n);
+      virtual void flush() {}
+      virtual bool fail() { return m_fail; }
+      virtual bool is_open() { return m_hdr != NULL; }
+};
+
+class shmistream : public vistream, private ShmRing
+{
+   private:
+      bool m_fail;
+      std::streamsize m_gcount;
+   public:
+      shmistream(const char *filename);
+      virtual ~shmistream();
+      virtual void read(char* s, std::streamsize n);
+      virtual int peek();
+      virtual bool fail() const { return m_fail; }
+      virtual std::streamsize gcount() const { return m_gcount; }
+
+      bool is_open() const { return m_hdr != NULL; }
+};
+
+#endif // __SHM_STREAM_H
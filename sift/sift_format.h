@@ -18,6 +18,14 @@
 # define SIFT_USE_ZLIB 1
 #endif
 
+// Optional block codecs for block-compressed traces, enable with SIFT_ZSTD=1 / SIFT_LZ4=1 on the make command line
+#ifndef SIFT_USE_ZSTD
+# define SIFT_USE_ZSTD 0
+#endif
+#ifndef SIFT_USE_LZ4
+# define SIFT_USE_LZ4 0
+#endif
+
 namespace Sift
 {
 
@@ -42,8 +50,76 @@ namespace Sift
       ArchIA32 = 2,
       IcacheVariable = 4,
       PhysicalAddress = 8,
+      CompressionBlock = 16,     //< Stream consists of independently compressed blocks followed by a block index
+      BasicBlocks = 32,          //< Straight-line instruction sequences are sent as basic blocks (see below)
    } Option;
 
+   // Block-compressed traces (CompressionBlock): after the Header, the stream is a sequence of blocks, each a
+   // BlockHeader followed by <size> bytes of compressed records. Blocks start on an instruction boundary with
+   // all state (icache pages, va2pa mappings, instruction address) resent, so decoding can start at any block.
+   // The last block is followed by an index: a BlockHeader with magic BlockIndexMagic, <size> bytes of
+   // BlockIndexEntry records, and a BlockIndexTrailer at the very end of the file pointing back to the index.
+   const uint32_t BlockMagic = 0x4b4c4253; // "SBLK"
+   const uint32_t BlockIndexMagic = 0x58444953; // "SIDX"
+   const uint32_t BlockSizeDefault = 1 << 20;
+
+   typedef enum
+   {
+      BlockCodecNone = 0,        //< Stored uncompressed
+      BlockCodecZlib = 1,
+      BlockCodecZstd = 2,
+      BlockCodecLz4 = 3,
+   } BlockCodec;
+
+   typedef struct
+   {
+      uint32_t magic;
+      uint8_t  codec;            //< BlockCodec
+      uint8_t  reserved[3];
+      uint32_t size;             //< Compressed size, in bytes
+      uint32_t raw_size;         //< Uncompressed size, in bytes
+      uint64_t icount;           //< Number of instructions written before this block
+   } __attribute__ ((__packed__)) BlockHeader;
+
+   typedef struct
+   {
+      uint64_t icount;
+      uint64_t offset;           //< File offset of the BlockHeader
+   } __attribute__ ((__packed__)) BlockIndexEntry;
+
+   typedef struct
+   {
+      uint64_t offset;           //< File offset of the index BlockHeader
+      uint32_t num_blocks;
+      uint32_t magic;            //< BlockIndexMagic
+   } __attribute__ ((__packed__)) BlockIndexTrailer;
+
+   // Basic-block encoding (BasicBlocks): a static basic block, a sequence of at most BasicBlockMaxInsns consecutive
+   // instructions of which only the last one can be a branch, is announced once by a RecOtherBasicBlockAnnounce
+   // record: a BasicBlockAnnounce header followed by one BasicBlockInsn descriptor per instruction.
+   // Its executions are sent as RecOtherBasicBlocks records, each holding a run of executions of the form
+   //   varint(id << 1 | taken) { zigzag-varint(address - previous address of this operand in this block) }*
+   // with one address delta per memory operand of the block, in instruction order. An announcement (re)starts
+   // the previous addresses of its block at zero. Block-compressed traces announce all blocks again in every block.
+   // Predicated instructions are always sent as individual records.
+   const uint32_t BasicBlockMaxInsns = 64;
+   const uint32_t BasicBlockRunSize = 4096;  //< Runs are sent once they reach this size, or before any other record
+
+   typedef struct
+   {
+      uint32_t id;
+      uint64_t addr;
+      uint8_t  num_insns;
+      uint8_t  insns[];          //< BasicBlockInsn
+   } __attribute__ ((__packed__)) BasicBlockAnnounce;
+
+   // Per-instruction descriptor: bits 0-3 size, bits 4-5 number of memory addresses, bit 6 is_branch
+   inline uint8_t BasicBlockInsn(uint8_t size, uint8_t num_addresses, bool is_branch)
+      { return size | (num_addresses << 4) | (is_branch << 6); }
+   inline uint8_t BasicBlockInsnSize(uint8_t insn) { return insn & 0xf; }
+   inline uint8_t BasicBlockInsnNumAddresses(uint8_t insn) { return (insn >> 4) & 0x3; }
+   inline bool BasicBlockInsnIsBranch(uint8_t insn) { return insn & 0x40; }
+
    typedef union
    {
       // Simple format for common instructions
@@ -116,6 +192,9 @@ namespace Sift
       RecOtherCacheOnly,
       RecOtherISAChange,
       RecOtherShutdown,
+      RecOtherBasicBlockAnnounce,
+      RecOtherBasicBlocks,
+      RecOtherSyscallAsync,   // Syscall whose return value the frontend does not use, answered without a RecOtherSyscallResponse
       RecOtherEnd = 0xff,
    } RecOtherType;
 
@@ -2,9 +2,15 @@
 #include "sift_format.h"
 #include "sift_utils.h"
 #include "zfstream.h"
+#include "zbstream.h"
+#include "mmap_stream.h"
+#include "prefetch_stream.h"
+#include "shm_stream.h"
+#include "shared_stream.h"
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <sys/types.h>
@@ -41,13 +47,29 @@ Sift::Reader::Reader(const char *filename, const char *response_filename, uint32
    , handleRoutineAnnounceFunc(NULL)
    , handleRoutineArg(NULL)   
    , filesize(0)
+   , inputstream(NULL)
    , last_address(0)
    , icache()
    , m_id(id)
    , m_trace_has_pa(false)
    , m_seen_end(false)
    , m_last_sinst(NULL)
+   , m_bb_run_offset(0)
+   , m_bb_current(NULL)
+   , m_bb_insn(0)
+   , m_bb_address(0)
+   , m_bb_taken(false)
+   , m_mmap_input(NULL)
+   , m_block_input(NULL)
+   , m_shared(NULL)
+   , m_shared_input(NULL)
+   , m_block_index()
+   , m_prefetch_chunks(0)
+   , m_prefetch_chunksize(0)
+   , m_use_mmap(false)
+   , m_rewindable(false)
    , m_isa(0)
+   , m_in_async_syscall(false)
 {
    m_filename = strdup(filename);
    m_response_filename = strdup(response_filename);
@@ -80,19 +102,61 @@ bool Sift::Reader::initStream()
    std::cerr << "[DEBUG:" << m_id << "] InitStream Attempting Open" << std::endl;
    #endif
 
-   inputstream = new std::ifstream(m_filename, std::ios::in);
+   bool is_file = false;
 
-   if ((!inputstream->is_open()) || (!inputstream->good()))
+   if (m_shared)
    {
-      std::cerr << "[SIFT:" << m_id << "] Cannot open " << m_filename << "\n";
-      return false;
+      // Header and decompression were handled by the shared reader
+      input = m_shared_input = m_shared->newConsumer();
+      m_trace_has_pa = m_shared->getTraceHasPhysicalAddresses();
+      filesize = m_shared->getLength();
+      return true;
    }
 
-   struct stat filestatus;
-   stat(m_filename, &filestatus);
-   filesize = filestatus.st_size;
+   if (ShmRing::isRing(m_filename))
+   {
+      shmistream *shm_input = new shmistream(m_filename);
+      if (!shm_input->is_open())
+      {
+         delete shm_input;
+         std::cerr << "[SIFT:" << m_id << "] Cannot open " << m_filename << "\n";
+         return false;
+      }
+      input = shm_input;
+   }
+   else
+   {
+      inputstream = new std::ifstream(m_filename, std::ios::in);
 
-   input = new vifstream(inputstream);
+      if ((!inputstream->is_open()) || (!inputstream->good()))
+      {
+         std::cerr << "[SIFT:" << m_id << "] Cannot open " << m_filename << "\n";
+         return false;
+      }
+
+      struct stat filestatus;
+      stat(m_filename, &filestatus);
+      filesize = filestatus.st_size;
+      is_file = S_ISREG(filestatus.st_mode);
+   }
+
+   if (m_use_mmap && is_file)
+   {
+      m_mmap_input = new mmapistream(m_filename);
+      if (m_mmap_input->is_open())
+      {
+         input = m_mmap_input;
+         delete inputstream;
+         inputstream = NULL;
+      }
+      else
+      {
+         delete m_mmap_input;
+         m_mmap_input = NULL;
+      }
+   }
+   if (!input)
+      input = new vifstream(inputstream);
 
    Sift::Header hdr;
    input->read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
@@ -106,6 +170,7 @@ bool Sift::Reader::initStream()
       std::cerr << "[SIFT:" << m_id << "] Invalid header size\n";
    }
 
+   bool zlib = hdr.options & CompressionZlib;
 #if SIFT_USE_ZLIB
    if (hdr.options & CompressionZlib)
    {
@@ -119,6 +184,12 @@ bool Sift::Reader::initStream()
    }
 #endif
 
+   if (hdr.options & CompressionBlock)
+   {
+      input = m_block_input = new ibzstream(input);
+      hdr.options &= ~CompressionBlock;
+   }
+
    if (hdr.options & ArchIA32)
    {
       hdr.options &= ~ArchIA32;
@@ -132,6 +203,18 @@ bool Sift::Reader::initStream()
 
    hdr.options &= ~IcacheVariable;
 
+   // Recognized below in the record stream, no setup needed
+   hdr.options &= ~BasicBlocks;
+
+   // Pipes and rings can depend on our responses to make progress, so only read ahead on regular files
+   if (m_prefetch_chunks >= 2 && m_prefetch_chunksize > 0 && is_file)
+   {
+      input = new prefetchistream(input, m_prefetch_chunks, m_prefetch_chunksize);
+   }
+
+   // Rewind() seeks the file and resets the block decompressor, other stream layers keep state we cannot reset
+   m_rewindable = is_file && !zlib && !(m_prefetch_chunks >= 2 && m_prefetch_chunksize > 0);
+
    // Make sure there are no unrecognized options
    if (hdr.options != 0)
    {
@@ -154,7 +237,10 @@ bool Sift::Reader::initResponse()
          std::cerr << "[SIFT:" << m_id << "] Response filename not set\n";
          return false;
       }
-      response = new vofstream(m_response_filename, std::ios::out);
+      if (ShmRing::isRing(m_response_filename))
+         response = new shmostream(m_response_filename);
+      else
+         response = new vofstream(m_response_filename, std::ios::out);
    }
 
    if ((!response->is_open()) || (response->fail()))
@@ -179,6 +265,12 @@ bool Sift::Reader::Read(Instruction &inst)
 
    while(!m_seen_end)
    {
+      if (m_bb_current || m_bb_run_offset < m_bb_run.size())
+      {
+         nextBasicBlockInstruction(inst);
+         return true;
+      }
+
       Record rec;
       uint8_t byte = input->peek();
       if (input->fail())
@@ -203,10 +295,11 @@ bool Sift::Reader::Read(Instruction &inst)
             {
                assert(rec.Other.size == sizeof(uint64_t) + ICACHE_SIZE);
                uint64_t address;
-               uint8_t *bytes = new uint8_t[ICACHE_SIZE];
                input->read(reinterpret_cast<char*>(&address), sizeof(uint64_t));
-               input->read(reinterpret_cast<char*>(bytes), ICACHE_SIZE);
-               icache[address] = bytes;
+               // Block-compressed traces resend pages at every block, reuse the existing copy
+               if (icache.count(address) == 0)
+                  icache[address] = new uint8_t[ICACHE_SIZE];
+               input->read(const_cast<char*>(reinterpret_cast<const char*>(icache[address])), ICACHE_SIZE);
                break;
             }
             case RecOtherIcacheVariable:
@@ -294,6 +387,7 @@ bool Sift::Reader::Read(Instruction &inst)
                break;
             }
             case RecOtherSyscallRequest:
+            case RecOtherSyscallAsync:
             {
                #if VERBOSE > 0
                std::cerr << "[DEBUG:" << m_id << "] Read SyscallRequest" << std::endl;
@@ -322,8 +416,18 @@ bool Sift::Reader::Read(Instruction &inst)
                   #if VERBOSE > 0
                   std::cerr << "[DEBUG:" << m_id << "] HandleSyscall" << std::endl;
                   #endif
-                  uint64_t ret = handleSyscallFunc(handleSyscallArg, syscall_number, bytes, size);
-                  sendSyscallResponse(ret);
+                  if (rec.Other.type == RecOtherSyscallAsync)
+                  {
+                     // The frontend has moved on without waiting for us, so it cannot serve memory requests
+                     m_in_async_syscall = true;
+                     handleSyscallFunc(handleSyscallArg, syscall_number, bytes, size);
+                     m_in_async_syscall = false;
+                  }
+                  else
+                  {
+                     uint64_t ret = handleSyscallFunc(handleSyscallArg, syscall_number, bytes, size);
+                     sendSyscallResponse(ret);
+                  }
                }
                delete [] bytes;
                break;
@@ -470,6 +574,18 @@ bool Sift::Reader::Read(Instruction &inst)
 
                break;
             }
+            case RecOtherBasicBlockAnnounce:
+            {
+               announceBasicBlock(rec.Other.size);
+               break;
+            }
+            case RecOtherBasicBlocks:
+            {
+               m_bb_run.resize(rec.Other.size);
+               input->read(reinterpret_cast<char*>(&m_bb_run[0]), rec.Other.size);
+               m_bb_run_offset = 0;
+               break;
+            }
             default:
             {
                uint8_t *bytes = new uint8_t[rec.Other.size];
@@ -563,30 +679,27 @@ bool Sift::Reader::AccessMemory(MemoryLockType lock_signal, MemoryOpType mem_op,
       }
    }
 
-   if (!initResponse())
+   if (m_in_async_syscall)
    {
-      std::cerr << "[SIFT:" << m_id << "] Error: initResponse failed\n";
+      std::cerr << "[SIFT:" << m_id << "] Error: Memory access during an asynchronous system call\n";
       return false;
    }
 
-   Record rec;
-   rec.Other.zero = 0;
-   rec.Other.type = RecOtherMemoryRequest;
-   rec.Other.size = sizeof(d_addr) + sizeof(data_size) + sizeof(lock_signal) + sizeof(mem_op);
-   if (mem_op == MemWrite)
+   if (!initResponse())
    {
-      rec.Other.size += data_size;
+      std::cerr << "[SIFT:" << m_id << "] Error: initResponse failed\n";
+      return false;
    }
-   response->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
-   response->write(reinterpret_cast<char*>(&d_addr), sizeof(d_addr));
-   response->write(reinterpret_cast<char*>(&data_size), sizeof(data_size));
-   response->write(reinterpret_cast<char*>(&lock_signal), sizeof(lock_signal));
-   response->write(reinterpret_cast<char*>(&mem_op), sizeof(mem_op));
+
+   m_response_record.begin(RecOtherMemoryRequest).add(&d_addr, sizeof(d_addr)).add(&data_size, sizeof(data_size))
+      .add(&lock_signal, sizeof(lock_signal)).add(&mem_op, sizeof(mem_op));
    if (mem_op == MemWrite)
    {
-      response->write(reinterpret_cast<char*>(data_buffer), data_size);
+      m_response_record.add(data_buffer, data_size);
    }
-   response->flush();
+   m_response_record.write(response);
+
+   Record rec;
 
    #if VERBOSE > 0
    std::cerr << "[DEBUG:" << m_id << "] Read MemoryResponse" << std::endl;
@@ -701,6 +814,113 @@ const Sift::StaticInstruction* Sift::Reader::getStaticInstruction(uint64_t addr,
    return sinst;
 }
 
+void Sift::Reader::announceBasicBlock(uint32_t size)
+{
+   BasicBlockAnnounce announce;
+   assert(size > sizeof(announce));
+   input->read(reinterpret_cast<char*>(&announce), sizeof(announce));
+   assert(size == sizeof(announce) + announce.num_insns);
+
+   if (announce.id >= m_bb_table.size())
+      m_bb_table.resize(announce.id + 1);
+   BasicBlock &block = m_bb_table[announce.id];
+   block.insns.resize(announce.num_insns);
+   input->read(reinterpret_cast<char*>(&block.insns[0]), announce.num_insns);
+
+   // Code for all instructions in the block has been sent by now
+   block.sinsts.clear();
+   size_t num_addresses = 0;
+   uint64_t addr = announce.addr;
+   for(uint8_t insn : block.insns)
+   {
+      uint8_t insn_size = BasicBlockInsnSize(insn);
+      auto it = scache.find(addr);
+      if (it == scache.end())
+         it = scache.insert(std::make_pair(addr, staticInfoInstruction(addr, insn_size))).first;
+      assert(it->second->size == insn_size);
+      block.sinsts.push_back(it->second);
+      num_addresses += BasicBlockInsnNumAddresses(insn);
+      addr += insn_size;
+   }
+   block.addresses.assign(num_addresses, 0);
+}
+
+void Sift::Reader::nextBasicBlockInstruction(Instruction &inst)
+{
+   if (!m_bb_current)
+   {
+      // Decode the next execution in the run: block id, branch outcome, and address deltas
+      const uint8_t *data = &m_bb_run[m_bb_run_offset];
+      uint64_t value = decodeVarint(data);
+      assert((value >> 1) < m_bb_table.size());
+      BasicBlock &block = m_bb_table[value >> 1];
+      for(uint64_t &address : block.addresses)
+         address += zigzagDecode(decodeVarint(data));
+      m_bb_run_offset = data - &m_bb_run[0];
+      assert(m_bb_run_offset <= m_bb_run.size());
+
+      m_bb_current = &block;
+      m_bb_insn = 0;
+      m_bb_address = 0;
+      m_bb_taken = value & 1;
+   }
+
+   const BasicBlock &block = *m_bb_current;
+   uint8_t insn = block.insns[m_bb_insn];
+   inst.sinst = block.sinsts[m_bb_insn];
+   inst.num_addresses = BasicBlockInsnNumAddresses(insn);
+   for(int i = 0; i < inst.num_addresses; ++i)
+      inst.addresses[i] = block.addresses[m_bb_address++];
+   inst.is_branch = BasicBlockInsnIsBranch(insn);
+   inst.taken = inst.is_branch && m_bb_taken;
+   inst.is_predicate = false;
+   inst.executed = true;
+   inst.isa = m_isa;
+
+   if (++m_bb_insn == block.insns.size())
+   {
+      // Leave the state as if the block's instructions had been read one by one
+      m_bb_current = NULL;
+      last_address = inst.sinst->addr + inst.sinst->size;
+      m_last_sinst = inst.sinst;
+   }
+}
+
+size_t Sift::Reader::peekBranches(BranchOutcome *outcomes, size_t max, uint64_t &next_addr)
+{
+   const BasicBlock *block = m_bb_current;
+   bool taken = m_bb_taken;
+   next_addr = block ? block->sinsts[m_bb_insn]->addr : 0;
+
+   size_t count = 0;
+   const uint8_t *data = m_bb_run.data() + m_bb_run_offset;
+   const uint8_t *end = m_bb_run.data() + m_bb_run.size();
+   while(data < end && (count < max || !next_addr))
+   {
+      // Only the block id and outcome are needed, skip the address deltas
+      uint64_t value = decodeVarint(data);
+      assert((value >> 1) < m_bb_table.size());
+      const BasicBlock *next = &m_bb_table[value >> 1];
+      for(size_t i = 0; i < next->addresses.size(); ++i)
+         decodeVarint(data);
+
+      uint64_t addr = next->sinsts[0]->addr;
+      if (!next_addr)
+         next_addr = addr;
+      if (block && BasicBlockInsnIsBranch(block->insns.back()) && count < max)
+      {
+         BranchOutcome &outcome = outcomes[count++];
+         outcome.sinst = block->sinsts.back();
+         outcome.target = addr;
+         outcome.taken = taken;
+      }
+
+      block = next;
+      taken = value & 1;
+   }
+   return count;
+}
+
 void Sift::Reader::sendSyscallResponse(uint64_t return_code)
 {
    #if VERBOSE > 0
@@ -712,13 +932,7 @@ void Sift::Reader::sendSyscallResponse(uint64_t return_code)
       std::cerr << "[SIFT:" << m_id << "] Error: initResponse failed\n";
    }
 
-   Record rec;
-   rec.Other.zero = 0;
-   rec.Other.type = RecOtherSyscallResponse;
-   rec.Other.size = sizeof(return_code);
-   response->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
-   response->write(reinterpret_cast<char*>(&return_code), sizeof(return_code));
-   response->flush();
+   m_response_record.begin(RecOtherSyscallResponse).add(&return_code, sizeof(return_code)).write(response);
 }
 
 void Sift::Reader::sendEmuResponse(bool handled, EmuReply res)
@@ -732,15 +946,8 @@ void Sift::Reader::sendEmuResponse(bool handled, EmuReply res)
       std::cerr << "[SIFT:" << m_id << "] Error: initResponse failed\n";
    }
 
-   Record rec;
-   rec.Other.zero = 0;
-   rec.Other.type = RecOtherEmuResponse;
-   rec.Other.size = sizeof(uint8_t) + sizeof(EmuReply);
    uint8_t result = handled;
-   response->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
-   response->write(reinterpret_cast<char*>(&result), sizeof(uint8_t));
-   response->write(reinterpret_cast<char*>(&res), sizeof(EmuReply));
-   response->flush();
+   m_response_record.begin(RecOtherEmuResponse).add(&result, sizeof(uint8_t)).add(&res, sizeof(EmuReply)).write(response);
 }
 
 void Sift::Reader::sendSimpleResponse(RecOtherType type, void *data, uint32_t size)
@@ -754,21 +961,160 @@ void Sift::Reader::sendSimpleResponse(RecOtherType type, void *data, uint32_t si
       std::cerr << "[SIFT:" << m_id << "] Error: initResponse failed\n";
    }
 
-   Record rec;
-   rec.Other.zero = 0;
-   rec.Other.type = type;
-   rec.Other.size = size;
-   response->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
-   if (size > 0)
+   m_response_record.begin(type).add(data, size).write(response);
+}
+
+bool Sift::Reader::getBlockIndex(std::vector<BlockIndexEntry> &index)
+{
+   if (input == NULL)
+   {
+      if (!initStream())
+         return false;
+   }
+
+   if (m_block_input == NULL)
+   {
+      std::cerr << "[SIFT:" << m_id << "] Error: Trace is not block-compressed\n";
+      return false;
+   }
+
+   if (m_block_index.empty())
    {
-      response->write(reinterpret_cast<char*>(data), size);
+      // Use a separate stream so we don't disturb the current read position
+      std::ifstream file(m_filename, std::ios::in | std::ios::binary);
+      BlockIndexTrailer trailer;
+      BlockHeader hdr;
+      file.seekg(-std::streamoff(sizeof(trailer)), std::ios::end);
+      file.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+      if (file.fail() || trailer.magic != BlockIndexMagic)
+      {
+         std::cerr << "[SIFT:" << m_id << "] Error: Block index not found, trace is incomplete\n";
+         return false;
+      }
+      file.seekg(trailer.offset);
+      file.read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+      if (file.fail() || hdr.magic != BlockIndexMagic || hdr.size != trailer.num_blocks * sizeof(BlockIndexEntry))
+      {
+         std::cerr << "[SIFT:" << m_id << "] Error: Invalid block index\n";
+         return false;
+      }
+      m_block_index.resize(trailer.num_blocks);
+      if (trailer.num_blocks)
+         file.read(reinterpret_cast<char*>(&m_block_index[0]), hdr.size);
+      if (file.fail())
+      {
+         m_block_index.clear();
+         return false;
+      }
    }
-   response->flush();
+
+   index = m_block_index;
+   return true;
+}
+
+bool Sift::Reader::Seek(uint64_t icount, uint64_t *actual)
+{
+   if (m_shared)
+   {
+      std::cerr << "[SIFT:" << m_id << "] Error: Cannot seek in a shared trace\n";
+      return false;
+   }
+
+   std::vector<BlockIndexEntry> index;
+   if (!getBlockIndex(index) || index.empty())
+      return false;
+
+   if (input != m_block_input)
+   {
+      std::cerr << "[SIFT:" << m_id << "] Error: Cannot seek while prefetching\n";
+      return false;
+   }
+
+   // Last block starting at or before icount
+   std::vector<BlockIndexEntry>::iterator it = std::upper_bound(index.begin(), index.end(), icount,
+      [](uint64_t value, const BlockIndexEntry &entry) { return value < entry.icount; });
+   if (it != index.begin())
+      --it;
+
+   if (m_mmap_input)
+   {
+      m_mmap_input->seek(it->offset);
+   }
+   else
+   {
+      inputstream->clear();
+      inputstream->seekg(it->offset);
+   }
+   m_block_input->reset();
+   m_seen_end = false;
+   m_last_sinst = NULL;
+   m_bb_run.clear();
+   m_bb_run_offset = 0;
+   m_bb_current = NULL;
+
+   if (actual)
+      *actual = it->icount;
+   return true;
+}
+
+bool Sift::Reader::Rewind()
+{
+   if (!m_rewindable)
+      return false;
+
+   if (m_mmap_input)
+   {
+      m_mmap_input->seek(sizeof(Sift::Header));
+   }
+   else
+   {
+      inputstream->clear();
+      inputstream->seekg(sizeof(Sift::Header));
+   }
+   if (m_block_input)
+      m_block_input->reset();
+   last_address = 0;
+   m_seen_end = false;
+   m_last_sinst = NULL;
+   m_bb_run.clear();
+   m_bb_run_offset = 0;
+   m_bb_current = NULL;
+   m_in_async_syscall = false;
+
+   return true;
+}
+
+bool Sift::Reader::Restart(Reader &finished)
+{
+   assert(input == NULL);
+   if (!finished.m_rewindable || finished.response || strcmp(m_filename, finished.m_filename) != 0)
+      return false;
+
+   std::swap(input, finished.input);
+   std::swap(inputstream, finished.inputstream);
+   std::swap(filesize, finished.filesize);
+   std::swap(m_mmap_input, finished.m_mmap_input);
+   std::swap(m_block_input, finished.m_block_input);
+   std::swap(m_block_index, finished.m_block_index);
+   std::swap(m_rewindable, finished.m_rewindable);
+   std::swap(m_trace_has_pa, finished.m_trace_has_pa);
+   std::swap(m_isa, finished.m_isa);
+   // Basic blocks point into scache, both move along
+   std::swap(icache, finished.icache);
+   std::swap(scache, finished.scache);
+   std::swap(vcache, finished.vcache);
+   std::swap(m_bb_table, finished.m_bb_table);
+
+   return Rewind();
 }
 
 uint64_t Sift::Reader::getPosition()
 {
-   if (inputstream)
+   if (m_mmap_input)
+      return m_mmap_input->tell();
+   else if (m_shared_input)
+      return m_shared_input->tell();
+   else if (inputstream)
       return inputstream->tellg();
    else
       return 0;
@@ -3,13 +3,19 @@
 
 #include "sift.h"
 #include "sift_format.h"
+#include "sift_utils.h"
 
 #include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <cassert>
 
 class vistream;
 class vostream;
+class ibzstream;
+class mmapistream;
+class sharedistream;
+class SharedTrace;
 
 namespace Sift
 {
@@ -38,6 +44,14 @@ namespace Sift
       int isa;
    } Instruction;
 
+   // Upcoming branch, as returned by Reader::peekBranches
+   typedef struct
+   {
+      const StaticInstruction *sinst;
+      uint64_t target;           //< Address of the instruction executed after the branch
+      bool taken;
+   } BranchOutcome;
+
    class Reader
    {
       typedef Mode (*HandleInstructionCountFunc)(void* arg, uint32_t icount);
@@ -92,12 +106,43 @@ namespace Sift
          bool m_trace_has_pa;
          bool m_seen_end;
          const StaticInstruction *m_last_sinst;
+
+         // Basic-block encoding (BasicBlocks option): announced blocks, with their static instructions looked up once
+         struct BasicBlock
+         {
+            std::vector<const StaticInstruction*> sinsts;
+            std::vector<uint8_t> insns;         // BasicBlockInsn descriptors
+            std::vector<uint64_t> addresses;    // Addresses of the current (last decoded) execution
+         };
+         std::vector<BasicBlock> m_bb_table;
+         std::vector<uint8_t> m_bb_run;         // Current run of block executions
+         size_t m_bb_run_offset;
+         const BasicBlock *m_bb_current;        // Execution being expanded, NULL if none
+         size_t m_bb_insn;
+         size_t m_bb_address;
+         bool m_bb_taken;
+
+         mmapistream *m_mmap_input;
+         ibzstream *m_block_input;
+         SharedTrace *m_shared;
+         sharedistream *m_shared_input;
+         std::vector<BlockIndexEntry> m_block_index;
+
+         uint32_t m_prefetch_chunks;
+         uint32_t m_prefetch_chunksize;
+         bool m_use_mmap;
+         bool m_rewindable;                     // Regular file without zlib compression or read-ahead
          
          int m_isa;
 
+         RecordBuffer m_response_record;
+         bool m_in_async_syscall;
+
          bool initResponse();
          const Sift::StaticInstruction* staticInfoInstruction(uint64_t addr, uint8_t size);
          const Sift::StaticInstruction* getStaticInstruction(uint64_t addr, uint8_t size);
+         void announceBasicBlock(uint32_t size);
+         void nextBasicBlockInstruction(Instruction &inst);
          void sendSyscallResponse(uint64_t return_code);
          void sendEmuResponse(bool handled, EmuReply res);
          void sendSimpleResponse(RecOtherType type, void *data = NULL, uint32_t size = 0);
@@ -119,6 +164,36 @@ namespace Sift
          void setHandleEmuFunc(HandleEmuFunc func, void* arg = NULL) { assert(func); handleEmuFunc = func; handleEmuArg = arg; }
          void setHandleRoutineFunc(HandleRoutineChange funcChange, HandleRoutineAnnounce funcAnnounce, void* arg = NULL) { assert(funcChange); assert(funcAnnounce); handleRoutineChangeFunc = funcChange; handleRoutineAnnounceFunc = funcAnnounce; handleRoutineArg = arg; }
          void setHandleForkFunc(HandleForkFunc func, void* arg = NULL) { assert(func); handleForkFunc = func; handleForkArg = arg;}
+         // Read ahead (and decompress) the trace on a helper thread into num_chunks buffers of chunksize bytes,
+         // must be called before initStream(). Only used when the trace is a regular file.
+         void setPrefetch(uint32_t num_chunks, uint32_t chunksize) { m_prefetch_chunks = num_chunks; m_prefetch_chunksize = chunksize; }
+         // Read the trace through a shared memory mapping instead of std::ifstream, must be called before initStream().
+         // Only used when the trace is a regular file.
+         void setMmap(bool use_mmap) { m_use_mmap = use_mmap; }
+         // Read the trace from a SharedTrace (decoded once for all copies of the same trace) rather than opening
+         // the file ourselves, must be called before initStream(). Such a stream cannot seek.
+         void setShared(SharedTrace *shared) { m_shared = shared; }
+
+         // Block-compressed traces only: read the block index, which lists the instruction count and
+         // file offset of every block
+         bool getBlockIndex(std::vector<BlockIndexEntry> &index);
+         // Block-compressed traces only: continue reading at the start of the last block that begins at or
+         // before instruction <icount>. Returns the number of instructions preceding that block in <actual>,
+         // the remaining ones should be skipped by the caller.
+         bool Seek(uint64_t icount, uint64_t *actual = NULL);
+         // Continue reading at the start of the trace, keeping the static instruction and basic-block caches.
+         // Only for regular files that are not zlib-compressed, read ahead or shared, returns false otherwise.
+         bool Rewind();
+         // Replay the trace <finished> has read to the end, from the start: take over its open stream and caches,
+         // and rewind. Must be called instead of initStream(), returns false (nothing taken) when <finished> cannot rewind.
+         bool Restart(Reader &finished);
+
+         // Basic-block encoded traces only: look at the branches ending the executions that remain in the current
+         // run, in the order Read() will return them, without consuming anything. Returns the number of branches
+         // written (at most <max>). <next_addr> is set to the address of the next instruction Read() will return,
+         // or zero if that is not known yet. The last execution of a run is never included, its target is only
+         // known once the next record has been read.
+         size_t peekBranches(BranchOutcome *outcomes, size_t max, uint64_t &next_addr);
 
          uint64_t getPosition();
          uint64_t getLength();
@@ -1,7 +1,9 @@
 #include "sift_utils.h"
 #include "sift_format.h"
+#include "zfstream.h"
 
 #include <cstdio>
+#include <cstring>
 
 void Sift::hexdump(const void * __data, uint32_t size)
 {
@@ -16,3 +18,28 @@ void Sift::hexdump(const void * __data, uint32_t size)
    }
    printf("\n");
 }
+
+Sift::RecordBuffer &Sift::RecordBuffer::begin(uint8_t type)
+{
+   Record rec;
+   rec.Other.zero = 0;
+   rec.Other.type = type;
+   rec.Other.size = 0;
+   m_data.assign(reinterpret_cast<char*>(&rec), reinterpret_cast<char*>(&rec) + sizeof(rec.Other));
+   return *this;
+}
+
+Sift::RecordBuffer &Sift::RecordBuffer::add(const void *data, uint32_t size)
+{
+   m_data.insert(m_data.end(), reinterpret_cast<const char*>(data), reinterpret_cast<const char*>(data) + size);
+   return *this;
+}
+
+void Sift::RecordBuffer::write(vostream *stream)
+{
+   Record rec;
+   uint32_t size = m_data.size() - sizeof(rec.Other);
+   memcpy(&m_data[offsetof(Record, Other.size)], &size, sizeof(size));
+   stream->write(m_data.data(), m_data.size());
+   stream->flush();
+}
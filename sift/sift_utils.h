@@ -3,9 +3,49 @@
 
 #include "sift.h"
 
+#include <vector>
+
+class vostream;
+
 namespace Sift
 {
    void hexdump(const void * data, uint32_t size);
+
+   // Assembles an Other record and its payload so it goes out in a single write. On a shared-memory ring
+   // this publishes the record once, rather than waking up the other side for the header and each field.
+   class RecordBuffer
+   {
+      private:
+         std::vector<char> m_data;
+      public:
+         RecordBuffer &begin(uint8_t type);
+         RecordBuffer &add(const void *data, uint32_t size);
+         void write(vostream *stream);
+   };
+
+   // LEB128 variable-length integers, and the zigzag mapping of signed deltas onto them
+   inline void encodeVarint(std::vector<uint8_t> &buffer, uint64_t value)
+   {
+      while (value >= 0x80)
+      {
+         buffer.push_back(uint8_t(value) | 0x80);
+         value >>= 7;
+      }
+      buffer.push_back(uint8_t(value));
+   }
+   inline uint64_t decodeVarint(const uint8_t *&data)
+   {
+      uint64_t value = 0;
+      for(unsigned int shift = 0; ; shift += 7)
+      {
+         uint8_t byte = *data++;
+         value |= uint64_t(byte & 0x7f) << shift;
+         if (!(byte & 0x80))
+            return value;
+      }
+   }
+   inline uint64_t zigzagEncode(int64_t value) { return (uint64_t(value) << 1) ^ uint64_t(value >> 63); }
+   inline int64_t zigzagDecode(uint64_t value) { return int64_t(value >> 1) ^ -int64_t(value & 1); }
 };
 
 #endif // __SIFT_UTILS_H
@@ -4,6 +4,9 @@
 #include "sift_utils.h"
 #include "sift_assert.h"
 #include "zfstream.h"
+#include "zbstream.h"
+#include "shm_stream.h"
+#include "async_stream.h"
 
 #include <cstdlib>
 #include <cstring>
@@ -39,8 +42,10 @@ __sift_assert_fail(__const char *__assertion, __const char *__file,
 }
 
 
-Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression, const char *response_filename, uint32_t id, bool arch32, bool requires_icache_per_insn, bool send_va2pa_mapping, GetCodeFunc2 getCodeFunc2, void* getCodeFunc2Data)
-   : response(NULL)
+Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression, const char *response_filename, uint32_t id, bool arch32, bool requires_icache_per_insn, bool send_va2pa_mapping, GetCodeFunc2 getCodeFunc2, void* getCodeFunc2Data, BlockCodec block_codec, uint32_t block_size, AsyncWriter *async_writer, bool basic_blocks)
+   : m_block_output(NULL)
+   , m_async_output(NULL)
+   , response(NULL)
    , getCodeFunc(getCodeFunc)
    , getCodeFunc2(getCodeFunc2)
    , getCodeFunc2Data(getCodeFunc2Data)
@@ -56,6 +61,7 @@ Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useComp
    , m_id(id)
    , m_requires_icache_per_insn(requires_icache_per_insn)
    , m_send_va2pa_mapping(send_va2pa_mapping)
+   , m_basic_blocks(basic_blocks)
 {
    memset(hsize, 0, sizeof(hsize));
    memset(haddr, 0, sizeof(haddr));
@@ -63,6 +69,19 @@ Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useComp
    m_response_filename = strdup(response_filename);
 
    uint64_t options = 0;
+   if (block_codec != BlockCodecNone)
+   {
+      if (obzstream::isSupported(block_codec))
+      {
+         // Block compression replaces whole-stream compression
+         options |= CompressionBlock;
+         useCompression = false;
+      }
+      else
+      {
+         std::cerr << "[SIFT:" << m_id << "] Warning: Block codec " << int(block_codec) << " disabled at compile time, ignoring request.\n";
+      }
+   }
 #if SIFT_USE_ZLIB
    if (useCompression)
       options |= CompressionZlib;
@@ -77,8 +96,13 @@ Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useComp
       options |= IcacheVariable;
    if (m_send_va2pa_mapping)
       options |= PhysicalAddress;
+   if (m_basic_blocks)
+      options |= BasicBlocks;
 
-   output = new vofstream(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+   if (ShmRing::isRing(filename))
+      output = new shmostream(filename);
+   else
+      output = new vofstream(filename, std::ios::out | std::ios::binary | std::ios::trunc);
 
    if (!output->is_open())
    {
@@ -101,6 +125,13 @@ Sift::Writer::Writer(const char *filename, GetCodeFunc getCodeFunc, bool useComp
 
    if (options & CompressionZlib)
       output = new ozstream(output);
+   else if (options & CompressionBlock)
+      output = m_block_output = new obzstream(output, block_codec, block_size, sizeof(hdr));
+
+   // Hand (compressing and) writing the stream off to a dedicated thread. Flushes become no-ops,
+   // which is fine as long as nobody waits on our output (no response channel).
+   if (async_writer)
+      output = m_async_output = new asyncostream(output, async_writer, m_block_output, block_size);
 }
 
 // Modified from http://stackoverflow.com/questions/2203159/is-there-a-c-equivalent-to-getcwd
@@ -116,7 +147,10 @@ void Sift::Writer::initResponse()
    {
      sift_assert(strcmp(m_response_filename, "") != 0);
      //response = new vifstream(m_response_filename, std::ios::in);
-     response = new cvifstream(m_response_filename, std::ios_base::in);
+     if (ShmRing::isRing(m_response_filename))
+       response = new shmistream(m_response_filename);
+     else
+       response = new cvifstream(m_response_filename, std::ios_base::in);
      sift_assert(!response->fail());
    }
 }
@@ -129,6 +163,8 @@ void Sift::Writer::End()
 
    if (output)
    {
+      flushBasicBlocks();
+
       Record rec;
       rec.Other.zero = 0;
       rec.Other.type = RecOtherEnd;
@@ -158,6 +194,8 @@ void Sift::Writer::End()
    {
       delete output;
       output = NULL;
+      m_block_output = NULL;
+      m_async_output = NULL;
    }
 }
 
@@ -189,6 +227,22 @@ void Sift::Writer::Instruction(uint64_t addr, uint8_t size, uint8_t num_addresse
       return;
    }
 
+   if (m_block_output && (m_async_output ? m_async_output->full() : m_block_output->full()))
+   {
+      // Start a new block, and make it self-contained so readers can start decoding here:
+      // resend code, va2pa mappings and basic blocks, and force the next instruction into the extended format
+      flushBasicBlocks();
+      m_bb_table.clear();
+      m_bb_ids.clear();
+      if (m_async_output)
+         m_async_output->startBlock(ninstrs);
+      else
+         m_block_output->startBlock(ninstrs);
+      icache.clear();
+      m_va2pa.clear();
+      last_address = 0;
+   }
+
    if (m_requires_icache_per_insn)
    {
       if (! icache[addr])
@@ -256,6 +310,27 @@ void Sift::Writer::Instruction(uint64_t addr, uint8_t size, uint8_t num_addresse
    for(int i = 0; i < num_addresses; ++i)
       send_va2pa(addresses[i]);
 
+   ninstrs++;
+   hsize[size]++;
+   haddr[num_addresses]++;
+   if (is_branch)
+      nbranch++;
+   if (is_predicate)
+      npredicate++;
+
+   // Code and va2pa records can go out ahead of the instructions that are still being collected into basic blocks,
+   // everything else (including predicated instructions, which have no block encoding) has to wait for them
+   if (m_basic_blocks)
+   {
+      if (!is_predicate)
+      {
+         addBasicBlockInstruction(addr, size, num_addresses, addresses, is_branch, taken);
+         last_address = addr + size;
+         return;
+      }
+      flushBasicBlocks();
+   }
+
    // Try as simple instruction
    if (addr == last_address && !is_predicate)
    {
@@ -308,14 +383,106 @@ void Sift::Writer::Instruction(uint64_t addr, uint8_t size, uint8_t num_addresse
       output->write(reinterpret_cast<char*>(&addresses[i]), sizeof(uint64_t));
 
    last_address += size;
+}
+
+void Sift::Writer::InstructionBlock(uint32_t count, const InstructionInfo insns[], uint64_t addresses[])
+{
+   for(uint32_t i = 0; i < count; ++i)
+   {
+      Instruction(insns[i].addr, insns[i].size, insns[i].num_addresses, addresses, insns[i].is_branch, insns[i].taken, insns[i].is_predicate, insns[i].executed);
+      addresses += insns[i].num_addresses;
+   }
+}
+
+void Sift::Writer::addBasicBlockInstruction(uint64_t addr, uint8_t size, uint8_t num_addresses, uint64_t addresses[], bool is_branch, bool taken)
+{
+   // Blocks are straight-line code: a discontinuity without a branch (e.g., a gap in the trace) ends the block
+   if (!m_bb_current.insns.empty() && addr != last_address)
+      endBasicBlock(false);
+
+   if (m_bb_current.insns.empty())
+      m_bb_current.addr = addr;
+   m_bb_current.insns.push_back(BasicBlockInsn(size, num_addresses, is_branch));
+   m_bb_current.addresses.insert(m_bb_current.addresses.end(), addresses, addresses + num_addresses);
 
-   ninstrs++;
-   hsize[size]++;
-   haddr[num_addresses]++;
    if (is_branch)
-      nbranch++;
-   if (is_predicate)
-      npredicate++;
+      endBasicBlock(taken);
+   else if (m_bb_current.insns.size() == BasicBlockMaxInsns)
+      endBasicBlock(false);
+}
+
+void Sift::Writer::endBasicBlock(bool taken)
+{
+   uint32_t id = getBasicBlockId();
+   std::vector<uint64_t> &previous = m_bb_table[id].addresses;
+
+   encodeVarint(m_bb_run, (uint64_t(id) << 1) | taken);
+   for(size_t i = 0; i < previous.size(); ++i)
+   {
+      encodeVarint(m_bb_run, zigzagEncode(int64_t(m_bb_current.addresses[i] - previous[i])));
+      previous[i] = m_bb_current.addresses[i];
+   }
+
+   m_bb_current.insns.clear();
+   m_bb_current.addresses.clear();
+
+   if (m_bb_run.size() >= BasicBlockRunSize)
+      flushBasicBlocks();
+}
+
+uint32_t Sift::Writer::getBasicBlockId()
+{
+   // Different blocks can start at the same address, e.g. when entered by different branches with different targets
+   auto range = m_bb_ids.equal_range(m_bb_current.addr);
+   for(auto it = range.first; it != range.second; ++it)
+   {
+      if (m_bb_table[it->second].insns == m_bb_current.insns)
+         return it->second;
+   }
+
+   uint32_t id = m_bb_table.size();
+   m_bb_table.push_back(BasicBlock());
+   BasicBlock &block = m_bb_table.back();
+   block.addr = m_bb_current.addr;
+   block.insns = m_bb_current.insns;
+   block.addresses.resize(m_bb_current.addresses.size(), 0);
+   m_bb_ids.insert(std::make_pair(block.addr, id));
+
+   // Announcements only add static information, so they can be written before the pending run that uses them
+   BasicBlockAnnounce announce;
+   announce.id = id;
+   announce.addr = block.addr;
+   announce.num_insns = block.insns.size();
+
+   Record rec;
+   rec.Other.zero = 0;
+   rec.Other.type = RecOtherBasicBlockAnnounce;
+   rec.Other.size = sizeof(announce) + block.insns.size();
+   output->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
+   output->write(reinterpret_cast<char*>(&announce), sizeof(announce));
+   output->write(reinterpret_cast<char*>(&block.insns[0]), block.insns.size());
+
+   return id;
+}
+
+void Sift::Writer::flushBasicBlocks()
+{
+   if (!m_basic_blocks)
+      return;
+
+   if (!m_bb_current.insns.empty())
+      endBasicBlock(false);
+
+   if (m_bb_run.empty())
+      return;
+
+   Record rec;
+   rec.Other.zero = 0;
+   rec.Other.type = RecOtherBasicBlocks;
+   rec.Other.size = m_bb_run.size();
+   output->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
+   output->write(reinterpret_cast<char*>(&m_bb_run[0]), m_bb_run.size());
+   m_bb_run.clear();
 }
 
 Sift::Mode Sift::Writer::InstructionCount(uint32_t icount)
@@ -329,6 +496,8 @@ Sift::Mode Sift::Writer::InstructionCount(uint32_t icount)
       return Sift::ModeUnknown;
    }
 
+   flushBasicBlocks();
+
    Record rec;
    rec.Other.zero = 0;
    rec.Other.type = RecOtherInstructionCount;
@@ -378,6 +547,8 @@ void Sift::Writer::CacheOnly(uint8_t icount, CacheOnlyType type, uint64_t eip, u
       return;
    }
 
+   flushBasicBlocks();
+
    send_va2pa(eip);
    send_va2pa(address);
 
@@ -414,6 +585,8 @@ void Sift::Writer::Output(uint8_t fd, const char *data, uint32_t size)
       return;
    }
 
+   flushBasicBlocks();
+
    Record rec;
    rec.Other.zero = 0;
    rec.Other.type = RecOtherOutput;
@@ -441,6 +614,8 @@ int32_t Sift::Writer::NewThread()
       return -1;
    }
 
+   flushBasicBlocks();
+
    Record rec;
    rec.Other.zero = 0;
    rec.Other.type = RecOtherNewThread;
@@ -496,17 +671,15 @@ static T force_read(volatile T *addr)
     return *addr;
 }
 
-uint64_t Sift::Writer::Syscall(uint16_t syscall_number, const char *data, uint32_t size)
+bool Sift::Writer::sendSyscall(RecOtherType type, uint16_t syscall_number, const char *data, uint32_t size)
 {
-   #if VERBOSE > 0
-   std::cerr << "[DEBUG:" << m_id << "] Write Syscall" << std::endl;
-   #endif
-
    if (!output)
    {
-      return 1;
+      return false;
    }
 
+   flushBasicBlocks();
+
    // Try to send some extra logical2physical address mappings for data referenced by system call arguments.
    // Also try to read from the address first, if the mapping wasn't set up yet (never accessed before, or swapped out),
    // then this will cause a page fault that brings in the data.
@@ -528,19 +701,34 @@ uint64_t Sift::Writer::Syscall(uint16_t syscall_number, const char *data, uint32
       }
    }
 
-   Record rec;
-   rec.Other.zero = 0;
-   rec.Other.type = RecOtherSyscallRequest;
-   rec.Other.size = sizeof(uint16_t) + size;
+   m_record.begin(type).add(&syscall_number, sizeof(uint16_t)).add(data, size);
    #if VERBOSE_HEX > 0
-   hexdump((char*)&rec, sizeof(rec.Other));
    hexdump((char*)&syscall_number, sizeof(syscall_number));
    hexdump((char*)data, size);
    #endif
-   output->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
-   output->write(reinterpret_cast<char*>(&syscall_number), sizeof(uint16_t));
-   output->write(data, size);
-   output->flush();
+   m_record.write(output);
+   return true;
+}
+
+void Sift::Writer::SyscallAsync(uint16_t syscall_number, const char *data, uint32_t size)
+{
+   #if VERBOSE > 0
+   std::cerr << "[DEBUG:" << m_id << "] Write SyscallAsync" << std::endl;
+   #endif
+
+   sendSyscall(RecOtherSyscallAsync, syscall_number, data, size);
+}
+
+uint64_t Sift::Writer::Syscall(uint16_t syscall_number, const char *data, uint32_t size)
+{
+   #if VERBOSE > 0
+   std::cerr << "[DEBUG:" << m_id << "] Write Syscall" << std::endl;
+   #endif
+
+   if (!sendSyscall(RecOtherSyscallRequest, syscall_number, data, size))
+   {
+      return 1;
+   }
 
    initResponse();
 
@@ -548,7 +736,7 @@ uint64_t Sift::Writer::Syscall(uint16_t syscall_number, const char *data, uint32
    while (true)
    {
       Record respRec;
-      response->read(reinterpret_cast<char*>(&respRec), sizeof(rec.Other));
+      response->read(reinterpret_cast<char*>(&respRec), sizeof(respRec.Other));
       if (response->fail())
       {
          return 1;
@@ -594,13 +782,9 @@ int32_t Sift::Writer::Join(int32_t thread)
       return -1;
    }
 
-   Record rec;
-   rec.Other.zero = 0;
-   rec.Other.type = RecOtherJoin;
-   rec.Other.size = sizeof(thread);
-   output->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
-   output->write(reinterpret_cast<char*>(&thread), sizeof(thread));
-   output->flush();
+   flushBasicBlocks();
+
+   m_record.begin(RecOtherJoin).add(&thread, sizeof(thread)).write(output);
    #if VERBOSE > 0
    std::cerr << "[DEBUG:" << m_id << "] Write Join Done" << std::endl;
    #endif
@@ -614,7 +798,7 @@ int32_t Sift::Writer::Join(int32_t thread)
       std::cerr << "[DEBUG:" << m_id << "] Join Waiting for Response" << std::endl;
       #endif
       Record respRec;
-      response->read(reinterpret_cast<char*>(&respRec), sizeof(rec.Other));
+      response->read(reinterpret_cast<char*>(&respRec), sizeof(respRec.Other));
       if (respRec.Other.zero != 0)
       {
          return -1;
@@ -651,6 +835,8 @@ Sift::Mode Sift::Writer::Sync()
       return Sift::ModeUnknown;
    }
 
+   flushBasicBlocks();
+
    // send sync
    Record rec;
    rec.Other.zero = 0;
@@ -710,6 +896,8 @@ int32_t Sift::Writer::Fork()
       return -1;
    }
 
+   flushBasicBlocks();
+
    Record rec;
    rec.Other.zero = 0;
    rec.Other.type = RecOtherFork;
@@ -757,16 +945,10 @@ uint64_t Sift::Writer::Magic(uint64_t a, uint64_t b, uint64_t c)
       return 1;
    }
 
+   flushBasicBlocks();
+
    // send magic
-   Record rec;
-   rec.Other.zero = 0;
-   rec.Other.type = RecOtherMagicInstruction;
-   rec.Other.size = 3 * sizeof(uint64_t);
-   output->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
-   output->write(reinterpret_cast<char*>(&a), sizeof(uint64_t));
-   output->write(reinterpret_cast<char*>(&b), sizeof(uint64_t));
-   output->write(reinterpret_cast<char*>(&c), sizeof(uint64_t));
-   output->flush();
+   m_record.begin(RecOtherMagicInstruction).add(&a, sizeof(uint64_t)).add(&b, sizeof(uint64_t)).add(&c, sizeof(uint64_t)).write(output);
 
    initResponse();
 
@@ -774,7 +956,7 @@ uint64_t Sift::Writer::Magic(uint64_t a, uint64_t b, uint64_t c)
    while (true)
    {
       Record respRec;
-      response->read(reinterpret_cast<char*>(&respRec), sizeof(rec.Other));
+      response->read(reinterpret_cast<char*>(&respRec), sizeof(respRec.Other));
       sift_assert(!response->fail());
       sift_assert(respRec.Other.zero == 0);
 
@@ -810,16 +992,11 @@ bool Sift::Writer::Emulate(Sift::EmuType type, Sift::EmuRequest &req, Sift::EmuR
       return false;
    }
 
+   flushBasicBlocks();
+
    // send magic
-   Record rec;
-   rec.Other.zero = 0;
-   rec.Other.type = RecOtherEmu;
-   rec.Other.size = sizeof(uint16_t) + sizeof(EmuRequest);
-   output->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
    uint16_t _type = type;
-   output->write(reinterpret_cast<char*>(&_type), sizeof(uint16_t));
-   output->write(reinterpret_cast<char*>(&req), sizeof(EmuRequest));
-   output->flush();
+   m_record.begin(RecOtherEmu).add(&_type, sizeof(uint16_t)).add(&req, sizeof(EmuRequest)).write(output);
 
    initResponse();
 
@@ -827,7 +1004,7 @@ bool Sift::Writer::Emulate(Sift::EmuType type, Sift::EmuRequest &req, Sift::EmuR
    while (true)
    {
       Record respRec;
-      response->read(reinterpret_cast<char*>(&respRec), sizeof(rec.Other));
+      response->read(reinterpret_cast<char*>(&respRec), sizeof(respRec.Other));
       sift_assert(!response->fail());
       sift_assert(respRec.Other.zero == 0);
 
@@ -865,6 +1042,8 @@ void Sift::Writer::RoutineChange(Sift::RoutineOpType event, uint64_t eip, uint64
       return;
    }
 
+   flushBasicBlocks();
+
    Record rec;
    rec.Other.zero = 0;
    rec.Other.type = RecOtherRoutineChange;
@@ -884,6 +1063,8 @@ void Sift::Writer::RoutineAnnounce(uint64_t eip, const char *name, const char *i
       return;
    }
 
+   flushBasicBlocks();
+
    uint16_t len_name = strlen(name) + 1, len_imgname = strlen(imgname) + 1, len_filename = strlen(filename) + 1;
 
    Record rec;
@@ -914,6 +1095,8 @@ void Sift::Writer::ISAChange(uint32_t new_isa)
       return;
    }
 
+   flushBasicBlocks();
+
    Record rec;
    rec.Other.zero = 0;
    rec.Other.type = RecOtherISAChange;
@@ -975,12 +1158,7 @@ void Sift::Writer::handleMemoryRequest(Record &respRec)
       bzero(read_data, size);
       // Do the read here via a callback to populate the read buffer
       handleAccessMemoryFunc(handleAccessMemoryArg, lock, type, addr, (uint8_t*)read_data, size);
-      Record rec;
-      rec.Other.zero = 0;
-      rec.Other.type = RecOtherMemoryResponse;
-      rec.Other.size = sizeof(addr) + sizeof(type) + size;
       #if VEBOSE_HEX > 0
-      hexdump((char*)&rec, sizeof(rec.Other));
       hexdump((char*)&addr, sizeof(addr));
       hexdump((char*)&type, sizeof(type));
       hexdump((char*)read_data, size);
@@ -989,11 +1167,7 @@ void Sift::Writer::handleMemoryRequest(Record &respRec)
       std::cerr << "[DEBUG:" << m_id << "] Write AccessMemory-Read" << std::endl;
       #endif
 
-      output->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
-      output->write(reinterpret_cast<char*>(&addr), sizeof(addr));
-      output->write(reinterpret_cast<char*>(&type), sizeof(type));
-      output->write(read_data, size);
-      output->flush();
+      m_record.begin(RecOtherMemoryResponse).add(&addr, sizeof(addr)).add(&type, sizeof(type)).add(read_data, size).write(output);
       delete [] read_data;
    }
    else if (type == MemWrite)
@@ -1013,19 +1187,11 @@ void Sift::Writer::handleMemoryRequest(Record &respRec)
       response->read(reinterpret_cast<char*>(payload), payload_size);
       // Do the write here via a callback to write the data to the appropriate address
       handleAccessMemoryFunc(handleAccessMemoryArg, lock, type, addr, (uint8_t*)payload, payload_size);
-      Record rec;
-      rec.Other.zero = 0;
-      rec.Other.type = RecOtherMemoryResponse;
-      rec.Other.size = sizeof(addr) + sizeof(type);
       #if VEBOSE_HEX > 0
-      hexdump((char*)&rec, sizeof(rec.Other));
       hexdump((char*)&addr, sizeof(addr));
       hexdump((char*)&type, sizeof(type));
       #endif
-      output->write(reinterpret_cast<char*>(&rec), sizeof(rec.Other));
-      output->write(reinterpret_cast<char*>(&addr), sizeof(addr));
-      output->write(reinterpret_cast<char*>(&type), sizeof(type));
-      output->flush();
+      m_record.begin(RecOtherMemoryResponse).add(&addr, sizeof(addr)).add(&type, sizeof(type)).write(output);
       delete [] payload;
    }
    else
@@ -3,16 +3,33 @@
 
 #include "sift.h"
 #include "sift_format.h"
+#include "sift_utils.h"
 
 #include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <assert.h>
 
 class vistream;
 class vostream;
+class obzstream;
+class asyncostream;
+class AsyncWriter;
 
 namespace Sift
 {
+   // One instruction of a batch passed to Writer::InstructionBlock
+   struct InstructionInfo
+   {
+      uint64_t addr;
+      uint8_t size;
+      uint8_t num_addresses;
+      bool is_branch;
+      bool taken;
+      bool is_predicate;
+      bool executed;
+   };
+
    class Writer
    {
       typedef void (*GetCodeFunc)(uint8_t *dst, const uint8_t *src, uint32_t size);
@@ -21,6 +38,8 @@ namespace Sift
 
       private:
          vostream *output;
+         obzstream *m_block_output;
+         asyncostream *m_async_output;
          vistream *response;
          GetCodeFunc getCodeFunc;
          GetCodeFunc2 getCodeFunc2;
@@ -37,23 +56,46 @@ namespace Sift
          uint32_t m_id;
          bool m_requires_icache_per_insn;
          bool m_send_va2pa_mapping;
+         RecordBuffer m_record;
+
+         // Basic-block encoding (BasicBlocks option)
+         struct BasicBlock
+         {
+            uint64_t addr;
+            std::vector<uint8_t> insns;         // BasicBlockInsn descriptors
+            std::vector<uint64_t> addresses;    // Previous address of each memory operand
+         };
+         bool m_basic_blocks;
+         std::vector<BasicBlock> m_bb_table;
+         std::unordered_multimap<uint64_t, uint32_t> m_bb_ids;
+         BasicBlock m_bb_current;               // Block being built, with the addresses of this execution
+         std::vector<uint8_t> m_bb_run;         // Encoded executions not yet written out
 
          void initResponse();
+         bool sendSyscall(RecOtherType type, uint16_t syscall_number, const char *data, uint32_t size);
          void handleMemoryRequest(Record &respRec);
          void send_va2pa(uint64_t va);
          uint64_t va2pa_lookup(uint64_t va);
+         void addBasicBlockInstruction(uint64_t addr, uint8_t size, uint8_t num_addresses, uint64_t addresses[], bool is_branch, bool taken);
+         void endBasicBlock(bool taken);
+         uint32_t getBasicBlockId();
+         void flushBasicBlocks();
 
 	 void frontEndStop();
 
       public:
-         Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression = false, const char *response_filename = "", uint32_t id = 0, bool arch32 = false, bool requires_icache_per_insn = false, bool send_va2pa_mapping = false, GetCodeFunc2 getCodeFunc2 = NULL, void *GetCodeFunc2Data = NULL);
+         Writer(const char *filename, GetCodeFunc getCodeFunc, bool useCompression = false, const char *response_filename = "", uint32_t id = 0, bool arch32 = false, bool requires_icache_per_insn = false, bool send_va2pa_mapping = false, GetCodeFunc2 getCodeFunc2 = NULL, void *GetCodeFunc2Data = NULL, BlockCodec block_codec = BlockCodecNone, uint32_t block_size = BlockSizeDefault, AsyncWriter *async_writer = NULL, bool basic_blocks = false);
          ~Writer();
          void End();
          void Instruction(uint64_t addr, uint8_t size, uint8_t num_addresses, uint64_t addresses[], bool is_branch, bool taken, bool is_predicate, bool executed);
+         // A run of instructions buffered by the frontend, addresses holds the memory addresses of all of them in order
+         void InstructionBlock(uint32_t count, const InstructionInfo insns[], uint64_t addresses[]);
          Mode InstructionCount(uint32_t icount);
          void CacheOnly(uint8_t icount, CacheOnlyType type, uint64_t eip, uint64_t address);
          void Output(uint8_t fd, const char *data, uint32_t size);
          uint64_t Syscall(uint16_t syscall_number, const char *data, uint32_t size);
+         // Syscall that is passed through to the OS and whose return value is not needed: does not wait for the simulator
+         void SyscallAsync(uint16_t syscall_number, const char *data, uint32_t size);
          int32_t NewThread();
          int32_t Join(int32_t);
          Mode Sync();
@@ -8,6 +8,7 @@
 #include <cstring>
 #include <map>
 #include <unordered_map>
+#include <vector>
 
 #if PIN_REV >= 67254
 extern "C" {
@@ -65,6 +66,18 @@ int main(int argc, char* argv[])
          eip_last = it->first + it->second->size;
       }
    }
+   else if (argc > 1 && strcmp(argv[1], "-i") == 0)
+   {
+      Sift::Reader reader(argv[2]);
+
+      std::vector<Sift::BlockIndexEntry> index;
+      if (!reader.getBlockIndex(index))
+         return 1;
+
+      printf("%8s %16s %16s\n", "block", "icount", "offset");
+      for(size_t i = 0; i < index.size(); ++i)
+         printf("%8zu %16" PRIu64 " %16" PRIu64 "\n", i, index[i].icount, index[i].offset);
+   }
    else if (argc > 1)
    {
       Sift::Reader reader(argv[1]);
@@ -100,6 +113,6 @@ int main(int argc, char* argv[])
    }
    else
    {
-      printf("Usage: %s [-d] <file.sift>\n", argv[0]);
+      printf("Usage: %s [-d|-i] <file.sift>\n", argv[0]);
    }
 }
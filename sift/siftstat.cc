@@ -0,0 +1,314 @@
+#define __STDC_FORMAT_MACROS
+
+#include "sift_reader.h"
+
+#include <inttypes.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Trace characterization: instruction mix, memory footprint, basic-block hotness and branch statistics, as JSON.
+// Block-compressed traces are split on their block index into one range of blocks per worker thread, each with its
+// own Sift::Reader; other traces are read by a single thread. Basic blocks end at branches, a block spanning two
+// ranges is counted as two.
+
+static const uint64_t LINE_SIZE = 64;
+static const uint64_t PAGE_SIZE = 4096;
+
+struct BlockStats
+{
+   uint64_t executions;
+   uint64_t instructions;
+};
+
+struct BranchStats
+{
+   uint64_t executions;
+   uint64_t taken;
+   uint64_t flips;         //< Outcome differs from the previous execution
+   bool last_taken;
+};
+
+struct Stats
+{
+   uint64_t instructions;
+   uint64_t branches;
+   uint64_t taken;
+   uint64_t predicated;
+   uint64_t not_executed;
+   uint64_t memory_instructions;
+   uint64_t memory_operands;
+   uint64_t by_addresses[Sift::MAX_DYNAMIC_ADDRESSES + 1];
+   uint64_t by_size[17];
+
+   std::unordered_set<uint64_t> code_lines;
+   std::unordered_set<uint64_t> data_lines;
+   std::unordered_set<uint64_t> data_pages;
+   std::unordered_map<uint64_t, BlockStats> blocks;
+   std::unordered_map<uint64_t, BranchStats> static_branches;
+
+   Stats()
+      : instructions(0), branches(0), taken(0), predicated(0), not_executed(0), memory_instructions(0), memory_operands(0)
+   {
+      memset(by_addresses, 0, sizeof(by_addresses));
+      memset(by_size, 0, sizeof(by_size));
+   }
+
+   void merge(const Stats &other)
+   {
+      instructions += other.instructions;
+      branches += other.branches;
+      taken += other.taken;
+      predicated += other.predicated;
+      not_executed += other.not_executed;
+      memory_instructions += other.memory_instructions;
+      memory_operands += other.memory_operands;
+      for(size_t i = 0; i < sizeof(by_addresses) / sizeof(by_addresses[0]); ++i)
+         by_addresses[i] += other.by_addresses[i];
+      for(size_t i = 0; i < sizeof(by_size) / sizeof(by_size[0]); ++i)
+         by_size[i] += other.by_size[i];
+
+      code_lines.insert(other.code_lines.begin(), other.code_lines.end());
+      data_lines.insert(other.data_lines.begin(), other.data_lines.end());
+      data_pages.insert(other.data_pages.begin(), other.data_pages.end());
+      for(auto it = other.blocks.begin(); it != other.blocks.end(); ++it)
+      {
+         BlockStats &block = blocks[it->first];
+         block.executions += it->second.executions;
+         block.instructions += it->second.instructions;
+      }
+      // Flips across range boundaries are not seen, like the block split
+      for(auto it = other.static_branches.begin(); it != other.static_branches.end(); ++it)
+      {
+         BranchStats &branch = static_branches[it->first];
+         branch.executions += it->second.executions;
+         branch.taken += it->second.taken;
+         branch.flips += it->second.flips;
+      }
+   }
+};
+
+// Read <count> instructions starting at block <first_block>, or up to the end of the trace when count is zero
+static bool analyze(const char *filename, size_t first_block, uint64_t count, Stats *stats)
+{
+   Sift::Reader reader(filename);
+
+   if (first_block)
+   {
+      std::vector<Sift::BlockIndexEntry> index;
+      uint64_t actual = 0;
+      if (!reader.getBlockIndex(index) || !reader.Seek(index[first_block].icount, &actual) || actual != index[first_block].icount)
+         return false;
+   }
+
+   uint64_t block_start = 0, block_instructions = 0;
+   Sift::Instruction inst;
+   while((count == 0 || stats->instructions < count) && reader.Read(inst))
+   {
+      const uint64_t addr = inst.sinst->addr;
+      if (block_instructions == 0)
+         block_start = addr;
+      ++block_instructions;
+
+      ++stats->instructions;
+      ++stats->by_size[std::min<size_t>(inst.sinst->size, 16)];
+      stats->code_lines.insert(addr / LINE_SIZE);
+      if (addr / LINE_SIZE != (addr + inst.sinst->size - 1) / LINE_SIZE)
+         stats->code_lines.insert((addr + inst.sinst->size - 1) / LINE_SIZE);
+
+      if (inst.is_predicate)
+      {
+         ++stats->predicated;
+         if (!inst.executed)
+            ++stats->not_executed;
+      }
+
+      ++stats->by_addresses[inst.num_addresses];
+      if (inst.num_addresses && inst.executed)
+      {
+         ++stats->memory_instructions;
+         stats->memory_operands += inst.num_addresses;
+         for(int i = 0; i < inst.num_addresses; ++i)
+         {
+            stats->data_lines.insert(inst.addresses[i] / LINE_SIZE);
+            stats->data_pages.insert(inst.addresses[i] / PAGE_SIZE);
+         }
+      }
+
+      if (inst.is_branch)
+      {
+         ++stats->branches;
+         if (inst.taken)
+            ++stats->taken;
+
+         BranchStats &branch = stats->static_branches[addr];
+         if (branch.executions && branch.last_taken != inst.taken)
+            ++branch.flips;
+         ++branch.executions;
+         if (inst.taken)
+            ++branch.taken;
+         branch.last_taken = inst.taken;
+
+         BlockStats &block = stats->blocks[block_start];
+         ++block.executions;
+         block.instructions += block_instructions;
+         block_instructions = 0;
+      }
+   }
+
+   if (block_instructions)
+   {
+      BlockStats &block = stats->blocks[block_start];
+      ++block.executions;
+      block.instructions += block_instructions;
+   }
+   return true;
+}
+
+template <typename T, typename F> static std::vector<std::pair<uint64_t, T> > topN(const std::unordered_map<uint64_t, T> &map, size_t n, F key)
+{
+   std::vector<std::pair<uint64_t, T> > items(map.begin(), map.end());
+   n = std::min(n, items.size());
+   std::partial_sort(items.begin(), items.begin() + n, items.end(),
+      [&](const std::pair<uint64_t, T> &a, const std::pair<uint64_t, T> &b) { return key(a.second) > key(b.second); });
+   items.resize(n);
+   return items;
+}
+
+static void printJson(const char *filename, const Stats &stats, size_t num_blocks, unsigned int num_threads, size_t top)
+{
+   printf("{\n");
+   printf("  \"trace\": \"%s\",\n", filename);
+   printf("  \"blocks\": %zu,\n", num_blocks);
+   printf("  \"threads\": %u,\n", num_threads);
+
+   printf("  \"mix\": {\n");
+   printf("    \"instructions\": %" PRIu64 ",\n", stats.instructions);
+   printf("    \"branches\": %" PRIu64 ",\n", stats.branches);
+   printf("    \"taken_branches\": %" PRIu64 ",\n", stats.taken);
+   printf("    \"memory_instructions\": %" PRIu64 ",\n", stats.memory_instructions);
+   printf("    \"memory_operands\": %" PRIu64 ",\n", stats.memory_operands);
+   printf("    \"predicated\": %" PRIu64 ",\n", stats.predicated);
+   printf("    \"not_executed\": %" PRIu64 ",\n", stats.not_executed);
+   printf("    \"by_num_addresses\": [");
+   for(size_t i = 0; i < sizeof(stats.by_addresses) / sizeof(stats.by_addresses[0]); ++i)
+      printf("%s%" PRIu64, i ? ", " : "", stats.by_addresses[i]);
+   printf("],\n");
+   printf("    \"by_size\": [");
+   for(size_t i = 0; i < sizeof(stats.by_size) / sizeof(stats.by_size[0]); ++i)
+      printf("%s%" PRIu64, i ? ", " : "", stats.by_size[i]);
+   printf("]\n");
+   printf("  },\n");
+
+   printf("  \"footprint\": {\n");
+   printf("    \"code_bytes\": %" PRIu64 ",\n", stats.code_lines.size() * LINE_SIZE);
+   printf("    \"data_bytes\": %" PRIu64 ",\n", stats.data_lines.size() * LINE_SIZE);
+   printf("    \"data_pages\": %zu\n", stats.data_pages.size());
+   printf("  },\n");
+
+   printf("  \"basic_blocks\": {\n");
+   printf("    \"static\": %zu,\n", stats.blocks.size());
+   printf("    \"hottest\": [");
+   std::vector<std::pair<uint64_t, BlockStats> > blocks = topN(stats.blocks, top, [](const BlockStats &b) { return b.instructions; });
+   for(size_t i = 0; i < blocks.size(); ++i)
+      printf("%s\n      { \"address\": \"0x%" PRIx64 "\", \"executions\": %" PRIu64 ", \"instructions\": %" PRIu64 ", \"fraction\": %.6f }",
+         i ? "," : "", blocks[i].first, blocks[i].second.executions, blocks[i].second.instructions,
+         stats.instructions ? double(blocks[i].second.instructions) / stats.instructions : 0.);
+   printf("%s]\n", blocks.size() ? "\n    " : "");
+   printf("  },\n");
+
+   // Branches that go both ways often, and flip often, are the ones predictors struggle with
+   uint64_t biased = 0;
+   for(auto it = stats.static_branches.begin(); it != stats.static_branches.end(); ++it)
+      if (it->second.taken * 100 < it->second.executions * 5 || it->second.taken * 100 > it->second.executions * 95)
+         ++biased;
+
+   printf("  \"branches\": {\n");
+   printf("    \"static\": %zu,\n", stats.static_branches.size());
+   printf("    \"static_biased\": %" PRIu64 ",\n", biased);
+   printf("    \"taken_fraction\": %.6f,\n", stats.branches ? double(stats.taken) / stats.branches : 0.);
+   printf("    \"most_flipping\": [");
+   std::vector<std::pair<uint64_t, BranchStats> > branches = topN(stats.static_branches, top, [](const BranchStats &b) { return b.flips; });
+   for(size_t i = 0; i < branches.size(); ++i)
+      printf("%s\n      { \"address\": \"0x%" PRIx64 "\", \"executions\": %" PRIu64 ", \"taken\": %" PRIu64 ", \"flips\": %" PRIu64 " }",
+         i ? "," : "", branches[i].first, branches[i].second.executions, branches[i].second.taken, branches[i].second.flips);
+   printf("%s]\n", branches.size() ? "\n    " : "");
+   printf("  }\n");
+   printf("}\n");
+}
+
+int main(int argc, char* argv[])
+{
+   unsigned int num_threads = std::max(1u, std::thread::hardware_concurrency());
+   size_t top = 20;
+   int arg = 1;
+   for( ; arg < argc && argv[arg][0] == '-'; ++arg)
+   {
+      if (strcmp(argv[arg], "-t") == 0 && arg + 1 < argc)
+         num_threads = std::max(1, atoi(argv[++arg]));
+      else if (strcmp(argv[arg], "-n") == 0 && arg + 1 < argc)
+         top = atoi(argv[++arg]);
+      else
+         break;
+   }
+   if (arg + 1 != argc)
+   {
+      fprintf(stderr, "Usage: %s [-t <threads>] [-n <top>] <file.sift>\n", argv[0]);
+      return 1;
+   }
+   const char *filename = argv[arg];
+
+   // Without a block index (not block-compressed, or incomplete), read the whole trace on one thread
+   std::vector<Sift::BlockIndexEntry> index;
+   {
+      Sift::Reader reader(filename);
+      if (!reader.getBlockIndex(index))
+         index.clear();
+   }
+   if (index.size() < 2)
+      num_threads = 1;
+   num_threads = std::min<size_t>(num_threads, std::max<size_t>(index.size(), 1));
+
+   // Split on blocks, with about the same number of instructions per thread (the last block's size is not known)
+   std::vector<size_t> first(num_threads + 1, index.size());
+   first[0] = 0;
+   for(unsigned int t = 1; t < num_threads; ++t)
+   {
+      uint64_t target = index.back().icount / num_threads * t;
+      first[t] = std::upper_bound(index.begin(), index.end(), target,
+         [](uint64_t value, const Sift::BlockIndexEntry &entry) { return value < entry.icount; }) - index.begin();
+      first[t] = std::max(first[t], first[t - 1] + 1);
+   }
+
+   std::vector<Stats> stats(num_threads);
+   std::vector<char> ok(num_threads, false);
+   std::vector<std::thread> threads;
+   for(unsigned int t = 0; t < num_threads; ++t)
+   {
+      // The last range runs to the end of the trace
+      uint64_t count = first[t + 1] < index.size() ? index[first[t + 1]].icount - index[first[t]].icount : 0;
+      threads.emplace_back([&, t, count]() { ok[t] = analyze(filename, first[t], count, &stats[t]); });
+   }
+   for(unsigned int t = 0; t < num_threads; ++t)
+   {
+      threads[t].join();
+      if (!ok[t])
+      {
+         fprintf(stderr, "Cannot seek to block %zu of %s\n", first[t], filename);
+         return 1;
+      }
+      if (t)
+      {
+         stats[0].merge(stats[t]);
+         stats[t] = Stats();
+      }
+   }
+
+   printJson(filename, stats[0], index.size(), num_threads, top);
+   return 0;
+}
@@ -0,0 +1,280 @@
+#include "zbstream.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#if SIFT_USE_ZLIB
+# include <zlib.h>
+#endif
+#if SIFT_USE_ZSTD
+# include <zstd.h>
+#endif
+#if SIFT_USE_LZ4
+# include <lz4.h>
+#endif
+
+obzstream::obzstream(vostream *output, Sift::BlockCodec codec, size_t block_size, uint64_t offset)
+   : output(output)
+   , m_codec(codec)
+   , m_block_size(block_size)
+   , m_offset(offset)
+   , m_block_icount(0)
+{
+   assert(isSupported(codec));
+   // Blocks only end on an instruction boundary, leave some room for the records that follow
+   m_buffer.reserve(block_size + 64*1024);
+}
+
+obzstream::~obzstream()
+{
+   writeBlock();
+
+   Sift::BlockHeader hdr;
+   memset(&hdr, 0, sizeof(hdr));
+   hdr.magic = Sift::BlockIndexMagic;
+   hdr.size = m_index.size() * sizeof(Sift::BlockIndexEntry);
+   hdr.icount = m_block_icount;
+
+   Sift::BlockIndexTrailer trailer = { m_offset, (uint32_t)m_index.size(), Sift::BlockIndexMagic };
+
+   output->write(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+   if (m_index.size())
+      output->write(reinterpret_cast<char*>(&m_index[0]), hdr.size);
+   output->write(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+   output->flush();
+   delete output;
+}
+
+bool obzstream::isSupported(Sift::BlockCodec codec)
+{
+   switch(codec)
+   {
+      case Sift::BlockCodecNone:
+         return true;
+      case Sift::BlockCodecZlib:
+         return SIFT_USE_ZLIB;
+      case Sift::BlockCodecZstd:
+         return SIFT_USE_ZSTD;
+      case Sift::BlockCodecLz4:
+         return SIFT_USE_LZ4;
+   }
+   return false;
+}
+
+void obzstream::write(const char* s, std::streamsize n)
+{
+   m_buffer.insert(m_buffer.end(), s, s + n);
+}
+
+void obzstream::startBlock(uint64_t icount)
+{
+   writeBlock();
+   m_block_icount = icount;
+}
+
+void obzstream::writeBlock()
+{
+   if (m_buffer.empty())
+      return;
+
+   Sift::BlockHeader hdr;
+   memset(&hdr, 0, sizeof(hdr));
+   hdr.magic = Sift::BlockMagic;
+   hdr.codec = m_codec;
+   hdr.raw_size = m_buffer.size();
+   hdr.icount = m_block_icount;
+
+   size_t size = 0;
+   switch(m_codec)
+   {
+      case Sift::BlockCodecNone:
+         break;
+#if SIFT_USE_ZLIB
+      case Sift::BlockCodecZlib:
+      {
+         uLongf len = compressBound(m_buffer.size());
+         m_compressed.resize(len);
+         int ret = compress2((Bytef*)&m_compressed[0], &len, (const Bytef*)&m_buffer[0], m_buffer.size(), Z_DEFAULT_COMPRESSION);
+         assert(ret == Z_OK);
+         size = len;
+         break;
+      }
+#endif
+#if SIFT_USE_ZSTD
+      case Sift::BlockCodecZstd:
+      {
+         m_compressed.resize(ZSTD_compressBound(m_buffer.size()));
+         size_t len = ZSTD_compress(&m_compressed[0], m_compressed.size(), &m_buffer[0], m_buffer.size(), ZSTD_CLEVEL_DEFAULT);
+         assert(!ZSTD_isError(len));
+         size = len;
+         break;
+      }
+#endif
+#if SIFT_USE_LZ4
+      case Sift::BlockCodecLz4:
+      {
+         m_compressed.resize(LZ4_compressBound(m_buffer.size()));
+         int len = LZ4_compress_default(&m_buffer[0], &m_compressed[0], m_buffer.size(), m_compressed.size());
+         assert(len > 0);
+         size = len;
+         break;
+      }
+#endif
+      default:
+         assert(false);
+   }
+
+   // Store incompressible blocks as-is
+   const char *data;
+   if (m_codec == Sift::BlockCodecNone || size >= m_buffer.size())
+   {
+      hdr.codec = Sift::BlockCodecNone;
+      size = m_buffer.size();
+      data = &m_buffer[0];
+   }
+   else
+   {
+      data = &m_compressed[0];
+   }
+   hdr.size = size;
+
+   Sift::BlockIndexEntry entry = { m_block_icount, m_offset };
+   m_index.push_back(entry);
+
+   output->write(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+   output->write(data, size);
+   m_offset += sizeof(hdr) + size;
+
+   m_buffer.clear();
+}
+
+
+
+ibzstream::ibzstream(vistream *input)
+   : input(input)
+   , m_eof(false)
+   , m_fail(false)
+   , m_gcount(0)
+   , m_offset(0)
+{
+}
+
+ibzstream::~ibzstream()
+{
+   delete input;
+}
+
+void ibzstream::reset()
+{
+   m_buffer.clear();
+   m_offset = 0;
+   m_eof = false;
+   m_fail = false;
+}
+
+bool ibzstream::readBlock()
+{
+   m_buffer.clear();
+   m_offset = 0;
+
+   if (m_eof)
+      return false;
+
+   Sift::BlockHeader hdr;
+   input->read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+   if (input->fail() || hdr.magic == Sift::BlockIndexMagic)
+   {
+      // End of the block stream
+      m_eof = true;
+      return false;
+   }
+   if (hdr.magic != Sift::BlockMagic)
+   {
+      std::cerr << "[SIFT] Invalid block header\n";
+      m_eof = true;
+      return false;
+   }
+
+   m_buffer.resize(hdr.raw_size);
+
+   if (hdr.codec == Sift::BlockCodecNone)
+   {
+      assert(hdr.size == hdr.raw_size);
+      input->read(&m_buffer[0], hdr.size);
+      return !input->fail();
+   }
+
+   m_compressed.resize(hdr.size);
+   input->read(&m_compressed[0], hdr.size);
+   if (input->fail())
+      return false;
+
+   switch(hdr.codec)
+   {
+#if SIFT_USE_ZLIB
+      case Sift::BlockCodecZlib:
+      {
+         uLongf len = hdr.raw_size;
+         int ret = uncompress((Bytef*)&m_buffer[0], &len, (const Bytef*)&m_compressed[0], hdr.size);
+         return ret == Z_OK && len == hdr.raw_size;
+      }
+#endif
+#if SIFT_USE_ZSTD
+      case Sift::BlockCodecZstd:
+      {
+         size_t len = ZSTD_decompress(&m_buffer[0], hdr.raw_size, &m_compressed[0], hdr.size);
+         return !ZSTD_isError(len) && len == hdr.raw_size;
+      }
+#endif
+#if SIFT_USE_LZ4
+      case Sift::BlockCodecLz4:
+      {
+         int len = LZ4_decompress_safe(&m_compressed[0], &m_buffer[0], hdr.size, hdr.raw_size);
+         return len >= 0 && (uint32_t)len == hdr.raw_size;
+      }
+#endif
+      default:
+         std::cerr << "[SIFT] Error: Block codec " << int(hdr.codec) << " not supported by this build\n";
+         m_eof = true;
+         return false;
+   }
+}
+
+void ibzstream::read(char* s, std::streamsize n)
+{
+   m_gcount = 0;
+   while(n > 0)
+   {
+      if (m_offset == m_buffer.size())
+      {
+         if (!readBlock() || m_buffer.empty())
+         {
+            m_eof = true;
+            m_fail = true;
+            return;
+         }
+      }
+      std::streamsize len = std::min(n, std::streamsize(m_buffer.size() - m_offset));
+      memcpy(s, &m_buffer[m_offset], len);
+      m_offset += len;
+      m_gcount += len;
+      s += len;
+      n -= len;
+   }
+}
+
+int ibzstream::peek()
+{
+   if (m_offset == m_buffer.size())
+   {
+      if (!readBlock() || m_buffer.empty())
+      {
+         m_eof = true;
+         m_fail = true;
+         return 0;
+      }
+   }
+   return (unsigned char)m_buffer[m_offset];
+}
@@ -0,0 +1,66 @@
+#ifndef __ZBSTREAM_H
+#define __ZBSTREAM_H
+
+#include "zfstream.h"
+
+#include <vector>
+
+// Block-compressed streams (Sift::CompressionBlock), see sift_format.h for the on-disk layout
+
+class obzstream : public vostream
+{
+   private:
+      vostream *output;
+      const Sift::BlockCodec m_codec;
+      const size_t m_block_size;
+      uint64_t m_offset;
+      uint64_t m_block_icount;
+      std::vector<char> m_buffer;
+      std::vector<char> m_compressed;
+      std::vector<Sift::BlockIndexEntry> m_index;
+      void writeBlock();
+   public:
+      // offset: position in the file at which the first block will be written
+      obzstream(vostream *output, Sift::BlockCodec codec, size_t block_size, uint64_t offset);
+      virtual ~obzstream();
+      virtual void write(const char* s, std::streamsize n);
+      // Blocks are only cut at the explicit request of the writer, so flush() does not end the current block
+      virtual void flush()
+         { output->flush(); }
+      virtual bool fail()
+         { return output->fail(); }
+      virtual bool is_open()
+         { return output->is_open(); }
+
+      bool full() const { return m_buffer.size() >= m_block_size; }
+      // End the current block, the next one starts after <icount> instructions
+      void startBlock(uint64_t icount);
+
+      static bool isSupported(Sift::BlockCodec codec);
+};
+
+class ibzstream : public vistream
+{
+   private:
+      vistream *input;
+      bool m_eof;
+      bool m_fail;
+      std::streamsize m_gcount;
+      std::vector<char> m_buffer;
+      std::vector<char> m_compressed;
+      size_t m_offset;
+      bool readBlock();
+   public:
+      ibzstream(vistream *input);
+      virtual ~ibzstream();
+      virtual void read(char* s, std::streamsize n);
+      virtual int peek();
+      virtual bool eof() const { return m_eof; }
+      virtual bool fail() const { return m_fail; }
+      virtual std::streamsize gcount() const { return m_gcount; }
+
+      // Drop all buffered data, to be called after repositioning the underlying stream at a BlockHeader
+      void reset();
+};
+
+#endif // __ZBSTREAM_H
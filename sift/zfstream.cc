@@ -28,6 +28,7 @@ izstream::izstream(vistream *input)
    : input(input)
    , m_eof(false)
    , m_fail(false)
+   , m_gcount(0)
    , peek_valid(false)
 {
 }
@@ -97,6 +98,7 @@ izstream::izstream(vistream *input)
    : input(input)
    , m_eof(false)
    , m_fail(false)
+   , m_gcount(0)
    , peek_valid(false)
 {
    zstream.zalloc = Z_NULL;
@@ -116,18 +118,21 @@ izstream::~izstream()
 
 void izstream::read(char* s, std::streamsize n)
 {
+   m_gcount = 0;
    if (peek_valid)
    {
       s[0] = peek_value;
       peek_valid = false;
       ++s;
       --n;
+      ++m_gcount;
    }
    if (n == 0)
       return;
 
    zstream.next_out = (Bytef*)s;
    zstream.avail_out = n;
+   m_gcount += n;
 
    do
    {
@@ -142,6 +147,7 @@ void izstream::read(char* s, std::streamsize n)
          m_eof = true;
          if (zstream.avail_out)
          {
+            m_gcount -= zstream.avail_out;
             m_fail = true;
             return;
          }
@@ -181,6 +187,7 @@ cvifstream::cvifstream(const char * filename, std::ios_base::openmode mode)
 	this->stream = std::fopen(filename, mode_str.c_str());
 	assert(this->stream != NULL);
 	this->buffer_in_use = false;
+	this->m_gcount = 0;
 }
 
 cvifstream::~cvifstream()
@@ -192,17 +199,20 @@ void cvifstream::read(char* s, std::streamsize n)
 {
 	size_t nr_to_read = n;
 	char* start_buffer = s;
+	this->m_gcount = 0;
 	if(this->buffer_in_use)
     {
 		start_buffer[0] = this->peek_buffer;
 		nr_to_read--;
 		start_buffer++;
 		this->buffer_in_use = false;
+		this->m_gcount = 1;
 	}
 	if(nr_to_read > 0)
     {
 		ssize_t num_read = std::fread(start_buffer, sizeof(char), nr_to_read, this->stream);
 		assert(num_read == n || std::ferror(this->stream) == 0);
+		this->m_gcount += num_read;
 	}
 }
 
@@ -73,6 +73,8 @@ class vistream
       virtual void read(char* s, std::streamsize n) = 0;
       virtual int peek() = 0;
       virtual bool fail() const = 0;
+      // Number of bytes returned by the last read()
+      virtual std::streamsize gcount() const = 0;
 };
 
 class vifstream : public vistream
@@ -90,6 +92,7 @@ class vifstream : public vistream
       virtual int peek()
          { return stream->peek(); }
       virtual bool fail() const { return stream->fail(); }
+      virtual std::streamsize gcount() const { return stream->gcount(); }
 };
 
 class cvifstream : public vistream
@@ -98,14 +101,16 @@ class cvifstream : public vistream
 	   std::FILE *stream;
 	   char peek_buffer;
 	   bool buffer_in_use;
+	   std::streamsize m_gcount;
    public:
 	   cvifstream(const char * filename, std::ios_base::openmode mode = std::ios_base::in);
 	   cvifstream(std::FILE *stream)
-		   : stream(stream) {}
+		   : stream(stream), buffer_in_use(false), m_gcount(0) {}
 	   virtual ~cvifstream();
 	   virtual void read(char* s, std::streamsize n);
 	   virtual int peek();
 	   virtual bool fail() const;
+	   virtual std::streamsize gcount() const { return m_gcount; }
 };
 
 class izstream : public vistream
@@ -114,6 +119,7 @@ class izstream : public vistream
       vistream *input;
       bool m_eof;
       bool m_fail;
+      std::streamsize m_gcount;
 #if SIFT_USE_ZLIB
       z_stream zstream;
 #endif
@@ -128,6 +134,7 @@ class izstream : public vistream
       virtual int peek();
       virtual bool eof() const { return m_eof; }
       virtual bool fail() const { return m_fail; }
+      virtual std::streamsize gcount() const { return m_gcount; }
 };
 
 #endif // __ZFSTREAM_H
@@ -0,0 +1,189 @@
+#include "server.h"
+#include "hooks_py.h"
+#include "mmap_stream.h"
+
+#include <map>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+// Read one job, returns false if the client went away or sent something malformed
+static bool readJob(int fd, std::vector<String> &job)
+{
+   const size_t max_size = 1 << 20;
+   String current;
+   char buffer[4096];
+
+   while(true)
+   {
+      ssize_t len = read(fd, buffer, sizeof(buffer));
+      if (len < 0 && errno == EINTR)
+         continue;
+      if (len <= 0)
+         return false;
+
+      for(ssize_t i = 0; i < len; ++i)
+      {
+         if (buffer[i] != '\0')
+         {
+            current += buffer[i];
+            continue;
+         }
+         // The working directory may be empty (shutdown request), an empty argument ends the job
+         if (current.empty() && !job.empty())
+            return true;
+         job.push_back(current);
+         current.clear();
+         if (job.size() == 1 && job[0].empty())
+            return true;
+      }
+      if (current.size() > max_size || job.size() > max_size)
+         return false;
+   }
+}
+
+static void sendStatus(int fd, int code)
+{
+   char trailer[64];
+   int len = snprintf(trailer, sizeof(trailer), "%cexit %d\n", '\0', code);
+   if (write(fd, trailer, len) != len)
+      fprintf(stderr, "[SNIPER-SERVER] Cannot send job status to client\n");
+   close(fd);
+}
+
+static void runJob(int fd, const std::vector<String> &job, config::ConfigFile *cfg)
+{
+   // Simulation output goes to the client
+   dup2(fd, STDOUT_FILENO);
+   dup2(fd, STDERR_FILENO);
+   close(fd);
+
+   if (chdir(job[0].c_str()) != 0)
+   {
+      fprintf(stderr, "[SNIPER-SERVER] Cannot change to directory %s\n", job[0].c_str());
+      exit(-1);
+   }
+
+   std::vector<char*> argv;
+   argv.push_back((char*)"sniper");
+   for(size_t i = 1; i < job.size(); ++i)
+      argv.push_back((char*)job[i].c_str());
+
+   // The base configuration was loaded by the server, all configuration files given by the job are extra ones
+   string_vec args;
+   String config_path = "-";
+   parse_args(args, config_path, argv.size(), argv.data());
+   if (config_path != "-")
+      args.insert(args.begin(), "--config=" + config_path);
+   handle_args(args, *cfg);
+
+   exit(simulate(cfg));
+}
+
+int runServer(const String &socket_path, const string_vec &preload, UInt32 max_jobs, config::ConfigFile *cfg)
+{
+   HooksPy::preinit();
+   for(string_vec::const_iterator it = preload.begin(); it != preload.end(); ++it)
+   {
+      if (!mmapistream::preload(it->c_str()))
+         fprintf(stderr, "[SNIPER-SERVER] Cannot preload %s\n", it->c_str());
+   }
+
+   int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+   struct sockaddr_un addr;
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   if (listen_fd < 0 || socket_path.size() >= sizeof(addr.sun_path))
+   {
+      fprintf(stderr, "[SNIPER-SERVER] Cannot create socket %s\n", socket_path.c_str());
+      return -1;
+   }
+   strcpy(addr.sun_path, socket_path.c_str());
+   unlink(socket_path.c_str());
+   if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 64) != 0)
+   {
+      fprintf(stderr, "[SNIPER-SERVER] Cannot listen on %s: %s\n", socket_path.c_str(), strerror(errno));
+      return -1;
+   }
+
+   // Clients that disconnect early should not take the server down
+   signal(SIGPIPE, SIG_IGN);
+   printf("[SNIPER-SERVER] Listening on %s, running up to %u jobs at once\n", socket_path.c_str(), max_jobs);
+
+   std::map<pid_t, int> running;
+   bool stopping = false;
+   while(!stopping || !running.empty())
+   {
+      // Reap finished jobs, block when we can't take any new ones
+      int status;
+      pid_t pid;
+      bool full = stopping || running.size() >= max_jobs;
+      while(!running.empty() && (pid = waitpid(-1, &status, full ? 0 : WNOHANG)) > 0)
+      {
+         std::map<pid_t, int>::iterator it = running.find(pid);
+         if (it != running.end())
+         {
+            sendStatus(it->second, WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+            running.erase(it);
+         }
+         full = stopping ? !running.empty() : running.size() >= max_jobs;
+      }
+      if (stopping)
+         continue;
+
+      struct pollfd pfd = { listen_fd, POLLIN, 0 };
+      if (poll(&pfd, 1, running.empty() ? -1 : 100) <= 0)
+         continue;
+
+      int fd = accept(listen_fd, NULL, NULL);
+      if (fd < 0)
+         continue;
+      // Don't let a stuck client block the server
+      struct timeval timeout = { 10, 0 };
+      setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+      std::vector<String> job;
+      if (!readJob(fd, job))
+      {
+         close(fd);
+         continue;
+      }
+      if (job[0].empty())
+      {
+         printf("[SNIPER-SERVER] Shutting down\n");
+         close(fd);
+         stopping = true;
+         continue;
+      }
+
+      // Don't have the job repeat our own buffered output
+      fflush(stdout);
+      fflush(stderr);
+      pid = HooksPy::forkProcess();
+      if (pid == 0)
+      {
+         close(listen_fd);
+         for(std::map<pid_t, int>::iterator it = running.begin(); it != running.end(); ++it)
+            close(it->second);
+         runJob(fd, job, cfg);
+      }
+      else if (pid < 0)
+      {
+         sendStatus(fd, 255);
+      }
+      else
+      {
+         running[pid] = fd;
+      }
+   }
+
+   close(listen_fd);
+   unlink(socket_path.c_str());
+   return 0;
+}
@@ -0,0 +1,21 @@
+#ifndef __SERVER_H
+#define __SERVER_H
+
+#include "config_file.hpp"
+#include "handle_args.h"
+
+// Server mode: keep one process with the base configuration parsed, the Python interpreter started and
+// (optionally) trace files mapped resident, and fork off a fresh simulator for every job received on a
+// Unix socket. Each job starts from the same pristine state, so there is nothing to reset between jobs.
+//
+// A job is a sequence of NUL-terminated strings: the working directory, then command line arguments as
+// for the standalone simulator (-c <file>, --section/key=value), then an empty string. The simulation's
+// stdout and stderr are sent back on the connection, followed by a NUL byte and "exit <status>\n".
+// A job with an empty working directory shuts the server down after the running jobs have finished.
+
+int runServer(const String &socket_path, const string_vec &preload, UInt32 max_jobs, config::ConfigFile *cfg);
+
+// Run one simulation with the given configuration, implemented in standalone.cc
+int simulate(config::ConfigFile *cfg);
+
+#endif // __SERVER_H
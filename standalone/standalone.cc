@@ -6,6 +6,11 @@
 #include "logmem.h"
 #include "exceptions.h"
 #include "sim_api.h"
+#include "server.h"
+
+#include <algorithm>
+#include <string.h>
+#include <unistd.h>
 
 int main(int argc, char* argv[])
 {
@@ -21,19 +26,47 @@ int main(int argc, char* argv[])
    if (ld_orig)
       setenv("LD_LIBRARY_PATH", ld_orig, 1);
 
+   // Server mode options are ours, everything else is handled like a normal simulation's command line
+   String server_socket;
+   string_vec server_preload;
+   UInt32 server_jobs = sysconf(_SC_NPROCESSORS_ONLN);
+   std::vector<char*> sim_argv;
+   for(int i = 0; i < argc; ++i)
+   {
+      if (strncmp(argv[i], "--server=", 9) == 0)
+         server_socket = argv[i] + 9;
+      else if (strncmp(argv[i], "--server-preload=", 17) == 0)
+         server_preload.push_back(argv[i] + 17);
+      else if (strncmp(argv[i], "--server-jobs=", 14) == 0)
+         server_jobs = std::max(1, atoi(argv[i] + 14));
+      else
+         sim_argv.push_back(argv[i]);
+   }
+
    string_vec args;
 
    // Set the default config path if it isn't
    // overwritten on the command line.
    String config_path = "carbon_sim.cfg";
 
-   parse_args(args, config_path, argc, argv);
+   parse_args(args, config_path, sim_argv.size(), sim_argv.data());
 
    config::ConfigFile *cfg = new config::ConfigFile();
    cfg->load(config_path);
 
    handle_args(args, *cfg);
 
+   if (!server_socket.empty())
+      return runServer(server_socket, server_preload, server_jobs, cfg);
+
+   int ret = simulate(cfg);
+   delete cfg;
+
+   return ret;
+}
+
+int simulate(config::ConfigFile *cfg)
+{
    Simulator::setConfig(cfg, Config::STANDALONE);
 
    Simulator::allocate();
@@ -58,7 +91,6 @@ int main(int argc, char* argv[])
    }
 
    Simulator::release();
-   delete cfg;
 
    return 0;
 }
@@ -0,0 +1,17 @@
+#!/usr/bin/env python3
+
+# Compare runtime, energy and energy-delay product (EDP) of the big-small scheduler policies,
+# as produced by 'make run_policies' in this directory
+
+import sys, os
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'tools'))
+import mcpat
+
+resultsdirs = sys.argv[1:] or [ 'random', 'predicted' ]
+
+print('%-12s %12s %12s %14s' % ('policy', 'time (ms)', 'energy (mJ)', 'EDP (mJ*ms)'))
+for resultsdir in resultsdirs:
+  data = mcpat.main(None, resultsdir, os.path.join(resultsdir, 'power'), powertype = 'total', no_graph = True, print_stack = False, return_data = True)
+  energy = sum(sum(components.values()) for components in data['power_data'].values())
+  time = data['time_s']
+  print('%-12s %12.3f %12.3f %14.3f' % (os.path.basename(resultsdir.rstrip('/')), time * 1e3, energy * 1e3, energy * time * 1e6))
@@ -0,0 +1,234 @@
+// Micro-benchmark for the containers behind the history_list and windowed_mg1 queue models.
+//
+// Runs the same request stream through the original std::list / std::multimap implementations and
+// through FreeIntervalRing / CalendarQueue, checks that every request sees the same queue delay
+// (history_list) and the same window contents (windowed_mg1), and reports the time per request.
+// The queue model logic is mirrored from QueueModelHistoryList::computeUsingHistoryList and
+// QueueModelWindowedMG1::removeItems, with times as plain femtosecond counts.
+// The std::list reference includes the fix for requests that do not fit in the interval they are moved to.
+//
+// Usage: queue_model_bench [<requests (10M)> [<max out-of-order skew in ns (100)> [<utilization (0.5)>]]]
+
+#include "fixed_types.h"
+#include "free_interval_ring.h"
+#include "calendar_queue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <random>
+#include <vector>
+
+static const UInt64 NS = 1000000; // fs
+
+struct Request
+{
+   UInt64 time;
+   UInt64 processing_time;
+};
+
+static std::vector<Request> makeRequests(UInt64 count, UInt64 skew, double utilization)
+{
+   // Mostly increasing arrival times, each request is shifted back by up to skew to model fluffy time
+   std::mt19937_64 rng(42);
+   const UInt64 processing_time = 4 * NS;
+   std::exponential_distribution<double> gap(utilization / processing_time);
+   std::uniform_int_distribution<UInt64> jitter(0, skew);
+   std::vector<Request> requests(count);
+   UInt64 time = 10 * skew + 1000 * NS;
+   for(UInt64 i = 0; i < count; ++i)
+   {
+      time += gap(rng);
+      requests[i].time = time - jitter(rng);
+      requests[i].processing_time = processing_time / 2 + rng() % processing_time;
+   }
+   return requests;
+}
+
+template <typename F> static double timeIt(F func)
+{
+   auto start = std::chrono::steady_clock::now();
+   func();
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// history_list
+
+static const UInt64 MAX_TIME = 1ULL << 63;
+
+class HistoryListReference
+{
+   private:
+      std::list<std::pair<UInt64, UInt64> > m_list;
+      const UInt32 m_max_size;
+      const UInt64 m_min_processing_time;
+   public:
+      HistoryListReference(UInt32 max_size, UInt64 min_processing_time)
+         : m_max_size(max_size), m_min_processing_time(min_processing_time)
+      { m_list.push_back(std::make_pair(0, MAX_TIME)); }
+
+      UInt64 compute(UInt64 pkt_time, UInt64 processing_time)
+      {
+         UInt64 queue_delay = UINT64_MAX;
+         for (auto it = m_list.begin(); it != m_list.end(); it++)
+         {
+            std::pair<UInt64, UInt64> interval = *it;
+            if (pkt_time >= interval.first && pkt_time + processing_time <= interval.second)
+            {
+               queue_delay = 0;
+               it = m_list.erase(it);
+               if (pkt_time - interval.first >= m_min_processing_time)
+                  m_list.insert(it, std::make_pair(interval.first, pkt_time));
+               if (interval.second - (pkt_time + processing_time) >= m_min_processing_time)
+                  m_list.insert(it, std::make_pair(pkt_time + processing_time, interval.second));
+               break;
+            }
+            else if (pkt_time < interval.first)
+            {
+               queue_delay = interval.first - pkt_time;
+               it = m_list.erase(it);
+               if (interval.first + processing_time < interval.second && interval.second - (interval.first + processing_time) >= m_min_processing_time)
+                  m_list.insert(it, std::make_pair(interval.first + processing_time, interval.second));
+               break;
+            }
+         }
+         if (m_list.size() > m_max_size)
+            m_list.erase(m_list.begin());
+         return queue_delay;
+      }
+};
+
+class HistoryListRing
+{
+   private:
+      FreeIntervalRing<UInt64> m_list;
+      const UInt32 m_max_size;
+      const UInt64 m_min_processing_time;
+   public:
+      HistoryListRing(UInt32 max_size, UInt64 min_processing_time)
+         : m_list(max_size), m_max_size(max_size), m_min_processing_time(min_processing_time)
+      { m_list.push_back(std::make_pair(0, MAX_TIME)); }
+
+      UInt64 compute(UInt64 pkt_time, UInt64 processing_time)
+      {
+         UInt64 queue_delay = UINT64_MAX;
+         bool fits;
+         UInt32 index = m_list.find(pkt_time, pkt_time + processing_time, fits);
+         if (index < m_list.size())
+         {
+            std::pair<UInt64, UInt64> interval = m_list[index], remaining[2];
+            UInt32 num_remaining = 0;
+            if (fits)
+            {
+               queue_delay = 0;
+               if (pkt_time - interval.first >= m_min_processing_time)
+                  remaining[num_remaining++] = std::make_pair(interval.first, pkt_time);
+               if (interval.second - (pkt_time + processing_time) >= m_min_processing_time)
+                  remaining[num_remaining++] = std::make_pair(pkt_time + processing_time, interval.second);
+            }
+            else
+            {
+               queue_delay = interval.first - pkt_time;
+               if (interval.first + processing_time < interval.second && interval.second - (interval.first + processing_time) >= m_min_processing_time)
+                  remaining[num_remaining++] = std::make_pair(interval.first + processing_time, interval.second);
+            }
+            m_list.replace(index, remaining, num_remaining);
+         }
+         if (m_list.size() > m_max_size)
+            m_list.pop_front();
+         return queue_delay;
+      }
+};
+
+template <typename Q> static double runHistoryList(const std::vector<Request> &requests, std::vector<UInt64> &delays)
+{
+   Q queue(100, 2 * NS);
+   delays.resize(requests.size());
+   return timeIt([&]() {
+      for(size_t i = 0; i < requests.size(); ++i)
+         delays[i] = queue.compute(requests[i].time, requests[i].processing_time);
+   });
+}
+
+// windowed_mg1
+
+struct WindowSums
+{
+   UInt64 num_arrivals, service_time_sum, service_time_sum2;
+   WindowSums() : num_arrivals(0), service_time_sum(0), service_time_sum2(0) {}
+   void add(UInt64 service_time) { num_arrivals++; service_time_sum += service_time; service_time_sum2 += service_time * service_time; }
+   void remove(UInt64 service_time) { num_arrivals--; service_time_sum -= service_time; service_time_sum2 -= service_time * service_time; }
+   UInt64 hash() const { return num_arrivals * 1000003 ^ service_time_sum * 10007 ^ service_time_sum2; }
+};
+
+template <typename F> static double runWindow(const std::vector<Request> &requests, UInt64 window_size, std::vector<UInt64> &hashes, F step)
+{
+   hashes.resize(requests.size());
+   return timeIt([&]() {
+      UInt64 global_time = 0;
+      for(size_t i = 0; i < requests.size(); ++i)
+      {
+         // Barrier time trails the requests by about the out-of-order skew
+         global_time = std::max(global_time, requests[i].time - std::min(requests[i].time, window_size / 2));
+         UInt64 earliest = std::max(global_time - std::min(global_time, window_size), requests[i].time - std::min(requests[i].time, 10 * window_size));
+         hashes[i] = step(earliest, requests[i]);
+      }
+   });
+}
+
+static double runWindowReference(const std::vector<Request> &requests, UInt64 window_size, std::vector<UInt64> &hashes)
+{
+   std::multimap<UInt64, UInt64> window;
+   WindowSums sums;
+   return runWindow(requests, window_size, hashes, [&](UInt64 earliest, const Request &request) {
+      while(!window.empty() && window.begin()->first < earliest)
+      {
+         sums.remove(window.begin()->second);
+         window.erase(window.begin());
+      }
+      window.insert(std::make_pair(request.time, request.processing_time));
+      sums.add(request.processing_time);
+      return sums.hash();
+   });
+}
+
+static double runWindowCalendar(const std::vector<Request> &requests, UInt64 window_size, std::vector<UInt64> &hashes)
+{
+   const UInt32 buckets = 32;
+   CalendarQueue<UInt64> window(window_size / buckets, 2 * buckets);
+   WindowSums sums;
+   return runWindow(requests, window_size, hashes, [&](UInt64 earliest, const Request &request) {
+      window.popBefore(earliest, [&](UInt64 time, UInt64 service_time) { sums.remove(service_time); });
+      window.push(request.time, request.processing_time);
+      sums.add(request.processing_time);
+      return sums.hash();
+   });
+}
+
+int main(int argc, char **argv)
+{
+   UInt64 count = argc > 1 ? strtoull(argv[1], NULL, 0) : 10000000;
+   UInt64 skew = (argc > 2 ? strtoull(argv[2], NULL, 0) : 100) * NS;
+   double utilization = argc > 3 ? atof(argv[3]) : 0.5;
+   const UInt64 window_size = 1000 * NS; // queue_model/windowed_mg1/window_size default
+
+   std::vector<Request> requests = makeRequests(count, skew, utilization);
+   std::vector<UInt64> reference, result;
+   bool ok = true;
+
+   double t_list = runHistoryList<HistoryListReference>(requests, reference);
+   double t_ring = runHistoryList<HistoryListRing>(requests, result);
+   ok &= reference == result;
+   printf("history_list  std::list        %7.1f ns/request\n", 1e9 * t_list / count);
+   printf("history_list  FreeIntervalRing %7.1f ns/request  %s\n", 1e9 * t_ring / count, reference == result ? "identical" : "MISMATCH");
+
+   double t_map = runWindowReference(requests, window_size, reference);
+   double t_cal = runWindowCalendar(requests, window_size, result);
+   ok &= reference == result;
+   printf("windowed_mg1  std::multimap    %7.1f ns/request\n", 1e9 * t_map / count);
+   printf("windowed_mg1  CalendarQueue    %7.1f ns/request  %s\n", 1e9 * t_cal / count, reference == result ? "identical" : "MISMATCH");
+
+   return ok ? 0 : 1;
+}
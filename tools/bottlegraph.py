@@ -12,7 +12,7 @@ def translateThreadNameJikes(name):
 
 
 def bottlegraph(jobid = None, resultsdir = None, outputfile = './bottlegraph', partial = None, no_text = False, thread_names_translate = translateThreadNameJikes):
-  stats = sniper_stats.SniperStats(resultsdir = resultsdir, jobid = jobid)
+  stats = sniper_stats.SniperStats(resultsdir = resultsdir, jobid = jobid, cpistack = True)
   results = stats.get_results(partial = partial)['results']
 
   thread_names = dict([ (threadid, 'Thread-%d' % threadid) for threadid in range(len(results['thread.bottle_runtime_time'])) ])
@@ -1,10 +1,14 @@
-import collections, sniper_lib, sniper_config
+import collections, sniper_lib, sniper_config, sniper_stats
 
 class CpiData:
 
   def __init__(self, jobid = '', resultsdir = '', config = None, stats = None, data = None, partial = None):
     if data:
       data_raw = data
+    elif resultsdir and not jobid and not stats:
+      # Prefer the pre-aggregated sim.cpistack over reading back all statistics
+      stats = sniper_stats.SniperStats(resultsdir = resultsdir, cpistack = True)
+      data_raw = sniper_lib.get_results(config = config, stats = stats, partial = partial)
     else:
       data_raw = sniper_lib.get_results(jobid = jobid, resultsdir = resultsdir, config = config, stats = stats, partial = partial)
     self.stats = data_raw['results']
@@ -72,7 +72,7 @@ def build_itemlist(use_simple_sync = False, use_simple_mem = True):
 
   if use_simple_sync:
     items += [ [ 'sync', .01, ('SyncFutex', 'SyncPthreadMutex', 'SyncPthreadCond', 'SyncPthreadBarrier', 'SyncJoin',
-                                   'SyncPause', 'SyncSleep', 'SyncUnscheduled', 'SyncMemAccess', 'Recv' ) ] ]
+                                   'SyncPause', 'SyncSleep', 'SyncUnscheduled', 'SyncSpin', 'SyncMemAccess', 'Recv' ) ] ]
   else:
     items += [
     [ 'sync',     .01, [
@@ -85,6 +85,7 @@ def build_itemlist(use_simple_sync = False, use_simple_mem = True):
       [ 'sleep',    .01, 'SyncSleep' ],
       [ 'syscall',  .01, 'SyncSyscall' ],
       [ 'unscheduled', .01, 'SyncUnscheduled' ],
+      [ 'spin',     .01, 'SyncSpin' ],
       [ 'memaccess',.01, 'SyncMemAccess' ],
       [ 'recv',     .01, 'Recv' ],
     ] ],
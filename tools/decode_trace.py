@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+
+# Decode sim.trace, the binary event trace written by TraceLog (see common/misc/trace_log.h)
+
+import sys, os, getopt, re, struct
+
+LEVELS = [ 'none', 'info', 'debug', 'verbose' ]
+EVENT = struct.Struct('QII4Q')
+CONVERSION = re.compile(r'%([-+ #0]*[0-9]*(?:\.[0-9]+)?)(?:hh|h|ll|l|L|q|j|z|t)?([diouxXeEfFgGcp%])')
+
+
+class TraceFile:
+  def __init__(self, filename = 'sim.trace'):
+    self.data = open(filename, 'rb').read()
+    self.offset = 0
+    magic, version, self.time_end, num_modules = self.read('8sQQQ')
+    if magic != b'SNIPTRCE':
+      raise ValueError('%s is not a Sniper trace file' % filename)
+    self.modules = [ self.read_string() for i in range(num_modules) ]
+    (num_sites,) = self.read('Q')
+    self.sites = []
+    for i in range(num_sites):
+      module, level, line, num_args = self.read('IIII')
+      filename, format = self.read_string(), self.read_string()
+      self.sites.append((self.modules[module], LEVELS[level], os.path.basename(filename), line, num_args, format))
+    (num_buffers,) = self.read('Q')
+    self.events = []
+    for i in range(num_buffers):
+      thread_id, count = self.read('QQ')
+      for j in range(count):
+        time, site, _, a0, a1, a2, a3 = EVENT.unpack_from(self.data, self.offset)
+        self.offset += EVENT.size
+        self.events.append((time, thread_id, site, (a0, a1, a2, a3)))
+    self.events.sort()
+
+  def read(self, fmt):
+    values = struct.unpack_from(fmt, self.data, self.offset)
+    self.offset += struct.calcsize(fmt)
+    return values
+
+  def read_string(self):
+    end = self.data.index(b'\0', self.offset)
+    value = self.data[self.offset:end].decode()
+    self.offset = end + 1
+    return value
+
+  def format(self, site, args):
+    args = list(args)
+    def convert(match):
+      flags, conversion = match.groups()
+      if conversion == '%':
+        return '%'
+      value = args.pop(0)
+      if conversion in 'eEfFgG':
+        (value,) = struct.unpack('d', struct.pack('Q', value))
+      elif conversion in 'di':
+        value = value - (1 << 64) if value >= (1 << 63) else value
+      elif conversion == 'p':
+        return '0x%x' % value
+      elif conversion == 'c':
+        return chr(value & 0xff)
+      return ('%' + flags + conversion) % value
+    return CONVERSION.sub(convert, self.sites[site][5])
+
+
+if __name__ == '__main__':
+  def usage():
+    print('Usage:', sys.argv[0], '[-h (help)] [-m <module>] [-d <resultsdir (default: .)>]')
+
+  resultsdir = '.'
+  modules = None
+
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], "hd:m:")
+  except getopt.GetoptError as e:
+    print(e)
+    usage()
+    sys.exit()
+  for o, a in opts:
+    if o == '-h':
+      usage()
+      sys.exit()
+    if o == '-d':
+      resultsdir = a
+    if o == '-m':
+      modules = (modules or []) + a.split(',')
+
+  trace = TraceFile(os.path.join(resultsdir, 'sim.trace'))
+  time_zero = trace.events[0][0] if trace.events else 0
+  for time, thread_id, site, args in trace.events:
+    module, level, filename, line, num_args, format = trace.sites[site]
+    if modules and module not in modules:
+      continue
+    print('[%12u] [%6u] [%-9s] %s:%u %s' % (time - time_zero, thread_id, module, filename, line, trace.format(site, args[:num_args])))
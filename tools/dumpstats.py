@@ -142,12 +142,10 @@ if do_stats:
   if through_time:
     import sniper_stats
     stats = sniper_stats.SniperStats(resultsdir = resultsdir, jobid = jobid)
-    names = stats.read_metricnames()
     metrics = [ metric[1:] if metric[0] in '-' else metric for metric in through_time ]
-    nameids = dict([ ('%s.%s' % (objectname, metricname), nameid) for nameid, (objectname, metricname) in names.items() if '%s.%s' % (objectname, metricname) in metrics ])
     prefixes = stats.get_snapshots()
     prefixes_len = max(map(len, prefixes))
-    data = dict([ (prefix, stats.read_snapshot(prefix, metrics)) for prefix in prefixes ])
+    data = dict([ (metric, stats.read_metric_series(metric)) for metric in metrics ])
 
     def do_op(op, state, v):
       if op == '-':
@@ -162,8 +160,7 @@ if do_stats:
         op = _metric[0]
         print('==', metric, '==')
         state = {}
-        for prefix in prefixes:
-          v = data[prefix].get(nameids[metric], {})
+        for prefix, v in data[metric]:
           v = [ v.get(i, 0) for i in range(max(v.keys() or [0])+1) ]
           v = do_op(op, state, v)
           print_result('%-*s' % (prefixes_len, prefix), v)
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+
+import sys, getopt, sniper_lib
+
+# Turn the stack distance histograms of a cache's reuse profiler (config/reuse.cfg) into miss-ratio curves:
+# a fully-associative LRU cache of 2^k lines misses on cold accesses and on all accesses with distance bucket > k
+
+def generate_mrc(cache = 'L3', jobid = None, resultsdir = '.', partial = None, blocksize = 64):
+  res = sniper_lib.get_results(jobid = jobid, resultsdir = resultsdir, partial = partial)
+  results = res['results']
+  prefix = '%s.reuse.' % cache
+  if prefix + 'accesses' not in results:
+    raise ValueError('No reuse profile found for %s, was reuse_profiler enabled for this cache?' % cache)
+
+  buckets = sorted([ int(k[len(prefix + 'distance-'):]) for k in results if k.startswith(prefix + 'distance-') ])
+  curves = []
+  for core, accesses in enumerate(results[prefix + 'accesses']):
+    if not accesses:
+      continue
+    misses = accesses
+    curve = []
+    for bucket in buckets:
+      misses -= results[prefix + 'distance-%d' % bucket][core]
+      curve.append((bucket, misses / float(accesses)))
+    curves.append((core, curve))
+  return curves
+
+
+if __name__ == '__main__':
+  def usage():
+    print('Usage:', sys.argv[0], '[-h (help)] [-j <jobid> | -d <resultsdir (default: .)>] [--partial=<begin:end (roi-begin:roi-end)>] [-c <cache (L3)>] [-b <blocksize (64)>]')
+    sys.exit(-1)
+
+  jobid = 0
+  resultsdir = '.'
+  partial = None
+  cache = 'L3'
+  blocksize = 64
+
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], "hj:d:c:b:", [ 'partial=' ])
+  except getopt.GetoptError as e:
+    print(e)
+    usage()
+  for o, a in opts:
+    if o == '-h':
+      usage()
+    if o == '-d':
+      resultsdir = a
+    if o == '-j':
+      jobid = int(a)
+    if o == '-c':
+      cache = a
+    if o == '-b':
+      blocksize = int(a)
+    if o == '--partial':
+      if ':' not in a:
+        sys.stderr.write('--partial=<from>:<to>\n')
+        usage()
+      partial = a.split(':')
+
+  for core, curve in generate_mrc(cache = cache, jobid = jobid, resultsdir = resultsdir, partial = partial, blocksize = blocksize):
+    print('Core %d' % core)
+    for bucket, miss_ratio in curve:
+      print('  %12d bytes  %6.2f%%' % ((1 << bucket) * blocksize, 100 * miss_ratio))
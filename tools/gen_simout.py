@@ -99,6 +99,16 @@ def generate_simout(jobid = None, resultsdir = None, partial = None, output = sy
         ('    mpki', '%s.mpki'%tlb, lambda v: '%.2f' % v),
       ])
 
+  if 'page_walker.walks' in results:
+    results['page_walker.avglatency'] = [a/float(b or 1) for a, b in zip(results['page_walker.total-latency'], results['page_walker.walks'])]
+    template.extend([
+      ('  Page walker', '', ''),
+      ('    num walks', 'page_walker.walks', str),
+      ('    memory accesses', 'page_walker.memory-accesses', str),
+      ('    walk cache hits', 'page_walker.walk-cache-hits', str),
+      ('    average latency (ns)', 'page_walker.avglatency', format_ns(2)),
+    ])
+
   template += [
     ('Cache Summary', '', ''),
   ]
@@ -183,6 +193,15 @@ def generate_simout(jobid = None, resultsdir = None, partial = None, output = sy
   for j, line in enumerate(lines):
     output.write(' | '.join([ ('%%%s%us' % ((j==0 or i==0) and '-' or '', widths[i])) % line[i] for i in range(len(line)) ]) + '\n')
 
+  # Host time measured by general/self_profile, indexed by host thread rather than by core
+  subsystems = [ name[len('self_profile.'):-len('-time')] for name in results if name.startswith('self_profile.') and name.endswith('-time') ]
+  if subsystems:
+    totals = [ (subsystem, sum(results['self_profile.%s-time' % subsystem])) for subsystem in subsystems ]
+    total = sum([ t for subsystem, t in totals ]) or 1
+    output.write('Host time (self profile, all host threads)\n')
+    for subsystem, t in sorted(totals, key = lambda st: st[1], reverse = True):
+      output.write('  %-18s %10.3f s  %5.1f%%\n' % (subsystem, t / 1e9, 100. * t / total))
+
 
 
 if __name__ == '__main__':
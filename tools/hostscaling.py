@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+
+# Host scaling study: runs multi-threaded test/ programs at several simulated core counts, each restricted
+# (with taskset) to 1, 2, 4, ... host CPUs, and reports how simulation speed scales with the number of host cores.
+# Per run it collects wall time, simulated KIPS, time host threads spent waiting in the barrier (self-profiler)
+# and contention on the shared cache set locks, and writes them to a JSON file and a text report.
+# For each workload and core count, the report marks the host core count beyond which the next step up in host cores
+# adds less than --knee (default 10%) to the simulation speed.
+
+import sys, os, getopt, json, time, platform, subprocess, shutil, sniper_lib, speedsuite
+
+HOME = speedsuite.HOME
+VERSION = 1
+
+# Workloads, scaled to the number of simulated cores
+TESTS = [
+  ('fft',     dict(dir = 'fft',     target = 'fft',    options = lambda n: '--roi', cmd = lambda n: './fft -p %d' % n)),
+  ('mpi-omp', dict(dir = 'mpi-omp', target = 'hybrid', options = lambda n: '--mpi --mpi-ranks=2', cmd = lambda n: './hybrid',
+                   env = lambda n: { 'OMP_NUM_THREADS': str(max(1, n // 2)), 'OMP_WAIT_POLICY': 'passive' })),
+]
+
+SIM_CORES = [ 8, 16, 64, 256 ]
+
+
+def usage():
+  print('Usage:', sys.argv[0], '[-h (help)] [-o <output.json> (default: hostscaling.json)] [-d <rundir (default: hostscaling.runs)>]', \
+        '[--tests=<test>[,<test>...]] [--cores=<simulated cores>[,...] (default: 8,16,64,256)]', \
+        '[--host-cores=<host cores>[,...] (default: 1,2,4,... up to all usable CPUs)] [--knee=<fraction (default: 0.1)>]', \
+        '[-- <extra run-sniper options>]')
+
+
+def log(*args):
+  print('[HOSTSCALING]', *args)
+  sys.stdout.flush()
+
+
+def host_cpus():
+  return sorted(os.sched_getaffinity(0))
+
+
+def default_host_cores(ncpus):
+  counts = []
+  n = 1
+  while n < ncpus:
+    counts.append(n)
+    n *= 2
+  return counts + [ ncpus ]
+
+
+def collect_results(resultsdir):
+  siminfo = eval(open(os.path.join(resultsdir, 'sim.info')).read())
+  results = sniper_lib.get_results(resultsdir = resultsdir)['results']
+  roi_walltime = results.get('time.walltime', [0])[0] / 1e6 # microseconds -> seconds
+  instrs = sum(results.get('core.instructions', [0]))
+  # Both are summed over all host threads (self_profile) and over all caches with set locks
+  barrier_time = sum(results.get('self_profile.barrier-time', [0])) / 1e9 # ns -> seconds
+  lock_contended = sum(sum(values) for key, values in results.items() if key.endswith('.setlock-shared-contended') or key.endswith('.setlock-exclusive-contended'))
+  return dict(
+    wall_time = siminfo['t_elapsed'],
+    roi_wall_time = roi_walltime,
+    instructions = instrs,
+    kips = roi_walltime and instrs / roi_walltime / 1e3 or 0,
+    barrier_wait_time = barrier_time,
+    setlock_contended = lock_contended,
+  )
+
+
+def run(testname, test, ncores, cpus, rundir, extra_options):
+  resultsdir = os.path.join(rundir, '%s-%d-host%d' % (testname, ncores, len(cpus)))
+  if os.path.exists(resultsdir):
+    shutil.rmtree(resultsdir)
+  os.makedirs(resultsdir)
+
+  cmd = [ 'taskset', '-c', ','.join(map(str, cpus)), os.path.join(HOME, 'run-sniper'), '-d', resultsdir, '-n', str(ncores), '-c', 'gainestown' ]
+  cmd += [ '-g', '--general/self_profile=true', '-g', '--general/startup_threads=%d' % len(cpus) ]
+  cmd += test['options'](ncores).split() + extra_options + [ '--' ] + test['cmd'](ncores).split()
+
+  env = dict(os.environ)
+  env.update(test.get('env', lambda n: {})(ncores))
+  log('Running', testname, 'on', ncores, 'cores with', len(cpus), 'host cores')
+  rc = subprocess.call(cmd, cwd = os.path.join(HOME, 'test', test['dir']), env = env,
+                       stdout = open(os.path.join(resultsdir, 'hostscaling.log'), 'w'), stderr = subprocess.STDOUT)
+  if rc != 0:
+    return dict(status = 'failed', reason = 'run-sniper exited with code %d, see %s' % (rc, os.path.join(resultsdir, 'hostscaling.log')))
+
+  try:
+    result = collect_results(resultsdir)
+  except (IOError, ValueError, KeyError, sniper_lib.SniperResultsException) as e:
+    return dict(status = 'failed', reason = 'cannot read results: %s' % e)
+  result['status'] = 'ok'
+  return result
+
+
+def report(runs, knee):
+  lines = []
+  for testname, ncores in sorted(set((r['test'], r['ncores']) for r in runs)):
+    series = sorted([ r for r in runs if r['test'] == testname and r['ncores'] == ncores and r['status'] == 'ok' ], key = lambda r: r['host_cores'])
+    if not series:
+      continue
+    base = series[0]
+    saturated = None
+    lines.append('%s, %d simulated cores' % (testname, ncores))
+    lines.append('  %10s %10s %10s %8s %10s %14s %12s' % ('host cores', 'wall (s)', 'KIPS', 'speedup', 'efficiency', 'barrier (s)', 'lock waits'))
+    for i, r in enumerate(series):
+      speedup = base['kips'] and r['kips'] / base['kips'] or 0
+      efficiency = speedup * base['host_cores'] / r['host_cores']
+      lines.append('  %10d %10.1f %10.1f %8.2f %9.0f%% %14.2f %12d' % (r['host_cores'], r['wall_time'], r['kips'], speedup, 100 * efficiency, r['barrier_wait_time'], r['setlock_contended']))
+      if saturated is None and i + 1 < len(series) and r['kips'] and series[i+1]['kips'] / r['kips'] - 1 < knee:
+        saturated = r['host_cores']
+    if saturated is not None:
+      lines.append('  Adding host cores beyond %d gains less than %d%%' % (saturated, 100 * knee))
+    else:
+      lines.append('  Still scaling at %d host cores' % series[-1]['host_cores'])
+    lines.append('')
+  return '\n'.join(lines)
+
+
+if __name__ == '__main__':
+  outputfile = 'hostscaling.json'
+  rundir = 'hostscaling.runs'
+  testnames = [ name for name, _ in TESTS ]
+  sim_cores = SIM_CORES
+  host_cores = None
+  knee = 0.1
+
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], "ho:d:", [ 'tests=', 'cores=', 'host-cores=', 'knee=' ])
+  except getopt.GetoptError as e:
+    print(e)
+    usage()
+    sys.exit(-1)
+  for o, a in opts:
+    if o == '-h':
+      usage()
+      sys.exit()
+    if o == '-o':
+      outputfile = a
+    if o == '-d':
+      rundir = a
+    if o == '--tests':
+      testnames = a.split(',')
+    if o == '--cores':
+      sim_cores = list(map(int, a.split(',')))
+    if o == '--host-cores':
+      host_cores = list(map(int, a.split(',')))
+    if o == '--knee':
+      knee = float(a)
+
+  tests = dict(TESTS)
+  for name in testnames:
+    if name not in tests:
+      print('Unknown test', name, '- valid tests are:', ', '.join(tests.keys()))
+      sys.exit(-1)
+
+  cpus = host_cpus()
+  host_cores = host_cores or default_host_cores(len(cpus))
+  if max(host_cores) > len(cpus):
+    print('Only %d host CPUs are available' % len(cpus))
+    sys.exit(-1)
+
+  rundir = os.path.abspath(rundir)
+  runs = []
+  for testname in testnames:
+    test = tests[testname]
+    built = speedsuite.build_test(test)
+    for ncores in sim_cores:
+      for nhost in host_cores:
+        if built:
+          result = run(testname, test, ncores, cpus[:nhost], rundir, args)
+        else:
+          result = dict(status = 'failed', reason = 'cannot build test/%s' % test['dir'])
+        result.update(test = testname, ncores = ncores, host_cores = nhost)
+        if result['status'] == 'ok':
+          log('%s on %d cores, %d host cores: %.1f KIPS, %.1f s' % (testname, ncores, nhost, result['kips'], result['wall_time']))
+        else:
+          log('%s on %d cores, %d host cores %s: %s' % (testname, ncores, nhost, result['status'], result['reason']))
+        runs.append(result)
+
+  git_revision = subprocess.getoutput('git -C "%s" rev-parse HEAD 2>/dev/null' % HOME)
+  output = dict(
+    suite = 'sniper-hostscaling',
+    version = VERSION,
+    host = platform.node(),
+    cpu = platform.processor(),
+    host_cpus = len(cpus),
+    git_revision = git_revision,
+    date = time.strftime('%Y-%m-%dT%H:%M:%S'),
+    runs = runs,
+  )
+  json.dump(output, open(outputfile, 'w'), indent = 2, sort_keys = True)
+  text = report(runs, knee)
+  open(os.path.splitext(outputfile)[0] + '.txt', 'w').write(text)
+  print(text)
+  log('Results written to', outputfile)
+
+  if any(r['status'] == 'failed' for r in runs):
+    sys.exit(2)
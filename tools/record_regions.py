@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+
+# Record a set of regions of an application as separate SIFT traces, using several recorder processes in parallel,
+# and write an index file that maps each region to its trace (input for sampled_regions.py --index).
+#
+# Regions are given as <start> <length> <weight> (instruction counts from the start of the application),
+# or as SimPoint output. Each region is recorded with <warmup> instructions in front of it.
+# Regions are spread over <jobs> groups of non-overlapping regions; every group is one record-trace run that
+# fast-forwards through the application and records all of its regions in a single pass (-sniper:regions),
+# so the number of times the application is run is <jobs> rather than the number of regions.
+# Traces are block-compressed so they carry a block index, and can be seeked into.
+#
+# With --pinball, every group replays the same whole-program pinball, which makes the separate runs
+# see the same execution. With --region-pinballs, each region is recorded from its own PinPlay region pinball
+# (<pattern> with %d replaced by the region number), which needs no fast-forwarding at all; -w then
+# gives the number of warmup instructions the region pinballs contain.
+#
+# The index lists, per region: <region> <start> <length> <weight> <warmup> <trace>,
+# where <start> is the start of the region proper and the trace begins <warmup> instructions before it.
+
+import sys, os, getopt, subprocess, threading, queue, env_setup
+import sampled_regions
+
+def usage():
+  print('Usage:', sys.argv[0], '{ -r <regions file (start length weight)> | --simpoints=<file> --weights=<file> --interval=<size> }', file=sys.stderr)
+  print('  [-w <warmup instructions (0)>] [-j <parallel recordings (#cpus)>] [-d <outputdir (.)>] [--codec=<block codec (zlib)>]', file=sys.stderr)
+  print('  [--record-option=<record-trace option>]* { --pinball=<pinball-basename> | --region-pinballs=<pattern> | -- <cmdline> }', file=sys.stderr)
+
+
+def make_groups(regions, warmup, njobs):
+  # Assign each region (with its warmup) to the least loaded group it does not overlap with
+  groups = [ [] for _ in range(njobs) ]
+  for region_id, (start, length, weight) in sorted(enumerate(regions), key = lambda r: r[1][0]):
+    begin = start - min(warmup, start)
+    free = [ group for group in groups if not group or group[-1][2] <= begin ]
+    if not free:
+      free = [ [] ]
+      groups += free
+    group = min(free, key = len)
+    group.append((region_id, begin, start + length))
+  return [ group for group in groups if group ]
+
+
+def record(cmds):
+  jobs = queue.Queue()
+  for job in cmds:
+    jobs.put(job)
+  failed = []
+
+  def worker():
+    while True:
+      try:
+        name, cmd, outputdir = jobs.get_nowait()
+      except queue.Empty:
+        return
+      print('[RECORD-REGIONS] Starting %s' % name)
+      with open(os.path.join(outputdir, 'record.log'), 'w') as log:
+        rc = subprocess.call(cmd, stdout = log, stderr = subprocess.STDOUT)
+      print('[RECORD-REGIONS] %s done%s' % (name, rc and ' (failed, see %s)' % os.path.join(outputdir, 'record.log') or ''))
+      if rc:
+        failed.append(name)
+
+  threads = [ threading.Thread(target = worker) for _ in range(min(njobs, len(cmds))) ]
+  for t in threads:
+    t.start()
+  for t in threads:
+    t.join()
+  return failed
+
+
+if __name__ == '__main__':
+  regionsfile = None
+  simpoints = None
+  weights = None
+  interval = None
+  warmup = 0
+  njobs = os.cpu_count() or 1
+  outputdir = '.'
+  codec = 'zlib'
+  pinball = None
+  region_pinballs = None
+  record_options = []
+
+  try:
+    opts, cmdline = getopt.getopt(sys.argv[1:], 'hr:w:j:d:', [ 'simpoints=', 'weights=', 'interval=', 'codec=', 'pinball=', 'region-pinballs=', 'record-option=' ])
+  except getopt.GetoptError as e:
+    print(e, file=sys.stderr)
+    usage()
+    sys.exit(-1)
+  for o, a in opts:
+    if o == '-h':
+      usage()
+      sys.exit()
+    if o == '-r':
+      regionsfile = a
+    if o == '--simpoints':
+      simpoints = a
+    if o == '--weights':
+      weights = a
+    if o == '--interval':
+      interval = int(a)
+    if o == '-w':
+      warmup = int(a)
+    if o == '-j':
+      njobs = int(a)
+    if o == '-d':
+      outputdir = a
+    if o == '--codec':
+      codec = a
+    if o == '--pinball':
+      pinball = os.path.abspath(a)
+    if o == '--region-pinballs':
+      region_pinballs = os.path.abspath(a)
+    if o == '--record-option':
+      record_options.append(a)
+
+  if not (regionsfile or (simpoints and weights and interval)) or (not cmdline and not pinball and not region_pinballs):
+    usage()
+    sys.exit(-1)
+
+  if regionsfile:
+    regions = sampled_regions.read_regions(regionsfile)
+  else:
+    regions = sampled_regions.read_simpoints(simpoints, weights, interval)
+  if not regions:
+    print('[RECORD-REGIONS] No regions to record', file=sys.stderr)
+    sys.exit(-1)
+
+  outputdir = os.path.abspath(outputdir)
+  record_trace = [ os.path.join(env_setup.sim_root(), 'record-trace') ] + record_options + [ '-X', '-sniper:blockcomp %s' % codec ]
+
+  cmds = []
+  traces = {}
+  if region_pinballs:
+    # One recording per region, each replaying its own pinball from start to end
+    for region_id in range(len(regions)):
+      regiondir = os.path.join(outputdir, 'region-%d' % region_id)
+      if not os.path.exists(regiondir):
+        os.makedirs(regiondir)
+      cmd = record_trace + [ '-o', os.path.join(regiondir, 'trace'), '--pinball=%s' % (region_pinballs % region_id) ]
+      cmds.append(('region %d' % region_id, cmd, regiondir))
+      traces[region_id] = (warmup, os.path.join(regiondir, 'trace.sift'))
+  else:
+    groups = make_groups(regions, warmup, njobs)
+    for group_id, group in enumerate(groups):
+      groupdir = os.path.join(outputdir, 'group-%d' % group_id)
+      if not os.path.exists(groupdir):
+        os.makedirs(groupdir)
+      with open(os.path.join(groupdir, 'regions'), 'w') as fp:
+        for region_id, begin, end in group:
+          fp.write('%d %d # region %d\n' % (begin, end - begin, region_id))
+      cmd = record_trace + [ '-o', os.path.join(groupdir, 'trace'), '-X', '-sniper:regions %s' % os.path.join(groupdir, 'regions') ]
+      if pinball:
+        cmd.append('--pinball=%s' % pinball)
+      else:
+        cmd += [ '--' ] + cmdline
+      cmds.append(('group %d (%d regions)' % (group_id, len(group)), cmd, groupdir))
+    print('[RECORD-REGIONS] Recording %d regions in %d runs, %d at a time' % (len(regions), len(groups), njobs))
+
+  failed = record(cmds)
+  if failed:
+    print('[RECORD-REGIONS] %s failed, not writing the index' % ', '.join(failed), file=sys.stderr)
+    sys.exit(1)
+
+  if not region_pinballs:
+    # The recorder lists <n> <start> <recorded length> <trace> for each region of its group
+    for group_id, group in enumerate(groups):
+      for line in open(os.path.join(outputdir, 'group-%d' % group_id, 'trace.regions')):
+        n, begin, recorded, tracefile = line.split()
+        region_id = group[int(n)][0]
+        start, length, weight = regions[region_id]
+        if int(recorded) < start + length - int(begin):
+          print('[RECORD-REGIONS] Warning: region %d is incomplete, %d of %d instructions recorded' % (region_id, int(recorded), start + length - int(begin)), file=sys.stderr)
+        traces[region_id] = (start - int(begin), tracefile)
+
+  indexfile = os.path.join(outputdir, 'regions.index')
+  with open(indexfile, 'w') as fp:
+    fp.write('# region start length weight warmup trace\n')
+    for region_id, (start, length, weight) in enumerate(regions):
+      if region_id not in traces:
+        print('[RECORD-REGIONS] Warning: region %d was not reached, it is left out of the index' % region_id, file=sys.stderr)
+        continue
+      region_warmup, tracefile = traces[region_id]
+      fp.write('%d %d %d %g %d %s\n' % (region_id, start, length, weight, region_warmup, tracefile))
+  print('[RECORD-REGIONS] Index written to %s' % indexfile)
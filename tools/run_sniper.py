@@ -5,6 +5,15 @@ def Tee(filename, prefix = ''):
   obj = subprocess.Popen(['bash', '-c', 'while read line; do echo "%s"$line; echo $line >> %s; done' % (prefix, filename)], stdin = subprocess.PIPE)
   return obj.stdin.fileno()
 
+# Create an empty shared-memory ring, replacing a FIFO for traceinput/transport = shm (layout: sift/shm_stream.h)
+def create_shm_ring(filename, size = 4096*1024):
+  import struct
+  header_size = 4096
+  fp = open(filename, 'wb')
+  fp.write(struct.pack('<IIQ', 0x52534853, 1, size))
+  fp.truncate(header_size + size)
+  fp.close()
+
 def __run_program_redirect(app_id, program_func, program_arg, outputdir, run_id = 0):
   prefix_fd = Tee(os.path.join(outputdir, 'benchmark-app%d-run%d.log' % (app_id, run_id)), '[app%d] ' % app_id)
   os.dup2(prefix_fd, sys.stdout.fileno())
@@ -0,0 +1,270 @@
+#!/usr/bin/env python3
+
+# Simulate a set of sampled regions of a SIFT trace as concurrent Sniper instances, and merge their statistics
+# into a single sim.stats.sqlite3 with per-region weights.
+#
+# Each region is given as <start> <length> <weight> (instruction counts relative to the start of the trace).
+# For every region, a separate simulation is started in <outputdir>/region-<n> which:
+#  - seeks into the trace at the last block boundary before <start> - <warmup>
+#    (traceinput/start_icount, this needs a trace recorded with block compression),
+#  - fast-forwards to <start> - <warmup>, warms up caches and predictors for <warmup> instructions,
+#  - simulates <length> instructions in detail and then stops.
+# With --checkpoints, the warmed state at the start of each region is saved to <checkpoint-dir>/region-<n>.ckpt,
+# and later runs (with the same configuration) restore it instead of running the warmup.
+#
+# The merged statistics contain a roi-begin snapshot of all zeros and a roi-end snapshot with, for every statistic,
+# the sum over all regions of <weight> * (roi-end - roi-begin). With SimPoint-style weights that sum to one this
+# describes an average region, with weights set to the number of intervals each region represents
+# the totals are extrapolated to the full trace.
+#
+# With --index, regions come from an index written by record_regions.py, and each region is simulated from its own
+# trace, which already starts at the beginning of the region's recorded warmup (so -w is limited to that warmup).
+
+import sys, os, getopt, struct, shutil, subprocess, threading, queue, sqlite3, env_setup, sniper_stats_sqlite
+
+BLOCK_INDEX_MAGIC = 0x58444953 # "SIDX", see sift/sift_format.h
+
+def usage():
+  print('Usage:', sys.argv[0], '{ --traces=<trace.sift> { -r <regions file (start length weight)> | --simpoints=<file> --weights=<file> --interval=<size> } | --index=<regions.index> }', file=sys.stderr)
+  print('  [-w <warmup instructions (0)>] [-j <parallel simulations (#cpus)>] [-d <outputdir (.)>] [--checkpoints=<dir>] [-- <run-sniper options>]', file=sys.stderr)
+
+
+def read_block_index(tracefile):
+  # Returns a list of (icount, offset) for each block, see Sift::BlockIndexTrailer, BlockHeader and BlockIndexEntry
+  with open(tracefile, 'rb') as fp:
+    fp.seek(0, os.SEEK_END)
+    if fp.tell() < 16:
+      return []
+    fp.seek(-16, os.SEEK_END)
+    offset, num_blocks, magic = struct.unpack('<QII', fp.read(16))
+    if magic != BLOCK_INDEX_MAGIC:
+      return []
+    fp.seek(offset)
+    magic, codec, size, raw_size, icount = struct.unpack('<IB3xIIQ', fp.read(24))
+    if magic != BLOCK_INDEX_MAGIC or size != num_blocks * 16:
+      return []
+    return list(struct.iter_unpack('<QQ', fp.read(size)))
+
+
+def block_start(index, icount):
+  # Instruction count of the last block at or before icount, where Sift::Reader::Seek will end up
+  start = 0
+  for block_icount, offset in index:
+    if block_icount > icount:
+      break
+    start = block_icount
+  return start
+
+
+def read_regions(filename):
+  regions = []
+  for line in open(filename):
+    line = line.split('#')[0].split()
+    if line:
+      regions.append((int(line[0]), int(line[1]), float(line[2]) if len(line) > 2 else 1.))
+  return regions
+
+
+def read_simpoints(simpoints, weights, interval):
+  # SimPoint output: <interval index> <cluster> and <weight> <cluster>
+  points = dict( (int(cluster), int(index)) for index, cluster in (line.split() for line in open(simpoints) if line.strip()) )
+  regions = []
+  for weight, cluster in (line.split() for line in open(weights) if line.strip()):
+    regions.append((points[int(cluster)] * interval, interval, float(weight)))
+  return sorted(regions)
+
+
+def read_index(filename):
+  # Lines of <region> <start> <length> <weight> <warmup> <trace>, see record_regions.py
+  entries = []
+  for line in open(filename):
+    line = line.split('#')[0].split()
+    if line:
+      entries.append((int(line[0]), int(line[1]), int(line[2]), float(line[3]), int(line[4]), line[5]))
+  return entries
+
+
+def region_command(region_id, region, tracefile, index, warmup, outputdir, checkpointdir, sniper_options):
+  start, length, weight = region
+  warmup = min(warmup, start)
+  seek = block_start(index, start - warmup)
+
+  options = [ '-d', outputdir, '--traces=%s' % tracefile, '--roi-script', '--no-cache-warming' ]
+  if seek:
+    options += [ '-g', '--traceinput/start_icount=%d' % seek ]
+
+  checkpoint = checkpointdir and os.path.join(checkpointdir, 'region-%d.ckpt' % region_id)
+  if checkpoint and os.path.exists(checkpoint):
+    # Restored state already contains the warmup, fast-forward straight to the region
+    options += [ '-g', '--checkpoint/restore=%s' % os.path.abspath(checkpoint) ]
+    options += [ '-s', 'roi-icount:%d:0:%d:stop' % (start - seek, length) ]
+  else:
+    options += [ '-s', 'roi-icount:%d:%d:%d:stop' % (start - warmup - seek, warmup, length) ]
+    if checkpoint:
+      options += [ '-g', '--checkpoint/save=%s' % os.path.abspath(checkpoint), '-g', '--checkpoint/save_icount=%d' % max(1, start - seek) ]
+
+  return [ os.path.join(env_setup.sim_root(), 'run-sniper') ] + options + sniper_options
+
+
+def run_regions(commands, njobs):
+  jobs = queue.Queue()
+  for region_id, cmd, outputdir in commands:
+    jobs.put((region_id, cmd, outputdir))
+  failed = []
+
+  def worker():
+    while True:
+      try:
+        region_id, cmd, outputdir = jobs.get_nowait()
+      except queue.Empty:
+        return
+      print('[SAMPLED] Starting region %d' % region_id)
+      with open(os.path.join(outputdir, 'region.log'), 'w') as log:
+        rc = subprocess.call(cmd, stdout = log, stderr = subprocess.STDOUT)
+      print('[SAMPLED] Region %d done%s' % (region_id, rc and ' (failed, see %s)' % os.path.join(outputdir, 'region.log') or ''))
+      if rc:
+        failed.append(region_id)
+
+  threads = [ threading.Thread(target = worker) for _ in range(min(njobs, len(commands))) ]
+  for t in threads:
+    t.start()
+  for t in threads:
+    t.join()
+  return failed
+
+
+def merge_stats(regions, regiondirs, outputdir):
+  # Weighted sum of the roi-begin:roi-end delta of each region
+  names = {}
+  merged = {}
+  for (start, length, weight), regiondir in zip(regions, regiondirs):
+    stats = sniper_stats_sqlite.SniperStatsSqlite(os.path.join(regiondir, 'sim.stats.sqlite3'))
+    begin = stats.read_snapshot('roi-begin')
+    end = stats.read_snapshot('roi-end')
+    for nameid, values in end.items():
+      name = stats.names[nameid]
+      if name not in names:
+        names[name] = len(names)
+      for core, value in values.items():
+        delta = (value or 0) - (begin.get(nameid, {}).get(core) or 0)
+        key = (names[name], core)
+        merged[key] = merged.get(key, 0.) + weight * delta
+
+  filename = os.path.join(outputdir, 'sim.stats.sqlite3')
+  if os.path.exists(filename):
+    os.unlink(filename)
+  db = sqlite3.connect(filename)
+  # Schema as in common/misc/stats.cc
+  db.execute('CREATE TABLE `names` (nameid INTEGER, objectname TEXT, metricname TEXT)')
+  db.execute('CREATE TABLE `prefixes` (prefixid INTEGER, prefixname TEXT)')
+  db.execute('CREATE TABLE `values` (prefixid INTEGER, nameid INTEGER, core INTEGER, value INTEGER)')
+  db.execute('CREATE INDEX `idx_prefix_name` ON `prefixes`(`prefixname`)')
+  db.execute('CREATE INDEX `idx_value_prefix` ON `values`(`prefixid`)')
+  db.execute('CREATE TABLE `topology` (componentname TEXT, coreid INTEGER, masterid INTEGER)')
+  db.execute('CREATE TABLE `event` (event INTEGER, time INTEGER, core INTEGER, thread INTEGER, value0 INTEGER, value1 INTEGER, description TEXT)')
+  db.executemany('INSERT INTO `names` (nameid, objectname, metricname) VALUES (?, ?, ?)', [ (nameid, objectname, metricname) for (objectname, metricname), nameid in names.items() ])
+  db.executemany('INSERT INTO `prefixes` (prefixid, prefixname) VALUES (?, ?)', [ (1, 'roi-begin'), (2, 'roi-end') ])
+  db.executemany('INSERT INTO `values` (prefixid, nameid, core, value) VALUES (?, ?, ?, ?)', [ (1, nameid, core, 0) for nameid, core in merged ])
+  db.executemany('INSERT INTO `values` (prefixid, nameid, core, value) VALUES (?, ?, ?, ?)', [ (2, nameid, core, int(round(value))) for (nameid, core), value in merged.items() ])
+  db.executemany('INSERT INTO topology (componentname, coreid, masterid) VALUES (?, ?, ?)', sniper_stats_sqlite.SniperStatsSqlite(os.path.join(regiondirs[0], 'sim.stats.sqlite3')).get_topology())
+  db.commit()
+  db.close()
+
+  # Make the merged results readable by the usual tools (sniper_lib, dumpstats, cpistack, ...)
+  shutil.copy(os.path.join(regiondirs[0], 'sim.cfg'), os.path.join(outputdir, 'sim.cfg'))
+  with open(os.path.join(outputdir, 'regions.txt'), 'w') as fp:
+    for region_id, (start, length, weight) in enumerate(regions):
+      fp.write('%d %d %d %g\n' % (region_id, start, length, weight))
+
+
+if __name__ == '__main__':
+  tracefile = None
+  regionsfile = None
+  simpoints = None
+  weights = None
+  interval = None
+  warmup = 0
+  njobs = os.cpu_count() or 1
+  outputdir = '.'
+  checkpointdir = None
+  indexfile = None
+
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], 'hr:w:j:d:', [ 'traces=', 'simpoints=', 'weights=', 'interval=', 'checkpoints=', 'index=' ])
+  except getopt.GetoptError as e:
+    print(e, file=sys.stderr)
+    usage()
+    sys.exit(-1)
+  for o, a in opts:
+    if o == '-h':
+      usage()
+      sys.exit()
+    if o == '--traces':
+      tracefile = os.path.abspath(a)
+    if o == '-r':
+      regionsfile = a
+    if o == '--simpoints':
+      simpoints = a
+    if o == '--weights':
+      weights = a
+    if o == '--interval':
+      interval = int(a)
+    if o == '-w':
+      warmup = int(a)
+    if o == '-j':
+      njobs = int(a)
+    if o == '-d':
+      outputdir = a
+    if o == '--checkpoints':
+      checkpointdir = a
+    if o == '--index':
+      indexfile = a
+
+  if not indexfile and (not tracefile or not (regionsfile or (simpoints and weights and interval))):
+    usage()
+    sys.exit(-1)
+
+  if indexfile:
+    entries = read_index(indexfile)
+    region_ids = [ region_id for region_id, start, length, weight, region_warmup, trace in entries ]
+    regions = [ (start, length, weight) for region_id, start, length, weight, region_warmup, trace in entries ]
+    # Within its own trace, a region starts after the recorded warmup
+    tracefiles = [ (os.path.abspath(trace), (region_warmup, length, weight)) for region_id, start, length, weight, region_warmup, trace in entries ]
+  else:
+    if regionsfile:
+      regions = read_regions(regionsfile)
+    else:
+      regions = read_simpoints(simpoints, weights, interval)
+    region_ids = list(range(len(regions)))
+    tracefiles = [ (tracefile, region) for region in regions ]
+  if not regions:
+    print('[SAMPLED] No regions to simulate', file=sys.stderr)
+    sys.exit(-1)
+
+  indices = {}
+  for trace, region in tracefiles:
+    if trace not in indices:
+      indices[trace] = read_block_index(trace)
+      if not indices[trace]:
+        print('[SAMPLED] Warning: %s has no block index, regions in it will fast-forward from the start of the trace' % trace, file=sys.stderr)
+
+  if checkpointdir and not os.path.exists(checkpointdir):
+    os.makedirs(checkpointdir)
+
+  commands = []
+  regiondirs = []
+  for region_id, (trace, region) in zip(region_ids, tracefiles):
+    regiondir = os.path.join(outputdir, 'region-%d' % region_id)
+    if not os.path.exists(regiondir):
+      os.makedirs(regiondir)
+    regiondirs.append(regiondir)
+    commands.append((region_id, region_command(region_id, region, trace, indices[trace], warmup, regiondir, checkpointdir, args), regiondir))
+
+  print('[SAMPLED] Simulating %d regions, %d at a time' % (len(regions), njobs))
+  failed = run_regions(commands, njobs)
+  if failed:
+    print('[SAMPLED] Regions %s failed, not merging statistics' % ', '.join(map(str, sorted(failed))), file=sys.stderr)
+    sys.exit(1)
+
+  merge_stats(regions, regiondirs, outputdir)
+  print('[SAMPLED] Merged statistics written to %s' % os.path.join(outputdir, 'sim.stats.sqlite3'))
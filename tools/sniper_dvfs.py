@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+
+# Read sim.dvfs.bin, the per-domain frequency trace written with dvfs/trace = true (see common/system/dvfs_manager.cc)
+
+import sys, os, getopt, struct
+
+
+def read_dvfs(filename = 'sim.dvfs.bin'):
+  data = open(filename, 'rb').read()
+  magic, version, num_domains, cores_per_domain = struct.unpack_from('8sQQQ', data, 0)
+  if magic != b'SNIPDVFS':
+    raise ValueError('%s is not a Sniper DVFS trace' % filename)
+  record = struct.Struct('Q%uI' % ((num_domains + 1) & ~1))
+  offset = struct.calcsize('8sQQQ')
+  records = []
+  while offset + record.size <= len(data):
+    values = record.unpack_from(data, offset)
+    offset += record.size
+    # Time in fs, frequency in MHz for each domain
+    records.append((values[0], list(values[1:1+num_domains])))
+  return cores_per_domain, records
+
+
+if __name__ == '__main__':
+  def usage():
+    print('Usage:', sys.argv[0], '[-h (help)] [-d <resultsdir (default: .)>]')
+
+  resultsdir = '.'
+
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], "hd:")
+  except getopt.GetoptError as e:
+    print(e)
+    usage()
+    sys.exit()
+  for o, a in opts:
+    if o == '-h':
+      usage()
+      sys.exit()
+    if o == '-d':
+      resultsdir = a
+
+  cores_per_domain, records = read_dvfs(os.path.join(resultsdir, 'sim.dvfs.bin'))
+  if records:
+    print('%16s  ' % 'time (ns)' + ' '.join([ '%7s' % ('dom%u' % i) for i in range(len(records[0][1])) ]))
+  for time, freqs in records:
+    print('%16u  ' % (time / 1000000) + ' '.join([ '%7u' % f for f in freqs ]))
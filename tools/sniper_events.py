@@ -0,0 +1,28 @@
+import struct
+
+# Reader for sim.events.bin (see common/misc/event_trace.h)
+
+MAGIC = b'SNIPEVNT'
+HEADER = struct.Struct('IIQQiiQQ')
+
+def read_events(filename = 'sim.events.bin'):
+  data = open(filename, 'rb').read()
+  if data[:8] != MAGIC:
+    raise ValueError('%s is not a Sniper event trace' % filename)
+  events = []
+  offset = 16
+  while offset + HEADER.size <= len(data):
+    length, event, seqnum, time, core, thread, value0, value1 = HEADER.unpack_from(data, offset)
+    if length == 0:
+      break
+    description = data[offset+HEADER.size:offset+length].split(b'\0')[0].decode()
+    events.append((seqnum, (event, time, core, thread, value0, value1, description)))
+    offset += length
+  # Each thread writes its own buffer, restore the global order in which events were logged
+  events.sort(key = lambda e: e[0])
+  return [ event for seqnum, event in events ]
+
+
+if __name__ == '__main__':
+  for event in read_events():
+    print(event)
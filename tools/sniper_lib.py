@@ -168,6 +168,8 @@ def parse_results_from_dir(resultsdir, partial = None, metrics = None):
     # If we're called from inside run-graphite, sim.info may not yet exist
     results.append(('walltime', -1, siminfo['t_elapsed']))
     results.append(('vmem', -1, siminfo['vmem']))
+    if 'rss' in siminfo:
+      results.append(('rss', -1, siminfo['rss']))
 
   ## sim.stats
   if partial:
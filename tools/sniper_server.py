@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+
+# Start, use and stop a Sniper server (lib/sniper --server=<socket>, see standalone/server.h).
+#
+# The server parses its configuration, starts Python and maps the preloaded traces once, then forks a fresh
+# simulator for every job it receives. Jobs are normally submitted through run-sniper --server=<socket>,
+# which takes care of output directories and post-processing like a normal run.
+#
+#   sniper_server.py start <socket> [-j <parallel jobs (#cpus)>] [--preload=<trace>]... [-c <config>]... [-g <section/key=value>]...
+#   sniper_server.py submit <socket> [--] <sniper options>...
+#   sniper_server.py stop <socket>
+
+import sys, os, getopt, socket, env_setup, run_sniper
+
+HOME = env_setup.sim_root()
+
+
+def usage():
+  print('Usage:', sys.argv[0], 'start <socket> [-j <parallel jobs>] [--preload=<trace>]... [-c <config>]... [-g <section/key=value>]...', file=sys.stderr)
+  print('      ', sys.argv[0], 'submit <socket> [--] <sniper options>...', file=sys.stderr)
+  print('      ', sys.argv[0], 'stop <socket>', file=sys.stderr)
+  sys.exit(2)
+
+
+def start(path, args):
+  try:
+    opts, args = getopt.getopt(args, 'j:c:g:', [ 'preload=' ])
+  except getopt.GetoptError as e:
+    print(e, file=sys.stderr)
+    usage()
+
+  cmd = [ os.path.join(HOME, 'lib', 'sniper'), '--server=%s' % path, '-c', os.path.join(HOME, 'config', 'base.cfg') ]
+  for o, a in opts:
+    if o == '-j':
+      cmd.append('--server-jobs=%d' % int(a))
+    if o == '--preload':
+      cmd.append('--server-preload=%s' % os.path.abspath(a))
+    if o == '-c':
+      cmd.append('--config=%s' % a)
+    if o == '-g':
+      cmd.append(a if a.startswith('--') else '--' + a)
+
+  # Same environment as run-sniper sets up for standalone simulations
+  config = {}
+  configfile = os.path.join(HOME, 'config', 'sniper.py')
+  exec(compile(open(configfile, 'rb').read(), configfile, 'exec'), {}, config)
+  homes = dict([ (d, os.path.join(HOME, config[d])) for d in ('pin_home', 'xed_home', 'torch_home') ])
+  env = run_sniper.setup_env(HOME, homes['pin_home'], config.get('target', 'intel64'), True, homes['xed_home'], homes['torch_home'])
+  os.execve(cmd[0], cmd, env)
+
+
+def connect(path):
+  sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+  try:
+    sock.connect(path)
+  except OSError as e:
+    print('Cannot connect to Sniper server at %s: %s' % (path, e), file=sys.stderr)
+    sys.exit(-1)
+  return sock
+
+
+def submit(path, args):
+  if args and args[0] == '--':
+    args = args[1:]
+  sock = connect(path)
+  sock.sendall(b''.join([ s.encode() + b'\0' for s in [ os.getcwd() ] + args ]) + b'\0')
+
+  # Forward the simulation's output until the status trailer: a NUL byte, then "exit <status>\n"
+  out = sys.stdout.buffer
+  pending = b''
+  while True:
+    data = sock.recv(65536)
+    if not data:
+      break
+    pending += data
+    nul = pending.rfind(b'\0')
+    if nul < 0:
+      out.write(pending)
+      pending = b''
+    else:
+      out.write(pending[:nul])
+      pending = pending[nul:]
+    out.flush()
+
+  if not pending.startswith(b'\0exit '):
+    out.write(pending)
+    print('Sniper server closed the connection without a status', file=sys.stderr)
+    return -1
+  return int(pending[6:].strip())
+
+
+def stop(path):
+  sock = connect(path)
+  sock.sendall(b'\0')
+  sock.recv(1)
+  return 0
+
+
+if __name__ == '__main__':
+  if len(sys.argv) < 3:
+    usage()
+  command, path, args = sys.argv[1], sys.argv[2], sys.argv[3:]
+  if command == 'start':
+    start(path, args)
+  elif command == 'submit':
+    sys.exit(submit(path, args))
+  elif command == 'stop':
+    sys.exit(stop(path))
+  else:
+    usage()
@@ -26,6 +26,16 @@ class SniperStatsBase:
         results += [ ('barrier.global_time_end', idx, vals2.get(idx, 0)) for idx in range(ncores) ]
     return results
 
+  def read_metric_series(self, metric):
+    # Values of one metric ('object.metric') in each snapshot: [ (prefix, { index: value }) ]
+    # Backends that can read a single metric without loading whole snapshots override this
+    nameids = [ nameid for nameid, name in self.names.items() if '%s.%s' % name == metric ]
+    series = []
+    for prefix in self.get_snapshots():
+      values = self.read_snapshot(prefix, metrics = [ metric ])
+      series.append((prefix, values.get(nameids[0], {}) if nameids else {}))
+    return series
+
   def get_topology(self):
     raise ValueError("Topology information not available from statistics of this type")
 
@@ -50,10 +60,17 @@ class SniperStatsBase:
     return sniper_lib.get_results(stats = self, **kwds)
 
 
-def SniperStats(resultsdir = '.', jobid = None):
+def SniperStats(resultsdir = '.', jobid = None, cpistack = False):
+  # cpistack = True: the caller only needs CPI stack and bottle graph statistics, read them from sim.cpistack if it exists
   if jobid:
     import sniper_stats_jobid
     stats = sniper_stats_jobid.SniperStatsJobid(jobid)
+  elif cpistack and os.path.exists(os.path.join(resultsdir, 'sim.cpistack')) and os.path.exists(os.path.join(resultsdir, 'sim.stats.sqlite3')):
+    import sniper_stats_cpistack
+    stats = sniper_stats_cpistack.SniperStatsCpiStack(os.path.join(resultsdir, 'sim.cpistack'), os.path.join(resultsdir, 'sim.stats.sqlite3'))
+  elif os.path.exists(os.path.join(resultsdir, 'sim.stats.bin')):
+    import sniper_stats_binary
+    stats = sniper_stats_binary.SniperStatsBinary(os.path.join(resultsdir, 'sim.stats.bin'), os.path.join(resultsdir, 'sim.stats.sqlite3'))
   elif os.path.exists(os.path.join(resultsdir, 'sim.stats.sqlite3')):
     import sniper_stats_sqlite
     stats = sniper_stats_sqlite.SniperStatsSqlite(os.path.join(resultsdir, 'sim.stats.sqlite3'))
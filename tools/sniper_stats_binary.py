@@ -0,0 +1,157 @@
+import os, mmap, struct, array, zlib, sniper_stats, sniper_stats_sqlite
+
+# Reader for sim.stats.bin (see common/misc/stats_binary_file.h)
+# Snapshots and metric names come from the binary file, topology and events from sim.stats.sqlite3
+# Files closed normally end in an index, which is used to find all records without scanning the file
+
+MAGIC = b'SNIPSTAT'
+RECORD_END, RECORD_NAME, RECORD_COLUMNS, RECORD_PREFIX, RECORD_SNAPSHOT, RECORD_SNAPSHOT_DELTA, RECORD_INDEX, RECORD_INDEX_END = list(range(8))
+FLAG_DELTA = 1
+
+class SniperStatsBinary(sniper_stats_sqlite.SniperStatsSqlite):
+  def __init__(self, filename = 'sim.stats.bin', dbfilename = 'sim.stats.sqlite3'):
+    with open(filename, 'rb') as fp:
+      self.data = mmap.mmap(fp.fileno(), 0, access = mmap.ACCESS_READ)
+    if self.data[:8] != MAGIC:
+      raise ValueError('%s is not a Sniper statistics file' % filename)
+    self.view = memoryview(self.data)
+    self.names, self.columns, self.prefixes, self.snapshots = {}, [], [], {}
+    # Snapshot records: (type, payload offset, prefix, index of the keyframe record they are decoded from)
+    self.records = []
+    self.prefixnames = {}
+    if not self.read_index():
+      self.read_records()
+    sniper_stats_sqlite.SniperStatsSqlite.__init__(self, dbfilename)
+
+  def read_index(self):
+    if len(self.data) < 32:
+      return False
+    rtype, length = struct.unpack_from('II', self.data, len(self.data) - 16)
+    if rtype != RECORD_INDEX_END:
+      return False
+    (offset,) = struct.unpack_from('Q', self.data, len(self.data) - 8)
+    rtype, length = struct.unpack_from('II', self.data, offset)
+    if rtype != RECORD_INDEX:
+      return False
+    nmeta, nsnapshots = struct.unpack_from('QQ', self.data, offset + 8)
+    for meta in struct.unpack_from('%dQ' % nmeta, self.data, offset + 24):
+      self.read_meta(*struct.unpack_from('II', self.data, meta), offset = meta + 8)
+    entries = struct.unpack_from('%dQ' % (3 * nsnapshots), self.data, offset + 24 + 8 * nmeta)
+    keyframes = {}
+    for prefixid, record, keyframe in zip(entries[0::3], entries[1::3], entries[2::3]):
+      (rtype,) = struct.unpack_from('I', self.data, record)
+      if record == keyframe:
+        keyframes[record] = len(self.records)
+      self.add_snapshot(rtype, record + 8, prefixid, keyframes[keyframe])
+    return True
+
+  def read_records(self):
+    offset = 16
+    keyframe = 0
+    while offset + 8 <= len(self.data):
+      rtype, length = struct.unpack_from('II', self.data, offset)
+      offset += 8
+      if rtype == RECORD_END:
+        break
+      elif rtype in (RECORD_SNAPSHOT, RECORD_SNAPSHOT_DELTA):
+        (prefixid,) = struct.unpack_from('Q', self.data, offset)
+        if rtype == RECORD_SNAPSHOT or not (struct.unpack_from('Q', self.data, offset + 16)[0] & FLAG_DELTA):
+          keyframe = len(self.records)
+        self.add_snapshot(rtype, offset, prefixid, keyframe)
+      else:
+        self.read_meta(rtype, length, offset)
+      offset += length
+
+  def read_meta(self, rtype, length, offset):
+    if rtype == RECORD_NAME:
+      (nameid,) = struct.unpack_from('Q', self.data, offset)
+      objectname, metricname = self.data[offset+8:offset+length].split(b'\0')[:2]
+      self.names[nameid] = (objectname.decode(), metricname.decode())
+    elif rtype == RECORD_COLUMNS:
+      first, count = struct.unpack_from('QQ', self.data, offset)
+      assert first == len(self.columns)
+      entries = struct.unpack_from('Ii' * count, self.data, offset + 16)
+      self.columns += list(zip(entries[0::2], entries[1::2]))
+    elif rtype == RECORD_PREFIX:
+      (prefixid,) = struct.unpack_from('Q', self.data, offset)
+      self.prefixnames[prefixid] = self.data[offset+8:offset+length].split(b'\0')[0].decode()
+
+  def add_snapshot(self, rtype, offset, prefixid, keyframe):
+    prefix = self.prefixnames[prefixid]
+    # Like the sqlite backend, a prefix refers to its first snapshot
+    if prefix not in self.snapshots:
+      self.prefixes.append(prefix)
+      self.snapshots[prefix] = len(self.records)
+    self.records.append((rtype, offset, prefix, keyframe))
+
+  def get_snapshots(self):
+    return self.prefixes
+
+  def read_metricnames(self):
+    return self.names
+
+  def read_snapshot(self, prefix, metrics = None):
+    if prefix not in self.snapshots:
+      raise ValueError('Invalid prefix %s' % prefix)
+    snapshot = self.decode_snapshot(self.snapshots[prefix])
+    if metrics:
+      nameids = set([ nameid for nameid, (objectname, metricname) in self.names.items() if '%s.%s' % (objectname, metricname) in metrics ])
+    values = {}
+    for (nameid, index), value in zip(self.columns, snapshot):
+      # Skip default values, the sqlite backend does not store them either
+      if value and (not metrics or nameid in nameids):
+        values.setdefault(nameid, {})[index] = value
+    return values
+
+  def read_metric_series(self, metric):
+    # Walk all snapshots once, only decompressing each one up to the last column of this metric
+    cols = [ (col, index) for col, (nameid, index) in enumerate(self.columns) if '%s.%s' % self.names[nameid] == metric ]
+    if not cols:
+      return [ (prefix, {}) for prefix in self.prefixes ]
+    needed = max([ col for col, index in cols ]) + 1
+    current = [ 0 ] * needed
+    series = []
+    for idx, (rtype, offset, prefix, keyframe) in enumerate(self.records):
+      values, delta = self.decode_record(rtype, offset, needed)
+      for col in range(needed):
+        if col >= len(values):
+          current[col] = 0
+        elif delta:
+          current[col] = (current[col] + values[col]) & 0xffffffffffffffff
+        else:
+          current[col] = values[col]
+      if self.snapshots[prefix] == idx:
+        series.append((prefix, dict([ (index, current[col]) for col, index in cols if current[col] ])))
+    return series
+
+  def decode_record(self, rtype, offset, needed = None):
+    values = array.array('Q')
+    if rtype == RECORD_SNAPSHOT:
+      (count,) = struct.unpack_from('Q', self.data, offset + 8)
+      if needed is not None:
+        count = min(count, needed)
+      values.frombytes(self.view[offset+16:offset+16+8*count])
+      return values, False
+    else:
+      count, flags, length = struct.unpack_from('QQQ', self.data, offset + 8)
+      compressed = self.view[offset+32:offset+32+length]
+      if needed is None:
+        values.frombytes(zlib.decompress(compressed))
+      else:
+        values.frombytes(zlib.decompressobj().decompress(compressed, 8 * min(count, needed)))
+      return values, bool(flags & FLAG_DELTA)
+
+  def decode_snapshot(self, idx):
+    # Start from the snapshot's keyframe, then apply all deltas
+    keyframe = self.records[idx][3]
+    values, delta = self.decode_record(*self.records[keyframe][:2])
+    for rtype, offset, prefix, _ in self.records[keyframe+1:idx+1]:
+      delta, _ = self.decode_record(rtype, offset)
+      values = array.array('Q', [ (d + (values[i] if i < len(values) else 0)) & 0xffffffffffffffff for i, d in enumerate(delta) ])
+    return values
+
+
+if __name__ == '__main__':
+  stats = SniperStatsBinary()
+  print(stats.get_snapshots())
+  print(stats.read_snapshot('roi-end'))
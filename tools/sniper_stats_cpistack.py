@@ -0,0 +1,55 @@
+import sniper_stats_sqlite
+
+# Reader for sim.cpistack (see common/misc/cpistack_file.h)
+# Holds only the pre-aggregated CPI stack components and the few other statistics used by cpistack.py and bottlegraph.py,
+# topology and events come from sim.stats.sqlite3
+# Only snapshot offsets are collected up front, values are parsed when a snapshot is read
+
+class SniperStatsCpiStack(sniper_stats_sqlite.SniperStatsSqlite):
+  def __init__(self, filename = 'sim.cpistack', dbfilename = 'sim.stats.sqlite3'):
+    sniper_stats_sqlite.SniperStatsSqlite.__init__(self, dbfilename)
+    self.fp = open(filename, 'rb')
+    self.names = {}
+    self.prefixes = []
+    self.offsets = {}
+    offset = 0
+    for line in self.fp:
+      if line.startswith(b'name '):
+        _, nameid, objectname, metricname = line.split()
+        self.names[int(nameid)] = (objectname.decode(), metricname.decode())
+      elif line.startswith(b'snapshot '):
+        prefix = line[9:].rstrip(b'\n').decode()
+        if prefix not in self.offsets:
+          self.prefixes.append(prefix)
+        # Later snapshots with the same prefix replace earlier ones
+        self.offsets[prefix] = offset + len(line)
+      offset += len(line)
+
+  def get_snapshots(self):
+    return self.prefixes
+
+  def read_snapshot(self, prefix, metrics = None):
+    if prefix not in self.offsets:
+      raise ValueError('Invalid prefix %s' % prefix)
+    if metrics:
+      nameids = set([ nameid for nameid, name in self.names.items() if '%s.%s' % name in metrics ])
+    values = {}
+    self.fp.seek(self.offsets[prefix])
+    for line in self.fp:
+      if line.startswith(b'snapshot ') or line.startswith(b'name '):
+        break
+      if line.startswith(b'#'):
+        continue
+      fields = line.split()
+      nameid = int(fields[0])
+      if metrics and nameid not in nameids:
+        continue
+      values[nameid] = dict([ (idx, int(value)) for idx, value in enumerate(fields[1:]) if value != b'0' ])
+    return values
+
+
+
+if __name__ == '__main__':
+  stats = SniperStatsCpiStack()
+  print(stats.get_snapshots())
+  print(stats.read_snapshot('roi-end'))
@@ -1,8 +1,9 @@
-import collections, sqlite3, sniper_stats
+import os, collections, sqlite3, sniper_stats, sniper_events
 
 class SniperStatsSqlite(sniper_stats.SniperStatsBase):
   def __init__(self, filename = 'sim.stats.sqlite3'):
     self.db = sqlite3.connect(filename)
+    self.eventsfile = os.path.join(os.path.dirname(filename), 'sim.events.bin')
     self.db.text_factory = str # Don't try to convert database contents to UTF-8
     self.names = self.read_metricnames()
 
@@ -55,6 +56,8 @@ class SniperStatsSqlite(sniper_stats.SniperStatsBase):
       return [ (timestamp, core, thread, value0, value1, description) for event, timestamp, core, thread, value0, value1, description in self.get_events() if event == sniper_stats.EVENT_MARKER ]
 
   def get_events(self):
+    if os.path.exists(self.eventsfile):
+      return sniper_events.read_events(self.eventsfile)
     c = self.db.cursor()
     return c.execute('SELECT event, time, core, thread, value0, value1, description FROM event').fetchall()
 
@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+
+# End-to-end simulation speed suite: runs the test/ programs under a fixed set of configurations
+# and writes simulated KIPS/MIPS, host memory usage and per-phase wall time to a JSON file.
+# Pass the output of an earlier run with --baseline to report (and fail on) speed regressions.
+
+import sys, os, getopt, json, time, platform, subprocess, shutil, sniper_lib, sniper_stats
+
+HOME = os.path.abspath(os.path.join(os.path.dirname(__file__), '..'))
+VERSION = 1
+
+# Test programs, with the same command lines as their run_<target> Makefile rules
+TESTS = [
+  ('fft',      dict(dir = 'fft',      target = 'fft',      ncores = 1, options = '--roi', cmd = './fft -p 1')),
+  ('spinloop', dict(dir = 'spinloop', target = 'spinloop', ncores = 2, options = '--roi -gcore/spin_loop_detection=true', cmd = './spinloop')),
+  ('mpi-omp',  dict(dir = 'mpi-omp',  target = 'hybrid',   ncores = 4, options = '--mpi --mpi-ranks=2', cmd = './hybrid',
+                    env = { 'OMP_NUM_THREADS': '2', 'OMP_WAIT_POLICY': 'passive' })),
+]
+
+# Configurations. rob, noc and dram-cache only override parts of a full configuration, so they are
+# layered on top of gainestown. riscv-mediumboom cannot run x86 binaries: it needs RISC-V SIFT traces
+# of the test programs, named <test>.sift, in the directory passed with --riscv-traces.
+CONFIGS = [
+  ('gainestown',       [ 'gainestown' ]),
+  ('rob',              [ 'gainestown', 'rob' ]),
+  ('riscv-mediumboom', [ 'riscv-mediumboom' ]),
+  ('noc',              [ 'gainestown', 'noc' ]),
+  ('dram-cache',       [ 'gainestown', 'dram-cache' ]),
+]
+
+# Statistics snapshots delimiting the phases of a run
+PHASES = [
+  ('warmup',   'start',     'roi-begin'),
+  ('roi',      'roi-begin', 'roi-end'),
+  ('cooldown', 'roi-end',   'stop'),
+]
+
+
+def usage():
+  print('Usage:', sys.argv[0], '[-h (help)] [-o <output.json> (default: speedsuite.json)] [-d <rundir (default: speedsuite.runs)>]', \
+        '[--tests=<test>[,<test>...]] [--configs=<config>[,<config>...]] [--riscv-traces=<dir>]', \
+        '[--baseline=<previous.json>] [--threshold=<fraction (default: 0.05)>] [--list] [-- <extra run-sniper options>]')
+
+
+def log(*args):
+  print('[SPEEDSUITE]', *args)
+  sys.stdout.flush()
+
+
+def build_test(test):
+  testdir = os.path.join(HOME, 'test', test['dir'])
+  rc = subprocess.call([ 'make', '-C', testdir, test['target'] ], stdout = subprocess.DEVNULL)
+  return rc == 0
+
+
+def get_snapshots(resultsdir):
+  stats = sniper_stats.SniperStats(resultsdir)
+  snapshots = {}
+  for prefix in stats.get_snapshots():
+    if prefix in ('start', 'roi-begin', 'roi-end', 'stop'):
+      values = stats.read_snapshot(prefix, metrics = ('time.walltime', 'core.instructions'))
+      walltime = instrs = 0
+      for nameid, vals in values.items():
+        name = '%s.%s' % stats.names[nameid]
+        if name == 'time.walltime':
+          walltime = vals.get(0, 0) / 1e6 # microseconds -> seconds
+        elif name == 'core.instructions':
+          instrs = sum(vals.values())
+      snapshots[prefix] = (walltime, instrs)
+  return snapshots
+
+
+def phase_result(walltime, instrs):
+  return dict(
+    wall_time = walltime,
+    instructions = instrs,
+    kips = walltime and instrs / walltime / 1e3 or 0,
+  )
+
+
+def collect_results(resultsdir):
+  siminfo = eval(open(os.path.join(resultsdir, 'sim.info')).read())
+  snapshots = get_snapshots(resultsdir)
+
+  phases = {}
+  if 'start' in snapshots:
+    phases['startup'] = phase_result(snapshots['start'][0] - siminfo['t_start'], 0)
+  for name, begin, end in PHASES:
+    if begin in snapshots and end in snapshots:
+      phases[name] = phase_result(snapshots[end][0] - snapshots[begin][0], snapshots[end][1] - snapshots[begin][1])
+  if 'stop' in snapshots:
+    phases['exit'] = phase_result(siminfo['t_start'] + siminfo['t_elapsed'] - snapshots['stop'][0], 0)
+
+  # Speed of the whole simulation, including all setup and teardown the cluster pays for
+  instrs = 'stop' in snapshots and snapshots['stop'][1] or 0
+  walltime = siminfo['t_elapsed']
+  # rusage[2] is ru_maxrss (in KB) of the largest process, rss the (sampled) peak over all processes
+  rss = max(siminfo.get('rss', 0), siminfo['rusage'] and siminfo['rusage'][2] * 1024 or 0)
+
+  return dict(
+    instructions = instrs,
+    wall_time = walltime,
+    kips = walltime and instrs / walltime / 1e3 or 0,
+    mips = walltime and instrs / walltime / 1e6 or 0,
+    roi_kips = phases.get('roi', {}).get('kips'),
+    rss_peak = rss,
+    vmem_peak = siminfo['vmem'],
+    phases = phases,
+  )
+
+
+def run(testname, test, configname, configs, rundir, riscv_traces, extra_options):
+  resultsdir = os.path.join(rundir, '%s-%s' % (testname, configname))
+  if os.path.exists(resultsdir):
+    shutil.rmtree(resultsdir)
+  os.makedirs(resultsdir)
+
+  cmd = [ os.path.join(HOME, 'run-sniper'), '-d', resultsdir, '-n', str(test['ncores']) ]
+  cmd += [ '-c%s' % config for config in configs ]
+  if configname == 'riscv-mediumboom':
+    trace = os.path.join(riscv_traces, '%s.sift' % testname)
+    if test['ncores'] > 1 or test['options'].startswith('--mpi'):
+      return dict(status = 'skipped', reason = 'multi-threaded RISC-V traces are not supported')
+    if not os.path.exists(trace):
+      return dict(status = 'skipped', reason = 'no RISC-V trace %s' % trace)
+    cmd += [ '--traces=%s' % trace ] + extra_options
+  else:
+    cmd += test['options'].split() + extra_options + [ '--' ] + test['cmd'].split()
+
+  env = dict(os.environ)
+  env.update(test.get('env', {}))
+  log('Running', testname, 'on', configname)
+  rc = subprocess.call(cmd, cwd = os.path.join(HOME, 'test', test['dir']), env = env,
+                       stdout = open(os.path.join(resultsdir, 'speedsuite.log'), 'w'), stderr = subprocess.STDOUT)
+  if rc != 0:
+    return dict(status = 'failed', reason = 'run-sniper exited with code %d, see %s' % (rc, os.path.join(resultsdir, 'speedsuite.log')))
+
+  try:
+    result = collect_results(resultsdir)
+  except (IOError, ValueError, KeyError, sniper_lib.SniperResultsException) as e:
+    return dict(status = 'failed', reason = 'cannot read results: %s' % e)
+  result['status'] = 'ok'
+  return result
+
+
+def compare(runs, baseline, threshold):
+  regressions = []
+  previous = dict(((r['test'], r['config']), r) for r in baseline['runs'])
+  for r in runs:
+    p = previous.get((r['test'], r['config']))
+    if r['status'] != 'ok' or not p or p['status'] != 'ok' or not p['kips']:
+      continue
+    change = r['kips'] / p['kips'] - 1
+    log('%-10s %-18s %10.1f KIPS -> %10.1f KIPS (%+.1f%%)' % (r['test'], r['config'], p['kips'], r['kips'], 100 * change))
+    if change < -threshold:
+      regressions.append((r['test'], r['config'], change))
+  return regressions
+
+
+if __name__ == '__main__':
+  outputfile = 'speedsuite.json'
+  rundir = 'speedsuite.runs'
+  testnames = [ name for name, _ in TESTS ]
+  confignames = [ name for name, _ in CONFIGS ]
+  riscv_traces = '.'
+  baseline = None
+  threshold = 0.05
+  do_list = False
+
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], "ho:d:", [ 'tests=', 'configs=', 'riscv-traces=', 'baseline=', 'threshold=', 'list' ])
+  except getopt.GetoptError as e:
+    print(e)
+    usage()
+    sys.exit(-1)
+  for o, a in opts:
+    if o == '-h':
+      usage()
+      sys.exit()
+    if o == '-o':
+      outputfile = a
+    if o == '-d':
+      rundir = a
+    if o == '--tests':
+      testnames = a.split(',')
+    if o == '--configs':
+      confignames = a.split(',')
+    if o == '--riscv-traces':
+      riscv_traces = os.path.abspath(a)
+    if o == '--baseline':
+      baseline = json.load(open(a))
+    if o == '--threshold':
+      threshold = float(a)
+    if o == '--list':
+      do_list = True
+
+  tests = dict(TESTS)
+  configs = dict(CONFIGS)
+  for name in testnames:
+    if name not in tests:
+      print('Unknown test', name, '- valid tests are:', ', '.join(tests.keys()))
+      sys.exit(-1)
+  for name in confignames:
+    if name not in configs:
+      print('Unknown configuration', name, '- valid configurations are:', ', '.join(configs.keys()))
+      sys.exit(-1)
+
+  if do_list:
+    for testname in testnames:
+      for configname in confignames:
+        print(testname, configname)
+    sys.exit(0)
+
+  rundir = os.path.abspath(rundir)
+  runs = []
+  for testname in testnames:
+    test = tests[testname]
+    built = build_test(test)
+    for configname in confignames:
+      if built:
+        result = run(testname, test, configname, configs[configname], rundir, riscv_traces, args)
+      else:
+        result = dict(status = 'failed', reason = 'cannot build test/%s' % test['dir'])
+      result.update(test = testname, config = configname, ncores = test['ncores'])
+      if result['status'] == 'ok':
+        log('%s on %s: %.1f KIPS, %.1f MB RSS, %.1f s' % (testname, configname, result['kips'], result['rss_peak'] / 1e6, result['wall_time']))
+      else:
+        log('%s on %s %s: %s' % (testname, configname, result['status'], result['reason']))
+      runs.append(result)
+
+  git_revision = subprocess.getoutput('git -C "%s" rev-parse HEAD 2>/dev/null' % HOME)
+  output = dict(
+    suite = 'sniper-speedsuite',
+    version = VERSION,
+    host = platform.node(),
+    cpu = platform.processor(),
+    git_revision = git_revision,
+    date = time.strftime('%Y-%m-%dT%H:%M:%S'),
+    runs = runs,
+  )
+  json.dump(output, open(outputfile, 'w'), indent = 2, sort_keys = True)
+  log('Results written to', outputfile)
+
+  if baseline:
+    regressions = compare(runs, baseline, threshold)
+    if regressions:
+      for testname, configname, change in regressions:
+        log('Regression: %s on %s is %.1f%% slower' % (testname, configname, -100 * change))
+      sys.exit(1)
+
+  if any(r['status'] == 'failed' for r in runs):
+    sys.exit(2)
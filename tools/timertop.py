@@ -1,21 +1,86 @@
 #!/usr/bin/env python3
 
-import sys, os, subprocess, addr2line
+import sys, os, getopt, subprocess, addr2line
 
 def ex(cmd):
   return subprocess.Popen([ 'bash', '-c', cmd ], stdout = subprocess.PIPE, text=True).communicate()[0]
 
-if len(sys.argv) > 1:
-  if sys.argv[1] == '-':
+def usage():
+  print('Usage:', sys.argv[0], '[-h (help)] [<sim_timers.out (default) or - for stdin>]')
+  print('      ', sys.argv[0], '-s [--partial <section-start>:<section-end> (default: start:stop)] [-d <resultsdir (default: .)>]')
+  print('  -s: show the host time per subsystem and host thread measured by general/self_profile')
+
+def self_profile(resultsdir, partial):
+  import sniper_stats
+  stats = sniper_stats.SniperStats(resultsdir)
+  results = stats.get_results(partial = partial)['results']
+  subsystems = [ name[len('self_profile.'):-len('-time')] for name in results if name.startswith('self_profile.') and name.endswith('-time') ]
+  if not subsystems:
+    print('No self-profile statistics found, run with -g --general/self_profile=true')
+    sys.exit(1)
+  # Thread ids are constant, so take them from the last snapshot rather than from the difference
+  tids = {}
+  for nameid, values in stats.read_snapshot(partial[1]).items():
+    if stats.names.get(nameid) == ('self_profile', 'host-tid'):
+      tids = values
+  nthreads = max([ len(results['self_profile.%s-time' % subsystem]) for subsystem in subsystems ])
+  def value(name, thread):
+    values = results.get(name, [])
+    return values[thread] if thread < len(values) else 0
+  totals = dict([ (subsystem, sum(results['self_profile.%s-time' % subsystem])) for subsystem in subsystems ])
+  subsystems.sort(key = lambda subsystem: totals[subsystem], reverse = True)
+  total = sum(totals.values()) or 1
+
+  print('%-12s %10s %7s %12s %9s' % ('subsystem', 'time (s)', 'share', 'calls', 'us/call'))
+  for subsystem in subsystems:
+    calls = sum(results.get('self_profile.%s-calls' % subsystem, []))
+    print('%-12s %10.3f %6.1f%% %12u %9.2f' % (subsystem, totals[subsystem] / 1e9, 100. * totals[subsystem] / total, calls, totals[subsystem] / (calls or 1) / 1e3))
+  print()
+  print('%-8s ' % 'tid' + ' '.join([ '%12s' % subsystem for subsystem in subsystems ]))
+  for thread in range(nthreads):
+    times = [ value('self_profile.%s-time' % subsystem, thread) for subsystem in subsystems ]
+    if sum(times):
+      print('%-8u ' % tids.get(thread, 0) + ' '.join([ '%11.3fs' % (t / 1e9) for t in times ]))
+
+try:
+  opts, args = getopt.getopt(sys.argv[1:], "hsd:", [ "partial=" ])
+except getopt.GetoptError as e:
+  print(e)
+  usage()
+  sys.exit(1)
+resultsdir = '.'
+partial = ('start', 'stop')
+mode_self_profile = False
+for o, a in opts:
+  if o == '-h':
+    usage()
+    sys.exit()
+  if o == '-s':
+    mode_self_profile = True
+  if o == '-d':
+    resultsdir = a
+  if o == '--partial':
+    if ':' not in a:
+      sys.stderr.write('--partial=<from>:<to>\n')
+      usage()
+      sys.exit(1)
+    partial = tuple(a.split(':'))[0:2]
+
+if mode_self_profile:
+  self_profile(resultsdir, partial)
+  sys.exit()
+
+if args:
+  if args[0] == '-':
     data = sys.stdin.readlines()
   else:
-    data = open(sys.argv[1], "r").readlines()
+    data = open(args[0], "r").readlines()
 else:
   data = open('sim_timers.out', "r").readlines()
 
 addr2line.set_rdtsc(int(data[0]))
 
-data = [ map(int, line.split()[:4]) + [ map(int, line.split()[4:10]), line.split(' ', 10)[10].strip() ] for line in data[1:] ]
+data = [ list(map(int, line.split()[:4])) + [ list(map(int, line.split()[4:10])), line.split(' ', 10)[10].strip() ] for line in data[1:] ]
 data.sort(key = lambda line: line[0], reverse = True)
 
 height, width = ex('stty size').split()
@@ -22,7 +22,7 @@ levels_default = [ '1', '2', '3', 'topo' ]
 
 if __name__ == '__main__':
   def usage():
-    print('Usage: '+sys.argv[0]+ ' [-h|--help (help)] [-d <resultsdir (default: .)>] [-j <jobid>] [-t <title>] [-n <num-intervals (default: 1000, all: 0)>] [-i <interval (default: smallest_interval)>] [-o <outputdir (default: viz)>] [--mcpat] [--level <levels (default: %s)>] [--add-level <level>] [-v|--verbose]' % ','.join(levels_default))
+    print('Usage: '+sys.argv[0]+ ' [-h|--help (help)] [-d <resultsdir (default: .)>] [-j <jobid>] [-t <title>] [-n <num-intervals (default: 1000, all: 0)>] [-i <interval (default: smallest_interval)>] [-o <outputdir (default: viz)>] [--mcpat] [--level <levels (default: %s)>] [--add-level <level>] [--streamed] [-v|--verbose]' % ','.join(levels_default))
     sys.exit()
 
   resultsdir = '.'
@@ -34,9 +34,10 @@ if __name__ == '__main__':
   verbose = False
   levels = levels_default
   dircleanup = None
+  streamed = False
 
   try:
-    opts, args = getopt.getopt(sys.argv[1:], "hd:o:t:n:i:vj:", [ "help", "mcpat", "level=", "add-level=", "verbose" ])
+    opts, args = getopt.getopt(sys.argv[1:], "hd:o:t:n:i:vj:", [ "help", "mcpat", "level=", "add-level=", "streamed", "verbose" ])
   except getopt.GetoptError as e:
     print(e)
     usage()
@@ -67,6 +68,9 @@ if __name__ == '__main__':
         print('Invalid level', a)
         sys.exit(1)
       levels.append(a)
+    if o == '--streamed':
+      # Level 2 data was already written during the simulation by scripts/viz-stream.py
+      streamed = True
     if o == '-v' or o == '--verbose':
       verbose = True
     if o == '-j':
@@ -137,12 +141,27 @@ if __name__ == '__main__':
     interval = defaultinterval
     num_intervals = defaultnum_intervals
 
+  if streamed:
+    try:
+      stream = json.load(open(os.path.join(outputdir,'levels','level2','data','stream.json')))
+    except (IOError, ValueError):
+      print('No streamed level 2 data found in '+outputdir+', was the simulation run with -s viz-stream?')
+      sys.exit(1)
+    title = stream['title']
+    interval = stream['interval']
+    num_intervals = stream['num_intervals']
+    if '2' not in levels:
+      levels.append('2')
+
   # Mainline visualization
 
   mkdir_p(outputdir)
 
   if '1' in levels: level1.createJSONData(resultsdir, outputdir, verbose = verbose)
-  if '2' in levels: level2.createJSONData(defaultinterval, defaultnum_intervals, interval, num_intervals, resultsdir, outputdir, title, use_mcpat, verbose = verbose)
+  if '2' in levels and streamed:
+    level2.stats = stats
+    level2.writemarkers(outputdir, verbose = verbose)
+  elif '2' in levels: level2.createJSONData(defaultinterval, defaultnum_intervals, interval, num_intervals, resultsdir, outputdir, title, use_mcpat, verbose = verbose)
   if '3' in levels: level3.createJSONData(interval, num_intervals, resultsdir, outputdir, title, verbose = verbose)
   if 'topo' in levels: topology.createJSONData(interval, num_intervals, resultsdir, outputdir, verbose = verbose)
   if 'profile' in levels: profile.createJSONData(resultsdir, outputdir, verbose = verbose)